@@ -135,6 +135,9 @@ typedef intptr_t ssize_t;
 #if defined __BIG_ENDIAN__
 #define LOAD_32BE(DEST, ADDR, ARR) DEST = *(uint32_t*) ((uintptr_t) (ARR) + (size_t) (ADDR))
 #if defined(__PPC__) || defined(__POWERPC__)
+// Emulated memory stays little-endian on these hosts too. The byte-reversed loads and stores
+// swap as part of the access at no extra cost, whereas keeping memory in host order would mean
+// adjusting the address of every byte and halfword access and swapping at every other boundary.
 #define LOAD_32LE(DEST, ADDR, ARR) { \
 	size_t _addr = (ADDR); \
 	const void* _ptr = (ARR); \
@@ -15,6 +15,8 @@ CXX_GUARD_START
 struct VFile;
 
 bool GUISelectFile(struct GUIParams*, char* outPath, size_t outLen, bool (*filterName)(const char* name), bool (*filterContents)(struct VFile*), const char* preselect);
+// Drops the listings kept from directories visited earlier
+void GUISelectFileClearCache(void);
 
 CXX_GUARD_END
 
@@ -11,6 +11,8 @@
 CXX_GUARD_START
 
 uint32_t hash32(const void* key, int len, uint32_t seed);
+// Fast 64-bit hash (xxHash64) for large buffers; chain regions by passing the previous hash as the seed
+uint64_t hash64(const void* key, size_t len, uint64_t seed);
 
 CXX_GUARD_END
 
@@ -15,7 +15,15 @@ struct VFile;
 struct Patch {
 	struct VFile* vf;
 
+	// Set by the caller when it already knows the CRC32 of the input, so it isn't computed again
+	bool hasInputCrc32;
+	uint32_t inputCrc32;
+	// Set by applyPatch when it had to verify the CRC32 of the whole output anyway
+	bool hasOutputCrc32;
+	uint32_t outputCrc32;
+
 	size_t (*outputSize)(struct Patch* patch, size_t inSize);
+	// in and out may be the same buffer; formats that can't be applied in place fail instead
 	bool (*applyPatch)(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize);
 };
 
@@ -120,7 +120,8 @@ static inline int _sceThreadEntry(SceSize args, void* argp) {
 }
 
 static inline int ThreadCreate(Thread* thread, ThreadEntry entry, void* context) {
-	Thread id = sceKernelCreateThread("SceThread", _sceThreadEntry, 0x10000100, 0x10000, 0, 0, 0);
+	// Core 0 is left to the emulation thread
+	Thread id = sceKernelCreateThread("SceThread", _sceThreadEntry, 0x10000100, 0x10000, 0, SCE_KERNEL_CPU_MASK_USER_1 | SCE_KERNEL_CPU_MASK_USER_2, 0);
 	if (id < 0) {
 		*thread = 0;
 		return id;
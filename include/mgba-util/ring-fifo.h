@@ -10,11 +10,26 @@
 
 CXX_GUARD_START
 
+#define RING_FIFO_CACHE_LINE 64
+
+// Single producer, single consumer. Each side keeps its own pointers on a separate cache
+// line, along with the last value it saw of the other side's, so it only has to touch the
+// other side's line when that stale view says the queue is full or empty.
 struct RingFIFO {
 	void* data;
 	size_t capacity;
-	void* readPtr;
+
+	uint8_t padWriter[RING_FIFO_CACHE_LINE];
 	void* writePtr;
+	// End of staged writes the reader can't see until the next commit
+	void* stagedPtr;
+	void* readPtrCache;
+
+	uint8_t padReader[RING_FIFO_CACHE_LINE];
+	void* readPtr;
+	void* writePtrCache;
+
+	uint8_t padEnd[RING_FIFO_CACHE_LINE];
 };
 
 void RingFIFOInit(struct RingFIFO* buffer, size_t capacity);
@@ -23,6 +38,9 @@ size_t RingFIFOCapacity(const struct RingFIFO* buffer);
 size_t RingFIFOSize(const struct RingFIFO* buffer);
 void RingFIFOClear(struct RingFIFO* buffer);
 size_t RingFIFOWrite(struct RingFIFO* buffer, const void* value, size_t length);
+// Like RingFIFOWrite, but the reader only sees staged writes once they're committed
+size_t RingFIFOStage(struct RingFIFO* buffer, const void* value, size_t length);
+void RingFIFOCommit(struct RingFIFO* buffer);
 size_t RingFIFORead(struct RingFIFO* buffer, void* output, size_t length);
 
 CXX_GUARD_END
@@ -288,6 +288,124 @@ static inline Socket SocketAccept(Socket socket, struct Address* address) {
 	return INVALID_SOCKET;
 }
 
+static inline Socket SocketOpenUDP(int port, const struct Address* bindAddress) {
+	int err;
+#if !defined(_3DS) && !defined(GEKKO)
+	if (bindAddress && bindAddress->version == IPV6) {
+		Socket sock = socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+		if (SOCKET_FAILED(sock)) {
+			return sock;
+		}
+		struct sockaddr_in6 bindInfo;
+		memset(&bindInfo, 0, sizeof(bindInfo));
+		bindInfo.sin6_family = AF_INET6;
+		bindInfo.sin6_port = htons(port);
+		memcpy(bindInfo.sin6_addr.s6_addr, bindAddress->ipv6, sizeof(bindInfo.sin6_addr.s6_addr));
+		err = bind(sock, (const struct sockaddr*) &bindInfo, sizeof(bindInfo));
+		if (err) {
+			SocketClose(sock);
+			return INVALID_SOCKET;
+		}
+		return sock;
+	}
+#endif
+#ifdef GEKKO
+	Socket sock = net_socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+#else
+	Socket sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#endif
+	if (SOCKET_FAILED(sock)) {
+		return sock;
+	}
+
+	struct sockaddr_in bindInfo;
+	memset(&bindInfo, 0, sizeof(bindInfo));
+	bindInfo.sin_family = AF_INET;
+	bindInfo.sin_port = htons(port);
+	if (bindAddress) {
+		bindInfo.sin_addr.s_addr = htonl(bindAddress->ipv4);
+	} else {
+#ifndef _3DS
+		bindInfo.sin_addr.s_addr = INADDR_ANY;
+#else
+		bindInfo.sin_addr.s_addr = gethostid();
+#endif
+	}
+#ifdef GEKKO
+	err = net_bind(sock, (struct sockaddr*) &bindInfo, sizeof(bindInfo));
+#else
+	err = bind(sock, (const struct sockaddr*) &bindInfo, sizeof(bindInfo));
+#endif
+	if (err) {
+		SocketClose(sock);
+		return INVALID_SOCKET;
+	}
+	return sock;
+}
+
+static inline ssize_t SocketSendTo(Socket socket, const void* buffer, size_t size, int port, const struct Address* address) {
+#if !defined(_3DS) && !defined(GEKKO)
+	if (address->version == IPV6) {
+		struct sockaddr_in6 addrInfo;
+		memset(&addrInfo, 0, sizeof(addrInfo));
+		addrInfo.sin6_family = AF_INET6;
+		addrInfo.sin6_port = htons(port);
+		memcpy(addrInfo.sin6_addr.s6_addr, address->ipv6, sizeof(addrInfo.sin6_addr.s6_addr));
+#ifdef _WIN32
+		return sendto(socket, (const char*) buffer, size, 0, (const struct sockaddr*) &addrInfo, sizeof(addrInfo));
+#else
+		return sendto(socket, buffer, size, 0, (const struct sockaddr*) &addrInfo, sizeof(addrInfo));
+#endif
+	}
+#endif
+	struct sockaddr_in addrInfo;
+	memset(&addrInfo, 0, sizeof(addrInfo));
+	addrInfo.sin_family = AF_INET;
+	addrInfo.sin_port = htons(port);
+	addrInfo.sin_addr.s_addr = htonl(address->ipv4);
+#ifdef _WIN32
+	return sendto(socket, (const char*) buffer, size, 0, (const struct sockaddr*) &addrInfo, sizeof(addrInfo));
+#elif defined(GEKKO)
+	return net_sendto(socket, buffer, size, 0, (struct sockaddr*) &addrInfo, sizeof(addrInfo));
+#else
+	return sendto(socket, buffer, size, 0, (const struct sockaddr*) &addrInfo, sizeof(addrInfo));
+#endif
+}
+
+static inline ssize_t SocketRecvFrom(Socket socket, void* buffer, size_t size, int* port, struct Address* address) {
+#if !defined(_3DS) && !defined(GEKKO)
+	struct sockaddr_storage addrInfo;
+#else
+	struct sockaddr_in addrInfo;
+#endif
+	memset(&addrInfo, 0, sizeof(addrInfo));
+	socklen_t len = sizeof(addrInfo);
+#ifdef _WIN32
+	ssize_t received = recvfrom(socket, (char*) buffer, size, 0, (struct sockaddr*) &addrInfo, &len);
+#elif defined(GEKKO)
+	ssize_t received = net_recvfrom(socket, buffer, size, 0, (struct sockaddr*) &addrInfo, &len);
+#else
+	ssize_t received = recvfrom(socket, buffer, size, 0, (struct sockaddr*) &addrInfo, &len);
+#endif
+	if (received < 0) {
+		return received;
+	}
+#if !defined(_3DS) && !defined(GEKKO)
+	if (addrInfo.ss_family == AF_INET6) {
+		const struct sockaddr_in6* addrInfo6 = (const struct sockaddr_in6*) &addrInfo;
+		address->version = IPV6;
+		memcpy(address->ipv6, addrInfo6->sin6_addr.s6_addr, sizeof(address->ipv6));
+		*port = ntohs(addrInfo6->sin6_port);
+		return received;
+	}
+#endif
+	const struct sockaddr_in* addrInfo4 = (const struct sockaddr_in*) &addrInfo;
+	address->version = IPV4;
+	address->ipv4 = ntohl(addrInfo4->sin_addr.s_addr);
+	*port = ntohs(addrInfo4->sin_port);
+	return received;
+}
+
 static inline int SocketSetBlocking(Socket socket, bool blocking) {
 #ifdef _WIN32
 	u_long unblocking = !blocking;
@@ -10,13 +10,20 @@
 
 CXX_GUARD_START
 
-struct TableList;
+struct TableTuple;
 
+// Open addressing with Robin Hood probing. When it grows, the old slots are moved into
+// the new ones a few at a time by later insertions and removals.
 struct Table {
-	struct TableList* table;
+	struct TableTuple* table;
 	size_t tableSize;
 	size_t size;
 	void (*deinitializer)(void*);
+
+	struct TableTuple* oldTable;
+	size_t oldTableSize;
+	size_t oldSize;
+	size_t migrated;
 };
 
 void TableInit(struct Table*, size_t initialSize, void (deinitializer(void*)));
@@ -95,6 +95,29 @@ static inline int ConditionWake(Condition* cond) {
 }
 #endif
 
+enum ThreadPriority {
+	THREAD_PRIO_LOW = -1,
+	THREAD_PRIO_NORMAL = 0,
+	THREAD_PRIO_HIGH = 1,
+};
+
+// Placement of the calling thread. CPU cores are numbered from 0; on platforms that can't
+// place threads these all return a negative value and change nothing.
+int ThreadCoreCount(void);
+// The core with the highest capacity or clock on asymmetric (big.LITTLE) systems, or -1 if they look alike
+int ThreadFastestCore(void);
+int ThreadSetCore(int core);
+int ThreadClearCore(void);
+int ThreadSetPriority(enum ThreadPriority priority);
+
+// One thread, typically emulation, can claim a core; an exclusive claim also keeps helper threads
+// off it. Helpers call ThreadPlaceHelper as they start, which also undoes any pinning they inherited
+// from the thread that created them. Without a claim it changes nothing.
+void ThreadClaimCore(int core, bool exclusive);
+void ThreadReleaseCore(void);
+int ThreadClaimedCore(void);
+int ThreadPlaceHelper(void);
+
 CXX_GUARD_END
 
 #endif
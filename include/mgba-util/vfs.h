@@ -68,6 +68,23 @@ struct VFile* VFileOpen(const char* path, int flags);
 
 struct VFile* VFileOpenFD(const char* path, int flags);
 struct VFile* VFileFromFD(int fd);
+void* VFileFDMapCopyOnWrite(struct VFile* vf, size_t size, size_t mapSize);
+bool VFileFDRemapCopyOnWrite(struct VFile* vf, void* memory, size_t offset, size_t size);
+int64_t VFileFDModificationTime(struct VFile* vf);
+
+// Maps the first size bytes of vf into a zeroed, writable region of mapSize bytes whose pages stay
+// shared with the file until they are written. Free it with mappedMemoryFree. Returns NULL if vf
+// can't be mapped this way.
+void* VFileMapCopyOnWrite(struct VFile* vf, size_t size, size_t mapSize);
+// Puts size bytes of vf from offset in place of the memory at the given address, which has to lie in
+// a region that mappedMemoryFree can free, the same way. Returns false and leaves the memory alone
+// unless the address, offset and size are all whole pages and vf is long enough.
+bool VFileRemapCopyOnWrite(struct VFile* vf, void* memory, size_t offset, size_t size);
+
+// Returns the modification time of the file backing vf in seconds, or 0 if it isn't known
+int64_t VFileModificationTime(struct VFile* vf);
+// Same for a directory, which changes whenever an entry is added, removed or renamed
+int64_t VDirModificationTime(const char* path);
 
 struct VFile* VFileFromMemory(void* mem, size_t size);
 struct VFile* VFileFromConstMemory(const void* mem, size_t size);
@@ -76,6 +93,12 @@ struct VFile* VFileMemChunk(const void* mem, size_t size);
 struct CircleBuffer;
 struct VFile* VFileFIFO(struct CircleBuffer* backing);
 
+// Queues writes to backing in a buffer of bufferSize bytes and writes them out on another thread,
+// so long sequential writers don't wait on slow storage. Anything else waits for the queue to
+// drain first, which makes sync a flush barrier. Closing it closes backing. Without threading,
+// backing is returned as is.
+struct VFile* VFileAsync(struct VFile* backing, size_t bufferSize);
+
 struct VDir* VDirOpen(const char* path);
 struct VDir* VDirOpenArchive(const char* path);
 
@@ -85,6 +108,8 @@ struct VDir* VDirOpenZip(const char* path, int flags);
 
 #ifdef USE_LZMA
 struct VDir* VDirOpen7z(const char* path, int flags);
+// Sets how many threads decode 7z archives, or 0 for one per core
+void VDir7zSetThreads(int threads);
 #endif
 
 #if defined(__wii__) || defined(_3DS) || defined(PSP2)
@@ -0,0 +1,70 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef M_CORE_BATCH_H
+#define M_CORE_BATCH_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba/core/interface.h>
+#include <mgba-util/threading.h>
+
+struct mCore;
+struct VFile;
+
+struct mCoreBatchInstance {
+	struct mCore* core;
+	// Only set when the instance can't run from the shared ROM mapping
+	void* privateRom;
+	bool render;
+};
+
+// Runs many headless cores of the same ROM in lockstep, one frame at a time. All
+// instances read from a single mapping of the ROM, and each frame is spread over a
+// pool of worker threads, with the calling thread taking its share as well.
+struct mCoreBatch {
+	struct VFile* romVf;
+	void* rom;
+	size_t romSize;
+
+	struct mCoreBatchInstance* instances;
+	size_t nInstances;
+
+	size_t nThreads;
+#ifndef DISABLE_THREADING
+	Thread* threads;
+#endif
+	Mutex mutex;
+	Condition workCond;
+	Condition doneCond;
+	unsigned generation;
+	size_t nextInstance;
+	size_t remaining;
+	bool shutdown;
+};
+
+// Takes ownership of rom. threads is the number of extra workers; with 0, every
+// instance runs on the calling thread.
+bool mCoreBatchInit(struct mCoreBatch*, struct VFile* rom, size_t instances, size_t threads);
+void mCoreBatchDeinit(struct mCoreBatch*);
+
+struct mCore* mCoreBatchGetCore(struct mCoreBatch*, size_t instance);
+
+// Instance i renders into buffer + i * stride * height, where height comes from
+// desiredVideoDimensions. Must be followed by mCoreBatchReset to take effect.
+void mCoreBatchSetVideoBuffers(struct mCoreBatch*, color_t* buffer, size_t stride);
+void mCoreBatchReset(struct mCoreBatch*);
+
+// Instances that aren't rendering leave their part of the buffer untouched
+void mCoreBatchSetRendering(struct mCoreBatch*, size_t instance, bool enable);
+
+// keys holds one entry per instance, or is NULL to keep the previous keys
+void mCoreBatchRunFrame(struct mCoreBatch*, const uint32_t* keys);
+
+CXX_GUARD_END
+
+#endif
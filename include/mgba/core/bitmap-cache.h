@@ -55,7 +55,8 @@ void mBitmapCacheConfigureSystem(struct mBitmapCache* cache, mBitmapCacheSystemI
 void mBitmapCacheWriteVRAM(struct mBitmapCache* cache, uint32_t address);
 void mBitmapCacheWritePalette(struct mBitmapCache* cache, uint32_t entry, color_t color);
 
-void mBitmapCacheCleanRow(struct mBitmapCache* cache, struct mBitmapCacheEntry* entry, unsigned y);
+// Returns whether the row changed since entry last saw it
+bool mBitmapCacheCleanRow(struct mBitmapCache* cache, struct mBitmapCacheEntry* entry, unsigned y);
 bool mBitmapCacheCheckRow(struct mBitmapCache* cache, const struct mBitmapCacheEntry* entry, unsigned y);
 const color_t* mBitmapCacheGetRow(struct mBitmapCache* cache, unsigned y);
 
@@ -35,6 +35,10 @@ void blip_add_delta( blip_t*, unsigned int clock_time, int delta );
 /** Same as blip_add_delta(), but uses faster, lower-quality synthesis. */
 void blip_add_delta_fast( blip_t*, unsigned int clock_time, int delta );
 
+/** Same as blip_add_delta_fast(), but places the whole delta on the nearest
+output sample instead of interpolating between two. */
+void blip_add_delta_nearest( blip_t*, unsigned int clock_time, int delta );
+
 /** Length of time frame, in clocks, needed to make sample_count additional
 samples available. */
 int blip_clocks_needed( const blip_t*, int sample_count );
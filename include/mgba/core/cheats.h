@@ -44,9 +44,29 @@ struct mCheat {
 	int32_t operandOffset;
 };
 
+// A cheat as run by mCheatRefresh, with its memory accesses resolved ahead of time
+struct mCheatOp {
+	// What the op was compiled from, so edits to the cheat are noticed
+	struct mCheat cheat;
+	// Index into the device's regions that every access of the op falls in, or -1 for the bus
+	int region;
+};
+
+#define M_CHEAT_MAX_REGIONS 4
+
+// RAM that compiled cheats may access directly instead of going over the bus
+struct mCheatRegion {
+	uint32_t start;
+	uint32_t size;
+	uint32_t mask;
+	// NULL whenever accesses must go over the bus, e.g. while watchpoints are set
+	uint8_t* data;
+};
+
 mLOG_DECLARE_CATEGORY(CHEATS);
 
 DECLARE_VECTOR(mCheatList, struct mCheat);
+DECLARE_VECTOR(mCheatOpList, struct mCheatOp);
 
 struct mCheatDevice;
 struct mCheatSet {
@@ -67,6 +87,8 @@ struct mCheatSet {
 	char* name;
 	bool enabled;
 	struct StringList lines;
+
+	struct mCheatOpList ops;
 };
 
 DECLARE_VECTOR(mCheatSets, struct mCheatSet*);
@@ -76,10 +98,21 @@ struct mCheatDevice {
 	struct mCore* p;
 
 	struct mCheatSet* (*createSet)(struct mCheatDevice*, const char* name);
+	void (*deinit)(struct mCheatDevice*);
+
+	// Fills in the data pointers of the regions; their addresses must never change
+	void (*mapRegions)(struct mCheatDevice*);
+	// Called after a cheat writes to a region directly
+	void (*written)(struct mCheatDevice*, uint32_t address, int width);
 
 	struct mCheatSets cheats;
+	// Bumped whenever sets are added or removed
+	unsigned revision;
 	bool autosave;
 	bool buttonDown;
+
+	struct mCheatRegion regions[M_CHEAT_MAX_REGIONS];
+	size_t nRegions;
 };
 
 struct VFile;
@@ -33,9 +33,15 @@ struct mCoreOptions {
 	int frameskip;
 	bool rewindEnable;
 	int rewindBufferCapacity;
+	// In megabytes, or 0 for no limit
+	int rewindBufferMemory;
+	// Keep a small copy of each rewound frame, so rewinding plays them back instead of emulating
+	bool rewindFrames;
 	float fpsTarget;
 	size_t audioBuffers;
 	unsigned sampleRate;
+	// Threads used to decode compressed archives, or 0 for one per core
+	int archiveThreads;
 
 	int fullscreen;
 	int width;
@@ -52,6 +58,9 @@ struct mCoreOptions {
 	char* screenshotPath;
 	char* patchPath;
 	char* cheatsPath;
+	char* romCachePath;
+	// In megabytes, or 0 for no limit
+	int romCacheSize;
 
 	int volume;
 	bool mute;
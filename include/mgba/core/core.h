@@ -40,6 +40,7 @@ struct mCoreConfig;
 struct mCoreSync;
 struct mDebuggerSymbols;
 struct mStateExtdata;
+struct mStateRegion;
 struct mVideoLogContext;
 struct mCore {
 	void* cpu;
@@ -72,14 +73,21 @@ struct mCore {
 
 	void (*desiredVideoDimensions)(struct mCore*, unsigned* width, unsigned* height);
 	void (*setVideoBuffer)(struct mCore*, color_t* buffer, size_t stride);
+	// Format of the buffers passed to setVideoBuffer after this, mCOLOR_NATIVE to begin with; fails if
+	// the core can't draw in it. putPixels still takes color_t.
+	bool (*setVideoBufferFormat)(struct mCore*, enum mColorFormat format);
 	void (*setVideoGLTex)(struct mCore*, unsigned texid);
+	// Maps all 32768 BGR555 colors to output colors, e.g. for color correction; NULL restores the plain conversion
+	void (*setVideoColorTable)(struct mCore*, const color_t* table);
 
 	void (*getPixels)(struct mCore*, const void** buffer, size_t* stride);
 	void (*putPixels)(struct mCore*, const void* buffer, size_t stride);
+	bool (*videoFrameChanged)(struct mCore*);
 
 	struct blip_t* (*getAudioChannel)(struct mCore*, int ch);
 	void (*setAudioBufferSize)(struct mCore*, size_t samples);
 	size_t (*getAudioBufferSize)(struct mCore*);
+	void (*setAudioMuted)(struct mCore*, bool muted);
 
 	void (*addCoreCallbacks)(struct mCore*, struct mCoreCallbacks*);
 	void (*clearCoreCallbacks)(struct mCore*);
@@ -105,6 +113,20 @@ struct mCore {
 	size_t (*stateSize)(struct mCore*);
 	bool (*loadState)(struct mCore*, const void* state);
 	bool (*saveState)(struct mCore*, void* state);
+	// Sets the bits of the pages of the first size bytes of a state that may have changed since
+	// the previous call, see M_STATE_PAGE_SIZE. Returns false if the core can't tell.
+	bool (*collectDirtyState)(struct mCore*, uint32_t* pages, size_t size);
+	// Continues from the live state of source, which must be the same kind of core with the same
+	// ROM loaded, without serializing its memory. NULL if the core can't; see mCoreCopyState.
+	bool (*copyState)(struct mCore*, struct mCore* source);
+	// Lists where each mStateRegion lives in the state, so that it can be diffed or copied on its
+	// own. Cores that can only save and load the whole state leave these NULL.
+	size_t (*listStateRegions)(struct mCore*, const struct mStateRegion** regions);
+	bool (*saveStateRegions)(struct mCore*, void* state, uint32_t regions);
+	bool (*loadStateRegions)(struct mCore*, const void* state, uint32_t regions);
+	// Hashes the live emulated state, e.g. to compare netplay peers every frame. Two cores running
+	// the same game in sync hash the same, on any host. NULL if the core can't.
+	uint64_t (*stateHash)(struct mCore*);
 
 	void (*setKeys)(struct mCore*, uint32_t keys);
 	void (*addKeys)(struct mCore*, uint32_t keys);
@@ -163,6 +185,8 @@ struct mCore {
 #ifndef MINIMAL_CORE
 	void (*startVideoLog)(struct mCore*, struct mVideoLogContext*);
 	void (*endVideoLog)(struct mCore*);
+	// Only set on video log players; returns the frame playback actually resumes from
+	uint32_t (*seekVideoLog)(struct mCore*, uint32_t frame);
 #endif
 };
 
@@ -188,8 +212,19 @@ void mCoreDeleteState(struct mCore* core, int slot);
 void mCoreTakeScreenshot(struct mCore* core);
 #endif
 
+struct mCoreROMInfo {
+	enum mPlatform platform;
+	char title[17];
+	char code[9];
+	size_t size;
+	uint32_t crc32;
+};
+
 struct mCore* mCoreFindVF(struct VFile* vf);
 enum mPlatform mCoreIsCompatible(struct VFile* vf);
+// Reads what a loaded core would report as its title, code and checksum from the file
+// alone, without creating a core. Returns false if the file needs a core to tell.
+bool mCoreIdentifyVF(struct VFile* vf, struct mCoreROMInfo* info);
 
 bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags);
 bool mCoreLoadStateNamed(struct mCore* core, struct VFile* vf, int flags);
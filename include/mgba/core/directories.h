@@ -22,6 +22,11 @@ struct mDirectorySet {
 	struct VDir* state;
 	struct VDir* screenshot;
 	struct VDir* cheats;
+	// Archived ROMs are decompressed into here the first time they are opened, and the
+	// decompressed copy is opened directly from then on. The least recently used copies are
+	// deleted once the cache grows past romCacheLimit bytes, if set.
+	struct VDir* romCache;
+	size_t romCacheLimit;
 };
 
 void mDirectorySetInit(struct mDirectorySet* dirs);
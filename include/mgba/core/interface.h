@@ -80,10 +80,40 @@ enum mColorFormat {
 	mCOLOR_ANY    = -1
 };
 
+// The format color_t is in
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+#define mCOLOR_NATIVE mCOLOR_RGB565
+#else
+#define mCOLOR_NATIVE mCOLOR_BGR5
+#endif
+#else
+#define mCOLOR_NATIVE mCOLOR_XBGR8
+#endif
+
+typedef void (*mColorRowConverter)(void* dst, const color_t* src, size_t count);
+
+// Picked once for a whole buffer, so that nothing branches on the format per pixel. Returns NULL
+// for mCOLOR_NATIVE, which needs no conversion, and for formats that can't be converted to.
+mColorRowConverter mColorGetRowConverter(enum mColorFormat format);
+unsigned mColorFormatBytes(enum mColorFormat format);
+
 enum mCoreFeature {
 	mCORE_FEATURE_OPENGL = 1,
 };
 
+// Zero is left free so overrides can mean "no limit"
+enum mCoreAccuracy {
+	// Everything the core knows how to emulate
+	mCORE_ACCURACY_ACCURATE = 1,
+	// Drops behavior that only test ROMs are known to check
+	mCORE_ACCURACY_BALANCED,
+	// Also drops timing details most games tolerate
+	mCORE_ACCURACY_FAST,
+};
+
+enum mCoreAccuracy mCoreAccuracyFromName(const char* name);
+
 struct mCoreCallbacks {
 	void* context;
 	void (*videoFrameStarted)(void* context);
@@ -0,0 +1,52 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef M_LOG_BUFFER_H
+#define M_LOG_BUFFER_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba/core/log.h>
+#include <mgba-util/ring-fifo.h>
+
+#define mLOG_BUFFER_MESSAGE_SIZE 244
+
+struct mLogBufferEntry {
+	int32_t category;
+	int32_t level;
+	// How many times in a row the message was logged
+	uint32_t repeats;
+	char message[mLOG_BUFFER_MESSAGE_SIZE];
+};
+
+// Carries log messages from one thread to another without either ever waiting on the other.
+// The producer holds on to its latest message, so a run of identical ones goes out as a single
+// entry with a repeat count, and only hands it over once a different message comes along or it
+// commits. Messages that don't fit are dropped and counted instead of blocking.
+struct mLogBuffer {
+	struct RingFIFO fifo;
+	struct mLogBufferEntry held;
+	bool hasHeld;
+	int dropped;
+};
+
+void mLogBufferInit(struct mLogBuffer*, size_t entries);
+void mLogBufferDeinit(struct mLogBuffer*);
+
+// Producer side
+void mLogBufferPost(struct mLogBuffer*, int category, enum mLogLevel level, const char* format, va_list args);
+// Hands over the held message, if any; meant to be called once a frame
+void mLogBufferCommit(struct mLogBuffer*);
+
+// Consumer side
+bool mLogBufferRead(struct mLogBuffer*, struct mLogBufferEntry* entry);
+// Returns the number of messages dropped since the last call
+int mLogBufferTakeDropped(struct mLogBuffer*);
+
+CXX_GUARD_END
+
+#endif
@@ -24,11 +24,19 @@ enum mLogLevel {
 	mLOG_ALL = 0x7F
 };
 
+#define mLOG_MAX_CATEGORY 64
+
+// Levels to build logging in for at all; the rest compile down to nothing
+#ifndef M_LOG_LEVELS
+#define M_LOG_LEVELS mLOG_ALL
+#endif
+
 struct Table;
 struct mLogFilter {
 	int defaultLevels;
 	struct Table categories;
 	struct Table levels;
+	struct mLogFilter* next;
 };
 
 struct mLogger {
@@ -48,6 +56,7 @@ void mLogFilterInit(struct mLogFilter*);
 void mLogFilterDeinit(struct mLogFilter*);
 void mLogFilterLoad(struct mLogFilter*, const struct mCoreConfig*);
 void mLogFilterSave(const struct mLogFilter*, struct mCoreConfig*);
+void mLogFilterSetDefaultLevels(struct mLogFilter*, int levels);
 void mLogFilterSet(struct mLogFilter*, const char* category, int levels);
 void mLogFilterReset(struct mLogFilter*, const char* category);
 bool mLogFilterTest(const struct mLogFilter*, int category, enum mLogLevel level);
@@ -56,7 +65,22 @@ int mLogFilterLevels(const struct mLogFilter*, int category);
 ATTRIBUTE_FORMAT(printf, 3, 4)
 void mLog(int category, enum mLogLevel level, const char* format, ...);
 
-#define mLOG(CATEGORY, LEVEL, ...) mLog(_mLOG_CAT_ ## CATEGORY, mLOG_ ## LEVEL, __VA_ARGS__)
+// Levels of each category that every live filter turns away, kept up to date as filters change.
+// Loggers without a filter don't count, so they only see what the filters let through, except
+// while there are no filters at all.
+MGBA_EXPORT extern int mLogDisabledLevels[mLOG_MAX_CATEGORY];
+
+static inline bool mLogLevelEnabled(int category, enum mLogLevel level) {
+	return (unsigned) category >= mLOG_MAX_CATEGORY || !(mLogDisabledLevels[category] & level);
+}
+
+// Messages that no filter would let through are turned away before their arguments are evaluated
+#define mLOG(CATEGORY, LEVEL, ...) \
+	do { \
+		if ((mLOG_ ## LEVEL & M_LOG_LEVELS) && mLogLevelEnabled(_mLOG_CAT_ ## CATEGORY, mLOG_ ## LEVEL)) { \
+			mLog(_mLOG_CAT_ ## CATEGORY, mLOG_ ## LEVEL, __VA_ARGS__); \
+		} \
+	} while (0)
 
 #define mLOG_DECLARE_CATEGORY(CATEGORY) extern int _mLOG_CAT_ ## CATEGORY;
 #define mLOG_DEFINE_CATEGORY(CATEGORY, NAME, ID) \
@@ -69,7 +69,8 @@ void mMapCacheWriteVRAM(struct mMapCache* cache, uint32_t address);
 uint32_t mMapCacheTileId(struct mMapCache* cache, unsigned x, unsigned y);
 
 bool mMapCacheCheckTile(struct mMapCache* cache, const struct mMapCacheEntry* entry, unsigned x, unsigned y);
-void mMapCacheCleanTile(struct mMapCache* cache, struct mMapCacheEntry* entry, unsigned x, unsigned y);
+// Returns whether the tile was redrawn, i.e. it changed since entry last saw it
+bool mMapCacheCleanTile(struct mMapCache* cache, struct mMapCacheEntry* entry, unsigned x, unsigned y);
 
 void mMapCacheCleanRow(struct mMapCache* cache, unsigned y);
 const color_t* mMapCacheGetRow(struct mMapCache* cache, unsigned y);
@@ -53,10 +53,36 @@ struct mCoreMemorySearchResult {
 
 DECLARE_VECTOR(mCoreMemorySearchResults, struct mCoreMemorySearchResult);
 
+// Candidates for an integer search kept as one bit per aligned address, with a copy of
+// the memory they were last compared against, for result sets too large to list
+struct mCoreMemorySearchSnapshotBlock {
+	size_t id;
+	uint32_t start;
+	size_t size;
+	uint8_t* values;
+	uint32_t* candidates;
+	size_t count;
+};
+
+DECLARE_VECTOR(mCoreMemorySearchSnapshotBlocks, struct mCoreMemorySearchSnapshotBlock);
+
+struct mCoreMemorySearchSnapshot {
+	int width;
+	struct mCoreMemorySearchSnapshotBlocks blocks;
+};
+
 struct mCore;
 void mCoreMemorySearch(struct mCore* core, const struct mCoreMemorySearchParams* params, struct mCoreMemorySearchResults* out, size_t limit);
 void mCoreMemorySearchRepeat(struct mCore* core, const struct mCoreMemorySearchParams* params, struct mCoreMemorySearchResults* inout);
 
+void mCoreMemorySearchSnapshotInit(struct mCoreMemorySearchSnapshot*);
+void mCoreMemorySearchSnapshotDeinit(struct mCoreMemorySearchSnapshot*);
+void mCoreMemorySearchSnapshotClear(struct mCoreMemorySearchSnapshot*);
+void mCoreMemorySearchSnapshotTake(struct mCore* core, const struct mCoreMemorySearchParams* params, struct mCoreMemorySearchSnapshot* snapshot);
+void mCoreMemorySearchSnapshotRepeat(struct mCore* core, const struct mCoreMemorySearchParams* params, struct mCoreMemorySearchSnapshot* snapshot);
+size_t mCoreMemorySearchSnapshotSize(const struct mCoreMemorySearchSnapshot* snapshot);
+size_t mCoreMemorySearchSnapshotResults(const struct mCoreMemorySearchSnapshot* snapshot, struct mCoreMemorySearchResults* out, size_t limit);
+
 CXX_GUARD_END
 
 #endif
@@ -0,0 +1,50 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef CORE_MEM_WATCH_H
+#define CORE_MEM_WATCH_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba-util/vector.h>
+
+struct mCore;
+
+struct mCoreMemoryRead {
+	uint32_t address;
+	int width;
+};
+
+DECLARE_VECTOR(mCoreMemoryReadList, struct mCoreMemoryRead);
+
+// Bytes a batch of reads fills; entries with a width other than 1, 2 or 4 take none
+size_t mCoreMemoryReadBatchSize(const struct mCoreMemoryRead* reads, size_t nReads);
+// Reads every entry over the bus, in order, packing the values little-endian into out.
+// Returns the number of bytes written.
+size_t mCoreMemoryReadBatch(struct mCore*, const struct mCoreMemoryRead* reads, size_t nReads, void* out);
+
+// A fixed list of reads with a buffer holding the values they returned when last taken,
+// meant to be taken once per frame so scripts can look at everything without going back to the core
+struct mCoreMemoryWatchSet {
+	struct mCoreMemoryReadList reads;
+	uint8_t* values;
+	size_t size;
+	size_t capacity;
+	uint32_t frame;
+};
+
+void mCoreMemoryWatchSetInit(struct mCoreMemoryWatchSet*);
+void mCoreMemoryWatchSetDeinit(struct mCoreMemoryWatchSet*);
+void mCoreMemoryWatchSetClear(struct mCoreMemoryWatchSet*);
+
+// Returns the offset of the value within the buffer, or -1 for an invalid width
+ssize_t mCoreMemoryWatchSetAdd(struct mCoreMemoryWatchSet*, uint32_t address, int width);
+void mCoreMemoryWatchSetTake(struct mCore*, struct mCoreMemoryWatchSet*);
+
+CXX_GUARD_END
+
+#endif
@@ -0,0 +1,68 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef M_CORE_QUICK_SAVE_H
+#define M_CORE_QUICK_SAVE_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#ifndef DISABLE_THREADING
+#include <mgba-util/threading.h>
+#endif
+
+#define M_QUICK_SAVE_MAX_SLOTS 4
+
+struct mCore;
+struct VFile;
+struct mCoreQuickSaveSlot {
+	struct VFile* state;
+	// Zero while the slot is empty or being filled
+	uint64_t sequence;
+	// Whether the state still has to be persisted
+	bool pending;
+};
+
+// Savestates are taken into memory and persisted to <base>.qs<slot> later, on a thread if requested.
+// Slots are used in rotation so an interrupted write only ever loses the newest file.
+//
+// With deltaInterval set, only every deltaInterval + 1th state is persisted in full. The ones in
+// between are appended to <base>.qd<slot> as deltas against the state persisted before them, and
+// the chain is restarted in the other file slot, leaving the previous one intact until the new
+// base is complete.
+struct mCoreQuickSaveContext {
+	struct mCoreQuickSaveSlot slots[M_QUICK_SAVE_MAX_SLOTS];
+	size_t nSlots;
+	uint64_t sequence;
+	struct mCore* core;
+	size_t deltaInterval;
+
+	// Only touched by whoever persists states
+	struct VFile* persisted;
+	struct VFile* scratch;
+	size_t baseSlot;
+	size_t deltas;
+
+#ifndef DISABLE_THREADING
+	bool onThread;
+	Thread thread;
+	Condition cond;
+	Mutex mutex;
+	// Index of the slot the writer is persisting, or nSlots
+	size_t writing;
+#endif
+};
+
+void mCoreQuickSaveContextInit(struct mCoreQuickSaveContext*, size_t slots, bool onThread);
+void mCoreQuickSaveContextDeinit(struct mCoreQuickSaveContext*);
+
+bool mCoreQuickSaveTake(struct mCoreQuickSaveContext*, struct mCore*, int flags);
+void mCoreQuickSaveFlush(struct mCoreQuickSaveContext*);
+bool mCoreQuickSaveRestore(struct mCoreQuickSaveContext*, struct mCore*, int flags);
+
+CXX_GUARD_END
+
+#endif
@@ -10,21 +10,55 @@
 
 CXX_GUARD_START
 
-#include <mgba-util/vector.h>
+#include <mgba/core/interface.h>
+
 #ifndef DISABLE_THREADING
 #include <mgba-util/threading.h>
 #endif
 
-DECLARE_VECTOR(mCoreRewindPatches, struct PatchFast);
+#define M_REWIND_KEYFRAME_INTERVAL 32
+#define M_REWIND_FRAME_SHIFT 1
+
+// Entries are stored as run-length coded XORs: keyframes against an empty state,
+// the rest against the entry before them. The oldest entry is always a keyframe.
+struct mCoreRewindEntry {
+	void* data;
+	size_t size;
+	// Bytes of state covered, which may include zero padding
+	size_t length;
+	bool keyframe;
+	// What was on screen when the state was taken, scaled down, or NULL if frames aren't kept
+	color_t* frame;
+	unsigned frameWidth;
+	unsigned frameHeight;
+};
 
 struct VFile;
 struct mCoreRewindContext {
-	struct mCoreRewindPatches patchMemory;
-	size_t current;
+	struct mCoreRewindEntry* entries;
+	size_t capacity;
+	size_t first;
 	size_t size;
+	// Bytes of encoded entries kept at most, or 0 to only limit the entry count
+	size_t memoryLimit;
+	size_t memoryUsed;
+	void* encodeBuffer;
+	size_t encodeBufferSize;
+	// Pages of the current state that may differ from the previous one, covering dirtySize bytes
+	uint32_t* dirtyPages;
+	size_t dirtyPagesSize;
+	size_t dirtySize;
 	struct VFile* previousState;
 	struct VFile* currentState;
 
+	// Keeping frames lets reverse playback show them instead of emulating each one again.
+	// They are scaled down by 1 << frameShift each way and count towards memoryLimit.
+	bool storeFrames;
+	unsigned frameShift;
+	color_t* pendingFrame;
+	unsigned pendingWidth;
+	unsigned pendingHeight;
+
 #ifndef DISABLE_THREADING
 	bool onThread;
 	Thread thread;
@@ -37,10 +71,25 @@ struct mCoreRewindContext {
 void mCoreRewindContextInit(struct mCoreRewindContext*, size_t entries, bool onThread);
 void mCoreRewindContextDeinit(struct mCoreRewindContext*);
 
+// The entry coding, for other users of state deltas. A NULL base encodes a keyframe.
+// Encoding writes at most mCoreRewindEncodeBound(words) words and returns how many it wrote;
+// applying returns false if the data doesn't fit the state.
+size_t mCoreRewindEncodeBound(size_t words);
+size_t mCoreRewindEncode(uint32_t* out, const uint32_t* base, const uint32_t* state, size_t words, const uint32_t* dirty, size_t dirtyPages);
+bool mCoreRewindApply(uint32_t* state, size_t stateWords, const uint32_t* data, size_t words);
+
 struct mCore;
 void mCoreRewindAppend(struct mCoreRewindContext*, struct mCore*);
 bool mCoreRewindRestore(struct mCoreRewindContext*, struct mCore*);
 
+// Reverse playback: stepping drops the newest entry like restoring does, but leaves the core alone.
+// The frame of the state stepped to can then be drawn, scaled back up, at full size into a buffer
+// of color_t; drawing returns false if there is no frame. The state landed on has to be loaded
+// into the core before it runs or appends again.
+bool mCoreRewindStep(struct mCoreRewindContext*);
+bool mCoreRewindDrawFrame(struct mCoreRewindContext*, color_t* pixels, size_t stride);
+bool mCoreRewindLoad(struct mCoreRewindContext*, struct mCore*);
+
 CXX_GUARD_END
 
 #endif
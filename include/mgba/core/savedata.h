@@ -0,0 +1,82 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef M_SAVEDATA_H
+#define M_SAVEDATA_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#ifndef DISABLE_THREADING
+#include <mgba-util/threading.h>
+#endif
+
+enum mSavedataDurability {
+	// Savedata is only written back when it is unmapped, e.g. when the game is unloaded
+	mSAVEDATA_DURABILITY_NEVER = 0,
+	// Batches flushes so the file is synced at most every mSAVEDATA_LAZY_INTERVAL frames
+	mSAVEDATA_DURABILITY_LAZY,
+	// Syncs the file every time the game stops writing to it
+	mSAVEDATA_DURABILITY_FLUSH,
+	// Syncs the file once, when the game is unloaded
+	mSAVEDATA_DURABILITY_EXIT,
+};
+
+enum mSavedataDirty {
+	mSAVEDATA_DIRT_NEW = 1,
+	mSAVEDATA_DIRT_SEEN = 2
+};
+
+#define mSAVEDATA_CLEANUP_THRESHOLD 15
+#define mSAVEDATA_LAZY_INTERVAL 600
+
+struct VFile;
+
+// Tracks when savedata stops changing and syncs it, off the emulation thread if threading is available
+struct mSavedataFlusher {
+	enum mSavedataDurability durability;
+	int dirty;
+	uint32_t dirtAge;
+	uint32_t lastFlush;
+	// Bumped every time the savedata settles after a write, for anything mirroring it to compare against
+	uint32_t generation;
+
+	bool unsynced;
+	struct VFile* vf;
+	const void* data;
+	size_t size;
+
+#ifndef DISABLE_THREADING
+	bool onThread;
+	bool busy;
+	Thread thread;
+	Condition cond;
+	Mutex mutex;
+#endif
+};
+
+void mSavedataFlusherInit(struct mSavedataFlusher*);
+void mSavedataFlusherDeinit(struct mSavedataFlusher*);
+void mSavedataFlusherReset(struct mSavedataFlusher*);
+
+static inline void mSavedataFlusherMarkDirty(struct mSavedataFlusher* flusher) {
+	flusher->dirty |= mSAVEDATA_DIRT_NEW;
+}
+
+// Call once per frame; returns true once the savedata has settled and should be flushed
+bool mSavedataFlusherPoll(struct mSavedataFlusher*, uint32_t frameCount);
+// The data must stay mapped until mSavedataFlusherWait returns
+void mSavedataFlusherFlush(struct mSavedataFlusher*, struct VFile* vf, const void* data, size_t size);
+// Must be called before the VFile is touched from the emulation thread again
+void mSavedataFlusherWait(struct mSavedataFlusher*);
+// Waits for pending flushes and syncs the file if the durability requires it
+void mSavedataFlusherFinish(struct mSavedataFlusher*, struct VFile* vf, const void* data, size_t size);
+
+enum mSavedataDurability mSavedataDurabilityFromName(const char* name);
+
+CXX_GUARD_END
+
+#endif
@@ -10,12 +10,18 @@
 
 CXX_GUARD_START
 
+#include <mgba/core/interface.h>
+#ifndef DISABLE_THREADING
+#include <mgba-util/threading.h>
+#endif
+
 enum mStateExtdataTag {
 	EXTDATA_NONE = 0,
 	EXTDATA_SCREENSHOT = 1,
 	EXTDATA_SAVEDATA = 2,
 	EXTDATA_CHEATS = 3,
 	EXTDATA_RTC = 4,
+	EXTDATA_THUMBNAIL = 5,
 	EXTDATA_META_TIME = 0x101,
 	EXTDATA_MAX
 };
@@ -25,6 +31,66 @@ enum mStateExtdataTag {
 #define SAVESTATE_CHEATS     4
 #define SAVESTATE_RTC        8
 #define SAVESTATE_METADATA   16
+#define SAVESTATE_THUMBNAIL  32
+
+// States without a screenshot can be wrapped in a compressed container, picked per save with
+// SAVESTATE_COMPRESS in the flags. Loading recognizes the container by itself.
+enum mStateCompression {
+	mSTATE_COMPRESSION_NONE = 0,
+	// The rewind coding, which only squeezes out runs of zeroes but runs at memory speed
+	mSTATE_COMPRESSION_RLE = 1,
+	// zlib at the given level, if built with it
+	mSTATE_COMPRESSION_ZLIB = 2,
+	mSTATE_COMPRESSION_MAX
+};
+
+#define SAVESTATE_COMPRESS(CODEC, LEVEL) ((((CODEC) & 0xF) << 8) | (((LEVEL) & 0xF) << 12))
+#define SAVESTATE_COMPRESSION_CODEC(FLAGS) (((FLAGS) >> 8) & 0xF)
+#define SAVESTATE_COMPRESSION_LEVEL(FLAGS) (((FLAGS) >> 12) & 0xF)
+
+// Thumbnails are the screen shrunk by this much in each direction, stored apart from the
+// screenshot so that state pickers can show them without reading in the rest of the state
+#define mSTATE_THUMBNAIL_SCALE 2
+
+// Memory that is serialized verbatim is tracked in pages of this size, so that
+// consumers of consecutive states only have to look at the pages that were written
+#define M_STATE_PAGE_SHIFT 8
+#define M_STATE_PAGE_SIZE (1 << M_STATE_PAGE_SHIFT)
+#define M_STATE_PAGE_WORDS(SIZE) (((((SIZE) + M_STATE_PAGE_SIZE - 1) >> M_STATE_PAGE_SHIFT) + 31) >> 5)
+
+static inline void mStatePageMark(uint32_t* pages, uint32_t offset) {
+	offset >>= M_STATE_PAGE_SHIFT;
+	pages[offset >> 5] |= 1U << (offset & 31);
+}
+
+static inline bool mStatePageIsDirty(const uint32_t* pages, size_t page) {
+	return pages[page >> 5] & (1U << (page & 31));
+}
+
+void mStatePagesMarkRange(uint32_t* pages, size_t start, size_t end);
+// Moves the dirty pages of a region serialized at the given offset into the state's pages
+void mStatePagesCollect(uint32_t* pages, size_t offset, uint32_t* regionPages, size_t regionSize);
+
+// The parts of a state that can be saved and loaded apart from the rest, e.g. for a netplay
+// resync that only needs the CPU, or a debugger that only wants VRAM. Savedata and the other
+// extdata are already picked separately through the SAVESTATE_ flags.
+enum mStateRegionId {
+	// The CPU, IO and everything else that isn't one of the memory blocks below
+	mSTATE_REGION_CORE = 1,
+	mSTATE_REGION_PALETTE_OAM = 2,
+	mSTATE_REGION_VRAM = 4,
+	mSTATE_REGION_IWRAM = 8,
+	mSTATE_REGION_WRAM = 16,
+	mSTATE_REGION_ALL = 31
+};
+
+// Where a region lives in the state; regions that are saved together are also diffed together
+struct mStateRegion {
+	uint32_t id;
+	const char* name;
+	size_t offset;
+	size_t size;
+};
 
 struct mStateExtdataItem {
 	int32_t size;
@@ -45,10 +111,65 @@ struct VFile;
 bool mStateExtdataSerialize(struct mStateExtdata* extdata, struct VFile* vf);
 bool mStateExtdataDeserialize(struct mStateExtdata* extdata, struct VFile* vf);
 
+// Always fills in the size of an EXTDATA_THUMBNAIL item, and decodes it into pixels if given
+bool mStateThumbnailDecode(const struct mStateExtdataItem* item, unsigned* width, unsigned* height, color_t* pixels, size_t stride);
+
+bool mStateCompressionAvailable(enum mStateCompression);
+// Turns "none", "rle" or "zlib", optionally followed by a colon and a level, into flags for
+// SAVESTATE_COMPRESS; anything else, or a codec that isn't built in, means no compression
+int mStateCompressionParse(const char* name);
+bool mStateIsCompressed(struct VFile* vf);
+bool mStateCompress(struct VFile* dest, struct VFile* source, int flags);
+// Returns the uncompressed contents of a compressed state, or NULL if it is damaged
+struct VFile* mStateDecompress(struct VFile* vf);
+
 struct mCore;
 bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags);
 bool mCoreLoadStateNamed(struct mCore* core, struct VFile* vf, int flags);
 void* mCoreExtractState(struct mCore* core, struct VFile* vf, struct mStateExtdata* extdata);
+// Reads only the listed extdata out of a state, seeking past the state and everything else
+bool mCoreExtractExtdata(struct mCore* core, struct VFile* vf, struct mStateExtdata* extdata, const enum mStateExtdataTag* tags, size_t nTags);
+// Uses mCore::copyState when both cores support it, and a plain save and load otherwise
+bool mCoreCopyState(struct mCore* core, struct mCore* source);
+// Only the given mSTATE_REGION_ bits of the state buffer are written or read. Saving falls back to
+// the whole state when the core can't split it up, but loading part of such a state fails.
+bool mCoreSaveStateRegions(struct mCore* core, void* state, uint32_t regions);
+bool mCoreLoadStateRegions(struct mCore* core, const void* state, uint32_t regions);
+
+// Saves states in two phases: the state, screenshot and extdata are copied out of the core
+// on the calling thread, and the thumbnail, PNG encoding and writing happen afterwards, on a
+// thread if requested.
+struct mCoreStateSaver {
+	// Called once the state is written, from the writer thread if there is one
+	void (*callback)(struct mCoreStateSaver*, int slot, bool success);
+	void* context;
+
+	struct VFile* vf;
+	int flags;
+	int slot;
+	void* state;
+	size_t stateSize;
+	void* pixels;
+	size_t pixelsSize;
+	unsigned width;
+	unsigned height;
+	struct mStateExtdata extdata;
+	struct VFile* cheats;
+
+#ifndef DISABLE_THREADING
+	bool onThread;
+	bool busy;
+	Thread thread;
+	Condition cond;
+	Mutex mutex;
+#endif
+};
+
+void mCoreStateSaverInit(struct mCoreStateSaver*, bool onThread);
+void mCoreStateSaverDeinit(struct mCoreStateSaver*);
+// Takes ownership of vf; waits for the previous save first if it is still being written
+bool mCoreStateSaverSave(struct mCoreStateSaver*, struct mCore* core, struct VFile* vf, int flags, int slot);
+void mCoreStateSaverWait(struct mCoreStateSaver*);
 
 CXX_GUARD_END
 
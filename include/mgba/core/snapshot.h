@@ -0,0 +1,76 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef CORE_SNAPSHOT_H
+#define CORE_SNAPSHOT_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba-util/threading.h>
+
+#define mCORE_SNAPSHOT_MAX_REGIONS 16
+#define mCORE_SNAPSHOT_MAX_CONSUMERS 32
+
+struct mCore;
+struct mCoreMemoryBlock;
+
+struct mCoreSnapshotRegion {
+	const struct mCoreMemoryBlock* block;
+	uint8_t* buffers[2];
+	size_t size;
+	int front;
+	// Frame the front buffer was taken on, or -1 if it never has been
+	int64_t frame;
+	uint32_t generation;
+};
+
+// Read-only copies of the core's writable memory blocks, taken by the emulation thread when it
+// publishes (once per frame) so that inspection tools can look at them without interrupting it.
+// Each region is double-buffered: publishing fills the back buffer and then swaps it to the front,
+// and readers hold the front while they look at it. Only regions some consumer asked for since
+// the last publish get copied, so the cost is only paid while a tool is actually watching.
+struct mCoreSnapshot {
+	struct mCore* core;
+	Mutex mutex;
+	struct mCoreSnapshotRegion regions[mCORE_SNAPSHOT_MAX_REGIONS];
+	size_t nRegions;
+
+	uint32_t consumers[mCORE_SNAPSHOT_MAX_CONSUMERS];
+	uint32_t usedConsumers;
+	uint32_t pendingConsumers;
+	int64_t frame;
+};
+
+void mCoreSnapshotInit(struct mCoreSnapshot*, struct mCore*);
+void mCoreSnapshotDeinit(struct mCoreSnapshot*);
+
+// Index of the region holding the memory block with that internal name, or -1 if there is none
+ssize_t mCoreSnapshotFindRegion(const struct mCoreSnapshot*, const char* name);
+
+// Registers a consumer interested in the regions named, terminated by a NULL. Returns its id,
+// or -1 if there are too many consumers or none of the names matched.
+int mCoreSnapshotAddConsumer(struct mCoreSnapshot*, const char* const* names);
+void mCoreSnapshotRemoveConsumer(struct mCoreSnapshot*, int consumer);
+// Asks for the consumer's regions to be copied again at the next publish
+void mCoreSnapshotRequest(struct mCoreSnapshot*, int consumer);
+
+// Only to be called from the emulation thread, or while it is interrupted
+void mCoreSnapshotPublish(struct mCoreSnapshot*);
+
+// Holds every region's front buffer until mCoreSnapshotRelease, which must come soon, since
+// publishing waits on it, and must come even if this returns NULL for a region never taken.
+const void* mCoreSnapshotAcquire(struct mCoreSnapshot*, size_t region, size_t* size, int64_t* frame);
+void mCoreSnapshotRelease(struct mCoreSnapshot*);
+// Counts how many times a region has been taken, telling a fresh copy apart from one already seen
+uint32_t mCoreSnapshotGeneration(struct mCoreSnapshot*, size_t region);
+
+// Copies out of a region's front buffer, returning false if the range hasn't been taken
+bool mCoreSnapshotRead(struct mCoreSnapshot*, size_t region, size_t offset, void* out, size_t size);
+
+CXX_GUARD_END
+
+#endif
@@ -10,8 +10,38 @@
 
 CXX_GUARD_START
 
+#include <mgba/core/interface.h>
+#include <mgba-util/ring-fifo.h>
 #include <mgba-util/threading.h>
 
+#define mCORE_SYNC_FRAME_BUFFERS 3
+#define mCORE_SYNC_FRAME_STRIDE 256
+#define mCORE_SYNC_AUDIO_CHUNK 32
+#define mCORE_SYNC_AUDIO_RATE_DRIFT 0.005
+#define mCORE_SYNC_AUDIO_HISTOGRAM 8
+
+struct mCoreSyncFrame {
+	// Rows are mCORE_SYNC_FRAME_STRIDE pixels apart
+	color_t* pixels;
+	unsigned width;
+	unsigned height;
+	// Counts published frames, so a display can tell how many it missed
+	uint32_t sequence;
+};
+
+// Audio telemetry, for telling a slow emulator apart from a badly sized buffer. The producer
+// counts overruns and time spent blocked; the reader counts underruns and samples the fill.
+struct mCoreSyncAudioStats {
+	uint32_t reads;
+	uint32_t underruns;
+	// Times the producer found the buffer full and had to leave samples behind
+	uint32_t overruns;
+	uint32_t blocks;
+	int64_t blockedTime;
+	// Buffer fill at each read, bucketed into equal parts of its capacity
+	uint32_t occupancy[mCORE_SYNC_AUDIO_HISTOGRAM];
+};
+
 struct mCoreSync {
 	int videoFramePending;
 	bool videoFrameWait;
@@ -25,6 +55,48 @@ struct mCoreSync {
 	Mutex audioBufferMutex;
 
 	float fpsTarget;
+
+	// Power saving: frames that change nothing on screen are held to fpsTarget by sleeping out
+	// the rest of the frame period. The counters cover every frame since it was turned on.
+	bool powerSave;
+	int64_t powerSaveLastFrame;
+	uint32_t powerSaveFrames;
+	uint32_t powerSaveThrottled;
+	int64_t paceLastFrame;
+
+	// Triple-buffered frame exchange: the emulation thread copies each new frame into
+	// the back buffer and swaps it with the middle one, while the display swaps the
+	// middle buffer with its front one whenever a newer frame is there. Neither side
+	// ever waits on the other.
+	bool frameExchange;
+	struct mCoreSyncFrame frames[mCORE_SYNC_FRAME_BUFFERS];
+	unsigned frameBack;
+	unsigned frameFront;
+	int frameMiddle;
+	uint32_t frameSequence;
+
+	// Lock-free audio: the emulation thread moves samples out of the blip buffers in
+	// fixed-size chunks of interleaved stereo frames, and the audio callback reads them
+	// back out of the ring without touching audioBufferMutex.
+	bool audioRingOn;
+	struct RingFIFO audioRing;
+	struct blip_t* audioLeft;
+	struct blip_t* audioRight;
+	size_t audioRingFrames;
+	// Dynamic rate control: the reader stretches or squeezes the output rate slightly so the ring
+	// hovers around half full, rather than slowly filling up or running dry
+	bool audioRateControl;
+	// Chunks that went through the ring each way; RingFIFOSize also counts the gap left by wrapping
+	int32_t audioChunksWritten;
+	int32_t audioChunksRead;
+	// Owned by the emulation thread: a chunk that didn't fit in the ring yet
+	int16_t audioPending[mCORE_SYNC_AUDIO_CHUNK * 2];
+	bool audioPendingValid;
+	// Owned by the audio thread: the chunk being read and how many frames of it are used up
+	int16_t audioChunk[mCORE_SYNC_AUDIO_CHUNK * 2];
+	unsigned audioChunkOffset;
+
+	struct mCoreSyncAudioStats audioStats;
 };
 
 void mCoreSyncPostFrame(struct mCoreSync* sync);
@@ -33,12 +105,44 @@ bool mCoreSyncWaitFrameStart(struct mCoreSync* sync);
 void mCoreSyncWaitFrameEnd(struct mCoreSync* sync);
 void mCoreSyncSetVideoSync(struct mCoreSync* sync, bool wait);
 
+void mCoreSyncSetPowerSave(struct mCoreSync* sync, bool enable);
+// Called as each frame ends; returns whether the frame was held back
+bool mCoreSyncThrottleFrame(struct mCoreSync* sync, bool idle);
+// Fraction of frames held back since power saving was turned on
+float mCoreSyncPowerSaveRatio(const struct mCoreSync* sync);
+// Holds frames that make no audio, such as rewind playback, to fpsTarget when only audio sync is on
+void mCoreSyncPaceFrame(struct mCoreSync* sync);
+
+void mCoreSyncFrameExchangeInit(struct mCoreSync* sync);
+void mCoreSyncFrameExchangeDeinit(struct mCoreSync* sync);
+void mCoreSyncPublishFrame(struct mCoreSync* sync, const color_t* pixels, size_t stride, unsigned width, unsigned height);
+// Points frame at the newest published frame; returns false if there was nothing newer than last time.
+// The frame stays valid until the next call.
+bool mCoreSyncAcquireFrame(struct mCoreSync* sync, const struct mCoreSyncFrame** frame);
+
 struct blip_t;
 bool mCoreSyncProduceAudio(struct mCoreSync* sync, const struct blip_t*, size_t samples);
 void mCoreSyncLockAudio(struct mCoreSync* sync);
 void mCoreSyncUnlockAudio(struct mCoreSync* sync);
 void mCoreSyncConsumeAudio(struct mCoreSync* sync);
 
+// Audio rates must still be set on the blip buffers under mCoreSyncLockAudio
+void mCoreSyncAudioRingInit(struct mCoreSync* sync, struct blip_t* left, struct blip_t* right, size_t frames);
+void mCoreSyncAudioRingDeinit(struct mCoreSync* sync);
+// Copies up to the requested number of interleaved stereo frames without blocking, returning how many there were
+size_t mCoreSyncReadAudio(struct mCoreSync* sync, int16_t* samples, size_t frames);
+// Frames ready for mCoreSyncReadAudio; meant for the audio thread to steer its resampling rate
+size_t mCoreSyncAudioOccupancy(const struct mCoreSync* sync);
+void mCoreSyncSetAudioRateControl(struct mCoreSync* sync, bool enable);
+// Factor to scale the output sample rate by, within mCORE_SYNC_AUDIO_RATE_DRIFT of 1; exactly 1 while rate control is off
+double mCoreSyncAudioRateRatio(const struct mCoreSync* sync);
+
+// Counters are only approximate while the threads are still running; blockedTime is in microseconds
+void mCoreSyncGetAudioStats(const struct mCoreSync* sync, struct mCoreSyncAudioStats* stats);
+void mCoreSyncResetAudioStats(struct mCoreSync* sync);
+// Records one read for audio paths outside of mCoreSync, such as a frontend's own buffer
+void mCoreSyncAudioStatsRecordRead(struct mCoreSyncAudioStats* stats, size_t fill, size_t capacity, bool underrun);
+
 CXX_GUARD_END
 
 #endif
@@ -23,6 +23,12 @@ struct mThreadLogger {
 	struct mCoreThread* p;
 };
 
+enum mCoreThreadAffinity {
+	mCORE_THREAD_AFFINITY_ANY = 0,
+	mCORE_THREAD_AFFINITY_FASTEST,
+	mCORE_THREAD_AFFINITY_CORE,
+};
+
 struct mCoreThreadInternal;
 struct mCoreThread {
 	// Input
@@ -36,14 +42,36 @@ struct mCoreThread {
 	ThreadCallback sleepCallback;
 	ThreadCallback pauseCallback;
 	ThreadCallback unpauseCallback;
+	// Called from the savestate writer thread once mCoreThreadSaveState has finished
+	void (*stateSavedCallback)(struct mCoreThread* threadContext, int slot, bool success);
 	void* userData;
 	void (*run)(struct mCoreThread*);
+	// Hand finished frames to the display through mCoreSyncAcquireFrame instead of the frame mutex
+	bool frameExchange;
+	// Hand audio to the device callback through mCoreSyncReadAudio instead of the audio mutex
+	bool audioRing;
+	// Sleep through frames that leave the screen unchanged instead of running ahead of fpsTarget
+	bool powerSave;
+	// Steer the audio ring's resampling rate to keep it half full; needs audioRing, and is meant
+	// for pacing by video sync, since audio sync alone keeps the ring full
+	bool audioRateControl;
+	// Where the emulation thread runs: wherever the OS puts it, on the fastest core, or on emulationCore
+	enum mCoreThreadAffinity emulationAffinity;
+	int emulationCore;
+	// Keep helper threads, such as rewind and rendering, off the core emulation is pinned to
+	bool isolateEmulationCore;
+	// A ThreadPriority for the emulation thread; helpers stay at normal priority
+	int emulationPriority;
+	// Poll for a little while before sleeping in mCoreThreadWaitFromThread. Meant for threads
+	// linked in lockstep, whose waits are short, when each of them has a host core to itself
+	bool spinOnWait;
 
 	struct mCoreThreadInternal* impl;
 };
 
 #ifndef OPAQUE_THREADING
 #include <mgba/core/rewind.h>
+#include <mgba/core/serialize.h>
 #include <mgba/core/sync.h>
 #include <mgba-util/threading.h>
 
@@ -82,6 +110,10 @@ struct mCoreThreadInternal {
 
 	struct mCoreSync sync;
 	struct mCoreRewindContext rewind;
+	// Reverse playback has stepped back past the state the core is in
+	bool rewindStepped;
+	color_t* rewindFrame;
+	struct mCoreStateSaver stateSaver;
 };
 
 #endif
@@ -113,6 +145,9 @@ void mCoreThreadStopWaiting(struct mCoreThread* threadContext);
 void mCoreThreadSetRewinding(struct mCoreThread* threadContext, bool);
 void mCoreThreadRewindParamsChanged(struct mCoreThread* threadContext);
 
+// Must be called from the core thread or while it is interrupted
+bool mCoreThreadSaveState(struct mCoreThread* threadContext, int slot, int flags);
+
 struct mCoreThread* mCoreThreadGet(void);
 struct mLogger* mCoreThreadLogger(void);
 
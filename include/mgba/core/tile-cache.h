@@ -23,6 +23,8 @@ DECL_BITS(mTileCacheSystemInfo, MaxTiles, 16, 13);
 struct mTileCacheEntry {
 	uint32_t paletteVersion;
 	uint32_t vramVersion;
+	// Hash of the tile data the entry was generated from, so rewriting the same data doesn't dirty it
+	uint32_t vramHash;
 	uint8_t vramClean;
 	uint8_t paletteId;
 	uint16_t padding;
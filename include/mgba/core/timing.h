@@ -10,6 +10,8 @@
 
 CXX_GUARD_START
 
+#include <mgba-util/vector.h>
+
 struct mTiming;
 struct mTimingEvent {
 	void* context;
@@ -18,12 +20,68 @@ struct mTimingEvent {
 	uint32_t when;
 	unsigned priority;
 
-	struct mTimingEvent* next;
+	// Managed by the scheduler: position in the heap and insertion order,
+	// which breaks ties between events with equal time and priority
+	size_t index;
+	uint32_t order;
+};
+
+DECLARE_VECTOR(mTimingEventHeap, struct mTimingEvent*);
+
+struct mTimingEventStats {
+	const char* name;
+	uint64_t fired;
+	uint64_t scheduled;
+	// Scheduled again while still pending
+	uint64_t rescheduled;
+	// Spent in the callback, in units of the stats clock
+	uint64_t hostTime;
+};
+
+DECLARE_VECTOR(mTimingEventStatsList, struct mTimingEventStats);
+
+typedef uint64_t (*mTimingStatsClock)(void);
+
+// Where host time goes while stats are enabled, charged to exactly one of these at a time
+enum mTimingHostCategory {
+	mTIMING_HOST_CPU = 0,
+	mTIMING_HOST_EVENTS,
+	mTIMING_HOST_RENDER_SCANLINE,
+	mTIMING_HOST_RENDER_FRAME,
+	mTIMING_HOST_AUDIO,
+	mTIMING_HOST_IO,
+	mTIMING_HOST_MAX
+};
+
+// Emulated cycles spent waiting on memory while stats are enabled, split by the top byte of the
+// address and by kind of access, so that it can be weighed against the cycles spent executing
+#define mTIMING_WAIT_REGIONS 16
+
+enum mTimingWaitAccess {
+	// The fetches that refill the pipeline after a branch
+	mTIMING_WAIT_CODE_NONSEQ = 0,
+	mTIMING_WAIT_CODE_SEQ,
+	mTIMING_WAIT_DATA_NONSEQ,
+	mTIMING_WAIT_DATA_SEQ,
+	// Data accesses held up until the prefetcher was done with its current fetch
+	mTIMING_WAIT_PREFETCH_STALL,
+	// Code waitstates the prefetcher hid behind data accesses, which were never actually spent
+	mTIMING_WAIT_PREFETCH_HIDDEN,
+	mTIMING_WAIT_MAX
 };
 
 struct mTiming {
-	struct mTimingEvent* root;
-	struct mTimingEvent* reroot;
+	struct mTimingEventHeap events;
+	uint32_t nextOrder;
+	bool interrupted;
+
+	// Statistics are only gathered while a clock is set
+	mTimingStatsClock statsClock;
+	struct mTimingEventStatsList stats;
+	uint64_t hostTime[mTIMING_HOST_MAX];
+	uint64_t hostMark;
+	enum mTimingHostCategory hostCategory;
+	uint64_t waitCycles[mTIMING_WAIT_REGIONS][mTIMING_WAIT_MAX];
 
 	uint32_t masterCycles;
 	int32_t* relativeCycles;
@@ -36,10 +94,47 @@ void mTimingClear(struct mTiming* timing);
 void mTimingSchedule(struct mTiming* timing, struct mTimingEvent*, int32_t when);
 void mTimingDeschedule(struct mTiming* timing, struct mTimingEvent*);
 bool mTimingIsScheduled(const struct mTiming* timing, const struct mTimingEvent*);
+void mTimingInterrupt(struct mTiming* timing);
 int32_t mTimingTick(struct mTiming* timing, int32_t cycles);
 int32_t mTimingCurrentTime(const struct mTiming* timing);
 int32_t mTimingNextEvent(struct mTiming* timing);
 int32_t mTimingUntil(const struct mTiming* timing, const struct mTimingEvent*);
+// The latest time lazily evaluated state may catch up to without getting
+// ahead of an event that is already due but has not fired yet
+uint32_t mTimingSettledTime(const struct mTiming* timing);
+
+void mTimingEnableStats(struct mTiming* timing, mTimingStatsClock clock);
+void mTimingDisableStats(struct mTiming* timing);
+void mTimingResetStats(struct mTiming* timing);
+size_t mTimingStatsSize(const struct mTiming* timing);
+const struct mTimingEventStats* mTimingStatsGet(const struct mTiming* timing, size_t index);
+
+void mTimingHostSwitch(struct mTiming* timing, enum mTimingHostCategory category);
+uint64_t mTimingHostTime(struct mTiming* timing, enum mTimingHostCategory category);
+const char* mTimingHostCategoryName(enum mTimingHostCategory category);
+uint64_t mTimingWaitCycles(const struct mTiming* timing, unsigned region, enum mTimingWaitAccess access);
+const char* mTimingWaitAccessName(enum mTimingWaitAccess access);
+
+// Cheap enough to leave around hot paths; returns what to pass to mTimingHostLeave
+static inline enum mTimingHostCategory mTimingHostEnter(struct mTiming* timing, enum mTimingHostCategory category) {
+	enum mTimingHostCategory previous = timing->hostCategory;
+	if (timing->statsClock) {
+		mTimingHostSwitch(timing, category);
+	}
+	return previous;
+}
+
+static inline void mTimingHostLeave(struct mTiming* timing, enum mTimingHostCategory previous) {
+	if (timing->statsClock) {
+		mTimingHostSwitch(timing, previous);
+	}
+}
+
+static inline void mTimingChargeWait(struct mTiming* timing, unsigned region, enum mTimingWaitAccess access, int32_t cycles) {
+	if (timing->statsClock && region < mTIMING_WAIT_REGIONS) {
+		timing->waitCycles[region][access] += cycles;
+	}
+}
 
 CXX_GUARD_END
 
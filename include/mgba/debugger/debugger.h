@@ -77,6 +77,8 @@ struct mBreakpoint {
 	int segment;
 	enum mBreakpointType type;
 	struct ParseTree* condition;
+	// Filled in from the condition by the platform when the breakpoint is set
+	struct ParseProgram* program;
 };
 
 struct mWatchpoint {
@@ -85,13 +87,30 @@ struct mWatchpoint {
 	int segment;
 	enum mWatchpointType type;
 	struct ParseTree* condition;
+	// Filled in from the condition by the platform when the watchpoint is set
+	struct ParseProgram* program;
 };
 
 DECLARE_VECTOR(mBreakpointList, struct mBreakpoint);
 DECLARE_VECTOR(mWatchpointList, struct mWatchpoint);
 
+#define mDEBUGGER_TRACE_MAX_REGISTERS 16
+
+// One executed instruction, as captured for binary traces. The address and the
+// cycle count are those of the instruction about to run; the registers are a
+// platform-specific set, excluding the program counter.
+struct mDebuggerTraceEntry {
+	uint32_t address;
+	uint32_t opcode;
+	uint32_t cycles;
+	uint8_t opcodeSize;
+	uint8_t nRegisters;
+	uint32_t registers[mDEBUGGER_TRACE_MAX_REGISTERS];
+};
+
 struct mDebugger;
 struct ParseTree;
+struct ParseProgram;
 struct mDebuggerPlatform {
 	struct mDebugger* p;
 
@@ -110,9 +129,12 @@ struct mDebuggerPlatform {
 	void (*listWatchpoints)(struct mDebuggerPlatform*, struct mWatchpointList*);
 
 	void (*trace)(struct mDebuggerPlatform*, char* out, size_t* length);
+	void (*traceEntry)(struct mDebuggerPlatform*, struct mDebuggerTraceEntry* entry);
 
 	bool (*getRegister)(struct mDebuggerPlatform*, const char* name, int32_t* value);
 	bool (*setRegister)(struct mDebuggerPlatform*, const char* name, int32_t value);
+	// Optional. Where a register lives, if reading it doesn't need anything else done first
+	const int32_t* (*getRegisterPointer)(struct mDebuggerPlatform*, const char* name);
 	bool (*lookupIdentifier)(struct mDebuggerPlatform*, const char* name, int32_t* value, int* segment);
 };
 
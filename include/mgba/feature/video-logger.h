@@ -13,6 +13,8 @@ CXX_GUARD_START
 #include <mgba-util/circle-buffer.h>
 
 #define mVL_MAX_CHANNELS 32
+#define mVL_DEFAULT_KEYFRAME_INTERVAL 600
+#define mVL_STATS_MAX_LINES 256
 
 enum mVideoLoggerDirtyType {
 	DIRTY_DUMMY = 0,
@@ -47,6 +49,19 @@ struct mVideoLoggerDirtyInfo {
 	uint32_t value2;
 };
 
+typedef uint64_t (*mVideoLoggerStatsClock)(void);
+
+struct mVideoLoggerStats {
+	mVideoLoggerStatsClock clock;
+	// Spent drawing each scanline, including partial ranges, in units of the clock
+	uint64_t lines;
+	uint64_t lineTime;
+	uint64_t maxLineTime;
+	uint64_t lineTimeByY[mVL_STATS_MAX_LINES];
+	uint32_t linesByY[mVL_STATS_MAX_LINES];
+	uint64_t pendingTime;
+};
+
 struct VFile;
 struct mVideoLogger {
 	bool (*writeData)(struct mVideoLogger* logger, const void* data, size_t length);
@@ -82,6 +97,9 @@ struct mVideoLogger {
 
 	const void* pixelBuffer;
 	size_t pixelStride;
+
+	// Only updated by whichever thread runs the logger
+	struct mVideoLoggerStats* stats;
 };
 
 void mVideoLoggerRendererCreate(struct mVideoLogger* logger, bool readonly);
@@ -104,6 +122,9 @@ void mVideoLoggerRendererFinishFrame(struct mVideoLogger* logger);
 bool mVideoLoggerRendererRun(struct mVideoLogger* logger, bool block);
 bool mVideoLoggerRendererRunInjected(struct mVideoLogger* logger);
 
+void mVideoLoggerEnableStats(struct mVideoLogger* logger, struct mVideoLoggerStats* stats, mVideoLoggerStatsClock clock);
+void mVideoLoggerDisableStats(struct mVideoLogger* logger);
+
 struct mVideoLogContext;
 void mVideoLoggerAttachChannel(struct mVideoLogger* logger, struct mVideoLogContext* context, size_t channelId);
 
@@ -111,6 +132,8 @@ struct mCore;
 struct mVideoLogContext* mVideoLogContextCreate(struct mCore* core);
 
 void mVideoLogContextSetCompression(struct mVideoLogContext*, bool enable);
+// Saves the whole core state into the log every so many frames so playback can seek; 0 turns this off
+void mVideoLogContextSetKeyframeInterval(struct mVideoLogContext*, uint32_t frames);
 void mVideoLogContextSetOutput(struct mVideoLogContext*, struct VFile*);
 void mVideoLogContextWriteHeader(struct mVideoLogContext*, struct mCore* core);
 
@@ -119,6 +142,10 @@ void mVideoLogContextDestroy(struct mCore* core, struct mVideoLogContext*);
 
 void mVideoLogContextRewind(struct mVideoLogContext*, struct mCore*);
 void* mVideoLogContextInitialState(struct mVideoLogContext*, size_t* size);
+// Zero for logs recorded without an index
+uint32_t mVideoLogContextFrameCount(const struct mVideoLogContext*);
+// Loads the last keyframe at or before the frame and returns the frame the next run shows; playing on from there reaches the frame
+uint32_t mVideoLogContextSeek(struct mVideoLogContext*, struct mCore*, uint32_t frame);
 
 int mVideoLoggerAddChannel(struct mVideoLogContext*);
 
@@ -52,6 +52,8 @@ struct VFile;
 
 bool GBIsROM(struct VFile* vf);
 bool GBIsBIOS(struct VFile* vf);
+struct mCoreROMInfo;
+bool GBIdentifyROM(struct VFile* vf, struct mCoreROMInfo* info);
 
 enum GBModel GBNameToModel(const char*);
 const char* GBModelToName(enum GBModel);
@@ -50,6 +50,8 @@ enum {
 bool GBAIsROM(struct VFile* vf);
 bool GBAIsMB(struct VFile* vf);
 bool GBAIsBIOS(struct VFile* vf);
+struct mCoreROMInfo;
+bool GBAIdentifyROM(struct VFile* vf, struct mCoreROMInfo* info);
 
 struct GBALuminanceSource {
 	void (*sample)(struct GBALuminanceSource*);
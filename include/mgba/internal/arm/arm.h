@@ -48,6 +48,13 @@ enum ExecutionVector {
 	BASE_FIQ = 0x0000001C
 };
 
+enum ARMLazyFlags {
+	ARM_LAZY_NONE = 0,
+	ARM_LAZY_NZ = 1,
+	ARM_LAZY_ADDITION = 2,
+	ARM_LAZY_SUBTRACTION = 4
+};
+
 enum RegisterBank {
 	BANK_NONE = 0,
 	BANK_FIQ = 1,
@@ -67,6 +74,7 @@ enum LSMDirection {
 };
 
 struct ARMCore;
+struct ARMBlockCache;
 
 union PSR {
 	struct {
@@ -110,6 +118,18 @@ union PSR {
 	int32_t packed;
 };
 
+#define ARM_FAST_PAGE_SHIFT 24
+#define ARM_FAST_PAGES 0x100
+
+struct ARMFastPage {
+	uint32_t* data;
+	// Bitmap of written pages, see M_STATE_PAGE_SIZE
+	uint32_t* dirty;
+	uint32_t mask;
+	int32_t waitstates16;
+	int32_t waitstates32;
+};
+
 struct ARMMemory {
 	uint32_t (*load32)(struct ARMCore*, uint32_t address, int* cycleCounter);
 	uint32_t (*load16)(struct ARMCore*, uint32_t address, int* cycleCounter);
@@ -132,6 +152,10 @@ struct ARMMemory {
 	uint32_t activeNonseqCycles16;
 	int32_t (*stall)(struct ARMCore*, int32_t wait);
 	void (*setActiveRegion)(struct ARMCore*, uint32_t address);
+
+	// Plain RAM that loads and stores may touch directly, indexed by the top
+	// address byte. Pages without data go through the handlers above.
+	const struct ARMFastPage* fastPages;
 };
 
 struct ARMInterruptHandler {
@@ -162,6 +186,13 @@ struct ARMCore {
 	int32_t shifterOperand;
 	int32_t shifterCarryOut;
 
+	// Pending NZCV state that has not been written back to cpsr yet
+	unsigned lazyFlags;
+	uint32_t lazyResult;
+	uint32_t lazyOperand1;
+	uint32_t lazyOperand2;
+	uint32_t lazyCVResult;
+
 	uint32_t prefetch[2];
 	enum ExecutionMode executionMode;
 	enum PrivilegeMode privilegeMode;
@@ -173,6 +204,8 @@ struct ARMCore {
 
 	size_t numComponents;
 	struct mCPUComponent** components;
+
+	struct ARMBlockCache* blockCache;
 };
 
 void ARMInit(struct ARMCore* cpu);
@@ -191,6 +224,8 @@ void ARMRun(struct ARMCore* cpu);
 void ARMRunLoop(struct ARMCore* cpu);
 void ARMRunFake(struct ARMCore* cpu, uint32_t opcode);
 
+void ARMSetBlockCache(struct ARMCore* cpu, bool enable);
+
 CXX_GUARD_END
 
 #endif
@@ -0,0 +1,98 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef ARM_BLOCK_CACHE_H
+#define ARM_BLOCK_CACHE_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba/internal/arm/arm.h>
+#include <mgba/internal/arm/isa-arm.h>
+#include <mgba/internal/arm/isa-thumb.h>
+
+#define ARM_BLOCK_CACHE_SLOTS 0x1000
+#define ARM_BLOCK_MAX_LENGTH 16
+#define ARM_BLOCK_HOT_THRESHOLD 8
+#define ARM_BLOCK_CACHE_PAGE_SHIFT 8
+#define ARM_BLOCK_CACHE_PAGES 0x10000
+
+union ARMCachedHandler {
+	ARMInstruction arm;
+	ThumbInstruction thumb;
+};
+
+struct ARMCachedInstruction {
+	union ARMCachedHandler handler;
+	uint32_t opcode;
+	// The handler also executes the following instruction
+	bool fused;
+};
+
+struct ARMCachedBlock {
+	uint32_t key;
+	enum ExecutionMode mode;
+	bool valid;
+	unsigned length;
+
+	// Entry point waiting to become hot enough to replace this block
+	uint32_t candidateKey;
+	enum ExecutionMode candidateMode;
+	unsigned candidateHits;
+
+	// Two trailing entries hold the opcodes that sit in the prefetch queue
+	// while the last instruction of the block executes
+	struct ARMCachedInstruction instructions[ARM_BLOCK_MAX_LENGTH + 2];
+};
+
+struct ARMBlockCache {
+	// Set by the platform whenever the active region may be cached
+	bool activeCacheable;
+
+	struct ARMCachedBlock blocks[ARM_BLOCK_CACHE_SLOTS];
+	uint8_t codePages[ARM_BLOCK_CACHE_PAGES];
+};
+
+struct ARMBlockCache* ARMBlockCacheCreate(void);
+void ARMBlockCacheDestroy(struct ARMBlockCache*);
+void ARMBlockCacheClear(struct ARMBlockCache*);
+
+struct ARMCachedBlock* ARMBlockCacheTranslate(struct ARMBlockCache*, struct ARMCore*, uint32_t key);
+void ARMBlockCacheInvalidateRange(struct ARMBlockCache*, uint32_t key);
+
+static inline uint32_t ARMBlockCacheKey(uint32_t address, uint32_t mask) {
+	return (address & 0xFF000000) | (address & mask);
+}
+
+static inline unsigned ARMBlockCacheSlot(uint32_t key, enum ExecutionMode mode) {
+	uint32_t index = key >> (mode == MODE_THUMB ? 1 : 2);
+	return (index ^ (index >> 12) ^ (key >> 24) ^ mode) & (ARM_BLOCK_CACHE_SLOTS - 1);
+}
+
+static inline unsigned ARMBlockCachePage(uint32_t key) {
+	return ((key >> ARM_BLOCK_CACHE_PAGE_SHIFT) ^ (key >> 20)) & (ARM_BLOCK_CACHE_PAGES - 1);
+}
+
+static inline struct ARMCachedBlock* ARMBlockCacheLookup(struct ARMBlockCache* cache, struct ARMCore* cpu) {
+	uint32_t address = cpu->gprs[ARM_PC] - (cpu->executionMode == MODE_THUMB ? WORD_SIZE_THUMB : WORD_SIZE_ARM);
+	uint32_t key = ARMBlockCacheKey(address, cpu->memory.activeMask);
+	struct ARMCachedBlock* block = &cache->blocks[ARMBlockCacheSlot(key, cpu->executionMode)];
+	if (block->valid && block->key == key && block->mode == cpu->executionMode) {
+		return block;
+	}
+	return ARMBlockCacheTranslate(cache, cpu, key);
+}
+
+// Call with a key built from the canonical (unmirrored) address of a write
+static inline void ARMBlockCacheInvalidate(struct ARMBlockCache* cache, uint32_t key) {
+	if (cache && cache->codePages[ARMBlockCachePage(key)]) {
+		ARMBlockCacheInvalidateRange(cache, key);
+	}
+}
+
+CXX_GUARD_END
+
+#endif
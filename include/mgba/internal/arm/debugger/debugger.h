@@ -13,8 +13,12 @@ CXX_GUARD_START
 #include <mgba/debugger/debugger.h>
 
 #include <mgba/internal/arm/arm.h>
+#include <mgba-util/table.h>
 #include <mgba-util/vector.h>
 
+#define ARM_DEBUGGER_PAGE_BITS 12
+#define ARM_DEBUGGER_PAGE_BUCKETS 4096
+
 struct ParseTree;
 struct ARMDebugBreakpoint {
 	struct mBreakpoint d;
@@ -35,6 +39,11 @@ struct ARMDebugger {
 	struct mWatchpointList watchpoints;
 	struct ARMMemory originalMemory;
 
+	// Rebuilt whenever points change; pages share buckets, so a set bit only means "maybe"
+	struct Table breakpointIndex;
+	uint32_t breakpointPages[ARM_DEBUGGER_PAGE_BUCKETS / 32];
+	uint8_t watchpointPages[ARM_DEBUGGER_PAGE_BUCKETS];
+
 	ssize_t nextId;
 
 	void (*entered)(struct mDebugger*, enum mDebuggerEntryReason, struct mDebuggerEntryInfo*);
@@ -43,6 +52,11 @@ struct ARMDebugger {
 	void (*clearSoftwareBreakpoint)(struct ARMDebugger*, const struct ARMDebugBreakpoint*);
 };
 
+static inline unsigned ARMDebuggerPageBucket(uint32_t address) {
+	// Fold the region into the page so mirrors and neighbouring regions don't share buckets
+	return ((address >> ARM_DEBUGGER_PAGE_BITS) ^ (address >> 20)) & (ARM_DEBUGGER_PAGE_BUCKETS - 1);
+}
+
 struct mDebuggerPlatform* ARMDebuggerPlatformCreate(void);
 ssize_t ARMDebuggerSetSoftwareBreakpoint(struct mDebuggerPlatform* debugger, uint32_t address, enum ExecutionMode mode);
 
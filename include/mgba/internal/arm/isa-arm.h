@@ -17,6 +17,10 @@ struct ARMCore;
 typedef void (*ARMInstruction)(struct ARMCore*, uint32_t opcode);
 extern const ARMInstruction _armTable[0x1000];
 
+#ifdef ENABLE_THREADED_DISPATCH
+void ARMRunThreaded(struct ARMCore*);
+#endif
+
 CXX_GUARD_END
 
 #endif
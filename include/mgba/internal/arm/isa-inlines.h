@@ -8,7 +8,49 @@
 
 #include "macros.h"
 
+#include <mgba/core/serialize.h>
+
 #include "arm.h"
+#include "block-cache.h"
+
+#ifdef ENABLE_DIRECT_DISPATCH
+// GBA-only builds call the GBA handlers by name on the hot paths instead of
+// going through the tables, so nothing may swap those entries out at runtime
+uint32_t GBALoad32(struct ARMCore* cpu, uint32_t address, int* cycleCounter);
+uint32_t GBALoad16(struct ARMCore* cpu, uint32_t address, int* cycleCounter);
+uint32_t GBALoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter);
+void GBAStore32(struct ARMCore* cpu, uint32_t address, int32_t value, int* cycleCounter);
+void GBAStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycleCounter);
+void GBAStore8(struct ARMCore* cpu, uint32_t address, int8_t value, int* cycleCounter);
+uint32_t GBALoadMultiple(struct ARMCore*, uint32_t baseAddress, int mask, enum LSMDirection direction,
+                         int* cycleCounter);
+uint32_t GBAStoreMultiple(struct ARMCore*, uint32_t baseAddress, int mask, enum LSMDirection direction,
+                          int* cycleCounter);
+int32_t GBAMemoryStall(struct ARMCore* cpu, int32_t wait);
+void GBASetActiveRegion(struct ARMCore* cpu, uint32_t address);
+void GBAProcessEvents(struct ARMCore* cpu);
+void GBASwi16(struct ARMCore* cpu, int immediate);
+void GBASwi32(struct ARMCore* cpu, int immediate);
+
+#define ARM_MEMORY(CPU, HANDLER) _ARM_DIRECT_ ## HANDLER
+#define ARM_IRQH(CPU, HANDLER) _ARM_DIRECT_ ## HANDLER
+#define _ARM_DIRECT_load32 GBALoad32
+#define _ARM_DIRECT_load16 GBALoad16
+#define _ARM_DIRECT_load8 GBALoad8
+#define _ARM_DIRECT_store32 GBAStore32
+#define _ARM_DIRECT_store16 GBAStore16
+#define _ARM_DIRECT_store8 GBAStore8
+#define _ARM_DIRECT_loadMultiple GBALoadMultiple
+#define _ARM_DIRECT_storeMultiple GBAStoreMultiple
+#define _ARM_DIRECT_stall GBAMemoryStall
+#define _ARM_DIRECT_setActiveRegion GBASetActiveRegion
+#define _ARM_DIRECT_processEvents GBAProcessEvents
+#define _ARM_DIRECT_swi16 GBASwi16
+#define _ARM_DIRECT_swi32 GBASwi32
+#else
+#define ARM_MEMORY(CPU, HANDLER) (CPU)->memory.HANDLER
+#define ARM_IRQH(CPU, HANDLER) (CPU)->irqh.HANDLER
+#endif
 
 #define ARM_COND_EQ (cpu->cpsr.z)
 #define ARM_COND_NE (!cpu->cpsr.z)
@@ -49,15 +91,218 @@
 		} else {                                                          \
 			wait = 4;                                                     \
 		}                                                                 \
-		currentCycles += cpu->memory.stall(cpu, wait);                    \
+		currentCycles += ARM_MEMORY(cpu, stall)(cpu, wait);               \
+	}
+
+// Thumb ALU instructions defer their flag updates; anything that reads or
+// partially writes NZCV must commit them first
+static inline void ARMCommitFlags(struct ARMCore* cpu) {
+	unsigned lazy = cpu->lazyFlags;
+	if (!lazy) {
+		return;
+	}
+	if (lazy & ARM_LAZY_ADDITION) {
+		cpu->cpsr.flags &= 0xC0;
+		cpu->cpsr.c = ARM_CARRY_FROM(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
+		cpu->cpsr.v = ARM_V_ADDITION(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
+	} else if (lazy & ARM_LAZY_SUBTRACTION) {
+		cpu->cpsr.flags &= 0xC0;
+		cpu->cpsr.c = ARM_BORROW_FROM(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
+		cpu->cpsr.v = ARM_V_SUBTRACTION(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
+	}
+	if (lazy & ARM_LAZY_NZ) {
+		cpu->cpsr.n = ARM_SIGN(cpu->lazyResult);
+		cpu->cpsr.z = !cpu->lazyResult;
+	}
+	cpu->lazyFlags = ARM_LAZY_NONE;
+}
+
+// Individual flags can also be read straight from the pending state
+static inline bool ARMLazyN(const struct ARMCore* cpu) {
+	return (cpu->lazyFlags & ARM_LAZY_NZ) ? ARM_SIGN(cpu->lazyResult) : cpu->cpsr.n;
+}
+
+static inline bool ARMLazyZ(const struct ARMCore* cpu) {
+	return (cpu->lazyFlags & ARM_LAZY_NZ) ? !cpu->lazyResult : cpu->cpsr.z;
+}
+
+static inline bool ARMLazyC(const struct ARMCore* cpu) {
+	if (cpu->lazyFlags & ARM_LAZY_ADDITION) {
+		return ARM_CARRY_FROM(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
+	}
+	if (cpu->lazyFlags & ARM_LAZY_SUBTRACTION) {
+		return ARM_BORROW_FROM(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
+	}
+	return cpu->cpsr.c;
+}
+
+static inline bool ARMLazyV(const struct ARMCore* cpu) {
+	if (cpu->lazyFlags & ARM_LAZY_ADDITION) {
+		return ARM_V_ADDITION(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
+	}
+	if (cpu->lazyFlags & ARM_LAZY_SUBTRACTION) {
+		return ARM_V_SUBTRACTION(cpu->lazyOperand1, cpu->lazyOperand2, cpu->lazyCVResult);
 	}
+	return cpu->cpsr.v;
+}
 
 #define ARM_STUB cpu->irqh.hitStub(cpu, opcode)
 #define ARM_ILL cpu->irqh.hitIllegal(cpu, opcode)
 
+static inline bool ARMTestCondition(const struct ARMCore* cpu, unsigned condition) {
+#ifdef ENABLE_THREADED_DISPATCH
+	// Bit n of each entry is set if the condition passes when NZCV == n
+	static const uint16_t conditionTable[16] = {
+		0xF0F0, 0x0F0F, 0xCCCC, 0x3333, 0xFF00, 0x00FF, 0xAAAA, 0x5555,
+		0x0C0C, 0xF3F3, 0xAA55, 0x55AA, 0x0A05, 0xF5FA, 0xFFFF, 0x0000
+	};
+	return (conditionTable[condition] >> ((uint32_t) cpu->cpsr.packed >> 28)) & 1;
+#else
+	bool conditionMet = false;
+	switch (condition) {
+	case 0x0:
+		conditionMet = ARM_COND_EQ;
+		break;
+	case 0x1:
+		conditionMet = ARM_COND_NE;
+		break;
+	case 0x2:
+		conditionMet = ARM_COND_CS;
+		break;
+	case 0x3:
+		conditionMet = ARM_COND_CC;
+		break;
+	case 0x4:
+		conditionMet = ARM_COND_MI;
+		break;
+	case 0x5:
+		conditionMet = ARM_COND_PL;
+		break;
+	case 0x6:
+		conditionMet = ARM_COND_VS;
+		break;
+	case 0x7:
+		conditionMet = ARM_COND_VC;
+		break;
+	case 0x8:
+		conditionMet = ARM_COND_HI;
+		break;
+	case 0x9:
+		conditionMet = ARM_COND_LS;
+		break;
+	case 0xA:
+		conditionMet = ARM_COND_GE;
+		break;
+	case 0xB:
+		conditionMet = ARM_COND_LT;
+		break;
+	case 0xC:
+		conditionMet = ARM_COND_GT;
+		break;
+	case 0xD:
+		conditionMet = ARM_COND_LE;
+		break;
+	default:
+		break;
+	}
+	return conditionMet;
+#endif
+}
+
+static inline const struct ARMFastPage* _ARMFastPage(const struct ARMCore* cpu, uint32_t address) {
+	if (!cpu->memory.fastPages) {
+		return NULL;
+	}
+	const struct ARMFastPage* page = &cpu->memory.fastPages[address >> ARM_FAST_PAGE_SHIFT];
+	return page->data ? page : NULL;
+}
+
+static inline uint32_t ARMLoad32(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
+	const struct ARMFastPage* page = _ARMFastPage(cpu, address);
+	if (!page) {
+		return ARM_MEMORY(cpu, load32)(cpu, address, cycleCounter);
+	}
+	uint32_t value;
+	LOAD_32(value, address & (page->mask & ~3), page->data);
+	if (cycleCounter) {
+		*cycleCounter += ARM_MEMORY(cpu, stall)(cpu, page->waitstates32 + 2);
+	}
+	// Unaligned 32-bit loads are rotated, as in the full handler
+	int rotate = (address & 3) << 3;
+	return ROR(value, rotate);
+}
+
+static inline uint32_t ARMLoad16(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
+	const struct ARMFastPage* page = _ARMFastPage(cpu, address);
+	if (!page) {
+		return ARM_MEMORY(cpu, load16)(cpu, address, cycleCounter);
+	}
+	uint32_t value;
+	LOAD_16(value, address & (page->mask & ~1), page->data);
+	if (cycleCounter) {
+		*cycleCounter += ARM_MEMORY(cpu, stall)(cpu, page->waitstates16 + 2);
+	}
+	int rotate = (address & 1) << 3;
+	return ROR(value, rotate);
+}
+
+static inline uint32_t ARMLoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
+	const struct ARMFastPage* page = _ARMFastPage(cpu, address);
+	if (!page) {
+		return ARM_MEMORY(cpu, load8)(cpu, address, cycleCounter);
+	}
+	uint32_t value = ((uint8_t*) page->data)[address & page->mask];
+	if (cycleCounter) {
+		*cycleCounter += ARM_MEMORY(cpu, stall)(cpu, page->waitstates16 + 2);
+	}
+	return value;
+}
+
+static inline void ARMStore32(struct ARMCore* cpu, uint32_t address, int32_t value, int* cycleCounter) {
+	const struct ARMFastPage* page = _ARMFastPage(cpu, address);
+	if (!page) {
+		ARM_MEMORY(cpu, store32)(cpu, address, value, cycleCounter);
+		return;
+	}
+	STORE_32(value, address & (page->mask & ~3), page->data);
+	mStatePageMark(page->dirty, address & page->mask);
+	ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address, page->mask));
+	if (cycleCounter) {
+		*cycleCounter += ARM_MEMORY(cpu, stall)(cpu, page->waitstates32 + 1);
+	}
+}
+
+static inline void ARMStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycleCounter) {
+	const struct ARMFastPage* page = _ARMFastPage(cpu, address);
+	if (!page) {
+		ARM_MEMORY(cpu, store16)(cpu, address, value, cycleCounter);
+		return;
+	}
+	STORE_16(value, address & (page->mask & ~1), page->data);
+	mStatePageMark(page->dirty, address & page->mask);
+	ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address, page->mask));
+	if (cycleCounter) {
+		*cycleCounter += ARM_MEMORY(cpu, stall)(cpu, page->waitstates16 + 1);
+	}
+}
+
+static inline void ARMStore8(struct ARMCore* cpu, uint32_t address, int8_t value, int* cycleCounter) {
+	const struct ARMFastPage* page = _ARMFastPage(cpu, address);
+	if (!page) {
+		ARM_MEMORY(cpu, store8)(cpu, address, value, cycleCounter);
+		return;
+	}
+	((int8_t*) page->data)[address & page->mask] = value;
+	mStatePageMark(page->dirty, address & page->mask);
+	ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address, page->mask));
+	if (cycleCounter) {
+		*cycleCounter += ARM_MEMORY(cpu, stall)(cpu, page->waitstates16 + 1);
+	}
+}
+
 static inline int32_t ARMWritePC(struct ARMCore* cpu) {
 	cpu->gprs[ARM_PC] = (cpu->gprs[ARM_PC] & -WORD_SIZE_ARM);
-	cpu->memory.setActiveRegion(cpu, cpu->gprs[ARM_PC]);
+	ARM_MEMORY(cpu, setActiveRegion)(cpu, cpu->gprs[ARM_PC]);
 	LOAD_32(cpu->prefetch[0], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion);
 	cpu->gprs[ARM_PC] += WORD_SIZE_ARM;
 	LOAD_32(cpu->prefetch[1], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion);
@@ -66,7 +311,7 @@ static inline int32_t ARMWritePC(struct ARMCore* cpu) {
 
 static inline int32_t ThumbWritePC(struct ARMCore* cpu) {
 	cpu->gprs[ARM_PC] = (cpu->gprs[ARM_PC] & -WORD_SIZE_THUMB);
-	cpu->memory.setActiveRegion(cpu, cpu->gprs[ARM_PC]);
+	ARM_MEMORY(cpu, setActiveRegion)(cpu, cpu->gprs[ARM_PC]);
 	LOAD_16(cpu->prefetch[0], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion);
 	cpu->gprs[ARM_PC] += WORD_SIZE_THUMB;
 	LOAD_16(cpu->prefetch[1], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion);
@@ -82,6 +327,8 @@ static inline void _ARMSetMode(struct ARMCore* cpu, enum ExecutionMode execution
 		return;
 	}
 
+	ARMCommitFlags(cpu);
+
 	cpu->executionMode = executionMode;
 	switch (executionMode) {
 	case MODE_ARM:
@@ -15,6 +15,14 @@ struct ARMCore;
 typedef void (*ThumbInstruction)(struct ARMCore*, uint16_t opcode);
 extern const ThumbInstruction _thumbTable[0x400];
 
+// Returns a handler that runs both instructions back to back, if one exists.
+// It expects to be called with the second opcode in prefetch[0].
+ThumbInstruction ThumbFuse(uint16_t opcode, uint16_t next);
+
+#ifdef ENABLE_THREADED_DISPATCH
+void ThumbRunThreaded(struct ARMCore*);
+#endif
+
 CXX_GUARD_END
 
 #endif
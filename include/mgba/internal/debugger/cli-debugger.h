@@ -20,6 +20,8 @@ extern const char* INFO_WATCHPOINT_ADDED;
 
 struct CLIDebugger;
 struct VFile;
+struct mDebuggerProfiler;
+struct mDebuggerTraceWriter;
 
 struct CLIDebugVector {
 	struct CLIDebugVector* next;
@@ -87,6 +89,8 @@ struct CLIDebugger {
 
 	int traceRemaining;
 	struct VFile* traceVf;
+	struct mDebuggerTraceWriter* traceWriter;
+	struct mDebuggerProfiler* profiler;
 };
 
 void CLIDebuggerCreate(struct CLIDebugger*);
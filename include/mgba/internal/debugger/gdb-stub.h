@@ -14,7 +14,7 @@ CXX_GUARD_START
 
 #include <mgba-util/socket.h>
 
-#define GDB_STUB_MAX_LINE 1200
+#define GDB_STUB_MAX_LINE 16384
 #define GDB_STUB_INTERVAL 32
 
 enum GDBStubAckState {
@@ -28,6 +28,7 @@ struct GDBStub {
 	struct mDebugger d;
 
 	char line[GDB_STUB_MAX_LINE];
+	size_t lineLength;
 	char outgoing[GDB_STUB_MAX_LINE];
 	enum GDBStubAckState lineAck;
 
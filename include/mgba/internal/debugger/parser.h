@@ -70,9 +70,47 @@ void parseLexedExpression(struct ParseTree* tree, struct LexVector* lv);
 void lexFree(struct LexVector* lv);
 void parseFree(struct ParseTree* tree);
 
+#define PARSE_PROGRAM_MAX_SLOTS 16
+
+// A condition flattened into straight-line code that leaves each result in a numbered slot,
+// with everything that can't change between hits looked up once when it's compiled
+struct ParseInstruction {
+	enum ParseInstructionType {
+		PARSE_CONSTANT,
+		PARSE_REGISTER,
+		PARSE_IDENTIFIER,
+		PARSE_SEGMENT,
+		PARSE_OPERATION,
+	} type;
+	enum Operation operation;
+	uint8_t dest;
+	uint8_t lhs;
+	uint8_t rhs;
+	int segment;
+	union {
+		int32_t value;
+		const int32_t* reg;
+		char* identifier;
+	};
+};
+
+struct ParseProgram {
+	struct ParseInstruction* instructions;
+	size_t nInstructions;
+};
+
 struct mDebugger;
 bool mDebuggerEvaluateParseTree(struct mDebugger* debugger, struct ParseTree* tree, int32_t* value, int* segment);
 
+bool mDebuggerCompileParseTree(struct mDebugger* debugger, const struct ParseTree* tree, struct ParseProgram* program);
+bool mDebuggerEvaluateParseProgram(struct mDebugger* debugger, const struct ParseProgram* program, int32_t* value, int* segment);
+void parseProgramFree(struct ParseProgram* program);
+
+// Compiled when a breakpoint or watchpoint is set. Conditions that can't be compiled come back
+// as NULL and are checked by walking the tree instead.
+struct ParseProgram* mDebuggerCompileCondition(struct mDebugger* debugger, const struct ParseTree* condition);
+bool mDebuggerCheckCondition(struct mDebugger* debugger, struct ParseTree* condition, const struct ParseProgram* program);
+
 CXX_GUARD_END
 
 #endif
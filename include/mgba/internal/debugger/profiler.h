@@ -0,0 +1,55 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef DEBUGGER_PROFILER_H
+#define DEBUGGER_PROFILER_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba/core/timing.h>
+#include <mgba-util/table.h>
+
+#define mDEBUGGER_PROFILER_DEFAULT_PERIOD 0x1000
+
+struct mCore;
+struct mDebuggerProfilerSample {
+	// Thumb addresses have their low bit set, matching ELF symbols
+	uint32_t pc;
+	uint32_t lr;
+	int segment;
+	// Only set on CPUs with a link register, where it stands in for the caller
+	bool hasLink;
+};
+
+struct mDebuggerProfiler {
+	struct mCore* core;
+	struct mTimingEvent event;
+	uint32_t period;
+	uint64_t samples;
+
+	// Sample counts by PC and LR
+	struct Table sites;
+
+	void (*sample)(struct mCore*, struct mDebuggerProfilerSample*);
+};
+
+void mDebuggerProfilerInit(struct mDebuggerProfiler*, struct mCore* core, uint32_t period);
+void mDebuggerProfilerDeinit(struct mDebuggerProfiler*);
+
+// Resetting the core or loading a state clears its scheduler, so sampling has to be started again afterwards
+void mDebuggerProfilerStart(struct mDebuggerProfiler*);
+void mDebuggerProfilerStop(struct mDebuggerProfiler*);
+bool mDebuggerProfilerIsRunning(const struct mDebuggerProfiler*);
+void mDebuggerProfilerClear(struct mDebuggerProfiler*);
+
+// Writes one "caller;function count" line per call site, as read by flamegraph.pl and compatible tools
+struct VFile;
+bool mDebuggerProfilerWriteFolded(struct mDebuggerProfiler*, struct VFile* vf);
+
+CXX_GUARD_END
+
+#endif
@@ -16,8 +16,15 @@ struct mDebuggerSymbols* mDebuggerSymbolTableCreate(void);
 void mDebuggerSymbolTableDestroy(struct mDebuggerSymbols*);
 
 bool mDebuggerSymbolLookup(const struct mDebuggerSymbols*, const char* name, int32_t* value, int* segment);
+// Finds the symbol at or closest below an address, i.e. the function containing it,
+// unless that symbol's size is known and says the address lies past its end
+const char* mDebuggerSymbolNearest(struct mDebuggerSymbols*, uint32_t address, int segment, uint32_t* offset);
+// The same for a whole array of addresses at once, e.g. profiler samples, writing NULL where nothing matches
+void mDebuggerSymbolResolve(struct mDebuggerSymbols*, const uint32_t* addresses, size_t count, int segment, const char** names);
 
 void mDebuggerSymbolAdd(struct mDebuggerSymbols*, const char* name, int32_t value, int segment);
+// A size of 0 means unknown, in which case the symbol extends up to the next one
+void mDebuggerSymbolAddSized(struct mDebuggerSymbols*, const char* name, int32_t value, uint32_t size, int segment);
 void mDebuggerSymbolRemove(struct mDebuggerSymbols*, const char* name);
 
 struct VFile;
@@ -0,0 +1,84 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef DEBUGGER_TRACE_H
+#define DEBUGGER_TRACE_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba/debugger/debugger.h>
+#include <mgba-util/ring-fifo.h>
+#include <mgba-util/threading.h>
+
+#define mDEBUGGER_TRACE_VERSION 1
+#define mDEBUGGER_TRACE_CHUNK_SIZE 0x4000
+#define mDEBUGGER_TRACE_CHUNKS 64
+// A record with every register changed, which is as large as they get
+#define mDEBUGGER_TRACE_MAX_RECORD (1 + 4 + 4 + 5 + 3 + 4 * mDEBUGGER_TRACE_MAX_REGISTERS)
+
+enum mDebuggerTraceFlags {
+	mDEBUGGER_TRACE_REGISTERS = 1
+};
+
+struct mDebuggerTraceHeader {
+	char magic[4];
+	uint16_t version;
+	uint8_t flags;
+	uint8_t nRegisters;
+	int32_t platform;
+	uint32_t reserved;
+};
+
+struct mDebuggerTraceChunk {
+	uint32_t size;
+	uint8_t data[mDEBUGGER_TRACE_CHUNK_SIZE];
+};
+
+struct VFile;
+struct mDebuggerTraceWriter {
+	struct VFile* vf;
+	unsigned flags;
+	uint64_t records;
+
+	struct mDebuggerTraceEntry last;
+	bool hasLast;
+	struct mDebuggerTraceChunk chunk;
+
+#ifndef DISABLE_THREADING
+	// The emulation thread only waits here when the writer falls a whole ring behind
+	struct RingFIFO fifo;
+	Thread thread;
+	Mutex mutex;
+	Condition dataAvailable;
+	Condition dataConsumed;
+	bool finished;
+	struct mDebuggerTraceChunk pending;
+#endif
+};
+
+struct mDebuggerTraceReader {
+	struct VFile* vf;
+	struct mDebuggerTraceHeader header;
+
+	struct mDebuggerTraceEntry last;
+	bool hasLast;
+	uint8_t buffer[mDEBUGGER_TRACE_CHUNK_SIZE];
+	size_t offset;
+	size_t size;
+};
+
+bool mDebuggerTraceWriterInit(struct mDebuggerTraceWriter*, struct VFile* vf, int platform, unsigned nRegisters, unsigned flags);
+void mDebuggerTraceWriterDeinit(struct mDebuggerTraceWriter*);
+void mDebuggerTraceWriterRecord(struct mDebuggerTraceWriter*, const struct mDebuggerTraceEntry*);
+void mDebuggerTraceWriterFlush(struct mDebuggerTraceWriter*);
+
+bool mDebuggerTraceReaderInit(struct mDebuggerTraceReader*, struct VFile* vf);
+bool mDebuggerTraceReaderNext(struct mDebuggerTraceReader*, struct mDebuggerTraceEntry*);
+
+CXX_GUARD_END
+
+#endif
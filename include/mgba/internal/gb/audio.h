@@ -144,6 +144,19 @@ struct GBAudioNoiseChannel {
 	int8_t sample;
 };
 
+// Channels are evaluated lazily: this holds the time of a channel's next
+// edge, which is only processed once something observes the channel
+struct GBAudioChannelTimer {
+	uint32_t when;
+	bool scheduled;
+};
+
+enum GBAudioResampler {
+	GB_AUDIO_RESAMPLE_NEAREST,
+	GB_AUDIO_RESAMPLE_LINEAR,
+	GB_AUDIO_RESAMPLE_BANDLIMITED,
+};
+
 enum GBAudioStyle {
 	GB_AUDIO_DMG,
 	GB_AUDIO_MGB = GB_AUDIO_DMG, // TODO
@@ -193,18 +206,26 @@ struct GBAudio {
 	int32_t sampleInterval;
 	enum GBAudioStyle style;
 
+	// Called with the time of a frame sequencer step before it changes the
+	// channels, so that a lazy mixer can catch up first
+	void (*sync)(void* context, uint32_t when);
+	void* syncContext;
+
 	struct mTimingEvent frameEvent;
-	struct mTimingEvent ch1Event;
-	struct mTimingEvent ch2Event;
-	struct mTimingEvent ch3Event;
-	struct mTimingEvent ch3Fade;
-	struct mTimingEvent ch4Event;
+	struct GBAudioChannelTimer ch1Timer;
+	struct GBAudioChannelTimer ch2Timer;
+	struct GBAudioChannelTimer ch3Timer;
+	struct GBAudioChannelTimer ch3Fade;
+	struct GBAudioChannelTimer ch4Timer;
 	struct mTimingEvent sampleEvent;
 	bool enable;
 
 	size_t samples;
 	bool forceDisableCh[4];
 	int masterVolume;
+	// No samples are mixed or produced while muted, but the channels still run
+	bool muted;
+	void (*addDelta)(struct blip_t*, unsigned clockTime, int delta);
 };
 
 void GBAudioInit(struct GBAudio* audio, size_t samples, uint8_t* nr52, enum GBAudioStyle style);
@@ -212,6 +233,8 @@ void GBAudioDeinit(struct GBAudio* audio);
 void GBAudioReset(struct GBAudio* audio);
 
 void GBAudioResizeBuffer(struct GBAudio* audio, size_t samples);
+void GBAudioSetResampler(struct GBAudio* audio, enum GBAudioResampler resampler);
+enum GBAudioResampler GBAudioNameToResampler(const char* name);
 
 void GBAudioWriteNR10(struct GBAudio* audio, uint8_t);
 void GBAudioWriteNR11(struct GBAudio* audio, uint8_t);
@@ -239,7 +262,11 @@ void GBAudioWriteNR50(struct GBAudio* audio, uint8_t);
 void GBAudioWriteNR51(struct GBAudio* audio, uint8_t);
 void GBAudioWriteNR52(struct GBAudio* audio, uint8_t);
 
-void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing);
+// Runs the channels up to timestamp, then steps the frame sequencer
+void GBAudioUpdateFrame(struct GBAudio* audio, uint32_t timestamp);
+
+// Processes every channel edge due at or before timestamp
+void GBAudioRun(struct GBAudio* audio, uint32_t timestamp);
 
 void GBAudioSamplePSG(struct GBAudio* audio, int16_t* left, int16_t* right);
 
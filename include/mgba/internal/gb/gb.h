@@ -13,6 +13,7 @@ CXX_GUARD_START
 #include <mgba/core/cpu.h>
 #include <mgba/core/interface.h>
 #include <mgba/core/log.h>
+#include <mgba/core/savedata.h>
 #include <mgba/core/timing.h>
 
 #include <mgba/internal/gb/audio.h>
@@ -72,6 +73,16 @@ enum GBSGBCommand {
 	SGB_OBJ_TRN
 };
 
+enum GBIdleLoopOptimization {
+	GB_IDLE_LOOP_IGNORE = -1,
+	GB_IDLE_LOOP_REMOVE = 0,
+	GB_IDLE_LOOP_DETECT
+};
+
+#define GB_IDLE_REGISTERS 5
+// One load per instruction of the longest loop memory.c detects
+#define GB_IDLE_LOADS 16
+
 struct SM83Core;
 struct mCoreSync;
 struct mAVStream;
@@ -101,8 +112,7 @@ struct GB {
 	struct VFile* sramVf;
 	struct VFile* sramRealVf;
 	uint32_t sramSize;
-	int sramDirty;
-	int32_t sramDirtAge;
+	struct mSavedataFlusher sramFlusher;
 	bool sramMaskWriteback;
 
 	int sgbBit;
@@ -120,7 +130,26 @@ struct GB {
 	struct mTimingEvent eiPending;
 	unsigned doubleSpeed;
 
+	enum GBIdleLoopOptimization idleOptimization;
+	uint32_t idleLoop;
+	uint16_t lastJump;
+	bool idlePending;
+	uint32_t idleTimestamp;
+	int32_t idleCycles;
+	uint16_t idleRegisters[GB_IDLE_REGISTERS];
+	// Every address a pass of the loop loads from, or -1 if not known, and the values seen by a pass known to be idle
+	int idleLoads;
+	bool idleLoadsFixed;
+	bool idleProven;
+	int32_t idlePass;
+	uint16_t idleLoadAddresses[GB_IDLE_LOADS];
+	uint8_t idleLoadValues[GB_IDLE_LOADS];
+	int idleDetectionStep;
+	int idleDetectionFailures;
+
 	bool allowOpposingDirections;
+	// Moves every DMA byte in its own event, even when nothing could observe a batched copy
+	bool accurateDma;
 };
 
 struct GBCartridge {
@@ -42,6 +42,7 @@ struct GBMBCRTCSaveBuffer {
 	uint64_t unixTime;
 };
 void GBMBCRTCRead(struct GB* gb);
+void GBMBCRTCResample(struct GB* gb);
 void GBMBCRTCWrite(struct GB* gb);
 
 CXX_GUARD_END
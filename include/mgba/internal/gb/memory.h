@@ -11,6 +11,7 @@
 CXX_GUARD_START
 
 #include <mgba/core/log.h>
+#include <mgba/core/serialize.h>
 #include <mgba/core/timing.h>
 #include <mgba/gb/interface.h>
 
@@ -63,9 +64,11 @@ enum {
 	GB_SIZE_HRAM = 0x7F,
 };
 
+// VRAM and WRAM are carved out of a single mapping that lasts as long as the core
 enum {
-	GB_SRAM_DIRT_NEW = 1,
-	GB_SRAM_DIRT_SEEN = 2
+	GB_ARENA_VRAM = 0,
+	GB_ARENA_WRAM = GB_ARENA_VRAM + GB_SIZE_VRAM,
+	GB_ARENA_SIZE = GB_ARENA_WRAM + GB_SIZE_WORKING_RAM
 };
 
 struct GBMemory;
@@ -164,6 +167,7 @@ struct GBMemory {
 	union GBMBCState mbcState;
 	int currentBank;
 
+	uint8_t* arena;
 	uint8_t* wram;
 	uint8_t* wramBank;
 	int wramCurrentBank;
@@ -198,10 +202,25 @@ struct GBMemory {
 	bool rtcLatched;
 	uint8_t rtcRegs[5];
 	time_t rtcLastLatch;
+	// Host time is sampled at most once a frame; latches count emulated cycles from there
+	time_t rtcSampledTime;
+	uint32_t rtcSampledCycle;
+	bool rtcSampled;
 	struct mRTCSource* rtc;
 	struct mRotationSource* rotation;
 	struct mRumble* rumble;
 	struct mImageSource* cam;
+
+	// Pages written since they were last collected by GBCollectDirtyState
+	uint32_t dirtyWram[M_STATE_PAGE_WORDS(GB_SIZE_WORKING_RAM)];
+	uint32_t dirtyVram[M_STATE_PAGE_WORDS(GB_SIZE_VRAM)];
+	// Cleared when memory is replaced wholesale, so the next collection reports everything
+	bool dirtyTracked;
+
+	// Host memory behind each 256-byte page of the address space, or NULL where accesses need the
+	// slow path. Only WRAM is writable directly; other stores have side effects to track.
+	uint8_t* readPages[0x100];
+	uint8_t* writePages[0x100];
 };
 
 struct SM83Core;
@@ -211,6 +230,11 @@ void GBMemoryDeinit(struct GB* gb);
 void GBMemoryReset(struct GB* gb);
 void GBMemorySwitchWramBank(struct GBMemory* memory, int bank);
 
+void GBMemoryRemap(struct GB* gb);
+void GBMemoryRemapRom(struct GB* gb);
+void GBMemoryRemapSram(struct GB* gb);
+void GBMemoryRemapVram(struct GB* gb);
+
 uint8_t GBLoad8(struct SM83Core* cpu, uint16_t address);
 void GBStore8(struct SM83Core* cpu, uint16_t address, int8_t value);
 
@@ -12,12 +12,15 @@ CXX_GUARD_START
 
 #include <mgba/gb/interface.h>
 
+#define GB_IDLE_LOOP_NONE 0xFFFFFFFF
+
 struct GBCartridgeOverride {
 	int headerCrc32;
 	enum GBModel model;
 	enum GBMemoryBankControllerType mbc;
 
 	uint32_t gbColors[12];
+	uint32_t idleLoop;
 };
 
 struct Configuration;
@@ -19,11 +19,19 @@ struct GBVideoSoftwareRenderer {
 
 	color_t* outputBuffer;
 	int outputBufferStride;
+	// Set when the frontend wants another format than color_t. Frames are still drawn into
+	// outputBuffer, then converted into convertBuffer, whose stride counts pixels of that format.
+	mColorRowConverter convertRow;
+	void* convertBuffer;
+	size_t convertStride;
+	unsigned convertBytes;
 
 	uint8_t row[GB_VIDEO_HORIZONTAL_PIXELS + 8];
 
 	color_t palette[128];
 	uint8_t lookup[64];
+	// Used in place of mColorFrom555 to turn BGR555 into output colors when set, e.g. for color correction
+	const color_t* colorTable;
 
 	uint32_t* temporaryBuffer;
 
@@ -51,9 +59,15 @@ struct GBVideoSoftwareRenderer {
 	uint8_t sgbPacket[128];
 	uint8_t sgbCommandHeader;
 	bool sgbBorders;
+	// Palette indices of the rasterized 256x224 border, rebuilt only when the border's tiles or map change
+	uint8_t* sgbBorder;
+	bool sgbBorderDirty;
 };
 
 void GBVideoSoftwareRendererCreate(struct GBVideoSoftwareRenderer*);
+// The table has 32768 entries and must outlive the renderer, or be unset first
+// Entries already written from palette, if given, are converted again
+void GBVideoSoftwareRendererSetColorTable(struct GBVideoSoftwareRenderer*, const color_t* table, const uint16_t* palette);
 
 CXX_GUARD_END
 
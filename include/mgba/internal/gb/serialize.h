@@ -417,6 +417,9 @@ struct GBSerializedState {
 #pragma pack(pop)
 
 bool GBDeserialize(struct GB* gb, const struct GBSerializedState* state);
+bool GBCollectDirtyState(struct GB* gb, uint32_t* pages, size_t size);
+// Hashes the live registers, memory and save data, which is much cheaper than serializing them first
+uint64_t GBStateHash(struct GB* gb);
 void GBSerialize(struct GB* gb, struct GBSerializedState* state);
 
 CXX_GUARD_END
@@ -20,6 +20,9 @@ struct GBSIOLockstep {
 
 	uint8_t pendingSB[MAX_GBS];
 	bool masterClaimed;
+
+	// Longest slice the master hands out while no transfer is in flight, 0 to always use the shortest
+	int32_t idleWindow;
 };
 
 struct GBSIOLockstepNode {
@@ -29,6 +32,7 @@ struct GBSIOLockstepNode {
 
 	volatile int32_t nextEvent;
 	int32_t eventDiff;
+	int32_t increment;
 	int id;
 	bool transferFinished;
 #ifndef NDEBUG
@@ -34,6 +34,8 @@ struct GBTimer {
 
 void GBTimerReset(struct GBTimer*);
 void GBTimerDivReset(struct GBTimer*);
+void GBTimerUpdateRegisters(struct GBTimer*);
+void GBTimerReschedule(struct GBTimer*);
 uint8_t GBTimerUpdateTAC(struct GBTimer*, GBRegisterTAC tac);
 
 struct GBSerializedState;
@@ -77,6 +77,8 @@ struct GBVideoRenderer {
 	void (*drawRange)(struct GBVideoRenderer* renderer, int startX, int endX, int y, struct GBObj* objOnLine, size_t nObj);
 	void (*finishScanline)(struct GBVideoRenderer* renderer, int y);
 	void (*finishFrame)(struct GBVideoRenderer* renderer);
+	// Optional; called in place of finishFrame when a frame was skipped, to keep per-frame state in step
+	void (*skipFrame)(struct GBVideoRenderer* renderer);
 	void (*enableSGBBorder)(struct GBVideoRenderer* renderer, bool enable);
 
 	void (*getPixels)(struct GBVideoRenderer* renderer, size_t* stride, const void** pixels);
@@ -155,6 +157,8 @@ struct GBVideo {
 	int32_t frameCounter;
 	int frameskip;
 	int frameskipCounter;
+	// Frames that must be drawn regardless of frameskip, since the SGB reads transfers off the screen
+	int sgbTransferFrames;
 };
 
 void GBVideoInit(struct GBVideo* video);
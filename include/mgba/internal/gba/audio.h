@@ -17,6 +17,7 @@ CXX_GUARD_START
 
 #define MP2K_MAGIC 0x68736D53
 #define MP2K_MAX_SOUND_CHANNELS 12
+#define MP2K_PCM_BUFFER_SIZE 0x630
 
 mLOG_DECLARE_CATEGORY(GBA_AUDIO);
 
@@ -48,6 +49,12 @@ DECL_BITFIELD(GBARegisterSOUNDBIAS, uint16_t);
 DECL_BITS(GBARegisterSOUNDBIAS, Bias, 0, 10);
 DECL_BITS(GBARegisterSOUNDBIAS, Resolution, 14, 2);
 
+enum GBAAudioHleMode {
+	GBA_AUDIO_HLE_DEFAULT = 0,
+	GBA_AUDIO_HLE_DISABLED,
+	GBA_AUDIO_HLE_ENABLED,
+};
+
 struct GBAAudioMixer;
 struct GBAAudio {
 	struct GBA* p;
@@ -78,11 +85,17 @@ struct GBAAudio {
 
 	struct GBAAudioMixer* mixer;
 	bool externalMixing;
+	// Per-game choice from the cartridge overrides; the default defers to the config
+	enum GBAAudioHleMode hleMode;
 	int32_t sampleInterval;
+	// Samples are mixed lazily; this is the time of the first unmixed one
+	uint32_t nextSample;
 
 	bool forceDisableChA;
 	bool forceDisableChB;
 	int masterVolume;
+	// No samples are mixed or produced while muted, but the channels still run
+	bool muted;
 
 	struct mTimingEvent sampleEvent;
 };
@@ -244,34 +257,38 @@ struct GBAMP2kMusicPlayerTrack {
 	uint32_t patternStack[3];
 };
 
-struct GBAMP2kTrack {
-	struct GBAMP2kMusicPlayerTrack track;
-	struct GBAMP2kSoundChannel* channel;
-	uint8_t lastCommand;
-	struct CircleBuffer buffer;
-	uint32_t samplePlaying;
-	float currentOffset;
-	bool waiting;
+struct GBAMP2kVoice {
+	bool active;
+	uint32_t waveData;
+	// Playback position at the end of the last rendered block
+	uint32_t position;
+	uint32_t fraction;
 };
 
+// Re-renders the MP2K driver's output at full precision. The driver still mixes on the emulated CPU,
+// so this improves sound quality at a small extra cost rather than saving any emulation time.
 struct GBAAudioMixer {
 	struct mCPUComponent d;
 	struct GBAAudio* p;
 
 	uint32_t contextAddress;
+	// The half of the driver's PCM buffer (0 for right, 1 for left) feeding each FIFO, or -1
+	int fifoSource[2];
+	// Set once the driver does something the mixer can't reproduce; the FIFOs are used from then on
+	bool unsupported;
 
-	bool (*engage)(struct GBAAudioMixer* mixer, uint32_t address);
+	bool (*engage)(struct GBAAudioMixer* mixer, uint32_t address, int fifo, bool left);
+	void (*release)(struct GBAAudioMixer* mixer, int fifo);
 	void (*vblank)(struct GBAAudioMixer* mixer);
-	void (*step)(struct GBAAudioMixer* mixer);
+	void (*step)(struct GBAAudioMixer* mixer, int16_t* sampleA, int16_t* sampleB);
 
 	struct GBAMP2kContext context;
-	struct GBAMP2kMusicPlayerInfo player;
-	struct GBAMP2kTrack activeTracks[MP2K_MAX_SOUND_CHANNELS];
-
-	double tempo;
-	double frame;
+	struct GBAMP2kVoice voices[MP2K_MAX_SOUND_CHANNELS];
 
-	struct GBAStereoSample last;
+	// Output laid out like the driver's own PCM buffer, with 8 extra bits of precision
+	int16_t pcm[2][MP2K_PCM_BUFFER_SIZE];
+	int segment;
+	uint32_t segmentStart;
 };
 
 void GBAAudioInit(struct GBAAudio* audio, size_t samples);
@@ -300,6 +317,7 @@ void GBAAudioWriteSOUNDBIAS(struct GBAAudio* audio, uint16_t value);
 void GBAAudioWriteWaveRAM(struct GBAAudio* audio, int address, uint32_t value);
 void GBAAudioWriteFIFO(struct GBAAudio* audio, int address, uint32_t value);
 void GBAAudioSampleFIFO(struct GBAAudio* audio, int fifoId, int32_t cycles);
+void GBAAudioSample(struct GBAAudio* audio, uint32_t timestamp);
 
 struct GBASerializedState;
 void GBAAudioSerialize(const struct GBAAudio* audio, struct GBASerializedState* state);
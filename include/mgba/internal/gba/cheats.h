@@ -12,6 +12,7 @@ CXX_GUARD_START
 
 #include <mgba/internal/arm/arm.h>
 #include <mgba/core/cheats.h>
+#include <mgba-util/table.h>
 
 #define MAX_ROM_PATCHES 10
 #define COMPLETE ((size_t) -1)
@@ -159,9 +160,17 @@ struct GBACheatSet {
 	int remainingAddresses;
 };
 
+struct GBACheatDevice {
+	struct mCheatDevice d;
+	// Sets run by each hook address, rebuilt whenever the device's revision changes
+	struct Table hooks;
+	unsigned hooksRevision;
+};
+
 struct VFile;
 
 struct mCheatDevice* GBACheatDeviceCreate(void);
+struct GBACheatHook* GBACheatRunHooks(struct mCheatDevice*, uint32_t address);
 
 bool GBACheatAddCodeBreaker(struct GBACheatSet*, uint32_t op1, uint16_t op2);
 bool GBACheatAddCodeBreakerLine(struct GBACheatSet*, const char* line);
@@ -76,7 +76,10 @@ struct GBA {
 
 	struct ARMDebugger* debugger;
 
+	// What DMAs read from open bus. It follows the CPU's last prefetch until a DMA transfers
+	// something, but that is only worked out when it's needed, while busFromPrefetch is set.
 	uint32_t bus;
+	bool busFromPrefetch;
 	int performingDMA;
 
 	struct GBATimer timers[4];
@@ -141,6 +144,8 @@ void GBACreate(struct GBA* gba);
 void GBADestroy(struct GBA* gba);
 
 void GBAReset(struct ARMCore* cpu);
+void GBAProcessEvents(struct ARMCore* cpu);
+void GBALatchBus(struct GBA* gba);
 void GBASkipBIOS(struct GBA* gba);
 
 void GBARaiseIRQ(struct GBA* gba, enum GBAIRQ irq, uint32_t cyclesLate);
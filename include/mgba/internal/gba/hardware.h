@@ -117,6 +117,20 @@ struct GBACartridgeHardware {
 	uint16_t tiltY;
 	int tiltState;
 
+	// Sensor readings are fetched from the frontend at most once every sensorInterval frames,
+	// and GPIO accesses in between are served from these; 0 fetches on every access
+	unsigned sensorInterval;
+	uint32_t sensorsCached;
+	int32_t rtcSampleFrame;
+	time_t rtcSampleTime;
+	int32_t gyroSampleFrame;
+	int32_t gyroZ;
+	int32_t lightSampleFrame;
+	uint8_t luminance;
+	int32_t tiltSampleFrame;
+	int32_t rawTiltX;
+	int32_t rawTiltY;
+
 	unsigned gbpInputsPosted;
 	int gbpTxPosition;
 	struct mTimingEvent gbpNextEvent;
@@ -10,6 +10,8 @@
 
 CXX_GUARD_START
 
+#include <mgba/core/interface.h>
+#include <mgba/core/serialize.h>
 #include <mgba/core/timing.h>
 
 #include <mgba/internal/arm/arm.h>
@@ -75,6 +77,15 @@ enum {
 	SIZE_AGB_PRINT = 0x10000
 };
 
+// RAM regions are carved out of a single mapping, IWRAM and VRAM first so the
+// memory touched on nearly every instruction and scanline is packed together
+enum {
+	GBA_ARENA_IWRAM = 0,
+	GBA_ARENA_VRAM = GBA_ARENA_IWRAM + SIZE_WORKING_IRAM,
+	GBA_ARENA_WRAM = GBA_ARENA_VRAM + SIZE_VRAM,
+	GBA_ARENA_SIZE = GBA_ARENA_WRAM + SIZE_WORKING_RAM
+};
+
 enum {
 	OFFSET_MASK = 0x00FFFFFF,
 	BASE_OFFSET = 24
@@ -98,6 +109,7 @@ struct GBAPrintContext {
 };
 
 struct GBAMemory {
+	uint8_t* arena;
 	uint32_t* bios;
 	uint32_t* wram;
 	uint32_t* iwram;
@@ -117,9 +129,11 @@ struct GBAMemory {
 	char waitstatesSeq16[256];
 	char waitstatesNonseq32[256];
 	char waitstatesNonseq16[256];
+	struct ARMFastPage fastPages[ARM_FAST_PAGES];
 	int activeRegion;
 	bool prefetch;
 	uint32_t lastPrefetchedPc;
+	enum mCoreAccuracy accuracy;
 	uint32_t biosPrefetch;
 
 	struct GBADMA dma[4];
@@ -132,6 +146,15 @@ struct GBAMemory {
 	uint16_t* agbPrintBuffer;
 
 	bool mirroring;
+
+	// Pages written since they were last collected by GBACollectDirtyState
+	uint32_t dirtyWram[M_STATE_PAGE_WORDS(SIZE_WORKING_RAM)];
+	uint32_t dirtyIwram[M_STATE_PAGE_WORDS(SIZE_WORKING_IRAM)];
+	uint32_t dirtyPalette[M_STATE_PAGE_WORDS(SIZE_PALETTE_RAM)];
+	uint32_t dirtyVram[M_STATE_PAGE_WORDS(SIZE_VRAM)];
+	uint32_t dirtyOam[M_STATE_PAGE_WORDS(SIZE_OAM)];
+	// Cleared when memory is replaced wholesale, so the next collection reports everything
+	bool dirtyTracked;
 };
 
 struct GBA;
@@ -150,6 +173,12 @@ void GBAStore32(struct ARMCore* cpu, uint32_t address, int32_t value, int* cycle
 void GBAStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycleCounter);
 void GBAStore8(struct ARMCore* cpu, uint32_t address, int8_t value, int* cycleCounter);
 
+// Memory that plain loads and stores to address can go straight to, if any, and how many
+// bytes of it follow address before the end of its region
+uint8_t* GBAMemoryHostPointer(struct GBA* gba, uint32_t address, uint32_t* available, bool write);
+// Copies into memory from GBAMemoryHostPointer as stores of width bytes to address would
+void GBAMemoryHostCopy(struct GBA* gba, uint32_t address, uint8_t* to, const uint8_t* from, uint32_t length, uint32_t width);
+
 uint32_t GBAView32(struct ARMCore* cpu, uint32_t address);
 uint16_t GBAView16(struct ARMCore* cpu, uint32_t address);
 uint8_t GBAView8(struct ARMCore* cpu, uint32_t address);
@@ -163,11 +192,17 @@ uint32_t GBALoadMultiple(struct ARMCore*, uint32_t baseAddress, int mask, enum L
 uint32_t GBAStoreMultiple(struct ARMCore*, uint32_t baseAddress, int mask, enum LSMDirection direction,
                           int* cycleCounter);
 
+int32_t GBAMemoryStall(struct ARMCore* cpu, int32_t wait);
+void GBASetActiveRegion(struct ARMCore* cpu, uint32_t address);
+
 void GBAAdjustWaitstates(struct GBA* gba, uint16_t parameters);
+void GBAMemorySetAccuracy(struct GBA* gba, enum mCoreAccuracy accuracy);
 
 struct GBASerializedState;
 void GBAMemorySerialize(const struct GBAMemory* memory, struct GBASerializedState* state);
 void GBAMemoryDeserialize(struct GBAMemory* memory, const struct GBASerializedState* state);
+void GBAMemorySerializeRegions(const struct GBAMemory* memory, struct GBASerializedState* state, uint32_t regions);
+void GBAMemoryDeserializeRegions(struct GBAMemory* memory, const struct GBASerializedState* state, uint32_t regions);
 
 void GBAPrintFlush(struct GBA* gba);
 
@@ -10,6 +10,8 @@
 
 CXX_GUARD_START
 
+#include <mgba/core/interface.h>
+#include <mgba/internal/gba/audio.h>
 #include <mgba/internal/gba/savedata.h>
 
 #define IDLE_LOOP_NONE 0xFFFFFFFF
@@ -20,6 +22,9 @@ struct GBACartridgeOverride {
 	int hardware;
 	uint32_t idleLoop;
 	bool mirroring;
+	enum GBAAudioHleMode audioHle;
+	// The fastest accuracy profile the game still runs correctly with, or 0 for any
+	enum mCoreAccuracy accuracy;
 };
 
 struct Configuration;
@@ -30,6 +35,12 @@ struct GBA;
 void GBAOverrideApply(struct GBA*, const struct GBACartridgeOverride*);
 void GBAOverrideApplyDefaults(struct GBA*, const struct Configuration*);
 
+// The idle loop cache uses the same override.XXXX sections as the override
+// table, so an exported cache can be merged straight into a config file
+void GBAOverrideApplyIdleLoop(struct GBA*, const struct Configuration* cache);
+bool GBAOverrideLearnIdleLoop(struct Configuration* cache, const struct GBA*);
+size_t GBAOverrideExportIdleLoops(const struct Configuration* cache, struct Configuration* overrides);
+
 CXX_GUARD_END
 
 #endif
@@ -151,7 +151,17 @@ struct GBAVideoGLRenderer {
 
 	GLuint outputTex;
 
-	GLint shadowPalette[512];
+	// Frames are read back through a pair of pixel buffers, so getPixels hands out the frame
+	// before the last one instead of waiting on the GPU
+	bool asyncReadback;
+	GLuint readbackPbo[2];
+	GLsync readbackFence[2];
+	int readbackIndex;
+	size_t readbackSize;
+
+	// One copy of the palette per scanline, so raster palette effects don't split a frame into batches
+	GLuint paletteTex;
+	uint16_t shadowPalette[GBA_VIDEO_VERTICAL_PIXELS][512];
 	bool paletteDirty;
 
 	GLuint vramTex;
@@ -196,6 +206,10 @@ struct GBAVideoGLRenderer {
 };
 
 void GBAVideoGLRendererCreate(struct GBAVideoGLRenderer* renderer);
+// Checks the current context against what the shaders need (GL 3.2 or GLES 3.0)
+bool GBAVideoGLRendererIsSupported(void);
+// Reads back the frame just finished, waiting on the GPU if need be, even when readback is asynchronous
+void GBAVideoGLRendererReadPixels(struct GBAVideoGLRenderer* renderer, size_t* stride, const void** pixels);
 void GBAVideoGLRendererSetScale(struct GBAVideoGLRenderer* renderer, int scale);
 
 #endif
@@ -77,17 +77,34 @@ struct WindowControl {
 };
 
 #define MAX_WINDOW 5
+#define MAX_BAND_THREADS 8
 
 struct Window {
 	uint8_t endX;
 	struct WindowControl control;
 };
 
+struct GBAVideoSoftwareBands;
+struct GBAVideoSoftwareTileCache;
+
 struct GBAVideoSoftwareRenderer {
 	struct GBAVideoRenderer d;
 
 	color_t* outputBuffer;
 	int outputBufferStride;
+	// Set when outputBuffer is in another format than color_t. Lines are then drawn into
+	// convertSource and converted into outputBuffer, whose stride counts pixels of that format.
+	mColorRowConverter convertRow;
+	unsigned convertBytes;
+	color_t convertSource[GBA_VIDEO_HORIZONTAL_PIXELS];
+
+	// Scanlines are rendered in parallel bands at the end of the frame when this is above 1
+	int threads;
+	struct GBAVideoSoftwareBands* bands;
+
+	// Tile rows are also kept pre-expanded to one palette index per byte when this is set
+	bool decodeTiles;
+	struct GBAVideoSoftwareTileCache* tileCache;
 
 	uint32_t* temporaryBuffer;
 
@@ -103,7 +120,11 @@ struct GBAVideoSoftwareRenderer {
 	unsigned target2Obj;
 	unsigned target2Bd;
 	bool blendDirty;
+	// Halves of variantPalette left stale until a line uses them, backgrounds in bit 0 and sprites in bit 1
+	unsigned variantDirty;
 	enum GBAVideoBlendEffect blendEffect;
+	// Used in place of mColorFrom555 to turn BGR555 into output colors when set, e.g. for color correction
+	const color_t* colorTable;
 	color_t normalPalette[512];
 	color_t variantPalette[512];
 	color_t highlightPalette[512];
@@ -128,6 +149,8 @@ struct GBAVideoSoftwareRenderer {
 
 	int nWindows;
 	struct Window windows[MAX_WINDOW];
+	// Which windows covered the line the spans were built for, or -1 once they need rebuilding
+	int windowsKey;
 
 	struct GBAVideoSoftwareBackground bg[4];
 
@@ -135,10 +158,17 @@ struct GBAVideoSoftwareRenderer {
 	bool oamDirty;
 	int oamMax;
 	struct GBAVideoRendererSprite sprites[128];
+	uint8_t spriteLineCount[GBA_VIDEO_VERTICAL_PIXELS];
+	uint8_t spriteLines[GBA_VIDEO_VERTICAL_PIXELS][128];
 	int16_t objOffsetX;
 	int16_t objOffsetY;
 
 	uint32_t scanlineDirty[5];
+	// Scanlines whose output was lost (e.g. to a new output buffer) without their contents changing
+	uint32_t scanlineStale[5];
+	// Whether any scanline was drawn since the last frame finished, and whether that frame had any
+	bool frameDirty;
+	bool frameChanged;
 	uint16_t nextIo[REG_SOUND1CNT_LO];
 	struct ScanlineCache {
 		uint16_t io[REG_SOUND1CNT_LO];
@@ -153,6 +183,10 @@ struct GBAVideoSoftwareRenderer {
 };
 
 void GBAVideoSoftwareRendererCreate(struct GBAVideoSoftwareRenderer* renderer);
+void GBAVideoSoftwareRendererSetThreads(struct GBAVideoSoftwareRenderer* renderer, int threads);
+void GBAVideoSoftwareRendererSetTileCache(struct GBAVideoSoftwareRenderer* renderer, bool enable);
+// The table has 32768 entries and must outlive the renderer, or be unset first
+void GBAVideoSoftwareRendererSetColorTable(struct GBAVideoSoftwareRenderer* renderer, const color_t* table);
 
 CXX_GUARD_START
 
@@ -0,0 +1,82 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef RR_CMV_H
+#define RR_CMV_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba/internal/gba/rr/rr.h>
+#include <mgba-util/threading.h>
+#include <mgba-util/vector.h>
+
+#define GBA_CMV_DEFAULT_KEYFRAME_INTERVAL 3600
+
+struct GBA;
+struct VFile;
+
+struct GBACMVKeyframe {
+	uint32_t frame;
+	uint32_t offset;
+};
+
+DECLARE_VECTOR(GBACMVKeyframeList, struct GBACMVKeyframe);
+
+// A compact movie: one input word per run of identical frames, with savestates embedded every
+// keyframeInterval frames so playback can seek. Recording only appends to a memory buffer; full
+// buffers are written out by a thread, in large blocks.
+struct GBACMVContext {
+	struct GBARRContext d;
+	struct GBA* gba;
+	struct VFile* vf;
+
+	// Frames between embedded savestates, or 0 for none besides the one at the start
+	uint32_t keyframeInterval;
+
+	bool isPlaying;
+	bool isRecording;
+	bool autorecord;
+	bool inputThisFrame;
+	bool loadingState;
+
+	uint16_t currentInput;
+	uint16_t runInput;
+	uint32_t runLength;
+	uint32_t endOffset;
+
+	struct GBACMVKeyframeList keyframes;
+	struct GBASerializedState* scratch;
+
+	// Recording state; offset counts everything emitted, written or not
+	uint8_t* buffer;
+	size_t bufferSize;
+	size_t bufferCapacity;
+	uint32_t offset;
+	uint32_t lastFlush;
+
+#ifndef DISABLE_THREADING
+	bool writerRunning;
+	bool writerBusy;
+	uint8_t* writerBuffer;
+	size_t writerSize;
+	size_t writerCapacity;
+	Thread writer;
+	Mutex mutex;
+	Condition cond;
+#endif
+};
+
+void GBACMVContextCreate(struct GBACMVContext*, struct GBA*);
+
+// Takes ownership of vf; an empty file can be recorded into
+bool GBACMVSetStream(struct GBACMVContext*, struct VFile*);
+// Moves playback to the embedded savestate closest before frame, returning the frame reached
+int32_t GBACMVSeek(struct GBACMVContext*, uint32_t frame);
+
+CXX_GUARD_END
+
+#endif
@@ -11,6 +11,7 @@
 CXX_GUARD_START
 
 #include <mgba/core/log.h>
+#include <mgba/core/savedata.h>
 #include <mgba/core/timing.h>
 
 mLOG_DECLARE_CATEGORY(GBA_SAVE);
@@ -59,11 +60,6 @@ enum FlashManufacturer {
 	FLASH_MFG_SANYO = 0x1362
 };
 
-enum SavedataDirty {
-	SAVEDATA_DIRT_NEW = 1,
-	SAVEDATA_DIRT_SEEN = 2
-};
-
 enum {
 	SAVEDATA_FLASH_BASE = 0x0E005555,
 
@@ -91,8 +87,7 @@ struct GBASavedata {
 	unsigned settling;
 	struct mTimingEvent dust;
 
-	enum SavedataDirty dirty;
-	uint32_t dirtAge;
+	struct mSavedataFlusher flusher;
 
 	enum FlashStateMachine flashState;
 };
@@ -116,8 +111,10 @@ void GBASavedataWriteFlash(struct GBASavedata* savedata, uint16_t address, uint8
 
 uint16_t GBASavedataReadEEPROM(struct GBASavedata* savedata);
 void GBASavedataWriteEEPROM(struct GBASavedata* savedata, uint16_t value, uint32_t writeSize);
+void GBASavedataWriteEEPROMBlock(struct GBASavedata* savedata, const uint8_t* data, uint32_t units, uint32_t writeSize, int32_t firstCycles, int32_t seqCycles);
 
 void GBASavedataClean(struct GBASavedata* savedata, uint32_t frameCount);
+void GBASavedataFinish(struct GBASavedata* savedata);
 
 struct GBASerializedState;
 void GBASavedataSerialize(const struct GBASavedata* savedata, struct GBASerializedState* state);
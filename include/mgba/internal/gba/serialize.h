@@ -339,6 +339,18 @@ struct VDir;
 
 void GBASerialize(struct GBA* gba, struct GBASerializedState* state);
 bool GBADeserialize(struct GBA* gba, const struct GBASerializedState* state);
+// Only the given mSTATE_REGION_ parts of the state, see GBAStateRegions; the header is always included
+void GBASerializeRegions(struct GBA* gba, struct GBASerializedState* state, uint32_t regions);
+bool GBADeserializeRegions(struct GBA* gba, const struct GBASerializedState* state, uint32_t regions);
+bool GBACollectDirtyState(struct GBA* gba, uint32_t* pages, size_t size);
+// Hashes the live registers, memory and save data, which is much cheaper than serializing them first
+uint64_t GBAStateHash(struct GBA* gba);
+// Continues from the live state of another GBA running the same game. scratch is only
+// used for the registers and events; memory is copied from source directly.
+bool GBACopyState(struct GBA* gba, struct GBA* source, struct GBASerializedState* scratch);
+
+extern const struct mStateRegion GBAStateRegions[];
+extern const size_t GBAStateRegionCount;
 
 CXX_GUARD_END
 
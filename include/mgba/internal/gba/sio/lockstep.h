@@ -22,6 +22,10 @@ struct GBASIOLockstep {
 
 	uint16_t multiRecv[MAX_GBAS];
 	uint32_t normalRecv[MAX_GBAS];
+
+	// While no transfer is in flight, the master hands out time to the other players
+	// in slices that grow up to this many cycles, so they sync less often; 0 disables it
+	int32_t idleWindow;
 };
 
 struct GBASIOLockstepNode {
@@ -31,6 +35,7 @@ struct GBASIOLockstepNode {
 
 	volatile int32_t nextEvent;
 	int32_t eventDiff;
+	int32_t increment;
 	bool normalSO;
 	int id;
 	enum GBASIOMode mode;
@@ -0,0 +1,83 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef GBA_SIO_NET_H
+#define GBA_SIO_NET_H
+
+#include <mgba-util/common.h>
+
+CXX_GUARD_START
+
+#include <mgba/core/timing.h>
+#include <mgba/internal/gba/sio.h>
+#include <mgba-util/socket.h>
+
+#define GBA_SIO_NET_QUEUE 32
+#define GBA_SIO_NET_HISTORY 16
+
+struct GBASIONetMessage {
+	uint32_t sequence;
+	uint8_t type;
+	uint32_t transfer;
+	uint16_t data[MAX_GBAS];
+	uint32_t hash;
+};
+
+struct GBASIONetPeer {
+	struct Address address;
+	int port;
+	bool known;
+	bool connected;
+
+	// Messages stay queued and are sent again with every packet until they're acknowledged
+	uint32_t nextSequence;
+	uint32_t sent;
+	uint32_t acked;
+	uint32_t received;
+	bool ackPending;
+	struct GBASIONetMessage queue[GBA_SIO_NET_QUEUE];
+
+	bool hasData;
+	uint16_t data;
+	uint16_t lastData;
+};
+
+// A multiplayer link cable between separate devices, with the master talking to
+// every other player over UDP. Only the master ever waits on the network: the
+// other players answer transfers as they arrive, like the passive side of a cable.
+struct GBASIONetLink {
+	struct GBASIODriver d;
+	struct mTimingEvent event;
+	Socket socket;
+	int id;
+	int players;
+	struct GBASIONetPeer peers[MAX_GBAS];
+
+	// Cycles the master keeps running past the end of a transfer while data is still in flight
+	int32_t inputDelay;
+	// Whether the master then fills in late data with what that player sent last, instead of waiting
+	bool predict;
+
+	uint32_t transfer;
+	bool transferActive;
+	int32_t transferLate;
+	uint16_t transferData[MAX_GBAS];
+
+	// Running hash of everything transferred, compared between players to spot desyncs
+	uint32_t hash;
+	uint32_t historyTransfer[GBA_SIO_NET_HISTORY];
+	uint32_t historyHash[GBA_SIO_NET_HISTORY];
+	bool desynced;
+	unsigned ticks;
+};
+
+void GBASIONetLinkCreate(struct GBASIONetLink*);
+bool GBASIONetLinkOpen(struct GBASIONetLink*, int id, int players, int port, const struct Address* bindAddress);
+void GBASIONetLinkClose(struct GBASIONetLink*);
+void GBASIONetLinkSetPeer(struct GBASIONetLink*, int id, const struct Address* address, int port);
+
+CXX_GUARD_END
+
+#endif
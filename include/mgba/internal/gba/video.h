@@ -204,6 +204,8 @@ struct GBAVideo {
 	struct GBA* p;
 	struct GBAVideoRenderer* renderer;
 	struct mTimingEvent event;
+	// The current line's HBlank had nothing to do, so the event skips straight to the next HDraw
+	bool mergedHblank;
 
 	// VCOUNT
 	int vcount;
@@ -223,10 +225,17 @@ void GBAVideoDeinit(struct GBAVideo* video);
 void GBAVideoAssociateRenderer(struct GBAVideo* video, struct GBAVideoRenderer* renderer);
 
 void GBAVideoWriteDISPSTAT(struct GBAVideo* video, uint16_t value);
+uint16_t GBAVideoReadDISPSTAT(const struct GBAVideo* video);
+void GBAVideoSplitHblank(struct GBAVideo* video);
+void GBAVideoSplitDueHblank(struct GBAVideo* video, uint32_t when);
 
 struct GBASerializedState;
 void GBAVideoSerialize(const struct GBAVideo* video, struct GBASerializedState* state);
 void GBAVideoDeserialize(struct GBAVideo* video, const struct GBASerializedState* state);
+// Only the palette, OAM and VRAM named in the mSTATE_REGION_ bits, plus the timing with mSTATE_REGION_CORE
+void GBAVideoSerializeRegions(const struct GBAVideo* video, struct GBASerializedState* state, uint32_t regions);
+void GBAVideoDeserializeRegions(struct GBAVideo* video, const struct GBASerializedState* state, uint32_t regions);
+void GBAVideoCopyState(struct GBAVideo* video, const struct GBAVideo* source);
 
 extern MGBA_EXPORT const int GBAVideoObjSizes[16][2];
 
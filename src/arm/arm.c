@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/internal/arm/arm.h>
 
+#include <mgba/internal/arm/block-cache.h>
 #include <mgba/internal/arm/isa-arm.h>
 #include <mgba/internal/arm/isa-inlines.h>
 #include <mgba/internal/arm/isa-thumb.h>
@@ -88,6 +89,7 @@ void ARMDeinit(struct ARMCore* cpu) {
 			cpu->components[i]->deinit(cpu->components[i]);
 		}
 	}
+	ARMSetBlockCache(cpu, false);
 }
 
 void ARMSetComponents(struct ARMCore* cpu, struct mCPUComponent* master, int extra, struct mCPUComponent** extras) {
@@ -132,6 +134,7 @@ void ARMReset(struct ARMCore* cpu) {
 
 	cpu->shifterOperand = 0;
 	cpu->shifterCarryOut = 0;
+	cpu->lazyFlags = ARM_LAZY_NONE;
 
 	cpu->executionMode = MODE_THUMB;
 	_ARMSetMode(cpu, MODE_ARM);
@@ -145,6 +148,7 @@ void ARMReset(struct ARMCore* cpu) {
 }
 
 void ARMRaiseIRQ(struct ARMCore* cpu) {
+	ARMCommitFlags(cpu);
 	if (cpu->cpsr.i) {
 		return;
 	}
@@ -167,6 +171,7 @@ void ARMRaiseIRQ(struct ARMCore* cpu) {
 }
 
 void ARMRaiseSWI(struct ARMCore* cpu) {
+	ARMCommitFlags(cpu);
 	union PSR cpsr = cpu->cpsr;
 	int instructionWidth;
 	if (cpu->executionMode == MODE_THUMB) {
@@ -185,6 +190,7 @@ void ARMRaiseSWI(struct ARMCore* cpu) {
 }
 
 void ARMRaiseUndefined(struct ARMCore* cpu) {
+	ARMCommitFlags(cpu);
 	union PSR cpsr = cpu->cpsr;
 	int instructionWidth;
 	if (cpu->executionMode == MODE_THUMB) {
@@ -209,58 +215,9 @@ static inline void ARMStep(struct ARMCore* cpu) {
 	LOAD_32(cpu->prefetch[1], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion);
 
 	unsigned condition = opcode >> 28;
-	if (condition != 0xE) {
-		bool conditionMet = false;
-		switch (condition) {
-		case 0x0:
-			conditionMet = ARM_COND_EQ;
-			break;
-		case 0x1:
-			conditionMet = ARM_COND_NE;
-			break;
-		case 0x2:
-			conditionMet = ARM_COND_CS;
-			break;
-		case 0x3:
-			conditionMet = ARM_COND_CC;
-			break;
-		case 0x4:
-			conditionMet = ARM_COND_MI;
-			break;
-		case 0x5:
-			conditionMet = ARM_COND_PL;
-			break;
-		case 0x6:
-			conditionMet = ARM_COND_VS;
-			break;
-		case 0x7:
-			conditionMet = ARM_COND_VC;
-			break;
-		case 0x8:
-			conditionMet = ARM_COND_HI;
-			break;
-		case 0x9:
-			conditionMet = ARM_COND_LS;
-			break;
-		case 0xA:
-			conditionMet = ARM_COND_GE;
-			break;
-		case 0xB:
-			conditionMet = ARM_COND_LT;
-			break;
-		case 0xC:
-			conditionMet = ARM_COND_GT;
-			break;
-		case 0xD:
-			conditionMet = ARM_COND_LE;
-			break;
-		default:
-			break;
-		}
-		if (!conditionMet) {
-			cpu->cycles += ARM_PREFETCH_CYCLES;
-			return;
-		}
+	if (condition != 0xE && !ARMTestCondition(cpu, condition)) {
+		cpu->cycles += ARM_PREFETCH_CYCLES;
+		return;
 	}
 	ARMInstruction instruction = _armTable[((opcode >> 16) & 0xFF0) | ((opcode >> 4) & 0x00F)];
 	instruction(cpu, opcode);
@@ -277,16 +234,95 @@ static inline void ThumbStep(struct ARMCore* cpu) {
 
 void ARMRun(struct ARMCore* cpu) {
 	while (cpu->cycles >= cpu->nextEvent) {
-		cpu->irqh.processEvents(cpu);
+		ARM_IRQH(cpu, processEvents)(cpu);
 	}
 	if (cpu->executionMode == MODE_THUMB) {
 		ThumbStep(cpu);
 	} else {
 		ARMStep(cpu);
 	}
+	ARMCommitFlags(cpu);
+}
+
+static void _ThumbRunBlock(struct ARMCore* cpu, const struct ARMCachedBlock* block) {
+	uint32_t pc = cpu->gprs[ARM_PC];
+	const struct ARMCachedInstruction* instruction = block->instructions;
+	unsigned i;
+	for (i = 0; i < block->length; ++i, ++instruction) {
+		cpu->prefetch[0] = instruction[1].opcode;
+		cpu->prefetch[1] = instruction[2].opcode;
+		pc += WORD_SIZE_THUMB;
+		cpu->gprs[ARM_PC] = pc;
+		instruction->handler.thumb(cpu, instruction->opcode);
+		if (instruction->fused) {
+			pc += WORD_SIZE_THUMB;
+			++i;
+			++instruction;
+		}
+		if (cpu->gprs[ARM_PC] != (int32_t) pc || !block->valid || cpu->cycles >= cpu->nextEvent) {
+			break;
+		}
+	}
+}
+
+static void _ARMRunBlock(struct ARMCore* cpu, const struct ARMCachedBlock* block) {
+	uint32_t pc = cpu->gprs[ARM_PC];
+	const struct ARMCachedInstruction* instruction = block->instructions;
+	unsigned i;
+	for (i = 0; i < block->length; ++i, ++instruction) {
+		cpu->prefetch[0] = instruction[1].opcode;
+		cpu->prefetch[1] = instruction[2].opcode;
+		pc += WORD_SIZE_ARM;
+		cpu->gprs[ARM_PC] = pc;
+		unsigned condition = instruction->opcode >> 28;
+		if (condition != 0xE && !ARMTestCondition(cpu, condition)) {
+			cpu->cycles += ARM_PREFETCH_CYCLES;
+		} else {
+			instruction->handler.arm(cpu, instruction->opcode);
+		}
+		if (cpu->gprs[ARM_PC] != (int32_t) pc || !block->valid || cpu->cycles >= cpu->nextEvent) {
+			break;
+		}
+	}
+}
+
+static void _ARMRunLoopCached(struct ARMCore* cpu) {
+	struct ARMBlockCache* cache = cpu->blockCache;
+	while (cpu->cycles < cpu->nextEvent) {
+		struct ARMCachedBlock* block = NULL;
+		if (cache->activeCacheable) {
+			block = ARMBlockCacheLookup(cache, cpu);
+		}
+		// The prefetch queue may hold stale opcodes after self-modifying code,
+		// in which case only the plain interpreter can be trusted
+		if (!block || block->instructions[0].opcode != cpu->prefetch[0] || block->instructions[1].opcode != cpu->prefetch[1]) {
+			if (cpu->executionMode == MODE_THUMB) {
+				ThumbStep(cpu);
+			} else {
+				ARMStep(cpu);
+			}
+		} else if (block->mode == MODE_THUMB) {
+			_ThumbRunBlock(cpu, block);
+		} else {
+			_ARMRunBlock(cpu, block);
+		}
+	}
+	ARMCommitFlags(cpu);
+	ARM_IRQH(cpu, processEvents)(cpu);
 }
 
 void ARMRunLoop(struct ARMCore* cpu) {
+	if (cpu->blockCache) {
+		_ARMRunLoopCached(cpu);
+		return;
+	}
+#ifdef ENABLE_THREADED_DISPATCH
+	if (cpu->executionMode == MODE_THUMB) {
+		ThumbRunThreaded(cpu);
+	} else {
+		ARMRunThreaded(cpu);
+	}
+#else
 	if (cpu->executionMode == MODE_THUMB) {
 		while (cpu->cycles < cpu->nextEvent) {
 			ThumbStep(cpu);
@@ -296,7 +332,9 @@ void ARMRunLoop(struct ARMCore* cpu) {
 			ARMStep(cpu);
 		}
 	}
-	cpu->irqh.processEvents(cpu);
+#endif
+	ARMCommitFlags(cpu);
+	ARM_IRQH(cpu, processEvents)(cpu);
 }
 
 void ARMRunFake(struct ARMCore* cpu, uint32_t opcode) {
@@ -308,3 +346,12 @@ void ARMRunFake(struct ARMCore* cpu, uint32_t opcode) {
 	cpu->prefetch[1] = cpu->prefetch[0];
 	cpu->prefetch[0] = opcode;
 }
+
+void ARMSetBlockCache(struct ARMCore* cpu, bool enable) {
+	if (enable && !cpu->blockCache) {
+		cpu->blockCache = ARMBlockCacheCreate();
+	} else if (!enable && cpu->blockCache) {
+		ARMBlockCacheDestroy(cpu->blockCache);
+		cpu->blockCache = NULL;
+	}
+}
@@ -0,0 +1,129 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/internal/arm/block-cache.h>
+
+#include <mgba/internal/arm/decoder.h>
+#include <mgba/internal/arm/macros.h>
+#include <mgba-util/memory.h>
+
+struct ARMBlockCache* ARMBlockCacheCreate(void) {
+	struct ARMBlockCache* cache = anonymousMemoryMap(sizeof(*cache));
+	if (!cache) {
+		return NULL;
+	}
+	ARMBlockCacheClear(cache);
+	return cache;
+}
+
+void ARMBlockCacheDestroy(struct ARMBlockCache* cache) {
+	mappedMemoryFree(cache, sizeof(*cache));
+}
+
+void ARMBlockCacheClear(struct ARMBlockCache* cache) {
+	size_t i;
+	for (i = 0; i < ARM_BLOCK_CACHE_SLOTS; ++i) {
+		cache->blocks[i].valid = false;
+		cache->blocks[i].candidateHits = 0;
+	}
+	memset(cache->codePages, 0, sizeof(cache->codePages));
+}
+
+static bool _endsBlock(const struct ARMInstructionInfo* info) {
+	if (info->traps || info->mnemonic == ARM_MN_MSR) {
+		return true;
+	}
+	// The decoder reports any write to the PC as an indirect branch
+	return info->branchType != ARM_BRANCH_NONE && info->condition == ARM_CONDITION_AL;
+}
+
+struct ARMCachedBlock* ARMBlockCacheTranslate(struct ARMBlockCache* cache, struct ARMCore* cpu, uint32_t key) {
+	uint32_t mask = cpu->memory.activeMask;
+	uint32_t offset = key & mask;
+	enum ExecutionMode mode = cpu->executionMode;
+	unsigned width = mode == MODE_THUMB ? WORD_SIZE_THUMB : WORD_SIZE_ARM;
+	uint32_t span = (ARM_BLOCK_MAX_LENGTH + 2) * width;
+	if ((uint64_t) offset + span > (uint64_t) mask + 1) {
+		// Don't bother with blocks that would wrap around the region
+		return NULL;
+	}
+
+	struct ARMCachedBlock* block = &cache->blocks[ARMBlockCacheSlot(key, mode)];
+	if (block->candidateKey != key || block->candidateMode != mode) {
+		block->candidateKey = key;
+		block->candidateMode = mode;
+		block->candidateHits = 0;
+	}
+	if (++block->candidateHits < ARM_BLOCK_HOT_THRESHOLD) {
+		// Leave cold code to the interpreter so it can't evict hot blocks
+		return NULL;
+	}
+	block->candidateHits = 0;
+	block->key = key;
+	block->mode = mode;
+	block->length = ARM_BLOCK_MAX_LENGTH;
+
+	// Read through the active region exactly as the prefetcher would
+	struct ARMInstructionInfo info;
+	unsigned i;
+	for (i = 0; i < block->length + 2; ++i) {
+		struct ARMCachedInstruction* instruction = &block->instructions[i];
+		instruction->fused = false;
+		if (mode == MODE_THUMB) {
+			LOAD_16(instruction->opcode, offset + i * WORD_SIZE_THUMB, cpu->memory.activeRegion);
+			instruction->handler.thumb = _thumbTable[instruction->opcode >> 6];
+		} else {
+			LOAD_32(instruction->opcode, offset + i * WORD_SIZE_ARM, cpu->memory.activeRegion);
+			instruction->handler.arm = _armTable[((instruction->opcode >> 16) & 0xFF0) | ((instruction->opcode >> 4) & 0x00F)];
+		}
+		if (i >= block->length) {
+			continue;
+		}
+		if (mode == MODE_THUMB) {
+			ARMDecodeThumb(instruction->opcode, &info);
+		} else {
+			ARMDecodeARM(instruction->opcode, &info);
+		}
+		if (_endsBlock(&info)) {
+			block->length = i + 1;
+		}
+	}
+
+	if (mode == MODE_THUMB) {
+		for (i = 0; i + 1 < block->length; ++i) {
+			struct ARMCachedInstruction* instruction = &block->instructions[i];
+			ThumbInstruction fused = ThumbFuse(instruction->opcode, instruction[1].opcode);
+			if (fused) {
+				instruction->handler.thumb = fused;
+				instruction->fused = true;
+				++i;
+			}
+		}
+	}
+
+	cache->codePages[ARMBlockCachePage(key)] = 1;
+	cache->codePages[ARMBlockCachePage(key + span - 1)] = 1;
+	block->valid = true;
+	return block;
+}
+
+void ARMBlockCacheInvalidateRange(struct ARMBlockCache* cache, uint32_t key) {
+	// Any block whose span (including its prefetch tail) covers this word is stale
+	uint32_t start = key & ~3;
+	uint32_t end = key | 3;
+	uint32_t candidate;
+	for (candidate = start - (ARM_BLOCK_MAX_LENGTH + 2) * WORD_SIZE_THUMB; candidate != end + 1; candidate += WORD_SIZE_THUMB) {
+		struct ARMCachedBlock* block = &cache->blocks[ARMBlockCacheSlot(candidate, MODE_THUMB)];
+		if (block->valid && block->mode == MODE_THUMB && block->key == candidate) {
+			block->valid = false;
+		}
+	}
+	for (candidate = start - (ARM_BLOCK_MAX_LENGTH + 2) * WORD_SIZE_ARM; candidate != start + WORD_SIZE_ARM; candidate += WORD_SIZE_ARM) {
+		struct ARMCachedBlock* block = &cache->blocks[ARMBlockCacheSlot(candidate, MODE_ARM)];
+		if (block->valid && block->mode == MODE_ARM && block->key == candidate) {
+			block->valid = false;
+		}
+	}
+}
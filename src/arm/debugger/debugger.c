@@ -6,6 +6,7 @@
 #include <mgba/internal/arm/debugger/debugger.h>
 
 #include <mgba/core/core.h>
+#include <mgba/core/timing.h>
 #include <mgba/internal/arm/arm.h>
 #include <mgba/internal/arm/decoder.h>
 #include <mgba/internal/arm/isa-inlines.h>
@@ -24,11 +25,37 @@ static struct ARMDebugBreakpoint* _lookupBreakpoint(struct ARMDebugBreakpointLis
 	return 0;
 }
 
+static void _indexBreakpoints(struct ARMDebugger* debugger) {
+	TableClear(&debugger->breakpointIndex);
+	memset(debugger->breakpointPages, 0, sizeof(debugger->breakpointPages));
+	// Walk backwards so the first breakpoint at an address wins, as in a linear scan
+	size_t i;
+	for (i = ARMDebugBreakpointListSize(&debugger->breakpoints); i; --i) {
+		struct ARMDebugBreakpoint* breakpoint = ARMDebugBreakpointListGetPointer(&debugger->breakpoints, i - 1);
+		unsigned bucket = ARMDebuggerPageBucket(breakpoint->d.address);
+		debugger->breakpointPages[bucket >> 5] |= 1U << (bucket & 31);
+		TableInsert(&debugger->breakpointIndex, breakpoint->d.address, breakpoint);
+	}
+}
+
+static void _indexWatchpoints(struct ARMDebugger* debugger) {
+	memset(debugger->watchpointPages, 0, sizeof(debugger->watchpointPages));
+	size_t i;
+	for (i = 0; i < mWatchpointListSize(&debugger->watchpoints); ++i) {
+		struct mWatchpoint* watchpoint = mWatchpointListGetPointer(&debugger->watchpoints, i);
+		debugger->watchpointPages[ARMDebuggerPageBucket(watchpoint->address)] |= watchpoint->type;
+	}
+}
+
 static void _destroyBreakpoint(struct ARMDebugBreakpoint* breakpoint) {
 	if (breakpoint->d.condition) {
 		parseFree(breakpoint->d.condition);
 		free(breakpoint->d.condition);
 	}
+	if (breakpoint->d.program) {
+		parseProgramFree(breakpoint->d.program);
+		free(breakpoint->d.program);
+	}
 }
 
 static void _destroyWatchpoint(struct mWatchpoint* watchpoint) {
@@ -36,6 +63,10 @@ static void _destroyWatchpoint(struct mWatchpoint* watchpoint) {
 		parseFree(watchpoint->condition);
 		free(watchpoint->condition);
 	}
+	if (watchpoint->program) {
+		parseProgramFree(watchpoint->program);
+		free(watchpoint->program);
+	}
 }
 
 static void ARMDebuggerCheckBreakpoints(struct mDebuggerPlatform* d) {
@@ -47,16 +78,17 @@ static void ARMDebuggerCheckBreakpoints(struct mDebuggerPlatform* d) {
 	} else {
 		instructionLength = WORD_SIZE_THUMB;
 	}
-	struct ARMDebugBreakpoint* breakpoint = _lookupBreakpoint(&debugger->breakpoints, debugger->cpu->gprs[ARM_PC] - instructionLength);
+	uint32_t address = debugger->cpu->gprs[ARM_PC] - instructionLength;
+	unsigned bucket = ARMDebuggerPageBucket(address);
+	if (!(debugger->breakpointPages[bucket >> 5] & (1U << (bucket & 31)))) {
+		return;
+	}
+	struct ARMDebugBreakpoint* breakpoint = TableLookup(&debugger->breakpointIndex, address);
 	if (!breakpoint) {
 		return;
 	}
-	if (breakpoint->d.condition) {
-		int32_t value;
-		int segment;
-		if (!mDebuggerEvaluateParseTree(d->p, breakpoint->d.condition, &value, &segment) || !(value || segment >= 0)) {
-			return;
-		}
+	if (breakpoint->d.condition && !mDebuggerCheckCondition(d->p, breakpoint->d.condition, breakpoint->d.program)) {
+		return;
 	}
 	struct mDebuggerEntryInfo info = {
 		.address = breakpoint->d.address,
@@ -79,8 +111,10 @@ static void ARMDebuggerListWatchpoints(struct mDebuggerPlatform*, struct mWatchp
 static void ARMDebuggerCheckBreakpoints(struct mDebuggerPlatform*);
 static bool ARMDebuggerHasBreakpoints(struct mDebuggerPlatform*);
 static void ARMDebuggerTrace(struct mDebuggerPlatform*, char* out, size_t* length);
+static void ARMDebuggerTraceEntry(struct mDebuggerPlatform*, struct mDebuggerTraceEntry* entry);
 static bool ARMDebuggerGetRegister(struct mDebuggerPlatform*, const char* name, int32_t* value);
 static bool ARMDebuggerSetRegister(struct mDebuggerPlatform*, const char* name, int32_t value);
+static const int32_t* ARMDebuggerGetRegisterPointer(struct mDebuggerPlatform*, const char* name);
 
 struct mDebuggerPlatform* ARMDebuggerPlatformCreate(void) {
 	struct mDebuggerPlatform* platform = (struct mDebuggerPlatform*) malloc(sizeof(struct ARMDebugger));
@@ -95,8 +129,10 @@ struct mDebuggerPlatform* ARMDebuggerPlatformCreate(void) {
 	platform->checkBreakpoints = ARMDebuggerCheckBreakpoints;
 	platform->hasBreakpoints = ARMDebuggerHasBreakpoints;
 	platform->trace = ARMDebuggerTrace;
+	platform->traceEntry = ARMDebuggerTraceEntry;
 	platform->getRegister = ARMDebuggerGetRegister;
 	platform->setRegister = ARMDebuggerSetRegister;
+	platform->getRegisterPointer = ARMDebuggerGetRegisterPointer;
 	return platform;
 }
 
@@ -108,6 +144,9 @@ void ARMDebuggerInit(void* cpu, struct mDebuggerPlatform* platform) {
 	ARMDebugBreakpointListInit(&debugger->breakpoints, 0);
 	ARMDebugBreakpointListInit(&debugger->swBreakpoints, 0);
 	mWatchpointListInit(&debugger->watchpoints, 0);
+	TableInit(&debugger->breakpointIndex, 0, NULL);
+	memset(debugger->breakpointPages, 0, sizeof(debugger->breakpointPages));
+	memset(debugger->watchpointPages, 0, sizeof(debugger->watchpointPages));
 }
 
 void ARMDebuggerDeinit(struct mDebuggerPlatform* platform) {
@@ -127,6 +166,7 @@ void ARMDebuggerDeinit(struct mDebuggerPlatform* platform) {
 		_destroyBreakpoint(ARMDebugBreakpointListGetPointer(&debugger->breakpoints, i));
 	}
 	ARMDebugBreakpointListDeinit(&debugger->breakpoints);
+	TableDeinit(&debugger->breakpointIndex);
 
 	for (i = 0; i < mWatchpointListSize(&debugger->watchpoints); ++i) {
 		_destroyWatchpoint(mWatchpointListGetPointer(&debugger->watchpoints, i));
@@ -139,6 +179,7 @@ static void ARMDebuggerEnter(struct mDebuggerPlatform* platform, enum mDebuggerE
 	struct ARMDebugger* debugger = (struct ARMDebugger*) platform;
 	struct ARMCore* cpu = debugger->cpu;
 	cpu->nextEvent = cpu->cycles;
+	ARMCommitFlags(cpu);
 	if (reason == DEBUGGER_ENTER_BREAKPOINT) {
 		struct ARMDebugBreakpoint* breakpoint = _lookupBreakpoint(&debugger->swBreakpoints, _ARMPCAddress(cpu));
 		if (breakpoint && breakpoint->d.type == BREAKPOINT_SOFTWARE) {
@@ -189,10 +230,12 @@ static ssize_t ARMDebuggerSetBreakpoint(struct mDebuggerPlatform* d, const struc
 	breakpoint->d = *info;
 	breakpoint->d.address &= ~1; // Clear Thumb bit since it's not part of a valid address
 	breakpoint->d.id = id;
+	breakpoint->d.program = mDebuggerCompileCondition(d->p, info->condition);
 	if (info->type == BREAKPOINT_SOFTWARE) {
 		// TODO
 		abort();
 	}
+	_indexBreakpoints(debugger);
 	return id;
 }
 
@@ -205,6 +248,7 @@ static bool ARMDebuggerClearBreakpoint(struct mDebuggerPlatform* d, ssize_t id)
 		if (ARMDebugBreakpointListGetPointer(breakpoints, i)->d.id == id) {
 			_destroyBreakpoint(ARMDebugBreakpointListGetPointer(breakpoints, i));
 			ARMDebugBreakpointListShift(breakpoints, i, 1);
+			_indexBreakpoints(debugger);
 			return true;
 		}
 	}
@@ -225,6 +269,7 @@ static bool ARMDebuggerClearBreakpoint(struct mDebuggerPlatform* d, ssize_t id)
 		if (mWatchpointListGetPointer(watchpoints, i)->id == id) {
 			_destroyWatchpoint(mWatchpointListGetPointer(watchpoints, i));
 			mWatchpointListShift(watchpoints, i, 1);
+			_indexWatchpoints(debugger);
 			if (!mWatchpointListSize(&debugger->watchpoints)) {
 				ARMDebuggerRemoveMemoryShim(debugger);
 			}
@@ -283,6 +328,8 @@ static ssize_t ARMDebuggerSetWatchpoint(struct mDebuggerPlatform* d, const struc
 	++debugger->nextId;
 	*watchpoint = *info;
 	watchpoint->id = id;
+	watchpoint->program = mDebuggerCompileCondition(d->p, info->condition);
+	_indexWatchpoints(debugger);
 	return id;
 }
 
@@ -295,6 +342,7 @@ static void ARMDebuggerListWatchpoints(struct mDebuggerPlatform* d, struct mWatc
 static void ARMDebuggerTrace(struct mDebuggerPlatform* d, char* out, size_t* length) {
 	struct ARMDebugger* debugger = (struct ARMDebugger*) d;
 	struct ARMCore* cpu = debugger->cpu;
+	ARMCommitFlags(cpu);
 
 	char disassembly[64];
 
@@ -328,20 +376,50 @@ static void ARMDebuggerTrace(struct mDebuggerPlatform* d, char* out, size_t* len
 		               cpu->cpsr.packed, disassembly);
 }
 
-bool ARMDebuggerGetRegister(struct mDebuggerPlatform* d, const char* name, int32_t* value) {
+static void ARMDebuggerTraceEntry(struct mDebuggerPlatform* d, struct mDebuggerTraceEntry* entry) {
 	struct ARMDebugger* debugger = (struct ARMDebugger*) d;
 	struct ARMCore* cpu = debugger->cpu;
+	ARMCommitFlags(cpu);
+
+	entry->opcodeSize = cpu->executionMode == MODE_ARM ? WORD_SIZE_ARM : WORD_SIZE_THUMB;
+	entry->address = _ARMPCAddress(cpu);
+	entry->opcode = cpu->prefetch[0];
+	entry->cycles = mTimingCurrentTime(d->p->core->timing);
 
+	// r0-r14 and the CPSR; the PC is implied by the address
+	memcpy(entry->registers, cpu->gprs, ARM_PC * sizeof(*cpu->gprs));
+	entry->registers[ARM_PC] = cpu->cpsr.packed;
+	entry->nRegisters = ARM_PC + 1;
+}
+
+static int _generalRegister(const char* name) {
 	if (strcmp(name, "sp") == 0) {
-		*value = cpu->gprs[ARM_SP];
-		return true;
+		return ARM_SP;
 	}
 	if (strcmp(name, "lr") == 0) {
-		*value = cpu->gprs[ARM_LR];
-		return true;
+		return ARM_LR;
 	}
 	if (strcmp(name, "pc") == 0) {
-		*value = cpu->gprs[ARM_PC];
+		return ARM_PC;
+	}
+	if (name[0] == 'r') {
+		char* end;
+		uint32_t reg = strtoul(&name[1], &end, 10);
+		if (reg <= ARM_PC) {
+			return reg;
+		}
+	}
+	return -1;
+}
+
+bool ARMDebuggerGetRegister(struct mDebuggerPlatform* d, const char* name, int32_t* value) {
+	struct ARMDebugger* debugger = (struct ARMDebugger*) d;
+	struct ARMCore* cpu = debugger->cpu;
+	ARMCommitFlags(cpu);
+
+	int reg = _generalRegister(name);
+	if (reg >= 0) {
+		*value = cpu->gprs[reg];
 		return true;
 	}
 	if (strcmp(name, "cpsr") == 0) {
@@ -353,20 +431,23 @@ bool ARMDebuggerGetRegister(struct mDebuggerPlatform* d, const char* name, int32
 		*value = cpu->spsr.packed;
 		return true;
 	}
-	if (name[0] == 'r') {
-		char* end;
-		uint32_t reg = strtoul(&name[1], &end, 10);
-		if (reg <= ARM_PC) {
-			*value = cpu->gprs[reg];
-			return true;
-		}
-	}
 	return false;
 }
 
+// The status registers are left out, since their flags have to be committed before they're read
+static const int32_t* ARMDebuggerGetRegisterPointer(struct mDebuggerPlatform* d, const char* name) {
+	struct ARMDebugger* debugger = (struct ARMDebugger*) d;
+	int reg = _generalRegister(name);
+	if (reg < 0) {
+		return NULL;
+	}
+	return &debugger->cpu->gprs[reg];
+}
+
 bool ARMDebuggerSetRegister(struct mDebuggerPlatform* d, const char* name, int32_t value) {
 	struct ARMDebugger* debugger = (struct ARMDebugger*) d;
 	struct ARMCore* cpu = debugger->cpu;
+	ARMCommitFlags(cpu);
 
 	if (strcmp(name, "sp") == 0) {
 		cpu->gprs[ARM_SP] = value;
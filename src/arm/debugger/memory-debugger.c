@@ -92,18 +92,18 @@ CREATE_MULTIPLE_WATCHPOINT_SHIM(storeMultiple, WATCHPOINT_WRITE)
 CREATE_SHIM(setActiveRegion, void, (struct ARMCore* cpu, uint32_t address), address)
 
 static bool _checkWatchpoints(struct ARMDebugger* debugger, uint32_t address, struct mDebuggerEntryInfo* info, enum mWatchpointType type, uint32_t newValue, int width) {
+	// A watchpoint only matches accesses within its own word, which never crosses a page
+	if (!(debugger->watchpointPages[ARMDebuggerPageBucket(address)] & type)) {
+		return false;
+	}
 	--width;
 	struct mWatchpoint* watchpoint;
 	size_t i;
 	for (i = 0; i < mWatchpointListSize(&debugger->watchpoints); ++i) {
 		watchpoint = mWatchpointListGetPointer(&debugger->watchpoints, i);
 		if (!((watchpoint->address ^ address) & ~width) && watchpoint->type & type) {
-			if (watchpoint->condition) {
-				int32_t value;
-				int segment;
-				if (!mDebuggerEvaluateParseTree(debugger->d.p, watchpoint->condition, &value, &segment) || !(value || segment >= 0)) {
-					return false;
-				}
+			if (watchpoint->condition && !mDebuggerCheckCondition(debugger->d.p, watchpoint->condition, watchpoint->program)) {
+				return false;
 			}
 
 			switch (width + 1) {
@@ -139,6 +139,8 @@ void ARMDebuggerInstallMemoryShim(struct ARMDebugger* debugger) {
 	debugger->cpu->memory.storeMultiple = DebuggerShim_storeMultiple;
 	debugger->cpu->memory.loadMultiple = DebuggerShim_loadMultiple;
 	debugger->cpu->memory.setActiveRegion = DebuggerShim_setActiveRegion;
+	// Watchpoints need to see every access
+	debugger->cpu->memory.fastPages = NULL;
 }
 
 void ARMDebuggerRemoveMemoryShim(struct ARMDebugger* debugger) {
@@ -151,4 +153,5 @@ void ARMDebuggerRemoveMemoryShim(struct ARMDebugger* debugger) {
 	debugger->cpu->memory.storeMultiple = debugger->originalMemory.storeMultiple;
 	debugger->cpu->memory.loadMultiple = debugger->originalMemory.loadMultiple;
 	debugger->cpu->memory.setActiveRegion = debugger->originalMemory.setActiveRegion;
+	debugger->cpu->memory.fastPages = debugger->originalMemory.fastPages;
 }
@@ -298,471 +298,44 @@ ATTRIBUTE_NOINLINE static void _neutralS(struct ARMCore* cpu, int32_t d) {
 		cpu->cycles += currentCycles; \
 	}
 
-#define DEFINE_ALU_INSTRUCTION_EX_ARM(NAME, S_BODY, SHIFTER, BODY) \
-	DEFINE_INSTRUCTION_ARM(NAME, \
-		int rd = (opcode >> 12) & 0xF; \
-		int rn = (opcode >> 16) & 0xF; \
-		UNUSED(rn); \
-		SHIFTER(cpu, opcode); \
-		BODY; \
-		S_BODY; \
-		if (rd == ARM_PC) { \
-			if (cpu->executionMode == MODE_ARM) { \
-				currentCycles += ARMWritePC(cpu); \
-			} else { \
-				currentCycles += ThumbWritePC(cpu); \
-			} \
-		})
-
-#define DEFINE_ALU_INSTRUCTION_ARM(NAME, S_BODY, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _LSL, , _shiftLSL, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## S_LSL, S_BODY, _shiftLSL, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _LSR, , _shiftLSR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## S_LSR, S_BODY, _shiftLSR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _ASR, , _shiftASR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## S_ASR, S_BODY, _shiftASR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _ROR, , _shiftROR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## S_ROR, S_BODY, _shiftROR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## I, , _immediate, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## SI, S_BODY, _immediate, BODY)
-
-#define DEFINE_ALU_INSTRUCTION_S_ONLY_ARM(NAME, S_BODY, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _LSL, S_BODY, _shiftLSL, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _LSR, S_BODY, _shiftLSR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _ASR, S_BODY, _shiftASR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## _ROR, S_BODY, _shiftROR, BODY) \
-	DEFINE_ALU_INSTRUCTION_EX_ARM(NAME ## I, S_BODY, _immediate, BODY)
-
-#define DEFINE_MULTIPLY_INSTRUCTION_EX_ARM(NAME, BODY, S_BODY) \
-	DEFINE_INSTRUCTION_ARM(NAME, \
-		int rd = (opcode >> 16) & 0xF; \
-		int rs = (opcode >> 8) & 0xF; \
-		int rm = opcode & 0xF; \
-		if (rd == ARM_PC) { \
-			return; \
-		} \
-		ARM_WAIT_MUL(cpu->gprs[rs]); \
-		BODY; \
-		S_BODY; \
-		currentCycles += cpu->memory.activeNonseqCycles32 - cpu->memory.activeSeqCycles32)
-
-#define DEFINE_MULTIPLY_INSTRUCTION_2_EX_ARM(NAME, BODY, S_BODY, WAIT) \
-	DEFINE_INSTRUCTION_ARM(NAME, \
-		int rd = (opcode >> 12) & 0xF; \
-		int rdHi = (opcode >> 16) & 0xF; \
-		int rs = (opcode >> 8) & 0xF; \
-		int rm = opcode & 0xF; \
-		if (rdHi == ARM_PC || rd == ARM_PC) { \
-			return; \
-		} \
-		currentCycles += cpu->memory.stall(cpu, WAIT); \
-		BODY; \
-		S_BODY; \
-		currentCycles += cpu->memory.activeNonseqCycles32 - cpu->memory.activeSeqCycles32)
-
-#define DEFINE_MULTIPLY_INSTRUCTION_ARM(NAME, BODY, S_BODY) \
-	DEFINE_MULTIPLY_INSTRUCTION_EX_ARM(NAME, BODY, ) \
-	DEFINE_MULTIPLY_INSTRUCTION_EX_ARM(NAME ## S, BODY, S_BODY)
-
-#define DEFINE_MULTIPLY_INSTRUCTION_2_ARM(NAME, BODY, S_BODY, WAIT) \
-	DEFINE_MULTIPLY_INSTRUCTION_2_EX_ARM(NAME, BODY, , WAIT) \
-	DEFINE_MULTIPLY_INSTRUCTION_2_EX_ARM(NAME ## S, BODY, S_BODY, WAIT)
-
-#define DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME, ADDRESS, WRITEBACK, LS, BODY) \
-	DEFINE_INSTRUCTION_ARM(NAME, \
-		uint32_t address; \
-		int rn = (opcode >> 16) & 0xF; \
-		int rd = (opcode >> 12) & 0xF; \
-		int rm = opcode & 0xF; \
-		UNUSED(rm); \
-		address = ADDRESS; \
-		ADDR_MODE_2_WRITEBACK_PRE_ ## LS (WRITEBACK); \
-		BODY; \
-		ADDR_MODE_2_WRITEBACK_POST_ ## LS (WRITEBACK);)
-
-#define DEFINE_LOAD_STORE_INSTRUCTION_SHIFTER_ARM(NAME, SHIFTER, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME, ADDR_MODE_2_RN, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(-, SHIFTER)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## U, ADDR_MODE_2_RN, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(+, SHIFTER)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## P, ADDR_MODE_2_INDEX(-, SHIFTER), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## PW, ADDR_MODE_2_INDEX(-, SHIFTER), ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_ADDRESS), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## PU, ADDR_MODE_2_INDEX(+, SHIFTER), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## PUW, ADDR_MODE_2_INDEX(+, SHIFTER), ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_ADDRESS), LS, BODY)
-
-#define DEFINE_LOAD_STORE_INSTRUCTION_ARM(NAME, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_SHIFTER_ARM(NAME ## _LSL_, ADDR_MODE_2_LSL, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_SHIFTER_ARM(NAME ## _LSR_, ADDR_MODE_2_LSR, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_SHIFTER_ARM(NAME ## _ASR_, ADDR_MODE_2_ASR, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_SHIFTER_ARM(NAME ## _ROR_, ADDR_MODE_2_ROR, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## I, ADDR_MODE_2_RN, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(-, ADDR_MODE_2_IMMEDIATE)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IU, ADDR_MODE_2_RN, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(+, ADDR_MODE_2_IMMEDIATE)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IP, ADDR_MODE_2_INDEX(-, ADDR_MODE_2_IMMEDIATE), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IPW, ADDR_MODE_2_INDEX(-, ADDR_MODE_2_IMMEDIATE), ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_ADDRESS), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IPU, ADDR_MODE_2_INDEX(+, ADDR_MODE_2_IMMEDIATE), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IPUW, ADDR_MODE_2_INDEX(+, ADDR_MODE_2_IMMEDIATE), ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_ADDRESS), LS, BODY) \
-
-#define DEFINE_LOAD_STORE_MODE_3_INSTRUCTION_ARM(NAME, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME, ADDR_MODE_3_RN, ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_INDEX(-, ADDR_MODE_3_RM)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## U, ADDR_MODE_3_RN, ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_INDEX(+, ADDR_MODE_3_RM)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## P, ADDR_MODE_3_INDEX(-, ADDR_MODE_3_RM), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## PW, ADDR_MODE_3_INDEX(-, ADDR_MODE_3_RM), ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_ADDRESS), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## PU, ADDR_MODE_3_INDEX(+, ADDR_MODE_3_RM), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## PUW, ADDR_MODE_3_INDEX(+, ADDR_MODE_3_RM), ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_ADDRESS), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## I, ADDR_MODE_3_RN, ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_INDEX(-, ADDR_MODE_3_IMMEDIATE)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IU, ADDR_MODE_3_RN, ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_INDEX(+, ADDR_MODE_3_IMMEDIATE)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IP, ADDR_MODE_3_INDEX(-, ADDR_MODE_3_IMMEDIATE), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IPW, ADDR_MODE_3_INDEX(-, ADDR_MODE_3_IMMEDIATE), ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_ADDRESS), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IPU, ADDR_MODE_3_INDEX(+, ADDR_MODE_3_IMMEDIATE), , LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IPUW, ADDR_MODE_3_INDEX(+, ADDR_MODE_3_IMMEDIATE), ADDR_MODE_3_WRITEBACK(ADDR_MODE_3_ADDRESS), LS, BODY) \
-
-#define DEFINE_LOAD_STORE_T_INSTRUCTION_SHIFTER_ARM(NAME, SHIFTER, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME, SHIFTER, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(-, ADDR_MODE_2_RM)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## U, SHIFTER, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(+, ADDR_MODE_2_RM)), LS, BODY) \
-
-#define DEFINE_LOAD_STORE_T_INSTRUCTION_ARM(NAME, LS, BODY) \
-	DEFINE_LOAD_STORE_T_INSTRUCTION_SHIFTER_ARM(NAME ## _LSL_, ADDR_MODE_2_LSL, LS, BODY) \
-	DEFINE_LOAD_STORE_T_INSTRUCTION_SHIFTER_ARM(NAME ## _LSR_, ADDR_MODE_2_LSR, LS, BODY) \
-	DEFINE_LOAD_STORE_T_INSTRUCTION_SHIFTER_ARM(NAME ## _ASR_, ADDR_MODE_2_ASR, LS, BODY) \
-	DEFINE_LOAD_STORE_T_INSTRUCTION_SHIFTER_ARM(NAME ## _ROR_, ADDR_MODE_2_ROR, LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## I, ADDR_MODE_2_RN, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(-, ADDR_MODE_2_IMMEDIATE)), LS, BODY) \
-	DEFINE_LOAD_STORE_INSTRUCTION_EX_ARM(NAME ## IU, ADDR_MODE_2_RN, ADDR_MODE_2_WRITEBACK(ADDR_MODE_2_INDEX(+, ADDR_MODE_2_IMMEDIATE)), LS, BODY) \
-
-#define ARM_MS_PRE_store \
-	enum PrivilegeMode privilegeMode = cpu->privilegeMode; \
-	ARMSetPrivilegeMode(cpu, MODE_SYSTEM);
-
-#define ARM_MS_PRE_load \
-	enum PrivilegeMode privilegeMode; \
-	if (!(rs & 0x8000)) { \
-		privilegeMode = cpu->privilegeMode; \
-		ARMSetPrivilegeMode(cpu, MODE_SYSTEM); \
-	}
-
-#define ARM_MS_POST_store ARMSetPrivilegeMode(cpu, privilegeMode);
-
-#define ARM_MS_POST_load \
-	if (!(rs & 0x8000)) { \
-		ARMSetPrivilegeMode(cpu, privilegeMode); \
-	} else if (_ARMModeHasSPSR(cpu->cpsr.priv)) { \
-		cpu->cpsr = cpu->spsr; \
-		_ARMReadCPSR(cpu); \
-	}
-
-#define DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME, LS, WRITEBACK, S_PRE, S_POST, DIRECTION, POST_BODY) \
-	DEFINE_INSTRUCTION_ARM(NAME, \
-		int rn = (opcode >> 16) & 0xF; \
-		int rs = opcode & 0x0000FFFF; \
-		uint32_t address = cpu->gprs[rn]; \
-		S_PRE; \
-		address = cpu->memory. LS ## Multiple(cpu, address, rs, LSM_ ## DIRECTION, &currentCycles); \
-		WRITEBACK; \
-		S_POST; \
-		POST_BODY;)
-
-
-#define DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_ARM(NAME, LS, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## DA,   LS,                               ,                  ,                   , DA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## DAW,  LS, ADDR_MODE_4_WRITEBACK_ ## NAME,                  ,                   , DA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## DB,   LS,                               ,                  ,                   , DB, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## DBW,  LS, ADDR_MODE_4_WRITEBACK_ ## NAME,                  ,                   , DB, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## IA,   LS,                               ,                  ,                   , IA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## IAW,  LS, ADDR_MODE_4_WRITEBACK_ ## NAME,                  ,                   , IA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## IB,   LS,                               ,                  ,                   , IB, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## IBW,  LS, ADDR_MODE_4_WRITEBACK_ ## NAME,                  ,                   , IB, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SDA,  LS,                               , ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, DA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SDAW, LS, ADDR_MODE_4_WRITEBACK_ ## NAME, ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, DA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SDB,  LS,                               , ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, DB, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SDBW, LS, ADDR_MODE_4_WRITEBACK_ ## NAME, ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, DB, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SIA,  LS,                               , ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, IA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SIAW, LS, ADDR_MODE_4_WRITEBACK_ ## NAME, ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, IA, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SIB,  LS,                               , ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, IB, POST_BODY) \
-	DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_EX_ARM(NAME ## SIBW, LS, ADDR_MODE_4_WRITEBACK_ ## NAME, ARM_MS_PRE_ ## LS, ARM_MS_POST_ ## LS, IB, POST_BODY)
-
-// Begin ALU definitions
-
-DEFINE_ALU_INSTRUCTION_ARM(ADD, ARM_ADDITION_S(n, cpu->shifterOperand, cpu->gprs[rd]),
-	int32_t n = cpu->gprs[rn];
-	cpu->gprs[rd] = n + cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_ARM(ADC, ARM_ADDITION_S(n, cpu->shifterOperand, cpu->gprs[rd]),
-	int32_t n = cpu->gprs[rn];
-	cpu->gprs[rd] = n + cpu->shifterOperand + cpu->cpsr.c;)
-
-DEFINE_ALU_INSTRUCTION_ARM(AND, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, cpu->gprs[rd]),
-	cpu->gprs[rd] = cpu->gprs[rn] & cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_ARM(BIC, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, cpu->gprs[rd]),
-	cpu->gprs[rd] = cpu->gprs[rn] & ~cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_S_ONLY_ARM(CMN, ARM_ADDITION_S(cpu->gprs[rn], cpu->shifterOperand, aluOut),
-	int32_t aluOut = cpu->gprs[rn] + cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_S_ONLY_ARM(CMP, ARM_SUBTRACTION_S(cpu->gprs[rn], cpu->shifterOperand, aluOut),
-	int32_t aluOut = cpu->gprs[rn] - cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_ARM(EOR, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, cpu->gprs[rd]),
-	cpu->gprs[rd] = cpu->gprs[rn] ^ cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_ARM(MOV, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, cpu->gprs[rd]),
-	cpu->gprs[rd] = cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_ARM(MVN, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, cpu->gprs[rd]),
-	cpu->gprs[rd] = ~cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_ARM(ORR, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, cpu->gprs[rd]),
-	cpu->gprs[rd] = cpu->gprs[rn] | cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_ARM(RSB, ARM_SUBTRACTION_S(cpu->shifterOperand, n, cpu->gprs[rd]),
-	int32_t n = cpu->gprs[rn];
-	cpu->gprs[rd] = cpu->shifterOperand - n;)
-
-DEFINE_ALU_INSTRUCTION_ARM(RSC, ARM_SUBTRACTION_CARRY_S(cpu->shifterOperand, n, cpu->gprs[rd], !cpu->cpsr.c),
-	int32_t n = cpu->gprs[rn];
-	cpu->gprs[rd] = cpu->shifterOperand - n - !cpu->cpsr.c;)
-
-DEFINE_ALU_INSTRUCTION_ARM(SBC, ARM_SUBTRACTION_CARRY_S(n, cpu->shifterOperand, cpu->gprs[rd], !cpu->cpsr.c),
-	int32_t n = cpu->gprs[rn];
-	cpu->gprs[rd] = n - cpu->shifterOperand - !cpu->cpsr.c;)
-
-DEFINE_ALU_INSTRUCTION_ARM(SUB, ARM_SUBTRACTION_S(n, cpu->shifterOperand, cpu->gprs[rd]),
-	int32_t n = cpu->gprs[rn];
-	cpu->gprs[rd] = n - cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_S_ONLY_ARM(TEQ, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, aluOut),
-	int32_t aluOut = cpu->gprs[rn] ^ cpu->shifterOperand;)
-
-DEFINE_ALU_INSTRUCTION_S_ONLY_ARM(TST, ARM_NEUTRAL_S(cpu->gprs[rn], cpu->shifterOperand, aluOut),
-	int32_t aluOut = cpu->gprs[rn] & cpu->shifterOperand;)
-
-// End ALU definitions
-
-// Begin multiply definitions
-
-DEFINE_MULTIPLY_INSTRUCTION_2_ARM(MLA, cpu->gprs[rdHi] = cpu->gprs[rm] * cpu->gprs[rs] + cpu->gprs[rd], ARM_NEUTRAL_S(, , cpu->gprs[rdHi]), 2)
-DEFINE_MULTIPLY_INSTRUCTION_ARM(MUL, cpu->gprs[rd] = cpu->gprs[rm] * cpu->gprs[rs], ARM_NEUTRAL_S(cpu->gprs[rm], cpu->gprs[rs], cpu->gprs[rd]))
-
-DEFINE_MULTIPLY_INSTRUCTION_2_ARM(SMLAL,
-	int64_t d = ((int64_t) cpu->gprs[rm]) * ((int64_t) cpu->gprs[rs]);
-	int32_t dm = cpu->gprs[rd];
-	int32_t dn = d;
-	cpu->gprs[rd] = dm + dn;
-	cpu->gprs[rdHi] = cpu->gprs[rdHi] + (d >> 32) + ARM_CARRY_FROM(dm, dn, cpu->gprs[rd]);,
-	ARM_NEUTRAL_HI_S(cpu->gprs[rd], cpu->gprs[rdHi]), 3)
-
-DEFINE_MULTIPLY_INSTRUCTION_2_ARM(SMULL,
-	int64_t d = ((int64_t) cpu->gprs[rm]) * ((int64_t) cpu->gprs[rs]);
-	cpu->gprs[rd] = d;
-	cpu->gprs[rdHi] = d >> 32;,
-	ARM_NEUTRAL_HI_S(cpu->gprs[rd], cpu->gprs[rdHi]), 2)
-
-DEFINE_MULTIPLY_INSTRUCTION_2_ARM(UMLAL,
-	uint64_t d = ARM_UXT_64(cpu->gprs[rm]) * ARM_UXT_64(cpu->gprs[rs]);
-	int32_t dm = cpu->gprs[rd];
-	int32_t dn = d;
-	cpu->gprs[rd] = dm + dn;
-	cpu->gprs[rdHi] = cpu->gprs[rdHi] + (d >> 32) + ARM_CARRY_FROM(dm, dn, cpu->gprs[rd]);,
-	ARM_NEUTRAL_HI_S(cpu->gprs[rd], cpu->gprs[rdHi]), 3)
-
-DEFINE_MULTIPLY_INSTRUCTION_2_ARM(UMULL,
-	uint64_t d = ARM_UXT_64(cpu->gprs[rm]) * ARM_UXT_64(cpu->gprs[rs]);
-	cpu->gprs[rd] = d;
-	cpu->gprs[rdHi] = d >> 32;,
-	ARM_NEUTRAL_HI_S(cpu->gprs[rd], cpu->gprs[rdHi]), 2)
-
-// End multiply definitions
-
-// Begin load/store definitions
-
-DEFINE_LOAD_STORE_INSTRUCTION_ARM(LDR, LOAD, cpu->gprs[rd] = cpu->memory.load32(cpu, address, &currentCycles); ARM_LOAD_POST_BODY;)
-DEFINE_LOAD_STORE_INSTRUCTION_ARM(LDRB, LOAD, cpu->gprs[rd] = cpu->memory.load8(cpu, address, &currentCycles); ARM_LOAD_POST_BODY;)
-DEFINE_LOAD_STORE_MODE_3_INSTRUCTION_ARM(LDRH, LOAD, cpu->gprs[rd] = cpu->memory.load16(cpu, address, &currentCycles); ARM_LOAD_POST_BODY;)
-DEFINE_LOAD_STORE_MODE_3_INSTRUCTION_ARM(LDRSB, LOAD, cpu->gprs[rd] = ARM_SXT_8(cpu->memory.load8(cpu, address, &currentCycles)); ARM_LOAD_POST_BODY;)
-DEFINE_LOAD_STORE_MODE_3_INSTRUCTION_ARM(LDRSH, LOAD, cpu->gprs[rd] = address & 1 ? ARM_SXT_8(cpu->memory.load16(cpu, address, &currentCycles)) : ARM_SXT_16(cpu->memory.load16(cpu, address, &currentCycles)); ARM_LOAD_POST_BODY;)
-DEFINE_LOAD_STORE_INSTRUCTION_ARM(STR, STORE, cpu->memory.store32(cpu, address, cpu->gprs[rd], &currentCycles); ARM_STORE_POST_BODY;)
-DEFINE_LOAD_STORE_INSTRUCTION_ARM(STRB, STORE, cpu->memory.store8(cpu, address, cpu->gprs[rd], &currentCycles); ARM_STORE_POST_BODY;)
-DEFINE_LOAD_STORE_MODE_3_INSTRUCTION_ARM(STRH, STORE, cpu->memory.store16(cpu, address, cpu->gprs[rd], &currentCycles); ARM_STORE_POST_BODY;)
-
-DEFINE_LOAD_STORE_T_INSTRUCTION_ARM(LDRBT, LOAD,
-	enum PrivilegeMode priv = cpu->privilegeMode;
-	ARMSetPrivilegeMode(cpu, MODE_USER);
-	int32_t r = cpu->memory.load8(cpu, address, &currentCycles);
-	ARMSetPrivilegeMode(cpu, priv);
-	cpu->gprs[rd] = r;
-	ARM_LOAD_POST_BODY;)
-
-DEFINE_LOAD_STORE_T_INSTRUCTION_ARM(LDRT, LOAD,
-	enum PrivilegeMode priv = cpu->privilegeMode;
-	ARMSetPrivilegeMode(cpu, MODE_USER);
-	int32_t r = cpu->memory.load32(cpu, address, &currentCycles);
-	ARMSetPrivilegeMode(cpu, priv);
-	cpu->gprs[rd] = r;
-	ARM_LOAD_POST_BODY;)
-
-DEFINE_LOAD_STORE_T_INSTRUCTION_ARM(STRBT, STORE,
-	enum PrivilegeMode priv = cpu->privilegeMode;
-	int32_t r = cpu->gprs[rd];
-	ARMSetPrivilegeMode(cpu, MODE_USER);
-	cpu->memory.store8(cpu, address, r, &currentCycles);
-	ARMSetPrivilegeMode(cpu, priv);
-	ARM_STORE_POST_BODY;)
-
-DEFINE_LOAD_STORE_T_INSTRUCTION_ARM(STRT, STORE,
-	enum PrivilegeMode priv = cpu->privilegeMode;
-	int32_t r = cpu->gprs[rd];
-	ARMSetPrivilegeMode(cpu, MODE_USER);
-	cpu->memory.store32(cpu, address, r, &currentCycles);
-	ARMSetPrivilegeMode(cpu, priv);
-	ARM_STORE_POST_BODY;)
-
-DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_ARM(LDM,
-	load,
-	currentCycles += cpu->memory.activeNonseqCycles32 - cpu->memory.activeSeqCycles32;
-	if ((rs & 0x8000) || !rs) {
-		if (cpu->executionMode == MODE_THUMB) {
-			currentCycles += ThumbWritePC(cpu);
-		} else {
-			currentCycles += ARMWritePC(cpu);
-		}
-	})
-
-DEFINE_LOAD_STORE_MULTIPLE_INSTRUCTION_ARM(STM,
-	store,
-	ARM_STORE_POST_BODY;)
-
-DEFINE_INSTRUCTION_ARM(SWP,
-	int rm = opcode & 0xF;
-	int rd = (opcode >> 12) & 0xF;
-	int rn = (opcode >> 16) & 0xF;
-	int32_t d = cpu->memory.load32(cpu, cpu->gprs[rn], &currentCycles);
-	cpu->memory.store32(cpu, cpu->gprs[rn], cpu->gprs[rm], &currentCycles);
-	cpu->gprs[rd] = d;)
-
-DEFINE_INSTRUCTION_ARM(SWPB,
-	int rm = opcode & 0xF;
-	int rd = (opcode >> 12) & 0xF;
-	int rn = (opcode >> 16) & 0xF;
-	int32_t d = cpu->memory.load8(cpu, cpu->gprs[rn], &currentCycles);
-	cpu->memory.store8(cpu, cpu->gprs[rn], cpu->gprs[rm], &currentCycles);
-	cpu->gprs[rd] = d;)
-
-// End load/store definitions
-
-// Begin branch definitions
-
-DEFINE_INSTRUCTION_ARM(B,
-	int32_t offset = opcode << 8;
-	offset >>= 6;
-	cpu->gprs[ARM_PC] += offset;
-	currentCycles += ARMWritePC(cpu);)
-
-DEFINE_INSTRUCTION_ARM(BL,
-	int32_t immediate = (opcode & 0x00FFFFFF) << 8;
-	cpu->gprs[ARM_LR] = cpu->gprs[ARM_PC] - WORD_SIZE_ARM;
-	cpu->gprs[ARM_PC] += immediate >> 6;
-	currentCycles += ARMWritePC(cpu);)
-
-DEFINE_INSTRUCTION_ARM(BX,
-	int rm = opcode & 0x0000000F;
-	_ARMSetMode(cpu, cpu->gprs[rm] & 0x00000001);
-	cpu->gprs[ARM_PC] = cpu->gprs[rm] & 0xFFFFFFFE;
-	if (cpu->executionMode == MODE_THUMB) {
-		currentCycles += ThumbWritePC(cpu);
-	} else {
-		currentCycles += ARMWritePC(cpu);
-	})
-
-// End branch definitions
-
-// Begin coprocessor definitions
-
-DEFINE_INSTRUCTION_ARM(CDP, ARM_STUB)
-DEFINE_INSTRUCTION_ARM(LDC, ARM_STUB)
-DEFINE_INSTRUCTION_ARM(STC, ARM_STUB)
-DEFINE_INSTRUCTION_ARM(MCR, ARM_STUB)
-DEFINE_INSTRUCTION_ARM(MRC, ARM_STUB)
-
-// Begin miscellaneous definitions
-
-DEFINE_INSTRUCTION_ARM(BKPT, cpu->irqh.bkpt32(cpu, ((opcode >> 4) & 0xFFF0) | (opcode & 0xF))); // Not strictly in ARMv4T, but here for convenience
-DEFINE_INSTRUCTION_ARM(ILL, ARM_ILL) // Illegal opcode
-
-DEFINE_INSTRUCTION_ARM(MSR,
-	int c = opcode & 0x00010000;
-	int f = opcode & 0x00080000;
-	int32_t operand = cpu->gprs[opcode & 0x0000000F];
-	int32_t mask = (c ? 0x000000FF : 0) | (f ? 0xFF000000 : 0);
-	if (mask & PSR_USER_MASK) {
-		cpu->cpsr.packed = (cpu->cpsr.packed & ~PSR_USER_MASK) | (operand & PSR_USER_MASK);
-	}
-	if (mask & PSR_STATE_MASK) {
-		cpu->cpsr.packed = (cpu->cpsr.packed & ~PSR_STATE_MASK) | (operand & PSR_STATE_MASK);
-	}
-	if (cpu->privilegeMode != MODE_USER && (mask & PSR_PRIV_MASK)) {
-		ARMSetPrivilegeMode(cpu, (enum PrivilegeMode) ((operand & 0x0000000F) | 0x00000010));
-		cpu->cpsr.packed = (cpu->cpsr.packed & ~PSR_PRIV_MASK) | (operand & PSR_PRIV_MASK);
-	}
-	_ARMReadCPSR(cpu);
-	if (cpu->executionMode == MODE_THUMB) {
-		cpu->prefetch[0] = 0x46C0; // nop
-		cpu->prefetch[1] &= 0xFFFF;
-		cpu->gprs[ARM_PC] += WORD_SIZE_THUMB;
-	} else {
-		LOAD_32(cpu->prefetch[0], (cpu->gprs[ARM_PC] - WORD_SIZE_ARM) & cpu->memory.activeMask, cpu->memory.activeRegion);
-		LOAD_32(cpu->prefetch[1], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion);
-	})
-
-DEFINE_INSTRUCTION_ARM(MSRR,
-	int c = opcode & 0x00010000;
-	int f = opcode & 0x00080000;
-	int32_t operand = cpu->gprs[opcode & 0x0000000F];
-	int32_t mask = (c ? 0x000000FF : 0) | (f ? 0xFF000000 : 0);
-	mask &= PSR_USER_MASK | PSR_PRIV_MASK | PSR_STATE_MASK;
-	cpu->spsr.packed = (cpu->spsr.packed & ~mask) | (operand & mask) | 0x00000010;)
-
-DEFINE_INSTRUCTION_ARM(MRS, \
-	int rd = (opcode >> 12) & 0xF; \
-	cpu->gprs[rd] = cpu->cpsr.packed;)
-
-DEFINE_INSTRUCTION_ARM(MRSR, \
-	int rd = (opcode >> 12) & 0xF; \
-	cpu->gprs[rd] = cpu->spsr.packed;)
-
-DEFINE_INSTRUCTION_ARM(MSRI,
-	int c = opcode & 0x00010000;
-	int f = opcode & 0x00080000;
-	int rotate = (opcode & 0x00000F00) >> 7;
-	int32_t operand = ROR(opcode & 0x000000FF, rotate);
-	int32_t mask = (c ? 0x000000FF : 0) | (f ? 0xFF000000 : 0);
-	if (mask & PSR_USER_MASK) {
-		cpu->cpsr.packed = (cpu->cpsr.packed & ~PSR_USER_MASK) | (operand & PSR_USER_MASK);
-	}
-	if (mask & PSR_STATE_MASK) {
-		cpu->cpsr.packed = (cpu->cpsr.packed & ~PSR_STATE_MASK) | (operand & PSR_STATE_MASK);
-	}
-	if (cpu->privilegeMode != MODE_USER && (mask & PSR_PRIV_MASK)) {
-		ARMSetPrivilegeMode(cpu, (enum PrivilegeMode) ((operand & 0x0000000F) | 0x00000010));
-		cpu->cpsr.packed = (cpu->cpsr.packed & ~PSR_PRIV_MASK) | (operand & PSR_PRIV_MASK);
-	}
-	_ARMReadCPSR(cpu);
-	if (cpu->executionMode == MODE_THUMB) {
-		cpu->prefetch[0] = 0x46C0; // nop
-		cpu->prefetch[1] &= 0xFFFF;
-		cpu->gprs[ARM_PC] += WORD_SIZE_THUMB;
-	} else {
-		LOAD_32(cpu->prefetch[0], (cpu->gprs[ARM_PC] - WORD_SIZE_ARM) & cpu->memory.activeMask, cpu->memory.activeRegion);
-		LOAD_32(cpu->prefetch[1], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion);
-	})
-
-DEFINE_INSTRUCTION_ARM(MSRRI,
-	int c = opcode & 0x00010000;
-	int f = opcode & 0x00080000;
-	int rotate = (opcode & 0x00000F00) >> 7;
-	int32_t operand = ROR(opcode & 0x000000FF, rotate);
-	int32_t mask = (c ? 0x000000FF : 0) | (f ? 0xFF000000 : 0);
-	mask &= PSR_USER_MASK | PSR_PRIV_MASK | PSR_STATE_MASK;
-	cpu->spsr.packed = (cpu->spsr.packed & ~mask) | (operand & mask) | 0x00000010;)
-
-DEFINE_INSTRUCTION_ARM(SWI, cpu->irqh.swi32(cpu, opcode & 0xFFFFFF))
+#include "isa-arm-instructions.h"
 
 const ARMInstruction _armTable[0x1000] = {
 	DECLARE_ARM_EMITTER_BLOCK(_ARMInstruction)
 };
+
+#ifdef ENABLE_THREADED_DISPATCH
+#define ARM_DISPATCH \
+	if (cpu->cycles >= cpu->nextEvent) { \
+		return; \
+	} \
+	opcode = cpu->prefetch[0]; \
+	cpu->prefetch[0] = cpu->prefetch[1]; \
+	cpu->gprs[ARM_PC] += WORD_SIZE_ARM; \
+	LOAD_32(cpu->prefetch[1], cpu->gprs[ARM_PC] & cpu->memory.activeMask, cpu->memory.activeRegion); \
+	condition = opcode >> 28; \
+	if (condition != 0xE && !ARMTestCondition(cpu, condition)) { \
+		cpu->cycles += ARM_PREFETCH_CYCLES; \
+		goto dispatch; \
+	} \
+	goto *labels[((opcode >> 16) & 0xFF0) | ((opcode >> 4) & 0x00F)];
+
+void ARMRunThreaded(struct ARMCore* cpu) {
+	static const void* const labels[0x1000] = {
+		DECLARE_ARM_EMITTER_BLOCK(&&_ARMLabel)
+	};
+	uint32_t opcode;
+	unsigned condition;
+dispatch:
+	ARM_DISPATCH
+
+	// See ThumbRunThreaded
+#undef DEFINE_INSTRUCTION_ARM
+#define DEFINE_INSTRUCTION_ARM(NAME, BODY) \
+	_ARMLabel ## NAME: \
+	_ARMInstruction ## NAME(cpu, opcode); \
+	ARM_DISPATCH
+
+#include "isa-arm-instructions.h"
+}
+#endif
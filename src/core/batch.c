@@ -0,0 +1,246 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/batch.h>
+
+#include <mgba/core/core.h>
+#include <mgba-util/memory.h>
+#include <mgba-util/vfs.h>
+
+#ifdef M_CORE_GBA
+#include <mgba/internal/gba/gba.h>
+#endif
+
+#include <limits.h>
+
+mLOG_DECLARE_CATEGORY(BATCH);
+mLOG_DEFINE_CATEGORY(BATCH, "Batch", "core.batch");
+
+static bool _needsPrivateRom(struct mCore* core) {
+#ifdef M_CORE_GBA
+	if (core->platform(core) == PLATFORM_GBA) {
+		// Cartridge GPIO registers are mirrored into the ROM itself
+		struct GBA* gba = core->board;
+		return gba->memory.hw.devices != HW_NONE;
+	}
+#else
+	UNUSED(core);
+#endif
+	return false;
+}
+
+static void _makeRomPrivate(struct mCoreBatch* batch, struct mCoreBatchInstance* instance) {
+	instance->privateRom = anonymousMemoryMap(batch->romSize);
+	memcpy(instance->privateRom, batch->rom, batch->romSize);
+	instance->core->unloadROM(instance->core);
+	instance->core->loadROM(instance->core, VFileFromMemory(instance->privateRom, batch->romSize));
+	instance->core->reset(instance->core);
+}
+
+static void _runInstances(struct mCoreBatch* batch) {
+	MutexLock(&batch->mutex);
+	while (batch->nextInstance < batch->nInstances) {
+		struct mCore* core = batch->instances[batch->nextInstance].core;
+		++batch->nextInstance;
+		MutexUnlock(&batch->mutex);
+		core->runFrame(core);
+		MutexLock(&batch->mutex);
+		--batch->remaining;
+		if (!batch->remaining) {
+			ConditionWake(&batch->doneCond);
+		}
+	}
+	MutexUnlock(&batch->mutex);
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _batchWorker(void* context) {
+	struct mCoreBatch* batch = context;
+	ThreadSetName("Batch Worker");
+	MutexLock(&batch->mutex);
+	unsigned generation = batch->generation;
+	while (true) {
+		while (batch->generation == generation && !batch->shutdown) {
+			ConditionWait(&batch->workCond, &batch->mutex);
+		}
+		if (batch->shutdown) {
+			break;
+		}
+		generation = batch->generation;
+		MutexUnlock(&batch->mutex);
+		_runInstances(batch);
+		MutexLock(&batch->mutex);
+	}
+	MutexUnlock(&batch->mutex);
+	return 0;
+}
+#endif
+
+bool mCoreBatchInit(struct mCoreBatch* batch, struct VFile* rom, size_t instances, size_t threads) {
+	memset(batch, 0, sizeof(*batch));
+	if (!rom || !instances) {
+		return false;
+	}
+	batch->romSize = rom->size(rom);
+	batch->rom = rom->map(rom, batch->romSize, MAP_READ);
+	if (!batch->rom) {
+		mLOG(BATCH, ERROR, "Could not map ROM");
+		rom->close(rom);
+		return false;
+	}
+	batch->romVf = rom;
+	MutexInit(&batch->mutex);
+	ConditionInit(&batch->workCond);
+	ConditionInit(&batch->doneCond);
+
+	batch->instances = calloc(instances, sizeof(*batch->instances));
+	size_t i;
+	for (i = 0; i < instances; ++i) {
+		struct mCoreBatchInstance* instance = &batch->instances[i];
+		struct VFile* vf = VFileFromConstMemory(batch->rom, batch->romSize);
+		instance->core = mCoreFindVF(vf);
+		if (!instance->core || !instance->core->init(instance->core)) {
+			mLOG(BATCH, ERROR, "Could not create a core for instance %" PRIz "u", i);
+			if (instance->core) {
+				instance->core->deinit(instance->core);
+				instance->core = NULL;
+			}
+			vf->close(vf);
+			mCoreBatchDeinit(batch);
+			return false;
+		}
+		mCoreInitConfig(instance->core, NULL);
+		instance->render = true;
+		++batch->nInstances;
+		if (!instance->core->loadROM(instance->core, vf)) {
+			mLOG(BATCH, ERROR, "Could not load ROM into instance %" PRIz "u", i);
+			vf->close(vf);
+			mCoreBatchDeinit(batch);
+			return false;
+		}
+	}
+
+#ifndef DISABLE_THREADING
+	if (threads > instances - 1) {
+		threads = instances - 1;
+	}
+	if (threads) {
+		batch->threads = calloc(threads, sizeof(*batch->threads));
+	}
+	for (i = 0; i < threads; ++i) {
+		if (ThreadCreate(&batch->threads[i], _batchWorker, batch)) {
+			mLOG(BATCH, WARN, "Could only start %" PRIz "u of %" PRIz "u worker threads", i, threads);
+			break;
+		}
+		++batch->nThreads;
+	}
+#else
+	UNUSED(threads);
+#endif
+	mCoreBatchReset(batch);
+	return true;
+}
+
+void mCoreBatchDeinit(struct mCoreBatch* batch) {
+	if (!batch->romVf) {
+		return;
+	}
+	size_t i;
+#ifndef DISABLE_THREADING
+	MutexLock(&batch->mutex);
+	batch->shutdown = true;
+	ConditionWake(&batch->workCond);
+	MutexUnlock(&batch->mutex);
+	for (i = 0; i < batch->nThreads; ++i) {
+		ThreadJoin(&batch->threads[i]);
+	}
+	free(batch->threads);
+	batch->threads = NULL;
+	batch->nThreads = 0;
+#endif
+	for (i = 0; i < batch->nInstances; ++i) {
+		struct mCoreBatchInstance* instance = &batch->instances[i];
+		mCoreConfigDeinit(&instance->core->config);
+		instance->core->deinit(instance->core);
+		if (instance->privateRom) {
+			mappedMemoryFree(instance->privateRom, batch->romSize);
+		}
+	}
+	free(batch->instances);
+	batch->instances = NULL;
+	batch->nInstances = 0;
+
+	MutexDeinit(&batch->mutex);
+	ConditionDeinit(&batch->workCond);
+	ConditionDeinit(&batch->doneCond);
+	batch->romVf->unmap(batch->romVf, batch->rom, batch->romSize);
+	batch->romVf->close(batch->romVf);
+	batch->romVf = NULL;
+	batch->rom = NULL;
+}
+
+struct mCore* mCoreBatchGetCore(struct mCoreBatch* batch, size_t instance) {
+	if (instance >= batch->nInstances) {
+		return NULL;
+	}
+	return batch->instances[instance].core;
+}
+
+void mCoreBatchSetVideoBuffers(struct mCoreBatch* batch, color_t* buffer, size_t stride) {
+	size_t i;
+	for (i = 0; i < batch->nInstances; ++i) {
+		struct mCore* core = batch->instances[i].core;
+		unsigned width, height;
+		core->desiredVideoDimensions(core, &width, &height);
+		core->setVideoBuffer(core, &buffer[i * stride * height], stride);
+	}
+}
+
+void mCoreBatchReset(struct mCoreBatch* batch) {
+	size_t i;
+	for (i = 0; i < batch->nInstances; ++i) {
+		struct mCoreBatchInstance* instance = &batch->instances[i];
+		instance->core->reset(instance->core);
+		if (!instance->privateRom && _needsPrivateRom(instance->core)) {
+			_makeRomPrivate(batch, instance);
+		}
+		mCoreBatchSetRendering(batch, i, instance->render);
+	}
+}
+
+void mCoreBatchSetRendering(struct mCoreBatch* batch, size_t instance, bool enable) {
+	if (instance >= batch->nInstances) {
+		return;
+	}
+	struct mCore* core = batch->instances[instance].core;
+	batch->instances[instance].render = enable;
+	mCoreConfigSetOverrideIntValue(&core->config, "frameskip", enable ? 0 : INT_MAX);
+	core->reloadConfigOption(core, "frameskip", NULL);
+}
+
+void mCoreBatchRunFrame(struct mCoreBatch* batch, const uint32_t* keys) {
+	size_t i;
+	if (keys) {
+		for (i = 0; i < batch->nInstances; ++i) {
+			batch->instances[i].core->setKeys(batch->instances[i].core, keys[i]);
+		}
+	}
+	MutexLock(&batch->mutex);
+	batch->nextInstance = 0;
+	batch->remaining = batch->nInstances;
+	if (batch->nThreads) {
+		++batch->generation;
+		ConditionWake(&batch->workCond);
+	}
+	MutexUnlock(&batch->mutex);
+
+	_runInstances(batch);
+
+	MutexLock(&batch->mutex);
+	while (batch->remaining) {
+		ConditionWait(&batch->doneCond, &batch->mutex);
+	}
+	MutexUnlock(&batch->mutex);
+}
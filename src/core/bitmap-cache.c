@@ -121,22 +121,24 @@ uint32_t _lookupEntry15(void* vram, uint32_t offset) {
 	return mColorFrom555(((uint16_t*) vram)[offset]);
 }
 
-void mBitmapCacheCleanRow(struct mBitmapCache* cache, struct mBitmapCacheEntry* entry, unsigned y) {
+bool mBitmapCacheCleanRow(struct mBitmapCache* cache, struct mBitmapCacheEntry* entry, unsigned y) {
 	color_t* row = &cache->cache[(cache->buffer * mBitmapCacheSystemInfoGetHeight(cache->sysConfig) + y) * mBitmapCacheSystemInfoGetWidth(cache->sysConfig)];
 	size_t location = cache->buffer + mBitmapCacheSystemInfoGetBuffers(cache->sysConfig) * y;
 	struct mBitmapCacheEntry* status = &cache->status[location];
 	struct mBitmapCacheEntry desiredStatus = {
 		.paletteVersion = cache->globalPaletteVersion,
-		.vramVersion = entry->vramVersion,
+		.vramVersion = status->vramVersion,
 		.vramClean = 1
 	};
 
+	bool changed = true;
 	if (entry) {
+		changed = memcmp(&entry[location], &desiredStatus, sizeof(*entry)) != 0;
 		entry[location] = desiredStatus;
 	}
 
-	if (!mBitmapCacheConfigurationIsShouldStore(cache->config) || !memcmp(status, &desiredStatus, sizeof(*entry))) {
-		return;
+	if (!mBitmapCacheConfigurationIsShouldStore(cache->config) || !memcmp(status, &desiredStatus, sizeof(*status))) {
+		return changed;
 	}
 
 	size_t offset = cache->bitsStart[cache->buffer] + y * mBitmapCacheSystemInfoGetWidth(cache->sysConfig);
@@ -168,13 +170,14 @@ void mBitmapCacheCleanRow(struct mBitmapCache* cache, struct mBitmapCacheEntry*
 		}
 	}
 	*status = desiredStatus;
+	return changed;
 }
 
 bool mBitmapCacheCheckRow(struct mBitmapCache* cache, const struct mBitmapCacheEntry* entry, unsigned y) {
 	size_t location = cache->buffer + mBitmapCacheSystemInfoGetBuffers(cache->sysConfig) * y;
 	struct mBitmapCacheEntry desiredStatus = {
 		.paletteVersion = cache->globalPaletteVersion,
-		.vramVersion = entry->vramVersion,
+		.vramVersion = cache->status[location].vramVersion,
 		.vramClean = 1
 	};
 
@@ -17,6 +17,7 @@ const uint32_t M_CHEAT_DEVICE_ID = 0xABADC0DE;
 mLOG_DEFINE_CATEGORY(CHEATS, "Cheats", "core.cheats");
 
 DEFINE_VECTOR(mCheatList, struct mCheat);
+DEFINE_VECTOR(mCheatOpList, struct mCheatOp);
 DEFINE_VECTOR(mCheatSets, struct mCheatSet*);
 
 static int32_t _readMem(struct mCore* core, uint32_t address, int width) {
@@ -45,6 +46,123 @@ static void _writeMem(struct mCore* core, uint32_t address, int width, int32_t v
 	}
 }
 
+static int32_t _readOp(struct mCheatDevice* device, const struct mCheatOp* op, uint32_t address) {
+	if (op->region >= 0) {
+		const struct mCheatRegion* region = &device->regions[op->region];
+		if (region->data) {
+			uint32_t offset = (address - region->start) & region->mask;
+			uint16_t value16;
+			int32_t value32;
+			switch (op->cheat.width) {
+			case 1:
+				return region->data[offset];
+			case 2:
+				LOAD_16LE(value16, offset, region->data);
+				return value16;
+			case 4:
+				LOAD_32LE(value32, offset, region->data);
+				return value32;
+			}
+		}
+	}
+	return _readMem(device->p, address, op->cheat.width);
+}
+
+static void _writeOp(struct mCheatDevice* device, const struct mCheatOp* op, uint32_t address, int32_t value) {
+	if (op->region >= 0) {
+		const struct mCheatRegion* region = &device->regions[op->region];
+		if (region->data) {
+			uint32_t offset = (address - region->start) & region->mask;
+			switch (op->cheat.width) {
+			case 1:
+				region->data[offset] = value;
+				break;
+			case 2:
+				STORE_16LE(value, offset, region->data);
+				break;
+			case 4:
+				STORE_32LE(value, offset, region->data);
+				break;
+			}
+			if (device->written) {
+				device->written(device, address, op->cheat.width);
+			}
+			return;
+		}
+	}
+	_writeMem(device->p, address, op->cheat.width, value);
+	if (device->mapRegions) {
+		// The write may have been a bank switch
+		device->mapRegions(device);
+	}
+}
+
+static int _resolveRegion(const struct mCheatDevice* device, const struct mCheat* cheat) {
+	switch (cheat->type) {
+	case CHEAT_ASSIGN_INDIRECT:
+	case CHEAT_IF_BUTTON:
+		return -1;
+	default:
+		break;
+	}
+	if (cheat->width != 1 && cheat->width != 2 && cheat->width != 4) {
+		return -1;
+	}
+	if ((cheat->address | (uint32_t) cheat->addressOffset) & (cheat->width - 1)) {
+		return -1;
+	}
+	int64_t first = cheat->address;
+	int64_t last = first;
+	switch (cheat->type) {
+	case CHEAT_ASSIGN:
+	case CHEAT_AND:
+	case CHEAT_ADD:
+	case CHEAT_OR:
+		if (cheat->repeat > 1) {
+			last += (int64_t) cheat->addressOffset * (cheat->repeat - 1);
+		}
+		break;
+	default:
+		// Conditions only ever read once
+		break;
+	}
+	if (last < first) {
+		int64_t swap = first;
+		first = last;
+		last = swap;
+	}
+	size_t i;
+	for (i = 0; i < device->nRegions; ++i) {
+		const struct mCheatRegion* region = &device->regions[i];
+		if (first >= region->start && last + cheat->width <= (int64_t) region->start + region->size) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void _compile(struct mCheatDevice* device, struct mCheatSet* cheats) {
+	size_t nCodes = mCheatListSize(&cheats->list);
+	size_t nOps = mCheatOpListSize(&cheats->ops);
+	if (nOps != nCodes) {
+		mCheatOpListResize(&cheats->ops, (ssize_t) nCodes - (ssize_t) nOps);
+		if (nOps > nCodes) {
+			nOps = nCodes;
+		}
+	}
+	size_t i;
+	for (i = 0; i < nCodes; ++i) {
+		const struct mCheat* cheat = mCheatListGetConstPointer(&cheats->list, i);
+		struct mCheatOp* op = mCheatOpListGetPointer(&cheats->ops, i);
+		// Parsers fill in multi-line codes in place, so existing ops are checked too
+		if (i < nOps && memcmp(&op->cheat, cheat, sizeof(*cheat)) == 0) {
+			continue;
+		}
+		op->cheat = *cheat;
+		op->region = _resolveRegion(device, cheat);
+	}
+}
+
 static void mCheatDeviceInit(void*, struct mCPUComponent*);
 static void mCheatDeviceDeinit(struct mCPUComponent*);
 
@@ -52,14 +170,22 @@ void mCheatDeviceCreate(struct mCheatDevice* device) {
 	device->d.id = M_CHEAT_DEVICE_ID;
 	device->d.init = mCheatDeviceInit;
 	device->d.deinit = mCheatDeviceDeinit;
+	device->deinit = NULL;
+	device->mapRegions = NULL;
+	device->written = NULL;
+	device->revision = 0;
 	device->autosave = false;
 	device->buttonDown = false;
+	device->nRegions = 0;
 	mCheatSetsInit(&device->cheats, 4);
 }
 
 void mCheatDeviceDestroy(struct mCheatDevice* device) {
 	mCheatDeviceClear(device);
 	mCheatSetsDeinit(&device->cheats);
+	if (device->deinit) {
+		device->deinit(device);
+	}
 }
 
 void mCheatDeviceClear(struct mCheatDevice* device) {
@@ -69,10 +195,12 @@ void mCheatDeviceClear(struct mCheatDevice* device) {
 		mCheatSetDeinit(set);
 	}
 	mCheatSetsClear(&device->cheats);
+	++device->revision;
 }
 
 void mCheatSetInit(struct mCheatSet* set, const char* name) {
 	mCheatListInit(&set->list, 4);
+	mCheatOpListInit(&set->ops, 0);
 	StringListInit(&set->lines, 4);
 	if (name) {
 		set->name = strdup(name);
@@ -88,6 +216,7 @@ void mCheatSetDeinit(struct mCheatSet* set) {
 		free(*StringListGetPointer(&set->lines, i));
 	}
 	mCheatListDeinit(&set->list);
+	mCheatOpListDeinit(&set->ops);
 	if (set->name) {
 		free(set->name);
 	}
@@ -116,6 +245,7 @@ bool mCheatAddLine(struct mCheatSet* set, const char* line, int type) {
 
 void mCheatAddSet(struct mCheatDevice* device, struct mCheatSet* cheats) {
 	*mCheatSetsAppend(&device->cheats) = cheats;
+	++device->revision;
 	cheats->add(cheats, device);
 }
 
@@ -130,6 +260,7 @@ void mCheatRemoveSet(struct mCheatDevice* device, struct mCheatSet* cheats) {
 		return;
 	}
 	mCheatSetsShift(&device->cheats, i, 1);
+	++device->revision;
 	cheats->remove(cheats, device);
 }
 
@@ -509,10 +640,16 @@ void mCheatRefresh(struct mCheatDevice* device, struct mCheatSet* cheats) {
 
 	size_t elseLoc = 0;
 	size_t endLoc = 0;
-	size_t nCodes = mCheatListSize(&cheats->list);
+	if (device->mapRegions) {
+		device->mapRegions(device);
+	}
+	_compile(device, cheats);
+
+	size_t nCodes = mCheatOpListSize(&cheats->ops);
 	size_t i;
 	for (i = 0; i < nCodes; ++i) {
-		struct mCheat* cheat = mCheatListGetPointer(&cheats->list, i);
+		const struct mCheatOp* op = mCheatOpListGetConstPointer(&cheats->ops, i);
+		const struct mCheat* cheat = &op->cheat;
 		int32_t value = 0;
 		int32_t operand = cheat->operand;
 		uint32_t operationsRemaining = cheat->repeat;
@@ -534,67 +671,67 @@ void mCheatRefresh(struct mCheatDevice* device, struct mCheatSet* cheats) {
 				performAssignment = true;
 				break;
 			case CHEAT_AND:
-				value = _readMem(device->p, address, cheat->width) & operand;
+				value = _readOp(device, op, address) & operand;
 				performAssignment = true;
 				break;
 			case CHEAT_ADD:
-				value = _readMem(device->p, address, cheat->width) + operand;
+				value = _readOp(device, op, address) + operand;
 				performAssignment = true;
 				break;
 			case CHEAT_OR:
-				value = _readMem(device->p, address, cheat->width) | operand;
+				value = _readOp(device, op, address) | operand;
 				performAssignment = true;
 				break;
 			case CHEAT_IF_EQ:
-				condition = _readMem(device->p, address, cheat->width) == operand;
+				condition = _readOp(device, op, address) == operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_NE:
-				condition = _readMem(device->p, address, cheat->width) != operand;
+				condition = _readOp(device, op, address) != operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_LT:
-				condition = _readMem(device->p, address, cheat->width) < operand;
+				condition = _readOp(device, op, address) < operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_GT:
-				condition = _readMem(device->p, address, cheat->width) > operand;
+				condition = _readOp(device, op, address) > operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_ULT:
-				condition = (uint32_t) _readMem(device->p, address, cheat->width) < (uint32_t) operand;
+				condition = (uint32_t) _readOp(device, op, address) < (uint32_t) operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_UGT:
-				condition = (uint32_t) _readMem(device->p, address, cheat->width) > (uint32_t) operand;
+				condition = (uint32_t) _readOp(device, op, address) > (uint32_t) operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_AND:
-				condition = _readMem(device->p, address, cheat->width) & operand;
+				condition = _readOp(device, op, address) & operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_LAND:
-				condition = _readMem(device->p, address, cheat->width) && operand;
+				condition = _readOp(device, op, address) && operand;
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
 				break;
 			case CHEAT_IF_NAND:
-				condition = !(_readMem(device->p, address, cheat->width) & operand);
+				condition = !(_readOp(device, op, address) & operand);
 				conditionRemaining = cheat->repeat;
 				negativeConditionRemaining = cheat->negativeRepeat;
 				operationsRemaining = 1;
@@ -608,7 +745,7 @@ void mCheatRefresh(struct mCheatDevice* device, struct mCheatSet* cheats) {
 			}
 
 			if (performAssignment) {
-				_writeMem(device->p, address, cheat->width, value);
+				_writeOp(device, op, address, value);
 			}
 
 			address += cheat->addressOffset;
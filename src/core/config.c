@@ -331,6 +331,8 @@ void mCoreConfigMap(const struct mCoreConfig* config, struct mCoreOptions* opts)
 	_lookupIntValue(config, "frameskip", &opts->frameskip);
 	_lookupIntValue(config, "volume", &opts->volume);
 	_lookupIntValue(config, "rewindBufferCapacity", &opts->rewindBufferCapacity);
+	_lookupIntValue(config, "rewindBufferMemory", &opts->rewindBufferMemory);
+	_lookupIntValue(config, "archiveThreads", &opts->archiveThreads);
 	_lookupFloatValue(config, "fpsTarget", &opts->fpsTarget);
 	unsigned audioBuffers;
 	if (_lookupUIntValue(config, "audioBuffers", &audioBuffers)) {
@@ -372,6 +374,9 @@ void mCoreConfigMap(const struct mCoreConfig* config, struct mCoreOptions* opts)
 	if (_lookupIntValue(config, "rewindEnable", &fakeBool)) {
 		opts->rewindEnable = fakeBool;
 	}
+	if (_lookupIntValue(config, "rewindFrames", &fakeBool)) {
+		opts->rewindFrames = fakeBool;
+	}
 
 	_lookupIntValue(config, "fullscreen", &opts->fullscreen);
 	_lookupIntValue(config, "width", &opts->width);
@@ -382,6 +387,8 @@ void mCoreConfigMap(const struct mCoreConfig* config, struct mCoreOptions* opts)
 	_lookupCharValue(config, "screenshotPath", &opts->screenshotPath);
 	_lookupCharValue(config, "patchPath", &opts->patchPath);
 	_lookupCharValue(config, "cheatsPath", &opts->cheatsPath);
+	_lookupCharValue(config, "romCachePath", &opts->romCachePath);
+	_lookupIntValue(config, "romCacheSize", &opts->romCacheSize);
 }
 
 void mCoreConfigLoadDefaults(struct mCoreConfig* config, const struct mCoreOptions* opts) {
@@ -393,6 +400,9 @@ void mCoreConfigLoadDefaults(struct mCoreConfig* config, const struct mCoreOptio
 	ConfigurationSetIntValue(&config->defaultsTable, 0, "frameskip", opts->frameskip);
 	ConfigurationSetIntValue(&config->defaultsTable, 0, "rewindEnable", opts->rewindEnable);
 	ConfigurationSetIntValue(&config->defaultsTable, 0, "rewindBufferCapacity", opts->rewindBufferCapacity);
+	ConfigurationSetIntValue(&config->defaultsTable, 0, "rewindBufferMemory", opts->rewindBufferMemory);
+	ConfigurationSetIntValue(&config->defaultsTable, 0, "rewindFrames", opts->rewindFrames);
+	ConfigurationSetIntValue(&config->defaultsTable, 0, "archiveThreads", opts->archiveThreads);
 	ConfigurationSetFloatValue(&config->defaultsTable, 0, "fpsTarget", opts->fpsTarget);
 	ConfigurationSetUIntValue(&config->defaultsTable, 0, "audioBuffers", opts->audioBuffers);
 	ConfigurationSetUIntValue(&config->defaultsTable, 0, "sampleRate", opts->sampleRate);
@@ -446,6 +456,7 @@ void mCoreConfigFreeOpts(struct mCoreOptions* opts) {
 	free(opts->screenshotPath);
 	free(opts->patchPath);
 	free(opts->cheatsPath);
+	free(opts->romCachePath);
 	opts->bios = 0;
 	opts->shader = 0;
 	opts->savegamePath = 0;
@@ -453,4 +464,5 @@ void mCoreConfigFreeOpts(struct mCoreOptions* opts) {
 	opts->screenshotPath = 0;
 	opts->patchPath = 0;
 	opts->cheatsPath = 0;
+	opts->romCachePath = 0;
 }
@@ -8,15 +8,26 @@
 #include <mgba/core/core.h>
 #include <mgba/core/cheats.h>
 #include <mgba/core/interface.h>
+#include <mgba/core/rewind.h>
 #include <mgba-util/memory.h>
 #include <mgba-util/vfs.h>
 
 #ifdef USE_PNG
 #include <mgba-util/png-io.h>
 #include <png.h>
+#endif
+#if defined(USE_PNG) || defined(USE_ZLIB)
 #include <zlib.h>
 #endif
 
+// Magic, codec, uncompressed size and compressed size
+#define COMPRESSED_STATE_HEADER_SIZE 16
+#define COMPRESSED_STATE_MAX_SIZE 0x4000000
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _stateSaverThread(void* context);
+#endif
+
 mLOG_DEFINE_CATEGORY(SAVESTATE, "Savestate", "core.serialize");
 
 struct mBundledState {
@@ -31,6 +42,9 @@ struct mStateExtdataHeader {
 	int64_t offset;
 };
 
+static const char _compressedStateMagic[4] = { 'm', 'S', 'T', 'z' };
+static const char* const _compressionNames[mSTATE_COMPRESSION_MAX] = { "none", "rle", "zlib" };
+
 bool mStateExtdataInit(struct mStateExtdata* extdata) {
 	memset(extdata->data, 0, sizeof(extdata->data));
 	return true;
@@ -65,6 +79,32 @@ bool mStateExtdataGet(struct mStateExtdata* extdata, enum mStateExtdataTag tag,
 	return true;
 }
 
+void mStatePagesMarkRange(uint32_t* pages, size_t start, size_t end) {
+	if (start >= end) {
+		return;
+	}
+	size_t page;
+	for (page = start >> M_STATE_PAGE_SHIFT; page <= (end - 1) >> M_STATE_PAGE_SHIFT; ++page) {
+		pages[page >> 5] |= 1U << (page & 31);
+	}
+}
+
+void mStatePagesCollect(uint32_t* pages, size_t offset, uint32_t* regionPages, size_t regionSize) {
+	size_t page;
+	for (page = 0; page << M_STATE_PAGE_SHIFT < regionSize; ++page) {
+		if (!mStatePageIsDirty(regionPages, page)) {
+			continue;
+		}
+		size_t start = page << M_STATE_PAGE_SHIFT;
+		size_t end = start + M_STATE_PAGE_SIZE;
+		if (end > regionSize) {
+			end = regionSize;
+		}
+		mStatePagesMarkRange(pages, offset + start, offset + end);
+	}
+	memset(regionPages, 0, M_STATE_PAGE_WORDS(regionSize) * sizeof(*regionPages));
+}
+
 bool mStateExtdataSerialize(struct mStateExtdata* extdata, struct VFile* vf) {
 	ssize_t position = vf->seek(vf, 0, SEEK_CUR);
 	ssize_t size = sizeof(struct mStateExtdataHeader);
@@ -110,7 +150,20 @@ bool mStateExtdataSerialize(struct mStateExtdata* extdata, struct VFile* vf) {
 	return true;
 }
 
-bool mStateExtdataDeserialize(struct mStateExtdata* extdata, struct VFile* vf) {
+static bool _wantsTag(const enum mStateExtdataTag* tags, size_t nTags, uint32_t tag) {
+	if (!tags) {
+		return true;
+	}
+	size_t i;
+	for (i = 0; i < nTags; ++i) {
+		if (tags[i] == tag) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool _deserializeExtdata(struct mStateExtdata* extdata, struct VFile* vf, const enum mStateExtdataTag* tags, size_t nTags) {
 	while (true) {
 		struct mStateExtdataHeader buffer, header;
 		if (vf->read(vf, &buffer, sizeof(buffer)) != sizeof(buffer)) {
@@ -123,7 +176,7 @@ bool mStateExtdataDeserialize(struct mStateExtdata* extdata, struct VFile* vf) {
 		if (header.tag == EXTDATA_NONE) {
 			break;
 		}
-		if (header.tag >= EXTDATA_MAX) {
+		if (header.tag >= EXTDATA_MAX || !_wantsTag(tags, nTags, header.tag)) {
 			continue;
 		}
 		ssize_t position = vf->seek(vf, 0, SEEK_CUR);
@@ -148,34 +201,306 @@ bool mStateExtdataDeserialize(struct mStateExtdata* extdata, struct VFile* vf) {
 	return true;
 }
 
-#ifdef USE_PNG
-static bool _savePNGState(struct mCore* core, struct VFile* vf, struct mStateExtdata* extdata) {
-	size_t stride;
-	const void* pixels = 0;
+bool mStateExtdataDeserialize(struct mStateExtdata* extdata, struct VFile* vf) {
+	return _deserializeExtdata(extdata, vf, NULL, 0);
+}
 
-	core->getPixels(core, &pixels, &stride);
+// Points the items straight into a state that is already in memory; they are only valid while it is
+static void _deserializeExtdataInPlace(struct mStateExtdata* extdata, const uint8_t* state, size_t size, size_t offset) {
+	while (offset + sizeof(struct mStateExtdataHeader) <= size) {
+		struct mStateExtdataHeader buffer, header;
+		memcpy(&buffer, &state[offset], sizeof(buffer));
+		offset += sizeof(buffer);
+		LOAD_32LE(header.tag, 0, &buffer.tag);
+		LOAD_32LE(header.size, 0, &buffer.size);
+		LOAD_64LE(header.offset, 0, &buffer.offset);
+
+		if (header.tag == EXTDATA_NONE) {
+			break;
+		}
+		if (header.tag >= EXTDATA_MAX || header.size < 0 || header.offset < 0 || (uint64_t) header.offset > size || (size_t) header.size > size - header.offset) {
+			continue;
+		}
+		struct mStateExtdataItem item = {
+			.data = (void*) &state[header.offset],
+			.size = header.size,
+			.clean = NULL
+		};
+		mStateExtdataPut(extdata, header.tag, &item);
+	}
+}
+
+// Thumbnails are stored as a little-endian width and height, followed by 32-bit little-endian
+// pixels with red in the low byte, so that they read the same whatever color_t is
+static void _putThumbnail(struct mStateExtdata* extdata, const color_t* pixels, unsigned width, unsigned height, size_t stride) {
+	unsigned thumbWidth = width / mSTATE_THUMBNAIL_SCALE;
+	unsigned thumbHeight = height / mSTATE_THUMBNAIL_SCALE;
+	if (!thumbWidth || !thumbHeight) {
+		return;
+	}
+	struct mStateExtdataItem item = {
+		.size = sizeof(uint16_t) * 2 + thumbWidth * thumbHeight * sizeof(uint32_t),
+		.clean = free
+	};
+	uint8_t* data = malloc(item.size);
+	if (!data) {
+		return;
+	}
+	item.data = data;
+	STORE_16LE(thumbWidth, 0, data);
+	STORE_16LE(thumbHeight, sizeof(uint16_t), data);
+	data += sizeof(uint16_t) * 2;
+
+	unsigned x, y, i, j;
+	for (y = 0; y < thumbHeight; ++y) {
+		for (x = 0; x < thumbWidth; ++x) {
+			unsigned r = 0, g = 0, b = 0;
+			for (j = 0; j < mSTATE_THUMBNAIL_SCALE; ++j) {
+				const color_t* row = &pixels[(y * mSTATE_THUMBNAIL_SCALE + j) * stride + x * mSTATE_THUMBNAIL_SCALE];
+				for (i = 0; i < mSTATE_THUMBNAIL_SCALE; ++i) {
+					color_t c = row[i];
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+					r += (c >> 8) & 0xF8;
+					g += (c >> 3) & 0xFC;
+					b += (c << 3) & 0xF8;
+#else
+					r += (c >> 7) & 0xF8;
+					g += (c >> 2) & 0xF8;
+					b += (c << 3) & 0xF8;
+#endif
+#else
+					r += c & 0xFF;
+					g += (c >> 8) & 0xFF;
+					b += (c >> 16) & 0xFF;
+#endif
+				}
+			}
+			r /= mSTATE_THUMBNAIL_SCALE * mSTATE_THUMBNAIL_SCALE;
+			g /= mSTATE_THUMBNAIL_SCALE * mSTATE_THUMBNAIL_SCALE;
+			b /= mSTATE_THUMBNAIL_SCALE * mSTATE_THUMBNAIL_SCALE;
+			STORE_32LE(r | (g << 8) | (b << 16), (y * thumbWidth + x) * sizeof(uint32_t), (uint32_t*) data);
+		}
+	}
+	mStateExtdataPut(extdata, EXTDATA_THUMBNAIL, &item);
+}
+
+bool mStateThumbnailDecode(const struct mStateExtdataItem* item, unsigned* width, unsigned* height, color_t* pixels, size_t stride) {
+	if (!item->data || item->size < (int32_t) sizeof(uint16_t) * 2) {
+		return false;
+	}
+	uint16_t thumbWidth, thumbHeight;
+	LOAD_16LE(thumbWidth, 0, item->data);
+	LOAD_16LE(thumbHeight, sizeof(uint16_t), item->data);
+	if (item->size < (int32_t) (sizeof(uint16_t) * 2 + thumbWidth * thumbHeight * sizeof(uint32_t))) {
+		return false;
+	}
+	*width = thumbWidth;
+	*height = thumbHeight;
 	if (!pixels) {
+		return true;
+	}
+
+	const uint32_t* data = (const uint32_t*) ((const uint8_t*) item->data + sizeof(uint16_t) * 2);
+	unsigned x, y;
+	for (y = 0; y < thumbHeight; ++y) {
+		for (x = 0; x < thumbWidth; ++x) {
+			uint32_t c;
+			LOAD_32LE(c, (y * thumbWidth + x) * sizeof(uint32_t), data);
+			unsigned r = c & 0xFF;
+			unsigned g = (c >> 8) & 0xFF;
+			unsigned b = (c >> 16) & 0xFF;
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+			pixels[y * stride + x] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+#else
+			pixels[y * stride + x] = ((r & 0xF8) << 7) | ((g & 0xF8) << 2) | (b >> 3);
+#endif
+#else
+			pixels[y * stride + x] = r | (g << 8) | (b << 16) | 0xFF000000;
+#endif
+		}
+	}
+	return true;
+}
+
+bool mStateCompressionAvailable(enum mStateCompression compression) {
+	switch (compression) {
+	case mSTATE_COMPRESSION_NONE:
+	case mSTATE_COMPRESSION_RLE:
+		return true;
+#ifdef USE_ZLIB
+	case mSTATE_COMPRESSION_ZLIB:
+		return true;
+#endif
+	default:
 		return false;
 	}
+}
 
-	size_t stateSize = core->stateSize(core);
-	void* state = anonymousMemoryMap(stateSize);
-	if (!state) {
+int mStateCompressionParse(const char* name) {
+	if (!name) {
+		return 0;
+	}
+	int compression;
+	for (compression = 0; compression < mSTATE_COMPRESSION_MAX; ++compression) {
+		size_t length = strlen(_compressionNames[compression]);
+		if (strncmp(name, _compressionNames[compression], length) != 0 || (name[length] && name[length] != ':')) {
+			continue;
+		}
+		long level = 0;
+		if (name[length] == ':') {
+			char* end;
+			level = strtol(&name[length + 1], &end, 10);
+			if (*end || level < 0 || level > 9) {
+				return 0;
+			}
+		}
+		if (!mStateCompressionAvailable(compression)) {
+			return 0;
+		}
+		return SAVESTATE_COMPRESS(compression, level);
+	}
+	return 0;
+}
+
+bool mStateIsCompressed(struct VFile* vf) {
+	char magic[sizeof(_compressedStateMagic)];
+	vf->seek(vf, 0, SEEK_SET);
+	bool compressed = vf->read(vf, magic, sizeof(magic)) == sizeof(magic) && !memcmp(magic, _compressedStateMagic, sizeof(magic));
+	vf->seek(vf, 0, SEEK_SET);
+	return compressed;
+}
+
+bool mStateCompress(struct VFile* dest, struct VFile* source, int flags) {
+	enum mStateCompression compression = SAVESTATE_COMPRESSION_CODEC(flags);
+	size_t size = source->size(source);
+	if (compression == mSTATE_COMPRESSION_NONE || !mStateCompressionAvailable(compression) || size > COMPRESSED_STATE_MAX_SIZE) {
 		return false;
 	}
-	core->saveState(core, state);
+	const uint8_t* in = source->map(source, size, MAP_READ);
+	if (!in) {
+		return false;
+	}
+	uint8_t* out = NULL;
+	size_t compressedSize = 0;
+	switch (compression) {
+	case mSTATE_COMPRESSION_RLE: {
+		// The coding works on whole words, so a partial last word gets padded out
+		size_t words = (size + 3) / 4;
+		uint32_t* padded = NULL;
+		if (size & 3) {
+			padded = calloc(words, sizeof(uint32_t));
+			if (!padded) {
+				break;
+			}
+			memcpy(padded, in, size);
+		}
+		out = malloc(COMPRESSED_STATE_HEADER_SIZE + mCoreRewindEncodeBound(words) * sizeof(uint32_t));
+		if (out) {
+			compressedSize = mCoreRewindEncode((uint32_t*) &out[COMPRESSED_STATE_HEADER_SIZE], NULL, padded ? padded : (const uint32_t*) in, words, NULL, 0) * sizeof(uint32_t);
+		}
+		free(padded);
+		break;
+	}
+#ifdef USE_ZLIB
+	case mSTATE_COMPRESSION_ZLIB: {
+		uLongf length = compressBound(size);
+		int level = SAVESTATE_COMPRESSION_LEVEL(flags);
+		out = malloc(COMPRESSED_STATE_HEADER_SIZE + length);
+		if (out && compress2(&out[COMPRESSED_STATE_HEADER_SIZE], &length, in, size, level ? level : Z_DEFAULT_COMPRESSION) == Z_OK) {
+			compressedSize = length;
+		} else {
+			free(out);
+			out = NULL;
+		}
+		break;
+	}
+#endif
+	default:
+		break;
+	}
+	source->unmap(source, (void*) in, size);
+	if (!out) {
+		return false;
+	}
+
+	memcpy(out, _compressedStateMagic, sizeof(_compressedStateMagic));
+	STORE_32LE(compression, 4, out);
+	STORE_32LE(size, 8, out);
+	STORE_32LE(compressedSize, 12, out);
+	compressedSize += COMPRESSED_STATE_HEADER_SIZE;
+	dest->truncate(dest, compressedSize);
+	dest->seek(dest, 0, SEEK_SET);
+	bool success = dest->write(dest, out, compressedSize) == (ssize_t) compressedSize;
+	free(out);
+	return success;
+}
+
+struct VFile* mStateDecompress(struct VFile* vf) {
+	uint8_t header[COMPRESSED_STATE_HEADER_SIZE];
+	vf->seek(vf, 0, SEEK_SET);
+	if (vf->read(vf, header, sizeof(header)) != sizeof(header) || memcmp(header, _compressedStateMagic, sizeof(_compressedStateMagic))) {
+		return NULL;
+	}
+	uint32_t compression;
+	uint32_t size;
+	uint32_t compressedSize;
+	LOAD_32LE(compression, 4, header);
+	LOAD_32LE(size, 8, header);
+	LOAD_32LE(compressedSize, 12, header);
+	if (compression == mSTATE_COMPRESSION_NONE || !mStateCompressionAvailable(compression) || size > COMPRESSED_STATE_MAX_SIZE || compressedSize > COMPRESSED_STATE_MAX_SIZE) {
+		return NULL;
+	}
+	uint8_t* data = malloc(compressedSize ? compressedSize : 1);
+	if (!data || vf->read(vf, data, compressedSize) != (ssize_t) compressedSize) {
+		free(data);
+		return NULL;
+	}
+
+	size_t words = (size + 3) / 4;
+	struct VFile* state = VFileMemChunk(NULL, words * sizeof(uint32_t));
+	uint8_t* out = state ? state->map(state, words * sizeof(uint32_t), MAP_WRITE) : NULL;
+	bool success = false;
+	if (out) {
+		switch (compression) {
+		case mSTATE_COMPRESSION_RLE:
+			memset(out, 0, words * sizeof(uint32_t));
+			success = !(compressedSize & 3) && mCoreRewindApply((uint32_t*) out, words, (const uint32_t*) data, compressedSize / sizeof(uint32_t));
+			break;
+#ifdef USE_ZLIB
+		case mSTATE_COMPRESSION_ZLIB: {
+			uLongf length = size;
+			success = uncompress(out, &length, data, compressedSize) == Z_OK && length == size;
+			break;
+		}
+#endif
+		default:
+			break;
+		}
+		state->unmap(state, out, words * sizeof(uint32_t));
+	}
+	free(data);
+	if (!success) {
+		if (state) {
+			state->close(state);
+		}
+		return NULL;
+	}
+	state->truncate(state, size);
+	state->seek(state, 0, SEEK_SET);
+	return state;
+}
 
+#ifdef USE_PNG
+static bool _encodePNGState(struct VFile* vf, const void* state, size_t stateSize, const void* pixels, unsigned width, unsigned height, size_t stride, struct mStateExtdata* extdata) {
 	uLongf len = compressBound(stateSize);
 	void* buffer = malloc(len);
 	if (!buffer) {
-		mappedMemoryFree(state, stateSize);
 		return false;
 	}
 	compress(buffer, &len, (const Bytef*) state, stateSize);
-	mappedMemoryFree(state, stateSize);
 
-	unsigned width, height;
-	core->desiredVideoDimensions(core, &width, &height);
 	png_structp png = PNGWriteOpen(vf);
 	png_infop info = PNGWriteHeader(png, width, height);
 	if (!png || !info) {
@@ -208,6 +533,29 @@ static bool _savePNGState(struct mCore* core, struct VFile* vf, struct mStateExt
 	return true;
 }
 
+static bool _savePNGState(struct mCore* core, struct VFile* vf, struct mStateExtdata* extdata) {
+	size_t stride;
+	const void* pixels = 0;
+
+	core->getPixels(core, &pixels, &stride);
+	if (!pixels) {
+		return false;
+	}
+
+	size_t stateSize = core->stateSize(core);
+	void* state = anonymousMemoryMap(stateSize);
+	if (!state) {
+		return false;
+	}
+	core->saveState(core, state);
+
+	unsigned width, height;
+	core->desiredVideoDimensions(core, &width, &height);
+	bool success = _encodePNGState(vf, state, stateSize, pixels, width, height, stride, extdata);
+	mappedMemoryFree(state, stateSize);
+	return success;
+}
+
 static int _loadPNGChunkHandler(png_structp png, png_unknown_chunkp chunk) {
 	struct mBundledState* bundle = png_get_user_chunk_ptr(png);
 	if (!bundle) {
@@ -297,13 +645,63 @@ static void* _loadPNGState(struct mCore* core, struct VFile* vf, struct mStateEx
 	}
 	return state;
 }
-#endif
 
-bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags) {
-	struct mStateExtdata extdata;
-	mStateExtdataInit(&extdata);
-	size_t stateSize = core->stateSize(core);
+// Walks the chunks by hand instead of going through libpng, so that the image data and the
+// state itself are seeked past rather than decoded
+static bool _extractPNGExtdata(struct VFile* vf, struct mStateExtdata* extdata, const enum mStateExtdataTag* tags, size_t nTags) {
+	if (vf->seek(vf, PNG_HEADER_BYTES, SEEK_SET) < 0) {
+		return false;
+	}
+	while (true) {
+		uint8_t header[8];
+		if (vf->read(vf, header, sizeof(header)) != sizeof(header)) {
+			break;
+		}
+		uint32_t length;
+		LOAD_32BE(length, 0, header);
+		if (length > 0x7FFFFFFF || !memcmp(&header[4], "IEND", 4)) {
+			break;
+		}
+		if (memcmp(&header[4], "gbAx", 4) || length < sizeof(uint32_t) * 2) {
+			vf->seek(vf, length + 4, SEEK_CUR);
+			continue;
+		}
+		uint32_t itemHeader[2];
+		if (vf->read(vf, itemHeader, sizeof(itemHeader)) != sizeof(itemHeader)) {
+			break;
+		}
+		length -= sizeof(itemHeader);
+		uint32_t tag;
+		struct mStateExtdataItem item;
+		LOAD_32LE(tag, 0, itemHeader);
+		LOAD_32LE(item.size, sizeof(uint32_t), itemHeader);
+		if (item.size < 0 || tag == EXTDATA_NONE || tag >= EXTDATA_MAX || !_wantsTag(tags, nTags, tag)) {
+			vf->seek(vf, length + 4, SEEK_CUR);
+			continue;
+		}
+		void* compressed = malloc(length);
+		item.data = malloc(item.size);
+		item.clean = free;
+		if (!compressed || !item.data || vf->read(vf, compressed, length) != (ssize_t) length) {
+			free(compressed);
+			free(item.data);
+			break;
+		}
+		uLongf len = item.size;
+		if (uncompress((Bytef*) item.data, &len, compressed, length) == Z_OK) {
+			item.size = len;
+			mStateExtdataPut(extdata, tag, &item);
+		} else {
+			free(item.data);
+		}
+		free(compressed);
+		vf->seek(vf, 4, SEEK_CUR);
+	}
+	return true;
+}
+#endif
 
+static struct VFile* _collectExtdata(struct mCore* core, struct mStateExtdata* extdata, int flags) {
 	if (flags & SAVESTATE_METADATA) {
 		uint64_t* creationUsec = malloc(sizeof(*creationUsec));
 		if (creationUsec) {
@@ -334,7 +732,7 @@ bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags) {
 				.data = creationUsec,
 				.clean = free
 			};
-			mStateExtdataPut(&extdata, EXTDATA_META_TIME, &item);
+			mStateExtdataPut(extdata, EXTDATA_META_TIME, &item);
 		}
 	}
 
@@ -347,7 +745,7 @@ bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags) {
 				.data = sram,
 				.clean = free
 			};
-			mStateExtdataPut(&extdata, EXTDATA_SAVEDATA, &item);
+			mStateExtdataPut(extdata, EXTDATA_SAVEDATA, &item);
 		}
 	}
 	struct VFile* cheatVf = 0;
@@ -361,44 +759,77 @@ bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags) {
 				.data = cheatVf->map(cheatVf, cheatVf->size(cheatVf), MAP_READ),
 				.clean = 0
 			};
-			mStateExtdataPut(&extdata, EXTDATA_CHEATS, &item);
+			mStateExtdataPut(extdata, EXTDATA_CHEATS, &item);
 		}
 	}
 	if (flags & SAVESTATE_RTC) {
 		struct mStateExtdataItem item;
 		if (core->rtc.d.serialize) {
 			core->rtc.d.serialize(&core->rtc.d, &item);
-			mStateExtdataPut(&extdata, EXTDATA_RTC, &item);
+			mStateExtdataPut(extdata, EXTDATA_RTC, &item);
+		}
+	}
+	return cheatVf;
+}
+
+bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags) {
+	struct mStateExtdata extdata;
+	mStateExtdataInit(&extdata);
+	size_t stateSize = core->stateSize(core);
+	struct VFile* cheatVf = _collectExtdata(core, &extdata, flags);
+	if (flags & SAVESTATE_THUMBNAIL) {
+		const void* pixels = NULL;
+		size_t stride;
+		unsigned width, height;
+		core->getPixels(core, &pixels, &stride);
+		core->desiredVideoDimensions(core, &width, &height);
+		if (pixels) {
+			_putThumbnail(&extdata, pixels, width, height, stride);
 		}
 	}
 #ifdef USE_PNG
 	if (!(flags & SAVESTATE_SCREENSHOT)) {
-#else
-	UNUSED(flags);
 #endif
-		vf->truncate(vf, stateSize);
-		struct GBASerializedState* state = vf->map(vf, stateSize, MAP_WRITE);
+		struct VFile* raw = vf;
+		enum mStateCompression compression = SAVESTATE_COMPRESSION_CODEC(flags);
+		if (compression != mSTATE_COMPRESSION_NONE && mStateCompressionAvailable(compression)) {
+			// Serialized into memory as usual, then compressed out to the file
+			raw = VFileMemChunk(NULL, 0);
+		}
+		raw->truncate(raw, stateSize);
+		struct GBASerializedState* state = raw->map(raw, stateSize, MAP_WRITE);
 		if (!state) {
 			mStateExtdataDeinit(&extdata);
 			if (cheatVf) {
 				cheatVf->close(cheatVf);
 			}
+			if (raw != vf) {
+				raw->close(raw);
+			}
 			return false;
 		}
 		core->saveState(core, state);
-		vf->unmap(vf, state, stateSize);
-		vf->seek(vf, stateSize, SEEK_SET);
-		mStateExtdataSerialize(&extdata, vf);
+		raw->unmap(raw, state, stateSize);
+		raw->seek(raw, stateSize, SEEK_SET);
+		mStateExtdataSerialize(&extdata, raw);
 		mStateExtdataDeinit(&extdata);
 		if (cheatVf) {
 			cheatVf->close(cheatVf);
 		}
-		return true;
+		bool success = true;
+		if (raw != vf) {
+			success = mStateCompress(vf, raw, flags);
+			raw->close(raw);
+		}
+		return success;
 #ifdef USE_PNG
 	}
 	else {
 		bool success = _savePNGState(core, vf, &extdata);
 		mStateExtdataDeinit(&extdata);
+		if (cheatVf) {
+			cheatVf->close(cheatVf);
+		}
 		return success;
 	}
 #endif
@@ -407,6 +838,15 @@ bool mCoreSaveStateNamed(struct mCore* core, struct VFile* vf, int flags) {
 }
 
 void* mCoreExtractState(struct mCore* core, struct VFile* vf, struct mStateExtdata* extdata) {
+	if (mStateIsCompressed(vf)) {
+		struct VFile* decompressed = mStateDecompress(vf);
+		if (!decompressed) {
+			return NULL;
+		}
+		void* state = mCoreExtractState(core, decompressed, extdata);
+		decompressed->close(decompressed);
+		return state;
+	}
 #ifdef USE_PNG
 	if (isPNG(vf)) {
 		return _loadPNGState(core, vf, extdata);
@@ -425,15 +865,71 @@ void* mCoreExtractState(struct mCore* core, struct VFile* vf, struct mStateExtda
 	return state;
 }
 
+bool mCoreExtractExtdata(struct mCore* core, struct VFile* vf, struct mStateExtdata* extdata, const enum mStateExtdataTag* tags, size_t nTags) {
+	if (mStateIsCompressed(vf)) {
+		struct VFile* decompressed = mStateDecompress(vf);
+		if (!decompressed) {
+			return false;
+		}
+		bool success = mCoreExtractExtdata(core, decompressed, extdata, tags, nTags);
+		decompressed->close(decompressed);
+		return success;
+	}
+	vf->seek(vf, 0, SEEK_SET);
+#ifdef USE_PNG
+	if (isPNG(vf)) {
+		return _extractPNGExtdata(vf, extdata, tags, nTags);
+	}
+#endif
+	ssize_t stateSize = core->stateSize(core);
+	if (vf->size(vf) < stateSize || vf->seek(vf, stateSize, SEEK_SET) < 0) {
+		return false;
+	}
+	return _deserializeExtdata(extdata, vf, tags, nTags);
+}
+
 bool mCoreLoadStateNamed(struct mCore* core, struct VFile* vf, int flags) {
+	if (mStateIsCompressed(vf)) {
+		struct VFile* decompressed = mStateDecompress(vf);
+		if (!decompressed) {
+			return false;
+		}
+		bool success = mCoreLoadStateNamed(core, decompressed, flags);
+		decompressed->close(decompressed);
+		return success;
+	}
 	struct mStateExtdata extdata;
 	mStateExtdataInit(&extdata);
-	void* state = mCoreExtractState(core, vf, &extdata);
+	size_t stateSize = core->stateSize(core);
+	void* state = NULL;
+	bool mapped = vf->size(vf) >= (ssize_t) stateSize;
+#ifdef USE_PNG
+	if (mapped) {
+		mapped = !isPNG(vf);
+		vf->seek(vf, 0, SEEK_SET);
+	}
+#endif
+	size_t mappedSize = 0;
+	if (mapped) {
+		// States that are already in memory, e.g. for run-ahead, are loaded in place instead of
+		// copied, and so is their extdata, so the mapping is kept until everything is loaded
+		mappedSize = vf->size(vf);
+		state = vf->map(vf, mappedSize, MAP_READ);
+		mapped = state;
+		if (mapped) {
+			_deserializeExtdataInPlace(&extdata, state, mappedSize, stateSize);
+		}
+	}
+	if (!state) {
+		state = mCoreExtractState(core, vf, &extdata);
+	}
 	if (!state) {
 		return false;
 	}
 	bool success = core->loadState(core, state);
-	mappedMemoryFree(state, core->stateSize(core));
+	if (!mapped) {
+		mappedMemoryFree(state, stateSize);
+	}
 
 	unsigned width, height;
 	core->desiredVideoDimensions(core, &width, &height);
@@ -474,6 +970,233 @@ bool mCoreLoadStateNamed(struct mCore* core, struct VFile* vf, int flags) {
 		}
 	}
 	mStateExtdataDeinit(&extdata);
+	if (mapped) {
+		vf->unmap(vf, state, mappedSize);
+	}
+	return success;
+}
+
+bool mCoreCopyState(struct mCore* core, struct mCore* source) {
+	if (core->copyState && core->copyState == source->copyState) {
+		return core->copyState(core, source);
+	}
+	size_t stateSize = core->stateSize(core);
+	if (core->platform(core) != source->platform(source) || source->stateSize(source) != stateSize) {
+		return false;
+	}
+	void* state = anonymousMemoryMap(stateSize);
+	bool success = source->saveState(source, state) && core->loadState(core, state);
+	mappedMemoryFree(state, stateSize);
+	if (!success) {
+		return false;
+	}
+	void* sram = NULL;
+	size_t size = source->savedataClone(source, &sram);
+	if (size) {
+		core->savedataRestore(core, sram, size, false);
+	}
+	free(sram);
+	return true;
+}
+
+bool mCoreSaveStateRegions(struct mCore* core, void* state, uint32_t regions) {
+	if (core->saveStateRegions && (regions & mSTATE_REGION_ALL) != mSTATE_REGION_ALL) {
+		return core->saveStateRegions(core, state, regions);
+	}
+	return core->saveState(core, state);
+}
+
+bool mCoreLoadStateRegions(struct mCore* core, const void* state, uint32_t regions) {
+	if ((regions & mSTATE_REGION_ALL) == mSTATE_REGION_ALL) {
+		return core->loadState(core, state);
+	}
+	if (!core->loadStateRegions) {
+		return false;
+	}
+	return core->loadStateRegions(core, state, regions);
+}
+
+void mCoreStateSaverInit(struct mCoreStateSaver* saver, bool onThread) {
+	saver->callback = NULL;
+	saver->context = NULL;
+	saver->vf = NULL;
+	saver->state = NULL;
+	saver->stateSize = 0;
+	saver->pixels = NULL;
+	saver->pixelsSize = 0;
+	saver->cheats = NULL;
+	mStateExtdataInit(&saver->extdata);
+#ifndef DISABLE_THREADING
+	saver->onThread = onThread;
+	saver->busy = false;
+	if (onThread) {
+		MutexInit(&saver->mutex);
+		ConditionInit(&saver->cond);
+		ThreadCreate(&saver->thread, _stateSaverThread, saver);
+	}
+#else
+	UNUSED(onThread);
+#endif
+}
+
+void mCoreStateSaverDeinit(struct mCoreStateSaver* saver) {
+#ifndef DISABLE_THREADING
+	if (saver->onThread) {
+		MutexLock(&saver->mutex);
+		while (saver->busy) {
+			ConditionWait(&saver->cond, &saver->mutex);
+		}
+		saver->onThread = false;
+		ConditionWake(&saver->cond);
+		MutexUnlock(&saver->mutex);
+		ThreadJoin(&saver->thread);
+		MutexDeinit(&saver->mutex);
+		ConditionDeinit(&saver->cond);
+	}
+#endif
+	if (saver->state) {
+		mappedMemoryFree(saver->state, saver->stateSize);
+		saver->state = NULL;
+	}
+	free(saver->pixels);
+	saver->pixels = NULL;
+}
+
+void mCoreStateSaverWait(struct mCoreStateSaver* saver) {
+#ifndef DISABLE_THREADING
+	if (!saver->onThread) {
+		return;
+	}
+	MutexLock(&saver->mutex);
+	while (saver->busy) {
+		ConditionWait(&saver->cond, &saver->mutex);
+	}
+	MutexUnlock(&saver->mutex);
+#else
+	UNUSED(saver);
+#endif
+}
+
+static bool _stateSaverWrite(struct mCoreStateSaver* saver) {
+	struct VFile* vf = saver->vf;
+	bool success;
+	if (saver->flags & SAVESTATE_THUMBNAIL) {
+		_putThumbnail(&saver->extdata, saver->pixels, saver->width, saver->height, saver->width);
+	}
+#ifdef USE_PNG
+	if (saver->flags & SAVESTATE_SCREENSHOT) {
+		success = _encodePNGState(vf, saver->state, saver->stateSize, saver->pixels, saver->width, saver->height, saver->width, &saver->extdata);
+	} else
+#endif
+	{
+		struct VFile* raw = vf;
+		enum mStateCompression compression = SAVESTATE_COMPRESSION_CODEC(saver->flags);
+		if (compression != mSTATE_COMPRESSION_NONE && mStateCompressionAvailable(compression)) {
+			raw = VFileMemChunk(NULL, 0);
+		}
+		raw->seek(raw, 0, SEEK_SET);
+		success = raw->write(raw, saver->state, saver->stateSize) == (ssize_t) saver->stateSize;
+		success = success && mStateExtdataSerialize(&saver->extdata, raw);
+		if (raw != vf) {
+			success = success && mStateCompress(vf, raw, saver->flags);
+			raw->close(raw);
+		}
+	}
+	mStateExtdataDeinit(&saver->extdata);
+	mStateExtdataInit(&saver->extdata);
+	if (saver->cheats) {
+		saver->cheats->close(saver->cheats);
+		saver->cheats = NULL;
+	}
+	vf->close(vf);
+	saver->vf = NULL;
 	return success;
 }
 
+bool mCoreStateSaverSave(struct mCoreStateSaver* saver, struct mCore* core, struct VFile* vf, int flags, int slot) {
+	mCoreStateSaverWait(saver);
+
+	size_t stateSize = core->stateSize(core);
+	if (stateSize != saver->stateSize) {
+		if (saver->state) {
+			mappedMemoryFree(saver->state, saver->stateSize);
+		}
+		saver->state = anonymousMemoryMap(stateSize);
+		saver->stateSize = saver->state ? stateSize : 0;
+	}
+	bool success = saver->state && core->saveState(core, saver->state);
+	int pixelFlags = SAVESTATE_THUMBNAIL;
+#ifdef USE_PNG
+	pixelFlags |= SAVESTATE_SCREENSHOT;
+#endif
+	if (success && flags & pixelFlags) {
+		const void* pixels = NULL;
+		size_t stride;
+		core->getPixels(core, &pixels, &stride);
+		core->desiredVideoDimensions(core, &saver->width, &saver->height);
+		size_t rowSize = saver->width * BYTES_PER_PIXEL;
+		size_t pixelsSize = rowSize * saver->height;
+		if (pixelsSize > saver->pixelsSize) {
+			free(saver->pixels);
+			saver->pixels = malloc(pixelsSize);
+			saver->pixelsSize = saver->pixels ? pixelsSize : 0;
+		}
+		success = pixels && saver->pixels;
+		if (success) {
+			unsigned y;
+			for (y = 0; y < saver->height; ++y) {
+				memcpy((uint8_t*) saver->pixels + rowSize * y, (const uint8_t*) pixels + stride * BYTES_PER_PIXEL * y, rowSize);
+			}
+		}
+	}
+	if (!success) {
+		vf->close(vf);
+		return false;
+	}
+	saver->cheats = _collectExtdata(core, &saver->extdata, flags);
+	saver->vf = vf;
+	saver->flags = flags;
+	saver->slot = slot;
+
+#ifndef DISABLE_THREADING
+	if (saver->onThread) {
+		MutexLock(&saver->mutex);
+		saver->busy = true;
+		ConditionWake(&saver->cond);
+		MutexUnlock(&saver->mutex);
+		return true;
+	}
+#endif
+	success = _stateSaverWrite(saver);
+	if (saver->callback) {
+		saver->callback(saver, slot, success);
+	}
+	return true;
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _stateSaverThread(void* context) {
+	struct mCoreStateSaver* saver = context;
+	ThreadSetName("Savestate Writer");
+	ThreadPlaceHelper();
+	MutexLock(&saver->mutex);
+	while (true) {
+		while (!saver->busy && saver->onThread) {
+			ConditionWait(&saver->cond, &saver->mutex);
+		}
+		if (!saver->busy) {
+			break;
+		}
+		MutexUnlock(&saver->mutex);
+		bool success = _stateSaverWrite(saver);
+		if (saver->callback) {
+			saver->callback(saver, saver->slot, success);
+		}
+		MutexLock(&saver->mutex);
+		saver->busy = false;
+		ConditionWake(&saver->cond);
+	}
+	MutexUnlock(&saver->mutex);
+	return 0;
+}
+#endif
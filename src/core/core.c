@@ -30,15 +30,16 @@
 static const struct mCoreFilter {
 	bool (*filter)(struct VFile*);
 	struct mCore* (*open)(void);
+	bool (*identify)(struct VFile*, struct mCoreROMInfo*);
 	enum mPlatform platform;
 } _filters[] = {
 #ifdef M_CORE_GBA
-	{ GBAIsROM, GBACoreCreate, PLATFORM_GBA },
+	{ GBAIsROM, GBACoreCreate, GBAIdentifyROM, PLATFORM_GBA },
 #endif
 #ifdef M_CORE_GB
-	{ GBIsROM, GBCoreCreate, PLATFORM_GB },
+	{ GBIsROM, GBCoreCreate, GBIdentifyROM, PLATFORM_GB },
 #endif
-	{ 0, 0, PLATFORM_NONE }
+	{ 0, 0, 0, PLATFORM_NONE }
 };
 
 struct mCore* mCoreFindVF(struct VFile* vf) {
@@ -73,6 +74,27 @@ enum mPlatform mCoreIsCompatible(struct VFile* vf) {
 	return PLATFORM_NONE;
 }
 
+bool mCoreIdentifyVF(struct VFile* vf, struct mCoreROMInfo* info) {
+	if (!vf) {
+		return false;
+	}
+	const struct mCoreFilter* filter;
+	for (filter = &_filters[0]; filter->filter; ++filter) {
+		if (filter->filter(vf)) {
+			break;
+		}
+	}
+	if (!filter->identify) {
+		return false;
+	}
+	memset(info, 0, sizeof(*info));
+	if (!filter->identify(vf, info)) {
+		return false;
+	}
+	info->platform = filter->platform;
+	return true;
+}
+
 #if !defined(MINIMAL_CORE) || MINIMAL_CORE < 2
 #include <mgba-util/png-io.h>
 
@@ -328,6 +350,9 @@ void mCoreLoadForeignConfig(struct mCore* core, const struct mCoreConfig* config
 	if (core->opts.audioBuffers) {
 		core->setAudioBufferSize(core, core->opts.audioBuffers);
 	}
+#ifdef USE_LZMA
+	VDir7zSetThreads(core->opts.archiveThreads);
+#endif
 
 	mCoreConfigCopyValue(&core->config, config, "cheatAutosave");
 	mCoreConfigCopyValue(&core->config, config, "cheatAutoload");
@@ -368,13 +393,26 @@ bool mCoreLoadELF(struct mCore* core, struct ELF* elf) {
 	ELFProgramHeadersInit(&ph, 0);
 	ELFGetProgramHeaders(elf, &ph);
 	size_t i;
+	size_t esize;
+	char* bytes = ELFBytes(elf, &esize);
 	for (i = 0; i < ELFProgramHeadersSize(&ph); ++i) {
-		size_t bsize, esize;
+		size_t bsize;
 		Elf32_Phdr* phdr = ELFProgramHeadersGetPointer(&ph, i);
-		void* block = mCoreGetMemoryBlock(core, phdr->p_paddr, &bsize);
-		char* bytes = ELFBytes(elf, &esize);
+		// Only loadable segments end up in memory; the rest describe the file
+		if (phdr->p_type != PT_LOAD || !phdr->p_memsz) {
+			continue;
+		}
+		uint8_t* block = mCoreGetMemoryBlock(core, phdr->p_paddr, &bsize);
 		if (block && bsize >= phdr->p_filesz && esize > phdr->p_offset && esize >= phdr->p_filesz + phdr->p_offset) {
 			memcpy(block, &bytes[phdr->p_offset], phdr->p_filesz);
+			// The rest of the segment, e.g. .bss, starts out zeroed
+			if (phdr->p_memsz > phdr->p_filesz) {
+				size_t zeroes = phdr->p_memsz - phdr->p_filesz;
+				if (zeroes > bsize - phdr->p_filesz) {
+					zeroes = bsize - phdr->p_filesz;
+				}
+				memset(&block[phdr->p_filesz], 0, zeroes);
+			}
 		} else {
 			ELFProgramHeadersDeinit(&ph);
 			return false;
@@ -401,7 +439,7 @@ void mCoreLoadELFSymbols(struct mDebuggerSymbols* symbols, struct ELF* elf) {
 		if (name[0] == '$') {
 			continue;
 		}
-		mDebuggerSymbolAdd(symbols, name, syms[i].st_value, -1);
+		mDebuggerSymbolAddSized(symbols, name, syms[i].st_value, syms[i].st_size, -1);
 	}
 }
 #endif
@@ -6,9 +6,25 @@
 #include <mgba/core/directories.h>
 
 #include <mgba/core/config.h>
+#include <mgba-util/crc32.h>
+#include <mgba-util/vector.h>
 #include <mgba-util/vfs.h>
 
+#include <inttypes.h>
+
 #if !defined(MINIMAL_CORE) || MINIMAL_CORE < 2
+#define ROM_CACHE_INDEX "index"
+#define ROM_CACHE_NAME_LENGTH 64
+#define ROM_CACHE_COPY_CHUNK 0x10000
+
+struct mRomCacheEntry {
+	char name[ROM_CACHE_NAME_LENGTH];
+	uint64_t size;
+};
+
+DECLARE_VECTOR(mRomCacheIndex, struct mRomCacheEntry);
+DEFINE_VECTOR(mRomCacheIndex, struct mRomCacheEntry);
+
 void mDirectorySetInit(struct mDirectorySet* dirs) {
 	dirs->base = 0;
 	dirs->archive = 0;
@@ -17,6 +33,8 @@ void mDirectorySetInit(struct mDirectorySet* dirs) {
 	dirs->state = 0;
 	dirs->screenshot = 0;
 	dirs->cheats = 0;
+	dirs->romCache = 0;
+	dirs->romCacheLimit = 0;
 }
 
 void mDirectorySetDeinit(struct mDirectorySet* dirs) {
@@ -96,6 +114,11 @@ void mDirectorySetDeinit(struct mDirectorySet* dirs) {
 		dirs->cheats->close(dirs->cheats);
 		dirs->cheats = NULL;
 	}
+
+	if (dirs->romCache) {
+		dirs->romCache->close(dirs->romCache);
+		dirs->romCache = NULL;
+	}
 }
 
 void mDirectorySetAttachBase(struct mDirectorySet* dirs, struct VDir* base) {
@@ -140,14 +163,175 @@ void mDirectorySetDetachBase(struct mDirectorySet* dirs) {
 	}
 }
 
+// Cached copies are named after the archive's path, modification time and size, so a changed
+// archive never picks up a stale copy
+static bool _romCacheName(const char* path, char* name) {
+	struct VFile* archive = VFileOpen(path, O_RDONLY);
+	if (!archive) {
+		return false;
+	}
+	int64_t mtime = VFileModificationTime(archive);
+	ssize_t size = archive->size(archive);
+	archive->close(archive);
+	if (!mtime || size < 0) {
+		return false;
+	}
+	snprintf(name, ROM_CACHE_NAME_LENGTH, "%08X-%" PRIX64 "-%" PRIX64 ".rom", doCrc32(path, strlen(path)), (uint64_t) mtime, (uint64_t) size);
+	return true;
+}
+
+// The index lists the cached copies, most recently used first, one "name size" pair per line.
+// Copies only count as cached once they are in the index, so partial ones are never used.
+static void _romCacheReadIndex(struct VDir* cache, struct mRomCacheIndex* index) {
+	struct VFile* vf = cache->openFile(cache, ROM_CACHE_INDEX, O_RDONLY);
+	if (!vf) {
+		return;
+	}
+	char line[ROM_CACHE_NAME_LENGTH + 32];
+	while (vf->readline(vf, line, sizeof(line)) > 0) {
+		struct mRomCacheEntry entry;
+		char* space = strchr(line, ' ');
+		if (!space || space - line >= ROM_CACHE_NAME_LENGTH) {
+			continue;
+		}
+		memcpy(entry.name, line, space - line);
+		entry.name[space - line] = '\0';
+		entry.size = strtoull(&space[1], NULL, 10);
+		*mRomCacheIndexAppend(index) = entry;
+	}
+	vf->close(vf);
+}
+
+static void _romCacheWriteIndex(struct VDir* cache, struct mRomCacheIndex* index) {
+	struct VFile* vf = cache->openFile(cache, ROM_CACHE_INDEX, O_CREAT | O_TRUNC | O_WRONLY);
+	if (!vf) {
+		return;
+	}
+	size_t i;
+	for (i = 0; i < mRomCacheIndexSize(index); ++i) {
+		const struct mRomCacheEntry* entry = mRomCacheIndexGetPointer(index, i);
+		char line[ROM_CACHE_NAME_LENGTH + 32];
+		int length = snprintf(line, sizeof(line), "%s %" PRIu64 "\n", entry->name, entry->size);
+		vf->write(vf, line, length);
+	}
+	vf->close(vf);
+}
+
+// Moves a copy to the front of the index, adding it if need be, then evicts from the back
+static void _romCacheUse(struct mDirectorySet* dirs, const char* name, uint64_t size) {
+	struct mRomCacheIndex index;
+	mRomCacheIndexInit(&index, 8);
+	_romCacheReadIndex(dirs->romCache, &index);
+	size_t i;
+	for (i = 0; i < mRomCacheIndexSize(&index); ++i) {
+		if (!strcmp(mRomCacheIndexGetPointer(&index, i)->name, name)) {
+			mRomCacheIndexShift(&index, i, 1);
+			break;
+		}
+	}
+	mRomCacheIndexUnshift(&index, 0, 1);
+	struct mRomCacheEntry* entry = mRomCacheIndexGetPointer(&index, 0);
+	strncpy(entry->name, name, sizeof(entry->name) - 1);
+	entry->name[sizeof(entry->name) - 1] = '\0';
+	entry->size = size;
+
+	// The copy in use is kept even if it alone is over the limit
+	uint64_t total = 0;
+	for (i = 0; i < mRomCacheIndexSize(&index); ++i) {
+		total += mRomCacheIndexGetPointer(&index, i)->size;
+		if (i && dirs->romCacheLimit && total > dirs->romCacheLimit) {
+			size_t j;
+			for (j = i; j < mRomCacheIndexSize(&index); ++j) {
+				dirs->romCache->deleteFile(dirs->romCache, mRomCacheIndexGetPointer(&index, j)->name);
+			}
+			mRomCacheIndexResize(&index, (ssize_t) i - (ssize_t) mRomCacheIndexSize(&index));
+			break;
+		}
+	}
+	_romCacheWriteIndex(dirs->romCache, &index);
+	mRomCacheIndexDeinit(&index);
+}
+
+static struct VFile* _romCacheOpen(struct mDirectorySet* dirs, const char* name) {
+	struct mRomCacheIndex index;
+	mRomCacheIndexInit(&index, 8);
+	_romCacheReadIndex(dirs->romCache, &index);
+	struct VFile* vf = NULL;
+	size_t i;
+	for (i = 0; i < mRomCacheIndexSize(&index); ++i) {
+		const struct mRomCacheEntry* entry = mRomCacheIndexGetPointer(&index, i);
+		if (strcmp(entry->name, name)) {
+			continue;
+		}
+		vf = dirs->romCache->openFile(dirs->romCache, name, O_RDONLY);
+		if (vf && (uint64_t) vf->size(vf) != entry->size) {
+			vf->close(vf);
+			vf = NULL;
+		}
+		break;
+	}
+	mRomCacheIndexDeinit(&index);
+	return vf;
+}
+
+static struct VFile* _romCacheStore(struct mDirectorySet* dirs, const char* name, struct VFile* file) {
+	struct VFile* vf = dirs->romCache->openFile(dirs->romCache, name, O_CREAT | O_TRUNC | O_RDWR);
+	if (!vf) {
+		return NULL;
+	}
+	uint8_t* buffer = malloc(ROM_CACHE_COPY_CHUNK);
+	ssize_t size = 0;
+	bool success = buffer && file->seek(file, 0, SEEK_SET) == 0;
+	while (success) {
+		ssize_t read = file->read(file, buffer, ROM_CACHE_COPY_CHUNK);
+		if (read <= 0) {
+			success = read == 0;
+			break;
+		}
+		success = vf->write(vf, buffer, read) == read;
+		size += read;
+	}
+	free(buffer);
+	success = success && size == file->size(file) && vf->sync(vf, NULL, 0);
+	vf->close(vf);
+	if (!success) {
+		dirs->romCache->deleteFile(dirs->romCache, name);
+		return NULL;
+	}
+	_romCacheUse(dirs, name, size);
+	return dirs->romCache->openFile(dirs->romCache, name, O_RDONLY);
+}
+
 struct VFile* mDirectorySetOpenPath(struct mDirectorySet* dirs, const char* path, bool (*filter)(struct VFile*)) {
 	dirs->archive = VDirOpenArchive(path);
 	struct VFile* file;
 	if (dirs->archive) {
-		file = VDirFindFirst(dirs->archive, filter);
-		if (!file) {
+		char cacheName[ROM_CACHE_NAME_LENGTH];
+		bool cacheable = dirs->romCache && _romCacheName(path, cacheName);
+		file = NULL;
+		if (cacheable) {
+			file = _romCacheOpen(dirs, cacheName);
+			if (file && !filter(file)) {
+				file->close(file);
+				file = NULL;
+			}
+		}
+		if (file) {
+			_romCacheUse(dirs, cacheName, file->size(file));
 			dirs->archive->close(dirs->archive);
 			dirs->archive = 0;
+		} else {
+			file = VDirFindFirst(dirs->archive, filter);
+			if (!file) {
+				dirs->archive->close(dirs->archive);
+				dirs->archive = 0;
+			} else if (cacheable) {
+				struct VFile* cached = _romCacheStore(dirs, cacheName, file);
+				if (cached) {
+					file->close(file);
+					file = cached;
+				}
+			}
 		}
 	} else {
 		file = VFileOpen(path, O_RDONLY);
@@ -223,6 +407,20 @@ void mDirectorySetMapOptions(struct mDirectorySet* dirs, const struct mCoreOptio
 		}
 	}
 
+	if (opts->romCachePath) {
+		struct VDir* dir = VDirOpen(opts->romCachePath);
+		if (!dir && VDirCreate(opts->romCachePath)) {
+			dir = VDirOpen(opts->romCachePath);
+		}
+		if (dir) {
+			if (dirs->romCache) {
+				dirs->romCache->close(dirs->romCache);
+			}
+			dirs->romCache = dir;
+		}
+	}
+	dirs->romCacheLimit = opts->romCacheSize > 0 ? (size_t) opts->romCacheSize << 20 : 0;
+
 	if (opts->cheatsPath) {
 		struct VDir* dir = VDirOpen(opts->cheatsPath);
 		if (!dir && VDirCreate(opts->cheatsPath)) {
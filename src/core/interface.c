@@ -10,6 +10,135 @@
 
 DEFINE_VECTOR(mCoreCallbacksList, struct mCoreCallbacks);
 
+enum mCoreAccuracy mCoreAccuracyFromName(const char* name) {
+	if (strcasecmp(name, "balanced") == 0) {
+		return mCORE_ACCURACY_BALANCED;
+	}
+	if (strcasecmp(name, "fast") == 0) {
+		return mCORE_ACCURACY_FAST;
+	}
+	return mCORE_ACCURACY_ACCURATE;
+}
+
+static inline unsigned _nativeR8(color_t color) {
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+	unsigned r = color >> 11;
+#else
+	unsigned r = color & 0x1F;
+#endif
+	return (r << 3) | (r >> 2);
+#else
+	return color & 0xFF;
+#endif
+}
+
+static inline unsigned _nativeG8(color_t color) {
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+	unsigned g = (color >> 5) & 0x3F;
+	return (g << 2) | (g >> 4);
+#else
+	unsigned g = (color >> 5) & 0x1F;
+	return (g << 3) | (g >> 2);
+#endif
+#else
+	return (color >> 8) & 0xFF;
+#endif
+}
+
+static inline unsigned _nativeB8(color_t color) {
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+	unsigned b = color & 0x1F;
+#else
+	unsigned b = (color >> 10) & 0x1F;
+#endif
+	return (b << 3) | (b >> 2);
+#else
+	return (color >> 16) & 0xFF;
+#endif
+}
+
+// One kernel per output format, so the packing below gets inlined into the loop
+#define DEFINE_ROW_CONVERTER(FORMAT, TYPE, PACK) \
+	static void _convertRowTo ## FORMAT(void* dst, const color_t* src, size_t count) { \
+		TYPE* out = dst; \
+		size_t i; \
+		for (i = 0; i < count; ++i) { \
+			unsigned r = _nativeR8(src[i]); \
+			unsigned g = _nativeG8(src[i]); \
+			unsigned b = _nativeB8(src[i]); \
+			out[i] = PACK; \
+		} \
+	}
+
+DEFINE_ROW_CONVERTER(XBGR8, uint32_t, r | (g << 8) | (b << 16))
+DEFINE_ROW_CONVERTER(XRGB8, uint32_t, b | (g << 8) | (r << 16))
+DEFINE_ROW_CONVERTER(BGRX8, uint32_t, (r << 8) | (g << 16) | (b << 24))
+DEFINE_ROW_CONVERTER(RGBX8, uint32_t, (b << 8) | (g << 16) | (r << 24))
+DEFINE_ROW_CONVERTER(ABGR8, uint32_t, r | (g << 8) | (b << 16) | 0xFF000000)
+DEFINE_ROW_CONVERTER(ARGB8, uint32_t, b | (g << 8) | (r << 16) | 0xFF000000)
+DEFINE_ROW_CONVERTER(BGRA8, uint32_t, 0xFF | (r << 8) | (g << 16) | (b << 24))
+DEFINE_ROW_CONVERTER(RGBA8, uint32_t, 0xFF | (b << 8) | (g << 16) | (r << 24))
+DEFINE_ROW_CONVERTER(RGB5, uint16_t, (b >> 3) | ((g >> 3) << 5) | ((r >> 3) << 10))
+DEFINE_ROW_CONVERTER(BGR5, uint16_t, (r >> 3) | ((g >> 3) << 5) | ((b >> 3) << 10))
+DEFINE_ROW_CONVERTER(RGB565, uint16_t, (b >> 3) | ((g >> 2) << 5) | ((r >> 3) << 11))
+DEFINE_ROW_CONVERTER(BGR565, uint16_t, (r >> 3) | ((g >> 2) << 5) | ((b >> 3) << 11))
+
+mColorRowConverter mColorGetRowConverter(enum mColorFormat format) {
+	if (format == mCOLOR_NATIVE) {
+		return NULL;
+	}
+	switch (format) {
+	case mCOLOR_XBGR8:
+		return _convertRowToXBGR8;
+	case mCOLOR_XRGB8:
+		return _convertRowToXRGB8;
+	case mCOLOR_BGRX8:
+		return _convertRowToBGRX8;
+	case mCOLOR_RGBX8:
+		return _convertRowToRGBX8;
+	case mCOLOR_ABGR8:
+		return _convertRowToABGR8;
+	case mCOLOR_ARGB8:
+		return _convertRowToARGB8;
+	case mCOLOR_BGRA8:
+		return _convertRowToBGRA8;
+	case mCOLOR_RGBA8:
+		return _convertRowToRGBA8;
+	case mCOLOR_RGB5:
+		return _convertRowToRGB5;
+	case mCOLOR_BGR5:
+		return _convertRowToBGR5;
+	case mCOLOR_RGB565:
+		return _convertRowToRGB565;
+	case mCOLOR_BGR565:
+		return _convertRowToBGR565;
+	default:
+		return NULL;
+	}
+}
+
+unsigned mColorFormatBytes(enum mColorFormat format) {
+	switch (format) {
+	case mCOLOR_RGB8:
+	case mCOLOR_BGR8:
+		return 3;
+	case mCOLOR_RGB5:
+	case mCOLOR_BGR5:
+	case mCOLOR_RGB565:
+	case mCOLOR_BGR565:
+	case mCOLOR_ARGB5:
+	case mCOLOR_ABGR5:
+	case mCOLOR_RGBA5:
+	case mCOLOR_BGRA5:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
 static void _rtcGenericSample(struct mRTCSource* source) {
 	struct mRTCGenericSource* rtc = (struct mRTCGenericSource*) source;
 	switch (rtc->override) {
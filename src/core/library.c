@@ -6,13 +6,21 @@
 #include <mgba/core/library.h>
 
 #include <mgba/core/core.h>
+#include <mgba-util/table.h>
 #include <mgba-util/vfs.h>
 
 #ifdef USE_SQLITE3
 
+#ifndef DISABLE_THREADING
+#include <mgba-util/threading.h>
+#endif
+
 #include <sqlite3.h>
 #include "feature/sqlite3/no-intro.h"
 
+#define LIBRARY_SCAN_THREADS 4
+#define LIBRARY_SCAN_QUEUE 32
+
 DEFINE_VECTOR(mLibraryListing, struct mLibraryEntry);
 
 struct mLibrary {
@@ -24,25 +32,72 @@ struct mLibrary {
 	sqlite3_stmt* selectRoot;
 	sqlite3_stmt* deletePath;
 	sqlite3_stmt* deleteRoot;
+	sqlite3_stmt* selectPaths;
+	sqlite3_stmt* insertStale;
+	sqlite3_stmt* pruneStale;
 	sqlite3_stmt* count;
 	sqlite3_stmt* select;
 	const struct NoIntroDB* gameDB;
 };
 
+#ifndef DISABLE_THREADING
+enum mLibraryScanState {
+	SCAN_EMPTY = 0,
+	SCAN_PENDING,
+	SCAN_WORKING,
+	SCAN_DONE
+};
+
+struct mLibraryScanJob {
+	enum mLibraryScanState state;
+	char* filename;
+	struct VFile* vf;
+	int64_t mtime;
+	bool found;
+	struct mLibraryEntry entry;
+};
+
+// Files are identified and checksummed on worker threads, while the thread
+// walking the directory is also the only one writing to the database
+struct mLibraryScanner {
+	struct mLibrary* library;
+	const char* base;
+	struct mLibraryScanJob jobs[LIBRARY_SCAN_QUEUE];
+	bool done;
+	Mutex mutex;
+	Condition jobCond;
+	Condition resultCond;
+	Thread threads[LIBRARY_SCAN_THREADS];
+	size_t nThreads;
+};
+#endif
+
 #define CONSTRAINTS_ROMONLY \
 	"CASE WHEN :useSize THEN roms.size = :size ELSE 1 END AND " \
 	"CASE WHEN :usePlatform THEN roms.platform = :platform ELSE 1 END AND " \
 	"CASE WHEN :useCrc32 THEN roms.crc32 = :crc32 ELSE 1 END AND " \
 	"CASE WHEN :useInternalCode THEN roms.internalCode = :internalCode ELSE 1 END"
 
+// What a rescan knows about a file from the last time it was scanned
+struct mLibraryKnownPath {
+	int64_t mtime;
+	int64_t size;
+	bool unchanged;
+};
+
 #define CONSTRAINTS \
 	CONSTRAINTS_ROMONLY " AND " \
 	"CASE WHEN :useFilename THEN paths.path = :path ELSE 1 END AND " \
 	"CASE WHEN :useRoot THEN roots.path = :root ELSE 1 END"
 
-static void _mLibraryDeleteEntry(struct mLibrary* library, struct mLibraryEntry* entry);
-static void _mLibraryInsertEntry(struct mLibrary* library, struct mLibraryEntry* entry);
-static void _mLibraryAddEntry(struct mLibrary* library, const char* filename, const char* base, struct VFile* vf);
+static void _mLibraryInsertEntry(struct mLibrary* library, struct mLibraryEntry* entry, int64_t mtime);
+static void _mLibraryAddEntry(struct mLibrary* library, const char* filename, const char* base, struct VFile* vf, int64_t mtime);
+static bool _mLibraryIdentify(struct VFile* vf, struct mLibraryEntry* entry);
+#ifndef DISABLE_THREADING
+static bool _mLibraryScannerStart(struct mLibraryScanner* scanner, struct mLibrary* library, const char* base);
+static void _mLibraryScannerSubmit(struct mLibraryScanner* scanner, const char* filename, struct VFile* vf, int64_t mtime);
+static void _mLibraryScannerFinish(struct mLibraryScanner* scanner);
+#endif
 
 static void _bindConstraints(sqlite3_stmt* statement, const struct mLibraryEntry* constraints) {
 	if (!constraints) {
@@ -138,6 +193,9 @@ struct mLibrary* mLibraryLoad(const char* path) {
 		"\n 	CONSTRAINT location UNIQUE (path, rootid)"
 		"\n );"
 		"\n CREATE INDEX IF NOT EXISTS crc32 ON roms (crc32);"
+		"\n CREATE TEMP TABLE IF NOT EXISTS stale ("
+		"\n 	path TEXT NOT NULL PRIMARY KEY"
+		"\n );"
 		"\n INSERT OR IGNORE INTO version (tname, version) VALUES ('version', 1);"
 		"\n INSERT OR IGNORE INTO version (tname, version) VALUES ('roots', 1);"
 		"\n INSERT OR IGNORE INTO version (tname, version) VALUES ('roms', 1);"
@@ -146,7 +204,7 @@ struct mLibrary* mLibraryLoad(const char* path) {
 		goto error;
 	}
 
-	static const char insertPath[] = "INSERT INTO paths (romid, path, customTitle, rootid) VALUES (?, ?, ?, ?);";
+	static const char insertPath[] = "INSERT INTO paths (romid, path, customTitle, rootid, mtime) VALUES (?, ?, ?, ?, ?);";
 	if (sqlite3_prepare_v2(library->db, insertPath, -1, &library->insertPath, NULL)) {
 		goto error;
 	}
@@ -171,6 +229,21 @@ struct mLibrary* mLibraryLoad(const char* path) {
 		goto error;
 	}
 
+	static const char selectPaths[] = "SELECT paths.path, paths.mtime, roms.size FROM paths JOIN roots USING (rootid) JOIN roms USING (romid) WHERE roots.path = ?;";
+	if (sqlite3_prepare_v2(library->db, selectPaths, -1, &library->selectPaths, NULL)) {
+		goto error;
+	}
+
+	static const char insertStale[] = "INSERT OR IGNORE INTO stale (path) VALUES (?);";
+	if (sqlite3_prepare_v2(library->db, insertStale, -1, &library->insertStale, NULL)) {
+		goto error;
+	}
+
+	static const char pruneStale[] = "DELETE FROM paths WHERE rootid = (SELECT rootid FROM roots WHERE path = ?) AND path IN (SELECT path FROM stale);";
+	if (sqlite3_prepare_v2(library->db, pruneStale, -1, &library->pruneStale, NULL)) {
+		goto error;
+	}
+
 	static const char selectRom[] = "SELECT romid FROM roms WHERE " CONSTRAINTS_ROMONLY ";";
 	if (sqlite3_prepare_v2(library->db, selectRom, -1, &library->selectRom, NULL)) {
 		goto error;
@@ -204,6 +277,9 @@ void mLibraryDestroy(struct mLibrary* library) {
 	sqlite3_finalize(library->insertRoot);
 	sqlite3_finalize(library->deletePath);
 	sqlite3_finalize(library->deleteRoot);
+	sqlite3_finalize(library->selectPaths);
+	sqlite3_finalize(library->insertStale);
+	sqlite3_finalize(library->pruneStale);
 	sqlite3_finalize(library->selectRom);
 	sqlite3_finalize(library->selectRoot);
 	sqlite3_finalize(library->select);
@@ -212,8 +288,21 @@ void mLibraryDestroy(struct mLibrary* library) {
 	free(library);
 }
 
+static void _mLibraryMarkStale(const char* key, void* value, void* user) {
+	struct mLibraryKnownPath* known = value;
+	struct mLibrary* library = user;
+	if (known->unchanged) {
+		return;
+	}
+	sqlite3_clear_bindings(library->insertStale);
+	sqlite3_reset(library->insertStale);
+	sqlite3_bind_text(library->insertStale, 1, key, -1, SQLITE_TRANSIENT);
+	sqlite3_step(library->insertStale);
+}
+
 void mLibraryLoadDirectory(struct mLibrary* library, const char* base) {
 	struct VDir* dir = VDirOpenArchive(base);
+	bool isArchive = dir;
 	if (!dir) {
 		dir = VDirOpen(base);
 	}
@@ -227,68 +316,267 @@ void mLibraryLoadDirectory(struct mLibrary* library, const char* base) {
 		return;
 	}
 
-	struct mLibraryEntry entry;
-	memset(&entry, 0, sizeof(entry));
-	entry.base = base;
-	struct mLibraryListing entries;
-	mLibraryListingInit(&entries, 0);
-	mLibraryGetEntries(library, &entries, 0, 0, &entry);
-	size_t i;
-	for (i = 0; i < mLibraryListingSize(&entries); ++i) {
-		struct mLibraryEntry* current = mLibraryListingGetPointer(&entries, i);
-		struct VFile* vf = dir->openFile(dir, current->filename, O_RDONLY);
-		_mLibraryDeleteEntry(library, current);
-		if (!vf) {
-			continue;
+	// Files in an archive have no dates of their own, so they all take the archive's and
+	// can only have changed if it did
+	int64_t archiveMtime = 0;
+	if (isArchive) {
+		struct VFile* archive = VFileOpen(base, O_RDONLY);
+		if (archive) {
+			archiveMtime = VFileModificationTime(archive);
+			archive->close(archive);
 		}
-		_mLibraryAddEntry(library, current->filename, base, vf);
 	}
-	mLibraryListingDeinit(&entries);
 
-	dir->rewind(dir);
+	struct Table known;
+	HashTableInit(&known, 0, free);
+	sqlite3_reset(library->selectPaths);
+	sqlite3_bind_text(library->selectPaths, 1, base, -1, SQLITE_TRANSIENT);
+	while (sqlite3_step(library->selectPaths) == SQLITE_ROW) {
+		struct mLibraryKnownPath* path = malloc(sizeof(*path));
+		path->mtime = sqlite3_column_int64(library->selectPaths, 1);
+		path->size = sqlite3_column_int64(library->selectPaths, 2);
+		path->unchanged = false;
+		HashTableInsert(&known, (const char*) sqlite3_column_text(library->selectPaths, 0), path);
+	}
+	sqlite3_reset(library->selectPaths);
+
+	// Files whose size and date match the last scan are left alone without being read;
+	// the rest are identified again once the stale rows are gone
+	struct StringList pending;
+	StringListInit(&pending, 0);
 	struct VDirEntry* dirent = dir->listNext(dir);
 	while (dirent) {
-		struct VFile* vf = dir->openFile(dir, dirent->name(dirent), O_RDONLY);
-		if (!vf) {
-			dirent = dir->listNext(dir);
-			continue;
+		const char* name = dirent->name(dirent);
+		struct mLibraryKnownPath* path = HashTableLookup(&known, name);
+		if (path && path->mtime && isArchive) {
+			path->unchanged = path->mtime == archiveMtime;
+		} else if (path && path->mtime) {
+			struct VFile* vf = dir->openFile(dir, name, O_RDONLY);
+			if (vf) {
+				path->unchanged = VFileModificationTime(vf) == path->mtime && vf->size(vf) == path->size;
+				vf->close(vf);
+			}
+		}
+		if (!path || !path->unchanged) {
+			*StringListAppend(&pending) = strdup(name);
 		}
-		_mLibraryAddEntry(library, dirent->name(dirent), base, vf);
 		dirent = dir->listNext(dir);
 	}
+
+	HashTableEnumerate(&known, _mLibraryMarkStale, library);
+	HashTableDeinit(&known);
+	sqlite3_reset(library->pruneStale);
+	sqlite3_bind_text(library->pruneStale, 1, base, -1, SQLITE_TRANSIENT);
+	sqlite3_step(library->pruneStale);
+	sqlite3_reset(library->pruneStale);
+	sqlite3_exec(library->db, "DELETE FROM stale;", NULL, NULL, NULL);
+
+#ifndef DISABLE_THREADING
+	// Files in an archive share its state, so only plain directories are scanned in parallel
+	struct mLibraryScanner scanner;
+	bool threaded = !isArchive && StringListSize(&pending) > 1 && _mLibraryScannerStart(&scanner, library, base);
+#endif
+
+	size_t i;
+	for (i = 0; i < StringListSize(&pending); ++i) {
+		char* name = *StringListGetPointer(&pending, i);
+		struct VFile* vf = dir->openFile(dir, name, O_RDONLY);
+		if (vf) {
+			int64_t mtime = isArchive ? archiveMtime : VFileModificationTime(vf);
+#ifndef DISABLE_THREADING
+			if (threaded) {
+				_mLibraryScannerSubmit(&scanner, name, vf, mtime);
+			} else {
+				_mLibraryAddEntry(library, name, base, vf, mtime);
+			}
+#else
+			_mLibraryAddEntry(library, name, base, vf, mtime);
+#endif
+		}
+		free(name);
+	}
+	StringListDeinit(&pending);
+#ifndef DISABLE_THREADING
+	if (threaded) {
+		_mLibraryScannerFinish(&scanner);
+	}
+#endif
 	dir->close(dir);
 	sqlite3_exec(library->db, "COMMIT;", NULL, NULL, NULL);
 }
 
-void _mLibraryAddEntry(struct mLibrary* library, const char* filename, const char* base, struct VFile* vf) {
-	struct mCore* core;
-	if (!vf) {
+void _mLibraryAddEntry(struct mLibrary* library, const char* filename, const char* base, struct VFile* vf, int64_t mtime) {
+	struct mLibraryEntry entry;
+	if (!vf || !_mLibraryIdentify(vf, &entry)) {
 		return;
 	}
-	core = mCoreFindVF(vf);
-	if (core) {
-		struct mLibraryEntry entry;
-		memset(&entry, 0, sizeof(entry));
-		core->init(core);
-		core->loadROM(core, vf);
-
-		core->getGameTitle(core, entry.internalTitle);
-		core->getGameCode(core, entry.internalCode);
-		core->checksum(core, &entry.crc32, CHECKSUM_CRC32);
-		entry.platform = core->platform(core);
-		entry.title = NULL;
-		entry.base = base;
-		entry.filename = filename;
-		entry.filesize = vf->size(vf);
-		_mLibraryInsertEntry(library, &entry);
-		// Note: this destroys the VFile
-		core->deinit(core);
-	} else {
+	entry.base = base;
+	entry.filename = filename;
+	_mLibraryInsertEntry(library, &entry, mtime);
+}
+
+// Fills in everything but the base and filename; this closes the VFile
+static bool _mLibraryIdentify(struct VFile* vf, struct mLibraryEntry* entry) {
+	struct mCoreROMInfo info;
+	if (mCoreIdentifyVF(vf, &info)) {
+		memset(entry, 0, sizeof(*entry));
+		memcpy(entry->internalTitle, info.title, sizeof(entry->internalTitle));
+		memcpy(entry->internalCode, info.code, sizeof(entry->internalCode));
+		entry->crc32 = info.crc32;
+		entry->platform = info.platform;
+		entry->filesize = info.size;
+		vf->close(vf);
+		return true;
+	}
+
+	struct mCore* core = mCoreFindVF(vf);
+	if (!core) {
 		vf->close(vf);
+		return false;
+	}
+	memset(entry, 0, sizeof(*entry));
+	core->init(core);
+	core->loadROM(core, vf);
+
+	core->getGameTitle(core, entry->internalTitle);
+	core->getGameCode(core, entry->internalCode);
+	core->checksum(core, &entry->crc32, CHECKSUM_CRC32);
+	entry->platform = core->platform(core);
+	entry->title = NULL;
+	entry->filesize = vf->size(vf);
+	// Note: this destroys the VFile
+	core->deinit(core);
+	return true;
+}
+
+#ifndef DISABLE_THREADING
+static struct mLibraryScanJob* _mLibraryScannerFindJob(struct mLibraryScanner* scanner, enum mLibraryScanState state) {
+	size_t i;
+	for (i = 0; i < LIBRARY_SCAN_QUEUE; ++i) {
+		if (scanner->jobs[i].state == state) {
+			return &scanner->jobs[i];
+		}
+	}
+	return NULL;
+}
+
+static THREAD_ENTRY _mLibraryScannerThread(void* context) {
+	struct mLibraryScanner* scanner = context;
+	ThreadSetName("Library Scanner");
+	MutexLock(&scanner->mutex);
+	while (true) {
+		struct mLibraryScanJob* job = _mLibraryScannerFindJob(scanner, SCAN_PENDING);
+		if (!job) {
+			if (scanner->done) {
+				break;
+			}
+			ConditionWait(&scanner->jobCond, &scanner->mutex);
+			continue;
+		}
+		job->state = SCAN_WORKING;
+		MutexUnlock(&scanner->mutex);
+
+		job->found = _mLibraryIdentify(job->vf, &job->entry);
+		job->vf = NULL;
+
+		MutexLock(&scanner->mutex);
+		job->state = SCAN_DONE;
+		ConditionWake(&scanner->resultCond);
+	}
+	MutexUnlock(&scanner->mutex);
+	return 0;
+}
+
+static bool _mLibraryScannerStart(struct mLibraryScanner* scanner, struct mLibrary* library, const char* base) {
+	memset(scanner->jobs, 0, sizeof(scanner->jobs));
+	scanner->library = library;
+	scanner->base = base;
+	scanner->done = false;
+	MutexInit(&scanner->mutex);
+	ConditionInit(&scanner->jobCond);
+	ConditionInit(&scanner->resultCond);
+	for (scanner->nThreads = 0; scanner->nThreads < LIBRARY_SCAN_THREADS; ++scanner->nThreads) {
+		if (ThreadCreate(&scanner->threads[scanner->nThreads], _mLibraryScannerThread, scanner)) {
+			break;
+		}
 	}
+	if (!scanner->nThreads) {
+		MutexDeinit(&scanner->mutex);
+		ConditionDeinit(&scanner->jobCond);
+		ConditionDeinit(&scanner->resultCond);
+		return false;
+	}
+	return true;
+}
+
+// Must be called with the mutex held; returns false if no jobs were finished
+static bool _mLibraryScannerCollect(struct mLibraryScanner* scanner) {
+	bool collected = false;
+	size_t i;
+	for (i = 0; i < LIBRARY_SCAN_QUEUE; ++i) {
+		struct mLibraryScanJob* job = &scanner->jobs[i];
+		if (job->state != SCAN_DONE) {
+			continue;
+		}
+		if (job->found) {
+			job->entry.base = scanner->base;
+			job->entry.filename = job->filename;
+			_mLibraryInsertEntry(scanner->library, &job->entry, job->mtime);
+		}
+		free(job->filename);
+		job->filename = NULL;
+		job->state = SCAN_EMPTY;
+		collected = true;
+	}
+	return collected;
+}
+
+static void _mLibraryScannerSubmit(struct mLibraryScanner* scanner, const char* filename, struct VFile* vf, int64_t mtime) {
+	MutexLock(&scanner->mutex);
+	struct mLibraryScanJob* job;
+	while (!(job = _mLibraryScannerFindJob(scanner, SCAN_EMPTY))) {
+		if (!_mLibraryScannerCollect(scanner)) {
+			ConditionWait(&scanner->resultCond, &scanner->mutex);
+		}
+	}
+	job->filename = strdup(filename);
+	job->vf = vf;
+	job->mtime = mtime;
+	job->state = SCAN_PENDING;
+	ConditionWake(&scanner->jobCond);
+	MutexUnlock(&scanner->mutex);
+}
+
+static void _mLibraryScannerFinish(struct mLibraryScanner* scanner) {
+	MutexLock(&scanner->mutex);
+	while (true) {
+		_mLibraryScannerCollect(scanner);
+		size_t i;
+		for (i = 0; i < LIBRARY_SCAN_QUEUE; ++i) {
+			if (scanner->jobs[i].state != SCAN_EMPTY) {
+				break;
+			}
+		}
+		if (i == LIBRARY_SCAN_QUEUE) {
+			break;
+		}
+		ConditionWait(&scanner->resultCond, &scanner->mutex);
+	}
+	scanner->done = true;
+	ConditionWake(&scanner->jobCond);
+	MutexUnlock(&scanner->mutex);
+
+	size_t i;
+	for (i = 0; i < scanner->nThreads; ++i) {
+		ThreadJoin(&scanner->threads[i]);
+	}
+	MutexDeinit(&scanner->mutex);
+	ConditionDeinit(&scanner->jobCond);
+	ConditionDeinit(&scanner->resultCond);
 }
+#endif
 
-static void _mLibraryInsertEntry(struct mLibrary* library, struct mLibraryEntry* entry) {
+static void _mLibraryInsertEntry(struct mLibrary* library, struct mLibraryEntry* entry, int64_t mtime) {
 	sqlite3_clear_bindings(library->selectRom);
 	sqlite3_reset(library->selectRom);
 	struct mLibraryEntry constraints = *entry;
@@ -330,13 +618,7 @@ static void _mLibraryInsertEntry(struct mLibrary* library, struct mLibraryEntry*
 	if (rootId > 0) {
 		sqlite3_bind_int64(library->insertPath, 4, rootId);
 	}
-	sqlite3_step(library->insertPath);
-}
-
-static void _mLibraryDeleteEntry(struct mLibrary* library, struct mLibraryEntry* entry) {
-	sqlite3_clear_bindings(library->deletePath);
-	sqlite3_reset(library->deletePath);
-	sqlite3_bind_text(library->deletePath, 1, entry->filename, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int64(library->insertPath, 5, mtime);
 	sqlite3_step(library->insertPath);
 }
 
@@ -0,0 +1,54 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/log-buffer.h>
+
+void mLogBufferInit(struct mLogBuffer* buffer, size_t entries) {
+	memset(buffer, 0, sizeof(*buffer));
+	// Entries never straddle the end of the ring, so one extra keeps all of the requested ones usable
+	RingFIFOInit(&buffer->fifo, (entries + 1) * sizeof(struct mLogBufferEntry));
+}
+
+void mLogBufferDeinit(struct mLogBuffer* buffer) {
+	RingFIFODeinit(&buffer->fifo);
+}
+
+void mLogBufferPost(struct mLogBuffer* buffer, int category, enum mLogLevel level, const char* format, va_list args) {
+	char message[mLOG_BUFFER_MESSAGE_SIZE];
+	vsnprintf(message, sizeof(message), format, args);
+	if (buffer->hasHeld && buffer->held.category == category && buffer->held.level == (int32_t) level && strcmp(buffer->held.message, message) == 0) {
+		++buffer->held.repeats;
+		return;
+	}
+	mLogBufferCommit(buffer);
+	buffer->held.category = category;
+	buffer->held.level = level;
+	buffer->held.repeats = 1;
+	memcpy(buffer->held.message, message, sizeof(message));
+	buffer->hasHeld = true;
+}
+
+void mLogBufferCommit(struct mLogBuffer* buffer) {
+	if (!buffer->hasHeld) {
+		return;
+	}
+	buffer->hasHeld = false;
+	if (!RingFIFOWrite(&buffer->fifo, &buffer->held, sizeof(buffer->held))) {
+		ATOMIC_ADD(buffer->dropped, buffer->held.repeats);
+	}
+}
+
+bool mLogBufferRead(struct mLogBuffer* buffer, struct mLogBufferEntry* entry) {
+	return RingFIFORead(&buffer->fifo, entry, sizeof(*entry)) == sizeof(*entry);
+}
+
+int mLogBufferTakeDropped(struct mLogBuffer* buffer) {
+	int dropped;
+	ATOMIC_LOAD(dropped, buffer->dropped);
+	if (dropped) {
+		ATOMIC_SUB(buffer->dropped, dropped);
+	}
+	return dropped;
+}
@@ -7,11 +7,22 @@
 
 #include <mgba/core/config.h>
 #include <mgba/core/thread.h>
+#include <mgba-util/threading.h>
 
-#define MAX_CATEGORY 64
+#define MAX_CATEGORY mLOG_MAX_CATEGORY
 
 static struct mLogger* _defaultLogger = NULL;
 
+int mLogDisabledLevels[mLOG_MAX_CATEGORY];
+
+// Every initialized filter, so the disabled levels can be worked out across all of them
+static struct mLogFilter* _filters = NULL;
+static Mutex _filtersMutex;
+
+CONSTRUCTOR(_mLogFiltersInit) {
+	MutexInit(&_filtersMutex);
+}
+
 struct mLogger* mLogGetContext(void) {
 	struct mLogger* logger = NULL;
 #ifndef DISABLE_THREADING
@@ -31,12 +42,44 @@ static int _category = 0;
 static const char* _categoryNames[MAX_CATEGORY];
 static const char* _categoryIds[MAX_CATEGORY];
 
+static int _filterCategoryLevels(const struct mLogFilter* filter, int category) {
+	int value = mLogFilterLevels(filter, category);
+	if (value) {
+		return value & mLOG_ALL;
+	}
+	return filter->defaultLevels & mLOG_ALL;
+}
+
+static void _updateDisabledLevels(int category) {
+	if (category >= MAX_CATEGORY) {
+		return;
+	}
+	int enabled = _filters ? 0 : mLOG_ALL;
+	const struct mLogFilter* filter;
+	for (filter = _filters; filter; filter = filter->next) {
+		enabled |= _filterCategoryLevels(filter, category);
+	}
+	mLogDisabledLevels[category] = mLOG_ALL & ~enabled;
+}
+
+static void _updateAllDisabledLevels(void) {
+	MutexLock(&_filtersMutex);
+	int i;
+	for (i = 0; i < _category && i < MAX_CATEGORY; ++i) {
+		_updateDisabledLevels(i);
+	}
+	MutexUnlock(&_filtersMutex);
+}
+
 int mLogGenerateCategory(const char* name, const char* id) {
 	if (_category < MAX_CATEGORY) {
 		_categoryNames[_category] = name;
 		_categoryIds[_category] = id;
 	}
 	++_category;
+	// Categories are generated by constructors, before the mutex is necessarily initialized,
+	// and before there are any other threads to race with
+	_updateDisabledLevels(_category - 1);
 	return _category - 1;
 }
 
@@ -83,9 +126,25 @@ void mLog(int category, enum mLogLevel level, const char* format, ...) {
 void mLogFilterInit(struct mLogFilter* filter) {
 	HashTableInit(&filter->categories, 8, NULL);
 	TableInit(&filter->levels, 8, NULL);
+	filter->defaultLevels = mLOG_ALL;
+	MutexLock(&_filtersMutex);
+	filter->next = _filters;
+	_filters = filter;
+	MutexUnlock(&_filtersMutex);
+	_updateAllDisabledLevels();
 }
 
 void mLogFilterDeinit(struct mLogFilter* filter) {
+	MutexLock(&_filtersMutex);
+	struct mLogFilter** link;
+	for (link = &_filters; *link; link = &(*link)->next) {
+		if (*link == filter) {
+			*link = filter->next;
+			break;
+		}
+	}
+	MutexUnlock(&_filtersMutex);
+	_updateAllDisabledLevels();
 	HashTableDeinit(&filter->categories);
 	TableDeinit(&filter->levels);
 }
@@ -119,6 +178,7 @@ void mLogFilterLoad(struct mLogFilter* filter, const struct mCoreConfig* config)
 	mCoreConfigEnumerate(config, "logLevel.", _setFilterLevel, filter);
 	filter->defaultLevels = mLOG_ALL;
 	mCoreConfigGetIntValue(config, "logLevel", &filter->defaultLevels);
+	_updateAllDisabledLevels();
 }
 
 void mLogFilterSave(const struct mLogFilter* filter, struct mCoreConfig* config) {
@@ -136,6 +196,11 @@ void mLogFilterSave(const struct mLogFilter* filter, struct mCoreConfig* config)
 	}
 }
 
+void mLogFilterSetDefaultLevels(struct mLogFilter* filter, int levels) {
+	filter->defaultLevels = levels;
+	_updateAllDisabledLevels();
+}
+
 void mLogFilterSet(struct mLogFilter* filter, const char* category, int levels) {
 	levels |= 0x80;
 	HashTableInsert(&filter->categories, category, (void*)(intptr_t) levels);
@@ -144,6 +209,7 @@ void mLogFilterSet(struct mLogFilter* filter, const char* category, int levels)
 	if (cat >= 0) {
 		TableInsert(&filter->levels, cat, (void*)(intptr_t) levels);
 	}
+	_updateAllDisabledLevels();
 }
 
 void mLogFilterReset(struct mLogFilter* filter, const char* category) {
@@ -153,6 +219,7 @@ void mLogFilterReset(struct mLogFilter* filter, const char* category) {
 	if (cat >= 0) {
 		TableRemove(&filter->levels, cat);
 	}
+	_updateAllDisabledLevels();
 }
 
 bool mLogFilterTest(const struct mLogFilter* filter, int category, enum mLogLevel level) {
@@ -7,8 +7,18 @@
 
 #include <mgba/core/core.h>
 #include <mgba/core/interface.h>
+#include <mgba-util/math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define SEARCH_CHUNK 16
 
 DEFINE_VECTOR(mCoreMemorySearchResults, struct mCoreMemorySearchResult);
+DEFINE_VECTOR(mCoreMemorySearchSnapshotBlocks, struct mCoreMemorySearchSnapshotBlock);
 
 static bool _op(int32_t value, int32_t match, enum mCoreMemorySearchOp op) {
 	switch (op) {
@@ -31,68 +41,165 @@ static bool _op(int32_t value, int32_t match, enum mCoreMemorySearchOp op) {
 	return false;
 }
 
-static size_t _search32(const void* mem, size_t size, const struct mCoreMemoryBlock* block, uint32_t value32, enum mCoreMemorySearchOp op, struct mCoreMemorySearchResults* out, size_t limit) {
-	const uint32_t* mem32 = mem;
-	size_t found = 0;
-	uint32_t start = block->start;
-	uint32_t end = size; // TODO: Segments
-	size_t i;
-	// TODO: Big endian
-	for (i = 0; (!limit || found < limit) && i < end; i += 4) {
-		if (_op(mem32[i >> 2], value32, op)) {
-			struct mCoreMemorySearchResult* res = mCoreMemorySearchResultsAppend(out);
-			res->address = start + i;
-			res->type = mCORE_MEMORY_SEARCH_INT;
-			res->width = 4;
-			res->segment = -1; // TODO
-			res->guessDivisor = 1;
-			res->guessMultiplier = 1;
-			res->oldValue = value32;
-			++found;
-		}
+static int32_t _load(const uint8_t* mem, size_t offset, int width) {
+	uint16_t value16;
+	int32_t value32;
+	switch (width) {
+	case 1:
+		return mem[offset];
+	case 2:
+		LOAD_16LE(value16, offset, mem);
+		return value16;
+	case 4:
+		LOAD_32LE(value32, offset, mem);
+		return value32;
 	}
-	return found;
+	return 0;
 }
 
-static size_t _search16(const void* mem, size_t size, const struct mCoreMemoryBlock* block, uint16_t value16, enum mCoreMemorySearchOp op, struct mCoreMemorySearchResults* out, size_t limit) {
-	const uint16_t* mem16 = mem;
-	size_t found = 0;
-	uint32_t start = block->start;
-	uint32_t end = size; // TODO: Segments
-	size_t i;
-	// TODO: Big endian
-	for (i = 0; (!limit || found < limit) && i < end; i += 2) {
-		if (_op(mem16[i >> 1], value16, op)) {
-			struct mCoreMemorySearchResult* res = mCoreMemorySearchResultsAppend(out);
-			res->address = start + i;
-			res->type = mCORE_MEMORY_SEARCH_INT;
-			res->width = 2;
-			res->segment = -1; // TODO
-			res->guessDivisor = 1;
-			res->guessMultiplier = 1;
-			res->oldValue = value16;
-			++found;
+static int32_t _truncate(int32_t value, int width) {
+	switch (width) {
+	case 1:
+		return (uint8_t) value;
+	case 2:
+		return (uint16_t) value;
+	}
+	return value;
+}
+
+static inline unsigned _lowestBit(uint32_t bits) {
+	return 31 - clz32(bits & -bits);
+}
+
+// Returns one bit per value in the SEARCH_CHUNK bytes at mem, set if the value matches
+static uint32_t _matchChunk(const uint8_t* mem, int width, int32_t match, enum mCoreMemorySearchOp op) {
+#if defined(__SSE2__)
+	if (op == mCORE_MEMORY_SEARCH_EQUAL || op == mCORE_MEMORY_SEARCH_GREATER || op == mCORE_MEMORY_SEARCH_LESS) {
+		// Narrower values are unsigned, but SSE2 only compares signed lanes, so both sides are biased
+		__m128i values = _mm_loadu_si128((const __m128i*) mem);
+		__m128i matches;
+		__m128i bias;
+		switch (width) {
+		case 1:
+			bias = _mm_set1_epi8((char) 0x80);
+			matches = _mm_xor_si128(_mm_set1_epi8(match), bias);
+			values = _mm_xor_si128(values, bias);
+			if (op == mCORE_MEMORY_SEARCH_EQUAL) {
+				return _mm_movemask_epi8(_mm_cmpeq_epi8(values, matches));
+			}
+			if (op == mCORE_MEMORY_SEARCH_GREATER) {
+				return _mm_movemask_epi8(_mm_cmpgt_epi8(values, matches));
+			}
+			return _mm_movemask_epi8(_mm_cmplt_epi8(values, matches));
+		case 2:
+			bias = _mm_set1_epi16((short) 0x8000);
+			matches = _mm_xor_si128(_mm_set1_epi16(match), bias);
+			values = _mm_xor_si128(values, bias);
+			if (op == mCORE_MEMORY_SEARCH_EQUAL) {
+				values = _mm_cmpeq_epi16(values, matches);
+			} else if (op == mCORE_MEMORY_SEARCH_GREATER) {
+				values = _mm_cmpgt_epi16(values, matches);
+			} else {
+				values = _mm_cmplt_epi16(values, matches);
+			}
+			return _mm_movemask_epi8(_mm_packs_epi16(values, _mm_setzero_si128()));
+		case 4:
+			matches = _mm_set1_epi32(match);
+			if (op == mCORE_MEMORY_SEARCH_EQUAL) {
+				values = _mm_cmpeq_epi32(values, matches);
+			} else if (op == mCORE_MEMORY_SEARCH_GREATER) {
+				values = _mm_cmpgt_epi32(values, matches);
+			} else {
+				values = _mm_cmplt_epi32(values, matches);
+			}
+			return _mm_movemask_ps(_mm_castsi128_ps(values));
 		}
 	}
-	return found;
+#elif defined(__ARM_NEON)
+	if (op == mCORE_MEMORY_SEARCH_EQUAL || op == mCORE_MEMORY_SEARCH_GREATER || op == mCORE_MEMORY_SEARCH_LESS) {
+		static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+		uint8x16_t bytes;
+		uint16x8_t halves;
+		uint32x4_t words;
+		uint8x8_t bits;
+		switch (width) {
+		case 1:
+			if (op == mCORE_MEMORY_SEARCH_EQUAL) {
+				bytes = vceqq_u8(vld1q_u8(mem), vdupq_n_u8(match));
+			} else if (op == mCORE_MEMORY_SEARCH_GREATER) {
+				bytes = vcgtq_u8(vld1q_u8(mem), vdupq_n_u8(match));
+			} else {
+				bytes = vcltq_u8(vld1q_u8(mem), vdupq_n_u8(match));
+			}
+			bytes = vandq_u8(bytes, vld1q_u8(weights));
+			bits = vpadd_u8(vget_low_u8(bytes), vget_high_u8(bytes));
+			bits = vpadd_u8(bits, bits);
+			bits = vpadd_u8(bits, bits);
+			return vget_lane_u8(bits, 0) | (vget_lane_u8(bits, 1) << 8);
+		case 2:
+			if (op == mCORE_MEMORY_SEARCH_EQUAL) {
+				halves = vceqq_u16(vld1q_u16((const uint16_t*) mem), vdupq_n_u16(match));
+			} else if (op == mCORE_MEMORY_SEARCH_GREATER) {
+				halves = vcgtq_u16(vld1q_u16((const uint16_t*) mem), vdupq_n_u16(match));
+			} else {
+				halves = vcltq_u16(vld1q_u16((const uint16_t*) mem), vdupq_n_u16(match));
+			}
+			bits = vand_u8(vmovn_u16(halves), vld1_u8(weights));
+			bits = vpadd_u8(bits, bits);
+			bits = vpadd_u8(bits, bits);
+			bits = vpadd_u8(bits, bits);
+			return vget_lane_u8(bits, 0);
+		case 4:
+			if (op == mCORE_MEMORY_SEARCH_EQUAL) {
+				words = vceqq_s32(vld1q_s32((const int32_t*) mem), vdupq_n_s32(match));
+			} else if (op == mCORE_MEMORY_SEARCH_GREATER) {
+				words = vcgtq_s32(vld1q_s32((const int32_t*) mem), vdupq_n_s32(match));
+			} else {
+				words = vcltq_s32(vld1q_s32((const int32_t*) mem), vdupq_n_s32(match));
+			}
+			return (vgetq_lane_u32(words, 0) & 1) | (vgetq_lane_u32(words, 1) & 2) | (vgetq_lane_u32(words, 2) & 4) | (vgetq_lane_u32(words, 3) & 8);
+		}
+	}
+#endif
+	uint32_t mask = 0;
+	int i;
+	for (i = 0; i < SEARCH_CHUNK / width; ++i) {
+		if (_op(_load(mem, i * width, width), match, op)) {
+			mask |= 1U << i;
+		}
+	}
+	return mask;
+}
+
+static void _appendInt(struct mCoreMemorySearchResults* out, uint32_t address, int width, int32_t value) {
+	struct mCoreMemorySearchResult* res = mCoreMemorySearchResultsAppend(out);
+	res->address = address;
+	res->type = mCORE_MEMORY_SEARCH_INT;
+	res->width = width;
+	res->segment = -1; // TODO
+	res->guessDivisor = 1;
+	res->guessMultiplier = 1;
+	res->oldValue = value;
 }
 
-static size_t _search8(const void* mem, size_t size, const struct mCoreMemoryBlock* block, uint8_t value8, enum mCoreMemorySearchOp op, struct mCoreMemorySearchResults* out, size_t limit) {
-	const uint8_t* mem8 = mem;
+static size_t _searchWidth(const uint8_t* mem, size_t size, const struct mCoreMemoryBlock* block, int width, int32_t match, enum mCoreMemorySearchOp op, struct mCoreMemorySearchResults* out, size_t limit) {
 	size_t found = 0;
 	uint32_t start = block->start;
-	uint32_t end = size; // TODO: Segments
+	size_t end = size; // TODO: Segments
 	size_t i;
-	for (i = 0; (!limit || found < limit) && i < end; ++i) {
-		if (_op(mem8[i], value8, op)) {
-			struct mCoreMemorySearchResult* res = mCoreMemorySearchResultsAppend(out);
-			res->address = start + i;
-			res->type = mCORE_MEMORY_SEARCH_INT;
-			res->width = 1;
-			res->segment = -1; // TODO
-			res->guessDivisor = 1;
-			res->guessMultiplier = 1;
-			res->oldValue = value8;
+	match = _truncate(match, width);
+	for (i = 0; (!limit || found < limit) && i + SEARCH_CHUNK <= end; i += SEARCH_CHUNK) {
+		uint32_t mask = _matchChunk(&mem[i], width, match, op);
+		for (; mask && (!limit || found < limit); mask &= mask - 1) {
+			size_t offset = i + _lowestBit(mask) * width;
+			_appendInt(out, start + offset, width, _load(mem, offset, width));
+			++found;
+		}
+	}
+	for (; (!limit || found < limit) && i + width <= end; i += width) {
+		int32_t value = _load(mem, i, width);
+		if (_op(value, match, op)) {
+			_appendInt(out, start + i, width, value);
 			++found;
 		}
 	}
@@ -103,11 +210,11 @@ static size_t _searchInt(const void* mem, size_t size, const struct mCoreMemoryB
 	if (params->align == params->width || params->align == -1) {
 		switch (params->width) {
 		case 4:
-			return _search32(mem, size, block, params->valueInt, params->op, out, limit);
+			return _searchWidth(mem, size, block, 4, params->valueInt, params->op, out, limit);
 		case 2:
-			return _search16(mem, size, block, params->valueInt, params->op, out, limit);
+			return _searchWidth(mem, size, block, 2, params->valueInt, params->op, out, limit);
 		case 1:
-			return _search8(mem, size, block, params->valueInt, params->op, out, limit);
+			return _searchWidth(mem, size, block, 1, params->valueInt, params->op, out, limit);
 		}
 	}
 	return 0;
@@ -147,11 +254,11 @@ static size_t _searchGuess(const void* mem, size_t size, const struct mCoreMemor
 	value = strtoll(params->valueStr, &end, 10);
 	if (end && !end[0]) {
 		if ((params->width == -1 && value > 0x10000) || params->width == 4) {
-			found += _search32(mem, size, block, value, params->op, out, limit ? limit - found : 0);
+			found += _searchWidth(mem, size, block, 4, value, params->op, out, limit ? limit - found : 0);
 		} else if ((params->width == -1 && value > 0x100) || params->width == 2) {
-			found += _search16(mem, size, block, value, params->op, out, limit ? limit - found : 0);
+			found += _searchWidth(mem, size, block, 2, value, params->op, out, limit ? limit - found : 0);
 		} else {
-			found += _search8(mem, size, block, value, params->op, out, limit ? limit - found : 0);
+			found += _searchWidth(mem, size, block, 1, value, params->op, out, limit ? limit - found : 0);
 		}
 
 		uint32_t divisor = 1;
@@ -161,11 +268,11 @@ static size_t _searchGuess(const void* mem, size_t size, const struct mCoreMemor
 			divisor *= 10;
 
 			if ((params->width == -1 && value > 0x10000) || params->width == 4) {
-				found += _search32(mem, size, block, value, params->op, &tmp, limit ? limit - found : 0);
+				found += _searchWidth(mem, size, block, 4, value, params->op, &tmp, limit ? limit - found : 0);
 			} else if ((params->width == -1 && value > 0x100) || params->width == 2) {
-				found += _search16(mem, size, block, value, params->op, &tmp, limit ? limit - found : 0);
+				found += _searchWidth(mem, size, block, 2, value, params->op, &tmp, limit ? limit - found : 0);
 			} else {
-				found += _search8(mem, size, block, value, params->op, &tmp, limit ? limit - found : 0);
+				found += _searchWidth(mem, size, block, 1, value, params->op, &tmp, limit ? limit - found : 0);
 			}
 			size_t i;
 			for (i = 0; i < mCoreMemorySearchResultsSize(&tmp); ++i) {
@@ -180,11 +287,11 @@ static size_t _searchGuess(const void* mem, size_t size, const struct mCoreMemor
 	value = strtoll(params->valueStr, &end, 16);
 	if (end && !end[0]) {
 		if ((params->width == -1 && value > 0x10000) || params->width == 4) {
-			found += _search32(mem, size, block, value, params->op, out, limit ? limit - found : 0);
+			found += _searchWidth(mem, size, block, 4, value, params->op, out, limit ? limit - found : 0);
 		} else if ((params->width == -1 && value > 0x100) || params->width == 2) {
-			found += _search16(mem, size, block, value, params->op, out, limit ? limit - found : 0);
+			found += _searchWidth(mem, size, block, 2, value, params->op, out, limit ? limit - found : 0);
 		} else {
-			found += _search8(mem, size, block, value, params->op, out, limit ? limit - found : 0);
+			found += _searchWidth(mem, size, block, 1, value, params->op, out, limit ? limit - found : 0);
 		}
 
 		uint32_t divisor = 1;
@@ -194,11 +301,11 @@ static size_t _searchGuess(const void* mem, size_t size, const struct mCoreMemor
 			divisor <<= 4;
 
 			if ((params->width == -1 && value > 0x10000) || params->width == 4) {
-				found += _search32(mem, size, block, value, params->op, &tmp, limit ? limit - found : 0);
+				found += _searchWidth(mem, size, block, 4, value, params->op, &tmp, limit ? limit - found : 0);
 			} else if ((params->width == -1 && value > 0x100) || params->width == 2) {
-				found += _search16(mem, size, block, value, params->op, &tmp, limit ? limit - found : 0);
+				found += _searchWidth(mem, size, block, 2, value, params->op, &tmp, limit ? limit - found : 0);
 			} else {
-				found += _search8(mem, size, block, value, params->op, &tmp, limit ? limit - found : 0);
+				found += _searchWidth(mem, size, block, 1, value, params->op, &tmp, limit ? limit - found : 0);
 			}
 			size_t i;
 			for (i = 0; i < mCoreMemorySearchResultsSize(&tmp); ++i) {
@@ -336,3 +443,160 @@ void mCoreMemorySearchRepeat(struct mCore* core, const struct mCoreMemorySearchP
 		}
 	}
 }
+
+void mCoreMemorySearchSnapshotInit(struct mCoreMemorySearchSnapshot* snapshot) {
+	snapshot->width = 0;
+	mCoreMemorySearchSnapshotBlocksInit(&snapshot->blocks, 0);
+}
+
+void mCoreMemorySearchSnapshotDeinit(struct mCoreMemorySearchSnapshot* snapshot) {
+	mCoreMemorySearchSnapshotClear(snapshot);
+	mCoreMemorySearchSnapshotBlocksDeinit(&snapshot->blocks);
+}
+
+void mCoreMemorySearchSnapshotClear(struct mCoreMemorySearchSnapshot* snapshot) {
+	size_t i;
+	for (i = 0; i < mCoreMemorySearchSnapshotBlocksSize(&snapshot->blocks); ++i) {
+		struct mCoreMemorySearchSnapshotBlock* block = mCoreMemorySearchSnapshotBlocksGetPointer(&snapshot->blocks, i);
+		free(block->values);
+		free(block->candidates);
+	}
+	mCoreMemorySearchSnapshotBlocksClear(&snapshot->blocks);
+	snapshot->width = 0;
+}
+
+// Clears the candidates in a block whose values no longer match, then recounts them
+static void _narrowBlock(struct mCoreMemorySearchSnapshotBlock* block, const uint8_t* mem, int width, int32_t match, enum mCoreMemorySearchOp op) {
+	size_t nValues = block->size / width;
+	unsigned chunkValues = SEARCH_CHUNK / width;
+	uint32_t chunkMask = (1U << chunkValues) - 1;
+	size_t nFull = op < mCORE_MEMORY_SEARCH_DELTA ? (block->size / SEARCH_CHUNK) * chunkValues : 0;
+	size_t i;
+	block->count = 0;
+	if (op != mCORE_MEMORY_SEARCH_ANY) {
+		match = op < mCORE_MEMORY_SEARCH_DELTA ? _truncate(match, width) : match;
+		// Whole chunks compare many values at once; deltas and the tail go one value at a time
+		for (i = 0; i < nFull; i += chunkValues) {
+			uint32_t* word = &block->candidates[i >> 5];
+			unsigned shift = i & 31;
+			if (!((*word >> shift) & chunkMask)) {
+				continue;
+			}
+			uint32_t mask = _matchChunk(&mem[i * width], width, match, op);
+			*word &= ~((~mask & chunkMask) << shift);
+		}
+		for (i = nFull; i < nValues; ++i) {
+			uint32_t* word = &block->candidates[i >> 5];
+			uint32_t bit = 1U << (i & 31);
+			if (!(*word & bit)) {
+				// Skip empty words in one go
+				if (!*word) {
+					i |= 31;
+				}
+				continue;
+			}
+			int32_t value = _load(mem, i * width, width);
+			if (op >= mCORE_MEMORY_SEARCH_DELTA) {
+				value -= _load(block->values, i * width, width);
+			}
+			if (!_op(value, match, op)) {
+				*word &= ~bit;
+			}
+		}
+	}
+	for (i = 0; i < (nValues + 31) >> 5; ++i) {
+		block->count += popcount32(block->candidates[i]);
+	}
+	memcpy(block->values, mem, block->size);
+}
+
+void mCoreMemorySearchSnapshotTake(struct mCore* core, const struct mCoreMemorySearchParams* params, struct mCoreMemorySearchSnapshot* snapshot) {
+	mCoreMemorySearchSnapshotClear(snapshot);
+	if (params->type != mCORE_MEMORY_SEARCH_INT || (params->width != 1 && params->width != 2 && params->width != 4)) {
+		return;
+	}
+	snapshot->width = params->width;
+
+	const struct mCoreMemoryBlock* blocks;
+	size_t nBlocks = core->listMemoryBlocks(core, &blocks);
+	size_t b;
+	for (b = 0; b < nBlocks; ++b) {
+		size_t size;
+		const struct mCoreMemoryBlock* block = &blocks[b];
+		if (!(block->flags & params->memoryFlags)) {
+			continue;
+		}
+		const uint8_t* mem = core->getMemoryBlock(core, block->id, &size);
+		if (!mem) {
+			continue;
+		}
+		if (size > block->end - block->start) {
+			size = block->end - block->start; // TOOD: Segments
+		}
+		size_t nValues = size / params->width;
+		if (!nValues) {
+			continue;
+		}
+		struct mCoreMemorySearchSnapshotBlock* snap = mCoreMemorySearchSnapshotBlocksAppend(&snapshot->blocks);
+		snap->id = block->id;
+		snap->start = block->start;
+		snap->size = nValues * params->width;
+		snap->values = malloc(snap->size);
+		snap->candidates = malloc(((nValues + 31) >> 5) * sizeof(uint32_t));
+		memset(snap->candidates, 0xFF, ((nValues + 31) >> 5) * sizeof(uint32_t));
+		if (nValues & 31) {
+			snap->candidates[nValues >> 5] = (1U << (nValues & 31)) - 1;
+		}
+		// There is nothing to take a delta against yet, so every value is a candidate
+		_narrowBlock(snap, mem, params->width, params->valueInt, params->op < mCORE_MEMORY_SEARCH_DELTA ? params->op : mCORE_MEMORY_SEARCH_ANY);
+	}
+}
+
+void mCoreMemorySearchSnapshotRepeat(struct mCore* core, const struct mCoreMemorySearchParams* params, struct mCoreMemorySearchSnapshot* snapshot) {
+	if (params->type != mCORE_MEMORY_SEARCH_INT) {
+		return;
+	}
+	size_t i;
+	for (i = 0; i < mCoreMemorySearchSnapshotBlocksSize(&snapshot->blocks); ++i) {
+		struct mCoreMemorySearchSnapshotBlock* block = mCoreMemorySearchSnapshotBlocksGetPointer(&snapshot->blocks, i);
+		if (!block->count) {
+			continue;
+		}
+		size_t size;
+		const uint8_t* mem = core->getMemoryBlock(core, block->id, &size);
+		if (!mem || size < block->size) {
+			memset(block->candidates, 0, ((block->size / snapshot->width + 31) >> 5) * sizeof(uint32_t));
+			block->count = 0;
+			continue;
+		}
+		_narrowBlock(block, mem, snapshot->width, params->valueInt, params->op);
+	}
+}
+
+size_t mCoreMemorySearchSnapshotSize(const struct mCoreMemorySearchSnapshot* snapshot) {
+	size_t count = 0;
+	size_t i;
+	for (i = 0; i < mCoreMemorySearchSnapshotBlocksSize(&snapshot->blocks); ++i) {
+		count += mCoreMemorySearchSnapshotBlocksGetConstPointer(&snapshot->blocks, i)->count;
+	}
+	return count;
+}
+
+size_t mCoreMemorySearchSnapshotResults(const struct mCoreMemorySearchSnapshot* snapshot, struct mCoreMemorySearchResults* out, size_t limit) {
+	size_t found = 0;
+	size_t b;
+	for (b = 0; (!limit || found < limit) && b < mCoreMemorySearchSnapshotBlocksSize(&snapshot->blocks); ++b) {
+		const struct mCoreMemorySearchSnapshotBlock* block = mCoreMemorySearchSnapshotBlocksGetConstPointer(&snapshot->blocks, b);
+		size_t nWords = block->count ? (block->size / snapshot->width + 31) >> 5 : 0;
+		size_t i;
+		for (i = 0; (!limit || found < limit) && i < nWords; ++i) {
+			uint32_t word;
+			for (word = block->candidates[i]; word && (!limit || found < limit); word &= word - 1) {
+				size_t offset = ((i << 5) + _lowestBit(word)) * snapshot->width;
+				_appendInt(out, block->start + offset, snapshot->width, _load(block->values, offset, snapshot->width));
+				++found;
+			}
+		}
+	}
+	return found;
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/mem-watch.h>
+
+#include <mgba/core/core.h>
+
+DEFINE_VECTOR(mCoreMemoryReadList, struct mCoreMemoryRead);
+
+static size_t _readWidth(int width) {
+	switch (width) {
+	case 1:
+	case 2:
+	case 4:
+		return width;
+	default:
+		return 0;
+	}
+}
+
+size_t mCoreMemoryReadBatchSize(const struct mCoreMemoryRead* reads, size_t nReads) {
+	size_t size = 0;
+	size_t i;
+	for (i = 0; i < nReads; ++i) {
+		size += _readWidth(reads[i].width);
+	}
+	return size;
+}
+
+size_t mCoreMemoryReadBatch(struct mCore* core, const struct mCoreMemoryRead* reads, size_t nReads, void* out) {
+	uint8_t* bytes = out;
+	size_t offset = 0;
+	size_t i;
+	for (i = 0; i < nReads; ++i) {
+		uint32_t address = reads[i].address;
+		uint32_t value;
+		switch (reads[i].width) {
+		case 1:
+			bytes[offset] = core->busRead8(core, address);
+			++offset;
+			break;
+		case 2:
+			value = core->busRead16(core, address);
+			bytes[offset] = value;
+			bytes[offset + 1] = value >> 8;
+			offset += 2;
+			break;
+		case 4:
+			value = core->busRead32(core, address);
+			bytes[offset] = value;
+			bytes[offset + 1] = value >> 8;
+			bytes[offset + 2] = value >> 16;
+			bytes[offset + 3] = value >> 24;
+			offset += 4;
+			break;
+		default:
+			break;
+		}
+	}
+	return offset;
+}
+
+void mCoreMemoryWatchSetInit(struct mCoreMemoryWatchSet* set) {
+	mCoreMemoryReadListInit(&set->reads, 0);
+	set->values = NULL;
+	set->size = 0;
+	set->capacity = 0;
+	set->frame = 0;
+}
+
+void mCoreMemoryWatchSetDeinit(struct mCoreMemoryWatchSet* set) {
+	mCoreMemoryReadListDeinit(&set->reads);
+	free(set->values);
+	set->values = NULL;
+	set->capacity = 0;
+}
+
+void mCoreMemoryWatchSetClear(struct mCoreMemoryWatchSet* set) {
+	mCoreMemoryReadListClear(&set->reads);
+	set->size = 0;
+}
+
+ssize_t mCoreMemoryWatchSetAdd(struct mCoreMemoryWatchSet* set, uint32_t address, int width) {
+	size_t bytes = _readWidth(width);
+	if (!bytes) {
+		return -1;
+	}
+	if (set->size + bytes > set->capacity) {
+		size_t capacity = set->capacity ? set->capacity * 2 : 64;
+		while (capacity < set->size + bytes) {
+			capacity *= 2;
+		}
+		set->values = realloc(set->values, capacity);
+		memset(&set->values[set->size], 0, capacity - set->size);
+		set->capacity = capacity;
+	}
+	struct mCoreMemoryRead* read = mCoreMemoryReadListAppend(&set->reads);
+	read->address = address;
+	read->width = width;
+	ssize_t offset = set->size;
+	set->size += bytes;
+	return offset;
+}
+
+void mCoreMemoryWatchSetTake(struct mCore* core, struct mCoreMemoryWatchSet* set) {
+	mCoreMemoryReadBatch(core, mCoreMemoryReadListGetConstPointer(&set->reads, 0), mCoreMemoryReadListSize(&set->reads), set->values);
+	set->frame = core->frameCounter(core);
+}
@@ -0,0 +1,449 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/quick-save.h>
+
+#include <mgba/core/core.h>
+#include <mgba/core/log.h>
+#include <mgba/core/rewind.h>
+#include <mgba/core/serialize.h>
+#include <mgba-util/memory.h>
+#include <mgba-util/vfs.h>
+
+static bool _quickSaveWrite(struct mCoreQuickSaveContext* context, struct mCore* core, struct VFile* state, size_t slot);
+
+#ifndef DISABLE_THREADING
+THREAD_ENTRY _quickSaveThread(void* context);
+#endif
+
+void mCoreQuickSaveContextInit(struct mCoreQuickSaveContext* context, size_t slots, bool onThread) {
+	if (context->nSlots) {
+		return;
+	}
+	if (slots < 2) {
+		slots = 2;
+	} else if (slots > M_QUICK_SAVE_MAX_SLOTS) {
+		slots = M_QUICK_SAVE_MAX_SLOTS;
+	}
+	size_t s;
+	for (s = 0; s < slots; ++s) {
+		context->slots[s].state = VFileMemChunk(0, 0);
+		context->slots[s].sequence = 0;
+		context->slots[s].pending = false;
+	}
+	context->nSlots = slots;
+	context->sequence = 0;
+	context->core = NULL;
+	context->deltaInterval = 0;
+	context->persisted = VFileMemChunk(0, 0);
+	context->scratch = VFileMemChunk(0, 0);
+	context->baseSlot = slots;
+	context->deltas = 0;
+#ifndef DISABLE_THREADING
+	context->onThread = onThread;
+	context->writing = slots;
+	if (onThread) {
+		MutexInit(&context->mutex);
+		ConditionInit(&context->cond);
+		ThreadCreate(&context->thread, _quickSaveThread, context);
+	}
+#else
+	UNUSED(onThread);
+#endif
+}
+
+void mCoreQuickSaveContextDeinit(struct mCoreQuickSaveContext* context) {
+	if (!context->nSlots) {
+		return;
+	}
+#ifndef DISABLE_THREADING
+	if (context->onThread) {
+		// The writer drains any pending slot before it exits
+		MutexLock(&context->mutex);
+		context->onThread = false;
+		MutexUnlock(&context->mutex);
+		ConditionWake(&context->cond);
+		ThreadJoin(&context->thread);
+		MutexDeinit(&context->mutex);
+		ConditionDeinit(&context->cond);
+	}
+#endif
+	size_t s;
+	for (s = 0; s < context->nSlots; ++s) {
+		context->slots[s].state->close(context->slots[s].state);
+		context->slots[s].state = NULL;
+	}
+	context->persisted->close(context->persisted);
+	context->scratch->close(context->scratch);
+	context->persisted = NULL;
+	context->scratch = NULL;
+	context->nSlots = 0;
+}
+
+static size_t _newestSlot(struct mCoreQuickSaveContext* context, bool pending) {
+	size_t newest = context->nSlots;
+	size_t s;
+	for (s = 0; s < context->nSlots; ++s) {
+		if (!context->slots[s].sequence || (pending && !context->slots[s].pending)) {
+			continue;
+		}
+		if (newest == context->nSlots || context->slots[s].sequence > context->slots[newest].sequence) {
+			newest = s;
+		}
+	}
+	return newest;
+}
+
+bool mCoreQuickSaveTake(struct mCoreQuickSaveContext* context, struct mCore* core, int flags) {
+#ifndef DISABLE_THREADING
+	if (context->onThread) {
+		MutexLock(&context->mutex);
+	}
+#endif
+	size_t oldest = context->nSlots;
+	size_t s;
+	for (s = 0; s < context->nSlots; ++s) {
+#ifndef DISABLE_THREADING
+		if (s == context->writing) {
+			continue;
+		}
+#endif
+		if (oldest == context->nSlots || context->slots[s].sequence < context->slots[oldest].sequence) {
+			oldest = s;
+		}
+	}
+	struct mCoreQuickSaveSlot* slot = &context->slots[oldest];
+	// Keep the writer off this slot while it is being refilled
+	slot->sequence = 0;
+	slot->pending = false;
+	context->core = core;
+#ifndef DISABLE_THREADING
+	if (context->onThread) {
+		MutexUnlock(&context->mutex);
+	}
+#endif
+
+	// The metadata goes last in the file, so its presence on disk marks a complete write
+	bool success = mCoreSaveStateNamed(core, slot->state, flags | SAVESTATE_METADATA);
+
+#ifndef DISABLE_THREADING
+	if (context->onThread) {
+		MutexLock(&context->mutex);
+		if (success) {
+			slot->sequence = ++context->sequence;
+			slot->pending = true;
+			ConditionWake(&context->cond);
+		}
+		MutexUnlock(&context->mutex);
+		return success;
+	}
+#endif
+	if (success) {
+		slot->sequence = ++context->sequence;
+		_quickSaveWrite(context, core, slot->state, oldest);
+	}
+	return success;
+}
+
+void mCoreQuickSaveFlush(struct mCoreQuickSaveContext* context) {
+#ifndef DISABLE_THREADING
+	if (!context->onThread) {
+		return;
+	}
+	MutexLock(&context->mutex);
+	while (_newestSlot(context, true) < context->nSlots || context->writing < context->nSlots) {
+		ConditionWait(&context->cond, &context->mutex);
+	}
+	MutexUnlock(&context->mutex);
+#else
+	UNUSED(context);
+#endif
+}
+
+#if !defined(MINIMAL_CORE) || MINIMAL_CORE < 2
+static struct VFile* _quickSaveOpen(struct mCore* core, const char* type, size_t slot, int mode) {
+	if (!core->dirs.state) {
+		return NULL;
+	}
+	char name[PATH_MAX + 14]; // Quash warning
+	snprintf(name, sizeof(name), "%s.%s%u", core->dirs.baseName, type, (unsigned) slot);
+	return core->dirs.state->openFile(core->dirs.state, name, mode);
+}
+#else
+static struct VFile* _quickSaveOpen(struct mCore* core, const char* type, size_t slot, int mode) {
+	UNUSED(core);
+	UNUSED(type);
+	UNUSED(slot);
+	UNUSED(mode);
+	return NULL;
+}
+#endif
+
+// Grows a state to the given length, zeroing the new bytes
+static void _quickSavePad(struct VFile* vf, size_t length) {
+	size_t size = vf->size(vf);
+	if (length <= size) {
+		return;
+	}
+	vf->truncate(vf, length);
+	uint8_t* state = vf->map(vf, length, MAP_WRITE);
+	memset(&state[size], 0, length - size);
+	vf->unmap(vf, state, length);
+}
+
+// Copies a state, zero-padding it to the given length
+static void _quickSaveCopy(struct VFile* dest, struct VFile* source, size_t length) {
+	size_t size = source->size(source);
+	if (length < size) {
+		length = size;
+	}
+	dest->truncate(dest, length);
+	uint8_t* out = dest->map(dest, length, MAP_WRITE);
+	void* in = source->map(source, size, MAP_READ);
+	memcpy(out, in, size);
+	memset(&out[size], 0, length - size);
+	source->unmap(source, in, size);
+	dest->unmap(dest, out, length);
+}
+
+static bool _quickSaveWriteFull(struct mCore* core, struct VFile* state, size_t slot) {
+	// Deltas left over from the previous base don't apply to this one
+	struct VFile* vf = _quickSaveOpen(core, "qd", slot, O_TRUNC | O_WRONLY);
+	if (vf) {
+		vf->close(vf);
+	}
+	vf = _quickSaveOpen(core, "qs", slot, O_CREAT | O_TRUNC | O_RDWR);
+	if (!vf) {
+		return false;
+	}
+	size_t size = state->size(state);
+	void* mem = state->map(state, size, MAP_READ);
+	bool success = vf->write(vf, mem, size) == (ssize_t) size;
+	state->unmap(state, mem, size);
+	success = success && vf->sync(vf, NULL, 0);
+	vf->close(vf);
+	return success;
+}
+
+static bool _quickSaveWriteDelta(struct mCoreQuickSaveContext* context, struct mCore* core, struct VFile* state, size_t slot) {
+	size_t length = state->size(state);
+	if (context->persisted->size(context->persisted) > (ssize_t) length) {
+		length = context->persisted->size(context->persisted);
+	}
+	length = (length + 3) & ~3;
+	_quickSaveCopy(context->scratch, state, length);
+	_quickSavePad(context->persisted, length);
+
+	size_t words = length / 4;
+	uint32_t* buffer = malloc((mCoreRewindEncodeBound(words) + 2) * sizeof(uint32_t));
+	if (!buffer) {
+		return false;
+	}
+	const uint32_t* base = context->persisted->map(context->persisted, length, MAP_READ);
+	const uint32_t* next = context->scratch->map(context->scratch, length, MAP_READ);
+	size_t size = mCoreRewindEncode(&buffer[2], base, next, words, NULL, 0) * sizeof(uint32_t);
+	context->persisted->unmap(context->persisted, (void*) base, length);
+	context->scratch->unmap(context->scratch, (void*) next, length);
+	STORE_32LE(size, 0, buffer);
+	STORE_32LE(length, sizeof(uint32_t), buffer);
+	size += sizeof(uint32_t) * 2;
+
+	bool success = false;
+	struct VFile* vf = _quickSaveOpen(core, "qd", slot, O_CREAT | O_RDWR);
+	if (vf) {
+		success = vf->seek(vf, 0, SEEK_END) >= 0;
+		success = success && vf->write(vf, buffer, size) == (ssize_t) size;
+		success = success && vf->sync(vf, NULL, 0);
+		vf->close(vf);
+	}
+	free(buffer);
+	if (success) {
+		struct VFile* persisted = context->persisted;
+		context->persisted = context->scratch;
+		context->scratch = persisted;
+	}
+	return success;
+}
+
+static bool _quickSaveWrite(struct mCoreQuickSaveContext* context, struct mCore* core, struct VFile* state, size_t slot) {
+	bool success;
+	if (context->deltaInterval && context->baseSlot < context->nSlots && context->deltas < context->deltaInterval) {
+		slot = context->baseSlot;
+		success = _quickSaveWriteDelta(context, core, state, slot);
+		if (success) {
+			++context->deltas;
+		} else {
+			// Start over with a new base rather than append after a partial delta
+			context->deltas = context->deltaInterval;
+		}
+	} else {
+		if (context->baseSlot < context->nSlots) {
+			// The newest chain on disk stays intact until the new base is complete
+			slot = (context->baseSlot + 1) % context->nSlots;
+		}
+		success = _quickSaveWriteFull(core, state, slot);
+		if (success) {
+			if (context->deltaInterval) {
+				_quickSaveCopy(context->persisted, state, 0);
+				context->baseSlot = slot;
+			}
+			context->deltas = 0;
+		}
+	}
+	if (!success) {
+		mLOG(STATUS, WARN, "Quick save %u failed to write", (unsigned) slot);
+	}
+	return success;
+}
+
+// Reads a base state and applies the deltas that follow it, up to the first incomplete one
+static struct VFile* _quickSaveReadFile(struct mCore* core, size_t slot) {
+	struct VFile* vf = _quickSaveOpen(core, "qs", slot, O_RDONLY);
+	if (!vf) {
+		return NULL;
+	}
+	ssize_t size = vf->size(vf);
+	struct VFile* state = VFileMemChunk(NULL, size > 0 ? size : 0);
+	void* mem = state->map(state, size, MAP_WRITE);
+	bool success = size > 0 && vf->read(vf, mem, size) == size;
+	state->unmap(state, mem, size);
+	vf->close(vf);
+
+	struct VFile* deltas = success ? _quickSaveOpen(core, "qd", slot, O_RDONLY) : NULL;
+	while (deltas) {
+		uint32_t header[2];
+		if (deltas->read(deltas, header, sizeof(header)) != sizeof(header)) {
+			break;
+		}
+		uint32_t deltaSize;
+		uint32_t length;
+		LOAD_32LE(deltaSize, 0, header);
+		LOAD_32LE(length, sizeof(uint32_t), header);
+		if ((deltaSize | length) & 3 || length < state->size(state) || deltaSize > mCoreRewindEncodeBound(length / 4) * sizeof(uint32_t)) {
+			success = false;
+			break;
+		}
+		uint32_t* data = malloc(deltaSize ? deltaSize : 1);
+		if (!data || deltas->read(deltas, data, deltaSize) != (ssize_t) deltaSize) {
+			free(data);
+			break;
+		}
+		_quickSavePad(state, length);
+		uint32_t* words = state->map(state, length, MAP_WRITE);
+		success = mCoreRewindApply(words, length / 4, data, deltaSize / 4);
+		state->unmap(state, words, length);
+		free(data);
+		if (!success) {
+			break;
+		}
+	}
+	if (deltas) {
+		deltas->close(deltas);
+	}
+	if (!success) {
+		state->close(state);
+		return NULL;
+	}
+	return state;
+}
+
+static bool _quickSaveRestoreFile(struct mCoreQuickSaveContext* context, struct mCore* core, int flags) {
+	struct VFile* newest = NULL;
+	uint64_t newestTime = 0;
+	size_t stateSize = core->stateSize(core);
+	size_t s;
+	for (s = 0; s < context->nSlots; ++s) {
+		struct VFile* vf = _quickSaveReadFile(core, s);
+		if (!vf) {
+			continue;
+		}
+		struct mStateExtdata extdata;
+		mStateExtdataInit(&extdata);
+		void* state = mCoreExtractState(core, vf, &extdata);
+		struct mStateExtdataItem item;
+		uint64_t creation = 0;
+		if (state) {
+			mappedMemoryFree(state, stateSize);
+			if (mStateExtdataGet(&extdata, EXTDATA_META_TIME, &item) && item.data && item.size >= (int32_t) sizeof(creation)) {
+				LOAD_64LE(creation, 0, item.data);
+			}
+		}
+		mStateExtdataDeinit(&extdata);
+		if (!creation || (newest && creation <= newestTime)) {
+			// Either an interrupted write or an older state
+			vf->close(vf);
+			continue;
+		}
+		if (newest) {
+			newest->close(newest);
+		}
+		newest = vf;
+		newestTime = creation;
+	}
+	if (!newest) {
+		return false;
+	}
+	bool success = mCoreLoadStateNamed(core, newest, flags);
+	newest->close(newest);
+	return success;
+}
+
+bool mCoreQuickSaveRestore(struct mCoreQuickSaveContext* context, struct mCore* core, int flags) {
+#ifndef DISABLE_THREADING
+	if (context->onThread) {
+		MutexLock(&context->mutex);
+	}
+#endif
+	size_t newest = _newestSlot(context, false);
+	bool success = false;
+	if (newest < context->nSlots) {
+		struct VFile* state = context->slots[newest].state;
+		success = mCoreLoadStateNamed(core, state, flags);
+	}
+#ifndef DISABLE_THREADING
+	if (context->onThread) {
+		MutexUnlock(&context->mutex);
+	}
+#endif
+	if (newest < context->nSlots) {
+		return success;
+	}
+	return _quickSaveRestoreFile(context, core, flags);
+}
+
+#ifndef DISABLE_THREADING
+THREAD_ENTRY _quickSaveThread(void* context) {
+	struct mCoreQuickSaveContext* quickSave = context;
+	ThreadSetName("Quick Save Writer");
+	ThreadPlaceHelper();
+	MutexLock(&quickSave->mutex);
+	while (true) {
+		size_t newest = _newestSlot(quickSave, true);
+		if (newest == quickSave->nSlots) {
+			if (!quickSave->onThread) {
+				break;
+			}
+			ConditionWait(&quickSave->cond, &quickSave->mutex);
+			continue;
+		}
+		// Older pending slots are superseded by the newest one
+		size_t s;
+		for (s = 0; s < quickSave->nSlots; ++s) {
+			quickSave->slots[s].pending = false;
+		}
+		quickSave->writing = newest;
+		struct mCore* core = quickSave->core;
+		MutexUnlock(&quickSave->mutex);
+
+		_quickSaveWrite(quickSave, core, quickSave->slots[newest].state, newest);
+
+		MutexLock(&quickSave->mutex);
+		quickSave->writing = quickSave->nSlots;
+		ConditionWake(&quickSave->cond);
+	}
+	MutexUnlock(&quickSave->mutex);
+	return 0;
+}
+#endif
@@ -7,10 +7,10 @@
 
 #include <mgba/core/core.h>
 #include <mgba/core/serialize.h>
-#include <mgba-util/patch/fast.h>
 #include <mgba-util/vfs.h>
 
-DEFINE_VECTOR(mCoreRewindPatches, struct PatchFast);
+// Zero runs shorter than this cost less as literals than as a new run header
+#define REWIND_MIN_SKIP 3
 
 void _rewindDiff(struct mCoreRewindContext* context);
 
@@ -22,14 +22,25 @@ void mCoreRewindContextInit(struct mCoreRewindContext* context, size_t entries,
 	if (context->currentState) {
 		return;
 	}
-	mCoreRewindPatchesInit(&context->patchMemory, entries);
-	size_t e;
-	for (e = 0; e < entries; ++e) {
-		initPatchFast(mCoreRewindPatchesAppend(&context->patchMemory));
+	if (!entries) {
+		entries = 1;
 	}
+	context->entries = calloc(entries, sizeof(*context->entries));
+	context->capacity = entries;
+	context->first = 0;
+	context->size = 0;
+	context->memoryLimit = 0;
+	context->memoryUsed = 0;
+	context->encodeBuffer = NULL;
+	context->encodeBufferSize = 0;
+	context->dirtyPages = NULL;
+	context->dirtyPagesSize = 0;
+	context->dirtySize = 0;
+	context->storeFrames = false;
+	context->frameShift = M_REWIND_FRAME_SHIFT;
+	context->pendingFrame = NULL;
 	context->previousState = VFileMemChunk(0, 0);
 	context->currentState = VFileMemChunk(0, 0);
-	context->size = 0;
 #ifndef DISABLE_THREADING
 	context->onThread = onThread;
 	context->ready = false;
@@ -62,21 +73,204 @@ void mCoreRewindContextDeinit(struct mCoreRewindContext* context) {
 	context->currentState->close(context->currentState);
 	context->previousState = NULL;
 	context->currentState = NULL;
-	size_t s;
-	for (s = 0; s < mCoreRewindPatchesSize(&context->patchMemory); ++s) {
-		deinitPatchFast(mCoreRewindPatchesGetPointer(&context->patchMemory, s));
+	size_t e;
+	for (e = 0; e < context->capacity; ++e) {
+		free(context->entries[e].data);
+		free(context->entries[e].frame);
+	}
+	free(context->entries);
+	context->entries = NULL;
+	free(context->encodeBuffer);
+	context->encodeBuffer = NULL;
+	free(context->dirtyPages);
+	context->dirtyPages = NULL;
+	free(context->pendingFrame);
+	context->pendingFrame = NULL;
+}
+
+static struct mCoreRewindEntry* _rewindEntry(struct mCoreRewindContext* context, size_t index) {
+	return &context->entries[(context->first + index) % context->capacity];
+}
+
+static size_t _rewindFrameSize(const struct mCoreRewindEntry* entry) {
+	return entry->frameWidth * entry->frameHeight * sizeof(color_t);
+}
+
+static void _rewindFreeEntry(struct mCoreRewindContext* context, struct mCoreRewindEntry* entry) {
+	context->memoryUsed -= entry->size;
+	free(entry->data);
+	entry->data = NULL;
+	if (entry->frame) {
+		context->memoryUsed -= _rewindFrameSize(entry);
+		free(entry->frame);
+		entry->frame = NULL;
+	}
+}
+
+static size_t _rewindLastKeyframe(struct mCoreRewindContext* context, size_t before) {
+	while (before && !_rewindEntry(context, before)->keyframe) {
+		--before;
+	}
+	return before;
+}
+
+static void _rewindDropOldest(struct mCoreRewindContext* context) {
+	// The deltas after a keyframe can't be decoded without it, so the whole group goes
+	do {
+		_rewindFreeEntry(context, _rewindEntry(context, 0));
+		context->first = (context->first + 1) % context->capacity;
+		--context->size;
+	} while (context->size && !_rewindEntry(context, 0)->keyframe);
+}
+
+// Grows the state to the given size, zeroing the new bytes
+static void _rewindPad(struct VFile* vf, size_t size) {
+	size_t oldSize = vf->size(vf);
+	if (size <= oldSize) {
+		return;
+	}
+	vf->truncate(vf, size);
+	uint8_t* state = vf->map(vf, size, MAP_WRITE);
+	memset(&state[oldSize], 0, size - oldSize);
+	vf->unmap(vf, state, size);
+}
+
+// Finds the next word that differs, skipping pages the core reported as untouched
+static size_t _rewindSkip(const uint32_t* restrict base, const uint32_t* restrict state, size_t i, size_t words, const uint32_t* dirty, size_t dirtyPages) {
+	while (i < words) {
+		size_t page = i >> (M_STATE_PAGE_SHIFT - 2);
+		size_t end = (page + 1) << (M_STATE_PAGE_SHIFT - 2);
+		if (end > words) {
+			end = words;
+		}
+		if (page < dirtyPages && !mStatePageIsDirty(dirty, page)) {
+			i = end;
+			continue;
+		}
+		while (i < end && base[i] == state[i]) {
+			++i;
+		}
+		if (i < end) {
+			break;
+		}
+	}
+	return i;
+}
+
+size_t mCoreRewindEncodeBound(size_t words) {
+	return (words + REWIND_MIN_SKIP * 2) * 2;
+}
+
+size_t mCoreRewindEncode(uint32_t* restrict out, const uint32_t* restrict base, const uint32_t* restrict state, size_t words, const uint32_t* dirty, size_t dirtyPages) {
+	size_t o = 0;
+	size_t i = 0;
+	while (i < words) {
+		size_t start = i;
+		if (base) {
+			i = _rewindSkip(base, state, i, words, dirty, dirtyPages);
+		} else {
+			while (i < words && !state[i]) {
+				++i;
+			}
+		}
+		if (i == words) {
+			break;
+		}
+		out[o] = i - start;
+		uint32_t* literal = &out[o + 2];
+		start = i;
+		size_t end = i;
+		for (; i < words && i - end < REWIND_MIN_SKIP; ++i) {
+			uint32_t word = base ? base[i] ^ state[i] : state[i];
+			literal[i - start] = word;
+			if (word) {
+				end = i + 1;
+			}
+		}
+		out[o + 1] = end - start;
+		o += 2 + end - start;
+		i = end;
+	}
+	return o;
+}
+
+bool mCoreRewindApply(uint32_t* restrict state, size_t stateWords, const uint32_t* restrict data, size_t words) {
+	size_t i = 0;
+	size_t o = 0;
+	while (o + 2 <= words) {
+		i += data[o];
+		size_t count = data[o + 1];
+		o += 2;
+		if (i > stateWords || count > stateWords - i || count > words - o) {
+			return false;
+		}
+		for (; count; --count, ++i, ++o) {
+			state[i] ^= data[o];
+		}
+	}
+	return o == words;
+}
+
+static void _rewindCollectDirty(struct mCoreRewindContext* context, struct mCore* core, size_t size) {
+	context->dirtySize = 0;
+	if (!core->collectDirtyState) {
+		return;
+	}
+	size_t words = M_STATE_PAGE_WORDS(size);
+	if (words > context->dirtyPagesSize) {
+		free(context->dirtyPages);
+		context->dirtyPages = malloc(words * sizeof(*context->dirtyPages));
+		context->dirtyPagesSize = words;
+	}
+	if (core->collectDirtyState(core, context->dirtyPages, size)) {
+		context->dirtySize = size;
+	}
+}
+
+// Samples every (1 << frameShift)th pixel of every (1 << frameShift)th line
+static void _rewindCaptureFrame(struct mCoreRewindContext* context, struct mCore* core) {
+	const void* buffer;
+	size_t stride;
+	unsigned width;
+	unsigned height;
+	core->getPixels(core, &buffer, &stride);
+	core->desiredVideoDimensions(core, &width, &height);
+	width >>= context->frameShift;
+	height >>= context->frameShift;
+	free(context->pendingFrame);
+	context->pendingFrame = malloc(width * height * sizeof(color_t));
+	context->pendingWidth = width;
+	context->pendingHeight = height;
+	if (!context->pendingFrame) {
+		return;
+	}
+	const color_t* pixels = buffer;
+	unsigned x, y;
+	for (y = 0; y < height; ++y) {
+		const color_t* row = &pixels[(y << context->frameShift) * stride];
+		for (x = 0; x < width; ++x) {
+			context->pendingFrame[y * width + x] = row[x << context->frameShift];
+		}
 	}
-	mCoreRewindPatchesDeinit(&context->patchMemory);
 }
 
 void mCoreRewindAppend(struct mCoreRewindContext* context, struct mCore* core) {
 #ifndef DISABLE_THREADING
 	if (context->onThread) {
 		MutexLock(&context->mutex);
+		if (context->ready) {
+			// The state about to be overwritten hasn't been diffed yet
+			_rewindDiff(context);
+			context->ready = false;
+		}
 	}
 #endif
 	struct VFile* nextState = context->previousState;
 	mCoreSaveStateNamed(core, nextState, SAVESTATE_SAVEDATA | SAVESTATE_RTC);
+	_rewindCollectDirty(context, core, nextState->size(nextState));
+	if (context->storeFrames) {
+		_rewindCaptureFrame(context, core);
+	}
 	context->previousState = context->currentState;
 	context->currentState = nextState;
 #ifndef DISABLE_THREADING
@@ -91,77 +285,182 @@ void mCoreRewindAppend(struct mCoreRewindContext* context, struct mCore* core) {
 }
 
 void _rewindDiff(struct mCoreRewindContext* context) {
-	++context->current;
-	if (context->size < mCoreRewindPatchesSize(&context->patchMemory)) {
-		++context->size;
+	if (context->size == context->capacity) {
+		_rewindDropOldest(context);
+	}
+	bool keyframe = !context->size || context->size - _rewindLastKeyframe(context, context->size - 1) >= M_REWIND_KEYFRAME_INTERVAL;
+
+	size_t length = context->currentState->size(context->currentState);
+	if (!keyframe) {
+		size_t previousLength = context->previousState->size(context->previousState);
+		if (previousLength > length) {
+			length = previousLength;
+		}
+	}
+	length = (length + 3) & ~3;
+	_rewindPad(context->currentState, length);
+	if (!keyframe) {
+		_rewindPad(context->previousState, length);
+	}
+
+	size_t words = length / 4;
+	size_t bufferSize = mCoreRewindEncodeBound(words) * sizeof(uint32_t);
+	if (bufferSize > context->encodeBufferSize) {
+		free(context->encodeBuffer);
+		context->encodeBuffer = malloc(bufferSize);
+		context->encodeBufferSize = bufferSize;
+	}
+	const uint32_t* current = context->currentState->map(context->currentState, length, MAP_READ);
+	const uint32_t* previous = NULL;
+	if (!keyframe) {
+		previous = context->previousState->map(context->previousState, length, MAP_READ);
+	}
+	// Only whole pages within the collected size are known to be clean
+	size_t size = mCoreRewindEncode(context->encodeBuffer, previous, current, words, context->dirtyPages, context->dirtySize >> M_STATE_PAGE_SHIFT) * sizeof(uint32_t);
+	context->currentState->unmap(context->currentState, (void*) current, length);
+	if (previous) {
+		context->previousState->unmap(context->previousState, (void*) previous, length);
 	}
-	if (context->current >= mCoreRewindPatchesSize(&context->patchMemory)) {
-		context->current = 0;
+
+	struct mCoreRewindEntry* entry = _rewindEntry(context, context->size);
+	entry->data = malloc(size ? size : 1);
+	memcpy(entry->data, context->encodeBuffer, size);
+	entry->size = size;
+	entry->length = length;
+	entry->keyframe = keyframe;
+	entry->frame = context->pendingFrame;
+	entry->frameWidth = context->pendingWidth;
+	entry->frameHeight = context->pendingHeight;
+	context->pendingFrame = NULL;
+	++context->size;
+	context->memoryUsed += size;
+	if (entry->frame) {
+		context->memoryUsed += _rewindFrameSize(entry);
 	}
-	struct PatchFast* patch = mCoreRewindPatchesGetPointer(&context->patchMemory, context->current);
-	size_t size2 = context->currentState->size(context->currentState);
-	size_t size = context->previousState->size(context->previousState);
-	if (size2 > size) {
-		context->previousState->truncate(context->previousState, size2);
-		size = size2;
-	} else if (size > size2) {
-		context->currentState->truncate(context->currentState, size);
+
+	while (context->memoryLimit && context->memoryUsed > context->memoryLimit && _rewindLastKeyframe(context, context->size - 1)) {
+		_rewindDropOldest(context);
 	}
-	void* current = context->previousState->map(context->previousState, size, MAP_READ);
-	void* next = context->currentState->map(context->currentState, size, MAP_READ);
-	diffPatchFast(patch, current, next, size);
-	context->previousState->unmap(context->previousState, current, size);
-	context->currentState->unmap(context->currentState, next, size);
 }
 
-bool mCoreRewindRestore(struct mCoreRewindContext* context, struct mCore* core) {
-#ifndef DISABLE_THREADING
-	if (context->onThread) {
-		MutexLock(&context->mutex);
+static bool _rewindStep(struct mCoreRewindContext* context) {
+	if (context->size < 2) {
+		return false;
 	}
-#endif
-	if (!context->size) {
-#ifndef DISABLE_THREADING
-		if (context->onThread) {
-			MutexUnlock(&context->mutex);
+
+	struct mCoreRewindEntry* newest = _rewindEntry(context, context->size - 1);
+	size_t first = context->size - 1;
+	if (newest->keyframe) {
+		// Decode the group of the state being restored from its keyframe
+		first = _rewindLastKeyframe(context, context->size - 2);
+	}
+	size_t length = 0;
+	size_t e;
+	for (e = first; e < context->size; ++e) {
+		if (_rewindEntry(context, e)->length > length) {
+			length = _rewindEntry(context, e)->length;
 		}
-#endif
-		return false;
 	}
+	_rewindPad(context->currentState, length);
+	uint32_t* state = context->currentState->map(context->currentState, length, MAP_WRITE);
+	if (newest->keyframe) {
+		memset(state, 0, length);
+		for (e = first; e < context->size - 1; ++e) {
+			struct mCoreRewindEntry* entry = _rewindEntry(context, e);
+			mCoreRewindApply(state, length / sizeof(uint32_t), entry->data, entry->size / sizeof(uint32_t));
+		}
+	} else {
+		// Applying a delta a second time undoes it
+		mCoreRewindApply(state, length / sizeof(uint32_t), newest->data, newest->size / sizeof(uint32_t));
+	}
+	context->currentState->unmap(context->currentState, state, length);
+
+	_rewindFreeEntry(context, newest);
 	--context->size;
+	return true;
+}
 
-	mCoreLoadStateNamed(core, context->previousState, SAVESTATE_SAVEDATA | SAVESTATE_RTC);
-	if (context->current == 0) {
-		context->current = mCoreRewindPatchesSize(&context->patchMemory);
+static void _rewindLock(struct mCoreRewindContext* context) {
+#ifndef DISABLE_THREADING
+	if (context->onThread) {
+		MutexLock(&context->mutex);
+		if (context->ready) {
+			// The newest state hasn't been encoded yet
+			_rewindDiff(context);
+			context->ready = false;
+		}
 	}
-	--context->current;
+#else
+	UNUSED(context);
+#endif
+}
 
-	struct PatchFast* patch = mCoreRewindPatchesGetPointer(&context->patchMemory, context->current);
-	size_t size2 = context->previousState->size(context->previousState);
-	size_t size = context->currentState->size(context->currentState);
-	if (size2 < size) {
-		size = size2;
-	}
-	void* current = context->currentState->map(context->currentState, size, MAP_READ);
-	void* previous = context->previousState->map(context->previousState, size, MAP_WRITE);
-	patch->d.applyPatch(&patch->d, previous, size, current, size);
-	context->currentState->unmap(context->currentState, current, size);
-	context->previousState->unmap(context->previousState, previous, size);
-	struct VFile* nextState = context->previousState;
-	context->previousState = context->currentState;
-	context->currentState = nextState;
+static void _rewindUnlock(struct mCoreRewindContext* context) {
 #ifndef DISABLE_THREADING
 	if (context->onThread) {
 		MutexUnlock(&context->mutex);
 	}
+#else
+	UNUSED(context);
 #endif
+}
+
+bool mCoreRewindRestore(struct mCoreRewindContext* context, struct mCore* core) {
+	_rewindLock(context);
+	bool success = _rewindStep(context);
+	if (success) {
+		context->currentState->seek(context->currentState, 0, SEEK_SET);
+		mCoreLoadStateNamed(core, context->currentState, SAVESTATE_SAVEDATA | SAVESTATE_RTC);
+	}
+	_rewindUnlock(context);
+	return success;
+}
+
+bool mCoreRewindStep(struct mCoreRewindContext* context) {
+	_rewindLock(context);
+	bool success = _rewindStep(context);
+	_rewindUnlock(context);
+	return success;
+}
+
+bool mCoreRewindDrawFrame(struct mCoreRewindContext* context, color_t* pixels, size_t stride) {
+	_rewindLock(context);
+	const struct mCoreRewindEntry* entry = NULL;
+	if (context->size) {
+		entry = _rewindEntry(context, context->size - 1);
+	}
+	if (!entry || !entry->frame) {
+		_rewindUnlock(context);
+		return false;
+	}
+	unsigned scale = 1 << context->frameShift;
+	unsigned x, y;
+	for (y = 0; y < entry->frameHeight * scale; ++y) {
+		const color_t* row = &entry->frame[(y >> context->frameShift) * entry->frameWidth];
+		for (x = 0; x < entry->frameWidth * scale; ++x) {
+			pixels[y * stride + x] = row[x >> context->frameShift];
+		}
+	}
+	_rewindUnlock(context);
 	return true;
 }
 
+bool mCoreRewindLoad(struct mCoreRewindContext* context, struct mCore* core) {
+	_rewindLock(context);
+	bool success = context->size > 0;
+	if (success) {
+		context->currentState->seek(context->currentState, 0, SEEK_SET);
+		success = mCoreLoadStateNamed(core, context->currentState, SAVESTATE_SAVEDATA | SAVESTATE_RTC);
+	}
+	_rewindUnlock(context);
+	return success;
+}
+
 #ifndef DISABLE_THREADING
 THREAD_ENTRY _rewindThread(void* context) {
 	struct mCoreRewindContext* rewindContext = context;
 	ThreadSetName("Rewind Diffing");
+	ThreadPlaceHelper();
 	MutexLock(&rewindContext->mutex);
 	while (rewindContext->onThread) {
 		while (!rewindContext->ready && rewindContext->onThread) {
@@ -176,4 +475,3 @@ THREAD_ENTRY _rewindThread(void* context) {
 	return 0;
 }
 #endif
-
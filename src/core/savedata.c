@@ -0,0 +1,179 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/savedata.h>
+
+#include <mgba/core/log.h>
+#include <mgba-util/vfs.h>
+
+mLOG_DECLARE_CATEGORY(SAVEDATA);
+mLOG_DEFINE_CATEGORY(SAVEDATA, "Savedata", "core.savedata");
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _flusherThread(void* context);
+#endif
+
+void mSavedataFlusherInit(struct mSavedataFlusher* flusher) {
+	flusher->durability = mSAVEDATA_DURABILITY_FLUSH;
+	flusher->vf = NULL;
+	flusher->data = NULL;
+	flusher->size = 0;
+	flusher->generation = 0;
+#ifndef DISABLE_THREADING
+	flusher->onThread = false;
+	flusher->busy = false;
+#endif
+	mSavedataFlusherReset(flusher);
+}
+
+void mSavedataFlusherDeinit(struct mSavedataFlusher* flusher) {
+#ifndef DISABLE_THREADING
+	if (flusher->onThread) {
+		MutexLock(&flusher->mutex);
+		while (flusher->busy) {
+			ConditionWait(&flusher->cond, &flusher->mutex);
+		}
+		flusher->onThread = false;
+		ConditionWake(&flusher->cond);
+		MutexUnlock(&flusher->mutex);
+		ThreadJoin(&flusher->thread);
+		MutexDeinit(&flusher->mutex);
+		ConditionDeinit(&flusher->cond);
+	}
+#else
+	UNUSED(flusher);
+#endif
+}
+
+void mSavedataFlusherReset(struct mSavedataFlusher* flusher) {
+	mSavedataFlusherWait(flusher);
+	flusher->dirty = 0;
+	flusher->dirtAge = 0;
+	flusher->lastFlush = 0;
+	flusher->unsynced = false;
+}
+
+bool mSavedataFlusherPoll(struct mSavedataFlusher* flusher, uint32_t frameCount) {
+	if (flusher->dirty & mSAVEDATA_DIRT_NEW) {
+		flusher->dirtAge = frameCount;
+		flusher->dirty &= ~mSAVEDATA_DIRT_NEW;
+		flusher->dirty |= mSAVEDATA_DIRT_SEEN;
+		return false;
+	}
+	if (!(flusher->dirty & mSAVEDATA_DIRT_SEEN) || frameCount - flusher->dirtAge <= mSAVEDATA_CLEANUP_THRESHOLD) {
+		return false;
+	}
+	if (flusher->durability == mSAVEDATA_DURABILITY_LAZY && frameCount - flusher->lastFlush <= mSAVEDATA_LAZY_INTERVAL) {
+		return false;
+	}
+	flusher->dirty = 0;
+	flusher->lastFlush = frameCount;
+	++flusher->generation;
+	return true;
+}
+
+static void _flusherSync(struct VFile* vf, const void* data, size_t size) {
+	if (vf->sync(vf, data, size)) {
+		mLOG(SAVEDATA, INFO, "Savedata synced");
+	} else {
+		mLOG(SAVEDATA, INFO, "Savedata failed to sync!");
+	}
+}
+
+void mSavedataFlusherFlush(struct mSavedataFlusher* flusher, struct VFile* vf, const void* data, size_t size) {
+	if (flusher->durability == mSAVEDATA_DURABILITY_NEVER || flusher->durability == mSAVEDATA_DURABILITY_EXIT) {
+		flusher->unsynced = true;
+		return;
+	}
+	if (!data) {
+		mLOG(SAVEDATA, INFO, "Savedata failed to sync!");
+		return;
+	}
+	flusher->unsynced = false;
+#ifndef DISABLE_THREADING
+	if (!flusher->onThread) {
+		MutexInit(&flusher->mutex);
+		ConditionInit(&flusher->cond);
+		flusher->onThread = true;
+		ThreadCreate(&flusher->thread, _flusherThread, flusher);
+	}
+	MutexLock(&flusher->mutex);
+	while (flusher->busy) {
+		ConditionWait(&flusher->cond, &flusher->mutex);
+	}
+	flusher->vf = vf;
+	flusher->data = data;
+	flusher->size = size;
+	flusher->busy = true;
+	ConditionWake(&flusher->cond);
+	MutexUnlock(&flusher->mutex);
+#else
+	_flusherSync(vf, data, size);
+#endif
+}
+
+void mSavedataFlusherWait(struct mSavedataFlusher* flusher) {
+#ifndef DISABLE_THREADING
+	if (!flusher->onThread) {
+		return;
+	}
+	MutexLock(&flusher->mutex);
+	while (flusher->busy) {
+		ConditionWait(&flusher->cond, &flusher->mutex);
+	}
+	MutexUnlock(&flusher->mutex);
+#else
+	UNUSED(flusher);
+#endif
+}
+
+void mSavedataFlusherFinish(struct mSavedataFlusher* flusher, struct VFile* vf, const void* data, size_t size) {
+	mSavedataFlusherWait(flusher);
+	if (flusher->durability == mSAVEDATA_DURABILITY_NEVER) {
+		return;
+	}
+	if ((flusher->dirty || flusher->unsynced) && vf && data) {
+		_flusherSync(vf, data, size);
+	}
+	flusher->dirty = 0;
+	flusher->unsynced = false;
+}
+
+enum mSavedataDurability mSavedataDurabilityFromName(const char* name) {
+	if (strcasecmp(name, "never") == 0) {
+		return mSAVEDATA_DURABILITY_NEVER;
+	}
+	if (strcasecmp(name, "lazy") == 0) {
+		return mSAVEDATA_DURABILITY_LAZY;
+	}
+	if (strcasecmp(name, "exit") == 0) {
+		return mSAVEDATA_DURABILITY_EXIT;
+	}
+	return mSAVEDATA_DURABILITY_FLUSH;
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _flusherThread(void* context) {
+	struct mSavedataFlusher* flusher = context;
+	ThreadSetName("Savedata Flusher");
+	ThreadPlaceHelper();
+	MutexLock(&flusher->mutex);
+	while (true) {
+		while (!flusher->busy && flusher->onThread) {
+			ConditionWait(&flusher->cond, &flusher->mutex);
+		}
+		if (!flusher->busy) {
+			break;
+		}
+		MutexUnlock(&flusher->mutex);
+		_flusherSync(flusher->vf, flusher->data, flusher->size);
+		MutexLock(&flusher->mutex);
+		flusher->busy = false;
+		ConditionWake(&flusher->cond);
+	}
+	MutexUnlock(&flusher->mutex);
+	return 0;
+}
+#endif
@@ -0,0 +1,223 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/snapshot.h>
+
+#include <mgba/core/core.h>
+
+static size_t _regionSize(struct mCore* core, const struct mCoreMemoryBlock* block) {
+	size_t size = 0;
+	if (core->getMemoryBlock(core, block->id, &size) && size) {
+		return size;
+	}
+	// Blocks without backing memory, like MMIO, are read through the bus window instead
+	return block->end - block->start;
+}
+
+static void _takeRegion(struct mCore* core, struct mCoreSnapshotRegion* region, uint8_t* out) {
+	const struct mCoreMemoryBlock* block = region->block;
+	size_t size = 0;
+	const uint8_t* memory = core->getMemoryBlock(core, block->id, &size);
+	if (memory && size) {
+		if (size > region->size) {
+			size = region->size;
+		}
+		memcpy(out, memory, size);
+		return;
+	}
+	size_t offset;
+	if (!(region->size & 1)) {
+		for (offset = 0; offset < region->size; offset += 2) {
+			STORE_16LE(core->rawRead16(core, block->start + offset, -1), offset, (uint16_t*) out);
+		}
+	} else {
+		for (offset = 0; offset < region->size; ++offset) {
+			out[offset] = core->rawRead8(core, block->start + offset, -1);
+		}
+	}
+}
+
+void mCoreSnapshotInit(struct mCoreSnapshot* snapshot, struct mCore* core) {
+	memset(snapshot, 0, sizeof(*snapshot));
+	snapshot->core = core;
+	snapshot->frame = -1;
+	MutexInit(&snapshot->mutex);
+
+	const struct mCoreMemoryBlock* blocks;
+	size_t nBlocks = core->listMemoryBlocks(core, &blocks);
+	size_t i;
+	for (i = 0; i < nBlocks && snapshot->nRegions < mCORE_SNAPSHOT_MAX_REGIONS; ++i) {
+		// Read-only blocks don't change from frame to frame, so there's nothing to take
+		if ((blocks[i].flags & mCORE_MEMORY_VIRTUAL) || !(blocks[i].flags & mCORE_MEMORY_WRITE)) {
+			continue;
+		}
+		struct mCoreSnapshotRegion* region = &snapshot->regions[snapshot->nRegions];
+		region->block = &blocks[i];
+		region->frame = -1;
+		++snapshot->nRegions;
+	}
+}
+
+void mCoreSnapshotDeinit(struct mCoreSnapshot* snapshot) {
+	size_t i;
+	for (i = 0; i < snapshot->nRegions; ++i) {
+		free(snapshot->regions[i].buffers[0]);
+		free(snapshot->regions[i].buffers[1]);
+	}
+	MutexDeinit(&snapshot->mutex);
+}
+
+ssize_t mCoreSnapshotFindRegion(const struct mCoreSnapshot* snapshot, const char* name) {
+	size_t i;
+	for (i = 0; i < snapshot->nRegions; ++i) {
+		if (strcmp(snapshot->regions[i].block->internalName, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int mCoreSnapshotAddConsumer(struct mCoreSnapshot* snapshot, const char* const* names) {
+	uint32_t regions = 0;
+	for (; *names; ++names) {
+		ssize_t region = mCoreSnapshotFindRegion(snapshot, *names);
+		if (region >= 0) {
+			regions |= 1 << region;
+		}
+	}
+	if (!regions) {
+		return -1;
+	}
+
+	MutexLock(&snapshot->mutex);
+	int consumer;
+	for (consumer = 0; consumer < mCORE_SNAPSHOT_MAX_CONSUMERS; ++consumer) {
+		if (!(snapshot->usedConsumers & (1 << consumer))) {
+			break;
+		}
+	}
+	if (consumer == mCORE_SNAPSHOT_MAX_CONSUMERS) {
+		MutexUnlock(&snapshot->mutex);
+		return -1;
+	}
+	size_t i;
+	for (i = 0; i < snapshot->nRegions; ++i) {
+		struct mCoreSnapshotRegion* region = &snapshot->regions[i];
+		if (!(regions & (1 << i)) || region->buffers[0]) {
+			continue;
+		}
+		// Buffers are only allocated once something wants the region, and then kept until deinit
+		region->size = _regionSize(snapshot->core, region->block);
+		region->buffers[0] = calloc(1, region->size);
+		region->buffers[1] = calloc(1, region->size);
+	}
+	snapshot->consumers[consumer] = regions;
+	snapshot->usedConsumers |= 1 << consumer;
+	snapshot->pendingConsumers |= 1 << consumer;
+	MutexUnlock(&snapshot->mutex);
+	return consumer;
+}
+
+void mCoreSnapshotRemoveConsumer(struct mCoreSnapshot* snapshot, int consumer) {
+	if (consumer < 0 || consumer >= mCORE_SNAPSHOT_MAX_CONSUMERS) {
+		return;
+	}
+	MutexLock(&snapshot->mutex);
+	snapshot->consumers[consumer] = 0;
+	snapshot->usedConsumers &= ~(1 << consumer);
+	snapshot->pendingConsumers &= ~(1 << consumer);
+	MutexUnlock(&snapshot->mutex);
+}
+
+void mCoreSnapshotRequest(struct mCoreSnapshot* snapshot, int consumer) {
+	if (consumer < 0 || consumer >= mCORE_SNAPSHOT_MAX_CONSUMERS) {
+		return;
+	}
+	MutexLock(&snapshot->mutex);
+	snapshot->pendingConsumers |= snapshot->usedConsumers & (1 << consumer);
+	MutexUnlock(&snapshot->mutex);
+}
+
+void mCoreSnapshotPublish(struct mCoreSnapshot* snapshot) {
+	uint32_t regions = 0;
+	MutexLock(&snapshot->mutex);
+	int consumer;
+	for (consumer = 0; consumer < mCORE_SNAPSHOT_MAX_CONSUMERS; ++consumer) {
+		if (snapshot->pendingConsumers & (1 << consumer)) {
+			regions |= snapshot->consumers[consumer];
+		}
+	}
+	snapshot->pendingConsumers = 0;
+	MutexUnlock(&snapshot->mutex);
+	if (!regions) {
+		return;
+	}
+
+	// Readers only ever look at the front buffers, so the back ones can be filled without the lock
+	struct mCore* core = snapshot->core;
+	size_t i;
+	for (i = 0; i < snapshot->nRegions; ++i) {
+		struct mCoreSnapshotRegion* region = &snapshot->regions[i];
+		if (regions & (1 << i)) {
+			_takeRegion(core, region, region->buffers[region->front ^ 1]);
+		}
+	}
+
+	int64_t frame = core->frameCounter(core);
+	MutexLock(&snapshot->mutex);
+	for (i = 0; i < snapshot->nRegions; ++i) {
+		struct mCoreSnapshotRegion* region = &snapshot->regions[i];
+		if (regions & (1 << i)) {
+			region->front ^= 1;
+			region->frame = frame;
+			++region->generation;
+		}
+	}
+	snapshot->frame = frame;
+	MutexUnlock(&snapshot->mutex);
+}
+
+const void* mCoreSnapshotAcquire(struct mCoreSnapshot* snapshot, size_t regionId, size_t* size, int64_t* frame) {
+	MutexLock(&snapshot->mutex);
+	if (regionId >= snapshot->nRegions) {
+		return NULL;
+	}
+	struct mCoreSnapshotRegion* region = &snapshot->regions[regionId];
+	if (region->frame < 0) {
+		return NULL;
+	}
+	if (size) {
+		*size = region->size;
+	}
+	if (frame) {
+		*frame = region->frame;
+	}
+	return region->buffers[region->front];
+}
+
+void mCoreSnapshotRelease(struct mCoreSnapshot* snapshot) {
+	MutexUnlock(&snapshot->mutex);
+}
+
+uint32_t mCoreSnapshotGeneration(struct mCoreSnapshot* snapshot, size_t region) {
+	uint32_t generation = 0;
+	MutexLock(&snapshot->mutex);
+	if (region < snapshot->nRegions) {
+		generation = snapshot->regions[region].generation;
+	}
+	MutexUnlock(&snapshot->mutex);
+	return generation;
+}
+
+bool mCoreSnapshotRead(struct mCoreSnapshot* snapshot, size_t region, size_t offset, void* out, size_t size) {
+	size_t regionSize;
+	const uint8_t* data = mCoreSnapshotAcquire(snapshot, region, &regionSize, NULL);
+	bool success = data && offset <= regionSize && size <= regionSize - offset;
+	if (success) {
+		memcpy(out, &data[offset], size);
+	}
+	mCoreSnapshotRelease(snapshot);
+	return success;
+}
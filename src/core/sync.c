@@ -7,6 +7,16 @@
 
 #include <mgba/core/blip_buf.h>
 
+#if !defined(DISABLE_THREADING) && (defined(_WIN32) || defined(USE_PTHREADS))
+#define SYNC_HOST_CLOCK
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+#endif
+
+// Set on the middle buffer's index while it holds a frame the display hasn't taken yet
+#define FRAME_FRESH 0x4
+
 static void _changeVideoSync(struct mCoreSync* sync, bool frameOn) {
 	// Make sure the video thread can process events while the GBA thread is paused
 	MutexLock(&sync->videoFrameMutex);
@@ -78,17 +88,246 @@ void mCoreSyncSetVideoSync(struct mCoreSync* sync, bool wait) {
 	_changeVideoSync(sync, wait);
 }
 
+#ifdef SYNC_HOST_CLOCK
+static int64_t _hostTime(void) {
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return counter.QuadPart / frequency.QuadPart * 1000000LL + counter.QuadPart % frequency.QuadPart * 1000000LL / frequency.QuadPart;
+#else
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	if (!clock_gettime(CLOCK_MONOTONIC, &ts)) {
+		return 1000000LL * ts.tv_sec + ts.tv_nsec / 1000;
+	}
+#endif
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return 1000000LL * tv.tv_sec + tv.tv_usec;
+#endif
+}
+#endif
+
+void mCoreSyncSetPowerSave(struct mCoreSync* sync, bool enable) {
+	if (!sync) {
+		return;
+	}
+	if (enable && !sync->powerSave) {
+		sync->powerSaveLastFrame = 0;
+		sync->powerSaveFrames = 0;
+		sync->powerSaveThrottled = 0;
+	}
+	sync->powerSave = enable;
+}
+
+bool mCoreSyncThrottleFrame(struct mCoreSync* sync, bool idle) {
+	if (!sync || !sync->powerSave) {
+		return false;
+	}
+	++sync->powerSaveFrames;
+#ifdef SYNC_HOST_CLOCK
+	int64_t now = _hostTime();
+	bool throttled = false;
+	// Without any sync the frontend wants frames as fast as they come, e.g. while fast forwarding
+	if (idle && sync->powerSaveLastFrame && sync->fpsTarget > 0 && (sync->audioWait || sync->videoFrameWait)) {
+		int64_t deadline = sync->powerSaveLastFrame + (int64_t) (1000000 / sync->fpsTarget);
+		MutexLock(&sync->videoFrameMutex);
+		// Interrupting the thread turns both waits off and wakes this up
+		while (deadline - now >= 1000 && (sync->audioWait || sync->videoFrameWait)) {
+			ConditionWaitTimed(&sync->videoFrameRequiredCond, &sync->videoFrameMutex, (deadline - now) / 1000);
+			now = _hostTime();
+		}
+		MutexUnlock(&sync->videoFrameMutex);
+		++sync->powerSaveThrottled;
+		throttled = true;
+	}
+	sync->powerSaveLastFrame = now;
+	return throttled;
+#else
+	UNUSED(idle);
+	return false;
+#endif
+}
+
+float mCoreSyncPowerSaveRatio(const struct mCoreSync* sync) {
+	if (!sync || !sync->powerSaveFrames) {
+		return 0;
+	}
+	return sync->powerSaveThrottled / (float) sync->powerSaveFrames;
+}
+
+void mCoreSyncPaceFrame(struct mCoreSync* sync) {
+	if (!sync) {
+		return;
+	}
+#ifdef SYNC_HOST_CLOCK
+	int64_t now = _hostTime();
+	// Video sync already waits for the display in mCoreSyncPostFrame
+	if (sync->paceLastFrame && sync->fpsTarget > 0 && sync->audioWait && !sync->videoFrameWait) {
+		int64_t deadline = sync->paceLastFrame + (int64_t) (1000000 / sync->fpsTarget);
+		MutexLock(&sync->videoFrameMutex);
+		while (deadline - now >= 1000 && sync->audioWait) {
+			ConditionWaitTimed(&sync->videoFrameRequiredCond, &sync->videoFrameMutex, (deadline - now) / 1000);
+			now = _hostTime();
+		}
+		MutexUnlock(&sync->videoFrameMutex);
+	}
+	sync->paceLastFrame = now;
+#endif
+}
+
+void mCoreSyncFrameExchangeInit(struct mCoreSync* sync) {
+	size_t i;
+	for (i = 0; i < mCORE_SYNC_FRAME_BUFFERS; ++i) {
+		sync->frames[i].pixels = calloc(mCORE_SYNC_FRAME_STRIDE * mCORE_SYNC_FRAME_STRIDE, sizeof(color_t));
+		sync->frames[i].width = 0;
+		sync->frames[i].height = 0;
+		sync->frames[i].sequence = 0;
+	}
+	sync->frameBack = 0;
+	sync->frameMiddle = 1;
+	sync->frameFront = 2;
+	sync->frameSequence = 0;
+	sync->frameExchange = true;
+}
+
+void mCoreSyncFrameExchangeDeinit(struct mCoreSync* sync) {
+	if (!sync->frameExchange) {
+		return;
+	}
+	size_t i;
+	for (i = 0; i < mCORE_SYNC_FRAME_BUFFERS; ++i) {
+		free(sync->frames[i].pixels);
+		sync->frames[i].pixels = NULL;
+	}
+	sync->frameExchange = false;
+}
+
+static int _exchangeMiddleFrame(struct mCoreSync* sync, int frame) {
+	while (true) {
+		int middle;
+		ATOMIC_LOAD(middle, sync->frameMiddle);
+		if (ATOMIC_CMPXCHG(sync->frameMiddle, middle, frame)) {
+			return middle;
+		}
+	}
+}
+
+void mCoreSyncPublishFrame(struct mCoreSync* sync, const color_t* pixels, size_t stride, unsigned width, unsigned height) {
+	if (!sync || !sync->frameExchange) {
+		return;
+	}
+	if (width > mCORE_SYNC_FRAME_STRIDE) {
+		width = mCORE_SYNC_FRAME_STRIDE;
+	}
+	if (height > mCORE_SYNC_FRAME_STRIDE) {
+		height = mCORE_SYNC_FRAME_STRIDE;
+	}
+
+	struct mCoreSyncFrame* back = &sync->frames[sync->frameBack];
+	unsigned y;
+	for (y = 0; y < height; ++y) {
+		memcpy(&back->pixels[y * mCORE_SYNC_FRAME_STRIDE], &pixels[y * stride], width * sizeof(color_t));
+	}
+	back->width = width;
+	back->height = height;
+	back->sequence = ++sync->frameSequence;
+
+	// Whatever was in the middle is either stale or already superseded, so it becomes the next back buffer
+	sync->frameBack = _exchangeMiddleFrame(sync, sync->frameBack | FRAME_FRESH) & ~FRAME_FRESH;
+}
+
+bool mCoreSyncAcquireFrame(struct mCoreSync* sync, const struct mCoreSyncFrame** frame) {
+	if (!sync || !sync->frameExchange) {
+		return false;
+	}
+	int middle;
+	ATOMIC_LOAD(middle, sync->frameMiddle);
+	bool fresh = middle & FRAME_FRESH;
+	if (fresh) {
+		// Only the display clears the fresh bit, so the buffer swapped out is still fresh
+		sync->frameFront = _exchangeMiddleFrame(sync, sync->frameFront) & ~FRAME_FRESH;
+	}
+	*frame = &sync->frames[sync->frameFront];
+	return fresh;
+}
+
+static void _audioBlocked(struct mCoreSync* sync, int64_t since) {
+	++sync->audioStats.blocks;
+#ifdef SYNC_HOST_CLOCK
+	sync->audioStats.blockedTime += _hostTime() - since;
+#else
+	UNUSED(since);
+#endif
+}
+
+static int64_t _audioBlockStart(void) {
+#ifdef SYNC_HOST_CLOCK
+	return _hostTime();
+#else
+	return 0;
+#endif
+}
+
+static bool _produceAudioRing(struct mCoreSync* sync) {
+	bool waited = false;
+	int64_t blockStart = 0;
+	while (true) {
+		if (!sync->audioPendingValid) {
+			if (blip_samples_avail(sync->audioLeft) < mCORE_SYNC_AUDIO_CHUNK) {
+				break;
+			}
+			blip_read_samples(sync->audioLeft, sync->audioPending, mCORE_SYNC_AUDIO_CHUNK, true);
+			blip_read_samples(sync->audioRight, &sync->audioPending[1], mCORE_SYNC_AUDIO_CHUNK, true);
+			sync->audioPendingValid = true;
+		}
+		if (RingFIFOWrite(&sync->audioRing, sync->audioPending, sizeof(sync->audioPending))) {
+			sync->audioPendingValid = false;
+			ATOMIC_ADD(sync->audioChunksWritten, 1);
+			continue;
+		}
+		if (!sync->audioWait) {
+			++sync->audioStats.overruns;
+			break;
+		}
+		if (!waited) {
+			blockStart = _audioBlockStart();
+			waited = true;
+		}
+		// The reader signals without taking the mutex, so a wakeup can slip past; don't sleep on it for long
+		ConditionWaitTimed(&sync->audioRequiredCond, &sync->audioBufferMutex, 5);
+	}
+	if (waited) {
+		_audioBlocked(sync, blockStart);
+	}
+	MutexUnlock(&sync->audioBufferMutex);
+	return waited;
+}
+
 bool mCoreSyncProduceAudio(struct mCoreSync* sync, const struct blip_t* buf, size_t samples) {
 	if (!sync) {
 		return true;
 	}
+	if (sync->audioRingOn) {
+		return _produceAudioRing(sync);
+	}
 
 	size_t produced = blip_samples_avail(buf);
 	size_t producedNew = produced;
-	while (sync->audioWait && producedNew >= samples) {
-		ConditionWait(&sync->audioRequiredCond, &sync->audioBufferMutex);
-		produced = producedNew;
-		producedNew = blip_samples_avail(buf);
+	if (producedNew >= samples) {
+		if (sync->audioWait) {
+			int64_t blockStart = _audioBlockStart();
+			while (sync->audioWait && producedNew >= samples) {
+				ConditionWait(&sync->audioRequiredCond, &sync->audioBufferMutex);
+				produced = producedNew;
+				producedNew = blip_samples_avail(buf);
+			}
+			_audioBlocked(sync, blockStart);
+		} else {
+			++sync->audioStats.overruns;
+		}
 	}
 	MutexUnlock(&sync->audioBufferMutex);
 	return producedNew != produced;
@@ -118,3 +357,108 @@ void mCoreSyncConsumeAudio(struct mCoreSync* sync) {
 	ConditionWake(&sync->audioRequiredCond);
 	MutexUnlock(&sync->audioBufferMutex);
 }
+
+void mCoreSyncAudioRingInit(struct mCoreSync* sync, struct blip_t* left, struct blip_t* right, size_t frames) {
+	// Chunks never straddle the end of the ring, so one slot's worth is lost to wrapping
+	size_t chunks = (frames + mCORE_SYNC_AUDIO_CHUNK - 1) / mCORE_SYNC_AUDIO_CHUNK + 1;
+	RingFIFOInit(&sync->audioRing, chunks * sizeof(sync->audioChunk));
+	sync->audioLeft = left;
+	sync->audioRight = right;
+	sync->audioRingFrames = (chunks - 1) * mCORE_SYNC_AUDIO_CHUNK;
+	sync->audioPendingValid = false;
+	sync->audioChunksWritten = 0;
+	sync->audioChunksRead = 0;
+	sync->audioChunkOffset = mCORE_SYNC_AUDIO_CHUNK;
+	mCoreSyncResetAudioStats(sync);
+	sync->audioRingOn = true;
+}
+
+void mCoreSyncAudioRingDeinit(struct mCoreSync* sync) {
+	if (!sync->audioRingOn) {
+		return;
+	}
+	RingFIFODeinit(&sync->audioRing);
+	sync->audioRingOn = false;
+}
+
+size_t mCoreSyncReadAudio(struct mCoreSync* sync, int16_t* samples, size_t frames) {
+	if (!sync || !sync->audioRingOn) {
+		return 0;
+	}
+	size_t fill = mCoreSyncAudioOccupancy(sync);
+	mCoreSyncAudioStatsRecordRead(&sync->audioStats, fill, sync->audioRingFrames, fill < frames);
+	size_t read = 0;
+	while (read < frames) {
+		if (sync->audioChunkOffset == mCORE_SYNC_AUDIO_CHUNK) {
+			if (!RingFIFORead(&sync->audioRing, sync->audioChunk, sizeof(sync->audioChunk))) {
+				break;
+			}
+			sync->audioChunkOffset = 0;
+			ATOMIC_ADD(sync->audioChunksRead, 1);
+		}
+		size_t count = mCORE_SYNC_AUDIO_CHUNK - sync->audioChunkOffset;
+		if (count > frames - read) {
+			count = frames - read;
+		}
+		memcpy(&samples[read * 2], &sync->audioChunk[sync->audioChunkOffset * 2], count * 2 * sizeof(*samples));
+		sync->audioChunkOffset += count;
+		read += count;
+	}
+	if (read) {
+		ConditionWake(&sync->audioRequiredCond);
+	}
+	return read;
+}
+
+size_t mCoreSyncAudioOccupancy(const struct mCoreSync* sync) {
+	if (!sync || !sync->audioRingOn) {
+		return 0;
+	}
+	int32_t written;
+	int32_t read;
+	ATOMIC_LOAD(written, sync->audioChunksWritten);
+	ATOMIC_LOAD(read, sync->audioChunksRead);
+	return ((uint32_t) written - (uint32_t) read) * mCORE_SYNC_AUDIO_CHUNK + mCORE_SYNC_AUDIO_CHUNK - sync->audioChunkOffset;
+}
+
+void mCoreSyncGetAudioStats(const struct mCoreSync* sync, struct mCoreSyncAudioStats* stats) {
+	memcpy(stats, &sync->audioStats, sizeof(*stats));
+}
+
+void mCoreSyncResetAudioStats(struct mCoreSync* sync) {
+	memset(&sync->audioStats, 0, sizeof(sync->audioStats));
+}
+
+void mCoreSyncAudioStatsRecordRead(struct mCoreSyncAudioStats* stats, size_t fill, size_t capacity, bool underrun) {
+	++stats->reads;
+	if (underrun) {
+		++stats->underruns;
+	}
+	size_t bucket = 0;
+	if (capacity) {
+		bucket = fill * mCORE_SYNC_AUDIO_HISTOGRAM / capacity;
+	}
+	if (bucket >= mCORE_SYNC_AUDIO_HISTOGRAM) {
+		bucket = mCORE_SYNC_AUDIO_HISTOGRAM - 1;
+	}
+	++stats->occupancy[bucket];
+}
+
+void mCoreSyncSetAudioRateControl(struct mCoreSync* sync, bool enable) {
+	sync->audioRateControl = enable;
+}
+
+double mCoreSyncAudioRateRatio(const struct mCoreSync* sync) {
+	if (!sync || !sync->audioRingOn || !sync->audioRateControl || !sync->audioRingFrames) {
+		return 1;
+	}
+	// Scales linearly with how far the fill is from the target, so the correction fades out as it gets there
+	double target = sync->audioRingFrames / 2.;
+	double error = (target - mCoreSyncAudioOccupancy(sync)) / target;
+	if (error > 1) {
+		error = 1;
+	} else if (error < -1) {
+		error = -1;
+	}
+	return 1 + error * mCORE_SYNC_AUDIO_RATE_DRIFT;
+}
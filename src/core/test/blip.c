@@ -0,0 +1,112 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/blip_buf.h>
+#include <mgba-util/crc32.h>
+
+#define BLIP_CLOCK_RATE 0x1000000
+#define BLIP_SAMPLE_RATE 32768
+#define BLIP_FRAME 280896
+#define BLIP_BUFFER 0x1000
+#define BLIP_FRAMES 600
+#define BLIP_DELTAS 2048
+
+typedef void (*BlipAddDelta)(blip_t*, unsigned int clock_time, int delta);
+
+static uint32_t _synthesize(BlipAddDelta add, bool stereo) {
+	blip_t* left = blip_new(BLIP_BUFFER);
+	blip_t* right = blip_new(BLIP_BUFFER);
+	blip_set_rates(left, BLIP_CLOCK_RATE, BLIP_SAMPLE_RATE);
+	blip_set_rates(right, BLIP_CLOCK_RATE, BLIP_SAMPLE_RATE);
+
+	static int16_t samples[BLIP_BUFFER * 2];
+	uint32_t crc = 0;
+	uint32_t seed = 1;
+	int lastLeft = 0;
+	int lastRight = 0;
+	int frame;
+	for (frame = 0; frame < BLIP_FRAMES; ++frame) {
+		int i;
+		for (i = 0; i < BLIP_DELTAS; ++i) {
+			seed = seed * 1103515245 + 12345;
+			unsigned when = (seed >> 8) % BLIP_FRAME;
+			// Full-scale swings, as produced by a square wave at maximum volume
+			int sample = (int16_t) (seed >> 16);
+			if (seed & 0x80) {
+				add(left, when, sample - lastLeft);
+				lastLeft = sample;
+			} else {
+				add(right, when, sample - lastRight);
+				lastRight = sample;
+			}
+		}
+		blip_end_frame(left, BLIP_FRAME);
+		blip_end_frame(right, BLIP_FRAME);
+		int produced;
+		if (stereo) {
+			produced = blip_read_samples(left, samples, BLIP_BUFFER, true);
+			assert_int_equal(blip_read_samples(right, &samples[1], BLIP_BUFFER, true), produced);
+			crc = crc32(crc, samples, produced * 2 * sizeof(*samples));
+		} else {
+			produced = blip_read_samples(left, samples, BLIP_BUFFER, false);
+			assert_int_equal(blip_read_samples(right, &samples[produced], BLIP_BUFFER, false), produced);
+			crc = crc32(crc, samples, produced * 2 * sizeof(*samples));
+		}
+		assert_int_equal(blip_samples_avail(left), 0);
+		assert_int_equal(blip_samples_avail(right), 0);
+	}
+
+	blip_delete(left);
+	blip_delete(right);
+	return crc;
+}
+
+// These also serve as microbenchmarks for the synthesis and read-out kernels
+M_TEST_DEFINE(addDeltaStereo) {
+	assert_int_equal(_synthesize(blip_add_delta, true), 0xB3D53371);
+}
+
+M_TEST_DEFINE(addDeltaMono) {
+	assert_int_equal(_synthesize(blip_add_delta, false), 0x73794DDD);
+}
+
+M_TEST_DEFINE(addDeltaFast) {
+	assert_int_equal(_synthesize(blip_add_delta_fast, true), 0x86AE70E4);
+}
+
+M_TEST_DEFINE(addDeltaNearest) {
+	assert_int_equal(_synthesize(blip_add_delta_nearest, true), 0x4FD64E4C);
+}
+
+M_TEST_DEFINE(readPartial) {
+	blip_t* blip = blip_new(BLIP_BUFFER);
+	blip_set_rates(blip, BLIP_CLOCK_RATE, BLIP_SAMPLE_RATE);
+	int16_t samples[64];
+	blip_add_delta(blip, 100, 0x4000);
+	blip_add_delta(blip, 2000, -0x4000);
+	blip_end_frame(blip, BLIP_FRAME);
+	int produced = blip_samples_avail(blip);
+	assert_true(produced > 64);
+	assert_int_equal(blip_read_samples(blip, samples, 64, false), 64);
+	int i;
+	bool nonzero = false;
+	for (i = 0; i < 64; ++i) {
+		nonzero = nonzero || samples[i];
+	}
+	assert_true(nonzero);
+	assert_int_equal(blip_samples_avail(blip), produced - 64);
+	blip_clear(blip);
+	assert_int_equal(blip_samples_avail(blip), 0);
+	blip_delete(blip);
+}
+
+M_TEST_SUITE_DEFINE(Blip,
+	cmocka_unit_test(addDeltaStereo),
+	cmocka_unit_test(addDeltaMono),
+	cmocka_unit_test(addDeltaFast),
+	cmocka_unit_test(addDeltaNearest),
+	cmocka_unit_test(readPartial))
@@ -0,0 +1,81 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/interface.h>
+
+#define COLOR_COUNT 0x8000
+
+static color_t* _allColors(void) {
+	color_t* colors = malloc(COLOR_COUNT * sizeof(*colors));
+	unsigned i;
+	for (i = 0; i < COLOR_COUNT; ++i) {
+		colors[i] = mColorFrom555(i);
+	}
+	return colors;
+}
+
+M_TEST_DEFINE(nativeNeedsNoConverter) {
+	assert_null(mColorGetRowConverter(mCOLOR_NATIVE));
+	assert_int_equal(mColorFormatBytes(mCOLOR_NATIVE), BYTES_PER_PIXEL);
+	// Nothing converts to formats with alpha in 16 bits, or to packed 24-bit ones
+	assert_null(mColorGetRowConverter(mCOLOR_ARGB5));
+	assert_null(mColorGetRowConverter(mCOLOR_RGB8));
+	assert_int_equal(mColorFormatBytes(mCOLOR_RGB8), 3);
+}
+
+M_TEST_DEFINE(convertTo555) {
+	color_t* colors = _allColors();
+	uint16_t* out = malloc(COLOR_COUNT * sizeof(*out));
+	unsigned i;
+
+	// Every format color_t can be in keeps all 15 bits, so this has to give them back
+	mColorRowConverter convert = mColorGetRowConverter(mCOLOR_BGR5);
+	if (convert) {
+		convert(out, colors, COLOR_COUNT);
+		for (i = 0; i < COLOR_COUNT; ++i) {
+			assert_int_equal(out[i], i);
+		}
+	}
+
+	convert = mColorGetRowConverter(mCOLOR_RGB5);
+	assert_non_null(convert);
+	convert(out, colors, COLOR_COUNT);
+	for (i = 0; i < COLOR_COUNT; ++i) {
+		assert_int_equal(out[i], (M_B5(i) | (M_G5(i) << 5) | (M_R5(i) << 10)));
+	}
+
+	free(out);
+	free(colors);
+}
+
+M_TEST_DEFINE(convertTo8888) {
+	color_t* colors = _allColors();
+	uint32_t* out = malloc(COLOR_COUNT * sizeof(*out));
+	unsigned i;
+
+	mColorRowConverter convert = mColorGetRowConverter(mCOLOR_ABGR8);
+	assert_non_null(convert);
+	convert(out, colors, COLOR_COUNT);
+	for (i = 0; i < COLOR_COUNT; ++i) {
+		assert_int_equal(out[i] & 0xFFF8F8F8, M_RGB5_TO_BGR8(i) | 0xFF000000);
+	}
+
+	convert = mColorGetRowConverter(mCOLOR_RGBX8);
+	assert_non_null(convert);
+	convert(out, colors, COLOR_COUNT);
+	for (i = 0; i < COLOR_COUNT; ++i) {
+		assert_int_equal(out[i] & 0xF8F8F800, M_RGB5_TO_RGB8(i) << 8);
+	}
+
+	free(out);
+	free(colors);
+}
+
+M_TEST_SUITE_DEFINE(mCoreInterface,
+	cmocka_unit_test(nativeNeedsNoConverter),
+	cmocka_unit_test(convertTo555),
+	cmocka_unit_test(convertTo8888))
@@ -0,0 +1,92 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/log-buffer.h>
+
+static void _post(struct mLogBuffer* buffer, int category, enum mLogLevel level, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	mLogBufferPost(buffer, category, level, format, args);
+	va_end(args);
+}
+
+M_TEST_DEFINE(coalesce) {
+	struct mLogBuffer buffer;
+	mLogBufferInit(&buffer, 8);
+	struct mLogBufferEntry entry;
+
+	int i;
+	for (i = 0; i < 5; ++i) {
+		_post(&buffer, 1, mLOG_WARN, "Bad read %X", 0x1234);
+	}
+	// The run isn't handed over until something else comes along
+	assert_false(mLogBufferRead(&buffer, &entry));
+	_post(&buffer, 1, mLOG_WARN, "Bad read %X", 0x5678);
+	_post(&buffer, 2, mLOG_WARN, "Bad read %X", 0x5678);
+	mLogBufferCommit(&buffer);
+
+	assert_true(mLogBufferRead(&buffer, &entry));
+	assert_int_equal(entry.category, 1);
+	assert_int_equal(entry.level, mLOG_WARN);
+	assert_int_equal(entry.repeats, 5);
+	assert_string_equal(entry.message, "Bad read 1234");
+	assert_true(mLogBufferRead(&buffer, &entry));
+	assert_int_equal(entry.repeats, 1);
+	assert_string_equal(entry.message, "Bad read 5678");
+	assert_true(mLogBufferRead(&buffer, &entry));
+	assert_int_equal(entry.category, 2);
+	assert_false(mLogBufferRead(&buffer, &entry));
+
+	mLogBufferDeinit(&buffer);
+}
+
+M_TEST_DEFINE(dropWhenFull) {
+	struct mLogBuffer buffer;
+	mLogBufferInit(&buffer, 4);
+	struct mLogBufferEntry entry;
+
+	int i;
+	for (i = 0; i < 6; ++i) {
+		_post(&buffer, 0, mLOG_INFO, "Message %i", i);
+		_post(&buffer, 0, mLOG_INFO, "Message %i", i);
+	}
+	mLogBufferCommit(&buffer);
+	for (i = 0; i < 4; ++i) {
+		assert_true(mLogBufferRead(&buffer, &entry));
+		assert_int_equal(entry.repeats, 2);
+	}
+	assert_false(mLogBufferRead(&buffer, &entry));
+	assert_int_equal(mLogBufferTakeDropped(&buffer), 4);
+	assert_int_equal(mLogBufferTakeDropped(&buffer), 0);
+
+	// Space frees up once the consumer catches up
+	_post(&buffer, 0, mLOG_INFO, "After");
+	mLogBufferCommit(&buffer);
+	assert_true(mLogBufferRead(&buffer, &entry));
+	assert_string_equal(entry.message, "After");
+
+	mLogBufferDeinit(&buffer);
+}
+
+M_TEST_DEFINE(truncateLong) {
+	struct mLogBuffer buffer;
+	mLogBufferInit(&buffer, 2);
+	struct mLogBufferEntry entry;
+	char longMessage[mLOG_BUFFER_MESSAGE_SIZE * 2];
+	memset(longMessage, 'a', sizeof(longMessage) - 1);
+	longMessage[sizeof(longMessage) - 1] = '\0';
+	_post(&buffer, 0, mLOG_INFO, "%s", longMessage);
+	mLogBufferCommit(&buffer);
+	assert_true(mLogBufferRead(&buffer, &entry));
+	assert_int_equal(strlen(entry.message), mLOG_BUFFER_MESSAGE_SIZE - 1);
+	mLogBufferDeinit(&buffer);
+}
+
+M_TEST_SUITE_DEFINE(mLogBuffer,
+	cmocka_unit_test(coalesce),
+	cmocka_unit_test(dropWhenFull),
+	cmocka_unit_test(truncateLong))
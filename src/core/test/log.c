@@ -0,0 +1,79 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/log.h>
+
+mLOG_DECLARE_CATEGORY(TEST);
+mLOG_DEFINE_CATEGORY(TEST, "Test", "test.log");
+
+static int _logged;
+static int _evaluated;
+
+static void _log(struct mLogger* logger, int category, enum mLogLevel level, const char* format, va_list args) {
+	UNUSED(logger);
+	UNUSED(category);
+	UNUSED(level);
+	UNUSED(format);
+	UNUSED(args);
+	++_logged;
+}
+
+static int _argument(void) {
+	++_evaluated;
+	return 0;
+}
+
+M_TEST_DEFINE(disabledLevels) {
+	assert_true(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_DEBUG));
+
+	struct mLogFilter a;
+	mLogFilterInit(&a);
+	mLogFilterSetDefaultLevels(&a, mLOG_ALL & ~mLOG_DEBUG);
+	mLogFilterSet(&a, "test.log", mLOG_WARN | mLOG_ERROR);
+	assert_false(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_DEBUG));
+	assert_false(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_INFO));
+	assert_true(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_WARN));
+
+	// A level is only turned away if every filter turns it away
+	struct mLogFilter b;
+	mLogFilterInit(&b);
+	assert_true(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_DEBUG));
+	mLogFilterDeinit(&b);
+	assert_false(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_DEBUG));
+
+	mLogFilterReset(&a, "test.log");
+	assert_true(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_INFO));
+	assert_false(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_DEBUG));
+
+	mLogFilterDeinit(&a);
+	assert_true(mLogLevelEnabled(_mLOG_CAT_TEST, mLOG_DEBUG));
+}
+
+M_TEST_DEFINE(skipDisabled) {
+	struct mLogger logger = { .log = _log };
+	struct mLogFilter filter;
+	mLogFilterInit(&filter);
+	mLogFilterSetDefaultLevels(&filter, mLOG_WARN);
+	logger.filter = &filter;
+	mLogSetDefaultLogger(&logger);
+	_logged = 0;
+	_evaluated = 0;
+
+	mLOG(TEST, DEBUG, "%i", _argument());
+	assert_int_equal(_logged, 0);
+	assert_int_equal(_evaluated, 0);
+	mLOG(TEST, WARN, "%i", _argument());
+	assert_int_equal(_logged, 1);
+	assert_int_equal(_evaluated, 1);
+
+	mLogSetDefaultLogger(NULL);
+	mLogFilterDeinit(&filter);
+}
+
+M_TEST_SUITE_DEFINE(mLog,
+	cmocka_unit_test(disabledLevels),
+	cmocka_unit_test(skipDisabled))
@@ -0,0 +1,197 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/core/interface.h>
+#include <mgba/core/mem-search.h>
+
+#define TEST_MEMORY_SIZE 0x1003
+#define TEST_MEMORY_BASE 0x02000000
+
+static uint8_t _memory[TEST_MEMORY_SIZE];
+
+static const struct mCoreMemoryBlock _blocks[] = {
+	{ 0, "ram", "RAM", "RAM", TEST_MEMORY_BASE, TEST_MEMORY_BASE + TEST_MEMORY_SIZE, TEST_MEMORY_SIZE, mCORE_MEMORY_RW },
+};
+
+static size_t _listMemoryBlocks(const struct mCore* core, const struct mCoreMemoryBlock** blocks) {
+	UNUSED(core);
+	*blocks = _blocks;
+	return 1;
+}
+
+static void* _getMemoryBlock(struct mCore* core, size_t id, size_t* sizeOut) {
+	UNUSED(core);
+	UNUSED(id);
+	*sizeOut = TEST_MEMORY_SIZE;
+	return _memory;
+}
+
+static void _fakeCore(struct mCore* core) {
+	memset(core, 0, sizeof(*core));
+	core->listMemoryBlocks = _listMemoryBlocks;
+	core->getMemoryBlock = _getMemoryBlock;
+}
+
+static void _fillMemory(uint32_t seed) {
+	size_t i;
+	for (i = 0; i < TEST_MEMORY_SIZE; ++i) {
+		seed = seed * 1103515245 + 12345;
+		// Few distinct values, so every op finds plenty of matches
+		_memory[i] = (seed >> 16) & 0x83;
+	}
+}
+
+static int32_t _value(size_t offset, int width) {
+	switch (width) {
+	case 1:
+		return _memory[offset];
+	case 2:
+		return _memory[offset] | (_memory[offset + 1] << 8);
+	default:
+		return (int32_t) (_memory[offset] | (_memory[offset + 1] << 8) | (_memory[offset + 2] << 16) | ((uint32_t) _memory[offset + 3] << 24));
+	}
+}
+
+static bool _matches(int32_t value, int32_t match, enum mCoreMemorySearchOp op) {
+	switch (op) {
+	case mCORE_MEMORY_SEARCH_GREATER:
+		return value > match;
+	case mCORE_MEMORY_SEARCH_LESS:
+		return value < match;
+	case mCORE_MEMORY_SEARCH_EQUAL:
+		return value == match;
+	default:
+		return true;
+	}
+}
+
+M_TEST_DEFINE(searchOps) {
+	static const enum mCoreMemorySearchOp ops[] = { mCORE_MEMORY_SEARCH_EQUAL, mCORE_MEMORY_SEARCH_GREATER, mCORE_MEMORY_SEARCH_LESS, mCORE_MEMORY_SEARCH_ANY };
+	static const int32_t matches[] = { 0, 0x81, 0x8381, 0x3, -0x7C7D7F80 };
+	struct mCore core;
+	_fakeCore(&core);
+	_fillMemory(1);
+	struct mCoreMemorySearchResults results;
+	mCoreMemorySearchResultsInit(&results, 0);
+
+	int width;
+	for (width = 1; width <= 4; width *= 2) {
+		size_t o;
+		for (o = 0; o < sizeof(ops) / sizeof(*ops); ++o) {
+			size_t m;
+			for (m = 0; m < sizeof(matches) / sizeof(*matches); ++m) {
+				struct mCoreMemorySearchParams params = {
+					.memoryFlags = mCORE_MEMORY_RW,
+					.type = mCORE_MEMORY_SEARCH_INT,
+					.op = ops[o],
+					.align = width,
+					.width = width,
+					.valueInt = matches[m]
+				};
+				int32_t match = matches[m];
+				if (width == 1) {
+					match = (uint8_t) match;
+				} else if (width == 2) {
+					match = (uint16_t) match;
+				}
+				mCoreMemorySearchResultsClear(&results);
+				mCoreMemorySearch(&core, &params, &results, 0);
+
+				size_t found = 0;
+				size_t offset;
+				for (offset = 0; offset + width <= TEST_MEMORY_SIZE; offset += width) {
+					if (!_matches(_value(offset, width), match, ops[o])) {
+						continue;
+					}
+					assert_true(found < mCoreMemorySearchResultsSize(&results));
+					const struct mCoreMemorySearchResult* res = mCoreMemorySearchResultsGetConstPointer(&results, found);
+					assert_int_equal(res->address, TEST_MEMORY_BASE + offset);
+					assert_int_equal(res->width, width);
+					assert_int_equal(res->oldValue, _value(offset, width));
+					++found;
+				}
+				assert_int_equal(mCoreMemorySearchResultsSize(&results), found);
+			}
+		}
+	}
+	mCoreMemorySearchResultsDeinit(&results);
+}
+
+M_TEST_DEFINE(searchLimit) {
+	struct mCore core;
+	_fakeCore(&core);
+	memset(_memory, 7, sizeof(_memory));
+	struct mCoreMemorySearchResults results;
+	mCoreMemorySearchResultsInit(&results, 0);
+	struct mCoreMemorySearchParams params = {
+		.memoryFlags = mCORE_MEMORY_RW,
+		.type = mCORE_MEMORY_SEARCH_INT,
+		.op = mCORE_MEMORY_SEARCH_EQUAL,
+		.align = 1,
+		.width = 1,
+		.valueInt = 7
+	};
+	mCoreMemorySearch(&core, &params, &results, 21);
+	assert_int_equal(mCoreMemorySearchResultsSize(&results), 21);
+	assert_int_equal(mCoreMemorySearchResultsGetPointer(&results, 20)->address, TEST_MEMORY_BASE + 20);
+	mCoreMemorySearchResultsDeinit(&results);
+}
+
+M_TEST_DEFINE(snapshotNarrow) {
+	struct mCore core;
+	_fakeCore(&core);
+	_fillMemory(2);
+	struct mCoreMemorySearchSnapshot snapshot;
+	mCoreMemorySearchSnapshotInit(&snapshot);
+	struct mCoreMemorySearchParams params = {
+		.memoryFlags = mCORE_MEMORY_RW,
+		.type = mCORE_MEMORY_SEARCH_INT,
+		.op = mCORE_MEMORY_SEARCH_ANY,
+		.align = 2,
+		.width = 2
+	};
+	mCoreMemorySearchSnapshotTake(&core, &params, &snapshot);
+	assert_int_equal(mCoreMemorySearchSnapshotSize(&snapshot), TEST_MEMORY_SIZE / 2);
+
+	// Nothing changed, so nothing is dropped for being unchanged either
+	params.op = mCORE_MEMORY_SEARCH_DELTA;
+	params.valueInt = 0;
+	mCoreMemorySearchSnapshotRepeat(&core, &params, &snapshot);
+	assert_int_equal(mCoreMemorySearchSnapshotSize(&snapshot), TEST_MEMORY_SIZE / 2);
+
+	_memory[0x10] += 3;
+	_memory[0x800] += 1;
+	_memory[0xFFE] -= 1;
+	params.op = mCORE_MEMORY_SEARCH_DELTA_ANY;
+	mCoreMemorySearchSnapshotRepeat(&core, &params, &snapshot);
+	assert_int_equal(mCoreMemorySearchSnapshotSize(&snapshot), 3);
+
+	_memory[0x800] += 1;
+	_memory[0xFFE] += 1;
+	params.op = mCORE_MEMORY_SEARCH_DELTA_POSITIVE;
+	mCoreMemorySearchSnapshotRepeat(&core, &params, &snapshot);
+	assert_int_equal(mCoreMemorySearchSnapshotSize(&snapshot), 2);
+
+	params.op = mCORE_MEMORY_SEARCH_EQUAL;
+	params.valueInt = _value(0x800, 2);
+	mCoreMemorySearchSnapshotRepeat(&core, &params, &snapshot);
+	assert_int_equal(mCoreMemorySearchSnapshotSize(&snapshot), 1);
+
+	struct mCoreMemorySearchResults results;
+	mCoreMemorySearchResultsInit(&results, 0);
+	assert_int_equal(mCoreMemorySearchSnapshotResults(&snapshot, &results, 0), 1);
+	assert_int_equal(mCoreMemorySearchResultsGetPointer(&results, 0)->address, TEST_MEMORY_BASE + 0x800);
+	assert_int_equal(mCoreMemorySearchResultsGetPointer(&results, 0)->oldValue, _value(0x800, 2));
+	mCoreMemorySearchResultsDeinit(&results);
+	mCoreMemorySearchSnapshotDeinit(&snapshot);
+}
+
+M_TEST_SUITE_DEFINE(mCoreMemorySearch,
+	cmocka_unit_test(searchOps),
+	cmocka_unit_test(searchLimit),
+	cmocka_unit_test(snapshotNarrow))
@@ -0,0 +1,94 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/core/mem-watch.h>
+
+#define TEST_MEMORY_SIZE 0x100
+
+static uint8_t _memory[TEST_MEMORY_SIZE];
+static uint32_t _frame;
+
+static uint32_t _busRead8(struct mCore* core, uint32_t address) {
+	UNUSED(core);
+	return _memory[address % TEST_MEMORY_SIZE];
+}
+
+static uint32_t _busRead16(struct mCore* core, uint32_t address) {
+	return _busRead8(core, address) | (_busRead8(core, address + 1) << 8);
+}
+
+static uint32_t _busRead32(struct mCore* core, uint32_t address) {
+	return _busRead16(core, address) | (_busRead16(core, address + 2) << 16);
+}
+
+static int32_t _frameCounter(const struct mCore* core) {
+	UNUSED(core);
+	return _frame;
+}
+
+static void _fakeCore(struct mCore* core) {
+	memset(core, 0, sizeof(*core));
+	core->busRead8 = _busRead8;
+	core->busRead16 = _busRead16;
+	core->busRead32 = _busRead32;
+	core->frameCounter = _frameCounter;
+	size_t i;
+	for (i = 0; i < TEST_MEMORY_SIZE; ++i) {
+		_memory[i] = i;
+	}
+}
+
+M_TEST_DEFINE(readBatch) {
+	struct mCore core;
+	_fakeCore(&core);
+	static const struct mCoreMemoryRead reads[] = {
+		{ 0x10, 4 },
+		{ 0x03, 1 },
+		{ 0x20, 3 },
+		{ 0x40, 2 },
+	};
+	uint8_t out[8];
+	assert_int_equal(mCoreMemoryReadBatchSize(reads, 4), 7);
+	assert_int_equal(mCoreMemoryReadBatch(&core, reads, 4, out), 7);
+	static const uint8_t expected[] = { 0x10, 0x11, 0x12, 0x13, 0x03, 0x40, 0x41 };
+	assert_memory_equal(out, expected, sizeof(expected));
+}
+
+M_TEST_DEFINE(watchSet) {
+	struct mCore core;
+	_fakeCore(&core);
+	struct mCoreMemoryWatchSet set;
+	mCoreMemoryWatchSetInit(&set);
+	assert_int_equal(mCoreMemoryWatchSetAdd(&set, 0x80, 2), 0);
+	assert_int_equal(mCoreMemoryWatchSetAdd(&set, 0x90, 5), -1);
+	int i;
+	for (i = 0; i < 40; ++i) {
+		assert_int_equal(mCoreMemoryWatchSetAdd(&set, i, 4), 2 + i * 4);
+	}
+	assert_int_equal(set.size, 162);
+
+	_frame = 7;
+	mCoreMemoryWatchSetTake(&core, &set);
+	assert_int_equal(set.frame, 7);
+	assert_int_equal(set.values[0], 0x80);
+	assert_int_equal(set.values[1], 0x81);
+	assert_int_equal(set.values[161], 39 + 3);
+
+	_memory[0x81] = 0;
+	assert_int_equal(set.values[1], 0x81);
+	mCoreMemoryWatchSetTake(&core, &set);
+	assert_int_equal(set.values[1], 0);
+
+	mCoreMemoryWatchSetClear(&set);
+	assert_int_equal(mCoreMemoryWatchSetAdd(&set, 0x10, 1), 0);
+	mCoreMemoryWatchSetDeinit(&set);
+}
+
+M_TEST_SUITE_DEFINE(mCoreMemoryWatch,
+	cmocka_unit_test(readBatch),
+	cmocka_unit_test(watchSet))
@@ -0,0 +1,136 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/savedata.h>
+#include <mgba-util/vfs.h>
+
+static int _syncs;
+
+static bool _countSync(struct VFile* vf, const void* buffer, size_t size) {
+	UNUSED(vf);
+	UNUSED(buffer);
+	UNUSED(size);
+	++_syncs;
+	return true;
+}
+
+static struct VFile* _countingVFile(void) {
+	struct VFile* vf = VFileMemChunk(NULL, 0);
+	vf->sync = _countSync;
+	_syncs = 0;
+	return vf;
+}
+
+static uint32_t _settle(struct mSavedataFlusher* flusher, uint32_t frame) {
+	uint32_t start = frame;
+	while (!mSavedataFlusherPoll(flusher, frame)) {
+		++frame;
+		assert_true(frame - start < 10 * mSAVEDATA_LAZY_INTERVAL);
+	}
+	return frame;
+}
+
+M_TEST_DEFINE(pollSettles) {
+	struct mSavedataFlusher flusher;
+	mSavedataFlusherInit(&flusher);
+	assert_false(mSavedataFlusherPoll(&flusher, 0));
+	mSavedataFlusherMarkDirty(&flusher);
+	uint32_t frame;
+	for (frame = 1; frame <= mSAVEDATA_CLEANUP_THRESHOLD + 1; ++frame) {
+		assert_false(mSavedataFlusherPoll(&flusher, frame));
+	}
+	assert_int_equal(flusher.generation, 0);
+	assert_true(mSavedataFlusherPoll(&flusher, frame));
+	assert_false(mSavedataFlusherPoll(&flusher, frame + 1));
+	assert_int_equal(flusher.generation, 1);
+
+	// Writes push the flush back
+	mSavedataFlusherMarkDirty(&flusher);
+	assert_false(mSavedataFlusherPoll(&flusher, 100));
+	mSavedataFlusherMarkDirty(&flusher);
+	assert_false(mSavedataFlusherPoll(&flusher, 110));
+	assert_false(mSavedataFlusherPoll(&flusher, 120));
+	assert_int_equal(_settle(&flusher, 120), 110 + mSAVEDATA_CLEANUP_THRESHOLD + 1);
+	assert_int_equal(flusher.generation, 2);
+	mSavedataFlusherDeinit(&flusher);
+}
+
+M_TEST_DEFINE(lazyBatches) {
+	struct mSavedataFlusher flusher;
+	mSavedataFlusherInit(&flusher);
+	flusher.durability = mSAVEDATA_DURABILITY_LAZY;
+	mSavedataFlusherMarkDirty(&flusher);
+	uint32_t first = _settle(&flusher, 0);
+	assert_true(first > mSAVEDATA_LAZY_INTERVAL);
+	mSavedataFlusherMarkDirty(&flusher);
+	uint32_t second = _settle(&flusher, first + 1);
+	assert_true(second - first > mSAVEDATA_LAZY_INTERVAL);
+	mSavedataFlusherDeinit(&flusher);
+}
+
+M_TEST_DEFINE(flushSyncs) {
+	uint8_t data[0x100] = { 0 };
+	struct VFile* vf = _countingVFile();
+	struct mSavedataFlusher flusher;
+	mSavedataFlusherInit(&flusher);
+	mSavedataFlusherFlush(&flusher, vf, data, sizeof(data));
+	mSavedataFlusherFlush(&flusher, vf, data, sizeof(data));
+	mSavedataFlusherWait(&flusher);
+	assert_int_equal(_syncs, 2);
+	mSavedataFlusherFinish(&flusher, vf, data, sizeof(data));
+	assert_int_equal(_syncs, 2);
+	mSavedataFlusherDeinit(&flusher);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(exitSyncsOnce) {
+	uint8_t data[0x100] = { 0 };
+	struct VFile* vf = _countingVFile();
+	struct mSavedataFlusher flusher;
+	mSavedataFlusherInit(&flusher);
+	flusher.durability = mSAVEDATA_DURABILITY_EXIT;
+	mSavedataFlusherFlush(&flusher, vf, data, sizeof(data));
+	mSavedataFlusherFlush(&flusher, vf, data, sizeof(data));
+	mSavedataFlusherWait(&flusher);
+	assert_int_equal(_syncs, 0);
+	mSavedataFlusherFinish(&flusher, vf, data, sizeof(data));
+	assert_int_equal(_syncs, 1);
+	mSavedataFlusherFinish(&flusher, vf, data, sizeof(data));
+	assert_int_equal(_syncs, 1);
+	mSavedataFlusherDeinit(&flusher);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(neverSyncs) {
+	uint8_t data[0x100] = { 0 };
+	struct VFile* vf = _countingVFile();
+	struct mSavedataFlusher flusher;
+	mSavedataFlusherInit(&flusher);
+	flusher.durability = mSAVEDATA_DURABILITY_NEVER;
+	mSavedataFlusherMarkDirty(&flusher);
+	mSavedataFlusherFlush(&flusher, vf, data, sizeof(data));
+	mSavedataFlusherFinish(&flusher, vf, data, sizeof(data));
+	assert_int_equal(_syncs, 0);
+	mSavedataFlusherDeinit(&flusher);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(durabilityNames) {
+	assert_int_equal(mSavedataDurabilityFromName("never"), mSAVEDATA_DURABILITY_NEVER);
+	assert_int_equal(mSavedataDurabilityFromName("Lazy"), mSAVEDATA_DURABILITY_LAZY);
+	assert_int_equal(mSavedataDurabilityFromName("flush"), mSAVEDATA_DURABILITY_FLUSH);
+	assert_int_equal(mSavedataDurabilityFromName("exit"), mSAVEDATA_DURABILITY_EXIT);
+	assert_int_equal(mSavedataDurabilityFromName("bogus"), mSAVEDATA_DURABILITY_FLUSH);
+}
+
+M_TEST_SUITE_DEFINE(mSavedataFlusher,
+	cmocka_unit_test(pollSettles),
+	cmocka_unit_test(lazyBatches),
+	cmocka_unit_test(flushSyncs),
+	cmocka_unit_test(exitSyncsOnce),
+	cmocka_unit_test(neverSyncs),
+	cmocka_unit_test(durabilityNames))
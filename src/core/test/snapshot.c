@@ -0,0 +1,138 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/core/snapshot.h>
+
+#define TEST_RAM_SIZE 0x40
+#define TEST_IO_SIZE 0x10
+
+static uint8_t _ram[TEST_RAM_SIZE];
+static uint8_t _io[TEST_IO_SIZE];
+static uint32_t _frame;
+
+static const struct mCoreMemoryBlock _blocks[] = {
+	{ -1, "mem", "All", "All", 0, 0x1000, 0x1000, mCORE_MEMORY_VIRTUAL },
+	{ 0, "rom", "ROM", "ROM", 0x000, 0x100, 0x100, mCORE_MEMORY_READ | mCORE_MEMORY_MAPPED },
+	{ 1, "ram", "RAM", "RAM", 0x100, 0x100 + TEST_RAM_SIZE, TEST_RAM_SIZE, mCORE_MEMORY_RW | mCORE_MEMORY_MAPPED },
+	{ 2, "io", "MMIO", "MMIO", 0x200, 0x200 + TEST_IO_SIZE, TEST_IO_SIZE, mCORE_MEMORY_RW | mCORE_MEMORY_MAPPED },
+};
+
+static size_t _listMemoryBlocks(const struct mCore* core, const struct mCoreMemoryBlock** blocks) {
+	UNUSED(core);
+	*blocks = _blocks;
+	return sizeof(_blocks) / sizeof(*_blocks);
+}
+
+static void* _getMemoryBlock(struct mCore* core, size_t id, size_t* sizeOut) {
+	UNUSED(core);
+	if (id != 1) {
+		return NULL;
+	}
+	*sizeOut = TEST_RAM_SIZE;
+	return _ram;
+}
+
+static uint32_t _rawRead16(struct mCore* core, uint32_t address, int segment) {
+	UNUSED(core);
+	UNUSED(segment);
+	address -= 0x200;
+	return _io[address] | (_io[address + 1] << 8);
+}
+
+static int32_t _frameCounter(const struct mCore* core) {
+	UNUSED(core);
+	return _frame;
+}
+
+static void _fakeCore(struct mCore* core) {
+	memset(core, 0, sizeof(*core));
+	core->listMemoryBlocks = _listMemoryBlocks;
+	core->getMemoryBlock = _getMemoryBlock;
+	core->rawRead16 = _rawRead16;
+	core->frameCounter = _frameCounter;
+	memset(_ram, 0x11, sizeof(_ram));
+	memset(_io, 0x22, sizeof(_io));
+	_frame = 0;
+}
+
+M_TEST_DEFINE(regions) {
+	struct mCore core;
+	_fakeCore(&core);
+	struct mCoreSnapshot snapshot;
+	mCoreSnapshotInit(&snapshot, &core);
+	assert_int_equal(snapshot.nRegions, 2);
+	assert_int_equal(mCoreSnapshotFindRegion(&snapshot, "ram"), 0);
+	assert_int_equal(mCoreSnapshotFindRegion(&snapshot, "io"), 1);
+	assert_int_equal(mCoreSnapshotFindRegion(&snapshot, "rom"), -1);
+	static const char* const none[] = { "rom", "mem", NULL };
+	assert_int_equal(mCoreSnapshotAddConsumer(&snapshot, none), -1);
+	mCoreSnapshotDeinit(&snapshot);
+}
+
+M_TEST_DEFINE(publishOnDemand) {
+	struct mCore core;
+	_fakeCore(&core);
+	struct mCoreSnapshot snapshot;
+	mCoreSnapshotInit(&snapshot, &core);
+	static const char* const ram[] = { "ram", NULL };
+	static const char* const io[] = { "io", NULL };
+	int ramConsumer = mCoreSnapshotAddConsumer(&snapshot, ram);
+	int ioConsumer = mCoreSnapshotAddConsumer(&snapshot, io);
+	assert_int_not_equal(ramConsumer, -1);
+	assert_int_not_equal(ioConsumer, -1);
+
+	uint8_t value;
+	assert_false(mCoreSnapshotRead(&snapshot, 0, 0, &value, 1));
+
+	// New consumers get a first copy without asking
+	_frame = 1;
+	mCoreSnapshotPublish(&snapshot);
+	assert_true(mCoreSnapshotRead(&snapshot, 0, 0, &value, 1));
+	assert_int_equal(value, 0x11);
+	assert_true(mCoreSnapshotRead(&snapshot, 1, TEST_IO_SIZE - 1, &value, 1));
+	assert_int_equal(value, 0x22);
+	assert_false(mCoreSnapshotRead(&snapshot, 1, TEST_IO_SIZE - 1, &value, 2));
+
+	// Only regions asked for again are taken
+	_frame = 2;
+	_ram[0] = 0x33;
+	_io[0] = 0x44;
+	mCoreSnapshotRequest(&snapshot, ioConsumer);
+	mCoreSnapshotPublish(&snapshot);
+	int64_t frame;
+	size_t size;
+	const uint8_t* data = mCoreSnapshotAcquire(&snapshot, 0, &size, &frame);
+	assert_non_null(data);
+	assert_int_equal(size, TEST_RAM_SIZE);
+	assert_int_equal(frame, 1);
+	assert_int_equal(data[0], 0x11);
+	mCoreSnapshotRelease(&snapshot);
+	data = mCoreSnapshotAcquire(&snapshot, 1, &size, &frame);
+	assert_non_null(data);
+	assert_int_equal(size, TEST_IO_SIZE);
+	assert_int_equal(frame, 2);
+	assert_int_equal(data[0], 0x44);
+	mCoreSnapshotRelease(&snapshot);
+	assert_int_equal(mCoreSnapshotGeneration(&snapshot, 0), 1);
+	assert_int_equal(mCoreSnapshotGeneration(&snapshot, 1), 2);
+
+	// Removed consumers stop their regions from being taken
+	_frame = 3;
+	_ram[0] = 0x55;
+	mCoreSnapshotRemoveConsumer(&snapshot, ramConsumer);
+	mCoreSnapshotRequest(&snapshot, ramConsumer);
+	mCoreSnapshotPublish(&snapshot);
+	assert_true(mCoreSnapshotRead(&snapshot, 0, 0, &value, 1));
+	assert_int_equal(value, 0x11);
+
+	mCoreSnapshotDeinit(&snapshot);
+}
+
+M_TEST_SUITE_DEFINE(mCoreSnapshot,
+	cmocka_unit_test(regions),
+	cmocka_unit_test(publishOnDemand))
@@ -0,0 +1,269 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/blip_buf.h>
+#include <mgba/core/sync.h>
+
+#define TEST_WIDTH 240
+#define TEST_HEIGHT 160
+#define TEST_FRAMES 2000
+#define TEST_AUDIO_RATE 32768
+#define TEST_AUDIO_LEVEL 1000
+
+static void _fillFrame(color_t* pixels, color_t value) {
+	size_t i;
+	for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; ++i) {
+		pixels[i] = value;
+	}
+}
+
+static bool _frameIs(const struct mCoreSyncFrame* frame, color_t value) {
+	unsigned x, y;
+	for (y = 0; y < frame->height; ++y) {
+		for (x = 0; x < frame->width; ++x) {
+			if (frame->pixels[y * mCORE_SYNC_FRAME_STRIDE + x] != value) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+M_TEST_DEFINE(newestFrame) {
+	struct mCoreSync sync = {0};
+	mCoreSyncFrameExchangeInit(&sync);
+	color_t* pixels = malloc(TEST_WIDTH * TEST_HEIGHT * sizeof(color_t));
+	const struct mCoreSyncFrame* frame;
+	assert_false(mCoreSyncAcquireFrame(&sync, &frame));
+
+	_fillFrame(pixels, 1);
+	mCoreSyncPublishFrame(&sync, pixels, TEST_WIDTH, TEST_WIDTH, TEST_HEIGHT);
+	assert_true(mCoreSyncAcquireFrame(&sync, &frame));
+	assert_int_equal(frame->width, TEST_WIDTH);
+	assert_int_equal(frame->height, TEST_HEIGHT);
+	assert_int_equal(frame->sequence, 1);
+	assert_true(_frameIs(frame, 1));
+	assert_false(mCoreSyncAcquireFrame(&sync, &frame));
+	assert_int_equal(frame->sequence, 1);
+
+	// Frames the display didn't get to are dropped in favor of the newest
+	_fillFrame(pixels, 2);
+	mCoreSyncPublishFrame(&sync, pixels, TEST_WIDTH, TEST_WIDTH, TEST_HEIGHT);
+	_fillFrame(pixels, 3);
+	mCoreSyncPublishFrame(&sync, pixels, TEST_WIDTH, TEST_WIDTH, TEST_HEIGHT);
+	_fillFrame(pixels, 4);
+	mCoreSyncPublishFrame(&sync, pixels, TEST_WIDTH, TEST_WIDTH, TEST_HEIGHT);
+	assert_true(_frameIs(frame, 1));
+	assert_true(mCoreSyncAcquireFrame(&sync, &frame));
+	assert_int_equal(frame->sequence, 4);
+	assert_true(_frameIs(frame, 4));
+
+	free(pixels);
+	mCoreSyncFrameExchangeDeinit(&sync);
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _producer(void* context) {
+	struct mCoreSync* sync = context;
+	color_t* pixels = malloc(TEST_WIDTH * TEST_HEIGHT * sizeof(color_t));
+	color_t i;
+	for (i = 1; i <= TEST_FRAMES; ++i) {
+		_fillFrame(pixels, i);
+		mCoreSyncPublishFrame(sync, pixels, TEST_WIDTH, TEST_WIDTH, TEST_HEIGHT);
+	}
+	free(pixels);
+	return 0;
+}
+#endif
+
+M_TEST_DEFINE(concurrentFrames) {
+#ifndef DISABLE_THREADING
+	struct mCoreSync sync = {0};
+	mCoreSyncFrameExchangeInit(&sync);
+	Thread thread;
+	assert_int_equal(ThreadCreate(&thread, _producer, &sync), 0);
+
+	uint32_t last = 0;
+	while (last < TEST_FRAMES) {
+		const struct mCoreSyncFrame* frame;
+		if (!mCoreSyncAcquireFrame(&sync, &frame)) {
+			continue;
+		}
+		// A frame is never torn, and never older than one already seen
+		assert_true(frame->sequence > last);
+		assert_true(_frameIs(frame, frame->sequence));
+		last = frame->sequence;
+	}
+	ThreadJoin(&thread);
+	mCoreSyncFrameExchangeDeinit(&sync);
+#endif
+}
+
+static void _initAudio(struct mCoreSync* sync, size_t frames) {
+	MutexInit(&sync->audioBufferMutex);
+	ConditionInit(&sync->audioRequiredCond);
+	struct blip_t* left = blip_new(TEST_AUDIO_RATE);
+	struct blip_t* right = blip_new(TEST_AUDIO_RATE);
+	blip_set_rates(left, TEST_AUDIO_RATE, TEST_AUDIO_RATE);
+	blip_set_rates(right, TEST_AUDIO_RATE, TEST_AUDIO_RATE);
+	// Mirrored levels on each side, so a frame that got pulled apart shows up
+	blip_add_delta(left, 0, TEST_AUDIO_LEVEL);
+	blip_add_delta(right, 0, -TEST_AUDIO_LEVEL);
+	mCoreSyncAudioRingInit(sync, left, right, frames);
+}
+
+static void _deinitAudio(struct mCoreSync* sync) {
+	blip_delete(sync->audioLeft);
+	blip_delete(sync->audioRight);
+	mCoreSyncAudioRingDeinit(sync);
+	ConditionDeinit(&sync->audioRequiredCond);
+	MutexDeinit(&sync->audioBufferMutex);
+}
+
+static void _produceAudio(struct mCoreSync* sync, unsigned frames) {
+	mCoreSyncLockAudio(sync);
+	blip_end_frame(sync->audioLeft, frames);
+	blip_end_frame(sync->audioRight, frames);
+	mCoreSyncProduceAudio(sync, sync->audioLeft, 0);
+}
+
+static size_t _unread(const struct mCoreSync* sync) {
+	return blip_samples_avail(sync->audioLeft) + (sync->audioPendingValid ? mCORE_SYNC_AUDIO_CHUNK : 0);
+}
+
+M_TEST_DEFINE(audioRing) {
+	struct mCoreSync sync = {0};
+	_initAudio(&sync, 256);
+	int16_t samples[512 * 2];
+	assert_int_equal(mCoreSyncAudioOccupancy(&sync), 0);
+	assert_int_equal(mCoreSyncReadAudio(&sync, samples, 64), 0);
+
+	// Only whole chunks move into the ring
+	_produceAudio(&sync, 200);
+	assert_int_equal(mCoreSyncAudioOccupancy(&sync), 192);
+	assert_int_equal(blip_samples_avail(sync.audioLeft), 8);
+	assert_int_equal(mCoreSyncReadAudio(&sync, samples, 100), 100);
+	assert_int_equal(mCoreSyncAudioOccupancy(&sync), 92);
+	size_t i;
+	for (i = 32; i < 100; ++i) {
+		assert_true(samples[i * 2] > TEST_AUDIO_LEVEL / 2);
+		assert_true(abs(samples[i * 2] + samples[i * 2 + 1]) <= 1);
+	}
+
+	// Without audio sync, whatever doesn't fit stays behind for later
+	_produceAudio(&sync, 400);
+	size_t occupancy = mCoreSyncAudioOccupancy(&sync);
+	assert_true(occupancy <= 256 + mCORE_SYNC_AUDIO_CHUNK);
+	assert_int_equal(occupancy + _unread(&sync), 600 - 100);
+	size_t read = 0;
+	size_t frames;
+	while ((frames = mCoreSyncReadAudio(&sync, samples, 37))) {
+		read += frames;
+	}
+	assert_int_equal(read, occupancy);
+	assert_int_equal(mCoreSyncAudioOccupancy(&sync), 0);
+
+	_produceAudio(&sync, 0);
+	assert_int_equal(mCoreSyncAudioOccupancy(&sync) + _unread(&sync) + read, 600 - 100);
+	_deinitAudio(&sync);
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _audioProducer(void* context) {
+	struct mCoreSync* sync = context;
+	unsigned i;
+	for (i = 0; i < TEST_AUDIO_RATE; i += 128) {
+		_produceAudio(sync, 128);
+	}
+	return 0;
+}
+#endif
+
+M_TEST_DEFINE(concurrentAudio) {
+#ifndef DISABLE_THREADING
+	struct mCoreSync sync = {0};
+	_initAudio(&sync, 512);
+	sync.audioWait = true;
+	Thread thread;
+	assert_int_equal(ThreadCreate(&thread, _audioProducer, &sync), 0);
+
+	// The producer blocks on a full ring, so no samples may be dropped
+	int16_t samples[100 * 2];
+	size_t read = 0;
+	while (read < TEST_AUDIO_RATE - mCORE_SYNC_AUDIO_CHUNK) {
+		size_t frames = mCoreSyncReadAudio(&sync, samples, 100);
+		size_t i;
+		for (i = 0; i < frames; ++i) {
+			assert_true(abs(samples[i * 2] + samples[i * 2 + 1]) <= 1);
+		}
+		read += frames;
+	}
+	ThreadJoin(&thread);
+	while (mCoreSyncReadAudio(&sync, samples, 100)) {
+		continue;
+	}
+	assert_true(read + _unread(&sync) <= TEST_AUDIO_RATE);
+	_deinitAudio(&sync);
+#endif
+}
+
+M_TEST_DEFINE(audioRateControl) {
+	struct mCoreSync sync = {0};
+	_initAudio(&sync, 256);
+	assert_true(mCoreSyncAudioRateRatio(&sync) == 1);
+
+	// An empty ring asks for as many extra samples as allowed...
+	mCoreSyncSetAudioRateControl(&sync, true);
+	assert_true(fabs(mCoreSyncAudioRateRatio(&sync) - (1 + mCORE_SYNC_AUDIO_RATE_DRIFT)) < 1e-9);
+
+	// ...half full is on target...
+	_produceAudio(&sync, 128);
+	assert_int_equal(mCoreSyncAudioOccupancy(&sync), 128);
+	assert_true(fabs(mCoreSyncAudioRateRatio(&sync) - 1) < 1e-9);
+
+	// ...and a full one asks for as few
+	_produceAudio(&sync, 256);
+	assert_true(fabs(mCoreSyncAudioRateRatio(&sync) - (1 - mCORE_SYNC_AUDIO_RATE_DRIFT)) < 1e-9);
+
+	mCoreSyncSetAudioRateControl(&sync, false);
+	assert_true(mCoreSyncAudioRateRatio(&sync) == 1);
+	_deinitAudio(&sync);
+}
+
+M_TEST_DEFINE(audioStats) {
+	struct mCoreSync sync = {0};
+	_initAudio(&sync, 256);
+	int16_t samples[256 * 2];
+	struct mCoreSyncAudioStats stats;
+
+	// Reading from an empty ring runs dry
+	mCoreSyncReadAudio(&sync, samples, 64);
+	// Filling it past the brim without audio sync leaves samples behind
+	_produceAudio(&sync, 400);
+	mCoreSyncReadAudio(&sync, samples, 64);
+	mCoreSyncGetAudioStats(&sync, &stats);
+	assert_int_equal(stats.reads, 2);
+	assert_int_equal(stats.underruns, 1);
+	assert_int_equal(stats.overruns, 1);
+	assert_int_equal(stats.blocks, 0);
+	assert_int_equal(stats.occupancy[0], 1);
+	assert_int_equal(stats.occupancy[mCORE_SYNC_AUDIO_HISTOGRAM - 1], 1);
+
+	mCoreSyncResetAudioStats(&sync);
+	mCoreSyncGetAudioStats(&sync, &stats);
+	assert_int_equal(stats.reads, 0);
+	assert_int_equal(stats.overruns, 0);
+	_deinitAudio(&sync);
+}
+
+M_TEST_SUITE_DEFINE(mCoreSync,
+	cmocka_unit_test(newestFrame),
+	cmocka_unit_test(concurrentFrames),
+	cmocka_unit_test(audioRing),
+	cmocka_unit_test(audioRateControl),
+	cmocka_unit_test(audioStats),
+	cmocka_unit_test(concurrentAudio))
@@ -0,0 +1,355 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/timing.h>
+
+#define CHURN_EVENTS 64
+#define CHURN_ROUNDS 200000
+
+struct TimingTestContext;
+struct TimingTestEvent {
+	struct mTimingEvent event;
+	struct TimingTestContext* ctx;
+	int id;
+};
+
+struct TimingTestContext {
+	struct mTiming timing;
+	int32_t relativeCycles;
+	int32_t nextEvent;
+
+	struct TimingTestEvent events[CHURN_EVENTS];
+	int fired[CHURN_EVENTS];
+	size_t nFired;
+	size_t pending;
+	uint32_t lastFired;
+	bool outOfOrder;
+};
+
+static void _fire(struct mTiming* timing, void* context, uint32_t cyclesLate) {
+	struct TimingTestEvent* event = context;
+	struct TimingTestContext* ctx = event->ctx;
+	uint32_t when = timing->masterCycles - cyclesLate;
+	if (ctx->nFired && (int32_t) (when - ctx->lastFired) < 0) {
+		ctx->outOfOrder = true;
+	}
+	ctx->lastFired = when;
+	ctx->fired[ctx->nFired % CHURN_EVENTS] = event->id;
+	++ctx->nFired;
+	--ctx->pending;
+}
+
+static struct mTimingEvent* _event(struct TimingTestContext* ctx, int id) {
+	return &ctx->events[id].event;
+}
+
+static void _schedule(struct TimingTestContext* ctx, int id, int32_t when) {
+	if (!mTimingIsScheduled(&ctx->timing, _event(ctx, id))) {
+		++ctx->pending;
+	}
+	mTimingSchedule(&ctx->timing, _event(ctx, id), when);
+}
+
+static void _deschedule(struct TimingTestContext* ctx, int id) {
+	if (mTimingIsScheduled(&ctx->timing, _event(ctx, id))) {
+		--ctx->pending;
+	}
+	mTimingDeschedule(&ctx->timing, _event(ctx, id));
+}
+
+static int32_t _tick(struct TimingTestContext* ctx, int32_t cycles) {
+	// Mirror the CPU loops, which reset nextEvent before ticking
+	ctx->nextEvent = INT_MAX;
+	return mTimingTick(&ctx->timing, cycles);
+}
+
+M_TEST_SUITE_SETUP(mTiming) {
+	struct TimingTestContext* ctx = calloc(1, sizeof(*ctx));
+	mTimingInit(&ctx->timing, &ctx->relativeCycles, &ctx->nextEvent);
+	int i;
+	for (i = 0; i < CHURN_EVENTS; ++i) {
+		ctx->events[i].event.context = &ctx->events[i];
+		ctx->events[i].event.name = "Test";
+		ctx->events[i].ctx = ctx;
+		ctx->events[i].id = i;
+	}
+	*state = ctx;
+	return 0;
+}
+
+M_TEST_SUITE_TEARDOWN(mTiming) {
+	struct TimingTestContext* ctx = *state;
+	mTimingDeinit(&ctx->timing);
+	free(ctx);
+	return 0;
+}
+
+static struct TimingTestContext* _reset(void** state) {
+	struct TimingTestContext* ctx = *state;
+	mTimingClear(&ctx->timing);
+	ctx->relativeCycles = 0;
+	ctx->nextEvent = INT_MAX;
+	ctx->nFired = 0;
+	ctx->pending = 0;
+	ctx->lastFired = 0;
+	ctx->outOfOrder = false;
+	int i;
+	for (i = 0; i < CHURN_EVENTS; ++i) {
+		ctx->events[i].event.callback = _fire;
+		ctx->events[i].event.priority = 0;
+	}
+	return ctx;
+}
+
+M_TEST_DEFINE(orderByTime) {
+	struct TimingTestContext* ctx = _reset(state);
+	_schedule(ctx, 0, 30);
+	_schedule(ctx, 1, 10);
+	_schedule(ctx, 2, 20);
+	assert_int_equal(ctx->nextEvent, 10);
+	assert_int_equal(mTimingNextEvent(&ctx->timing), 10);
+
+	assert_int_equal(_tick(ctx, 10), 10);
+	assert_int_equal(ctx->nFired, 1);
+	assert_int_equal(_tick(ctx, 20), INT_MAX);
+	assert_int_equal(ctx->nFired, 3);
+	assert_int_equal(ctx->fired[0], 1);
+	assert_int_equal(ctx->fired[1], 2);
+	assert_int_equal(ctx->fired[2], 0);
+}
+
+M_TEST_DEFINE(orderByPriority) {
+	struct TimingTestContext* ctx = _reset(state);
+	_event(ctx, 0)->priority = 2;
+	_event(ctx, 1)->priority = 0;
+	_event(ctx, 2)->priority = 1;
+	_schedule(ctx, 0, 10);
+	_schedule(ctx, 1, 10);
+	_schedule(ctx, 2, 10);
+	_tick(ctx, 10);
+	assert_int_equal(ctx->nFired, 3);
+	assert_int_equal(ctx->fired[0], 1);
+	assert_int_equal(ctx->fired[1], 2);
+	assert_int_equal(ctx->fired[2], 0);
+}
+
+M_TEST_DEFINE(orderByInsertion) {
+	struct TimingTestContext* ctx = _reset(state);
+	int i;
+	for (i = 0; i < 8; ++i) {
+		_schedule(ctx, i, 10);
+	}
+	// Rescheduling an event sends it to the back of its tie
+	_schedule(ctx, 3, 10);
+	_tick(ctx, 10);
+	assert_int_equal(ctx->nFired, 8);
+	assert_int_equal(ctx->fired[0], 0);
+	assert_int_equal(ctx->fired[1], 1);
+	assert_int_equal(ctx->fired[2], 2);
+	assert_int_equal(ctx->fired[3], 4);
+	assert_int_equal(ctx->fired[6], 7);
+	assert_int_equal(ctx->fired[7], 3);
+}
+
+M_TEST_DEFINE(deschedule) {
+	struct TimingTestContext* ctx = _reset(state);
+	_schedule(ctx, 0, 10);
+	_schedule(ctx, 1, 20);
+	assert_true(mTimingIsScheduled(&ctx->timing, _event(ctx, 0)));
+	assert_false(mTimingIsScheduled(&ctx->timing, _event(ctx, 2)));
+	_deschedule(ctx, 0);
+	_deschedule(ctx, 2);
+	assert_false(mTimingIsScheduled(&ctx->timing, _event(ctx, 0)));
+	assert_true(mTimingIsScheduled(&ctx->timing, _event(ctx, 1)));
+	assert_int_equal(mTimingNextEvent(&ctx->timing), 20);
+	_tick(ctx, 20);
+	assert_int_equal(ctx->nFired, 1);
+	assert_int_equal(ctx->fired[0], 1);
+	assert_int_equal(ctx->pending, 0);
+}
+
+M_TEST_DEFINE(reschedule) {
+	struct TimingTestContext* ctx = _reset(state);
+	_schedule(ctx, 0, 10);
+	_schedule(ctx, 1, 20);
+	_schedule(ctx, 0, 30);
+	assert_int_equal(mTimingUntil(&ctx->timing, _event(ctx, 0)), 30);
+	_tick(ctx, 30);
+	assert_int_equal(ctx->nFired, 2);
+	assert_int_equal(ctx->fired[0], 1);
+	assert_int_equal(ctx->fired[1], 0);
+}
+
+M_TEST_DEFINE(relativeCycles) {
+	struct TimingTestContext* ctx = _reset(state);
+	ctx->relativeCycles = 5;
+	_schedule(ctx, 0, 10);
+	assert_int_equal(ctx->nextEvent, 15);
+	assert_int_equal(mTimingUntil(&ctx->timing, _event(ctx, 0)), 10);
+	assert_int_equal(_tick(ctx, 14), 1);
+	assert_int_equal(ctx->nFired, 0);
+	ctx->relativeCycles = 0;
+	_tick(ctx, 3);
+	assert_int_equal(ctx->nFired, 1);
+	assert_int_equal(ctx->lastFired, 15);
+}
+
+static void _interrupt(struct mTiming* timing, void* context, uint32_t cyclesLate) {
+	_fire(timing, context, cyclesLate);
+	mTimingInterrupt(timing);
+}
+
+M_TEST_DEFINE(interrupt) {
+	struct TimingTestContext* ctx = _reset(state);
+	_event(ctx, 0)->callback = _interrupt;
+	_schedule(ctx, 0, 10);
+	_schedule(ctx, 1, 10);
+	assert_int_equal(_tick(ctx, 10), 0);
+	assert_int_equal(ctx->nFired, 1);
+	assert_true(mTimingIsScheduled(&ctx->timing, _event(ctx, 1)));
+	_tick(ctx, 0);
+	assert_int_equal(ctx->nFired, 2);
+}
+
+static uint64_t _fakeClock(void) {
+	static uint64_t now = 0;
+	now += 3;
+	return now;
+}
+
+M_TEST_DEFINE(stats) {
+	struct TimingTestContext* ctx = _reset(state);
+	_event(ctx, 1)->name = "Other";
+	mTimingEnableStats(&ctx->timing, _fakeClock);
+	_schedule(ctx, 0, 10);
+	_schedule(ctx, 1, 10);
+	_schedule(ctx, 2, 20);
+	_schedule(ctx, 0, 15);
+	_tick(ctx, 20);
+	mTimingDisableStats(&ctx->timing);
+	_schedule(ctx, 0, 10);
+	_tick(ctx, 10);
+	_event(ctx, 1)->name = "Test";
+
+	assert_int_equal(mTimingStatsSize(&ctx->timing), 2);
+	const struct mTimingEventStats* stats = mTimingStatsGet(&ctx->timing, 0);
+	assert_string_equal(stats->name, "Test");
+	assert_int_equal(stats->scheduled, 3);
+	assert_int_equal(stats->rescheduled, 1);
+	assert_int_equal(stats->fired, 2);
+	assert_int_equal(stats->hostTime, 6);
+	stats = mTimingStatsGet(&ctx->timing, 1);
+	assert_string_equal(stats->name, "Other");
+	assert_int_equal(stats->scheduled, 1);
+	assert_int_equal(stats->rescheduled, 0);
+	assert_int_equal(stats->fired, 1);
+	assert_null(mTimingStatsGet(&ctx->timing, 2));
+
+	mTimingResetStats(&ctx->timing);
+	assert_int_equal(mTimingStatsSize(&ctx->timing), 0);
+}
+
+static void _render(struct mTiming* timing, void* context, uint32_t cyclesLate) {
+	enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_RENDER_SCANLINE);
+	_fakeClock();
+	mTimingHostLeave(timing, category);
+	_fire(timing, context, cyclesLate);
+}
+
+M_TEST_DEFINE(hostBreakdown) {
+	struct TimingTestContext* ctx = _reset(state);
+	_event(ctx, 0)->callback = _render;
+	// Nothing is charged while stats are off
+	assert_int_equal(mTimingHostEnter(&ctx->timing, mTIMING_HOST_AUDIO), mTIMING_HOST_CPU);
+	mTimingHostLeave(&ctx->timing, mTIMING_HOST_CPU);
+
+	mTimingEnableStats(&ctx->timing, _fakeClock);
+	_schedule(ctx, 0, 10);
+	_schedule(ctx, 1, 10);
+	_tick(ctx, 10);
+	enum mTimingHostCategory category = mTimingHostEnter(&ctx->timing, mTIMING_HOST_IO);
+	mTimingHostLeave(&ctx->timing, category);
+	mTimingDisableStats(&ctx->timing);
+
+	// Each switch reads the clock once, and time spent nested is only counted where it was spent
+	assert_int_equal(mTimingHostTime(&ctx->timing, mTIMING_HOST_RENDER_SCANLINE), 6);
+	assert_int_equal(mTimingHostTime(&ctx->timing, mTIMING_HOST_EVENTS), 9);
+	assert_int_equal(mTimingHostTime(&ctx->timing, mTIMING_HOST_IO), 3);
+	assert_int_equal(mTimingHostTime(&ctx->timing, mTIMING_HOST_CPU), 12);
+	assert_int_equal(mTimingHostTime(&ctx->timing, mTIMING_HOST_AUDIO), 0);
+	assert_int_equal(mTimingHostTime(&ctx->timing, mTIMING_HOST_MAX), 0);
+	// Both events share a name, and their times still cover everything done inside the callbacks
+	assert_int_equal(mTimingStatsGet(&ctx->timing, 0)->hostTime, 15);
+	assert_string_equal(mTimingHostCategoryName(mTIMING_HOST_RENDER_SCANLINE), "render_scanline");
+
+	mTimingResetStats(&ctx->timing);
+	assert_int_equal(mTimingHostTime(&ctx->timing, mTIMING_HOST_EVENTS), 0);
+}
+
+M_TEST_DEFINE(waitCycles) {
+	struct TimingTestContext* ctx = _reset(state);
+	// Nothing is charged while stats are off
+	mTimingChargeWait(&ctx->timing, 8, mTIMING_WAIT_DATA_NONSEQ, 4);
+	assert_int_equal(mTimingWaitCycles(&ctx->timing, 8, mTIMING_WAIT_DATA_NONSEQ), 0);
+
+	mTimingEnableStats(&ctx->timing, _fakeClock);
+	mTimingChargeWait(&ctx->timing, 8, mTIMING_WAIT_DATA_NONSEQ, 4);
+	mTimingChargeWait(&ctx->timing, 8, mTIMING_WAIT_DATA_NONSEQ, 4);
+	mTimingChargeWait(&ctx->timing, 2, mTIMING_WAIT_CODE_SEQ, 2);
+	mTimingChargeWait(&ctx->timing, mTIMING_WAIT_REGIONS, mTIMING_WAIT_CODE_SEQ, 2);
+	mTimingDisableStats(&ctx->timing);
+
+	assert_int_equal(mTimingWaitCycles(&ctx->timing, 8, mTIMING_WAIT_DATA_NONSEQ), 8);
+	assert_int_equal(mTimingWaitCycles(&ctx->timing, 8, mTIMING_WAIT_DATA_SEQ), 0);
+	assert_int_equal(mTimingWaitCycles(&ctx->timing, 2, mTIMING_WAIT_CODE_SEQ), 2);
+	assert_int_equal(mTimingWaitCycles(&ctx->timing, mTIMING_WAIT_REGIONS, mTIMING_WAIT_CODE_SEQ), 0);
+	assert_string_equal(mTimingWaitAccessName(mTIMING_WAIT_PREFETCH_HIDDEN), "prefetch_hidden");
+
+	mTimingResetStats(&ctx->timing);
+	assert_int_equal(mTimingWaitCycles(&ctx->timing, 8, mTIMING_WAIT_DATA_NONSEQ), 0);
+}
+
+M_TEST_DEFINE(churn) {
+	// Also serves as a microbenchmark for schedule/deschedule-heavy workloads
+	struct TimingTestContext* ctx = _reset(state);
+	uint32_t seed = 1;
+	int i;
+	for (i = 0; i < CHURN_EVENTS; ++i) {
+		_event(ctx, i)->priority = i & 3;
+	}
+	for (i = 0; i < CHURN_ROUNDS; ++i) {
+		seed = seed * 1103515245 + 12345;
+		int id = (seed >> 16) % CHURN_EVENTS;
+		if ((seed >> 8) & 3) {
+			_schedule(ctx, id, (seed >> 4) & 0x3FF);
+		} else {
+			_deschedule(ctx, id);
+		}
+		if (!(i & 7)) {
+			_tick(ctx, (seed >> 12) & 0x3F);
+		}
+	}
+	assert_int_equal(_tick(ctx, 0x400), INT_MAX);
+	assert_false(ctx->outOfOrder);
+	assert_int_equal(ctx->pending, 0);
+	for (i = 0; i < CHURN_EVENTS; ++i) {
+		assert_false(mTimingIsScheduled(&ctx->timing, _event(ctx, i)));
+	}
+}
+
+M_TEST_SUITE_DEFINE_SETUP_TEARDOWN(mTiming,
+	cmocka_unit_test(orderByTime),
+	cmocka_unit_test(orderByPriority),
+	cmocka_unit_test(orderByInsertion),
+	cmocka_unit_test(deschedule),
+	cmocka_unit_test(reschedule),
+	cmocka_unit_test(relativeCycles),
+	cmocka_unit_test(interrupt),
+	cmocka_unit_test(stats),
+	cmocka_unit_test(hostBreakdown),
+	cmocka_unit_test(waitCycles),
+	cmocka_unit_test(churn))
@@ -122,6 +122,20 @@ void _frameEnded(void* context) {
 	if (thread->frameCallback) {
 		thread->frameCallback(thread);
 	}
+	struct mCore* core = thread->core;
+	struct mCoreSync* sync = &thread->impl->sync;
+	// Skipped and unchanged frames leave the newest published frame as it is
+	if (sync->frameExchange && (!sync->frameSequence || core->videoFrameChanged(core))) {
+		const void* pixels;
+		size_t stride;
+		unsigned width, height;
+		core->getPixels(core, &pixels, &stride);
+		core->desiredVideoDimensions(core, &width, &height);
+		mCoreSyncPublishFrame(sync, pixels, stride, width, height);
+	}
+	if (sync->powerSave) {
+		mCoreSyncThrottleFrame(sync, !core->videoFrameChanged(core));
+	}
 }
 
 void _crashed(void* context) {
@@ -142,6 +156,110 @@ void _coreSleep(void* context) {
 	}
 }
 
+ATTRIBUTE_FORMAT(printf, 2, 3)
+static void _logStatus(struct mLogger* logger, const char* format, ...) {
+	if (logger->filter && !mLogFilterTest(logger->filter, _mLOG_CAT_STATUS, mLOG_INFO)) {
+		return;
+	}
+	va_list args;
+	va_start(args, format);
+	logger->log(logger, _mLOG_CAT_STATUS, mLOG_INFO, format, args);
+	va_end(args);
+}
+
+static void _logAudioStats(struct mLogger* logger, const struct mCoreSync* sync) {
+	struct mCoreSyncAudioStats stats;
+	mCoreSyncGetAudioStats(sync, &stats);
+	if (!stats.reads && !stats.overruns && !stats.blocks) {
+		return;
+	}
+	_logStatus(logger, "Audio: %u underruns in %u reads, %u overruns, blocked %u times for %" PRIi64 " ms",
+	           stats.underruns, stats.reads, stats.overruns, stats.blocks, stats.blockedTime / 1000);
+	if (stats.reads) {
+		char histogram[mCORE_SYNC_AUDIO_HISTOGRAM * 8] = "";
+		size_t length = 0;
+		size_t i;
+		for (i = 0; i < mCORE_SYNC_AUDIO_HISTOGRAM; ++i) {
+			length += snprintf(&histogram[length], sizeof(histogram) - length, " %.0f%%", stats.occupancy[i] * 100.f / stats.reads);
+		}
+		_logStatus(logger, "Audio buffer fill, emptiest to fullest:%s", histogram);
+	}
+}
+
+static void _stateSaved(struct mCoreStateSaver* saver, int slot, bool success) {
+	struct mCoreThread* threadContext = saver->context;
+	// The writer thread has no logger of its own, so report through the core thread's
+	if (success) {
+		_logStatus(&threadContext->logger.d, "State %i saved", slot);
+	} else {
+		_logStatus(&threadContext->logger.d, "State %i failed to save", slot);
+	}
+	if (threadContext->stateSavedCallback) {
+		threadContext->stateSavedCallback(threadContext, slot, success);
+	}
+}
+
+static void _placeThread(struct mCoreThread* threadContext) {
+	int core = -1;
+	switch (threadContext->emulationAffinity) {
+	case mCORE_THREAD_AFFINITY_ANY:
+		break;
+	case mCORE_THREAD_AFFINITY_FASTEST:
+		core = ThreadFastestCore();
+		break;
+	case mCORE_THREAD_AFFINITY_CORE:
+		core = threadContext->emulationCore;
+		break;
+	}
+	// Helpers started from here on would otherwise inherit the pinning
+	if (core >= 0 && !ThreadSetCore(core)) {
+		ThreadClaimCore(core, threadContext->isolateEmulationCore);
+	}
+	if (threadContext->emulationPriority != THREAD_PRIO_NORMAL) {
+		ThreadSetPriority(threadContext->emulationPriority);
+	}
+}
+
+// Roughly tens of microseconds, which covers a lockstep partner catching up to a sync point
+#define WAIT_SPIN_POLLS 0x4000
+// Wide and tall enough for any core's frames
+#define REWIND_FRAME_STRIDE 256
+
+// Called and returns with the state mutex held; true if the wait ended while polling
+static bool _spinWhileWaiting(struct mCoreThreadInternal* impl) {
+	enum mCoreThreadState state = THREAD_WAITING;
+	int i;
+	MutexUnlock(&impl->stateMutex);
+	for (i = 0; i < WAIT_SPIN_POLLS && state == THREAD_WAITING; ++i) {
+		ATOMIC_LOAD(state, impl->state);
+	}
+	MutexLock(&impl->stateMutex);
+	return state != THREAD_WAITING;
+}
+
+// Shows the frame kept with each older state in place of emulating it again
+static void _rewindPlayback(struct mCoreThread* threadContext) {
+	struct mCoreThreadInternal* impl = threadContext->impl;
+	struct mCore* core = threadContext->core;
+	if (mCoreRewindStep(&impl->rewind)) {
+		impl->rewindStepped = true;
+		if (!impl->rewindFrame) {
+			impl->rewindFrame = calloc(REWIND_FRAME_STRIDE * REWIND_FRAME_STRIDE, sizeof(color_t));
+		}
+		if (impl->rewindFrame && mCoreRewindDrawFrame(&impl->rewind, impl->rewindFrame, REWIND_FRAME_STRIDE)) {
+			core->putPixels(core, impl->rewindFrame, REWIND_FRAME_STRIDE);
+		}
+	}
+	mCoreSyncPostFrame(&impl->sync);
+	_frameEnded(threadContext);
+	mCoreSyncPaceFrame(&impl->sync);
+}
+
+static void _rewindLand(struct mCoreThread* threadContext) {
+	mCoreRewindLoad(&threadContext->impl->rewind, threadContext->core);
+	threadContext->impl->rewindStepped = false;
+}
+
 static THREAD_ENTRY _mCoreThreadRun(void* context) {
 	struct mCoreThread* threadContext = context;
 #ifdef USE_PTHREADS
@@ -153,6 +271,7 @@ static THREAD_ENTRY _mCoreThreadRun(void* context) {
 #endif
 
 	ThreadSetName("CPU Thread");
+	_placeThread(threadContext);
 
 #if !defined(_WIN32) && defined(USE_PTHREADS)
 	sigset_t signals;
@@ -179,6 +298,9 @@ static THREAD_ENTRY _mCoreThreadRun(void* context) {
 	}
 
 	mCoreThreadRewindParamsChanged(threadContext);
+	mCoreStateSaverInit(&threadContext->impl->stateSaver, true);
+	threadContext->impl->stateSaver.callback = _stateSaved;
+	threadContext->impl->stateSaver.context = threadContext;
 	if (threadContext->startCallback) {
 		threadContext->startCallback(threadContext);
 	}
@@ -203,9 +325,20 @@ static THREAD_ENTRY _mCoreThreadRun(void* context) {
 #endif
 		{
 			while (impl->state <= THREAD_MAX_RUNNING) {
+				if (impl->state == THREAD_REWINDING && impl->rewind.storeFrames) {
+					_rewindPlayback(threadContext);
+					continue;
+				}
+				if (impl->rewindStepped) {
+					_rewindLand(threadContext);
+				}
 				core->runLoop(core);
 			}
 		}
+		// Anything run while interrupted has to see the state playback ended on
+		if (impl->rewindStepped) {
+			_rewindLand(threadContext);
+		}
 
 		enum mCoreThreadState deferred = THREAD_RUNNING;
 		MutexLock(&impl->stateMutex);
@@ -235,7 +368,14 @@ static THREAD_ENTRY _mCoreThreadRun(void* context) {
 			if (deferred == THREAD_INTERRUPTED) {
 				deferred = impl->savedState;
 			}
+			bool spun = false;
 			while (impl->state >= THREAD_WAITING && impl->state <= THREAD_MAX_WAITING) {
+				if (!spun && impl->state == THREAD_WAITING && threadContext->spinOnWait) {
+					spun = true;
+					if (_spinWhileWaiting(impl)) {
+						continue;
+					}
+				}
 				ConditionWait(&impl->stateCond, &impl->stateMutex);
 
 				if (impl->sync.audioWait) {
@@ -282,6 +422,17 @@ static THREAD_ENTRY _mCoreThreadRun(void* context) {
 	if (core->opts.rewindEnable) {
 		 mCoreRewindContextDeinit(&impl->rewind);
 	}
+	free(impl->rewindFrame);
+	impl->rewindFrame = NULL;
+	mCoreStateSaverDeinit(&impl->stateSaver);
+
+	if (impl->sync.powerSave) {
+		_logStatus(&threadContext->logger.d, "Power saving held back %.1f%% of frames", mCoreSyncPowerSaveRatio(&impl->sync) * 100.f);
+	}
+	_logAudioStats(&threadContext->logger.d, &impl->sync);
+	if (threadContext->emulationAffinity != mCORE_THREAD_AFFINITY_ANY) {
+		ThreadReleaseCore();
+	}
 
 	if (threadContext->cleanCallback) {
 		threadContext->cleanCallback(threadContext);
@@ -317,6 +468,13 @@ bool mCoreThreadStart(struct mCoreThread* threadContext) {
 	ConditionInit(&threadContext->impl->sync.videoFrameRequiredCond);
 	MutexInit(&threadContext->impl->sync.audioBufferMutex);
 	ConditionInit(&threadContext->impl->sync.audioRequiredCond);
+	if (threadContext->frameExchange) {
+		mCoreSyncFrameExchangeInit(&threadContext->impl->sync);
+	}
+	if (threadContext->audioRing) {
+		struct mCore* core = threadContext->core;
+		mCoreSyncAudioRingInit(&threadContext->impl->sync, core->getAudioChannel(core, 0), core->getAudioChannel(core, 1), core->getAudioBufferSize(core));
+	}
 
 	threadContext->impl->interruptDepth = 0;
 
@@ -331,6 +489,8 @@ bool mCoreThreadStart(struct mCoreThread* threadContext) {
 	threadContext->impl->sync.audioWait = threadContext->core->opts.audioSync;
 	threadContext->impl->sync.videoFrameWait = threadContext->core->opts.videoSync;
 	threadContext->impl->sync.fpsTarget = threadContext->core->opts.fpsTarget;
+	mCoreSyncSetPowerSave(&threadContext->impl->sync, threadContext->powerSave);
+	mCoreSyncSetAudioRateControl(&threadContext->impl->sync, threadContext->audioRateControl);
 
 	MutexLock(&threadContext->impl->stateMutex);
 	ThreadCreate(&threadContext->impl->thread, _mCoreThreadRun, threadContext);
@@ -429,6 +589,8 @@ void mCoreThreadJoin(struct mCoreThread* threadContext) {
 	ConditionWake(&threadContext->impl->sync.audioRequiredCond);
 	ConditionDeinit(&threadContext->impl->sync.audioRequiredCond);
 	MutexDeinit(&threadContext->impl->sync.audioBufferMutex);
+	mCoreSyncFrameExchangeDeinit(&threadContext->impl->sync);
+	mCoreSyncAudioRingDeinit(&threadContext->impl->sync);
 
 	free(threadContext->impl);
 	threadContext->impl = NULL;
@@ -596,11 +758,28 @@ void mCoreThreadRewindParamsChanged(struct mCoreThread* threadContext) {
 	struct mCore* core = threadContext->core;
 	if (core->opts.rewindEnable && core->opts.rewindBufferCapacity > 0) {
 		 mCoreRewindContextInit(&threadContext->impl->rewind, core->opts.rewindBufferCapacity, true);
+		 threadContext->impl->rewind.memoryLimit = core->opts.rewindBufferMemory > 0 ? (size_t) core->opts.rewindBufferMemory << 20 : 0;
+		 threadContext->impl->rewind.storeFrames = core->opts.rewindFrames;
 	} else {
 		 mCoreRewindContextDeinit(&threadContext->impl->rewind);
 	}
 }
 
+bool mCoreThreadSaveState(struct mCoreThread* threadContext, int slot, int flags) {
+#if !defined(MINIMAL_CORE) || MINIMAL_CORE < 2
+	struct VFile* vf = mCoreGetState(threadContext->core, slot, true);
+	if (!vf) {
+		return false;
+	}
+	return mCoreStateSaverSave(&threadContext->impl->stateSaver, threadContext->core, vf, flags, slot);
+#else
+	UNUSED(threadContext);
+	UNUSED(slot);
+	UNUSED(flags);
+	return false;
+#endif
+}
+
 void mCoreThreadWaitFromThread(struct mCoreThread* threadContext) {
 	MutexLock(&threadContext->impl->stateMutex);
 	if (threadContext->impl->interruptDepth && threadContext->impl->savedState == THREAD_RUNNING) {
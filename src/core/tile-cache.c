@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/core/tile-cache.h>
 
+#include <mgba-util/hash.h>
 #include <mgba-util/memory.h>
 
 void mTileCacheInit(struct mTileCache* cache) {
@@ -85,7 +86,6 @@ void mTileCacheWriteVRAM(struct mTileCache* cache, uint32_t address) {
 	size_t i;
 	for (i = 0; i < count; ++i) {
 		cache->status[address * count + i].vramClean = 0;
-		++cache->status[address * count + i].vramVersion;
 	}
 }
 
@@ -211,63 +211,61 @@ static inline color_t* _tileLookup(struct mTileCache* cache, unsigned tileId, un
 	}
 }
 
+static bool _updateStatus(struct mTileCache* cache, struct mTileCacheEntry* status, unsigned tileId, unsigned paletteId) {
+	bool dirty = false;
+	if (!status->vramClean) {
+		// VRAM writes only flag the tile, so only count it as changed if the data actually differs
+		uint32_t hash = hash32(&cache->vram[tileId << (cache->bpp + 2)], 8 << cache->bpp, 0);
+		if (!status->vramVersion || hash != status->vramHash) {
+			status->vramHash = hash;
+			++status->vramVersion;
+			dirty = true;
+		}
+		status->vramClean = 1;
+	}
+	if (status->paletteVersion != cache->globalPaletteVersion[paletteId] || status->paletteId != paletteId) {
+		status->paletteVersion = cache->globalPaletteVersion[paletteId];
+		status->paletteId = paletteId;
+		dirty = true;
+	}
+	return dirty;
+}
+
+static bool _regenerateTile(struct mTileCache* cache, color_t* tile, unsigned tileId, unsigned paletteId) {
+	switch (cache->bpp) {
+	case 0:
+		return false;
+	case 1:
+		_regenerateTile4(cache, tile, tileId, paletteId);
+		break;
+	case 2:
+		_regenerateTile16(cache, tile, tileId, paletteId);
+		break;
+	case 3:
+		_regenerateTile256(cache, tile, tileId, paletteId);
+		break;
+	}
+	return true;
+}
+
 const color_t* mTileCacheGetTile(struct mTileCache* cache, unsigned tileId, unsigned paletteId) {
-	unsigned count = cache->entriesPerTile;
-	unsigned bpp = cache->bpp;
-	struct mTileCacheEntry* status = &cache->status[tileId * count + paletteId];
-	struct mTileCacheEntry desiredStatus = {
-		.paletteVersion = cache->globalPaletteVersion[paletteId],
-		.vramVersion = status->vramVersion,
-		.vramClean = 1,
-		.paletteId = paletteId
-	};
+	struct mTileCacheEntry* status = &cache->status[tileId * cache->entriesPerTile + paletteId];
 	color_t* tile = _tileLookup(cache, tileId, paletteId);
-	if (!mTileCacheConfigurationIsShouldStore(cache->config) || memcmp(status, &desiredStatus, sizeof(*status))) {
-		switch (bpp) {
-		case 0:
-			return NULL;
-		case 1:
-			_regenerateTile4(cache, tile, tileId, paletteId);
-			break;
-		case 2:
-			_regenerateTile16(cache, tile, tileId, paletteId);
-			break;
-		case 3:
-			_regenerateTile256(cache, tile, tileId, paletteId);
-			break;
-		}
-		*status = desiredStatus;
+	bool dirty = _updateStatus(cache, status, tileId, paletteId);
+	if ((dirty || !mTileCacheConfigurationIsShouldStore(cache->config)) && !_regenerateTile(cache, tile, tileId, paletteId)) {
+		return NULL;
 	}
 	return tile;
 }
 
 const color_t* mTileCacheGetTileIfDirty(struct mTileCache* cache, struct mTileCacheEntry* entry, unsigned tileId, unsigned paletteId) {
-	unsigned count = cache->entriesPerTile;
-	unsigned bpp = cache->bpp;
-	struct mTileCacheEntry* status = &cache->status[tileId * count + paletteId];
-	struct mTileCacheEntry desiredStatus = {
-		.paletteVersion = cache->globalPaletteVersion[paletteId],
-		.vramVersion = status->vramVersion,
-		.vramClean = 1,
-		.paletteId = paletteId
-	};
+	struct mTileCacheEntry* status = &cache->status[tileId * cache->entriesPerTile + paletteId];
 	color_t* tile = NULL;
-	if (memcmp(status, &desiredStatus, sizeof(*status))) {
+	if (_updateStatus(cache, status, tileId, paletteId)) {
 		tile = _tileLookup(cache, tileId, paletteId);
-		switch (bpp) {
-		case 0:
+		if (!_regenerateTile(cache, tile, tileId, paletteId)) {
 			return NULL;
-		case 1:
-			_regenerateTile4(cache, tile, tileId, paletteId);
-			break;
-		case 2:
-			_regenerateTile16(cache, tile, tileId, paletteId);
-			break;
-		case 3:
-			_regenerateTile256(cache, tile, tileId, paletteId);
-			break;
 		}
-		*status = desiredStatus;
 	}
 	if (memcmp(status, &entry[paletteId], sizeof(*status))) {
 		tile = _tileLookup(cache, tileId, paletteId);
@@ -5,96 +5,200 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/core/timing.h>
 
+DEFINE_VECTOR(mTimingEventHeap, struct mTimingEvent*);
+DEFINE_VECTOR(mTimingEventStatsList, struct mTimingEventStats);
+
+static inline bool _eventBefore(const struct mTiming* timing, const struct mTimingEvent* a, const struct mTimingEvent* b) {
+	int32_t aWhen = a->when - timing->masterCycles;
+	int32_t bWhen = b->when - timing->masterCycles;
+	if (aWhen != bWhen) {
+		return aWhen < bWhen;
+	}
+	if (a->priority != b->priority) {
+		return a->priority < b->priority;
+	}
+	return (int32_t) (a->order - b->order) < 0;
+}
+
+// The heap is walked directly rather than through the vector accessors, as
+// those are exported and can't be inlined into the scheduler's hot paths
+static inline void _eventPlace(struct mTiming* timing, struct mTimingEvent* event, size_t index) {
+	timing->events.vector[index] = event;
+	event->index = index;
+}
+
+static inline bool _eventIsScheduled(const struct mTiming* timing, const struct mTimingEvent* event) {
+	return event->index < timing->events.size && timing->events.vector[event->index] == event;
+}
+
+static void _siftUp(struct mTiming* timing, size_t index) {
+	struct mTimingEvent* event = timing->events.vector[index];
+	while (index) {
+		size_t parentIndex = (index - 1) >> 1;
+		struct mTimingEvent* parent = timing->events.vector[parentIndex];
+		if (!_eventBefore(timing, event, parent)) {
+			break;
+		}
+		_eventPlace(timing, parent, index);
+		index = parentIndex;
+	}
+	_eventPlace(timing, event, index);
+}
+
+static void _siftDown(struct mTiming* timing, size_t index) {
+	size_t size = timing->events.size;
+	struct mTimingEvent* event = timing->events.vector[index];
+	while (true) {
+		size_t childIndex = index * 2 + 1;
+		if (childIndex >= size) {
+			break;
+		}
+		struct mTimingEvent* child = timing->events.vector[childIndex];
+		if (childIndex + 1 < size) {
+			struct mTimingEvent* sibling = timing->events.vector[childIndex + 1];
+			if (_eventBefore(timing, sibling, child)) {
+				child = sibling;
+				++childIndex;
+			}
+		}
+		if (!_eventBefore(timing, child, event)) {
+			break;
+		}
+		_eventPlace(timing, child, index);
+		index = childIndex;
+	}
+	_eventPlace(timing, event, index);
+}
+
+static void _eventRemove(struct mTiming* timing, size_t index) {
+	size_t last = --timing->events.size;
+	struct mTimingEvent* event = timing->events.vector[last];
+	if (index == last) {
+		return;
+	}
+	_eventPlace(timing, event, index);
+	_siftUp(timing, index);
+	_siftDown(timing, event->index);
+}
+
+static size_t _eventStats(struct mTiming* timing, const struct mTimingEvent* event) {
+	// Events are grouped by name, as some subsystems own several identical events
+	const char* name = event->name ? event->name : "(unnamed)";
+	size_t i;
+	for (i = 0; i < mTimingEventStatsListSize(&timing->stats); ++i) {
+		struct mTimingEventStats* stats = mTimingEventStatsListGetPointer(&timing->stats, i);
+		if (stats->name == name || strcmp(stats->name, name) == 0) {
+			return i;
+		}
+	}
+	struct mTimingEventStats* stats = mTimingEventStatsListAppend(&timing->stats);
+	memset(stats, 0, sizeof(*stats));
+	stats->name = name;
+	return i;
+}
+
 void mTimingInit(struct mTiming* timing, int32_t* relativeCycles, int32_t* nextEvent) {
-	timing->root = NULL;
-	timing->reroot = NULL;
+	mTimingEventHeapInit(&timing->events, 16);
+	mTimingEventStatsListInit(&timing->stats, 0);
+	timing->statsClock = NULL;
+	memset(timing->hostTime, 0, sizeof(timing->hostTime));
+	memset(timing->waitCycles, 0, sizeof(timing->waitCycles));
+	timing->hostMark = 0;
+	timing->hostCategory = mTIMING_HOST_CPU;
+	timing->nextOrder = 0;
+	timing->interrupted = false;
 	timing->masterCycles = 0;
 	timing->relativeCycles = relativeCycles;
 	timing->nextEvent = nextEvent;
 }
 
 void mTimingDeinit(struct mTiming* timing) {
-	UNUSED(timing);
+	mTimingEventHeapDeinit(&timing->events);
+	mTimingEventStatsListDeinit(&timing->stats);
 }
 
 void mTimingClear(struct mTiming* timing) {
-	timing->root = NULL;
-	timing->reroot = NULL;
+	mTimingEventHeapClear(&timing->events);
+	timing->interrupted = false;
 	timing->masterCycles = 0;
 }
 
 void mTimingSchedule(struct mTiming* timing, struct mTimingEvent* event, int32_t when) {
 	int32_t nextEvent = when + *timing->relativeCycles;
 	event->when = nextEvent + timing->masterCycles;
+	event->order = timing->nextOrder++;
 	if (nextEvent < *timing->nextEvent) {
 		*timing->nextEvent = nextEvent;
 	}
-	if (timing->reroot) {
-		timing->root = timing->reroot;
-		timing->reroot = NULL;
-	}
-	struct mTimingEvent** previous = &timing->root;
-	struct mTimingEvent* next = timing->root;
-	unsigned priority = event->priority;
-	while (next) {
-		int32_t nextWhen = next->when - timing->masterCycles;
-		if (nextWhen > nextEvent || (nextWhen == nextEvent && next->priority > priority)) {
-			break;
+	timing->interrupted = false;
+	if (timing->statsClock) {
+		struct mTimingEventStats* stats = mTimingEventStatsListGetPointer(&timing->stats, _eventStats(timing, event));
+		++stats->scheduled;
+		if (_eventIsScheduled(timing, event)) {
+			++stats->rescheduled;
 		}
-		previous = &next->next;
-		next = next->next;
 	}
-	event->next = next;
-	*previous = event;
+	if (_eventIsScheduled(timing, event)) {
+		// Rescheduling moves the event rather than queueing it twice
+		_siftUp(timing, event->index);
+		_siftDown(timing, event->index);
+		return;
+	}
+	if (timing->events.size == timing->events.capacity) {
+		mTimingEventHeapEnsureCapacity(&timing->events, timing->events.size + 1);
+	}
+	timing->events.vector[timing->events.size] = event;
+	_siftUp(timing, timing->events.size++);
 }
 
 void mTimingDeschedule(struct mTiming* timing, struct mTimingEvent* event) {
-	if (timing->reroot) {
-		timing->root = timing->reroot;
-		timing->reroot = NULL;
-	}
-	struct mTimingEvent** previous = &timing->root;
-	struct mTimingEvent* next = timing->root;
-	while (next) {
-		if (next == event) {
-			*previous = next->next;
-			return;
-		}
-		previous = &next->next;
-		next = next->next;
+	timing->interrupted = false;
+	if (_eventIsScheduled(timing, event)) {
+		_eventRemove(timing, event->index);
 	}
 }
 
 bool mTimingIsScheduled(const struct mTiming* timing, const struct mTimingEvent* event) {
-	const struct mTimingEvent* next = timing->root;
-	if (!next) {
-		next = timing->reroot;
-	}
-	while (next) {
-		if (next == event) {
-			return true;
-		}
-		next = next->next;
-	}
-	return false;
+	return _eventIsScheduled(timing, event);
+}
+
+void mTimingInterrupt(struct mTiming* timing) {
+	timing->interrupted = true;
+}
+
+static void _fireWithStats(struct mTiming* timing, struct mTimingEvent* event, uint32_t cyclesLate) {
+	size_t index = _eventStats(timing, event);
+	mTimingStatsClock clock = timing->statsClock;
+	enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_EVENTS);
+	uint64_t start = timing->hostMark;
+	event->callback(timing, event->context, cyclesLate);
+	mTimingHostLeave(timing, category);
+	uint64_t end = timing->statsClock ? timing->hostMark : clock();
+	// The callback may have added new entries, so don't hold a pointer across it
+	struct mTimingEventStats* stats = mTimingEventStatsListGetPointer(&timing->stats, index);
+	++stats->fired;
+	stats->hostTime += end - start;
 }
 
 int32_t mTimingTick(struct mTiming* timing, int32_t cycles) {
 	timing->masterCycles += cycles;
 	uint32_t masterCycles = timing->masterCycles;
-	while (timing->root) {
-		struct mTimingEvent* next = timing->root;
+	while (!timing->interrupted && timing->events.size) {
+		struct mTimingEvent* next = timing->events.vector[0];
 		int32_t nextWhen = next->when - masterCycles;
 		if (nextWhen > 0) {
 			return nextWhen;
 		}
-		timing->root = next->next;
-		next->callback(timing, next->context, -nextWhen);
+		_eventRemove(timing, 0);
+		if (timing->statsClock) {
+			_fireWithStats(timing, next, -nextWhen);
+		} else {
+			next->callback(timing, next->context, -nextWhen);
+		}
 	}
-	if (timing->reroot) {
-		timing->root = timing->reroot;
-		timing->reroot = NULL;
-		*timing->nextEvent = mTimingNextEvent(timing); 
+	if (timing->interrupted) {
+		timing->interrupted = false;
+		*timing->nextEvent = mTimingNextEvent(timing);
 	}
 	return *timing->nextEvent;
 }
@@ -104,13 +208,121 @@ int32_t mTimingCurrentTime(const struct mTiming* timing) {
 }
 
 int32_t mTimingNextEvent(struct mTiming* timing) {
-	struct mTimingEvent* next = timing->root;
-	if (!next) {
+	if (!timing->events.size) {
 		return INT_MAX;
 	}
+	struct mTimingEvent* next = timing->events.vector[0];
 	return next->when - timing->masterCycles - *timing->relativeCycles;
 }
 
 int32_t mTimingUntil(const struct mTiming* timing, const struct mTimingEvent* event) {
 	return event->when - timing->masterCycles - *timing->relativeCycles;
 }
+
+uint32_t mTimingSettledTime(const struct mTiming* timing) {
+	uint32_t now = mTimingCurrentTime(timing);
+	if (timing->events.size) {
+		int32_t pending = timing->events.vector[0]->when - now;
+		if (pending <= 0) {
+			return now + pending - 1;
+		}
+	}
+	return now;
+}
+
+void mTimingEnableStats(struct mTiming* timing, mTimingStatsClock clock) {
+	if (!timing->statsClock) {
+		timing->hostMark = clock();
+	}
+	timing->statsClock = clock;
+}
+
+void mTimingDisableStats(struct mTiming* timing) {
+	if (timing->statsClock) {
+		mTimingHostSwitch(timing, timing->hostCategory);
+	}
+	timing->statsClock = NULL;
+}
+
+void mTimingResetStats(struct mTiming* timing) {
+	mTimingEventStatsListClear(&timing->stats);
+	memset(timing->hostTime, 0, sizeof(timing->hostTime));
+	memset(timing->waitCycles, 0, sizeof(timing->waitCycles));
+	if (timing->statsClock) {
+		timing->hostMark = timing->statsClock();
+	}
+}
+
+void mTimingHostSwitch(struct mTiming* timing, enum mTimingHostCategory category) {
+	uint64_t now = timing->statsClock();
+	timing->hostTime[timing->hostCategory] += now - timing->hostMark;
+	timing->hostMark = now;
+	timing->hostCategory = category;
+}
+
+uint64_t mTimingHostTime(struct mTiming* timing, enum mTimingHostCategory category) {
+	if (category >= mTIMING_HOST_MAX) {
+		return 0;
+	}
+	if (timing->statsClock) {
+		// Settle whatever is running right now
+		mTimingHostSwitch(timing, timing->hostCategory);
+	}
+	return timing->hostTime[category];
+}
+
+const char* mTimingHostCategoryName(enum mTimingHostCategory category) {
+	switch (category) {
+	case mTIMING_HOST_CPU:
+		return "cpu";
+	case mTIMING_HOST_EVENTS:
+		return "events";
+	case mTIMING_HOST_RENDER_SCANLINE:
+		return "render_scanline";
+	case mTIMING_HOST_RENDER_FRAME:
+		return "render_frame";
+	case mTIMING_HOST_AUDIO:
+		return "audio";
+	case mTIMING_HOST_IO:
+		return "io";
+	default:
+		return NULL;
+	}
+}
+
+uint64_t mTimingWaitCycles(const struct mTiming* timing, unsigned region, enum mTimingWaitAccess access) {
+	if (region >= mTIMING_WAIT_REGIONS || access >= mTIMING_WAIT_MAX) {
+		return 0;
+	}
+	return timing->waitCycles[region][access];
+}
+
+const char* mTimingWaitAccessName(enum mTimingWaitAccess access) {
+	switch (access) {
+	case mTIMING_WAIT_CODE_NONSEQ:
+		return "code_n";
+	case mTIMING_WAIT_CODE_SEQ:
+		return "code_s";
+	case mTIMING_WAIT_DATA_NONSEQ:
+		return "data_n";
+	case mTIMING_WAIT_DATA_SEQ:
+		return "data_s";
+	case mTIMING_WAIT_PREFETCH_STALL:
+		return "prefetch_stall";
+	case mTIMING_WAIT_PREFETCH_HIDDEN:
+		return "prefetch_hidden";
+	default:
+		return NULL;
+	}
+}
+
+size_t mTimingStatsSize(const struct mTiming* timing) {
+	return mTimingEventStatsListSize(&timing->stats);
+}
+
+const struct mTimingEventStats* mTimingStatsGet(const struct mTiming* timing, size_t index) {
+	if (index >= mTimingEventStatsListSize(&timing->stats)) {
+		return NULL;
+	}
+	return mTimingEventStatsListGetConstPointer(&timing->stats, index);
+}
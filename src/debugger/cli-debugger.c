@@ -10,6 +10,8 @@
 #include <mgba/core/core.h>
 #include <mgba/core/version.h>
 #include <mgba/internal/debugger/parser.h>
+#include <mgba/internal/debugger/profiler.h>
+#include <mgba/internal/debugger/trace.h>
 #include <mgba-util/string.h>
 #include <mgba-util/vfs.h>
 
@@ -33,6 +35,7 @@ const char* INFO_WATCHPOINT_ADDED = "Added watchpoint #%" PRIz "i\n";
 
 static struct ParseTree* _parseTree(const char** string);
 static bool _doTrace(struct CLIDebugger* debugger);
+static void _endBinaryTrace(struct CLIDebugger* debugger);
 
 #if !defined(NDEBUG) && !defined(_WIN32)
 static void _breakInto(struct CLIDebugger*, struct CLIDebugVector*);
@@ -59,6 +62,10 @@ static void _setWriteWatchpoint(struct CLIDebugger*, struct CLIDebugVector*);
 static void _setWriteChangedWatchpoint(struct CLIDebugger*, struct CLIDebugVector*);
 static void _listWatchpoints(struct CLIDebugger*, struct CLIDebugVector*);
 static void _trace(struct CLIDebugger*, struct CLIDebugVector*);
+static void _traceBinary(struct CLIDebugger*, struct CLIDebugVector*);
+static void _startProfile(struct CLIDebugger*, struct CLIDebugVector*);
+static void _saveProfile(struct CLIDebugger*, struct CLIDebugVector*);
+static void _stopProfile(struct CLIDebugger*, struct CLIDebugVector*);
 static void _writeByte(struct CLIDebugger*, struct CLIDebugVector*);
 static void _writeHalfword(struct CLIDebugger*, struct CLIDebugVector*);
 static void _writeRegister(struct CLIDebugger*, struct CLIDebugVector*);
@@ -82,6 +89,9 @@ static struct CLIDebuggerCommandSummary _debuggerCommands[] = {
 	{ "print", _print, "S+", "Print a value" },
 	{ "print/t", _printBin, "S+", "Print a value as binary" },
 	{ "print/x", _printHex, "S+", "Print a value as hexadecimal" },
+	{ "profile", _startProfile, "i", "Sample the program counter every number of cycles" },
+	{ "profile/save", _saveProfile, "S", "Save the sampled call stacks for a flame graph" },
+	{ "profile/stop", _stopProfile, "", "Stop sampling and discard the samples" },
 	{ "quit", _quit, "", "Quit the emulator" },
 	{ "reset", _reset, "", "Reset the emulation" },
 	{ "r/1", _readByte, "I", "Read a byte from a specified offset" },
@@ -89,6 +99,7 @@ static struct CLIDebuggerCommandSummary _debuggerCommands[] = {
 	{ "r/4", _readWord, "I", "Read a word from a specified offset" },
 	{ "status", _printStatus, "", "Print the current status" },
 	{ "trace", _trace, "Is", "Trace a number of instructions" },
+	{ "trace/b", _traceBinary, "ISs", "Trace a number of instructions to a binary file" },
 	{ "w/1", _writeByte, "II", "Write a byte at a specified offset" },
 	{ "w/2", _writeHalfword, "II", "Write a halfword at a specified offset" },
 	{ "w/r", _writeRegister, "SI", "Write a register" },
@@ -693,6 +704,7 @@ static void _trace(struct CLIDebugger* debugger, struct CLIDebugVector* dv) {
 		debugger->traceVf->close(debugger->traceVf);
 		debugger->traceVf = NULL;
 	}
+	_endBinaryTrace(debugger);
 	if (debugger->traceRemaining == 0) {
 		return;
 	}
@@ -706,7 +718,129 @@ static void _trace(struct CLIDebugger* debugger, struct CLIDebugVector* dv) {
 	}
 }
 
+static void _traceBinary(struct CLIDebugger* debugger, struct CLIDebugVector* dv) {
+	if (!dv || dv->type != CLIDV_INT_TYPE || !dv->next || !dv->next->charValue) {
+		debugger->backend->printf(debugger->backend, "%s\n", ERROR_MISSING_ARGS);
+		return;
+	}
+	unsigned flags = 0;
+	if (dv->next->next && dv->next->next->charValue) {
+		if (strcmp(dv->next->next->charValue, "regs") != 0) {
+			debugger->backend->printf(debugger->backend, "%s\n", ERROR_INVALID_ARGS);
+			return;
+		}
+		flags |= mDEBUGGER_TRACE_REGISTERS;
+	}
+	if (!debugger->d.platform->traceEntry) {
+		debugger->backend->printf(debugger->backend, "Binary traces are not supported on this platform\n");
+		return;
+	}
+
+	if (debugger->traceVf) {
+		debugger->traceVf->close(debugger->traceVf);
+		debugger->traceVf = NULL;
+	}
+	_endBinaryTrace(debugger);
+	debugger->traceRemaining = dv->intValue;
+	if (debugger->traceRemaining == 0) {
+		return;
+	}
+
+	struct VFile* vf = VFileOpen(dv->next->charValue, O_CREAT | O_TRUNC | O_WRONLY);
+	if (!vf) {
+		debugger->traceRemaining = 0;
+		debugger->backend->printf(debugger->backend, "Could not open %s\n", dv->next->charValue);
+		return;
+	}
+	struct mDebuggerTraceEntry entry;
+	debugger->d.platform->traceEntry(debugger->d.platform, &entry);
+	debugger->traceWriter = malloc(sizeof(*debugger->traceWriter));
+	if (!mDebuggerTraceWriterInit(debugger->traceWriter, vf, debugger->d.core->platform(debugger->d.core), entry.nRegisters, flags)) {
+		free(debugger->traceWriter);
+		debugger->traceWriter = NULL;
+		vf->close(vf);
+		debugger->traceRemaining = 0;
+		debugger->backend->printf(debugger->backend, "Could not start trace\n");
+		return;
+	}
+	if (_doTrace(debugger)) {
+		debugger->d.state = DEBUGGER_CALLBACK;
+	}
+}
+
+static void _endBinaryTrace(struct CLIDebugger* debugger) {
+	if (!debugger->traceWriter) {
+		return;
+	}
+	mDebuggerTraceWriterDeinit(debugger->traceWriter);
+	debugger->traceWriter->vf->close(debugger->traceWriter->vf);
+	debugger->backend->printf(debugger->backend, "Traced %" PRIu64 " instructions\n", debugger->traceWriter->records);
+	free(debugger->traceWriter);
+	debugger->traceWriter = NULL;
+}
+
+static void _startProfile(struct CLIDebugger* debugger, struct CLIDebugVector* dv) {
+	uint32_t period = 0;
+	if (dv && dv->type == CLIDV_INT_TYPE) {
+		period = dv->intValue;
+	}
+	if (!debugger->profiler) {
+		debugger->profiler = malloc(sizeof(*debugger->profiler));
+		mDebuggerProfilerInit(debugger->profiler, debugger->d.core, period);
+	} else if (period) {
+		debugger->profiler->period = period;
+	}
+	mDebuggerProfilerStart(debugger->profiler);
+	debugger->backend->printf(debugger->backend, "Sampling every %" PRIu32 " cycles\n", debugger->profiler->period);
+}
+
+static void _saveProfile(struct CLIDebugger* debugger, struct CLIDebugVector* dv) {
+	if (!dv || !dv->charValue) {
+		debugger->backend->printf(debugger->backend, "%s\n", ERROR_MISSING_ARGS);
+		return;
+	}
+	if (!debugger->profiler) {
+		debugger->backend->printf(debugger->backend, "Not profiling\n");
+		return;
+	}
+	struct VFile* vf = VFileOpen(dv->charValue, O_CREAT | O_TRUNC | O_WRONLY);
+	if (!vf) {
+		debugger->backend->printf(debugger->backend, "Could not open %s\n", dv->charValue);
+		return;
+	}
+	if (mDebuggerProfilerWriteFolded(debugger->profiler, vf)) {
+		debugger->backend->printf(debugger->backend, "Saved %" PRIu64 " samples\n", debugger->profiler->samples);
+	} else {
+		debugger->backend->printf(debugger->backend, "Could not write %s\n", dv->charValue);
+	}
+	vf->close(vf);
+}
+
+static void _stopProfile(struct CLIDebugger* debugger, struct CLIDebugVector* dv) {
+	UNUSED(dv);
+	if (!debugger->profiler) {
+		return;
+	}
+	mDebuggerProfilerDeinit(debugger->profiler);
+	free(debugger->profiler);
+	debugger->profiler = NULL;
+}
+
 static bool _doTrace(struct CLIDebugger* debugger) {
+	if (debugger->traceWriter) {
+		struct mDebuggerTraceEntry entry;
+		debugger->d.platform->traceEntry(debugger->d.platform, &entry);
+		mDebuggerTraceWriterRecord(debugger->traceWriter, &entry);
+		if (debugger->traceRemaining > 0) {
+			--debugger->traceRemaining;
+		}
+		if (!debugger->traceRemaining) {
+			_endBinaryTrace(debugger);
+			return false;
+		}
+		return true;
+	}
+
 	char trace[1024];
 	trace[sizeof(trace) - 1] = '\0';
 	size_t traceSize = sizeof(trace) - 2;
@@ -969,6 +1103,10 @@ static void _reportEntry(struct mDebugger* debugger, enum mDebuggerEntryReason r
 	struct CLIDebugger* cliDebugger = (struct CLIDebugger*) debugger;
 	if (cliDebugger->traceRemaining > 0) {
 		cliDebugger->traceRemaining = 0;
+		_endBinaryTrace(cliDebugger);
+	} else if (cliDebugger->traceWriter) {
+		// Open-ended traces carry on afterwards, but what is there so far should be readable
+		mDebuggerTraceWriterFlush(cliDebugger->traceWriter);
 	}
 	switch (reason) {
 	case DEBUGGER_ENTER_MANUAL:
@@ -1010,6 +1148,8 @@ static void _cliDebuggerInit(struct mDebugger* debugger) {
 	struct CLIDebugger* cliDebugger = (struct CLIDebugger*) debugger;
 	cliDebugger->traceRemaining = 0;
 	cliDebugger->traceVf = NULL;
+	cliDebugger->traceWriter = NULL;
+	cliDebugger->profiler = NULL;
 	cliDebugger->backend->init(cliDebugger->backend);
 }
 
@@ -1019,6 +1159,8 @@ static void _cliDebuggerDeinit(struct mDebugger* debugger) {
 		cliDebugger->traceVf->close(cliDebugger->traceVf);
 		cliDebugger->traceVf = NULL;
 	}
+	_endBinaryTrace(cliDebugger);
+	_stopProfile(cliDebugger, NULL);
 
 	if (cliDebugger->system) {
 		if (cliDebugger->system->deinit) {
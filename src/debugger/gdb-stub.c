@@ -166,26 +166,19 @@ static uint32_t _readHex(const char* in, unsigned* out) {
 	return _hex2int(in, i);
 }
 
-static void _sendMessage(struct GDBStub* stub) {
+static void _sendPacket(struct GDBStub* stub, size_t length) {
 	if (stub->lineAck != GDB_ACK_OFF) {
 		stub->lineAck = GDB_ACK_PENDING;
 	}
+	if (length > GDB_STUB_MAX_LINE - 5) {
+		length = GDB_STUB_MAX_LINE - 5;
+	}
 	uint8_t checksum = 0;
-	int i = 1;
-	char buffer = stub->outgoing[0];
-	char swap;
+	memmove(&stub->outgoing[1], stub->outgoing, length);
 	stub->outgoing[0] = '$';
-	if (buffer) {
-		for (; i < GDB_STUB_MAX_LINE - 5; ++i) {
-			checksum += buffer;
-			swap = stub->outgoing[i];
-			stub->outgoing[i] = buffer;
-			buffer = swap;
-			if (!buffer) {
-				++i;
-				break;
-			}
-		}
+	size_t i;
+	for (i = 1; i <= length; ++i) {
+		checksum += stub->outgoing[i];
 	}
 	stub->outgoing[i] = '#';
 	_int2hex8(checksum, &stub->outgoing[i + 1]);
@@ -194,6 +187,11 @@ static void _sendMessage(struct GDBStub* stub) {
 	SocketSend(stub->connection, stub->outgoing, i + 3);
 }
 
+static void _sendMessage(struct GDBStub* stub) {
+	const char* end = memchr(stub->outgoing, '\0', GDB_STUB_MAX_LINE - 5);
+	_sendPacket(stub, end ? (size_t) (end - stub->outgoing) : GDB_STUB_MAX_LINE - 5);
+}
+
 static void _error(struct GDBStub* stub, enum GDBError error) {
 	snprintf(stub->outgoing, GDB_STUB_MAX_LINE - 4, "E%02x", error);
 	_sendMessage(stub);
@@ -229,7 +227,7 @@ static void _writeMemoryBinary(struct GDBStub* stub, const char* message) {
 	uint32_t size = _readHex(readAddress, &i);
 	readAddress += i + 1;
 
-	if (size > 512) {
+	if (size > GDB_STUB_MAX_LINE) {
 		_error(stub, GDB_BAD_ARGUMENTS);
 		return;
 	}
@@ -263,7 +261,7 @@ static void _writeMemory(struct GDBStub* stub, const char* message) {
 	uint32_t size = _readHex(readAddress, &i);
 	readAddress += i + 1;
 
-	if (size > 512) {
+	if (size > GDB_STUB_MAX_LINE / 2) {
 		_error(stub, GDB_BAD_ARGUMENTS);
 		return;
 	}
@@ -278,26 +276,93 @@ static void _writeMemory(struct GDBStub* stub, const char* message) {
 	_sendMessage(stub);
 }
 
-static void _readMemory(struct GDBStub* stub, const char* message) {
+static void _readBytes(struct GDBStub* stub, uint32_t address, uint8_t* out, uint32_t size) {
+	// Ranges that sit inside one flat block are copied straight out of it; anything
+	// else, including I/O and banked blocks, still goes through the bus a byte at a time
+	struct mCore* core = stub->d.core;
+	const struct mCoreMemoryBlock* blocks;
+	size_t nBlocks = core->listMemoryBlocks(core, &blocks);
+	size_t i;
+	for (i = 0; i < nBlocks; ++i) {
+		const struct mCoreMemoryBlock* block = &blocks[i];
+		if (!(block->flags & mCORE_MEMORY_MAPPED) || block->maxSegment || address < block->start || address >= block->end) {
+			continue;
+		}
+		size_t blockSize = 0;
+		const uint8_t* data = core->getMemoryBlock(core, block->id, &blockSize);
+		uint32_t offset = address - block->start;
+		if (data && offset < blockSize && size <= blockSize - offset) {
+			memcpy(out, &data[offset], size);
+			return;
+		}
+		break;
+	}
+	struct ARMCore* cpu = core->cpu;
+	for (i = 0; i < size; ++i) {
+		out[i] = cpu->memory.load8(cpu, address + i, 0);
+	}
+}
+
+static const uint8_t* _readMemoryRange(struct GDBStub* stub, const char* message, uint32_t* sizeOut) {
 	const char* readAddress = message;
 	unsigned i = 0;
 	uint32_t address = _readHex(readAddress, &i);
 	readAddress += i + 1;
 	uint32_t size = _readHex(readAddress, &i);
-	if (size > 512) {
-		_error(stub, GDB_BAD_ARGUMENTS);
-		return;
+	// Replies may be shorter than asked for, so big reads are trimmed to one packet
+	if (size > GDB_STUB_MAX_LINE / 2 - 3) {
+		size = GDB_STUB_MAX_LINE / 2 - 3;
 	}
-	struct ARMCore* cpu = stub->d.core->cpu;
+	// The bytes are staged at the end of the outgoing buffer, which stays ahead of
+	// the encoder since no byte takes more than two characters
+	uint8_t* bytes = (uint8_t*) &stub->outgoing[GDB_STUB_MAX_LINE - 5 - size];
+	_readBytes(stub, address, bytes, size);
+	*sizeOut = size;
+	return bytes;
+}
+
+static void _readMemory(struct GDBStub* stub, const char* message) {
+	uint32_t size;
+	const uint8_t* bytes = _readMemoryRange(stub, message, &size);
 	int writeAddress = 0;
+	uint32_t i;
 	for (i = 0; i < size; ++i, writeAddress += 2) {
-		uint8_t byte = cpu->memory.load8(cpu, address + i, 0);
-		_int2hex8(byte, &stub->outgoing[writeAddress]);
+		_int2hex8(bytes[i], &stub->outgoing[writeAddress]);
 	}
 	stub->outgoing[writeAddress] = 0;
 	_sendMessage(stub);
 }
 
+static void _readMemoryBinary(struct GDBStub* stub, const char* message) {
+	uint32_t size;
+	const uint8_t* bytes = _readMemoryRange(stub, message, &size);
+	if (!size) {
+		strncpy(stub->outgoing, "OK", GDB_STUB_MAX_LINE - 4);
+		_sendMessage(stub);
+		return;
+	}
+	size_t writeAddress = 0;
+	stub->outgoing[writeAddress] = 'b';
+	++writeAddress;
+	uint32_t i;
+	for (i = 0; i < size; ++i) {
+		uint8_t byte = bytes[i];
+		switch (byte) {
+		case '#':
+		case '$':
+		case '*':
+		case 0x7D:
+			stub->outgoing[writeAddress] = 0x7D;
+			++writeAddress;
+			byte ^= 0x20;
+			break;
+		}
+		stub->outgoing[writeAddress] = byte;
+		++writeAddress;
+	}
+	_sendPacket(stub, writeAddress);
+}
+
 static void _writeGPRs(struct GDBStub* stub, const char* message) {
 	struct ARMCore* cpu = stub->d.core->cpu;
 	const char* readAddress = message;
@@ -396,6 +461,14 @@ static void _readRegister(struct GDBStub* stub, const char* message) {
 	uint32_t value;
 	if (reg < 0x10) {
 		value = cpu->gprs[reg];
+	} else if (reg < 0x18) {
+		// Floating point registers, unused on the GBA, as laid out in the g packet
+		memset(stub->outgoing, '0', 24);
+		stub->outgoing[24] = '\0';
+		_sendMessage(stub);
+		return;
+	} else if (reg == 0x18) {
+		value = 0;
 	} else if (reg == 0x19) {
 		value = cpu->cpsr.packed;
 	} else {
@@ -434,7 +507,52 @@ static void _processQSupportedCommand(struct GDBStub* stub, const char* message)
 		}
 		message = end + 1;
 	}
-	strncpy(stub->outgoing, "swbreak+;hwbreak+", GDB_STUB_MAX_LINE - 4);
+	// Incoming packets also carry the leading '$' and trailing checksum, plus a possible ack
+	snprintf(stub->outgoing, GDB_STUB_MAX_LINE - 4, "swbreak+;hwbreak+;PacketSize=%x;qXfer:memory-map:read+", GDB_STUB_MAX_LINE - 8);
+}
+
+static void _processQXferMemoryMap(struct GDBStub* stub, const char* message) {
+	const char* readAddress = message;
+	unsigned i = 0;
+	uint32_t offset = _readHex(readAddress, &i);
+	readAddress += i + 1;
+	i = 0;
+	uint32_t length = _readHex(readAddress, &i);
+
+	char map[2048];
+	size_t size = snprintf(map, sizeof(map), "<?xml version=\"1.0\"?>\n<memory-map>\n");
+	struct mCore* core = stub->d.core;
+	const struct mCoreMemoryBlock* blocks;
+	size_t nBlocks = core->listMemoryBlocks(core, &blocks);
+	for (i = 0; i < nBlocks && size < sizeof(map); ++i) {
+		if (!(blocks[i].flags & mCORE_MEMORY_MAPPED)) {
+			continue;
+		}
+		size += snprintf(&map[size], sizeof(map) - size, "<memory type=\"%s\" start=\"0x%08x\" length=\"0x%x\"/>\n",
+		                 (blocks[i].flags & mCORE_MEMORY_WRITE) ? "ram" : "rom", blocks[i].start, blocks[i].end - blocks[i].start);
+	}
+	if (size < sizeof(map)) {
+		size += snprintf(&map[size], sizeof(map) - size, "</memory-map>\n");
+	}
+	if (size >= sizeof(map)) {
+		_error(stub, GDB_BAD_ARGUMENTS);
+		return;
+	}
+
+	if (offset > size) {
+		offset = size;
+	}
+	if (length > GDB_STUB_MAX_LINE - 6) {
+		length = GDB_STUB_MAX_LINE - 6;
+	}
+	if (length >= size - offset) {
+		length = size - offset;
+		stub->outgoing[0] = 'l';
+	} else {
+		stub->outgoing[0] = 'm';
+	}
+	memcpy(&stub->outgoing[1], &map[offset], length);
+	_sendPacket(stub, length + 1);
 }
 
 static void _processQReadCommand(struct GDBStub* stub, const char* message) {
@@ -455,6 +573,9 @@ static void _processQReadCommand(struct GDBStub* stub, const char* message) {
 		strncpy(stub->outgoing, "l", GDB_STUB_MAX_LINE - 4);
 	} else if (!strncmp("Supported:", message, 10)) {
 		_processQSupportedCommand(stub, message + 10);
+	} else if (!strncmp("Xfer:memory-map:read::", message, 22)) {
+		_processQXferMemoryMap(stub, message + 22);
+		return;
 	}
 	_sendMessage(stub);
 }
@@ -567,9 +688,9 @@ static void _clearBreakpoint(struct GDBStub* stub, const char* message) {
 	_sendMessage(stub);
 }
 
-size_t _parseGDBMessage(struct GDBStub* stub, const char* message) {
+size_t _parseGDBMessage(struct GDBStub* stub, const char* message, size_t length) {
 	uint8_t checksum = 0;
-	int parsed = 1;
+	size_t parsed = 1;
 	switch (*message) {
 	case '+':
 		stub->lineAck = GDB_ACK_RECEIVED;
@@ -578,7 +699,6 @@ size_t _parseGDBMessage(struct GDBStub* stub, const char* message) {
 		stub->lineAck = GDB_NAK_RECEIVED;
 		return parsed;
 	case '$':
-		++message;
 		break;
 	case '\x03':
 		mDebuggerEnter(&stub->d, DEBUGGER_ENTER_MANUAL, 0);
@@ -588,26 +708,19 @@ size_t _parseGDBMessage(struct GDBStub* stub, const char* message) {
 		return parsed;
 	}
 
-	int i;
+	// Large packets can span several reads, so wait until the checksum has arrived
+	const char* terminator = memchr(message, '#', length);
+	if (!terminator || (size_t) (terminator - message) + 3 > length) {
+		return 0;
+	}
+	++message;
+	size_t i;
 	char messageType = message[0];
 	for (i = 0; message[i] != '#'; ++i, ++parsed) {
 		checksum += message[i];
 	}
-	if (!message[i]) {
-		_nak(stub);
-		return parsed;
-	}
 	++i;
-	++parsed;
-	if (!message[i]) {
-		_nak(stub);
-		return parsed;
-	} else if (!message[i + 1]) {
-		++parsed;
-		_nak(stub);
-		return parsed;
-	}
-	parsed += 2;
+	parsed += 3;
 	int networkChecksum = _hex2int(&message[i], 2);
 	if (networkChecksum != checksum) {
 		mLOG(DEBUGGER, WARN, "Checksum error: expected %02x, got %02x", checksum, networkChecksum);
@@ -665,7 +778,10 @@ size_t _parseGDBMessage(struct GDBStub* stub, const char* message) {
 		break;
 	case 'X':
 		_writeMemoryBinary(stub, message);
-                break;
+		break;
+	case 'x':
+		_readMemoryBinary(stub, message);
+		break;
 	case 'Z':
 		_setBreakpoint(stub, message);
 		break;
@@ -690,6 +806,7 @@ void GDBStubCreate(struct GDBStub* stub) {
 	stub->d.type = DEBUGGER_GDB;
 	stub->untilPoll = GDB_STUB_INTERVAL;
 	stub->lineAck = GDB_ACK_PENDING;
+	stub->lineLength = 0;
 	stub->shouldBlock = false;
 }
 
@@ -724,6 +841,7 @@ void GDBStubHangup(struct GDBStub* stub) {
 		SocketClose(stub->connection);
 		stub->connection = INVALID_SOCKET;
 	}
+	stub->lineLength = 0;
 	if (stub->d.state == DEBUGGER_PAUSED) {
 		stub->d.state = DEBUGGER_RUNNING;
 	}
@@ -766,7 +884,12 @@ void GDBStubUpdate(struct GDBStub* stub) {
 			Socket reads = stub->connection;
 			SocketPoll(1, &reads, 0, 0, SOCKET_TIMEOUT);
 		}
-		ssize_t messageLen = SocketRecv(stub->connection, stub->line, GDB_STUB_MAX_LINE - 1);
+		if (stub->lineLength == GDB_STUB_MAX_LINE - 1) {
+			mLOG(DEBUGGER, WARN, "Packet too large");
+			stub->lineLength = 0;
+			_nak(stub);
+		}
+		ssize_t messageLen = SocketRecv(stub->connection, &stub->line[stub->lineLength], GDB_STUB_MAX_LINE - 1 - stub->lineLength);
 		if (messageLen == 0) {
 			goto connectionLost;
 		}
@@ -776,12 +899,19 @@ void GDBStubUpdate(struct GDBStub* stub) {
 			}
 			goto connectionLost;
 		}
-		stub->line[messageLen] = '\0';
-		mLOG(DEBUGGER, DEBUG, "< %s", stub->line);
-		ssize_t position = 0;
-		while (position < messageLen) {
-			position += _parseGDBMessage(stub, &stub->line[position]);
+		mLOG(DEBUGGER, DEBUG, "< %.*s", (int) messageLen, &stub->line[stub->lineLength]);
+		stub->lineLength += messageLen;
+		stub->line[stub->lineLength] = '\0';
+		size_t position = 0;
+		while (position < stub->lineLength) {
+			size_t parsed = _parseGDBMessage(stub, &stub->line[position], stub->lineLength - position);
+			if (!parsed) {
+				break;
+			}
+			position += parsed;
 		}
+		stub->lineLength -= position;
+		memmove(stub->line, &stub->line[position], stub->lineLength);
 	}
 
 connectionLost:
@@ -7,6 +7,7 @@
 
 #include <mgba/core/core.h>
 #include <mgba/debugger/debugger.h>
+#include <mgba/internal/debugger/symbols.h>
 #include <mgba-util/string.h>
 
 DEFINE_VECTOR(LexVector, struct Token);
@@ -774,3 +775,218 @@ bool mDebuggerEvaluateParseTree(struct mDebugger* debugger, struct ParseTree* tr
 	}
 	return false;
 }
+
+static struct ParseInstruction* _appendInstruction(struct ParseProgram* program, size_t* capacity) {
+	if (program->nInstructions == *capacity) {
+		*capacity = *capacity ? *capacity * 2 : 8;
+		program->instructions = realloc(program->instructions, *capacity * sizeof(*program->instructions));
+	}
+	struct ParseInstruction* instruction = &program->instructions[program->nInstructions];
+	++program->nInstructions;
+	memset(instruction, 0, sizeof(*instruction));
+	return instruction;
+}
+
+// Looked up in the same order as mDebuggerLookupIdentifier, but only as far as a name that
+// will always mean the same thing. Anything else is looked up again on every evaluation.
+static void _compileIdentifier(struct mDebugger* debugger, const char* name, struct ParseInstruction* instruction) {
+	int32_t value;
+	int segment = -1;
+#ifdef ENABLE_SCRIPTING
+	// Scripts can define names at any time, and those come first
+	if (debugger && debugger->bridge) {
+		debugger = NULL;
+	}
+#endif
+	if (debugger && debugger->core->symbolTable && mDebuggerSymbolLookup(debugger->core->symbolTable, name, &value, &segment)) {
+		instruction->type = PARSE_CONSTANT;
+		instruction->value = value;
+		instruction->segment = segment;
+		return;
+	}
+	if (debugger && debugger->core->lookupIdentifier(debugger->core, name, &value, &segment)) {
+		instruction->type = PARSE_CONSTANT;
+		instruction->value = value;
+		instruction->segment = segment;
+		return;
+	}
+	if (debugger && debugger->platform && debugger->platform->getRegisterPointer) {
+		const int32_t* reg = debugger->platform->getRegisterPointer(debugger->platform, name);
+		if (reg) {
+			instruction->type = PARSE_REGISTER;
+			instruction->reg = reg;
+			return;
+		}
+	}
+	instruction->type = PARSE_IDENTIFIER;
+	instruction->identifier = strdup(name);
+}
+
+static bool _compileNode(struct mDebugger* debugger, const struct ParseTree* tree, unsigned slot, struct ParseProgram* program, size_t* capacity) {
+	if (slot >= PARSE_PROGRAM_MAX_SLOTS) {
+		return false;
+	}
+	struct ParseInstruction* instruction;
+	switch (tree->token.type) {
+	case TOKEN_UINT_TYPE:
+		instruction = _appendInstruction(program, capacity);
+		instruction->type = PARSE_CONSTANT;
+		instruction->dest = slot;
+		instruction->value = tree->token.uintValue;
+		instruction->segment = -1;
+		return true;
+	case TOKEN_SEGMENT_TYPE:
+		// The segment itself is evaluated without one, which only makes sense for a plain number
+		if (!tree->lhs || tree->lhs->token.type != TOKEN_UINT_TYPE || !tree->rhs) {
+			return false;
+		}
+		if (!_compileNode(debugger, tree->rhs, slot, program, capacity)) {
+			return false;
+		}
+		instruction = _appendInstruction(program, capacity);
+		instruction->type = PARSE_SEGMENT;
+		instruction->segment = tree->lhs->token.uintValue;
+		return true;
+	case TOKEN_OPERATOR_TYPE:
+		switch (tree->token.operatorValue) {
+		case OP_ASSIGN:
+		case OP_ADD:
+		case OP_SUBTRACT:
+		case OP_MULTIPLY:
+		case OP_DIVIDE:
+		case OP_MODULO:
+		case OP_AND:
+		case OP_OR:
+		case OP_XOR:
+		case OP_LESS:
+		case OP_GREATER:
+		case OP_EQUAL:
+		case OP_NOT_EQUAL:
+		case OP_LOGICAL_AND:
+		case OP_LOGICAL_OR:
+		case OP_LE:
+		case OP_GE:
+		case OP_SHIFT_L:
+		case OP_SHIFT_R:
+			if (!tree->lhs || !tree->rhs) {
+				return false;
+			}
+			if (!_compileNode(debugger, tree->lhs, slot, program, capacity)) {
+				return false;
+			}
+			if (!_compileNode(debugger, tree->rhs, slot + 1, program, capacity)) {
+				return false;
+			}
+			instruction = _appendInstruction(program, capacity);
+			instruction->rhs = slot + 1;
+			break;
+		default:
+			if (!tree->rhs) {
+				return false;
+			}
+			if (!_compileNode(debugger, tree->rhs, slot, program, capacity)) {
+				return false;
+			}
+			instruction = _appendInstruction(program, capacity);
+			instruction->rhs = slot;
+			break;
+		}
+		instruction->type = PARSE_OPERATION;
+		instruction->operation = tree->token.operatorValue;
+		instruction->dest = slot;
+		instruction->lhs = slot;
+		return true;
+	case TOKEN_IDENTIFIER_TYPE:
+		instruction = _appendInstruction(program, capacity);
+		_compileIdentifier(debugger, tree->token.identifierValue, instruction);
+		instruction->dest = slot;
+		return true;
+	case TOKEN_ERROR_TYPE:
+	default:
+		break;
+	}
+	return false;
+}
+
+bool mDebuggerCompileParseTree(struct mDebugger* debugger, const struct ParseTree* tree, struct ParseProgram* program) {
+	program->instructions = NULL;
+	program->nInstructions = 0;
+	size_t capacity = 0;
+	if (!_compileNode(debugger, tree, 0, program, &capacity)) {
+		parseProgramFree(program);
+		return false;
+	}
+	return true;
+}
+
+bool mDebuggerEvaluateParseProgram(struct mDebugger* debugger, const struct ParseProgram* program, int32_t* value, int* segment) {
+	int32_t slots[PARSE_PROGRAM_MAX_SLOTS];
+	int currentSegment = -1;
+	size_t i;
+	for (i = 0; i < program->nInstructions; ++i) {
+		const struct ParseInstruction* instruction = &program->instructions[i];
+		switch (instruction->type) {
+		case PARSE_CONSTANT:
+			slots[instruction->dest] = instruction->value;
+			currentSegment = instruction->segment;
+			break;
+		case PARSE_REGISTER:
+			slots[instruction->dest] = *instruction->reg;
+			currentSegment = -1;
+			break;
+		case PARSE_IDENTIFIER:
+			if (!debugger || !mDebuggerLookupIdentifier(debugger, instruction->identifier, &slots[instruction->dest], &currentSegment)) {
+				return false;
+			}
+			break;
+		case PARSE_SEGMENT:
+			currentSegment = instruction->segment;
+			break;
+		case PARSE_OPERATION:
+			if (!_performOperation(debugger, instruction->operation, slots[instruction->lhs], slots[instruction->rhs], &slots[instruction->dest], &currentSegment)) {
+				return false;
+			}
+			break;
+		}
+	}
+	*value = slots[0];
+	*segment = currentSegment;
+	return true;
+}
+
+void parseProgramFree(struct ParseProgram* program) {
+	size_t i;
+	for (i = 0; i < program->nInstructions; ++i) {
+		if (program->instructions[i].type == PARSE_IDENTIFIER) {
+			free(program->instructions[i].identifier);
+		}
+	}
+	free(program->instructions);
+	program->instructions = NULL;
+	program->nInstructions = 0;
+}
+
+struct ParseProgram* mDebuggerCompileCondition(struct mDebugger* debugger, const struct ParseTree* condition) {
+	if (!condition) {
+		return NULL;
+	}
+	struct ParseProgram* program = malloc(sizeof(*program));
+	if (!mDebuggerCompileParseTree(debugger, condition, program)) {
+		free(program);
+		return NULL;
+	}
+	return program;
+}
+
+bool mDebuggerCheckCondition(struct mDebugger* debugger, struct ParseTree* condition, const struct ParseProgram* program) {
+	int32_t value;
+	int segment;
+	if (program) {
+		if (!mDebuggerEvaluateParseProgram(debugger, program, &value, &segment)) {
+			return false;
+		}
+	} else if (!mDebuggerEvaluateParseTree(debugger, condition, &value, &segment)) {
+		return false;
+	}
+	return value || segment >= 0;
+}
@@ -0,0 +1,265 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/internal/debugger/profiler.h>
+
+#include <mgba/core/core.h>
+#include <mgba/internal/debugger/symbols.h>
+#include <mgba-util/vfs.h>
+
+#ifdef M_CORE_GBA
+#include <mgba/internal/arm/arm.h>
+#include <mgba/internal/arm/isa-inlines.h>
+#endif
+#ifdef M_CORE_GB
+#include <mgba/internal/gb/gb.h>
+#include <mgba/internal/sm83/sm83.h>
+#endif
+
+#include <inttypes.h>
+
+#define PROFILER_NAME_LENGTH 128
+
+struct mDebuggerProfilerSite {
+	struct mDebuggerProfilerSample sample;
+	uint64_t count;
+	// Sites whose keys collide
+	struct mDebuggerProfilerSite* next;
+};
+
+struct mDebuggerProfilerStack {
+	const char* name;
+	uint64_t count;
+};
+
+#ifdef M_CORE_GBA
+static void _sampleARM(struct mCore* core, struct mDebuggerProfilerSample* sample) {
+	struct ARMCore* cpu = core->cpu;
+	sample->pc = _ARMPCAddress(cpu);
+	if (cpu->executionMode == MODE_THUMB) {
+		sample->pc |= 1;
+	}
+	sample->lr = cpu->gprs[ARM_LR];
+	sample->segment = -1;
+	sample->hasLink = true;
+}
+#endif
+
+#ifdef M_CORE_GB
+static void _sampleSM83(struct mCore* core, struct mDebuggerProfilerSample* sample) {
+	struct SM83Core* cpu = core->cpu;
+	struct GB* gb = core->board;
+	sample->pc = cpu->pc;
+	sample->lr = 0;
+	if (cpu->pc < GB_BASE_CART_BANK1) {
+		sample->segment = 0;
+	} else if (cpu->pc < GB_BASE_VRAM) {
+		sample->segment = gb->memory.currentBank;
+	} else {
+		sample->segment = -1;
+	}
+	sample->hasLink = false;
+}
+#endif
+
+static void _sampleNone(struct mCore* core, struct mDebuggerProfilerSample* sample) {
+	UNUSED(core);
+	memset(sample, 0, sizeof(*sample));
+	sample->segment = -1;
+}
+
+static uint32_t _siteKey(const struct mDebuggerProfilerSample* sample) {
+	return sample->pc ^ (sample->lr * 0x9E3779B1) ^ (uint32_t) sample->segment;
+}
+
+static void _freeSite(void* value) {
+	struct mDebuggerProfilerSite* site = value;
+	while (site) {
+		struct mDebuggerProfilerSite* next = site->next;
+		free(site);
+		site = next;
+	}
+}
+
+static void _record(struct mDebuggerProfiler* profiler, const struct mDebuggerProfilerSample* sample) {
+	uint32_t key = _siteKey(sample);
+	struct mDebuggerProfilerSite* head = TableLookup(&profiler->sites, key);
+	struct mDebuggerProfilerSite* site;
+	for (site = head; site; site = site->next) {
+		if (site->sample.pc == sample->pc && site->sample.lr == sample->lr && site->sample.segment == sample->segment && site->sample.hasLink == sample->hasLink) {
+			++site->count;
+			++profiler->samples;
+			return;
+		}
+	}
+	site = malloc(sizeof(*site));
+	site->sample = *sample;
+	site->count = 1;
+	if (head) {
+		// Splice in behind the head so the table keeps owning the whole chain
+		site->next = head->next;
+		head->next = site;
+	} else {
+		site->next = NULL;
+		TableInsert(&profiler->sites, key, site);
+	}
+	++profiler->samples;
+}
+
+static void _mDebuggerProfilerSample(struct mTiming* timing, void* context, uint32_t cyclesLate) {
+	struct mDebuggerProfiler* profiler = context;
+	struct mDebuggerProfilerSample sample;
+	profiler->sample(profiler->core, &sample);
+	_record(profiler, &sample);
+
+	uint32_t when = profiler->period;
+	if (cyclesLate < when) {
+		when -= cyclesLate;
+	} else {
+		when = 1;
+	}
+	mTimingSchedule(timing, &profiler->event, when);
+}
+
+void mDebuggerProfilerInit(struct mDebuggerProfiler* profiler, struct mCore* core, uint32_t period) {
+	profiler->core = core;
+	profiler->period = period ? period : mDEBUGGER_PROFILER_DEFAULT_PERIOD;
+	profiler->samples = 0;
+	TableInit(&profiler->sites, 0, _freeSite);
+
+	profiler->event.context = profiler;
+	profiler->event.name = "Sampling Profiler";
+	profiler->event.callback = _mDebuggerProfilerSample;
+	profiler->event.priority = 0x80;
+
+	switch (core->platform(core)) {
+#ifdef M_CORE_GBA
+	case PLATFORM_GBA:
+		profiler->sample = _sampleARM;
+		break;
+#endif
+#ifdef M_CORE_GB
+	case PLATFORM_GB:
+		profiler->sample = _sampleSM83;
+		break;
+#endif
+	default:
+		profiler->sample = _sampleNone;
+		break;
+	}
+}
+
+void mDebuggerProfilerDeinit(struct mDebuggerProfiler* profiler) {
+	mDebuggerProfilerStop(profiler);
+	TableDeinit(&profiler->sites);
+}
+
+void mDebuggerProfilerStart(struct mDebuggerProfiler* profiler) {
+	if (!mTimingIsScheduled(profiler->core->timing, &profiler->event)) {
+		mTimingSchedule(profiler->core->timing, &profiler->event, profiler->period);
+	}
+}
+
+void mDebuggerProfilerStop(struct mDebuggerProfiler* profiler) {
+	mTimingDeschedule(profiler->core->timing, &profiler->event);
+}
+
+bool mDebuggerProfilerIsRunning(const struct mDebuggerProfiler* profiler) {
+	return mTimingIsScheduled(profiler->core->timing, &profiler->event);
+}
+
+void mDebuggerProfilerClear(struct mDebuggerProfiler* profiler) {
+	TableClear(&profiler->sites);
+	profiler->samples = 0;
+}
+
+static const char* _symbolName(struct mDebuggerSymbols* symbols, uint32_t address, int segment, char* buffer) {
+	if (symbols) {
+		const char* name = mDebuggerSymbolNearest(symbols, address, segment, NULL);
+		if (name) {
+			return name;
+		}
+	}
+	if (segment >= 0) {
+		snprintf(buffer, PROFILER_NAME_LENGTH, "%02X:%04X", segment, address);
+	} else {
+		snprintf(buffer, PROFILER_NAME_LENGTH, "%08X", address & ~1);
+	}
+	return buffer;
+}
+
+struct mDebuggerProfilerFoldContext {
+	struct mDebuggerSymbols* symbols;
+	struct Table stacks;
+};
+
+static void _foldSite(uint32_t key, void* value, void* user) {
+	UNUSED(key);
+	struct mDebuggerProfilerFoldContext* context = user;
+	const struct mDebuggerProfilerSite* site;
+	for (site = value; site; site = site->next) {
+		char functionBuffer[PROFILER_NAME_LENGTH];
+		char callerBuffer[PROFILER_NAME_LENGTH];
+		char stack[PROFILER_NAME_LENGTH * 2 + 2];
+		const char* function = _symbolName(context->symbols, site->sample.pc, site->sample.segment, functionBuffer);
+		const char* caller = NULL;
+		if (site->sample.hasLink) {
+			caller = _symbolName(context->symbols, site->sample.lr, site->sample.segment, callerBuffer);
+		}
+		// The link register is stale once the function itself calls out, so only trust it across functions
+		if (caller && strcmp(caller, function) != 0) {
+			snprintf(stack, sizeof(stack), "%s;%s", caller, function);
+		} else {
+			snprintf(stack, sizeof(stack), "%s", function);
+		}
+		uint64_t* count = HashTableLookup(&context->stacks, stack);
+		if (!count) {
+			count = calloc(1, sizeof(*count));
+			HashTableInsert(&context->stacks, stack, count);
+		}
+		*count += site->count;
+	}
+}
+
+static void _collectStack(const char* key, void* value, void* user) {
+	struct mDebuggerProfilerStack** cursor = user;
+	(*cursor)->name = key;
+	(*cursor)->count = *(uint64_t*) value;
+	++*cursor;
+}
+
+static int _compareStacks(const void* a, const void* b) {
+	const struct mDebuggerProfilerStack* left = a;
+	const struct mDebuggerProfilerStack* right = b;
+	return strcmp(left->name, right->name);
+}
+
+bool mDebuggerProfilerWriteFolded(struct mDebuggerProfiler* profiler, struct VFile* vf) {
+	struct mDebuggerProfilerFoldContext context = {
+		.symbols = profiler->core->symbolTable
+	};
+	HashTableInit(&context.stacks, 0, free);
+	TableEnumerate(&profiler->sites, _foldSite, &context);
+
+	size_t size = HashTableSize(&context.stacks);
+	struct mDebuggerProfilerStack* stacks = malloc((size ? size : 1) * sizeof(*stacks));
+	struct mDebuggerProfilerStack* cursor = stacks;
+	HashTableEnumerate(&context.stacks, _collectStack, &cursor);
+	qsort(stacks, size, sizeof(*stacks), _compareStacks);
+
+	bool success = true;
+	size_t i;
+	for (i = 0; i < size && success; ++i) {
+		char line[PROFILER_NAME_LENGTH * 2 + 32];
+		int length = snprintf(line, sizeof(line), "%s %" PRIu64 "\n", stacks[i].name, stacks[i].count);
+		if (length < 0 || (size_t) length >= sizeof(line)) {
+			continue;
+		}
+		success = vf->write(vf, line, length) == length;
+	}
+	free(stacks);
+	HashTableDeinit(&context.stacks);
+	return success;
+}
@@ -7,25 +7,44 @@
 
 #include <mgba-util/string.h>
 #include <mgba-util/table.h>
+#include <mgba-util/vector.h>
 #include <mgba-util/vfs.h>
 
 struct mDebuggerSymbol {
 	int32_t value;
+	uint32_t size;
 	int segment;
 };
 
+struct mDebuggerSymbolAddress {
+	uint32_t value;
+	uint32_t size;
+	int segment;
+	const char* name;
+};
+
+DECLARE_VECTOR(mDebuggerSymbolAddressList, struct mDebuggerSymbolAddress);
+DEFINE_VECTOR(mDebuggerSymbolAddressList, struct mDebuggerSymbolAddress);
+
 struct mDebuggerSymbols {
 	struct Table names;
+
+	// Sorted by address, rebuilt on the first reverse lookup after a change
+	struct mDebuggerSymbolAddressList addresses;
+	bool addressesDirty;
 };
 
 struct mDebuggerSymbols* mDebuggerSymbolTableCreate(void) {
 	struct mDebuggerSymbols* st = malloc(sizeof(*st));
 	HashTableInit(&st->names, 0, free);
+	mDebuggerSymbolAddressListInit(&st->addresses, 0);
+	st->addressesDirty = false;
 	return st;
 }
 
 void mDebuggerSymbolTableDestroy(struct mDebuggerSymbols* st) {
 	HashTableDeinit(&st->names);
+	mDebuggerSymbolAddressListDeinit(&st->addresses);
 	free(st);
 }
 
@@ -40,14 +59,113 @@ bool mDebuggerSymbolLookup(const struct mDebuggerSymbols* st, const char* name,
 }
 
 void mDebuggerSymbolAdd(struct mDebuggerSymbols* st, const char* name, int32_t value, int segment) {
+	mDebuggerSymbolAddSized(st, name, value, 0, segment);
+}
+
+void mDebuggerSymbolAddSized(struct mDebuggerSymbols* st, const char* name, int32_t value, uint32_t size, int segment) {
 	struct mDebuggerSymbol* sym = malloc(sizeof(*sym));
 	sym->value = value;
+	sym->size = size;
 	sym->segment = segment;
 	HashTableInsert(&st->names, name, sym);
+	st->addressesDirty = true;
 }
 
 void mDebuggerSymbolRemove(struct mDebuggerSymbols* st, const char* name) {
 	HashTableRemove(&st->names, name);
+	st->addressesDirty = true;
+}
+
+static void _addAddress(const char* name, void* value, void* user) {
+	const struct mDebuggerSymbol* sym = value;
+	struct mDebuggerSymbolAddress* address = mDebuggerSymbolAddressListAppend(user);
+	address->value = sym->value;
+	address->size = sym->size;
+	address->segment = sym->segment;
+	address->name = name;
+}
+
+static int _compareAddresses(const void* a, const void* b) {
+	const struct mDebuggerSymbolAddress* left = a;
+	const struct mDebuggerSymbolAddress* right = b;
+	if (left->value != right->value) {
+		return left->value < right->value ? -1 : 1;
+	}
+	// Keep the order stable for symbols sharing an address
+	return strcmp(left->name, right->name);
+}
+
+static void _sortAddresses(struct mDebuggerSymbols* st) {
+	if (!st->addressesDirty) {
+		return;
+	}
+	mDebuggerSymbolAddressListClear(&st->addresses);
+	HashTableEnumerate(&st->names, _addAddress, &st->addresses);
+	qsort(mDebuggerSymbolAddressListGetPointer(&st->addresses, 0), mDebuggerSymbolAddressListSize(&st->addresses), sizeof(struct mDebuggerSymbolAddress), _compareAddresses);
+	st->addressesDirty = false;
+}
+
+// Index of the first symbol past the address
+static size_t _upperBound(const struct mDebuggerSymbols* st, uint32_t address) {
+	size_t low = 0;
+	size_t high = mDebuggerSymbolAddressListSize(&st->addresses);
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (mDebuggerSymbolAddressListGetConstPointer(&st->addresses, mid)->value <= address) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+// Walks back from the upper bound to a symbol in a compatible segment. One whose size is known
+// and doesn't reach the address means the address lies between symbols, so nothing matches.
+static const struct mDebuggerSymbolAddress* _nearestBelow(const struct mDebuggerSymbols* st, size_t upper, uint32_t address, int segment) {
+	while (upper) {
+		--upper;
+		const struct mDebuggerSymbolAddress* sym = mDebuggerSymbolAddressListGetConstPointer(&st->addresses, upper);
+		if (sym->segment < 0 || segment < 0 || sym->segment == segment) {
+			if (sym->size && address - sym->value >= sym->size) {
+				return NULL;
+			}
+			return sym;
+		}
+	}
+	return NULL;
+}
+
+const char* mDebuggerSymbolNearest(struct mDebuggerSymbols* st, uint32_t address, int segment, uint32_t* offset) {
+	_sortAddresses(st);
+	const struct mDebuggerSymbolAddress* sym = _nearestBelow(st, _upperBound(st, address), address, segment);
+	if (!sym) {
+		return NULL;
+	}
+	if (offset) {
+		*offset = address - sym->value;
+	}
+	return sym->name;
+}
+
+void mDebuggerSymbolResolve(struct mDebuggerSymbols* st, const uint32_t* addresses, size_t count, int segment, const char** names) {
+	_sortAddresses(st);
+	size_t nSymbols = mDebuggerSymbolAddressListSize(&st->addresses);
+	size_t upper = 0;
+	const struct mDebuggerSymbolAddress* sym = NULL;
+	bool valid = false;
+	size_t i;
+	for (i = 0; i < count; ++i) {
+		uint32_t address = addresses[i];
+		// Samples tend to come in runs within the same function, and then the search can be skipped
+		if (!valid || (upper && mDebuggerSymbolAddressListGetConstPointer(&st->addresses, upper - 1)->value > address) ||
+		    (upper < nSymbols && mDebuggerSymbolAddressListGetConstPointer(&st->addresses, upper)->value <= address)) {
+			upper = _upperBound(st, address);
+			valid = true;
+		}
+		sym = _nearestBelow(st, upper, address, segment);
+		names[i] = sym ? sym->name : NULL;
+	}
 }
 
 void mDebuggerLoadARMIPSSymbols(struct mDebuggerSymbols* st, struct VFile* vf) {
@@ -83,6 +201,16 @@ void mDebuggerLoadARMIPSSymbols(struct mDebuggerSymbols* st, struct VFile* vf) {
 			continue;
 		}
 
-		mDebuggerSymbolAdd(st, buf, address, -1);
+		// Newer versions of armips can follow the name with its size in hex
+		uint32_t size = 0;
+		char* comma = strchr(buf, ',');
+		if (comma) {
+			*comma = '\0';
+			if (!hex32(&comma[1], &size)) {
+				size = 0;
+			}
+		}
+
+		mDebuggerSymbolAddSized(st, buf, address, size, -1);
 	}
 }
@@ -135,6 +135,50 @@ M_TEST_DEFINE(parseUnaryChainedOperator) {
 	assert_int_equal(tree->rhs->rhs->token.uintValue, 2);
 }
 
+static void _compareCompiled(struct LPTest* lp, const char* expression) {
+	lexFree(&lp->lv);
+	LexVectorClear(&lp->lv);
+	lexExpression(&lp->lv, expression, strlen(expression), "");
+	parseLexedExpression(&lp->tree, &lp->lv);
+
+	int32_t treeValue = 0;
+	int treeSegment = -1;
+	bool treeSuccess = mDebuggerEvaluateParseTree(NULL, &lp->tree, &treeValue, &treeSegment);
+
+	struct ParseProgram program;
+	assert_true(mDebuggerCompileParseTree(NULL, &lp->tree, &program));
+	int32_t programValue = 0;
+	int programSegment = -1;
+	assert_int_equal(mDebuggerEvaluateParseProgram(NULL, &program, &programValue, &programSegment), treeSuccess);
+	if (treeSuccess) {
+		assert_int_equal(programValue, treeValue);
+		assert_int_equal(programSegment, treeSegment);
+	}
+	parseProgramFree(&program);
+	parseFree(&lp->tree);
+	lp->tree = (struct ParseTree) { .token.type = TOKEN_ERROR_TYPE };
+}
+
+M_TEST_DEFINE(compileExpressions) {
+	struct LPTest* lp = *state;
+	_compareCompiled(lp, "(1+2)*3");
+	_compareCompiled(lp, "-5 + ~3 - 10 / 3");
+	_compareCompiled(lp, "!0 || 2 && 0");
+	_compareCompiled(lp, "10 % 4 << 3 >> 1 ^ 0x55 | 2 & 6");
+	_compareCompiled(lp, "1 < 2 == 3 >= 3");
+	_compareCompiled(lp, "1 + (2 * (3 + (4 * (5 + (6 * (7 + 8))))))");
+	_compareCompiled(lp, "$01:0010");
+	_compareCompiled(lp, "7 / 0");
+	_compareCompiled(lp, "7 % (1 - 1)");
+}
+
+M_TEST_DEFINE(compileErrors) {
+	PARSE("1 2");
+	struct ParseProgram program;
+	assert_false(mDebuggerCompileParseTree(NULL, tree, &program));
+	assert_null(program.instructions);
+}
+
 M_TEST_SUITE_DEFINE(Parser,
 	cmocka_unit_test_setup_teardown(parseEmpty, parseSetup, parseTeardown),
 	cmocka_unit_test_setup_teardown(parseInt, parseSetup, parseTeardown),
@@ -145,4 +189,6 @@ M_TEST_SUITE_DEFINE(Parser,
 	cmocka_unit_test_setup_teardown(parseParentheticalExpression, parseSetup, parseTeardown),
 	cmocka_unit_test_setup_teardown(parseParentheticalAddMultplyExpression, parseSetup, parseTeardown),
 	cmocka_unit_test_setup_teardown(parseIsolatedOperator, parseSetup, parseTeardown),
-	cmocka_unit_test_setup_teardown(parseUnaryChainedOperator, parseSetup, parseTeardown))
+	cmocka_unit_test_setup_teardown(parseUnaryChainedOperator, parseSetup, parseTeardown),
+	cmocka_unit_test_setup_teardown(compileExpressions, parseSetup, parseTeardown),
+	cmocka_unit_test_setup_teardown(compileErrors, parseSetup, parseTeardown))
@@ -0,0 +1,155 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/internal/debugger/profiler.h>
+#include <mgba/internal/debugger/symbols.h>
+#include <mgba-util/vfs.h>
+
+#ifdef M_CORE_GBA
+#include <mgba/gba/core.h>
+#include <mgba/internal/gba/gba.h>
+#endif
+
+M_TEST_DEFINE(nearestSymbol) {
+	struct mDebuggerSymbols* symbols = mDebuggerSymbolTableCreate();
+	mDebuggerSymbolAdd(symbols, "start", 0x08000000, -1);
+	mDebuggerSymbolAdd(symbols, "thumbFunc", 0x08000101, -1);
+	mDebuggerSymbolAdd(symbols, "banked", 0x4000, 2);
+	mDebuggerSymbolAdd(symbols, "otherBank", 0x4100, 3);
+
+	uint32_t offset;
+	assert_null(mDebuggerSymbolNearest(symbols, 0x3FFF, -1, &offset));
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x08000000, -1, &offset), "start");
+	assert_int_equal(offset, 0);
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x080000FE, -1, &offset), "start");
+	assert_int_equal(offset, 0xFE);
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x08000141, -1, &offset), "thumbFunc");
+	assert_int_equal(offset, 0x40);
+
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x4180, 2, NULL), "banked");
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x4180, 3, NULL), "otherBank");
+	assert_null(mDebuggerSymbolNearest(symbols, 0x4080, 3, NULL));
+
+	// Changes after the first lookup must still be seen
+	mDebuggerSymbolRemove(symbols, "thumbFunc");
+	mDebuggerSymbolAdd(symbols, "late", 0x08000120, -1);
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x08000141, -1, NULL), "late");
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x08000110, -1, NULL), "start");
+	mDebuggerSymbolTableDestroy(symbols);
+}
+
+M_TEST_DEFINE(sizedSymbols) {
+	static const char symFile[] =
+		"08000000 .arm\n"
+		"08000000 main,00000010\n"
+		"08000100 table,00000040\n"
+		"08000200 tail\n";
+	struct mDebuggerSymbols* symbols = mDebuggerSymbolTableCreate();
+	struct VFile* vf = VFileFromConstMemory(symFile, sizeof(symFile) - 1);
+	mDebuggerLoadARMIPSSymbols(symbols, vf);
+	vf->close(vf);
+
+	int32_t value;
+	int segment;
+	assert_true(mDebuggerSymbolLookup(symbols, "main", &value, &segment));
+	assert_int_equal(value, 0x08000000);
+
+	uint32_t offset;
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x0800000C, -1, &offset), "main");
+	assert_int_equal(offset, 0xC);
+	// Past the end of a symbol and before the next one
+	assert_null(mDebuggerSymbolNearest(symbols, 0x08000010, -1, NULL));
+	assert_null(mDebuggerSymbolNearest(symbols, 0x08000140, -1, NULL));
+	assert_string_equal(mDebuggerSymbolNearest(symbols, 0x08000400, -1, NULL), "tail");
+
+	static const uint32_t samples[] = { 0x08000004, 0x08000008, 0x08000120, 0x08000080, 0x08000008, 0x07FFFFFF, 0x08000200, 0x08000130 };
+	const char* names[8];
+	mDebuggerSymbolResolve(symbols, samples, 8, -1, names);
+	size_t i;
+	for (i = 0; i < 8; ++i) {
+		const char* name = mDebuggerSymbolNearest(symbols, samples[i], -1, NULL);
+		if (name) {
+			assert_string_equal(names[i], name);
+		} else {
+			assert_null(names[i]);
+		}
+	}
+	assert_string_equal(names[1], "main");
+	assert_null(names[3]);
+	assert_string_equal(names[7], "table");
+	mDebuggerSymbolTableDestroy(symbols);
+}
+
+M_TEST_DEFINE(sampleGBA) {
+#ifdef M_CORE_GBA
+	static const uint32_t rom[] = {
+		0xEB000002, // 08000000 main: bl func
+		0xEAFFFFFD, // 08000004       b main
+		0xE1A00000, // 08000008       nop
+		0xE1A00000, // 0800000C       nop
+		0xE3A01A01, // 08000010 func: mov r1, #0x1000
+		0xE2511001, // 08000014 loop: subs r1, r1, #1
+		0x1AFFFFFD, // 08000018       bne loop
+		0xE12FFF1E, // 0800001C       bx lr
+	};
+	struct mCore* core = GBACoreCreate();
+	core->init(core);
+	mCoreInitConfig(core, NULL);
+	assert_true(core->loadROM(core, VFileFromConstMemory(rom, sizeof(rom))));
+	core->symbolTable = mDebuggerSymbolTableCreate();
+	mDebuggerSymbolAdd(core->symbolTable, "main", 0x08000000, -1);
+	mDebuggerSymbolAdd(core->symbolTable, "func", 0x08000010, -1);
+	core->reset(core);
+	GBASkipBIOS(core->board);
+
+	struct mDebuggerProfiler profiler;
+	mDebuggerProfilerInit(&profiler, core, 0x100);
+	mDebuggerProfilerStart(&profiler);
+	assert_true(mDebuggerProfilerIsRunning(&profiler));
+	// Skipping the BIOS leaves the first frame short
+	core->runFrame(core);
+	core->runFrame(core);
+	assert_true(profiler.samples > 1000);
+
+	struct VFile* vf = VFileMemChunk(NULL, 0);
+	assert_true(mDebuggerProfilerWriteFolded(&profiler, vf));
+	vf->seek(vf, 0, SEEK_SET);
+	char line[64];
+	uint64_t total = 0;
+	uint64_t inFunc = 0;
+	while (vf->readline(vf, line, sizeof(line)) > 0) {
+		char* count = strrchr(line, ' ');
+		assert_non_null(count);
+		*count = '\0';
+		uint64_t samples = strtoull(&count[1], NULL, 10);
+		total += samples;
+		if (strcmp(line, "main;func") == 0) {
+			inFunc = samples;
+		} else {
+			// The only other place the CPU can be is main itself
+			assert_string_equal(line, "main");
+		}
+	}
+	vf->close(vf);
+	assert_int_equal(total, profiler.samples);
+	assert_true(inFunc > total * 9 / 10);
+
+	mDebuggerProfilerStop(&profiler);
+	assert_false(mDebuggerProfilerIsRunning(&profiler));
+	mDebuggerProfilerClear(&profiler);
+	assert_int_equal(profiler.samples, 0);
+	mDebuggerProfilerDeinit(&profiler);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+#endif
+}
+
+M_TEST_SUITE_DEFINE(mDebuggerProfiler,
+	cmocka_unit_test(nearestSymbol),
+	cmocka_unit_test(sizedSymbols),
+	cmocka_unit_test(sampleGBA))
@@ -0,0 +1,87 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/internal/debugger/trace.h>
+#include <mgba-util/vfs.h>
+
+// Enough records to fill several chunks, so the ring wraps at least once
+#define TRACE_TEST_RECORDS 200000
+#define TRACE_TEST_REGISTERS 16
+
+static void _makeEntry(struct mDebuggerTraceEntry* entry, uint32_t i) {
+	entry->opcodeSize = (i & 0x100) ? 2 : 4;
+	// Mostly sequential, with a branch every so often
+	entry->address = 0x08000000 + (i % 61 == 0 ? i * 16 : i * entry->opcodeSize);
+	entry->opcode = i * 0x9E3779B9;
+	if (entry->opcodeSize == 2) {
+		entry->opcode &= 0xFFFF;
+	}
+	entry->cycles = i * 3 + (i & 7);
+	entry->nRegisters = TRACE_TEST_REGISTERS;
+	unsigned r;
+	for (r = 0; r < TRACE_TEST_REGISTERS; ++r) {
+		entry->registers[r] = (i / (r + 1)) * (r + 1);
+	}
+}
+
+static void _roundTrip(unsigned flags) {
+	struct VFile* vf = VFileMemChunk(NULL, 0);
+	struct mDebuggerTraceWriter* writer = malloc(sizeof(*writer));
+	assert_true(mDebuggerTraceWriterInit(writer, vf, 0, TRACE_TEST_REGISTERS, flags));
+	struct mDebuggerTraceEntry entry;
+	uint32_t i;
+	for (i = 0; i < TRACE_TEST_RECORDS; ++i) {
+		_makeEntry(&entry, i);
+		mDebuggerTraceWriterRecord(writer, &entry);
+	}
+	assert_int_equal(writer->records, TRACE_TEST_RECORDS);
+	mDebuggerTraceWriterDeinit(writer);
+	free(writer);
+
+	vf->seek(vf, 0, SEEK_SET);
+	struct mDebuggerTraceReader* reader = malloc(sizeof(*reader));
+	assert_true(mDebuggerTraceReaderInit(reader, vf));
+	assert_int_equal(reader->header.flags, flags);
+	assert_int_equal(reader->header.nRegisters, TRACE_TEST_REGISTERS);
+	struct mDebuggerTraceEntry expected;
+	for (i = 0; i < TRACE_TEST_RECORDS; ++i) {
+		_makeEntry(&expected, i);
+		assert_true(mDebuggerTraceReaderNext(reader, &entry));
+		assert_int_equal(entry.address, expected.address);
+		assert_int_equal(entry.opcode, expected.opcode);
+		assert_int_equal(entry.opcodeSize, expected.opcodeSize);
+		assert_int_equal(entry.cycles, expected.cycles);
+		if (flags & mDEBUGGER_TRACE_REGISTERS) {
+			assert_memory_equal(entry.registers, expected.registers, sizeof(expected.registers));
+		}
+	}
+	assert_false(mDebuggerTraceReaderNext(reader, &entry));
+	free(reader);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(roundTrip) {
+	_roundTrip(0);
+}
+
+M_TEST_DEFINE(roundTripRegisters) {
+	_roundTrip(mDEBUGGER_TRACE_REGISTERS);
+}
+
+M_TEST_DEFINE(rejectForeign) {
+	static const char garbage[32] = "not a trace at all";
+	struct VFile* vf = VFileFromConstMemory(garbage, sizeof(garbage));
+	struct mDebuggerTraceReader* reader = malloc(sizeof(*reader));
+	assert_false(mDebuggerTraceReaderInit(reader, vf));
+	free(reader);
+	vf->close(vf);
+}
+
+M_TEST_SUITE_DEFINE(mDebuggerTrace,
+	cmocka_unit_test(roundTrip),
+	cmocka_unit_test(roundTripRegisters),
+	cmocka_unit_test(rejectForeign))
@@ -0,0 +1,307 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/internal/debugger/trace.h>
+
+#include <mgba-util/vfs.h>
+
+// Each record starts with a byte holding the opcode size in its low three bits,
+// followed by the cycles elapsed since the previous record as a varint, then the
+// address unless it directly follows the previous instruction, then the opcode.
+// With register tracing on, records where registers changed end with a varint
+// mask of those registers and their new values.
+#define TRACE_OPCODE_SIZE_MASK 0x07
+#define TRACE_HAS_ADDRESS 0x08
+#define TRACE_HAS_REGISTERS 0x10
+
+#define TRACE_HEADER_SIZE 16
+
+static const char _magic[4] = { 'm', 'T', 'R', 'C' };
+
+static size_t _writeVarint(uint8_t* out, uint32_t value) {
+	size_t size = 0;
+	while (value >= 0x80) {
+		out[size] = (value & 0x7F) | 0x80;
+		value >>= 7;
+		++size;
+	}
+	out[size] = value;
+	return size + 1;
+}
+
+static size_t _readVarint(const uint8_t* in, size_t available, uint32_t* value) {
+	*value = 0;
+	size_t size;
+	for (size = 0; size < available && size < 5; ++size) {
+		*value |= (uint32_t) (in[size] & 0x7F) << (7 * size);
+		if (!(in[size] & 0x80)) {
+			return size + 1;
+		}
+	}
+	return 0;
+}
+
+static void _writeChunk(struct mDebuggerTraceWriter* writer, const struct mDebuggerTraceChunk* chunk) {
+	if (chunk->size) {
+		writer->vf->write(writer->vf, chunk->data, chunk->size);
+	}
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _mDebuggerTraceWriterThread(void* context) {
+	struct mDebuggerTraceWriter* writer = context;
+	ThreadSetName("Trace Writer");
+	MutexLock(&writer->mutex);
+	while (true) {
+		if (RingFIFORead(&writer->fifo, &writer->pending, sizeof(writer->pending))) {
+			ConditionWake(&writer->dataConsumed);
+			MutexUnlock(&writer->mutex);
+			_writeChunk(writer, &writer->pending);
+			MutexLock(&writer->mutex);
+			continue;
+		}
+		if (writer->finished) {
+			break;
+		}
+		ConditionWait(&writer->dataAvailable, &writer->mutex);
+	}
+	MutexUnlock(&writer->mutex);
+	return 0;
+}
+#endif
+
+static void _pushChunk(struct mDebuggerTraceWriter* writer) {
+	if (!writer->chunk.size) {
+		return;
+	}
+#ifndef DISABLE_THREADING
+	MutexLock(&writer->mutex);
+	while (!RingFIFOWrite(&writer->fifo, &writer->chunk, sizeof(writer->chunk))) {
+		ConditionWait(&writer->dataConsumed, &writer->mutex);
+	}
+	ConditionWake(&writer->dataAvailable);
+	MutexUnlock(&writer->mutex);
+#else
+	_writeChunk(writer, &writer->chunk);
+#endif
+	writer->chunk.size = 0;
+}
+
+bool mDebuggerTraceWriterInit(struct mDebuggerTraceWriter* writer, struct VFile* vf, int platform, unsigned nRegisters, unsigned flags) {
+	if (nRegisters > mDEBUGGER_TRACE_MAX_REGISTERS) {
+		return false;
+	}
+	uint8_t header[TRACE_HEADER_SIZE] = {0};
+	memcpy(header, _magic, sizeof(_magic));
+	STORE_16LE(mDEBUGGER_TRACE_VERSION, 4, header);
+	header[6] = flags;
+	header[7] = nRegisters;
+	STORE_32LE(platform, 8, header);
+	if (vf->write(vf, header, sizeof(header)) != sizeof(header)) {
+		return false;
+	}
+
+	writer->vf = vf;
+	writer->flags = flags;
+	writer->records = 0;
+	writer->hasLast = false;
+	memset(&writer->last, 0, sizeof(writer->last));
+	writer->last.nRegisters = nRegisters;
+	writer->chunk.size = 0;
+
+#ifndef DISABLE_THREADING
+	RingFIFOInit(&writer->fifo, (mDEBUGGER_TRACE_CHUNKS + 1) * sizeof(struct mDebuggerTraceChunk));
+	MutexInit(&writer->mutex);
+	ConditionInit(&writer->dataAvailable);
+	ConditionInit(&writer->dataConsumed);
+	writer->finished = false;
+	if (ThreadCreate(&writer->thread, _mDebuggerTraceWriterThread, writer)) {
+		ConditionDeinit(&writer->dataConsumed);
+		ConditionDeinit(&writer->dataAvailable);
+		MutexDeinit(&writer->mutex);
+		RingFIFODeinit(&writer->fifo);
+		return false;
+	}
+#endif
+	return true;
+}
+
+void mDebuggerTraceWriterDeinit(struct mDebuggerTraceWriter* writer) {
+	_pushChunk(writer);
+#ifndef DISABLE_THREADING
+	MutexLock(&writer->mutex);
+	writer->finished = true;
+	ConditionWake(&writer->dataAvailable);
+	MutexUnlock(&writer->mutex);
+	ThreadJoin(&writer->thread);
+	ConditionDeinit(&writer->dataConsumed);
+	ConditionDeinit(&writer->dataAvailable);
+	MutexDeinit(&writer->mutex);
+	RingFIFODeinit(&writer->fifo);
+#endif
+}
+
+void mDebuggerTraceWriterFlush(struct mDebuggerTraceWriter* writer) {
+	_pushChunk(writer);
+}
+
+void mDebuggerTraceWriterRecord(struct mDebuggerTraceWriter* writer, const struct mDebuggerTraceEntry* entry) {
+	if (writer->chunk.size + mDEBUGGER_TRACE_MAX_RECORD > sizeof(writer->chunk.data)) {
+		_pushChunk(writer);
+	}
+	struct mDebuggerTraceEntry* last = &writer->last;
+	uint8_t* out = &writer->chunk.data[writer->chunk.size];
+	size_t size = 1;
+	uint8_t head = entry->opcodeSize & TRACE_OPCODE_SIZE_MASK;
+
+	size += _writeVarint(&out[size], entry->cycles - last->cycles);
+	if (!writer->hasLast || entry->address != last->address + last->opcodeSize) {
+		head |= TRACE_HAS_ADDRESS;
+		STORE_32LE(entry->address, size, out);
+		size += 4;
+	}
+	unsigned i;
+	for (i = 0; i < entry->opcodeSize; ++i) {
+		out[size] = entry->opcode >> (8 * i);
+		++size;
+	}
+
+	if (writer->flags & mDEBUGGER_TRACE_REGISTERS) {
+		uint32_t mask = 0;
+		for (i = 0; i < last->nRegisters; ++i) {
+			if (entry->registers[i] != last->registers[i]) {
+				mask |= 1 << i;
+			}
+		}
+		if (mask) {
+			head |= TRACE_HAS_REGISTERS;
+			size += _writeVarint(&out[size], mask);
+			for (i = 0; i < last->nRegisters; ++i) {
+				if (mask & (1 << i)) {
+					STORE_32LE(entry->registers[i], size, out);
+					size += 4;
+					last->registers[i] = entry->registers[i];
+				}
+			}
+		}
+	}
+	out[0] = head;
+
+	last->address = entry->address;
+	last->opcodeSize = entry->opcodeSize;
+	last->cycles = entry->cycles;
+	writer->hasLast = true;
+	writer->chunk.size += size;
+	++writer->records;
+}
+
+bool mDebuggerTraceReaderInit(struct mDebuggerTraceReader* reader, struct VFile* vf) {
+	uint8_t header[TRACE_HEADER_SIZE];
+	if (vf->read(vf, header, sizeof(header)) != sizeof(header)) {
+		return false;
+	}
+	if (memcmp(header, _magic, sizeof(_magic)) != 0) {
+		return false;
+	}
+	memcpy(reader->header.magic, _magic, sizeof(_magic));
+	LOAD_16LE(reader->header.version, 4, header);
+	reader->header.flags = header[6];
+	reader->header.nRegisters = header[7];
+	LOAD_32LE(reader->header.platform, 8, header);
+	LOAD_32LE(reader->header.reserved, 12, header);
+	if (reader->header.version != mDEBUGGER_TRACE_VERSION || reader->header.nRegisters > mDEBUGGER_TRACE_MAX_REGISTERS) {
+		return false;
+	}
+
+	reader->vf = vf;
+	reader->hasLast = false;
+	memset(&reader->last, 0, sizeof(reader->last));
+	reader->last.nRegisters = reader->header.nRegisters;
+	reader->offset = 0;
+	reader->size = 0;
+	return true;
+}
+
+bool mDebuggerTraceReaderNext(struct mDebuggerTraceReader* reader, struct mDebuggerTraceEntry* entry) {
+	if (reader->size - reader->offset < mDEBUGGER_TRACE_MAX_RECORD) {
+		memmove(reader->buffer, &reader->buffer[reader->offset], reader->size - reader->offset);
+		reader->size -= reader->offset;
+		reader->offset = 0;
+		ssize_t read = reader->vf->read(reader->vf, &reader->buffer[reader->size], sizeof(reader->buffer) - reader->size);
+		if (read > 0) {
+			reader->size += read;
+		}
+	}
+	const uint8_t* in = &reader->buffer[reader->offset];
+	size_t available = reader->size - reader->offset;
+	if (!available) {
+		return false;
+	}
+
+	struct mDebuggerTraceEntry* last = &reader->last;
+	uint8_t head = in[0];
+	size_t size = 1;
+	uint32_t delta;
+	size_t varintSize = _readVarint(&in[size], available - size, &delta);
+	if (!varintSize) {
+		return false;
+	}
+	size += varintSize;
+
+	entry->opcodeSize = head & TRACE_OPCODE_SIZE_MASK;
+	if (!entry->opcodeSize || entry->opcodeSize > 4) {
+		return false;
+	}
+	if (head & TRACE_HAS_ADDRESS) {
+		if (available - size < 4) {
+			return false;
+		}
+		LOAD_32LE(entry->address, size, in);
+		size += 4;
+	} else if (reader->hasLast) {
+		entry->address = last->address + last->opcodeSize;
+	} else {
+		return false;
+	}
+	if (available - size < entry->opcodeSize) {
+		return false;
+	}
+	entry->opcode = 0;
+	unsigned i;
+	for (i = 0; i < entry->opcodeSize; ++i) {
+		entry->opcode |= in[size] << (8 * i);
+		++size;
+	}
+
+	if (head & TRACE_HAS_REGISTERS) {
+		uint32_t mask;
+		varintSize = _readVarint(&in[size], available - size, &mask);
+		if (!varintSize) {
+			return false;
+		}
+		size += varintSize;
+		for (i = 0; i < last->nRegisters; ++i) {
+			if (!(mask & (1 << i))) {
+				continue;
+			}
+			if (available - size < 4) {
+				return false;
+			}
+			LOAD_32LE(last->registers[i], size, in);
+			size += 4;
+		}
+	}
+
+	entry->cycles = last->cycles + delta;
+	entry->nRegisters = last->nRegisters;
+	memcpy(entry->registers, last->registers, sizeof(entry->registers));
+
+	last->address = entry->address;
+	last->opcodeSize = entry->opcodeSize;
+	last->cycles = entry->cycles;
+	reader->hasLast = true;
+	reader->offset += size;
+	return true;
+}
@@ -35,6 +35,14 @@ static void _ffmpegSetVideoDimensions(struct mAVStream*, unsigned width, unsigne
 
 static bool _ffmpegWriteAudioFrame(struct FFmpegEncoder* encoder, struct AVFrame* audioFrame);
 static bool _ffmpegWriteVideoFrame(struct FFmpegEncoder* encoder, struct AVFrame* videoFrame);
+static void _ffmpegEncodeVideoFrame(struct FFmpegEncoder* encoder, const uint8_t* pixels, int stride, int64_t pts);
+static void _ffmpegWritePacket(struct FFmpegEncoder* encoder, AVPacket* packet);
+
+#ifndef DISABLE_THREADING
+static void _ffmpegStartWorker(struct FFmpegEncoder* encoder);
+static void _ffmpegStopWorker(struct FFmpegEncoder* encoder);
+static void _ffmpegDrainQueue(struct FFmpegEncoder* encoder);
+#endif
 
 enum {
 	PREFERRED_SAMPLE_RATE = 0x8000
@@ -96,6 +104,15 @@ void FFmpegEncoderInit(struct FFmpegEncoder* encoder) {
 	for (i = 0; i < FFMPEG_FILTERS_MAX; ++i) {
 		encoder->filters[i] = NULL;
 	}
+
+#ifndef DISABLE_THREADING
+	encoder->maxQueueMemory = FFMPEG_QUEUE_MEMORY;
+	encoder->workerRunning = false;
+	for (i = 0; i < FFMPEG_QUEUE_MAX; ++i) {
+		encoder->queue[i].pixels = NULL;
+		encoder->queue[i].capacity = 0;
+	}
+#endif
 }
 
 bool FFmpegEncoderSetAudio(struct FFmpegEncoder* encoder, const char* acodec, unsigned abr) {
@@ -180,6 +197,7 @@ bool FFmpegEncoderSetVideo(struct FFmpegEncoder* encoder, const char* vcodec, un
 		{ AV_PIX_FMT_YUV422P, 4 },
 		{ AV_PIX_FMT_YUV444P, 5 },
 		{ AV_PIX_FMT_YUV420P, 6 },
+		{ AV_PIX_FMT_NV12, 6 },
 		{ AV_PIX_FMT_PAL8, 7 },
 	};
 
@@ -361,6 +379,16 @@ bool FFmpegEncoderOpen(struct FFmpegEncoder* encoder, const char* outfile) {
 		encoder->video->time_base = (AVRational) { VIDEO_TOTAL_LENGTH * encoder->frameskip, GBA_ARM7TDMI_FREQUENCY };
 		encoder->video->framerate = (AVRational) { GBA_ARM7TDMI_FREQUENCY, VIDEO_TOTAL_LENGTH * encoder->frameskip };
 		encoder->video->pix_fmt = encoder->pixFormat;
+		if (encoder->pixFormat != AV_PIX_FMT_PAL8 && encoder->width == encoder->iwidth && encoder->height == encoder->iheight) {
+			// If the codec takes frames just as the core produces them, they don't need converting at all
+			size_t i;
+			for (i = 0; vcodec->pix_fmts[i] != AV_PIX_FMT_NONE; ++i) {
+				if (vcodec->pix_fmts[i] == encoder->ipixFormat) {
+					encoder->video->pix_fmt = encoder->ipixFormat;
+					break;
+				}
+			}
+		}
 		encoder->video->gop_size = 60;
 		encoder->video->max_b_frames = 3;
 		if (encoder->context->oformat->flags & AVFMT_GLOBALHEADER) {
@@ -458,6 +486,10 @@ bool FFmpegEncoderOpen(struct FFmpegEncoder* encoder, const char* outfile) {
 			encoder->sinkFrame = avcodec_alloc_frame();
 #endif
 		}
+		// Codecs that can will spread the work over frames and slices on their own threads
+		encoder->video->thread_count = 0;
+		encoder->video->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
 		AVDictionary* opts = 0;
 		av_dict_set(&opts, "strict", "-2", 0);
 		int res = avcodec_open2(encoder->video, vcodec, &opts);
@@ -490,10 +522,20 @@ bool FFmpegEncoderOpen(struct FFmpegEncoder* encoder, const char* outfile) {
 		FFmpegEncoderClose(encoder);
 		return false;
 	}
+#ifndef DISABLE_THREADING
+	if (encoder->video) {
+		_ffmpegStartWorker(encoder);
+	}
+#endif
 	return true;
 }
 
 void FFmpegEncoderClose(struct FFmpegEncoder* encoder) {
+#ifndef DISABLE_THREADING
+	if (encoder->workerRunning) {
+		_ffmpegStopWorker(encoder);
+	}
+#endif
 	if (encoder->audio) {
 		while (true) {
 			if (!_ffmpegWriteAudioFrame(encoder, NULL)) {
@@ -710,11 +752,11 @@ bool _ffmpegWriteAudioFrame(struct FFmpegEncoder* encoder, struct AVFrame* audio
 #endif
 
 				packet.stream_index = encoder->audioStream->index;
-				av_interleaved_write_frame(encoder->context, &packet);
+				_ffmpegWritePacket(encoder, &packet);
 			}
 		} else {
 			packet.stream_index = encoder->audioStream->index;
-			av_interleaved_write_frame(encoder->context, &packet);
+			_ffmpegWritePacket(encoder, &packet);
 		}
 	}
 #ifdef FFMPEG_USE_PACKET_UNREF
@@ -736,29 +778,73 @@ void _ffmpegPostVideoFrame(struct mAVStream* stream, const color_t* pixels, size
 	}
 	stride *= BYTES_PER_PIXEL;
 
+	int64_t pts = av_rescale_q(encoder->currentVideoFrame, encoder->video->time_base, encoder->videoStream->time_base);
+	++encoder->currentVideoFrame;
+
+#ifndef DISABLE_THREADING
+	if (encoder->workerRunning) {
+		size_t size = stride * encoder->iheight;
+		MutexLock(&encoder->queueMutex);
+		while (encoder->queueCount == FFMPEG_QUEUE_MAX || (encoder->queueCount && encoder->queueMemory + size > encoder->maxQueueMemory)) {
+			ConditionWait(&encoder->queueCond, &encoder->queueMutex);
+		}
+		struct FFmpegQueuedFrame* frame = &encoder->queue[(encoder->queueStart + encoder->queueCount) % FFMPEG_QUEUE_MAX];
+		MutexUnlock(&encoder->queueMutex);
+
+		// The worker never touches slots past the end of the queue, so this can be filled unlocked
+		if (frame->capacity < size) {
+			free(frame->pixels);
+			frame->pixels = malloc(size);
+			frame->capacity = size;
+		}
+		memcpy(frame->pixels, pixels, size);
+		frame->size = size;
+		frame->stride = stride;
+		frame->pts = pts;
+
+		MutexLock(&encoder->queueMutex);
+		++encoder->queueCount;
+		encoder->queueMemory += size;
+		ConditionWake(&encoder->queueCond);
+		MutexUnlock(&encoder->queueMutex);
+		return;
+	}
+#endif
+	_ffmpegEncodeVideoFrame(encoder, (const uint8_t*) pixels, stride, pts);
+}
+
+static void _ffmpegEncodeVideoFrame(struct FFmpegEncoder* encoder, const uint8_t* pixels, int stride, int64_t pts) {
 #if LIBAVCODEC_VERSION_MAJOR >= 55
 	av_frame_make_writable(encoder->videoFrame);
 #endif
-	encoder->videoFrame->pts = av_rescale_q(encoder->currentVideoFrame, encoder->video->time_base, encoder->videoStream->time_base);
-	++encoder->currentVideoFrame;
+	encoder->videoFrame->pts = pts;
 
-	sws_scale(encoder->scaleContext, (const uint8_t* const*) &pixels, (const int*) &stride, 0, encoder->iheight, encoder->videoFrame->data, encoder->videoFrame->linesize);
+	uint8_t* frameData = encoder->videoFrame->data[0];
+	int frameStride = encoder->videoFrame->linesize[0];
+	if (encoder->scaleContext) {
+		sws_scale(encoder->scaleContext, &pixels, &stride, 0, encoder->iheight, encoder->videoFrame->data, encoder->videoFrame->linesize);
+	} else {
+		// Nothing to convert, so point the frame at the pixels instead; the encoder copies what it keeps
+		encoder->videoFrame->data[0] = (uint8_t*) pixels;
+		encoder->videoFrame->linesize[0] = stride;
+	}
 
 	if (encoder->graph) {
-		if (av_buffersrc_add_frame(encoder->source, encoder->videoFrame) < 0) {
-			return;
-		}
-		while (true) {
-			int res = av_buffersink_get_frame(encoder->sink, encoder->sinkFrame);
-			if (res < 0) {
-				break;
+		if (av_buffersrc_add_frame(encoder->source, encoder->videoFrame) >= 0) {
+			while (true) {
+				int res = av_buffersink_get_frame(encoder->sink, encoder->sinkFrame);
+				if (res < 0) {
+					break;
+				}
+				_ffmpegWriteVideoFrame(encoder, encoder->sinkFrame);
+				av_frame_unref(encoder->sinkFrame);
 			}
-			_ffmpegWriteVideoFrame(encoder, encoder->sinkFrame);
-			av_frame_unref(encoder->sinkFrame);
 		}
 	} else {
 		_ffmpegWriteVideoFrame(encoder, encoder->videoFrame);
 	}
+	encoder->videoFrame->data[0] = frameData;
+	encoder->videoFrame->linesize[0] = frameStride;
 }
 
 bool _ffmpegWriteVideoFrame(struct FFmpegEncoder* encoder, struct AVFrame* videoFrame) {
@@ -782,7 +868,7 @@ bool _ffmpegWriteVideoFrame(struct FFmpegEncoder* encoder, struct AVFrame* video
 		}
 #endif
 		packet.stream_index = encoder->videoStream->index;
-		av_interleaved_write_frame(encoder->context, &packet);
+		_ffmpegWritePacket(encoder, &packet);
 	}
 #ifdef FFMPEG_USE_PACKET_UNREF
 	av_packet_unref(&packet);
@@ -793,15 +879,103 @@ bool _ffmpegWriteVideoFrame(struct FFmpegEncoder* encoder, struct AVFrame* video
 	return gotData;
 }
 
+static void _ffmpegWritePacket(struct FFmpegEncoder* encoder, AVPacket* packet) {
+#ifndef DISABLE_THREADING
+	// Video packets come from the worker while audio is still written from the emulator
+	if (encoder->workerRunning) {
+		MutexLock(&encoder->muxMutex);
+		av_interleaved_write_frame(encoder->context, packet);
+		MutexUnlock(&encoder->muxMutex);
+		return;
+	}
+#endif
+	av_interleaved_write_frame(encoder->context, packet);
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _ffmpegWorkerThread(void* context) {
+	struct FFmpegEncoder* encoder = context;
+	ThreadSetName("Video Encoder");
+	MutexLock(&encoder->queueMutex);
+	while (true) {
+		while (!encoder->queueCount && encoder->workerRunning) {
+			ConditionWait(&encoder->queueCond, &encoder->queueMutex);
+		}
+		if (!encoder->queueCount) {
+			break;
+		}
+		struct FFmpegQueuedFrame* frame = &encoder->queue[encoder->queueStart];
+		MutexUnlock(&encoder->queueMutex);
+		_ffmpegEncodeVideoFrame(encoder, frame->pixels, frame->stride, frame->pts);
+		MutexLock(&encoder->queueMutex);
+		encoder->queueStart = (encoder->queueStart + 1) % FFMPEG_QUEUE_MAX;
+		--encoder->queueCount;
+		encoder->queueMemory -= frame->size;
+		ConditionWake(&encoder->queueCond);
+	}
+	MutexUnlock(&encoder->queueMutex);
+	return 0;
+}
+
+static void _ffmpegStartWorker(struct FFmpegEncoder* encoder) {
+	MutexInit(&encoder->queueMutex);
+	MutexInit(&encoder->muxMutex);
+	ConditionInit(&encoder->queueCond);
+	encoder->queueStart = 0;
+	encoder->queueCount = 0;
+	encoder->queueMemory = 0;
+	encoder->workerRunning = true;
+	ThreadCreate(&encoder->worker, _ffmpegWorkerThread, encoder);
+}
+
+static void _ffmpegDrainQueue(struct FFmpegEncoder* encoder) {
+	MutexLock(&encoder->queueMutex);
+	while (encoder->queueCount) {
+		ConditionWait(&encoder->queueCond, &encoder->queueMutex);
+	}
+	MutexUnlock(&encoder->queueMutex);
+}
+
+static void _ffmpegStopWorker(struct FFmpegEncoder* encoder) {
+	_ffmpegDrainQueue(encoder);
+	MutexLock(&encoder->queueMutex);
+	encoder->workerRunning = false;
+	ConditionWake(&encoder->queueCond);
+	MutexUnlock(&encoder->queueMutex);
+	ThreadJoin(&encoder->worker);
+	MutexDeinit(&encoder->queueMutex);
+	MutexDeinit(&encoder->muxMutex);
+	ConditionDeinit(&encoder->queueCond);
+
+	int i;
+	for (i = 0; i < FFMPEG_QUEUE_MAX; ++i) {
+		free(encoder->queue[i].pixels);
+		encoder->queue[i].pixels = NULL;
+		encoder->queue[i].capacity = 0;
+	}
+}
+#endif
+
 static void _ffmpegSetVideoDimensions(struct mAVStream* stream, unsigned width, unsigned height) {
 	struct FFmpegEncoder* encoder = (struct FFmpegEncoder*) stream;
 	if (!encoder->context || !encoder->videoCodec) {
 		return;
 	}
+#ifndef DISABLE_THREADING
+	if (encoder->workerRunning) {
+		// Frames already queued still need to be scaled from the old dimensions
+		_ffmpegDrainQueue(encoder);
+	}
+#endif
 	encoder->iwidth = width;
 	encoder->iheight = height;
 	if (encoder->scaleContext) {
 		sws_freeContext(encoder->scaleContext);
+		encoder->scaleContext = NULL;
+	}
+	if (encoder->iwidth == encoder->videoFrame->width && encoder->iheight == encoder->videoFrame->height &&
+	    encoder->ipixFormat == encoder->videoFrame->format) {
+		return;
 	}
 	encoder->scaleContext = sws_getContext(encoder->iwidth, encoder->iheight, encoder->ipixFormat,
 	    encoder->videoFrame->width, encoder->videoFrame->height, encoder->videoFrame->format,
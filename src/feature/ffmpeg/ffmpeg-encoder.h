@@ -11,6 +11,7 @@
 CXX_GUARD_START
 
 #include <mgba/internal/gba/gba.h>
+#include <mgba-util/threading.h>
 
 #include <libavformat/avformat.h>
 #include <libavcodec/version.h>
@@ -35,6 +36,16 @@ CXX_GUARD_START
 #endif
 
 #define FFMPEG_FILTERS_MAX 4
+#define FFMPEG_QUEUE_MAX 16
+#define FFMPEG_QUEUE_MEMORY 0x2000000
+
+struct FFmpegQueuedFrame {
+	uint8_t* pixels;
+	size_t capacity;
+	size_t size;
+	size_t stride;
+	int64_t pts;
+};
 
 struct FFmpegEncoder {
 	struct mAVStream d;
@@ -89,6 +100,21 @@ struct FFmpegEncoder {
 	struct AVFilterContext* sink;
 	struct AVFilterContext* filters[FFMPEG_FILTERS_MAX];
 	struct AVFrame* sinkFrame;
+
+#ifndef DISABLE_THREADING
+	// Raw frames are queued for a worker thread to convert and encode, so emulation only waits on it
+	// once more than maxQueueMemory bytes of frames are still outstanding
+	size_t maxQueueMemory;
+	struct FFmpegQueuedFrame queue[FFMPEG_QUEUE_MAX];
+	unsigned queueStart;
+	unsigned queueCount;
+	size_t queueMemory;
+	bool workerRunning;
+	Thread worker;
+	Mutex queueMutex;
+	Condition queueCond;
+	Mutex muxMutex;
+#endif
 };
 
 void FFmpegEncoderInit(struct FFmpegEncoder*);
@@ -24,6 +24,8 @@ mLOG_DECLARE_CATEGORY(GUI_RUNNER);
 mLOG_DEFINE_CATEGORY(GUI_RUNNER, "GUI Runner", "gui.runner");
 
 #define AUTOSAVE_GRANULARITY 600
+// Autosaves persisted as deltas between full ones, which keeps the writes to a few KB on slow storage
+#define AUTOSAVE_DELTAS 15
 #define FPS_GRANULARITY 120
 #define FPS_BUFFER_SIZE 3
 
@@ -102,6 +104,31 @@ static void _drawBackground(struct GUIBackground* background, void* context) {
 	}
 }
 
+static bool _readThumbnail(struct mCore* core, struct VFile* vf, color_t* pixels, unsigned width, unsigned height) {
+	static const enum mStateExtdataTag tags[] = { EXTDATA_THUMBNAIL };
+	struct mStateExtdata extdata;
+	struct mStateExtdataItem item;
+	mStateExtdataInit(&extdata);
+	bool success = mCoreExtractExtdata(core, vf, &extdata, tags, 1) && mStateExtdataGet(&extdata, EXTDATA_THUMBNAIL, &item);
+	unsigned thumbWidth, thumbHeight;
+	success = success && mStateThumbnailDecode(&item, &thumbWidth, &thumbHeight, NULL, 0);
+	success = success && thumbWidth && thumbHeight && thumbWidth <= width && thumbHeight <= height;
+	if (success) {
+		// Decode into the bottom-right corner, then scale up in place from the top-left
+		color_t* thumbnail = &pixels[(height - thumbHeight) * width + width - thumbWidth];
+		mStateThumbnailDecode(&item, &thumbWidth, &thumbHeight, thumbnail, width);
+		unsigned x, y;
+		for (y = 0; y < height; ++y) {
+			const color_t* row = &thumbnail[(y * thumbHeight / height) * width];
+			for (x = 0; x < width; ++x) {
+				pixels[y * width + x] = row[x * thumbWidth / width];
+			}
+		}
+	}
+	mStateExtdataDeinit(&extdata);
+	return success;
+}
+
 static void _drawState(struct GUIBackground* background, void* id) {
 	struct mGUIBackground* gbaBackground = (struct mGUIBackground*) background;
 	int stateId = ((int) id) >> 16;
@@ -118,8 +145,8 @@ static void _drawState(struct GUIBackground* background, void* id) {
 			pixels = anonymousMemoryMap(w * h * 4);
 			gbaBackground->screenshot = pixels;
 		}
-		bool success = false;
-		if (vf && isPNG(vf) && pixels) {
+		bool success = vf && pixels && _readThumbnail(gbaBackground->p->core, vf, pixels, w, h);
+		if (!success && vf && pixels && !vf->seek(vf, 0, SEEK_SET) && isPNG(vf)) {
 			png_structp png = PNGReadOpen(vf, PNG_HEADER_BYTES);
 			png_infop info = png_create_info_struct(png);
 			png_infop end = png_create_info_struct(png);
@@ -162,18 +189,7 @@ static void _tryAutosave(struct mGUIRunner* runner) {
 		return;
 	}
 
-#ifdef DISABLE_THREADING
-	mCoreSaveState(runner->core, 0, SAVESTATE_SAVEDATA | SAVESTATE_RTC | SAVESTATE_METADATA);
-#else
-	if (!runner->autosave.buffer) {
-		runner->autosave.buffer = VFileMemChunk(NULL, 0);
-	}
-	MutexLock(&runner->autosave.mutex);
-	runner->autosave.core = runner->core;
-	mCoreSaveStateNamed(runner->core, runner->autosave.buffer, SAVESTATE_SAVEDATA | SAVESTATE_RTC | SAVESTATE_METADATA);
-	ConditionWake(&runner->autosave.cond);
-	MutexUnlock(&runner->autosave.mutex);
-#endif
+	mCoreQuickSaveTake(&runner->autosave, runner->core, SAVESTATE_SAVEDATA | SAVESTATE_RTC | SAVESTATE_METADATA);
 }
 
 void mGUIInit(struct mGUIRunner* runner, const char* port) {
@@ -185,6 +201,7 @@ void mGUIInit(struct mGUIRunner* runner, const char* port) {
 	runner->luminanceSource.luxLevel = 0;
 	runner->background.d.draw = _drawBackground;
 	runner->background.p = runner;
+	runner->autosave.nSlots = 0;
 	runner->fps = 0;
 	runner->lastFpsCheck = 0;
 	runner->totalDelta = 0;
@@ -219,41 +236,16 @@ void mGUIInit(struct mGUIRunner* runner, const char* port) {
 			runner->params.currentPath[PATH_MAX - 1] = '\0';
 		}
 	}
-
-#ifndef DISABLE_THREADING
-	if (!runner->autosave.running) {
-		runner->autosave.running = true;
-		runner->autosave.core = NULL;
-		MutexInit(&runner->autosave.mutex);
-		ConditionInit(&runner->autosave.cond);
-		ThreadCreate(&runner->autosave.thread, mGUIAutosaveThread, &runner->autosave);
-	}
-#endif
 }
 
 void mGUIDeinit(struct mGUIRunner* runner) {
-#ifndef DISABLE_THREADING
-	MutexLock(&runner->autosave.mutex);
-	runner->autosave.running = false;
-	ConditionWake(&runner->autosave.cond);
-	MutexUnlock(&runner->autosave.mutex);
-
-	ThreadJoin(&runner->autosave.thread);
-
-	ConditionDeinit(&runner->autosave.cond);
-	MutexDeinit(&runner->autosave.mutex);
-
-	if (runner->autosave.buffer) {
-		runner->autosave.buffer->close(runner->autosave.buffer);
-	}
-#endif
-
 	if (runner->teardown) {
 		runner->teardown(runner);
 	}
 	CircleBufferDeinit(&runner->fpsBuffer);
 	mInputMapDeinit(&runner->params.keyMap);
 	mCoreConfigDeinit(&runner->config);
+	GUISelectFileClearCache();
 	if (logger.vf) {
 		logger.vf->close(logger.vf);
 		logger.vf = NULL;
@@ -420,20 +412,17 @@ void mGUIRun(struct mGUIRunner* runner, const char* path) {
 	mLOG(GUI_RUNNER, DEBUG, "Reset!");
 
 
+	mCoreQuickSaveContextInit(&runner->autosave, 2, true);
+	runner->autosave.deltaInterval = AUTOSAVE_DELTAS;
+
 	int autoload = false;
 	mCoreConfigGetIntValue(&runner->config, "autoload", &autoload);
-	if (autoload) {
+	if (autoload && !mCoreQuickSaveRestore(&runner->autosave, runner->core, SAVESTATE_SCREENSHOT | SAVESTATE_RTC)) {
 		mCoreLoadState(runner->core, 0, SAVESTATE_SCREENSHOT | SAVESTATE_RTC);
 	}
 
 	bool running = true;
 
-#ifndef DISABLE_THREADING
-	MutexLock(&runner->autosave.mutex);
-	runner->autosave.core = runner->core;
-	MutexUnlock(&runner->autosave.mutex);
-#endif
-
 	if (runner->gameLoaded) {
 		runner->gameLoaded(runner);
 	}
@@ -563,7 +552,7 @@ void mGUIRun(struct mGUIRunner* runner, const char* path) {
 				runner->core->reset(runner->core);
 				break;
 			case RUNNER_SAVE_STATE:
-				mCoreSaveState(runner->core, ((int) item->data) >> 16, SAVESTATE_SCREENSHOT | SAVESTATE_SAVEDATA | SAVESTATE_RTC | SAVESTATE_METADATA);
+				mCoreSaveState(runner->core, ((int) item->data) >> 16, SAVESTATE_SCREENSHOT | SAVESTATE_THUMBNAIL | SAVESTATE_SAVEDATA | SAVESTATE_RTC | SAVESTATE_METADATA);
 				break;
 			case RUNNER_LOAD_STATE:
 				mCoreLoadState(runner->core, ((int) item->data) >> 16, SAVESTATE_SCREENSHOT | SAVESTATE_RTC);
@@ -599,17 +588,10 @@ void mGUIRun(struct mGUIRunner* runner, const char* path) {
 	if (runner->gameUnloaded) {
 		runner->gameUnloaded(runner);
 	}
-#ifndef DISABLE_THREADING
-	MutexLock(&runner->autosave.mutex);
-	runner->autosave.core = NULL;
-	MutexUnlock(&runner->autosave.mutex);
-#endif
 
-	int autosave = false;
-	mCoreConfigGetIntValue(&runner->config, "autosave", &autosave);
-	if (autosave) {
-		mCoreSaveState(runner->core, 0, SAVESTATE_SAVEDATA | SAVESTATE_RTC | SAVESTATE_METADATA);
-	}
+	// Only this last state is left to write on exit; the periodic ones are already on storage
+	_tryAutosave(runner);
+	mCoreQuickSaveContextDeinit(&runner->autosave);
 
 	mLOG(GUI_RUNNER, DEBUG, "Unloading game...");
 	runner->core->unloadROM(runner->core);
@@ -669,21 +651,3 @@ void mGUIRunloop(struct mGUIRunner* runner) {
 		mGUIRun(runner, path);
 	}
 }
-
-#ifndef DISABLE_THREADING
-THREAD_ENTRY mGUIAutosaveThread(void* context) {
-	struct mGUIAutosaveContext* autosave = context;
-	MutexLock(&autosave->mutex);
-	while (autosave->running) {
-		ConditionWait(&autosave->cond, &autosave->mutex);
-		if (autosave->running && autosave->core) {
-			struct VFile* vf = mCoreGetState(autosave->core, 0, true);
-			void* mem = autosave->buffer->map(autosave->buffer, autosave->buffer->size(autosave->buffer), MAP_READ);
-			vf->write(vf, mem, autosave->buffer->size(autosave->buffer));
-			autosave->buffer->unmap(autosave->buffer, mem, autosave->buffer->size(autosave->buffer));
-			vf->close(vf);
-		}
-	}
-	MutexUnlock(&autosave->mutex);
-}
-#endif
@@ -11,6 +11,7 @@
 CXX_GUARD_START
 
 #include <mgba/core/config.h>
+#include <mgba/core/quick-save.h>
 #include "feature/gui/remap.h"
 #include <mgba/internal/gba/hardware.h>
 #include <mgba-util/circle-buffer.h>
@@ -40,27 +41,13 @@ struct mGUIRunnerLux {
 	int luxLevel;
 };
 
-#ifndef DISABLE_THREADING
-struct VFile;
-struct mGUIAutosaveContext {
-	struct VFile* buffer;
-	struct mCore* core;
-	Thread thread;
-	Mutex mutex;
-	Condition cond;
-	bool running;
-};
-#endif
-
 struct mGUIRunner {
 	struct mCore* core;
 	struct GUIParams params;
 
 	struct mGUIBackground background;
 	struct mGUIRunnerLux luminanceSource;
-#ifndef DISABLE_THREADING
-	struct mGUIAutosaveContext autosave;
-#endif
+	struct mCoreQuickSaveContext autosave;
 
 	struct mInputMap guiKeys;
 	struct mCoreConfig config;
@@ -95,10 +82,6 @@ void mGUIDeinit(struct mGUIRunner*);
 void mGUIRun(struct mGUIRunner*, const char* path);
 void mGUIRunloop(struct mGUIRunner*);
 
-#ifndef DISABLE_THREADING
-THREAD_ENTRY mGUIAutosaveThread(void* context);
-#endif
-
 CXX_GUARD_END
 
 #endif
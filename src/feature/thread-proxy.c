@@ -8,8 +8,15 @@
 #include <mgba/core/tile-cache.h>
 #include <mgba/internal/gba/gba.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #ifndef DISABLE_THREADING
 
+// How many times either side polls the queue before falling back to sleeping on a condition
+#define PROXY_SPIN_LIMIT 1024
+
 static void mVideoThreadProxyInit(struct mVideoLogger* logger);
 static void mVideoThreadProxyReset(struct mVideoLogger* logger);
 static void mVideoThreadProxyDeinit(struct mVideoLogger* logger);
@@ -25,6 +32,14 @@ static void _unlock(struct mVideoLogger* logger);
 static void _wait(struct mVideoLogger* logger);
 static void _wake(struct mVideoLogger* logger, int y);
 
+static inline void _spinPause(void) {
+#ifdef __SSE2__
+	_mm_pause();
+#elif defined(__ARM_NEON)
+	__asm__ __volatile__("yield");
+#endif
+}
+
 void mVideoThreadProxyCreate(struct mVideoThreadProxy* renderer) {
 	mVideoLoggerRendererCreate(&renderer->d, false);
 	renderer->d.block = true;
@@ -55,6 +70,7 @@ void mVideoThreadProxyInit(struct mVideoLogger* logger) {
 
 void mVideoThreadProxyReset(struct mVideoLogger* logger) {
 	struct mVideoThreadProxy* proxyRenderer = (struct mVideoThreadProxy*) logger;
+	RingFIFOCommit(&proxyRenderer->dirtyQueue);
 	MutexLock(&proxyRenderer->mutex);
 	while (proxyRenderer->threadState == PROXY_THREAD_BUSY) {
 		ConditionWake(&proxyRenderer->toThreadCond);
@@ -101,7 +117,16 @@ void _proxyThreadRecover(struct mVideoThreadProxy* proxyRenderer) {
 
 static bool _writeData(struct mVideoLogger* logger, const void* data, size_t length) {
 	struct mVideoThreadProxy* proxyRenderer = (struct mVideoThreadProxy*) logger;
-	while (!RingFIFOWrite(&proxyRenderer->dirtyQueue, data, length)) {
+	unsigned spins = 0;
+	// Writes are only committed once per scanline, so the proxy thread isn't handed every packet separately
+	while (!RingFIFOStage(&proxyRenderer->dirtyQueue, data, length)) {
+		RingFIFOCommit(&proxyRenderer->dirtyQueue);
+		if (spins < PROXY_SPIN_LIMIT && proxyRenderer->threadState == PROXY_THREAD_BUSY) {
+			// The proxy thread is already draining the queue, so room should turn up shortly
+			++spins;
+			_spinPause();
+			continue;
+		}
 		mLOG(GBA_VIDEO, DEBUG, "Can't write %"PRIz"u bytes. Proxy thread asleep?", length);
 		MutexLock(&proxyRenderer->mutex);
 		if (proxyRenderer->threadState == PROXY_THREAD_STOPPED) {
@@ -119,9 +144,19 @@ static bool _writeData(struct mVideoLogger* logger, const void* data, size_t len
 static bool _readData(struct mVideoLogger* logger, void* data, size_t length, bool block) {
 	struct mVideoThreadProxy* proxyRenderer = (struct mVideoThreadProxy*) logger;
 	bool read = false;
+	unsigned spins = 0;
 	while (true) {
 		read = RingFIFORead(&proxyRenderer->dirtyQueue, data, length);
-		if (!block || read) {
+		if (read) {
+			break;
+		}
+		if (spins < PROXY_SPIN_LIMIT) {
+			// The next scanline usually gets committed sooner than sleeping and being woken up would take
+			++spins;
+			_spinPause();
+			continue;
+		}
+		if (!block) {
 			break;
 		}
 		mLOG(GBA_VIDEO, DEBUG, "Can't read %"PRIz"u bytes. CPU thread asleep?", length);
@@ -135,6 +170,7 @@ static bool _readData(struct mVideoLogger* logger, void* data, size_t length, bo
 
 static void _postEvent(struct mVideoLogger* logger, enum mVideoLoggerEvent event) {
 	struct mVideoThreadProxy* proxyRenderer = (struct mVideoThreadProxy*) logger;
+	RingFIFOCommit(&proxyRenderer->dirtyQueue);
 	MutexLock(&proxyRenderer->mutex);
 	proxyRenderer->event = event;
 	while (proxyRenderer->event) {
@@ -156,6 +192,7 @@ static void _wait(struct mVideoLogger* logger) {
 		_proxyThreadRecover(proxyRenderer);
 		return;
 	}
+	RingFIFOCommit(&proxyRenderer->dirtyQueue);
 	MutexLock(&proxyRenderer->mutex);
 	while (RingFIFOSize(&proxyRenderer->dirtyQueue)) {
 		ConditionWake(&proxyRenderer->toThreadCond);
@@ -171,6 +208,7 @@ static void _unlock(struct mVideoLogger* logger) {
 
 static void _wake(struct mVideoLogger* logger, int y) {
 	struct mVideoThreadProxy* proxyRenderer = (struct mVideoThreadProxy*) logger;
+	RingFIFOCommit(&proxyRenderer->dirtyQueue);
 	if ((y & 15) == 15) {
 		ConditionWake(&proxyRenderer->toThreadCond);
 	}
@@ -179,6 +217,7 @@ static void _wake(struct mVideoLogger* logger, int y) {
 static THREAD_ENTRY _proxyThread(void* logger) {
 	struct mVideoThreadProxy* proxyRenderer = logger;
 	ThreadSetName("Proxy Rendering");
+	ThreadPlaceHelper();
 
 	MutexLock(&proxyRenderer->mutex);
 	ConditionWake(&proxyRenderer->fromThreadCond);
@@ -7,6 +7,7 @@
 
 #include <mgba/core/core.h>
 #include <mgba-util/memory.h>
+#include <mgba-util/vector.h>
 #include <mgba-util/vfs.h>
 #include <mgba-util/math.h>
 
@@ -23,9 +24,13 @@
 
 #define BUFFER_BASE_SIZE 0x20000
 #define MAX_BLOCK_SIZE 0x800000
+#define MAX_INDEX_ENTRIES (MAX_BLOCK_SIZE / sizeof(struct mVLIndexEntry))
 
 const char mVL_MAGIC[] = "mVL\0";
+const char mVL_INDEX_MAGIC[] = "mVLi";
 
+// Minimal cores only use the logger to proxy rendering to another thread, not to record or play back logs
+#ifndef MINIMAL_CORE
 static const struct mVLDescriptor {
 	enum mPlatform platform;
 	struct mCore* (*open)(void);
@@ -38,12 +43,14 @@ static const struct mVLDescriptor {
 #endif
 	{ PLATFORM_NONE, 0 }
 };
+#endif
 
 enum mVLBlockType {
 	mVL_BLOCK_DUMMY = 0,
 	mVL_BLOCK_INITIAL_STATE,
 	mVL_BLOCK_CHANNEL_HEADER,
 	mVL_BLOCK_DATA,
+	mVL_BLOCK_KEYFRAME,
 	mVL_BLOCK_FOOTER = 0x784C566D
 };
 
@@ -69,6 +76,33 @@ struct mVideoLogHeader {
 	uint32_t nChannels;
 };
 
+// The footer block carries an index of keyframe blocks, found through a trailer at the very end of the file.
+// Readers that don't know about it stop at the footer and never see either.
+struct mVLIndexHeader {
+	uint32_t frames;
+	uint32_t nKeyframes;
+};
+
+struct mVLIndexEntry {
+	uint32_t frame;
+	uint32_t reserved;
+	uint64_t offset;
+};
+
+struct mVLIndexTrailer {
+	char magic[4];
+	uint32_t reserved;
+	uint64_t footerOffset;
+};
+
+struct mVLKeyframe {
+	uint32_t frame;
+	off_t offset;
+};
+
+DECLARE_VECTOR(mVLKeyframeList, struct mVLKeyframe);
+DEFINE_VECTOR(mVLKeyframeList, struct mVLKeyframe);
+
 struct mVideoLogContext;
 struct mVideoLogChannel {
 	struct mVideoLogContext* p;
@@ -102,6 +136,13 @@ struct mVideoLogContext {
 	bool compression;
 	uint32_t activeChannel;
 	struct VFile* backing;
+
+	// Frames finished so far when writing, or the whole log's length when an index was read
+	uint32_t frames;
+	bool frameEnded;
+	uint32_t keyframeInterval;
+	struct mVLKeyframeList keyframes;
+	struct mCore* core;
 };
 
 
@@ -112,6 +153,8 @@ static bool _readData(struct mVideoLogger* logger, void* data, size_t length, bo
 static ssize_t mVideoLoggerReadChannel(struct mVideoLogChannel* channel, void* data, size_t length);
 static ssize_t mVideoLoggerWriteChannel(struct mVideoLogChannel* channel, const void* data, size_t length);
 
+static void _frameEnded(struct mVideoLogContext* context);
+
 static inline size_t _roundUp(size_t value, int shift) {
 	value += (1 << shift) - 1;
 	return value >> shift;
@@ -135,6 +178,8 @@ void mVideoLoggerRendererCreate(struct mVideoLogger* logger, bool readonly) {
 	logger->unlock = NULL;
 	logger->wait = NULL;
 	logger->wake = NULL;
+
+	logger->stats = NULL;
 }
 
 void mVideoLoggerRendererInit(struct mVideoLogger* logger) {
@@ -267,6 +312,14 @@ void mVideoLoggerRendererFlush(struct mVideoLogger* logger) {
 	if (logger->wait) {
 		logger->wait(logger);
 	}
+	if (logger->writeData == _writeData) {
+		struct mVideoLogChannel* channel = logger->dataContext;
+		// Frames are ended by the flush that follows them, which is where playback stops too
+		if (channel->p->frameEnded) {
+			channel->p->frameEnded = false;
+			_frameEnded(channel->p);
+		}
+	}
 }
 
 void mVideoLoggerRendererFinishFrame(struct mVideoLogger* logger) {
@@ -277,6 +330,10 @@ void mVideoLoggerRendererFinishFrame(struct mVideoLogger* logger) {
 		0xDEADBEEF,
 	};
 	logger->writeData(logger, &dirty, sizeof(dirty));
+	if (logger->writeData == _writeData) {
+		struct mVideoLogChannel* channel = logger->dataContext;
+		channel->p->frameEnded = true;
+	}
 }
 
 void mVideoLoggerWriteBuffer(struct mVideoLogger* logger, uint32_t bufferId, uint32_t offset, uint32_t length, const void* data) {
@@ -290,6 +347,29 @@ void mVideoLoggerWriteBuffer(struct mVideoLogger* logger, uint32_t bufferId, uin
 	logger->writeData(logger, data, length);
 }
 
+static bool _parseTimedPacket(struct mVideoLogger* logger, const struct mVideoLoggerDirtyInfo* item) {
+	struct mVideoLoggerStats* stats = logger->stats;
+	uint64_t start = stats->clock();
+	bool result = logger->parsePacket(logger, item);
+	stats->pendingTime += stats->clock() - start;
+	if (item->type != DIRTY_SCANLINE) {
+		// Ranges are drawn ahead of the scanline they belong to, so count them with it
+		return result;
+	}
+	uint64_t time = stats->pendingTime;
+	stats->pendingTime = 0;
+	++stats->lines;
+	stats->lineTime += time;
+	if (time > stats->maxLineTime) {
+		stats->maxLineTime = time;
+	}
+	if (item->address < mVL_STATS_MAX_LINES) {
+		stats->lineTimeByY[item->address] += time;
+		++stats->linesByY[item->address];
+	}
+	return result;
+}
+
 bool mVideoLoggerRendererRun(struct mVideoLogger* logger, bool block) {
 	struct mVideoLogChannel* channel = logger->dataContext;
 	uint32_t ignorePackets = 0;
@@ -317,7 +397,11 @@ bool mVideoLoggerRendererRun(struct mVideoLogger* logger, bool block) {
 		case DIRTY_FRAME:
 		case DIRTY_RANGE:
 		case DIRTY_BUFFER:
-			if (!logger->parsePacket(logger, &item)) {
+			if (logger->stats && (item.type == DIRTY_SCANLINE || item.type == DIRTY_RANGE)) {
+				if (!_parseTimedPacket(logger, &item)) {
+					return true;
+				}
+			} else if (!logger->parsePacket(logger, &item)) {
 				return true;
 			}
 			break;
@@ -336,6 +420,16 @@ bool mVideoLoggerRendererRunInjected(struct mVideoLogger* logger) {
 	return res;	
 }
 
+void mVideoLoggerEnableStats(struct mVideoLogger* logger, struct mVideoLoggerStats* stats, mVideoLoggerStatsClock clock) {
+	memset(stats, 0, sizeof(*stats));
+	stats->clock = clock;
+	logger->stats = stats;
+}
+
+void mVideoLoggerDisableStats(struct mVideoLogger* logger) {
+	logger->stats = NULL;
+}
+
 void mVideoLoggerInjectionPoint(struct mVideoLogger* logger, enum mVideoLoggerInjectionPoint injectionPoint) {
 	struct mVideoLogChannel* channel = logger->dataContext;
 	channel->injectionPoint = injectionPoint;	
@@ -373,7 +467,7 @@ static void _copyVf(struct VFile* dest, struct VFile* src) {
 	src->unmap(src, mem, size);
 }
 
-static void _compress(struct VFile* dest, struct VFile* src) {
+static void _compress(struct VFile* dest, struct VFile* src, int level) {
 	uint8_t writeBuffer[0x800];
 	uint8_t compressBuffer[0x400];
 	z_stream zstr;
@@ -383,7 +477,7 @@ static void _compress(struct VFile* dest, struct VFile* src) {
 	zstr.avail_in = 0;
 	zstr.avail_out = sizeof(compressBuffer);
 	zstr.next_out = (Bytef*) compressBuffer;
-	if (deflateInit(&zstr, 9) != Z_OK) {
+	if (deflateInit(&zstr, level) != Z_OK) {
 		return;
 	}
 
@@ -503,6 +597,11 @@ struct mVideoLogContext* mVideoLogContextCreate(struct mCore* core) {
 	context->write = !!core;
 	context->initialStateSize = 0;
 	context->initialState = NULL;
+	context->core = core;
+	context->frames = 0;
+	context->frameEnded = false;
+	context->keyframeInterval = mVL_DEFAULT_KEYFRAME_INTERVAL;
+	mVLKeyframeListInit(&context->keyframes, 0);
 
 #ifdef USE_ZLIB
 	context->compression = true;
@@ -514,7 +613,9 @@ struct mVideoLogContext* mVideoLogContextCreate(struct mCore* core) {
 		context->initialStateSize = core->stateSize(core);
 		context->initialState = anonymousMemoryMap(context->initialStateSize);
 		core->saveState(core, context->initialState);
+#ifndef MINIMAL_CORE
 		core->startVideoLog(core, context);
+#endif
 	}
 
 	context->activeChannel = 0;
@@ -531,6 +632,36 @@ void mVideoLogContextSetCompression(struct mVideoLogContext* context, bool compr
 	context->compression = compression;
 }
 
+void mVideoLogContextSetKeyframeInterval(struct mVideoLogContext* context, uint32_t frames) {
+	context->keyframeInterval = frames;
+}
+
+static void _writeStateBlock(struct mVideoLogContext* context, enum mVLBlockType type, const void* state, size_t size, int level) {
+	struct mVLBlockHeader chheader = { 0 };
+	STORE_32LE(type, 0, &chheader.blockType);
+#ifdef USE_ZLIB
+	if (context->compression) {
+		STORE_32LE(mVL_FLAG_BLOCK_COMPRESSED, 0, &chheader.flags);
+
+		struct VFile* vfm = VFileMemChunk(NULL, 0);
+		struct VFile* src = VFileFromConstMemory(state, size);
+		_compress(vfm, src, level);
+		src->close(src);
+		STORE_32LE(vfm->size(vfm), 0, &chheader.length);
+		context->backing->write(context->backing, &chheader, sizeof(chheader));
+		_copyVf(context->backing, vfm);
+		vfm->close(vfm);
+	} else
+#else
+	UNUSED(level);
+#endif
+	{
+		STORE_32LE(size, 0, &chheader.length);
+		context->backing->write(context->backing, &chheader, sizeof(chheader));
+		context->backing->write(context->backing, state, size);
+	}
+}
+
 void mVideoLogContextWriteHeader(struct mVideoLogContext* context, struct mCore* core) {
 	struct mVideoLogHeader header = { { 0 } };
 	memcpy(header.magic, mVL_MAGIC, sizeof(header.magic));
@@ -545,27 +676,7 @@ void mVideoLogContextWriteHeader(struct mVideoLogContext* context, struct mCore*
 	STORE_32LE(flags, 0, &header.flags);
 	context->backing->write(context->backing, &header, sizeof(header));
 	if (context->initialState) {
-		struct mVLBlockHeader chheader = { 0 };
-		STORE_32LE(mVL_BLOCK_INITIAL_STATE, 0, &chheader.blockType);
-#ifdef USE_ZLIB
-		if (context->compression) {
-			STORE_32LE(mVL_FLAG_BLOCK_COMPRESSED, 0, &chheader.flags);
-
-			struct VFile* vfm = VFileMemChunk(NULL, 0);
-			struct VFile* src = VFileFromConstMemory(context->initialState, context->initialStateSize);
-			_compress(vfm, src);
-			src->close(src);
-			STORE_32LE(vfm->size(vfm), 0, &chheader.length);
-			context->backing->write(context->backing, &chheader, sizeof(chheader));
-			_copyVf(context->backing, vfm);
-			vfm->close(vfm);
-		} else
-#endif
-		{
-			STORE_32LE(context->initialStateSize, 0, &chheader.length);
-			context->backing->write(context->backing, &chheader, sizeof(chheader));
-			context->backing->write(context->backing, context->initialState, context->initialStateSize);
-		}
+		_writeStateBlock(context, mVL_BLOCK_INITIAL_STATE, context->initialState, context->initialStateSize, 9);
 	}
 
  	size_t i;
@@ -595,6 +706,31 @@ bool _readBlockHeader(struct mVideoLogContext* context, struct mVLBlockHeader* h
 	return true;
 }
 
+static bool _readStateBlock(struct mVideoLogContext* context, const struct mVLBlockHeader* header, void** state, size_t* size) {
+	if (header->flags & mVL_FLAG_BLOCK_COMPRESSED) {
+#ifdef USE_ZLIB
+		struct VFile* vfm = VFileMemChunk(NULL, 0);
+		if (!_decompress(vfm, context->backing, header->length)) {
+			vfm->close(vfm);
+			return false;
+		}
+		*size = vfm->size(vfm);
+		*state = anonymousMemoryMap(*size);
+		void* mem = vfm->map(vfm, *size, MAP_READ);
+		memcpy(*state, mem, *size);
+		vfm->unmap(vfm, mem, *size);
+		vfm->close(vfm);
+#else
+		return false;
+#endif
+	} else {
+		*size = header->length;
+		*state = anonymousMemoryMap(header->length);
+		context->backing->read(context->backing, *state, *size);
+	}
+	return true;
+}
+
 bool _readHeader(struct mVideoLogContext* context) {
 	struct mVideoLogHeader header;
 	context->backing->seek(context->backing, 0, SEEK_SET);
@@ -625,31 +761,70 @@ bool _readHeader(struct mVideoLogContext* context) {
 			context->initialState = NULL;
 			context->initialStateSize = 0;
 		}
-		if (header.flags & mVL_FLAG_BLOCK_COMPRESSED) {
-#ifdef USE_ZLIB
-			struct VFile* vfm = VFileMemChunk(NULL, 0);
-			if (!_decompress(vfm, context->backing, header.length)) {
-				vfm->close(vfm);
-				return false;
-			}
-			context->initialStateSize = vfm->size(vfm);
-			context->initialState = anonymousMemoryMap(context->initialStateSize);
-			void* mem = vfm->map(vfm, context->initialStateSize, MAP_READ);
-			memcpy(context->initialState, mem, context->initialStateSize);
-			vfm->unmap(vfm, mem, context->initialStateSize);
-			vfm->close(vfm);
-#else
+		if (!_readStateBlock(context, &header, &context->initialState, &context->initialStateSize)) {
 			return false;
-#endif
-		} else {
-			context->initialStateSize = header.length;
-			context->initialState = anonymousMemoryMap(header.length);
-			context->backing->read(context->backing, context->initialState, context->initialStateSize);
 		}
 	}
 	return true;
 }
 
+static void _readIndex(struct mVideoLogContext* context) {
+	struct VFile* vf = context->backing;
+	mVLKeyframeListClear(&context->keyframes);
+	context->frames = 0;
+
+	ssize_t size = vf->size(vf);
+	struct mVLIndexTrailer trailer;
+	if (size < (ssize_t) sizeof(trailer)) {
+		return;
+	}
+	vf->seek(vf, size - sizeof(trailer), SEEK_SET);
+	if (vf->read(vf, &trailer, sizeof(trailer)) != sizeof(trailer) || memcmp(trailer.magic, mVL_INDEX_MAGIC, sizeof(trailer.magic)) != 0) {
+		return;
+	}
+	uint64_t footerOffset;
+	LOAD_64LE(footerOffset, 0, &trailer.footerOffset);
+	if (footerOffset >= (uint64_t) size) {
+		return;
+	}
+	vf->seek(vf, footerOffset, SEEK_SET);
+	struct mVLBlockHeader header;
+	if (!_readBlockHeader(context, &header) || header.blockType != mVL_BLOCK_FOOTER || header.length < sizeof(struct mVLIndexHeader)) {
+		return;
+	}
+	struct mVLIndexHeader index;
+	if (vf->read(vf, &index, sizeof(index)) != sizeof(index)) {
+		return;
+	}
+	uint32_t frames;
+	uint32_t nKeyframes;
+	LOAD_32LE(frames, 0, &index.frames);
+	LOAD_32LE(nKeyframes, 0, &index.nKeyframes);
+	if (nKeyframes > MAX_INDEX_ENTRIES || header.length != sizeof(index) + nKeyframes * sizeof(struct mVLIndexEntry)) {
+		return;
+	}
+
+	uint32_t i;
+	for (i = 0; i < nKeyframes; ++i) {
+		struct mVLIndexEntry entry;
+		if (vf->read(vf, &entry, sizeof(entry)) != sizeof(entry)) {
+			break;
+		}
+		struct mVLKeyframe keyframe;
+		uint64_t offset;
+		LOAD_32LE(keyframe.frame, 0, &entry.frame);
+		LOAD_64LE(offset, 0, &entry.offset);
+		// An index that doesn't make sense is no better than none at all
+		if (offset >= footerOffset || keyframe.frame > frames || (i && keyframe.frame <= mVLKeyframeListGetPointer(&context->keyframes, i - 1)->frame)) {
+			mVLKeyframeListClear(&context->keyframes);
+			return;
+		}
+		keyframe.offset = offset;
+		*mVLKeyframeListAppend(&context->keyframes) = keyframe;
+	}
+	context->frames = frames;
+}
+
 bool mVideoLogContextLoad(struct mVideoLogContext* context, struct VFile* vf) {
 	context->backing = vf;
 
@@ -658,6 +833,7 @@ bool mVideoLogContextLoad(struct mVideoLogContext* context, struct VFile* vf) {
 	}
 
 	off_t pointer = context->backing->seek(context->backing, 0, SEEK_CUR);
+	_readIndex(context);
 
 	size_t i;
 	for (i = 0; i < context->nChannels; ++i) {
@@ -681,7 +857,7 @@ static void _flushBufferCompressed(struct mVideoLogContext* context) {
 	}
 	struct VFile* vfm = VFileMemChunk(NULL, 0);
 	struct VFile* src = VFileFIFO(buffer);
-	_compress(vfm, src);
+	_compress(vfm, src, 9);
 	src->close(src);
 
 	size_t size = vfm->size(vfm);
@@ -724,21 +900,85 @@ static void _flushBuffer(struct mVideoLogContext* context) {
 	}
 }
 
+static void _writeKeyframe(struct mVideoLogContext* context) {
+	// Everything before the keyframe has to be out of the buffers, so playback can start right after it
+	uint32_t activeChannel = context->activeChannel;
+	size_t i;
+	for (i = 0; i < context->nChannels; ++i) {
+		context->activeChannel = i;
+		_flushBuffer(context);
+	}
+	context->activeChannel = activeChannel;
+
+	struct mCore* core = context->core;
+	size_t size = core->stateSize(core);
+	void* state = anonymousMemoryMap(size);
+	if (!core->saveState(core, state)) {
+		mappedMemoryFree(state, size);
+		return;
+	}
+	struct mVLKeyframe* keyframe = mVLKeyframeListAppend(&context->keyframes);
+	keyframe->frame = context->frames;
+	keyframe->offset = context->backing->seek(context->backing, 0, SEEK_CUR);
+	// This happens in the middle of recording, so don't hold up emulation for a slightly smaller file
+	_writeStateBlock(context, mVL_BLOCK_KEYFRAME, state, size, 1);
+	mappedMemoryFree(state, size);
+}
+
+static void _frameEnded(struct mVideoLogContext* context) {
+	++context->frames;
+	if (context->core && context->keyframeInterval && !(context->frames % context->keyframeInterval)) {
+		_writeKeyframe(context);
+	}
+}
+
+static void _writeFooter(struct mVideoLogContext* context) {
+	struct VFile* vf = context->backing;
+	off_t footerOffset = vf->seek(vf, 0, SEEK_CUR);
+	size_t nKeyframes = mVLKeyframeListSize(&context->keyframes);
+
+	struct mVLBlockHeader header = { 0 };
+	STORE_32LE(mVL_BLOCK_FOOTER, 0, &header.blockType);
+	STORE_32LE(sizeof(struct mVLIndexHeader) + nKeyframes * sizeof(struct mVLIndexEntry), 0, &header.length);
+	vf->write(vf, &header, sizeof(header));
+
+	struct mVLIndexHeader index;
+	STORE_32LE(context->frames, 0, &index.frames);
+	STORE_32LE(nKeyframes, 0, &index.nKeyframes);
+	vf->write(vf, &index, sizeof(index));
+
+	size_t i;
+	for (i = 0; i < nKeyframes; ++i) {
+		const struct mVLKeyframe* keyframe = mVLKeyframeListGetConstPointer(&context->keyframes, i);
+		struct mVLIndexEntry entry = { 0 };
+		STORE_32LE(keyframe->frame, 0, &entry.frame);
+		STORE_64LE((uint64_t) keyframe->offset, 0, &entry.offset);
+		vf->write(vf, &entry, sizeof(entry));
+	}
+
+	struct mVLIndexTrailer trailer = { { 0 } };
+	memcpy(trailer.magic, mVL_INDEX_MAGIC, sizeof(trailer.magic));
+	STORE_64LE((uint64_t) footerOffset, 0, &trailer.footerOffset);
+	vf->write(vf, &trailer, sizeof(trailer));
+}
+
 void mVideoLogContextDestroy(struct mCore* core, struct mVideoLogContext* context) {
 	if (context->write) {
 		_flushBuffer(context);
-
-		struct mVLBlockHeader header = { 0 };
-		STORE_32LE(mVL_BLOCK_FOOTER, 0, &header.blockType);
-		context->backing->write(context->backing, &header, sizeof(header));
+		_writeFooter(context);
 	}
 
+#ifndef MINIMAL_CORE
 	if (core) {
 		core->endVideoLog(core);
 	}
+#else
+	UNUSED(core);
+#endif
 	if (context->initialState) {
 		mappedMemoryFree(context->initialState, context->initialStateSize);
 	}
+	mVLKeyframeListDeinit(&context->keyframes);
 
 	size_t i;
 	for (i = 0; i < context->nChannels; ++i) {
@@ -755,22 +995,19 @@ void mVideoLogContextDestroy(struct mCore* core, struct mVideoLogContext* contex
 	free(context);
 }
 
-void mVideoLogContextRewind(struct mVideoLogContext* context, struct mCore* core) {
-	_readHeader(context);
-	if (core) {
-		size_t size = core->stateSize(core);
-		if (size <= context->initialStateSize) {
-			core->loadState(core, context->initialState);
-		} else {
-			void* extendedState = anonymousMemoryMap(size);
-			memcpy(extendedState, context->initialState, context->initialStateSize);
-			core->loadState(core, extendedState);
-			mappedMemoryFree(extendedState, size);
-		}
+static void _loadState(struct mCore* core, const void* state, size_t stateSize) {
+	size_t size = core->stateSize(core);
+	if (size <= stateSize) {
+		core->loadState(core, state);
+	} else {
+		void* extendedState = anonymousMemoryMap(size);
+		memcpy(extendedState, state, stateSize);
+		core->loadState(core, extendedState);
+		mappedMemoryFree(extendedState, size);
 	}
+}
 
-	off_t pointer = context->backing->seek(context->backing, 0, SEEK_CUR);
-
+static void _resetChannels(struct mVideoLogContext* context, off_t pointer) {
 	size_t i;
 	for (i = 0; i < context->nChannels; ++i) {
 		CircleBufferClear(&context->channels[i].injectedBuffer);
@@ -786,6 +1023,52 @@ void mVideoLogContextRewind(struct mVideoLogContext* context, struct mCore* core
 	}
 }
 
+void mVideoLogContextRewind(struct mVideoLogContext* context, struct mCore* core) {
+	_readHeader(context);
+	if (core) {
+		_loadState(core, context->initialState, context->initialStateSize);
+	}
+
+	_resetChannels(context, context->backing->seek(context->backing, 0, SEEK_CUR));
+}
+
+uint32_t mVideoLogContextFrameCount(const struct mVideoLogContext* context) {
+	return context->frames;
+}
+
+uint32_t mVideoLogContextSeek(struct mVideoLogContext* context, struct mCore* core, uint32_t frame) {
+	// Playback spends its first frame on the initial state, so the keyframe taken after N logged frames starts playback frame N + 1
+	size_t low = 0;
+	size_t high = mVLKeyframeListSize(&context->keyframes);
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (mVLKeyframeListGetPointer(&context->keyframes, mid)->frame < frame) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	while (low) {
+		const struct mVLKeyframe* keyframe = mVLKeyframeListGetPointer(&context->keyframes, low - 1);
+		struct mVLBlockHeader header;
+		void* state;
+		size_t stateSize;
+		context->backing->seek(context->backing, keyframe->offset, SEEK_SET);
+		if (!_readBlockHeader(context, &header) || header.blockType != mVL_BLOCK_KEYFRAME || !_readStateBlock(context, &header, &state, &stateSize)) {
+			// Fall back on an earlier keyframe, or the start of the log
+			--low;
+			continue;
+		}
+		off_t pointer = context->backing->seek(context->backing, 0, SEEK_CUR);
+		_loadState(core, state, stateSize);
+		mappedMemoryFree(state, stateSize);
+		_resetChannels(context, pointer);
+		return keyframe->frame + 1;
+	}
+	mVideoLogContextRewind(context, core);
+	return 0;
+}
+
 void* mVideoLogContextInitialState(struct mVideoLogContext* context, size_t* size) {
 	if (size) {
 		*size = context->initialStateSize;
@@ -1046,6 +1329,8 @@ struct mCore* mVideoLogCoreFind(struct VFile* vf) {
 	if (memcmp(header.magic, mVL_MAGIC, sizeof(header.magic)) != 0) {
 		return NULL;
 	}
+	struct mCore* core = NULL;
+#ifndef MINIMAL_CORE
 	enum mPlatform platform;
 	LOAD_32LE(platform, 0, &header.platform);
 
@@ -1055,9 +1340,9 @@ struct mCore* mVideoLogCoreFind(struct VFile* vf) {
 			break;
 		}
 	}
-	struct mCore* core = NULL;
 	if (descriptor->open) {
 		core = descriptor->open();
 	}
+#endif
 	return core;
 }
@@ -13,7 +13,9 @@
 #include <mgba/internal/gb/io.h>
 
 #ifdef _3DS
-#define blip_add_delta blip_add_delta_fast
+#define GB_AUDIO_RESAMPLE_DEFAULT GB_AUDIO_RESAMPLE_LINEAR
+#else
+#define GB_AUDIO_RESAMPLE_DEFAULT GB_AUDIO_RESAMPLE_BANDLIMITED
 #endif
 
 #define FRAME_CYCLES (DMG_SM83_FREQUENCY >> 9)
@@ -40,15 +42,24 @@ static int32_t _updateSquareChannel(struct GBAudioSquareChannel* ch);
 static int16_t _coalesceNoiseChannel(struct GBAudioNoiseChannel* ch);
 
 static void _updateFrame(struct mTiming* timing, void* user, uint32_t cyclesLate);
-static void _updateChannel1(struct mTiming* timing, void* user, uint32_t cyclesLate);
-static void _updateChannel2(struct mTiming* timing, void* user, uint32_t cyclesLate);
-static void _updateChannel3(struct mTiming* timing, void* user, uint32_t cyclesLate);
-static void _fadeChannel3(struct mTiming* timing, void* user, uint32_t cyclesLate);
-static void _updateChannel4(struct mTiming* timing, void* user, uint32_t cyclesLate);
+static void _runSquareChannel(struct GBAudio* audio, struct GBAudioSquareChannel* ch, struct GBAudioChannelTimer* timer, uint32_t timestamp);
+static void _runWaveChannel(struct GBAudio* audio, uint32_t timestamp);
+static void _runNoiseChannel(struct GBAudio* audio, uint32_t timestamp);
 static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate);
 
+static inline bool _isDue(const struct GBAudioChannelTimer* timer, uint32_t timestamp) {
+	return timer->scheduled && (int32_t) (timestamp - timer->when) >= 0;
+}
+
+static inline void _scheduleTimer(struct GBAudio* audio, struct GBAudioChannelTimer* timer, int32_t when) {
+	timer->when = mTimingCurrentTime(audio->timing) + when;
+	timer->scheduled = true;
+}
+
 void GBAudioInit(struct GBAudio* audio, size_t samples, uint8_t* nr52, enum GBAudioStyle style) {
 	audio->samples = samples;
+	audio->muted = false;
+	GBAudioSetResampler(audio, GB_AUDIO_RESAMPLE_DEFAULT);
 	audio->left = blip_new(BLIP_BUFFER_SIZE);
 	audio->right = blip_new(BLIP_BUFFER_SIZE);
 	audio->clockRate = DMG_SM83_FREQUENCY;
@@ -62,6 +73,8 @@ void GBAudioInit(struct GBAudio* audio, size_t samples, uint8_t* nr52, enum GBAu
 	audio->masterVolume = GB_AUDIO_VOLUME_MAX;
 	audio->nr52 = nr52;
 	audio->style = style;
+	audio->sync = NULL;
+	audio->syncContext = NULL;
 	if (style == GB_AUDIO_GBA) {
 		audio->timingFactor = 4;
 	} else {
@@ -72,26 +85,6 @@ void GBAudioInit(struct GBAudio* audio, size_t samples, uint8_t* nr52, enum GBAu
 	audio->frameEvent.name = "GB Audio Frame Sequencer";
 	audio->frameEvent.callback = _updateFrame;
 	audio->frameEvent.priority = 0x10;
-	audio->ch1Event.context = audio;
-	audio->ch1Event.name = "GB Audio Channel 1";
-	audio->ch1Event.callback = _updateChannel1;
-	audio->ch1Event.priority = 0x11;
-	audio->ch2Event.context = audio;
-	audio->ch2Event.name = "GB Audio Channel 2";
-	audio->ch2Event.callback = _updateChannel2;
-	audio->ch2Event.priority = 0x12;
-	audio->ch3Event.context = audio;
-	audio->ch3Event.name = "GB Audio Channel 3";
-	audio->ch3Event.callback = _updateChannel3;
-	audio->ch3Event.priority = 0x13;
-	audio->ch3Fade.context = audio;
-	audio->ch3Fade.name = "GB Audio Channel 3 Memory";
-	audio->ch3Fade.callback = _fadeChannel3;
-	audio->ch3Fade.priority = 0x14;
-	audio->ch4Event.context = audio;
-	audio->ch4Event.name = "GB Audio Channel 4";
-	audio->ch4Event.callback = _updateChannel4;
-	audio->ch4Event.priority = 0x15;
 	audio->sampleEvent.context = audio;
 	audio->sampleEvent.name = "GB Audio Sample";
 	audio->sampleEvent.callback = _sample;
@@ -105,12 +98,12 @@ void GBAudioDeinit(struct GBAudio* audio) {
 
 void GBAudioReset(struct GBAudio* audio) {
 	mTimingDeschedule(audio->timing, &audio->frameEvent);
-	mTimingDeschedule(audio->timing, &audio->ch1Event);
-	mTimingDeschedule(audio->timing, &audio->ch2Event);
-	mTimingDeschedule(audio->timing, &audio->ch3Event);
-	mTimingDeschedule(audio->timing, &audio->ch3Fade);
-	mTimingDeschedule(audio->timing, &audio->ch4Event);
 	mTimingDeschedule(audio->timing, &audio->sampleEvent);
+	audio->ch1Timer.scheduled = false;
+	audio->ch2Timer.scheduled = false;
+	audio->ch3Timer.scheduled = false;
+	audio->ch3Fade.scheduled = false;
+	audio->ch4Timer.scheduled = false;
 	if (audio->style != GB_AUDIO_GBA) {
 		mTimingSchedule(audio->timing, &audio->sampleEvent, 0);
 	}
@@ -166,9 +159,34 @@ void GBAudioResizeBuffer(struct GBAudio* audio, size_t samples) {
 	mCoreSyncConsumeAudio(audio->p->sync);
 }
 
+void GBAudioSetResampler(struct GBAudio* audio, enum GBAudioResampler resampler) {
+	switch (resampler) {
+	case GB_AUDIO_RESAMPLE_NEAREST:
+		audio->addDelta = blip_add_delta_nearest;
+		break;
+	case GB_AUDIO_RESAMPLE_LINEAR:
+		audio->addDelta = blip_add_delta_fast;
+		break;
+	case GB_AUDIO_RESAMPLE_BANDLIMITED:
+		audio->addDelta = blip_add_delta;
+		break;
+	}
+}
+
+enum GBAudioResampler GBAudioNameToResampler(const char* name) {
+	if (strcasecmp(name, "nearest") == 0) {
+		return GB_AUDIO_RESAMPLE_NEAREST;
+	} else if (strcasecmp(name, "linear") == 0) {
+		return GB_AUDIO_RESAMPLE_LINEAR;
+	} else if (strcasecmp(name, "bandlimited") == 0) {
+		return GB_AUDIO_RESAMPLE_BANDLIMITED;
+	}
+	return GB_AUDIO_RESAMPLE_DEFAULT;
+}
+
 void GBAudioWriteNR10(struct GBAudio* audio, uint8_t value) {
 	if (!_writeSweep(&audio->ch1.sweep, value)) {
-		mTimingDeschedule(audio->timing, &audio->ch1Event);
+		audio->ch1Timer.scheduled = false;
 		audio->playingCh1 = false;
 		*audio->nr52 &= ~0x0001;
 	}
@@ -181,7 +199,7 @@ void GBAudioWriteNR11(struct GBAudio* audio, uint8_t value) {
 
 void GBAudioWriteNR12(struct GBAudio* audio, uint8_t value) {
 	if (!_writeEnvelope(&audio->ch1.envelope, value, audio->style)) {
-		mTimingDeschedule(audio->timing, &audio->ch1Event);
+		audio->ch1Timer.scheduled = false;
 		audio->playingCh1 = false;
 		*audio->nr52 &= ~0x0001;
 	}
@@ -200,7 +218,7 @@ void GBAudioWriteNR14(struct GBAudio* audio, uint8_t value) {
 	if (!wasStop && audio->ch1.control.stop && audio->ch1.control.length && !(audio->frame & 1)) {
 		--audio->ch1.control.length;
 		if (audio->ch1.control.length == 0) {
-			mTimingDeschedule(audio->timing, &audio->ch1Event);
+			audio->ch1Timer.scheduled = false;
 			audio->playingCh1 = false;
 		}
 	}
@@ -219,8 +237,7 @@ void GBAudioWriteNR14(struct GBAudio* audio, uint8_t value) {
 		}
 		if (audio->playingCh1 && audio->ch1.envelope.dead != 2) {
 			_updateSquareChannel(&audio->ch1);
-			mTimingDeschedule(audio->timing, &audio->ch1Event);
-			mTimingSchedule(audio->timing, &audio->ch1Event, 0);
+			_scheduleTimer(audio, &audio->ch1Timer, 0);
 		}
 	}
 	*audio->nr52 &= ~0x0001;
@@ -234,7 +251,7 @@ void GBAudioWriteNR21(struct GBAudio* audio, uint8_t value) {
 
 void GBAudioWriteNR22(struct GBAudio* audio, uint8_t value) {
 	if (!_writeEnvelope(&audio->ch2.envelope, value, audio->style)) {
-		mTimingDeschedule(audio->timing, &audio->ch2Event);
+		audio->ch2Timer.scheduled = false;
 		audio->playingCh2 = false;
 		*audio->nr52 &= ~0x0002;
 	}
@@ -253,7 +270,7 @@ void GBAudioWriteNR24(struct GBAudio* audio, uint8_t value) {
 	if (!wasStop && audio->ch2.control.stop && audio->ch2.control.length && !(audio->frame & 1)) {
 		--audio->ch2.control.length;
 		if (audio->ch2.control.length == 0) {
-			mTimingDeschedule(audio->timing, &audio->ch2Event);
+			audio->ch2Timer.scheduled = false;
 			audio->playingCh2 = false;
 		}
 	}
@@ -268,8 +285,7 @@ void GBAudioWriteNR24(struct GBAudio* audio, uint8_t value) {
 		}
 		if (audio->playingCh2 && audio->ch2.envelope.dead != 2) {
 			_updateSquareChannel(&audio->ch2);
-			mTimingDeschedule(audio->timing, &audio->ch2Event);
-			mTimingSchedule(audio->timing, &audio->ch2Event, 0);
+			_scheduleTimer(audio, &audio->ch2Timer, 0);
 		}
 	}
 	*audio->nr52 &= ~0x0002;
@@ -279,7 +295,7 @@ void GBAudioWriteNR24(struct GBAudio* audio, uint8_t value) {
 void GBAudioWriteNR30(struct GBAudio* audio, uint8_t value) {
 	audio->ch3.enable = GBAudioRegisterBankGetEnable(value);
 	if (!audio->ch3.enable) {
-		mTimingDeschedule(audio->timing, &audio->ch3Event);
+		audio->ch3Timer.scheduled = false;
 		audio->playingCh3 = false;
 		*audio->nr52 &= ~0x0004;
 	}
@@ -334,12 +350,12 @@ void GBAudioWriteNR34(struct GBAudio* audio, uint8_t value) {
 			audio->ch3.sample = 0;
 		}
 	}
-	mTimingDeschedule(audio->timing, &audio->ch3Fade);
-	mTimingDeschedule(audio->timing, &audio->ch3Event);
+	audio->ch3Fade.scheduled = false;
+	audio->ch3Timer.scheduled = false;
 	if (audio->playingCh3) {
 		audio->ch3.readable = audio->style != GB_AUDIO_DMG;
 		// TODO: Where does this cycle delay come from?
-		mTimingSchedule(audio->timing, &audio->ch3Event, audio->timingFactor * 4 + 2 * (2048 - audio->ch3.rate));
+		_scheduleTimer(audio, &audio->ch3Timer, audio->timingFactor * 4 + 2 * (2048 - audio->ch3.rate));
 	}
 	*audio->nr52 &= ~0x0004;
 	*audio->nr52 |= audio->playingCh3 << 2;
@@ -352,7 +368,7 @@ void GBAudioWriteNR41(struct GBAudio* audio, uint8_t value) {
 
 void GBAudioWriteNR42(struct GBAudio* audio, uint8_t value) {
 	if (!_writeEnvelope(&audio->ch4.envelope, value, audio->style)) {
-		mTimingDeschedule(audio->timing, &audio->ch4Event);
+		audio->ch4Timer.scheduled = false;
 		audio->playingCh4 = false;
 		*audio->nr52 &= ~0x0008;
 	}
@@ -371,7 +387,7 @@ void GBAudioWriteNR44(struct GBAudio* audio, uint8_t value) {
 	if (!wasStop && audio->ch4.stop && audio->ch4.length && !(audio->frame & 1)) {
 		--audio->ch4.length;
 		if (audio->ch4.length == 0) {
-			mTimingDeschedule(audio->timing, &audio->ch4Event);
+			audio->ch4Timer.scheduled = false;
 			audio->playingCh4 = false;
 		}
 	}
@@ -390,8 +406,7 @@ void GBAudioWriteNR44(struct GBAudio* audio, uint8_t value) {
 			}
 		}
 		if (audio->playingCh4 && audio->ch4.envelope.dead != 2) {
-			mTimingDeschedule(audio->timing, &audio->ch4Event);
-			mTimingSchedule(audio->timing, &audio->ch4Event, 0);
+			_scheduleTimer(audio, &audio->ch4Timer, 0);
 		}
 	}
 	*audio->nr52 &= ~0x0008;
@@ -488,13 +503,19 @@ void GBAudioWriteNR52(struct GBAudio* audio, uint8_t value) {
 
 void _updateFrame(struct mTiming* timing, void* user, uint32_t cyclesLate) {
 	struct GBAudio* audio = user;
-	GBAudioUpdateFrame(audio, timing);
+	uint32_t when = mTimingCurrentTime(timing) - cyclesLate;
+	if (audio->sync) {
+		audio->sync(audio->syncContext, when);
+	}
+	// The frame sequencer steps before any channel edge due at the same time
+	GBAudioUpdateFrame(audio, when - 1);
 	if (audio->style == GB_AUDIO_GBA) {
 		mTimingSchedule(timing, &audio->frameEvent, audio->timingFactor * FRAME_CYCLES - cyclesLate);
 	}
 }
 
-void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
+void GBAudioUpdateFrame(struct GBAudio* audio, uint32_t timestamp) {
+	GBAudioRun(audio, timestamp);
 	if (!audio->enable) {
 		return;
 	}
@@ -515,7 +536,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 				*audio->nr52 &= ~0x0001;
 				*audio->nr52 |= audio->playingCh1;
 				if (!audio->playingCh1) {
-					mTimingDeschedule(audio->timing, &audio->ch1Event);
+					audio->ch1Timer.scheduled = false;
 				}
 			}
 		}
@@ -525,7 +546,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 		if (audio->ch1.control.length && audio->ch1.control.stop) {
 			--audio->ch1.control.length;
 			if (audio->ch1.control.length == 0) {
-				mTimingDeschedule(timing, &audio->ch1Event);
+				audio->ch1Timer.scheduled = false;
 				audio->playingCh1 = 0;
 				*audio->nr52 &= ~0x0001;
 			}
@@ -534,7 +555,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 		if (audio->ch2.control.length && audio->ch2.control.stop) {
 			--audio->ch2.control.length;
 			if (audio->ch2.control.length == 0) {
-				mTimingDeschedule(timing, &audio->ch2Event);
+				audio->ch2Timer.scheduled = false;
 				audio->playingCh2 = 0;
 				*audio->nr52 &= ~0x0002;
 			}
@@ -543,7 +564,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 		if (audio->ch3.length && audio->ch3.stop) {
 			--audio->ch3.length;
 			if (audio->ch3.length == 0) {
-				mTimingDeschedule(timing, &audio->ch3Event);
+				audio->ch3Timer.scheduled = false;
 				audio->playingCh3 = 0;
 				*audio->nr52 &= ~0x0004;
 			}
@@ -552,7 +573,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 		if (audio->ch4.length && audio->ch4.stop) {
 			--audio->ch4.length;
 			if (audio->ch4.length == 0) {
-				mTimingDeschedule(timing, &audio->ch4Event);
+				audio->ch4Timer.scheduled = false;
 				audio->playingCh4 = 0;
 				*audio->nr52 &= ~0x0008;
 			}
@@ -564,7 +585,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 			if (audio->ch1.envelope.nextStep == 0) {
 				_updateEnvelope(&audio->ch1.envelope);
 				if (audio->ch1.envelope.dead == 2) {
-					mTimingDeschedule(timing, &audio->ch1Event);
+					audio->ch1Timer.scheduled = false;
 				}
 				_updateSquareSample(&audio->ch1);
 			}
@@ -575,7 +596,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 			if (audio->ch2.envelope.nextStep == 0) {
 				_updateEnvelope(&audio->ch2.envelope);
 				if (audio->ch2.envelope.dead == 2) {
-					mTimingDeschedule(timing, &audio->ch2Event);
+					audio->ch2Timer.scheduled = false;
 				}
 				_updateSquareSample(&audio->ch2);
 			}
@@ -588,7 +609,7 @@ void GBAudioUpdateFrame(struct GBAudio* audio, struct mTiming* timing) {
 				audio->ch4.samples -= audio->ch4.sample;
 				_updateEnvelope(&audio->ch4.envelope);
 				if (audio->ch4.envelope.dead == 2) {
-					mTimingDeschedule(timing, &audio->ch4Event);
+					audio->ch4Timer.scheduled = false;
 				}
 				audio->ch4.sample = sample * audio->ch4.envelope.currentVolume;
 				audio->ch4.samples += audio->ch4.sample;
@@ -651,8 +672,37 @@ void GBAudioSamplePSG(struct GBAudio* audio, int16_t* left, int16_t* right) {
 	*right = sampleRight * (1 + audio->volumeRight);
 }
 
+void GBAudioRun(struct GBAudio* audio, uint32_t timestamp) {
+	if (_isDue(&audio->ch1Timer, timestamp)) {
+		_runSquareChannel(audio, &audio->ch1, &audio->ch1Timer, timestamp);
+	}
+	if (_isDue(&audio->ch2Timer, timestamp)) {
+		_runSquareChannel(audio, &audio->ch2, &audio->ch2Timer, timestamp);
+	}
+	if (_isDue(&audio->ch3Timer, timestamp)) {
+		_runWaveChannel(audio, timestamp);
+	}
+	if (_isDue(&audio->ch3Fade, timestamp)) {
+		audio->ch3Fade.scheduled = false;
+		audio->ch3.readable = false;
+	}
+	if (_isDue(&audio->ch4Timer, timestamp)) {
+		_runNoiseChannel(audio, timestamp);
+	}
+}
+
 static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate) {
 	struct GBAudio* audio = user;
+	if (audio->muted) {
+		// The channels catch up on their own, but the noise average would grow without bound
+		audio->ch4.nSamples = 0;
+		audio->ch4.samples = 0;
+		mTimingSchedule(timing, &audio->sampleEvent, audio->sampleInterval * audio->timingFactor - cyclesLate);
+		return;
+	}
+	enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_AUDIO);
+	// Channel edges come before any sample due at the same time
+	GBAudioRun(audio, mTimingCurrentTime(timing) - cyclesLate);
 	int16_t sampleLeft = 0;
 	int16_t sampleRight = 0;
 	GBAudioSamplePSG(audio, &sampleLeft, &sampleRight);
@@ -670,8 +720,8 @@ static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate) {
 	sampleRight = degradedRight;
 
 	if ((size_t) blip_samples_avail(audio->left) < audio->samples) {
-		blip_add_delta(audio->left, audio->clock, sampleLeft - audio->lastLeft);
-		blip_add_delta(audio->right, audio->clock, sampleRight - audio->lastRight);
+		audio->addDelta(audio->left, audio->clock, sampleLeft - audio->lastLeft);
+		audio->addDelta(audio->right, audio->clock, sampleRight - audio->lastRight);
 		audio->lastLeft = sampleLeft;
 		audio->lastRight = sampleRight;
 		audio->clock += audio->sampleInterval;
@@ -682,6 +732,7 @@ static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate) {
 		}
 	}
 	produced = blip_samples_avail(audio->left);
+	mTimingHostLeave(timing, category);
 	if (audio->p->stream && audio->p->stream->postAudioFrame) {
 		audio->p->stream->postAudioFrame(audio->p->stream, sampleLeft, sampleRight);
 	}
@@ -838,23 +889,24 @@ static bool _updateSweep(struct GBAudioSquareChannel* ch, bool initial) {
 	return true;
 }
 
-static void _updateChannel1(struct mTiming* timing, void* user, uint32_t cyclesLate) {
-	struct GBAudio* audio = user;
-	struct GBAudioSquareChannel* ch = &audio->ch1;
-	int cycles = _updateSquareChannel(ch);
-	mTimingSchedule(timing, &audio->ch1Event, audio->timingFactor * cycles - cyclesLate);
-}
-
-static void _updateChannel2(struct mTiming* timing, void* user, uint32_t cyclesLate) {
-	struct GBAudio* audio = user;
-	struct GBAudioSquareChannel* ch = &audio->ch2;
-	int cycles = _updateSquareChannel(ch);
-	mTimingSchedule(timing, &audio->ch2Event, audio->timingFactor * cycles - cyclesLate);
+static void _runSquareChannel(struct GBAudio* audio, struct GBAudioSquareChannel* ch, struct GBAudioChannelTimer* timer, uint32_t timestamp) {
+	// A whole duty cycle flips the output twice, leaving it where it started
+	int32_t period = 32 * (2048 - ch->control.frequency) * audio->timingFactor;
+	timer->when += ((int32_t) (timestamp - timer->when) / period) * period;
+	do {
+		timer->when += audio->timingFactor * _updateSquareChannel(ch);
+	} while ((int32_t) (timestamp - timer->when) >= 0);
 }
 
-static void _updateChannel3(struct mTiming* timing, void* user, uint32_t cyclesLate) {
-	struct GBAudio* audio = user;
+static void _runWaveChannel(struct GBAudio* audio, uint32_t timestamp) {
 	struct GBAudioWaveChannel* ch = &audio->ch3;
+	int32_t cycles = audio->timingFactor * 2 * (2048 - ch->rate);
+	uint32_t steps = (uint32_t) (timestamp - audio->ch3Timer.when) / cycles + 1;
+	audio->ch3Timer.when += steps * cycles;
+	// Only the last step is observable, and the wave repeats every 32 or 64 steps
+	unsigned period = audio->style == GB_AUDIO_GBA && ch->size ? 64 : 32;
+	steps = (steps - 1) % period + 1;
+
 	int i;
 	int volume;
 	switch (ch->volume) {
@@ -877,7 +929,7 @@ static void _updateChannel3(struct mTiming* timing, void* user, uint32_t cyclesL
 	switch (audio->style) {
 	case GB_AUDIO_DMG:
 	default:
-		++ch->window;
+		ch->window += steps;
 		ch->window &= 0x1F;
 		ch->sample = ch->wavedata8[ch->window >> 1];
 		if (!(ch->window & 1)) {
@@ -896,13 +948,16 @@ static void _updateChannel3(struct mTiming* timing, void* user, uint32_t cyclesL
 			start = 3;
 			end = 0;
 		}
-		uint32_t bitsCarry = ch->wavedata32[end] & 0x000000F0;
-		uint32_t bits;
-		for (i = start; i >= end; --i) {
-			bits = ch->wavedata32[i] & 0x000000F0;
-			ch->wavedata32[i] = ((ch->wavedata32[i] & 0x0F0F0F0F) << 4) | ((ch->wavedata32[i] & 0xF0F0F000) >> 12);
-			ch->wavedata32[i] |= bitsCarry << 20;
-			bitsCarry = bits;
+		uint32_t bitsCarry = 0;
+		for (; steps; --steps) {
+			bitsCarry = ch->wavedata32[end] & 0x000000F0;
+			uint32_t bits;
+			for (i = start; i >= end; --i) {
+				bits = ch->wavedata32[i] & 0x000000F0;
+				ch->wavedata32[i] = ((ch->wavedata32[i] & 0x0F0F0F0F) << 4) | ((ch->wavedata32[i] & 0xF0F0F000) >> 12);
+				ch->wavedata32[i] |= bitsCarry << 20;
+				bitsCarry = bits;
+			}
 		}
 		ch->sample = bitsCarry >> 4;
 		break;
@@ -913,53 +968,41 @@ static void _updateChannel3(struct mTiming* timing, void* user, uint32_t cyclesL
 	ch->sample >>= volume;
 	audio->ch3.readable = true;
 	if (audio->style == GB_AUDIO_DMG) {
-		mTimingDeschedule(audio->timing, &audio->ch3Fade);
-		mTimingSchedule(timing, &audio->ch3Fade, 2 - cyclesLate);
+		audio->ch3Fade.when = audio->ch3Timer.when - cycles + 2;
+		audio->ch3Fade.scheduled = true;
 	}
-	int cycles = 2 * (2048 - ch->rate);
-	mTimingSchedule(timing, &audio->ch3Event, audio->timingFactor * cycles - cyclesLate);
-}
-static void _fadeChannel3(struct mTiming* timing, void* user, uint32_t cyclesLate) {
-	UNUSED(timing);
-	UNUSED(cyclesLate);
-	struct GBAudio* audio = user;
-	audio->ch3.readable = false;
 }
 
-static void _updateChannel4(struct mTiming* timing, void* user, uint32_t cyclesLate) {
-	struct GBAudio* audio = user;
+static void _runNoiseChannel(struct GBAudio* audio, uint32_t timestamp) {
 	struct GBAudioNoiseChannel* ch = &audio->ch4;
 
 	int32_t cycles = ch->ratio ? 2 * ch->ratio : 1;
 	cycles <<= ch->frequency;
 	cycles *= 8 * audio->timingFactor;
 
-	uint32_t last = 0;
-	uint32_t now = cycles;
-	int32_t next = cycles - cyclesLate;
-
-	if (audio->style == GB_AUDIO_GBA) {
-		last = ch->lastEvent;
-		now = mTimingCurrentTime(timing) - cyclesLate;
-		ch->lastEvent = now;
-		now -= last;
-		last = 0;
-		if (audio->sampleInterval > next) {
-			// TODO: Make batching work when descheduled
-			next = audio->sampleInterval;
+	do {
+		uint32_t steps = 1;
+		int32_t next = cycles;
+		if (audio->style == GB_AUDIO_GBA) {
+			// Catch up on every step since the last batch at once
+			uint32_t elapsed = audio->ch4Timer.when - ch->lastEvent;
+			steps = elapsed / cycles + (elapsed % cycles != 0);
+			ch->lastEvent = audio->ch4Timer.when;
+			if (audio->sampleInterval > next) {
+				next = audio->sampleInterval;
+			}
 		}
-	}
 
-	for (; last < now; last += cycles) {
-		int lsb = ch->lfsr & 1;
-		ch->sample = lsb * ch->envelope.currentVolume;
-		++ch->nSamples;
-		ch->samples += ch->sample;
-		ch->lfsr >>= 1;
-		ch->lfsr ^= (lsb * 0x60) << (ch->power ? 0 : 8);
-	}
-
-	mTimingSchedule(timing, &audio->ch4Event, next);
+		for (; steps; --steps) {
+			int lsb = ch->lfsr & 1;
+			ch->sample = lsb * ch->envelope.currentVolume;
+			++ch->nSamples;
+			ch->samples += ch->sample;
+			ch->lfsr >>= 1;
+			ch->lfsr ^= (lsb * 0x60) << (ch->power ? 0 : 8);
+		}
+		audio->ch4Timer.when += next;
+	} while ((int32_t) (timestamp - audio->ch4Timer.when) >= 0);
 }
 
 void GBAudioPSGSerialize(const struct GBAudio* audio, struct GBSerializedPSGState* state, uint32_t* flagsOut) {
@@ -981,7 +1024,7 @@ void GBAudioPSGSerialize(const struct GBAudio* audio, struct GBSerializedPSGStat
 	ch1Flags = GBSerializedAudioEnvelopeSetNextStep(ch1Flags, audio->ch1.envelope.nextStep);
 	ch1Flags = GBSerializedAudioEnvelopeSetFrequency(ch1Flags, audio->ch1.sweep.realFrequency);
 	STORE_32LE(ch1Flags, 0, &state->ch1.envelope);
-	STORE_32LE(audio->ch1Event.when - mTimingCurrentTime(audio->timing), 0, &state->ch1.nextEvent);
+	STORE_32LE(audio->ch1Timer.when - mTimingCurrentTime(audio->timing), 0, &state->ch1.nextEvent);
 
 	flags = GBSerializedAudioFlagsSetCh2Volume(flags, audio->ch2.envelope.currentVolume);
 	flags = GBSerializedAudioFlagsSetCh2Dead(flags, audio->ch2.envelope.dead);
@@ -989,12 +1032,12 @@ void GBAudioPSGSerialize(const struct GBAudio* audio, struct GBSerializedPSGStat
 	ch2Flags = GBSerializedAudioEnvelopeSetLength(ch2Flags, audio->ch2.control.length);
 	ch2Flags = GBSerializedAudioEnvelopeSetNextStep(ch2Flags, audio->ch2.envelope.nextStep);
 	STORE_32LE(ch2Flags, 0, &state->ch2.envelope);
-	STORE_32LE(audio->ch2Event.when - mTimingCurrentTime(audio->timing), 0, &state->ch2.nextEvent);
+	STORE_32LE(audio->ch2Timer.when - mTimingCurrentTime(audio->timing), 0, &state->ch2.nextEvent);
 
 	flags = GBSerializedAudioFlagsSetCh3Readable(flags, audio->ch3.readable);
 	memcpy(state->ch3.wavebanks, audio->ch3.wavedata32, sizeof(state->ch3.wavebanks));
 	STORE_16LE(audio->ch3.length, 0, &state->ch3.length);
-	STORE_32LE(audio->ch3Event.when - mTimingCurrentTime(audio->timing), 0, &state->ch3.nextEvent);
+	STORE_32LE(audio->ch3Timer.when - mTimingCurrentTime(audio->timing), 0, &state->ch3.nextEvent);
 	STORE_32LE(audio->ch3Fade.when - mTimingCurrentTime(audio->timing), 0, &state->ch1.nextCh3Fade);
 
 	flags = GBSerializedAudioFlagsSetCh4Volume(flags, audio->ch4.envelope.currentVolume);
@@ -1004,7 +1047,7 @@ void GBAudioPSGSerialize(const struct GBAudio* audio, struct GBSerializedPSGStat
 	ch4Flags = GBSerializedAudioEnvelopeSetNextStep(ch4Flags, audio->ch4.envelope.nextStep);
 	STORE_32LE(ch4Flags, 0, &state->ch4.envelope);
 	STORE_32LE(audio->ch4.lastEvent, 0, &state->ch4.lastEvent);
-	STORE_32LE(audio->ch4Event.when - mTimingCurrentTime(audio->timing), 0, &state->ch4.nextEvent);
+	STORE_32LE(audio->ch4Timer.when - mTimingCurrentTime(audio->timing), 0, &state->ch4.nextEvent);
 
 	STORE_32LE(flags, 0, flagsOut);
 }
@@ -1041,8 +1084,9 @@ void GBAudioPSGDeserialize(struct GBAudio* audio, const struct GBSerializedPSGSt
 	audio->ch1.envelope.nextStep = GBSerializedAudioEnvelopeGetNextStep(ch1Flags);
 	audio->ch1.sweep.realFrequency = GBSerializedAudioEnvelopeGetFrequency(ch1Flags);
 	LOAD_32LE(when, 0, &state->ch1.nextEvent);
+	audio->ch1Timer.scheduled = false;
 	if (audio->ch1.envelope.dead < 2 && audio->playingCh1) {
-		mTimingSchedule(audio->timing, &audio->ch1Event, when);
+		_scheduleTimer(audio, &audio->ch1Timer, when);
 	}
 
 	LOAD_32LE(ch2Flags, 0, &state->ch2.envelope);
@@ -1052,8 +1096,9 @@ void GBAudioPSGDeserialize(struct GBAudio* audio, const struct GBSerializedPSGSt
 	audio->ch2.control.length = GBSerializedAudioEnvelopeGetLength(ch2Flags);
 	audio->ch2.envelope.nextStep = GBSerializedAudioEnvelopeGetNextStep(ch2Flags);
 	LOAD_32LE(when, 0, &state->ch2.nextEvent);
+	audio->ch2Timer.scheduled = false;
 	if (audio->ch2.envelope.dead < 2 && audio->playingCh2) {
-		mTimingSchedule(audio->timing, &audio->ch2Event, when);
+		_scheduleTimer(audio, &audio->ch2Timer, when);
 	}
 
 	audio->ch3.readable = GBSerializedAudioFlagsGetCh3Readable(flags);
@@ -1061,12 +1106,14 @@ void GBAudioPSGDeserialize(struct GBAudio* audio, const struct GBSerializedPSGSt
 	memcpy(audio->ch3.wavedata32, state->ch3.wavebanks, sizeof(audio->ch3.wavedata32));
 	LOAD_16LE(audio->ch3.length, 0, &state->ch3.length);
 	LOAD_32LE(when, 0, &state->ch3.nextEvent);
+	audio->ch3Timer.scheduled = false;
 	if (audio->playingCh3) {
-		mTimingSchedule(audio->timing, &audio->ch3Event, when);
+		_scheduleTimer(audio, &audio->ch3Timer, when);
 	}
 	LOAD_32LE(when, 0, &state->ch1.nextCh3Fade);
+	audio->ch3Fade.scheduled = false;
 	if (audio->ch3.readable && audio->style == GB_AUDIO_DMG) {
-		mTimingSchedule(audio->timing, &audio->ch3Fade, when);
+		_scheduleTimer(audio, &audio->ch3Fade, when);
 	}
 
 	LOAD_32LE(ch4Flags, 0, &state->ch4.envelope);
@@ -1077,6 +1124,7 @@ void GBAudioPSGDeserialize(struct GBAudio* audio, const struct GBSerializedPSGSt
 	LOAD_32LE(audio->ch4.lfsr, 0, &state->ch4.lfsr);
 	LOAD_32LE(audio->ch4.lastEvent, 0, &state->ch4.lastEvent);
 	LOAD_32LE(when, 0, &state->ch4.nextEvent);
+	audio->ch4Timer.scheduled = false;
 	if (audio->ch4.envelope.dead < 2 && audio->playingCh4) {
 		if (!audio->ch4.lastEvent) {
 			// Back-compat: fake this value
@@ -1086,7 +1134,7 @@ void GBAudioPSGDeserialize(struct GBAudio* audio, const struct GBSerializedPSGSt
 			cycles *= 8 * audio->timingFactor;
 			audio->ch4.lastEvent = currentTime + (when & (cycles - 1)) - cycles;
 		}
-		mTimingSchedule(audio->timing, &audio->ch4Event, when);
+		_scheduleTimer(audio, &audio->ch4Timer, when);
 	}
 }
 
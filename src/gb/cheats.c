@@ -6,8 +6,10 @@
 #include <mgba/internal/gb/cheats.h>
 
 #include <mgba/core/core.h>
+#include <mgba/core/serialize.h>
 #include <mgba/internal/gb/gb.h>
 #include <mgba/internal/gb/memory.h>
+#include <mgba/internal/sm83/sm83.h>
 #include <mgba-util/string.h>
 
 DEFINE_VECTOR(GBCheatPatchList, struct GBCheatPatch);
@@ -88,10 +90,59 @@ static struct mCheatSet* GBCheatSetCreate(struct mCheatDevice* device, const cha
 	return &set->d;
 }
 
+enum {
+	GB_CHEAT_REGION_WRAM_BANK0,
+	GB_CHEAT_REGION_WRAM_BANK1,
+	GB_CHEAT_REGION_HRAM,
+	GB_CHEAT_REGION_MAX
+};
+
+static void _mapRegions(struct mCheatDevice* device) {
+	if (!device->p) {
+		return;
+	}
+	struct GB* gb = device->p->board;
+	struct SM83Core* cpu = device->p->cpu;
+	// DMA blocks the bus and the debugger needs to see every access
+	if (gb->memory.dmaRemaining || cpu->memory.store8 != GBStore8 || cpu->memory.load8 != GBLoad8) {
+		device->regions[GB_CHEAT_REGION_WRAM_BANK0].data = NULL;
+		device->regions[GB_CHEAT_REGION_WRAM_BANK1].data = NULL;
+		device->regions[GB_CHEAT_REGION_HRAM].data = NULL;
+		return;
+	}
+	device->regions[GB_CHEAT_REGION_WRAM_BANK0].data = gb->memory.wram;
+	device->regions[GB_CHEAT_REGION_WRAM_BANK1].data = gb->memory.wramBank;
+	device->regions[GB_CHEAT_REGION_HRAM].data = gb->memory.hram;
+}
+
+static void _written(struct mCheatDevice* device, uint32_t address, int width) {
+	struct GB* gb = device->p->board;
+	gb->idlePending = false;
+	if (address >= GB_BASE_HRAM) {
+		return;
+	}
+	uint8_t* bank = address >= GB_BASE_WORKING_RAM_BANK1 ? gb->memory.wramBank : gb->memory.wram;
+	uint32_t offset = (bank - gb->memory.wram) + (address & (GB_SIZE_WORKING_RAM_BANK0 - 1));
+	mStatePageMark(gb->memory.dirtyWram, offset);
+	mStatePageMark(gb->memory.dirtyWram, offset + width - 1);
+}
+
 struct mCheatDevice* GBCheatDeviceCreate(void) {
 	struct mCheatDevice* device = malloc(sizeof(*device));
 	mCheatDeviceCreate(device);
 	device->createSet = GBCheatSetCreate;
+	device->mapRegions = _mapRegions;
+	device->written = _written;
+	device->nRegions = GB_CHEAT_REGION_MAX;
+	device->regions[GB_CHEAT_REGION_WRAM_BANK0] = (struct mCheatRegion) {
+		GB_BASE_WORKING_RAM_BANK0, GB_SIZE_WORKING_RAM_BANK0, GB_SIZE_WORKING_RAM_BANK0 - 1, NULL
+	};
+	device->regions[GB_CHEAT_REGION_WRAM_BANK1] = (struct mCheatRegion) {
+		GB_BASE_WORKING_RAM_BANK1, GB_SIZE_WORKING_RAM_BANK0, GB_SIZE_WORKING_RAM_BANK0 - 1, NULL
+	};
+	device->regions[GB_CHEAT_REGION_HRAM] = (struct mCheatRegion) {
+		GB_BASE_HRAM, GB_SIZE_HRAM, GB_SIZE_HRAM, NULL
+	};
 	return device;
 }
 
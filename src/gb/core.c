@@ -72,6 +72,9 @@ struct GBCore {
 	const struct Configuration* overrides;
 	struct mDebuggerPlatform* debuggerPlatform;
 	struct mCheatDevice* cheatDevice;
+	enum mColorFormat videoBufferFormat;
+	// What gets drawn into while converting to videoBufferFormat
+	color_t* nativeBuffer;
 };
 
 static bool _GBCoreInit(struct mCore* core) {
@@ -100,6 +103,8 @@ static bool _GBCoreInit(struct mCore* core) {
 
 	GBVideoSoftwareRendererCreate(&gbcore->renderer);
 	gbcore->renderer.outputBuffer = NULL;
+	gbcore->videoBufferFormat = mCOLOR_NATIVE;
+	gbcore->nativeBuffer = NULL;
 
 	gbcore->keys = 0;
 	gb->keySource = &gbcore->keys;
@@ -131,6 +136,7 @@ static void _GBCoreDeinit(struct mCore* core) {
 		mCheatDeviceDestroy(gbcore->cheatDevice);
 	}
 	free(gbcore->cheatDevice);
+	free(gbcore->nativeBuffer);
 	mCoreConfigFreeOpts(&core->opts);
 	free(core);
 }
@@ -202,6 +208,31 @@ static void _GBCoreLoadConfig(struct mCore* core, const struct mCoreConfig* conf
 		GBVideoSetPalette(&gb->video, 11, color);
 	}
 
+	const char* idleOptimization = mCoreConfigGetValue(config, "idleOptimization");
+	if (idleOptimization) {
+		if (strcasecmp(idleOptimization, "ignore") == 0) {
+			gb->idleOptimization = GB_IDLE_LOOP_IGNORE;
+		} else if (strcasecmp(idleOptimization, "remove") == 0) {
+			gb->idleOptimization = GB_IDLE_LOOP_REMOVE;
+		} else if (strcasecmp(idleOptimization, "detect") == 0) {
+			if (gb->idleLoop == GB_IDLE_LOOP_NONE) {
+				gb->idleOptimization = GB_IDLE_LOOP_DETECT;
+			} else {
+				gb->idleOptimization = GB_IDLE_LOOP_REMOVE;
+			}
+		}
+	}
+
+	const char* audioResampler = mCoreConfigGetValue(config, "audioResampler");
+	if (audioResampler) {
+		GBAudioSetResampler(&gb->audio, GBAudioNameToResampler(audioResampler));
+	}
+
+	const char* savedataDurability = mCoreConfigGetValue(config, "savedataDurability");
+	if (savedataDurability) {
+		gb->sramFlusher.durability = mSavedataDurabilityFromName(savedataDurability);
+	}
+
 	mCoreConfigCopyValue(&core->config, config, "gb.bios");
 	mCoreConfigCopyValue(&core->config, config, "sgb.bios");
 	mCoreConfigCopyValue(&core->config, config, "gbc.bios");
@@ -215,6 +246,10 @@ static void _GBCoreLoadConfig(struct mCore* core, const struct mCoreConfig* conf
 	mCoreConfigGetIntValue(config, "allowOpposingDirections", &fakeBool);
 	gb->allowOpposingDirections = fakeBool;
 
+	fakeBool = 0;
+	mCoreConfigGetIntValue(config, "gb.accurateDma", &fakeBool);
+	gb->accurateDma = fakeBool;
+
 	if (mCoreConfigGetIntValue(config, "sgb.borders", &fakeBool)) {
 		gb->video.sgbBorders = fakeBool;
 		gb->video.renderer->enableSGBBorder(gb->video.renderer, fakeBool);
@@ -265,6 +300,15 @@ static void _GBCoreReloadConfigOption(struct mCore* core, const char* option, co
 	if (strcmp("frameskip", option) == 0) {
 		if (mCoreConfigGetIntValue(config, "frameskip", &core->opts.frameskip)) {
 			gb->video.frameskip = core->opts.frameskip;
+			// Start the new cadence on the next frame instead of finishing out the old one
+			gb->video.frameskipCounter = core->opts.frameskip;
+		}
+		return;
+	}
+	if (strcmp("savedataDurability", option) == 0) {
+		const char* savedataDurability = mCoreConfigGetValue(config, "savedataDurability");
+		if (savedataDurability) {
+			gb->sramFlusher.durability = mSavedataDurabilityFromName(savedataDurability);
 		}
 		return;
 	}
@@ -277,6 +321,19 @@ static void _GBCoreReloadConfigOption(struct mCore* core, const char* option, co
 		}
 		return;
 	}
+	if (strcmp("gb.accurateDma", option) == 0) {
+		if (mCoreConfigGetIntValue(config, "gb.accurateDma", &fakeBool)) {
+			gb->accurateDma = fakeBool;
+		}
+		return;
+	}
+	if (strcmp("audioResampler", option) == 0) {
+		const char* audioResampler = mCoreConfigGetValue(config, "audioResampler");
+		if (audioResampler) {
+			GBAudioSetResampler(&gb->audio, GBAudioNameToResampler(audioResampler));
+		}
+		return;
+	}
 	if (strcmp("sgb.borders", option) == 0) {
 		if (mCoreConfigGetIntValue(config, "sgb.borders", &fakeBool)) {
 			gb->video.sgbBorders = fakeBool;
@@ -298,8 +355,29 @@ static void _GBCoreDesiredVideoDimensions(struct mCore* core, unsigned* width, u
 
 static void _GBCoreSetVideoBuffer(struct mCore* core, color_t* buffer, size_t stride) {
 	struct GBCore* gbcore = (struct GBCore*) core;
-	gbcore->renderer.outputBuffer = buffer;
-	gbcore->renderer.outputBufferStride = stride;
+	gbcore->renderer.convertRow = mColorGetRowConverter(gbcore->videoBufferFormat);
+	if (!gbcore->renderer.convertRow) {
+		gbcore->renderer.outputBuffer = buffer;
+		gbcore->renderer.outputBufferStride = stride;
+		return;
+	}
+	if (!gbcore->nativeBuffer) {
+		gbcore->nativeBuffer = calloc(256 * 224, BYTES_PER_PIXEL);
+	}
+	gbcore->renderer.outputBuffer = gbcore->nativeBuffer;
+	gbcore->renderer.outputBufferStride = 256;
+	gbcore->renderer.convertBuffer = buffer;
+	gbcore->renderer.convertStride = stride;
+	gbcore->renderer.convertBytes = mColorFormatBytes(gbcore->videoBufferFormat);
+}
+
+static bool _GBCoreSetVideoBufferFormat(struct mCore* core, enum mColorFormat format) {
+	struct GBCore* gbcore = (struct GBCore*) core;
+	if (format != mCOLOR_NATIVE && !mColorGetRowConverter(format)) {
+		return false;
+	}
+	gbcore->videoBufferFormat = format;
+	return true;
 }
 
 static void _GBCoreSetVideoGLTex(struct mCore* core, unsigned texid) {
@@ -307,6 +385,16 @@ static void _GBCoreSetVideoGLTex(struct mCore* core, unsigned texid) {
 	UNUSED(texid);
 }
 
+static void _GBCoreSetVideoColorTable(struct mCore* core, const color_t* table) {
+	struct GBCore* gbcore = (struct GBCore*) core;
+	struct GB* gb = core->board;
+	const uint16_t* palette = NULL;
+	if (gb->video.renderer == &gbcore->renderer.d) {
+		palette = gb->video.palette;
+	}
+	GBVideoSoftwareRendererSetColorTable(&gbcore->renderer, table, palette);
+}
+
 static void _GBCoreGetPixels(struct mCore* core, const void** buffer, size_t* stride) {
 	struct GBCore* gbcore = (struct GBCore*) core;
 	gbcore->renderer.d.getPixels(&gbcore->renderer.d, stride, buffer);
@@ -317,6 +405,11 @@ static void _GBCorePutPixels(struct mCore* core, const void* buffer, size_t stri
 	gbcore->renderer.d.putPixels(&gbcore->renderer.d, stride, buffer);
 }
 
+static bool _GBCoreVideoFrameChanged(struct mCore* core) {
+	UNUSED(core);
+	return true;
+}
+
 static struct blip_t* _GBCoreGetAudioChannel(struct mCore* core, int ch) {
 	struct GB* gb = core->board;
 	switch (ch) {
@@ -339,6 +432,11 @@ static size_t _GBCoreGetAudioBufferSize(struct mCore* core) {
 	return gb->audio.samples;
 }
 
+static void _GBCoreSetAudioMuted(struct mCore* core, bool muted) {
+	struct GB* gb = core->board;
+	gb->audio.muted = muted;
+}
+
 static void _GBCoreAddCoreCallbacks(struct mCore* core, struct mCoreCallbacks* coreCallbacks) {
 	struct GB* gb = core->board;
 	*mCoreCallbacksListAppend(&gb->coreCallbacks) = *coreCallbacks;
@@ -566,6 +664,14 @@ static bool _GBCoreSaveState(struct mCore* core, void* state) {
 	return true;
 }
 
+static bool _GBCoreCollectDirtyState(struct mCore* core, uint32_t* pages, size_t size) {
+	return GBCollectDirtyState(core->board, pages, size);
+}
+
+static uint64_t _GBCoreStateHash(struct mCore* core) {
+	return GBStateHash(core->board);
+}
+
 static void _GBCoreSetKeys(struct mCore* core, uint32_t keys) {
 	struct GBCore* gbcore = (struct GBCore*) core;
 	gbcore->keys = keys;
@@ -826,6 +932,7 @@ static size_t _GBCoreSavedataClone(struct mCore* core, void** sram) {
 	struct GB* gb = core->board;
 	struct VFile* vf = gb->sramVf;
 	if (vf) {
+		mSavedataFlusherWait(&gb->sramFlusher);
 		*sram = malloc(vf->size(vf));
 		vf->seek(vf, 0, SEEK_SET);
 		return vf->read(vf, *sram, vf->size(vf));
@@ -848,6 +955,7 @@ static bool _GBCoreSavedataRestore(struct mCore* core, const void* sram, size_t
 	}
 	struct VFile* vf = gb->sramVf;
 	if (vf) {
+		mSavedataFlusherWait(&gb->sramFlusher);
 		vf->seek(vf, 0, SEEK_SET);
 		return vf->write(vf, sram, size) > 0;
 	}
@@ -970,12 +1078,16 @@ struct mCore* GBCoreCreate(void) {
 	core->reloadConfigOption = _GBCoreReloadConfigOption;
 	core->desiredVideoDimensions = _GBCoreDesiredVideoDimensions;
 	core->setVideoBuffer = _GBCoreSetVideoBuffer;
+	core->setVideoBufferFormat = _GBCoreSetVideoBufferFormat;
 	core->setVideoGLTex = _GBCoreSetVideoGLTex;
+	core->setVideoColorTable = _GBCoreSetVideoColorTable;
 	core->getPixels = _GBCoreGetPixels;
 	core->putPixels = _GBCorePutPixels;
+	core->videoFrameChanged = _GBCoreVideoFrameChanged;
 	core->getAudioChannel = _GBCoreGetAudioChannel;
 	core->setAudioBufferSize = _GBCoreSetAudioBufferSize;
 	core->getAudioBufferSize = _GBCoreGetAudioBufferSize;
+	core->setAudioMuted = _GBCoreSetAudioMuted;
 	core->setAVStream = _GBCoreSetAVStream;
 	core->addCoreCallbacks = _GBCoreAddCoreCallbacks;
 	core->clearCoreCallbacks = _GBCoreClearCoreCallbacks;
@@ -994,6 +1106,12 @@ struct mCore* GBCoreCreate(void) {
 	core->stateSize = _GBCoreStateSize;
 	core->loadState = _GBCoreLoadState;
 	core->saveState = _GBCoreSaveState;
+	core->collectDirtyState = _GBCoreCollectDirtyState;
+	core->copyState = NULL;
+	core->listStateRegions = NULL;
+	core->saveStateRegions = NULL;
+	core->loadStateRegions = NULL;
+	core->stateHash = _GBCoreStateHash;
 	core->setKeys = _GBCoreSetKeys;
 	core->addKeys = _GBCoreAddKeys;
 	core->clearKeys = _GBCoreClearKeys;
@@ -1037,6 +1155,7 @@ struct mCore* GBCoreCreate(void) {
 #ifndef MINIMAL_CORE
 	core->startVideoLog = _GBCoreStartVideoLog;
 	core->endVideoLog = _GBCoreEndVideoLog;
+	core->seekVideoLog = NULL;
 #endif
 	return core;
 }
@@ -1099,6 +1218,20 @@ static void _GBVLPReset(struct mCore* core) {
 	gb->memory.ime = false;
 }
 
+static uint32_t _GBVLPSeekVideoLog(struct mCore* core, uint32_t frame) {
+	struct GBCore* gbcore = (struct GBCore*) core;
+	struct GB* gb = core->board;
+	bool shimmed = gb->video.renderer == &gbcore->proxyRenderer.d;
+	if (shimmed) {
+		GBVideoProxyRendererUnshim(&gb->video, &gbcore->proxyRenderer);
+	}
+	uint32_t keyframe = mVideoLogContextSeek(gbcore->logContext, core, frame);
+	if (shimmed) {
+		GBVideoProxyRendererShim(&gb->video, &gbcore->proxyRenderer);
+	}
+	return keyframe;
+}
+
 static bool _GBVLPLoadROM(struct mCore* core, struct VFile* vf) {
 	struct GBCore* gbcore = (struct GBCore*) core;
 	gbcore->logContext = mVideoLogContextCreate(NULL);
@@ -1115,7 +1248,7 @@ static bool _GBVLPLoadState(struct mCore* core, const void* buffer) {
 	struct GB* gb = (struct GB*) core->board;
 	const struct GBSerializedState* state = buffer;
 
-	gb->timing.root = NULL;
+	mTimingEventHeapClear(&gb->timing.events);
 	gb->model = state->model;
 
 	gb->cpu->pc = GB_BASE_HRAM;
@@ -1146,6 +1279,9 @@ struct mCore* GBVideoLogPlayerCreate(void) {
 	core->reset = _GBVLPReset;
 	core->loadROM = _GBVLPLoadROM;
 	core->loadState = _GBVLPLoadState;
+	core->seekVideoLog = _GBVLPSeekVideoLog;
+	core->collectDirtyState = NULL;
+	core->stateHash = NULL;
 	core->isROM = _returnTrue;
 	return core;
 }
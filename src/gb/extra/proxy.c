@@ -40,6 +40,7 @@ void GBVideoProxyRendererCreate(struct GBVideoProxyRenderer* renderer, struct GB
 	renderer->d.drawRange = GBVideoProxyRendererDrawRange;
 	renderer->d.finishScanline = GBVideoProxyRendererFinishScanline;
 	renderer->d.finishFrame = GBVideoProxyRendererFinishFrame;
+	renderer->d.skipFrame = NULL;
 	renderer->d.enableSGBBorder = GBVideoProxyRendererEnableSGBBorder;
 	renderer->d.getPixels = GBVideoProxyRendererGetPixels;
 	renderer->d.putPixels = GBVideoProxyRendererPutPixels;
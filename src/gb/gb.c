@@ -7,6 +7,7 @@
 
 #include <mgba/internal/gb/io.h>
 #include <mgba/internal/gb/mbc.h>
+#include <mgba/internal/gb/overrides.h>
 #include <mgba/internal/sm83/sm83.h>
 
 #include <mgba/core/core.h>
@@ -17,8 +18,6 @@
 #include <mgba-util/patch.h>
 #include <mgba-util/vfs.h>
 
-#define CLEANUP_THRESHOLD 15
-
 const uint32_t CGB_SM83_FREQUENCY = 0x800000;
 const uint32_t SGB_SM83_FREQUENCY = 0x418B1E;
 
@@ -73,10 +72,14 @@ static void GBInit(void* cpu, struct mCPUComponent* component) {
 
 	gb->model = GB_MODEL_AUTODETECT;
 
+	gb->idleOptimization = GB_IDLE_LOOP_REMOVE;
+	gb->idleLoop = GB_IDLE_LOOP_NONE;
+
 	gb->biosVf = NULL;
 	gb->romVf = NULL;
 	gb->sramVf = NULL;
 	gb->sramRealVf = NULL;
+	mSavedataFlusherInit(&gb->sramFlusher);
 
 	gb->isPristine = false;
 	gb->pristineRomSize = 0;
@@ -141,6 +144,7 @@ void GBYankROM(struct GB* gb) {
 }
 
 static void GBSramDeinit(struct GB* gb) {
+	mSavedataFlusherWait(&gb->sramFlusher);
 	if (gb->sramVf) {
 		gb->sramVf->unmap(gb->sramVf, gb->memory.sram, gb->sramSize);
 		if (gb->memory.mbcType == GB_MBC3_RTC && gb->sramVf == gb->sramRealVf) {
@@ -155,6 +159,7 @@ static void GBSramDeinit(struct GB* gb) {
 
 bool GBLoadSave(struct GB* gb, struct VFile* vf) {
 	GBSramDeinit(gb);
+	mSavedataFlusherReset(&gb->sramFlusher);
 	gb->sramVf = vf;
 	gb->sramRealVf = vf;
 	if (gb->sramSize) {
@@ -170,6 +175,7 @@ void GBResizeSram(struct GB* gb, size_t size) {
 	}
 	struct VFile* vf = gb->sramVf;
 	if (vf) {
+		mSavedataFlusherWait(&gb->sramFlusher);
 		if (vf == gb->sramRealVf) {
 			ssize_t vfSize = vf->size(vf);
 			if (vfSize >= 0 && (size_t) vfSize < size) {
@@ -221,33 +227,25 @@ void GBResizeSram(struct GB* gb, size_t size) {
 	if (gb->sramSize < size) {
 		gb->sramSize = size;
 	}
+	GBMemoryRemapSram(gb);
 }
 
 void GBSramClean(struct GB* gb, uint32_t frameCount) {
-	// TODO: Share with GBASavedataClean
 	if (!gb->sramVf) {
 		return;
 	}
-	if (gb->sramDirty & GB_SRAM_DIRT_NEW) {
-		gb->sramDirtAge = frameCount;
-		gb->sramDirty &= ~GB_SRAM_DIRT_NEW;
-		if (!(gb->sramDirty & GB_SRAM_DIRT_SEEN)) {
-			gb->sramDirty |= GB_SRAM_DIRT_SEEN;
-		}
-	} else if ((gb->sramDirty & GB_SRAM_DIRT_SEEN) && frameCount - gb->sramDirtAge > CLEANUP_THRESHOLD) {
-		if (gb->sramMaskWriteback) {
-			GBSavedataUnmask(gb);
-		}
-		if (gb->memory.mbcType == GB_MBC3_RTC) {
-			GBMBCRTCWrite(gb);
-		}
-		gb->sramDirty = 0;
-		if (gb->memory.sram && gb->sramVf->sync(gb->sramVf, gb->memory.sram, gb->sramSize)) {
-			mLOG(GB_MEM, INFO, "Savedata synced");
-		} else {
-			mLOG(GB_MEM, INFO, "Savedata failed to sync!");
-		}
+	if (!mSavedataFlusherPoll(&gb->sramFlusher, frameCount)) {
+		return;
+	}
+	enum mTimingHostCategory category = mTimingHostEnter(&gb->timing, mTIMING_HOST_IO);
+	if (gb->sramMaskWriteback) {
+		GBSavedataUnmask(gb);
+	}
+	if (gb->memory.mbcType == GB_MBC3_RTC) {
+		GBMBCRTCWrite(gb);
 	}
+	mSavedataFlusherFlush(&gb->sramFlusher, gb->sramVf, gb->memory.sram, gb->sramSize);
+	mTimingHostLeave(&gb->timing, category);
 }
 
 void GBSavedataMask(struct GB* gb, struct VFile* vf, bool writeback) {
@@ -303,6 +301,9 @@ void GBUnloadROM(struct GB* gb) {
 	gb->isPristine = false;
 
 	gb->sramMaskWriteback = false;
+	if (gb->sramVf && gb->sramVf == gb->sramRealVf) {
+		mSavedataFlusherFinish(&gb->sramFlusher, gb->sramVf, gb->memory.sram, gb->sramSize);
+	}
 	GBSramDeinit(gb);
 	if (gb->sramRealVf) {
 		gb->sramRealVf->close(gb->sramRealVf);
@@ -312,6 +313,7 @@ void GBUnloadROM(struct GB* gb) {
 	if (gb->memory.cam && gb->memory.cam->stopRequestImage) {
 		gb->memory.cam->stopRequestImage(gb->memory.cam);
 	}
+	gb->idleLoop = GB_IDLE_LOOP_NONE;
 }
 
 void GBSynthesizeROM(struct VFile* vf) {
@@ -338,10 +340,24 @@ void GBApplyPatch(struct GB* gb, struct Patch* patch) {
 	if (patchedSize > GB_SIZE_CART_MAX) {
 		patchedSize = GB_SIZE_CART_MAX;
 	}
-	void* newRom = anonymousMemoryMap(GB_SIZE_CART_MAX);
-	if (!patch->applyPatch(patch, gb->memory.rom, gb->pristineRomSize, newRom, patchedSize)) {
-		mappedMemoryFree(newRom, GB_SIZE_CART_MAX);
-		return;
+	void* newRom = NULL;
+	// The CRC32 taken when the ROM was loaded only covers it while it's pristine
+	patch->hasInputCrc32 = gb->isPristine;
+	patch->inputCrc32 = gb->romCrc32;
+	if (gb->isPristine && gb->romVf) {
+		// Patch a private mapping of the ROM in place, so unpatched pages stay shared with the file
+		newRom = VFileMapCopyOnWrite(gb->romVf, gb->pristineRomSize, GB_SIZE_CART_MAX);
+		if (newRom && !patch->applyPatch(patch, newRom, gb->pristineRomSize, newRom, patchedSize)) {
+			mappedMemoryFree(newRom, GB_SIZE_CART_MAX);
+			newRom = NULL;
+		}
+	}
+	if (!newRom) {
+		newRom = anonymousMemoryMap(GB_SIZE_CART_MAX);
+		if (!patch->applyPatch(patch, gb->memory.rom, gb->pristineRomSize, newRom, patchedSize)) {
+			mappedMemoryFree(newRom, GB_SIZE_CART_MAX);
+			return;
+		}
 	}
 	if (gb->romVf) {
 #ifndef FIXED_ROM_BUFFER
@@ -356,7 +372,8 @@ void GBApplyPatch(struct GB* gb, struct Patch* patch) {
 	}
 	gb->memory.rom = newRom;
 	gb->memory.romSize = patchedSize;
-	gb->romCrc32 = doCrc32(gb->memory.rom, gb->memory.romSize);
+	gb->romCrc32 = patch->hasOutputCrc32 ? patch->outputCrc32 : doCrc32(gb->memory.rom, gb->memory.romSize);
+	GBMemoryRemapRom(gb);
 	gb->cpu->memory.setActiveRegion(gb->cpu, gb->cpu->pc);
 }
 
@@ -368,9 +385,10 @@ void GBDestroy(struct GB* gb) {
 		gb->biosVf = 0;
 	}
 
-	GBMemoryDeinit(gb);
+	mSavedataFlusherDeinit(&gb->sramFlusher);
 	GBAudioDeinit(&gb->audio);
 	GBVideoDeinit(&gb->video);
+	GBMemoryDeinit(gb);
 	GBSIODeinit(&gb->sio);
 	mCoreCallbacksListDeinit(&gb->coreCallbacks);
 }
@@ -424,6 +442,13 @@ void GBReset(struct SM83Core* cpu) {
 	gb->earlyExit = false;
 	gb->doubleSpeed = 0;
 
+	gb->lastJump = 0;
+	gb->idlePending = false;
+	gb->idleLoads = -1;
+	gb->idleProven = false;
+	gb->idleDetectionStep = 0;
+	gb->idleDetectionFailures = 0;
+
 	if (gb->yankedRomSize) {
 		gb->memory.romSize = gb->yankedRomSize;
 		gb->memory.mbcType = gb->yankedMbc;
@@ -576,6 +601,7 @@ void GBMapBIOS(struct GB* gb) {
 	if (size > 0x100) {
 		memcpy(&gb->memory.romBase[0x100], &oldRomBase[0x100], sizeof(struct GBCartridge));
 	}
+	GBMemoryRemapRom(gb);
 }
 
 void GBUnmapBIOS(struct GB* gb) {
@@ -756,8 +782,10 @@ void GBStop(struct SM83Core* cpu) {
 		mLOG(GB, GAME_ERROR, "Hit illegal stop at address %04X:%02X", cpu->pc, cpu->bus);
 	}
 	if (gb->memory.io[REG_KEY1] & 1) {
+		GBTimerUpdateRegisters(&gb->timer);
 		gb->doubleSpeed ^= 1;
 		gb->audio.timingFactor = gb->doubleSpeed + 1;
+		GBTimerReschedule(&gb->timer);
 		gb->memory.io[REG_KEY1] = 0;
 		gb->memory.io[REG_KEY1] |= gb->doubleSpeed << 7;
 	} else if (cpu->bus) {
@@ -810,14 +838,7 @@ bool GBIsROM(struct VFile* vf) {
 	return true;
 }
 
-void GBGetGameTitle(const struct GB* gb, char* out) {
-	const struct GBCartridge* cart = NULL;
-	if (gb->memory.rom) {
-		cart = (const struct GBCartridge*) &gb->memory.rom[0x100];
-	}
-	if (!cart) {
-		return;
-	}
+static void _getCartTitle(const struct GBCartridge* cart, char* out) {
 	if (cart->oldLicensee != 0x33) {
 		memcpy(out, cart->titleLong, 16);
 	} else {
@@ -825,15 +846,8 @@ void GBGetGameTitle(const struct GB* gb, char* out) {
 	}
 }
 
-void GBGetGameCode(const struct GB* gb, char* out) {
+static void _getCartCode(const struct GBCartridge* cart, char* out) {
 	memset(out, 0, 8);
-	const struct GBCartridge* cart = NULL;
-	if (gb->memory.rom) {
-		cart = (const struct GBCartridge*) &gb->memory.rom[0x100];
-	}
-	if (!cart) {
-		return;
-	}
 	if (cart->cgb == 0xC0) {
 		memcpy(out, "CGB-????", 8);
 	} else {
@@ -844,8 +858,35 @@ void GBGetGameCode(const struct GB* gb, char* out) {
 	}
 }
 
+bool GBIdentifyROM(struct VFile* vf, struct mCoreROMInfo* info) {
+	struct GBCartridge cart;
+	if (vf->seek(vf, 0x100, SEEK_SET) < 0 || vf->read(vf, &cart, sizeof(cart)) != (ssize_t) sizeof(cart)) {
+		return false;
+	}
+	_getCartTitle(&cart, info->title);
+	_getCartCode(&cart, info->code);
+	info->size = vf->size(vf);
+	info->crc32 = fileCrc32(vf, info->size);
+	return true;
+}
+
+void GBGetGameTitle(const struct GB* gb, char* out) {
+	if (gb->memory.rom) {
+		_getCartTitle((const struct GBCartridge*) &gb->memory.rom[0x100], out);
+	}
+}
+
+void GBGetGameCode(const struct GB* gb, char* out) {
+	if (gb->memory.rom) {
+		_getCartCode((const struct GBCartridge*) &gb->memory.rom[0x100], out);
+	} else {
+		memset(out, 0, 8);
+	}
+}
+
 void GBFrameStarted(struct GB* gb) {
 	GBTestKeypadIRQ(gb);
+	GBMBCRTCResample(gb);
 
 	size_t c;
 	for (c = 0; c < mCoreCallbacksListSize(&gb->coreCallbacks); ++c) {
@@ -107,6 +107,14 @@ static const uint8_t _registerMask[] = {
 static uint8_t _readKeys(struct GB* gb);
 static uint8_t _readKeysFiltered(struct GB* gb);
 
+static void _runAudio(struct GB* gb) {
+	// Registers are replayed before the channels are restored when loading a savestate
+	if (mTimingIsScheduled(&gb->timing, &gb->audio.sampleEvent)) {
+		// The CPU accesses the bus before anything due on the same cycle is processed
+		GBAudioRun(&gb->audio, mTimingCurrentTime(&gb->timing) - 1);
+	}
+}
+
 static void _writeSGBBits(struct GB* gb, int bits) {
 	if (!bits) {
 		gb->sgbBit = -1;
@@ -218,6 +226,10 @@ void GBIOReset(struct GB* gb) {
 }
 
 void GBIOWrite(struct GB* gb, unsigned address, uint8_t value) {
+	if (address >= REG_NR10 && address <= REG_WAVE_F) {
+		// The channels are evaluated lazily, so they need to catch up first
+		_runAudio(gb);
+	}
 	switch (address) {
 	case REG_SB:
 		GBSIOWriteSB(&gb->sio, value);
@@ -409,16 +421,21 @@ void GBIOWrite(struct GB* gb, unsigned address, uint8_t value) {
 		}
 		return;
 	case REG_TIMA:
+		GBTimerUpdateRegisters(&gb->timer);
 		if (value && mTimingUntil(&gb->timing, &gb->timer.irq) > 1) {
 			mTimingDeschedule(&gb->timing, &gb->timer.irq);
 		}
 		if (mTimingUntil(&gb->timing, &gb->timer.irq) == -1) {
 			return;
 		}
-		break;
+		gb->memory.io[REG_TIMA] = value;
+		GBTimerReschedule(&gb->timer);
+		return;
 	case REG_TMA:
 		if (mTimingUntil(&gb->timing, &gb->timer.irq) == -1) {
+			GBTimerUpdateRegisters(&gb->timer);
 			gb->memory.io[REG_TIMA] = value;
+			GBTimerReschedule(&gb->timer);
 		}
 		break;
 	case REG_TAC:
@@ -579,6 +596,8 @@ static uint8_t _readKeysFiltered(struct GB* gb) {
 uint8_t GBIORead(struct GB* gb, unsigned address) {
 	switch (address) {
 	case REG_JOYP:
+		// Input can change without an event, so this read isn't idle
+		gb->idlePending = false;
 		{
 			size_t c;
 			for (c = 0; c < mCoreCallbacksListSize(&gb->coreCallbacks); ++c) {
@@ -591,6 +610,10 @@ uint8_t GBIORead(struct GB* gb, unsigned address) {
 		return _readKeysFiltered(gb);
 	case REG_IE:
 		return gb->memory.ie;
+	case REG_DIV:
+	case REG_TIMA:
+		GBTimerUpdateRegisters(&gb->timer);
+		break;
 	case REG_WAVE_0:
 	case REG_WAVE_1:
 	case REG_WAVE_2:
@@ -607,6 +630,8 @@ uint8_t GBIORead(struct GB* gb, unsigned address) {
 	case REG_WAVE_D:
 	case REG_WAVE_E:
 	case REG_WAVE_F:
+		gb->idlePending = false;
+		_runAudio(gb);
 		if (gb->audio.playingCh3) {
 			if (gb->audio.ch3.readable || gb->audio.style != GB_AUDIO_DMG) {
 				return gb->audio.ch3.wavedata8[gb->audio.ch3.window >> 1];
@@ -637,8 +662,6 @@ uint8_t GBIORead(struct GB* gb, unsigned address) {
 	case REG_NR50:
 	case REG_NR51:
 	case REG_NR52:
-	case REG_DIV:
-	case REG_TIMA:
 	case REG_TMA:
 	case REG_TAC:
 	case REG_STAT:
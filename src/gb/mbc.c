@@ -56,6 +56,7 @@ void GBMBCSwitchBank(struct GB* gb, int bank) {
 	}
 	gb->memory.romBank = &gb->memory.rom[bankStart];
 	gb->memory.currentBank = bank;
+	GBMemoryRemapRom(gb);
 	if (gb->cpu->pc < GB_BASE_VRAM) {
 		gb->cpu->memory.setActiveRegion(gb->cpu, gb->cpu->pc);
 	}
@@ -68,6 +69,7 @@ void GBMBCSwitchBank0(struct GB* gb, int bank) {
 		bankStart &= (gb->memory.romSize - 1);
 	}
 	gb->memory.romBase = &gb->memory.rom[bankStart];
+	GBMemoryRemapRom(gb);
 	if (gb->cpu->pc < GB_SIZE_CART_BANK0) {
 		gb->cpu->memory.setActiveRegion(gb->cpu, gb->cpu->pc);
 	}
@@ -90,6 +92,7 @@ void GBMBCSwitchHalfBank(struct GB* gb, int half, int bank) {
 		gb->memory.mbcState.mbc6.romBank1 = &gb->memory.rom[bankStart];
 		gb->memory.mbcState.mbc6.currentBank1 = bank;
 	}
+	GBMemoryRemapRom(gb);
 	if (gb->cpu->pc < GB_BASE_VRAM) {
 		gb->cpu->memory.setActiveRegion(gb->cpu, gb->cpu->pc);
 	}
@@ -152,6 +155,7 @@ void GBMBCSwitchSramBank(struct GB* gb, int bank) {
 	}
 	gb->memory.sramBank = &gb->memory.sram[bankStart];
 	gb->memory.sramCurrentBank = bank;
+	GBMemoryRemapSram(gb);
 }
 
 void GBMBCSwitchSramHalfBank(struct GB* gb, int half, int bank) {
@@ -168,6 +172,7 @@ void GBMBCSwitchSramHalfBank(struct GB* gb, int half, int bank) {
 		gb->memory.mbcState.mbc6.sramBank1 = &gb->memory.sram[bankStart];
 		gb->memory.mbcState.mbc6.currentSramBank1 = bank;
 	}
+	GBMemoryRemapSram(gb);
 }
 
 void GBMBCInit(struct GB* gb) {
@@ -351,6 +356,7 @@ void GBMBCInit(struct GB* gb) {
 	gb->memory.activeRtcReg = 0;
 	gb->memory.rtcLatched = false;
 	gb->memory.rtcLastLatch = 0;
+	gb->memory.rtcSampled = false;
 	if (gb->memory.rtc) {
 		if (gb->memory.rtc->sample) {
 			gb->memory.rtc->sample(gb->memory.rtc);
@@ -362,22 +368,37 @@ void GBMBCInit(struct GB* gb) {
 	memset(&gb->memory.rtcRegs, 0, sizeof(gb->memory.rtcRegs));
 
 	GBResizeSram(gb, gb->sramSize);
+	GBMemoryRemapRom(gb);
 
 	if (gb->memory.mbcType == GB_MBC3_RTC) {
 		GBMBCRTCRead(gb);
 	}
 }
 
-static void _latchRtc(struct mRTCSource* rtc, uint8_t* rtcRegs, time_t* rtcLastLatch) {
-	time_t t;
-	if (rtc) {
-		if (rtc->sample) {
-			rtc->sample(rtc);
+static time_t _rtcTime(struct GB* gb) {
+	struct GBMemory* memory = &gb->memory;
+	if (!memory->rtcSampled) {
+		struct mRTCSource* rtc = memory->rtc;
+		if (rtc) {
+			if (rtc->sample) {
+				rtc->sample(rtc);
+			}
+			memory->rtcSampledTime = rtc->unixTime(rtc);
+		} else {
+			memory->rtcSampledTime = time(0);
 		}
-		t = rtc->unixTime(rtc);
-	} else {
-		t = time(0);
+		memory->rtcSampledCycle = mTimingCurrentTime(&gb->timing);
+		memory->rtcSampled = true;
 	}
+	uint32_t elapsed = mTimingCurrentTime(&gb->timing) - memory->rtcSampledCycle;
+	return memory->rtcSampledTime + elapsed / (DMG_SM83_FREQUENCY << gb->doubleSpeed);
+}
+
+void GBMBCRTCResample(struct GB* gb) {
+	gb->memory.rtcSampled = false;
+}
+
+static void _latchRtc(time_t t, uint8_t* rtcRegs, time_t* rtcLastLatch) {
 	time_t currentLatch = t;
 	t -= *rtcLastLatch;
 	*rtcLastLatch = currentLatch;
@@ -563,7 +584,7 @@ void _GBMBC3(struct GB* gb, uint16_t address, uint8_t value) {
 		if (memory->rtcLatched && value == 0) {
 			memory->rtcLatched = false;
 		} else if (!memory->rtcLatched && value == 1) {
-			_latchRtc(gb->memory.rtc, gb->memory.rtcRegs, &gb->memory.rtcLastLatch);
+			_latchRtc(_rtcTime(gb), gb->memory.rtcRegs, &gb->memory.rtcLastLatch);
 			memory->rtcLatched = true;
 		}
 		break;
@@ -1229,6 +1250,7 @@ void GBMBCRTCRead(struct GB* gb) {
 	if (!vf) {
 		return;
 	}
+	mSavedataFlusherWait(&gb->sramFlusher);
 	vf->seek(vf, gb->sramSize, SEEK_SET);
 	if (vf->read(vf, &rtcBuffer, sizeof(rtcBuffer)) < (ssize_t) sizeof(rtcBuffer) - 4) {
 		return;
@@ -1240,6 +1262,7 @@ void GBMBCRTCRead(struct GB* gb) {
 	LOAD_32LE(gb->memory.rtcRegs[3], 0, &rtcBuffer.latchedDays);
 	LOAD_32LE(gb->memory.rtcRegs[4], 0, &rtcBuffer.latchedDaysHi);
 	LOAD_64LE(gb->memory.rtcLastLatch, 0, &rtcBuffer.unixTime);
+	GBMBCRTCResample(gb);
 }
 
 void GBMBCRTCWrite(struct GB* gb) {
@@ -1247,11 +1270,14 @@ void GBMBCRTCWrite(struct GB* gb) {
 	if (!vf) {
 		return;
 	}
+	mSavedataFlusherWait(&gb->sramFlusher);
 
 	uint8_t rtcRegs[5];
 	memcpy(rtcRegs, gb->memory.rtcRegs, sizeof(rtcRegs));
 	time_t rtcLastLatch = gb->memory.rtcLastLatch;
-	_latchRtc(gb->memory.rtc, rtcRegs, &rtcLastLatch);
+	// Saves are rare enough to take the current host time
+	GBMBCRTCResample(gb);
+	_latchRtc(_rtcTime(gb), rtcRegs, &rtcLastLatch);
 
 	struct GBMBCRTCSaveBuffer rtcBuffer;
 	STORE_32LE(rtcRegs[0], 0, &rtcBuffer.sec);
@@ -10,9 +10,14 @@
 #include <mgba/internal/gb/io.h>
 #include <mgba/internal/gb/mbc.h>
 #include <mgba/internal/gb/serialize.h>
+#include <mgba/internal/sm83/decoder.h>
 #include <mgba/internal/sm83/sm83.h>
 
 #include <mgba-util/memory.h>
+#include <mgba-util/vfs.h>
+
+#define IDLE_LOOP_THRESHOLD 10000
+#define IDLE_LOOP_MAX_LENGTH 16
 
 mLOG_DEFINE_CATEGORY(GB_MEM, "GB Memory", "gb.memory");
 
@@ -59,9 +64,335 @@ static uint8_t GBFastLoad8(struct SM83Core* cpu, uint16_t address) {
 	return cpu->memory.activeRegion[address & cpu->memory.activeMask];
 }
 
+static void _idleSnapshot(const struct SM83Core* cpu, uint16_t* registers) {
+	registers[0] = cpu->af;
+	registers[1] = cpu->bc;
+	registers[2] = cpu->de;
+	registers[3] = cpu->hl;
+	registers[4] = cpu->sp;
+}
+
+static void _idleTaint(bool* tainted, unsigned reg) {
+	switch (reg) {
+	case SM83_REG_BC:
+		tainted[SM83_REG_B] = true;
+		tainted[SM83_REG_C] = true;
+		break;
+	case SM83_REG_DE:
+		tainted[SM83_REG_D] = true;
+		tainted[SM83_REG_E] = true;
+		break;
+	case SM83_REG_HL:
+		tainted[SM83_REG_H] = true;
+		tainted[SM83_REG_L] = true;
+		break;
+	case SM83_REG_AF:
+		tainted[SM83_REG_A] = true;
+		break;
+	default:
+		if (reg <= SM83_REG_A) {
+			tainted[reg] = true;
+		}
+		break;
+	}
+}
+
+static void _idleSetValue(uint8_t* values, bool* tainted, unsigned reg, uint16_t value) {
+	switch (reg) {
+	case SM83_REG_BC:
+	case SM83_REG_DE:
+	case SM83_REG_HL:
+		// B, C, D, E, H and L are enumerated in pair order
+		reg = SM83_REG_B + (reg - SM83_REG_BC) * 2;
+		values[reg] = value >> 8;
+		values[reg + 1] = value;
+		tainted[reg] = false;
+		tainted[reg + 1] = false;
+		break;
+	default:
+		if (reg <= SM83_REG_A) {
+			values[reg] = value;
+			tainted[reg] = false;
+		}
+		break;
+	}
+}
+
+static bool _idleResolveAddress(const uint8_t* values, const bool* tainted, const struct SM83Operand* op, uint16_t* address) {
+	switch (op->reg) {
+	case 0:
+		*address = op->immediate;
+		return true;
+	case SM83_REG_C:
+		// LDH A, (C)
+		*address = op->immediate + values[SM83_REG_C];
+		return !tainted[SM83_REG_C];
+	case SM83_REG_BC:
+		*address = (values[SM83_REG_B] << 8) | values[SM83_REG_C];
+		return !tainted[SM83_REG_B] && !tainted[SM83_REG_C];
+	case SM83_REG_DE:
+		*address = (values[SM83_REG_D] << 8) | values[SM83_REG_E];
+		return !tainted[SM83_REG_D] && !tainted[SM83_REG_E];
+	case SM83_REG_HL:
+		*address = (values[SM83_REG_H] << 8) | values[SM83_REG_L];
+		return !tainted[SM83_REG_H] && !tainted[SM83_REG_L];
+	default:
+		return false;
+	}
+}
+
+static bool _idleLoadIsStable(const struct GB* gb, uint16_t address) {
+	// Everything else only changes when the CPU writes it or an event fires
+	if (address >= GB_BASE_IO && address < GB_BASE_HRAM) {
+		address &= GB_SIZE_IO - 1;
+		return address != REG_JOYP && (address < REG_WAVE_0 || address > REG_WAVE_F);
+	}
+	if (address >= GB_BASE_EXTERNAL_RAM && address < GB_BASE_WORKING_RAM_BANK0) {
+		return !gb->memory.rtcAccess && !gb->memory.mbcRead;
+	}
+	return true;
+}
+
+static bool _idleCheckLoad(const struct GB* gb, const uint8_t* values, const bool* tainted, const struct SM83Operand* op, uint16_t* loads, int* nLoads, bool* fixed) {
+	uint16_t address;
+	if (!_idleResolveAddress(values, tainted, op, &address)) {
+		return false;
+	}
+	loads[*nLoads] = address;
+	++*nLoads;
+	if (op->reg) {
+		*fixed = false;
+	}
+	return _idleLoadIsStable(gb, address);
+}
+
+// Decodes the loop at address for the current registers, listing every address a pass loads from,
+// and whether that list would be the same for any registers
+static bool _idleDecodeLoop(const struct GB* gb, struct SM83Core* cpu, uint16_t address, uint16_t* loads, int* nLoads, bool* fixed) {
+	uint8_t values[SM83_REG_A + 1] = { 0, cpu->b, cpu->c, cpu->d, cpu->e, cpu->h, cpu->l, cpu->a };
+	bool tainted[SM83_REG_A + 1] = { false };
+	uint16_t pc = address;
+	int i;
+	*nLoads = 0;
+	*fixed = true;
+	for (i = 0; i < IDLE_LOOP_MAX_LENGTH; ++i) {
+		struct SM83InstructionInfo info;
+		memset(&info, 0, sizeof(info));
+		size_t bytesRemaining;
+		for (bytesRemaining = 1; bytesRemaining; --bytesRemaining) {
+			bytesRemaining += SM83Decode(GBView8(cpu, pc, -1), &info);
+			++pc;
+		}
+		if ((info.op1.flags | info.op2.flags) & (SM83_OP_FLAG_INCREMENT | SM83_OP_FLAG_DECREMENT)) {
+			return false;
+		}
+		if (info.op1.reg == SM83_REG_SP || info.op2.reg == SM83_REG_SP) {
+			return false;
+		}
+		switch (info.mnemonic) {
+		case SM83_MN_NOP:
+		case SM83_MN_CCF:
+		case SM83_MN_SCF:
+			break;
+		case SM83_MN_JP:
+		case SM83_MN_JR:
+			if (info.op1.reg) {
+				return false;
+			} else {
+				uint16_t target = info.op1.immediate;
+				if (info.mnemonic == SM83_MN_JR) {
+					target = pc + (int8_t) info.op1.immediate;
+				}
+				if (target == address) {
+					return true;
+				}
+				if (info.condition == SM83_COND_NONE || (target > address && target < pc)) {
+					return false;
+				}
+				// Conditional exits out of the loop don't affect it
+			}
+			break;
+		case SM83_MN_LD:
+			if (info.op1.flags & SM83_OP_FLAG_MEMORY) {
+				return false;
+			}
+			if (info.op2.flags & SM83_OP_FLAG_MEMORY) {
+				if (!_idleCheckLoad(gb, values, tainted, &info.op2, loads, nLoads, fixed)) {
+					return false;
+				}
+				_idleTaint(tainted, info.op1.reg);
+			} else if (!info.op2.reg) {
+				_idleSetValue(values, tainted, info.op1.reg, info.op2.immediate);
+			} else if (info.op2.reg <= SM83_REG_A && !tainted[info.op2.reg]) {
+				_idleSetValue(values, tainted, info.op1.reg, values[info.op2.reg]);
+			} else {
+				_idleTaint(tainted, info.op1.reg);
+			}
+			break;
+		case SM83_MN_ADC:
+		case SM83_MN_ADD:
+		case SM83_MN_AND:
+		case SM83_MN_CP:
+		case SM83_MN_OR:
+		case SM83_MN_SBC:
+		case SM83_MN_SUB:
+		case SM83_MN_XOR:
+			if (info.op1.flags & SM83_OP_FLAG_MEMORY && !_idleCheckLoad(gb, values, tainted, &info.op1, loads, nLoads, fixed)) {
+				return false;
+			}
+			if (info.op2.reg) {
+				// ADD HL, rr
+				_idleTaint(tainted, info.op1.reg);
+			} else if (info.mnemonic != SM83_MN_CP) {
+				_idleTaint(tainted, SM83_REG_A);
+			}
+			break;
+		case SM83_MN_BIT:
+			if (info.op2.flags & SM83_OP_FLAG_MEMORY && !_idleCheckLoad(gb, values, tainted, &info.op2, loads, nLoads, fixed)) {
+				return false;
+			}
+			break;
+		case SM83_MN_DEC:
+		case SM83_MN_INC:
+		case SM83_MN_RL:
+		case SM83_MN_RLC:
+		case SM83_MN_RR:
+		case SM83_MN_RRC:
+		case SM83_MN_SLA:
+		case SM83_MN_SRA:
+		case SM83_MN_SRL:
+		case SM83_MN_SWAP:
+			if (info.op1.flags & SM83_OP_FLAG_MEMORY) {
+				return false;
+			}
+			_idleTaint(tainted, info.op1.reg);
+			break;
+		case SM83_MN_RES:
+		case SM83_MN_SET:
+			if (info.op2.flags & SM83_OP_FLAG_MEMORY) {
+				return false;
+			}
+			_idleTaint(tainted, info.op2.reg);
+			break;
+		case SM83_MN_CPL:
+		case SM83_MN_DAA:
+			_idleTaint(tainted, SM83_REG_A);
+			break;
+		default:
+			return false;
+		}
+	}
+	return false;
+}
+
+static void _analyzeForIdleLoop(struct GB* gb, struct SM83Core* cpu, uint16_t address) {
+	uint16_t loads[GB_IDLE_LOADS];
+	int nLoads;
+	bool fixed;
+	gb->idleDetectionStep = -1;
+	if (_idleDecodeLoop(gb, cpu, address, loads, &nLoads, &fixed)) {
+		gb->idleLoop = address;
+		gb->idleOptimization = GB_IDLE_LOOP_REMOVE;
+		// The timer batches less once the loop can be skipped
+		GBTimerReschedule(&gb->timer);
+	}
+}
+
+static bool _idleRecordLoads(struct GB* gb, struct SM83Core* cpu, uint16_t address) {
+	if (gb->idleLoads < 0 || !gb->idleLoadsFixed) {
+		// Code anywhere else only changes when the CPU writes something, but VRAM and OAM can be blocked by events
+		bool stableCode = address < GB_BASE_VRAM || (address >= GB_BASE_WORKING_RAM_BANK0 && address < GB_BASE_OAM) || address >= GB_BASE_HRAM;
+		if (!stableCode || !_idleDecodeLoop(gb, cpu, address, gb->idleLoadAddresses, &gb->idleLoads, &gb->idleLoadsFixed)) {
+			// Not a loop this can follow, so only a pass between events can show it's still idle
+			gb->idleLoads = -1;
+			return false;
+		}
+	}
+	int i;
+	for (i = 0; i < gb->idleLoads; ++i) {
+		gb->idleLoadValues[i] = GBLoad8(cpu, gb->idleLoadAddresses[i]);
+	}
+	return true;
+}
+
+static bool _idleLoadsUnchanged(struct GB* gb, struct SM83Core* cpu) {
+	int i;
+	for (i = 0; i < gb->idleLoads; ++i) {
+		if (GBLoad8(cpu, gb->idleLoadAddresses[i]) != gb->idleLoadValues[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void _idleLoopCheck(struct GB* gb, struct SM83Core* cpu, uint16_t address) {
+	uint16_t registers[GB_IDLE_REGISTERS];
+	if (address == gb->idleLoop) {
+		_idleSnapshot(cpu, registers);
+		int32_t pass = 0;
+		if (!gb->idlePending) {
+			// Something was written since the last pass, maybe even the loop itself
+			gb->idleProven = false;
+			gb->idleLoads = -1;
+		} else if (memcmp(registers, gb->idleRegisters, sizeof(registers))) {
+			gb->idleProven = false;
+		} else if (gb->idleTimestamp == gb->timing.masterCycles) {
+			// The last pass had no side effects and nothing it read can change before the next event
+			pass = cpu->cycles - gb->idleCycles;
+			if (!gb->idleProven && gb->lastJump == address) {
+				gb->idlePass = pass;
+				gb->idleProven = _idleRecordLoads(gb, cpu, address);
+			}
+		} else if (gb->idleProven && cpu->nextEvent - cpu->cycles > gb->idlePass && !cpu->irqPending && !gb->memory.dmaRemaining) {
+			// Events landed during the last pass. If they left everything a known idle pass reads as it was,
+			// the next pass repeats it. Checking only pays off with room for a whole pass before the next event.
+			if (_idleLoadsUnchanged(gb, cpu)) {
+				pass = gb->idlePass;
+			} else {
+				gb->idleProven = false;
+			}
+		}
+		if (pass > 0 && cpu->cycles < cpu->nextEvent) {
+			// Only skip whole passes, so the next event still lands at the same point in the loop
+			cpu->cycles += (cpu->nextEvent - cpu->cycles - 1) / pass * pass;
+		}
+		memcpy(gb->idleRegisters, registers, sizeof(registers));
+		gb->idleTimestamp = gb->timing.masterCycles;
+		gb->idleCycles = cpu->cycles;
+		gb->idlePending = true;
+	} else if (gb->idleOptimization >= GB_IDLE_LOOP_DETECT) {
+		if (address == gb->lastJump) {
+			switch (gb->idleDetectionStep) {
+			case 0:
+				_idleSnapshot(cpu, gb->idleRegisters);
+				++gb->idleDetectionStep;
+				break;
+			case 1:
+				_idleSnapshot(cpu, registers);
+				if (memcmp(registers, gb->idleRegisters, sizeof(registers))) {
+					gb->idleDetectionStep = -1;
+					++gb->idleDetectionFailures;
+					if (gb->idleDetectionFailures > IDLE_LOOP_THRESHOLD) {
+						gb->idleOptimization = GB_IDLE_LOOP_IGNORE;
+					}
+					break;
+				}
+				_analyzeForIdleLoop(gb, cpu, address);
+				break;
+			}
+		} else {
+			gb->idleDetectionStep = 0;
+		}
+	}
+	gb->lastJump = address;
+}
+
 static void GBSetActiveRegion(struct SM83Core* cpu, uint16_t address) {
 	struct GB* gb = (struct GB*) cpu->master;
 	struct GBMemory* memory = &gb->memory;
+	if (gb->idleOptimization >= GB_IDLE_LOOP_REMOVE) {
+		_idleLoopCheck(gb, cpu, address);
+	}
 	switch (address >> 12) {
 	case GB_REGION_CART_BANK0:
 	case GB_REGION_CART_BANK0 + 1:
@@ -126,6 +457,26 @@ static void GBSetActiveRegion(struct SM83Core* cpu, uint16_t address) {
 static void _GBMemoryDMAService(struct mTiming* timing, void* context, uint32_t cyclesLate);
 static void _GBMemoryHDMAService(struct mTiming* timing, void* context, uint32_t cyclesLate);
 
+#define GB_PAGE_SHIFT 8
+#define GB_PAGE_MASK ((1 << GB_PAGE_SHIFT) - 1)
+
+static void _mapPages(struct GBMemory* memory, uint16_t base, size_t size, uint8_t* host, bool writable) {
+	size_t page = base >> GB_PAGE_SHIFT;
+	size_t end = page + (size >> GB_PAGE_SHIFT);
+	for (; page < end; ++page, host = host ? host + (1 << GB_PAGE_SHIFT) : NULL) {
+		memory->readPages[page] = host;
+		memory->writePages[page] = writable ? host : NULL;
+	}
+}
+
+static void _remapWram(struct GBMemory* memory) {
+	_mapPages(memory, GB_BASE_WORKING_RAM_BANK0, GB_SIZE_WORKING_RAM_BANK0, memory->wram, true);
+	_mapPages(memory, GB_BASE_WORKING_RAM_BANK1, GB_SIZE_WORKING_RAM_BANK0, memory->wramBank, true);
+	// Echo RAM mirrors WRAM up to OAM
+	_mapPages(memory, GB_BASE_WORKING_RAM_BANK0 + 0x2000, GB_SIZE_WORKING_RAM_BANK0, memory->wram, true);
+	_mapPages(memory, GB_BASE_WORKING_RAM_BANK1 + 0x2000, GB_BASE_OAM - GB_BASE_WORKING_RAM_BANK1 - 0x2000, memory->wramBank, true);
+}
+
 void GBMemoryInit(struct GB* gb) {
 	struct SM83Core* cpu = gb->cpu;
 	cpu->memory.cpuLoad8 = GBLoad8;
@@ -134,7 +485,11 @@ void GBMemoryInit(struct GB* gb) {
 	cpu->memory.currentSegment = GBCurrentSegment;
 	cpu->memory.setActiveRegion = GBSetActiveRegion;
 
+	gb->memory.arena = anonymousMemoryMap(GB_ARENA_SIZE);
 	gb->memory.wram = 0;
+	if (gb->memory.arena) {
+		gb->memory.wram = &gb->memory.arena[GB_ARENA_WRAM];
+	}
 	gb->memory.wramBank = 0;
 	gb->memory.rom = 0;
 	gb->memory.romBank = 0;
@@ -149,11 +504,16 @@ void GBMemoryInit(struct GB* gb) {
 	gb->memory.rumble = NULL;
 	gb->memory.cam = NULL;
 
+	memset(gb->memory.readPages, 0, sizeof(gb->memory.readPages));
+	memset(gb->memory.writePages, 0, sizeof(gb->memory.writePages));
+
 	GBIOInit(gb);
 }
 
 void GBMemoryDeinit(struct GB* gb) {
-	mappedMemoryFree(gb->memory.wram, GB_SIZE_WORKING_RAM);
+	mappedMemoryFree(gb->memory.arena, GB_ARENA_SIZE);
+	gb->memory.arena = 0;
+	gb->memory.wram = 0;
 	if (gb->memory.rom) {
 		mappedMemoryFree(gb->memory.rom, gb->memory.romSize);
 	}
@@ -161,10 +521,9 @@ void GBMemoryDeinit(struct GB* gb) {
 
 void GBMemoryReset(struct GB* gb) {
 	if (gb->memory.wram) {
-		mappedMemoryFree(gb->memory.wram, GB_SIZE_WORKING_RAM);
+		memset(gb->memory.wram, 0, GB_SIZE_WORKING_RAM);
 	}
-	gb->memory.wram = anonymousMemoryMap(GB_SIZE_WORKING_RAM);
-	if (gb->model >= GB_MODEL_CGB) {
+	if (gb->memory.wram && gb->model >= GB_MODEL_CGB) {
 		uint32_t* base = (uint32_t*) gb->memory.wram;
 		size_t i;
 		uint32_t pattern = 0;
@@ -227,6 +586,8 @@ void GBMemoryReset(struct GB* gb) {
 		break;
 	}
 	gb->memory.sramBank = gb->memory.sram;
+	gb->memory.dirtyTracked = false;
+	GBMemoryRemap(gb);
 
 	if (!gb->memory.wram) {
 		GBMemoryDeinit(gb);
@@ -240,11 +601,54 @@ void GBMemorySwitchWramBank(struct GBMemory* memory, int bank) {
 	}
 	memory->wramBank = &memory->wram[GB_SIZE_WORKING_RAM_BANK0 * bank];
 	memory->wramCurrentBank = bank;
+	_remapWram(memory);
+}
+
+void GBMemoryRemap(struct GB* gb) {
+	GBMemoryRemapRom(gb);
+	GBMemoryRemapVram(gb);
+	GBMemoryRemapSram(gb);
+	_remapWram(&gb->memory);
+}
+
+void GBMemoryRemapRom(struct GB* gb) {
+	struct GBMemory* memory = &gb->memory;
+	_mapPages(memory, GB_BASE_CART_BANK0, GB_SIZE_CART_BANK0, memory->romBase, false);
+	if (memory->mbcType == GB_MBC6) {
+		_mapPages(memory, GB_BASE_CART_HALFBANK1, GB_SIZE_CART_HALFBANK, memory->romBank, false);
+		_mapPages(memory, GB_BASE_CART_HALFBANK2, GB_SIZE_CART_HALFBANK, memory->mbcState.mbc6.romBank1, false);
+	} else {
+		_mapPages(memory, GB_BASE_CART_BANK1, GB_SIZE_CART_BANK0, memory->romBank, false);
+	}
+	// Reads past the end of a small ROM are open bus
+	size_t page;
+	for (page = memory->romSize >> GB_PAGE_SHIFT; page < GB_BASE_VRAM >> GB_PAGE_SHIFT; ++page) {
+		memory->readPages[page] = NULL;
+	}
+}
+
+void GBMemoryRemapSram(struct GB* gb) {
+	struct GBMemory* memory = &gb->memory;
+	uint8_t* sramBank = NULL;
+	if (memory->sramAccess && !memory->rtcAccess && !memory->mbcRead && memory->sram &&
+	    memory->sramBank >= memory->sram && memory->sramBank + GB_SIZE_EXTERNAL_RAM <= memory->sram + gb->sramSize) {
+		sramBank = memory->sramBank;
+	}
+	_mapPages(memory, GB_BASE_EXTERNAL_RAM, GB_SIZE_EXTERNAL_RAM, sramBank, false);
+}
+
+void GBMemoryRemapVram(struct GB* gb) {
+	// VRAM is locked away from the CPU while mode 3 is drawing
+	_mapPages(&gb->memory, GB_BASE_VRAM, GB_SIZE_VRAM_BANK0, gb->video.mode != 3 ? gb->video.vramBank : NULL, false);
 }
 
 uint8_t GBLoad8(struct SM83Core* cpu, uint16_t address) {
 	struct GB* gb = (struct GB*) cpu->master;
 	struct GBMemory* memory = &gb->memory;
+	const uint8_t* page = memory->readPages[address >> GB_PAGE_SHIFT];
+	if (page && !memory->dmaRemaining) {
+		return page[address & GB_PAGE_MASK];
+	}
 	if (gb->memory.dmaRemaining) {
 		const enum GBBus* block = gb->model < GB_MODEL_CGB ? _oamBlockDMG : _oamBlockCGB;
 		enum GBBus dmaBus = block[memory->dmaSource >> 13];
@@ -286,8 +690,10 @@ uint8_t GBLoad8(struct SM83Core* cpu, uint16_t address) {
 	case GB_REGION_EXTERNAL_RAM:
 	case GB_REGION_EXTERNAL_RAM + 1:
 		if (memory->rtcAccess) {
+			gb->idlePending = false;
 			return memory->rtcRegs[memory->activeRtcReg];
 		} else if (memory->mbcRead) {
+			gb->idlePending = false;
 			return memory->mbcRead(memory, address);
 		} else if (memory->sramAccess && memory->sram) {
 			return memory->sramBank[address & (GB_SIZE_EXTERNAL_RAM - 1)];
@@ -324,9 +730,20 @@ uint8_t GBLoad8(struct SM83Core* cpu, uint16_t address) {
 	}
 }
 
+#define DIRTY_WRAM(OFFSET) mStatePageMark(memory->dirtyWram, OFFSET)
+#define DIRTY_WRAM_BANK DIRTY_WRAM((memory->wramBank - memory->wram) + (address & (GB_SIZE_WORKING_RAM_BANK0 - 1)))
+#define DIRTY_VRAM(OFFSET) mStatePageMark(memory->dirtyVram, OFFSET)
+
 void GBStore8(struct SM83Core* cpu, uint16_t address, int8_t value) {
 	struct GB* gb = (struct GB*) cpu->master;
 	struct GBMemory* memory = &gb->memory;
+	gb->idlePending = false;
+	uint8_t* page = memory->writePages[address >> GB_PAGE_SHIFT];
+	if (page && !memory->dmaRemaining) {
+		page[address & GB_PAGE_MASK] = value;
+		DIRTY_WRAM(&page[address & GB_PAGE_MASK] - memory->wram);
+		return;
+	}
 	if (gb->memory.dmaRemaining) {
 		const enum GBBus* block = gb->model < GB_MODEL_CGB ? _oamBlockDMG : _oamBlockCGB;
 		enum GBBus dmaBus = block[memory->dmaSource >> 13];
@@ -348,6 +765,7 @@ void GBStore8(struct SM83Core* cpu, uint16_t address, int8_t value) {
 	case GB_REGION_CART_BANK1 + 2:
 	case GB_REGION_CART_BANK1 + 3:
 		memory->mbcWrite(gb, address, value);
+		GBMemoryRemapSram(gb);
 		cpu->memory.setActiveRegion(cpu, cpu->pc);
 		return;
 	case GB_REGION_VRAM:
@@ -355,6 +773,7 @@ void GBStore8(struct SM83Core* cpu, uint16_t address, int8_t value) {
 		if (gb->video.mode != 3) {
 			gb->video.renderer->writeVRAM(gb->video.renderer, (address & (GB_SIZE_VRAM_BANK0 - 1)) | (GB_SIZE_VRAM_BANK0 * gb->video.vramCurrentBank));
 			gb->video.vramBank[address & (GB_SIZE_VRAM_BANK0 - 1)] = value;
+			DIRTY_VRAM((address & (GB_SIZE_VRAM_BANK0 - 1)) | (GB_SIZE_VRAM_BANK0 * gb->video.vramCurrentBank));
 		}
 		return;
 	case GB_REGION_EXTERNAL_RAM:
@@ -365,19 +784,23 @@ void GBStore8(struct SM83Core* cpu, uint16_t address, int8_t value) {
 			memory->sramBank[address & (GB_SIZE_EXTERNAL_RAM - 1)] = value;
 		} else {
 			memory->mbcWrite(gb, address, value);
+			GBMemoryRemapSram(gb);
 		}
-		gb->sramDirty |= GB_SRAM_DIRT_NEW;
+		mSavedataFlusherMarkDirty(&gb->sramFlusher);
 		return;
 	case GB_REGION_WORKING_RAM_BANK0:
 	case GB_REGION_WORKING_RAM_BANK0 + 2:
 		memory->wram[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)] = value;
+		DIRTY_WRAM(address & (GB_SIZE_WORKING_RAM_BANK0 - 1));
 		return;
 	case GB_REGION_WORKING_RAM_BANK1:
 		memory->wramBank[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)] = value;
+		DIRTY_WRAM_BANK;
 		return;
 	default:
 		if (address < GB_BASE_OAM) {
 			memory->wramBank[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)] = value;
+			DIRTY_WRAM_BANK;
 		} else if (address < GB_BASE_UNUSABLE) {
 			if (gb->video.mode < 2) {
 				gb->video.oam.raw[address & 0xFF] = value;
@@ -560,10 +983,38 @@ uint8_t GBMemoryWriteHDMA5(struct GB* gb, uint8_t value) {
 	return value & 0x7F;
 }
 
+static bool _canBatchDMA(struct GB* gb, uint16_t source, int length) {
+	if (gb->accurateDma) {
+		return false;
+	}
+	// Only plain memory reads the same no matter when it's read; VRAM depends on the PPU mode
+	if (!gb->memory.readPages[source >> GB_PAGE_SHIFT] || (source >= GB_BASE_VRAM && source < GB_BASE_EXTERNAL_RAM)) {
+		return false;
+	}
+	return (source & GB_PAGE_MASK) + length <= GB_PAGE_MASK + 1;
+}
+
 void _GBMemoryDMAService(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	struct GB* gb = context;
 	int dmaRemaining = gb->memory.dmaRemaining;
 	gb->memory.dmaRemaining = 0;
+	// The PPU only looks at OAM outside of vblank, so a transfer that ends before then can be copied at once.
+	// The last byte is still left to its own event so the bus stays blocked for as long as it should.
+	if (dmaRemaining > 1 && _canBatchDMA(gb, gb->memory.dmaSource, dmaRemaining) &&
+	    (!GBRegisterLCDCIsEnable(gb->memory.io[REG_LCDC]) || (gb->video.mode == 1 && gb->video.ly < GB_VIDEO_VERTICAL_TOTAL_PIXELS - 3))) {
+		const uint8_t* page = gb->memory.readPages[gb->memory.dmaSource >> GB_PAGE_SHIFT];
+		int count = dmaRemaining - 1;
+		int i;
+		for (i = 0; i < count; ++i) {
+			gb->video.oam.raw[gb->memory.dmaDest] = page[gb->memory.dmaSource & GB_PAGE_MASK];
+			gb->video.renderer->writeOAM(gb->video.renderer, gb->memory.dmaDest);
+			++gb->memory.dmaSource;
+			++gb->memory.dmaDest;
+		}
+		gb->memory.dmaRemaining = 1;
+		mTimingSchedule(timing, &gb->memory.dmaEvent, 4 * count - cyclesLate);
+		return;
+	}
 	uint8_t b = GBLoad8(gb->cpu, gb->memory.dmaSource);
 	// TODO: Can DMA write OAM during modes 2-3?
 	gb->video.oam.raw[gb->memory.dmaDest] = b;
@@ -579,6 +1030,21 @@ void _GBMemoryDMAService(struct mTiming* timing, void* context, uint32_t cyclesL
 void _GBMemoryHDMAService(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	struct GB* gb = context;
 	gb->cpuBlocked = true;
+	// At the start of a block, copy all but its last byte at once if the PPU won't change modes before it ends
+	if (!(gb->memory.hdmaRemaining & 0xF) && _canBatchDMA(gb, gb->memory.hdmaSource, 0x10) &&
+	    (!GBRegisterLCDCIsEnable(gb->memory.io[REG_LCDC]) || mTimingUntil(timing, &gb->video.modeEvent) > 0xF * 2)) {
+		int i;
+		for (i = 0; i < 0xF; ++i) {
+			uint8_t b = gb->cpu->memory.load8(gb->cpu, gb->memory.hdmaSource);
+			gb->cpu->memory.store8(gb->cpu, gb->memory.hdmaDest, b);
+			++gb->memory.hdmaSource;
+			++gb->memory.hdmaDest;
+		}
+		gb->memory.hdmaRemaining -= 0xF;
+		mTimingDeschedule(timing, &gb->memory.hdmaEvent);
+		mTimingSchedule(timing, &gb->memory.hdmaEvent, 0xF * 2 - cyclesLate);
+		return;
+	}
 	uint8_t b = gb->cpu->memory.load8(gb->cpu, gb->memory.hdmaSource);
 	gb->cpu->memory.store8(gb->cpu, gb->memory.hdmaDest, b);
 	++gb->memory.hdmaSource;
@@ -638,10 +1104,12 @@ void GBPatch8(struct SM83Core* cpu, uint16_t address, int8_t value, int8_t* old,
 		if (segment < 0) {
 			oldValue = gb->video.vramBank[address & (GB_SIZE_VRAM_BANK0 - 1)];
 			gb->video.vramBank[address & (GB_SIZE_VRAM_BANK0 - 1)] = value;
+			DIRTY_VRAM((address & (GB_SIZE_VRAM_BANK0 - 1)) + GB_SIZE_VRAM_BANK0 * gb->video.vramCurrentBank);
 			gb->video.renderer->writeVRAM(gb->video.renderer, (address & (GB_SIZE_VRAM_BANK0 - 1)) + GB_SIZE_VRAM_BANK0 * gb->video.vramCurrentBank);
 		} else if (segment < 2) {
 			oldValue = gb->video.vram[(address & (GB_SIZE_VRAM_BANK0 - 1)) + segment * GB_SIZE_VRAM_BANK0];
 			gb->video.vramBank[(address & (GB_SIZE_VRAM_BANK0 - 1)) + segment * GB_SIZE_VRAM_BANK0] = value;
+			DIRTY_VRAM((address & (GB_SIZE_VRAM_BANK0 - 1)) + segment * GB_SIZE_VRAM_BANK0);
 			gb->video.renderer->writeVRAM(gb->video.renderer, (address & (GB_SIZE_VRAM_BANK0 - 1)) + segment * GB_SIZE_VRAM_BANK0);
 		} else {
 			return;
@@ -657,20 +1125,23 @@ void GBPatch8(struct SM83Core* cpu, uint16_t address, int8_t value, int8_t* old,
 		} else {
 			memory->mbcWrite(gb, address, value);
 		}
-		gb->sramDirty |= GB_SRAM_DIRT_NEW;
+		mSavedataFlusherMarkDirty(&gb->sramFlusher);
 		return;
 	case GB_REGION_WORKING_RAM_BANK0:
 	case GB_REGION_WORKING_RAM_BANK0 + 2:
 		oldValue = memory->wram[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)];
 		memory->wram[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)] = value;
+		DIRTY_WRAM(address & (GB_SIZE_WORKING_RAM_BANK0 - 1));
 		break;
 	case GB_REGION_WORKING_RAM_BANK1:
 		if (segment < 0) {
 			oldValue = memory->wramBank[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)];
 			memory->wramBank[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)] = value;
+			DIRTY_WRAM_BANK;
 		} else if (segment < 8) {
 			oldValue = memory->wram[(address & (GB_SIZE_WORKING_RAM_BANK0 - 1)) + segment * GB_SIZE_WORKING_RAM_BANK0];
 			memory->wram[(address & (GB_SIZE_WORKING_RAM_BANK0 - 1)) + segment * GB_SIZE_WORKING_RAM_BANK0] = value;
+			DIRTY_WRAM((address & (GB_SIZE_WORKING_RAM_BANK0 - 1)) + segment * GB_SIZE_WORKING_RAM_BANK0);
 		} else {
 			return;
 		}
@@ -679,6 +1150,7 @@ void GBPatch8(struct SM83Core* cpu, uint16_t address, int8_t value, int8_t* old,
 		if (address < GB_BASE_OAM) {
 			oldValue = memory->wramBank[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)];
 			memory->wramBank[address & (GB_SIZE_WORKING_RAM_BANK0 - 1)] = value;
+			DIRTY_WRAM_BANK;
 		} else if (address < GB_BASE_UNUSABLE) {
 			oldValue = gb->video.oam.raw[address & 0xFF];
 			gb->video.oam.raw[address & 0xFF] = value;
@@ -836,9 +1308,16 @@ void _pristineCow(struct GB* gb) {
 	if (!gb->isPristine) {
 		return;
 	}
-	void* newRom = anonymousMemoryMap(GB_SIZE_CART_MAX);
-	memcpy(newRom, gb->memory.rom, gb->memory.romSize);
-	memset(((uint8_t*) newRom) + gb->memory.romSize, 0xFF, GB_SIZE_CART_MAX - gb->memory.romSize);
+	void* newRom = NULL;
+	if (gb->romVf) {
+		// Only the pages that actually get written are copied out of the file
+		newRom = VFileMapCopyOnWrite(gb->romVf, gb->memory.romSize, GB_SIZE_CART_MAX);
+	}
+	if (!newRom) {
+		newRom = anonymousMemoryMap(GB_SIZE_CART_MAX);
+		memcpy(newRom, gb->memory.rom, gb->memory.romSize);
+		memset(((uint8_t*) newRom) + gb->memory.romSize, 0xFF, GB_SIZE_CART_MAX - gb->memory.romSize);
+	}
 	if (gb->memory.rom == gb->memory.romBase) {
 		gb->memory.romBase = newRom;
 	}
@@ -491,45 +491,111 @@ static const struct GBCartridgeOverride _colorOverrides[] = {
 
 static const struct GBCartridgeOverride _overrides[] = {
 	// Pokemon Spaceworld 1997 demo
-	{ 0x232a067d, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 } }, // Gold (debug)
-	{ 0x630ed957, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 } }, // Gold (non-debug)
-	{ 0x5aff0038, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 } }, // Silver (debug)
-	{ 0xa61856bd, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 } }, // Silver (non-debug)
+	{ 0x232a067d, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 }, GB_IDLE_LOOP_NONE }, // Gold (debug)
+	{ 0x630ed957, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 }, GB_IDLE_LOOP_NONE }, // Gold (non-debug)
+	{ 0x5aff0038, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 }, GB_IDLE_LOOP_NONE }, // Silver (debug)
+	{ 0xa61856bd, GB_MODEL_AUTODETECT, GB_MBC3_RTC, { 0 }, GB_IDLE_LOOP_NONE }, // Silver (non-debug)
 
 	{ 0, 0, 0, { 0 } }
 };
 
-bool GBOverrideColorFind(struct GBCartridgeOverride* override) {
+// Open-addressed indices into the tables above by header CRC, holding entry numbers plus one.
+// Each is built by whichever lookup gets there first; lookups that find it unfinished scan the
+// table instead.
+#define OVERRIDE_INDEX_BITS 9
+#define OVERRIDE_INDEX_SIZE (1 << OVERRIDE_INDEX_BITS)
+
+enum {
+	OVERRIDE_INDEX_UNBUILT = 0,
+	OVERRIDE_INDEX_BUILDING,
+	OVERRIDE_INDEX_READY
+};
+
+struct GBOverrideIndex {
+	const struct GBCartridgeOverride* table;
+	int state;
+	uint16_t slots[OVERRIDE_INDEX_SIZE];
+};
+
+static struct GBOverrideIndex _colorOverrideIndex = { .table = _colorOverrides };
+static struct GBOverrideIndex _overrideIndex = { .table = _overrides };
+
+static unsigned _overrideSlot(int headerCrc32) {
+	return ((uint32_t) headerCrc32 * 0x9E3779B1U) >> (32 - OVERRIDE_INDEX_BITS);
+}
+
+static void _overrideIndexBuild(struct GBOverrideIndex* index) {
+	int state = OVERRIDE_INDEX_UNBUILT;
+	if (!ATOMIC_CMPXCHG(index->state, state, OVERRIDE_INDEX_BUILDING)) {
+		return;
+	}
+	int i;
+	for (i = 0; index->table[i].headerCrc32; ++i) {
+		unsigned slot = _overrideSlot(index->table[i].headerCrc32);
+		// Earlier entries stay earlier along the probe, so duplicates resolve like a scan would
+		while (index->slots[slot]) {
+			slot = (slot + 1) & (OVERRIDE_INDEX_SIZE - 1);
+		}
+		index->slots[slot] = i + 1;
+	}
+	ATOMIC_STORE(index->state, OVERRIDE_INDEX_READY);
+}
+
+static const struct GBCartridgeOverride* _overrideLookup(struct GBOverrideIndex* index, int headerCrc32) {
+	int state;
+	ATOMIC_LOAD(state, index->state);
+	if (state == OVERRIDE_INDEX_UNBUILT) {
+		_overrideIndexBuild(index);
+		ATOMIC_LOAD(state, index->state);
+	}
+	if (state == OVERRIDE_INDEX_READY) {
+		unsigned slot = _overrideSlot(headerCrc32);
+		for (; index->slots[slot]; slot = (slot + 1) & (OVERRIDE_INDEX_SIZE - 1)) {
+			const struct GBCartridgeOverride* override = &index->table[index->slots[slot] - 1];
+			if (override->headerCrc32 == headerCrc32) {
+				return override;
+			}
+		}
+		return NULL;
+	}
 	int i;
-	for (i = 0; _colorOverrides[i].headerCrc32; ++i) {
-		if (override->headerCrc32 == _colorOverrides[i].headerCrc32) {
-			memcpy(override->gbColors, _colorOverrides[i].gbColors, sizeof(override->gbColors));
-			return true;
+	for (i = 0; index->table[i].headerCrc32; ++i) {
+		if (index->table[i].headerCrc32 == headerCrc32) {
+			return &index->table[i];
 		}
 	}
-	return false;
+	return NULL;
+}
+
+bool GBOverrideColorFind(struct GBCartridgeOverride* override) {
+	const struct GBCartridgeOverride* builtin = _overrideLookup(&_colorOverrideIndex, override->headerCrc32);
+	if (!builtin) {
+		return false;
+	}
+	memcpy(override->gbColors, builtin->gbColors, sizeof(override->gbColors));
+	return true;
 }
 
 bool GBOverrideFind(const struct Configuration* config, struct GBCartridgeOverride* override) {
 	override->model = GB_MODEL_AUTODETECT;
 	override->mbc = GB_MBC_AUTODETECT;
 	memset(override->gbColors, 0, sizeof(override->gbColors));
+	override->idleLoop = GB_IDLE_LOOP_NONE;
 	bool found = false;
 
-	int i;
-	for (i = 0; _overrides[i].headerCrc32; ++i) {
-		if (override->headerCrc32 == _overrides[i].headerCrc32) {
-			*override = _overrides[i];
-			found = true;
-			break;
-		}
+	const struct GBCartridgeOverride* builtin = _overrideLookup(&_overrideIndex, override->headerCrc32);
+	if (builtin) {
+		*override = *builtin;
+		found = true;
 	}
 
 	if (config) {
+		int i;
 		char sectionName[24] = "";
 		snprintf(sectionName, sizeof(sectionName), "gb.override.%08X", override->headerCrc32);
 		const char* model = ConfigurationGetValue(config, sectionName, "model");
 		const char* mbc = ConfigurationGetValue(config, sectionName, "mbc");
+		const char* idleLoop = ConfigurationGetValue(config, sectionName, "idleLoop");
 		const char* pal[12] = {
 			ConfigurationGetValue(config, sectionName, "pal[0]"),
 			ConfigurationGetValue(config, sectionName, "pal[1]"),
@@ -559,6 +625,15 @@ bool GBOverrideFind(const struct Configuration* config, struct GBCartridgeOverri
 			}
 		}
 
+		if (idleLoop) {
+			char* end;
+			uint32_t address = strtoul(idleLoop, &end, 16);
+			if (end && !*end) {
+				override->idleLoop = address;
+				found = true;
+			}
+		}
+
 		for (i = 0; i < 12; ++i) {
 			if (!pal[i]) {
 				continue;
@@ -632,6 +707,14 @@ void GBOverrideSave(struct Configuration* config, const struct GBCartridgeOverri
 	} else {
 		ConfigurationClearValue(config, sectionName, "mbc");
 	}
+
+	if (override->idleLoop != GB_IDLE_LOOP_NONE) {
+		char idleLoop[9];
+		snprintf(idleLoop, sizeof(idleLoop), "%04X", override->idleLoop);
+		ConfigurationSetValue(config, sectionName, "idleLoop", idleLoop);
+	} else {
+		ConfigurationClearValue(config, sectionName, "idleLoop");
+	}
 }
 
 void GBOverrideApply(struct GB* gb, const struct GBCartridgeOverride* override) {
@@ -644,6 +727,13 @@ void GBOverrideApply(struct GB* gb, const struct GBCartridgeOverride* override)
 		GBMBCInit(gb);
 	}
 
+	if (override->idleLoop != GB_IDLE_LOOP_NONE) {
+		gb->idleLoop = override->idleLoop;
+		if (gb->idleOptimization == GB_IDLE_LOOP_DETECT) {
+			gb->idleOptimization = GB_IDLE_LOOP_REMOVE;
+		}
+	}
+
 	int i;
 	for (i = 0; i < 12; ++i) {
 		if (!(override->gbColors[i] & 0xFF000000)) {
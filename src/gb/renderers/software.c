@@ -21,6 +21,7 @@ static void GBVideoSoftwareRendererWriteOAM(struct GBVideoRenderer* renderer, ui
 static void GBVideoSoftwareRendererDrawRange(struct GBVideoRenderer* renderer, int startX, int endX, int y, struct GBObj* obj, size_t oamMax);
 static void GBVideoSoftwareRendererFinishScanline(struct GBVideoRenderer* renderer, int y);
 static void GBVideoSoftwareRendererFinishFrame(struct GBVideoRenderer* renderer);
+static void GBVideoSoftwareRendererSkipFrame(struct GBVideoRenderer* renderer);
 static void GBVideoSoftwareRendererEnableSGBBorder(struct GBVideoRenderer* renderer, bool enable);
 static void GBVideoSoftwareRendererGetPixels(struct GBVideoRenderer* renderer, size_t* stride, const void** pixels);
 static void GBVideoSoftwareRendererPutPixels(struct GBVideoRenderer* renderer, size_t stride, const void* pixels);
@@ -28,6 +29,65 @@ static void GBVideoSoftwareRendererPutPixels(struct GBVideoRenderer* renderer, s
 static void GBVideoSoftwareRendererDrawBackground(struct GBVideoSoftwareRenderer* renderer, uint8_t* maps, int startX, int endX, int sx, int sy);
 static void GBVideoSoftwareRendererDrawObj(struct GBVideoSoftwareRenderer* renderer, struct GBObj* obj, int startX, int endX, int y);
 
+// One bitplane byte spread over eight pixel bytes, leftmost pixel first, plus the same for flipped tiles.
+// Only ever accessed bytewise through memcpy, so the layout doesn't depend on host endianness.
+static uint64_t _bitplane[2][256];
+static bool _bitplaneInit = false;
+
+static void _initBitplane(void) {
+	if (_bitplaneInit) {
+		return;
+	}
+	int i;
+	for (i = 0; i < 256; ++i) {
+		uint8_t pixels[8];
+		uint8_t flipped[8];
+		int x;
+		for (x = 0; x < 8; ++x) {
+			pixels[x] = (i >> (7 - x)) & 1;
+			flipped[x] = (i >> x) & 1;
+		}
+		memcpy(&_bitplane[0][i], pixels, sizeof(pixels));
+		memcpy(&_bitplane[1][i], flipped, sizeof(flipped));
+	}
+	_bitplaneInit = true;
+}
+
+// The Game Boy Player's darker take on each BGR555 color, so that palette writes in that model are
+// a lookup rather than three squares and divides. Only built once a renderer is set up for it.
+static color_t _agbColors[0x8000];
+static bool _agbColorsInit = false;
+
+static void _initAGBColors(void) {
+	if (_agbColorsInit) {
+		return;
+	}
+	unsigned value;
+	for (value = 0; value < 0x8000; ++value) {
+		unsigned r = M_R5(value);
+		unsigned g = M_G5(value);
+		unsigned b = M_B5(value);
+		r = r * r;
+		g = g * g;
+		b = b * b;
+#ifdef COLOR_16_BIT
+		r /= 31;
+		g /= 31;
+		b /= 31;
+		_agbColors[value] = mColorFrom555(r | (g << 5) | (b << 10));
+#else
+		r >>= 2;
+		r += r >> 4;
+		g >>= 2;
+		g += g >> 4;
+		b >>= 2;
+		b += b >> 4;
+		_agbColors[value] = r | (g << 8) | (b << 16);
+#endif
+	}
+	_agbColorsInit = true;
+}
+
 static void _clearScreen(struct GBVideoSoftwareRenderer* renderer) {
 	size_t sgbOffset = 0;
 	if (renderer->model & GB_MODEL_SGB) {
@@ -46,13 +106,10 @@ static void _clearScreen(struct GBVideoSoftwareRenderer* renderer) {
 	}
 }
 
-static void _regenerateSGBBorder(struct GBVideoSoftwareRenderer* renderer) {
+#define SGB_BORDER_TRANSPARENT 0xFF
+
+static void _rasterizeSGBBorder(struct GBVideoSoftwareRenderer* renderer) {
 	int i;
-	for (i = 0; i < 0x40; ++i) {
-		uint16_t color;
-		LOAD_16LE(color, 0x800 + i * 2, renderer->d.sgbMapRam);
-		renderer->d.writePalette(&renderer->d, i + 0x40, color);
-	}
 	int x, y;
 	for (y = 0; y < 224; ++y) {
 		for (x = 0; x < 256; x += 8) {
@@ -61,7 +118,9 @@ static void _regenerateSGBBorder(struct GBVideoSoftwareRenderer* renderer) {
 			}
 			uint16_t mapData;
 			LOAD_16LE(mapData, (x >> 2) + (y & ~7) * 8, renderer->d.sgbMapRam);
+			uint8_t* border = &renderer->sgbBorder[y * 256 + x];
 			if (UNLIKELY(SGBBgAttributesGetTile(mapData) >= 0x100)) {
+				memset(border, SGB_BORDER_TRANSPARENT, 8);
 				continue;
 			}
 
@@ -75,7 +134,6 @@ static void _regenerateSGBBorder(struct GBVideoSoftwareRenderer* renderer) {
 			tileData[2] = renderer->d.sgbCharRam[(SGBBgAttributesGetTile(mapData) * 16 + localY) * 2 + 0x10];
 			tileData[3] = renderer->d.sgbCharRam[(SGBBgAttributesGetTile(mapData) * 16 + localY) * 2 + 0x11];
 
-			size_t base = y * renderer->outputBufferStride + x;
 			int paletteBase = SGBBgAttributesGetPalette(mapData) * 0x10;
 			int colorSelector;
 
@@ -85,7 +143,37 @@ static void _regenerateSGBBorder(struct GBVideoSoftwareRenderer* renderer) {
 			}
 			for (i = 7; i >= 0; --i) {
 				colorSelector = (tileData[0] >> i & 0x1) << 0 | (tileData[1] >> i & 0x1) << 1 | (tileData[2] >> i & 0x1) << 2 | (tileData[3] >> i & 0x1) << 3;
-				renderer->outputBuffer[(base + 7 - i) ^ flip] = renderer->palette[paletteBase | colorSelector];
+				border[(7 - i) ^ flip] = paletteBase | colorSelector;
+			}
+		}
+	}
+}
+
+static void _regenerateSGBBorder(struct GBVideoSoftwareRenderer* renderer) {
+	int i;
+	for (i = 0; i < 0x40; ++i) {
+		uint16_t color;
+		LOAD_16LE(color, 0x800 + i * 2, renderer->d.sgbMapRam);
+		renderer->d.writePalette(&renderer->d, i + 0x40, color);
+	}
+	if (!renderer->sgbBorder) {
+		return;
+	}
+	if (renderer->sgbBorderDirty) {
+		_rasterizeSGBBorder(renderer);
+		renderer->sgbBorderDirty = false;
+	}
+	int x, y;
+	for (y = 0; y < 224; ++y) {
+		const uint8_t* border = &renderer->sgbBorder[y * 256];
+		color_t* row = &renderer->outputBuffer[y * renderer->outputBufferStride];
+		for (x = 0; x < 256; ++x) {
+			if (x == 48 && y >= 40 && y < 184) {
+				x = 207;
+				continue;
+			}
+			if (border[x] != SGB_BORDER_TRANSPARENT) {
+				row[x] = renderer->palette[border[x]];
 			}
 		}
 	}
@@ -172,6 +260,7 @@ void GBVideoSoftwareRendererCreate(struct GBVideoSoftwareRenderer* renderer) {
 	renderer->d.drawRange = GBVideoSoftwareRendererDrawRange;
 	renderer->d.finishScanline = GBVideoSoftwareRendererFinishScanline;
 	renderer->d.finishFrame = GBVideoSoftwareRendererFinishFrame;
+	renderer->d.skipFrame = GBVideoSoftwareRendererSkipFrame;
 	renderer->d.enableSGBBorder = GBVideoSoftwareRendererEnableSGBBorder;
 	renderer->d.getPixels = GBVideoSoftwareRendererGetPixels;
 	renderer->d.putPixels = GBVideoSoftwareRendererPutPixels;
@@ -181,6 +270,28 @@ void GBVideoSoftwareRendererCreate(struct GBVideoSoftwareRenderer* renderer) {
 	renderer->d.disableWIN = false;
 
 	renderer->temporaryBuffer = 0;
+	renderer->colorTable = NULL;
+	renderer->convertRow = NULL;
+	renderer->sgbBorder = NULL;
+
+	_initBitplane();
+}
+
+void GBVideoSoftwareRendererSetColorTable(struct GBVideoSoftwareRenderer* renderer, const color_t* table, const uint16_t* palette) {
+	if (renderer->colorTable == table) {
+		return;
+	}
+	renderer->colorTable = table;
+	if (!palette) {
+		return;
+	}
+	int i;
+	for (i = 0; i < 64; ++i) {
+		renderer->d.writePalette(&renderer->d, i, palette[i]);
+	}
+	if (renderer->model & GB_MODEL_SGB && renderer->sgbBorders && !renderer->d.sgbRenderMode && renderer->d.sgbMapRam) {
+		_regenerateSGBBorder(renderer);
+	}
 }
 
 static void GBVideoSoftwareRendererInit(struct GBVideoRenderer* renderer, enum GBModel model, bool sgbBorders) {
@@ -196,6 +307,9 @@ static void GBVideoSoftwareRendererInit(struct GBVideoRenderer* renderer, enum G
 	softwareRenderer->hasWindow = false;
 	softwareRenderer->wx = 0;
 	softwareRenderer->model = model;
+	if (model == GB_MODEL_AGB) {
+		_initAGBColors();
+	}
 	softwareRenderer->sgbTransfer = 0;
 	softwareRenderer->sgbCommandHeader = 0;
 	softwareRenderer->sgbBorders = sgbBorders;
@@ -206,6 +320,11 @@ static void GBVideoSoftwareRendererInit(struct GBVideoRenderer* renderer, enum G
 	softwareRenderer->offsetWx = 0;
 	softwareRenderer->offsetWy = 0;
 
+	if (model & GB_MODEL_SGB && !softwareRenderer->sgbBorder) {
+		softwareRenderer->sgbBorder = anonymousMemoryMap(256 * 224);
+	}
+	softwareRenderer->sgbBorderDirty = true;
+
 	int i;
 	for (i = 0; i < 64; ++i) {
 		softwareRenderer->lookup[i] = i;
@@ -219,7 +338,10 @@ static void GBVideoSoftwareRendererInit(struct GBVideoRenderer* renderer, enum G
 
 static void GBVideoSoftwareRendererDeinit(struct GBVideoRenderer* renderer) {
 	struct GBVideoSoftwareRenderer* softwareRenderer = (struct GBVideoSoftwareRenderer*) renderer;
-	UNUSED(softwareRenderer);
+	if (softwareRenderer->sgbBorder) {
+		mappedMemoryFree(softwareRenderer->sgbBorder, 256 * 224);
+		softwareRenderer->sgbBorder = NULL;
+	}
 }
 
 static void GBVideoSoftwareRendererUpdateWindow(struct GBVideoSoftwareRenderer* renderer, bool before, bool after, uint8_t oldWy) {
@@ -430,6 +552,8 @@ static void GBVideoSoftwareRendererWriteSGBPacket(struct GBVideoRenderer* render
 		break;
 	case SGB_ATRC_EN:
 	case SGB_MASK_EN:
+		// Also sent after a state is loaded, which replaces the border data wholesale
+		softwareRenderer->sgbBorderDirty = true;
 		if (softwareRenderer->sgbBorders && !renderer->sgbRenderMode) {
 			_regenerateSGBBorder(softwareRenderer);
 		}
@@ -439,38 +563,27 @@ static void GBVideoSoftwareRendererWriteSGBPacket(struct GBVideoRenderer* render
 static void GBVideoSoftwareRendererWritePalette(struct GBVideoRenderer* renderer, int index, uint16_t value) {
 	struct GBVideoSoftwareRenderer* softwareRenderer = (struct GBVideoSoftwareRenderer*) renderer;
 	color_t color = mColorFrom555(value);
+	bool shared = false;
 	if (softwareRenderer->model & GB_MODEL_SGB) {
 		if (index < 0x10 && index && !(index & 3)) {
 			color = softwareRenderer->palette[0];
+			shared = true;
 		} else if (index >= 0x40 && !(index & 0xF)) {
 			color = softwareRenderer->palette[0];
+			shared = true;
 		}
 	}
 	if (renderer->cache) {
 		mCacheSetWritePalette(renderer->cache, index, color);
 	}
-	if (softwareRenderer->model == GB_MODEL_AGB) {
-		unsigned r = M_R5(value);
-		unsigned g = M_G5(value);
-		unsigned b = M_B5(value);
-		r = r * r;
-		g = g * g;
-		b = b * b;
-#ifdef COLOR_16_BIT
-		r /= 31;
-		g /= 31;
-		b /= 31;
-		color = mColorFrom555(r | (g << 5) | (b << 10));
-#else
-		r >>= 2;
-		r += r >> 4;
-		g >>= 2;
-		g += g >> 4;
-		b >>= 2;
-		b += b >> 4;
-		color = r | (g << 8) | (b << 16);
-#endif
+	if (softwareRenderer->colorTable) {
+		if (!shared) {
+			color = softwareRenderer->colorTable[value & 0x7FFF];
+		}
+	} else if (softwareRenderer->model == GB_MODEL_AGB) {
+		color = _agbColors[value & 0x7FFF];
 	}
+	color_t oldColor = softwareRenderer->palette[index];
 	softwareRenderer->palette[index] = color;
 
 	if (softwareRenderer->model & GB_MODEL_SGB && !index && GBRegisterLCDCIsEnable(softwareRenderer->lcdc)) {
@@ -481,7 +594,7 @@ static void GBVideoSoftwareRendererWritePalette(struct GBVideoRenderer* renderer
 		renderer->writePalette(renderer, 0x50, value);
 		renderer->writePalette(renderer, 0x60, value);
 		renderer->writePalette(renderer, 0x70, value);
-		if (softwareRenderer->sgbBorders && !renderer->sgbRenderMode) {
+		if (oldColor != color && softwareRenderer->sgbBorders && !renderer->sgbRenderMode) {
 			_regenerateSGBBorder(softwareRenderer);
 		}
 	}
@@ -643,9 +756,11 @@ static void GBVideoSoftwareRendererFinishScanline(struct GBVideoRenderer* render
 			break;
 		case SGB_CHR_TRN:
 			buffer = &renderer->sgbCharRam[SGB_SIZE_CHAR_RAM / 2 * (softwareRenderer->sgbPacket[1] & 1)];
+			softwareRenderer->sgbBorderDirty = true;
 			break;
 		case SGB_PCT_TRN:
 			buffer = renderer->sgbMapRam;
+			softwareRenderer->sgbBorderDirty = true;
 			break;
 		case SGB_ATTR_TRN:
 			buffer = renderer->sgbAttributeFiles;
@@ -684,16 +799,23 @@ static void GBVideoSoftwareRendererFinishScanline(struct GBVideoRenderer* render
 	}
 }
 
-static void GBVideoSoftwareRendererFinishFrame(struct GBVideoRenderer* renderer) {
-	struct GBVideoSoftwareRenderer* softwareRenderer = (struct GBVideoSoftwareRenderer*) renderer;
-
-	if (softwareRenderer->temporaryBuffer) {
-		mappedMemoryFree(softwareRenderer->temporaryBuffer, GB_VIDEO_HORIZONTAL_PIXELS * GB_VIDEO_VERTICAL_PIXELS * 4);
-		softwareRenderer->temporaryBuffer = 0;
+// Done once the frame is finished, borders included, so that the drawing paths stay in color_t
+static void _convertFrame(struct GBVideoSoftwareRenderer* softwareRenderer) {
+	unsigned width = GB_VIDEO_HORIZONTAL_PIXELS;
+	unsigned height = GB_VIDEO_VERTICAL_PIXELS;
+	if (softwareRenderer->model & GB_MODEL_SGB && softwareRenderer->sgbBorders) {
+		width = 256;
+		height = 224;
 	}
-	if (!GBRegisterLCDCIsEnable(softwareRenderer->lcdc)) {
-		_clearScreen(softwareRenderer);
+	uint8_t* output = softwareRenderer->convertBuffer;
+	unsigned y;
+	for (y = 0; y < height; ++y) {
+		softwareRenderer->convertRow(&output[softwareRenderer->convertStride * y * softwareRenderer->convertBytes], &softwareRenderer->outputBuffer[softwareRenderer->outputBufferStride * y], width);
 	}
+}
+
+static void _endFrame(struct GBVideoSoftwareRenderer* softwareRenderer, bool drawn) {
+	struct GBVideoRenderer* renderer = &softwareRenderer->d;
 	if (softwareRenderer->model & GB_MODEL_SGB) {
 		switch (softwareRenderer->sgbCommandHeader >> 3) {
 		case SGB_PAL_SET:
@@ -707,7 +829,7 @@ static void GBVideoSoftwareRendererFinishFrame(struct GBVideoRenderer* renderer)
 		case SGB_PCT_TRN:
 		case SGB_ATRC_EN:
 		case SGB_MASK_EN:
-			if (softwareRenderer->sgbBorders && !renderer->sgbRenderMode) {
+			if (drawn && softwareRenderer->sgbBorders && !renderer->sgbRenderMode) {
 				// Make sure every buffer sees this if we're multibuffering
 				_regenerateSGBBorder(softwareRenderer);
 			}
@@ -729,6 +851,27 @@ static void GBVideoSoftwareRendererFinishFrame(struct GBVideoRenderer* renderer)
 	softwareRenderer->hasWindow = false;
 }
 
+static void GBVideoSoftwareRendererFinishFrame(struct GBVideoRenderer* renderer) {
+	struct GBVideoSoftwareRenderer* softwareRenderer = (struct GBVideoSoftwareRenderer*) renderer;
+
+	if (softwareRenderer->temporaryBuffer) {
+		mappedMemoryFree(softwareRenderer->temporaryBuffer, GB_VIDEO_HORIZONTAL_PIXELS * GB_VIDEO_VERTICAL_PIXELS * 4);
+		softwareRenderer->temporaryBuffer = 0;
+	}
+	if (!GBRegisterLCDCIsEnable(softwareRenderer->lcdc)) {
+		_clearScreen(softwareRenderer);
+	}
+	_endFrame(softwareRenderer, true);
+	if (softwareRenderer->convertRow) {
+		_convertFrame(softwareRenderer);
+	}
+}
+
+static void GBVideoSoftwareRendererSkipFrame(struct GBVideoRenderer* renderer) {
+	// Nothing was drawn, so the output buffer keeps the last frame that was
+	_endFrame((struct GBVideoSoftwareRenderer*) renderer, false);
+}
+
 static void GBVideoSoftwareRendererEnableSGBBorder(struct GBVideoRenderer* renderer, bool enable) {
 	struct GBVideoSoftwareRenderer* softwareRenderer = (struct GBVideoSoftwareRenderer*) renderer;
 	if (softwareRenderer->model & GB_MODEL_SGB) {
@@ -803,6 +946,7 @@ static void GBVideoSoftwareRendererDrawBackground(struct GBVideoSoftwareRenderer
 			bgTile = ((int8_t*) maps)[topX + topY];
 		}
 		int p = 0;
+		int flip = 0;
 		if (renderer->model >= GB_MODEL_CGB) {
 			GBObjAttributes attrs = attr[topX + topY];
 			p = GBObjAttributesGetCGBPalette(attrs) * 4;
@@ -815,30 +959,14 @@ static void GBVideoSoftwareRendererDrawBackground(struct GBVideoSoftwareRenderer
 			if (GBObjAttributesIsYFlip(attrs)) {
 				localY = 7 - bottomY;
 			}
-			if (GBObjAttributesIsXFlip(attrs)) {
-				uint8_t tileDataLower = localData[(bgTile * 8 + localY) * 2];
-				uint8_t tileDataUpper = localData[(bgTile * 8 + localY) * 2 + 1];
-				renderer->row[x + 0] = p | ((tileDataUpper & 1) << 1) | (tileDataLower & 1);
-				renderer->row[x + 1] = p | (tileDataUpper & 2) | ((tileDataLower & 2) >> 1);
-				renderer->row[x + 2] = p | ((tileDataUpper & 4) >> 1) | ((tileDataLower & 4) >> 2);
-				renderer->row[x + 3] = p | ((tileDataUpper & 8) >> 2) | ((tileDataLower & 8) >> 3);
-				renderer->row[x + 4] = p | ((tileDataUpper & 16) >> 3) | ((tileDataLower & 16) >> 4);
-				renderer->row[x + 5] = p | ((tileDataUpper & 32) >> 4) | ((tileDataLower & 32) >> 5);
-				renderer->row[x + 6] = p | ((tileDataUpper & 64) >> 5) | ((tileDataLower & 64) >> 6);
-				renderer->row[x + 7] = p | ((tileDataUpper & 128) >> 6) | ((tileDataLower & 128) >> 7);
-				continue;
-			}
+			// The accessor hands back the raw attribute bit, which has to be 0 or 1 to index the table
+			flip = GBObjAttributesIsXFlip(attrs) ? 1 : 0;
 		}
 		uint8_t tileDataLower = localData[(bgTile * 8 + localY) * 2];
 		uint8_t tileDataUpper = localData[(bgTile * 8 + localY) * 2 + 1];
-		renderer->row[x + 7] = p | ((tileDataUpper & 1) << 1) | (tileDataLower & 1);
-		renderer->row[x + 6] = p | (tileDataUpper & 2) | ((tileDataLower & 2) >> 1);
-		renderer->row[x + 5] = p | ((tileDataUpper & 4) >> 1) | ((tileDataLower & 4) >> 2);
-		renderer->row[x + 4] = p | ((tileDataUpper & 8) >> 2) | ((tileDataLower & 8) >> 3);
-		renderer->row[x + 3] = p | ((tileDataUpper & 16) >> 3) | ((tileDataLower & 16) >> 4);
-		renderer->row[x + 2] = p | ((tileDataUpper & 32) >> 4) | ((tileDataLower & 32) >> 5);
-		renderer->row[x + 1] = p | ((tileDataUpper & 64) >> 5) | ((tileDataLower & 64) >> 6);
-		renderer->row[x + 0] = p | ((tileDataUpper & 128) >> 6) | ((tileDataLower & 128) >> 7);
+		// Each pixel byte holds at most 1, so shifting the upper plane can't carry into its neighbor
+		uint64_t pixels = _bitplane[flip][tileDataLower] | (_bitplane[flip][tileDataUpper] << 1) | (p * 0x0101010101010101ULL);
+		memcpy(&renderer->row[x], &pixels, sizeof(pixels));
 	}
 }
 
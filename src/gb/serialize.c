@@ -6,9 +6,11 @@
 #include <mgba/internal/gb/serialize.h>
 
 #include <mgba/internal/gb/io.h>
+#include <mgba/internal/gb/mbc.h>
 #include <mgba/internal/gb/timer.h>
 #include <mgba/internal/sm83/sm83.h>
 
+#include <mgba-util/hash.h>
 #include <mgba-util/memory.h>
 
 mLOG_DEFINE_CATEGORY(GB_STATE, "GB Savestate", "gb.serialize");
@@ -58,10 +60,12 @@ void GBSerialize(struct GB* gb, struct GBSerializedState* state) {
 	STORE_32LE(flags, 0, &state->cpu.flags);
 	STORE_32LE(gb->eiPending.when - mTimingCurrentTime(&gb->timing), 0, &state->cpu.eiPending);
 
+	GBTimerUpdateRegisters(&gb->timer);
 	GBMemorySerialize(gb, state);
 	GBIOSerialize(gb, state);
 	GBVideoSerialize(&gb->video, state);
 	GBTimerSerialize(&gb->timer, state);
+	GBAudioRun(&gb->audio, mTimingSettledTime(&gb->timing));
 	GBAudioSerialize(&gb->audio, state);
 
 	if (gb->model & GB_MODEL_SGB) {
@@ -175,7 +179,7 @@ bool GBDeserialize(struct GB* gb, const struct GBSerializedState* state) {
 
 	LOAD_32LE(gb->cpu->cycles, 0, &state->cpu.cycles);
 	LOAD_32LE(gb->cpu->nextEvent, 0, &state->cpu.nextEvent);
-	gb->timing.root = NULL;
+	mTimingEventHeapClear(&gb->timing.events);
 
 	uint32_t when;
 	LOAD_32LE(when, 0, &state->cpu.eiPending);
@@ -193,8 +197,10 @@ bool GBDeserialize(struct GB* gb, const struct GBSerializedState* state) {
 
 	GBMemoryDeserialize(gb, state);
 	GBVideoDeserialize(&gb->video, state);
+	gb->memory.dirtyTracked = false;
 	GBIODeserialize(gb, state);
 	GBTimerDeserialize(&gb->timer, state);
+	GBMBCRTCResample(gb);
 	GBAudioDeserialize(&gb->audio, state);
 
 	if (gb->memory.io[0x50] == 0xFF) {
@@ -207,14 +213,60 @@ bool GBDeserialize(struct GB* gb, const struct GBSerializedState* state) {
 		GBSGBDeserialize(gb, state);
 	}
 
+	GBMemoryRemap(gb);
 	gb->cpu->memory.setActiveRegion(gb->cpu, gb->cpu->pc);
 
-	gb->timing.reroot = gb->timing.root;
-	gb->timing.root = NULL;
+	mTimingInterrupt(&gb->timing);
 
 	return true;
 }
 
+bool GBCollectDirtyState(struct GB* gb, uint32_t* pages, size_t size) {
+	if (size < sizeof(struct GBSerializedState)) {
+		return false;
+	}
+	struct GBMemory* memory = &gb->memory;
+	memset(pages, 0, M_STATE_PAGE_WORDS(size) * sizeof(*pages));
+	if (!memory->dirtyTracked) {
+		mStatePagesMarkRange(pages, 0, size);
+		memset(memory->dirtyWram, 0, sizeof(memory->dirtyWram));
+		memset(memory->dirtyVram, 0, sizeof(memory->dirtyVram));
+		memory->dirtyTracked = true;
+		return true;
+	}
+	mStatePagesMarkRange(pages, 0, offsetof(struct GBSerializedState, vram));
+	mStatePagesMarkRange(pages, offsetof(struct GBSerializedState, vram) + GB_SIZE_VRAM, offsetof(struct GBSerializedState, wram));
+	mStatePagesMarkRange(pages, offsetof(struct GBSerializedState, wram) + GB_SIZE_WORKING_RAM, size);
+	mStatePagesCollect(pages, offsetof(struct GBSerializedState, vram), memory->dirtyVram, GB_SIZE_VRAM);
+	mStatePagesCollect(pages, offsetof(struct GBSerializedState, wram), memory->dirtyWram, GB_SIZE_WORKING_RAM);
+	return true;
+}
+
+uint64_t GBStateHash(struct GB* gb) {
+	struct SM83Core* cpu = gb->cpu;
+	uint16_t regs[6 + 4];
+	STORE_16LE(cpu->af, 0, regs);
+	STORE_16LE(cpu->bc, 2, regs);
+	STORE_16LE(cpu->de, 4, regs);
+	STORE_16LE(cpu->hl, 6, regs);
+	STORE_16LE(cpu->sp, 8, regs);
+	STORE_16LE(cpu->pc, 10, regs);
+	STORE_32LE(mTimingCurrentTime(&gb->timing), 12, regs);
+	STORE_32LE(gb->video.frameCounter, 16, regs);
+
+	uint64_t hash = hash64(regs, sizeof(regs), 0);
+	hash = hash64(gb->memory.io, GB_SIZE_IO, hash);
+	hash = hash64(gb->memory.hram, GB_SIZE_HRAM, hash);
+	hash = hash64(gb->video.palette, sizeof(gb->video.palette), hash);
+	hash = hash64(gb->video.oam.raw, GB_SIZE_OAM, hash);
+	hash = hash64(gb->video.vram, GB_SIZE_VRAM, hash);
+	hash = hash64(gb->memory.wram, GB_SIZE_WORKING_RAM, hash);
+	if (gb->memory.sram && gb->sramSize) {
+		hash = hash64(gb->memory.sram, gb->sramSize, hash);
+	}
+	return hash;
+}
+
 // TODO: Reorganize SGB into its own file
 void GBSGBSerialize(struct GB* gb, struct GBSerializedState* state) {
 	state->sgb.command = gb->video.sgbCommandHeader;
@@ -22,6 +22,7 @@ void GBSIOLockstepInit(struct GBSIOLockstep* lockstep) {
 	lockstep->pendingSB[0] = 0xFF;
 	lockstep->pendingSB[1] = 0xFF;
 	lockstep->masterClaimed = false;
+	lockstep->idleWindow = 0;
 }
 
 void GBSIOLockstepNodeCreate(struct GBSIOLockstepNode* node) {
@@ -70,6 +71,7 @@ bool GBSIOLockstepNodeInit(struct GBSIODriver* driver) {
 
 	node->nextEvent = 0;
 	node->eventDiff = 0;
+	node->increment = LOCKSTEP_INCREMENT;
 	mTimingSchedule(&driver->p->p->timing, &node->event, 0);
 #ifndef NDEBUG
 	node->phase = node->p->d.transferActive;
@@ -91,6 +93,10 @@ static void _finishTransfer(struct GBSIOLockstepNode* node) {
 	struct GBSIO* sio = node->d.p;
 	sio->pendingSB = node->p->pendingSB[!node->id];
 	if (GBRegisterSCIsEnable(sio->p->memory.io[REG_SC])) {
+		if (!GBRegisterSCIsShiftClock(sio->p->memory.io[REG_SC])) {
+			// The external clock shifts at whatever speed the master picked, including CGB fast mode
+			ATOMIC_LOAD(sio->period, node->p->d.transferCycles);
+		}
 		sio->remainingBits = 8;
 		mTimingDeschedule(&sio->p->timing, &sio->event);
 		mTimingSchedule(&sio->p->timing, &sio->event, 0);
@@ -111,11 +117,19 @@ static int32_t _masterUpdate(struct GBSIOLockstepNode* node) {
 	switch (transferActive) {
 	case TRANSFER_IDLE:
 		// If the master hasn't initiated a transfer, it can keep going.
-		node->nextEvent += LOCKSTEP_INCREMENT;
+		// Starting one brings the next update forward, so the wait can keep growing until then.
+		node->nextEvent += node->increment;
+		if (node->increment < node->p->idleWindow) {
+			node->increment *= 2;
+			if (node->increment > node->p->idleWindow) {
+				node->increment = node->p->idleWindow;
+			}
+		}
 		break;
 	case TRANSFER_STARTING:
 		// Start the transfer, but wait for the other GBs to catch up
 		node->transferFinished = false;
+		node->increment = LOCKSTEP_INCREMENT;
 		needsToWait = true;
 		ATOMIC_STORE(node->p->d.transferActive, TRANSFER_STARTED);
 		node->nextEvent += 4;
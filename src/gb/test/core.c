@@ -5,9 +5,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include "util/test/suite.h"
 
+#include <mgba/core/batch.h>
 #include <mgba/core/core.h>
 #include <mgba/gb/core.h>
 #include <mgba/internal/gb/gb.h>
+#include <mgba/internal/gb/io.h>
+#include <mgba/internal/gb/overrides.h>
+#include <mgba/internal/gb/renderers/software.h>
+#include <mgba/internal/sm83/sm83.h>
 #include <mgba-util/vfs.h>
 
 M_TEST_DEFINE(create) {
@@ -59,9 +64,248 @@ M_TEST_DEFINE(isROM) {
 	core->deinit(core);
 }
 
+M_TEST_DEFINE(identifyROM) {
+	struct VFile* vf = VFileMemChunk(NULL, 0x8000);
+	GBSynthesizeROM(vf);
+	vf->seek(vf, 0x134, SEEK_SET);
+	vf->write(vf, "IDENTIFY", 8);
+	vf->seek(vf, 0x4000, SEEK_SET);
+	vf->write(vf, "DATA", 4);
+
+	struct mCoreROMInfo info;
+	assert_true(mCoreIdentifyVF(vf, &info));
+	assert_int_equal(info.platform, PLATFORM_GB);
+	assert_int_equal(info.size, 0x8000);
+
+	struct mCore* core = mCoreFindVF(vf);
+	assert_non_null(core);
+	assert_true(core->init(core));
+	assert_true(core->loadROM(core, vf));
+	char title[17] = {0};
+	char code[9] = {0};
+	uint32_t crc32;
+	core->getGameTitle(core, title);
+	core->getGameCode(core, code);
+	core->checksum(core, &crc32, CHECKSUM_CRC32);
+	assert_string_equal(info.title, title);
+	assert_string_equal(info.code, code);
+	assert_int_equal(info.crc32, crc32);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(batch) {
+	struct VFile* vf = VFileMemChunk(NULL, 0x8000);
+	GBSynthesizeROM(vf);
+	struct mCoreBatch batch;
+	assert_true(mCoreBatchInit(&batch, vf, 4, 2));
+	assert_null(mCoreBatchGetCore(&batch, 4));
+
+	struct mCore* core = mCoreBatchGetCore(&batch, 0);
+	unsigned width, height;
+	core->desiredVideoDimensions(core, &width, &height);
+	size_t size = width * height;
+	color_t* buffer = malloc(size * 4 * sizeof(*buffer));
+	memset(buffer, 0x55, size * 4 * sizeof(*buffer));
+	mCoreBatchSetVideoBuffers(&batch, buffer, width);
+	mCoreBatchReset(&batch);
+	mCoreBatchSetRendering(&batch, 2, false);
+
+	uint32_t keys[4] = { 0, 1, 2, 3 };
+	int i;
+	for (i = 0; i < 10; ++i) {
+		mCoreBatchRunFrame(&batch, keys);
+	}
+	for (i = 0; i < 4; ++i) {
+		core = mCoreBatchGetCore(&batch, i);
+		assert_int_equal(core->frameCounter(core), 10);
+	}
+	assert_memory_equal(buffer, &buffer[size], size * sizeof(*buffer));
+	assert_int_equal(buffer[size * 2], 0x55555555);
+
+	mCoreBatchSetRendering(&batch, 2, true);
+	mCoreBatchRunFrame(&batch, NULL);
+	assert_memory_equal(buffer, &buffer[size * 2], size * sizeof(*buffer));
+
+	mCoreBatchDeinit(&batch);
+	free(buffer);
+}
+
+M_TEST_DEFINE(lazyTimer) {
+	struct VFile* vf = VFileMemChunk(NULL, 0x8000);
+	GBSynthesizeROM(vf);
+	struct mCore* core = GBCoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	assert_true(core->loadROM(core, vf));
+	core->reset(core);
+	struct GB* gb = core->board;
+
+	GBIOWrite(gb, REG_TMA, 0x80);
+	GBIOWrite(gb, REG_TAC, 0x05);
+	GBIOWrite(gb, REG_TIMA, 0xF0);
+	gb->memory.io[REG_IF] = 0;
+
+	// TIMA ticks every 16 cycles, but nothing runs until it overflows
+	int32_t until = mTimingUntil(&gb->timing, &gb->timer.event);
+	assert_in_range(until, 0xF0, 0x100);
+
+	uint8_t div = GBIORead(gb, REG_DIV);
+	gb->cpu->cycles += 0x80;
+	assert_in_range(GBIORead(gb, REG_TIMA), 0xF7, 0xF8);
+	assert_in_range(GBIORead(gb, REG_DIV), div, div + 1);
+	assert_int_equal(mTimingUntil(&gb->timing, &gb->timer.event), until - 0x80);
+
+	gb->cpu->cycles += until - 0x80;
+	gb->cpu->irqh.processEvents(gb->cpu);
+	assert_int_equal(GBIORead(gb, REG_TIMA), 0);
+	gb->cpu->cycles += 8;
+	gb->cpu->irqh.processEvents(gb->cpu);
+	assert_true(gb->memory.io[REG_IF] & (1 << GB_IRQ_TIMER));
+	assert_int_equal(GBIORead(gb, REG_TIMA), 0x80);
+
+	// Reloading from TMA moves the next overflow out accordingly
+	until = mTimingUntil(&gb->timing, &gb->timer.event);
+	assert_in_range(until, 0x7F0 - 0x10, 0x800);
+
+	// Once an idle loop can be skipped, every TIMA tick gets an event to skip to
+	gb->idleLoop = 0x150;
+	GBTimerReschedule(&gb->timer);
+	assert_in_range(mTimingUntil(&gb->timing, &gb->timer.event), 1, 0x10);
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+// Waits for a line, then for HBlank, then for the timer IRQ handler to bump a WRAM counter, writing
+// BGP and NR51 after each wait so the point where every loop exits shows up in the output
+static const uint8_t _idleTimingCode[] = {
+	0x3E, 0x80, 0xE0, 0x26, // ld a, $80; ldh [NR52], a
+	0x3E, 0x80, 0xE0, 0x11, // ld a, $80; ldh [NR11], a
+	0x3E, 0xF0, 0xE0, 0x12, // ld a, $F0; ldh [NR12], a
+	0x3E, 0x87, 0xE0, 0x14, // ld a, $87; ldh [NR14], a
+	0x3E, 0x04, 0xE0, 0x07, // ld a, $04; ldh [TAC], a
+	0x3E, 0x04, 0xE0, 0xFF, // ld a, $04; ldh [IE], a
+	0xFB, // ei
+	0x0E, 0x00, // ld c, 0
+	0x06, 0x03, // ld b, 3
+	0xF0, 0x44, // line: ldh a, [LY]
+	0xB8, // cp b
+	0x20, 0xFB, // jr nz, line
+	0x79, 0xE0, 0x47, 0x0C, // ld a, c; ldh [BGP], a; inc c
+	0xF0, 0x41, // hblank: ldh a, [STAT]
+	0xE6, 0x03, // and 3
+	0x20, 0xFA, // jr nz, hblank
+	0x79, 0xE0, 0x47, 0x0C, // ld a, c; ldh [BGP], a; inc c
+	0xFA, 0x00, 0xC0, // ld a, [$C000]
+	0x57, // ld d, a
+	0xFA, 0x00, 0xC0, // timer: ld a, [$C000]
+	0xBA, // cp d
+	0x28, 0xFA, // jr z, timer
+	0x79, 0xE0, 0x25, 0x0C, // ld a, c; ldh [NR51], a; inc c
+	0x78, 0xC6, 0x07, // ld a, b; add 7
+	0xFE, 0x9A, // cp 154
+	0x38, 0x02, // jr c, next
+	0xD6, 0x9A, // sub 154
+	0x47, // next: ld b, a
+	0x18, 0xD3, // jr line
+};
+
+static const uint8_t _idleTimingHandler[] = {
+	0xF5, // push af
+	0xFA, 0x00, 0xC0, 0x3C, 0xEA, 0x00, 0xC0, // ld a, [$C000]; inc a; ld [$C000], a
+	0xE0, 0x42, // ldh [SCY], a
+	0xF1, // pop af
+	0xD9, // reti
+};
+
+static struct mCore* _idleTimingCore(enum GBIdleLoopOptimization optimization) {
+	static const uint8_t entry[] = { 0x00, 0xC3, 0x50, 0x01 };
+	struct VFile* vf = VFileMemChunk(NULL, 0x8000);
+	GBSynthesizeROM(vf);
+	vf->seek(vf, 0x50, SEEK_SET);
+	vf->write(vf, _idleTimingHandler, sizeof(_idleTimingHandler));
+	vf->seek(vf, 0x100, SEEK_SET);
+	vf->write(vf, entry, sizeof(entry));
+	vf->seek(vf, 0x150, SEEK_SET);
+	vf->write(vf, _idleTimingCode, sizeof(_idleTimingCode));
+
+	struct mCore* core = GBCoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	assert_true(core->loadROM(core, vf));
+	core->reset(core);
+	struct GB* gb = core->board;
+	gb->idleOptimization = optimization;
+	return core;
+}
+
+M_TEST_DEFINE(idleTiming) {
+	static const int registers[] = { REG_DIV, REG_TIMA, REG_LY, REG_STAT, REG_SCY, REG_BGP, REG_NR51 };
+	struct mCore* detect = _idleTimingCore(GB_IDLE_LOOP_DETECT);
+	struct mCore* ignore = _idleTimingCore(GB_IDLE_LOOP_IGNORE);
+	struct GB* gb = detect->board;
+	struct GB* reference = ignore->board;
+
+	// Skipping idle loops must not move where a frame ends, or anything the loops do after exiting
+	int i;
+	size_t j;
+	for (i = 0; i < 30; ++i) {
+		detect->runFrame(detect);
+		ignore->runFrame(ignore);
+		assert_int_equal(gb->timing.masterCycles + gb->cpu->cycles, reference->timing.masterCycles + reference->cpu->cycles);
+		assert_int_equal(gb->memory.wram[0], reference->memory.wram[0]);
+		for (j = 0; j < sizeof(registers) / sizeof(*registers); ++j) {
+			assert_int_equal(GBIORead(gb, registers[j]), GBIORead(reference, registers[j]));
+		}
+	}
+	assert_int_not_equal(gb->idleLoop, GB_IDLE_LOOP_NONE);
+
+	mCoreConfigDeinit(&detect->config);
+	detect->deinit(detect);
+	mCoreConfigDeinit(&ignore->config);
+	ignore->deinit(ignore);
+}
+
+M_TEST_DEFINE(agbPalette) {
+	static color_t buffer[GB_VIDEO_HORIZONTAL_PIXELS * GB_VIDEO_VERTICAL_PIXELS];
+	struct GBVideoSoftwareRenderer renderer;
+	GBVideoSoftwareRendererCreate(&renderer);
+	renderer.outputBuffer = buffer;
+	renderer.outputBufferStride = GB_VIDEO_HORIZONTAL_PIXELS;
+	renderer.d.init(&renderer.d, GB_MODEL_AGB, false);
+
+	uint16_t value;
+	for (value = 0; value < 0x8000; value += 0x123) {
+		renderer.d.writePalette(&renderer.d, 5, value);
+		unsigned r = M_R5(value) * M_R5(value);
+		unsigned g = M_G5(value) * M_G5(value);
+		unsigned b = M_B5(value) * M_B5(value);
+#ifdef COLOR_16_BIT
+		assert_int_equal(renderer.palette[5], mColorFrom555(r / 31 | (g / 31) << 5 | (b / 31) << 10));
+#else
+		r >>= 2;
+		g >>= 2;
+		b >>= 2;
+		assert_int_equal(renderer.palette[5], (r + (r >> 4)) | (g + (g >> 4)) << 8 | (b + (b >> 4)) << 16);
+#endif
+	}
+
+	// Other models keep the plain conversion
+	renderer.d.deinit(&renderer.d);
+	renderer.d.init(&renderer.d, GB_MODEL_CGB, false);
+	renderer.d.writePalette(&renderer.d, 5, 0x4321);
+	assert_int_equal(renderer.palette[5], mColorFrom555(0x4321));
+	renderer.d.deinit(&renderer.d);
+}
+
 M_TEST_SUITE_DEFINE(GBCore,
 	cmocka_unit_test(create),
 	cmocka_unit_test(platform),
 	cmocka_unit_test(reset),
 	cmocka_unit_test(loadNullROM),
-	cmocka_unit_test(isROM))
+	cmocka_unit_test(isROM),
+	cmocka_unit_test(identifyROM),
+	cmocka_unit_test(batch),
+	cmocka_unit_test(lazyTimer),
+	cmocka_unit_test(idleTiming),
+	cmocka_unit_test(agbPalette))
@@ -8,6 +8,7 @@
 #include <mgba/core/core.h>
 #include <mgba/gb/core.h>
 #include <mgba/internal/gb/gb.h>
+#include <mgba/internal/gb/io.h>
 #include <mgba/internal/gb/mbc.h>
 #include <mgba-util/vfs.h>
 
@@ -74,7 +75,78 @@ M_TEST_DEFINE(patchROMBank2) {
 	assert_int_equal(GBView8(gb->cpu, GB_SIZE_CART_BANK0, 2), newExpected);
 }
 
+static int _runHDMA(struct GB* gb, bool accurate) {
+	gb->accurateDma = accurate;
+	GBIOWrite(gb, REG_LCDC, 0);
+	int i;
+	for (i = 0; i < 0x20; ++i) {
+		GBStore8(gb->cpu, GB_BASE_WORKING_RAM_BANK0 + i, i * 3 + 1);
+	}
+	memset(gb->video.vram, 0, GB_SIZE_VRAM_BANK0);
+	gb->memory.io[REG_HDMA1] = GB_BASE_WORKING_RAM_BANK0 >> 8;
+	gb->memory.io[REG_HDMA2] = 0;
+	gb->memory.io[REG_HDMA3] = 0x01;
+	gb->memory.io[REG_HDMA4] = 0x00;
+	GBMemoryWriteHDMA5(gb, 0x01);
+	assert_true(gb->cpuBlocked);
+	int cycles = 0;
+	while (gb->cpuBlocked) {
+		mTimingTick(&gb->timing, 1);
+		++cycles;
+	}
+	for (i = 0; i < 0x20; ++i) {
+		assert_int_equal(gb->video.vram[0x100 + i], i * 3 + 1);
+	}
+	assert_int_equal(gb->memory.io[REG_HDMA5], 0xFF);
+	return cycles;
+}
+
+M_TEST_DEFINE(batchedHDMA) {
+	struct mCore* core = *state;
+	struct GB* gb = core->board;
+
+	core->reset(core);
+	int accurateCycles = _runHDMA(gb, true);
+	core->reset(core);
+	int batchedCycles = _runHDMA(gb, false);
+	assert_int_equal(batchedCycles, accurateCycles);
+	gb->accurateDma = false;
+}
+
+static int _runOAMDMA(struct GB* gb, bool accurate) {
+	gb->accurateDma = accurate;
+	GBIOWrite(gb, REG_LCDC, 0);
+	int i;
+	for (i = 0; i < GB_SIZE_OAM; ++i) {
+		GBStore8(gb->cpu, GB_BASE_WORKING_RAM_BANK0 + i, i ^ 0x5A);
+	}
+	GBMemoryDMA(gb, GB_BASE_WORKING_RAM_BANK0);
+	int cycles = 0;
+	while (gb->memory.dmaRemaining) {
+		mTimingTick(&gb->timing, 1);
+		++cycles;
+	}
+	for (i = 0; i < GB_SIZE_OAM; ++i) {
+		assert_int_equal(gb->video.oam.raw[i], i ^ 0x5A);
+	}
+	return cycles;
+}
+
+M_TEST_DEFINE(batchedOAMDMA) {
+	struct mCore* core = *state;
+	struct GB* gb = core->board;
+
+	core->reset(core);
+	int accurateCycles = _runOAMDMA(gb, true);
+	core->reset(core);
+	int batchedCycles = _runOAMDMA(gb, false);
+	assert_int_equal(batchedCycles, accurateCycles);
+	gb->accurateDma = false;
+}
+
 M_TEST_SUITE_DEFINE_SETUP_TEARDOWN(GBMemory,
 	cmocka_unit_test(patchROMBank0),
 	cmocka_unit_test(patchROMBank1),
-	cmocka_unit_test(patchROMBank2))
+	cmocka_unit_test(patchROMBank2),
+	cmocka_unit_test(batchedHDMA),
+	cmocka_unit_test(batchedOAMDMA))
@@ -9,6 +9,7 @@
 #include <mgba/gb/core.h>
 #include <mgba/internal/gb/gb.h>
 #include <mgba/internal/gb/mbc.h>
+#include <mgba/internal/sm83/sm83.h>
 #include <mgba-util/vfs.h>
 
 struct GBRTCTest {
@@ -16,6 +17,7 @@ struct GBRTCTest {
 	struct mCore* core;
 	struct VFile* fakeSave;
 	time_t nextTime;
+	int samples;
 };
 
 static void _sampleRtc(struct GB* gb) {
@@ -31,6 +33,7 @@ static void _sampleRtcKeepLatch(struct GB* gb) {
 
 static time_t _testTime(struct mRTCSource* source) {
 	struct GBRTCTest* test = (struct GBRTCTest*) source;
+	++test->samples;
 	return test->nextTime;
 }
 
@@ -952,6 +955,33 @@ M_TEST_DEFINE(roundtripHuge) {
 	assert_memory_equal(gb->memory.rtcRegs, expected, sizeof(expected));
 }
 
+M_TEST_DEFINE(sampleOncePerFrame) {
+	struct GBRTCTest* test = *state;
+	test->nextTime = 0;
+	test->core->reset(test->core);
+	struct GB* gb = test->core->board;
+	memset(gb->memory.rtcRegs, 0, sizeof(gb->memory.rtcRegs));
+
+	test->samples = 0;
+	test->nextTime = 10;
+	_sampleRtc(gb);
+	_sampleRtc(gb);
+	assert_int_equal(test->samples, 1);
+	assert_int_equal(gb->memory.rtcRegs[0], 20);
+
+	// Host time only moves forward at the next frame, but emulated time still counts
+	test->nextTime = 20;
+	gb->cpu->cycles += DMG_SM83_FREQUENCY;
+	_sampleRtc(gb);
+	assert_int_equal(test->samples, 1);
+	assert_int_equal(gb->memory.rtcRegs[0], 31);
+
+	GBFrameStarted(gb);
+	_sampleRtc(gb);
+	assert_int_equal(test->samples, 2);
+	assert_int_equal(gb->memory.rtcRegs[0], 51);
+}
+
 M_TEST_SUITE_DEFINE_SETUP_TEARDOWN(GBRTC,
 	cmocka_unit_test(create),
 	cmocka_unit_test(tickSecond),
@@ -967,4 +997,5 @@ M_TEST_SUITE_DEFINE_SETUP_TEARDOWN(GBRTC,
 	cmocka_unit_test(roundtrip0),
 	cmocka_unit_test(roundtripSecond),
 	cmocka_unit_test(roundtripDay),
-	cmocka_unit_test(roundtripHuge))
+	cmocka_unit_test(roundtripHuge),
+	cmocka_unit_test(sampleOncePerFrame))
@@ -8,6 +8,7 @@
 #include <mgba/internal/sm83/sm83.h>
 #include <mgba/internal/gb/gb.h>
 #include <mgba/internal/gb/io.h>
+#include <mgba/internal/gb/overrides.h>
 #include <mgba/internal/gb/serialize.h>
 
 void _GBTimerIRQ(struct mTiming* timing, void* context, uint32_t cyclesLate) {
@@ -17,6 +18,7 @@ void _GBTimerIRQ(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	timer->p->memory.io[REG_TIMA] = timer->p->memory.io[REG_TMA];
 	timer->p->memory.io[REG_IF] |= (1 << GB_IRQ_TIMER);
 	GBUpdateIRQs(timer->p);
+	GBTimerReschedule(timer);
 }
 
 static void _GBTimerDivIncrement(struct GBTimer* timer, uint32_t cyclesLate) {
@@ -32,28 +34,47 @@ static void _GBTimerDivIncrement(struct GBTimer* timer, uint32_t cyclesLate) {
 		}
 		unsigned timingFactor = 0x3FF >> !timer->p->doubleSpeed;
 		if ((timer->internalDiv & timingFactor) == timingFactor) {
-			GBAudioUpdateFrame(&timer->p->audio, &timer->p->timing);
+			// nextDiv now holds how long ago this increment happened
+			GBAudioUpdateFrame(&timer->p->audio, mTimingCurrentTime(&timer->p->timing) - timer->nextDiv);
 		}
 		++timer->internalDiv;
 		timer->p->memory.io[REG_DIV] = timer->internalDiv >> 4;
 	}
 }
 
-void _GBTimerUpdate(struct mTiming* timing, void* context, uint32_t cyclesLate) {
-	struct GBTimer* timer = context;
-	timer->nextDiv += cyclesLate;
-	_GBTimerDivIncrement(timer, cyclesLate);
-	// Batch div increments
-	int divsToGo = 16 - (timer->internalDiv & 15);
+static void _GBTimerSchedule(struct GBTimer* timer, uint32_t cyclesLate) {
+	struct GB* gb = timer->p;
+	int divsToGo;
 	int timaToGo = INT_MAX;
-	if (timer->timaPeriod) {
-		timaToGo = timer->timaPeriod - (timer->internalDiv & (timer->timaPeriod - 1));
+	if (gb->idleOptimization >= GB_IDLE_LOOP_REMOVE && gb->idleLoop != GB_IDLE_LOOP_NONE) {
+		// Skipping an idle loop jumps to the next event, so it has to land wherever DIV or TIMA changes
+		divsToGo = 16 - (timer->internalDiv & 15);
+		if (timer->timaPeriod) {
+			timaToGo = timer->timaPeriod - (timer->internalDiv & (timer->timaPeriod - 1));
+		}
+	} else {
+		// Batch div increments up to the next audio frame step or TIMA overflow,
+		// since DIV and TIMA are caught up whenever they're read
+		unsigned timingFactor = 0x3FF >> !gb->doubleSpeed;
+		divsToGo = timingFactor + 1 - (timer->internalDiv & timingFactor);
+		if (timer->timaPeriod) {
+			timaToGo = timer->timaPeriod - (timer->internalDiv & (timer->timaPeriod - 1));
+			timaToGo += (0xFF - gb->memory.io[REG_TIMA]) * timer->timaPeriod;
+		}
 	}
 	if (timaToGo < divsToGo) {
 		divsToGo = timaToGo;
 	}
 	timer->nextDiv = GB_DMG_DIV_PERIOD * divsToGo;
-	mTimingSchedule(timing, &timer->event, timer->nextDiv - cyclesLate);
+	mTimingSchedule(&timer->p->timing, &timer->event, timer->nextDiv - cyclesLate);
+}
+
+void _GBTimerUpdate(struct mTiming* timing, void* context, uint32_t cyclesLate) {
+	UNUSED(timing);
+	struct GBTimer* timer = context;
+	timer->nextDiv += cyclesLate;
+	_GBTimerDivIncrement(timer, cyclesLate);
+	_GBTimerSchedule(timer, cyclesLate);
 }
 
 void GBTimerReset(struct GBTimer* timer) {
@@ -82,7 +103,8 @@ void GBTimerDivReset(struct GBTimer* timer) {
 	}
 	unsigned timingFactor = 0x400 >> !timer->p->doubleSpeed;
 	if (timer->internalDiv & timingFactor) {
-		GBAudioUpdateFrame(&timer->p->audio, &timer->p->timing);
+		// The write lands before anything due on the same cycle is processed
+		GBAudioUpdateFrame(&timer->p->audio, mTimingCurrentTime(&timer->p->timing) - 1);
 	}
 	timer->p->memory.io[REG_DIV] = 0;
 	timer->internalDiv = 0;
@@ -90,6 +112,21 @@ void GBTimerDivReset(struct GBTimer* timer) {
 	mTimingSchedule(&timer->p->timing, &timer->event, timer->nextDiv - ((timer->p->cpu->executionState + 1) & 3));
 }
 
+void GBTimerUpdateRegisters(struct GBTimer* timer) {
+	// The pending event still lands where it was going to, so only the increments up to now are taken
+	int32_t until = mTimingUntil(&timer->p->timing, &timer->event);
+	timer->nextDiv -= until;
+	_GBTimerDivIncrement(timer, 0);
+	timer->nextDiv += until;
+}
+
+void GBTimerReschedule(struct GBTimer* timer) {
+	timer->nextDiv -= mTimingUntil(&timer->p->timing, &timer->event);
+	mTimingDeschedule(&timer->p->timing, &timer->event);
+	_GBTimerDivIncrement(timer, 0);
+	_GBTimerSchedule(timer, timer->nextDiv);
+}
+
 uint8_t GBTimerUpdateTAC(struct GBTimer* timer, GBRegisterTAC tac) {
 	if (GBRegisterTACIsRun(tac)) {
 		timer->nextDiv -= mTimingUntil(&timer->p->timing, &timer->event);
@@ -49,6 +49,7 @@ static struct GBVideoRenderer dummyRenderer = {
 	.drawRange = GBVideoDummyRendererDrawRange,
 	.finishScanline = GBVideoDummyRendererFinishScanline,
 	.finishFrame = GBVideoDummyRendererFinishFrame,
+	.skipFrame = NULL,
 	.enableSGBBorder = GBVideoDummyRendererEnableSGBBorder,
 	.getPixels = GBVideoDummyRendererGetPixels,
 	.putPixels = GBVideoDummyRendererPutPixels,
@@ -58,7 +59,11 @@ void GBVideoInit(struct GBVideo* video) {
 	video->renderer = &dummyRenderer;
 	video->renderer->cache = NULL;
 	video->renderer->sgbRenderMode = 0;
-	video->vram = anonymousMemoryMap(GB_SIZE_VRAM);
+	// VRAM lives in the memory arena, which GBMemoryInit has already set up
+	video->vram = NULL;
+	if (video->p->memory.arena) {
+		video->vram = &video->p->memory.arena[GB_ARENA_VRAM];
+	}
 	video->frameskip = 0;
 
 	video->modeEvent.context = video;
@@ -100,6 +105,7 @@ void GBVideoReset(struct GBVideo* video) {
 
 	video->frameCounter = 0;
 	video->frameskipCounter = 0;
+	video->sgbTransferFrames = 0;
 
 	GBVideoSwitchBank(video, 0);
 	video->renderer->vram = video->vram;
@@ -150,7 +156,7 @@ void GBVideoReset(struct GBVideo* video) {
 
 void GBVideoDeinit(struct GBVideo* video) {
 	video->renderer->deinit(video->renderer);
-	mappedMemoryFree(video->vram, GB_SIZE_VRAM);
+	video->vram = NULL;
 	if (video->renderer->sgbCharRam) {
 		mappedMemoryFree(video->renderer->sgbCharRam, SGB_SIZE_CHAR_RAM);
 		video->renderer->sgbCharRam = NULL;
@@ -214,10 +220,16 @@ static bool _statIRQAsserted(GBRegisterSTAT stat) {
 	return false;
 }
 
+static inline bool _isSkipping(const struct GBVideo* video) {
+	return video->frameskipCounter > 0 && !video->sgbTransferFrames;
+}
+
 void _endMode0(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	struct GBVideo* video = context;
-	if (video->frameskipCounter <= 0) {
+	if (!_isSkipping(video)) {
+		enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_RENDER_SCANLINE);
 		video->renderer->finishScanline(video->renderer, video->ly);
+		mTimingHostLeave(timing, category);
 	}
 	int lyc = video->p->memory.io[REG_LYC];
 	int32_t next;
@@ -302,6 +314,7 @@ void _endMode2(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	video->dotClock = mTimingCurrentTime(timing) - cyclesLate + 5 - (video->x << video->p->doubleSpeed);
 	int32_t next = GB_VIDEO_MODE_3_LENGTH_BASE + video->objMax * 6 - video->x;
 	video->mode = 3;
+	GBMemoryRemapVram(video->p);
 	video->modeEvent.callback = _endMode3;
 	GBRegisterSTAT oldStat = video->stat;
 	video->stat = GBRegisterSTATSetMode(video->stat, video->mode);
@@ -323,6 +336,7 @@ void _endMode3(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 		mTimingSchedule(timing, &video->p->memory.hdmaEvent, 0);
 	}
 	video->mode = 0;
+	GBMemoryRemapVram(video->p);
 	video->modeEvent.callback = _endMode0;
 	GBRegisterSTAT oldStat = video->stat;
 	video->stat = GBRegisterSTATSetMode(video->stat, video->mode);
@@ -347,10 +361,20 @@ void _updateFrameCount(struct mTiming* timing, void* context, uint32_t cyclesLat
 		mTimingSchedule(timing, &video->frameEvent, GB_VIDEO_TOTAL_LENGTH);
 	}
 
+	bool skipped = _isSkipping(video);
 	--video->frameskipCounter;
-	if (video->frameskipCounter < 0) {
+	if (!skipped) {
+		enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_RENDER_FRAME);
 		video->renderer->finishFrame(video->renderer);
-		video->frameskipCounter = video->frameskip;
+		mTimingHostLeave(timing, category);
+		if (video->frameskipCounter < 0) {
+			video->frameskipCounter = video->frameskip;
+		}
+	} else if (video->renderer->skipFrame) {
+		video->renderer->skipFrame(video->renderer);
+	}
+	if (video->sgbTransferFrames) {
+		--video->sgbTransferFrames;
 	}
 	GBFrameEnded(video->p);
 	mCoreSyncPostFrame(video->p->sync);
@@ -398,8 +422,10 @@ void GBVideoProcessDots(struct GBVideo* video, uint32_t cyclesLate) {
 	if (oldX < 0) {
 		oldX = 0;
 	}
-	if (video->frameskipCounter <= 0) {
+	if (!_isSkipping(video)) {
+		enum mTimingHostCategory category = mTimingHostEnter(&video->p->timing, mTIMING_HOST_RENDER_SCANLINE);
 		video->renderer->drawRange(video->renderer, oldX, video->x, video->ly, video->objThisLine, video->objMax);
+		mTimingHostLeave(&video->p->timing, category);
 	}
 }
 
@@ -428,6 +454,7 @@ void GBVideoWriteLCDC(struct GBVideo* video, GBRegisterLCDC value) {
 	if (GBRegisterLCDCIsEnable(video->p->memory.io[REG_LCDC]) && !GBRegisterLCDCIsEnable(value)) {
 		// TODO: Fix serialization; this gets internal and visible modes out of sync
 		video->mode = 0;
+		GBMemoryRemapVram(video->p);
 		video->stat = GBRegisterSTATSetMode(video->stat, 0);
 		video->p->memory.io[REG_STAT] = video->stat;
 		video->ly = 0;
@@ -550,6 +577,7 @@ void GBVideoSwitchBank(struct GBVideo* video, uint8_t value) {
 	value &= 1;
 	video->vramBank = &video->vram[value * GB_SIZE_VRAM_BANK0];
 	video->vramCurrentBank = value;
+	GBMemoryRemapVram(video->p);
 }
 
 void GBVideoSetPalette(struct GBVideo* video, unsigned index, uint32_t color) {
@@ -693,12 +721,15 @@ void GBVideoWriteSGBPacket(struct GBVideo* video, uint8_t* data) {
 	case SGB_ATTR_DIV:
 	case SGB_ATTR_CHR:
 	case SGB_ATTR_LIN:
-	case SGB_PAL_TRN:
 	case SGB_ATRC_EN:
+	case SGB_ATTR_SET:
+		break;
+	case SGB_PAL_TRN:
 	case SGB_CHR_TRN:
 	case SGB_PCT_TRN:
 	case SGB_ATTR_TRN:
-	case SGB_ATTR_SET:
+		// The rest of this frame, and all of the next one, when the data gets read
+		video->sgbTransferFrames = 2;
 		break;
 	case SGB_MLT_REQ:
 		if ((video->sgbPacketBuffer[1] & 0x3) == 2) { // XXX: This unmasked increment appears to be an SGB hardware bug
@@ -16,10 +16,6 @@
 
 #define MP2K_LOCK_MAX 8
 
-#ifdef _3DS
-#define blip_add_delta blip_add_delta_fast
-#endif
-
 mLOG_DEFINE_CATEGORY(GBA_AUDIO, "GBA Audio", "gba.audio");
 
 const unsigned GBA_AUDIO_SAMPLES = 2048;
@@ -27,9 +23,12 @@ const unsigned GBA_AUDIO_FIFO_SIZE = 8 * sizeof(int32_t);
 const int GBA_AUDIO_VOLUME_MAX = 0x100;
 
 static const int CLOCKS_PER_FRAME = 0x800;
+static const int SAMPLES_PER_BLOCK = 64;
 
 static int _applyBias(struct GBAAudio* audio, int sample);
 static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate);
+static void _syncPSG(void* context, uint32_t when);
+static void _scheduleBlock(struct GBAAudio* audio);
 
 void GBAAudioInit(struct GBAAudio* audio, size_t samples) {
 	audio->sampleEvent.context = audio;
@@ -44,7 +43,10 @@ void GBAAudioInit(struct GBAAudio* audio, size_t samples) {
 	GBAudioInit(&audio->psg, 0, nr52, GB_AUDIO_GBA);
 	audio->psg.timing = &audio->p->timing;
 	audio->psg.clockRate = GBA_ARM7TDMI_FREQUENCY;
+	audio->psg.sync = _syncPSG;
+	audio->psg.syncContext = audio;
 	audio->samples = samples;
+	audio->muted = false;
 	// Guess too large; we hang producing extra samples if we guess too low
 	blip_set_rates(audio->psg.left, GBA_ARM7TDMI_FREQUENCY, 96000);
 	blip_set_rates(audio->psg.right, GBA_ARM7TDMI_FREQUENCY, 96000);
@@ -52,6 +54,7 @@ void GBAAudioInit(struct GBAAudio* audio, size_t samples) {
 	CircleBufferInit(&audio->chB.fifo, GBA_AUDIO_FIFO_SIZE);
 
 	audio->externalMixing = false;
+	audio->hleMode = GBA_AUDIO_HLE_DEFAULT;
 	audio->forceDisableChA = false;
 	audio->forceDisableChB = false;
 	audio->masterVolume = GBA_AUDIO_VOLUME_MAX;
@@ -61,7 +64,6 @@ void GBAAudioInit(struct GBAAudio* audio, size_t samples) {
 void GBAAudioReset(struct GBAAudio* audio) {
 	GBAudioReset(&audio->psg);
 	mTimingDeschedule(&audio->p->timing, &audio->sampleEvent);
-	mTimingSchedule(&audio->p->timing, &audio->sampleEvent, 0);
 	audio->chA.dmaSource = 1;
 	audio->chB.dmaSource = 2;
 	audio->chA.sample = 0;
@@ -80,6 +82,8 @@ void GBAAudioReset(struct GBAAudio* audio) {
 	audio->enable = false;
 	audio->sampleInterval = GBA_ARM7TDMI_FREQUENCY / audio->sampleRate;
 	audio->psg.sampleInterval = audio->sampleInterval;
+	audio->nextSample = mTimingCurrentTime(&audio->p->timing);
+	_scheduleBlock(audio);
 
 	blip_clear(audio->psg.left);
 	blip_clear(audio->psg.right);
@@ -95,6 +99,7 @@ void GBAAudioDeinit(struct GBAAudio* audio) {
 }
 
 void GBAAudioResizeBuffer(struct GBAAudio* audio, size_t samples) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	mCoreSyncLockAudio(audio->p->sync);
 	audio->samples = samples;
 	blip_clear(audio->psg.left);
@@ -106,12 +111,15 @@ void GBAAudioResizeBuffer(struct GBAAudio* audio, size_t samples) {
 void GBAAudioScheduleFifoDma(struct GBAAudio* audio, int number, struct GBADMA* info) {
 	info->reg = GBADMARegisterSetDestControl(info->reg, GBA_DMA_FIXED);
 	info->reg = GBADMARegisterSetWidth(info->reg, 1);
+	int fifo;
 	switch (info->dest) {
 	case BASE_IO | REG_FIFO_A_LO:
 		audio->chA.dmaSource = number;
+		fifo = 0;
 		break;
 	case BASE_IO | REG_FIFO_B_LO:
 		audio->chB.dmaSource = number;
+		fifo = 1;
 		break;
 	default:
 		mLOG(GBA_AUDIO, GAME_ERROR, "Invalid FIFO destination: 0x%08X", info->dest);
@@ -120,75 +128,88 @@ void GBAAudioScheduleFifoDma(struct GBAAudio* audio, int number, struct GBADMA*
 	uint32_t source = info->source;
 	uint32_t magic[2] = {
 		audio->p->cpu->memory.load32(audio->p->cpu, source - 0x350, NULL),
-		audio->p->cpu->memory.load32(audio->p->cpu, source - 0x980, NULL)
+		audio->p->cpu->memory.load32(audio->p->cpu, source - 0x350 - MP2K_PCM_BUFFER_SIZE, NULL)
 	};
 	if (audio->mixer) {
+		// The driver keeps its right and left PCM buffers back to back after the sound channels
 		if (magic[0] - MP2K_MAGIC <= MP2K_LOCK_MAX) {
-			audio->mixer->engage(audio->mixer, source - 0x350);
+			audio->mixer->engage(audio->mixer, source - 0x350, fifo, false);
 		} else if (magic[1] - MP2K_MAGIC <= MP2K_LOCK_MAX) {
-			audio->mixer->engage(audio->mixer, source - 0x980);
+			audio->mixer->engage(audio->mixer, source - 0x350 - MP2K_PCM_BUFFER_SIZE, fifo, true);
 		} else {
-			audio->externalMixing = false;
+			audio->mixer->release(audio->mixer, fifo);
 		}
 	}
 }
 
 void GBAAudioWriteSOUND1CNT_LO(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR10(&audio->psg, value);
 }
 
 void GBAAudioWriteSOUND1CNT_HI(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR11(&audio->psg, value);
 	GBAudioWriteNR12(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUND1CNT_X(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR13(&audio->psg, value);
 	GBAudioWriteNR14(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUND2CNT_LO(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR21(&audio->psg, value);
 	GBAudioWriteNR22(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUND2CNT_HI(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR23(&audio->psg, value);
 	GBAudioWriteNR24(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUND3CNT_LO(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	audio->psg.ch3.size = GBAudioRegisterBankGetSize(value);
 	audio->psg.ch3.bank = GBAudioRegisterBankGetBank(value);
 	GBAudioWriteNR30(&audio->psg, value);
 }
 
 void GBAAudioWriteSOUND3CNT_HI(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR31(&audio->psg, value);
 	audio->psg.ch3.volume = GBAudioRegisterBankVolumeGetVolumeGBA(value >> 8);
 }
 
 void GBAAudioWriteSOUND3CNT_X(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR33(&audio->psg, value);
 	GBAudioWriteNR34(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUND4CNT_LO(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR41(&audio->psg, value);
 	GBAudioWriteNR42(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUND4CNT_HI(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR43(&audio->psg, value);
 	GBAudioWriteNR44(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUNDCNT_LO(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	GBAudioWriteNR50(&audio->psg, value);
 	GBAudioWriteNR51(&audio->psg, value >> 8);
 }
 
 void GBAAudioWriteSOUNDCNT_HI(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	audio->volume = GBARegisterSOUNDCNT_HIGetVolume(value);
 	audio->volumeChA = GBARegisterSOUNDCNT_HIGetVolumeChA(value);
 	audio->volumeChB = GBARegisterSOUNDCNT_HIGetVolumeChB(value);
@@ -207,15 +228,18 @@ void GBAAudioWriteSOUNDCNT_HI(struct GBAAudio* audio, uint16_t value) {
 }
 
 void GBAAudioWriteSOUNDCNT_X(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	audio->enable = GBAudioEnableGetEnable(value);
 	GBAudioWriteNR52(&audio->psg, value);
 }
 
 void GBAAudioWriteSOUNDBIAS(struct GBAAudio* audio, uint16_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	audio->soundbias = value;
 }
 
 void GBAAudioWriteWaveRAM(struct GBAAudio* audio, int address, uint32_t value) {
+	GBAAudioSample(audio, mTimingSettledTime(&audio->p->timing));
 	audio->psg.ch3.wavedata32[address | (!audio->psg.ch3.bank * 4)] = value;
 }
 
@@ -251,6 +275,8 @@ void GBAAudioSampleFIFO(struct GBAAudio* audio, int fifoId, int32_t cycles) {
 		mLOG(GBA_AUDIO, ERROR, "Bad FIFO write to address 0x%03x", fifoId);
 		return;
 	}
+	// Timers fire after any sample due at the same time
+	GBAAudioSample(audio, mTimingCurrentTime(&audio->p->timing) - cycles);
 	if (CircleBufferSize(&channel->fifo) <= 4 * sizeof(int32_t) && channel->dmaSource > 0) {
 		struct GBADMA* dma = &audio->p->memory.dma[channel->dmaSource];
 		if (GBADMARegisterGetTiming(dma->reg) == GBA_DMA_TIMING_CUSTOM) {
@@ -274,48 +300,56 @@ static int _applyBias(struct GBAAudio* audio, int sample) {
 	return ((sample - GBARegisterSOUNDBIASGetBias(audio->soundbias)) * audio->masterVolume * 3) >> 4;
 }
 
-static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate) {
-	struct GBAAudio* audio = user;
+static void _mixSample(struct GBAAudio* audio, int16_t* left, int16_t* right) {
 	int16_t sampleLeft = 0;
 	int16_t sampleRight = 0;
 	int psgShift = 4 - audio->volume;
+	GBAudioRun(&audio->psg, audio->nextSample);
 	GBAudioSamplePSG(&audio->psg, &sampleLeft, &sampleRight);
 	sampleLeft >>= psgShift;
 	sampleRight >>= psgShift;
 
-	if (audio->mixer) {
-		audio->mixer->step(audio->mixer);
+	int16_t sampleA = audio->chA.sample << 2;
+	int16_t sampleB = audio->chB.sample << 2;
+	if (audio->externalMixing) {
+		audio->mixer->step(audio->mixer, &sampleA, &sampleB);
 	}
-	if (!audio->externalMixing) {
-		if (!audio->forceDisableChA) {
-			if (audio->chALeft) {
-				sampleLeft += (audio->chA.sample << 2) >> !audio->volumeChA;
-			}
-
-			if (audio->chARight) {
-				sampleRight += (audio->chA.sample << 2) >> !audio->volumeChA;
-			}
+
+	if (!audio->forceDisableChA) {
+		if (audio->chALeft) {
+			sampleLeft += sampleA >> !audio->volumeChA;
+		}
+
+		if (audio->chARight) {
+			sampleRight += sampleA >> !audio->volumeChA;
 		}
+	}
 
-		if (!audio->forceDisableChB) {
-			if (audio->chBLeft) {
-				sampleLeft += (audio->chB.sample << 2) >> !audio->volumeChB;
-			}
+	if (!audio->forceDisableChB) {
+		if (audio->chBLeft) {
+			sampleLeft += sampleB >> !audio->volumeChB;
+		}
 
-			if (audio->chBRight) {
-				sampleRight += (audio->chB.sample << 2) >> !audio->volumeChB;
-			}
+		if (audio->chBRight) {
+			sampleRight += sampleB >> !audio->volumeChB;
 		}
 	}
 
-	sampleLeft = _applyBias(audio, sampleLeft);
-	sampleRight = _applyBias(audio, sampleRight);
+	*left = _applyBias(audio, sampleLeft);
+	*right = _applyBias(audio, sampleRight);
+}
 
+static void _postSample(struct GBAAudio* audio, int16_t sampleLeft, int16_t sampleRight) {
 	mCoreSyncLockAudio(audio->p->sync);
 	unsigned produced;
 	if ((size_t) blip_samples_avail(audio->psg.left) < audio->samples) {
-		blip_add_delta(audio->psg.left, audio->clock, sampleLeft - audio->lastLeft);
-		blip_add_delta(audio->psg.right, audio->clock, sampleRight - audio->lastRight);
+		// Within a run of identical samples there is nothing to add
+		if (sampleLeft != audio->lastLeft) {
+			audio->psg.addDelta(audio->psg.left, audio->clock, sampleLeft - audio->lastLeft);
+		}
+		if (sampleRight != audio->lastRight) {
+			audio->psg.addDelta(audio->psg.right, audio->clock, sampleRight - audio->lastRight);
+		}
 		audio->lastLeft = sampleLeft;
 		audio->lastRight = sampleRight;
 		audio->clock += audio->sampleInterval;
@@ -338,8 +372,52 @@ static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate) {
 	if (wait && audio->p->stream && audio->p->stream->postAudioBuffer) {
 		audio->p->stream->postAudioBuffer(audio->p->stream, audio->psg.left, audio->psg.right);
 	}
+}
+
+static void _mixUntil(struct GBAAudio* audio, uint32_t timestamp) {
+	if (audio->muted) {
+		// Skip every due sample at once; the channels catch up on their own
+		if ((int32_t) (timestamp - audio->nextSample) >= 0) {
+			audio->nextSample += ((timestamp - audio->nextSample) / audio->sampleInterval + 1) * audio->sampleInterval;
+		}
+		return;
+	}
+	int16_t sampleLeft = 0;
+	int16_t sampleRight = 0;
+	while ((int32_t) (timestamp - audio->nextSample) >= 0) {
+		_mixSample(audio, &sampleLeft, &sampleRight);
+		_postSample(audio, sampleLeft, sampleRight);
+		audio->nextSample += audio->sampleInterval;
+	}
+}
+
+void GBAAudioSample(struct GBAAudio* audio, uint32_t timestamp) {
+	// Nothing is pending while the sample event is off, e.g. when loading a savestate
+	if (!mTimingIsScheduled(&audio->p->timing, &audio->sampleEvent)) {
+		return;
+	}
+	enum mTimingHostCategory category = mTimingHostEnter(&audio->p->timing, mTIMING_HOST_AUDIO);
+	_mixUntil(audio, timestamp);
+	GBAudioRun(&audio->psg, timestamp);
+	mTimingHostLeave(&audio->p->timing, category);
+}
+
+static void _syncPSG(void* context, uint32_t when) {
+	// The frame sequencer steps before any sample due at the same time
+	GBAAudioSample(context, when - 1);
+}
 
-	mTimingSchedule(timing, &audio->sampleEvent, audio->sampleInterval - cyclesLate);
+static void _scheduleBlock(struct GBAAudio* audio) {
+	uint32_t blockEnd = audio->nextSample + audio->sampleInterval * (SAMPLES_PER_BLOCK - 1);
+	mTimingSchedule(&audio->p->timing, &audio->sampleEvent, (int32_t) (blockEnd - mTimingCurrentTime(&audio->p->timing)));
+}
+
+static void _sample(struct mTiming* timing, void* user, uint32_t cyclesLate) {
+	struct GBAAudio* audio = user;
+	enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_AUDIO);
+	_mixUntil(audio, mTimingCurrentTime(timing) - cyclesLate);
+	mTimingHostLeave(timing, category);
+	_scheduleBlock(audio);
 }
 
 void GBAAudioSerialize(const struct GBAAudio* audio, struct GBASerializedState* state) {
@@ -349,7 +427,7 @@ void GBAAudioSerialize(const struct GBAAudio* audio, struct GBASerializedState*
 	CircleBufferDump(&audio->chB.fifo, state->audio.fifoB, sizeof(state->audio.fifoB));
 	uint32_t fifoSize = CircleBufferSize(&audio->chA.fifo);
 	STORE_32(fifoSize, 0, &state->audio.fifoSize);
-	STORE_32(audio->sampleEvent.when - mTimingCurrentTime(&audio->p->timing), 0, &state->audio.nextSample);
+	STORE_32(audio->nextSample - mTimingCurrentTime(&audio->p->timing), 0, &state->audio.nextSample);
 }
 
 void GBAAudioDeserialize(struct GBAAudio* audio, const struct GBASerializedState* state) {
@@ -370,7 +448,8 @@ void GBAAudioDeserialize(struct GBAAudio* audio, const struct GBASerializedState
 
 	uint32_t when;
 	LOAD_32(when, 0, &state->audio.nextSample);
-	mTimingSchedule(&audio->p->timing, &audio->sampleEvent, when);
+	audio->nextSample = mTimingCurrentTime(&audio->p->timing) + when;
+	_scheduleBlock(audio);
 }
 
 float GBAAudioCalculateRatio(float inputSampleRate, float desiredFPS, float desiredSampleRate) {
@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/internal/gba/bios.h>
 
+#include <mgba/internal/arm/block-cache.h>
 #include <mgba/internal/arm/isa-inlines.h>
 #include <mgba/internal/arm/macros.h>
 #include <mgba/internal/gba/gba.h>
@@ -50,6 +51,7 @@ static void _SoftReset(struct GBA* gba) {
 	cpu->gprs[ARM_SP] = SP_BASE_SYSTEM;
 	int8_t flag = ((int8_t*) gba->memory.iwram)[0x7FFA];
 	memset(((int8_t*) gba->memory.iwram) + SIZE_WORKING_IRAM - 0x200, 0, 0x200);
+	gba->memory.dirtyTracked = false;
 	if (flag) {
 		cpu->gprs[ARM_PC] = BASE_WORKING_RAM;
 	} else {
@@ -69,6 +71,9 @@ static void _RegisterRamReset(struct GBA* gba) {
 	if (registers & 0x02) {
 		memset(gba->memory.iwram, 0, SIZE_WORKING_IRAM - 0x200);
 	}
+	if ((registers & 0x03) && cpu->blockCache) {
+		ARMBlockCacheClear(cpu->blockCache);
+	}
 	if (registers & 0x04) {
 		memset(gba->video.palette, 0, SIZE_PALETTE_RAM);
 	}
@@ -78,6 +83,9 @@ static void _RegisterRamReset(struct GBA* gba) {
 	if (registers & 0x10) {
 		memset(gba->video.oam.raw, 0, SIZE_OAM);
 	}
+	if (registers & 0x1F) {
+		gba->memory.dirtyTracked = false;
+	}
 	if (registers & 0x20) {
 		cpu->memory.store16(cpu, BASE_IO | REG_SIOCNT, 0x0000, 0);
 		cpu->memory.store16(cpu, BASE_IO | REG_RCNT, RCNT_INITIAL, 0);
@@ -274,6 +282,119 @@ static void _MidiKey2Freq(struct GBA* gba) {
 	cpu->gprs[0] = key / exp2f((180.f - cpu->gprs[1] - cpu->gprs[2] / 256.f) / 12.f);
 }
 
+// Runs CpuSet and CpuFastSet on host memory when nothing but plain memory is involved,
+// rather than stepping through the loop in the replacement BIOS
+static bool _CpuSet(struct GBA* gba, bool fast) {
+	struct GBAMemory* memory = &gba->memory;
+	struct ARMCore* cpu = gba->cpu;
+	uint32_t source = cpu->gprs[0];
+	uint32_t dest = cpu->gprs[1];
+	bool fill = cpu->gprs[2] & 0x01000000;
+	uint32_t width = fast || cpu->gprs[2] & 0x04000000 ? 4 : 2;
+	uint32_t units = cpu->gprs[2] & 0x000FFFFF;
+	uint32_t length = units * width;
+	if (fast) {
+		// Whole blocks of 8 words get written
+		length = (length + 31) & ~31;
+	}
+	if (!units || (source | dest) & (width - 1)) {
+		return false;
+	}
+	if (cpu->memory.load16 != GBALoad16 || cpu->memory.load32 != GBALoad32 || cpu->memory.store16 != GBAStore16 || cpu->memory.store32 != GBAStore32) {
+		return false;
+	}
+	uint32_t sourceRegion = source >> BASE_OFFSET;
+	uint32_t destRegion = dest >> BASE_OFFSET;
+	switch (destRegion) {
+	case REGION_WORKING_RAM:
+	case REGION_WORKING_IRAM:
+	case REGION_PALETTE_RAM:
+	case REGION_VRAM:
+	case REGION_OAM:
+		break;
+	default:
+		return false;
+	}
+	uint32_t available;
+	const uint8_t* from = GBAMemoryHostPointer(gba, source, &available, false);
+	if (!from || available < (fill ? width : length)) {
+		return false;
+	}
+	uint8_t* to = GBAMemoryHostPointer(gba, dest, &available, true);
+	if (!to || available < length) {
+		return false;
+	}
+
+	uint32_t value;
+	if (width == 4) {
+		LOAD_32(value, 0, from);
+	} else {
+		uint16_t halfword;
+		LOAD_16(halfword, 0, from);
+		value = halfword | (halfword << 16);
+	}
+	if (fill) {
+		uint32_t pattern[64];
+		uint32_t offset;
+		for (offset = 0; offset < sizeof(pattern); offset += 4) {
+			STORE_32(value, offset, pattern);
+		}
+		for (offset = 0; offset < length; offset += sizeof(pattern)) {
+			uint32_t chunk = length - offset;
+			if (chunk > sizeof(pattern)) {
+				chunk = sizeof(pattern);
+			}
+			GBAMemoryHostCopy(gba, dest + offset, &to[offset], (const uint8_t*) pattern, chunk, width);
+		}
+	} else {
+		if (from < to + length && to < from + length) {
+			// Overlapping copies depend on the order of the loop
+			return false;
+		}
+		if (fast) {
+			// The last block loaded is left behind in r3
+			LOAD_32(value, length - 32, from);
+		}
+		GBAMemoryHostCopy(gba, dest, to, from, length, width);
+	}
+
+	// Charge for the loop in the replacement BIOS: its instructions, then its loads and stores
+	int32_t cycles;
+	if (fast) {
+		cycles = (fill ? 5 : 7) + 1 + memory->waitstatesNonseq32[destRegion] + 7 * (1 + memory->waitstatesSeq32[destRegion]);
+		if (!fill) {
+			cycles += 1 + memory->waitstatesNonseq32[sourceRegion] + 7 * (1 + memory->waitstatesSeq32[sourceRegion]);
+		}
+		cycles *= length / 32;
+	} else if (width == 4) {
+		cycles = (fill ? 5 : 7) + 1 + memory->waitstatesNonseq32[destRegion];
+		if (!fill) {
+			cycles += 1 + memory->waitstatesNonseq32[sourceRegion];
+		}
+		cycles *= units;
+	} else {
+		cycles = (fill ? 5 : 7) + 1 + memory->waitstatesNonseq16[destRegion];
+		if (!fill) {
+			cycles += 1 + memory->waitstatesNonseq16[sourceRegion];
+		}
+		cycles *= units;
+	}
+	cpu->cycles += cycles;
+
+	// Leave the registers as the replacement BIOS would
+	if (fast) {
+		if (!fill) {
+			cpu->gprs[0] = source + length;
+		}
+		cpu->gprs[1] = dest + length;
+		cpu->gprs[2] = dest + units * 4;
+		cpu->gprs[3] = value;
+	} else {
+		cpu->gprs[3] = 0x170;
+	}
+	return true;
+}
+
 static void _Div(struct GBA* gba, int32_t num, int32_t denom) {
 	struct ARMCore* cpu = gba->cpu;
 	if (denom != 0 && (denom != -1 || num != INT32_MIN)) {
@@ -479,7 +600,9 @@ void GBASwi16(struct ARMCore* cpu, int immediate) {
 		if (cpu->gprs[1] & (cpu->gprs[2] & (1 << 26) ? 3 : 1)) {
 			mLOG(GBA_BIOS, GAME_ERROR, "Misaligned CpuSet destination");
 		}
-		ARMRaiseSWI(cpu);
+		if (!_CpuSet(gba, immediate == 0xC)) {
+			ARMRaiseSWI(cpu);
+		}
 		break;
 	case 0xD:
 		cpu->gprs[0] = GBA_BIOS_CHECKSUM;
@@ -609,11 +732,160 @@ uint32_t GBAChecksum(uint32_t* memory, size_t size) {
 	return sum;
 }
 
+// Decompression goes straight to host memory where it can, with the side effects of the
+// stores applied in bulk once it's done. Anything outside of the window uses the bus.
+struct GBABIOSWindow {
+	uint8_t* host;
+	uint32_t address;
+	uint32_t available;
+	int region;
+	uint32_t written;
+};
+
+static void _windowInit(struct GBA* gba, struct GBABIOSWindow* window, uint32_t address, bool write) {
+	struct ARMCore* cpu = gba->cpu;
+	window->host = NULL;
+	window->address = address & ~3;
+	window->available = 0;
+	window->region = address >> BASE_OFFSET;
+	window->written = 0;
+	// Debuggers hook these to see every access
+	if (cpu->memory.load8 != GBALoad8 || cpu->memory.load16 != GBALoad16 || cpu->memory.load32 != GBALoad32) {
+		return;
+	}
+	if (write) {
+		if (cpu->memory.store16 != GBAStore16 || cpu->memory.store32 != GBAStore32) {
+			return;
+		}
+		switch (window->region) {
+		case REGION_WORKING_RAM:
+		case REGION_WORKING_IRAM:
+		case REGION_VRAM:
+			break;
+		default:
+			return;
+		}
+	}
+	window->host = GBAMemoryHostPointer(gba, window->address, &window->available, write);
+	if (!window->host) {
+		window->available = 0;
+	}
+}
+
+static inline uint8_t _windowLoad8(struct ARMCore* cpu, const struct GBABIOSWindow* window, uint32_t address) {
+	uint32_t offset = address - window->address;
+	if (offset < window->available) {
+		return window->host[offset];
+	}
+	return cpu->memory.load8(cpu, address, 0);
+}
+
+static inline uint16_t _windowLoad16(struct ARMCore* cpu, const struct GBABIOSWindow* window, uint32_t address) {
+	uint32_t offset = (address & ~1) - window->address;
+	if (offset < window->available) {
+		uint16_t value;
+		LOAD_16(value, offset, window->host);
+		return value;
+	}
+	return cpu->memory.load16(cpu, address, 0);
+}
+
+static inline uint32_t _windowLoad32(struct ARMCore* cpu, const struct GBABIOSWindow* window, uint32_t address) {
+	if (address & 3) {
+		// Unaligned loads rotate
+		return cpu->memory.load32(cpu, address, 0);
+	}
+	uint32_t offset = address - window->address;
+	if (offset < window->available) {
+		uint32_t value;
+		LOAD_32(value, offset, window->host);
+		return value;
+	}
+	return cpu->memory.load32(cpu, address, 0);
+}
+
+static inline void _windowStore8(struct ARMCore* cpu, struct GBABIOSWindow* window, uint32_t address, uint8_t value) {
+	uint32_t offset = address - window->address;
+	// Byte stores to VRAM are special, so they always take the bus
+	if (offset < window->available && window->region != REGION_VRAM) {
+		window->host[offset] = value;
+		if (offset >= window->written) {
+			window->written = offset + 1;
+		}
+		return;
+	}
+	cpu->memory.store8(cpu, address, value, 0);
+}
+
+static inline void _windowStore16(struct ARMCore* cpu, struct GBABIOSWindow* window, uint32_t address, uint16_t value) {
+	uint32_t offset = (address & ~1) - window->address;
+	if (offset < window->available) {
+		STORE_16(value, offset, window->host);
+		if (offset + 2 > window->written) {
+			window->written = offset + 2;
+		}
+		return;
+	}
+	cpu->memory.store16(cpu, address, value, 0);
+}
+
+static inline void _windowStore32(struct ARMCore* cpu, struct GBABIOSWindow* window, uint32_t address, uint32_t value) {
+	uint32_t offset = (address & ~3) - window->address;
+	if (offset < window->available) {
+		STORE_32(value, offset, window->host);
+		if (offset + 4 > window->written) {
+			window->written = offset + 4;
+		}
+		return;
+	}
+	cpu->memory.store32(cpu, address, value, 0);
+}
+
+static void _windowFinish(struct GBA* gba, struct GBABIOSWindow* window) {
+	struct GBAMemory* memory = &gba->memory;
+	struct ARMCore* cpu = gba->cpu;
+	// Decompression writes start at the beginning of the window and only move forward
+	uint32_t length = window->written;
+	if (!length) {
+		return;
+	}
+	uint32_t offset;
+	uint32_t mask;
+	switch (window->region) {
+	case REGION_WORKING_RAM:
+	case REGION_WORKING_IRAM:
+		if (window->region == REGION_WORKING_RAM) {
+			mask = SIZE_WORKING_RAM - 1;
+			mStatePagesMarkRange(memory->dirtyWram, window->address & mask, (window->address & mask) + length);
+		} else {
+			mask = SIZE_WORKING_IRAM - 1;
+			mStatePagesMarkRange(memory->dirtyIwram, window->address & mask, (window->address & mask) + length);
+		}
+		if (cpu->blockCache) {
+			for (offset = 0; offset < length; offset += 4) {
+				ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(window->address + offset, mask));
+			}
+		}
+		break;
+	case REGION_VRAM:
+		mStatePagesMarkRange(memory->dirtyVram, window->address & 0x0001FFFF, (window->address & 0x0001FFFF) + length);
+		for (offset = 0; offset < length; offset += 2) {
+			gba->video.renderer->writeVRAM(gba->video.renderer, (window->address + offset) & 0x0001FFFE);
+		}
+		break;
+	}
+	window->written = 0;
+}
+
 static void _unLz77(struct GBA* gba, int width) {
 	struct ARMCore* cpu = gba->cpu;
 	uint32_t source = cpu->gprs[0];
 	uint32_t dest = cpu->gprs[1];
-	int remaining = (cpu->memory.load32(cpu, source, 0) & 0xFFFFFF00) >> 8;
+	struct GBABIOSWindow sourceWindow;
+	struct GBABIOSWindow destWindow;
+	_windowInit(gba, &sourceWindow, source, false);
+	_windowInit(gba, &destWindow, dest, true);
+	int remaining = (_windowLoad32(cpu, &sourceWindow, source) & 0xFFFFFF00) >> 8;
 	// We assume the signature byte (0x10) is correct
 	int blockheader = 0; // Some compilers warn if this isn't set, even though it's trivially provably always set
 	source += 4;
@@ -626,7 +898,7 @@ static void _unLz77(struct GBA* gba, int width) {
 		if (blocksRemaining) {
 			if (blockheader & 0x80) {
 				// Compressed
-				int block = cpu->memory.load8(cpu, source + 1, 0) | (cpu->memory.load8(cpu, source, 0) << 8);
+				int block = _windowLoad8(cpu, &sourceWindow, source + 1) | (_windowLoad8(cpu, &sourceWindow, source) << 8);
 				source += 2;
 				disp = dest - (block & 0x0FFF) - 1;
 				bytes = (block >> 12) + 3;
@@ -635,35 +907,35 @@ static void _unLz77(struct GBA* gba, int width) {
 						--remaining;
 					}
 					if (width == 2) {
-						byte = (int16_t) cpu->memory.load16(cpu, disp & ~1, 0);
+						byte = (int16_t) _windowLoad16(cpu, &destWindow, disp & ~1);
 						if (dest & 1) {
 							byte >>= (disp & 1) * 8;
 							halfword |= byte << 8;
-							cpu->memory.store16(cpu, dest ^ 1, halfword, 0);
+							_windowStore16(cpu, &destWindow, dest ^ 1, halfword);
 						} else {
 							byte >>= (disp & 1) * 8;
 							halfword = byte & 0xFF;
 						}
 					} else {
-						byte = cpu->memory.load8(cpu, disp, 0);
-						cpu->memory.store8(cpu, dest, byte, 0);
+						byte = _windowLoad8(cpu, &destWindow, disp);
+						_windowStore8(cpu, &destWindow, dest, byte);
 					}
 					++disp;
 					++dest;
 				}
 			} else {
 				// Uncompressed
-				byte = cpu->memory.load8(cpu, source, 0);
+				byte = _windowLoad8(cpu, &sourceWindow, source);
 				++source;
 				if (width == 2) {
 					if (dest & 1) {
 						halfword |= byte << 8;
-						cpu->memory.store16(cpu, dest ^ 1, halfword, 0);
+						_windowStore16(cpu, &destWindow, dest ^ 1, halfword);
 					} else {
 						halfword = byte;
 					}
 				} else {
-					cpu->memory.store8(cpu, dest, byte, 0);
+					_windowStore8(cpu, &destWindow, dest, byte);
 				}
 				++dest;
 				--remaining;
@@ -671,11 +943,12 @@ static void _unLz77(struct GBA* gba, int width) {
 			blockheader <<= 1;
 			--blocksRemaining;
 		} else {
-			blockheader = cpu->memory.load8(cpu, source, 0);
+			blockheader = _windowLoad8(cpu, &sourceWindow, source);
 			++source;
 			blocksRemaining = 8;
 		}
 	}
+	_windowFinish(gba, &destWindow);
 	cpu->gprs[0] = source;
 	cpu->gprs[1] = dest;
 	cpu->gprs[3] = 0;
@@ -690,7 +963,11 @@ static void _unHuffman(struct GBA* gba) {
 	struct ARMCore* cpu = gba->cpu;
 	uint32_t source = cpu->gprs[0] & 0xFFFFFFFC;
 	uint32_t dest = cpu->gprs[1];
-	uint32_t header = cpu->memory.load32(cpu, source, 0);
+	struct GBABIOSWindow sourceWindow;
+	struct GBABIOSWindow destWindow;
+	_windowInit(gba, &sourceWindow, source, false);
+	_windowInit(gba, &destWindow, dest, true);
+	uint32_t header = _windowLoad32(cpu, &sourceWindow, source);
 	int remaining = header >> 8;
 	unsigned bits = header & 0xF;
 	if (bits == 0) {
@@ -702,7 +979,7 @@ static void _unHuffman(struct GBA* gba) {
 		return;
 	}
 	// We assume the signature byte (0x20) is correct
-	int treesize = (cpu->memory.load8(cpu, source + 4, 0) << 1) + 1;
+	int treesize = (_windowLoad8(cpu, &sourceWindow, source + 4) << 1) + 1;
 	int block = 0;
 	uint32_t treeBase = source + 5;
 	source += 5 + treesize;
@@ -711,28 +988,28 @@ static void _unHuffman(struct GBA* gba) {
 	int bitsRemaining;
 	int readBits;
 	int bitsSeen = 0;
-	node = cpu->memory.load8(cpu, nPointer, 0);
+	node = _windowLoad8(cpu, &sourceWindow, nPointer);
 	while (remaining > 0) {
-		uint32_t bitstream = cpu->memory.load32(cpu, source, 0);
+		uint32_t bitstream = _windowLoad32(cpu, &sourceWindow, source);
 		source += 4;
 		for (bitsRemaining = 32; bitsRemaining > 0 && remaining > 0; --bitsRemaining, bitstream <<= 1) {
 			uint32_t next = (nPointer & ~1) + HuffmanNodeGetOffset(node) * 2 + 2;
 			if (bitstream & 0x80000000) {
 				// Go right
 				if (HuffmanNodeIsRTerm(node)) {
-					readBits = cpu->memory.load8(cpu, next + 1, 0);
+					readBits = _windowLoad8(cpu, &sourceWindow, next + 1);
 				} else {
 					nPointer = next + 1;
-					node = cpu->memory.load8(cpu, nPointer, 0);
+					node = _windowLoad8(cpu, &sourceWindow, nPointer);
 					continue;
 				}
 			} else {
 				// Go left
 				if (HuffmanNodeIsLTerm(node)) {
-					readBits = cpu->memory.load8(cpu, next, 0);
+					readBits = _windowLoad8(cpu, &sourceWindow, next);
 				} else {
 					nPointer = next;
-					node = cpu->memory.load8(cpu, nPointer, 0);
+					node = _windowLoad8(cpu, &sourceWindow, nPointer);
 					continue;
 				}
 			}
@@ -740,16 +1017,17 @@ static void _unHuffman(struct GBA* gba) {
 			block |= (readBits & ((1 << bits) - 1)) << bitsSeen;
 			bitsSeen += bits;
 			nPointer = treeBase;
-			node = cpu->memory.load8(cpu, nPointer, 0);
+			node = _windowLoad8(cpu, &sourceWindow, nPointer);
 			if (bitsSeen == 32) {
 				bitsSeen = 0;
-				cpu->memory.store32(cpu, dest, block, 0);
+				_windowStore32(cpu, &destWindow, dest, block);
 				dest += 4;
 				remaining -= 4;
 				block = 0;
 			}
 		}
 	}
+	_windowFinish(gba, &destWindow);
 	cpu->gprs[0] = source;
 	cpu->gprs[1] = dest;
 }
@@ -757,34 +1035,38 @@ static void _unHuffman(struct GBA* gba) {
 static void _unRl(struct GBA* gba, int width) {
 	struct ARMCore* cpu = gba->cpu;
 	uint32_t source = cpu->gprs[0];
-	int remaining = (cpu->memory.load32(cpu, source & 0xFFFFFFFC, 0) & 0xFFFFFF00) >> 8;
+	uint32_t dest = cpu->gprs[1];
+	struct GBABIOSWindow sourceWindow;
+	struct GBABIOSWindow destWindow;
+	_windowInit(gba, &sourceWindow, source, false);
+	_windowInit(gba, &destWindow, dest, true);
+	int remaining = (_windowLoad32(cpu, &sourceWindow, source & 0xFFFFFFFC) & 0xFFFFFF00) >> 8;
 	int padding = (4 - remaining) & 0x3;
 	// We assume the signature byte (0x30) is correct
 	int blockheader;
 	int block;
 	source += 4;
-	uint32_t dest = cpu->gprs[1];
 	int halfword = 0;
 	while (remaining > 0) {
-		blockheader = cpu->memory.load8(cpu, source, 0);
+		blockheader = _windowLoad8(cpu, &sourceWindow, source);
 		++source;
 		if (blockheader & 0x80) {
 			// Compressed
 			blockheader &= 0x7F;
 			blockheader += 3;
-			block = cpu->memory.load8(cpu, source, 0);
+			block = _windowLoad8(cpu, &sourceWindow, source);
 			++source;
 			while (blockheader-- && remaining) {
 				--remaining;
 				if (width == 2) {
 					if (dest & 1) {
 						halfword |= block << 8;
-						cpu->memory.store16(cpu, dest ^ 1, halfword, 0);
+						_windowStore16(cpu, &destWindow, dest ^ 1, halfword);
 					} else {
 						halfword = block;
 					}
 				} else {
-					cpu->memory.store8(cpu, dest, block, 0);
+					_windowStore8(cpu, &destWindow, dest, block);
 				}
 				++dest;
 			}
@@ -793,17 +1075,17 @@ static void _unRl(struct GBA* gba, int width) {
 			blockheader++;
 			while (blockheader-- && remaining) {
 				--remaining;
-				int byte = cpu->memory.load8(cpu, source, 0);
+				int byte = _windowLoad8(cpu, &sourceWindow, source);
 				++source;
 				if (width == 2) {
 					if (dest & 1) {
 						halfword |= byte << 8;
-						cpu->memory.store16(cpu, dest ^ 1, halfword, 0);
+						_windowStore16(cpu, &destWindow, dest ^ 1, halfword);
 					} else {
 						halfword = byte;
 					}
 				} else {
-					cpu->memory.store8(cpu, dest, byte, 0);
+					_windowStore8(cpu, &destWindow, dest, byte);
 				}
 				++dest;
 			}
@@ -815,14 +1097,15 @@ static void _unRl(struct GBA* gba, int width) {
 			++dest;
 		}
 		for (; padding > 0; padding -= 2, dest += 2) {
-			cpu->memory.store16(cpu, dest, 0, 0);
+			_windowStore16(cpu, &destWindow, dest, 0);
 		}
 	} else {
 		while (padding--) {
-			cpu->memory.store8(cpu, dest, 0, 0);
+			_windowStore8(cpu, &destWindow, dest, 0);
 			++dest;
 		}
 	}
+	_windowFinish(gba, &destWindow);
 	cpu->gprs[0] = source;
 	cpu->gprs[1] = dest;
 }
@@ -900,13 +1183,17 @@ static void _unBitPack(struct GBA* gba) {
 		return;
 	}
 	uint32_t bias = cpu->memory.load32(cpu, info + 4, 0);
+	struct GBABIOSWindow sourceWindow;
+	struct GBABIOSWindow destWindow;
+	_windowInit(gba, &sourceWindow, source, false);
+	_windowInit(gba, &destWindow, dest, true);
 	uint8_t in = 0;
 	uint32_t out = 0;
 	int bitsRemaining = 0;
 	int bitsEaten = 0;
 	while (sourceLen > 0 || bitsRemaining) {
 		if (!bitsRemaining) {
-			in = cpu->memory.load8(cpu, source, 0);
+			in = _windowLoad8(cpu, &sourceWindow, source);
 			bitsRemaining = 8;
 			++source;
 			--sourceLen;
@@ -920,12 +1207,13 @@ static void _unBitPack(struct GBA* gba) {
 		out |= scaled << bitsEaten;
 		bitsEaten += destWidth;
 		if (bitsEaten == 32) {
-			cpu->memory.store32(cpu, dest, out, 0);
+			_windowStore32(cpu, &destWindow, dest, out);
 			bitsEaten = 0;
 			out = 0;
 			dest += 4;
 		}
 	}
+	_windowFinish(gba, &destWindow);
 	cpu->gprs[0] = source;
 	cpu->gprs[1] = dest;
 }
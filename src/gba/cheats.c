@@ -6,6 +6,8 @@
 #include <mgba/internal/gba/cheats.h>
 
 #include <mgba/core/core.h>
+#include <mgba/core/serialize.h>
+#include <mgba/internal/arm/block-cache.h>
 #include <mgba/internal/gba/gba.h>
 #include <mgba-util/string.h>
 #include "gba/cheats/gameshark.h"
@@ -104,11 +106,91 @@ static struct mCheatSet* GBACheatSetCreate(struct mCheatDevice* device, const ch
 	return &set->d;
 }
 
+static const int _cheatRegions[] = { REGION_WORKING_RAM, REGION_WORKING_IRAM };
+
+static void _mapRegions(struct mCheatDevice* device) {
+	if (!device->p) {
+		return;
+	}
+	struct ARMCore* cpu = device->p->cpu;
+	size_t i;
+	for (i = 0; i < device->nRegions; ++i) {
+		// The debugger drops the fast pages while it needs to see every access
+		const struct ARMFastPage* page = cpu->memory.fastPages ? &cpu->memory.fastPages[_cheatRegions[i]] : NULL;
+		device->regions[i].data = page ? (uint8_t*) page->data : NULL;
+	}
+}
+
+static void _written(struct mCheatDevice* device, uint32_t address, int width) {
+	UNUSED(width);
+	struct ARMCore* cpu = device->p->cpu;
+	const struct ARMFastPage* page = &cpu->memory.fastPages[address >> ARM_FAST_PAGE_SHIFT];
+	mStatePageMark(page->dirty, address & page->mask);
+	ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address, page->mask));
+}
+
+static void _freeHookedSets(void* value) {
+	mCheatSetsDeinit(value);
+	free(value);
+}
+
+static void _deinit(struct mCheatDevice* device) {
+	struct GBACheatDevice* gbadevice = (struct GBACheatDevice*) device;
+	TableDeinit(&gbadevice->hooks);
+}
+
 struct mCheatDevice* GBACheatDeviceCreate(void) {
-	struct mCheatDevice* device = malloc(sizeof(*device));
-	mCheatDeviceCreate(device);
-	device->createSet = GBACheatSetCreate;
-	return device;
+	struct GBACheatDevice* device = malloc(sizeof(*device));
+	mCheatDeviceCreate(&device->d);
+	device->d.createSet = GBACheatSetCreate;
+	device->d.deinit = _deinit;
+	device->d.mapRegions = _mapRegions;
+	device->d.written = _written;
+	device->d.nRegions = sizeof(_cheatRegions) / sizeof(*_cheatRegions);
+	size_t i;
+	for (i = 0; i < device->d.nRegions; ++i) {
+		device->d.regions[i].start = _cheatRegions[i] << ARM_FAST_PAGE_SHIFT;
+		device->d.regions[i].size = 1 << ARM_FAST_PAGE_SHIFT;
+		device->d.regions[i].mask = (_cheatRegions[i] == REGION_WORKING_RAM ? SIZE_WORKING_RAM : SIZE_WORKING_IRAM) - 1;
+		device->d.regions[i].data = NULL;
+	}
+	TableInit(&device->hooks, 0, _freeHookedSets);
+	device->hooksRevision = device->d.revision - 1;
+	return &device->d;
+}
+
+struct GBACheatHook* GBACheatRunHooks(struct mCheatDevice* device, uint32_t address) {
+	struct GBACheatDevice* gbadevice = (struct GBACheatDevice*) device;
+	size_t i;
+	if (gbadevice->hooksRevision != device->revision) {
+		TableClear(&gbadevice->hooks);
+		for (i = 0; i < mCheatSetsSize(&device->cheats); ++i) {
+			struct GBACheatSet* cheats = (struct GBACheatSet*) *mCheatSetsGetPointer(&device->cheats, i);
+			if (!cheats->hook) {
+				continue;
+			}
+			struct mCheatSets* hooked = TableLookup(&gbadevice->hooks, cheats->hook->address);
+			if (!hooked) {
+				hooked = malloc(sizeof(*hooked));
+				mCheatSetsInit(hooked, 1);
+				TableInsert(&gbadevice->hooks, cheats->hook->address, hooked);
+			}
+			*mCheatSetsAppend(hooked) = &cheats->d;
+		}
+		gbadevice->hooksRevision = device->revision;
+	}
+
+	struct mCheatSets* hooked = TableLookup(&gbadevice->hooks, address);
+	if (!hooked) {
+		return NULL;
+	}
+	struct GBACheatHook* hook = NULL;
+	for (i = 0; i < mCheatSetsSize(hooked); ++i) {
+		struct GBACheatSet* cheats = (struct GBACheatSet*) *mCheatSetsGetPointer(hooked, i);
+		mCheatRefresh(device, &cheats->d);
+		hook = cheats->hook;
+	}
+	return hook;
 }
 
 static void GBACheatSetDeinit(struct mCheatSet* set) {
@@ -135,8 +135,10 @@ struct GBACore {
 #endif
 #ifndef MINIMAL_CORE
 	struct GBAVideoProxyRenderer vlProxy;
-	struct GBAVideoProxyRenderer proxyRenderer;
 	struct mVideoLogContext* logContext;
+#endif
+#if !defined(MINIMAL_CORE) || !defined(DISABLE_THREADING)
+	struct GBAVideoProxyRenderer proxyRenderer;
 #endif
 	struct mCoreCallbacks logCallbacks;
 #ifndef DISABLE_THREADING
@@ -145,9 +147,13 @@ struct GBACore {
 	int keys;
 	struct mCPUComponent* components[CPU_COMPONENT_MAX];
 	const struct Configuration* overrides;
+	struct Configuration idleLoopCache;
+	uint32_t knownIdleLoop;
 	struct mDebuggerPlatform* debuggerPlatform;
 	struct mCheatDevice* cheatDevice;
 	struct GBAAudioMixer* audioMixer;
+	struct GBASerializedState* copyScratch;
+	enum mColorFormat videoBufferFormat;
 };
 
 static bool _GBACoreInit(struct mCore* core) {
@@ -167,12 +173,16 @@ static bool _GBACoreInit(struct mCore* core) {
 	core->symbolTable = NULL;
 	core->videoLogger = NULL;
 	gbacore->overrides = NULL;
+	ConfigurationInit(&gbacore->idleLoopCache);
+	gbacore->knownIdleLoop = IDLE_LOOP_NONE;
 	gbacore->debuggerPlatform = NULL;
 	gbacore->cheatDevice = NULL;
 #ifndef MINIMAL_CORE
 	gbacore->logContext = NULL;
 #endif
 	gbacore->audioMixer = NULL;
+	gbacore->copyScratch = NULL;
+	gbacore->videoBufferFormat = mCOLOR_NATIVE;
 
 	GBACreate(gba);
 	// TODO: Restore cheats
@@ -195,6 +205,8 @@ static bool _GBACoreInit(struct mCore* core) {
 #endif
 #ifndef MINIMAL_CORE
 	gbacore->vlProxy.logger = NULL;
+#endif
+#if !defined(MINIMAL_CORE) || !defined(DISABLE_THREADING)
 	gbacore->proxyRenderer.logger = NULL;
 #endif
 
@@ -208,6 +220,17 @@ static bool _GBACoreInit(struct mCore* core) {
 	return true;
 }
 
+static void _GBACoreLearnIdleLoop(struct mCore* core) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	struct GBA* gba = core->board;
+	gbacore->knownIdleLoop = gba->idleLoop;
+	const char* path = mCoreConfigGetValue(&core->config, "idleLoopCache");
+	if (path && GBAOverrideLearnIdleLoop(&gbacore->idleLoopCache, gba)) {
+		// Write it out right away; frontends aren't guaranteed to unload cleanly
+		ConfigurationWrite(&gbacore->idleLoopCache, path);
+	}
+}
+
 static void _GBACoreDeinit(struct mCore* core) {
 	ARMDeinit(core->cpu);
 	GBADestroy(core->board);
@@ -229,6 +252,10 @@ static void _GBACoreDeinit(struct mCore* core) {
 	}
 	free(gbacore->cheatDevice);
 	free(gbacore->audioMixer);
+	if (gbacore->copyScratch) {
+		mappedMemoryFree(gbacore->copyScratch, sizeof(struct GBASerializedState));
+	}
+	ConfigurationDeinit(&gbacore->idleLoopCache);
 	mCoreConfigFreeOpts(&core->opts);
 	free(core);
 }
@@ -257,6 +284,38 @@ static void _GBACoreSetSync(struct mCore* core, struct mCoreSync* sync) {
 	gba->sync = sync;
 }
 
+static void _GBACoreUpdateAudioMixer(struct mCore* core) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	struct GBA* gba = core->board;
+	struct ARMCore* cpu = core->cpu;
+	int useAudioMixer = 0;
+	mCoreConfigGetIntValue(&core->config, "gba.audioHle", &useAudioMixer);
+	// A per-game override wins over the global setting in either direction
+	switch (gba->audio.hleMode) {
+	case GBA_AUDIO_HLE_DEFAULT:
+		break;
+	case GBA_AUDIO_HLE_DISABLED:
+		useAudioMixer = 0;
+		break;
+	case GBA_AUDIO_HLE_ENABLED:
+		useAudioMixer = 1;
+		break;
+	}
+	if (useAudioMixer) {
+		if (!gbacore->audioMixer) {
+			gbacore->audioMixer = malloc(sizeof(*gbacore->audioMixer));
+			GBAAudioMixerCreate(gbacore->audioMixer);
+			cpu->components[CPU_COMPONENT_AUDIO_MIXER] = &gbacore->audioMixer->d;
+		}
+		ARMHotplugAttach(cpu, CPU_COMPONENT_AUDIO_MIXER);
+	} else if (gbacore->audioMixer) {
+		ARMHotplugDetach(cpu, CPU_COMPONENT_AUDIO_MIXER);
+		cpu->components[CPU_COMPONENT_AUDIO_MIXER] = NULL;
+		free(gbacore->audioMixer);
+		gbacore->audioMixer = NULL;
+	}
+}
+
 static void _GBACoreLoadConfig(struct mCore* core, const struct mCoreConfig* config) {
 	struct GBA* gba = core->board;
 	if (core->opts.mute) {
@@ -286,18 +345,48 @@ static void _GBACoreLoadConfig(struct mCore* core, const struct mCoreConfig* con
 		}
 	}
 
+	const char* audioResampler = mCoreConfigGetValue(config, "audioResampler");
+	if (audioResampler) {
+		GBAudioSetResampler(&gba->audio.psg, GBAudioNameToResampler(audioResampler));
+	}
+
+	const char* savedataDurability = mCoreConfigGetValue(config, "savedataDurability");
+	if (savedataDurability) {
+		gba->memory.savedata.flusher.durability = mSavedataDurabilityFromName(savedataDurability);
+	}
+
 	int fakeBool = 0;
 	mCoreConfigGetIntValue(config, "allowOpposingDirections", &fakeBool);
 	gba->allowOpposingDirections = fakeBool;
 
+	fakeBool = 0;
+	mCoreConfigGetIntValue(config, "cachedInterpreter", &fakeBool);
+	ARMSetBlockCache(core->cpu, fakeBool);
+
+	unsigned sensorInterval = 1;
+	mCoreConfigGetUIntValue(config, "gba.sensorInterval", &sensorInterval);
+	gba->memory.hw.sensorInterval = sensorInterval;
+
+	const char* idleLoopCache = mCoreConfigGetValue(config, "idleLoopCache");
+	if (idleLoopCache) {
+		struct GBACore* gbacore = (struct GBACore*) core;
+		ConfigurationRead(&gbacore->idleLoopCache, idleLoopCache);
+	}
+
+	mCoreConfigCopyValue(&core->config, config, "accuracy");
 	mCoreConfigCopyValue(&core->config, config, "allowOpposingDirections");
+	mCoreConfigCopyValue(&core->config, config, "cachedInterpreter");
+	mCoreConfigCopyValue(&core->config, config, "idleLoopCache");
 	mCoreConfigCopyValue(&core->config, config, "gba.bios");
 	mCoreConfigCopyValue(&core->config, config, "gba.forceGbp");
 	mCoreConfigCopyValue(&core->config, config, "gba.audioHle");
+	mCoreConfigCopyValue(&core->config, config, "gba.sensorInterval");
 
 #ifndef DISABLE_THREADING
 	mCoreConfigCopyValue(&core->config, config, "threadedVideo");
+	mCoreConfigCopyValue(&core->config, config, "videoThreads");
 #endif
+	mCoreConfigCopyValue(&core->config, config, "videoTileCache");
 	mCoreConfigCopyValue(&core->config, config, "hwaccelVideo");
 	mCoreConfigCopyValue(&core->config, config, "videoScale");
 }
@@ -341,6 +430,15 @@ static void _GBACoreReloadConfigOption(struct mCore* core, const char* option, c
 	if (strcmp("frameskip", option) == 0) {
 		if (mCoreConfigGetIntValue(config, "frameskip", &core->opts.frameskip)) {
 			gba->video.frameskip = core->opts.frameskip;
+			// Start the new cadence on the next frame instead of finishing out the old one
+			gba->video.frameskipCounter = core->opts.frameskip;
+		}
+		return;
+	}
+	if (strcmp("savedataDurability", option) == 0) {
+		const char* savedataDurability = mCoreConfigGetValue(config, "savedataDurability");
+		if (savedataDurability) {
+			gba->memory.savedata.flusher.durability = mSavedataDurabilityFromName(savedataDurability);
 		}
 		return;
 	}
@@ -353,6 +451,71 @@ static void _GBACoreReloadConfigOption(struct mCore* core, const char* option, c
 		}
 		return;
 	}
+	if (strcmp("cachedInterpreter", option) == 0) {
+		if (config != &core->config) {
+			mCoreConfigCopyValue(&core->config, config, "cachedInterpreter");
+		}
+		if (mCoreConfigGetIntValue(config, "cachedInterpreter", &fakeBool)) {
+			ARMSetBlockCache(core->cpu, fakeBool);
+		}
+		return;
+	}
+	if (strcmp("gba.sensorInterval", option) == 0) {
+		if (config != &core->config) {
+			mCoreConfigCopyValue(&core->config, config, "gba.sensorInterval");
+		}
+		unsigned sensorInterval;
+		if (mCoreConfigGetUIntValue(config, "gba.sensorInterval", &sensorInterval)) {
+			gba->memory.hw.sensorInterval = sensorInterval;
+		}
+		return;
+	}
+	if (strcmp("audioResampler", option) == 0) {
+		const char* audioResampler = mCoreConfigGetValue(config, "audioResampler");
+		if (audioResampler) {
+			GBAudioSetResampler(&gba->audio.psg, GBAudioNameToResampler(audioResampler));
+		}
+		return;
+	}
+	if (strcmp("videoTileCache", option) == 0) {
+		struct GBACore* gbacore = (struct GBACore*) core;
+		if (config != &core->config) {
+			mCoreConfigCopyValue(&core->config, config, "videoTileCache");
+		}
+		int fakeBool = 0;
+		mCoreConfigGetIntValue(&core->config, "videoTileCache", &fakeBool);
+		if (gba->video.renderer == &gbacore->renderer.d) {
+			GBAVideoSoftwareRendererSetTileCache(&gbacore->renderer, fakeBool);
+		} else {
+			// Picked up the next time the renderer is initialized
+			gbacore->renderer.decodeTiles = fakeBool;
+		}
+		return;
+	}
+#ifndef DISABLE_THREADING
+	if (strcmp("videoThreads", option) == 0) {
+		struct GBACore* gbacore = (struct GBACore*) core;
+		if (config != &core->config) {
+			mCoreConfigCopyValue(&core->config, config, "videoThreads");
+		}
+		int threads = 0;
+		mCoreConfigGetIntValue(&core->config, "videoThreads", &threads);
+		if (gba->video.renderer == &gbacore->renderer.d) {
+			GBAVideoSoftwareRendererSetThreads(&gbacore->renderer, threads);
+		} else {
+			// Picked up the next time the renderer is initialized
+			gbacore->renderer.threads = threads;
+		}
+		return;
+	}
+#endif
+	if (strcmp("gba.audioHle", option) == 0) {
+		if (config != &core->config) {
+			mCoreConfigCopyValue(&core->config, config, "gba.audioHle");
+		}
+		_GBACoreUpdateAudioMixer(core);
+		return;
+	}
 #if defined(BUILD_GLES2) || defined(BUILD_GLES3)
 	struct GBACore* gbacore = (struct GBACore*) core;
 	if (strcmp("videoScale", option) == 0) {
@@ -382,11 +545,37 @@ static void _GBACoreDesiredVideoDimensions(struct mCore* core, unsigned* width,
 	*height = GBA_VIDEO_VERTICAL_PIXELS * scale;
 }
 
+// Lets the caller touch the software renderer directly while a proxy thread may be driving it
+static void _GBACoreSyncRenderer(struct mCore* core) {
+#if !defined(MINIMAL_CORE) || !defined(DISABLE_THREADING)
+	struct GBACore* gbacore = (struct GBACore*) core;
+	struct GBA* gba = core->board;
+	if (gba->video.renderer == &gbacore->proxyRenderer.d && gbacore->proxyRenderer.logger->block) {
+		mVideoLoggerRendererFlush(gbacore->proxyRenderer.logger);
+	}
+#else
+	UNUSED(core);
+#endif
+}
+
 static void _GBACoreSetVideoBuffer(struct mCore* core, color_t* buffer, size_t stride) {
 	struct GBACore* gbacore = (struct GBACore*) core;
+	_GBACoreSyncRenderer(core);
 	gbacore->renderer.outputBuffer = buffer;
 	gbacore->renderer.outputBufferStride = stride;
-	memset(gbacore->renderer.scanlineDirty, 0xFFFFFFFF, sizeof(gbacore->renderer.scanlineDirty));
+	gbacore->renderer.convertRow = mColorGetRowConverter(gbacore->videoBufferFormat);
+	gbacore->renderer.convertBytes = mColorFormatBytes(gbacore->videoBufferFormat);
+	// Every line has to be drawn again, but that alone doesn't make the frame any different
+	memset(gbacore->renderer.scanlineStale, 0xFFFFFFFF, sizeof(gbacore->renderer.scanlineStale));
+}
+
+static bool _GBACoreSetVideoBufferFormat(struct mCore* core, enum mColorFormat format) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	if (format != mCOLOR_NATIVE && !mColorGetRowConverter(format)) {
+		return false;
+	}
+	gbacore->videoBufferFormat = format;
+	return true;
 }
 
 static void _GBACoreSetVideoGLTex(struct mCore* core, unsigned texid) {
@@ -399,8 +588,22 @@ static void _GBACoreSetVideoGLTex(struct mCore* core, unsigned texid) {
 #endif
 }
 
+static void _GBACoreSetVideoColorTable(struct mCore* core, const color_t* table) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	_GBACoreSyncRenderer(core);
+	GBAVideoSoftwareRendererSetColorTable(&gbacore->renderer, table);
+}
+
 static void _GBACoreGetPixels(struct mCore* core, const void** buffer, size_t* stride) {
 	struct GBA* gba = core->board;
+#if defined(BUILD_GLES2) || defined(BUILD_GLES3)
+	struct GBACore* gbacore = (struct GBACore*) core;
+	if (gba->video.renderer == &gbacore->glRenderer.d) {
+		// Screenshots and savestate thumbnails need this frame, not the one before it
+		GBAVideoGLRendererReadPixels(&gbacore->glRenderer, stride, buffer);
+		return;
+	}
+#endif
 	gba->video.renderer->getPixels(gba->video.renderer, stride, buffer);
 }
 
@@ -409,6 +612,23 @@ static void _GBACorePutPixels(struct mCore* core, const void* buffer, size_t str
 	gba->video.renderer->putPixels(gba->video.renderer, stride, buffer);
 }
 
+static bool _GBACoreVideoFrameChanged(struct mCore* core) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	struct GBA* gba = core->board;
+	struct GBAVideoRenderer* renderer = gba->video.renderer;
+#if !defined(MINIMAL_CORE) || !defined(DISABLE_THREADING)
+	if (renderer == &gbacore->proxyRenderer.d) {
+		// The proxy has finished drawing by the time the frame ends
+		renderer = gbacore->proxyRenderer.backend;
+	}
+#endif
+	if (renderer != &gbacore->renderer.d) {
+		// Only the software renderer knows which scanlines it had to draw again
+		return true;
+	}
+	return gbacore->renderer.frameChanged;
+}
+
 static struct blip_t* _GBACoreGetAudioChannel(struct mCore* core, int ch) {
 	struct GBA* gba = core->board;
 	switch (ch) {
@@ -431,6 +651,11 @@ static size_t _GBACoreGetAudioBufferSize(struct mCore* core) {
 	return gba->audio.samples;
 }
 
+static void _GBACoreSetAudioMuted(struct mCore* core, bool muted) {
+	struct GBA* gba = core->board;
+	gba->audio.muted = muted;
+}
+
 static void _GBACoreAddCoreCallbacks(struct mCore* core, struct mCoreCallbacks* coreCallbacks) {
 	struct GBA* gba = core->board;
 	*mCoreCallbacksListAppend(&gba->coreCallbacks) = *coreCallbacks;
@@ -507,6 +732,11 @@ static void _GBACoreUnloadROM(struct mCore* core) {
 		mCheatDeviceDestroy(gbacore->cheatDevice);
 		gbacore->cheatDevice = NULL;
 	}
+	struct GBA* gba = core->board;
+	if (gba->idleLoop != gbacore->knownIdleLoop) {
+		_GBACoreLearnIdleLoop(core);
+	}
+	gbacore->knownIdleLoop = IDLE_LOOP_NONE;
 	return GBAUnloadROM(core->board);
 }
 
@@ -520,6 +750,32 @@ static void _GBACoreChecksum(const struct mCore* core, void* data, enum mCoreChe
 	return;
 }
 
+static struct GBAVideoRenderer* _GBACoreConfigureRenderer(struct mCore* core) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	struct GBAVideoRenderer* renderer = NULL;
+	int fakeBool;
+	if (gbacore->renderer.outputBuffer) {
+		renderer = &gbacore->renderer.d;
+		if (mCoreConfigGetIntValue(&core->config, "videoTileCache", &fakeBool)) {
+			gbacore->renderer.decodeTiles = fakeBool;
+		}
+#ifndef DISABLE_THREADING
+		mCoreConfigGetIntValue(&core->config, "videoThreads", &gbacore->renderer.threads);
+#endif
+	}
+#if defined(BUILD_GLES2) || defined(BUILD_GLES3)
+	if (gbacore->glRenderer.outputTex != (unsigned) -1 && mCoreConfigGetIntValue(&core->config, "hwaccelVideo", &fakeBool) && fakeBool
+	    && (!renderer || GBAVideoGLRendererIsSupported())) {
+		renderer = &gbacore->glRenderer.d;
+		mCoreConfigGetIntValue(&core->config, "videoScale", &gbacore->glRenderer.scale);
+		if (mCoreConfigGetIntValue(&core->config, "videoAsyncReadback", &fakeBool)) {
+			gbacore->glRenderer.asyncReadback = fakeBool;
+		}
+	}
+#endif
+	return renderer;
+}
+
 static void _GBACoreReset(struct mCore* core) {
 	struct GBACore* gbacore = (struct GBACore*) core;
 	struct GBA* gba = (struct GBA*) core->board;
@@ -529,16 +785,7 @@ static void _GBACoreReset(struct mCore* core) {
 	    || gbacore->glRenderer.outputTex != (unsigned) -1
 #endif
 	) {
-		struct GBAVideoRenderer* renderer = NULL;
-		if (gbacore->renderer.outputBuffer) {
-			renderer = &gbacore->renderer.d;
-		}
-#if defined(BUILD_GLES2) || defined(BUILD_GLES3)
-		if (gbacore->glRenderer.outputTex != (unsigned) -1 && mCoreConfigGetIntValue(&core->config, "hwaccelVideo", &fakeBool) && fakeBool) {
-			renderer = &gbacore->glRenderer.d;
-			mCoreConfigGetIntValue(&core->config, "videoScale", &gbacore->glRenderer.scale);
-		}
-#endif
+		struct GBAVideoRenderer* renderer = _GBACoreConfigureRenderer(core);
 #ifndef DISABLE_THREADING
 		if (mCoreConfigGetIntValue(&core->config, "threadedVideo", &fakeBool) && fakeBool) {
 			if (!core->videoLogger) {
@@ -546,7 +793,7 @@ static void _GBACoreReset(struct mCore* core) {
 			}
 		}
 #endif
-#ifndef MINIMAL_CORE
+#if !defined(MINIMAL_CORE) || !defined(DISABLE_THREADING)
 		if (renderer && core->videoLogger) {
 			gbacore->proxyRenderer.logger = core->videoLogger;
 			GBAVideoProxyRendererCreate(&gbacore->proxyRenderer, renderer);
@@ -558,16 +805,6 @@ static void _GBACoreReset(struct mCore* core) {
 		}
 	}
 
-#ifndef MINIMAL_CORE
-	int useAudioMixer;
-	if (!gbacore->audioMixer && mCoreConfigGetIntValue(&core->config, "gba.audioHle", &useAudioMixer) && useAudioMixer) {
-		gbacore->audioMixer = malloc(sizeof(*gbacore->audioMixer));
-		GBAAudioMixerCreate(gbacore->audioMixer);
-		((struct ARMCore*) core->cpu)->components[CPU_COMPONENT_AUDIO_MIXER] = &gbacore->audioMixer->d;
-		ARMHotplugAttach(core->cpu, CPU_COMPONENT_AUDIO_MIXER);
-	}
-#endif
-
 	bool forceGbp = false;
 	if (mCoreConfigGetIntValue(&core->config, "gba.forceGbp", &fakeBool)) {
 		forceGbp = fakeBool;
@@ -575,10 +812,17 @@ static void _GBACoreReset(struct mCore* core) {
 	if (!forceGbp) {
 		gba->memory.hw.devices &= ~HW_GB_PLAYER_DETECTION;
 	}
+	// Set before the overrides, which may only ever make it more accurate
+	const char* accuracy = mCoreConfigGetValue(&core->config, "accuracy");
+	GBAMemorySetAccuracy(gba, accuracy ? mCoreAccuracyFromName(accuracy) : mCORE_ACCURACY_ACCURATE);
 	GBAOverrideApplyDefaults(gba, gbacore->overrides);
 	if (forceGbp) {
 		gba->memory.hw.devices |= HW_GB_PLAYER_DETECTION;
 	}
+	GBAOverrideApplyIdleLoop(gba, &gbacore->idleLoopCache);
+	gbacore->knownIdleLoop = gba->idleLoop;
+
+	_GBACoreUpdateAudioMixer(core);
 
 #if !defined(MINIMAL_CORE) || MINIMAL_CORE < 2
 	if (!gba->biosVf && core->opts.useBios) {
@@ -636,10 +880,17 @@ static void _GBACoreRunFrame(struct mCore* core) {
 	while (gba->video.frameCounter == frameCounter && mTimingCurrentTime(&gba->timing) - startCycle < VIDEO_TOTAL_LENGTH + VIDEO_HORIZONTAL_LENGTH) {
 		ARMRunLoop(core->cpu);
 	}
+	GBAAudioSample(&gba->audio, mTimingSettledTime(&gba->timing));
+	struct GBACore* gbacore = (struct GBACore*) core;
+	if (gba->idleLoop != gbacore->knownIdleLoop) {
+		_GBACoreLearnIdleLoop(core);
+	}
 }
 
 static void _GBACoreRunLoop(struct mCore* core) {
+	struct GBA* gba = core->board;
 	ARMRunLoop(core->cpu);
+	GBAAudioSample(&gba->audio, mTimingSettledTime(&gba->timing));
 }
 
 static void _GBACoreStep(struct mCore* core) {
@@ -660,6 +911,38 @@ static bool _GBACoreSaveState(struct mCore* core, void* state) {
 	return true;
 }
 
+static size_t _GBACoreListStateRegions(struct mCore* core, const struct mStateRegion** regions) {
+	UNUSED(core);
+	*regions = GBAStateRegions;
+	return GBAStateRegionCount;
+}
+
+static bool _GBACoreSaveStateRegions(struct mCore* core, void* state, uint32_t regions) {
+	GBASerializeRegions(core->board, state, regions);
+	return true;
+}
+
+static bool _GBACoreLoadStateRegions(struct mCore* core, const void* state, uint32_t regions) {
+	return GBADeserializeRegions(core->board, state, regions);
+}
+
+static bool _GBACoreCollectDirtyState(struct mCore* core, uint32_t* pages, size_t size) {
+	return GBACollectDirtyState(core->board, pages, size);
+}
+
+static uint64_t _GBACoreStateHash(struct mCore* core) {
+	return GBAStateHash(core->board);
+}
+
+static bool _GBACoreCopyState(struct mCore* core, struct mCore* source) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	if (!gbacore->copyScratch) {
+		// Most of this is never touched, as memory doesn't go through it
+		gbacore->copyScratch = anonymousMemoryMap(sizeof(struct GBASerializedState));
+	}
+	return GBACopyState(core->board, source->board, gbacore->copyScratch);
+}
+
 static void _GBACoreSetKeys(struct mCore* core, uint32_t keys) {
 	struct GBACore* gbacore = (struct GBACore*) core;
 	gbacore->keys = keys;
@@ -1109,12 +1392,16 @@ struct mCore* GBACoreCreate(void) {
 	core->reloadConfigOption = _GBACoreReloadConfigOption;
 	core->desiredVideoDimensions = _GBACoreDesiredVideoDimensions;
 	core->setVideoBuffer = _GBACoreSetVideoBuffer;
+	core->setVideoBufferFormat = _GBACoreSetVideoBufferFormat;
 	core->setVideoGLTex = _GBACoreSetVideoGLTex;
+	core->setVideoColorTable = _GBACoreSetVideoColorTable;
 	core->getPixels = _GBACoreGetPixels;
 	core->putPixels = _GBACorePutPixels;
+	core->videoFrameChanged = _GBACoreVideoFrameChanged;
 	core->getAudioChannel = _GBACoreGetAudioChannel;
 	core->setAudioBufferSize = _GBACoreSetAudioBufferSize;
 	core->getAudioBufferSize = _GBACoreGetAudioBufferSize;
+	core->setAudioMuted = _GBACoreSetAudioMuted;
 	core->addCoreCallbacks = _GBACoreAddCoreCallbacks;
 	core->clearCoreCallbacks = _GBACoreClearCoreCallbacks;
 	core->setAVStream = _GBACoreSetAVStream;
@@ -1133,6 +1420,12 @@ struct mCore* GBACoreCreate(void) {
 	core->stateSize = _GBACoreStateSize;
 	core->loadState = _GBACoreLoadState;
 	core->saveState = _GBACoreSaveState;
+	core->collectDirtyState = _GBACoreCollectDirtyState;
+	core->copyState = _GBACoreCopyState;
+	core->listStateRegions = _GBACoreListStateRegions;
+	core->saveStateRegions = _GBACoreSaveStateRegions;
+	core->loadStateRegions = _GBACoreLoadStateRegions;
+	core->stateHash = _GBACoreStateHash;
 	core->setKeys = _GBACoreSetKeys;
 	core->addKeys = _GBACoreAddKeys;
 	core->clearKeys = _GBACoreClearKeys;
@@ -1176,6 +1469,7 @@ struct mCore* GBACoreCreate(void) {
 #ifndef MINIMAL_CORE
 	core->startVideoLog = _GBACoreStartVideoLog;
 	core->endVideoLog = _GBACoreEndVideoLog;
+	core->seekVideoLog = NULL;
 #endif
 	return core;
 }
@@ -1223,9 +1517,20 @@ static void _GBAVLPReset(struct mCore* core) {
 	struct GBA* gba = (struct GBA*) core->board;
 	if (gba->video.renderer == &gbacore->vlProxy.d) {
 		GBAVideoProxyRendererUnshim(&gba->video, &gbacore->vlProxy);
-	} else if (gbacore->renderer.outputBuffer) {
-		struct GBAVideoRenderer* renderer = &gbacore->renderer.d;
-		GBAVideoAssociateRenderer(&gba->video, renderer);
+	} else {
+		struct GBAVideoRenderer* renderer = _GBACoreConfigureRenderer(core);
+#ifndef DISABLE_THREADING
+		int fakeBool;
+		if (renderer && mCoreConfigGetIntValue(&core->config, "threadedVideo", &fakeBool) && fakeBool) {
+			// The log drives the render thread the same way emulation would
+			gbacore->proxyRenderer.logger = &gbacore->threadProxy.d;
+			GBAVideoProxyRendererCreate(&gbacore->proxyRenderer, renderer);
+			renderer = &gbacore->proxyRenderer.d;
+		}
+#endif
+		if (renderer) {
+			GBAVideoAssociateRenderer(&gba->video, renderer);
+		}
 	}
 
 	ARMReset(core->cpu);
@@ -1238,6 +1543,20 @@ static void _GBAVLPReset(struct mCore* core) {
 	gba->cpu->memory.store16(gba->cpu, BASE_IO | REG_IE, 0, NULL);
 }
 
+static uint32_t _GBAVLPSeekVideoLog(struct mCore* core, uint32_t frame) {
+	struct GBACore* gbacore = (struct GBACore*) core;
+	struct GBA* gba = core->board;
+	bool shimmed = gba->video.renderer == &gbacore->vlProxy.d;
+	if (shimmed) {
+		GBAVideoProxyRendererUnshim(&gba->video, &gbacore->vlProxy);
+	}
+	uint32_t keyframe = mVideoLogContextSeek(gbacore->logContext, core, frame);
+	if (shimmed) {
+		GBAVideoProxyRendererShim(&gba->video, &gbacore->vlProxy);
+	}
+	return keyframe;
+}
+
 static bool _GBAVLPLoadROM(struct mCore* core, struct VFile* vf) {
 	struct GBACore* gbacore = (struct GBACore*) core;
 	gbacore->logContext = mVideoLogContextCreate(NULL);
@@ -1253,7 +1572,7 @@ static bool _GBAVLPLoadROM(struct mCore* core, struct VFile* vf) {
 static bool _GBAVLPLoadState(struct mCore* core, const void* state) {
 	struct GBA* gba = (struct GBA*) core->board;
 
-	gba->timing.root = NULL;
+	mTimingEventHeapClear(&gba->timing.events);
 	gba->cpu->gprs[ARM_PC] = BASE_WORKING_RAM;
 	gba->cpu->memory.setActiveRegion(gba->cpu, gba->cpu->gprs[ARM_PC]);
 
@@ -1280,6 +1599,13 @@ struct mCore* GBAVideoLogPlayerCreate(void) {
 	core->reset = _GBAVLPReset;
 	core->loadROM = _GBAVLPLoadROM;
 	core->loadState = _GBAVLPLoadState;
+	core->seekVideoLog = _GBAVLPSeekVideoLog;
+	core->collectDirtyState = NULL;
+	core->stateHash = NULL;
+	core->copyState = NULL;
+	core->listStateRegions = NULL;
+	core->saveStateRegions = NULL;
+	core->loadStateRegions = NULL;
 	core->isROM = _returnTrue;
 	return core;
 }
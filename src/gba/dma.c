@@ -5,6 +5,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/internal/gba/dma.h>
 
+#include <mgba/internal/arm/block-cache.h>
+#include <mgba/internal/arm/macros.h>
 #include <mgba/internal/gba/gba.h>
 #include <mgba/internal/gba/io.h>
 
@@ -67,6 +69,7 @@ void GBADMAWriteCNT_LO(struct GBA* gba, int dma, uint16_t count) {
 }
 
 uint16_t GBADMAWriteCNT_HI(struct GBA* gba, int dma, uint16_t control) {
+	GBAVideoSplitHblank(&gba->video);
 	struct GBAMemory* memory = &gba->memory;
 	struct GBADMA* currentDma = &memory->dma[dma];
 	int wasEnabled = GBADMARegisterIsEnable(currentDma->reg);
@@ -226,6 +229,216 @@ void GBADMAUpdate(struct GBA* gba) {
 	}
 }
 
+static uint8_t* _dmaHostPointer(struct GBA* gba, uint32_t address, uint32_t length, bool write) {
+	uint32_t available;
+	uint8_t* pointer = GBAMemoryHostPointer(gba, address, &available, write);
+	return pointer && length <= available ? pointer : NULL;
+}
+
+// How many units could run back to back from here, or 0 if there's no point batching
+static int32_t _dmaBatchUnits(struct GBA* gba, int number, const struct GBADMA* info, int32_t cycles, int32_t* seqCycles) {
+	struct GBAMemory* memory = &gba->memory;
+	uint32_t sourceRegion = info->nextSource >> BASE_OFFSET;
+	uint32_t destRegion = info->nextDest >> BASE_OFFSET;
+	uint32_t now = mTimingCurrentTime(&gba->timing);
+	if (info->when != now || gba->timing.masterCycles != now) {
+		// The CPU still owes cycles, e.g. from entering an IRQ, and they push back the next event once.
+		// Unit by unit that only delays the next unit, but it would delay the end of a whole batch
+		return 0;
+	}
+	int i;
+	for (i = 0; i < 4; ++i) {
+		// Another pending DMA could take over between units, unless it's a
+		// lower priority one that has already started (see GBADMAUpdate)
+		const struct GBADMA* other = &memory->dma[i];
+		if (i == number || !GBADMARegisterIsEnable(other->reg) || !other->nextCount) {
+			continue;
+		}
+		if (i < number || other->count == other->nextCount) {
+			return 0;
+		}
+	}
+
+	// Only units that would run before anything else is scheduled can be batched,
+	// so nothing can observe (or interrupt) the transfer partway through
+	*seqCycles = 2;
+	if (GBADMARegisterGetWidth(info->reg)) {
+		*seqCycles += memory->waitstatesSeq32[sourceRegion] + memory->waitstatesSeq32[destRegion];
+	} else {
+		*seqCycles += memory->waitstatesSeq16[sourceRegion] + memory->waitstatesSeq16[destRegion];
+	}
+	int64_t window = mTimingNextEvent(&gba->timing);
+	if (window <= cycles) {
+		return 0;
+	}
+	int64_t units = 2 + (window - cycles - 1) / *seqCycles;
+	if (units > (int32_t) info->nextCount) {
+		units = info->nextCount;
+	}
+	return units;
+}
+
+static void _dmaBatchFinish(struct GBA* gba, struct GBADMA* info, int32_t units, int32_t cycles, int32_t seqCycles, uint32_t source, uint32_t dest) {
+	uint32_t sourceRegion = info->nextSource >> BASE_OFFSET;
+	uint32_t destRegion = info->nextDest >> BASE_OFFSET;
+	info->when += cycles + (units - 1) * seqCycles;
+	info->nextCount -= units;
+	info->nextSource = source;
+	info->nextDest = dest;
+	if (!info->nextCount) {
+		info->nextCount |= 0x80000000;
+		if (sourceRegion < REGION_CART0 || destRegion < REGION_CART0) {
+			info->when += 2;
+		}
+	}
+	GBADMAUpdate(gba);
+}
+
+static bool _dmaServiceBatch(struct GBA* gba, int number, struct GBADMA* info, int32_t cycles) {
+	struct GBAMemory* memory = &gba->memory;
+	struct ARMCore* cpu = gba->cpu;
+	uint32_t width = 2 << GBADMARegisterGetWidth(info->reg);
+	int32_t wordsRemaining = info->nextCount;
+	uint32_t source = info->nextSource;
+	uint32_t dest = info->nextDest;
+	uint32_t destRegion = dest >> BASE_OFFSET;
+
+	if (wordsRemaining < 2 || !source || GBADMARegisterGetSrcControl(info->reg) != GBA_DMA_INCREMENT) {
+		return false;
+	}
+	bool fifo = false;
+	switch (GBADMARegisterGetDestControl(info->reg)) {
+	case GBA_DMA_INCREMENT:
+	case GBA_DMA_INCREMENT_RELOAD:
+		break;
+	case GBA_DMA_FIXED:
+		// Sound FIFO refills are forced to fixed 32-bit transfers
+		if (GBADMARegisterGetTiming(info->reg) != GBA_DMA_TIMING_CUSTOM || (number != 1 && number != 2)) {
+			return false;
+		}
+		if (dest != (BASE_IO | REG_FIFO_A_LO) && dest != (BASE_IO | REG_FIFO_B_LO)) {
+			return false;
+		}
+		fifo = true;
+		break;
+	default:
+		return false;
+	}
+	if (width == 4) {
+		if (cpu->memory.load32 != GBALoad32 || cpu->memory.store32 != GBAStore32) {
+			return false;
+		}
+	} else if (cpu->memory.load16 != GBALoad16 || cpu->memory.store16 != GBAStore16) {
+		return false;
+	}
+	int32_t seqCycles;
+	int32_t units = _dmaBatchUnits(gba, number, info, cycles, &seqCycles);
+	if (!units) {
+		return false;
+	}
+	uint32_t length = units * width;
+	const uint8_t* from = _dmaHostPointer(gba, source, length, false);
+	if (!from) {
+		return false;
+	}
+	uint8_t* to = NULL;
+	if (!fifo) {
+		to = _dmaHostPointer(gba, dest, length, true);
+		if (!to || (from < to + length && to < from + length)) {
+			return false;
+		}
+	}
+
+	if (width == 4) {
+		LOAD_32(memory->dmaTransferRegister, length - 4, from);
+	} else {
+		uint16_t value;
+		LOAD_16(value, length - 2, from);
+		memory->dmaTransferRegister = value | (value << 16);
+	}
+	gba->bus = memory->dmaTransferRegister;
+	gba->busFromPrefetch = false;
+
+	int i;
+	switch (destRegion) {
+	case REGION_IO:
+		for (i = 0; i < units; ++i) {
+			uint32_t value;
+			LOAD_32(value, i * 4, from);
+			GBAAudioWriteFIFO(&gba->audio, dest & OFFSET_MASK, value);
+		}
+		memory->io[(dest & OFFSET_MASK) >> 1] = memory->dmaTransferRegister;
+		memory->io[((dest & OFFSET_MASK) >> 1) + 1] = memory->dmaTransferRegister >> 16;
+		break;
+	default:
+		GBAMemoryHostCopy(gba, dest, to, from, length, width);
+		break;
+	}
+
+	_dmaBatchFinish(gba, info, units, cycles, seqCycles, source + length, fifo ? dest : dest + length);
+	return true;
+}
+
+// EEPROM commands are streamed a bit per halfword, so a whole command can go at once
+static bool _dmaServiceEEPROM(struct GBA* gba, int number, struct GBADMA* info, int32_t cycles) {
+	struct GBAMemory* memory = &gba->memory;
+	struct GBASavedata* savedata = &memory->savedata;
+	uint32_t source = info->nextSource;
+	uint32_t dest = info->nextDest;
+	bool read = (source >> BASE_OFFSET) == REGION_CART2_EX;
+
+	if (GBADMARegisterIsWidth(info->reg) || read == ((dest >> BASE_OFFSET) == REGION_CART2_EX)) {
+		return false;
+	}
+	if (savedata->type != SAVEDATA_EEPROM && savedata->type != SAVEDATA_EEPROM512) {
+		return false;
+	}
+	if (read ? GBADMARegisterGetDestControl(info->reg) != GBA_DMA_INCREMENT : GBADMARegisterGetSrcControl(info->reg) != GBA_DMA_INCREMENT) {
+		return false;
+	}
+	if (read && savedata->command != EEPROM_COMMAND_READ) {
+		return false;
+	}
+	if (gba->cpu->memory.load16 != GBALoad16 || gba->cpu->memory.store16 != GBAStore16) {
+		return false;
+	}
+	int32_t seqCycles;
+	int32_t units = _dmaBatchUnits(gba, number, info, cycles, &seqCycles);
+	if (read && units > savedata->readBitsRemaining) {
+		units = savedata->readBitsRemaining;
+	}
+	if (units < 2) {
+		return false;
+	}
+	uint32_t length = units * 2;
+	uint8_t* ram = _dmaHostPointer(gba, read ? dest : source, length, read);
+	if (!ram) {
+		return false;
+	}
+
+	uint16_t value;
+	if (read) {
+		uint16_t bits[68];
+		int32_t i;
+		for (i = 0; i < units; ++i) {
+			value = GBASavedataReadEEPROM(savedata);
+			STORE_16(value, i * 2, bits);
+		}
+		GBAMemoryHostCopy(gba, dest, ram, (const uint8_t*) bits, length, 2);
+	} else {
+		GBASavedataWriteEEPROMBlock(savedata, ram, units, info->nextCount, cycles, seqCycles);
+		LOAD_16(value, length - 2, ram);
+	}
+	memory->dmaTransferRegister = value | (value << 16);
+	gba->bus = memory->dmaTransferRegister;
+	gba->busFromPrefetch = false;
+
+	source += DMA_OFFSET[GBADMARegisterGetSrcControl(info->reg)] * 2 * units;
+	dest += DMA_OFFSET[GBADMARegisterGetDestControl(info->reg)] * 2 * units;
+	_dmaBatchFinish(gba, info, units, cycles, seqCycles, source, dest);
+	return true;
+}
+
 void GBADMAService(struct GBA* gba, int number, struct GBADMA* info) {
 	struct GBAMemory* memory = &gba->memory;
 	struct ARMCore* cpu = gba->cpu;
@@ -251,6 +464,9 @@ void GBADMAService(struct GBA* gba, int number, struct GBADMA* info) {
 			cycles += memory->waitstatesSeq16[sourceRegion] + memory->waitstatesSeq16[destRegion];
 		}
 	}
+	if (_dmaServiceBatch(gba, number, info, cycles) || _dmaServiceEEPROM(gba, number, info, cycles)) {
+		return;
+	}
 	info->when += cycles;
 
 	gba->performingDMA = 1 | (number << 1);
@@ -259,6 +475,7 @@ void GBADMAService(struct GBA* gba, int number, struct GBADMA* info) {
 			memory->dmaTransferRegister = cpu->memory.load32(cpu, source, 0);
 		}
 		gba->bus = memory->dmaTransferRegister;
+		gba->busFromPrefetch = false;
 		cpu->memory.store32(cpu, dest, memory->dmaTransferRegister, 0);
 	} else {
 		if (sourceRegion == REGION_CART2_EX && (memory->savedata.type == SAVEDATA_EEPROM || memory->savedata.type == SAVEDATA_EEPROM512)) {
@@ -281,6 +498,7 @@ void GBADMAService(struct GBA* gba, int number, struct GBADMA* info) {
 
 		}
 		gba->bus = memory->dmaTransferRegister;
+		gba->busFromPrefetch = false;
 	}
 	int sourceOffset = DMA_OFFSET[GBADMARegisterGetSrcControl(info->reg)] * width;
 	int destOffset = DMA_OFFSET[GBADMARegisterGetDestControl(info->reg)] * width;
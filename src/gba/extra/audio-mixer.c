@@ -5,305 +5,470 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/internal/gba/extra/audio-mixer.h>
 
-#include <mgba/core/blip_buf.h>
+#include <mgba/internal/arm/macros.h>
 #include <mgba/internal/gba/gba.h>
 #include <mgba/internal/gba/video.h>
 
-#define OVERSAMPLE 2
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define MP2K_FRACTION_BITS 23
+#define MP2K_FRACTION_MASK ((1 << MP2K_FRACTION_BITS) - 1)
+
+#define MP2K_STATUS_ACTIVE 0xC7
+#define MP2K_STATUS_START 0x80
+#define MP2K_TYPE_FIXED 0x08
+// Reversed and compressed samples
+#define MP2K_TYPE_UNSUPPORTED 0x30
+#define MP2K_WAVE_LOOP 0xC000
+#define MP2K_WAVE_HEADER_SIZE 0x10
+
+struct GBAMP2kWave {
+	const int8_t* data;
+	uint32_t size;
+	uint32_t loopStart;
+	bool loop;
+};
 
 static void _mp2kInit(void* cpu, struct mCPUComponent* component);
 static void _mp2kDeinit(struct mCPUComponent* component);
 
-static bool _mp2kEngage(struct GBAAudioMixer* mixer, uint32_t address);
+static bool _mp2kEngage(struct GBAAudioMixer* mixer, uint32_t address, int fifo, bool left);
+static void _mp2kRelease(struct GBAAudioMixer* mixer, int fifo);
 static void _mp2kVblank(struct GBAAudioMixer* mixer);
-static void _mp2kStep(struct GBAAudioMixer* mixer);
+static void _mp2kStep(struct GBAAudioMixer* mixer, int16_t* sampleA, int16_t* sampleB);
 
 void GBAAudioMixerCreate(struct GBAAudioMixer* mixer) {
 	mixer->d.init = _mp2kInit;
 	mixer->d.deinit = _mp2kDeinit;
 	mixer->engage = _mp2kEngage;
+	mixer->release = _mp2kRelease;
 	mixer->vblank = _mp2kVblank;
 	mixer->step = _mp2kStep;
 }
 
+static void _mp2kClear(struct GBAAudioMixer* mixer) {
+	mixer->segment = 0;
+	memset(mixer->voices, 0, sizeof(mixer->voices));
+	memset(mixer->pcm, 0, sizeof(mixer->pcm));
+}
+
 void _mp2kInit(void* cpu, struct mCPUComponent* component) {
 	struct ARMCore* arm = cpu;
 	struct GBA* gba = (struct GBA*) arm->master;
 	struct GBAAudioMixer* mixer = (struct GBAAudioMixer*) component;
 	gba->audio.mixer = mixer;
+	gba->audio.externalMixing = false;
 	mixer->p = &gba->audio;
 	mixer->contextAddress = 0;
-	mixer->tempo = 120.0 / 75.0;
-	mixer->frame = 0;
-	mixer->last.left = 0;
-	mixer->last.right = 0;
+	mixer->fifoSource[0] = -1;
+	mixer->fifoSource[1] = -1;
+	mixer->unsupported = false;
+	mixer->segmentStart = 0;
 	memset(&mixer->context, 0, sizeof(mixer->context));
-	memset(&mixer->activeTracks, 0, sizeof(mixer->activeTracks));
-
-	size_t i;
-	for (i = 0; i < MP2K_MAX_SOUND_CHANNELS; ++i) {
-		mixer->activeTracks[i].channel = &mixer->context.chans[i];
-		CircleBufferInit(&mixer->activeTracks[i].buffer, 0x10000);
-	}
+	_mp2kClear(mixer);
 }
 
 void _mp2kDeinit(struct mCPUComponent* component) {
 	struct GBAAudioMixer* mixer = (struct GBAAudioMixer*) component;
-	size_t i;
-	for (i = 0; i < MP2K_MAX_SOUND_CHANNELS; ++i) {
-		CircleBufferDeinit(&mixer->activeTracks[i].buffer);
+	mixer->p->mixer = NULL;
+	mixer->p->externalMixing = false;
+}
+
+static const void* _mp2kPointer(const struct GBA* gba, uint32_t address, uint32_t size) {
+	const void* base;
+	uint32_t limit;
+	switch (address >> BASE_OFFSET) {
+	case REGION_WORKING_RAM:
+		base = gba->memory.wram;
+		address &= SIZE_WORKING_RAM - 1;
+		limit = SIZE_WORKING_RAM;
+		break;
+	case REGION_WORKING_IRAM:
+		base = gba->memory.iwram;
+		address &= SIZE_WORKING_IRAM - 1;
+		limit = SIZE_WORKING_IRAM;
+		break;
+	case REGION_CART0:
+	case REGION_CART0_EX:
+	case REGION_CART1:
+	case REGION_CART1_EX:
+	case REGION_CART2:
+	case REGION_CART2_EX:
+		base = gba->memory.rom;
+		address &= SIZE_CART0 - 1;
+		limit = gba->memory.romSize;
+		break;
+	default:
+		return NULL;
 	}
+	if (!base || size > limit || address > limit - size) {
+		return NULL;
+	}
+	return (const uint8_t*) base + address;
 }
 
-static void _loadInstrument(struct ARMCore* cpu, struct GBAMP2kInstrument* instrument, uint32_t base) {
-	struct ARMMemory* memory = &cpu->memory;
-	instrument->type = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, type), 0);
-	instrument->key = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, key), 0);
-	instrument->length = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, length), 0);
-	instrument->ps.pan = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, ps.pan), 0);
-	if (instrument->type == 0x40 || instrument->type == 0x80) {
-		instrument->data.subTable = memory->load32(cpu, base + offsetof(struct GBAMP2kInstrument, data.subTable), 0);
-		instrument->extInfo.map = memory->load32(cpu, base + offsetof(struct GBAMP2kInstrument, extInfo.map), 0);
-	} else {
-		instrument->data.waveData = memory->load32(cpu, base + offsetof(struct GBAMP2kInstrument, data.waveData), 0);
-		instrument->extInfo.adsr.attack = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, extInfo.adsr.attack), 0);
-		instrument->extInfo.adsr.decay = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, extInfo.adsr.decay), 0);
-		instrument->extInfo.adsr.sustain = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, extInfo.adsr.sustain), 0);
-		instrument->extInfo.adsr.release = memory->load8(cpu, base + offsetof(struct GBAMP2kInstrument, extInfo.adsr.release), 0);
+static uint32_t _load32(const void* base, size_t offset) {
+	uint32_t value;
+	LOAD_32(value, offset, base);
+	return value;
+}
+
+static uint16_t _load16(const void* base, size_t offset) {
+	uint16_t value;
+	LOAD_16(value, offset, base);
+	return value;
+}
+
+static void _mp2kFallback(struct GBAAudioMixer* mixer) {
+	if (!mixer->p->externalMixing) {
+		return;
+	}
+	GBAAudioSample(mixer->p, mTimingSettledTime(&mixer->p->p->timing));
+	mixer->p->externalMixing = false;
+}
+
+static bool _mp2kReload(struct GBAAudioMixer* mixer) {
+	struct GBAMP2kContext* context = &mixer->context;
+	const uint8_t* base = _mp2kPointer(mixer->p->p, mixer->contextAddress, sizeof(*context));
+	if (!base) {
+		return false;
+	}
+	context->magic = _load32(base, offsetof(struct GBAMP2kContext, magic));
+	if (context->magic - MP2K_MAGIC > 8) {
+		// The driver is gone, but it may come back
+		return false;
 	}
+	int32_t length = _load32(base, offsetof(struct GBAMP2kContext, pcmSamplesPerVBlank));
+	uint8_t period = base[offsetof(struct GBAMP2kContext, pcmDmaPeriod)];
+	if (length <= 0 || !period || length * period > MP2K_PCM_BUFFER_SIZE) {
+		mLOG(GBA_AUDIO, STUB, "Unsupported MP2K buffer layout: %i x %u", length, period);
+		mixer->unsupported = true;
+		return false;
+	}
+	if (length != context->pcmSamplesPerVBlank || period != context->pcmDmaPeriod) {
+		// The driver was reconfigured, so the old output no longer lines up
+		_mp2kClear(mixer);
+	}
+	context->pcmSamplesPerVBlank = length;
+	context->pcmDmaPeriod = period;
+	context->reverb = base[offsetof(struct GBAMP2kContext, reverb)];
+	context->maxChans = base[offsetof(struct GBAMP2kContext, maxChans)];
+	if (context->maxChans > MP2K_MAX_SOUND_CHANNELS) {
+		context->maxChans = MP2K_MAX_SOUND_CHANNELS;
+	}
+	context->divFreq = _load32(base, offsetof(struct GBAMP2kContext, divFreq));
+
+	int i;
+	for (i = 0; i < context->maxChans; ++i) {
+		struct GBAMP2kSoundChannel* ch = &context->chans[i];
+		size_t offset = offsetof(struct GBAMP2kContext, chans[i]);
+		ch->status = base[offset + offsetof(struct GBAMP2kSoundChannel, status)];
+		ch->type = base[offset + offsetof(struct GBAMP2kSoundChannel, type)];
+		ch->envelopeRight = base[offset + offsetof(struct GBAMP2kSoundChannel, envelopeRight)];
+		ch->envelopeLeft = base[offset + offsetof(struct GBAMP2kSoundChannel, envelopeLeft)];
+		ch->fw = _load32(base, offset + offsetof(struct GBAMP2kSoundChannel, fw));
+		ch->freq = _load32(base, offset + offsetof(struct GBAMP2kSoundChannel, freq));
+		ch->waveData = _load32(base, offset + offsetof(struct GBAMP2kSoundChannel, waveData));
+		ch->cp = _load32(base, offset + offsetof(struct GBAMP2kSoundChannel, cp));
+		if ((ch->status & MP2K_STATUS_ACTIVE) && (ch->type & MP2K_TYPE_UNSUPPORTED)) {
+			mLOG(GBA_AUDIO, STUB, "Unsupported MP2K sample type: %02X", ch->type);
+			mixer->unsupported = true;
+			return false;
+		}
+	}
+	return true;
 }
 
-static void _lookupInstrument(struct ARMCore* cpu, struct GBAMP2kInstrument* instrument, uint8_t key) {
-	struct ARMMemory* memory = &cpu->memory;
-	if (instrument->type == 0x40) {
-		uint32_t subInstrumentBase = instrument->data.subTable;
-		uint32_t keyTable = instrument->extInfo.map;
-		uint8_t id = memory->load8(cpu, keyTable + key, 0);
-		subInstrumentBase += 12 * id;
-		_loadInstrument(cpu, instrument, subInstrumentBase);
+static bool _mp2kLoadWave(const struct GBA* gba, uint32_t address, struct GBAMP2kWave* wave) {
+	if (address & 3) {
+		return false;
 	}
-	if (instrument->type == 0x80) {
-		uint32_t subInstrumentBase = instrument->data.subTable;
-		subInstrumentBase += 12 * key;
-		_loadInstrument(cpu, instrument, subInstrumentBase);
+	const void* header = _mp2kPointer(gba, address, MP2K_WAVE_HEADER_SIZE);
+	if (!header) {
+		return false;
+	}
+	wave->loop = _load16(header, 0x2) & MP2K_WAVE_LOOP;
+	wave->loopStart = _load32(header, 0x8);
+	wave->size = _load32(header, 0xC);
+	wave->data = _mp2kPointer(gba, address + MP2K_WAVE_HEADER_SIZE, wave->size);
+	if (wave->loopStart >= wave->size) {
+		wave->loop = false;
 	}
+	return wave->data && wave->size;
 }
 
-static void _stepSample(struct GBAAudioMixer* mixer, struct GBAMP2kTrack* track) {
-	struct ARMCore* cpu = mixer->p->p->cpu;
-	struct ARMMemory* memory = &cpu->memory;
-	uint32_t headerAddress;
-	struct GBAMP2kInstrument instrument = track->track.instrument;
-
-	uint8_t note = track->track.key;
-	_lookupInstrument(cpu, &instrument, note);
-	double freq;
-
-	switch (instrument.type) {
-	case 0x00:
-	case 0x08:
-	case 0x40:
-	case 0x80:
-		freq = GBA_ARM7TDMI_FREQUENCY / (double) track->channel->freq;
-		break;
-	default:
-		// We don't care about PSG channels
+// Produces the driver's interpolated samples, with 8 extra bits of precision, until the block or the sample ends
+static int _mp2kRenderWave(const struct GBAMP2kWave* wave, int16_t* out, int length, uint32_t step, bool interpolate, uint32_t* position, uint32_t* fraction) {
+	uint32_t pos = *position;
+	uint32_t frac = *fraction;
+	int i;
+	for (i = 0; i < length && pos < wave->size; ++i) {
+		int sample = wave->data[pos];
+		if (interpolate) {
+			int next;
+			if (pos + 1 < wave->size) {
+				next = wave->data[pos + 1];
+			} else if (wave->loop) {
+				next = wave->data[wave->loopStart];
+			} else {
+				next = sample;
+			}
+			out[i] = sample * 256 + (((next - sample) * (int32_t) frac) >> (MP2K_FRACTION_BITS - 8));
+		} else {
+			out[i] = sample * 256;
+		}
+		frac += step;
+		pos += frac >> MP2K_FRACTION_BITS;
+		frac &= MP2K_FRACTION_MASK;
+		if (pos >= wave->size && wave->loop) {
+			pos = wave->loopStart + (pos - wave->size) % (wave->size - wave->loopStart);
+		}
+	}
+	*position = pos;
+	*fraction = frac;
+	return i;
+}
+
+// Finds where a block that consumed this many samples and ended at `end` must have started
+static uint32_t _mp2kRewind(const struct GBAMP2kWave* wave, uint32_t end, uint64_t consumed) {
+	if (consumed <= end) {
+		return end - consumed;
+	}
+	if (!wave->loop) {
+		return 0;
+	}
+	uint32_t loopLength = wave->size - wave->loopStart;
+	if (consumed >= wave->size && wave->loopStart + (consumed - wave->size) % loopLength == end) {
+		// A note that started this block and already went around the loop
+		return 0;
+	}
+	uint32_t back = (consumed - (end - wave->loopStart)) % loopLength;
+	return back ? wave->size - back : wave->loopStart;
+}
+
+static void _mp2kAccumulate(int32_t* out, const int16_t* samples, int count, int volume) {
+	int i = 0;
+#if defined(__SSE2__)
+	__m128i zero = _mm_setzero_si128();
+	__m128i scale = _mm_set1_epi16(volume);
+	for (; i + 8 <= count; i += 8) {
+		__m128i in = _mm_loadu_si128((const __m128i*) &samples[i]);
+		// Pairing every sample with a zero turns pmaddwd into a widening multiply
+		__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(in, zero), scale);
+		__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(in, zero), scale);
+		_mm_storeu_si128((__m128i*) &out[i], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &out[i]), lo));
+		_mm_storeu_si128((__m128i*) &out[i + 4], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &out[i + 4]), hi));
+	}
+#elif defined(__ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+		vst1q_s32(&out[i], vmlal_n_s16(vld1q_s32(&out[i]), vld1_s16(&samples[i]), volume));
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] += samples[i] * volume;
+	}
+}
+
+static void _mp2kStore(int16_t* out, const int32_t* in, int count) {
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_srai_epi32(_mm_loadu_si128((const __m128i*) &in[i]), 8);
+		__m128i hi = _mm_srai_epi32(_mm_loadu_si128((const __m128i*) &in[i + 4]), 8);
+		_mm_storeu_si128((__m128i*) &out[i], _mm_packs_epi32(lo, hi));
+	}
+#elif defined(__ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+		vst1_s16(&out[i], vqshrn_n_s32(vld1q_s32(&in[i]), 8));
+	}
+#endif
+	for (; i < count; ++i) {
+		int32_t sample = in[i] >> 8;
+		if (sample > INT16_MAX) {
+			sample = INT16_MAX;
+		} else if (sample < INT16_MIN) {
+			sample = INT16_MIN;
+		}
+		out[i] = sample;
+	}
+}
+
+static void _mp2kRenderVoice(struct GBAAudioMixer* mixer, int id, int32_t* right, int32_t* left) {
+	const struct GBAMP2kSoundChannel* channel = &mixer->context.chans[id];
+	struct GBAMP2kVoice* voice = &mixer->voices[id];
+	struct GBAMP2kVoice last = *voice;
+	int length = mixer->context.pcmSamplesPerVBlank;
+	bool active = (channel->status & MP2K_STATUS_ACTIVE) && !(channel->status & MP2K_STATUS_START);
+	bool resumable = last.active && last.waveData == channel->waveData;
+	voice->active = false;
+	if (!active && !resumable) {
 		return;
 	}
-	headerAddress = instrument.data.waveData;
-	if (headerAddress < 0x20) {
-		mLOG(GBA_AUDIO, ERROR, "Audio track has invalid instrument");
+
+	struct GBAMP2kWave wave;
+	if (!_mp2kLoadWave(mixer->p->p, channel->waveData, &wave)) {
+		if (active) {
+			mLOG(GBA_AUDIO, ERROR, "Audio channel has invalid sample");
+		}
 		return;
 	}
-	uint32_t loopOffset = memory->load32(cpu, headerAddress + 0x8, 0);
-	uint32_t endOffset = memory->load32(cpu, headerAddress + 0xC, 0);
-	uint32_t sampleBase = headerAddress + 0x10;
-	uint32_t sampleI = track->samplePlaying;
-	double sampleOffset = track->currentOffset;
-	double updates = VIDEO_TOTAL_LENGTH / (mixer->tempo * mixer->p->sampleInterval / OVERSAMPLE);
-	int nSample;
-	for (nSample = 0; nSample < updates; ++nSample) {
-		int8_t sample = memory->load8(cpu, sampleBase + sampleI, 0);
-
-		struct GBAStereoSample stereo = {
-			(sample * track->channel->leftVolume * track->channel->envelopeV) >> 9,
-			(sample * track->channel->rightVolume * track->channel->envelopeV) >> 9
-		};
-
-		CircleBufferWrite16(&track->buffer, stereo.left);
-		CircleBufferWrite16(&track->buffer, stereo.right);
-
-		sampleOffset += mixer->p->sampleInterval / OVERSAMPLE;
-		while (sampleOffset > freq) {
-			sampleOffset -= freq;
-			++sampleI;
-			if (sampleI >= endOffset) {
-				sampleI = loopOffset;
-			}
+	bool interpolate = !(channel->type & MP2K_TYPE_FIXED);
+	uint32_t step = interpolate ? channel->freq * mixer->context.divFreq : 1 << MP2K_FRACTION_BITS;
+	int16_t samples[MP2K_PCM_BUFFER_SIZE];
+	uint32_t position = last.position;
+	uint32_t fraction = last.fraction;
+	int count;
+
+	if (active) {
+		uint32_t end = channel->cp - (channel->waveData + MP2K_WAVE_HEADER_SIZE);
+		if (end > wave.size) {
+			return;
+		}
+		voice->active = true;
+		voice->waveData = channel->waveData;
+		voice->position = end;
+		voice->fraction = channel->fw & MP2K_FRACTION_MASK;
+
+		// The driver has already mixed this block, so its state describes the end of it.
+		// Continuing from the last block is exact; otherwise work backwards from the end.
+		bool resumed = false;
+		if (resumable) {
+			count = _mp2kRenderWave(&wave, samples, length, step, interpolate, &position, &fraction);
+			resumed = position == voice->position && fraction == voice->fraction;
+		}
+		if (!resumed) {
+			fraction = (voice->fraction - step * (uint32_t) length) & MP2K_FRACTION_MASK;
+			position = _mp2kRewind(&wave, end, (fraction + (uint64_t) step * length) >> MP2K_FRACTION_BITS);
+			count = _mp2kRenderWave(&wave, samples, length, step, interpolate, &position, &fraction);
+		}
+	} else {
+		if (wave.loop) {
+			return;
+		}
+		// A sample that ran out partway through the block still played up to its end,
+		// but one stopped by its envelope wasn't mixed at all
+		count = _mp2kRenderWave(&wave, samples, length, step, interpolate, &position, &fraction);
+		if (count == length) {
+			return;
 		}
 	}
 
-	track->samplePlaying = sampleI;
-	track->currentOffset = sampleOffset;
+	if (channel->envelopeRight) {
+		_mp2kAccumulate(right, samples, count, channel->envelopeRight);
+	}
+	if (channel->envelopeLeft) {
+		_mp2kAccumulate(left, samples, count, channel->envelopeLeft);
+	}
 }
 
-static void _mp2kReload(struct GBAAudioMixer* mixer) {
-	struct ARMCore* cpu = mixer->p->p->cpu;
-	struct ARMMemory* memory = &cpu->memory;
-	mixer->context.magic = memory->load32(cpu, mixer->contextAddress + offsetof(struct GBAMP2kContext, magic), 0);
+static void _mp2kRender(struct GBAAudioMixer* mixer) {
+	const struct GBAMP2kContext* context = &mixer->context;
+	int length = context->pcmSamplesPerVBlank;
+	int32_t right[MP2K_PCM_BUFFER_SIZE];
+	int32_t left[MP2K_PCM_BUFFER_SIZE];
+
+	mixer->segment = (mixer->segment + 1) % context->pcmDmaPeriod;
+	int16_t* outRight = &mixer->pcm[0][mixer->segment * length];
+	int16_t* outLeft = &mixer->pcm[1][mixer->segment * length];
 	int i;
-	for (i = 0; i < MP2K_MAX_SOUND_CHANNELS; ++i) {
-		struct GBAMP2kSoundChannel* ch = &mixer->context.chans[i];
-		struct GBAMP2kTrack* track = &mixer->activeTracks[i];
-		track->waiting = false;
-		uint32_t base = mixer->contextAddress + offsetof(struct GBAMP2kContext, chans[i]);
-
-		ch->status = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, status), 0);
-		ch->type = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, type), 0);
-		ch->rightVolume = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, rightVolume), 0);
-		ch->leftVolume = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, leftVolume), 0);
-		ch->adsr.attack = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, adsr.attack), 0);
-		ch->adsr.decay = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, adsr.decay), 0);
-		ch->adsr.sustain = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, adsr.sustain), 0);
-		ch->adsr.release = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, adsr.release), 0);
-		ch->ky = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, ky), 0);
-		ch->envelopeV = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, envelopeV), 0);
-		ch->envelopeRight = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, envelopeRight), 0);
-		ch->envelopeLeft = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, envelopeLeft), 0);
-		ch->echoVolume = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, echoVolume), 0);
-		ch->echoLength = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, echoLength), 0);
-		ch->d1 = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, d1), 0);
-		ch->d2 = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, d2), 0);
-		ch->gt = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, gt), 0);
-		ch->midiKey = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, midiKey), 0);
-		ch->ve = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, ve), 0);
-		ch->pr = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, pr), 0);
-		ch->rp = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, rp), 0);
-		ch->d3[0] = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, d3[0]), 0);
-		ch->d3[1] = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, d3[1]), 0);
-		ch->d3[2] = memory->load8(cpu, base + offsetof(struct GBAMP2kSoundChannel, d3[2]), 0);
-		ch->ct = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, ct), 0);
-		ch->fw = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, fw), 0);
-		ch->freq = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, freq), 0);
-		ch->waveData = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, waveData), 0);
-		ch->cp = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, cp), 0);
-		ch->track = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, track), 0);
-		ch->pp = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, pp), 0);
-		ch->np = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, np), 0);
-		ch->d4 = memory->load32(cpu, base + offsetof(struct GBAMP2kSoundChannel, d4), 0);
-		ch->xpi = memory->load16(cpu, base + offsetof(struct GBAMP2kSoundChannel, xpi), 0);
-		ch->xpc = memory->load16(cpu, base + offsetof(struct GBAMP2kSoundChannel, xpc), 0);
-
-		base = ch->track;
-		if (base) {
-			track->track.flags = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, flags), 0);
-			track->track.wait = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, wait), 0);
-			track->track.patternLevel = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, patternLevel), 0);
-			track->track.repN = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, repN), 0);
-			track->track.gateTime = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, gateTime), 0);
-			track->track.key = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, key), 0);
-			track->track.velocity = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, velocity), 0);
-			track->track.runningStatus = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, runningStatus), 0);
-			track->track.keyM = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, keyM), 0);
-			track->track.pitM = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, pitM), 0);
-			track->track.keyShift = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, keyShift), 0);
-			track->track.keyShiftX = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, keyShiftX), 0);
-			track->track.tune = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, tune), 0);
-			track->track.pitX = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, pitX), 0);
-			track->track.bend = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, bend), 0);
-			track->track.bendRange = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, bendRange), 0);
-			track->track.volMR = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, volMR), 0);
-			track->track.volML = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, volML), 0);
-			track->track.vol = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, vol), 0);
-			track->track.volX = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, volX), 0);
-			track->track.pan = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, pan), 0);
-			track->track.panX = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, panX), 0);
-			track->track.modM = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, modM), 0);
-			track->track.mod = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, mod), 0);
-			track->track.modT = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, modT), 0);
-			track->track.lfoSpeed = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, lfoSpeed), 0);
-			track->track.lfoSpeedC = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, lfoSpeedC), 0);
-			track->track.lfoDelay = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, lfoDelay), 0);
-			track->track.lfoDelayC = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, lfoDelayC), 0);
-			track->track.priority = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, priority), 0);
-			track->track.echoVolume = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, echoVolume), 0);
-			track->track.echoLength = memory->load8(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, echoLength), 0);
-			track->track.chan = memory->load32(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, chan), 0);
-			_loadInstrument(cpu, &track->track.instrument, base + offsetof(struct GBAMP2kMusicPlayerTrack, instrument));
-			track->track.cmdPtr = memory->load32(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, cmdPtr), 0);
-			track->track.patternStack[0] = memory->load32(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, patternStack[0]), 0);
-			track->track.patternStack[1] = memory->load32(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, patternStack[1]), 0);
-			track->track.patternStack[2] = memory->load32(cpu, base + offsetof(struct GBAMP2kMusicPlayerTrack, patternStack[2]), 0);
-		} else {
-			memset(&track->track, 0, sizeof(track->track));
-		}
-		if (track->track.runningStatus == 0xCD) {
-			// XCMD isn't supported
-			mixer->p->externalMixing = false;
+	if (context->reverb) {
+		// Like the driver, echo the block being replaced and the one after it into both sides
+		int next = ((mixer->segment + 1) % context->pcmDmaPeriod) * length;
+		const int16_t* nextRight = &mixer->pcm[0][next];
+		const int16_t* nextLeft = &mixer->pcm[1][next];
+		for (i = 0; i < length; ++i) {
+			int32_t echo = outRight[i] + outLeft[i] + nextRight[i] + nextLeft[i];
+			right[i] = ((echo * context->reverb) >> 9) * 256;
+			left[i] = right[i];
 		}
+	} else {
+		memset(right, 0, length * sizeof(*right));
+		memset(left, 0, length * sizeof(*left));
 	}
+
+	for (i = 0; i < context->maxChans; ++i) {
+		_mp2kRenderVoice(mixer, i, right, left);
+	}
+
+	_mp2kStore(outRight, right, length);
+	_mp2kStore(outLeft, left, length);
 }
 
-bool _mp2kEngage(struct GBAAudioMixer* mixer, uint32_t address) {
-	if (address < BASE_WORKING_RAM) {
+bool _mp2kEngage(struct GBAAudioMixer* mixer, uint32_t address, int fifo, bool left) {
+	switch (address >> BASE_OFFSET) {
+	case REGION_WORKING_RAM:
+	case REGION_WORKING_IRAM:
+		break;
+	default:
 		return false;
 	}
 	if (address != mixer->contextAddress) {
+		_mp2kFallback(mixer);
 		mixer->contextAddress = address;
+		mixer->fifoSource[0] = -1;
+		mixer->fifoSource[1] = -1;
+		mixer->unsupported = false;
+		memset(&mixer->context, 0, sizeof(mixer->context));
+		_mp2kClear(mixer);
+	}
+	mixer->fifoSource[fifo] = left;
+	if (mixer->unsupported) {
+		return false;
+	}
+	if (!mixer->p->externalMixing) {
+		GBAAudioSample(mixer->p, mTimingSettledTime(&mixer->p->p->timing));
+		mixer->segmentStart = mTimingSettledTime(&mixer->p->p->timing);
 		mixer->p->externalMixing = true;
-		_mp2kReload(mixer);
 	}
 	return true;
 }
 
-void _mp2kStep(struct GBAAudioMixer* mixer) {
-	mixer->frame += mixer->p->sampleInterval;
-
-	while (mixer->frame >= VIDEO_TOTAL_LENGTH / mixer->tempo) {
-		int i;
-		for (i = 0; i < MP2K_MAX_SOUND_CHANNELS; ++i) {
-			struct GBAMP2kTrack* track = &mixer->activeTracks[i];
-			if (track->channel->status > 0) {
-				_stepSample(mixer, track);
-			} else {
-				track->currentOffset = 0;
-				track->samplePlaying = 0;
-				CircleBufferClear(&track->buffer);
-			}
-		}
-		mixer->frame -= VIDEO_TOTAL_LENGTH / mixer->tempo;
+void _mp2kRelease(struct GBAAudioMixer* mixer, int fifo) {
+	if (mixer->fifoSource[fifo] < 0) {
+		return;
 	}
+	GBAAudioSample(mixer->p, mTimingSettledTime(&mixer->p->p->timing));
+	mixer->fifoSource[fifo] = -1;
+	if (mixer->fifoSource[fifo ^ 1] < 0) {
+		mixer->p->externalMixing = false;
+	}
+}
 
-	uint32_t interval = mixer->p->sampleInterval / OVERSAMPLE;
-	int i;
-	for (i = 0; i < OVERSAMPLE; ++i) {
-		struct GBAStereoSample sample = {0};
-		size_t track;
-		for (track = 0; track < MP2K_MAX_SOUND_CHANNELS; ++track) {
-			if (!mixer->activeTracks[track].channel->status) {
-				continue;
-			}
-			int16_t value;
-			CircleBufferRead16(&mixer->activeTracks[track].buffer, &value);
-			sample.left += value;
-			CircleBufferRead16(&mixer->activeTracks[track].buffer, &value);
-			sample.right += value;
-		}
-		sample.left = (sample.left * mixer->p->masterVolume) >> 8;
-		sample.right = (sample.right * mixer->p->masterVolume) >> 8;
-		if (mixer->p->externalMixing) {
-			blip_add_delta(mixer->p->psg.left, mixer->p->clock + i * interval, sample.left - mixer->last.left);
-			blip_add_delta(mixer->p->psg.right, mixer->p->clock + i * interval, sample.right - mixer->last.right);
+void _mp2kStep(struct GBAAudioMixer* mixer, int16_t* sampleA, int16_t* sampleB) {
+	// Hold each of the driver's samples for its share of the frame, as its timer would
+	int32_t length = mixer->context.pcmSamplesPerVBlank;
+	int32_t elapsed = mixer->p->nextSample - mixer->segmentStart;
+	int32_t index = 0;
+	if (elapsed > 0) {
+		index = (int64_t) elapsed * length / VIDEO_TOTAL_LENGTH;
+		if (index >= length) {
+			index = length - 1;
 		}
-		mixer->last = sample;
+	}
+	index += mixer->segment * length;
+	if (mixer->fifoSource[0] >= 0) {
+		*sampleA = mixer->pcm[mixer->fifoSource[0]][index] >> 6;
+	}
+	if (mixer->fifoSource[1] >= 0) {
+		*sampleB = mixer->pcm[mixer->fifoSource[1]][index] >> 6;
 	}
 }
 
 void _mp2kVblank(struct GBAAudioMixer* mixer) {
-	if (!mixer->contextAddress) {
+	if (!mixer->p->externalMixing) {
+		return;
+	}
+	uint32_t now = mTimingCurrentTime(&mixer->p->p->timing);
+	// Everything due until now still plays the last block
+	GBAAudioSample(mixer->p, now);
+	if (!_mp2kReload(mixer)) {
+		_mp2kFallback(mixer);
 		return;
 	}
-	mLOG(GBA_AUDIO, DEBUG, "Frame");
-	mixer->p->externalMixing = true;
-	_mp2kReload(mixer);
+	_mp2kRender(mixer);
+	mixer->segmentStart = now;
 }
@@ -190,8 +190,17 @@ static bool _parsePacket(struct mVideoLogger* logger, const struct mVideoLoggerD
 		break;
 	case DIRTY_VRAM:
 		if (item->address <= SIZE_VRAM - 0x1000) {
-			logger->readData(logger, &logger->vram[item->address >> 1], 0x1000, true);
-			proxyRenderer->backend->writeVRAM(proxyRenderer->backend, item->address);
+			// Backends track VRAM writes per halfword (e.g. for decoded tiles), so report each one that changed
+			uint16_t block[0x800];
+			uint16_t* vram = &logger->vram[item->address >> 1];
+			size_t i;
+			logger->readData(logger, block, 0x1000, true);
+			for (i = 0; i < 0x800; ++i) {
+				if (vram[i] != block[i]) {
+					vram[i] = block[i];
+					proxyRenderer->backend->writeVRAM(proxyRenderer->backend, item->address + i * 2);
+				}
+			}
 		} else {
 			logger->readData(logger, NULL, 0x1000, true);
 		}
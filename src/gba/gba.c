@@ -15,6 +15,8 @@
 #include <mgba/internal/gba/overrides.h>
 #include <mgba/internal/gba/rr/rr.h>
 
+#include <mgba/core/core.h>
+
 #include <mgba-util/patch.h>
 #include <mgba-util/crc32.h>
 #include <mgba-util/math.h>
@@ -42,7 +44,6 @@ static const size_t GBA_MB_MAGIC_OFFSET = 0xC0;
 
 static void GBAInit(void* cpu, struct mCPUComponent* component);
 static void GBAInterruptHandlerInit(struct ARMInterruptHandler* irqh);
-static void GBAProcessEvents(struct ARMCore* cpu);
 static void GBAHitStub(struct ARMCore* cpu, uint32_t opcode);
 static void GBAIllegal(struct ARMCore* cpu, uint32_t opcode);
 static void GBABreakpoint(struct ARMCore* cpu, int immediate);
@@ -76,6 +77,7 @@ static void GBAInit(void* cpu, struct mCPUComponent* component) {
 	GBAMemoryInit(gba);
 
 	gba->memory.savedata.timing = &gba->timing;
+	mSavedataFlusherInit(&gba->memory.savedata.flusher);
 	GBASavedataInit(&gba->memory.savedata, NULL);
 
 	gba->video.p = gba;
@@ -90,6 +92,7 @@ static void GBAInit(void* cpu, struct mCPUComponent* component) {
 	GBASIOInit(&gba->sio);
 
 	GBAHardwareInit(&gba->memory.hw, NULL);
+	gba->memory.hw.sensorInterval = 1;
 
 	gba->keySource = 0;
 	gba->rotationSource = 0;
@@ -151,12 +154,14 @@ void GBAUnloadROM(struct GBA* gba) {
 
 	gba->memory.savedata.maskWriteback = false;
 	GBASavedataUnmask(&gba->memory.savedata);
+	GBASavedataFinish(&gba->memory.savedata);
 	GBASavedataDeinit(&gba->memory.savedata);
 	if (gba->memory.savedata.realVf) {
 		gba->memory.savedata.realVf->close(gba->memory.savedata.realVf);
 		gba->memory.savedata.realVf = 0;
 	}
 	gba->idleLoop = IDLE_LOOP_NONE;
+	gba->audio.hleMode = GBA_AUDIO_HLE_DEFAULT;
 }
 
 void GBADestroy(struct GBA* gba) {
@@ -168,8 +173,9 @@ void GBADestroy(struct GBA* gba) {
 		gba->biosVf = 0;
 	}
 
-	GBAMemoryDeinit(gba);
+	mSavedataFlusherDeinit(&gba->memory.savedata.flusher);
 	GBAVideoDeinit(&gba->video);
+	GBAMemoryDeinit(gba);
 	GBAAudioDeinit(&gba->audio);
 	GBASIODeinit(&gba->sio);
 	gba->rr = 0;
@@ -268,31 +274,52 @@ void GBASkipBIOS(struct GBA* gba) {
 	}
 }
 
-static void GBAProcessEvents(struct ARMCore* cpu) {
-	struct GBA* gba = (struct GBA*) cpu->master;
-
+void GBALatchBus(struct GBA* gba) {
+	struct ARMCore* cpu = gba->cpu;
 	gba->bus = cpu->prefetch[1];
 	if (cpu->executionMode == MODE_THUMB) {
 		gba->bus |= cpu->prefetch[1] << 16;
 	}
+	gba->busFromPrefetch = false;
+}
+
+// Events that block the CPU, i.e. DMAs, keep time going until they're done
+static int32_t _processBlockedEvents(struct GBA* gba, int32_t nextEvent) {
+	struct ARMCore* cpu = gba->cpu;
+	do {
+		int32_t cycles = cpu->cycles;
+		cpu->cycles = 0;
+#ifndef NDEBUG
+		if (cycles < 0) {
+			mLOG(GBA, FATAL, "Negative cycles passed: %i", cycles);
+		}
+#endif
+		nextEvent = mTimingTick(&gba->timing, nextEvent + cycles);
+	} while (gba->cpuBlocked);
+	return nextEvent;
+}
+
+void GBAProcessEvents(struct ARMCore* cpu) {
+	struct GBA* gba = (struct GBA*) cpu->master;
+	gba->busFromPrefetch = true;
 
 	int32_t nextEvent = cpu->nextEvent;
 	while (cpu->cycles >= nextEvent) {
+		int32_t cycles = cpu->cycles;
+		cpu->cycles = 0;
 		cpu->nextEvent = INT_MAX;
-		nextEvent = 0;
-		do {
-			int32_t cycles = cpu->cycles;
-			cpu->cycles = 0;
 #ifndef NDEBUG
-			if (cycles < 0) {
-				mLOG(GBA, FATAL, "Negative cycles passed: %i", cycles);
-			}
+		if (cycles < 0) {
+			mLOG(GBA, FATAL, "Negative cycles passed: %i", cycles);
+		}
 #endif
-			nextEvent = mTimingTick(&gba->timing, nextEvent + cycles);
-		} while (gba->cpuBlocked);
+		nextEvent = mTimingTick(&gba->timing, cycles);
+		if (UNLIKELY(gba->cpuBlocked)) {
+			nextEvent = _processBlockedEvents(gba, nextEvent);
+		}
 
 		cpu->nextEvent = nextEvent;
-		if (cpu->halted) {
+		if (UNLIKELY(cpu->halted)) {
 			cpu->cycles = nextEvent;
 			if (!gba->memory.io[REG_IME >> 1] || !gba->memory.io[REG_IE >> 1]) {
 				break;
@@ -303,7 +330,7 @@ static void GBAProcessEvents(struct ARMCore* cpu) {
 			mLOG(GBA, FATAL, "Negative cycles will pass: %i", nextEvent);
 		}
 #endif
-		if (gba->earlyExit) {
+		if (UNLIKELY(gba->earlyExit)) {
 			break;
 		}
 	}
@@ -366,6 +393,7 @@ bool GBALoadMB(struct GBA* gba, struct VFile* vf) {
 	}
 	gba->isPristine = true;
 	memset(gba->memory.wram, 0, SIZE_WORKING_RAM);
+	gba->memory.dirtyTracked = false;
 	gba->yankedRomSize = 0;
 	gba->memory.romSize = 0;
 	gba->memory.romMask = 0;
@@ -416,8 +444,12 @@ bool GBALoadROM(struct GBA* gba, struct VFile* vf) {
 	if (popcount32(gba->memory.romSize) != 1) {
 		// This ROM is either a bad dump or homebrew. Emulate flash cart behavior.
 #ifndef FIXED_ROM_BUFFER
-		void* newRom = anonymousMemoryMap(SIZE_CART0);
-		memcpy(newRom, gba->memory.rom, gba->pristineRomSize);
+		void* newRom = VFileMapCopyOnWrite(vf, gba->pristineRomSize, SIZE_CART0);
+		if (!newRom) {
+			newRom = anonymousMemoryMap(SIZE_CART0);
+			memcpy(newRom, gba->memory.rom, gba->pristineRomSize);
+		}
+		vf->unmap(vf, gba->memory.rom, gba->pristineRomSize);
 		gba->memory.rom = newRom;
 #endif
 		gba->memory.romSize = SIZE_CART0;
@@ -483,10 +515,24 @@ void GBAApplyPatch(struct GBA* gba, struct Patch* patch) {
 	if (!patchedSize || patchedSize > SIZE_CART0) {
 		return;
 	}
-	void* newRom = anonymousMemoryMap(SIZE_CART0);
-	if (!patch->applyPatch(patch, gba->memory.rom, gba->pristineRomSize, newRom, patchedSize)) {
-		mappedMemoryFree(newRom, SIZE_CART0);
-		return;
+	void* newRom = NULL;
+	// The CRC32 taken when the ROM was loaded only covers it while it's pristine
+	patch->hasInputCrc32 = gba->isPristine;
+	patch->inputCrc32 = gba->romCrc32;
+	if (gba->isPristine && gba->romVf) {
+		// Patch a private mapping of the ROM in place, so unpatched pages stay shared with the file
+		newRom = VFileMapCopyOnWrite(gba->romVf, gba->pristineRomSize, SIZE_CART0);
+		if (newRom && !patch->applyPatch(patch, newRom, gba->pristineRomSize, newRom, patchedSize)) {
+			mappedMemoryFree(newRom, SIZE_CART0);
+			newRom = NULL;
+		}
+	}
+	if (!newRom) {
+		newRom = anonymousMemoryMap(SIZE_CART0);
+		if (!patch->applyPatch(patch, gba->memory.rom, gba->pristineRomSize, newRom, patchedSize)) {
+			mappedMemoryFree(newRom, SIZE_CART0);
+			return;
+		}
 	}
 	if (gba->romVf) {
 #ifndef FIXED_ROM_BUFFER
@@ -500,7 +546,7 @@ void GBAApplyPatch(struct GBA* gba, struct Patch* patch) {
 	gba->memory.hw.gpioBase = &((uint16_t*) gba->memory.rom)[GPIO_REG_DATA >> 1];
 	gba->memory.romSize = patchedSize;
 	gba->memory.romMask = SIZE_CART0 - 1;
-	gba->romCrc32 = doCrc32(gba->memory.rom, gba->memory.romSize);
+	gba->romCrc32 = patch->hasOutputCrc32 ? patch->outputCrc32 : doCrc32(gba->memory.rom, gba->memory.romSize);
 }
 
 void GBARaiseIRQ(struct GBA* gba, enum GBAIRQ irq, uint32_t cyclesLate) {
@@ -684,6 +730,36 @@ bool GBAIsMB(struct VFile* vf) {
 	return false;
 }
 
+bool GBAIdentifyROM(struct VFile* vf, struct mCoreROMInfo* info) {
+#ifdef USE_ELF
+	struct ELF* elf = ELFOpen(vf);
+	if (elf) {
+		// Only the loaded segments are checksummed, so this takes a core
+		ELFClose(elf);
+		return false;
+	}
+#endif
+	struct GBACartridge cart;
+	if (vf->seek(vf, 0, SEEK_SET) < 0 || vf->read(vf, &cart, sizeof(cart)) != (ssize_t) sizeof(cart)) {
+		return false;
+	}
+	memcpy(info->title, cart.title, sizeof(cart.title));
+	memcpy(info->code, "AGB-", 4);
+	memcpy(&info->code[4], &cart.id, sizeof(cart.id));
+	info->size = vf->size(vf);
+	// Like GBALoadROM and GBALoadMB, only what fits in the cartridge or working RAM counts
+	size_t crcSize = info->size;
+	if (GBAIsMB(vf)) {
+		if (crcSize > SIZE_WORKING_RAM) {
+			crcSize = SIZE_WORKING_RAM;
+		}
+	} else if (crcSize > SIZE_CART0) {
+		crcSize = SIZE_CART0;
+	}
+	info->crc32 = fileCrc32(vf, crcSize);
+	return true;
+}
+
 bool GBAIsBIOS(struct VFile* vf) {
 	if (vf->seek(vf, 0, SEEK_SET) < 0) {
 		return false;
@@ -784,15 +860,7 @@ void GBABreakpoint(struct ARMCore* cpu, int immediate) {
 	case CPU_COMPONENT_CHEAT_DEVICE:
 		if (gba->cpu->components[CPU_COMPONENT_CHEAT_DEVICE]) {
 			struct mCheatDevice* device = (struct mCheatDevice*) gba->cpu->components[CPU_COMPONENT_CHEAT_DEVICE];
-			struct GBACheatHook* hook = 0;
-			size_t i;
-			for (i = 0; i < mCheatSetsSize(&device->cheats); ++i) {
-				struct GBACheatSet* cheats = (struct GBACheatSet*) *mCheatSetsGetPointer(&device->cheats, i);
-				if (cheats->hook && cheats->hook->address == _ARMPCAddress(cpu)) {
-					mCheatRefresh(device, &cheats->d);
-					hook = cheats->hook;
-				}
-			}
+			struct GBACheatHook* hook = GBACheatRunHooks(device, _ARMPCAddress(cpu));
 			if (hook) {
 				ARMRunFake(cpu, hook->patchedOpcode);
 			}
@@ -822,6 +890,11 @@ void GBAFrameStarted(struct GBA* gba) {
 void GBAFrameEnded(struct GBA* gba) {
 	GBASavedataClean(&gba->memory.savedata, gba->video.frameCounter);
 
+	if (!gba->timing.statsClock) {
+		// Counting waits turns these off, see GBASetActiveRegion
+		gba->cpu->memory.fastPages = gba->memory.fastPages;
+	}
+
 	if (gba->rr) {
 		gba->rr->nextFrame(gba->rr);
 	}
@@ -879,8 +952,6 @@ void GBATestKeypadIRQ(struct GBA* gba) {
 }
 
 static void _triggerIRQ(struct mTiming* timing, void* user, uint32_t cyclesLate) {
-	UNUSED(timing);
-	UNUSED(cyclesLate);
 	struct GBA* gba = user;
 	gba->cpu->halted = 0;
 	if (!(gba->memory.io[REG_IE >> 1] & gba->memory.io[REG_IF >> 1])) {
@@ -888,6 +959,11 @@ static void _triggerIRQ(struct mTiming* timing, void* user, uint32_t cyclesLate)
 	}
 
 	if (gba->memory.io[REG_IME >> 1] && !gba->cpu->cpsr.i) {
+		// Entering the handler refills the prefetch, which DMAs later in the same batch must not see
+		if (gba->busFromPrefetch) {
+			GBALatchBus(gba);
+		}
+		GBAVideoSplitDueHblank(&gba->video, timing->masterCycles - cyclesLate);
 		ARMRaiseIRQ(gba->cpu);
 	}
 }
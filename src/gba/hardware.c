@@ -70,6 +70,7 @@ void GBAHardwareClear(struct GBACartridgeHardware* hw) {
 	hw->readWrite = GPIO_WRITE_ONLY;
 	hw->pinState = 0;
 	hw->direction = 0;
+	hw->sensorsCached = 0;
 
 	if (hw->p->sio.drivers.normal == &hw->gbpDriver.d) {
 		GBASIOSetDriver(&hw->p->sio, 0, SIO_NORMAL_32);
@@ -281,16 +282,35 @@ unsigned _rtcOutput(struct GBACartridgeHardware* hw) {
 	return output;
 }
 
+static bool _sensorCached(struct GBACartridgeHardware* hw, uint32_t device, int32_t* sampleFrame) {
+	if (!hw->sensorInterval) {
+		return false;
+	}
+	int32_t frame = hw->p->video.frameCounter;
+	if ((hw->sensorsCached & device) && (uint32_t) (frame - *sampleFrame) < hw->sensorInterval) {
+		return true;
+	}
+	hw->sensorsCached |= device;
+	*sampleFrame = frame;
+	return false;
+}
+
 void _rtcUpdateClock(struct GBACartridgeHardware* hw) {
 	time_t t;
 	struct mRTCSource* rtc = hw->p->rtcSource;
-	if (rtc) {
-		if (rtc->sample) {
-			rtc->sample(rtc);
-		}
-		t = rtc->unixTime(rtc);
+	if (_sensorCached(hw, HW_RTC, &hw->rtcSampleFrame)) {
+		// Between samples the clock runs off emulated time
+		t = hw->rtcSampleTime + (hw->p->video.frameCounter - hw->rtcSampleFrame) * (int64_t) VIDEO_TOTAL_LENGTH / GBA_ARM7TDMI_FREQUENCY;
 	} else {
-		t = time(0);
+		if (rtc) {
+			if (rtc->sample) {
+				rtc->sample(rtc);
+			}
+			t = rtc->unixTime(rtc);
+		} else {
+			t = time(0);
+		}
+		hw->rtcSampleTime = t;
 	}
 	struct tm date;
 	localtime_r(&t, &date);
@@ -350,10 +370,13 @@ void _gyroReadPins(struct GBACartridgeHardware* hw) {
 	}
 
 	if (hw->pinState & 1) {
-		if (gyro->sample) {
-			gyro->sample(gyro);
+		if (!_sensorCached(hw, HW_GYRO, &hw->gyroSampleFrame)) {
+			if (gyro->sample) {
+				gyro->sample(gyro);
+			}
+			hw->gyroZ = gyro->readGyroZ(gyro);
 		}
-		int32_t sample = gyro->readGyroZ(gyro);
+		int32_t sample = hw->gyroZ;
 
 		// Normalize to ~12 bits, focused on 0x6C0
 		hw->gyroSample = (sample >> 21) + 0x6C0; // Crop off an extra bit so that we can't go negative
@@ -403,8 +426,11 @@ void _lightReadPins(struct GBACartridgeHardware* hw) {
 		mLOG(GBA_HW, DEBUG, "[SOLAR] Got reset");
 		hw->lightCounter = 0;
 		if (lux) {
-			lux->sample(lux);
-			hw->lightSample = lux->readLuminance(lux);
+			if (!_sensorCached(hw, HW_LIGHT_SENSOR, &hw->lightSampleFrame)) {
+				lux->sample(lux);
+				hw->luminance = lux->readLuminance(lux);
+			}
+			hw->lightSample = hw->luminance;
 		} else {
 			hw->lightSample = 0xFF;
 		}
@@ -444,11 +470,15 @@ void GBAHardwareTiltWrite(struct GBACartridgeHardware* hw, uint32_t address, uin
 			if (!rotationSource || !rotationSource->readTiltX || !rotationSource->readTiltY) {
 				return;
 			}
-			if (rotationSource->sample) {
-				rotationSource->sample(rotationSource);
+			if (!_sensorCached(hw, HW_TILT, &hw->tiltSampleFrame)) {
+				if (rotationSource->sample) {
+					rotationSource->sample(rotationSource);
+				}
+				hw->rawTiltX = rotationSource->readTiltX(rotationSource);
+				hw->rawTiltY = rotationSource->readTiltY(rotationSource);
 			}
-			int32_t x = rotationSource->readTiltX(rotationSource);
-			int32_t y = rotationSource->readTiltY(rotationSource);
+			int32_t x = hw->rawTiltX;
+			int32_t y = hw->rawTiltY;
 			// Normalize to ~12 bits, focused on 0x3A0
 			hw->tiltX = (x >> 21) + 0x3A0; // Crop off an extra bit so that we can't go negative
 			hw->tiltY = (y >> 21) + 0x3A0;
@@ -632,6 +662,7 @@ void GBAHardwareDeserialize(struct GBACartridgeHardware* hw, const struct GBASer
 	LOAD_16(hw->pinState, 0, &state->hw.pinState);
 	LOAD_16(hw->direction, 0, &state->hw.pinDirection);
 	hw->devices = state->hw.devices;
+	hw->sensorsCached = 0;
 
 	LOAD_32(hw->rtc.bytesRemaining, 0, &state->hw.rtc.bytesRemaining);
 	LOAD_32(hw->rtc.transferStep, 0, &state->hw.rtc.transferStep);
@@ -402,10 +402,12 @@ void GBAIOWrite(struct GBA* gba, uint32_t address, uint16_t value) {
 			break;
 		case REG_SOUNDCNT_HI:
 			GBAAudioWriteSOUNDCNT_HI(&gba->audio, value);
+			GBATimerUpdateEvents(gba);
 			value &= 0x770F;
 			break;
 		case REG_SOUNDCNT_X:
 			GBAAudioWriteSOUNDCNT_X(&gba->audio, value);
+			GBATimerUpdateEvents(gba);
 			value &= 0x0080;
 			value |= gba->memory.io[REG_SOUNDCNT_X >> 1] & 0xF;
 			break;
@@ -614,6 +616,14 @@ void GBAIOWrite8(struct GBA* gba, uint32_t address, uint8_t value) {
 }
 
 void GBAIOWrite32(struct GBA* gba, uint32_t address, uint32_t value) {
+	if (address > REG_VCOUNT && address < REG_SOUND1CNT_LO) {
+		// Both halves go straight to the renderer, so there's nothing to dispatch on
+		struct GBAVideoRenderer* renderer = gba->video.renderer;
+		gba->memory.io[address >> 1] = renderer->writeVideoRegister(renderer, address, value);
+		gba->memory.io[(address >> 1) + 1] = renderer->writeVideoRegister(renderer, address | 2, value >> 16);
+		return;
+	}
+
 	switch (address) {
 	case REG_WAVE_RAM0_LO:
 		GBAAudioWriteWaveRAM(&gba->audio, 0, value);
@@ -655,6 +665,50 @@ void GBAIOWrite32(struct GBA* gba, uint32_t address, uint32_t value) {
 	case REG_DMA3DAD_LO:
 		value = GBADMAWriteDAD(gba, 3, value);
 		break;
+
+	// Count and control are usually written together
+	case REG_DMA0CNT_LO:
+		GBADMAWriteCNT_LO(gba, 0, value & 0x3FFF);
+		gba->memory.io[REG_DMA0CNT_LO >> 1] = value;
+		gba->memory.io[REG_DMA0CNT_HI >> 1] = GBADMAWriteCNT_HI(gba, 0, value >> 16);
+		return;
+	case REG_DMA1CNT_LO:
+		GBADMAWriteCNT_LO(gba, 1, value & 0x3FFF);
+		gba->memory.io[REG_DMA1CNT_LO >> 1] = value;
+		gba->memory.io[REG_DMA1CNT_HI >> 1] = GBADMAWriteCNT_HI(gba, 1, value >> 16);
+		return;
+	case REG_DMA2CNT_LO:
+		GBADMAWriteCNT_LO(gba, 2, value & 0x3FFF);
+		gba->memory.io[REG_DMA2CNT_LO >> 1] = value;
+		gba->memory.io[REG_DMA2CNT_HI >> 1] = GBADMAWriteCNT_HI(gba, 2, value >> 16);
+		return;
+	case REG_DMA3CNT_LO:
+		GBADMAWriteCNT_LO(gba, 3, value);
+		gba->memory.io[REG_DMA3CNT_LO >> 1] = value;
+		gba->memory.io[REG_DMA3CNT_HI >> 1] = GBADMAWriteCNT_HI(gba, 3, value >> 16);
+		return;
+
+	// The counter half isn't stored, since it reads back the live count
+	case REG_TM0CNT_LO:
+		GBATimerWriteTMCNT_LO(gba, 0, value);
+		GBATimerWriteTMCNT_HI(gba, 0, (value >> 16) & 0x00C7);
+		gba->memory.io[REG_TM0CNT_HI >> 1] = (value >> 16) & 0x00C7;
+		return;
+	case REG_TM1CNT_LO:
+		GBATimerWriteTMCNT_LO(gba, 1, value);
+		GBATimerWriteTMCNT_HI(gba, 1, (value >> 16) & 0x00C7);
+		gba->memory.io[REG_TM1CNT_HI >> 1] = (value >> 16) & 0x00C7;
+		return;
+	case REG_TM2CNT_LO:
+		GBATimerWriteTMCNT_LO(gba, 2, value);
+		GBATimerWriteTMCNT_HI(gba, 2, (value >> 16) & 0x00C7);
+		gba->memory.io[REG_TM2CNT_HI >> 1] = (value >> 16) & 0x00C7;
+		return;
+	case REG_TM3CNT_LO:
+		GBATimerWriteTMCNT_LO(gba, 3, value);
+		GBATimerWriteTMCNT_HI(gba, 3, (value >> 16) & 0x00C7);
+		gba->memory.io[REG_TM3CNT_HI >> 1] = (value >> 16) & 0x00C7;
+		return;
 	default:
 		if (address >= REG_DEBUG_STRING && address - REG_DEBUG_STRING < sizeof(gba->debugString)) {
 			STORE_32LE(value, address - REG_DEBUG_STRING, gba->debugString);
@@ -857,8 +911,9 @@ uint16_t GBAIORead(struct GBA* gba, uint32_t address) {
 			return 0;
 		}
 		// Fall through
-	case REG_DISPCNT:
 	case REG_DISPSTAT:
+		return GBAVideoReadDISPSTAT(&gba->video);
+	case REG_DISPCNT:
 	case REG_VCOUNT:
 	case REG_BG0CNT:
 	case REG_BG1CNT:
@@ -937,6 +992,7 @@ void GBAIOSerialize(struct GBA* gba, struct GBASerializedState* state) {
 			STORE_16(reg, i, state->io);
 		}
 	}
+	STORE_16(GBAVideoReadDISPSTAT(&gba->video), REG_DISPSTAT, state->io);
 
 	for (i = 0; i < 4; ++i) {
 		STORE_16(gba->memory.io[(REG_DMA0CNT_LO + i * 12) >> 1], (REG_DMA0CNT_LO + i * 12), state->io);
@@ -974,11 +1030,7 @@ void GBAIODeserialize(struct GBA* gba, const struct GBASerializedState* state) {
 		LOAD_32(when, 0, &state->timers[i].lastEvent);
 		gba->timers[i].lastEvent = when + mTimingCurrentTime(&gba->timing);
 		LOAD_32(when, 0, &state->timers[i].nextEvent);
-		if ((i < 1 || !GBATimerFlagsIsCountUp(gba->timers[i].flags)) && GBATimerFlagsIsEnable(gba->timers[i].flags)) {
-			mTimingSchedule(&gba->timing, &gba->timers[i].event, when);
-		} else {
-			gba->timers[i].event.when = when + mTimingCurrentTime(&gba->timing);
-		}
+		gba->timers[i].event.when = when + mTimingCurrentTime(&gba->timing);
 
 		LOAD_16(gba->memory.dma[i].reg, (REG_DMA0CNT_HI + i * 12), state->io);
 		LOAD_32(gba->memory.dma[i].nextSource, 0, &state->dma[i].nextSource);
@@ -987,6 +1039,7 @@ void GBAIODeserialize(struct GBA* gba, const struct GBASerializedState* state) {
 		LOAD_32(gba->memory.dma[i].when, 0, &state->dma[i].when);
 	}
 	GBAAudioWriteSOUNDCNT_X(&gba->audio, gba->memory.io[REG_SOUNDCNT_X >> 1]);
+	GBATimerUpdateEvents(gba);
 
 	LOAD_32(gba->memory.dmaTransferRegister, 0, &state->dmaTransferRegister);
 
@@ -11,8 +11,20 @@
 #include <mgba-util/vfs.h>
 
 static void _remapMatrix(struct GBA* gba) {
-	gba->romVf->seek(gba->romVf, gba->memory.matrix.paddr, SEEK_SET);
-	gba->romVf->read(gba->romVf, &gba->memory.rom[gba->memory.matrix.vaddr >> 2], gba->memory.matrix.size);
+	struct GBAMatrix* matrix = &gba->memory.matrix;
+	uint8_t* window = (uint8_t*) gba->memory.rom + matrix->vaddr;
+	uint32_t size = matrix->size;
+	if (size > SIZE_CART0 - matrix->vaddr) {
+		size = SIZE_CART0 - matrix->vaddr;
+	}
+#ifndef FIXED_ROM_BUFFER
+	// Whole pages can share the file's pages instead of being read in, which is most of what video carts move
+	if (VFileRemapCopyOnWrite(gba->romVf, window, matrix->paddr, size)) {
+		return;
+	}
+#endif
+	gba->romVf->seek(gba->romVf, matrix->paddr, SEEK_SET);
+	gba->romVf->read(gba->romVf, window, size);
 }
 
 void GBAMatrixReset(struct GBA* gba) {
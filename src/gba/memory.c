@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/internal/gba/memory.h>
 
+#include <mgba/internal/arm/block-cache.h>
 #include <mgba/internal/arm/decoder.h>
 #include <mgba/internal/arm/macros.h>
 #include <mgba/internal/gba/gba.h>
@@ -27,8 +28,6 @@ static int16_t  _agbPrintLoad(struct GBA* gba, uint32_t address);
 static uint8_t _deadbeef[4] = { 0x10, 0xB7, 0x10, 0xE7 }; // Illegal instruction on both ARM and Thumb
 static uint8_t _agbPrintFunc[4] = { 0xFA, 0xDF /* swi 0xFF */, 0x70, 0x47 /* bx lr */ };
 
-static void GBASetActiveRegion(struct ARMCore* cpu, uint32_t region);
-static int32_t GBAMemoryStall(struct ARMCore* cpu, int32_t wait);
 
 static const char GBA_BASE_WAITSTATES[16] = { 0, 0, 2, 0, 0, 0, 0, 0, 4, 4, 4, 4, 4, 4, 4 };
 static const char GBA_BASE_WAITSTATES_32[16] = { 0, 0, 5, 0, 0, 1, 1, 0, 7, 7, 9, 9, 13, 13, 9 };
@@ -37,6 +36,15 @@ static const char GBA_BASE_WAITSTATES_SEQ_32[16] = { 0, 0, 5, 0, 0, 1, 1, 0, 5,
 static const char GBA_ROM_WAITSTATES[] = { 4, 3, 2, 8 };
 static const char GBA_ROM_WAITSTATES_SEQ[] = { 2, 1, 4, 1, 8, 1 };
 
+static void _setFastPage(struct GBAMemory* memory, int region, uint32_t* data, uint32_t* dirty, uint32_t size) {
+	struct ARMFastPage* page = &memory->fastPages[region];
+	page->data = data;
+	page->dirty = dirty;
+	page->mask = size - 1;
+	page->waitstates16 = memory->waitstatesNonseq16[region];
+	page->waitstates32 = memory->waitstatesNonseq32[region];
+}
+
 void GBAMemoryInit(struct GBA* gba) {
 	struct ARMCore* cpu = gba->cpu;
 	cpu->memory.load32 = GBALoad32;
@@ -51,6 +59,8 @@ void GBAMemoryInit(struct GBA* gba) {
 
 	gba->memory.bios = (uint32_t*) hleBios;
 	gba->memory.fullBios = 0;
+	gba->memory.accuracy = mCORE_ACCURACY_ACCURATE;
+	gba->memory.arena = 0;
 	gba->memory.wram = 0;
 	gba->memory.iwram = 0;
 	gba->memory.rom = 0;
@@ -87,15 +97,30 @@ void GBAMemoryInit(struct GBA* gba) {
 	memset(&gba->memory.agbPrintCtx, 0, sizeof(gba->memory.agbPrintCtx));
 	gba->memory.agbPrintBuffer = NULL;
 
-	gba->memory.wram = anonymousMemoryMap(SIZE_WORKING_RAM + SIZE_WORKING_IRAM);
-	gba->memory.iwram = &gba->memory.wram[SIZE_WORKING_RAM >> 2];
+	gba->memory.arena = anonymousMemoryMap(GBA_ARENA_SIZE);
+	if (gba->memory.arena) {
+		gba->memory.wram = (uint32_t*) &gba->memory.arena[GBA_ARENA_WRAM];
+		gba->memory.iwram = (uint32_t*) &gba->memory.arena[GBA_ARENA_IWRAM];
+	}
+
+	// Only the RAM regions are free of side effects, so only they get a fast path
+	memset(gba->memory.fastPages, 0, sizeof(gba->memory.fastPages));
+	if (gba->memory.wram) {
+		_setFastPage(&gba->memory, REGION_WORKING_RAM, gba->memory.wram, gba->memory.dirtyWram, SIZE_WORKING_RAM);
+		_setFastPage(&gba->memory, REGION_WORKING_IRAM, gba->memory.iwram, gba->memory.dirtyIwram, SIZE_WORKING_IRAM);
+	}
+	cpu->memory.fastPages = gba->memory.fastPages;
 
 	GBADMAInit(gba);
 	GBAVFameInit(&gba->memory.vfame);
 }
 
 void GBAMemoryDeinit(struct GBA* gba) {
-	mappedMemoryFree(gba->memory.wram, SIZE_WORKING_RAM + SIZE_WORKING_IRAM);
+	memset(gba->memory.fastPages, 0, sizeof(gba->memory.fastPages));
+	mappedMemoryFree(gba->memory.arena, GBA_ARENA_SIZE);
+	gba->memory.arena = 0;
+	gba->memory.wram = 0;
+	gba->memory.iwram = 0;
 	if (gba->memory.rom) {
 		mappedMemoryFree(gba->memory.rom, gba->memory.romSize);
 	}
@@ -116,6 +141,10 @@ void GBAMemoryReset(struct GBA* gba) {
 	memset(gba->memory.io, 0, sizeof(gba->memory.io));
 	GBAAdjustWaitstates(gba, 0);
 
+	if (gba->cpu->blockCache) {
+		ARMBlockCacheClear(gba->cpu->blockCache);
+	}
+
 	gba->memory.agbPrint = 0;
 	memset(&gba->memory.agbPrintCtx, 0, sizeof(gba->memory.agbPrintCtx));
 	if (gba->memory.agbPrintBuffer) {
@@ -132,6 +161,7 @@ void GBAMemoryReset(struct GBA* gba) {
 
 	GBADMAReset(gba);
 	memset(&gba->memory.matrix, 0, sizeof(gba->memory.matrix));
+	gba->memory.dirtyTracked = false;
 }
 
 static void _analyzeForIdleLoop(struct GBA* gba, struct ARMCore* cpu, uint32_t address) {
@@ -208,11 +238,29 @@ static void _analyzeForIdleLoop(struct GBA* gba, struct ARMCore* cpu, uint32_t a
 	}
 }
 
-static void GBASetActiveRegion(struct ARMCore* cpu, uint32_t address) {
+// Counted from where the pipeline gets refilled rather than from the CPU loop, which is left alone.
+// Counting waits also needs every access to go through the handlers, so the fast pages stay off
+// until stats are disabled again; GBAFrameEnded puts them back.
+static void _chargeBranch(struct GBA* gba, int region) {
+	struct GBAMemory* memory = &gba->memory;
+	gba->cpu->memory.fastPages = NULL;
+	if (gba->cpu->executionMode == MODE_THUMB) {
+		mTimingChargeWait(&gba->timing, region, mTIMING_WAIT_CODE_NONSEQ, memory->waitstatesNonseq16[region]);
+		mTimingChargeWait(&gba->timing, region, mTIMING_WAIT_CODE_SEQ, memory->waitstatesSeq16[region]);
+	} else {
+		mTimingChargeWait(&gba->timing, region, mTIMING_WAIT_CODE_NONSEQ, memory->waitstatesNonseq32[region]);
+		mTimingChargeWait(&gba->timing, region, mTIMING_WAIT_CODE_SEQ, memory->waitstatesSeq32[region]);
+	}
+}
+
+void GBASetActiveRegion(struct ARMCore* cpu, uint32_t address) {
 	struct GBA* gba = (struct GBA*) cpu->master;
 	struct GBAMemory* memory = &gba->memory;
 
 	int newRegion = address >> BASE_OFFSET;
+	if (UNLIKELY(gba->timing.statsClock)) {
+		_chargeBranch(gba, newRegion);
+	}
 	if (gba->idleOptimization >= IDLE_LOOP_REMOVE && memory->activeRegion != REGION_BIOS) {
 		if (address == gba->idleLoop) {
 			if (gba->haltPending) {
@@ -312,6 +360,9 @@ static void GBASetActiveRegion(struct ARMCore* cpu, uint32_t address) {
 		memory->activeRegion = -1;
 		cpu->memory.activeRegion = (uint32_t*) _deadbeef;
 		cpu->memory.activeMask = 0;
+		if (cpu->blockCache) {
+			cpu->blockCache->activeCacheable = false;
+		}
 
 		if (!gba->yankedRomSize && mCoreCallbacksListSize(&gba->coreCallbacks)) {
 			size_t c;
@@ -334,14 +385,24 @@ static void GBASetActiveRegion(struct ARMCore* cpu, uint32_t address) {
 	cpu->memory.activeSeqCycles16 = memory->waitstatesSeq16[memory->activeRegion];
 	cpu->memory.activeNonseqCycles32 = memory->waitstatesNonseq32[memory->activeRegion];
 	cpu->memory.activeNonseqCycles16 = memory->waitstatesNonseq16[memory->activeRegion];
+	if (cpu->blockCache) {
+		// Only RAM that is guarded by invalidation and real ROM are safe to cache
+		cpu->blockCache->activeCacheable = newRegion == REGION_WORKING_RAM || newRegion == REGION_WORKING_IRAM || cpu->memory.activeRegion == memory->rom;
+	}
 }
 
 #define LOAD_BAD \
 	if (gba->performingDMA) { \
+		if (gba->busFromPrefetch) { \
+			GBALatchBus(gba); \
+		} \
 		value = gba->bus; \
 	} else { \
 		value = cpu->prefetch[1]; \
-		if (cpu->executionMode == MODE_THUMB) { \
+		if (cpu->executionMode == MODE_THUMB && gba->memory.accuracy >= mCORE_ACCURACY_BALANCED) { \
+			/* Only open bus tests look past the last fetched opcode */ \
+			value |= value << 16; \
+		} else if (cpu->executionMode == MODE_THUMB) { \
 			/* http://ngemu.com/threads/gba-open-bus.170809/ */ \
 			switch (cpu->gprs[ARM_PC] >> BASE_OFFSET) { \
 			case REGION_BIOS: \
@@ -479,6 +540,7 @@ uint32_t GBALoad32(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 	}
 
 	if (cycleCounter) {
+		mTimingChargeWait(&gba->timing, address >> BASE_OFFSET, mTIMING_WAIT_DATA_NONSEQ, wait);
 		wait += 2;
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
@@ -595,6 +657,7 @@ uint32_t GBALoad16(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 	}
 
 	if (cycleCounter) {
+		mTimingChargeWait(&gba->timing, address >> BASE_OFFSET, mTIMING_WAIT_DATA_NONSEQ, wait);
 		wait += 2;
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
@@ -703,6 +766,7 @@ uint32_t GBALoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 	}
 
 	if (cycleCounter) {
+		mTimingChargeWait(&gba->timing, address >> BASE_OFFSET, mTIMING_WAIT_DATA_NONSEQ, wait);
 		wait += 2;
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
@@ -712,12 +776,25 @@ uint32_t GBALoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 	return value;
 }
 
+#define INVALIDATE_WORKING_RAM ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address, SIZE_WORKING_RAM - 1))
+#define INVALIDATE_WORKING_IRAM ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address, SIZE_WORKING_IRAM - 1))
+
+#define DIRTY_WORKING_RAM mStatePageMark(memory->dirtyWram, address & (SIZE_WORKING_RAM - 1))
+#define DIRTY_WORKING_IRAM mStatePageMark(memory->dirtyIwram, address & (SIZE_WORKING_IRAM - 1))
+#define DIRTY_PALETTE_RAM mStatePageMark(memory->dirtyPalette, address & (SIZE_PALETTE_RAM - 1))
+#define DIRTY_VRAM(OFFSET) mStatePageMark(memory->dirtyVram, OFFSET)
+#define DIRTY_OAM mStatePageMark(memory->dirtyOam, address & (SIZE_OAM - 1))
+
 #define STORE_WORKING_RAM \
 	STORE_32(value, address & (SIZE_WORKING_RAM - 4), memory->wram); \
+	INVALIDATE_WORKING_RAM; \
+	DIRTY_WORKING_RAM; \
 	wait += waitstatesRegion[REGION_WORKING_RAM];
 
 #define STORE_WORKING_IRAM \
-	STORE_32(value, address & (SIZE_WORKING_IRAM - 4), memory->iwram);
+	STORE_32(value, address & (SIZE_WORKING_IRAM - 4), memory->iwram); \
+	INVALIDATE_WORKING_IRAM; \
+	DIRTY_WORKING_IRAM;
 
 #define STORE_IO \
 	GBAIOWrite32(gba, address & (OFFSET_MASK - 3), value);
@@ -726,6 +803,7 @@ uint32_t GBALoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 	LOAD_32(oldValue, address & (SIZE_PALETTE_RAM - 4), gba->video.palette); \
 	if (oldValue != value) { \
 		STORE_32(value, address & (SIZE_PALETTE_RAM - 4), gba->video.palette); \
+		DIRTY_PALETTE_RAM; \
 		gba->video.renderer->writePalette(gba->video.renderer, (address & (SIZE_PALETTE_RAM - 4)) + 2, value >> 16); \
 		gba->video.renderer->writePalette(gba->video.renderer, address & (SIZE_PALETTE_RAM - 4), value); \
 	} \
@@ -739,6 +817,7 @@ uint32_t GBALoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 			LOAD_32(oldValue, address & 0x00017FFC, gba->video.vram); \
 			if (oldValue != value) { \
 				STORE_32(value, address & 0x00017FFC, gba->video.vram); \
+				DIRTY_VRAM(address & 0x00017FFC); \
 				gba->video.renderer->writeVRAM(gba->video.renderer, (address & 0x00017FFC) + 2); \
 				gba->video.renderer->writeVRAM(gba->video.renderer, (address & 0x00017FFC)); \
 			} \
@@ -747,6 +826,7 @@ uint32_t GBALoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 		LOAD_32(oldValue, address & 0x0001FFFC, gba->video.vram); \
 		if (oldValue != value) { \
 			STORE_32(value, address & 0x0001FFFC, gba->video.vram); \
+			DIRTY_VRAM(address & 0x0001FFFC); \
 			gba->video.renderer->writeVRAM(gba->video.renderer, (address & 0x0001FFFC) + 2); \
 			gba->video.renderer->writeVRAM(gba->video.renderer, (address & 0x0001FFFC)); \
 		} \
@@ -757,6 +837,7 @@ uint32_t GBALoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
 	LOAD_32(oldValue, address & (SIZE_OAM - 4), gba->video.oam.raw); \
 	if (oldValue != value) { \
 		STORE_32(value, address & (SIZE_OAM - 4), gba->video.oam.raw); \
+		DIRTY_OAM; \
 		gba->video.renderer->writeOAM(gba->video.renderer, (address & (SIZE_OAM - 4)) >> 1); \
 		gba->video.renderer->writeOAM(gba->video.renderer, ((address & (SIZE_OAM - 4)) >> 1) + 1); \
 	}
@@ -826,6 +907,7 @@ void GBAStore32(struct ARMCore* cpu, uint32_t address, int32_t value, int* cycle
 	}
 
 	if (cycleCounter) {
+		mTimingChargeWait(&gba->timing, address >> BASE_OFFSET, mTIMING_WAIT_DATA_NONSEQ, wait);
 		++wait;
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
@@ -843,10 +925,14 @@ void GBAStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycle
 	switch (address >> BASE_OFFSET) {
 	case REGION_WORKING_RAM:
 		STORE_16(value, address & (SIZE_WORKING_RAM - 2), memory->wram);
+		INVALIDATE_WORKING_RAM;
+		DIRTY_WORKING_RAM;
 		wait = memory->waitstatesNonseq16[REGION_WORKING_RAM];
 		break;
 	case REGION_WORKING_IRAM:
 		STORE_16(value, address & (SIZE_WORKING_IRAM - 2), memory->iwram);
+		INVALIDATE_WORKING_IRAM;
+		DIRTY_WORKING_IRAM;
 		break;
 	case REGION_IO:
 		GBAIOWrite(gba, address & (OFFSET_MASK - 1), value);
@@ -855,6 +941,7 @@ void GBAStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycle
 		LOAD_16(oldValue, address & (SIZE_PALETTE_RAM - 2), gba->video.palette);
 		if (oldValue != value) {
 			STORE_16(value, address & (SIZE_PALETTE_RAM - 2), gba->video.palette);
+			DIRTY_PALETTE_RAM;
 			gba->video.renderer->writePalette(gba->video.renderer, address & (SIZE_PALETTE_RAM - 2), value);
 		}
 		break;
@@ -867,12 +954,14 @@ void GBAStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycle
 			LOAD_16(oldValue, address & 0x00017FFE, gba->video.vram);
 			if (value != oldValue) {
 				STORE_16(value, address & 0x00017FFE, gba->video.vram);
+				DIRTY_VRAM(address & 0x00017FFE);
 				gba->video.renderer->writeVRAM(gba->video.renderer, address & 0x00017FFE);
 			}
 		} else {
 			LOAD_16(oldValue, address & 0x0001FFFE, gba->video.vram);
 			if (value != oldValue) {
 				STORE_16(value, address & 0x0001FFFE, gba->video.vram);
+				DIRTY_VRAM(address & 0x0001FFFE);
 				gba->video.renderer->writeVRAM(gba->video.renderer, address & 0x0001FFFE);
 			}
 		}
@@ -881,6 +970,7 @@ void GBAStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycle
 		LOAD_16(oldValue, address & (SIZE_OAM - 2), gba->video.oam.raw);
 		if (value != oldValue) {
 			STORE_16(value, address & (SIZE_OAM - 2), gba->video.oam.raw);
+			DIRTY_OAM;
 			gba->video.renderer->writeOAM(gba->video.renderer, (address & (SIZE_OAM - 2)) >> 1);
 		}
 		break;
@@ -936,6 +1026,7 @@ void GBAStore16(struct ARMCore* cpu, uint32_t address, int16_t value, int* cycle
 	}
 
 	if (cycleCounter) {
+		mTimingChargeWait(&gba->timing, address >> BASE_OFFSET, mTIMING_WAIT_DATA_NONSEQ, wait);
 		++wait;
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
@@ -953,10 +1044,14 @@ void GBAStore8(struct ARMCore* cpu, uint32_t address, int8_t value, int* cycleCo
 	switch (address >> BASE_OFFSET) {
 	case REGION_WORKING_RAM:
 		((int8_t*) memory->wram)[address & (SIZE_WORKING_RAM - 1)] = value;
+		INVALIDATE_WORKING_RAM;
+		DIRTY_WORKING_RAM;
 		wait = memory->waitstatesNonseq16[REGION_WORKING_RAM];
 		break;
 	case REGION_WORKING_IRAM:
 		((int8_t*) memory->iwram)[address & (SIZE_WORKING_IRAM - 1)] = value;
+		INVALIDATE_WORKING_IRAM;
+		DIRTY_WORKING_IRAM;
 		break;
 	case REGION_IO:
 		GBAIOWrite8(gba, address & OFFSET_MASK, value);
@@ -972,6 +1067,7 @@ void GBAStore8(struct ARMCore* cpu, uint32_t address, int8_t value, int* cycleCo
 		oldValue = gba->video.renderer->vram[(address & 0x1FFFE) >> 1];
 		if (oldValue != (((uint8_t) value) | (value << 8))) {
 			gba->video.renderer->vram[(address & 0x1FFFE) >> 1] = ((uint8_t) value) | (value << 8);
+			DIRTY_VRAM(address & 0x0001FFFE);
 			gba->video.renderer->writeVRAM(gba->video.renderer, address & 0x0001FFFE);
 		}
 		break;
@@ -1000,7 +1096,7 @@ void GBAStore8(struct ARMCore* cpu, uint32_t address, int8_t value, int* cycleCo
 			} else {
 				memory->savedata.data[address & (SIZE_CART_SRAM - 1)] = value;
 			}
-			memory->savedata.dirty |= SAVEDATA_DIRT_NEW;
+			mSavedataFlusherMarkDirty(&memory->savedata.flusher);
 		} else if (memory->hw.devices & HW_TILT) {
 			GBAHardwareTiltWrite(&memory->hw, address & OFFSET_MASK, value);
 		} else {
@@ -1014,6 +1110,7 @@ void GBAStore8(struct ARMCore* cpu, uint32_t address, int8_t value, int* cycleCo
 	}
 
 	if (cycleCounter) {
+		mTimingChargeWait(&gba->timing, address >> BASE_OFFSET, mTIMING_WAIT_DATA_NONSEQ, wait);
 		++wait;
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
@@ -1142,10 +1239,14 @@ void GBAPatch32(struct ARMCore* cpu, uint32_t address, int32_t value, int32_t* o
 	case REGION_WORKING_RAM:
 		LOAD_32(oldValue, address & (SIZE_WORKING_RAM - 4), memory->wram);
 		STORE_32(value, address & (SIZE_WORKING_RAM - 4), memory->wram);
+		INVALIDATE_WORKING_RAM;
+		DIRTY_WORKING_RAM;
 		break;
 	case REGION_WORKING_IRAM:
 		LOAD_32(oldValue, address & (SIZE_WORKING_IRAM - 4), memory->iwram);
 		STORE_32(value, address & (SIZE_WORKING_IRAM - 4), memory->iwram);
+		INVALIDATE_WORKING_IRAM;
+		DIRTY_WORKING_IRAM;
 		break;
 	case REGION_IO:
 		mLOG(GBA_MEM, STUB, "Unimplemented memory Patch32: 0x%08X", address);
@@ -1153,6 +1254,7 @@ void GBAPatch32(struct ARMCore* cpu, uint32_t address, int32_t value, int32_t* o
 	case REGION_PALETTE_RAM:
 		LOAD_32(oldValue, address & (SIZE_PALETTE_RAM - 1), gba->video.palette);
 		STORE_32(value, address & (SIZE_PALETTE_RAM - 4), gba->video.palette);
+		DIRTY_PALETTE_RAM;
 		gba->video.renderer->writePalette(gba->video.renderer, address & (SIZE_PALETTE_RAM - 4), value);
 		gba->video.renderer->writePalette(gba->video.renderer, (address & (SIZE_PALETTE_RAM - 4)) + 2, value >> 16);
 		break;
@@ -1160,14 +1262,21 @@ void GBAPatch32(struct ARMCore* cpu, uint32_t address, int32_t value, int32_t* o
 		if ((address & 0x0001FFFF) < SIZE_VRAM) {
 			LOAD_32(oldValue, address & 0x0001FFFC, gba->video.vram);
 			STORE_32(value, address & 0x0001FFFC, gba->video.vram);
+			DIRTY_VRAM(address & 0x0001FFFC);
+			gba->video.renderer->writeVRAM(gba->video.renderer, (address & 0x0001FFFC) + 2);
+			gba->video.renderer->writeVRAM(gba->video.renderer, address & 0x0001FFFC);
 		} else {
 			LOAD_32(oldValue, address & 0x00017FFC, gba->video.vram);
 			STORE_32(value, address & 0x00017FFC, gba->video.vram);
+			DIRTY_VRAM(address & 0x00017FFC);
+			gba->video.renderer->writeVRAM(gba->video.renderer, (address & 0x00017FFC) + 2);
+			gba->video.renderer->writeVRAM(gba->video.renderer, address & 0x00017FFC);
 		}
 		break;
 	case REGION_OAM:
 		LOAD_32(oldValue, address & (SIZE_OAM - 4), gba->video.oam.raw);
 		STORE_32(value, address & (SIZE_OAM - 4), gba->video.oam.raw);
+		DIRTY_OAM;
 		gba->video.renderer->writeOAM(gba->video.renderer, (address & (SIZE_OAM - 4)) >> 1);
 		gba->video.renderer->writeOAM(gba->video.renderer, ((address & (SIZE_OAM - 4)) + 2) >> 1);
 		break;
@@ -1178,6 +1287,9 @@ void GBAPatch32(struct ARMCore* cpu, uint32_t address, int32_t value, int32_t* o
 	case REGION_CART2:
 	case REGION_CART2_EX:
 		_pristineCow(gba);
+		if (cpu->blockCache) {
+			ARMBlockCacheClear(cpu->blockCache);
+		}
 		if ((address & (SIZE_CART0 - 4)) >= gba->memory.romSize) {
 			gba->memory.romSize = (address & (SIZE_CART0 - 4)) + 4;
 			gba->memory.romMask = toPow2(gba->memory.romSize) - 1;
@@ -1212,10 +1324,14 @@ void GBAPatch16(struct ARMCore* cpu, uint32_t address, int16_t value, int16_t* o
 	case REGION_WORKING_RAM:
 		LOAD_16(oldValue, address & (SIZE_WORKING_RAM - 2), memory->wram);
 		STORE_16(value, address & (SIZE_WORKING_RAM - 2), memory->wram);
+		INVALIDATE_WORKING_RAM;
+		DIRTY_WORKING_RAM;
 		break;
 	case REGION_WORKING_IRAM:
 		LOAD_16(oldValue, address & (SIZE_WORKING_IRAM - 2), memory->iwram);
 		STORE_16(value, address & (SIZE_WORKING_IRAM - 2), memory->iwram);
+		INVALIDATE_WORKING_IRAM;
+		DIRTY_WORKING_IRAM;
 		break;
 	case REGION_IO:
 		mLOG(GBA_MEM, STUB, "Unimplemented memory Patch16: 0x%08X", address);
@@ -1223,20 +1339,26 @@ void GBAPatch16(struct ARMCore* cpu, uint32_t address, int16_t value, int16_t* o
 	case REGION_PALETTE_RAM:
 		LOAD_16(oldValue, address & (SIZE_PALETTE_RAM - 2), gba->video.palette);
 		STORE_16(value, address & (SIZE_PALETTE_RAM - 2), gba->video.palette);
+		DIRTY_PALETTE_RAM;
 		gba->video.renderer->writePalette(gba->video.renderer, address & (SIZE_PALETTE_RAM - 2), value);
 		break;
 	case REGION_VRAM:
 		if ((address & 0x0001FFFF) < SIZE_VRAM) {
 			LOAD_16(oldValue, address & 0x0001FFFE, gba->video.vram);
 			STORE_16(value, address & 0x0001FFFE, gba->video.vram);
+			DIRTY_VRAM(address & 0x0001FFFE);
+			gba->video.renderer->writeVRAM(gba->video.renderer, address & 0x0001FFFE);
 		} else {
 			LOAD_16(oldValue, address & 0x00017FFE, gba->video.vram);
 			STORE_16(value, address & 0x00017FFE, gba->video.vram);
+			DIRTY_VRAM(address & 0x00017FFE);
+			gba->video.renderer->writeVRAM(gba->video.renderer, address & 0x00017FFE);
 		}
 		break;
 	case REGION_OAM:
 		LOAD_16(oldValue, address & (SIZE_OAM - 2), gba->video.oam.raw);
 		STORE_16(value, address & (SIZE_OAM - 2), gba->video.oam.raw);
+		DIRTY_OAM;
 		gba->video.renderer->writeOAM(gba->video.renderer, (address & (SIZE_OAM - 2)) >> 1);
 		break;
 	case REGION_CART0:
@@ -1246,6 +1368,9 @@ void GBAPatch16(struct ARMCore* cpu, uint32_t address, int16_t value, int16_t* o
 	case REGION_CART2:
 	case REGION_CART2_EX:
 		_pristineCow(gba);
+		if (cpu->blockCache) {
+			ARMBlockCacheClear(cpu->blockCache);
+		}
 		if ((address & (SIZE_CART0 - 1)) >= gba->memory.romSize) {
 			gba->memory.romSize = (address & (SIZE_CART0 - 2)) + 2;
 			gba->memory.romMask = toPow2(gba->memory.romSize) - 1;
@@ -1280,10 +1405,14 @@ void GBAPatch8(struct ARMCore* cpu, uint32_t address, int8_t value, int8_t* old)
 	case REGION_WORKING_RAM:
 		oldValue = ((int8_t*) memory->wram)[address & (SIZE_WORKING_RAM - 1)];
 		((int8_t*) memory->wram)[address & (SIZE_WORKING_RAM - 1)] = value;
+		INVALIDATE_WORKING_RAM;
+		DIRTY_WORKING_RAM;
 		break;
 	case REGION_WORKING_IRAM:
 		oldValue = ((int8_t*) memory->iwram)[address & (SIZE_WORKING_IRAM - 1)];
 		((int8_t*) memory->iwram)[address & (SIZE_WORKING_IRAM - 1)] = value;
+		INVALIDATE_WORKING_IRAM;
+		DIRTY_WORKING_IRAM;
 		break;
 	case REGION_IO:
 		mLOG(GBA_MEM, STUB, "Unimplemented memory Patch8: 0x%08X", address);
@@ -1304,6 +1433,9 @@ void GBAPatch8(struct ARMCore* cpu, uint32_t address, int8_t value, int8_t* old)
 	case REGION_CART2:
 	case REGION_CART2_EX:
 		_pristineCow(gba);
+		if (cpu->blockCache) {
+			ARMBlockCacheClear(cpu->blockCache);
+		}
 		if ((address & (SIZE_CART0 - 1)) >= gba->memory.romSize) {
 			gba->memory.romSize = (address & (SIZE_CART0 - 2)) + 2;
 			gba->memory.romMask = toPow2(gba->memory.romSize) - 1;
@@ -1363,6 +1495,48 @@ void GBAPatch8(struct ARMCore* cpu, uint32_t address, int8_t value, int8_t* old)
 		} \
 	}
 
+// Transfers that stay within one mirror of plain RAM go straight through the host copy
+static uint8_t* _multipleHostPointer(struct GBAMemory* memory, uint32_t address, int mask) {
+	if (!mask) {
+		return NULL;
+	}
+	uint32_t length = popcount32(mask) << 2;
+	switch (address >> BASE_OFFSET) {
+	case REGION_WORKING_RAM:
+		if ((address & (SIZE_WORKING_RAM - 1)) + length > SIZE_WORKING_RAM) {
+			return NULL;
+		}
+		return (uint8_t*) memory->wram + (address & (SIZE_WORKING_RAM - 1));
+	case REGION_WORKING_IRAM:
+		if ((address & (SIZE_WORKING_IRAM - 1)) + length > SIZE_WORKING_IRAM) {
+			return NULL;
+		}
+		return (uint8_t*) memory->iwram + (address & (SIZE_WORKING_IRAM - 1));
+	default:
+		return NULL;
+	}
+}
+
+#define LDM_BLOCK(WAIT) \
+	for (i = 0; i < 16; ++i) { \
+		if (mask & (1 << i)) { \
+			LOAD_32(cpu->gprs[i], 0, host); \
+			host += 4; \
+		} \
+	} \
+	wait += popcount32(mask) * (1 + (WAIT)); \
+	address += popcount32(mask) << 2;
+
+// The first register costs a non-sequential access and the rest sequential ones, as in the loops above
+static void _chargeMultipleWait(struct GBA* gba, int region, int mask) {
+	int count = popcount32(mask);
+	if (!count) {
+		return;
+	}
+	mTimingChargeWait(&gba->timing, region, mTIMING_WAIT_DATA_NONSEQ, gba->memory.waitstatesNonseq32[region]);
+	mTimingChargeWait(&gba->timing, region, mTIMING_WAIT_DATA_SEQ, gba->memory.waitstatesSeq32[region] * (count - 1));
+}
+
 uint32_t GBALoadMultiple(struct ARMCore* cpu, uint32_t address, int mask, enum LSMDirection direction, int* cycleCounter) {
 	struct GBA* gba = (struct GBA*) cpu->master;
 	struct GBAMemory* memory = &gba->memory;
@@ -1388,15 +1562,26 @@ uint32_t GBALoadMultiple(struct ARMCore* cpu, uint32_t address, int mask, enum L
 		address &= 0xFFFFFFFC;
 	}
 	int wait = memory->waitstatesSeq32[region] - memory->waitstatesNonseq32[region];
+	uint8_t* host;
 
 	switch (region) {
 	case REGION_BIOS:
 		LDM_LOOP(LOAD_BIOS);
 		break;
 	case REGION_WORKING_RAM:
+		host = _multipleHostPointer(memory, address, mask);
+		if (host) {
+			LDM_BLOCK(waitstatesRegion[REGION_WORKING_RAM]);
+			break;
+		}
 		LDM_LOOP(LOAD_WORKING_RAM);
 		break;
 	case REGION_WORKING_IRAM:
+		host = _multipleHostPointer(memory, address, mask);
+		if (host) {
+			LDM_BLOCK(0);
+			break;
+		}
 		LDM_LOOP(LOAD_WORKING_IRAM);
 		break;
 	case REGION_IO:
@@ -1429,6 +1614,9 @@ uint32_t GBALoadMultiple(struct ARMCore* cpu, uint32_t address, int mask, enum L
 	}
 
 	if (cycleCounter) {
+		if (UNLIKELY(gba->timing.statsClock)) {
+			_chargeMultipleWait(gba, region, mask);
+		}
 		++wait;
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
@@ -1484,6 +1672,23 @@ uint32_t GBALoadMultiple(struct ARMCore* cpu, uint32_t address, int mask, enum L
 		} \
 	}
 
+#define STM_BLOCK(SIZE, DIRTY, WAIT) \
+	mStatePageMark(DIRTY, address & (SIZE - 1)); \
+	for (i = 0; i < 16; ++i) { \
+		if (mask & (1 << i)) { \
+			value = cpu->gprs[i]; \
+			if (i == ARM_PC) { \
+				value += WORD_SIZE_ARM; \
+			} \
+			STORE_32(value, 0, host); \
+			ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address, SIZE - 1)); \
+			host += 4; \
+			address += 4; \
+		} \
+	} \
+	mStatePageMark(DIRTY, (address - 4) & (SIZE - 1)); \
+	wait += popcount32(mask) * (1 + (WAIT));
+
 uint32_t GBAStoreMultiple(struct ARMCore* cpu, uint32_t address, int mask, enum LSMDirection direction, int* cycleCounter) {
 	struct GBA* gba = (struct GBA*) cpu->master;
 	struct GBAMemory* memory = &gba->memory;
@@ -1510,12 +1715,23 @@ uint32_t GBAStoreMultiple(struct ARMCore* cpu, uint32_t address, int mask, enum
 		address &= 0xFFFFFFFC;
 	}
 	int wait = memory->waitstatesSeq32[region] - memory->waitstatesNonseq32[region];
+	uint8_t* host;
 
 	switch (region) {
 	case REGION_WORKING_RAM:
+		host = _multipleHostPointer(memory, address, mask);
+		if (host) {
+			STM_BLOCK(SIZE_WORKING_RAM, memory->dirtyWram, waitstatesRegion[REGION_WORKING_RAM]);
+			break;
+		}
 		STM_LOOP(STORE_WORKING_RAM);
 		break;
 	case REGION_WORKING_IRAM:
+		host = _multipleHostPointer(memory, address, mask);
+		if (host) {
+			STM_BLOCK(SIZE_WORKING_IRAM, memory->dirtyIwram, 0);
+			break;
+		}
 		STM_LOOP(STORE_WORKING_IRAM);
 		break;
 	case REGION_IO:
@@ -1548,6 +1764,9 @@ uint32_t GBAStoreMultiple(struct ARMCore* cpu, uint32_t address, int mask, enum
 	}
 
 	if (cycleCounter) {
+		if (UNLIKELY(gba->timing.statsClock)) {
+			_chargeMultipleWait(gba, region, mask);
+		}
 		if (address >> BASE_OFFSET < REGION_CART0) {
 			wait = GBAMemoryStall(cpu, wait);
 		}
@@ -1598,7 +1817,8 @@ void GBAAdjustWaitstates(struct GBA* gba, uint16_t parameters) {
 	memory->waitstatesSeq32[REGION_CART1] = memory->waitstatesSeq32[REGION_CART1_EX] = 2 * memory->waitstatesSeq16[REGION_CART1] + 1;
 	memory->waitstatesSeq32[REGION_CART2] = memory->waitstatesSeq32[REGION_CART2_EX] = 2 * memory->waitstatesSeq16[REGION_CART2] + 1;
 
-	memory->prefetch = prefetch;
+	// Without prefetch emulation GBAMemoryStall bails out right away, at the cost of slightly slower games
+	memory->prefetch = prefetch && memory->accuracy < mCORE_ACCURACY_FAST;
 
 	cpu->memory.activeSeqCycles32 = memory->waitstatesSeq32[memory->activeRegion];
 	cpu->memory.activeSeqCycles16 = memory->waitstatesSeq16[memory->activeRegion];
@@ -1607,6 +1827,11 @@ void GBAAdjustWaitstates(struct GBA* gba, uint16_t parameters) {
 	cpu->memory.activeNonseqCycles16 = memory->waitstatesNonseq16[memory->activeRegion];
 }
 
+void GBAMemorySetAccuracy(struct GBA* gba, enum mCoreAccuracy accuracy) {
+	gba->memory.accuracy = accuracy;
+	GBAAdjustWaitstates(gba, gba->memory.io[REG_WAITCNT >> 1]);
+}
+
 int32_t GBAMemoryStall(struct ARMCore* cpu, int32_t wait) {
 	struct GBA* gba = (struct GBA*) cpu->master;
 	struct GBAMemory* memory = &gba->memory;
@@ -1639,6 +1864,7 @@ int32_t GBAMemoryStall(struct ARMCore* cpu, int32_t wait) {
 	}
 	if (stall > wait) {
 		// The wait cannot take less time than the prefetch stalls
+		mTimingChargeWait(&gba->timing, memory->activeRegion, mTIMING_WAIT_PREFETCH_STALL, stall - wait);
 		wait = stall;
 	}
 
@@ -1649,17 +1875,184 @@ int32_t GBAMemoryStall(struct ARMCore* cpu, int32_t wait) {
 
 	// The next |loads|S waitstates disappear entirely, so long as they're all in a row
 	cpu->cycles -= (s - 1) * loads;
+	mTimingChargeWait(&gba->timing, memory->activeRegion, mTIMING_WAIT_PREFETCH_HIDDEN, (s - 1) * loads);
 	return wait;
 }
 
+uint8_t* GBAMemoryHostPointer(struct GBA* gba, uint32_t address, uint32_t* available, bool write) {
+	struct GBAMemory* memory = &gba->memory;
+	uint32_t offset;
+	uint32_t size;
+	uint8_t* base;
+	switch (address >> BASE_OFFSET) {
+	case REGION_WORKING_RAM:
+		offset = address & (SIZE_WORKING_RAM - 1);
+		size = SIZE_WORKING_RAM;
+		base = (uint8_t*) memory->wram;
+		break;
+	case REGION_WORKING_IRAM:
+		offset = address & (SIZE_WORKING_IRAM - 1);
+		size = SIZE_WORKING_IRAM;
+		base = (uint8_t*) memory->iwram;
+		break;
+	case REGION_PALETTE_RAM:
+		offset = address & (SIZE_PALETTE_RAM - 1);
+		size = SIZE_PALETTE_RAM;
+		base = (uint8_t*) gba->video.palette;
+		break;
+	case REGION_VRAM:
+		// The upper mirror depends on the video mode, so leave it to the slow path
+		offset = address & 0x0001FFFF;
+		size = SIZE_VRAM;
+		base = (uint8_t*) gba->video.vram;
+		break;
+	case REGION_OAM:
+		offset = address & (SIZE_OAM - 1);
+		size = SIZE_OAM;
+		base = (uint8_t*) gba->video.oam.raw;
+		break;
+	case REGION_CART2_EX:
+		if (memory->savedata.type == SAVEDATA_EEPROM || memory->savedata.type == SAVEDATA_EEPROM512) {
+			return NULL;
+		}
+		// Fall through
+	case REGION_CART0:
+	case REGION_CART0_EX:
+	case REGION_CART1:
+	case REGION_CART1_EX:
+	case REGION_CART2:
+		if (write) {
+			return NULL;
+		}
+		offset = address & (SIZE_CART0 - 1);
+		size = memory->romSize;
+		base = (uint8_t*) memory->rom;
+		break;
+	default:
+		return NULL;
+	}
+	if (offset >= size) {
+		return NULL;
+	}
+	*available = size - offset;
+	return base + offset;
+}
+
+void GBAMemoryHostCopy(struct GBA* gba, uint32_t address, uint8_t* to, const uint8_t* from, uint32_t length, uint32_t width) {
+	struct GBAMemory* memory = &gba->memory;
+	struct ARMCore* cpu = gba->cpu;
+	struct GBAVideoRenderer* renderer = gba->video.renderer;
+	uint32_t region = address >> BASE_OFFSET;
+	uint32_t base;
+	uint32_t mask;
+	uint32_t* dirty;
+	uint32_t offset;
+	switch (region) {
+	case REGION_WORKING_RAM:
+	case REGION_WORKING_IRAM:
+		memcpy(to, from, length);
+		if (region == REGION_WORKING_RAM) {
+			mask = SIZE_WORKING_RAM - 1;
+			mStatePagesMarkRange(memory->dirtyWram, address & mask, (address & mask) + length);
+		} else {
+			mask = SIZE_WORKING_IRAM - 1;
+			mStatePagesMarkRange(memory->dirtyIwram, address & mask, (address & mask) + length);
+		}
+		if (cpu->blockCache) {
+			for (offset = 0; offset < length; offset += width) {
+				ARMBlockCacheInvalidate(cpu->blockCache, ARMBlockCacheKey(address + offset, mask));
+			}
+		}
+		return;
+	case REGION_PALETTE_RAM:
+		base = address & (SIZE_PALETTE_RAM - 1);
+		dirty = memory->dirtyPalette;
+		break;
+	case REGION_VRAM:
+		base = address & 0x0001FFFF;
+		dirty = memory->dirtyVram;
+		break;
+	default:
+		base = address & (SIZE_OAM - 1);
+		dirty = memory->dirtyOam;
+		break;
+	}
+	// Notify the renderer exactly as the individual stores would have
+	for (offset = 0; offset < length; offset += width) {
+		uint32_t videoAddress = base + offset;
+		if (width == 4) {
+			uint32_t oldValue;
+			uint32_t value;
+			LOAD_32(oldValue, offset, to);
+			LOAD_32(value, offset, from);
+			if (oldValue == value) {
+				continue;
+			}
+			STORE_32(value, offset, to);
+			mStatePageMark(dirty, videoAddress);
+			switch (region) {
+			case REGION_PALETTE_RAM:
+				renderer->writePalette(renderer, videoAddress + 2, value >> 16);
+				renderer->writePalette(renderer, videoAddress, value);
+				break;
+			case REGION_VRAM:
+				renderer->writeVRAM(renderer, videoAddress + 2);
+				renderer->writeVRAM(renderer, videoAddress);
+				break;
+			case REGION_OAM:
+				renderer->writeOAM(renderer, videoAddress >> 1);
+				renderer->writeOAM(renderer, (videoAddress >> 1) + 1);
+				break;
+			}
+		} else {
+			uint16_t oldValue;
+			uint16_t value;
+			LOAD_16(oldValue, offset, to);
+			LOAD_16(value, offset, from);
+			if (oldValue == value) {
+				continue;
+			}
+			STORE_16(value, offset, to);
+			mStatePageMark(dirty, videoAddress);
+			switch (region) {
+			case REGION_PALETTE_RAM:
+				renderer->writePalette(renderer, videoAddress, value);
+				break;
+			case REGION_VRAM:
+				renderer->writeVRAM(renderer, videoAddress);
+				break;
+			case REGION_OAM:
+				renderer->writeOAM(renderer, videoAddress >> 1);
+				break;
+			}
+		}
+	}
+}
+
 void GBAMemorySerialize(const struct GBAMemory* memory, struct GBASerializedState* state) {
-	memcpy(state->wram, memory->wram, SIZE_WORKING_RAM);
-	memcpy(state->iwram, memory->iwram, SIZE_WORKING_IRAM);
+	GBAMemorySerializeRegions(memory, state, mSTATE_REGION_ALL);
 }
 
 void GBAMemoryDeserialize(struct GBAMemory* memory, const struct GBASerializedState* state) {
-	memcpy(memory->wram, state->wram, SIZE_WORKING_RAM);
-	memcpy(memory->iwram, state->iwram, SIZE_WORKING_IRAM);
+	GBAMemoryDeserializeRegions(memory, state, mSTATE_REGION_ALL);
+}
+
+void GBAMemorySerializeRegions(const struct GBAMemory* memory, struct GBASerializedState* state, uint32_t regions) {
+	if (regions & mSTATE_REGION_WRAM) {
+		memcpy(state->wram, memory->wram, SIZE_WORKING_RAM);
+	}
+	if (regions & mSTATE_REGION_IWRAM) {
+		memcpy(state->iwram, memory->iwram, SIZE_WORKING_IRAM);
+	}
+}
+
+void GBAMemoryDeserializeRegions(struct GBAMemory* memory, const struct GBASerializedState* state, uint32_t regions) {
+	if (regions & mSTATE_REGION_WRAM) {
+		memcpy(memory->wram, state->wram, SIZE_WORKING_RAM);
+	}
+	if (regions & mSTATE_REGION_IWRAM) {
+		memcpy(memory->iwram, state->iwram, SIZE_WORKING_IRAM);
+	}
 }
 
 void _pristineCow(struct GBA* gba) {
@@ -1667,9 +2060,16 @@ void _pristineCow(struct GBA* gba) {
 		return;
 	}
 #if !defined(FIXED_ROM_BUFFER) && !defined(__wii__)
-	void* newRom = anonymousMemoryMap(SIZE_CART0);
-	memcpy(newRom, gba->memory.rom, gba->memory.romSize);
-	memset(((uint8_t*) newRom) + gba->memory.romSize, 0xFF, SIZE_CART0 - gba->memory.romSize);
+	void* newRom = NULL;
+	if (gba->romVf) {
+		// Only the pages that actually get written are copied out of the file
+		newRom = VFileMapCopyOnWrite(gba->romVf, gba->memory.romSize, SIZE_CART0);
+	}
+	if (!newRom) {
+		newRom = anonymousMemoryMap(SIZE_CART0);
+		memcpy(newRom, gba->memory.rom, gba->memory.romSize);
+		memset(((uint8_t*) newRom) + gba->memory.romSize, 0xFF, SIZE_CART0 - gba->memory.romSize);
+	}
 	if (gba->cpu->memory.activeRegion == gba->memory.rom) {
 		gba->cpu->memory.activeRegion = newRom;
 	}
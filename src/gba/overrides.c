@@ -191,11 +191,76 @@ static const struct GBACartridgeOverride _overrides[] = {
 	{ { 0, 0, 0, 0 }, 0, 0, IDLE_LOOP_NONE, false }
 };
 
+// Open-addressed index into _overrides by game code, holding entry numbers plus one. It's built
+// by whichever lookup gets there first; lookups that find it unfinished scan the table instead.
+#define OVERRIDE_INDEX_BITS 9
+#define OVERRIDE_INDEX_SIZE (1 << OVERRIDE_INDEX_BITS)
+
+enum {
+	OVERRIDE_INDEX_UNBUILT = 0,
+	OVERRIDE_INDEX_BUILDING,
+	OVERRIDE_INDEX_READY
+};
+
+static uint16_t _overrideIndex[OVERRIDE_INDEX_SIZE];
+static int _overrideIndexState = OVERRIDE_INDEX_UNBUILT;
+
+static unsigned _overrideSlot(const char* id) {
+	uint32_t key;
+	memcpy(&key, id, sizeof(key));
+	return (key * 0x9E3779B1U) >> (32 - OVERRIDE_INDEX_BITS);
+}
+
+static void _overrideIndexBuild(void) {
+	int state = OVERRIDE_INDEX_UNBUILT;
+	if (!ATOMIC_CMPXCHG(_overrideIndexState, state, OVERRIDE_INDEX_BUILDING)) {
+		return;
+	}
+	int i;
+	for (i = 0; _overrides[i].id[0]; ++i) {
+		unsigned slot = _overrideSlot(_overrides[i].id);
+		// Earlier entries stay earlier along the probe, so duplicates resolve like a scan would
+		while (_overrideIndex[slot]) {
+			slot = (slot + 1) & (OVERRIDE_INDEX_SIZE - 1);
+		}
+		_overrideIndex[slot] = i + 1;
+	}
+	ATOMIC_STORE(_overrideIndexState, OVERRIDE_INDEX_READY);
+}
+
+static const struct GBACartridgeOverride* _overrideLookup(const char* id) {
+	int state;
+	ATOMIC_LOAD(state, _overrideIndexState);
+	if (state == OVERRIDE_INDEX_UNBUILT) {
+		_overrideIndexBuild();
+		ATOMIC_LOAD(state, _overrideIndexState);
+	}
+	if (state == OVERRIDE_INDEX_READY) {
+		unsigned slot = _overrideSlot(id);
+		for (; _overrideIndex[slot]; slot = (slot + 1) & (OVERRIDE_INDEX_SIZE - 1)) {
+			const struct GBACartridgeOverride* override = &_overrides[_overrideIndex[slot] - 1];
+			if (memcmp(id, override->id, sizeof(override->id)) == 0) {
+				return override;
+			}
+		}
+		return NULL;
+	}
+	int i;
+	for (i = 0; _overrides[i].id[0]; ++i) {
+		if (memcmp(id, _overrides[i].id, sizeof(_overrides[i].id)) == 0) {
+			return &_overrides[i];
+		}
+	}
+	return NULL;
+}
+
 bool GBAOverrideFind(const struct Configuration* config, struct GBACartridgeOverride* override) {
 	override->savetype = SAVEDATA_AUTODETECT;
 	override->hardware = HW_NONE;
 	override->idleLoop = IDLE_LOOP_NONE;
 	override->mirroring = false;
+	override->audioHle = GBA_AUDIO_HLE_DEFAULT;
+	override->accuracy = 0;
 	bool found = false;
 
 	if (override->id[0] == 'F') {
@@ -204,13 +269,10 @@ bool GBAOverrideFind(const struct Configuration* config, struct GBACartridgeOver
 		override->mirroring = true;
 		found = true;
 	} else {
-		int i;
-		for (i = 0; _overrides[i].id[0]; ++i) {
-			if (memcmp(override->id, _overrides[i].id, sizeof(override->id)) == 0) {
-				*override = _overrides[i];
-				found = true;
-				break;
-			}
+		const struct GBACartridgeOverride* builtin = _overrideLookup(override->id);
+		if (builtin) {
+			*override = *builtin;
+			found = true;
 		}
 	}
 
@@ -220,6 +282,8 @@ bool GBAOverrideFind(const struct Configuration* config, struct GBACartridgeOver
 		const char* savetype = ConfigurationGetValue(config, sectionName, "savetype");
 		const char* hardware = ConfigurationGetValue(config, sectionName, "hardware");
 		const char* idleLoop = ConfigurationGetValue(config, sectionName, "idleLoop");
+		const char* audioHle = ConfigurationGetValue(config, sectionName, "audioHle");
+		const char* accuracy = ConfigurationGetValue(config, sectionName, "accuracy");
 
 		if (savetype) {
 			if (strcasecmp(savetype, "SRAM") == 0) {
@@ -260,6 +324,20 @@ bool GBAOverrideFind(const struct Configuration* config, struct GBACartridgeOver
 				found = true;
 			}
 		}
+
+		if (audioHle) {
+			char* end;
+			long enabled = strtol(audioHle, &end, 10);
+			if (end && !*end) {
+				override->audioHle = enabled ? GBA_AUDIO_HLE_ENABLED : GBA_AUDIO_HLE_DISABLED;
+				found = true;
+			}
+		}
+
+		if (accuracy) {
+			override->accuracy = mCoreAccuracyFromName(accuracy);
+			found = true;
+		}
 	}
 	return found;
 }
@@ -303,6 +381,24 @@ void GBAOverrideSave(struct Configuration* config, const struct GBACartridgeOver
 	} else {
 		ConfigurationClearValue(config, sectionName, "idleLoop");
 	}
+
+	if (override->audioHle != GBA_AUDIO_HLE_DEFAULT) {
+		ConfigurationSetIntValue(config, sectionName, "audioHle", override->audioHle == GBA_AUDIO_HLE_ENABLED);
+	} else {
+		ConfigurationClearValue(config, sectionName, "audioHle");
+	}
+
+	switch (override->accuracy) {
+	case mCORE_ACCURACY_ACCURATE:
+		ConfigurationSetValue(config, sectionName, "accuracy", "accurate");
+		break;
+	case mCORE_ACCURACY_BALANCED:
+		ConfigurationSetValue(config, sectionName, "accuracy", "balanced");
+		break;
+	default:
+		ConfigurationClearValue(config, sectionName, "accuracy");
+		break;
+	}
 }
 
 void GBAOverrideApply(struct GBA* gba, const struct GBACartridgeOverride* override) {
@@ -350,6 +446,14 @@ void GBAOverrideApply(struct GBA* gba, const struct GBACartridgeOverride* overri
 	if (override->mirroring) {
 		gba->memory.mirroring = true;
 	}
+
+	if (override->audioHle != GBA_AUDIO_HLE_DEFAULT) {
+		gba->audio.hleMode = override->audioHle;
+	}
+
+	if (override->accuracy && gba->memory.accuracy > override->accuracy) {
+		GBAMemorySetAccuracy(gba, override->accuracy);
+	}
 }
 
 void GBAOverrideApplyDefaults(struct GBA* gba, const struct Configuration* overrides) {
@@ -368,3 +472,95 @@ void GBAOverrideApplyDefaults(struct GBA* gba, const struct Configuration* overr
 		}
 	}
 }
+
+static bool _idleLoopCacheId(const struct GBA* gba, char* sectionName, size_t size) {
+	const struct GBACartridge* cart = (const struct GBACartridge*) gba->memory.rom;
+	if (!cart) {
+		return false;
+	}
+	const char* id = (const char*) &cart->id;
+	if (!id[0] || !id[1] || !id[2] || !id[3]) {
+		// Homebrew often leaves the game code blank
+		return false;
+	}
+	snprintf(sectionName, size, "override.%c%c%c%c", id[0], id[1], id[2], id[3]);
+	return true;
+}
+
+static uint32_t _idleLoopCacheFind(const struct Configuration* cache, const char* sectionName) {
+	const char* idleLoop = ConfigurationGetValue(cache, sectionName, "idleLoop");
+	if (!idleLoop) {
+		return IDLE_LOOP_NONE;
+	}
+	char* end;
+	uint32_t address = strtoul(idleLoop, &end, 16);
+	if (!end || *end) {
+		return IDLE_LOOP_NONE;
+	}
+	return address;
+}
+
+static void _idleLoopCacheSet(struct Configuration* cache, const char* sectionName, uint32_t idleLoop) {
+	// GBAOverrideFind parses idleLoop as hex
+	char value[9];
+	snprintf(value, sizeof(value), "%08X", idleLoop);
+	ConfigurationSetValue(cache, sectionName, "idleLoop", value);
+}
+
+void GBAOverrideApplyIdleLoop(struct GBA* gba, const struct Configuration* cache) {
+	char sectionName[16];
+	if (gba->idleLoop != IDLE_LOOP_NONE || !_idleLoopCacheId(gba, sectionName, sizeof(sectionName))) {
+		return;
+	}
+	uint32_t idleLoop = _idleLoopCacheFind(cache, sectionName);
+	if (idleLoop == IDLE_LOOP_NONE) {
+		return;
+	}
+	gba->idleLoop = idleLoop;
+	if (gba->idleOptimization == IDLE_LOOP_DETECT) {
+		gba->idleOptimization = IDLE_LOOP_REMOVE;
+	}
+}
+
+bool GBAOverrideLearnIdleLoop(struct Configuration* cache, const struct GBA* gba) {
+	char sectionName[16];
+	if (gba->idleLoop == IDLE_LOOP_NONE || !_idleLoopCacheId(gba, sectionName, sizeof(sectionName))) {
+		return false;
+	}
+	if (_idleLoopCacheFind(cache, sectionName) == gba->idleLoop) {
+		return false;
+	}
+	struct GBACartridgeOverride override = { .idleLoop = IDLE_LOOP_NONE };
+	memcpy(override.id, &sectionName[9], sizeof(override.id));
+	if (GBAOverrideFind(NULL, &override) && override.idleLoop == gba->idleLoop) {
+		// Already in the built-in table
+		return false;
+	}
+	_idleLoopCacheSet(cache, sectionName, gba->idleLoop);
+	return true;
+}
+
+struct GBAIdleLoopExport {
+	const struct Configuration* cache;
+	struct Configuration* overrides;
+	size_t count;
+};
+
+static void _exportIdleLoop(const char* sectionName, void* user) {
+	struct GBAIdleLoopExport* export = user;
+	if (strncmp(sectionName, "override.", 9) != 0 || strlen(sectionName) != 13) {
+		return;
+	}
+	uint32_t idleLoop = _idleLoopCacheFind(export->cache, sectionName);
+	if (idleLoop == IDLE_LOOP_NONE) {
+		return;
+	}
+	_idleLoopCacheSet(export->overrides, sectionName, idleLoop);
+	++export->count;
+}
+
+size_t GBAOverrideExportIdleLoops(const struct Configuration* cache, struct Configuration* overrides) {
+	struct GBAIdleLoopExport export = { cache, overrides, 0 };
+	ConfigurationEnumerateSections(cache, _exportIdleLoop, &export);
+	return export.count;
+}
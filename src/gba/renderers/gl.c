@@ -44,6 +44,8 @@ static void GBAVideoGLRendererDrawWindow(struct GBAVideoGLRenderer* renderer, in
 static void _cleanRegister(struct GBAVideoGLRenderer* renderer, int address, uint16_t value);
 static void _drawScanlines(struct GBAVideoGLRenderer* renderer, int lastY);
 static void _finalizeLayers(struct GBAVideoGLRenderer* renderer);
+static void _startReadback(struct GBAVideoGLRenderer* renderer);
+static void _resetReadback(struct GBAVideoGLRenderer* renderer);
 
 #define TEST_LAYER_ENABLED(X) !glRenderer->d.disableBG[X] && glRenderer->bg[X].enabled == 4
 
@@ -61,7 +63,8 @@ static const GLchar* const _gles3Header =
 	"precision highp float;\n"
 	"precision highp int;\n"
 	"precision highp sampler2D;\n"
-	"precision highp isampler2D;\n";
+	"precision highp isampler2D;\n"
+	"precision highp usampler2D;\n";
 
 static const GLchar* const _gl3Header =
 	"#version 150 core\n"
@@ -89,7 +92,7 @@ static const char* const _renderTile16 =
 	"	if (entry == 0) {\n"
 	"		discard;\n"
 	"	}\n"
-	"	int paletteEntry = palette[paletteId * 16 + entry];\n"
+	"	int paletteEntry = loadPalette(paletteId * 16 + entry);\n"
 	"	vec4 color = vec4(PALETTE_ENTRY(paletteEntry), 1.);\n"
 	"	return color;\n"
 	"}";
@@ -103,7 +106,7 @@ static const char* const _renderTile256 =
 	"	if ((pal2 | entry) == 0) {\n"
 	"		discard;\n"
 	"	}\n"
-	"	int paletteEntry = palette[pal2 * 16 + entry];\n"
+	"	int paletteEntry = loadPalette(pal2 * 16 + entry);\n"
 	"	vec4 color = vec4(PALETTE_ENTRY(paletteEntry), 1.);\n"
 	"	return color;\n"
 	"}";
@@ -125,7 +128,7 @@ static const struct GBAVideoGLUniform _uniformsMode0[] = {
 static const char* const _renderMode0 =
 	"in vec2 texCoord;\n"
 	"uniform sampler2D vram;\n"
-	"uniform int palette[256];\n"
+	"uniform usampler2D palette;\n"
 	"uniform int screenBase;\n"
 	"uniform int charBase;\n"
 	"uniform int size;\n"
@@ -137,6 +140,10 @@ static const char* const _renderMode0 =
 
 	"vec4 renderTile(int tile, int paletteId, ivec2 localCoord);\n"
 
+	"int loadPalette(int entry) {\n"
+	"	return int(texelFetch(palette, ivec2(entry, int(texCoord.y)), 0).r);\n"
+	"}\n"
+
 	"void main() {\n"
 	"	ivec2 coord = ivec2(texCoord);\n"
 	"	if (mosaic.x > 1) {\n"
@@ -231,7 +238,7 @@ static const char* const _interpolate =
 static const char* const _renderMode2 =
 	"in vec2 texCoord;\n"
 	"uniform sampler2D vram;\n"
-	"uniform int palette[256];\n"
+	"uniform usampler2D palette;\n"
 	"uniform int screenBase;\n"
 	"uniform int charBase;\n"
 	"uniform int size;\n"
@@ -258,7 +265,7 @@ static const char* const _renderMode2 =
 	"	if ((pal2 | entry) == 0) {\n"
 	"		discard;\n"
 	"	}\n"
-	"	int paletteEntry = palette[pal2 * 16 + entry];\n"
+	"	int paletteEntry = int(texelFetch(palette, ivec2(pal2 * 16 + entry, int(texCoord.y)), 0).r);\n"
 	"	vec4 color = vec4(PALETTE_ENTRY(paletteEntry), 1.);\n"
 	"	return color;\n"
 	"}\n"
@@ -368,7 +375,7 @@ static const struct GBAVideoGLUniform _uniformsMode4[] = {
 static const char* const _renderMode4 =
 	"in vec2 texCoord;\n"
 	"uniform sampler2D vram;\n"
-	"uniform int palette[256];\n"
+	"uniform usampler2D palette;\n"
 	"uniform int charBase;\n"
 	"uniform ivec2 size;\n"
 	"uniform ivec4 inflags;\n"
@@ -414,7 +421,7 @@ static const char* const _renderMode4 =
 	"	if (entry == 0) {\n"
 	"		discard;\n"
 	"	}\n"
-	"	int paletteEntry = palette[entry];\n"
+	"	int paletteEntry = int(texelFetch(palette, ivec2(entry, int(texCoord.y)), 0).r);\n"
 	"	color = vec4(PALETTE_ENTRY(paletteEntry), 1.);\n"
 	"	flags = inflags;\n"
 	"}";
@@ -438,7 +445,7 @@ static const struct GBAVideoGLUniform _uniformsObj[] = {
 static const char* const _renderObj =
 	"in vec2 texCoord;\n"
 	"uniform sampler2D vram;\n"
-	"uniform int palette[256];\n"
+	"uniform usampler2D palette;\n"
 	"uniform int charBase;\n"
 	"uniform int stride;\n"
 	"uniform int localPalette;\n"
@@ -453,6 +460,10 @@ static const char* const _renderObj =
 
 	"vec4 renderTile(int tile, int paletteId, ivec2 localCoord);\n"
 
+	"int loadPalette(int entry) {\n"
+	"	return int(texelFetch(palette, ivec2(entry + 256, mosaic.w + int(texCoord.y)), 0).r);\n"
+	"}\n"
+
 	"void main() {\n"
 	"	vec2 incoord = texCoord;\n"
 	"	if (mosaic.x > 1) {\n"
@@ -696,6 +707,28 @@ void GBAVideoGLRendererCreate(struct GBAVideoGLRenderer* renderer) {
 	renderer->d.highlightAmount = 0;
 
 	renderer->scale = 1;
+	renderer->asyncReadback = false;
+}
+
+bool GBAVideoGLRendererIsSupported(void) {
+	const char* version = (const char*) glGetString(GL_VERSION);
+	if (!version) {
+		// Without a current context there's nothing to go on, so trust the frontend
+		return true;
+	}
+	bool gles = false;
+	if (!strncmp(version, "OpenGL ES ", strlen("OpenGL ES "))) {
+		version += strlen("OpenGL ES ");
+		gles = true;
+	}
+	int major = 0;
+	int minor = 0;
+	sscanf(version, "%d.%d", &major, &minor);
+	if (gles ? major >= 3 : (major > 3 || (major == 3 && minor >= 2))) {
+		return true;
+	}
+	mLOG(GBA_VIDEO, WARN, "OpenGL %s%d.%d is too old for the hardware renderer", gles ? "ES " : "", major, minor);
+	return false;
 }
 
 static void _compileShader(struct GBAVideoGLRenderer* glRenderer, struct GBAVideoGLShader* shader, const char** shaderBuffer, int shaderBufferLines, GLuint vs, const struct GBAVideoGLUniform* uniforms, const char* const* outFrags, char* log) {
@@ -712,6 +745,10 @@ static void _compileShader(struct GBAVideoGLRenderer* glRenderer, struct GBAVide
 		mLOG(GBA_VIDEO, ERROR, "Fragment shader compilation failure: %s", log);
 	}
 	size_t i;
+	for (i = 0; i < GBA_GL_UNIFORM_MAX; ++i) {
+		// Uniforms a shader doesn't have are silently skipped by glUniform
+		shader->uniforms[i] = -1;
+	}
 #ifndef BUILD_GLES3
 	for (i = 0; outFrags[i]; ++i) {
 		glBindFragDataLocation(program, i, outFrags[i]);
@@ -797,6 +834,18 @@ void GBAVideoGLRendererInit(struct GBAVideoRenderer* renderer) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA4, 256, 192, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 0);
 
+	glGenTextures(1, &glRenderer->paletteTex);
+	glBindTexture(GL_TEXTURE_2D, glRenderer->paletteTex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, 512, GBA_VIDEO_VERTICAL_PIXELS, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, 0);
+
+	glGenBuffers(2, glRenderer->readbackPbo);
+	glRenderer->readbackFence[0] = NULL;
+	glRenderer->readbackFence[1] = NULL;
+	glRenderer->readbackIndex = 0;
+	glRenderer->readbackSize = 0;
+
 	glGenBuffers(1, &glRenderer->vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, glRenderer->vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(_vertices), _vertices, GL_STATIC_DRAW);
@@ -911,7 +960,10 @@ void GBAVideoGLRendererDeinit(struct GBAVideoRenderer* renderer) {
 	glDeleteFramebuffers(GBA_GL_FBO_MAX, glRenderer->fbo);
 	glDeleteTextures(GBA_GL_TEX_MAX, glRenderer->layers);
 	glDeleteTextures(1, &glRenderer->vramTex);
+	glDeleteTextures(1, &glRenderer->paletteTex);
 	glDeleteBuffers(1, &glRenderer->vbo);
+	_resetReadback(glRenderer);
+	glDeleteBuffers(2, glRenderer->readbackPbo);
 
 	_deleteShader(&glRenderer->bgShader[0]);
 	_deleteShader(&glRenderer->bgShader[1]);
@@ -1314,7 +1366,7 @@ void GBAVideoGLRendererDrawScanline(struct GBAVideoRenderer* renderer, int y) {
 		glRenderer->firstAffine = -1;
 	}
 
-	if (glRenderer->paletteDirty || _needsVramUpload(glRenderer, y) || glRenderer->oamDirty || glRenderer->regsDirty) {
+	if (_needsVramUpload(glRenderer, y) || glRenderer->oamDirty || glRenderer->regsDirty) {
 		if (glRenderer->firstY >= 0) {
 			_drawScanlines(glRenderer, y - 1);
 			glBindVertexArray(0);
@@ -1360,10 +1412,10 @@ void GBAVideoGLRendererDrawScanline(struct GBAVideoRenderer* renderer, int y) {
 	glRenderer->bg[3].scanlineAffine[y * 4 + 3] = glRenderer->bg[3].affine.sy;
 
 	if (glRenderer->paletteDirty) {
-		for (i = 0; i < 512; ++i) {
-			glRenderer->shadowPalette[i] = glRenderer->d.palette[i];
-		}
+		memcpy(glRenderer->shadowPalette[y], glRenderer->d.palette, sizeof(glRenderer->shadowPalette[y]));
 		glRenderer->paletteDirty = false;
+	} else {
+		memcpy(glRenderer->shadowPalette[y], glRenderer->shadowPalette[y ? y - 1 : GBA_VIDEO_VERTICAL_PIXELS - 1], sizeof(glRenderer->shadowPalette[y]));
 	}
 
 	if (_needsVramUpload(glRenderer, y)) {
@@ -1416,20 +1468,35 @@ void GBAVideoGLRendererDrawScanline(struct GBAVideoRenderer* renderer, int y) {
 }
 
 void _drawScanlines(struct GBAVideoGLRenderer* glRenderer, int y) {
-	glEnable(GL_SCISSOR_TEST);
+	int lines = y - glRenderer->firstY + 1;
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, glRenderer->paletteTex);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, glRenderer->firstY, 512, lines, GL_RED_INTEGER, GL_UNSIGNED_SHORT, glRenderer->shadowPalette[glRenderer->firstY]);
 
-	uint32_t backdrop = M_RGB5_TO_RGB8(glRenderer->shadowPalette[0]);
+	// The backdrop can differ on every line of the batch, so it's uploaded rather than cleared
+	uint8_t backdrop[GBA_VIDEO_VERTICAL_PIXELS * 3];
+	int i;
+	for (i = 0; i < lines; ++i) {
+		uint16_t color = glRenderer->shadowPalette[glRenderer->firstY + i][0];
+		backdrop[i * 3] = ((color & 0x1F) * 510 + 31) / 62;
+		backdrop[i * 3 + 1] = (((color >> 5) & 0x1F) * 510 + 31) / 62;
+		backdrop[i * 3 + 2] = (((color >> 10) & 0x1F) * 510 + 31) / 62;
+	}
+	glBindTexture(GL_TEXTURE_2D, glRenderer->layers[GBA_GL_TEX_BACKDROP_COLOR]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, glRenderer->firstY, 1, lines, GL_RGB, GL_UNSIGNED_BYTE, backdrop);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glEnable(GL_SCISSOR_TEST);
 	glViewport(0, 0, 1, GBA_VIDEO_VERTICAL_PIXELS);
-	glScissor(0, glRenderer->firstY, 1, y - glRenderer->firstY + 1);
+	glScissor(0, glRenderer->firstY, 1, lines);
 	glBindFramebuffer(GL_FRAMEBUFFER, glRenderer->fbo[GBA_GL_FBO_BACKDROP]);
-	glDrawBuffers(2, (GLenum[]) { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 });
-	glClearBufferfv(GL_COLOR, 0, (GLfloat[]) { ((backdrop >> 16) & 0xF8) / 248., ((backdrop >> 8) & 0xF8) / 248., (backdrop & 0xF8) / 248., 1.f });
+	glDrawBuffers(2, (GLenum[]) { GL_NONE, GL_COLOR_ATTACHMENT1 });
 	glClearBufferiv(GL_COLOR, 1, (GLint[]) { 32, glRenderer->target1Bd | (glRenderer->target2Bd * 2) | (glRenderer->blendEffect * 4), glRenderer->blda, 0 });
 	glDrawBuffers(1, (GLenum[]) { GL_COLOR_ATTACHMENT0 });
 
 	GBAVideoGLRendererDrawWindow(glRenderer, y);
 	if (GBARegisterDISPCNTIsObjEnable(glRenderer->dispcnt) && !glRenderer->d.disableOBJ) {
-		int i;
 		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 		glEnable(GL_STENCIL_TEST);
 		glDepthFunc(GL_LESS);
@@ -1488,6 +1555,9 @@ void GBAVideoGLRendererFinishFrame(struct GBAVideoRenderer* renderer) {
 	struct GBAVideoGLRenderer* glRenderer = (struct GBAVideoGLRenderer*) renderer;
 	_drawScanlines(glRenderer, GBA_VIDEO_VERTICAL_PIXELS - 1);
 	_finalizeLayers(glRenderer);
+	if (glRenderer->asyncReadback) {
+		_startReadback(glRenderer);
+	}
 	glDisable(GL_SCISSOR_TEST);
 	glBindVertexArray(0);
 	glRenderer->firstAffine = -1;
@@ -1498,12 +1568,85 @@ void GBAVideoGLRendererFinishFrame(struct GBAVideoRenderer* renderer) {
 	glRenderer->bg[3].affine.sy = glRenderer->bg[3].refy;
 }
 
-void GBAVideoGLRendererGetPixels(struct GBAVideoRenderer* renderer, size_t* stride, const void** pixels) {
-	struct GBAVideoGLRenderer* glRenderer = (struct GBAVideoGLRenderer*) renderer;
-	*stride = GBA_VIDEO_HORIZONTAL_PIXELS * glRenderer->scale;
+static void _resetReadback(struct GBAVideoGLRenderer* renderer) {
+	int i;
+	for (i = 0; i < 2; ++i) {
+		if (renderer->readbackFence[i]) {
+			glDeleteSync(renderer->readbackFence[i]);
+			renderer->readbackFence[i] = NULL;
+		}
+	}
+}
+
+static void _startReadback(struct GBAVideoGLRenderer* renderer) {
+	size_t size = GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS * renderer->scale * renderer->scale * BYTES_PER_PIXEL;
+	if (renderer->readbackSize != size) {
+		_resetReadback(renderer);
+		int i;
+		for (i = 0; i < 2; ++i) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, renderer->readbackPbo[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		}
+		renderer->readbackSize = size;
+	}
+	int index = renderer->readbackIndex;
+	if (renderer->readbackFence[index]) {
+		// Nobody picked this one up, so it can just be overwritten
+		glDeleteSync(renderer->readbackFence[index]);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, renderer->fbo[GBA_GL_FBO_OUTPUT]);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, renderer->readbackPbo[index]);
+	glPixelStorei(GL_PACK_ROW_LENGTH, GBA_VIDEO_HORIZONTAL_PIXELS * renderer->scale);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, GBA_VIDEO_HORIZONTAL_PIXELS * renderer->scale, GBA_VIDEO_VERTICAL_PIXELS * renderer->scale, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	renderer->readbackFence[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	renderer->readbackIndex = index ^ 1;
+}
+
+static void _ensureTemporaryBuffer(struct GBAVideoGLRenderer* glRenderer) {
 	if (!glRenderer->temporaryBuffer) {
 		glRenderer->temporaryBuffer = anonymousMemoryMap(GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS * glRenderer->scale * glRenderer->scale * BYTES_PER_PIXEL);
 	}
+}
+
+void GBAVideoGLRendererGetPixels(struct GBAVideoRenderer* renderer, size_t* stride, const void** pixels) {
+	struct GBAVideoGLRenderer* glRenderer = (struct GBAVideoGLRenderer*) renderer;
+	if (!glRenderer->asyncReadback) {
+		GBAVideoGLRendererReadPixels(glRenderer, stride, pixels);
+		return;
+	}
+	// The readback started a frame before the newest one has had a whole frame to finish
+	int index = glRenderer->readbackIndex;
+	if (!glRenderer->readbackFence[index]) {
+		if (!glRenderer->temporaryBuffer) {
+			GBAVideoGLRendererReadPixels(glRenderer, stride, pixels);
+			return;
+		}
+		// Already picked up, and still the newest frame that's ready
+		*stride = GBA_VIDEO_HORIZONTAL_PIXELS * glRenderer->scale;
+		*pixels = glRenderer->temporaryBuffer;
+		return;
+	}
+	_ensureTemporaryBuffer(glRenderer);
+	glClientWaitSync(glRenderer->readbackFence[index], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(glRenderer->readbackFence[index]);
+	glRenderer->readbackFence[index] = NULL;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, glRenderer->readbackPbo[index]);
+	const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, glRenderer->readbackSize, GL_MAP_READ_BIT);
+	if (mapped) {
+		memcpy(glRenderer->temporaryBuffer, mapped, glRenderer->readbackSize);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	*stride = GBA_VIDEO_HORIZONTAL_PIXELS * glRenderer->scale;
+	*pixels = glRenderer->temporaryBuffer;
+}
+
+void GBAVideoGLRendererReadPixels(struct GBAVideoGLRenderer* glRenderer, size_t* stride, const void** pixels) {
+	*stride = GBA_VIDEO_HORIZONTAL_PIXELS * glRenderer->scale;
+	_ensureTemporaryBuffer(glRenderer);
 	glFinish();
 	glBindFramebuffer(GL_FRAMEBUFFER, glRenderer->fbo[GBA_GL_FBO_OUTPUT]);
 	glPixelStorei(GL_PACK_ROW_LENGTH, GBA_VIDEO_HORIZONTAL_PIXELS * glRenderer->scale);
@@ -1678,10 +1821,12 @@ void GBAVideoGLRendererDrawSprite(struct GBAVideoGLRenderer* renderer, struct GB
 	glBindVertexArray(shader->vao);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, renderer->vramTex);
+	glActiveTexture(GL_TEXTURE0 + 1);
+	glBindTexture(GL_TEXTURE_2D, renderer->paletteTex);
 	glUniform2i(uniforms[GBA_GL_VS_LOC], totalHeight, 0);
 	glUniform2i(uniforms[GBA_GL_VS_MAXPOS], totalWidth, totalHeight);
 	glUniform1i(uniforms[GBA_GL_OBJ_VRAM], 0);
-	glUniform1iv(uniforms[GBA_GL_OBJ_PALETTE], 256, &renderer->shadowPalette[256]);
+	glUniform1i(uniforms[GBA_GL_OBJ_PALETTE], 1);
 	glUniform1i(uniforms[GBA_GL_OBJ_CHARBASE], charBase);
 	glUniform1i(uniforms[GBA_GL_OBJ_STRIDE], stride);
 	glUniform1i(uniforms[GBA_GL_OBJ_LOCALPALETTE], GBAObjAttributesCGetPalette(sprite->c));
@@ -1731,7 +1876,8 @@ void GBAVideoGLRendererDrawSprite(struct GBAVideoGLRenderer* renderer, struct GB
 		}
 		glUniform4i(uniforms[GBA_GL_OBJ_MOSAIC], mosaicH, GBAMosaicControlGetObjV(renderer->mosaic) + 1, x, spriteY);
 	} else {
-		glUniform4i(uniforms[GBA_GL_OBJ_MOSAIC], 0, 0, 0, 0);
+		// The sprite's position is still needed to find which scanline's palette to use
+		glUniform4i(uniforms[GBA_GL_OBJ_MOSAIC], 0, 0, x, spriteY);
 	}
 	if (GBAObjAttributesAGetMode(sprite->a) != OBJ_MODE_OBJWIN || GBARegisterDISPCNTIsObjwinEnable(renderer->dispcnt)) {
 		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
@@ -1761,9 +1907,11 @@ void _prepareBackground(struct GBAVideoGLRenderer* renderer, struct GBAVideoGLBa
 	glViewport(0, 0, GBA_VIDEO_HORIZONTAL_PIXELS * renderer->scale, GBA_VIDEO_VERTICAL_PIXELS * renderer->scale);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, renderer->vramTex);
+	glActiveTexture(GL_TEXTURE0 + 1);
+	glBindTexture(GL_TEXTURE_2D, renderer->paletteTex);
 	glUniform2i(uniforms[GBA_GL_VS_MAXPOS], GBA_VIDEO_HORIZONTAL_PIXELS, GBA_VIDEO_VERTICAL_PIXELS);
 	glUniform1i(uniforms[GBA_GL_BG_VRAM], 0);
-	glUniform1iv(uniforms[GBA_GL_OBJ_PALETTE], 256, renderer->shadowPalette);
+	glUniform1i(uniforms[GBA_GL_BG_PALETTE], 1);
 	if (background->mosaic) {
 		glUniform2i(uniforms[GBA_GL_BG_MOSAIC], GBAMosaicControlGetBgV(renderer->mosaic) + 1, GBAMosaicControlGetBgH(renderer->mosaic) + 1);
 	} else {
@@ -1885,6 +2033,7 @@ void GBAVideoGLRendererSetScale(struct GBAVideoGLRenderer* renderer, int scale)
 		renderer->temporaryBuffer = NULL;
 	}
 	renderer->scale = scale;
+	_resetReadback(renderer);
 	_initFramebuffers(renderer);
 	renderer->paletteDirty = true;
 }
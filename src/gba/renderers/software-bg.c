@@ -36,7 +36,7 @@
 	pixelData = charBase[(mapData << 6) + ((localY & 0x700) >> 5) + ((localX & 0x700) >> 8)];
 
 #define MODE_2_LOOP(MOSAIC, COORD, BLEND, OBJWIN) \
-	for (outX = renderer->start, pixel = &renderer->row[outX]; outX < renderer->end; ++outX, ++pixel) { \
+	for (pixel = &renderer->row[outX]; outX < renderer->end; ++outX, ++pixel) { \
 		x += background->dx; \
 		y += background->dy; \
 		\
@@ -47,6 +47,140 @@
 		} \
 	}
 
+#if defined(__SSE2__)
+// Map entry and tile offsets of four pixels, returning a bit for every pixel that falls outside of the background
+static inline int _mode2Coords4(__m128i x, __m128i y, int32_t mask, int size, bool overflow, uint32_t* map, uint32_t* offset) {
+	__m128i bounds = _mm_set1_epi32(mask);
+	__m128i localX = _mm_and_si128(x, bounds);
+	__m128i localY = _mm_and_si128(y, bounds);
+	__m128i row = _mm_sll_epi32(_mm_and_si128(_mm_srli_epi32(localY, 7), _mm_set1_epi32(0x7F0)), _mm_cvtsi32_si128(size));
+	_mm_storeu_si128((__m128i*) map, _mm_add_epi32(_mm_srli_epi32(localX, 11), row));
+	__m128i tileY = _mm_srli_epi32(_mm_and_si128(localY, _mm_set1_epi32(0x700)), 5);
+	__m128i tileX = _mm_srli_epi32(_mm_and_si128(localX, _mm_set1_epi32(0x700)), 8);
+	_mm_storeu_si128((__m128i*) offset, _mm_add_epi32(tileY, tileX));
+	if (overflow) {
+		return 0;
+	}
+	__m128i outside = _mm_andnot_si128(bounds, _mm_or_si128(x, y));
+	return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(outside, _mm_setzero_si128()))) ^ 0xF;
+}
+#elif defined(__ARM_NEON)
+static inline int _mode2Coords4(int32x4_t x, int32x4_t y, int32_t mask, int size, bool overflow, uint32_t* map, uint32_t* offset) {
+	uint32x4_t bounds = vdupq_n_u32(mask);
+	uint32x4_t localX = vandq_u32(vreinterpretq_u32_s32(x), bounds);
+	uint32x4_t localY = vandq_u32(vreinterpretq_u32_s32(y), bounds);
+	uint32x4_t row = vshlq_u32(vandq_u32(vshrq_n_u32(localY, 7), vdupq_n_u32(0x7F0)), vdupq_n_s32(size));
+	vst1q_u32(map, vaddq_u32(vshrq_n_u32(localX, 11), row));
+	uint32x4_t tileY = vshrq_n_u32(vandq_u32(localY, vdupq_n_u32(0x700)), 5);
+	uint32x4_t tileX = vshrq_n_u32(vandq_u32(localX, vdupq_n_u32(0x700)), 8);
+	vst1q_u32(offset, vaddq_u32(tileY, tileX));
+	if (overflow) {
+		return 0;
+	}
+	static const uint32_t lanes[4] = { 1, 2, 4, 8 };
+	uint32x4_t outside = vtstq_u32(vorrq_u32(vreinterpretq_u32_s32(x), vreinterpretq_u32_s32(y)), vmvnq_u32(bounds));
+	outside = vandq_u32(outside, vld1q_u32(lanes));
+	uint32x2_t bits = vorr_u32(vget_low_u32(outside), vget_high_u32(outside));
+	return vget_lane_u32(bits, 0) | vget_lane_u32(bits, 1);
+}
+#endif
+
+// Palette indices of the eight pixels starting at (x, y) of an unrotated and unscaled background, one per byte
+// in screen order. They span at most two tile rows, which can be read straight out of VRAM.
+static inline uint64_t _mode2Row(const struct GBAVideoSoftwareBackground* background, const uint8_t* screenBase, const uint8_t* charBase, int32_t x, int32_t y) {
+	int32_t mask = (0x8000 << background->size) - 1;
+	if (background->overflow) {
+		y &= mask;
+	} else if (y & ~mask) {
+		return 0;
+	}
+	const uint8_t* map = &screenBase[((y >> 7) & 0x7F0) << background->size];
+	const uint8_t* tileRow = &charBase[(y & 0x700) >> 5];
+	int32_t column = x >> 11;
+	int32_t columns = 0x10 << background->size;
+	int shift = ((x >> 8) & 7) * 8;
+	uint64_t left = 0;
+	uint64_t right = 0;
+	if (background->overflow || (column >= 0 && column < columns)) {
+		LOAD_64LE(left, map[column & (columns - 1)] << 6, tileRow);
+	}
+	if (!shift) {
+		return left;
+	}
+	++column;
+	if (background->overflow || (column >= 0 && column < columns)) {
+		LOAD_64LE(right, map[column & (columns - 1)] << 6, tileRow);
+	}
+	return (left >> shift) | (right << (64 - shift));
+}
+
+// Map entry and tile offsets of the eight pixels starting at (x, y), returning a bit for every pixel that falls outside of the background
+static inline int _mode2Coords(const struct GBAVideoSoftwareBackground* background, int32_t x, int32_t y, uint32_t* map, uint32_t* offset) {
+	int32_t mask = (0x8000 << background->size) - 1;
+	int outside;
+#if defined(__SSE2__)
+	__m128i dx = _mm_set1_epi32(background->dx * 4);
+	__m128i dy = _mm_set1_epi32(background->dy * 4);
+	__m128i vx = _mm_add_epi32(_mm_set1_epi32(x), _mm_set_epi32(background->dx * 3, background->dx * 2, background->dx, 0));
+	__m128i vy = _mm_add_epi32(_mm_set1_epi32(y), _mm_set_epi32(background->dy * 3, background->dy * 2, background->dy, 0));
+	outside = _mode2Coords4(vx, vy, mask, background->size, background->overflow, &map[0], &offset[0]);
+	outside |= _mode2Coords4(_mm_add_epi32(vx, dx), _mm_add_epi32(vy, dy), mask, background->size, background->overflow, &map[4], &offset[4]) << 4;
+#elif defined(__ARM_NEON)
+	const int32_t steps[4] = { 0, 1, 2, 3 };
+	int32x4_t step = vld1q_s32(steps);
+	int32x4_t vx = vmlaq_n_s32(vdupq_n_s32(x), step, background->dx);
+	int32x4_t vy = vmlaq_n_s32(vdupq_n_s32(y), step, background->dy);
+	outside = _mode2Coords4(vx, vy, mask, background->size, background->overflow, &map[0], &offset[0]);
+	vx = vaddq_s32(vx, vdupq_n_s32(background->dx * 4));
+	vy = vaddq_s32(vy, vdupq_n_s32(background->dy * 4));
+	outside |= _mode2Coords4(vx, vy, mask, background->size, background->overflow, &map[4], &offset[4]) << 4;
+#else
+	outside = 0;
+	int i;
+	for (i = 0; i < 8; ++i, x += background->dx, y += background->dy) {
+		int32_t localX = x & mask;
+		int32_t localY = y & mask;
+		if (!background->overflow && ((x | y) & ~mask)) {
+			outside |= 1 << i;
+		}
+		map[i] = (localX >> 11) + (((localY >> 7) & 0x7F0) << background->size);
+		offset[i] = ((localY & 0x700) >> 5) + ((localX & 0x700) >> 8);
+	}
+#endif
+	return outside;
+}
+
+// Whole groups of eight pixels, leaving whatever is left over for MODE_2_LOOP
+#define MODE_2_ROW_LOOP(BLEND) \
+	if (!background->dy && background->dx == 0x100) { \
+		for (pixel = &renderer->row[outX]; outX + 8 <= renderer->end; outX += 8, pixel += 8) { \
+			uint64_t indices = _mode2Row(background, screenBase, charBase, x + background->dx, y); \
+			x += background->dx * 8; \
+			if (indices) { \
+				_compositeTile ## BLEND ## NoObjwin(renderer, pixel, indices, palette, flags); \
+			} \
+		} \
+	} else { \
+		for (pixel = &renderer->row[outX]; outX + 8 <= renderer->end; outX += 8, pixel += 8) { \
+			uint32_t map[8]; \
+			uint32_t offset[8]; \
+			int outside = _mode2Coords(background, x + background->dx, y + background->dy, map, offset); \
+			x += background->dx * 8; \
+			y += background->dy * 8; \
+			int i; \
+			for (i = 0; i < 8; ++i) { \
+				if (outside & (1 << i)) { \
+					continue; \
+				} \
+				pixelData = charBase[(screenBase[map[i]] << 6) + offset[i]]; \
+				if (pixelData) { \
+					uint32_t current = pixel[i]; \
+					COMPOSITE_256_NO_OBJWIN(BLEND, i); \
+				} \
+			} \
+		} \
+	}
+
 #define DRAW_BACKGROUND_MODE_2(BLEND, OBJWIN) \
 	if (background->overflow) { \
 		if (mosaicH > 1) { \
@@ -72,10 +206,17 @@ void GBAVideoSoftwareRendererDrawBackgroundMode2(struct GBAVideoSoftwareRenderer
 	uint8_t mapData;
 	uint8_t pixelData = 0;
 
-	int outX;
+	int outX = renderer->start;
 	uint32_t* pixel;
 
 	if (!objwinSlowPath) {
+		if (mosaicH <= 1) {
+			if (!(flags & FLAG_TARGET_2)) {
+				MODE_2_ROW_LOOP(NoBlend);
+			} else {
+				MODE_2_ROW_LOOP(Blend);
+			}
+		}
 		if (!(flags & FLAG_TARGET_2)) {
 			DRAW_BACKGROUND_MODE_2(NoBlend, NO_OBJWIN);
 		} else {
@@ -102,7 +243,7 @@ void GBAVideoSoftwareRendererDrawBackgroundMode3(struct GBAVideoSoftwareRenderer
 
 		if (!mosaicWait) {
 			LOAD_16(color, ((localX >> 8) + (localY >> 8) * GBA_VIDEO_HORIZONTAL_PIXELS) << 1, renderer->d.vram);
-			color = mColorFrom555(color);
+			color = _colorFrom555(renderer, color);
 			mosaicWait = mosaicH;
 		} else {
 			--mosaicWait;
@@ -179,7 +320,7 @@ void GBAVideoSoftwareRendererDrawBackgroundMode5(struct GBAVideoSoftwareRenderer
 
 		if (!mosaicWait) {
 			LOAD_16(color, offset + (localX >> 8) * 2 + (localY >> 8) * 320, renderer->d.vram);
-			color = mColorFrom555(color);
+			color = _colorFrom555(renderer, color);
 			mosaicWait = mosaicH;
 		} else {
 			--mosaicWait;
@@ -201,3 +342,159 @@ void GBAVideoSoftwareRendererDrawBackgroundMode5(struct GBAVideoSoftwareRenderer
 		}
 	}
 }
+
+// Converts a run of BGR555 pixels straight to the output format, with the flags compositing would have left on them
+static void _convertBitmapRow(color_t* output, const uint16_t* vram, int count, uint32_t flags) {
+	int x = 0;
+#ifdef COLOR_16_BIT
+	UNUSED(flags);
+#ifdef COLOR_5_6_5
+#if defined(__SSE2__)
+	for (; x + 8 <= count; x += 8) {
+		__m128i color = _mm_loadu_si128((const __m128i*) &vram[x]);
+		__m128i r = _mm_slli_epi16(color, 11);
+		__m128i g = _mm_slli_epi16(_mm_and_si128(color, _mm_set1_epi16(0x03E0)), 1);
+		__m128i b = _mm_srli_epi16(_mm_and_si128(color, _mm_set1_epi16(0x7C00)), 10);
+		_mm_storeu_si128((__m128i*) &output[x], _mm_or_si128(r, _mm_or_si128(g, b)));
+	}
+#elif defined(__ARM_NEON)
+	for (; x + 8 <= count; x += 8) {
+		uint16x8_t color = vld1q_u16(&vram[x]);
+		uint16x8_t r = vshlq_n_u16(color, 11);
+		uint16x8_t g = vshlq_n_u16(vandq_u16(color, vdupq_n_u16(0x03E0)), 1);
+		uint16x8_t b = vshrq_n_u16(vandq_u16(color, vdupq_n_u16(0x7C00)), 10);
+		vst1q_u16(&output[x], vorrq_u16(r, vorrq_u16(g, b)));
+	}
+#endif
+#else
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	memcpy(output, vram, count * sizeof(*output));
+	x = count;
+#endif
+#endif
+#else
+#if defined(__SSE2__)
+	__m128i flagsVec = _mm_set1_epi32(flags);
+	for (; x + 4 <= count; x += 4) {
+		__m128i color = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*) &vram[x]), _mm_setzero_si128());
+		__m128i r = _mm_slli_epi32(_mm_and_si128(color, _mm_set1_epi32(0x001F)), 3);
+		__m128i g = _mm_slli_epi32(_mm_and_si128(color, _mm_set1_epi32(0x03E0)), 6);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(color, _mm_set1_epi32(0x7C00)), 9);
+		color = _mm_or_si128(r, _mm_or_si128(g, b));
+		color = _mm_or_si128(color, _mm_and_si128(_mm_srli_epi32(color, 5), _mm_set1_epi32(0x070707)));
+		_mm_storeu_si128((__m128i*) &output[x], _mm_or_si128(color, flagsVec));
+	}
+#elif defined(__ARM_NEON)
+	for (; x + 4 <= count; x += 4) {
+		uint32x4_t color = vmovl_u16(vld1_u16(&vram[x]));
+		uint32x4_t r = vshlq_n_u32(vandq_u32(color, vdupq_n_u32(0x001F)), 3);
+		uint32x4_t g = vshlq_n_u32(vandq_u32(color, vdupq_n_u32(0x03E0)), 6);
+		uint32x4_t b = vshlq_n_u32(vandq_u32(color, vdupq_n_u32(0x7C00)), 9);
+		color = vorrq_u32(r, vorrq_u32(g, b));
+		color = vorrq_u32(color, vandq_u32(vshrq_n_u32(color, 5), vdupq_n_u32(0x070707)));
+		vst1q_u32(&output[x], vorrq_u32(color, vdupq_n_u32(flags)));
+	}
+#endif
+#endif
+	for (; x < count; ++x) {
+		uint16_t color;
+		LOAD_16(color, x << 1, vram);
+#ifdef COLOR_16_BIT
+		output[x] = mColorFrom555(color);
+#else
+		output[x] = mColorFrom555(color) | flags;
+#endif
+	}
+}
+
+bool GBAVideoSoftwareRendererDrawBitmapScanline(struct GBAVideoSoftwareRenderer* renderer, color_t* output) {
+	struct GBAVideoSoftwareBackground* background = &renderer->bg[2];
+	int mode = GBARegisterDISPCNTGetMode(renderer->dispcnt);
+	if (mode < 3 || mode > 5) {
+		return false;
+	}
+	if (GBARegisterDISPCNTIsObjEnable(renderer->dispcnt) && !renderer->d.disableOBJ) {
+		return false;
+	}
+	if (GBARegisterDISPCNTIsWin0Enable(renderer->dispcnt) || GBARegisterDISPCNTIsWin1Enable(renderer->dispcnt) || GBARegisterDISPCNTIsObjwinEnable(renderer->dispcnt)) {
+		return false;
+	}
+	if (background->enabled != 4 || renderer->d.disableBG[2] || background->mosaic) {
+		return false;
+	}
+	if ((background->target1 && renderer->blendEffect != BLEND_NONE) || (renderer->d.highlightAmount && renderer->d.highlightBG[2])) {
+		return false;
+	}
+	if (background->dx != 0x100 || background->dy) {
+		return false;
+	}
+
+	// What the layer pipeline would leave behind: the backdrop where the bitmap doesn't reach, and the bitmap
+	// beaten to the top of the backdrop everywhere else, with nothing left to blend
+	uint32_t backdrop = FLAG_UNWRITTEN | FLAG_PRIORITY | FLAG_IS_BACKGROUND;
+	if (renderer->target1Bd && (renderer->blendEffect == BLEND_BRIGHTEN || renderer->blendEffect == BLEND_DARKEN)) {
+		backdrop |= renderer->variantPalette[0];
+	} else {
+		backdrop |= renderer->normalPalette[0];
+	}
+	uint32_t flags = (background->priority << OFFSET_PRIORITY) | (background->index << OFFSET_INDEX) | FLAG_IS_BACKGROUND;
+
+	int width = GBA_VIDEO_HORIZONTAL_PIXELS;
+	int height = GBA_VIDEO_VERTICAL_PIXELS;
+	if (mode == 5) {
+		width = 160;
+		height = 128;
+	}
+	uint32_t offset = 0;
+	if (mode != 3 && GBARegisterDISPCNTIsFrameSelect(renderer->dispcnt)) {
+		offset = 0xA000;
+	}
+	int32_t localX = background->sx >> 8;
+	int32_t localY = background->sy >> 8;
+	int start = 0;
+	int end = 0;
+	if (localY >= 0 && localY < height) {
+		start = localX < 0 ? -localX : 0;
+		end = width - localX;
+		if (start > GBA_VIDEO_HORIZONTAL_PIXELS) {
+			start = GBA_VIDEO_HORIZONTAL_PIXELS;
+		}
+		if (end > GBA_VIDEO_HORIZONTAL_PIXELS) {
+			end = GBA_VIDEO_HORIZONTAL_PIXELS;
+		}
+		if (end < start) {
+			end = start;
+		}
+	}
+
+	int x;
+	for (x = 0; x < start; ++x) {
+		output[x] = backdrop;
+	}
+	if (mode == 4) {
+		const uint8_t* vram = &((const uint8_t*) renderer->d.vram)[offset + localY * GBA_VIDEO_HORIZONTAL_PIXELS];
+		for (; x < end; ++x) {
+			uint8_t color = vram[localX + x];
+			if (color) {
+				output[x] = renderer->normalPalette[color] | flags;
+			} else {
+				output[x] = backdrop;
+			}
+		}
+	} else if (renderer->colorTable) {
+		const uint16_t* vram = &renderer->d.vram[(offset >> 1) + localY * width];
+		for (; x < end; ++x) {
+			uint16_t color;
+			LOAD_16(color, (localX + x) << 1, vram);
+			output[x] = renderer->colorTable[color & 0x7FFF] | flags;
+		}
+	} else if (start < end) {
+		const uint16_t* vram = &renderer->d.vram[(offset >> 1) + localY * width];
+		_convertBitmapRow(&output[start], &vram[localX + start], end - start, flags);
+		x = end;
+	}
+	for (; x < GBA_VIDEO_HORIZONTAL_PIXELS; ++x) {
+		output[x] = backdrop;
+	}
+	return true;
+}
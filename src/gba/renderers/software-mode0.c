@@ -7,6 +7,64 @@
 
 #include <mgba/internal/gba/gba.h>
 
+static inline uint64_t _reverseTileRow(uint64_t indices) {
+	indices = ((indices & 0x00FF00FF00FF00FFULL) << 8) | ((indices >> 8) & 0x00FF00FF00FF00FFULL);
+	indices = ((indices & 0x0000FFFF0000FFFFULL) << 16) | ((indices >> 16) & 0x0000FFFF0000FFFFULL);
+	return (indices << 32) | (indices >> 32);
+}
+
+// Palette indices of a whole tile row, one byte per pixel in screen order
+static inline uint64_t _tileRow16(uint32_t tileData, bool hflip) {
+	uint64_t indices = _expandTileRow16(tileData);
+	return hflip ? _reverseTileRow(indices) : indices;
+}
+
+static inline uint64_t _tileRow256(uint32_t tileDataLo, uint32_t tileDataHi, bool hflip) {
+	uint64_t indices = tileDataLo | ((uint64_t) tileDataHi << 32);
+	return hflip ? _reverseTileRow(indices) : indices;
+}
+
+#define BACKGROUND_DRAW_TILE_16_NO_OBJWIN(BLEND) \
+	if (tileCache) { \
+		if (tileCache->opaque[charBase >> 2]) { \
+			uint64_t indices; \
+			LOAD_64LE(indices, charBase << 1, tileCache->indices); \
+			if (GBA_TEXT_MAP_HFLIP(mapData)) { \
+				indices = _reverseTileRow(indices); \
+			} \
+			_compositeTile ## BLEND ## NoObjwin(renderer, pixel, indices, palette, flags); \
+		} \
+	} else { \
+		LOAD_32(tileData, charBase, vram); \
+		if (tileData) { \
+			_compositeTile ## BLEND ## NoObjwin(renderer, pixel, _tileRow16(tileData, GBA_TEXT_MAP_HFLIP(mapData)), palette, flags); \
+		} \
+	}
+
+#define BACKGROUND_DRAW_TILE_16_OBJWIN(BLEND) \
+	LOAD_32(tileData, charBase, vram); \
+	if (tileData) { \
+		if (!GBA_TEXT_MAP_HFLIP(mapData)) { \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 0); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 1); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 2); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 3); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 4); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 5); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 6); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 7); \
+		} else { \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 7); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 6); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 5); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 4); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 3); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 2); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 1); \
+			BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 0); \
+		} \
+	}
+
 #define BACKGROUND_TEXT_SELECT_CHARACTER \
 	xBase = localX & 0xF8; \
 	if (background->size & 1) { \
@@ -160,31 +218,58 @@
 			pixel += 8; \
 			continue; \
 		} \
+		BACKGROUND_DRAW_TILE_16_ ## OBJWIN (BLEND) \
+		pixel += 8; \
+	}
+
+#define BACKGROUND_DRAW_TILE_256_NO_OBJWIN(BLEND) \
+	{ \
+		uint32_t tileDataHi; \
 		LOAD_32(tileData, charBase, vram); \
-		if (tileData) { \
-			if (!GBA_TEXT_MAP_HFLIP(mapData)) { \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 0); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 1); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 2); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 3); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 4); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 5); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 6); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 7); \
-			} else { \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 7); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 6); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 5); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 4); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 3); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 2); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 1); \
-				BACKGROUND_DRAW_PIXEL_16(BLEND, OBJWIN, 0); \
-			} \
+		LOAD_32(tileDataHi, charBase + 4, vram); \
+		if (tileData | tileDataHi) { \
+			_compositeTile ## BLEND ## NoObjwin(renderer, pixel, _tileRow256(tileData, tileDataHi, GBA_TEXT_MAP_HFLIP(mapData)), palette, flags); \
 		} \
 		pixel += 8; \
 	}
 
+#define BACKGROUND_DRAW_TILE_256_OBJWIN(BLEND) \
+	if (!GBA_TEXT_MAP_HFLIP(mapData)) { \
+		LOAD_32(tileData, charBase, vram); \
+		if (tileData) { \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
+		} \
+		pixel += 4; \
+		LOAD_32(tileData, charBase + 4, vram); \
+		if (tileData) { \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
+		} \
+		pixel += 4; \
+	} else { \
+		LOAD_32(tileData, charBase + 4, vram); \
+		if (tileData) { \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+		} \
+		pixel += 4; \
+		LOAD_32(tileData, charBase, vram); \
+		if (tileData) { \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+		} \
+		pixel += 4; \
+	}
+
 #define DRAW_BACKGROUND_MODE_0_TILE_SUFFIX_256(BLEND, OBJWIN) \
 	charBase = (background->charBase + (GBA_TEXT_MAP_TILE(mapData) << 6)) + (localY << 3); \
 	int end2 = end - 4; \
@@ -205,7 +290,7 @@
 			LOAD_32(tileData, charBase + 4, vram); \
 			tileData >>= 8 * shift; \
 			for (; outX < end; ++outX, ++pixel) { \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
 			} \
 		} \
 	} else { \
@@ -225,7 +310,7 @@
 		if (LIKELY(charBase < 0x10000)) { \
 			LOAD_32(tileData, charBase, vram); \
 			for (; outX >= renderer->start; --outX, --pixel) { \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
 			} \
 		} \
 		outX = end; \
@@ -243,7 +328,7 @@
 		if (end > 0) { \
 			LOAD_32(tileData, charBase, vram); \
 			for (; outX < renderer->end - end; ++outX, ++pixel) { \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
 			} \
 			charBase += 4; \
 		} \
@@ -261,7 +346,7 @@
 			LOAD_32(tileData, charBase, vram); \
 			tileData >>= 8 * shift; \
 			for (; outX >= start + 4; --outX, --pixel) { \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
+			BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
 			} \
 			shift = 0; \
 		} \
@@ -291,41 +376,7 @@
 			pixel += 8; \
 			continue; \
 		} \
-		if (!GBA_TEXT_MAP_HFLIP(mapData)) { \
-			LOAD_32(tileData, charBase, vram); \
-			if (tileData) { \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
-			} \
-			pixel += 4; \
-			LOAD_32(tileData, charBase + 4, vram); \
-			if (tileData) { \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
-					BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
-			} \
-			pixel += 4; \
-		} else { \
-			LOAD_32(tileData, charBase + 4, vram); \
-			if (tileData) { \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
-			} \
-			pixel += 4; \
-			LOAD_32(tileData, charBase, vram); \
-			if (tileData) { \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 3); \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 2); \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 1); \
-				BACKGROUND_DRAW_PIXEL_256(BLEND, OBJWIN, 0); \
-			} \
-			pixel += 4; \
-		} \
+		BACKGROUND_DRAW_TILE_256_ ## OBJWIN (BLEND) \
 	}
 
 #define DRAW_BACKGROUND_MODE_0_MOSAIC_256(BLEND, OBJWIN) \
@@ -551,6 +602,7 @@ void GBAVideoSoftwareRendererDrawBackgroundMode0(struct GBAVideoSoftwareRenderer
 	int tileX;
 	int tileEnd = ((length + inX) >> 3) - (inX >> 3);
 	uint16_t* vram = renderer->d.vram;
+	const struct GBAVideoSoftwareTileCache* tileCache = renderer->tileCache;
 
 	if (background->yCache != inY >> 3) {
 		localX = 0;
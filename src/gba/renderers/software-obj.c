@@ -28,22 +28,26 @@
 	}
 
 #define SPRITE_TRANSFORMED_LOOP(DEPTH, TYPE) \
-	unsigned tileData; \
-	unsigned widthMask = ~(width - 1); \
-	unsigned heightMask = ~(height - 1); \
-	for (; outX < condition; ++outX, ++inX) { \
-		xAccum += mat.a; \
-		yAccum += mat.c; \
-		int localX = xAccum >> 8; \
-		int localY = yAccum >> 8; \
-		\
-		if (localX & widthMask || localY & heightMask) { \
-			break; \
+	if (untransformed) { \
+		SPRITE_NORMAL_LOOP(DEPTH, TYPE); \
+	} else { \
+		unsigned tileData; \
+		unsigned widthMask = ~(width - 1); \
+		unsigned heightMask = ~(height - 1); \
+		for (; outX < condition; ++outX, ++inX) { \
+			xAccum += mat.a; \
+			yAccum += mat.c; \
+			int localX = xAccum >> 8; \
+			int localY = yAccum >> 8; \
+			\
+			if (localX & widthMask || localY & heightMask) { \
+				break; \
+			} \
+			\
+			SPRITE_YBASE_ ## DEPTH(localY); \
+			SPRITE_XBASE_ ## DEPTH(localX); \
+			SPRITE_DRAW_PIXEL_ ## DEPTH ## _ ## TYPE(localX); \
 		} \
-		\
-		SPRITE_YBASE_ ## DEPTH(localY); \
-		SPRITE_XBASE_ ## DEPTH(localX); \
-		SPRITE_DRAW_PIXEL_ ## DEPTH ## _ ## TYPE(localX); \
 	}
 
 #define SPRITE_TRANSFORMED_MOSAIC_LOOP(DEPTH, TYPE) \
@@ -105,6 +109,21 @@
 		renderer->row[outX] |= FLAG_OBJWIN; \
 	}
 
+// The same 16 color pixels, read from the renderer's tile cache instead
+#define SPRITE_XBASE_16D(localX) SPRITE_XBASE_16(localX)
+#define SPRITE_YBASE_16D(localY) SPRITE_YBASE_16(localY)
+
+#define SPRITE_DRAW_PIXEL_16D_NORMAL(localX) \
+	tileData = tileIndices[(((yBase + charBase + xBase) & 0x7FFE) << 1) | (localX & 3)]; \
+	current = renderer->spriteLayer[outX]; \
+	if ((current & FLAG_ORDER_MASK) > flags) { \
+		if (tileData) { \
+			renderer->spriteLayer[outX] = palette[tileData] | flags; \
+		} else if (current != FLAG_UNWRITTEN) { \
+			renderer->spriteLayer[outX] = (current & ~(FLAG_ORDER_MASK | FLAG_REBLEND | FLAG_TARGET_1)) | (flags & (FLAG_ORDER_MASK | FLAG_REBLEND | FLAG_TARGET_1)); \
+		} \
+	}
+
 #define SPRITE_XBASE_256(localX) unsigned xBase = (localX & ~0x7) * 8 + (localX & 6);
 #define SPRITE_YBASE_256(localY) unsigned yBase = (localY & ~0x7) * stride + (localY & 0x7) * 8;
 
@@ -155,6 +174,7 @@ int GBAVideoSoftwareRendererPreprocessSprite(struct GBAVideoSoftwareRenderer* re
 	x >>= 23;
 	x += renderer->objOffsetX;
 	uint16_t* vramBase = &renderer->d.vram[BASE_TILE >> 1];
+	const uint8_t* tileIndices = renderer->tileCache ? &renderer->tileCache->indices[BASE_TILE << 1] : NULL;
 	bool align = GBAObjAttributesAIs256Color(sprite->a) && !GBARegisterDISPCNTIsObjCharacterMapping(renderer->dispcnt);
 	unsigned charBase = (GBAObjAttributesCGetTile(sprite->c) & ~align) * 0x20;
 	if (GBARegisterDISPCNTGetMode(renderer->dispcnt) >= 3 && GBAObjAttributesCGetTile(sprite->c) < 512) {
@@ -270,6 +290,22 @@ int GBAVideoSoftwareRendererPreprocessSprite(struct GBAVideoSoftwareRenderer* re
 			return 0;
 		}
 
+		// A matrix that neither scales nor rotates, even if it mirrors, maps the line onto a single row of the sprite
+		bool untransformed = mosaicH <= 1 && !mat.c && (mat.a == 0x100 || mat.a == -0x100);
+		int xOffset = 0;
+		if (untransformed) {
+			xOffset = mat.a >> 8;
+			inX = (xAccum + mat.a) >> 8;
+			inY = yAccum >> 8;
+			if (inX < 0 || inX >= width || inY < 0 || inY >= height) {
+				return 1;
+			}
+			int remaining = xOffset > 0 ? width - inX : inX + 1;
+			if (condition > outX + remaining) {
+				condition = outX + remaining;
+			}
+		}
+
 		if (!GBAObjAttributesAIs256Color(sprite->a)) {
 			palette = &palette[GBAObjAttributesCGetPalette(sprite->c) << 4];
 			if (flags & FLAG_OBJWIN) {
@@ -284,6 +320,8 @@ int GBAVideoSoftwareRendererPreprocessSprite(struct GBAVideoSoftwareRenderer* re
 			} else if (objwinSlowPath) {
 				objwinPalette = &objwinPalette[GBAObjAttributesCGetPalette(sprite->c) << 4];
 				SPRITE_TRANSFORMED_LOOP(16, NORMAL_OBJWIN);
+			} else if (tileIndices) {
+				SPRITE_TRANSFORMED_LOOP(16D, NORMAL);
 			} else {
 				SPRITE_TRANSFORMED_LOOP(16, NORMAL);
 			}
@@ -341,6 +379,8 @@ int GBAVideoSoftwareRendererPreprocessSprite(struct GBAVideoSoftwareRenderer* re
 			} else if (objwinSlowPath) {
 				objwinPalette = &objwinPalette[GBAObjAttributesCGetPalette(sprite->c) << 4];
 				SPRITE_NORMAL_LOOP(16, NORMAL_OBJWIN);
+			} else if (tileIndices) {
+				SPRITE_NORMAL_LOOP(16D, NORMAL);
 			} else {
 				SPRITE_NORMAL_LOOP(16, NORMAL);
 			}
@@ -409,7 +449,29 @@ void GBAVideoSoftwareRendererPostprocessSprite(struct GBAVideoSoftwareRenderer*
 	} else if (!GBAWindowControlIsObjEnable(renderer->currentWindow.packed)) {
 		return;
 	}
-	for (x = renderer->start; x < renderer->end; ++x, ++pixel) {
+	x = renderer->start;
+#if defined(__SSE2__)
+	__m128i objFlags = _mm_set1_epi32(flags);
+	__m128i objPriority = _mm_set1_epi32(priority << OFFSET_PRIORITY);
+	for (; x + 4 <= renderer->end; x += 4, pixel += 4) {
+		__m128i color = _mm_andnot_si128(_mm_set1_epi32(FLAG_OBJWIN), _mm_loadu_si128((const __m128i*) &renderer->spriteLayer[x]));
+		__m128i skip = _mm_cmpeq_epi32(_mm_and_si128(color, _mm_set1_epi32(FLAG_PRIORITY)), objPriority);
+		skip = _mm_or_si128(_hasFlag4(color, FLAG_UNWRITTEN), _mm_xor_si128(skip, _mm_set1_epi32(-1)));
+		__m128i current = _mm_loadu_si128((const __m128i*) pixel);
+		_mm_storeu_si128((__m128i*) pixel, _compositeBlendNoObjwin4(renderer, _mm_or_si128(color, objFlags), current, skip));
+	}
+#elif defined(__ARM_NEON)
+	uint32x4_t objFlags = vdupq_n_u32(flags);
+	uint32x4_t objPriority = vdupq_n_u32(priority << OFFSET_PRIORITY);
+	for (; x + 4 <= renderer->end; x += 4, pixel += 4) {
+		uint32x4_t color = vbicq_u32(vld1q_u32(&renderer->spriteLayer[x]), vdupq_n_u32(FLAG_OBJWIN));
+		uint32x4_t skip = vceqq_u32(vandq_u32(color, vdupq_n_u32(FLAG_PRIORITY)), objPriority);
+		skip = vorrq_u32(_hasFlag4(color, FLAG_UNWRITTEN), vmvnq_u32(skip));
+		uint32x4_t current = vld1q_u32(pixel);
+		vst1q_u32(pixel, _compositeBlendNoObjwin4(renderer, vorrq_u32(color, objFlags), current, skip));
+	}
+#endif
+	for (; x < renderer->end; ++x, ++pixel) {
 		uint32_t color = renderer->spriteLayer[x] & ~FLAG_OBJWIN;
 		uint32_t current = *pixel;
 		if ((color & FLAG_UNWRITTEN) != FLAG_UNWRITTEN && (color & FLAG_PRIORITY) >> OFFSET_PRIORITY == priority) {
@@ -7,14 +7,29 @@
 #define SOFTWARE_PRIVATE_H
 
 #include <mgba/internal/arm/macros.h>
+#include <mgba/internal/gba/memory.h>
 #include <mgba/internal/gba/renderers/video-software.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifdef NDEBUG
 #define VIDEO_CHECKS false
 #else
 #define VIDEO_CHECKS true
 #endif
 
+// Every 32-bit word of VRAM read as a row of a 16 color tile, which WriteVRAM keeps up to date
+struct GBAVideoSoftwareTileCache {
+	// One palette index per byte, in VRAM order
+	uint8_t indices[SIZE_VRAM * 2];
+	// One bit per non-transparent pixel
+	uint8_t opaque[SIZE_VRAM >> 2];
+};
+
 void GBAVideoSoftwareRendererDrawBackgroundMode0(struct GBAVideoSoftwareRenderer* renderer,
                                                  struct GBAVideoSoftwareBackground* background, int y);
 void GBAVideoSoftwareRendererDrawBackgroundMode2(struct GBAVideoSoftwareRenderer* renderer,
@@ -25,6 +40,8 @@ void GBAVideoSoftwareRendererDrawBackgroundMode4(struct GBAVideoSoftwareRenderer
                                                  struct GBAVideoSoftwareBackground* background, int y);
 void GBAVideoSoftwareRendererDrawBackgroundMode5(struct GBAVideoSoftwareRenderer* renderer,
                                                  struct GBAVideoSoftwareBackground* background, int y);
+// Draws a whole bitmap mode line straight into the output when nothing else would touch it, returning false otherwise
+bool GBAVideoSoftwareRendererDrawBitmapScanline(struct GBAVideoSoftwareRenderer* renderer, color_t* output);
 
 int GBAVideoSoftwareRendererPreprocessSprite(struct GBAVideoSoftwareRenderer* renderer, struct GBAObj* sprite, int index, int y);
 void GBAVideoSoftwareRendererPostprocessSprite(struct GBAVideoSoftwareRenderer* renderer, unsigned priority);
@@ -33,6 +50,21 @@ static inline unsigned _brighten(unsigned color, int y);
 static inline unsigned _darken(unsigned color, int y);
 static unsigned _mix(int weightA, unsigned colorA, int weightB, unsigned colorB);
 
+// Spreads the eight palette indices of a 16 color tile row out to one per byte
+static inline uint64_t _expandTileRow16(uint32_t tileData) {
+	uint64_t indices = tileData;
+	indices = (indices | (indices << 16)) & 0x0000FFFF0000FFFFULL;
+	indices = (indices | (indices << 8)) & 0x00FF00FF00FF00FFULL;
+	return (indices | (indices << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+static inline color_t _colorFrom555(const struct GBAVideoSoftwareRenderer* renderer, uint16_t value) {
+	if (renderer->colorTable) {
+		return renderer->colorTable[value & 0x7FFF];
+	}
+	return mColorFrom555(value);
+}
+
 
 // We stash the priority on the top bits so we can do a one-operator comparison
 // The lower the number, the higher the priority, and sprites take precedence over backgrounds
@@ -357,4 +389,314 @@ static unsigned _mix(int weightA, unsigned colorA, int weightB, unsigned colorB)
 	return c;
 }
 
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+#define COLOR_SHIFT_GREEN 6
+#define COLOR_SHIFT_RED 11
+#else
+#define COLOR_SHIFT_GREEN 5
+#define COLOR_SHIFT_RED 10
+#endif
+#endif
+
+// Four-pixel versions of the blending functions above. They work on the packed row layout
+// and give bit-identical results, including the flooring and saturation of every channel.
+// Darkening rounds every channel but the lowest one up, like the scalar version does.
+#if defined(__SSE2__)
+#ifdef COLOR_16_BIT
+#define CHANNEL_16(V, SHIFT) _mm_and_si128(_mm_srli_epi16(V, SHIFT), _mm_set1_epi16(0x1F))
+
+static inline __m128i _packChannels16(__m128i b, __m128i g, __m128i r) {
+	__m128i c = _mm_or_si128(b, _mm_or_si128(_mm_slli_epi16(g, COLOR_SHIFT_GREEN), _mm_slli_epi16(r, COLOR_SHIFT_RED)));
+	return _mm_and_si128(c, _mm_set1_epi32(0xFFFF));
+}
+
+static inline __m128i _mixChannel16(__m128i a, __m128i wA, __m128i b, __m128i wB) {
+	__m128i c = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, wA), _mm_mullo_epi16(b, wB)), 4);
+	return _mm_min_epi16(c, _mm_set1_epi16(0x1F));
+}
+
+static inline __m128i _mix4(int weightA, __m128i colorA, int weightB, __m128i colorB) {
+	__m128i wA = _mm_set1_epi16(weightA);
+	__m128i wB = _mm_set1_epi16(weightB);
+	return _packChannels16(_mixChannel16(CHANNEL_16(colorA, 0), wA, CHANNEL_16(colorB, 0), wB),
+	                       _mixChannel16(CHANNEL_16(colorA, COLOR_SHIFT_GREEN), wA, CHANNEL_16(colorB, COLOR_SHIFT_GREEN), wB),
+	                       _mixChannel16(CHANNEL_16(colorA, COLOR_SHIFT_RED), wA, CHANNEL_16(colorB, COLOR_SHIFT_RED), wB));
+}
+
+static inline __m128i _brightenChannel16(__m128i c, __m128i y) {
+	return _mm_add_epi16(c, _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_set1_epi16(0x1F), c), y), 4));
+}
+
+static inline __m128i _brighten4(__m128i color, int y) {
+	__m128i weight = _mm_set1_epi16(y);
+	return _packChannels16(_brightenChannel16(CHANNEL_16(color, 0), weight),
+	                       _brightenChannel16(CHANNEL_16(color, COLOR_SHIFT_GREEN), weight),
+	                       _brightenChannel16(CHANNEL_16(color, COLOR_SHIFT_RED), weight));
+}
+
+static inline __m128i _darkenChannel16(__m128i c, __m128i y, int round) {
+	return _mm_sub_epi16(c, _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(c, y), _mm_set1_epi16(round)), 4));
+}
+
+static inline __m128i _darken4(__m128i color, int y) {
+	__m128i weight = _mm_set1_epi16(y);
+	return _packChannels16(_darkenChannel16(CHANNEL_16(color, 0), weight, 0),
+	                       _darkenChannel16(CHANNEL_16(color, COLOR_SHIFT_GREEN), weight, 15),
+	                       _darkenChannel16(CHANNEL_16(color, COLOR_SHIFT_RED), weight, 15));
+}
+#else
+static inline __m128i _mix4(int weightA, __m128i colorA, int weightB, __m128i colorB) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i wA = _mm_set1_epi16(weightA);
+	__m128i wB = _mm_set1_epi16(weightB);
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(colorA, zero), wA), _mm_mullo_epi16(_mm_unpacklo_epi8(colorB, zero), wB));
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(colorA, zero), wA), _mm_mullo_epi16(_mm_unpackhi_epi8(colorB, zero), wB));
+	__m128i c = _mm_packus_epi16(_mm_srli_epi16(lo, 4), _mm_srli_epi16(hi, 4));
+	return _mm_and_si128(c, _mm_set1_epi32(0x00FFFFFF));
+}
+
+static inline __m128i _brighten4(__m128i color, int y) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(0xFF);
+	__m128i weight = _mm_set1_epi16(y);
+	__m128i lo = _mm_unpacklo_epi8(color, zero);
+	__m128i hi = _mm_unpackhi_epi8(color, zero);
+	lo = _mm_add_epi16(lo, _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(max, lo), weight), 4));
+	hi = _mm_add_epi16(hi, _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(max, hi), weight), 4));
+	return _mm_and_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0x00FFFFFF));
+}
+
+static inline __m128i _darken4(__m128i color, int y) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set_epi16(0, 15, 15, 0, 0, 15, 15, 0);
+	__m128i weight = _mm_set1_epi16(y);
+	__m128i lo = _mm_unpacklo_epi8(color, zero);
+	__m128i hi = _mm_unpackhi_epi8(color, zero);
+	lo = _mm_sub_epi16(lo, _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, weight), round), 4));
+	hi = _mm_sub_epi16(hi, _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, weight), round), 4));
+	return _mm_and_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0x00FFFFFF));
+}
+#endif
+
+static inline __m128i _select4(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Compares the packed priority and flags the way the scalar code does, as unsigned values
+static inline __m128i _isBelow4(__m128i a, __m128i b) {
+	const __m128i sign = _mm_set1_epi32(0x80000000);
+	return _mm_cmplt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+}
+
+static inline __m128i _isUnwritable4(__m128i current) {
+	return _mm_cmpeq_epi32(_mm_and_si128(current, _mm_set1_epi32(0xFE000000)), _mm_setzero_si128());
+}
+
+static inline __m128i _hasFlag4(__m128i pixel, uint32_t flag) {
+	__m128i flags = _mm_set1_epi32(flag);
+	return _mm_cmpeq_epi32(_mm_and_si128(pixel, flags), flags);
+}
+
+// Vector counterparts of _compositeNoBlendNoObjwin and _compositeBlendNoObjwin,
+// leaving the pixels in skip and the ones that can't be written untouched
+static inline __m128i _compositeNoBlendNoObjwin4(__m128i color, __m128i current, __m128i skip) {
+	__m128i result = _select4(_isBelow4(color, current), color, _mm_and_si128(current, _mm_set1_epi32(0x00FFFFFF | FLAG_REBLEND | FLAG_OBJWIN)));
+	return _select4(_mm_or_si128(skip, _isUnwritable4(current)), current, result);
+}
+
+static inline __m128i _compositeBlendNoObjwin4(struct GBAVideoSoftwareRenderer* renderer, __m128i color, __m128i current, __m128i skip) {
+	skip = _mm_or_si128(skip, _isUnwritable4(current));
+	__m128i above = _isBelow4(color, current);
+	__m128i result = _select4(above, _mm_andnot_si128(_mm_set1_epi32(FLAG_TARGET_2), color), _mm_and_si128(current, _mm_set1_epi32(0x00FFFFFF | FLAG_REBLEND | FLAG_OBJWIN)));
+	__m128i blend = _mm_andnot_si128(_mm_or_si128(skip, above), _mm_and_si128(_hasFlag4(current, FLAG_TARGET_1), _hasFlag4(color, FLAG_TARGET_2)));
+	if (_mm_movemask_epi8(blend)) {
+		result = _select4(blend, _mix4(renderer->blda, current, renderer->bldb, color), result);
+	}
+	return _select4(skip, current, result);
+}
+#elif defined(__ARM_NEON)
+#ifdef COLOR_16_BIT
+#define CHANNEL_16(V, SHIFT) vandq_u16(vshrq_n_u16(V, SHIFT), vdupq_n_u16(0x1F))
+
+static inline uint32x4_t _packChannels16(uint16x8_t b, uint16x8_t g, uint16x8_t r) {
+	uint16x8_t c = vorrq_u16(b, vorrq_u16(vshlq_n_u16(g, COLOR_SHIFT_GREEN), vshlq_n_u16(r, COLOR_SHIFT_RED)));
+	return vandq_u32(vreinterpretq_u32_u16(c), vdupq_n_u32(0xFFFF));
+}
+
+static inline uint16x8_t _mixChannel16(uint16x8_t a, int weightA, uint16x8_t b, int weightB) {
+	return vminq_u16(vshrq_n_u16(vmlaq_n_u16(vmulq_n_u16(a, weightA), b, weightB), 4), vdupq_n_u16(0x1F));
+}
+
+static inline uint32x4_t _mix4(int weightA, uint32x4_t colorA, int weightB, uint32x4_t colorB) {
+	uint16x8_t a = vreinterpretq_u16_u32(colorA);
+	uint16x8_t b = vreinterpretq_u16_u32(colorB);
+	return _packChannels16(_mixChannel16(CHANNEL_16(a, 0), weightA, CHANNEL_16(b, 0), weightB),
+	                       _mixChannel16(CHANNEL_16(a, COLOR_SHIFT_GREEN), weightA, CHANNEL_16(b, COLOR_SHIFT_GREEN), weightB),
+	                       _mixChannel16(CHANNEL_16(a, COLOR_SHIFT_RED), weightA, CHANNEL_16(b, COLOR_SHIFT_RED), weightB));
+}
+
+static inline uint16x8_t _brightenChannel16(uint16x8_t c, int y) {
+	return vaddq_u16(c, vshrq_n_u16(vmulq_n_u16(vsubq_u16(vdupq_n_u16(0x1F), c), y), 4));
+}
+
+static inline uint32x4_t _brighten4(uint32x4_t color, int y) {
+	uint16x8_t c = vreinterpretq_u16_u32(color);
+	return _packChannels16(_brightenChannel16(CHANNEL_16(c, 0), y),
+	                       _brightenChannel16(CHANNEL_16(c, COLOR_SHIFT_GREEN), y),
+	                       _brightenChannel16(CHANNEL_16(c, COLOR_SHIFT_RED), y));
+}
+
+static inline uint16x8_t _darkenChannel16(uint16x8_t c, int y, int round) {
+	return vsubq_u16(c, vshrq_n_u16(vaddq_u16(vmulq_n_u16(c, y), vdupq_n_u16(round)), 4));
+}
+
+static inline uint32x4_t _darken4(uint32x4_t color, int y) {
+	uint16x8_t c = vreinterpretq_u16_u32(color);
+	return _packChannels16(_darkenChannel16(CHANNEL_16(c, 0), y, 0),
+	                       _darkenChannel16(CHANNEL_16(c, COLOR_SHIFT_GREEN), y, 15),
+	                       _darkenChannel16(CHANNEL_16(c, COLOR_SHIFT_RED), y, 15));
+}
+#else
+static inline uint32x4_t _mix4(int weightA, uint32x4_t colorA, int weightB, uint32x4_t colorB) {
+	uint8x16_t a = vreinterpretq_u8_u32(colorA);
+	uint8x16_t b = vreinterpretq_u8_u32(colorB);
+	uint16x8_t lo = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_low_u8(a)), weightA), vmovl_u8(vget_low_u8(b)), weightB);
+	uint16x8_t hi = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_high_u8(a)), weightA), vmovl_u8(vget_high_u8(b)), weightB);
+	uint8x16_t c = vcombine_u8(vqshrn_n_u16(lo, 4), vqshrn_n_u16(hi, 4));
+	return vandq_u32(vreinterpretq_u32_u8(c), vdupq_n_u32(0x00FFFFFF));
+}
+
+static inline uint32x4_t _brighten4(uint32x4_t color, int y) {
+	uint8x16_t c = vreinterpretq_u8_u32(color);
+	uint8x16_t inverse = vmvnq_u8(c);
+	uint16x8_t lo = vaddw_u8(vshrq_n_u16(vmull_u8(vget_low_u8(inverse), vdup_n_u8(y)), 4), vget_low_u8(c));
+	uint16x8_t hi = vaddw_u8(vshrq_n_u16(vmull_u8(vget_high_u8(inverse), vdup_n_u8(y)), 4), vget_high_u8(c));
+	return vandq_u32(vreinterpretq_u32_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi))), vdupq_n_u32(0x00FFFFFF));
+}
+
+static inline uint32x4_t _darken4(uint32x4_t color, int y) {
+	static const uint16_t roundValues[8] = { 0, 15, 15, 0, 0, 15, 15, 0 };
+	uint16x8_t round = vld1q_u16(roundValues);
+	uint8x16_t c = vreinterpretq_u8_u32(color);
+	uint16x8_t lo = vmovl_u8(vget_low_u8(c));
+	uint16x8_t hi = vmovl_u8(vget_high_u8(c));
+	lo = vsubq_u16(lo, vshrq_n_u16(vmlaq_n_u16(round, lo, y), 4));
+	hi = vsubq_u16(hi, vshrq_n_u16(vmlaq_n_u16(round, hi, y), 4));
+	return vandq_u32(vreinterpretq_u32_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi))), vdupq_n_u32(0x00FFFFFF));
+}
+#endif
+
+static inline uint32x4_t _isUnwritable4(uint32x4_t current) {
+	return vceqq_u32(vandq_u32(current, vdupq_n_u32(0xFE000000)), vdupq_n_u32(0));
+}
+
+static inline uint32x4_t _hasFlag4(uint32x4_t pixel, uint32_t flag) {
+	return vceqq_u32(vandq_u32(pixel, vdupq_n_u32(flag)), vdupq_n_u32(flag));
+}
+
+static inline bool _any4(uint32x4_t mask) {
+	uint32x2_t any = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+	return vget_lane_u32(any, 0) | vget_lane_u32(any, 1);
+}
+
+// Vector counterparts of _compositeNoBlendNoObjwin and _compositeBlendNoObjwin,
+// leaving the pixels in skip and the ones that can't be written untouched
+static inline uint32x4_t _compositeNoBlendNoObjwin4(uint32x4_t color, uint32x4_t current, uint32x4_t skip) {
+	uint32x4_t result = vbslq_u32(vcltq_u32(color, current), color, vandq_u32(current, vdupq_n_u32(0x00FFFFFF | FLAG_REBLEND | FLAG_OBJWIN)));
+	return vbslq_u32(vorrq_u32(skip, _isUnwritable4(current)), current, result);
+}
+
+static inline uint32x4_t _compositeBlendNoObjwin4(struct GBAVideoSoftwareRenderer* renderer, uint32x4_t color, uint32x4_t current, uint32x4_t skip) {
+	skip = vorrq_u32(skip, _isUnwritable4(current));
+	uint32x4_t above = vcltq_u32(color, current);
+	uint32x4_t result = vbslq_u32(above, vbicq_u32(color, vdupq_n_u32(FLAG_TARGET_2)), vandq_u32(current, vdupq_n_u32(0x00FFFFFF | FLAG_REBLEND | FLAG_OBJWIN)));
+	uint32x4_t blend = vbicq_u32(vandq_u32(_hasFlag4(current, FLAG_TARGET_1), _hasFlag4(color, FLAG_TARGET_2)), vorrq_u32(skip, above));
+	if (_any4(blend)) {
+		result = vbslq_u32(blend, _mix4(renderer->blda, current, renderer->bldb, color), result);
+	}
+	return vbslq_u32(skip, current, result);
+}
+#endif
+
+#if defined(__SSE2__)
+static inline void _tileRowColors(uint64_t indices, const color_t* palette, uint32_t flags, __m128i* color, __m128i* transparent) {
+	__m128i index = _mm_set_epi32(0, 0, indices >> 32, (uint32_t) indices);
+	index = _mm_cmpeq_epi8(index, _mm_setzero_si128());
+	index = _mm_unpacklo_epi8(index, index);
+	transparent[0] = _mm_unpacklo_epi16(index, index);
+	transparent[1] = _mm_unpackhi_epi16(index, index);
+	__m128i flagsVec = _mm_set1_epi32(flags);
+	color[0] = _mm_or_si128(_mm_set_epi32(palette[(indices >> 24) & 0xFF], palette[(indices >> 16) & 0xFF], palette[(indices >> 8) & 0xFF], palette[indices & 0xFF]), flagsVec);
+	color[1] = _mm_or_si128(_mm_set_epi32(palette[indices >> 56], palette[(indices >> 48) & 0xFF], palette[(indices >> 40) & 0xFF], palette[(indices >> 32) & 0xFF]), flagsVec);
+}
+#elif defined(__ARM_NEON)
+static inline void _tileRowColors(uint64_t indices, const color_t* palette, uint32_t flags, uint32x4_t* color, uint32x4_t* transparent) {
+	int16x8_t index = vmovl_s8(vreinterpret_s8_u8(vceq_u8(vcreate_u8(indices), vdup_n_u8(0))));
+	transparent[0] = vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(index)));
+	transparent[1] = vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(index)));
+	uint32_t colors[8];
+	int i;
+	for (i = 0; i < 8; ++i) {
+		colors[i] = palette[(indices >> (i * 8)) & 0xFF];
+	}
+	color[0] = vorrq_u32(vld1q_u32(&colors[0]), vdupq_n_u32(flags));
+	color[1] = vorrq_u32(vld1q_u32(&colors[4]), vdupq_n_u32(flags));
+}
+#endif
+
+// These composite a row of eight background pixels, given as one palette index per byte, doing
+// the transparency masking, the priority comparisons and any blending for four pixels at a time
+static inline void _compositeTileNoBlendNoObjwin(struct GBAVideoSoftwareRenderer* renderer, uint32_t* pixel, uint64_t indices, const color_t* palette, uint32_t flags) {
+#if defined(__SSE2__)
+	UNUSED(renderer);
+	__m128i colors[2];
+	__m128i transparent[2];
+	_tileRowColors(indices, palette, flags, colors, transparent);
+	_mm_storeu_si128((__m128i*) &pixel[0], _compositeNoBlendNoObjwin4(colors[0], _mm_loadu_si128((const __m128i*) &pixel[0]), transparent[0]));
+	_mm_storeu_si128((__m128i*) &pixel[4], _compositeNoBlendNoObjwin4(colors[1], _mm_loadu_si128((const __m128i*) &pixel[4]), transparent[1]));
+#elif defined(__ARM_NEON)
+	UNUSED(renderer);
+	uint32x4_t colors[2];
+	uint32x4_t transparent[2];
+	_tileRowColors(indices, palette, flags, colors, transparent);
+	vst1q_u32(&pixel[0], _compositeNoBlendNoObjwin4(colors[0], vld1q_u32(&pixel[0]), transparent[0]));
+	vst1q_u32(&pixel[4], _compositeNoBlendNoObjwin4(colors[1], vld1q_u32(&pixel[4]), transparent[1]));
+#else
+	int i;
+	for (i = 0; i < 8; ++i, indices >>= 8) {
+		unsigned pixelData = indices & 0xFF;
+		uint32_t current = pixel[i];
+		if (pixelData && IS_WRITABLE(current)) {
+			_compositeNoBlendNoObjwin(renderer, &pixel[i], palette[pixelData] | flags, current);
+		}
+	}
+#endif
+}
+
+static inline void _compositeTileBlendNoObjwin(struct GBAVideoSoftwareRenderer* renderer, uint32_t* pixel, uint64_t indices, const color_t* palette, uint32_t flags) {
+#if defined(__SSE2__)
+	__m128i colors[2];
+	__m128i transparent[2];
+	_tileRowColors(indices, palette, flags, colors, transparent);
+	_mm_storeu_si128((__m128i*) &pixel[0], _compositeBlendNoObjwin4(renderer, colors[0], _mm_loadu_si128((const __m128i*) &pixel[0]), transparent[0]));
+	_mm_storeu_si128((__m128i*) &pixel[4], _compositeBlendNoObjwin4(renderer, colors[1], _mm_loadu_si128((const __m128i*) &pixel[4]), transparent[1]));
+#elif defined(__ARM_NEON)
+	uint32x4_t colors[2];
+	uint32x4_t transparent[2];
+	_tileRowColors(indices, palette, flags, colors, transparent);
+	vst1q_u32(&pixel[0], _compositeBlendNoObjwin4(renderer, colors[0], vld1q_u32(&pixel[0]), transparent[0]));
+	vst1q_u32(&pixel[4], _compositeBlendNoObjwin4(renderer, colors[1], vld1q_u32(&pixel[4]), transparent[1]));
+#else
+	int i;
+	for (i = 0; i < 8; ++i, indices >>= 8) {
+		unsigned pixelData = indices & 0xFF;
+		uint32_t current = pixel[i];
+		if (pixelData && IS_WRITABLE(current)) {
+			_compositeBlendNoObjwin(renderer, &pixel[i], palette[pixelData] | flags, current);
+		}
+	}
+#endif
+}
+
 #endif
@@ -8,10 +8,12 @@
 #include <mgba/core/cache-set.h>
 #include <mgba/internal/arm/macros.h>
 #include <mgba/internal/gba/io.h>
+#include <mgba/internal/gba/memory.h>
 #include <mgba/internal/gba/renderers/cache-set.h>
 
 #include <mgba-util/arm-algo.h>
 #include <mgba-util/memory.h>
+#include <mgba-util/threading.h>
 
 #define DIRTY_SCANLINE(R, Y) R->scanlineDirty[Y >> 5] |= (1 << (Y & 0x1F))
 #define CLEAN_SCANLINE(R, Y) R->scanlineDirty[Y >> 5] &= ~(1 << (Y & 0x1F))
@@ -36,13 +38,68 @@ static void GBAVideoSoftwareRendererWriteBGY_LO(struct GBAVideoSoftwareBackgroun
 static void GBAVideoSoftwareRendererWriteBGY_HI(struct GBAVideoSoftwareBackground* bg, uint16_t value);
 static void GBAVideoSoftwareRendererWriteBLDCNT(struct GBAVideoSoftwareRenderer* renderer, uint16_t value);
 
+static void _renderScanline(struct GBAVideoSoftwareRenderer* renderer, int y);
+static void _composeScanline(struct GBAVideoSoftwareRenderer* renderer, int y, color_t* row);
 static void _drawScanline(struct GBAVideoSoftwareRenderer* renderer, int y);
+static void _advanceScanline(struct GBAVideoSoftwareRenderer* renderer, int y);
 
 static void _updatePalettes(struct GBAVideoSoftwareRenderer* renderer);
+static void _updateVariantPalettes(struct GBAVideoSoftwareRenderer* renderer);
 
-static void _breakWindow(struct GBAVideoSoftwareRenderer* softwareRenderer, struct WindowN* win, int y);
+static bool _windowCoversLine(const struct WindowN* win, int y);
+static void _breakWindow(struct GBAVideoSoftwareRenderer* softwareRenderer, struct WindowN* win);
 static void _breakWindowInner(struct GBAVideoSoftwareRenderer* softwareRenderer, struct WindowN* win);
 
+static void _decodeTileRow(struct GBAVideoSoftwareTileCache* cache, const uint16_t* vram, uint32_t row);
+static void _decodeTiles(struct GBAVideoSoftwareRenderer* renderer);
+static void _binSprites(struct GBAVideoSoftwareRenderer* renderer);
+
+#ifndef DISABLE_THREADING
+// Flushes with fewer lines than this per band aren't worth waking up other threads for
+#define BAND_MIN_LINES 8
+
+struct GBAVideoSoftwareBandLine {
+	int y;
+	int enabled[4];
+};
+
+struct GBAVideoSoftwareBand {
+	struct GBAVideoSoftwareRenderer renderer;
+	struct GBAVideoSoftwareBands* bands;
+	Thread thread;
+	unsigned generation;
+	int start;
+	int end;
+};
+
+struct GBAVideoSoftwareBands {
+	struct GBAVideoSoftwareRenderer* p;
+
+	Mutex mutex;
+	Condition dispatchCond;
+	Condition doneCond;
+	unsigned generation;
+	int running;
+	bool exiting;
+
+	int nBands;
+	struct GBAVideoSoftwareBand band[MAX_BAND_THREADS];
+
+	int nLines;
+	struct GBAVideoSoftwareBandLine lines[GBA_VIDEO_VERTICAL_PIXELS];
+
+	bool vramDirty;
+	uint16_t vram[SIZE_VRAM >> 1];
+	union GBAOAM oam;
+};
+
+static void _createBands(struct GBAVideoSoftwareRenderer* softwareRenderer);
+static void _destroyBands(struct GBAVideoSoftwareRenderer* softwareRenderer);
+static void _resetBands(struct GBAVideoSoftwareRenderer* softwareRenderer);
+static void _queueBandLine(struct GBAVideoSoftwareRenderer* softwareRenderer, int y);
+static void _flushBands(struct GBAVideoSoftwareRenderer* softwareRenderer);
+#endif
+
 void GBAVideoSoftwareRendererCreate(struct GBAVideoSoftwareRenderer* renderer) {
 	renderer->d.init = GBAVideoSoftwareRendererInit;
 	renderer->d.reset = GBAVideoSoftwareRendererReset;
@@ -72,29 +129,109 @@ void GBAVideoSoftwareRendererCreate(struct GBAVideoSoftwareRenderer* renderer) {
 	}
 	renderer->d.highlightColor = GBA_COLOR_WHITE;
 	renderer->d.highlightAmount = 0;
+	// Not associated with any palette RAM yet
+	renderer->d.palette = NULL;
 
 	renderer->temporaryBuffer = 0;
+	renderer->threads = 0;
+	renderer->bands = NULL;
+	renderer->decodeTiles = false;
+	renderer->tileCache = NULL;
+	renderer->colorTable = NULL;
+	renderer->convertRow = NULL;
+	renderer->convertBytes = BYTES_PER_PIXEL;
 }
 
-static void GBAVideoSoftwareRendererInit(struct GBAVideoRenderer* renderer) {
-	GBAVideoSoftwareRendererReset(renderer);
+void GBAVideoSoftwareRendererSetThreads(struct GBAVideoSoftwareRenderer* renderer, int threads) {
+	renderer->threads = threads;
+#ifndef DISABLE_THREADING
+	if (renderer->bands) {
+		_destroyBands(renderer);
+	}
+	if (threads > 1) {
+		_createBands(renderer);
+	}
+#endif
+}
 
+void GBAVideoSoftwareRendererSetTileCache(struct GBAVideoSoftwareRenderer* renderer, bool enable) {
+	renderer->decodeTiles = enable;
+	if (enable && !renderer->tileCache) {
+		renderer->tileCache = anonymousMemoryMap(sizeof(*renderer->tileCache));
+		_decodeTiles(renderer);
+	} else if (!enable && renderer->tileCache) {
+		mappedMemoryFree(renderer->tileCache, sizeof(*renderer->tileCache));
+		renderer->tileCache = NULL;
+	}
+}
+
+void GBAVideoSoftwareRendererSetColorTable(struct GBAVideoSoftwareRenderer* renderer, const color_t* table) {
+	if (renderer->colorTable == table) {
+		return;
+	}
+	renderer->colorTable = table;
+#ifndef DISABLE_THREADING
+	if (renderer->bands) {
+		_flushBands(renderer);
+		int i;
+		for (i = 0; i < renderer->bands->nBands; ++i) {
+			renderer->bands->band[i].renderer.colorTable = table;
+		}
+	}
+#endif
+	if (!renderer->d.palette) {
+		return;
+	}
+	int i;
+	for (i = 0; i < 1024; i += 2) {
+		uint16_t entry;
+		LOAD_16(entry, i, renderer->d.palette);
+		GBAVideoSoftwareRendererWritePalette(&renderer->d, i, entry);
+	}
+}
+
+static void GBAVideoSoftwareRendererInit(struct GBAVideoRenderer* renderer) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
+	if (softwareRenderer->decodeTiles && !softwareRenderer->tileCache) {
+		softwareRenderer->tileCache = anonymousMemoryMap(sizeof(*softwareRenderer->tileCache));
+	}
+
+	GBAVideoSoftwareRendererReset(renderer);
 
+	color_t white = GBA_COLOR_WHITE;
+	if (softwareRenderer->colorTable) {
+		white = softwareRenderer->colorTable[0x7FFF];
+	}
 	int y;
 	for (y = 0; y < GBA_VIDEO_VERTICAL_PIXELS; ++y) {
-		color_t* row = &softwareRenderer->outputBuffer[softwareRenderer->outputBufferStride * y];
+		color_t* row = softwareRenderer->convertRow ? softwareRenderer->convertSource : &softwareRenderer->outputBuffer[softwareRenderer->outputBufferStride * y];
 		int x;
 		for (x = 0; x < GBA_VIDEO_HORIZONTAL_PIXELS; ++x) {
-			row[x] = GBA_COLOR_WHITE;
+			row[x] = white;
 		}
+		if (softwareRenderer->convertRow) {
+			uint8_t* output = (uint8_t*) softwareRenderer->outputBuffer;
+			softwareRenderer->convertRow(&output[softwareRenderer->outputBufferStride * y * softwareRenderer->convertBytes], row, GBA_VIDEO_HORIZONTAL_PIXELS);
+		}
+	}
+
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->threads > 1) {
+		_createBands(softwareRenderer);
 	}
+#endif
 }
 
 static void GBAVideoSoftwareRendererReset(struct GBAVideoRenderer* renderer) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
 	int i;
 
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->bands) {
+		_flushBands(softwareRenderer);
+	}
+#endif
+
 	softwareRenderer->dispcnt = 0x0080;
 
 	softwareRenderer->target1Obj = 0;
@@ -118,6 +255,7 @@ static void GBAVideoSoftwareRendererReset(struct GBAVideoRenderer* renderer) {
 	softwareRenderer->winN[1] = (struct WindowN) { .control = { .priority = 1 } };
 	softwareRenderer->objwin = (struct WindowControl) { .priority = 2 };
 	softwareRenderer->winout = (struct WindowControl) { .priority = 3 };
+	softwareRenderer->windowsKey = -1;
 	softwareRenderer->oamDirty = 1;
 	softwareRenderer->oamMax = 0;
 
@@ -128,7 +266,10 @@ static void GBAVideoSoftwareRendererReset(struct GBAVideoRenderer* renderer) {
 	softwareRenderer->objOffsetY = 0;
 
 	memset(softwareRenderer->scanlineDirty, 0xFFFFFFFF, sizeof(softwareRenderer->scanlineDirty));
+	memset(softwareRenderer->scanlineStale, 0, sizeof(softwareRenderer->scanlineStale));
 	memset(softwareRenderer->cache, 0, sizeof(softwareRenderer->cache));
+	softwareRenderer->frameDirty = true;
+	softwareRenderer->frameChanged = true;
 	memset(softwareRenderer->nextIo, 0, sizeof(softwareRenderer->nextIo));
 
 	softwareRenderer->lastHighlightAmount = 0;
@@ -160,15 +301,41 @@ static void GBAVideoSoftwareRendererReset(struct GBAVideoRenderer* renderer) {
 		bg->offsetX = 0;
 		bg->offsetY = 0;
 	}
+
+	// VRAM may have been replaced wholesale, e.g. by loading a savestate
+	if (softwareRenderer->tileCache) {
+		_decodeTiles(softwareRenderer);
+	}
+
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->bands) {
+		_resetBands(softwareRenderer);
+	}
+#endif
 }
 
 static void GBAVideoSoftwareRendererDeinit(struct GBAVideoRenderer* renderer) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
-	UNUSED(softwareRenderer);
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->bands) {
+		_destroyBands(softwareRenderer);
+	}
+#endif
+	if (softwareRenderer->tileCache) {
+		mappedMemoryFree(softwareRenderer->tileCache, sizeof(*softwareRenderer->tileCache));
+		softwareRenderer->tileCache = NULL;
+	}
 }
 
 static uint16_t GBAVideoSoftwareRendererWriteVideoRegister(struct GBAVideoRenderer* renderer, uint32_t address, uint16_t value) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
+#ifndef DISABLE_THREADING
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	if (bands && bands->nLines && bands->lines[bands->nLines - 1].y >= softwareRenderer->nextY) {
+		// The cache entry for the next line is still waiting to be rendered
+		_flushBands(softwareRenderer);
+	}
+#endif
 	if (renderer->cache) {
 		GBAVideoCacheWriteVideoRegister(renderer->cache, address, value);
 	}
@@ -336,6 +503,7 @@ static uint16_t GBAVideoSoftwareRendererWriteVideoRegister(struct GBAVideoRender
 				softwareRenderer->winN[0].h.start = GBA_VIDEO_HORIZONTAL_PIXELS;
 			}
 		}
+		softwareRenderer->windowsKey = -1;
 		break;
 	case REG_WIN1H:
 		softwareRenderer->winN[1].h.end = value;
@@ -349,6 +517,7 @@ static uint16_t GBAVideoSoftwareRendererWriteVideoRegister(struct GBAVideoRender
 				softwareRenderer->winN[1].h.start = GBA_VIDEO_HORIZONTAL_PIXELS;
 			}
 		}
+		softwareRenderer->windowsKey = -1;
 		break;
 	case REG_WIN0V:
 		softwareRenderer->winN[0].v.end = value;
@@ -380,11 +549,13 @@ static uint16_t GBAVideoSoftwareRendererWriteVideoRegister(struct GBAVideoRender
 		value &= 0x3F3F;
 		softwareRenderer->winN[0].control.packed = value;
 		softwareRenderer->winN[1].control.packed = value >> 8;
+		softwareRenderer->windowsKey = -1;
 		break;
 	case REG_WINOUT:
 		value &= 0x3F3F;
 		softwareRenderer->winout.packed = value;
 		softwareRenderer->objwin.packed = value >> 8;
+		softwareRenderer->windowsKey = -1;
 		break;
 	case REG_MOSAIC:
 		softwareRenderer->mosaic = value;
@@ -405,9 +576,20 @@ static uint16_t GBAVideoSoftwareRendererWriteVideoRegister(struct GBAVideoRender
 
 static void GBAVideoSoftwareRendererWriteVRAM(struct GBAVideoRenderer* renderer, uint32_t address) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
+#ifndef DISABLE_THREADING
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	if (bands) {
+		_flushBands(softwareRenderer);
+		bands->vram[address >> 1] = renderer->vram[address >> 1];
+		bands->vramDirty = true;
+	}
+#endif
 	if (renderer->cache) {
 		mCacheSetWriteVRAM(renderer->cache, address);
 	}
+	if (softwareRenderer->tileCache) {
+		_decodeTileRow(softwareRenderer->tileCache, renderer->vram, address >> 2);
+	}
 	memset(softwareRenderer->scanlineDirty, 0xFFFFFFFF, sizeof(softwareRenderer->scanlineDirty));
 	softwareRenderer->bg[0].yCache = -1;
 	softwareRenderer->bg[1].yCache = -1;
@@ -417,14 +599,32 @@ static void GBAVideoSoftwareRendererWriteVRAM(struct GBAVideoRenderer* renderer,
 
 static void GBAVideoSoftwareRendererWriteOAM(struct GBAVideoRenderer* renderer, uint32_t oam) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
+#ifndef DISABLE_THREADING
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	if (bands) {
+		_flushBands(softwareRenderer);
+		bands->oam.raw[oam] = renderer->oam->raw[oam];
+	}
+#else
 	UNUSED(oam);
+#endif
 	softwareRenderer->oamDirty = 1;
 	memset(softwareRenderer->scanlineDirty, 0xFFFFFFFF, sizeof(softwareRenderer->scanlineDirty));
 }
 
 static void GBAVideoSoftwareRendererWritePalette(struct GBAVideoRenderer* renderer, uint32_t address, uint16_t value) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
-	color_t color = mColorFrom555(value);
+#ifndef DISABLE_THREADING
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	if (bands) {
+		_flushBands(softwareRenderer);
+		int i;
+		for (i = 0; i < bands->nBands; ++i) {
+			GBAVideoSoftwareRendererWritePalette(&bands->band[i].renderer.d, address, value);
+		}
+	}
+#endif
+	color_t color = _colorFrom555(softwareRenderer, value);
 	softwareRenderer->normalPalette[address >> 1] = color;
 	if (softwareRenderer->blendEffect == BLEND_BRIGHTEN) {
 		softwareRenderer->variantPalette[address >> 1] = _brighten(color, softwareRenderer->bldy);
@@ -432,22 +632,19 @@ static void GBAVideoSoftwareRendererWritePalette(struct GBAVideoRenderer* render
 		softwareRenderer->variantPalette[address >> 1] = _darken(color, softwareRenderer->bldy);
 	}
 	if (renderer->cache) {
-		mCacheSetWritePalette(renderer->cache, address >> 1, color);
+		mCacheSetWritePalette(renderer->cache, address >> 1, mColorFrom555(value));
 	}
 	memset(softwareRenderer->scanlineDirty, 0xFFFFFFFF, sizeof(softwareRenderer->scanlineDirty));
 }
 
-static void _breakWindow(struct GBAVideoSoftwareRenderer* softwareRenderer, struct WindowN* win, int y) {
+static bool _windowCoversLine(const struct WindowN* win, int y) {
 	if (win->v.end >= win->v.start) {
-		if (y >= win->v.end) {
-			return;
-		}
-		if (y < win->v.start) {
-			return;
-		}
-	} else if (y >= win->v.end && y < win->v.start) {
-		return;
+		return y < win->v.end && y >= win->v.start;
 	}
+	return y < win->v.end || y >= win->v.start;
+}
+
+static void _breakWindow(struct GBAVideoSoftwareRenderer* softwareRenderer, struct WindowN* win) {
 	if (win->h.end > GBA_VIDEO_HORIZONTAL_PIXELS || win->h.end < win->h.start) {
 		struct WindowN splits[2] = { *win, *win };
 		splits[0].h.start = 0;
@@ -538,7 +735,8 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 	softwareRenderer->cache[y].scale[1][0] = softwareRenderer->bg[3].sx;
 	softwareRenderer->cache[y].scale[1][1] = softwareRenderer->bg[3].sy;
 
-	if (!dirty) {
+	bool stale = softwareRenderer->scanlineStale[y >> 5] & (1 << (y & 0x1F));
+	if (!dirty && !stale) {
 		if (GBARegisterDISPCNTGetMode(softwareRenderer->dispcnt) != 0) {
 			softwareRenderer->bg[2].sx += softwareRenderer->bg[2].dmx;
 			softwareRenderer->bg[2].sy += softwareRenderer->bg[2].dmy;
@@ -549,12 +747,43 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 	}
 
 	CLEAN_SCANLINE(softwareRenderer, y);
+	softwareRenderer->scanlineStale[y >> 5] &= ~(1 << (y & 0x1F));
+	if (dirty) {
+		softwareRenderer->frameDirty = true;
+	}
+
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->bands) {
+		_queueBandLine(softwareRenderer, y);
+		if (!GBARegisterDISPCNTIsForcedBlank(softwareRenderer->dispcnt)) {
+			_advanceScanline(softwareRenderer, y);
+		}
+		return;
+	}
+#endif
+	_renderScanline(softwareRenderer, y);
+}
 
-	color_t* row = &softwareRenderer->outputBuffer[softwareRenderer->outputBufferStride * y];
+static void _renderScanline(struct GBAVideoSoftwareRenderer* softwareRenderer, int y) {
+	if (!softwareRenderer->convertRow) {
+		_composeScanline(softwareRenderer, y, &softwareRenderer->outputBuffer[softwareRenderer->outputBufferStride * y]);
+		return;
+	}
+	// Converting whole lines at once keeps the format out of the per-pixel paths
+	_composeScanline(softwareRenderer, y, softwareRenderer->convertSource);
+	uint8_t* output = (uint8_t*) softwareRenderer->outputBuffer;
+	softwareRenderer->convertRow(&output[softwareRenderer->outputBufferStride * y * softwareRenderer->convertBytes], softwareRenderer->convertSource, GBA_VIDEO_HORIZONTAL_PIXELS);
+}
+
+static void _composeScanline(struct GBAVideoSoftwareRenderer* softwareRenderer, int y, color_t* row) {
 	if (GBARegisterDISPCNTIsForcedBlank(softwareRenderer->dispcnt)) {
+		color_t white = GBA_COLOR_WHITE;
+		if (softwareRenderer->colorTable) {
+			white = softwareRenderer->colorTable[0x7FFF];
+		}
 		int x;
 		for (x = 0; x < GBA_VIDEO_HORIZONTAL_PIXELS; ++x) {
-			row[x] = GBA_COLOR_WHITE;
+			row[x] = white;
 		}
 		return;
 	}
@@ -567,18 +796,33 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 		softwareRenderer->spriteLayer[x + 3] = FLAG_UNWRITTEN;
 	}
 
-	softwareRenderer->windows[0].endX = GBA_VIDEO_HORIZONTAL_PIXELS;
-	softwareRenderer->nWindows = 1;
+	// The spans only depend on which windows cover this line, so they carry over until that or a window register changes
+	int windowsKey = 0;
 	if (GBARegisterDISPCNTIsWin0Enable(softwareRenderer->dispcnt) || GBARegisterDISPCNTIsWin1Enable(softwareRenderer->dispcnt) || GBARegisterDISPCNTIsObjwinEnable(softwareRenderer->dispcnt)) {
-		softwareRenderer->windows[0].control = softwareRenderer->winout;
-		if (GBARegisterDISPCNTIsWin1Enable(softwareRenderer->dispcnt)) {
-			_breakWindow(softwareRenderer, &softwareRenderer->winN[1], y);
+		windowsKey = 4;
+		if (GBARegisterDISPCNTIsWin1Enable(softwareRenderer->dispcnt) && _windowCoversLine(&softwareRenderer->winN[1], y)) {
+			windowsKey |= 2;
 		}
-		if (GBARegisterDISPCNTIsWin0Enable(softwareRenderer->dispcnt)) {
-			_breakWindow(softwareRenderer, &softwareRenderer->winN[0], y);
+		if (GBARegisterDISPCNTIsWin0Enable(softwareRenderer->dispcnt) && _windowCoversLine(&softwareRenderer->winN[0], y)) {
+			windowsKey |= 1;
+		}
+	}
+	if (windowsKey != softwareRenderer->windowsKey) {
+		softwareRenderer->windowsKey = windowsKey;
+		softwareRenderer->windows[0].endX = GBA_VIDEO_HORIZONTAL_PIXELS;
+		softwareRenderer->nWindows = 1;
+		if (windowsKey) {
+			softwareRenderer->windows[0].control = softwareRenderer->winout;
+			if (windowsKey & 2) {
+				_breakWindow(softwareRenderer, &softwareRenderer->winN[1]);
+			}
+			if (windowsKey & 1) {
+				_breakWindow(softwareRenderer, &softwareRenderer->winN[0]);
+			}
+		} else {
+			// Reset the priority too, so it doesn't depend on which window began the previous line
+			softwareRenderer->windows[0].control = (struct WindowControl) { .packed = 0xFF, .priority = softwareRenderer->winout.priority };
 		}
-	} else {
-		softwareRenderer->windows[0].control.packed = 0xFF;
 	}
 
 	if (softwareRenderer->lastHighlightAmount != softwareRenderer->d.highlightAmount) {
@@ -592,8 +836,14 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 		_updatePalettes(softwareRenderer);
 		softwareRenderer->blendDirty = false;
 	}
+	_updateVariantPalettes(softwareRenderer);
 	softwareRenderer->forceTarget1 = false;
 
+	if (GBAVideoSoftwareRendererDrawBitmapScanline(softwareRenderer, row)) {
+		_advanceScanline(softwareRenderer, y);
+		return;
+	}
+
 	int w;
 	x = 0;
 	for (w = 0; w < softwareRenderer->nWindows; ++w) {
@@ -633,6 +883,21 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 				backdrop |= softwareRenderer->variantPalette[0];
 			}
 			int end = softwareRenderer->windows[w].endX;
+#if defined(__SSE2__)
+			__m128i backdropColor = _mm_set1_epi32(backdrop);
+			for (; x + 4 <= end; x += 4) {
+				__m128i color = _mm_loadu_si128((const __m128i*) &softwareRenderer->row[x]);
+				__m128i mixed = _mix4(softwareRenderer->bldb, backdropColor, softwareRenderer->blda, color);
+				_mm_storeu_si128((__m128i*) &softwareRenderer->row[x], _select4(_hasFlag4(color, FLAG_TARGET_1), mixed, color));
+			}
+#elif defined(__ARM_NEON)
+			uint32x4_t backdropColor = vdupq_n_u32(backdrop);
+			for (; x + 4 <= end; x += 4) {
+				uint32x4_t color = vld1q_u32(&softwareRenderer->row[x]);
+				uint32x4_t mixed = _mix4(softwareRenderer->bldb, backdropColor, softwareRenderer->blda, color);
+				vst1q_u32(&softwareRenderer->row[x], vbslq_u32(_hasFlag4(color, FLAG_TARGET_1), mixed, color));
+			}
+#endif
 			for (; x < end; ++x) {
 				uint32_t color = softwareRenderer->row[x];
 				if (color & FLAG_TARGET_1) {
@@ -658,6 +923,35 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 				x = end;
 				continue;
 			}
+#if defined(__SSE2__)
+			__m128i maskVec = _mm_set1_epi32(mask);
+			__m128i matchVec = _mm_set1_epi32(match);
+			for (; x + 4 <= end; x += 4) {
+				__m128i color = _mm_loadu_si128((const __m128i*) &softwareRenderer->row[x]);
+				__m128i adjusted;
+				if (softwareRenderer->blendEffect == BLEND_DARKEN) {
+					adjusted = _darken4(color, softwareRenderer->bldy);
+				} else {
+					adjusted = _brighten4(color, softwareRenderer->bldy);
+				}
+				__m128i selected = _mm_cmpeq_epi32(_mm_and_si128(color, maskVec), matchVec);
+				_mm_storeu_si128((__m128i*) &softwareRenderer->row[x], _select4(selected, adjusted, color));
+			}
+#elif defined(__ARM_NEON)
+			uint32x4_t maskVec = vdupq_n_u32(mask);
+			uint32x4_t matchVec = vdupq_n_u32(match);
+			for (; x + 4 <= end; x += 4) {
+				uint32x4_t color = vld1q_u32(&softwareRenderer->row[x]);
+				uint32x4_t adjusted;
+				if (softwareRenderer->blendEffect == BLEND_DARKEN) {
+					adjusted = _darken4(color, softwareRenderer->bldy);
+				} else {
+					adjusted = _brighten4(color, softwareRenderer->bldy);
+				}
+				uint32x4_t selected = vceqq_u32(vandq_u32(color, maskVec), matchVec);
+				vst1q_u32(&softwareRenderer->row[x], vbslq_u32(selected, adjusted, color));
+			}
+#endif
 			if (softwareRenderer->blendEffect == BLEND_DARKEN) {
 				for (; x < end; ++x) {
 					uint32_t color = softwareRenderer->row[x];
@@ -677,7 +971,24 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 	}
 
 #ifdef COLOR_16_BIT
-	for (x = 0; x < GBA_VIDEO_HORIZONTAL_PIXELS; x += 4) {
+	x = 0;
+#if defined(__SSE2__)
+	for (; x < GBA_VIDEO_HORIZONTAL_PIXELS; x += 8) {
+		// Sign-extending the low halves first keeps the saturating pack from clamping them
+		__m128i lo = _mm_loadu_si128((const __m128i*) &softwareRenderer->row[x]);
+		__m128i hi = _mm_loadu_si128((const __m128i*) &softwareRenderer->row[x + 4]);
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128((__m128i*) &row[x], _mm_packs_epi32(lo, hi));
+	}
+#elif defined(__ARM_NEON)
+	for (; x < GBA_VIDEO_HORIZONTAL_PIXELS; x += 8) {
+		uint16x4_t lo = vmovn_u32(vld1q_u32(&softwareRenderer->row[x]));
+		uint16x4_t hi = vmovn_u32(vld1q_u32(&softwareRenderer->row[x + 4]));
+		vst1q_u16(&row[x], vcombine_u16(lo, hi));
+	}
+#endif
+	for (; x < GBA_VIDEO_HORIZONTAL_PIXELS; x += 4) {
 		row[x] = softwareRenderer->row[x];
 		row[x + 1] = softwareRenderer->row[x + 1];
 		row[x + 2] = softwareRenderer->row[x + 2];
@@ -690,8 +1001,15 @@ static void GBAVideoSoftwareRendererDrawScanline(struct GBAVideoRenderer* render
 
 static void GBAVideoSoftwareRendererFinishFrame(struct GBAVideoRenderer* renderer) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->bands) {
+		_flushBands(softwareRenderer);
+	}
+#endif
 
 	softwareRenderer->nextY = 0;
+	softwareRenderer->frameChanged = softwareRenderer->frameDirty;
+	softwareRenderer->frameDirty = false;
 	if (softwareRenderer->temporaryBuffer) {
 		mappedMemoryFree(softwareRenderer->temporaryBuffer, GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS * 4);
 		softwareRenderer->temporaryBuffer = 0;
@@ -717,18 +1035,35 @@ static void GBAVideoSoftwareRendererFinishFrame(struct GBAVideoRenderer* rendere
 
 static void GBAVideoSoftwareRendererGetPixels(struct GBAVideoRenderer* renderer, size_t* stride, const void** pixels) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->bands) {
+		_flushBands(softwareRenderer);
+	}
+#endif
 	*stride = softwareRenderer->outputBufferStride;
 	*pixels = softwareRenderer->outputBuffer;
 }
 
 static void GBAVideoSoftwareRendererPutPixels(struct GBAVideoRenderer* renderer, size_t stride, const void* pixels) {
 	struct GBAVideoSoftwareRenderer* softwareRenderer = (struct GBAVideoSoftwareRenderer*) renderer;
+#ifndef DISABLE_THREADING
+	if (softwareRenderer->bands) {
+		_flushBands(softwareRenderer);
+	}
+#endif
 
 	const color_t* colorPixels = pixels;
 	unsigned i;
 	for (i = 0; i < GBA_VIDEO_VERTICAL_PIXELS; ++i) {
+		if (softwareRenderer->convertRow) {
+			uint8_t* output = (uint8_t*) softwareRenderer->outputBuffer;
+			softwareRenderer->convertRow(&output[softwareRenderer->outputBufferStride * i * softwareRenderer->convertBytes], &colorPixels[stride * i], GBA_VIDEO_HORIZONTAL_PIXELS);
+			continue;
+		}
 		memmove(&softwareRenderer->outputBuffer[softwareRenderer->outputBufferStride * i], &colorPixels[stride * i], GBA_VIDEO_HORIZONTAL_PIXELS * BYTES_PER_PIXEL);
 	}
+	softwareRenderer->frameDirty = true;
+	softwareRenderer->frameChanged = true;
 }
 
 static void _enableBg(struct GBAVideoSoftwareRenderer* renderer, int bg, bool active) {
@@ -824,19 +1159,19 @@ static void _drawScanline(struct GBAVideoSoftwareRenderer* renderer, int y) {
 	if (GBARegisterDISPCNTIsObjEnable(renderer->dispcnt) && !renderer->d.disableOBJ) {
 		if (renderer->oamDirty) {
 			renderer->oamMax = GBAVideoRendererCleanOAM(renderer->d.oam->obj, renderer->sprites, renderer->objOffsetY);
+			_binSprites(renderer);
 			renderer->oamDirty = false;
 		}
 		renderer->spriteCyclesRemaining = GBARegisterDISPCNTIsHblankIntervalFree(renderer->dispcnt) ? OBJ_HBLANK_FREE_LENGTH : OBJ_LENGTH;
 		int mosaicV = GBAMosaicControlGetObjV(renderer->mosaic) + 1;
 		int mosaicY = y - (y % mosaicV);
+		const uint8_t* spriteLine = renderer->spriteLines[y];
+		int nSprites = renderer->spriteLineCount[y];
 		int i;
-		for (i = 0; i < renderer->oamMax; ++i) {
-			struct GBAVideoRendererSprite* sprite = &renderer->sprites[i];
+		for (i = 0; i < nSprites; ++i) {
+			struct GBAVideoRendererSprite* sprite = &renderer->sprites[spriteLine[i]];
 			int localY = y;
 			renderer->end = 0;
-			if ((y < sprite->y && (sprite->endY - 256 < 0 || y >= sprite->endY - 256)) || y >= sprite->endY) {
-				continue;
-			}
 			if (GBAObjAttributesAIsMosaic(sprite->obj.a) && mosaicV > 1) {
 				localY = mosaicY;
 				if (localY < sprite->y && sprite->y < GBA_VIDEO_VERTICAL_PIXELS) {
@@ -918,6 +1253,56 @@ static void _drawScanline(struct GBAVideoSoftwareRenderer* renderer, int y) {
 			}
 		}
 	}
+	_advanceScanline(renderer, y);
+}
+
+static void _decodeTileRow(struct GBAVideoSoftwareTileCache* cache, const uint16_t* vram, uint32_t row) {
+	uint32_t tileData;
+	LOAD_32(tileData, row << 2, vram);
+	uint64_t indices = _expandTileRow16(tileData);
+	STORE_64LE(indices, row << 3, cache->indices);
+	// Every index fits in a nibble, so this sets the top bit of exactly the nonzero bytes,
+	// which the multiply then gathers into the top byte
+	uint64_t opaque = (indices + 0x7F7F7F7F7F7F7F7FULL) & 0x8080808080808080ULL;
+	cache->opaque[row] = ((opaque >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+static void _decodeTiles(struct GBAVideoSoftwareRenderer* renderer) {
+	uint32_t row;
+	for (row = 0; row < SIZE_VRAM >> 2; ++row) {
+		_decodeTileRow(renderer->tileCache, renderer->d.vram, row);
+	}
+}
+
+static void _binSprite(struct GBAVideoSoftwareRenderer* renderer, int sprite, int start, int end) {
+	if (start < 0) {
+		start = 0;
+	}
+	if (end > GBA_VIDEO_VERTICAL_PIXELS) {
+		end = GBA_VIDEO_VERTICAL_PIXELS;
+	}
+	int y;
+	for (y = start; y < end; ++y) {
+		renderer->spriteLines[y][renderer->spriteLineCount[y]] = sprite;
+		++renderer->spriteLineCount[y];
+	}
+}
+
+static void _binSprites(struct GBAVideoSoftwareRenderer* renderer) {
+	// Bins keep OAM order so the per-line cycle budget runs out on the same sprite
+	memset(renderer->spriteLineCount, 0, sizeof(renderer->spriteLineCount));
+	int i;
+	for (i = 0; i < renderer->oamMax; ++i) {
+		const struct GBAVideoRendererSprite* sprite = &renderer->sprites[i];
+		_binSprite(renderer, i, sprite->y, sprite->endY);
+		if (sprite->endY - 256 >= 0) {
+			// Sprites hanging off the bottom wrap around to the top
+			_binSprite(renderer, i, 0, sprite->endY - 256);
+		}
+	}
+}
+
+static void _advanceScanline(struct GBAVideoSoftwareRenderer* renderer, int y) {
 	if (GBARegisterDISPCNTGetMode(renderer->dispcnt) != 0) {
 		renderer->bg[2].sx += renderer->bg[2].dmx;
 		renderer->bg[2].sy += renderer->bg[2].dmy;
@@ -944,26 +1329,322 @@ static void _drawScanline(struct GBAVideoSoftwareRenderer* renderer, int y) {
 }
 
 static void _updatePalettes(struct GBAVideoSoftwareRenderer* renderer) {
-	int i;
-	if (renderer->blendEffect == BLEND_BRIGHTEN) {
+	// The variants are filled in by _updateVariantPalettes once a line actually uses them
+	renderer->variantDirty = 3;
+	unsigned highlightAmount = renderer->d.highlightAmount >> 4;
+	if (highlightAmount) {
+		int i;
 		for (i = 0; i < 512; ++i) {
-			renderer->variantPalette[i] = _brighten(renderer->normalPalette[i], renderer->bldy);
+			renderer->highlightPalette[i] = _mix(0x10 - highlightAmount, renderer->normalPalette[i], highlightAmount, renderer->d.highlightColor);
 		}
-	} else if (renderer->blendEffect == BLEND_DARKEN) {
-		for (i = 0; i < 512; ++i) {
-			renderer->variantPalette[i] = _darken(renderer->normalPalette[i], renderer->bldy);
+	}
+}
+
+static void _adjustPalette(color_t* out, const color_t* in, int count, enum GBAVideoBlendEffect effect, int y) {
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+#ifdef COLOR_16_BIT
+		__m128i color = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*) &in[i]), _mm_setzero_si128());
+#else
+		__m128i color = _mm_loadu_si128((const __m128i*) &in[i]);
+#endif
+		color = effect == BLEND_BRIGHTEN ? _brighten4(color, y) : _darken4(color, y);
+#ifdef COLOR_16_BIT
+		// There's no unsigned saturating pack in SSE2, so move the colors into signed range and back
+		color = _mm_packs_epi32(_mm_sub_epi32(color, _mm_set1_epi32(0x8000)), _mm_setzero_si128());
+		_mm_storel_epi64((__m128i*) &out[i], _mm_add_epi16(color, _mm_set1_epi16(-0x8000)));
+#else
+		_mm_storeu_si128((__m128i*) &out[i], color);
+#endif
+	}
+#elif defined(__ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+#ifdef COLOR_16_BIT
+		uint32x4_t color = vmovl_u16(vld1_u16(&in[i]));
+#else
+		uint32x4_t color = vld1q_u32(&in[i]);
+#endif
+		color = effect == BLEND_BRIGHTEN ? _brighten4(color, y) : _darken4(color, y);
+#ifdef COLOR_16_BIT
+		vst1_u16(&out[i], vmovn_u32(color));
+#else
+		vst1q_u32(&out[i], color);
+#endif
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] = effect == BLEND_BRIGHTEN ? _brighten(in[i], y) : _darken(in[i], y);
+	}
+}
+
+// Fills in the halves of the variant palettes that are stale and that this line can read from,
+// the backgrounds' half for the backdrop or any background layer and the sprites' for sprites
+static void _updateVariantPalettes(struct GBAVideoSoftwareRenderer* renderer) {
+	if (renderer->blendEffect != BLEND_BRIGHTEN && renderer->blendEffect != BLEND_DARKEN) {
+		return;
+	}
+	unsigned needed = 0;
+	if (renderer->target1Bd || renderer->bg[0].target1 || renderer->bg[1].target1 || renderer->bg[2].target1 || renderer->bg[3].target1) {
+		needed |= 1;
+	}
+	if (renderer->target1Obj) {
+		needed |= 2;
+	}
+	needed &= renderer->variantDirty;
+	if (!needed) {
+		return;
+	}
+	renderer->variantDirty &= ~needed;
+	unsigned highlightAmount = renderer->d.highlightAmount >> 4;
+	int half;
+	for (half = 0; half < 2; ++half) {
+		if (!(needed & (1 << half))) {
+			continue;
 		}
-	} else {
-		for (i = 0; i < 512; ++i) {
-			renderer->variantPalette[i] = renderer->normalPalette[i];
+		int start = half * 256;
+		_adjustPalette(&renderer->variantPalette[start], &renderer->normalPalette[start], 256, renderer->blendEffect, renderer->bldy);
+		if (highlightAmount) {
+			int i;
+			for (i = start; i < start + 256; ++i) {
+				renderer->highlightVariantPalette[i] = _mix(0x10 - highlightAmount, renderer->variantPalette[i], highlightAmount, renderer->d.highlightColor);
+			}
 		}
 	}
-	unsigned highlightAmount = renderer->d.highlightAmount >> 4;
+}
 
-	if (highlightAmount) {
-		for (i = 0; i < 512; ++i) {
-			renderer->highlightPalette[i] = _mix(0x10 - highlightAmount, renderer->normalPalette[i], highlightAmount, renderer->d.highlightColor);
-			renderer->highlightVariantPalette[i] = _mix(0x10 - highlightAmount, renderer->variantPalette[i], highlightAmount, renderer->d.highlightColor);
+#ifndef DISABLE_THREADING
+static void _renderBand(struct GBAVideoSoftwareBand* band) {
+	struct GBAVideoSoftwareRenderer* renderer = &band->renderer;
+	const struct GBAVideoSoftwareRenderer* softwareRenderer = band->bands->p;
+	int i;
+	for (i = band->start; i < band->end; ++i) {
+		const struct GBAVideoSoftwareBandLine* line = &band->bands->lines[i];
+		const struct ScanlineCache* cache = &softwareRenderer->cache[line->y];
+		// Bring this band up to date with the registers as they were latched for the line
+		uint32_t address;
+		for (address = REG_DISPCNT; address <= REG_BLDY; address += 2) {
+			if ((address > REG_DISPCNT && address < REG_BG0CNT) || address == REG_MOSAIC + 2) {
+				continue;
+			}
+			uint16_t value = cache->io[address >> 1];
+			if (renderer->nextIo[address >> 1] != value) {
+				GBAVideoSoftwareRendererWriteVideoRegister(&renderer->d, address, value);
+			}
+		}
+		renderer->bg[2].sx = cache->scale[0][0];
+		renderer->bg[2].sy = cache->scale[0][1];
+		renderer->bg[3].sx = cache->scale[1][0];
+		renderer->bg[3].sy = cache->scale[1][1];
+		int bg;
+		for (bg = 0; bg < 4; ++bg) {
+			renderer->bg[bg].enabled = line->enabled[bg];
+		}
+		_renderScanline(renderer, line->y);
+	}
+}
+
+static THREAD_ENTRY _bandThread(void* context) {
+	struct GBAVideoSoftwareBand* band = context;
+	struct GBAVideoSoftwareBands* bands = band->bands;
+	ThreadSetName("Video Band Rendering");
+	ThreadPlaceHelper();
+
+	MutexLock(&bands->mutex);
+	while (true) {
+		while (!bands->exiting && bands->generation == band->generation) {
+			ConditionWait(&bands->dispatchCond, &bands->mutex);
+		}
+		if (bands->exiting) {
+			break;
+		}
+		band->generation = bands->generation;
+		MutexUnlock(&bands->mutex);
+		_renderBand(band);
+		MutexLock(&bands->mutex);
+		--bands->running;
+		if (!bands->running) {
+			ConditionWake(&bands->doneCond);
+		}
+	}
+	MutexUnlock(&bands->mutex);
+
+#ifdef _3DS
+	svcExitThread();
+#endif
+	return 0;
+}
+
+static void _attachBands(struct GBAVideoSoftwareRenderer* softwareRenderer) {
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	memcpy(bands->vram, softwareRenderer->d.vram, sizeof(bands->vram));
+	memcpy(bands->oam.raw, softwareRenderer->d.oam->raw, sizeof(bands->oam.raw));
+	bands->vramDirty = false;
+	bands->nLines = 0;
+	int i;
+	for (i = 0; i < bands->nBands; ++i) {
+		struct GBAVideoSoftwareRenderer* renderer = &bands->band[i].renderer;
+		renderer->d.cache = NULL;
+		renderer->d.palette = softwareRenderer->d.palette;
+		renderer->d.vram = bands->vram;
+		renderer->d.oam = &bands->oam;
+		// Picked up from this renderer again when flushing
+		renderer->tileCache = NULL;
+	}
+}
+
+static void _resetBands(struct GBAVideoSoftwareRenderer* softwareRenderer) {
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	_attachBands(softwareRenderer);
+	int i;
+	for (i = 0; i < bands->nBands; ++i) {
+		GBAVideoSoftwareRendererReset(&bands->band[i].renderer.d);
+	}
+}
+
+static void _createBands(struct GBAVideoSoftwareRenderer* softwareRenderer) {
+	struct GBAVideoSoftwareBands* bands = anonymousMemoryMap(sizeof(*bands));
+	bands->p = softwareRenderer;
+	bands->nBands = softwareRenderer->threads;
+	if (bands->nBands > MAX_BAND_THREADS) {
+		bands->nBands = MAX_BAND_THREADS;
+	}
+	MutexInit(&bands->mutex);
+	ConditionInit(&bands->dispatchCond);
+	ConditionInit(&bands->doneCond);
+
+	// Bands only replay registers that changed since the last line they rendered,
+	// so they need to start out exactly where this renderer is
+	int i;
+	for (i = 0; i < bands->nBands; ++i) {
+		struct GBAVideoSoftwareRenderer* renderer = &bands->band[i].renderer;
+		bands->band[i].bands = bands;
+		*renderer = *softwareRenderer;
+		renderer->temporaryBuffer = NULL;
+		renderer->threads = 0;
+		renderer->bands = NULL;
+	}
+	softwareRenderer->bands = bands;
+	_attachBands(softwareRenderer);
+
+	// The first band is rendered on the emulation thread itself
+	for (i = 1; i < bands->nBands; ++i) {
+		// Set before the thread starts so a flush racing its startup isn't missed
+		bands->band[i].generation = bands->generation;
+		ThreadCreate(&bands->band[i].thread, _bandThread, &bands->band[i]);
+	}
+}
+
+static void _destroyBands(struct GBAVideoSoftwareRenderer* softwareRenderer) {
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	_flushBands(softwareRenderer);
+	MutexLock(&bands->mutex);
+	bands->exiting = true;
+	ConditionWake(&bands->dispatchCond);
+	MutexUnlock(&bands->mutex);
+	int i;
+	for (i = 1; i < bands->nBands; ++i) {
+		ThreadJoin(&bands->band[i].thread);
+	}
+	ConditionDeinit(&bands->doneCond);
+	ConditionDeinit(&bands->dispatchCond);
+	MutexDeinit(&bands->mutex);
+	mappedMemoryFree(bands, sizeof(*bands));
+	softwareRenderer->bands = NULL;
+
+	// Derived state was only kept up to date on the bands
+	softwareRenderer->oamDirty = true;
+	softwareRenderer->blendDirty = true;
+	memset(softwareRenderer->scanlineDirty, 0xFFFFFFFF, sizeof(softwareRenderer->scanlineDirty));
+}
+
+static void _queueBandLine(struct GBAVideoSoftwareRenderer* softwareRenderer, int y) {
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	if (bands->nLines && bands->lines[bands->nLines - 1].y >= y) {
+		// A frame ended without being finished, so the cache is about to be reused
+		_flushBands(softwareRenderer);
+	}
+	struct GBAVideoSoftwareBandLine* line = &bands->lines[bands->nLines];
+	++bands->nLines;
+	line->y = y;
+	int bg;
+	for (bg = 0; bg < 4; ++bg) {
+		line->enabled[bg] = softwareRenderer->bg[bg].enabled;
+	}
+}
+
+static void _syncBand(struct GBAVideoSoftwareRenderer* renderer, const struct GBAVideoSoftwareRenderer* softwareRenderer, bool vramDirty) {
+	renderer->outputBuffer = softwareRenderer->outputBuffer;
+	renderer->outputBufferStride = softwareRenderer->outputBufferStride;
+	renderer->convertRow = softwareRenderer->convertRow;
+	renderer->convertBytes = softwareRenderer->convertBytes;
+	memcpy(renderer->d.disableBG, softwareRenderer->d.disableBG, sizeof(renderer->d.disableBG));
+	renderer->d.disableOBJ = softwareRenderer->d.disableOBJ;
+	memcpy(renderer->d.highlightBG, softwareRenderer->d.highlightBG, sizeof(renderer->d.highlightBG));
+	memcpy(renderer->d.highlightOBJ, softwareRenderer->d.highlightOBJ, sizeof(renderer->d.highlightOBJ));
+	renderer->d.highlightColor = softwareRenderer->d.highlightColor;
+	renderer->d.highlightAmount = softwareRenderer->d.highlightAmount;
+	renderer->objOffsetX = softwareRenderer->objOffsetX;
+	renderer->objOffsetY = softwareRenderer->objOffsetY;
+	// Only ever written to between flushes
+	renderer->tileCache = softwareRenderer->tileCache;
+	if (softwareRenderer->oamDirty) {
+		renderer->oamDirty = true;
+	}
+	int bg;
+	for (bg = 0; bg < 4; ++bg) {
+		renderer->bg[bg].offsetX = softwareRenderer->bg[bg].offsetX;
+		renderer->bg[bg].offsetY = softwareRenderer->bg[bg].offsetY;
+		if (vramDirty) {
+			renderer->bg[bg].yCache = -1;
 		}
 	}
 }
+
+static void _flushBands(struct GBAVideoSoftwareRenderer* softwareRenderer) {
+	struct GBAVideoSoftwareBands* bands = softwareRenderer->bands;
+	if (!bands->nLines) {
+		return;
+	}
+	int i;
+	for (i = 0; i < bands->nBands; ++i) {
+		_syncBand(&bands->band[i].renderer, softwareRenderer, bands->vramDirty);
+	}
+	softwareRenderer->oamDirty = false;
+	bands->vramDirty = false;
+
+	int active = bands->nLines / BAND_MIN_LINES;
+	if (active < 1) {
+		active = 1;
+	} else if (active > bands->nBands) {
+		active = bands->nBands;
+	}
+	int start = 0;
+	for (i = 0; i < bands->nBands; ++i) {
+		int end = start;
+		if (i < active) {
+			end = bands->nLines * (i + 1) / active;
+		}
+		bands->band[i].start = start;
+		bands->band[i].end = end;
+		start = end;
+	}
+
+	if (active > 1) {
+		MutexLock(&bands->mutex);
+		bands->running = bands->nBands - 1;
+		++bands->generation;
+		ConditionWake(&bands->dispatchCond);
+		MutexUnlock(&bands->mutex);
+	}
+	_renderBand(&bands->band[0]);
+	if (active > 1) {
+		MutexLock(&bands->mutex);
+		while (bands->running) {
+			ConditionWait(&bands->doneCond, &bands->mutex);
+		}
+		MutexUnlock(&bands->mutex);
+	}
+	bands->nLines = 0;
+}
+#endif
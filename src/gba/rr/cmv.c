@@ -0,0 +1,694 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/internal/gba/rr/cmv.h>
+
+#include <mgba/internal/gba/gba.h>
+#include <mgba/internal/gba/serialize.h>
+#include <mgba-util/memory.h>
+#include <mgba-util/vfs.h>
+
+#define CMV_MAGIC "GBAc"
+#define CMV_TRAILER_MAGIC "GBAx"
+#define CMV_VERSION 1
+#define CMV_HEADER_SIZE 8
+
+// Recorded data is handed to the writer in blocks of at least this size, or after this many frames
+#define CMV_FLUSH_SIZE 0x1000
+#define CMV_FLUSH_FRAMES 3600
+
+DEFINE_VECTOR(GBACMVKeyframeList, struct GBACMVKeyframe);
+
+/* File layout, all little-endian:
+ *   magic "GBAc", u32 version
+ *   records, each a tag byte followed by:
+ *     CMV_RUN:      u16 input, varint frame count
+ *     CMV_KEYFRAME: u32 frame, u32 size, savestate; only a seek point
+ *     CMV_LOAD:     same as CMV_KEYFRAME, but the state was loaded while recording and must be loaded back
+ *     CMV_END:      u32 frames, u32 lag frames, u32 rerecords, u32 count, count * (u32 frame, u32 offset)
+ *   u32 offset of CMV_END, magic "GBAx"
+ * A movie cut short, e.g. by a crash, has no CMV_END and is scanned for its keyframes instead.
+ */
+enum GBACMVTag {
+	CMV_RUN = 0x01,
+	CMV_KEYFRAME = 0x02,
+	CMV_LOAD = 0x03,
+	CMV_END = 0x04,
+};
+
+enum {
+	CMV_INPUT_MASK = 0x3FF,
+	CMV_INPUT_LAG = 0x8000,
+};
+
+static void GBACMVContextDestroy(struct GBARRContext*);
+
+static bool GBACMVStartPlaying(struct GBARRContext*, bool autorecord);
+static void GBACMVStopPlaying(struct GBARRContext*);
+static bool GBACMVStartRecording(struct GBARRContext*);
+static void GBACMVStopRecording(struct GBARRContext*);
+
+static bool GBACMVIsPlaying(const struct GBARRContext*);
+static bool GBACMVIsRecording(const struct GBARRContext*);
+
+static void GBACMVNextFrame(struct GBARRContext*);
+static void GBACMVLogInput(struct GBARRContext*, uint16_t input);
+static uint16_t GBACMVQueryInput(struct GBARRContext*);
+static bool GBACMVQueryReset(struct GBARRContext*);
+
+static void GBACMVStateSaved(struct GBARRContext* rr, struct GBASerializedState* state);
+static void GBACMVStateLoaded(struct GBARRContext* rr, const struct GBASerializedState* state);
+
+static struct VFile* GBACMVOpenSavedata(struct GBARRContext*, int flags);
+static struct VFile* GBACMVOpenSavestate(struct GBARRContext*, int flags);
+
+static void _startWriter(struct GBACMVContext*);
+static void _stopWriter(struct GBACMVContext*);
+static void _flush(struct GBACMVContext*);
+static uint8_t* _reserve(struct GBACMVContext*, size_t size);
+static void _emitRun(struct GBACMVContext*);
+static void _emitState(struct GBACMVContext*, enum GBACMVTag tag, const struct GBASerializedState* state);
+static void _emitEnd(struct GBACMVContext*);
+
+static bool _loadIndex(struct GBACMVContext*);
+static bool _loadState(struct GBACMVContext*, uint32_t offset);
+static bool _nextRun(struct GBACMVContext*);
+static void _streamEndReached(struct GBACMVContext*);
+
+void GBACMVContextCreate(struct GBACMVContext* cmv, struct GBA* gba) {
+	memset(cmv, 0, sizeof(*cmv));
+
+	cmv->d.destroy = GBACMVContextDestroy;
+
+	cmv->d.startPlaying = GBACMVStartPlaying;
+	cmv->d.stopPlaying = GBACMVStopPlaying;
+	cmv->d.startRecording = GBACMVStartRecording;
+	cmv->d.stopRecording = GBACMVStopRecording;
+
+	cmv->d.isPlaying = GBACMVIsPlaying;
+	cmv->d.isRecording = GBACMVIsRecording;
+
+	cmv->d.nextFrame = GBACMVNextFrame;
+	cmv->d.logInput = GBACMVLogInput;
+	cmv->d.queryInput = GBACMVQueryInput;
+	cmv->d.queryReset = GBACMVQueryReset;
+
+	cmv->d.stateSaved = GBACMVStateSaved;
+	cmv->d.stateLoaded = GBACMVStateLoaded;
+
+	cmv->d.openSavedata = GBACMVOpenSavedata;
+	cmv->d.openSavestate = GBACMVOpenSavestate;
+
+	cmv->gba = gba;
+	cmv->keyframeInterval = GBA_CMV_DEFAULT_KEYFRAME_INTERVAL;
+	GBACMVKeyframeListInit(&cmv->keyframes, 0);
+}
+
+void GBACMVContextDestroy(struct GBARRContext* rr) {
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	if (cmv->vf) {
+		cmv->vf->close(cmv->vf);
+	}
+	if (cmv->scratch) {
+		mappedMemoryFree(cmv->scratch, sizeof(*cmv->scratch));
+	}
+	free(cmv->buffer);
+	GBACMVKeyframeListDeinit(&cmv->keyframes);
+}
+
+bool GBACMVSetStream(struct GBACMVContext* cmv, struct VFile* vf) {
+	if (cmv->d.isPlaying(&cmv->d) || cmv->d.isRecording(&cmv->d)) {
+		return false;
+	}
+	if (cmv->vf) {
+		cmv->vf->close(cmv->vf);
+	}
+	cmv->vf = vf;
+	GBACMVKeyframeListClear(&cmv->keyframes);
+	if (vf->size(vf) && !_loadIndex(cmv)) {
+		cmv->vf = NULL;
+		return false;
+	}
+	return true;
+}
+
+int32_t GBACMVSeek(struct GBACMVContext* cmv, uint32_t frame) {
+	if (!cmv->d.isPlaying(&cmv->d)) {
+		return -1;
+	}
+	const struct GBACMVKeyframe* best = NULL;
+	size_t i;
+	for (i = 0; i < GBACMVKeyframeListSize(&cmv->keyframes); ++i) {
+		const struct GBACMVKeyframe* keyframe = GBACMVKeyframeListGetConstPointer(&cmv->keyframes, i);
+		if (keyframe->frame <= frame && (!best || keyframe->frame >= best->frame)) {
+			best = keyframe;
+		}
+	}
+	if (!best || !_loadState(cmv, best->offset)) {
+		return -1;
+	}
+	cmv->d.frames = best->frame;
+	cmv->inputThisFrame = false;
+	if (!_nextRun(cmv)) {
+		_streamEndReached(cmv);
+	}
+	return best->frame;
+}
+
+bool GBACMVStartPlaying(struct GBARRContext* rr, bool autorecord) {
+	if (rr->isRecording(rr) || rr->isPlaying(rr)) {
+		return false;
+	}
+
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	if (!cmv->vf || !cmv->vf->size(cmv->vf)) {
+		return false;
+	}
+	cmv->isPlaying = true;
+	cmv->autorecord = autorecord;
+	cmv->inputThisFrame = false;
+	cmv->d.frames = 0;
+	cmv->d.lagFrames = 0;
+
+	// Movies start with a savestate, so they play back from exactly where recording began
+	const struct GBACMVKeyframe* keyframe = NULL;
+	if (GBACMVKeyframeListSize(&cmv->keyframes)) {
+		keyframe = GBACMVKeyframeListGetConstPointer(&cmv->keyframes, 0);
+	}
+	if (keyframe && keyframe->frame == 0) {
+		if (!_loadState(cmv, keyframe->offset)) {
+			cmv->isPlaying = false;
+			return false;
+		}
+	} else {
+		cmv->vf->seek(cmv->vf, CMV_HEADER_SIZE, SEEK_SET);
+	}
+	if (!_nextRun(cmv)) {
+		_streamEndReached(cmv);
+	}
+	return true;
+}
+
+void GBACMVStopPlaying(struct GBARRContext* rr) {
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	cmv->isPlaying = false;
+}
+
+bool GBACMVStartRecording(struct GBARRContext* rr) {
+	if (rr->isRecording(rr) || rr->isPlaying(rr)) {
+		return false;
+	}
+
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	if (!cmv->vf) {
+		return false;
+	}
+	cmv->vf->truncate(cmv->vf, 0);
+	cmv->vf->seek(cmv->vf, 0, SEEK_SET);
+	GBACMVKeyframeListClear(&cmv->keyframes);
+	cmv->d.frames = 0;
+	cmv->d.lagFrames = 0;
+	cmv->d.rrCount = 0;
+	cmv->bufferSize = 0;
+	cmv->offset = 0;
+	cmv->lastFlush = 0;
+	cmv->runLength = 0;
+	cmv->inputThisFrame = false;
+
+	uint8_t* header = _reserve(cmv, CMV_HEADER_SIZE);
+	memcpy(header, CMV_MAGIC, 4);
+	STORE_32LE(CMV_VERSION, 4, header);
+
+	cmv->isRecording = true;
+	_startWriter(cmv);
+	_emitState(cmv, CMV_KEYFRAME, NULL);
+	_flush(cmv);
+	return true;
+}
+
+void GBACMVStopRecording(struct GBARRContext* rr) {
+	if (!rr->isRecording(rr)) {
+		return;
+	}
+
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	_emitRun(cmv);
+	_emitEnd(cmv);
+	_flush(cmv);
+	_stopWriter(cmv);
+	cmv->isRecording = false;
+}
+
+bool GBACMVIsPlaying(const struct GBARRContext* rr) {
+	const struct GBACMVContext* cmv = (const struct GBACMVContext*) rr;
+	return cmv->isPlaying;
+}
+
+bool GBACMVIsRecording(const struct GBARRContext* rr) {
+	const struct GBACMVContext* cmv = (const struct GBACMVContext*) rr;
+	return cmv->isRecording;
+}
+
+void GBACMVNextFrame(struct GBARRContext* rr) {
+	if (!rr->isRecording(rr) && !rr->isPlaying(rr)) {
+		return;
+	}
+
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	bool lag = !cmv->inputThisFrame;
+	cmv->inputThisFrame = false;
+	++cmv->d.frames;
+	if (lag) {
+		++cmv->d.lagFrames;
+	}
+
+	if (rr->isPlaying(rr)) {
+		if (lag != !!(cmv->runInput & CMV_INPUT_LAG)) {
+			mLOG(GBA_RR, WARN, "Lag frame %u does not match movie", cmv->d.frames);
+		}
+		--cmv->runLength;
+		if (!cmv->runLength && !_nextRun(cmv)) {
+			_streamEndReached(cmv);
+		}
+		return;
+	}
+
+	uint16_t input = cmv->currentInput & CMV_INPUT_MASK;
+	if (lag) {
+		input |= CMV_INPUT_LAG;
+	}
+	if (cmv->runLength && input == cmv->runInput) {
+		++cmv->runLength;
+	} else {
+		_emitRun(cmv);
+		cmv->runInput = input;
+		cmv->runLength = 1;
+	}
+
+	if (cmv->keyframeInterval && !(cmv->d.frames % cmv->keyframeInterval)) {
+		_emitRun(cmv);
+		_emitState(cmv, CMV_KEYFRAME, NULL);
+		_flush(cmv);
+	} else if (cmv->bufferSize >= CMV_FLUSH_SIZE || cmv->d.frames - cmv->lastFlush >= CMV_FLUSH_FRAMES) {
+		_flush(cmv);
+	}
+}
+
+void GBACMVLogInput(struct GBARRContext* rr, uint16_t keys) {
+	if (!rr->isRecording(rr)) {
+		return;
+	}
+
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	cmv->currentInput = keys;
+	cmv->inputThisFrame = true;
+}
+
+uint16_t GBACMVQueryInput(struct GBARRContext* rr) {
+	if (!rr->isPlaying(rr)) {
+		return 0;
+	}
+
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	cmv->inputThisFrame = true;
+	return cmv->runInput & CMV_INPUT_MASK;
+}
+
+bool GBACMVQueryReset(struct GBARRContext* rr) {
+	UNUSED(rr);
+	return false;
+}
+
+void GBACMVStateSaved(struct GBARRContext* rr, struct GBASerializedState* state) {
+	UNUSED(rr);
+	UNUSED(state);
+}
+
+void GBACMVStateLoaded(struct GBARRContext* rr, const struct GBASerializedState* state) {
+	struct GBACMVContext* cmv = (struct GBACMVContext*) rr;
+	if (cmv->loadingState) {
+		return;
+	}
+	if (rr->isRecording(rr)) {
+		// The movie only ever moves forward, so it carries the loaded state along for playback
+		_emitRun(cmv);
+		_emitState(cmv, CMV_LOAD, state);
+		_flush(cmv);
+		++cmv->d.rrCount;
+	} else if (rr->isPlaying(rr)) {
+		mLOG(GBA_RR, WARN, "State loaded outside of the movie, stopping playback");
+		rr->stopPlaying(rr);
+	}
+}
+
+struct VFile* GBACMVOpenSavedata(struct GBARRContext* rr, int flags) {
+	UNUSED(rr);
+	UNUSED(flags);
+	return NULL;
+}
+
+struct VFile* GBACMVOpenSavestate(struct GBARRContext* rr, int flags) {
+	UNUSED(rr);
+	UNUSED(flags);
+	return NULL;
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _writerThread(void* context) {
+	struct GBACMVContext* cmv = context;
+	ThreadSetName("Movie Writer");
+	MutexLock(&cmv->mutex);
+	while (true) {
+		while (!cmv->writerBusy && cmv->writerRunning) {
+			ConditionWait(&cmv->cond, &cmv->mutex);
+		}
+		if (!cmv->writerBusy) {
+			break;
+		}
+		MutexUnlock(&cmv->mutex);
+		if (cmv->vf->write(cmv->vf, cmv->writerBuffer, cmv->writerSize) != (ssize_t) cmv->writerSize) {
+			mLOG(GBA_RR, ERROR, "Could not write movie");
+		}
+		MutexLock(&cmv->mutex);
+		cmv->writerBusy = false;
+		ConditionWake(&cmv->cond);
+	}
+	MutexUnlock(&cmv->mutex);
+	return 0;
+}
+#endif
+
+void _startWriter(struct GBACMVContext* cmv) {
+#ifndef DISABLE_THREADING
+	MutexInit(&cmv->mutex);
+	ConditionInit(&cmv->cond);
+	cmv->writerRunning = true;
+	cmv->writerBusy = false;
+	ThreadCreate(&cmv->writer, _writerThread, cmv);
+#else
+	UNUSED(cmv);
+#endif
+}
+
+void _stopWriter(struct GBACMVContext* cmv) {
+#ifndef DISABLE_THREADING
+	MutexLock(&cmv->mutex);
+	while (cmv->writerBusy) {
+		ConditionWait(&cmv->cond, &cmv->mutex);
+	}
+	cmv->writerRunning = false;
+	ConditionWake(&cmv->cond);
+	MutexUnlock(&cmv->mutex);
+	ThreadJoin(&cmv->writer);
+	MutexDeinit(&cmv->mutex);
+	ConditionDeinit(&cmv->cond);
+	free(cmv->writerBuffer);
+	cmv->writerBuffer = NULL;
+	cmv->writerCapacity = 0;
+#else
+	UNUSED(cmv);
+#endif
+}
+
+void _flush(struct GBACMVContext* cmv) {
+	cmv->lastFlush = cmv->d.frames;
+	if (!cmv->bufferSize) {
+		return;
+	}
+#ifndef DISABLE_THREADING
+	if (cmv->writerRunning) {
+		// Swap buffers with the writer once it's done with the last ones
+		MutexLock(&cmv->mutex);
+		while (cmv->writerBusy) {
+			ConditionWait(&cmv->cond, &cmv->mutex);
+		}
+		uint8_t* buffer = cmv->writerBuffer;
+		size_t capacity = cmv->writerCapacity;
+		cmv->writerBuffer = cmv->buffer;
+		cmv->writerCapacity = cmv->bufferCapacity;
+		cmv->writerSize = cmv->bufferSize;
+		cmv->buffer = buffer;
+		cmv->bufferCapacity = capacity;
+		cmv->bufferSize = 0;
+		cmv->writerBusy = true;
+		ConditionWake(&cmv->cond);
+		MutexUnlock(&cmv->mutex);
+		return;
+	}
+#endif
+	if (cmv->vf->write(cmv->vf, cmv->buffer, cmv->bufferSize) != (ssize_t) cmv->bufferSize) {
+		mLOG(GBA_RR, ERROR, "Could not write movie");
+	}
+	cmv->bufferSize = 0;
+}
+
+uint8_t* _reserve(struct GBACMVContext* cmv, size_t size) {
+	if (cmv->bufferSize + size > cmv->bufferCapacity) {
+		size_t capacity = cmv->bufferCapacity ? cmv->bufferCapacity : CMV_FLUSH_SIZE * 2;
+		while (capacity < cmv->bufferSize + size) {
+			capacity *= 2;
+		}
+		cmv->buffer = realloc(cmv->buffer, capacity);
+		cmv->bufferCapacity = capacity;
+	}
+	uint8_t* out = &cmv->buffer[cmv->bufferSize];
+	cmv->bufferSize += size;
+	cmv->offset += size;
+	return out;
+}
+
+void _emitRun(struct GBACMVContext* cmv) {
+	if (!cmv->runLength) {
+		return;
+	}
+	uint8_t record[3 + 5];
+	size_t size = 0;
+	record[size++] = CMV_RUN;
+	record[size++] = cmv->runInput;
+	record[size++] = cmv->runInput >> 8;
+	uint32_t length = cmv->runLength;
+	while (length >= 0x80) {
+		record[size++] = length | 0x80;
+		length >>= 7;
+	}
+	record[size++] = length;
+	memcpy(_reserve(cmv, size), record, size);
+	cmv->runLength = 0;
+}
+
+void _emitState(struct GBACMVContext* cmv, enum GBACMVTag tag, const struct GBASerializedState* state) {
+	if (!state) {
+		if (!cmv->scratch) {
+			cmv->scratch = anonymousMemoryMap(sizeof(*cmv->scratch));
+		}
+		GBASerialize(cmv->gba, cmv->scratch);
+		if (cmv->d.frames) {
+			// Taken as the frame ends, just before the frame counter moves on
+			int32_t frameCounter;
+			LOAD_32LE(frameCounter, 0, &cmv->scratch->video.frameCounter);
+			STORE_32LE(frameCounter + 1, 0, &cmv->scratch->video.frameCounter);
+		}
+		state = cmv->scratch;
+	}
+	struct GBACMVKeyframe* keyframe = GBACMVKeyframeListAppend(&cmv->keyframes);
+	keyframe->frame = cmv->d.frames;
+	keyframe->offset = cmv->offset;
+
+	uint8_t* record = _reserve(cmv, 9 + sizeof(*state));
+	record[0] = tag;
+	STORE_32LE(cmv->d.frames, 1, record);
+	STORE_32LE(sizeof(*state), 5, record);
+	memcpy(&record[9], state, sizeof(*state));
+}
+
+void _emitEnd(struct GBACMVContext* cmv) {
+	uint32_t endOffset = cmv->offset;
+	cmv->endOffset = endOffset;
+	size_t count = GBACMVKeyframeListSize(&cmv->keyframes);
+	uint8_t* record = _reserve(cmv, 17 + count * 8 + 8);
+	record[0] = CMV_END;
+	STORE_32LE(cmv->d.frames, 1, record);
+	STORE_32LE(cmv->d.lagFrames, 5, record);
+	STORE_32LE(cmv->d.rrCount, 9, record);
+	STORE_32LE(count, 13, record);
+	record += 17;
+	size_t i;
+	for (i = 0; i < count; ++i, record += 8) {
+		const struct GBACMVKeyframe* keyframe = GBACMVKeyframeListGetConstPointer(&cmv->keyframes, i);
+		STORE_32LE(keyframe->frame, 0, record);
+		STORE_32LE(keyframe->offset, 4, record);
+	}
+	STORE_32LE(endOffset, 0, record);
+	memcpy(&record[4], CMV_TRAILER_MAGIC, 4);
+}
+
+static bool _read32(struct VFile* vf, uint32_t* value) {
+	uint8_t buffer[4];
+	if (vf->read(vf, buffer, sizeof(buffer)) != sizeof(buffer)) {
+		return false;
+	}
+	LOAD_32LE(*value, 0, buffer);
+	return true;
+}
+
+bool _loadIndex(struct GBACMVContext* cmv) {
+	struct VFile* vf = cmv->vf;
+	uint8_t header[CMV_HEADER_SIZE];
+	vf->seek(vf, 0, SEEK_SET);
+	if (vf->read(vf, header, sizeof(header)) != sizeof(header) || memcmp(header, CMV_MAGIC, 4) != 0) {
+		return false;
+	}
+	uint32_t version;
+	LOAD_32LE(version, 4, header);
+	if (version != CMV_VERSION) {
+		mLOG(GBA_RR, WARN, "Unknown movie version %u", version);
+		return false;
+	}
+	cmv->endOffset = vf->size(vf);
+
+	uint32_t endOffset;
+	char magic[4];
+	if (vf->seek(vf, -8, SEEK_END) >= CMV_HEADER_SIZE && _read32(vf, &endOffset) &&
+	    vf->read(vf, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, CMV_TRAILER_MAGIC, 4) == 0) {
+		uint8_t tag = 0;
+		uint32_t count = 0;
+		vf->seek(vf, endOffset, SEEK_SET);
+		vf->read(vf, &tag, 1);
+		vf->seek(vf, 8, SEEK_CUR);
+		if (tag == CMV_END && _read32(vf, &cmv->d.rrCount) && _read32(vf, &count)) {
+			uint32_t i;
+			for (i = 0; i < count; ++i) {
+				struct GBACMVKeyframe* keyframe = GBACMVKeyframeListAppend(&cmv->keyframes);
+				if (!_read32(vf, &keyframe->frame) || !_read32(vf, &keyframe->offset)) {
+					return false;
+				}
+			}
+			cmv->endOffset = endOffset;
+			return true;
+		}
+	}
+
+	// No index, so the recording was cut short: find the states by walking the records
+	mLOG(GBA_RR, INFO, "Movie is incomplete, scanning for keyframes");
+	off_t offset = vf->seek(vf, CMV_HEADER_SIZE, SEEK_SET);
+	while (true) {
+		uint8_t tag;
+		if (vf->read(vf, &tag, 1) != 1) {
+			break;
+		}
+		if (tag == CMV_RUN) {
+			uint8_t byte = 0x80;
+			vf->seek(vf, 2, SEEK_CUR);
+			while ((byte & 0x80) && vf->read(vf, &byte, 1) == 1);
+		} else if (tag == CMV_KEYFRAME || tag == CMV_LOAD) {
+			uint32_t frame, size;
+			if (!_read32(vf, &frame) || !_read32(vf, &size) || vf->seek(vf, size, SEEK_CUR) > cmv->endOffset) {
+				break;
+			}
+			struct GBACMVKeyframe* keyframe = GBACMVKeyframeListAppend(&cmv->keyframes);
+			keyframe->frame = frame;
+			keyframe->offset = offset;
+		} else {
+			break;
+		}
+		offset = vf->seek(vf, 0, SEEK_CUR);
+	}
+	cmv->endOffset = offset;
+	return true;
+}
+
+bool _loadState(struct GBACMVContext* cmv, uint32_t offset) {
+	struct VFile* vf = cmv->vf;
+	uint8_t tag = 0;
+	uint32_t frame, size;
+	vf->seek(vf, offset, SEEK_SET);
+	vf->read(vf, &tag, 1);
+	if ((tag != CMV_KEYFRAME && tag != CMV_LOAD) || !_read32(vf, &frame) || !_read32(vf, &size) || size != sizeof(*cmv->scratch)) {
+		mLOG(GBA_RR, WARN, "Bad keyframe in movie");
+		return false;
+	}
+	if (!cmv->scratch) {
+		cmv->scratch = anonymousMemoryMap(sizeof(*cmv->scratch));
+	}
+	if (vf->read(vf, cmv->scratch, size) != (ssize_t) size) {
+		return false;
+	}
+	cmv->loadingState = true;
+	bool success = GBADeserialize(cmv->gba, cmv->scratch);
+	cmv->loadingState = false;
+	return success;
+}
+
+bool _nextRun(struct GBACMVContext* cmv) {
+	struct VFile* vf = cmv->vf;
+	while (true) {
+		off_t offset = vf->seek(vf, 0, SEEK_CUR);
+		uint8_t record[3];
+		if (offset >= cmv->endOffset || vf->read(vf, record, 1) != 1) {
+			return false;
+		}
+		switch (record[0]) {
+		case CMV_RUN: {
+			if (vf->read(vf, &record[1], 2) != 2) {
+				return false;
+			}
+			cmv->runInput = record[1] | (record[2] << 8);
+			cmv->runLength = 0;
+			int shift;
+			for (shift = 0; shift < 32; shift += 7) {
+				uint8_t byte;
+				if (vf->read(vf, &byte, 1) != 1) {
+					return false;
+				}
+				cmv->runLength |= (uint32_t) (byte & 0x7F) << shift;
+				if (!(byte & 0x80)) {
+					break;
+				}
+			}
+			if (cmv->runLength) {
+				return true;
+			}
+			break;
+		}
+		case CMV_KEYFRAME: {
+			uint32_t frame, size;
+			if (!_read32(vf, &frame) || !_read32(vf, &size)) {
+				return false;
+			}
+			vf->seek(vf, size, SEEK_CUR);
+			break;
+		}
+		case CMV_LOAD:
+			if (!_loadState(cmv, offset)) {
+				return false;
+			}
+			break;
+		default:
+			return false;
+		}
+	}
+}
+
+void _streamEndReached(struct GBACMVContext* cmv) {
+	if (!cmv->d.isPlaying(&cmv->d)) {
+		return;
+	}
+	cmv->d.stopPlaying(&cmv->d);
+	cmv->runLength = 0;
+	if (!cmv->autorecord) {
+		return;
+	}
+
+	// Carry on recording from the end of what was played
+	struct VFile* vf = cmv->vf;
+	vf->truncate(vf, cmv->endOffset);
+	vf->seek(vf, cmv->endOffset, SEEK_SET);
+	cmv->offset = cmv->endOffset;
+	cmv->bufferSize = 0;
+	cmv->lastFlush = cmv->d.frames;
+	cmv->currentInput = cmv->runInput & CMV_INPUT_MASK;
+	cmv->isRecording = true;
+	_startWriter(cmv);
+}
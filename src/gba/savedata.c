@@ -24,7 +24,6 @@
 #define FLASH_PROGRAM_CYCLES 650
 // This needs real testing, and is only an estimation currently
 #define EEPROM_SETTLE_CYCLES 115000
-#define CLEANUP_THRESHOLD 15
 
 mLOG_DEFINE_CATEGORY(GBA_SAVE, "GBA Savedata", "gba.savedata");
 
@@ -48,8 +47,7 @@ void GBASavedataInit(struct GBASavedata* savedata, struct VFile* vf) {
 	savedata->realVf = vf;
 	savedata->mapMode = MAP_WRITE;
 	savedata->maskWriteback = false;
-	savedata->dirty = 0;
-	savedata->dirtAge = 0;
+	mSavedataFlusherReset(&savedata->flusher);
 	savedata->dust.name = "GBA Savedata Settling";
 	savedata->dust.priority = 0x70;
 	savedata->dust.context = savedata;
@@ -57,6 +55,7 @@ void GBASavedataInit(struct GBASavedata* savedata, struct VFile* vf) {
 }
 
 void GBASavedataDeinit(struct GBASavedata* savedata) {
+	mSavedataFlusherWait(&savedata->flusher);
 	if (savedata->vf) {
 		size_t size = GBASavedataSize(savedata);
 		if (savedata->data) {
@@ -345,7 +344,7 @@ void GBASavedataWriteFlash(struct GBASavedata* savedata, uint16_t address, uint8
 	case FLASH_STATE_RAW:
 		switch (savedata->command) {
 		case FLASH_COMMAND_PROGRAM:
-			savedata->dirty |= SAVEDATA_DIRT_NEW;
+			mSavedataFlusherMarkDirty(&savedata->flusher);
 			savedata->currentBank[address] = value;
 			savedata->command = FLASH_COMMAND_NONE;
 			mTimingDeschedule(savedata->timing, &savedata->dust);
@@ -438,6 +437,7 @@ static void _ensureEeprom(struct GBASavedata* savedata, uint32_t size) {
 	if (!savedata->vf) {
 		return;
 	}
+	mSavedataFlusherWait(&savedata->flusher);
 	savedata->vf->unmap(savedata->vf, savedata->data, SIZE_CART_EEPROM512);
 	if (savedata->vf->size(savedata->vf) < SIZE_CART_EEPROM) {
 		savedata->vf->truncate(savedata->vf, SIZE_CART_EEPROM);
@@ -477,7 +477,7 @@ void GBASavedataWriteEEPROM(struct GBASavedata* savedata, uint16_t value, uint32
 			uint8_t current = savedata->data[savedata->writeAddress >> 3];
 			current &= ~(1 << (0x7 - (savedata->writeAddress & 0x7)));
 			current |= (value & 0x1) << (0x7 - (savedata->writeAddress & 0x7));
-			savedata->dirty |= SAVEDATA_DIRT_NEW;
+			mSavedataFlusherMarkDirty(&savedata->flusher);
 			savedata->data[savedata->writeAddress >> 3] = current;
 			mTimingDeschedule(savedata->timing, &savedata->dust);
 			mTimingSchedule(savedata->timing, &savedata->dust, EEPROM_SETTLE_CYCLES);
@@ -501,6 +501,26 @@ void GBASavedataWriteEEPROM(struct GBASavedata* savedata, uint16_t value, uint32
 	}
 }
 
+void GBASavedataWriteEEPROMBlock(struct GBASavedata* savedata, const uint8_t* data, uint32_t units, uint32_t writeSize, int32_t firstCycles, int32_t seqCycles) {
+	// Every bit goes in now, but the write settles from when the last one would have landed
+	int32_t settleDelay = 0;
+	uint32_t i;
+	for (i = 0; i < units; ++i) {
+		uint16_t value;
+		LOAD_16(value, i * 2, data);
+		uint32_t address = savedata->writeAddress;
+		bool writing = savedata->command == EEPROM_COMMAND_WRITE && writeSize - i > 1 && writeSize - i <= 65;
+		GBASavedataWriteEEPROM(savedata, value, writeSize - i);
+		if (writing && savedata->writeAddress != address) {
+			settleDelay = i ? firstCycles + (i - 1) * seqCycles : 0;
+		}
+	}
+	if (settleDelay) {
+		mTimingDeschedule(savedata->timing, &savedata->dust);
+		mTimingSchedule(savedata->timing, &savedata->dust, EEPROM_SETTLE_CYCLES + settleDelay);
+	}
+}
+
 uint16_t GBASavedataReadEEPROM(struct GBASavedata* savedata) {
 	if (savedata->command != EEPROM_COMMAND_READ) {
 		if (!mTimingIsScheduled(savedata->timing, &savedata->dust)) {
@@ -531,25 +551,24 @@ void GBASavedataClean(struct GBASavedata* savedata, uint32_t frameCount) {
 	if (!savedata->vf) {
 		return;
 	}
-	if (savedata->dirty & SAVEDATA_DIRT_NEW) {
-		savedata->dirtAge = frameCount;
-		savedata->dirty &= ~SAVEDATA_DIRT_NEW;
-		if (!(savedata->dirty & SAVEDATA_DIRT_SEEN)) {
-			savedata->dirty |= SAVEDATA_DIRT_SEEN;
-		}
-	} else if ((savedata->dirty & SAVEDATA_DIRT_SEEN) && frameCount - savedata->dirtAge > CLEANUP_THRESHOLD) {
-		if (savedata->maskWriteback) {
-			GBASavedataUnmask(savedata);
-		}
-		if (savedata->mapMode & MAP_WRITE) {
-			size_t size = GBASavedataSize(savedata);
-			savedata->dirty = 0;
-			if (savedata->data && savedata->vf->sync(savedata->vf, savedata->data, size)) {
-				mLOG(GBA_SAVE, INFO, "Savedata synced");
-			} else {
-				mLOG(GBA_SAVE, INFO, "Savedata failed to sync!");
-			}
-		}
+	if (!mSavedataFlusherPoll(&savedata->flusher, frameCount)) {
+		return;
+	}
+	enum mTimingHostCategory category = mTimingHostEnter(savedata->timing, mTIMING_HOST_IO);
+	if (savedata->maskWriteback) {
+		GBASavedataUnmask(savedata);
+	}
+	if (savedata->mapMode & MAP_WRITE) {
+		mSavedataFlusherFlush(&savedata->flusher, savedata->vf, savedata->data, GBASavedataSize(savedata));
+	}
+	mTimingHostLeave(savedata->timing, category);
+}
+
+void GBASavedataFinish(struct GBASavedata* savedata) {
+	if (savedata->vf && (savedata->mapMode & MAP_WRITE)) {
+		mSavedataFlusherFinish(&savedata->flusher, savedata->vf, savedata->data, GBASavedataSize(savedata));
+	} else {
+		mSavedataFlusherWait(&savedata->flusher);
 	}
 }
 
@@ -603,6 +622,7 @@ void _flashSwitchBank(struct GBASavedata* savedata, int bank) {
 		mLOG(GBA_SAVE, INFO, "Updating flash chip from 512kb to 1Mb");
 		savedata->type = SAVEDATA_FLASH1M;
 		if (savedata->vf) {
+			mSavedataFlusherWait(&savedata->flusher);
 			savedata->vf->unmap(savedata->vf, savedata->data, SIZE_CART_FLASH512);
 			if (savedata->vf->size(savedata->vf) < SIZE_CART_FLASH1M) {
 				savedata->vf->truncate(savedata->vf, SIZE_CART_FLASH1M);
@@ -618,7 +638,7 @@ void _flashSwitchBank(struct GBASavedata* savedata, int bank) {
 
 void _flashErase(struct GBASavedata* savedata) {
 	mLOG(GBA_SAVE, DEBUG, "Performing flash chip erase");
-	savedata->dirty |= SAVEDATA_DIRT_NEW;
+	mSavedataFlusherMarkDirty(&savedata->flusher);
 	size_t size = SIZE_CART_FLASH512;
 	if (savedata->type == SAVEDATA_FLASH1M) {
 		size = SIZE_CART_FLASH1M;
@@ -628,7 +648,7 @@ void _flashErase(struct GBASavedata* savedata) {
 
 void _flashEraseSector(struct GBASavedata* savedata, uint16_t sectorStart) {
 	mLOG(GBA_SAVE, DEBUG, "Performing flash sector erase at 0x%04x", sectorStart);
-	savedata->dirty |= SAVEDATA_DIRT_NEW;
+	mSavedataFlusherMarkDirty(&savedata->flusher);
 	size_t size = 0x1000;
 	if (savedata->type == SAVEDATA_FLASH1M) {
 		mLOG(GBA_SAVE, DEBUG, "Performing unknown sector-size erase at 0x%04x", sectorStart);
@@ -5,11 +5,13 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba/internal/gba/serialize.h>
 
+#include <mgba/internal/arm/block-cache.h>
 #include <mgba/internal/arm/macros.h>
 #include <mgba/internal/gba/bios.h>
 #include <mgba/internal/gba/io.h>
 #include <mgba/internal/gba/rr/rr.h>
 
+#include <mgba-util/hash.h>
 #include <mgba-util/memory.h>
 #include <mgba-util/vfs.h>
 
@@ -20,16 +22,29 @@ const uint32_t GBA_SAVESTATE_VERSION = 0x00000003;
 
 mLOG_DEFINE_CATEGORY(GBA_STATE, "GBA Savestate", "gba.serialize");
 
+const struct mStateRegion GBAStateRegions[] = {
+	{ mSTATE_REGION_CORE, "core", 0, offsetof(struct GBASerializedState, pram) },
+	{ mSTATE_REGION_PALETTE_OAM, "palette", offsetof(struct GBASerializedState, pram), SIZE_PALETTE_RAM + SIZE_OAM },
+	{ mSTATE_REGION_VRAM, "vram", offsetof(struct GBASerializedState, vram), SIZE_VRAM },
+	{ mSTATE_REGION_IWRAM, "iwram", offsetof(struct GBASerializedState, iwram), SIZE_WORKING_IRAM },
+	{ mSTATE_REGION_WRAM, "wram", offsetof(struct GBASerializedState, wram), SIZE_WORKING_RAM },
+};
+const size_t GBAStateRegionCount = sizeof(GBAStateRegions) / sizeof(*GBAStateRegions);
+
 struct GBABundledState {
 	struct GBASerializedState* state;
 	struct mStateExtdata* extdata;
 };
 
-void GBASerialize(struct GBA* gba, struct GBASerializedState* state) {
+static void _serializeCore(struct GBA* gba, struct GBASerializedState* state);
+static void _deserialize(struct GBA* gba, const struct GBASerializedState* state, const struct GBA* source, uint32_t regions);
+static void _deserializeCore(struct GBA* gba, const struct GBASerializedState* state);
+
+// The header is written with every region, so that partial states can be checked the same way
+static void _serialize(struct GBA* gba, struct GBASerializedState* state, uint32_t regions) {
 	STORE_32(GBA_SAVESTATE_MAGIC + GBA_SAVESTATE_VERSION, 0, &state->versionMagic);
 	STORE_32(gba->biosChecksum, 0, &state->biosChecksum);
 	STORE_32(gba->romCrc32, 0, &state->romCrc32);
-	STORE_32(gba->timing.masterCycles, 0, &state->masterCycles);
 
 	if (gba->memory.rom) {
 		state->id = ((struct GBACartridge*) gba->memory.rom)->id;
@@ -39,6 +54,16 @@ void GBASerialize(struct GBA* gba, struct GBASerializedState* state) {
 		memset(state->title, 0, sizeof(state->title));
 	}
 
+	if (regions & mSTATE_REGION_CORE) {
+		_serializeCore(gba, state);
+	}
+	GBAMemorySerializeRegions(&gba->memory, state, regions);
+	GBAVideoSerializeRegions(&gba->video, state, regions);
+}
+
+static void _serializeCore(struct GBA* gba, struct GBASerializedState* state) {
+	STORE_32(gba->timing.masterCycles, 0, &state->masterCycles);
+
 	int i;
 	for (i = 0; i < 16; ++i) {
 		STORE_32(gba->cpu->gprs[i], i * sizeof(state->cpu.gprs[0]), state->cpu.gprs);
@@ -69,19 +94,39 @@ void GBASerialize(struct GBA* gba, struct GBASerializedState* state) {
 	}
 	STORE_32(miscFlags, 0, &state->miscFlags);
 
-	GBAMemorySerialize(&gba->memory, state);
 	GBAIOSerialize(gba, state);
-	GBAVideoSerialize(&gba->video, state);
+	GBAAudioSample(&gba->audio, mTimingSettledTime(&gba->timing));
 	GBAAudioSerialize(&gba->audio, state);
 	GBASavedataSerialize(&gba->memory.savedata, state);
 
 	state->associatedStreamId = 0;
+}
+
+void GBASerialize(struct GBA* gba, struct GBASerializedState* state) {
+	_serialize(gba, state, mSTATE_REGION_ALL);
 	if (gba->rr) {
 		gba->rr->stateSaved(gba->rr, state);
 	}
 }
 
+void GBASerializeRegions(struct GBA* gba, struct GBASerializedState* state, uint32_t regions) {
+	if ((regions & mSTATE_REGION_ALL) == mSTATE_REGION_ALL) {
+		GBASerialize(gba, state);
+		return;
+	}
+	_serialize(gba, state, regions);
+}
+
 bool GBADeserialize(struct GBA* gba, const struct GBASerializedState* state) {
+	return GBADeserializeRegions(gba, state, mSTATE_REGION_ALL);
+}
+
+bool GBADeserializeRegions(struct GBA* gba, const struct GBASerializedState* state, uint32_t regions) {
+	bool all = (regions & mSTATE_REGION_ALL) == mSTATE_REGION_ALL;
+	if (gba->rr && !all) {
+		mLOG(GBA_STATE, WARN, "Can't load part of a savestate while recording or playing a movie");
+		return false;
+	}
 	bool error = false;
 	int32_t check;
 	uint32_t ucheck;
@@ -115,24 +160,60 @@ bool GBADeserialize(struct GBA* gba, const struct GBASerializedState* state) {
 	if (ucheck != gba->romCrc32) {
 		mLOG(GBA_STATE, WARN, "Savestate is for a different version of the game");
 	}
-	LOAD_32(check, 0, &state->cpu.cycles);
-	if (check < 0) {
-		mLOG(GBA_STATE, WARN, "Savestate is corrupted: CPU cycles are negative");
-		error = true;
-	}
-	if (check >= (int32_t) GBA_ARM7TDMI_FREQUENCY) {
-		mLOG(GBA_STATE, WARN, "Savestate is corrupted: CPU cycles are too high");
-		error = true;
-	}
-	LOAD_32(check, ARM_PC * sizeof(state->cpu.gprs[0]), state->cpu.gprs);
-	int region = (check >> BASE_OFFSET);
-	if ((region == REGION_CART0 || region == REGION_CART1 || region == REGION_CART2) && ((check - WORD_SIZE_ARM) & SIZE_CART0) >= gba->memory.romSize - WORD_SIZE_ARM) {
-		mLOG(GBA_STATE, WARN, "Savestate created using a differently sized version of the ROM");
-		error = true;
+	if (regions & mSTATE_REGION_CORE) {
+		LOAD_32(check, 0, &state->cpu.cycles);
+		if (check < 0) {
+			mLOG(GBA_STATE, WARN, "Savestate is corrupted: CPU cycles are negative");
+			error = true;
+		}
+		if (check >= (int32_t) GBA_ARM7TDMI_FREQUENCY) {
+			mLOG(GBA_STATE, WARN, "Savestate is corrupted: CPU cycles are too high");
+			error = true;
+		}
+		LOAD_32(check, ARM_PC * sizeof(state->cpu.gprs[0]), state->cpu.gprs);
+		int region = (check >> BASE_OFFSET);
+		if ((region == REGION_CART0 || region == REGION_CART1 || region == REGION_CART2) && ((check - WORD_SIZE_ARM) & SIZE_CART0) >= gba->memory.romSize - WORD_SIZE_ARM) {
+			mLOG(GBA_STATE, WARN, "Savestate created using a differently sized version of the ROM");
+			error = true;
+		}
 	}
 	if (error) {
 		return false;
 	}
+	_deserialize(gba, state, NULL, regions);
+	if (gba->rr && all) {
+		gba->rr->stateLoaded(gba->rr, state);
+	}
+	return true;
+}
+
+// With a source, memory and video come straight from it rather than from the state
+static void _deserialize(struct GBA* gba, const struct GBASerializedState* state, const struct GBA* source, uint32_t regions) {
+	if (regions & mSTATE_REGION_CORE) {
+		_deserializeCore(gba, state);
+	}
+	if (source) {
+		GBAVideoCopyState(&gba->video, &source->video);
+		memcpy(gba->memory.wram, source->memory.wram, SIZE_WORKING_RAM);
+		memcpy(gba->memory.iwram, source->memory.iwram, SIZE_WORKING_IRAM);
+	} else {
+		GBAVideoDeserializeRegions(&gba->video, state, regions);
+		GBAMemoryDeserializeRegions(&gba->memory, state, regions);
+	}
+	if (gba->cpu->blockCache) {
+		ARMBlockCacheClear(gba->cpu->blockCache);
+	}
+	gba->memory.dirtyTracked = false;
+	if (regions & mSTATE_REGION_CORE) {
+		GBAIODeserialize(gba, state);
+		GBAAudioDeserialize(&gba->audio, state);
+		GBASavedataDeserialize(&gba->memory.savedata, state);
+	}
+
+	mTimingInterrupt(&gba->timing);
+}
+
+static void _deserializeCore(struct GBA* gba, const struct GBASerializedState* state) {
 	mTimingClear(&gba->timing);
 	LOAD_32(gba->timing.masterCycles, 0, &state->masterCycles);
 
@@ -141,6 +222,7 @@ bool GBADeserialize(struct GBA* gba, const struct GBASerializedState* state) {
 		LOAD_32(gba->cpu->gprs[i], i * sizeof(gba->cpu->gprs[0]), state->cpu.gprs);
 	}
 	LOAD_32(gba->cpu->cpsr.packed, 0, &state->cpu.cpsr.packed);
+	gba->cpu->lazyFlags = ARM_LAZY_NONE;
 	LOAD_32(gba->cpu->spsr.packed, 0, &state->cpu.spsr.packed);
 	LOAD_32(gba->cpu->cycles, 0, &state->cpu.cycles);
 	LOAD_32(gba->cpu->nextEvent, 0, &state->cpu.nextEvent);
@@ -194,19 +276,87 @@ bool GBADeserialize(struct GBA* gba, const struct GBASerializedState* state) {
 		LOAD_32(when, 0, &state->nextIrq);
 		mTimingSchedule(&gba->timing, &gba->irqEvent, when);		
 	}
+}
 
-	GBAVideoDeserialize(&gba->video, state);
-	GBAMemoryDeserialize(&gba->memory, state);
-	GBAIODeserialize(gba, state);
-	GBAAudioDeserialize(&gba->audio, state);
-	GBASavedataDeserialize(&gba->memory.savedata, state);
-
-	if (gba->rr) {
-		gba->rr->stateLoaded(gba->rr, state);
+bool GBACopyState(struct GBA* gba, struct GBA* source, struct GBASerializedState* scratch) {
+	if (gba->rr || source->rr) {
+		return false;
 	}
+	if (gba->romCrc32 != source->romCrc32 || gba->memory.romSize != source->memory.romSize) {
+		mLOG(GBA_STATE, WARN, "Can't copy state from a different game");
+		return false;
+	}
+	if (gba->biosChecksum != source->biosChecksum) {
+		mLOG(GBA_STATE, WARN, "Can't copy state from a different BIOS");
+		return false;
+	}
+	// Only the small parts of the state go through the scratch state
+	_serialize(source, scratch, mSTATE_REGION_CORE);
+	_deserialize(gba, scratch, source, mSTATE_REGION_ALL);
 
-	gba->timing.reroot = gba->timing.root;
-	gba->timing.root = NULL;
+	struct GBASavedata* savedata = &gba->memory.savedata;
+	size_t size = GBASavedataSize(savedata);
+	if (savedata->data && source->memory.savedata.data && size == GBASavedataSize(&source->memory.savedata)) {
+		memcpy(savedata->data, source->memory.savedata.data, size);
+	}
+	return true;
+}
 
+bool GBACollectDirtyState(struct GBA* gba, uint32_t* pages, size_t size) {
+	if (size < sizeof(struct GBASerializedState)) {
+		return false;
+	}
+	struct GBAMemory* memory = &gba->memory;
+	memset(pages, 0, M_STATE_PAGE_WORDS(size) * sizeof(*pages));
+	if (!memory->dirtyTracked) {
+		mStatePagesMarkRange(pages, 0, size);
+		memset(memory->dirtyWram, 0, sizeof(memory->dirtyWram));
+		memset(memory->dirtyIwram, 0, sizeof(memory->dirtyIwram));
+		memset(memory->dirtyPalette, 0, sizeof(memory->dirtyPalette));
+		memset(memory->dirtyVram, 0, sizeof(memory->dirtyVram));
+		memset(memory->dirtyOam, 0, sizeof(memory->dirtyOam));
+		memory->dirtyTracked = true;
+		return true;
+	}
+	// Everything ahead of the memory blocks is small enough to always be compared
+	mStatePagesMarkRange(pages, 0, offsetof(struct GBASerializedState, pram));
+	mStatePagesMarkRange(pages, sizeof(struct GBASerializedState), size);
+	mStatePagesCollect(pages, offsetof(struct GBASerializedState, pram), memory->dirtyPalette, SIZE_PALETTE_RAM);
+	mStatePagesCollect(pages, offsetof(struct GBASerializedState, oam), memory->dirtyOam, SIZE_OAM);
+	mStatePagesCollect(pages, offsetof(struct GBASerializedState, vram), memory->dirtyVram, SIZE_VRAM);
+	mStatePagesCollect(pages, offsetof(struct GBASerializedState, iwram), memory->dirtyIwram, SIZE_WORKING_IRAM);
+	mStatePagesCollect(pages, offsetof(struct GBASerializedState, wram), memory->dirtyWram, SIZE_WORKING_RAM);
 	return true;
 }
+
+uint64_t GBAStateHash(struct GBA* gba) {
+	struct ARMCore* cpu = gba->cpu;
+	uint32_t regs[16 + 2 + 6 * 7 + 6 + 2];
+	size_t i = 0;
+	int j;
+	for (j = 0; j < 16; ++j, ++i) {
+		STORE_32LE(cpu->gprs[j], i * 4, regs);
+	}
+	STORE_32LE(cpu->cpsr.packed, i++ * 4, regs);
+	STORE_32LE(cpu->spsr.packed, i++ * 4, regs);
+	for (j = 0; j < 6 * 7; ++j, ++i) {
+		STORE_32LE(cpu->bankedRegisters[j / 7][j % 7], i * 4, regs);
+	}
+	for (j = 0; j < 6; ++j, ++i) {
+		STORE_32LE(cpu->bankedSPSRs[j], i * 4, regs);
+	}
+	STORE_32LE(mTimingCurrentTime(&gba->timing), i++ * 4, regs);
+	STORE_32LE(gba->video.frameCounter, i++ * 4, regs);
+
+	uint64_t hash = hash64(regs, sizeof(regs), 0);
+	hash = hash64(gba->memory.io, sizeof(gba->memory.io), hash);
+	hash = hash64(gba->video.palette, SIZE_PALETTE_RAM, hash);
+	hash = hash64(gba->video.oam.raw, SIZE_OAM, hash);
+	hash = hash64(gba->video.vram, SIZE_VRAM, hash);
+	hash = hash64(gba->memory.iwram, SIZE_WORKING_IRAM, hash);
+	hash = hash64(gba->memory.wram, SIZE_WORKING_RAM, hash);
+	if (gba->memory.savedata.data) {
+		hash = hash64(gba->memory.savedata.data, GBASavedataSize(&gba->memory.savedata), hash);
+	}
+	return hash;
+}
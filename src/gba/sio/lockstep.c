@@ -19,6 +19,7 @@ static uint16_t GBASIOLockstepNodeMultiWriteRegister(struct GBASIODriver* driver
 static uint16_t GBASIOLockstepNodeNormalWriteRegister(struct GBASIODriver* driver, uint32_t address, uint16_t value);
 static void _GBASIOLockstepNodeProcessEvents(struct mTiming* timing, void* driver, uint32_t cyclesLate);
 static void _finishTransfer(struct GBASIOLockstepNode* node);
+static void _updateNow(struct GBASIOLockstepNode* node);
 
 void GBASIOLockstepInit(struct GBASIOLockstep* lockstep) {
 	lockstep->players[0] = 0;
@@ -30,6 +31,7 @@ void GBASIOLockstepInit(struct GBASIOLockstep* lockstep) {
 	lockstep->multiRecv[2] = 0xFFFF;
 	lockstep->multiRecv[3] = 0xFFFF;
 	lockstep->attachedMulti = 0;
+	lockstep->idleWindow = 0;
 }
 
 void GBASIOLockstepNodeCreate(struct GBASIOLockstepNode* node) {
@@ -89,6 +91,7 @@ bool GBASIOLockstepNodeLoad(struct GBASIODriver* driver) {
 	struct GBASIOLockstepNode* node = (struct GBASIOLockstepNode*) driver;
 	node->nextEvent = 0;
 	node->eventDiff = 0;
+	node->increment = LOCKSTEP_INCREMENT;
 	mTimingSchedule(&driver->p->p->timing, &node->event, 0);
 
 	mLockstepLock(&node->p->d);
@@ -183,16 +186,7 @@ static uint16_t GBASIOLockstepNodeMultiWriteRegister(struct GBASIODriver* driver
 				mLOG(GBA_SIO, DEBUG, "Lockstep %i: Transfer initiated", node->id);
 				ATOMIC_STORE(node->p->d.transferActive, TRANSFER_STARTING);
 				ATOMIC_STORE(node->p->d.transferCycles, GBASIOCyclesPerTransfer[GBASIOMultiplayerGetBaud(node->d.p->siocnt)][node->p->d.attached - 1]);
-
-				bool scheduled = mTimingIsScheduled(&driver->p->p->timing, &node->event);
-				int oldWhen = node->event.when;
-
-				mTimingDeschedule(&driver->p->p->timing, &node->event);
-				mTimingSchedule(&driver->p->p->timing, &node->event, 0);
-
-				if (scheduled) {
-					node->eventDiff -= oldWhen - node->event.when;
-				}
+				_updateNow(node);
 			} else {
 				value &= ~0x0080;
 			}
@@ -208,6 +202,19 @@ static uint16_t GBASIOLockstepNodeMultiWriteRegister(struct GBASIODriver* driver
 	return value;
 }
 
+static void _updateNow(struct GBASIOLockstepNode* node) {
+	struct mTiming* timing = &node->d.p->p->timing;
+	bool scheduled = mTimingIsScheduled(timing, &node->event);
+	int oldWhen = node->event.when;
+
+	mTimingDeschedule(timing, &node->event);
+	mTimingSchedule(timing, &node->event, 0);
+
+	if (scheduled) {
+		node->eventDiff -= oldWhen - node->event.when;
+	}
+}
+
 static void _finishTransfer(struct GBASIOLockstepNode* node) {
 	if (node->transferFinished) {
 		return;
@@ -278,7 +285,14 @@ static int32_t _masterUpdate(struct GBASIOLockstepNode* node) {
 	switch (transferActive) {
 	case TRANSFER_IDLE:
 		// If the master hasn't initiated a transfer, it can keep going.
-		node->nextEvent += LOCKSTEP_INCREMENT;
+		// Starting one brings the next update forward, so the wait can keep growing until then.
+		node->nextEvent += node->increment;
+		if (node->increment < node->p->idleWindow) {
+			node->increment *= 2;
+			if (node->increment > node->p->idleWindow) {
+				node->increment = node->p->idleWindow;
+			}
+		}
 		node->d.p->siocnt = GBASIOMultiplayerSetReady(node->d.p->siocnt, attachedMulti == attached);
 		break;
 	case TRANSFER_STARTING:
@@ -293,6 +307,7 @@ static int32_t _masterUpdate(struct GBASIOLockstepNode* node) {
 		node->p->multiRecv[2] = 0xFFFF;
 		node->p->multiRecv[3] = 0xFFFF;
 		needsToWait = true;
+		node->increment = LOCKSTEP_INCREMENT;
 		ATOMIC_STORE(node->p->d.transferActive, TRANSFER_STARTED);
 		node->nextEvent += LOCKSTEP_TRANSFER;
 		break;
@@ -462,6 +477,7 @@ static uint16_t GBASIOLockstepNodeNormalWriteRegister(struct GBASIODriver* drive
 			// Internal shift clock
 			if (value & 1) {
 				ATOMIC_STORE(node->p->d.transferActive, TRANSFER_STARTING);
+				_updateNow(node);
 			}
 			// Frequency
 			if (value & 2) {
@@ -0,0 +1,458 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/internal/gba/sio/net.h>
+
+#include <mgba/internal/gba/gba.h>
+#include <mgba/internal/gba/io.h>
+#include <mgba-util/crc32.h>
+
+#define NET_MAGIC 0x314C4E6D
+#define NET_HEADER_SIZE 12
+#define NET_MESSAGE_SIZE 24
+#define NET_PACKET_SIZE (NET_HEADER_SIZE + NET_MESSAGE_SIZE * GBA_SIO_NET_QUEUE)
+
+#define NET_TICK 4096
+#define NET_RESEND_TICKS 8
+#define NET_HASH_INTERVAL 16
+#define NET_TIMEOUT 5000
+#define NET_WAIT_SLICE 50
+
+enum {
+	NET_HELLO = 1,
+	NET_START,
+	NET_DATA,
+	NET_COMPLETE,
+	NET_HASH
+};
+
+static bool GBASIONetLinkInit(struct GBASIODriver* driver);
+static void GBASIONetLinkDeinit(struct GBASIODriver* driver);
+static bool GBASIONetLinkLoad(struct GBASIODriver* driver);
+static bool GBASIONetLinkUnload(struct GBASIODriver* driver);
+static uint16_t GBASIONetLinkWriteRegister(struct GBASIODriver* driver, uint32_t address, uint16_t value);
+static void _GBASIONetLinkProcessEvents(struct mTiming* timing, void* user, uint32_t cyclesLate);
+
+void GBASIONetLinkCreate(struct GBASIONetLink* link) {
+	memset(link, 0, sizeof(*link));
+	link->d.init = GBASIONetLinkInit;
+	link->d.deinit = GBASIONetLinkDeinit;
+	link->d.load = GBASIONetLinkLoad;
+	link->d.unload = GBASIONetLinkUnload;
+	link->d.writeRegister = GBASIONetLinkWriteRegister;
+	link->socket = INVALID_SOCKET;
+	link->inputDelay = GBA_ARM7TDMI_FREQUENCY / 60;
+	link->predict = false;
+}
+
+static bool _queue(struct GBASIONetLink* link, int id, uint8_t type, const uint16_t* data, uint32_t hash) {
+	struct GBASIONetPeer* peer = &link->peers[id];
+	if (peer->nextSequence - peer->acked >= GBA_SIO_NET_QUEUE) {
+		mLOG(GBA_SIO, ERROR, "Net link %i: Too many messages in flight to player %i", link->id, id);
+		return false;
+	}
+	struct GBASIONetMessage* message = &peer->queue[peer->nextSequence % GBA_SIO_NET_QUEUE];
+	message->sequence = peer->nextSequence;
+	message->type = type;
+	message->transfer = link->transfer;
+	if (data) {
+		memcpy(message->data, data, sizeof(message->data));
+	} else {
+		memset(message->data, 0xFF, sizeof(message->data));
+	}
+	message->hash = hash;
+	++peer->nextSequence;
+	return true;
+}
+
+static void _flushPeer(struct GBASIONetLink* link, int id, bool resend) {
+	struct GBASIONetPeer* peer = &link->peers[id];
+	if (!peer->known) {
+		return;
+	}
+	uint32_t count = peer->nextSequence - peer->acked;
+	if (!peer->ackPending && peer->sent == peer->nextSequence && (!count || !resend)) {
+		return;
+	}
+	uint32_t packet[NET_PACKET_SIZE / 4];
+	STORE_32LE(NET_MAGIC, 0, packet);
+	STORE_32LE(link->id | (count << 8), 4, packet);
+	STORE_32LE(peer->received, 8, packet);
+	uint32_t i;
+	size_t offset = NET_HEADER_SIZE;
+	for (i = 0; i < count; ++i, offset += NET_MESSAGE_SIZE) {
+		const struct GBASIONetMessage* message = &peer->queue[(peer->acked + i) % GBA_SIO_NET_QUEUE];
+		STORE_32LE(message->sequence, offset, packet);
+		STORE_32LE(message->type, offset + 4, packet);
+		STORE_32LE(message->transfer, offset + 8, packet);
+		STORE_16LE(message->data[0], offset + 12, packet);
+		STORE_16LE(message->data[1], offset + 14, packet);
+		STORE_16LE(message->data[2], offset + 16, packet);
+		STORE_16LE(message->data[3], offset + 18, packet);
+		STORE_32LE(message->hash, offset + 20, packet);
+	}
+	SocketSendTo(link->socket, packet, offset, peer->port, &peer->address);
+	peer->sent = peer->nextSequence;
+	peer->ackPending = false;
+}
+
+static void _flush(struct GBASIONetLink* link, bool resend) {
+	int i;
+	for (i = 0; i < link->players; ++i) {
+		if (i != link->id) {
+			_flushPeer(link, i, resend);
+		}
+	}
+}
+
+static void _recordHash(struct GBASIONetLink* link) {
+	uint8_t data[MAX_GBAS * 2];
+	int i;
+	for (i = 0; i < MAX_GBAS; ++i) {
+		STORE_16LE(link->transferData[i], i * 2, data);
+	}
+	link->hash = crc32(link->hash, data, sizeof(data));
+	link->historyTransfer[link->transfer % GBA_SIO_NET_HISTORY] = link->transfer;
+	link->historyHash[link->transfer % GBA_SIO_NET_HISTORY] = link->hash;
+}
+
+static void _finishTransfer(struct GBASIONetLink* link) {
+	struct GBASIO* sio = link->d.p;
+	sio->p->memory.io[REG_SIOMULTI0 >> 1] = link->transferData[0];
+	sio->p->memory.io[REG_SIOMULTI1 >> 1] = link->transferData[1];
+	sio->p->memory.io[REG_SIOMULTI2 >> 1] = link->transferData[2];
+	sio->p->memory.io[REG_SIOMULTI3 >> 1] = link->transferData[3];
+	sio->rcnt |= 1;
+	sio->siocnt = GBASIOMultiplayerClearBusy(sio->siocnt);
+	sio->siocnt = GBASIOMultiplayerSetId(sio->siocnt, link->id);
+	if (GBASIOMultiplayerIsIrq(sio->siocnt)) {
+		GBARaiseIRQ(sio->p, IRQ_SIO, 0);
+	}
+	link->transferActive = false;
+	_recordHash(link);
+}
+
+static void _startTransfer(struct GBASIONetLink* link) {
+	struct GBASIO* sio = link->d.p;
+	link->transferActive = true;
+	sio->p->memory.io[REG_SIOMULTI0 >> 1] = 0xFFFF;
+	sio->p->memory.io[REG_SIOMULTI1 >> 1] = 0xFFFF;
+	sio->p->memory.io[REG_SIOMULTI2 >> 1] = 0xFFFF;
+	sio->p->memory.io[REG_SIOMULTI3 >> 1] = 0xFFFF;
+	sio->siocnt = GBASIOMultiplayerFillBusy(sio->siocnt);
+}
+
+static void _handleMessage(struct GBASIONetLink* link, int id, const struct GBASIONetMessage* message) {
+	struct GBASIONetPeer* peer = &link->peers[id];
+	struct GBASIO* sio = link->d.p;
+	uint16_t data[MAX_GBAS];
+	int i;
+	switch (message->type) {
+	case NET_HELLO:
+		break;
+	case NET_START:
+		// Answer with whatever the game has queued up to send, like a slave on a real cable
+		link->transfer = message->transfer;
+		memset(data, 0xFF, sizeof(data));
+		if (sio && sio->activeDriver == &link->d) {
+			_startTransfer(link);
+			sio->rcnt &= ~1;
+			data[link->id] = sio->p->memory.io[REG_SIOMLT_SEND >> 1];
+		}
+		link->transferData[link->id] = data[link->id];
+		_queue(link, 0, NET_DATA, data, 0);
+		break;
+	case NET_DATA:
+		if (link->transferActive && message->transfer == link->transfer) {
+			peer->data = message->data[id];
+			peer->hasData = true;
+		}
+		break;
+	case NET_COMPLETE:
+		if (message->transfer != link->transfer) {
+			break;
+		}
+		if (message->data[link->id] != link->transferData[link->id] && !link->desynced) {
+			// The master couldn't wait for our data and guessed wrong
+			mLOG(GBA_SIO, ERROR, "Net link %i: Master predicted transfer %u wrong", link->id, message->transfer);
+			link->desynced = true;
+		}
+		for (i = 0; i < MAX_GBAS; ++i) {
+			link->transferData[i] = message->data[i];
+		}
+		if (sio && sio->activeDriver == &link->d && link->transferActive) {
+			_finishTransfer(link);
+		} else {
+			_recordHash(link);
+		}
+		break;
+	case NET_HASH:
+		i = message->transfer % GBA_SIO_NET_HISTORY;
+		if (link->historyTransfer[i] != message->transfer || link->historyHash[i] == message->hash) {
+			break;
+		}
+		if (!link->desynced) {
+			mLOG(GBA_SIO, ERROR, "Net link %i: Desynced from player %i by transfer %u", link->id, id, message->transfer);
+		}
+		link->desynced = true;
+		break;
+	}
+}
+
+static void _receive(struct GBASIONetLink* link) {
+	uint32_t packet[NET_PACKET_SIZE / 4];
+	struct Address address;
+	int port;
+	ssize_t size;
+	while ((size = SocketRecvFrom(link->socket, packet, sizeof(packet), &port, &address)) >= NET_HEADER_SIZE) {
+		uint32_t magic;
+		uint32_t info;
+		uint32_t ack;
+		LOAD_32LE(magic, 0, packet);
+		LOAD_32LE(info, 4, packet);
+		LOAD_32LE(ack, 8, packet);
+		int id = info & 0xFF;
+		uint32_t count = info >> 8;
+		if (magic != NET_MAGIC || id >= link->players || id == link->id || (link->id && id)) {
+			continue;
+		}
+		if (count > GBA_SIO_NET_QUEUE || (size_t) size < NET_HEADER_SIZE + count * NET_MESSAGE_SIZE) {
+			continue;
+		}
+		struct GBASIONetPeer* peer = &link->peers[id];
+		if (!peer->known) {
+			// The master learns where everyone else is from their first packet
+			peer->address = address;
+			peer->port = port;
+			peer->known = true;
+		}
+		peer->connected = true;
+		if ((int32_t) (ack - peer->acked) > 0 && (int32_t) (ack - peer->nextSequence) <= 0) {
+			peer->acked = ack;
+		}
+
+		uint32_t i;
+		size_t offset = NET_HEADER_SIZE;
+		for (i = 0; i < count; ++i, offset += NET_MESSAGE_SIZE) {
+			struct GBASIONetMessage message;
+			uint32_t type;
+			LOAD_32LE(message.sequence, offset, packet);
+			if (message.sequence != peer->received) {
+				// Already seen, or past one that went missing and will come again
+				continue;
+			}
+			LOAD_32LE(type, offset + 4, packet);
+			message.type = type;
+			LOAD_32LE(message.transfer, offset + 8, packet);
+			LOAD_16LE(message.data[0], offset + 12, packet);
+			LOAD_16LE(message.data[1], offset + 14, packet);
+			LOAD_16LE(message.data[2], offset + 16, packet);
+			LOAD_16LE(message.data[3], offset + 18, packet);
+			LOAD_32LE(message.hash, offset + 20, packet);
+			++peer->received;
+			_handleMessage(link, id, &message);
+		}
+		if (count) {
+			peer->ackPending = true;
+		}
+	}
+}
+
+static bool _isReady(const struct GBASIONetLink* link) {
+	int i;
+	for (i = 0; i < link->players; ++i) {
+		if (i != link->id && !link->peers[i].connected) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void _masterComplete(struct GBASIONetLink* link) {
+	int i;
+	link->transferData[0] = link->peers[0].data;
+	for (i = 1; i < MAX_GBAS; ++i) {
+		struct GBASIONetPeer* peer = &link->peers[i];
+		if (i >= link->players) {
+			link->transferData[i] = 0xFFFF;
+		} else if (peer->hasData) {
+			link->transferData[i] = peer->data;
+			peer->lastData = peer->data;
+		} else {
+			link->transferData[i] = peer->lastData;
+		}
+	}
+	_finishTransfer(link);
+	for (i = 1; i < link->players; ++i) {
+		_queue(link, i, NET_COMPLETE, link->transferData, 0);
+		if (!(link->transfer % NET_HASH_INTERVAL)) {
+			_queue(link, i, NET_HASH, NULL, link->hash);
+		}
+	}
+}
+
+static bool _masterHasData(const struct GBASIONetLink* link) {
+	int i;
+	for (i = 1; i < link->players; ++i) {
+		if (!link->peers[i].hasData) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void _masterWait(struct GBASIONetLink* link) {
+	int waited;
+	for (waited = 0; waited < NET_TIMEOUT && !_masterHasData(link); waited += NET_WAIT_SLICE) {
+		Socket reads = link->socket;
+		SocketPoll(1, &reads, NULL, NULL, NET_WAIT_SLICE);
+		_receive(link);
+		_flush(link, waited % (NET_WAIT_SLICE * 4) == 0);
+	}
+	if (!_masterHasData(link)) {
+		mLOG(GBA_SIO, WARN, "Net link %i: Timed out waiting for transfer %u", link->id, link->transfer);
+	}
+}
+
+static void _GBASIONetLinkProcessEvents(struct mTiming* timing, void* user, uint32_t cyclesLate) {
+	struct GBASIONetLink* link = user;
+	struct GBASIO* sio = link->d.p;
+	++link->ticks;
+	_receive(link);
+	sio->siocnt = GBASIOMultiplayerSetReady(sio->siocnt, _isReady(link));
+
+	int32_t when = NET_TICK;
+	if (!link->id && link->transferActive) {
+		if (_masterHasData(link)) {
+			_masterComplete(link);
+		} else if (link->transferLate < link->inputDelay) {
+			when = link->inputDelay - link->transferLate;
+			if (when > NET_TICK) {
+				when = NET_TICK;
+			}
+			link->transferLate += when;
+		} else {
+			if (!link->predict) {
+				_masterWait(link);
+			}
+			_masterComplete(link);
+		}
+	}
+	_flush(link, !(link->ticks % NET_RESEND_TICKS));
+	mTimingSchedule(timing, &link->event, when - cyclesLate);
+}
+
+bool GBASIONetLinkOpen(struct GBASIONetLink* link, int id, int players, int port, const struct Address* bindAddress) {
+	if (id < 0 || id >= players || players > MAX_GBAS) {
+		return false;
+	}
+	link->socket = SocketOpenUDP(port, bindAddress);
+	if (SOCKET_FAILED(link->socket)) {
+		return false;
+	}
+	SocketSetBlocking(link->socket, false);
+	link->id = id;
+	link->players = players;
+	memset(link->peers, 0, sizeof(link->peers));
+	link->transfer = 0;
+	link->transferActive = false;
+	link->hash = 0;
+	memset(link->historyTransfer, 0xFF, sizeof(link->historyTransfer));
+	link->desynced = false;
+	if (id) {
+		// Keeps being sent until the master acknowledges it
+		_queue(link, 0, NET_HELLO, NULL, 0);
+	}
+	return true;
+}
+
+void GBASIONetLinkClose(struct GBASIONetLink* link) {
+	if (!SOCKET_FAILED(link->socket)) {
+		SocketClose(link->socket);
+	}
+	link->socket = INVALID_SOCKET;
+}
+
+void GBASIONetLinkSetPeer(struct GBASIONetLink* link, int id, const struct Address* address, int port) {
+	struct GBASIONetPeer* peer = &link->peers[id];
+	peer->address = *address;
+	peer->port = port;
+	peer->known = true;
+}
+
+static bool GBASIONetLinkInit(struct GBASIODriver* driver) {
+	struct GBASIONetLink* link = (struct GBASIONetLink*) driver;
+	driver->p->siocnt = GBASIOMultiplayerSetSlave(driver->p->siocnt, link->id > 0);
+	link->event.context = link;
+	link->event.name = "GBA SIO Net Link";
+	link->event.callback = _GBASIONetLinkProcessEvents;
+	link->event.priority = 0x80;
+	return true;
+}
+
+static void GBASIONetLinkDeinit(struct GBASIODriver* driver) {
+	UNUSED(driver);
+}
+
+static bool GBASIONetLinkLoad(struct GBASIODriver* driver) {
+	struct GBASIONetLink* link = (struct GBASIONetLink*) driver;
+	if (driver->p->mode != SIO_MULTI || SOCKET_FAILED(link->socket)) {
+		return false;
+	}
+	driver->p->rcnt |= 3;
+	driver->p->siocnt = GBASIOMultiplayerSetReady(driver->p->siocnt, _isReady(link));
+	if (link->id) {
+		driver->p->rcnt |= 4;
+		driver->p->siocnt = GBASIOMultiplayerFillSlave(driver->p->siocnt);
+	}
+	mTimingDeschedule(&driver->p->p->timing, &link->event);
+	mTimingSchedule(&driver->p->p->timing, &link->event, 0);
+	return true;
+}
+
+static bool GBASIONetLinkUnload(struct GBASIODriver* driver) {
+	struct GBASIONetLink* link = (struct GBASIONetLink*) driver;
+	mTimingDeschedule(&driver->p->p->timing, &link->event);
+	if (!link->id && link->transferActive) {
+		_masterComplete(link);
+		_flush(link, true);
+	}
+	link->transferActive = false;
+	return true;
+}
+
+static uint16_t GBASIONetLinkWriteRegister(struct GBASIODriver* driver, uint32_t address, uint16_t value) {
+	struct GBASIONetLink* link = (struct GBASIONetLink*) driver;
+	struct GBASIO* sio = driver->p;
+	if (address == REG_SIOCNT) {
+		mLOG(GBA_SIO, DEBUG, "Net link %i: SIOCNT <- %04x", link->id, value);
+		if (value & 0x0080 && !link->transferActive) {
+			if (!link->id && GBASIOMultiplayerIsReady(sio->siocnt)) {
+				mLOG(GBA_SIO, DEBUG, "Net link %i: Transfer initiated", link->id);
+				++link->transfer;
+				_startTransfer(link);
+				link->transferLate = 0;
+				link->peers[0].data = sio->p->memory.io[REG_SIOMLT_SEND >> 1];
+				int i;
+				for (i = 1; i < link->players; ++i) {
+					link->peers[i].hasData = false;
+					_queue(link, i, NET_START, NULL, 0);
+				}
+				_flush(link, false);
+
+				struct mTiming* timing = &sio->p->timing;
+				mTimingDeschedule(timing, &link->event);
+				mTimingSchedule(timing, &link->event, GBASIOCyclesPerTransfer[GBASIOMultiplayerGetBaud(sio->siocnt)][link->players - 1]);
+			} else {
+				value &= ~0x0080;
+			}
+		}
+		value &= 0xFF83;
+		value |= sio->siocnt & 0x00FC;
+	} else if (address == REG_SIOMLT_SEND) {
+		mLOG(GBA_SIO, DEBUG, "Net link %i: SIOMLT_SEND <- %04x", link->id, value);
+	}
+	return value;
+}
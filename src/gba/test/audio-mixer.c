@@ -0,0 +1,153 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/gba/core.h>
+#include <mgba/internal/arm/macros.h>
+#include <mgba/internal/gba/extra/audio-mixer.h>
+#include <mgba/internal/gba/gba.h>
+
+#define CONTEXT_ADDRESS 0x03001000
+#define WAVE_ADDRESS 0x02000000
+#define WAVE_SIZE 0x200
+#define BLOCK_LENGTH 224
+#define BLOCK_PERIOD 7
+
+static int8_t _waveSample(int i) {
+	return (i * 37) % 101 - 50;
+}
+
+static struct mCore* _setup(void) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	mCoreConfigSetIntValue(&core->config, "gba.audioHle", 1);
+	core->reset(core);
+	struct GBA* gba = core->board;
+	assert_non_null(gba->audio.mixer);
+
+	uint8_t* wave = (uint8_t*) gba->memory.wram;
+	STORE_16(0, 0x2, wave);
+	STORE_32(0, 0x8, wave);
+	STORE_32(WAVE_SIZE, 0xC, wave);
+	int i;
+	for (i = 0; i < WAVE_SIZE; ++i) {
+		wave[0x10 + i] = _waveSample(i);
+	}
+
+	uint8_t* context = (uint8_t*) gba->memory.iwram + (CONTEXT_ADDRESS & (SIZE_WORKING_IRAM - 1));
+	memset(context, 0, sizeof(struct GBAMP2kContext));
+	STORE_32(MP2K_MAGIC, 0x00, context);
+	context[0x06] = 1;
+	context[0x0B] = BLOCK_PERIOD;
+	STORE_32(BLOCK_LENGTH, 0x10, context);
+	STORE_32(1 << 14, 0x18, context);
+	return core;
+}
+
+static void _setVoice(struct mCore* core, uint8_t type, uint8_t right, uint8_t left, uint32_t freq, uint32_t consumed) {
+	struct GBA* gba = core->board;
+	uint8_t* channel = (uint8_t*) gba->memory.iwram + (CONTEXT_ADDRESS & (SIZE_WORKING_IRAM - 1)) + 0x50;
+	channel[0x00] = 0x03;
+	channel[0x01] = type;
+	channel[0x0A] = right;
+	channel[0x0B] = left;
+	STORE_32(0, 0x1C, channel);
+	STORE_32(freq, 0x20, channel);
+	STORE_32(WAVE_ADDRESS, 0x24, channel);
+	STORE_32(WAVE_ADDRESS + 0x10 + consumed, 0x28, channel);
+}
+
+static void _teardown(struct mCore* core) {
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(fixedVoice) {
+	struct mCore* core = _setup();
+	struct GBA* gba = core->board;
+	struct GBAAudioMixer* mixer = gba->audio.mixer;
+	_setVoice(core, 0x08, 0x80, 0x40, 0, BLOCK_LENGTH);
+	assert_true(mixer->engage(mixer, CONTEXT_ADDRESS, 0, false));
+	assert_true(gba->audio.externalMixing);
+	mixer->vblank(mixer);
+	assert_true(gba->audio.externalMixing);
+	assert_int_equal(mixer->segment, 1);
+	int i;
+	for (i = 0; i < BLOCK_LENGTH; ++i) {
+		assert_int_equal(mixer->pcm[0][BLOCK_LENGTH + i], _waveSample(i) * 0x80);
+		assert_int_equal(mixer->pcm[1][BLOCK_LENGTH + i], _waveSample(i) * 0x40);
+	}
+	_teardown(core);
+}
+
+M_TEST_DEFINE(interpolatedVoice) {
+	struct mCore* core = _setup();
+	struct GBA* gba = core->board;
+	struct GBAAudioMixer* mixer = gba->audio.mixer;
+	// Half a sample per output sample
+	_setVoice(core, 0x00, 0x80, 0, 0x100, BLOCK_LENGTH / 2);
+	assert_true(mixer->engage(mixer, CONTEXT_ADDRESS, 0, false));
+	mixer->vblank(mixer);
+	int i;
+	for (i = 0; i < BLOCK_LENGTH; ++i) {
+		int sample = _waveSample(i / 2) * 256;
+		if (i & 1) {
+			sample += (_waveSample(i / 2 + 1) - _waveSample(i / 2)) * 128;
+		}
+		assert_int_equal(mixer->pcm[0][BLOCK_LENGTH + i], sample / 2);
+		assert_int_equal(mixer->pcm[1][BLOCK_LENGTH + i], 0);
+	}
+
+	// The next block picks up exactly where this one left off
+	_setVoice(core, 0x00, 0x80, 0, 0x100, BLOCK_LENGTH);
+	mixer->vblank(mixer);
+	assert_int_equal(mixer->segment, 2);
+	for (i = 0; i < BLOCK_LENGTH; ++i) {
+		int sample = _waveSample((BLOCK_LENGTH + i) / 2) * 256;
+		if (i & 1) {
+			sample += (_waveSample((BLOCK_LENGTH + i) / 2 + 1) - _waveSample((BLOCK_LENGTH + i) / 2)) * 128;
+		}
+		assert_int_equal(mixer->pcm[0][BLOCK_LENGTH * 2 + i], sample / 2);
+	}
+	_teardown(core);
+}
+
+M_TEST_DEFINE(unsupportedFallback) {
+	struct mCore* core = _setup();
+	struct GBA* gba = core->board;
+	struct GBAAudioMixer* mixer = gba->audio.mixer;
+	// Compressed samples
+	_setVoice(core, 0x20, 0x80, 0x80, 0x100, BLOCK_LENGTH / 2);
+	assert_true(mixer->engage(mixer, CONTEXT_ADDRESS, 0, false));
+	mixer->vblank(mixer);
+	assert_true(mixer->unsupported);
+	assert_false(gba->audio.externalMixing);
+	assert_false(mixer->engage(mixer, CONTEXT_ADDRESS, 0, false));
+	assert_false(gba->audio.externalMixing);
+	_teardown(core);
+}
+
+M_TEST_DEFINE(disableAtRuntime) {
+	struct mCore* core = _setup();
+	struct GBA* gba = core->board;
+	mCoreConfigSetIntValue(&core->config, "gba.audioHle", 0);
+	core->reloadConfigOption(core, "gba.audioHle", NULL);
+	assert_null(gba->audio.mixer);
+	assert_false(gba->audio.externalMixing);
+	gba->audio.hleMode = GBA_AUDIO_HLE_ENABLED;
+	core->reset(core);
+	assert_non_null(gba->audio.mixer);
+	_teardown(core);
+}
+
+M_TEST_SUITE_DEFINE(GBAAudioMixer,
+	cmocka_unit_test(fixedVoice),
+	cmocka_unit_test(interpolatedVoice),
+	cmocka_unit_test(unsupportedFallback),
+	cmocka_unit_test(disableAtRuntime))
@@ -1051,6 +1051,52 @@ M_TEST_DEFINE(doPARv3IfButton) {
 	mCheatSetDeinit(set);
 }
 
+M_TEST_DEFINE(editCompiledCheat) {
+	struct mCore* core = *state;
+	struct mCheatDevice* device = core->cheatDevice(core);
+	assert_non_null(device);
+	struct mCheatSet* set = device->createSet(device, NULL);
+	assert_non_null(set);
+	struct mCheat* cheat = mCheatListAppend(&set->list);
+	cheat->type = CHEAT_ASSIGN;
+	cheat->width = 2;
+	cheat->address = 0x02040010;
+	cheat->operand = 0x1234;
+	cheat->repeat = 1;
+	cheat->negativeRepeat = 0;
+	cheat->addressOffset = 0;
+	cheat->operandOffset = 0;
+
+	core->reset(core);
+	mCheatRefresh(device, set);
+	assert_int_equal(core->rawRead16(core, 0x02000010, -1), 0x1234);
+
+	cheat = mCheatListGetPointer(&set->list, 0);
+	cheat->address = 0x03000001;
+	cheat->width = 1;
+	mCheatRefresh(device, set);
+	assert_int_equal(core->rawRead16(core, 0x03000000, -1), 0x3400);
+
+	cheat->address = 0x03007FFE;
+	cheat->width = 4;
+	mCheatRefresh(device, set);
+	assert_int_equal(core->rawRead16(core, 0x03007FFC, -1), 0x1234);
+
+	cheat->type = CHEAT_ADD;
+	cheat->address = 0x02000000;
+	cheat->width = 2;
+	cheat->operand = 1;
+	cheat->repeat = 4;
+	cheat->addressOffset = 2;
+	core->rawWrite16(core, 0x02000004, -1, 0x100);
+	mCheatRefresh(device, set);
+	assert_int_equal(core->rawRead16(core, 0x02000000, -1), 1);
+	assert_int_equal(core->rawRead16(core, 0x02000004, -1), 0x101);
+	assert_int_equal(core->rawRead16(core, 0x02000006, -1), 1);
+	assert_int_equal(core->rawRead16(core, 0x02000008, -1), 0);
+	mCheatSetDeinit(set);
+}
+
 M_TEST_SUITE_DEFINE(GBACheats,
 	cmocka_unit_test_setup_teardown(createSet, cheatsSetup, cheatsTeardown),
 	cmocka_unit_test_setup_teardown(addRawPARv3, cheatsSetup, cheatsTeardown),
@@ -1072,4 +1118,5 @@ M_TEST_SUITE_DEFINE(GBACheats,
 	cmocka_unit_test_setup_teardown(doPARv3IfXContain1Else, cheatsSetup, cheatsTeardown),
 	cmocka_unit_test_setup_teardown(doPARv3IfXElseContain1, cheatsSetup, cheatsTeardown),
 	cmocka_unit_test_setup_teardown(doPARv3IfXContain1ElseContain1, cheatsSetup, cheatsTeardown),
-	cmocka_unit_test_setup_teardown(doPARv3IfButton, cheatsSetup, cheatsTeardown))
+	cmocka_unit_test_setup_teardown(doPARv3IfButton, cheatsSetup, cheatsTeardown),
+	cmocka_unit_test_setup_teardown(editCompiledCheat, cheatsSetup, cheatsTeardown))
@@ -5,8 +5,19 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include "util/test/suite.h"
 
+#include "gba/renderers/software-private.h"
+
 #include <mgba/core/core.h>
+#include <mgba/core/quick-save.h>
+#include <mgba/core/rewind.h>
+#include <mgba/core/serialize.h>
 #include <mgba/gba/core.h>
+#include <mgba/internal/gba/bios.h>
+#include <mgba/internal/gba/gba.h>
+#include <mgba/internal/gba/io.h>
+#include <mgba/internal/gba/overrides.h>
+#include <mgba/internal/gba/serialize.h>
+#include <mgba-util/vfs.h>
 
 M_TEST_DEFINE(create) {
 	struct mCore* core = GBACoreCreate();
@@ -44,8 +55,981 @@ M_TEST_DEFINE(loadNullROM) {
 	core->deinit(core);
 }
 
+static void _drawFrame(struct GBAVideoRenderer* renderer) {
+	int y;
+	for (y = 0; y < GBA_VIDEO_VERTICAL_PIXELS; ++y) {
+		renderer->drawScanline(renderer, y);
+	}
+	renderer->finishFrame(renderer);
+}
+
+M_TEST_DEFINE(videoFrameChanged) {
+	static color_t buffer[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->setVideoBuffer(core, buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	core->reset(core);
+	struct GBA* gba = core->board;
+	struct GBAVideoRenderer* renderer = gba->video.renderer;
+
+	_drawFrame(renderer);
+	assert_true(core->videoFrameChanged(core));
+	_drawFrame(renderer);
+	assert_false(core->videoFrameChanged(core));
+
+	core->busWrite16(core, BASE_IO | REG_DISPCNT, 0x0100);
+	_drawFrame(renderer);
+	assert_true(core->videoFrameChanged(core));
+	_drawFrame(renderer);
+	assert_false(core->videoFrameChanged(core));
+
+	core->busWrite16(core, BASE_PALETTE_RAM, 0x001F);
+	_drawFrame(renderer);
+	assert_true(core->videoFrameChanged(core));
+
+	core->busWrite16(core, BASE_VRAM, 0x1111);
+	_drawFrame(renderer);
+	assert_true(core->videoFrameChanged(core));
+	_drawFrame(renderer);
+	assert_false(core->videoFrameChanged(core));
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(tileCache) {
+	static color_t buffer[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	mCoreConfigSetIntValue(&core->config, "videoTileCache", 1);
+	core->setVideoBuffer(core, buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	core->reset(core);
+	struct GBA* gba = core->board;
+	struct GBAVideoSoftwareRenderer* renderer = (struct GBAVideoSoftwareRenderer*) gba->video.renderer;
+	const struct GBAVideoSoftwareTileCache* tileCache = renderer->tileCache;
+	assert_non_null(tileCache);
+
+	core->busWrite16(core, BASE_VRAM, 0x0F30);
+	assert_int_equal(tileCache->indices[0], 0x0);
+	assert_int_equal(tileCache->indices[1], 0x3);
+	assert_int_equal(tileCache->indices[2], 0xF);
+	assert_int_equal(tileCache->indices[3], 0x0);
+	assert_int_equal(tileCache->opaque[0], 0x06);
+
+	core->busWrite32(core, BASE_VRAM + 0x10004, 0x81000000);
+	assert_int_equal(tileCache->indices[0x20008 + 6], 0x1);
+	assert_int_equal(tileCache->indices[0x20008 + 7], 0x8);
+	assert_int_equal(tileCache->opaque[0x4001], 0xC0);
+
+	// Patched memory bypasses the bus but must still reach the renderer
+	core->rawWrite16(core, BASE_VRAM + 0x10006, -1, 0);
+	assert_int_equal(tileCache->opaque[0x4001], 0x00);
+
+	mCoreConfigSetIntValue(&core->config, "videoTileCache", 0);
+	core->reloadConfigOption(core, "videoTileCache", NULL);
+	assert_null(renderer->tileCache);
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(windowSpans) {
+	static color_t buffer[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->setVideoBuffer(core, buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	core->reset(core);
+	struct GBA* gba = core->board;
+	struct GBAVideoSoftwareRenderer* renderer = (struct GBAVideoSoftwareRenderer*) gba->video.renderer;
+
+	core->busWrite16(core, BASE_IO | REG_WIN0H, 0x1050);
+	core->busWrite16(core, BASE_IO | REG_WIN0V, 0x0820);
+	core->busWrite16(core, BASE_IO | REG_DISPCNT, 0x2100);
+	renderer->d.drawScanline(&renderer->d, 10);
+	assert_int_equal(renderer->nWindows, 3);
+	assert_int_equal(renderer->windows[0].endX, 0x10);
+	assert_int_equal(renderer->windows[1].endX, 0x50);
+	renderer->d.drawScanline(&renderer->d, 40);
+	assert_int_equal(renderer->nWindows, 1);
+	renderer->d.drawScanline(&renderer->d, 11);
+	assert_int_equal(renderer->nWindows, 3);
+
+	// Moving the window rebuilds the spans even though the same windows cover the line
+	core->busWrite16(core, BASE_IO | REG_WIN0H, 0x2060);
+	renderer->d.drawScanline(&renderer->d, 12);
+	assert_int_equal(renderer->nWindows, 3);
+	assert_int_equal(renderer->windows[0].endX, 0x20);
+	assert_int_equal(renderer->windows[1].endX, 0x60);
+
+	core->busWrite16(core, BASE_IO | REG_DISPCNT, 0x0100);
+	renderer->d.drawScanline(&renderer->d, 13);
+	assert_int_equal(renderer->nWindows, 1);
+	assert_int_equal(renderer->windows[0].control.packed, 0xFF);
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(variantPalettes) {
+	static color_t buffer[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->setVideoBuffer(core, buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	core->reset(core);
+	struct GBA* gba = core->board;
+	struct GBAVideoSoftwareRenderer* renderer = (struct GBAVideoSoftwareRenderer*) gba->video.renderer;
+
+	int i;
+	for (i = 0; i < 512; ++i) {
+		core->busWrite16(core, BASE_PALETTE_RAM | (i * 2), i * 0x8D3B);
+	}
+	core->busWrite16(core, BASE_IO | REG_DISPCNT, 0x0100);
+	core->busWrite16(core, BASE_IO | REG_BLDY, 7);
+
+	// Nothing targets the brightening yet, so neither half is filled in
+	core->busWrite16(core, BASE_IO | REG_BLDCNT, 0x0080);
+	renderer->d.drawScanline(&renderer->d, 0);
+	assert_int_equal(renderer->variantDirty, 3);
+
+	core->busWrite16(core, BASE_IO | REG_BLDCNT, 0x0082);
+	renderer->d.drawScanline(&renderer->d, 1);
+	assert_int_equal(renderer->variantDirty, 2);
+	for (i = 0; i < 256; ++i) {
+		assert_int_equal(renderer->variantPalette[i], _brighten(renderer->normalPalette[i], 7));
+	}
+
+	// Changing the effect makes both halves stale, and a line targeting both fills them in
+	core->busWrite16(core, BASE_IO | REG_BLDCNT, 0x00D1);
+	renderer->d.drawScanline(&renderer->d, 2);
+	assert_int_equal(renderer->variantDirty, 0);
+	for (i = 0; i < 512; ++i) {
+		assert_int_equal(renderer->variantPalette[i], _darken(renderer->normalPalette[i], 7));
+	}
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(quickSave) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+
+	struct mCoreQuickSaveContext quickSave = { .nSlots = 0 };
+	mCoreQuickSaveContextInit(&quickSave, 2, true);
+	assert_false(mCoreQuickSaveRestore(&quickSave, core, 0));
+
+	// The third state reuses the oldest slot
+	core->busWrite32(core, BASE_WORKING_IRAM, 1);
+	assert_true(mCoreQuickSaveTake(&quickSave, core, 0));
+	core->busWrite32(core, BASE_WORKING_IRAM, 2);
+	assert_true(mCoreQuickSaveTake(&quickSave, core, 0));
+	core->busWrite32(core, BASE_WORKING_IRAM, 3);
+	assert_true(mCoreQuickSaveTake(&quickSave, core, 0));
+	mCoreQuickSaveFlush(&quickSave);
+
+	core->busWrite32(core, BASE_WORKING_IRAM, 4);
+	assert_true(mCoreQuickSaveRestore(&quickSave, core, 0));
+	assert_int_equal(core->busRead32(core, BASE_WORKING_IRAM), 3);
+
+	mCoreQuickSaveContextDeinit(&quickSave);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+static void _stateSaved(struct mCoreStateSaver* saver, int slot, bool success) {
+	int* result = saver->context;
+	*result = success ? slot : -1;
+}
+
+M_TEST_DEFINE(stateSaverAsync) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+
+	int result = 0;
+	struct mCoreStateSaver saver;
+	mCoreStateSaverInit(&saver, true);
+	saver.callback = _stateSaved;
+	saver.context = &result;
+
+	size_t size = core->stateSize(core) + 0x100;
+	void* buffer = malloc(size);
+	assert_non_null(buffer);
+	core->busWrite32(core, BASE_WORKING_IRAM, 0x12345678);
+	assert_true(mCoreStateSaverSave(&saver, core, VFileFromMemory(buffer, size), SAVESTATE_RTC, 3));
+	// The snapshot is already taken, so the core can carry on
+	core->busWrite32(core, BASE_WORKING_IRAM, 0);
+	mCoreStateSaverWait(&saver);
+	assert_int_equal(result, 3);
+
+	struct VFile* vf = VFileFromConstMemory(buffer, size);
+	assert_true(mCoreLoadStateNamed(core, vf, 0));
+	vf->close(vf);
+	assert_int_equal(core->busRead32(core, BASE_WORKING_IRAM), 0x12345678);
+
+	mCoreStateSaverDeinit(&saver);
+	free(buffer);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(stateThumbnail) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	static color_t buffer[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+	memset(buffer, 0, sizeof(buffer));
+	core->setVideoBuffer(core, buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	core->reset(core);
+
+	struct VFile* vf = VFileMemChunk(NULL, 0);
+	assert_non_null(vf);
+	assert_true(mCoreSaveStateNamed(core, vf, SAVESTATE_THUMBNAIL | SAVESTATE_METADATA));
+
+	// Only the requested items are read back
+	static const enum mStateExtdataTag tags[] = { EXTDATA_THUMBNAIL };
+	struct mStateExtdata extdata;
+	struct mStateExtdataItem item;
+	mStateExtdataInit(&extdata);
+	assert_true(mCoreExtractExtdata(core, vf, &extdata, tags, 1));
+	assert_true(mStateExtdataGet(&extdata, EXTDATA_META_TIME, &item));
+	assert_null(item.data);
+	assert_true(mStateExtdataGet(&extdata, EXTDATA_THUMBNAIL, &item));
+
+	unsigned width, height;
+	assert_true(mStateThumbnailDecode(&item, &width, &height, NULL, 0));
+	assert_int_equal(width, GBA_VIDEO_HORIZONTAL_PIXELS / mSTATE_THUMBNAIL_SCALE);
+	assert_int_equal(height, GBA_VIDEO_VERTICAL_PIXELS / mSTATE_THUMBNAIL_SCALE);
+	color_t* pixels = calloc(width * height, sizeof(*pixels));
+	assert_non_null(pixels);
+	assert_true(mStateThumbnailDecode(&item, &width, &height, pixels, width));
+	free(pixels);
+	mStateExtdataDeinit(&extdata);
+
+	// The state itself still loads as usual
+	assert_true(mCoreLoadStateNamed(core, vf, 0));
+	vf->close(vf);
+
+#ifdef USE_PNG
+	// Thumbnails are also found among the chunks of states with screenshots
+	vf = VFileMemChunk(NULL, 0);
+	assert_non_null(vf);
+	assert_true(mCoreSaveStateNamed(core, vf, SAVESTATE_SCREENSHOT | SAVESTATE_THUMBNAIL));
+	mStateExtdataInit(&extdata);
+	assert_true(mCoreExtractExtdata(core, vf, &extdata, tags, 1));
+	assert_true(mStateExtdataGet(&extdata, EXTDATA_THUMBNAIL, &item));
+	assert_true(mStateThumbnailDecode(&item, &width, &height, NULL, 0));
+	assert_int_equal(width, GBA_VIDEO_HORIZONTAL_PIXELS / mSTATE_THUMBNAIL_SCALE);
+	mStateExtdataDeinit(&extdata);
+	vf->close(vf);
+#endif
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(stateCompression) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+
+	assert_int_equal(mStateCompressionParse("none"), 0);
+	assert_int_equal(mStateCompressionParse("rle"), SAVESTATE_COMPRESS(mSTATE_COMPRESSION_RLE, 0));
+	assert_int_equal(mStateCompressionParse("rle:x"), 0);
+	assert_int_equal(mStateCompressionParse("rlex"), 0);
+
+	static const enum mStateExtdataTag tags[] = { EXTDATA_META_TIME };
+	int compression;
+	for (compression = mSTATE_COMPRESSION_RLE; compression < mSTATE_COMPRESSION_MAX; ++compression) {
+		if (!mStateCompressionAvailable(compression)) {
+			continue;
+		}
+		struct VFile* vf = VFileMemChunk(NULL, 0);
+		assert_non_null(vf);
+		core->busWrite32(core, BASE_WORKING_IRAM, 0x1234 + compression);
+		assert_true(mCoreSaveStateNamed(core, vf, SAVESTATE_COMPRESS(compression, 1) | SAVESTATE_METADATA));
+		assert_true(mStateIsCompressed(vf));
+		assert_true(vf->size(vf) < (ssize_t) core->stateSize(core));
+
+		struct mStateExtdata extdata;
+		struct mStateExtdataItem item;
+		mStateExtdataInit(&extdata);
+		assert_true(mCoreExtractExtdata(core, vf, &extdata, tags, 1));
+		assert_true(mStateExtdataGet(&extdata, EXTDATA_META_TIME, &item));
+		assert_non_null(item.data);
+		mStateExtdataDeinit(&extdata);
+
+		core->busWrite32(core, BASE_WORKING_IRAM, 0);
+		assert_true(mCoreLoadStateNamed(core, vf, 0));
+		assert_int_equal(core->busRead32(core, BASE_WORKING_IRAM), 0x1234 + compression);
+		vf->close(vf);
+	}
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(rewindKeyframes) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+
+	struct mCoreRewindContext rewind = { .currentState = NULL };
+	mCoreRewindContextInit(&rewind, 100, false);
+	assert_false(mCoreRewindRestore(&rewind, core));
+
+	// Enough states to wrap the ring, which drops the oldest keyframe group
+	uint32_t i;
+	for (i = 1; i <= M_REWIND_KEYFRAME_INTERVAL * 4; ++i) {
+		core->busWrite32(core, BASE_WORKING_IRAM, i);
+		core->busWrite32(core, BASE_WORKING_RAM + i * 4, i);
+		mCoreRewindAppend(&rewind, core);
+	}
+	assert_true(rewind.size <= 100);
+	assert_true(rewind.entries[rewind.first].keyframe);
+	size_t size = rewind.size;
+	for (--i; mCoreRewindRestore(&rewind, core); --i) {
+		assert_int_equal(core->busRead32(core, BASE_WORKING_IRAM), i - 1);
+		assert_int_equal(core->busRead32(core, BASE_WORKING_RAM + i * 4), 0);
+		assert_int_equal(core->busRead32(core, BASE_WORKING_RAM + (i - 1) * 4), i - 1);
+	}
+	assert_int_equal(M_REWIND_KEYFRAME_INTERVAL * 4 - i, size - 1);
+
+	// A budget smaller than two keyframe groups keeps only the newest group
+	mCoreRewindContextDeinit(&rewind);
+	mCoreRewindContextInit(&rewind, 100, false);
+	for (i = 1; i <= M_REWIND_KEYFRAME_INTERVAL * 2; ++i) {
+		core->busWrite32(core, BASE_WORKING_IRAM, i);
+		mCoreRewindAppend(&rewind, core);
+	}
+	rewind.memoryLimit = rewind.memoryUsed / 2;
+	core->busWrite32(core, BASE_WORKING_IRAM, i);
+	mCoreRewindAppend(&rewind, core);
+	assert_int_equal(rewind.size, 1);
+	assert_true(rewind.memoryUsed > 0);
+
+	mCoreRewindContextDeinit(&rewind);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(rewindPlayback) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	static color_t buffer[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+	static color_t frame[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+	core->setVideoBuffer(core, buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	core->reset(core);
+
+	struct mCoreRewindContext rewind = { .currentState = NULL };
+	mCoreRewindContextInit(&rewind, 100, false);
+	rewind.storeFrames = true;
+	uint32_t i;
+	for (i = 1; i <= M_REWIND_KEYFRAME_INTERVAL + 4; ++i) {
+		size_t p;
+		for (p = 0; p < GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS; ++p) {
+			frame[p] = i + p;
+		}
+		core->putPixels(core, frame, GBA_VIDEO_HORIZONTAL_PIXELS);
+		core->busWrite32(core, BASE_WORKING_IRAM, i);
+		mCoreRewindAppend(&rewind, core);
+	}
+	size_t used = rewind.memoryUsed;
+
+	// Stepping back across a keyframe shows each frame without touching the core
+	for (--i; mCoreRewindStep(&rewind); --i) {
+		memset(frame, 0, sizeof(frame));
+		assert_true(mCoreRewindDrawFrame(&rewind, frame, GBA_VIDEO_HORIZONTAL_PIXELS));
+		// Every other pixel of every other line was kept
+		unsigned x = 7;
+		unsigned y = 9;
+		color_t kept = i - 1 + ((y & ~1) * GBA_VIDEO_HORIZONTAL_PIXELS + (x & ~1));
+		assert_int_equal(frame[y * GBA_VIDEO_HORIZONTAL_PIXELS + x], kept);
+		assert_int_equal(core->busRead32(core, BASE_WORKING_IRAM), M_REWIND_KEYFRAME_INTERVAL + 4);
+	}
+	assert_int_equal(i, 1);
+	assert_true(rewind.memoryUsed < used);
+	assert_true(mCoreRewindLoad(&rewind, core));
+	assert_int_equal(core->busRead32(core, BASE_WORKING_IRAM), 1);
+
+	// Without frames there's nothing to draw
+	mCoreRewindContextDeinit(&rewind);
+	mCoreRewindContextInit(&rewind, 100, false);
+	mCoreRewindAppend(&rewind, core);
+	assert_false(mCoreRewindDrawFrame(&rewind, frame, GBA_VIDEO_HORIZONTAL_PIXELS));
+
+	mCoreRewindContextDeinit(&rewind);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(collectDirtyState) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+
+	size_t size = core->stateSize(core);
+	uint32_t* pages = malloc(M_STATE_PAGE_WORDS(size) * sizeof(*pages));
+	size_t wram = offsetof(struct GBASerializedState, wram) >> M_STATE_PAGE_SHIFT;
+	size_t vram = offsetof(struct GBASerializedState, vram) >> M_STATE_PAGE_SHIFT;
+	assert_false(core->collectDirtyState(core, pages, size - 1));
+
+	// Nothing is known about memory after a reset
+	assert_true(core->collectDirtyState(core, pages, size));
+	assert_true(mStatePageIsDirty(pages, wram + 2));
+	assert_true(core->collectDirtyState(core, pages, size));
+	assert_true(mStatePageIsDirty(pages, 0));
+	assert_false(mStatePageIsDirty(pages, wram + 2));
+
+	core->busWrite32(core, BASE_WORKING_RAM + M_STATE_PAGE_SIZE * 2 + 4, 1);
+	core->rawWrite16(core, BASE_VRAM + M_STATE_PAGE_SIZE, -1, 1);
+	assert_true(core->collectDirtyState(core, pages, size));
+	assert_false(mStatePageIsDirty(pages, wram + 1));
+	assert_true(mStatePageIsDirty(pages, wram + 2));
+	assert_false(mStatePageIsDirty(pages, wram + 3));
+	assert_false(mStatePageIsDirty(pages, vram));
+	assert_true(mStatePageIsDirty(pages, vram + 1));
+	assert_true(core->collectDirtyState(core, pages, size));
+	assert_false(mStatePageIsDirty(pages, wram + 2));
+
+	// Loading a state replaces everything
+	void* buffer = malloc(size);
+	assert_true(core->saveState(core, buffer));
+	assert_true(core->loadState(core, buffer));
+	assert_true(core->collectDirtyState(core, pages, size));
+	assert_true(mStatePageIsDirty(pages, wram + 3));
+
+	free(buffer);
+	free(pages);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(copyState) {
+	struct mCore* source = GBACoreCreate();
+	struct mCore* core = GBACoreCreate();
+	assert_true(source->init(source));
+	assert_true(core->init(core));
+	mCoreInitConfig(source, NULL);
+	mCoreInitConfig(core, NULL);
+	source->reset(source);
+	core->reset(core);
+
+	int i;
+	for (i = 0; i < 5; ++i) {
+		source->runFrame(source);
+	}
+	source->busWrite32(source, BASE_WORKING_RAM + 0x1000, 0x12345678);
+	source->busWrite16(source, BASE_PALETTE_RAM + 2, 0x7FFF);
+	assert_true(core->copyState(core, source));
+	assert_int_equal(core->frameCounter(core), source->frameCounter(source));
+	assert_int_equal(core->busRead32(core, BASE_WORKING_RAM + 0x1000), 0x12345678);
+	assert_int_equal(core->busRead16(core, BASE_PALETTE_RAM + 2), 0x7FFF);
+
+	// Both should carry on identically from here
+	for (i = 0; i < 3; ++i) {
+		source->runFrame(source);
+		core->runFrame(core);
+	}
+	size_t size = core->stateSize(core);
+	void* coreState = malloc(size);
+	void* sourceState = malloc(size);
+	assert_true(core->saveState(core, coreState));
+	assert_true(source->saveState(source, sourceState));
+	assert_memory_equal(coreState, sourceState, size);
+
+	free(coreState);
+	free(sourceState);
+	mCoreConfigDeinit(&core->config);
+	mCoreConfigDeinit(&source->config);
+	core->deinit(core);
+	source->deinit(source);
+}
+
+M_TEST_DEFINE(stateRegions) {
+	struct mCore* core = GBACoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+	core->runFrame(core);
+
+	size_t size = core->stateSize(core);
+	const struct mStateRegion* regions;
+	size_t nRegions = core->listStateRegions(core, &regions);
+	size_t offset = 0;
+	uint32_t ids = 0;
+	size_t i;
+	for (i = 0; i < nRegions; ++i) {
+		assert_int_equal(regions[i].offset, offset);
+		offset += regions[i].size;
+		ids |= regions[i].id;
+	}
+	assert_int_equal(offset, size);
+	assert_int_equal(ids, mSTATE_REGION_ALL);
+
+	uint8_t* full = malloc(size);
+	uint8_t* part = calloc(1, size);
+	core->busWrite32(core, BASE_WORKING_RAM + 0x100, 0x12345678);
+	core->busWrite16(core, BASE_VRAM + 0x100, 0x1234);
+	assert_true(mCoreSaveStateRegions(core, full, mSTATE_REGION_ALL));
+	assert_true(mCoreSaveStateRegions(core, part, mSTATE_REGION_WRAM));
+	struct GBASerializedState* saved = (struct GBASerializedState*) part;
+	assert_int_equal(saved->wram[0x100], 0x78);
+	assert_int_equal(saved->vram[0x80], 0);
+	assert_int_equal(saved->cpu.gprs[ARM_PC], 0);
+	assert_int_equal(saved->versionMagic, ((struct GBASerializedState*) full)->versionMagic);
+	assert_int_equal(saved->id, ((struct GBASerializedState*) full)->id);
+
+	// Loading one region leaves the others, and the CPU, alone
+	int32_t frame = core->frameCounter(core);
+	core->runFrame(core);
+	core->busWrite32(core, BASE_WORKING_RAM + 0x100, 0);
+	core->busWrite16(core, BASE_VRAM + 0x100, 0x4321);
+	assert_true(mCoreLoadStateRegions(core, full, mSTATE_REGION_WRAM));
+	assert_int_equal(core->busRead32(core, BASE_WORKING_RAM + 0x100), 0x12345678);
+	assert_int_equal(core->busRead16(core, BASE_VRAM + 0x100), 0x4321);
+	assert_int_equal(core->frameCounter(core), frame + 1);
+
+	assert_true(mCoreLoadStateRegions(core, full, mSTATE_REGION_CORE | mSTATE_REGION_VRAM));
+	assert_int_equal(core->frameCounter(core), frame);
+	assert_int_equal(core->busRead16(core, BASE_VRAM + 0x100), 0x1234);
+
+	// A partial state is still checked against the game
+	saved = (struct GBASerializedState*) full;
+	saved->id ^= 1;
+	assert_false(mCoreLoadStateRegions(core, full, mSTATE_REGION_IWRAM));
+
+	free(full);
+	free(part);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(stateHash) {
+	struct mCore* source = GBACoreCreate();
+	struct mCore* core = GBACoreCreate();
+	assert_true(source->init(source));
+	assert_true(core->init(core));
+	mCoreInitConfig(source, NULL);
+	mCoreInitConfig(core, NULL);
+	source->reset(source);
+	core->reset(core);
+	assert_int_equal(core->stateHash(core), source->stateHash(source));
+
+	source->runFrame(source);
+	core->runFrame(core);
+	uint64_t hash = core->stateHash(core);
+	assert_int_equal(hash, source->stateHash(source));
+	assert_int_equal(hash, core->stateHash(core));
+
+	core->busWrite8(core, BASE_WORKING_RAM + 0x3FFFF, 1);
+	assert_int_not_equal(core->stateHash(core), source->stateHash(source));
+	source->busWrite8(source, BASE_WORKING_RAM + 0x3FFFF, 1);
+	assert_int_equal(core->stateHash(core), source->stateHash(source));
+
+	core->busWrite16(core, BASE_OAM + 0x3FE, 0x1234);
+	assert_int_not_equal(core->stateHash(core), source->stateHash(source));
+	assert_true(core->copyState(core, source));
+	assert_int_equal(core->stateHash(core), source->stateHash(source));
+
+	mCoreConfigDeinit(&core->config);
+	mCoreConfigDeinit(&source->config);
+	core->deinit(core);
+	source->deinit(source);
+}
+
+static uint32_t _hookedLoad8(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
+	return GBALoad8(cpu, address, cycleCounter);
+}
+
+M_TEST_DEFINE(biosDecompress) {
+	static const uint8_t lz77[] = {
+		0x10, 0x10, 0x00, 0x00, 0x20, 'A', 'B', 0xB0, 0x01
+	};
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+	struct ARMCore* cpu = core->cpu;
+	size_t i;
+	for (i = 0; i < sizeof(lz77); ++i) {
+		core->busWrite8(core, BASE_WORKING_RAM + i, lz77[i]);
+	}
+	size_t size = core->stateSize(core);
+	uint32_t* pages = malloc(M_STATE_PAGE_WORDS(size) * sizeof(*pages));
+	size_t wram = offsetof(struct GBASerializedState, wram) >> M_STATE_PAGE_SHIFT;
+	size_t vram = offsetof(struct GBASerializedState, vram) >> M_STATE_PAGE_SHIFT;
+	assert_true(core->collectDirtyState(core, pages, size));
+
+	// Once straight to host memory, once through hooked loads on the bus
+	int pass;
+	for (pass = 0; pass < 2; ++pass) {
+		uint32_t dest[] = { BASE_WORKING_RAM + 0x1000 + pass * 0x100, BASE_VRAM + pass * 0x100 };
+		cpu->gprs[0] = BASE_WORKING_RAM;
+		cpu->gprs[1] = dest[0];
+		GBASwi16(cpu, 0x11);
+		assert_int_equal(cpu->gprs[1], dest[0] + 16);
+		cpu->gprs[0] = BASE_WORKING_RAM;
+		cpu->gprs[1] = dest[1];
+		GBASwi16(cpu, 0x12);
+		assert_int_equal(cpu->gprs[1], dest[1] + 16);
+		for (i = 0; i < 16; i += 2) {
+			assert_int_equal(core->busRead16(core, dest[0] + i), 0x4241);
+			assert_int_equal(core->busRead16(core, dest[1] + i), 0x4241);
+		}
+		assert_true(core->collectDirtyState(core, pages, size));
+		assert_true(mStatePageIsDirty(pages, wram + ((0x1000 + pass * 0x100) >> M_STATE_PAGE_SHIFT)));
+		assert_true(mStatePageIsDirty(pages, vram + pass));
+		cpu->memory.load8 = _hookedLoad8;
+	}
+	cpu->memory.load8 = GBALoad8;
+
+	free(pages);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(biosCpuSet) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+	struct ARMCore* cpu = core->cpu;
+	int i;
+
+	// CpuFastSet fill, rounded up to a whole block
+	core->busWrite32(core, BASE_WORKING_IRAM, 0x12345678);
+	cpu->gprs[0] = BASE_WORKING_IRAM;
+	cpu->gprs[1] = BASE_VRAM;
+	cpu->gprs[2] = 0x01000000 | 12;
+	GBASwi16(cpu, 0xC);
+	for (i = 0; i < 16; ++i) {
+		assert_int_equal(core->busRead32(core, BASE_VRAM + i * 4), 0x12345678);
+	}
+	assert_int_equal(core->busRead32(core, BASE_VRAM + 64), 0);
+	assert_int_equal(cpu->gprs[0], BASE_WORKING_IRAM);
+	assert_int_equal(cpu->gprs[1], BASE_VRAM + 64);
+	assert_int_equal(cpu->gprs[2], BASE_VRAM + 48);
+	assert_int_equal(cpu->gprs[3], 0x12345678);
+
+	// CpuSet halfword copy
+	for (i = 0; i < 3; ++i) {
+		core->busWrite16(core, BASE_WORKING_RAM + i * 2, 0x7C00 + i);
+	}
+	cpu->gprs[0] = BASE_WORKING_RAM;
+	cpu->gprs[1] = BASE_PALETTE_RAM + 2;
+	cpu->gprs[2] = 3;
+	GBASwi16(cpu, 0xB);
+	for (i = 0; i < 3; ++i) {
+		assert_int_equal(core->busRead16(core, BASE_PALETTE_RAM + 2 + i * 2), 0x7C00 + i);
+	}
+	assert_int_equal(core->busRead16(core, BASE_PALETTE_RAM + 8), 0);
+	assert_int_equal(cpu->gprs[0], BASE_WORKING_RAM);
+	assert_int_equal(cpu->gprs[1], BASE_PALETTE_RAM + 2);
+	assert_int_equal(cpu->gprs[3], 0x170);
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(accuracyProfile) {
+	struct mCore* core = GBACoreCreate();
+	assert_non_null(core);
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	mCoreConfigSetValue(&core->config, "accuracy", "fast");
+	core->reset(core);
+	struct GBA* gba = core->board;
+	assert_int_equal(gba->memory.accuracy, mCORE_ACCURACY_FAST);
+
+	GBAIOWrite(gba, REG_WAITCNT, 0x4000);
+	assert_false(gba->memory.prefetch);
+	GBAMemorySetAccuracy(gba, mCORE_ACCURACY_BALANCED);
+	assert_true(gba->memory.prefetch);
+
+	// Overrides can only make a game more accurate
+	struct GBACartridgeOverride override = {
+		.savetype = SAVEDATA_AUTODETECT,
+		.hardware = HW_NO_OVERRIDE,
+		.idleLoop = IDLE_LOOP_NONE,
+		.accuracy = mCORE_ACCURACY_FAST
+	};
+	GBAOverrideApply(gba, &override);
+	assert_int_equal(gba->memory.accuracy, mCORE_ACCURACY_BALANCED);
+	override.accuracy = mCORE_ACCURACY_ACCURATE;
+	GBAOverrideApply(gba, &override);
+	assert_int_equal(gba->memory.accuracy, mCORE_ACCURACY_ACCURATE);
+
+	// Resetting goes back to the configured profile
+	core->reset(core);
+	assert_int_equal(gba->memory.accuracy, mCORE_ACCURACY_FAST);
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(ioWrite32) {
+	static const uint32_t writes[][2] = {
+		{ REG_BG2X_LO, 0x0FEDCBA9 },
+		{ REG_BLDCNT, 0x10083F41 },
+		{ REG_DMA1CNT_LO, 0xB6400004 },
+		{ REG_DMA3CNT_LO, 0x84000010 },
+		{ REG_TM0CNT_LO, 0x00C3FF00 },
+		{ REG_TM2CNT_LO, 0x00841234 },
+	};
+	struct mCore* split = GBACoreCreate();
+	struct mCore* whole = GBACoreCreate();
+	assert_true(split->init(split));
+	assert_true(whole->init(whole));
+	mCoreInitConfig(split, NULL);
+	mCoreInitConfig(whole, NULL);
+	split->reset(split);
+	whole->reset(whole);
+	struct GBA* splitGba = split->board;
+	struct GBA* wholeGba = whole->board;
+
+	// Writing a pair at once has to look the same as writing each half
+	size_t i;
+	for (i = 0; i < sizeof(writes) / sizeof(*writes); ++i) {
+		GBAIOWrite(splitGba, writes[i][0], writes[i][1]);
+		GBAIOWrite(splitGba, writes[i][0] | 2, writes[i][1] >> 16);
+		GBAIOWrite32(wholeGba, writes[i][0], writes[i][1]);
+	}
+	assert_memory_equal(splitGba->memory.io, wholeGba->memory.io, sizeof(splitGba->memory.io));
+	assert_memory_equal(splitGba->memory.dma, wholeGba->memory.dma, sizeof(splitGba->memory.dma));
+	assert_int_equal(splitGba->timers[0].reload, wholeGba->timers[0].reload);
+	assert_int_equal(splitGba->timers[2].flags, wholeGba->timers[2].flags);
+
+	mCoreConfigDeinit(&split->config);
+	mCoreConfigDeinit(&whole->config);
+	split->deinit(split);
+	whole->deinit(whole);
+}
+
+M_TEST_DEFINE(mergedHblank) {
+	struct mCore* core = GBACoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+	core->runFrame(core);
+	struct GBA* gba = core->board;
+
+	// Nothing happens during VBlank HBlanks unless something asks for it
+	assert_int_equal(gba->video.vcount, GBA_VIDEO_VERTICAL_PIXELS);
+	assert_true(gba->video.mergedHblank);
+	int32_t until = mTimingUntil(&gba->timing, &gba->video.event);
+	assert_false(GBARegisterDISPSTATIsInHblank(GBAIORead(gba, REG_DISPSTAT)));
+	gba->cpu->cycles += until - VIDEO_HBLANK_LENGTH + 1;
+	assert_true(GBARegisterDISPSTATIsInHblank(GBAIORead(gba, REG_DISPSTAT)));
+
+	struct GBASerializedState* saved = malloc(sizeof(*saved));
+	GBASerialize(gba, saved);
+	uint16_t dispstat;
+	LOAD_16(dispstat, REG_DISPSTAT, saved->io);
+	assert_true(GBARegisterDISPSTATIsInHblank(dispstat));
+
+	// Enabling the HBlank IRQ before HBlank brings the event back in time for it
+	gba->cpu->cycles -= 11;
+	GBASerialize(gba, saved);
+	int32_t nextEvent;
+	LOAD_32(nextEvent, 0, &saved->video.nextEvent);
+	assert_int_equal(nextEvent, 10);
+	GBAIOWrite(gba, REG_DISPSTAT, GBARegisterDISPSTATFillHblankIRQ(0));
+	assert_false(gba->video.mergedHblank);
+	assert_int_equal(mTimingUntil(&gba->timing, &gba->video.event), 10);
+	assert_false(GBARegisterDISPSTATIsInHblank(GBAIORead(gba, REG_DISPSTAT)));
+
+	free(saved);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(cascadedTimers) {
+	struct mCore* core = GBACoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+	struct GBA* gba = core->board;
+
+	GBAIOWrite(gba, REG_TM0CNT_LO, 0xFFF0);
+	GBAIOWrite(gba, REG_TM1CNT_LO, 0);
+	GBAIOWrite(gba, REG_TM1CNT_HI, 0x0084);
+	GBAIOWrite(gba, REG_TM0CNT_HI, 0x0080);
+
+	// Nothing needs to hear about the overflows yet, so neither timer ticks on its own
+	assert_false(mTimingIsScheduled(&gba->timing, &gba->timers[1].event));
+	assert_true(mTimingUntil(&gba->timing, &gba->timers[0].event) > 0x10000);
+
+	// Reads take two cycles to land
+	gba->cpu->cycles += 0x10 * 100 + 7;
+	assert_int_equal(GBAIORead(gba, REG_TM0CNT_LO), 0xFFF5);
+	assert_int_equal(GBAIORead(gba, REG_TM1CNT_LO), 100);
+
+	// Asking for an IRQ schedules exactly the parent overflow that carries it
+	GBAIOWrite(gba, REG_TM1CNT_HI, 0x00C4);
+	int32_t until = mTimingUntil(&gba->timing, &gba->timers[1].event);
+	assert_int_equal(until, 9 + (0x10000 - 100 - 1) * 0x10);
+	assert_false(mTimingIsScheduled(&gba->timing, &gba->timers[0].event) && mTimingUntil(&gba->timing, &gba->timers[0].event) < until);
+
+	gba->cpu->cycles += until;
+	gba->cpu->irqh.processEvents(gba->cpu);
+	assert_true(gba->memory.io[REG_IF >> 1] & (1 << IRQ_TIMER1));
+	assert_int_equal(GBAIORead(gba, REG_TM1CNT_LO), 0);
+	assert_int_equal(mTimingUntil(&gba->timing, &gba->timers[1].event), 0x10000 * 0x10);
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+static void _runDMA3(struct GBA* gba, uint32_t source, uint32_t dest, uint16_t count) {
+	GBAIOWrite32(gba, REG_DMA3SAD_LO, source);
+	GBAIOWrite32(gba, REG_DMA3DAD_LO, dest);
+	GBAIOWrite(gba, REG_DMA3CNT_LO, count);
+	GBAIOWrite(gba, REG_DMA3CNT_HI, 0x8000);
+	int i;
+	for (i = 0; i < 0x1000 && GBADMARegisterIsEnable(gba->memory.dma[3].reg); ++i) {
+		gba->cpu->cycles += 4;
+		gba->cpu->irqh.processEvents(gba->cpu);
+	}
+	assert_false(GBADMARegisterIsEnable(gba->memory.dma[3].reg));
+}
+
+M_TEST_DEFINE(eepromDMA) {
+	struct mCore* core = GBACoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+	struct GBA* gba = core->board;
+	GBASavedataForceType(&gba->memory.savedata, SAVEDATA_EEPROM512);
+
+	static const uint8_t block[8] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0 };
+	uint16_t* bits = (uint16_t*) gba->memory.iwram;
+	int i;
+	bits[0] = 1;
+	bits[1] = 0;
+	for (i = 0; i < 6; ++i) {
+		bits[2 + i] = (3 >> (5 - i)) & 1;
+	}
+	for (i = 0; i < 64; ++i) {
+		bits[8 + i] = (block[i >> 3] >> (7 - (i & 7))) & 1;
+	}
+	bits[72] = 0;
+	_runDMA3(gba, BASE_WORKING_IRAM, 0x0D000000, 73);
+	assert_memory_equal(&gba->memory.savedata.data[3 * 8], block, sizeof(block));
+
+	// The write settles from when its last bit went in
+	assert_true(mTimingIsScheduled(&gba->timing, &gba->memory.savedata.dust));
+	assert_in_range(mTimingUntil(&gba->timing, &gba->memory.savedata.dust), 115000 - 0x100, 115000);
+
+	bits[1] = 1;
+	bits[8] = 0;
+	_runDMA3(gba, BASE_WORKING_IRAM, 0x0D000000, 9);
+	_runDMA3(gba, 0x0D000000, BASE_WORKING_IRAM | 0x200, 68);
+	for (i = 0; i < 64; ++i) {
+		assert_int_equal(bits[0x104 + i], (block[i >> 3] >> (7 - (i & 7))) & 1);
+	}
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+M_TEST_DEFINE(multipleTransfer) {
+	struct mCore* core = GBACoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	core->reset(core);
+	struct GBA* gba = core->board;
+	struct ARMCore* cpu = gba->cpu;
+	int mask = 0x0F0F;
+	int i;
+	for (i = 0; i < 16; ++i) {
+		if (mask & (1 << i)) {
+			cpu->gprs[i] = 0x11111111 * (i + 1);
+		}
+	}
+
+	// The block inside one mirror goes through the host copy, the one straddling it goes word by word
+	int blockCycles = 0;
+	int splitCycles = 0;
+	uint32_t end = cpu->memory.storeMultiple(cpu, BASE_WORKING_RAM | 0x100, mask, LSM_IA, &blockCycles);
+	assert_int_equal(end, BASE_WORKING_RAM | 0x120);
+	cpu->memory.storeMultiple(cpu, BASE_WORKING_RAM | (SIZE_WORKING_RAM - 0x10), mask, LSM_IA, &splitCycles);
+	assert_int_equal(blockCycles, splitCycles);
+	assert_memory_equal(&gba->memory.wram[(SIZE_WORKING_RAM - 0x10) >> 2], &gba->memory.wram[0x100 >> 2], 0x10);
+	assert_memory_equal(gba->memory.wram, &gba->memory.wram[0x110 >> 2], 0x10);
+	assert_int_equal(gba->memory.wram[0x100 >> 2], 0x11111111);
+	assert_int_equal(gba->memory.wram[0x11C >> 2], 0xCCCCCCCC);
+
+	memset(cpu->gprs, 0, sizeof(cpu->gprs[0]) * 12);
+	blockCycles = 0;
+	splitCycles = 0;
+	cpu->memory.loadMultiple(cpu, BASE_WORKING_RAM | 0x100, mask, LSM_IA, &blockCycles);
+	assert_int_equal((uint32_t) cpu->gprs[3], 0x44444444);
+	assert_int_equal((uint32_t) cpu->gprs[8], 0x99999999);
+	cpu->memory.loadMultiple(cpu, BASE_WORKING_RAM | (SIZE_WORKING_RAM - 0x10), mask, LSM_IA, &splitCycles);
+	assert_int_equal(blockCycles, splitCycles);
+	assert_int_equal((uint32_t) cpu->gprs[11], 0xCCCCCCCC);
+
+	// IWRAM has no waitstates either way
+	blockCycles = 0;
+	cpu->memory.storeMultiple(cpu, BASE_WORKING_IRAM | 0x40, mask, LSM_IA, &blockCycles);
+	splitCycles = 0;
+	cpu->memory.storeMultiple(cpu, BASE_WORKING_IRAM | (SIZE_WORKING_IRAM - 0x10), mask, LSM_IA, &splitCycles);
+	assert_int_equal(blockCycles, splitCycles);
+	assert_memory_equal(&gba->memory.iwram[0x40 >> 2], &gba->memory.iwram[(SIZE_WORKING_IRAM - 0x10) >> 2], 0x10);
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
 M_TEST_SUITE_DEFINE(GBACore,
 	cmocka_unit_test(create),
 	cmocka_unit_test(platform),
 	cmocka_unit_test(reset),
-	cmocka_unit_test(loadNullROM))
+	cmocka_unit_test(loadNullROM),
+	cmocka_unit_test(videoFrameChanged),
+	cmocka_unit_test(tileCache),
+	cmocka_unit_test(windowSpans),
+	cmocka_unit_test(variantPalettes),
+	cmocka_unit_test(quickSave),
+	cmocka_unit_test(stateSaverAsync),
+	cmocka_unit_test(stateThumbnail),
+	cmocka_unit_test(stateCompression),
+	cmocka_unit_test(rewindKeyframes),
+	cmocka_unit_test(rewindPlayback),
+	cmocka_unit_test(collectDirtyState),
+	cmocka_unit_test(copyState),
+	cmocka_unit_test(stateRegions),
+	cmocka_unit_test(stateHash),
+	cmocka_unit_test(biosDecompress),
+	cmocka_unit_test(biosCpuSet),
+	cmocka_unit_test(accuracyProfile),
+	cmocka_unit_test(ioWrite32),
+	cmocka_unit_test(mergedHblank),
+	cmocka_unit_test(cascadedTimers),
+	cmocka_unit_test(eepromDMA),
+	cmocka_unit_test(multipleTransfer))
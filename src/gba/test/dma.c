@@ -0,0 +1,167 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/gba/core.h>
+#include <mgba/internal/arm/arm.h>
+#include <mgba/internal/gba/gba.h>
+#include <mgba/internal/gba/io.h>
+#include <mgba-util/vfs.h>
+
+#define TEST_SEEDS 32
+#define TEST_FRAMES 2
+#define TEST_PARAMS (BASE_WORKING_IRAM + 0x7000)
+#define TEST_IRQ_LOG (BASE_WORKING_RAM + 0x4000)
+
+// Restarts an immediate DMA3 over and over while timer 0 raises an IRQ every few hundred cycles.
+// The loop and the IRQ handler both log TM0CNT_L to EWRAM, so the CPU resuming even a cycle later
+// changes the logs. Everything else comes from TEST_PARAMS: the IRQ log pointer, the timer reload,
+// then the DMA source, destination and control, and WAITCNT
+static const uint32_t _rom[] = {
+	0xE3A00301, // mov r0, #0x04000000
+	0xE28F105C, // adr r1, handler
+	0xE5001004, // str r1, [r0, #-4]
+	0xE3A02403, // mov r2, #0x03000000
+	0xE2822A07, // add r2, r2, #0x7000
+	0xE1D210B4, // ldrh r1, [r2, #4]
+	0xE3811503, // orr r1, r1, #0x00C00000
+	0xE5801100, // str r1, [r0, #0x100]
+	0xE3A01008, // mov r1, #8
+	0xE5801200, // str r1, [r0, #0x200]
+	0xE3A01001, // mov r1, #1
+	0xE5801208, // str r1, [r0, #0x208]
+	0xE3A04402, // mov r4, #0x02000000
+	0xE5925008, // ldr r5, [r2, #8]
+	0xE592600C, // ldr r6, [r2, #12]
+	0xE5927010, // ldr r7, [r2, #16]
+	0xE5921014, // ldr r1, [r2, #20]
+	0xE2803C02, // add r3, r0, #0x200
+	0xE1C310B4, // strh r1, [r3, #4]
+	0xE58050D4, // loop: str r5, [r0, #0xD4]
+	0xE58060D8, // str r6, [r0, #0xD8]
+	0xE58070DC, // str r7, [r0, #0xDC]
+	0xE5901100, // ldr r1, [r0, #0x100]
+	0xE0C410B2, // strh r1, [r4], #2
+	0xE3C44901, // bic r4, r4, #0x4000
+	0xEAFFFFF8, // b loop
+	0xE5901100, // handler: ldr r1, [r0, #0x100]
+	0xE3A02403, // mov r2, #0x03000000
+	0xE2822A07, // add r2, r2, #0x7000
+	0xE5923000, // ldr r3, [r2]
+	0xE0C310B2, // strh r1, [r3], #2
+	0xE3C33A01, // bic r3, r3, #0x1000
+	0xE5823000, // str r3, [r2]
+	0xE3A01008, // mov r1, #8
+	0xE2802C02, // add r2, r0, #0x200
+	0xE1C210B2, // strh r1, [r2, #2]
+	0xE12FFF1E, // bx lr
+};
+
+enum TestMode {
+	TEST_DEFAULT,
+	// Any handler but the stock one keeps DMAs going a unit at a time
+	TEST_UNIT_DMA,
+	// Enabling the HBlank IRQ in DISPSTAT but not IE keeps HBlank its own event on every line
+	TEST_SPLIT_HBLANK,
+};
+
+
+static uint32_t _unitLoad16(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
+	return GBALoad16(cpu, address, cycleCounter);
+}
+
+static uint32_t _unitLoad32(struct ARMCore* cpu, uint32_t address, int* cycleCounter) {
+	return GBALoad32(cpu, address, cycleCounter);
+}
+
+static struct mCore* _run(uint32_t seed, enum TestMode mode, int frames) {
+	static const uint32_t sources[] = {
+		BASE_WORKING_IRAM, BASE_WORKING_RAM + 0x20000, BASE_PALETTE_RAM, BASE_VRAM + 0x8000, BASE_CART0
+	};
+	static const uint32_t dests[] = {
+		BASE_WORKING_RAM + 0x10000, BASE_WORKING_RAM + 0x10002, BASE_WORKING_IRAM + 0x1000, BASE_PALETTE_RAM + 0x100, BASE_VRAM, BASE_OAM
+	};
+	struct mCore* core = GBACoreCreate();
+	assert_true(core->init(core));
+	mCoreInitConfig(core, NULL);
+	struct VFile* vf = VFileMemChunk(_rom, sizeof(_rom));
+	vf->truncate(vf, 0x1000);
+	assert_true(core->loadROM(core, vf));
+	core->reset(core);
+	GBASkipBIOS(core->board);
+
+	seed = seed * 1103515245 + 12345;
+	core->busWrite32(core, TEST_PARAMS, TEST_IRQ_LOG);
+	core->busWrite16(core, TEST_PARAMS + 4, 0xFE00 | ((seed >> 16) & 0x1FF));
+	seed = seed * 1103515245 + 12345;
+	core->busWrite32(core, TEST_PARAMS + 8, sources[(seed >> 16) % (sizeof(sources) / sizeof(*sources))]);
+	core->busWrite32(core, TEST_PARAMS + 12, dests[(seed >> 8) % (sizeof(dests) / sizeof(*dests))]);
+	seed = seed * 1103515245 + 12345;
+	core->busWrite32(core, TEST_PARAMS + 16, 0x80000000 | ((seed >> 12) & 0x04000000) | (2 + (seed >> 16) % 100));
+	seed = seed * 1103515245 + 12345;
+	core->busWrite32(core, TEST_PARAMS + 20, (seed >> 16) & 0x5FFF);
+
+	if (mode == TEST_UNIT_DMA) {
+		struct ARMCore* cpu = core->cpu;
+		cpu->memory.load16 = _unitLoad16;
+		cpu->memory.load32 = _unitLoad32;
+	} else if (mode == TEST_SPLIT_HBLANK) {
+		core->busWrite16(core, BASE_IO | REG_DISPSTAT, 0x10);
+	}
+	int i;
+	for (i = 0; i < frames; ++i) {
+		core->runFrame(core);
+	}
+	return core;
+}
+
+M_TEST_DEFINE(batchTiming) {
+	uint32_t seed;
+	for (seed = 0; seed < TEST_SEEDS; ++seed) {
+		struct mCore* batched = _run(seed, TEST_DEFAULT, TEST_FRAMES);
+		struct mCore* unit = _run(seed, TEST_UNIT_DMA, TEST_FRAMES);
+		struct GBA* gba = batched->board;
+		struct GBA* reference = unit->board;
+
+		// The IRQ has to have landed during DMAs for this to prove anything
+		assert_int_not_equal(batched->busRead32(batched, TEST_PARAMS), TEST_IRQ_LOG);
+		assert_int_equal(gba->timing.masterCycles, reference->timing.masterCycles);
+		assert_memory_equal(gba->memory.wram, reference->memory.wram, SIZE_WORKING_RAM);
+		assert_memory_equal(gba->memory.iwram, reference->memory.iwram, SIZE_WORKING_IRAM);
+		assert_int_equal(batched->stateHash(batched), unit->stateHash(unit));
+
+		mCoreConfigDeinit(&batched->config);
+		batched->deinit(batched);
+		mCoreConfigDeinit(&unit->config);
+		unit->deinit(unit);
+	}
+}
+
+M_TEST_DEFINE(mergedHblankTiming) {
+	uint32_t seed;
+	for (seed = 0; seed < TEST_SEEDS; ++seed) {
+		struct mCore* merged = _run(seed, TEST_DEFAULT, TEST_FRAMES * 2);
+		struct mCore* split = _run(seed, TEST_SPLIT_HBLANK, TEST_FRAMES * 2);
+		struct GBA* gba = merged->board;
+		struct GBA* reference = split->board;
+
+		// IRQs entered during VBlank, where the HBlank event is merged, must not move the video timeline.
+		// The state hashes differ, since the split run has a different DISPSTAT and HBlank IRQs pending in IF
+		assert_int_equal(gba->timing.masterCycles, reference->timing.masterCycles);
+		assert_memory_equal(gba->memory.wram, reference->memory.wram, SIZE_WORKING_RAM);
+		assert_memory_equal(gba->memory.iwram, reference->memory.iwram, SIZE_WORKING_IRAM);
+
+		mCoreConfigDeinit(&merged->config);
+		merged->deinit(merged);
+		mCoreConfigDeinit(&split->config);
+		split->deinit(split);
+	}
+}
+
+M_TEST_SUITE_DEFINE(GBADMA,
+	cmocka_unit_test(batchTiming),
+	cmocka_unit_test(mergedHblankTiming))
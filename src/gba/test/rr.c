@@ -0,0 +1,148 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/gba/core.h>
+#include <mgba/internal/gba/gba.h>
+#include <mgba/internal/gba/io.h>
+#include <mgba/internal/gba/rr/cmv.h>
+#include <mgba-util/vfs.h>
+
+#define FRAMES 10
+
+static const uint16_t _keys[FRAMES] = { 0x001, 0x001, 0x001, 0x000, 0x040, 0x040, 0x000, 0x000, 0x208, 0x208 };
+static const bool _lag[FRAMES] = { false, false, true, false, false, false, true, true, false, false };
+
+struct GBARRTest {
+	struct mCore* core;
+	struct GBACMVContext cmv;
+	struct VFile* vf;
+};
+
+M_TEST_SUITE_SETUP(GBARR) {
+	struct GBARRTest* test = malloc(sizeof(*test));
+	test->core = GBACoreCreate();
+	test->core->init(test->core);
+	mCoreInitConfig(test->core, NULL);
+	test->core->reset(test->core);
+	test->vf = VFileMemChunk(NULL, 0);
+	GBACMVContextCreate(&test->cmv, test->core->board);
+	test->cmv.keyframeInterval = 4;
+	GBACMVSetStream(&test->cmv, test->vf);
+	((struct GBA*) test->core->board)->rr = &test->cmv.d;
+	*state = test;
+	return 0;
+}
+
+M_TEST_SUITE_TEARDOWN(GBARR) {
+	struct GBARRTest* test = *state;
+	((struct GBA*) test->core->board)->rr = NULL;
+	GBARRDestroy(&test->cmv.d);
+	mCoreConfigDeinit(&test->core->config);
+	test->core->deinit(test->core);
+	free(test);
+	return 0;
+}
+
+static void _record(struct GBARRTest* test, uint64_t* hashes) {
+	struct mCore* core = test->core;
+	struct GBARRContext* rr = &test->cmv.d;
+	assert_true(rr->startRecording(rr));
+	hashes[0] = core->stateHash(core);
+	int i;
+	for (i = 0; i < FRAMES; ++i) {
+		core->setKeys(core, _keys[i]);
+		if (!_lag[i]) {
+			core->busRead16(core, BASE_IO | REG_KEYINPUT);
+		}
+		core->runFrame(core);
+		hashes[i + 1] = core->stateHash(core);
+	}
+	rr->stopRecording(rr);
+	assert_int_equal(rr->frames, FRAMES);
+	assert_int_equal(rr->lagFrames, 3);
+}
+
+M_TEST_DEFINE(recordAndPlay) {
+	struct GBARRTest* test = *state;
+	struct mCore* core = test->core;
+	struct GBARRContext* rr = &test->cmv.d;
+	uint64_t hashes[FRAMES + 1];
+	_record(test, hashes);
+
+	core->runFrame(core);
+	core->reset(core);
+	assert_true(rr->startPlaying(rr, false));
+	assert_int_equal(core->stateHash(core), hashes[0]);
+	core->setKeys(core, 0);
+	int i;
+	for (i = 0; i < FRAMES; ++i) {
+		if (!_lag[i]) {
+			assert_int_equal(core->busRead16(core, BASE_IO | REG_KEYINPUT), 0x3FF ^ _keys[i]);
+		}
+		core->runFrame(core);
+		assert_int_equal(core->stateHash(core), hashes[i + 1]);
+	}
+	assert_false(rr->isPlaying(rr));
+}
+
+M_TEST_DEFINE(seek) {
+	struct GBARRTest* test = *state;
+	struct mCore* core = test->core;
+	struct GBARRContext* rr = &test->cmv.d;
+	uint64_t hashes[FRAMES + 1];
+	_record(test, hashes);
+
+	assert_true(rr->startPlaying(rr, false));
+	// Keyframes are taken as the frame ends, so the state only lines up again after the next one
+	assert_int_equal(GBACMVSeek(&test->cmv, 7), 4);
+	assert_int_equal(rr->frames, 4);
+	int i;
+	for (i = 4; i < FRAMES; ++i) {
+		if (!_lag[i]) {
+			assert_int_equal(core->busRead16(core, BASE_IO | REG_KEYINPUT), 0x3FF ^ _keys[i]);
+		}
+		core->runFrame(core);
+		assert_int_equal(core->stateHash(core), hashes[i + 1]);
+	}
+	assert_int_equal(GBACMVSeek(&test->cmv, 1), -1);
+}
+
+M_TEST_DEFINE(truncated) {
+	struct GBARRTest* test = *state;
+	struct mCore* core = test->core;
+	struct GBARRContext* rr = &test->cmv.d;
+	uint64_t hashes[FRAMES + 1];
+	_record(test, hashes);
+
+	// Drop the index, as if recording had been cut short
+	uint32_t endOffset;
+	test->vf->seek(test->vf, -8, SEEK_END);
+	test->vf->read(test->vf, &endOffset, sizeof(endOffset));
+	test->vf->truncate(test->vf, endOffset);
+	struct VFile* vf = VFileMemChunk(NULL, 0);
+	void* data = test->vf->map(test->vf, endOffset, MAP_READ);
+	vf->write(vf, data, endOffset);
+	test->vf->unmap(test->vf, data, endOffset);
+	assert_true(GBACMVSetStream(&test->cmv, vf));
+	test->vf = vf;
+
+	assert_true(rr->startPlaying(rr, false));
+	assert_int_equal(GBACMVSeek(&test->cmv, 9), 8);
+	int i;
+	for (i = 8; i < FRAMES; ++i) {
+		assert_int_equal(core->busRead16(core, BASE_IO | REG_KEYINPUT), 0x3FF ^ _keys[i]);
+		core->runFrame(core);
+		assert_int_equal(core->stateHash(core), hashes[i + 1]);
+	}
+	assert_false(rr->isPlaying(rr));
+}
+
+M_TEST_SUITE_DEFINE_SETUP_TEARDOWN(GBARR,
+	cmocka_unit_test(recordAndPlay),
+	cmocka_unit_test(seek),
+	cmocka_unit_test(truncated))
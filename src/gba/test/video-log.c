@@ -0,0 +1,171 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba/core/core.h>
+#include <mgba/feature/video-logger.h>
+#include <mgba/gba/core.h>
+#include <mgba/internal/gba/gba.h>
+#include <mgba-util/crc32.h>
+#include <mgba-util/vfs.h>
+
+#define TEST_FRAMES 100
+#define TEST_KEYFRAME_INTERVAL 16
+
+// Turns the screen on and keeps changing the backdrop color, so every scanline of every frame differs
+static const uint32_t _rom[] = {
+	0xE3A00301, // mov r0, #0x04000000
+	0xE3A01000, // mov r1, #0
+	0xE1C010B0, // strh r1, [r0]
+	0xE3A00405, // mov r0, #0x05000000
+	0xE1C010B0, // loop: strh r1, [r0]
+	0xE2811001, // add r1, r1, #1
+	0xEAFFFFFC, // b loop
+};
+
+static color_t _buffer[GBA_VIDEO_HORIZONTAL_PIXELS * GBA_VIDEO_VERTICAL_PIXELS];
+
+static struct VFile* _record(uint32_t keyframeInterval) {
+	struct mCore* core = GBACoreCreate();
+	core->init(core);
+	core->setVideoBuffer(core, _buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	mCoreInitConfig(core, NULL);
+	assert_true(core->loadROM(core, VFileFromConstMemory(_rom, sizeof(_rom))));
+	core->reset(core);
+	GBASkipBIOS(core->board);
+
+	struct VFile* vf = VFileMemChunk(NULL, 0);
+	struct mVideoLogContext* context = mVideoLogContextCreate(core);
+	mVideoLogContextSetOutput(context, vf);
+	mVideoLogContextSetKeyframeInterval(context, keyframeInterval);
+	mVideoLogContextWriteHeader(context, core);
+	int i;
+	for (i = 0; i < TEST_FRAMES; ++i) {
+		core->runFrame(core);
+	}
+	mVideoLogContextDestroy(core, context);
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+	return vf;
+}
+
+static struct mCore* _play(struct VFile* vf) {
+	struct mCore* core = mVideoLogCoreFind(vf);
+	assert_non_null(core);
+	core->init(core);
+	core->setVideoBuffer(core, _buffer, GBA_VIDEO_HORIZONTAL_PIXELS);
+	mCoreInitConfig(core, NULL);
+	assert_true(core->loadROM(core, vf));
+	core->reset(core);
+	return core;
+}
+
+static void _stop(struct mCore* core) {
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+}
+
+static uint32_t _frameCrc(void) {
+	return doCrc32(_buffer, sizeof(_buffer));
+}
+
+M_TEST_DEFINE(seekKeyframes) {
+	struct VFile* vf = _record(TEST_KEYFRAME_INTERVAL);
+	struct mCore* core = _play(vf);
+	uint32_t crcs[TEST_FRAMES];
+	int i;
+	for (i = 0; i < TEST_FRAMES; ++i) {
+		core->runFrame(core);
+		crcs[i] = _frameCrc();
+		if (i) {
+			assert_int_not_equal(crcs[i], crcs[i - 1]);
+		}
+	}
+
+	static const uint32_t targets[] = { 50, 5, 16, 17, 99, 33, 1000 };
+	for (i = 0; i < (int) (sizeof(targets) / sizeof(*targets)); ++i) {
+		uint32_t target = targets[i];
+		uint32_t keyframe = core->seekVideoLog(core, target);
+		// The first playback frame shows the initial state, so keyframes land one frame after a multiple of the interval
+		uint32_t expected = 0;
+		if (target > TEST_KEYFRAME_INTERVAL) {
+			expected = (target - 1) - (target - 1) % TEST_KEYFRAME_INTERVAL + 1;
+		}
+		if (expected > TEST_FRAMES) {
+			expected = TEST_FRAMES - TEST_FRAMES % TEST_KEYFRAME_INTERVAL + 1;
+		}
+		assert_int_equal(keyframe, expected);
+		if (target >= TEST_FRAMES) {
+			continue;
+		}
+		for (; keyframe <= target; ++keyframe) {
+			core->runFrame(core);
+		}
+		assert_int_equal(_frameCrc(), crcs[target]);
+	}
+	_stop(core);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(seekWithoutKeyframes) {
+	struct VFile* vf = _record(0);
+	struct mCore* core = _play(vf);
+	uint32_t crcs[TEST_FRAMES];
+	int i;
+	for (i = 0; i < TEST_FRAMES; ++i) {
+		core->runFrame(core);
+		crcs[i] = _frameCrc();
+	}
+
+	// Only the start of the log is left to seek to
+	assert_int_equal(core->seekVideoLog(core, 60), 0);
+	for (i = 0; i <= 60; ++i) {
+		core->runFrame(core);
+	}
+	assert_int_equal(_frameCrc(), crcs[60]);
+	_stop(core);
+	vf->close(vf);
+}
+
+static uint64_t _fakeClock(void) {
+	static uint64_t ticks = 0;
+	return ++ticks;
+}
+
+M_TEST_DEFINE(scanlineStats) {
+	struct VFile* vf = _record(0);
+	struct mCore* core = _play(vf);
+	struct mVideoLoggerStats stats;
+	mVideoLoggerEnableStats(core->videoLogger, &stats, _fakeClock);
+	int i;
+	for (i = 0; i < 10; ++i) {
+		core->runFrame(core);
+	}
+	mVideoLoggerDisableStats(core->videoLogger);
+	core->runFrame(core);
+
+	// Every visible scanline was timed once per frame, and nothing past them; the log starts partway into a frame
+	assert_true(stats.linesByY[0] >= 8);
+	uint64_t lines = 0;
+	for (i = 0; i < mVL_STATS_MAX_LINES; ++i) {
+		if (i < GBA_VIDEO_VERTICAL_PIXELS) {
+			assert_true(stats.linesByY[i] - stats.linesByY[0] <= 1);
+		} else {
+			assert_int_equal(stats.linesByY[i], 0);
+		}
+		lines += stats.linesByY[i];
+	}
+	assert_int_equal(stats.lines, lines);
+	assert_true(stats.lineTime >= stats.lines);
+	assert_true(stats.maxLineTime >= 1);
+	_stop(core);
+	vf->close(vf);
+}
+
+M_TEST_SUITE_DEFINE(GBAVideoLog,
+	cmocka_unit_test(seekKeyframes),
+	cmocka_unit_test(seekWithoutKeyframes),
+	cmocka_unit_test(scanlineStats))
@@ -10,39 +10,177 @@
 
 #define REG_TMCNT_LO(X) (REG_TM0CNT_LO + ((X) << 2))
 
-static void GBATimerUpdate(struct GBA* gba, int timerId, uint32_t cyclesLate) {
-	struct GBATimer* timer = &gba->timers[timerId];
-	if (GBATimerFlagsIsCountUp(timer->flags)) {
-		gba->memory.io[REG_TMCNT_LO(timerId) >> 1] = timer->reload;
-	} else {
-		GBATimerUpdateRegister(gba, timerId, cyclesLate);
+// Timers are only synced when something looks at them; events are kept for overflows that
+// raise an IRQ or feed a FIFO, plus one every so often so the cycle deltas can't wrap
+#define TIMER_MAX_WAIT 0x20000000
+#define TIMER_NEVER -1
+
+static int _timerBase(const struct GBA* gba, int timerId) {
+	while (timerId > 0 && GBATimerFlagsIsCountUp(gba->timers[timerId].flags)) {
+		--timerId;
 	}
+	return timerId;
+}
 
+static bool _timerHasEffects(const struct GBA* gba, int timerId) {
+	const struct GBATimer* timer = &gba->timers[timerId];
+	if (!GBATimerFlagsIsEnable(timer->flags)) {
+		return false;
+	}
 	if (GBATimerFlagsIsDoIrq(timer->flags)) {
-		GBARaiseIRQ(gba, IRQ_TIMER0 + timerId, cyclesLate);
+		return true;
 	}
-
 	if (gba->audio.enable && timerId < 2) {
 		if ((gba->audio.chALeft || gba->audio.chARight) && gba->audio.chATimer == timerId) {
-			GBAAudioSampleFIFO(&gba->audio, 0, cyclesLate);
+			return true;
 		}
-
 		if ((gba->audio.chBLeft || gba->audio.chBRight) && gba->audio.chBTimer == timerId) {
-			GBAAudioSampleFIFO(&gba->audio, 1, cyclesLate);
+			return true;
 		}
 	}
+	return false;
+}
+
+static uint64_t _timerCount(uint16_t* value, uint16_t reload, uint64_t ticks) {
+	uint64_t next = *value + ticks;
+	if (next < 0x10000) {
+		*value = next;
+		return 0;
+	}
+	uint32_t period = 0x10000 - reload;
+	next -= 0x10000;
+	*value = reload + next % period;
+	return 1 + next / period;
+}
+
+static void _timerOverflow(struct GBA* gba, int timerId, uint64_t overflows, uint32_t cyclesLate) {
+	struct GBATimer* timer = &gba->timers[timerId];
+	if (GBATimerFlagsIsDoIrq(timer->flags)) {
+		GBARaiseIRQ(gba, IRQ_TIMER0 + timerId, cyclesLate);
+	}
+
+	if (gba->audio.enable && timerId < 2) {
+		for (; overflows; --overflows) {
+			if ((gba->audio.chALeft || gba->audio.chARight) && gba->audio.chATimer == timerId) {
+				GBAAudioSampleFIFO(&gba->audio, 0, cyclesLate);
+			}
 
-	if (timerId < 3) {
-		struct GBATimer* nextTimer = &gba->timers[timerId + 1];
-		if (GBATimerFlagsIsCountUp(nextTimer->flags)) { // TODO: Does this increment while disabled?
-			++gba->memory.io[REG_TMCNT_LO(timerId + 1) >> 1];
-			if (!gba->memory.io[REG_TMCNT_LO(timerId + 1) >> 1] && GBATimerFlagsIsEnable(nextTimer->flags)) {
-				GBATimerUpdate(gba, timerId + 1, cyclesLate);
+			if ((gba->audio.chBLeft || gba->audio.chBRight) && gba->audio.chBTimer == timerId) {
+				GBAAudioSampleFIFO(&gba->audio, 1, cyclesLate);
 			}
 		}
 	}
 }
 
+// Brings a base timer and the count-up timers chained off it up to currentTime
+static void _timerSync(struct GBA* gba, int timerId, int32_t currentTime, uint32_t cyclesLate, bool effects) {
+	struct GBATimer* timer = &gba->timers[timerId];
+	if (!GBATimerFlagsIsEnable(timer->flags)) {
+		return;
+	}
+
+	// Align timer
+	int prescaleBits = GBATimerFlagsGetPrescaleBits(timer->flags);
+	int32_t tickMask = (1 << prescaleBits) - 1;
+	currentTime &= ~tickMask;
+
+	// Update register
+	int32_t tickIncrement = (currentTime - timer->lastEvent) >> prescaleBits;
+	timer->lastEvent = currentTime;
+	uint16_t* value = &gba->memory.io[REG_TMCNT_LO(timerId) >> 1];
+	if (tickIncrement <= 0) {
+		*value += tickIncrement;
+		return;
+	}
+	uint64_t overflows = _timerCount(value, timer->reload, tickIncrement);
+
+	// Pass overflows down the chain
+	while (overflows) {
+		if (effects) {
+			_timerOverflow(gba, timerId, overflows, cyclesLate);
+		}
+		++timerId;
+		if (timerId > 3 || !GBATimerFlagsIsCountUp(gba->timers[timerId].flags)) {
+			break;
+		}
+		timer = &gba->timers[timerId];
+		value = &gba->memory.io[REG_TMCNT_LO(timerId) >> 1];
+		if (!GBATimerFlagsIsEnable(timer->flags)) { // TODO: Does this increment while disabled?
+			*value += overflows;
+			break;
+		}
+		overflows = _timerCount(value, timer->reload, overflows);
+	}
+}
+
+static void _timerSyncAll(struct GBA* gba, uint32_t cyclesLate, bool effects) {
+	int32_t currentTime = mTimingCurrentTime(&gba->timing) - cyclesLate;
+	int i;
+	for (i = 0; i < 4; ++i) {
+		if (!i || !GBATimerFlagsIsCountUp(gba->timers[i].flags)) {
+			_timerSync(gba, i, currentTime, cyclesLate, effects);
+		}
+	}
+}
+
+// Cycles from now until the timer has overflowed this many more times
+static int64_t _timerUntilOverflow(const struct GBA* gba, int timerId, uint64_t overflows) {
+	const struct GBATimer* timer = &gba->timers[timerId];
+	if (!GBATimerFlagsIsEnable(timer->flags)) {
+		return TIMER_NEVER;
+	}
+	if (overflows > (1ULL << 40)) {
+		return INT64_MAX;
+	}
+	uint64_t ticks = 0x10000 - gba->memory.io[REG_TMCNT_LO(timerId) >> 1];
+	ticks += (overflows - 1) * (0x10000 - timer->reload);
+	if (GBATimerFlagsIsCountUp(timer->flags)) {
+		return _timerUntilOverflow(gba, timerId - 1, ticks);
+	}
+	if (ticks > (1ULL << 50)) {
+		return INT64_MAX;
+	}
+	int32_t sinceLastEvent = mTimingCurrentTime(&gba->timing) - timer->lastEvent;
+	return (int64_t) (ticks << GBATimerFlagsGetPrescaleBits(timer->flags)) - sinceLastEvent;
+}
+
+static void _timerSchedule(struct GBA* gba, int timerId) {
+	struct GBATimer* timer = &gba->timers[timerId];
+	int64_t when = TIMER_NEVER;
+	if (_timerHasEffects(gba, timerId)) {
+		when = _timerUntilOverflow(gba, timerId, 1);
+	}
+	if (when == TIMER_NEVER) {
+		if (!GBATimerFlagsIsEnable(timer->flags) || GBATimerFlagsIsCountUp(timer->flags)) {
+			mTimingDeschedule(&gba->timing, &timer->event);
+			return;
+		}
+		when = TIMER_MAX_WAIT;
+	}
+	if (when < 0) {
+		when = 0;
+	} else if (when > TIMER_MAX_WAIT) {
+		when = TIMER_MAX_WAIT;
+	}
+	mTimingDeschedule(&gba->timing, &timer->event);
+	mTimingSchedule(&gba->timing, &timer->event, when);
+}
+
+static void _timerScheduleAll(struct GBA* gba) {
+	int i;
+	for (i = 0; i < 4; ++i) {
+		_timerSchedule(gba, i);
+	}
+}
+
+static void GBATimerUpdate(struct GBA* gba, int timerId, uint32_t cyclesLate) {
+	int base = _timerBase(gba, timerId);
+	_timerSync(gba, base, mTimingCurrentTime(&gba->timing) - cyclesLate, cyclesLate, true);
+	_timerSchedule(gba, base);
+	for (timerId = base + 1; timerId < 4 && GBATimerFlagsIsCountUp(gba->timers[timerId].flags); ++timerId) {
+		_timerSchedule(gba, timerId);
+	}
+}
 static void GBATimerUpdate0(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	UNUSED(timing);
 	GBATimerUpdate(context, 0, cyclesLate);
@@ -84,45 +222,27 @@ void GBATimerInit(struct GBA* gba) {
 }
 
 void GBATimerUpdateRegister(struct GBA* gba, int timer, int32_t cyclesLate) {
-	struct GBATimer* currentTimer = &gba->timers[timer];
-	if (!GBATimerFlagsIsEnable(currentTimer->flags) || GBATimerFlagsIsCountUp(currentTimer->flags)) {
-		return;
-	}
-
-	// Align timer
-	int prescaleBits = GBATimerFlagsGetPrescaleBits(currentTimer->flags);
-	int32_t currentTime = mTimingCurrentTime(&gba->timing) - cyclesLate;
-	int32_t tickMask = (1 << prescaleBits) - 1;
-	currentTime &= ~tickMask;
+	int base = _timerBase(gba, timer);
+	_timerSync(gba, base, mTimingCurrentTime(&gba->timing) - cyclesLate, 0, true);
+}
 
-	// Update register
-	int32_t tickIncrement = currentTime - currentTimer->lastEvent;
-	currentTimer->lastEvent = currentTime;
-	tickIncrement >>= prescaleBits;
-	tickIncrement += gba->memory.io[REG_TMCNT_LO(timer) >> 1];
-	while (tickIncrement >= 0x10000) {
-		tickIncrement -= 0x10000 - currentTimer->reload;
-	}
-	gba->memory.io[REG_TMCNT_LO(timer) >> 1] = tickIncrement;
-
-	// Schedule next update
-	tickIncrement = (0x10000 - tickIncrement) << prescaleBits;
-	currentTime += tickIncrement;
-	currentTime &= ~tickMask;
-	currentTime -= mTimingCurrentTime(&gba->timing);
-	mTimingDeschedule(&gba->timing, &currentTimer->event);
-	mTimingSchedule(&gba->timing, &currentTimer->event, currentTime);
+void GBATimerUpdateEvents(struct GBA* gba) {
+	_timerSyncAll(gba, 0, false);
+	_timerScheduleAll(gba);
 }
 
 void GBATimerWriteTMCNT_LO(struct GBA* gba, int timer, uint16_t reload) {
+	_timerSyncAll(gba, 0, true);
 	gba->timers[timer].reload = reload;
+	_timerScheduleAll(gba);
 }
 
 void GBATimerWriteTMCNT_HI(struct GBA* gba, int timer, uint16_t control) {
 	struct GBATimer* currentTimer = &gba->timers[timer];
-	GBATimerUpdateRegister(gba, timer, 0);
+	_timerSyncAll(gba, 0, true);
 
 	unsigned oldPrescale = GBATimerFlagsGetPrescaleBits(currentTimer->flags);
+	bool wasCountUp = GBATimerFlagsIsCountUp(currentTimer->flags);
 	unsigned prescaleBits;
 	switch (control & 0x0003) {
 	case 0x0000:
@@ -143,18 +263,12 @@ void GBATimerWriteTMCNT_HI(struct GBA* gba, int timer, uint16_t control) {
 	currentTimer->flags = GBATimerFlagsTestFillDoIrq(currentTimer->flags, control & 0x0040);
 	bool wasEnabled = GBATimerFlagsIsEnable(currentTimer->flags);
 	currentTimer->flags = GBATimerFlagsTestFillEnable(currentTimer->flags, control & 0x0080);
+	int32_t tickMask = (1 << prescaleBits) - 1;
 	if (!wasEnabled && GBATimerFlagsIsEnable(currentTimer->flags)) {
-		mTimingDeschedule(&gba->timing, &currentTimer->event);
 		gba->memory.io[REG_TMCNT_LO(timer) >> 1] = currentTimer->reload;
-		int32_t tickMask = (1 << prescaleBits) - 1;
 		currentTimer->lastEvent = mTimingCurrentTime(&gba->timing) & ~tickMask;
-		GBATimerUpdateRegister(gba, timer, 0);
-	} else if (wasEnabled && !GBATimerFlagsIsEnable(currentTimer->flags)) {
-		mTimingDeschedule(&gba->timing, &currentTimer->event);
-	} else if (GBATimerFlagsIsEnable(currentTimer->flags) && GBATimerFlagsGetPrescaleBits(currentTimer->flags) != oldPrescale && !GBATimerFlagsIsCountUp(currentTimer->flags)) {
-		mTimingDeschedule(&gba->timing, &currentTimer->event);
-		int32_t tickMask = (1 << prescaleBits) - 1;
+	} else if (GBATimerFlagsIsEnable(currentTimer->flags) && !GBATimerFlagsIsCountUp(currentTimer->flags) && (GBATimerFlagsGetPrescaleBits(currentTimer->flags) != oldPrescale || wasCountUp)) {
 		currentTimer->lastEvent = mTimingCurrentTime(&gba->timing) & ~tickMask;
-		GBATimerUpdateRegister(gba, timer, 0);
 	}
+	_timerScheduleAll(gba);
 }
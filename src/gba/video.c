@@ -69,7 +69,11 @@ static struct GBAVideoRenderer dummyRenderer = {
 void GBAVideoInit(struct GBAVideo* video) {
 	video->renderer = &dummyRenderer;
 	video->renderer->cache = NULL;
-	video->vram = anonymousMemoryMap(SIZE_VRAM);
+	// VRAM lives in the memory arena, which GBAMemoryInit has already set up
+	video->vram = NULL;
+	if (video->p->memory.arena) {
+		video->vram = (uint16_t*) &video->p->memory.arena[GBA_ARENA_VRAM];
+	}
 	video->frameskip = 0;
 	video->event.name = "GBA Video";
 	video->event.callback = NULL;
@@ -89,6 +93,7 @@ void GBAVideoReset(struct GBAVideo* video) {
 	video->p->memory.io[REG_VCOUNT >> 1] = video->vcount;
 
 	video->event.callback = _startHblank;
+	video->mergedHblank = false;
 	mTimingSchedule(&video->p->timing, &video->event, nextEvent);
 
 	video->frameCounter = 0;
@@ -103,7 +108,7 @@ void GBAVideoReset(struct GBAVideo* video) {
 
 void GBAVideoDeinit(struct GBAVideo* video) {
 	video->renderer->deinit(video->renderer);
-	mappedMemoryFree(video->vram, SIZE_VRAM);
+	video->vram = NULL;
 }
 
 void GBAVideoAssociateRenderer(struct GBAVideo* video, struct GBAVideoRenderer* renderer) {
@@ -116,12 +121,37 @@ void GBAVideoAssociateRenderer(struct GBAVideo* video, struct GBAVideoRenderer*
 	video->renderer->init(video->renderer);
 }
 
+static bool _hblankIsQuiet(const struct GBAVideo* video, GBARegisterDISPSTAT dispstat) {
+	if (GBARegisterDISPSTATIsHblankIRQ(dispstat)) {
+		return false;
+	}
+	if (video->vcount < GBA_VIDEO_VERTICAL_PIXELS && video->frameskipCounter <= 0) {
+		return false;
+	}
+	const struct GBADMA* dma = video->p->memory.dma;
+	int i;
+	for (i = 0; i < 4; ++i) {
+		if (!GBADMARegisterIsEnable(dma[i].reg)) {
+			continue;
+		}
+		if (video->vcount < GBA_VIDEO_VERTICAL_PIXELS && GBADMARegisterGetTiming(dma[i].reg) == GBA_DMA_TIMING_HBLANK) {
+			return false;
+		}
+		if (i == 3 && video->vcount >= 2 && video->vcount < GBA_VIDEO_VERTICAL_PIXELS + 2 && GBADMARegisterGetTiming(dma[i].reg) == GBA_DMA_TIMING_CUSTOM) {
+			return false;
+		}
+	}
+	return true;
+}
+
 void _startHdraw(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	struct GBAVideo* video = context;
 	GBARegisterDISPSTAT dispstat = video->p->memory.io[REG_DISPSTAT >> 1];
 	dispstat = GBARegisterDISPSTATClearInHblank(dispstat);
 	video->event.callback = _startHblank;
+	video->mergedHblank = false;
 	mTimingSchedule(timing, &video->event, VIDEO_HDRAW_LENGTH - cyclesLate);
+	uint32_t hblankWhen = video->event.when;
 
 	++video->vcount;
 	if (video->vcount == VIDEO_VERTICAL_TOTAL_PIXELS) {
@@ -147,7 +177,9 @@ void _startHdraw(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	case GBA_VIDEO_VERTICAL_PIXELS:
 		video->p->memory.io[REG_DISPSTAT >> 1] = GBARegisterDISPSTATFillInVblank(dispstat);
 		if (video->frameskipCounter <= 0) {
+			enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_RENDER_FRAME);
 			video->renderer->finishFrame(video->renderer);
+			mTimingHostLeave(timing, category);
 		}
 		GBADMARunVblank(video->p, -cyclesLate);
 		if (GBARegisterDISPSTATIsVblankIRQ(dispstat)) {
@@ -165,6 +197,14 @@ void _startHdraw(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 		video->p->memory.io[REG_DISPSTAT >> 1] = GBARegisterDISPSTATClearInVblank(dispstat);
 		break;
 	}
+
+	// Only the HBlank flag would change, and that can be worked out when it's read. The split
+	// event is scheduled first so states recorded above see it, and it's left alone if a callback moved it
+	if (video->event.callback == _startHblank && video->event.when == hblankWhen && _hblankIsQuiet(video, dispstat)) {
+		video->mergedHblank = true;
+		video->event.callback = _startHdraw;
+		mTimingSchedule(timing, &video->event, VIDEO_HORIZONTAL_LENGTH - cyclesLate);
+	}
 }
 
 void _startHblank(struct mTiming* timing, void* context, uint32_t cyclesLate) {
@@ -177,7 +217,9 @@ void _startHblank(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 	// Begin Hblank
 	dispstat = GBARegisterDISPSTATFillInHblank(dispstat);
 	if (video->vcount < GBA_VIDEO_VERTICAL_PIXELS && video->frameskipCounter <= 0) {
+		enum mTimingHostCategory category = mTimingHostEnter(timing, mTIMING_HOST_RENDER_SCANLINE);
 		video->renderer->drawScanline(video->renderer, video->vcount);
+		mTimingHostLeave(timing, category);
 	}
 
 	if (video->vcount < GBA_VIDEO_VERTICAL_PIXELS) {
@@ -193,11 +235,55 @@ void _startHblank(struct mTiming* timing, void* context, uint32_t cyclesLate) {
 }
 
 void GBAVideoWriteDISPSTAT(struct GBAVideo* video, uint16_t value) {
+	GBAVideoSplitHblank(video);
 	video->p->memory.io[REG_DISPSTAT >> 1] &= 0x7;
 	video->p->memory.io[REG_DISPSTAT >> 1] |= value;
 	// TODO: Does a VCounter IRQ trigger on write?
 }
 
+static bool _pastMergedHblank(const struct GBAVideo* video) {
+	return video->mergedHblank && mTimingUntil(&video->p->timing, &video->event) < VIDEO_HBLANK_LENGTH;
+}
+
+uint16_t GBAVideoReadDISPSTAT(const struct GBAVideo* video) {
+	GBARegisterDISPSTAT dispstat = video->p->memory.io[REG_DISPSTAT >> 1];
+	if (_pastMergedHblank(video)) {
+		dispstat = GBARegisterDISPSTATFillInHblank(dispstat);
+	}
+	return dispstat;
+}
+
+// Anything that could give the current line's HBlank something to do has to call this first
+void GBAVideoSplitHblank(struct GBAVideo* video) {
+	if (!video->mergedHblank) {
+		return;
+	}
+	video->mergedHblank = false;
+	int32_t until = mTimingUntil(&video->p->timing, &video->event);
+	if (until < VIDEO_HBLANK_LENGTH) {
+		video->p->memory.io[REG_DISPSTAT >> 1] = GBARegisterDISPSTATFillInHblank(video->p->memory.io[REG_DISPSTAT >> 1]);
+	} else {
+		video->event.callback = _startHblank;
+		mTimingSchedule(&video->p->timing, &video->event, until - VIDEO_HBLANK_LENGTH);
+	}
+}
+
+// Cycles added while events are being processed, like entering an IRQ, push back everything still due
+// in the same pass. An HBlank due after the event at when would have been one of those, so it has to be split
+void GBAVideoSplitDueHblank(struct GBAVideo* video, uint32_t when) {
+	if (!video->mergedHblank) {
+		return;
+	}
+	struct mTiming* timing = &video->p->timing;
+	uint32_t hblank = video->event.when - VIDEO_HBLANK_LENGTH;
+	if ((int32_t) (hblank - when) < 0 || (int32_t) (hblank - timing->masterCycles) > 0) {
+		return;
+	}
+	video->mergedHblank = false;
+	video->event.callback = _startHblank;
+	mTimingSchedule(timing, &video->event, hblank - mTimingCurrentTime(timing));
+}
+
 static void GBAVideoDummyRendererInit(struct GBAVideoRenderer* renderer) {
 	UNUSED(renderer);
 	// Nothing to do
@@ -299,37 +385,76 @@ static void GBAVideoDummyRendererPutPixels(struct GBAVideoRenderer* renderer, si
 }
 
 void GBAVideoSerialize(const struct GBAVideo* video, struct GBASerializedState* state) {
-	memcpy(state->vram, video->vram, SIZE_VRAM);
-	memcpy(state->oam, video->oam.raw, SIZE_OAM);
-	memcpy(state->pram, video->palette, SIZE_PALETTE_RAM);
-	STORE_32(video->event.when - mTimingCurrentTime(&video->p->timing), 0, &state->video.nextEvent);
-	STORE_32(video->frameCounter, 0, &state->video.frameCounter);
+	GBAVideoSerializeRegions(video, state, mSTATE_REGION_ALL);
 }
 
 void GBAVideoDeserialize(struct GBAVideo* video, const struct GBASerializedState* state) {
-	memcpy(video->vram, state->vram, SIZE_VRAM);
-	uint16_t value;
-	int i;
-	for (i = 0; i < SIZE_OAM; i += 2) {
-		LOAD_16(value, i, state->oam);
-		GBAStore16(video->p->cpu, BASE_OAM | i, value, 0);
+	GBAVideoDeserializeRegions(video, state, mSTATE_REGION_ALL);
+}
+
+void GBAVideoSerializeRegions(const struct GBAVideo* video, struct GBASerializedState* state, uint32_t regions) {
+	if (regions & mSTATE_REGION_VRAM) {
+		memcpy(state->vram, video->vram, SIZE_VRAM);
+	}
+	if (regions & mSTATE_REGION_PALETTE_OAM) {
+		memcpy(state->oam, video->oam.raw, SIZE_OAM);
+		memcpy(state->pram, video->palette, SIZE_PALETTE_RAM);
+	}
+	if (!(regions & mSTATE_REGION_CORE)) {
+		return;
+	}
+	int32_t until = video->event.when - mTimingCurrentTime(&video->p->timing);
+	if (video->mergedHblank && until >= VIDEO_HBLANK_LENGTH) {
+		// Saved as if the HBlank event were still coming, which is what loading expects
+		until -= VIDEO_HBLANK_LENGTH;
 	}
-	for (i = 0; i < SIZE_PALETTE_RAM; i += 2) {
-		LOAD_16(value, i, state->pram);
-		GBAStore16(video->p->cpu, BASE_PALETTE_RAM | i, value, 0);
+	STORE_32(until, 0, &state->video.nextEvent);
+	STORE_32(video->frameCounter, 0, &state->video.frameCounter);
+}
+
+void GBAVideoDeserializeRegions(struct GBAVideo* video, const struct GBASerializedState* state, uint32_t regions) {
+	// Everything is copied in bulk; the renderer reset at the end picks it all up at once
+	if (regions & mSTATE_REGION_VRAM) {
+		memcpy(video->vram, state->vram, SIZE_VRAM);
+	}
+	int i;
+	if (regions & mSTATE_REGION_PALETTE_OAM) {
+		for (i = 0; i < SIZE_OAM; i += 2) {
+			LOAD_16(video->oam.raw[i >> 1], i, state->oam);
+		}
+		for (i = 0; i < SIZE_PALETTE_RAM; i += 2) {
+			LOAD_16(video->palette[i >> 1], i, state->pram);
+		}
 	}
-	LOAD_32(video->frameCounter, 0, &state->video.frameCounter);
+	if (regions & mSTATE_REGION_CORE) {
+		LOAD_32(video->frameCounter, 0, &state->video.frameCounter);
+
+		uint32_t when;
+		LOAD_32(when, 0, &state->video.nextEvent);
+		GBARegisterDISPSTAT dispstat = state->io[REG_DISPSTAT >> 1];
+		if (GBARegisterDISPSTATIsInHblank(dispstat)) {
+			video->event.callback = _startHdraw;
+		} else {
+			video->event.callback = _startHblank;
+		}
+		video->mergedHblank = false;
+		mTimingSchedule(&video->p->timing, &video->event, when);
 
-	uint32_t when;
-	LOAD_32(when, 0, &state->video.nextEvent);
-	GBARegisterDISPSTAT dispstat = state->io[REG_DISPSTAT >> 1];
-	if (GBARegisterDISPSTATIsInHblank(dispstat)) {
-		video->event.callback = _startHdraw;
-	} else {
-		video->event.callback = _startHblank;
+		LOAD_16(video->vcount, REG_VCOUNT, state->io);
+	}
+	if (regions & (mSTATE_REGION_CORE | mSTATE_REGION_VRAM | mSTATE_REGION_PALETTE_OAM)) {
+		video->renderer->reset(video->renderer);
 	}
-	mTimingSchedule(&video->p->timing, &video->event, when);
+}
 
-	LOAD_16(video->vcount, REG_VCOUNT, state->io);
+void GBAVideoCopyState(struct GBAVideo* video, const struct GBAVideo* source) {
+	memcpy(video->vram, source->vram, SIZE_VRAM);
+	memcpy(video->oam.raw, source->oam.raw, SIZE_OAM);
+	memcpy(video->palette, source->palette, SIZE_PALETTE_RAM);
+	video->frameCounter = source->frameCounter;
+	video->event.callback = source->event.callback;
+	video->mergedHblank = source->mergedHblank;
+	mTimingSchedule(&video->p->timing, &video->event, source->event.when - mTimingCurrentTime(&source->p->timing));
+	video->vcount = source->vcount;
 	video->renderer->reset(video->renderer);
 }
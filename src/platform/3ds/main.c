@@ -269,8 +269,11 @@ static void _resetCamera(struct m3DSImageSource* imageSource) {
 static void _setup(struct mGUIRunner* runner) {
 	if (core2) {
 		mCoreConfigSetDefaultIntValue(&runner->config, "threadedVideo", 1);
-		mCoreLoadForeignConfig(runner->core, &runner->config);
+	} else {
+		// Without the extra core the render thread couldn't be started, so keep rendering inline
+		mCoreConfigSetOverrideIntValue(&runner->config, "threadedVideo", 0);
 	}
+	mCoreLoadForeignConfig(runner->core, &runner->config);
 
 	runner->core->setPeripheral(runner->core, mPERIPH_ROTATION, &rotation.d);
 	runner->core->setPeripheral(runner->core, mPERIPH_IMAGE_SOURCE, &camera.d);
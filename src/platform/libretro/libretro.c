@@ -12,7 +12,9 @@
 #include <mgba/core/core.h>
 #include <mgba/core/log.h>
 #include <mgba/core/serialize.h>
+#include <mgba/core/sync.h>
 #include <mgba/core/version.h>
+#include <mgba/gb/interface.h>
 #ifdef M_CORE_GB
 #include <mgba/gb/core.h>
 #include <mgba/internal/gb/gb.h>
@@ -26,6 +28,12 @@
 #include <mgba-util/memory.h>
 #include <mgba-util/vfs.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifndef __LIBRETRO__
 #error "Can't compile the libretro core as anything other than libretro."
 #endif
@@ -39,9 +47,19 @@ FS_Archive sdmcArchive;
 #include <switch.h>
 #endif
 
+/* GBA video can be drawn by the GL renderer when the
+ * core is built against OpenGL (ES) 3. Its output pass
+ * reuses the post processing settings, which only
+ * exist for RGB565 output */
+#if defined(M_CORE_GBA) && (defined(BUILD_GLES2) || defined(BUILD_GLES3)) && defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+#define HAVE_HW_RENDER
+#include <mgba/internal/gba/renderers/gl.h>
+#endif
+
 #include "libretro_core_options.h"
 
 #define SAMPLES 512
+#define FRAME_SAMPLES_MAX 2048
 #define RUMBLE_PWM 35
 #define EVENT_RATE 60
 
@@ -49,6 +67,16 @@ FS_Archive sdmcArchive;
 #define VIDEO_HEIGHT_MAX 224
 #define VIDEO_BUFF_SIZE  (VIDEO_WIDTH_MAX * VIDEO_HEIGHT_MAX * sizeof(color_t))
 
+/* Size of the display that the output scaling
+ * option targets. Other panels can override this,
+ * along with the option's label */
+#ifndef VIDEO_SCALED_WIDTH
+#define VIDEO_SCALED_WIDTH  240
+#endif
+#ifndef VIDEO_SCALED_HEIGHT
+#define VIDEO_SCALED_HEIGHT 240
+#endif
+
 static retro_environment_t environCallback;
 static retro_video_refresh_t videoCallback;
 static retro_audio_sample_batch_t audioCallback;
@@ -78,6 +106,11 @@ static int32_t _readGyroZ(struct mRotationSource* source);
 
 static struct mCore* core;
 static color_t* outputBuffer = NULL;
+static color_t* videoBuffer = NULL;
+static size_t videoBufferStride;
+static enum retro_pixel_format pixelFormat;
+static bool frameAligned;
+static size_t serializeSize;
 static void* data;
 static size_t dataSize;
 static void* savedata;
@@ -93,7 +126,13 @@ static int luxLevelIndex;
 static uint8_t luxLevel;
 static bool luxSensorEnabled;
 static bool luxSensorUsed;
+static bool latePollEnabled;
+static bool lowMemoryProfile;
+static bool romMapped;
+static bool latePollDone;
+static struct mCoreCallbacks latePollCallbacks;
 static struct mLogger logger;
+static struct mLogFilter logFilter;
 static struct retro_camera_callback cam;
 static struct mImageSource imageSource;
 static uint32_t* camData = NULL;
@@ -106,11 +145,33 @@ static bool envVarsUpdated;
 static unsigned frameskipType;
 static unsigned frameskipThreshold;
 static uint16_t frameskipCounter;
+static struct retro_perf_callback perfCallback;
+static retro_time_t governorFramePeriod;
+static float governorDrawCost;
+static float governorSkipCost;
+static float governorPostCost;
+static unsigned governorLevel;
+static unsigned governorStoredLevel;
+static unsigned governorCountdown;
+static unsigned governorSettle;
+static unsigned governorCalm;
+static struct Configuration governorCache;
+static char governorCachePath[PATH_MAX];
+static char governorSection[16];
+static unsigned frameStatsMode;
+static unsigned frameStatsFrames;
+static retro_time_t frameStatsAudioTime;
 static bool retroAudioBuffActive;
 static unsigned retroAudioBuffOccupancy;
 static bool retroAudioBuffUnderrun;
+static struct mCoreSyncAudioStats retroAudioStats;
 static unsigned retroAudioLatency;
 static bool updateAudioLatency;
+static bool audioPerFrame;
+static bool canDupe;
+static unsigned unchangedFrames;
+static bool hwRenderEnabled;
+static int16_t audioFrameBuffer[FRAME_SAMPLES_MAX * 2];
 static int32_t tiltX = 0;
 static int32_t tiltY = 0;
 static int32_t gyroZ = 0;
@@ -125,10 +186,95 @@ static void _retroAudioBuffStatusCallback(bool active, unsigned occupancy, bool
 	retroAudioBuffActive    = active;
 	retroAudioBuffOccupancy = occupancy;
 	retroAudioBuffUnderrun  = underrunLikely;
+
+	/* The frontend reports its fill as a percentage */
+	if (active) {
+		mCoreSyncAudioStatsRecordRead(&retroAudioStats, occupancy, 100, underrunLikely);
+	}
+}
+
+static void _logAudioStats(void) {
+	if (!logCallback || (!retroAudioStats.reads && !retroAudioStats.overruns)) {
+		return;
+	}
+	logCallback(RETRO_LOG_INFO, "Audio: %u underruns likely in %u buffer reports, %u batches not fully accepted\n",
+	            retroAudioStats.underruns, retroAudioStats.reads, retroAudioStats.overruns);
+	if (retroAudioStats.reads) {
+		char histogram[mCORE_SYNC_AUDIO_HISTOGRAM * 8] = "";
+		size_t length = 0;
+		size_t i;
+		for (i = 0; i < mCORE_SYNC_AUDIO_HISTOGRAM; ++i) {
+			length += snprintf(&histogram[length], sizeof(histogram) - length, " %.0f%%",
+			                   retroAudioStats.occupancy[i] * 100.f / retroAudioStats.reads);
+		}
+		logCallback(RETRO_LOG_INFO, "Audio buffer fill, emptiest to fullest:%s\n", histogram);
+	}
+}
+
+static bool _initPerfTimer(void) {
+	if (perfCallback.get_time_usec) {
+		return true;
+	}
+	return environCallback(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perfCallback) && perfCallback.get_time_usec;
+}
+
+/* Startup timing
+ * > Logged phase by phase from retro_load_game
+ *   up to the first retro_run, so that whatever
+ *   keeps a game from starting quickly shows up */
+static bool startupTiming = false;
+static retro_time_t startupStart;
+static retro_time_t startupPhaseStart;
+
+static void _startupTimingBegin(void) {
+	startupTiming = logCallback && _initPerfTimer();
+	if (startupTiming) {
+		startupStart = perfCallback.get_time_usec();
+		startupPhaseStart = startupStart;
+	}
+}
+
+static void _startupTimingPhase(const char* phase) {
+	retro_time_t now;
+	if (!startupTiming) {
+		return;
+	}
+	now = perfCallback.get_time_usec();
+	logCallback(RETRO_LOG_INFO, "Startup: %-20s %7u us\n", phase, (unsigned) (now - startupPhaseStart));
+	startupPhaseStart = now;
+}
+
+static void _startupTimingEnd(void) {
+	if (!startupTiming) {
+		return;
+	}
+	_startupTimingPhase("until first frame");
+	logCallback(RETRO_LOG_INFO, "Startup: %-20s %7u us\n", "total", (unsigned) (startupPhaseStart - startupStart));
+	startupTiming = false;
+}
+
+static bool _initFrameskipGovernor(void) {
+	if (!_initPerfTimer()) {
+		return false;
+	}
+	governorFramePeriod = (retro_time_t) core->frameCycles(core) * 1000000 / core->frequency(core);
+	governorDrawCost = 0;
+	governorSkipCost = 0;
+	governorPostCost = 0;
+	governorCountdown = 0;
+	governorSettle = 0;
+	governorCalm = 0;
+	return true;
 }
 
 static void _initFrameskip(void) {
 
+	if (frameskipType == 4 && !_initFrameskipGovernor()) {
+		if (logCallback)
+			logCallback(RETRO_LOG_WARN, "Frameskip disabled - frontend does not provide a performance timer.\n");
+		frameskipType = 0;
+	}
+
 	if (frameskipType > 0) {
 
 		bool calculateAudioLatency = true;
@@ -142,14 +288,19 @@ static void _initFrameskip(void) {
 
 			if (!environCallback(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, &BuffStatusCb)) {
 
-				if (logCallback)
-					logCallback(RETRO_LOG_WARN, "Frameskip disabled - frontend does not support audio buffer status monitoring.\n");
-
 				retroAudioBuffActive    = false;
 				retroAudioBuffOccupancy = 0;
 				retroAudioBuffUnderrun  = false;
-				retroAudioLatency       = 0;
-				calculateAudioLatency   = false;
+
+				/* The frame time governor only uses the
+				 * buffer status as an early warning */
+				if (frameskipType != 4) {
+					if (logCallback)
+						logCallback(RETRO_LOG_WARN, "Frameskip disabled - frontend does not support audio buffer status monitoring.\n");
+
+					retroAudioLatency       = 0;
+					calculateAudioLatency   = false;
+				}
 			}
 		}
 
@@ -195,6 +346,8 @@ static void _loadFrameskipSettings(struct mCoreOptions *opts) {
 			frameskipType = 2;
 		} else if (strcmp(var.value, "fixed_interval") == 0) {
 			frameskipType = 3;
+		} else if (strcmp(var.value, "auto_frametime") == 0) {
+			frameskipType = 4;
 		}
 	}
 
@@ -230,10 +383,362 @@ static void _loadFrameskipSettings(struct mCoreOptions *opts) {
 	}
 }
 
-/* Video post processing */
-#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+/* Frame time governor: level 0 draws every frame,
+ * level 1 drops post processing and each level
+ * above that skips one more frame after every one
+ * that is drawn */
+
+/* Maximum number of frames the governor skips
+ * after each drawn frame */
+#define GOVERNOR_SKIP_MAX 3
+#define GOVERNOR_LEVEL_MAX (GOVERNOR_SKIP_MAX + 1)
+
+/* Share of the frame period the core may spend
+ * before the governor steps up, leaving the rest to
+ * the frontend, and share below which it steps back
+ * down once that has held for a while */
+#define GOVERNOR_BUSY_PERCENT 75
+#define GOVERNOR_CALM_PERCENT 55
+#define GOVERNOR_CALM_FRAMES  180
+
+/* Frames to wait after a change of level before
+ * the measurements reflect it */
+#define GOVERNOR_SETTLE_FRAMES 15
+
+static void _governorSample(float* cost, retro_time_t usec) {
+	if (*cost <= 0.0f) {
+		*cost = (float) usec;
+	} else {
+		*cost += ((float) usec - *cost) / 8.0f;
+	}
+}
+
+/* Average host time per frame at a given level */
+static float _governorCost(unsigned level) {
+	unsigned skipped = level > 1 ? level - 1 : 0;
+	float cost = governorDrawCost + skipped * governorSkipCost;
+	if (!level) {
+		cost += governorPostCost;
+	}
+	return cost / (skipped + 1);
+}
+
+static void _governorUpdate(void) {
+	float busy = governorFramePeriod * (GOVERNOR_BUSY_PERCENT / 100.0f);
+	float calm = governorFramePeriod * (GOVERNOR_CALM_PERCENT / 100.0f);
+
+	if (governorSettle) {
+		--governorSettle;
+		return;
+	}
+
+	/* Step up as far as the measurements say is
+	 * needed, and at least once if the frontend
+	 * warns of an underrun anyway */
+	unsigned level = governorLevel;
+	if (retroAudioBuffActive && retroAudioBuffUnderrun && level < GOVERNOR_LEVEL_MAX) {
+		++level;
+	}
+	while (level < GOVERNOR_LEVEL_MAX && _governorCost(level) > busy) {
+		++level;
+	}
+	if (level != governorLevel) {
+		governorLevel  = level;
+		governorCalm   = 0;
+		governorSettle = GOVERNOR_SETTLE_FRAMES;
+		return;
+	}
+
+	/* Only step down after the level below has
+	 * looked affordable for a good while, so that
+	 * brief lulls don't cause oscillation */
+	if (governorLevel && _governorCost(governorLevel - 1) < calm) {
+		if (++governorCalm >= GOVERNOR_CALM_FRAMES) {
+			--governorLevel;
+			governorCalm   = 0;
+			governorSettle = GOVERNOR_SETTLE_FRAMES;
+		}
+	} else {
+		governorCalm = 0;
+	}
+}
+
+static bool _governorSkipFrame(void) {
+	if (governorLevel < 2) {
+		governorCountdown = 0;
+		return false;
+	}
+	if (governorCountdown) {
+		--governorCountdown;
+		return true;
+	}
+	governorCountdown = governorLevel - 1;
+	return false;
+}
+
+/* The level each game settles on is remembered
+ * across sessions, so that slow games don't have to
+ * stutter their way up to it every time */
+static void _loadGovernorLevel(void) {
+	const char* sysDir = 0;
+	uint32_t crc32 = 0;
+
+	governorCachePath[0] = '\0';
+	governorLevel = 0;
+	governorStoredLevel = 0;
+	ConfigurationInit(&governorCache);
+	if (!environCallback(RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY, &sysDir) || !sysDir) {
+		return;
+	}
+	snprintf(governorCachePath, sizeof(governorCachePath), "%s%s%s", sysDir, PATH_SEP, "mgba_frameskip_levels.ini");
+	core->checksum(core, &crc32, CHECKSUM_CRC32);
+	snprintf(governorSection, sizeof(governorSection), "game.%08X", crc32);
+	ConfigurationRead(&governorCache, governorCachePath);
+
+	const char* value = ConfigurationGetValue(&governorCache, governorSection, "frameskipLevel");
+	if (value) {
+		char* end;
+		unsigned long level = strtoul(value, &end, 10);
+		if (end && !*end && level <= GOVERNOR_LEVEL_MAX) {
+			governorLevel = level;
+			governorStoredLevel = level;
+		}
+	}
+}
+
+static void _saveGovernorLevel(void) {
+	if (frameskipType == 4 && governorCachePath[0] && governorLevel != governorStoredLevel) {
+		ConfigurationSetUIntValue(&governorCache, governorSection, "frameskipLevel", governorLevel);
+		ConfigurationWrite(&governorCache, governorCachePath);
+	}
+	ConfigurationDeinit(&governorCache);
+	governorCachePath[0] = '\0';
+}
+
+/* Frame statistics: host time spent in each stage of
+ * retro_run, gathered over a window of frames and
+ * then reported as average, median, 95th percentile
+ * and worst case. Nothing is timed while disabled */
+
+#define FRAME_STATS_WINDOW 120
+
+enum {
+	FRAME_STATS_OFF = 0,
+	FRAME_STATS_LOG,
+	FRAME_STATS_OSD
+};
+
+enum FrameStatStage {
+	FRAME_STAT_TOTAL = 0,
+	FRAME_STAT_INPUT,
+	/* Emulation is split by whether the frame was
+	 * drawn: the difference is the renderer's share */
+	FRAME_STAT_EMULATE,
+	FRAME_STAT_EMULATE_SKIPPED,
+	FRAME_STAT_AUDIO,
+	FRAME_STAT_POST_PROCESS,
+	FRAME_STAT_VIDEO,
+	FRAME_STAT_MAX
+};
+
+static const char* const frameStatNames[FRAME_STAT_MAX] = {
+	"total",
+	"input",
+	"emulate",
+	"emulate (no drawing)",
+	"audio",
+	"post process",
+	"video"
+};
+
+static struct FrameStat {
+	uint32_t samples[FRAME_STATS_WINDOW];
+	unsigned count;
+} frameStats[FRAME_STAT_MAX];
+
+static inline retro_time_t _frameStatsNow(void) {
+	return frameStatsMode ? perfCallback.get_time_usec() : 0;
+}
+
+static void _frameStatsAdd(enum FrameStatStage stage, retro_time_t usec) {
+	struct FrameStat* stat = &frameStats[stage];
+	if (!frameStatsMode || stat->count >= FRAME_STATS_WINDOW) {
+		return;
+	}
+	stat->samples[stat->count] = usec > 0 ? (uint32_t) usec : 0;
+	++stat->count;
+}
+
+static int _frameStatCompare(const void* a, const void* b) {
+	uint32_t x = *(const uint32_t*) a;
+	uint32_t y = *(const uint32_t*) b;
+	return (x > y) - (x < y);
+}
+
+static void _frameStatsReset(void) {
+	unsigned i;
+	for (i = 0; i < FRAME_STAT_MAX; ++i) {
+		frameStats[i].count = 0;
+	}
+	frameStatsFrames = 0;
+	frameStatsAudioTime = 0;
+}
+
+static void _frameStatsReport(void) {
+	uint32_t sorted[FRAME_STATS_WINDOW];
+	uint32_t average[FRAME_STAT_MAX] = {0};
+	uint32_t p95[FRAME_STAT_MAX] = {0};
+	unsigned i;
+
+	if (!frameStatsMode || ++frameStatsFrames < FRAME_STATS_WINDOW) {
+		return;
+	}
+
+	for (i = 0; i < FRAME_STAT_MAX; ++i) {
+		const struct FrameStat* stat = &frameStats[i];
+		uint64_t sum = 0;
+		unsigned j;
+		if (!stat->count) {
+			continue;
+		}
+		for (j = 0; j < stat->count; ++j) {
+			sum += stat->samples[j];
+		}
+		memcpy(sorted, stat->samples, stat->count * sizeof(*sorted));
+		qsort(sorted, stat->count, sizeof(*sorted), _frameStatCompare);
+		average[i] = sum / stat->count;
+		p95[i] = sorted[(stat->count * 95) / 100];
+		if (frameStatsMode == FRAME_STATS_LOG && logCallback) {
+			logCallback(RETRO_LOG_INFO, "Frame stats: %-20s avg %5u us, p50 %5u us, p95 %5u us, max %5u us (%u frames)\n",
+			            frameStatNames[i], average[i], sorted[stat->count / 2], p95[i], sorted[stat->count - 1], stat->count);
+		}
+	}
+
+	if (frameStatsMode == FRAME_STATS_OSD) {
+		char message[128];
+		char emulate[32];
+		struct retro_message msg;
+		if (frameStats[FRAME_STAT_EMULATE].count && frameStats[FRAME_STAT_EMULATE_SKIPPED].count) {
+			int render = (int) average[FRAME_STAT_EMULATE] - (int) average[FRAME_STAT_EMULATE_SKIPPED];
+			snprintf(emulate, sizeof(emulate), "%.1f (render ~%.1f)", average[FRAME_STAT_EMULATE] / 1000.0, render / 1000.0);
+		} else if (frameStats[FRAME_STAT_EMULATE].count) {
+			snprintf(emulate, sizeof(emulate), "%.1f", average[FRAME_STAT_EMULATE] / 1000.0);
+		} else {
+			snprintf(emulate, sizeof(emulate), "%.1f (no drawing)", average[FRAME_STAT_EMULATE_SKIPPED] / 1000.0);
+		}
+		snprintf(message, sizeof(message), "Frame %.1f ms (p95 %.1f) | emu %s | audio %.1f | post %.1f | video %.1f",
+		         average[FRAME_STAT_TOTAL] / 1000.0, p95[FRAME_STAT_TOTAL] / 1000.0, emulate,
+		         average[FRAME_STAT_AUDIO] / 1000.0, average[FRAME_STAT_POST_PROCESS] / 1000.0,
+		         average[FRAME_STAT_VIDEO] / 1000.0);
+		msg.msg = message;
+		msg.frames = FRAME_STATS_WINDOW;
+		environCallback(RETRO_ENVIRONMENT_SET_MESSAGE, &msg);
+	}
+
+	_frameStatsReset();
+}
+
+static void _loadInputPollSettings(void) {
+	struct retro_variable var;
+
+	var.key   = "mgba_input_poll";
+	var.value = 0;
+
+	latePollEnabled = false;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		latePollEnabled = strcmp(var.value, "late") == 0;
+	}
+}
+
+static void _loadMemoryProfileSettings(void) {
+	struct retro_variable var;
+
+	var.key   = "mgba_memory_profile";
+	var.value = 0;
 
-/* Colour correction */
+	lowMemoryProfile = false;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		lowMemoryProfile = strcmp(var.value, "low") == 0;
+	}
+}
+
+static void _loadFrameStatsSettings(void) {
+	struct retro_variable var;
+	unsigned oldFrameStatsMode = frameStatsMode;
+
+	var.key   = "mgba_frame_stats";
+	var.value = 0;
+
+	frameStatsMode = FRAME_STATS_OFF;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		if (strcmp(var.value, "log") == 0) {
+			frameStatsMode = FRAME_STATS_LOG;
+		} else if (strcmp(var.value, "osd") == 0) {
+			frameStatsMode = FRAME_STATS_OSD;
+		}
+	}
+
+	if (frameStatsMode && !_initPerfTimer()) {
+		if (logCallback)
+			logCallback(RETRO_LOG_WARN, "Frame statistics disabled - frontend does not provide a performance timer.\n");
+		frameStatsMode = FRAME_STATS_OFF;
+	}
+
+	if (frameStatsMode != oldFrameStatsMode) {
+		_frameStatsReset();
+	}
+}
+
+/* Audio delivery functions */
+
+static void _loadAudioSettings(bool init) {
+
+	struct retro_variable var;
+	bool oldAudioPerFrame = audioPerFrame;
+
+	var.key   = "mgba_audio_per_frame";
+	var.value = NULL;
+
+	audioPerFrame = false;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		audioPerFrame = strcmp(var.value, "ON") == 0;
+	}
+
+	if (!init && audioPerFrame == oldAudioPerFrame) {
+		return;
+	}
+
+	/* When draining once per frame, the core must
+	 * hold a whole frame of samples without stalling
+	 * on (or dropping samples past) a full buffer */
+	stream.postAudioBuffer = audioPerFrame ? NULL : _postAudioBuffer;
+	core->setAudioBufferSize(core, audioPerFrame ? FRAME_SAMPLES_MAX : SAMPLES);
+}
+
+static void _drainAudio(void) {
+	blip_t* left = core->getAudioChannel(core, 0);
+	blip_t* right = core->getAudioChannel(core, 1);
+	int produced = blip_samples_avail(left);
+	if (!produced) {
+		return;
+	}
+	if (produced > FRAME_SAMPLES_MAX) {
+		produced = FRAME_SAMPLES_MAX;
+	}
+	retro_time_t audioStart = _frameStatsNow();
+	blip_read_samples(left, audioFrameBuffer, produced, true);
+	blip_read_samples(right, audioFrameBuffer + 1, produced, true);
+	if (audioCallback(audioFrameBuffer, produced) < (size_t) produced) {
+		++retroAudioStats.overruns;
+	}
+	if (frameStatsMode) {
+		frameStatsAudioTime += _frameStatsNow() - audioStart;
+	}
+}
+
+/* Colour correction
+ * > Applied by the core's renderer as it converts
+ *   palette entries, so it works in any pixel format */
 #define CC_TARGET_GAMMA   2.2f
 #define CC_RGB_MAX        31.0f
 
@@ -267,11 +772,15 @@ static void _loadFrameskipSettings(struct mCoreOptions *opts) {
 static color_t* ccLUT              = NULL;
 static unsigned ccType             = 0;
 static bool colorCorrectionEnabled = false;
+#ifdef HAVE_HW_RENDER
+/* Column-major, as the GL output pass takes it */
+static float ccMatrix[9];
+static float ccGamma;
+#endif
 
 static void _initColorCorrection(void) {
 
 	/* Constants */
-	static const float displayGammaInv = 1.0f / CC_TARGET_GAMMA;
 	static const float rgbMaxInv = 1.0f / CC_RGB_MAX;
 
 	/* Variables */
@@ -365,57 +874,124 @@ static void _initColorCorrection(void) {
 			return;
 	}
 
+#ifdef HAVE_HW_RENDER
+	ccMatrix[0] = ccLum * ccR;
+	ccMatrix[1] = ccLum * ccRG;
+	ccMatrix[2] = ccLum * ccRB;
+	ccMatrix[3] = ccLum * ccGR;
+	ccMatrix[4] = ccLum * ccG;
+	ccMatrix[5] = ccLum * ccGB;
+	ccMatrix[6] = ccLum * ccBR;
+	ccMatrix[7] = ccLum * ccBG;
+	ccMatrix[8] = ccLum * ccB;
+	ccGamma = adjustedGamma;
+	if (hwRenderEnabled) {
+		/* Corrected by the GL output pass instead,
+		 * so there is no table to build */
+		colorCorrectionEnabled = true;
+		return;
+	}
+#endif
+
 	/* Allocate look-up table buffer, if required */
 	if (!ccLUT) {
-		size_t lutSize = 65536 * sizeof(color_t);
-		ccLUT = malloc(lutSize);
+		ccLUT = malloc(32768 * sizeof(color_t));
 		if (!ccLUT) {
 			return;
 		}
-		memset(ccLUT, 0xFF, lutSize);
 	}
 
 	/* If we get this far, then colour correction is enabled... */
 	colorCorrectionEnabled = true;
 
 	/* Populate colour correction look-up table
-	 * Note: This is somewhat slow (~100 ms on desktop),
-	 * but using precompiled look-up tables would double
-	 * the memory requirements, and make updating colour
-	 * correction parameters an absolute nightmare...) */
-	for (color = 0; color < 65536; color++) {
-		unsigned rFinal = 0;
-		unsigned gFinal = 0;
-		unsigned bFinal = 0;
-		/* Extract values from RGB565 input */
-		const unsigned r = color >> 11 & 0x1F;
-		const unsigned g = color >>  6 & 0x1F;
-		const unsigned b = color       & 0x1F;
-		/* Perform gamma expansion */
-		float rFloat = pow((float)r * rgbMaxInv, adjustedGamma);
-		float gFloat = pow((float)g * rgbMaxInv, adjustedGamma);
-		float bFloat = pow((float)b * rgbMaxInv, adjustedGamma);
-		/* Perform colour mangling */
-		float rCorrect = ccLum * ((ccR  * rFloat) + (ccGR * gFloat) + (ccBR * bFloat));
-		float gCorrect = ccLum * ((ccRG * rFloat) + (ccG  * gFloat) + (ccBG * bFloat));
-		float bCorrect = ccLum * ((ccRB * rFloat) + (ccGB * gFloat) + (ccB  * bFloat));
-		/* Range check... */
-		rCorrect = rCorrect > 0.0f ? rCorrect : 0.0f;
-		gCorrect = gCorrect > 0.0f ? gCorrect : 0.0f;
-		bCorrect = bCorrect > 0.0f ? bCorrect : 0.0f;
-		/* Perform gamma compression */
-		rCorrect = pow(rCorrect, displayGammaInv);
-		gCorrect = pow(gCorrect, displayGammaInv);
-		bCorrect = pow(bCorrect, displayGammaInv);
-		/* Range check... */
-		rCorrect = rCorrect > 1.0f ? 1.0f : rCorrect;
-		gCorrect = gCorrect > 1.0f ? 1.0f : gCorrect;
-		bCorrect = bCorrect > 1.0f ? 1.0f : bCorrect;
-		/* Convert back to RGB565 */
-		rFinal = (unsigned)((rCorrect * CC_RGB_MAX) + 0.5f) & 0x1F;
-		gFinal = (unsigned)((gCorrect * CC_RGB_MAX) + 0.5f) & 0x1F;
-		bFinal = (unsigned)((bCorrect * CC_RGB_MAX) + 0.5f) & 0x1F;
-		ccLUT[color] = rFinal << 11 | gFinal << 6 | bFinal;
+	 * Note: Rather than two gamma curves per channel of
+	 * every one of the 32768 colours, the expansion is
+	 * done once per channel level, folded into what each
+	 * input channel adds to each output channel, and the
+	 * compression becomes a look-up of the inputs at which
+	 * each output level starts. This keeps the table
+	 * quick enough to build at load time on handhelds,
+	 * without the memory of a precompiled one per model */
+	{
+#ifdef COLOR_16_BIT
+		/* Convert back to BGR555, then to the output format */
+#define CC_OUTPUT_MAX 31
+#else
+		/* Keep the full precision of 8-bit channels */
+#define CC_OUTPUT_MAX 255
+#endif
+#define CC_BUCKETS    1024
+		float contribution[3][3][32];
+		float thresholds[CC_OUTPUT_MAX];
+		uint8_t buckets[CC_BUCKETS];
+		const float weights[3][3] = {
+			{ ccR,  ccRG, ccRB },
+			{ ccGR, ccG,  ccGB },
+			{ ccBR, ccBG, ccB  }
+		};
+		unsigned level;
+		unsigned in;
+		unsigned out;
+
+		for (level = 0; level < 32; level++) {
+			/* Perform gamma expansion */
+			float expanded = ccLum * pow((float)level * rgbMaxInv, adjustedGamma);
+			for (in = 0; in < 3; in++) {
+				for (out = 0; out < 3; out++) {
+					contribution[in][out][level] = weights[in][out] * expanded;
+				}
+			}
+		}
+
+		/* Output level n is reached once gamma compression
+		 * would round up to it, i.e. at ((n - 0.5) / max)
+		 * raised to the target gamma */
+		for (level = 1; level <= CC_OUTPUT_MAX; level++) {
+			thresholds[level - 1] = pow(((float)level - 0.5f) / CC_OUTPUT_MAX, CC_TARGET_GAMMA);
+		}
+
+		/* The output level at the start of each evenly
+		 * sized slice of the input range, so that finding
+		 * a level only takes a step or two from there */
+		level = 0;
+		for (in = 0; in < CC_BUCKETS; in++) {
+			while (level < CC_OUTPUT_MAX && (float)in / CC_BUCKETS >= thresholds[level]) {
+				level++;
+			}
+			buckets[in] = level;
+		}
+
+		for (color = 0; color < 32768; color++) {
+			/* Extract values from BGR555 input */
+			const unsigned r = color       & 0x1F;
+			const unsigned g = color >>  5 & 0x1F;
+			const unsigned b = color >> 10 & 0x1F;
+			unsigned final[3];
+			for (out = 0; out < 3; out++) {
+				/* Perform colour mangling */
+				float linear = contribution[0][out][r] + contribution[1][out][g] + contribution[2][out][b];
+				/* Range check... */
+				if (linear >= 1.0f) {
+					final[out] = CC_OUTPUT_MAX;
+					continue;
+				}
+				linear = linear > 0.0f ? linear : 0.0f;
+				/* Perform gamma compression */
+				level = buckets[(unsigned)(linear * CC_BUCKETS)];
+				while (level < CC_OUTPUT_MAX && linear >= thresholds[level]) {
+					level++;
+				}
+				final[out] = level;
+			}
+#ifdef COLOR_16_BIT
+			ccLUT[color] = mColorFrom555(final[0] | final[1] << 5 | final[2] << 10);
+#else
+			ccLUT[color] = final[0] | final[1] << 8 | final[2] << 16;
+#endif
+		}
+#undef CC_BUCKETS
+#undef CC_OUTPUT_MAX
 	}
 }
 
@@ -440,10 +1016,28 @@ static void _loadColorCorrectionSettings(void) {
 	if (ccType == 0) {
 		colorCorrectionEnabled = false;
 	} else if (ccType != oldCcType) {
+		/* The table is rebuilt in place, so the core
+		 * has to let go of it to notice the change */
+		core->setVideoColorTable(core, NULL);
 		_initColorCorrection();
 	}
+
+	core->setVideoColorTable(core, colorCorrectionEnabled ? ccLUT : NULL);
+}
+
+static void _deinitColorCorrection(void) {
+	ccType                 = 0;
+	colorCorrectionEnabled = false;
+
+	if (ccLUT) {
+		free(ccLUT);
+		ccLUT = NULL;
+	}
 }
 
+/* Video post processing */
+#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+
 /* Interframe blending */
 #define LCD_RESPONSE_TIME 0.333f
 /* > 'LCD Ghosting (Fast)' method does not
@@ -453,6 +1047,18 @@ static void _loadColorCorrectionSettings(void) {
  *   the response time, hence this 'fake' value */
 #define LCD_RESPONSE_TIME_FAKE 0.5f
 
+/* Both LCD ghosting methods work in fixed point, so
+ * that they stay cheap on cores with a weak (or no)
+ * FPU and fit eight channel values per vector:
+ * > 'Accurate' weights are out of 1 << LCD_GHOST_WEIGHT_BITS
+ * > 'Fast' accumulators hold channels with
+ *   LCD_GHOST_ACC_BITS fractional bits. Since the
+ *   fake response time is one half, each frame is a
+ *   (rounded) average of the current colour and the
+ *   accumulator */
+#define LCD_GHOST_WEIGHT_BITS 10
+#define LCD_GHOST_ACC_BITS    11
+
 enum frame_blend_method
 {
    FRAME_BLEND_NONE = 0,
@@ -468,10 +1074,10 @@ static color_t* outputBufferPrev1             = NULL;
 static color_t* outputBufferPrev2             = NULL;
 static color_t* outputBufferPrev3             = NULL;
 static color_t* outputBufferPrev4             = NULL;
-static float* outputBufferAccR                = NULL;
-static float* outputBufferAccG                = NULL;
-static float* outputBufferAccB                = NULL;
-static float frameBlendResponse[4]            = {0.0f};
+static uint16_t* outputBufferAccR             = NULL;
+static uint16_t* outputBufferAccG             = NULL;
+static uint16_t* outputBufferAccB             = NULL;
+static uint16_t frameBlendWeights[5]          = {0};
 static bool frameBlendResponseSet             = false;
 
 static bool _allocateOutputBufferPrev(color_t** buf) {
@@ -487,7 +1093,7 @@ static bool _allocateOutputBufferPrev(color_t** buf) {
 
 static bool _allocateOutputBufferAcc(void) {
 	size_t i;
-	size_t buf_size = VIDEO_WIDTH_MAX * VIDEO_HEIGHT_MAX * sizeof(float);
+	size_t buf_size = VIDEO_WIDTH_MAX * VIDEO_HEIGHT_MAX * sizeof(uint16_t);
 
 	if (!outputBufferAccR) {
 		outputBufferAccR = malloc(buf_size);
@@ -510,73 +1116,77 @@ static bool _allocateOutputBufferAcc(void) {
 		}
 	}
 
-	/* Cannot use memset() on arrays of floats... */
+	/* Cannot use memset() for a value of 1.0... */
 	for (i = 0; i < (VIDEO_WIDTH_MAX * VIDEO_HEIGHT_MAX); i++) {
-		outputBufferAccR[i] = 1.0f;
-		outputBufferAccG[i] = 1.0f;
-		outputBufferAccB[i] = 1.0f;
+		outputBufferAccR[i] = 1 << LCD_GHOST_ACC_BITS;
+		outputBufferAccG[i] = 1 << LCD_GHOST_ACC_BITS;
+		outputBufferAccB[i] = 1 << LCD_GHOST_ACC_BITS;
 	}
 	return true;
 }
 
-static void _initFrameBlend(void) {
+static void _freeOutputBufferPrev(color_t** buf) {
+	if (*buf) {
+		free(*buf);
+		*buf = NULL;
+	}
+}
 
-	frameBlendEnabled = false;
+static void _freeOutputBufferAcc(void) {
+	if (outputBufferAccR) {
+		free(outputBufferAccR);
+		outputBufferAccR = NULL;
+	}
+
+	if (outputBufferAccG) {
+		free(outputBufferAccG);
+		outputBufferAccG = NULL;
+	}
+
+	if (outputBufferAccB) {
+		free(outputBufferAccB);
+		outputBufferAccB = NULL;
+	}
+}
+
+/* On the low memory profile, buffers are only kept
+ * while the current blending method uses them.
+ * Otherwise they stay around, so that switching
+ * back and forth doesn't reallocate them */
+static void _trimFrameBlendBuffers(void) {
+	if (!lowMemoryProfile) {
+		return;
+	}
 
-	/* Allocate interframe blending buffers, as required
-	 * NOTE: In all cases, any used buffers are 'reset'
-	 * (filled with 0xFF) to avoid drawing garbage on
-	 * the next frame */
 	switch (frameBlendType) {
 		case FRAME_BLEND_MIX:
-			/* Simple 50:50 blending requires a single buffer */
-			if (!_allocateOutputBufferPrev(&outputBufferPrev1)) {
-				return;
-			}
+			_freeOutputBufferPrev(&outputBufferPrev2);
+			_freeOutputBufferPrev(&outputBufferPrev3);
+			_freeOutputBufferPrev(&outputBufferPrev4);
+			_freeOutputBufferAcc();
 			break;
 		case FRAME_BLEND_MIX_SMART:
-			/* Smart 50:50 blending requires three buffers */
-			if (!_allocateOutputBufferPrev(&outputBufferPrev1)) {
-				return;
-			}
-			if (!_allocateOutputBufferPrev(&outputBufferPrev2)) {
-				return;
-			}
-			if (!_allocateOutputBufferPrev(&outputBufferPrev3)) {
-				return;
-			}
+			_freeOutputBufferPrev(&outputBufferPrev4);
+			_freeOutputBufferAcc();
 			break;
 		case FRAME_BLEND_LCD_GHOSTING:
-			/* 'Accurate' LCD ghosting requires four buffers */
-			if (!_allocateOutputBufferPrev(&outputBufferPrev1)) {
-				return;
-			}
-			if (!_allocateOutputBufferPrev(&outputBufferPrev2)) {
-				return;
-			}
-			if (!_allocateOutputBufferPrev(&outputBufferPrev3)) {
-				return;
-			}
-			if (!_allocateOutputBufferPrev(&outputBufferPrev4)) {
-				return;
-			}
-			break;
-		case FRAME_BLEND_LCD_GHOSTING_FAST:
-			/* 'Fast' LCD ghosting requires three (RGB)
-			 * 'accumulator' buffers */
-			if (!_allocateOutputBufferAcc()) {
-				return;
-			}
+			_freeOutputBufferAcc();
 			break;
 		case FRAME_BLEND_NONE:
 		default:
-			/* Error condition - cannot happen
-			 * > Just leave frameBlendEnabled set to false */
-			return;
+			_freeOutputBufferAcc();
+			/* Fall through */
+		case FRAME_BLEND_LCD_GHOSTING_FAST:
+			_freeOutputBufferPrev(&outputBufferPrev1);
+			_freeOutputBufferPrev(&outputBufferPrev2);
+			_freeOutputBufferPrev(&outputBufferPrev3);
+			_freeOutputBufferPrev(&outputBufferPrev4);
+			break;
 	}
+}
+
+static void _initFrameBlendWeights(void) {
 
-	/* Set LCD ghosting response time factors,
-	 * if required */
 	if ((frameBlendType == FRAME_BLEND_LCD_GHOSTING) &&
 	    !frameBlendResponseSet) {
 
@@ -591,13 +1201,92 @@ static void _initFrameBlend(void) {
 		 * increased, we may need to rethink this
 		 * (but more samples == greater performance
 		 * overheads) */
-		frameBlendResponse[0] = LCD_RESPONSE_TIME;
-		frameBlendResponse[1] = pow(LCD_RESPONSE_TIME, 2.0f);
-		frameBlendResponse[2] = pow(LCD_RESPONSE_TIME, 3.0f);
-		frameBlendResponse[3] = pow(LCD_RESPONSE_TIME, 4.0f);
+		float response[4];
+		response[0] = LCD_RESPONSE_TIME;
+		response[1] = pow(LCD_RESPONSE_TIME, 2.0f);
+		response[2] = pow(LCD_RESPONSE_TIME, 3.0f);
+		response[3] = pow(LCD_RESPONSE_TIME, 4.0f);
+
+		/* Applying each response in turn, i.e.
+		 *    curr += (prev[i] - curr) * response[i]
+		 * amounts to a weighted sum of all five frames:
+		 * each previous frame is weighted by its own
+		 * response times what is left after the ones
+		 * applied after it. Rounding these to fixed
+		 * point, the current frame takes the remainder */
+		float remaining = 1.0f;
+		unsigned weightSum = 0;
+		int i;
+		for (i = 3; i >= 0; i--) {
+			frameBlendWeights[i + 1] = (uint16_t)(remaining * response[i] * (1 << LCD_GHOST_WEIGHT_BITS) + 0.5f);
+			weightSum += frameBlendWeights[i + 1];
+			remaining *= 1.0f - response[i];
+		}
+		frameBlendWeights[0] = (1 << LCD_GHOST_WEIGHT_BITS) - weightSum;
 
 		frameBlendResponseSet = true;
 	}
+}
+
+static void _initFrameBlend(void) {
+
+	frameBlendEnabled = false;
+
+	/* Allocate interframe blending buffers, as required
+	 * NOTE: In all cases, any used buffers are 'reset'
+	 * (filled with 0xFF) to avoid drawing garbage on
+	 * the next frame */
+	switch (frameBlendType) {
+		case FRAME_BLEND_MIX:
+			/* Simple 50:50 blending requires a single buffer */
+			if (!_allocateOutputBufferPrev(&outputBufferPrev1)) {
+				return;
+			}
+			break;
+		case FRAME_BLEND_MIX_SMART:
+			/* Smart 50:50 blending requires three buffers */
+			if (!_allocateOutputBufferPrev(&outputBufferPrev1)) {
+				return;
+			}
+			if (!_allocateOutputBufferPrev(&outputBufferPrev2)) {
+				return;
+			}
+			if (!_allocateOutputBufferPrev(&outputBufferPrev3)) {
+				return;
+			}
+			break;
+		case FRAME_BLEND_LCD_GHOSTING:
+			/* 'Accurate' LCD ghosting requires four buffers */
+			if (!_allocateOutputBufferPrev(&outputBufferPrev1)) {
+				return;
+			}
+			if (!_allocateOutputBufferPrev(&outputBufferPrev2)) {
+				return;
+			}
+			if (!_allocateOutputBufferPrev(&outputBufferPrev3)) {
+				return;
+			}
+			if (!_allocateOutputBufferPrev(&outputBufferPrev4)) {
+				return;
+			}
+			break;
+		case FRAME_BLEND_LCD_GHOSTING_FAST:
+			/* 'Fast' LCD ghosting requires three (RGB)
+			 * 'accumulator' buffers */
+			if (!_allocateOutputBufferAcc()) {
+				return;
+			}
+			break;
+		case FRAME_BLEND_NONE:
+		default:
+			/* Error condition - cannot happen
+			 * > Just leave frameBlendEnabled set to false */
+			return;
+	}
+
+	/* Set LCD ghosting response time factors,
+	 * if required */
+	_initFrameBlendWeights();
 
 	/* If we get this far, then interframe blending is enabled... */
 	frameBlendEnabled = true;
@@ -626,45 +1315,72 @@ static void _loadFrameBlendSettings(void) {
 
 	if (frameBlendType == FRAME_BLEND_NONE) {
 		frameBlendEnabled = false;
+	} else if (hwRenderEnabled) {
+		/* Blended by the GL output pass, from frames
+		 * it keeps on the GPU */
+		_initFrameBlendWeights();
+		frameBlendEnabled = true;
 	} else if (frameBlendType != oldFrameBlendType) {
 		_initFrameBlend();
 	}
+	_trimFrameBlendBuffers();
 }
 
 /* General post processing buffers/functions */
 static color_t* ppOutputBuffer = NULL;
 
-static void (*videoPostProcess)(unsigned width, unsigned height) = NULL;
+static void (*videoPostProcess)(color_t* src, color_t* dst, unsigned width, unsigned height) = NULL;
 
 /* > Note: The individual post processing functions
  *   are somewhat WET (Write Everything Twice), in that
  *   we duplicate the entire nested for loop.
  *   This code is performance-critical, so we want to
- *   minimise logic in the inner loops where possible  */
-static void videoPostProcessCc(unsigned width, unsigned height) {
-
-	color_t *src = outputBuffer;
-	color_t *dst = ppOutputBuffer;
-	size_t x, y;
+ *   minimise logic in the inner loops where possible.
+ *   Each row is mixed eight pixels at a time where
+ *   SSE2 or NEON is available */
+
+/* > "Mixing Packed RGB Pixels Efficiently"
+ *   http://blargg.8bitalley.com/info/rgb_mixing.html */
+static inline color_t _mixPixels(color_t a, color_t b) {
+	return (a + b + ((a ^ b) & 0x821)) >> 1;
+}
 
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			*(dst + x) = *(ccLUT + *(src + x));
-		}
-		src += VIDEO_WIDTH_MAX;
-		dst += VIDEO_WIDTH_MAX;
-	}
+/* The same rounded-up mix, rearranged so that it
+ * cannot overflow 16-bit lanes */
+#if defined(__SSE2__)
+static inline __m128i _mixPixels8(__m128i a, __m128i b) {
+	return _mm_sub_epi16(_mm_or_si128(a, b), _mm_srli_epi16(_mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi16(0xF7DE)), 1));
 }
+#elif defined(__ARM_NEON)
+static inline uint16x8_t _mixPixels8(uint16x8_t a, uint16x8_t b) {
+	return vsubq_u16(vorrq_u16(a, b), vshrq_n_u16(vandq_u16(veorq_u16(a, b), vdupq_n_u16(0xF7DE)), 1));
+}
+#endif
 
-static void videoPostProcessMix(unsigned width, unsigned height) {
+static void videoPostProcessMix(color_t* src, color_t* dst, unsigned width, unsigned height) {
 
-	color_t *srcCurr = outputBuffer;
+	color_t *srcCurr = src;
 	color_t *srcPrev = outputBufferPrev1;
-	color_t *dst     = ppOutputBuffer;
 	size_t x, y;
 
 	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
+		x = 0;
+#if defined(__SSE2__)
+		for (; x + 8 <= width; x += 8) {
+			__m128i rgbCurr = _mm_loadu_si128((const __m128i*) (srcCurr + x));
+			__m128i rgbPrev = _mm_loadu_si128((const __m128i*) (srcPrev + x));
+			_mm_storeu_si128((__m128i*) (srcPrev + x), rgbCurr);
+			_mm_storeu_si128((__m128i*) (dst + x), _mixPixels8(rgbCurr, rgbPrev));
+		}
+#elif defined(__ARM_NEON)
+		for (; x + 8 <= width; x += 8) {
+			uint16x8_t rgbCurr = vld1q_u16(srcCurr + x);
+			uint16x8_t rgbPrev = vld1q_u16(srcPrev + x);
+			vst1q_u16(srcPrev + x, rgbCurr);
+			vst1q_u16(dst + x, _mixPixels8(rgbCurr, rgbPrev));
+		}
+#endif
+		for (; x < width; x++) {
 
 			/* Get colours from current + previous frames */
 			color_t rgbCurr = *(srcCurr + x);
@@ -673,14 +1389,8 @@ static void videoPostProcessMix(unsigned width, unsigned height) {
 			/* Store colours for next frame */
 			*(srcPrev + x)  = rgbCurr;
 
-			/* Mix colours
-			 * > "Mixing Packed RGB Pixels Efficiently"
-			 *   http://blargg.8bitalley.com/info/rgb_mixing.html */
-			color_t rgbMix  = (rgbCurr + rgbPrev + ((rgbCurr ^ rgbPrev) & 0x821)) >> 1;
-
 			/* Assign colours for current frame */
-			*(dst + x)      = colorCorrectionEnabled ?
-					*(ccLUT + rgbMix) : rgbMix;
+			*(dst + x)      = _mixPixels(rgbCurr, rgbPrev);
 		}
 		srcCurr += VIDEO_WIDTH_MAX;
 		srcPrev += VIDEO_WIDTH_MAX;
@@ -688,17 +1398,53 @@ static void videoPostProcessMix(unsigned width, unsigned height) {
 	}
 }
 
-static void videoPostProcessMixSmart(unsigned width, unsigned height) {
+static void videoPostProcessMixSmart(color_t* src, color_t* dst, unsigned width, unsigned height) {
 
-	color_t *srcCurr  = outputBuffer;
+	color_t *srcCurr  = src;
 	color_t *srcPrev1 = outputBufferPrev1;
 	color_t *srcPrev2 = outputBufferPrev2;
 	color_t *srcPrev3 = outputBufferPrev3;
-	color_t *dst      = ppOutputBuffer;
 	size_t x, y;
 
 	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
+		x = 0;
+#if defined(__SSE2__)
+		for (; x + 8 <= width; x += 8) {
+			__m128i rgbCurr  = _mm_loadu_si128((const __m128i*) (srcCurr + x));
+			__m128i rgbPrev1 = _mm_loadu_si128((const __m128i*) (srcPrev1 + x));
+			__m128i rgbPrev2 = _mm_loadu_si128((const __m128i*) (srcPrev2 + x));
+			__m128i rgbPrev3 = _mm_loadu_si128((const __m128i*) (srcPrev3 + x));
+			_mm_storeu_si128((__m128i*) (srcPrev1 + x), rgbCurr);
+			_mm_storeu_si128((__m128i*) (srcPrev2 + x), rgbPrev1);
+			_mm_storeu_si128((__m128i*) (srcPrev3 + x), rgbPrev2);
+
+			/* Lanes where alternate frames match,
+			 * but adjacent frames do not */
+			__m128i alternate = _mm_or_si128(_mm_cmpeq_epi16(rgbCurr, rgbPrev2), _mm_cmpeq_epi16(rgbPrev1, rgbPrev3));
+			__m128i adjacent  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(rgbCurr, rgbPrev1), _mm_cmpeq_epi16(rgbCurr, rgbPrev3)), _mm_cmpeq_epi16(rgbPrev1, rgbPrev2));
+			__m128i mix       = _mm_andnot_si128(adjacent, alternate);
+			__m128i rgbMix    = _mixPixels8(rgbCurr, rgbPrev1);
+			_mm_storeu_si128((__m128i*) (dst + x), _mm_or_si128(_mm_and_si128(mix, rgbMix), _mm_andnot_si128(mix, rgbCurr)));
+		}
+#elif defined(__ARM_NEON)
+		for (; x + 8 <= width; x += 8) {
+			uint16x8_t rgbCurr  = vld1q_u16(srcCurr + x);
+			uint16x8_t rgbPrev1 = vld1q_u16(srcPrev1 + x);
+			uint16x8_t rgbPrev2 = vld1q_u16(srcPrev2 + x);
+			uint16x8_t rgbPrev3 = vld1q_u16(srcPrev3 + x);
+			vst1q_u16(srcPrev1 + x, rgbCurr);
+			vst1q_u16(srcPrev2 + x, rgbPrev1);
+			vst1q_u16(srcPrev3 + x, rgbPrev2);
+
+			/* Lanes where alternate frames match,
+			 * but adjacent frames do not */
+			uint16x8_t alternate = vorrq_u16(vceqq_u16(rgbCurr, rgbPrev2), vceqq_u16(rgbPrev1, rgbPrev3));
+			uint16x8_t adjacent  = vorrq_u16(vorrq_u16(vceqq_u16(rgbCurr, rgbPrev1), vceqq_u16(rgbCurr, rgbPrev3)), vceqq_u16(rgbPrev1, rgbPrev2));
+			uint16x8_t mix       = vbicq_u16(alternate, adjacent);
+			vst1q_u16(dst + x, vbslq_u16(mix, _mixPixels8(rgbCurr, rgbPrev1), rgbCurr));
+		}
+#endif
+		for (; x < width; x++) {
 
 			/* Get colours from current + previous frames */
 			color_t rgbCurr  = *(srcCurr + x);
@@ -719,19 +1465,12 @@ static void videoPostProcessMixSmart(unsigned width, unsigned height) {
 				 (rgbCurr != rgbPrev3) &&
 				 (rgbPrev1 != rgbPrev2)) {
 
-				/* Mix colours
-				 * > "Mixing Packed RGB Pixels Efficiently"
-				 *   http://blargg.8bitalley.com/info/rgb_mixing.html */
-				color_t rgbMix = (rgbCurr + rgbPrev1 + ((rgbCurr ^ rgbPrev1) & 0x821)) >> 1;
-
-				/* Assign colours for current frame */
-				*(dst + x) = colorCorrectionEnabled ?
-						*(ccLUT + rgbMix) : rgbMix;
+				/* Assign mixed colours for current frame */
+				*(dst + x) = _mixPixels(rgbCurr, rgbPrev1);
 
 			} else {
 				/* Just use colours for current frame */
-				*(dst + x) = colorCorrectionEnabled ?
-						*(ccLUT + rgbCurr) :	rgbCurr;
+				*(dst + x) = rgbCurr;
 			}
 		}
 		srcCurr  += VIDEO_WIDTH_MAX;
@@ -742,19 +1481,80 @@ static void videoPostProcessMixSmart(unsigned width, unsigned height) {
 	}
 }
 
-static void videoPostProcessLcdGhost(unsigned width, unsigned height) {
+/* Vector helper for the LCD ghosting filters: one
+ * 5-bit channel of eight pixels */
+#if defined(__SSE2__)
+static inline __m128i _channel8(__m128i rgb, int shift) {
+	return _mm_and_si128(_mm_srl_epi16(rgb, _mm_cvtsi32_si128(shift)), _mm_set1_epi16(0x1F));
+}
+#elif defined(__ARM_NEON)
+static inline uint16x8_t _channel8(uint16x8_t rgb, int shift) {
+	return vandq_u16(vshlq_u16(rgb, vdupq_n_s16(-shift)), vdupq_n_u16(0x1F));
+}
+#endif
+
+static void videoPostProcessLcdGhost(color_t* src, color_t* dst, unsigned width, unsigned height) {
 
-	color_t *srcCurr  = outputBuffer;
+	color_t *srcCurr  = src;
 	color_t *srcPrev1 = outputBufferPrev1;
 	color_t *srcPrev2 = outputBufferPrev2;
 	color_t *srcPrev3 = outputBufferPrev3;
 	color_t *srcPrev4 = outputBufferPrev4;
-	color_t *dst      = ppOutputBuffer;
-	float *response   = frameBlendResponse;
+	uint16_t *weight  = frameBlendWeights;
 	size_t x, y;
 
 	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
+		x = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+		for (; x + 8 <= width; x += 8) {
+			static const int shifts[3] = { 11, 6, 0 };
+			int c, i;
+#if defined(__SSE2__)
+			__m128i rgb[5];
+			rgb[0] = _mm_loadu_si128((const __m128i*) (srcCurr + x));
+			rgb[1] = _mm_loadu_si128((const __m128i*) (srcPrev1 + x));
+			rgb[2] = _mm_loadu_si128((const __m128i*) (srcPrev2 + x));
+			rgb[3] = _mm_loadu_si128((const __m128i*) (srcPrev3 + x));
+			rgb[4] = _mm_loadu_si128((const __m128i*) (srcPrev4 + x));
+			_mm_storeu_si128((__m128i*) (srcPrev1 + x), rgb[0]);
+			_mm_storeu_si128((__m128i*) (srcPrev2 + x), rgb[1]);
+			_mm_storeu_si128((__m128i*) (srcPrev3 + x), rgb[2]);
+			_mm_storeu_si128((__m128i*) (srcPrev4 + x), rgb[3]);
+			__m128i rgbMix = _mm_setzero_si128();
+			for (c = 0; c < 3; c++) {
+				__m128i mix = _mm_set1_epi16(1 << (LCD_GHOST_WEIGHT_BITS - 1));
+				for (i = 0; i < 5; i++) {
+					mix = _mm_add_epi16(mix, _mm_mullo_epi16(_channel8(rgb[i], shifts[c]), _mm_set1_epi16(*(weight + i))));
+				}
+				mix = _mm_srli_epi16(mix, LCD_GHOST_WEIGHT_BITS);
+				rgbMix = _mm_or_si128(rgbMix, _mm_sll_epi16(mix, _mm_cvtsi32_si128(shifts[c])));
+			}
+			_mm_storeu_si128((__m128i*) (dst + x), rgbMix);
+#else
+			uint16x8_t rgb[5];
+			rgb[0] = vld1q_u16(srcCurr + x);
+			rgb[1] = vld1q_u16(srcPrev1 + x);
+			rgb[2] = vld1q_u16(srcPrev2 + x);
+			rgb[3] = vld1q_u16(srcPrev3 + x);
+			rgb[4] = vld1q_u16(srcPrev4 + x);
+			vst1q_u16(srcPrev1 + x, rgb[0]);
+			vst1q_u16(srcPrev2 + x, rgb[1]);
+			vst1q_u16(srcPrev3 + x, rgb[2]);
+			vst1q_u16(srcPrev4 + x, rgb[3]);
+			uint16x8_t rgbMix = vdupq_n_u16(0);
+			for (c = 0; c < 3; c++) {
+				uint16x8_t mix = vdupq_n_u16(1 << (LCD_GHOST_WEIGHT_BITS - 1));
+				for (i = 0; i < 5; i++) {
+					mix = vmlaq_n_u16(mix, _channel8(rgb[i], shifts[c]), *(weight + i));
+				}
+				mix = vshrq_n_u16(mix, LCD_GHOST_WEIGHT_BITS);
+				rgbMix = vorrq_u16(rgbMix, vshlq_u16(mix, vdupq_n_s16(shifts[c])));
+			}
+			vst1q_u16(dst + x, rgbMix);
+#endif
+		}
+#endif
+		for (; x < width; x++) {
 
 			/* Get colours from current + previous frames */
 			color_t rgbCurr  = *(srcCurr + x);
@@ -769,54 +1569,36 @@ static void videoPostProcessLcdGhost(unsigned width, unsigned height) {
 			*(srcPrev3 + x) = rgbPrev2;
 			*(srcPrev4 + x) = rgbPrev3;
 
-			/* Unpack colours and convert to float */
-			float rCurr = (float)(rgbCurr >> 11 & 0x1F);
-			float gCurr = (float)(rgbCurr >>  6 & 0x1F);
-			float bCurr = (float)(rgbCurr       & 0x1F);
-
-			float rPrev1 = (float)(rgbPrev1 >> 11 & 0x1F);
-			float gPrev1 = (float)(rgbPrev1 >>  6 & 0x1F);
-			float bPrev1 = (float)(rgbPrev1       & 0x1F);
-
-			float rPrev2 = (float)(rgbPrev2 >> 11 & 0x1F);
-			float gPrev2 = (float)(rgbPrev2 >>  6 & 0x1F);
-			float bPrev2 = (float)(rgbPrev2       & 0x1F);
-
-			float rPrev3 = (float)(rgbPrev3 >> 11 & 0x1F);
-			float gPrev3 = (float)(rgbPrev3 >>  6 & 0x1F);
-			float bPrev3 = (float)(rgbPrev3       & 0x1F);
-
-			float rPrev4 = (float)(rgbPrev4 >> 11 & 0x1F);
-			float gPrev4 = (float)(rgbPrev4 >>  6 & 0x1F);
-			float bPrev4 = (float)(rgbPrev4       & 0x1F);
-
-			/* Mix colours for current frame and convert back to color_t
+			/* Mix colours for current frame
 			 * > Response time effect implemented via an exponential
 			 *   drop-off algorithm, taken from the 'Gameboy Classic Shader'
 			 *   by Harlequin:
-			 *      https://github.com/libretro/glsl-shaders/blob/master/handheld/shaders/gameboy/shader-files/gb-pass0.glsl */
-			rCurr += (rPrev1 - rCurr) * *response;
-			rCurr += (rPrev2 - rCurr) * *(response + 1);
-			rCurr += (rPrev3 - rCurr) * *(response + 2);
-			rCurr += (rPrev4 - rCurr) * *(response + 3);
-			color_t rMix = (color_t)(rCurr + 0.5f) & 0x1F;
-
-			gCurr += (gPrev1 - gCurr) * *response;
-			gCurr += (gPrev2 - gCurr) * *(response + 1);
-			gCurr += (gPrev3 - gCurr) * *(response + 2);
-			gCurr += (gPrev4 - gCurr) * *(response + 3);
-			color_t gMix = (color_t)(gCurr + 0.5f) & 0x1F;
-
-			bCurr += (bPrev1 - bCurr) * *response;
-			bCurr += (bPrev2 - bCurr) * *(response + 1);
-			bCurr += (bPrev3 - bCurr) * *(response + 2);
-			bCurr += (bPrev4 - bCurr) * *(response + 3);
-			color_t bMix = (color_t)(bCurr + 0.5f) & 0x1F;
-
-			/* Repack colours for current frame */
-			*(dst + x) = colorCorrectionEnabled ?
-					*(ccLUT + (rMix << 11 | gMix << 6 | bMix)) :
-							rMix << 11 | gMix << 6 | bMix;
+			 *      https://github.com/libretro/glsl-shaders/blob/master/handheld/shaders/gameboy/shader-files/gb-pass0.glsl
+			 * > The successive drop-offs are folded into one
+			 *   fixed-point weight per frame, see _initFrameBlend() */
+			unsigned rMix = (rgbCurr  >> 11 & 0x1F) * *weight
+			              + (rgbPrev1 >> 11 & 0x1F) * *(weight + 1)
+			              + (rgbPrev2 >> 11 & 0x1F) * *(weight + 2)
+			              + (rgbPrev3 >> 11 & 0x1F) * *(weight + 3)
+			              + (rgbPrev4 >> 11 & 0x1F) * *(weight + 4);
+
+			unsigned gMix = (rgbCurr  >>  6 & 0x1F) * *weight
+			              + (rgbPrev1 >>  6 & 0x1F) * *(weight + 1)
+			              + (rgbPrev2 >>  6 & 0x1F) * *(weight + 2)
+			              + (rgbPrev3 >>  6 & 0x1F) * *(weight + 3)
+			              + (rgbPrev4 >>  6 & 0x1F) * *(weight + 4);
+
+			unsigned bMix = (rgbCurr        & 0x1F) * *weight
+			              + (rgbPrev1       & 0x1F) * *(weight + 1)
+			              + (rgbPrev2       & 0x1F) * *(weight + 2)
+			              + (rgbPrev3       & 0x1F) * *(weight + 3)
+			              + (rgbPrev4       & 0x1F) * *(weight + 4);
+
+			/* Round and repack colours for current frame */
+			rMix = (rMix + (1 << (LCD_GHOST_WEIGHT_BITS - 1))) >> LCD_GHOST_WEIGHT_BITS;
+			gMix = (gMix + (1 << (LCD_GHOST_WEIGHT_BITS - 1))) >> LCD_GHOST_WEIGHT_BITS;
+			bMix = (bMix + (1 << (LCD_GHOST_WEIGHT_BITS - 1))) >> LCD_GHOST_WEIGHT_BITS;
+			*(dst + x) = rMix << 11 | gMix << 6 | bMix;
 		}
 		srcCurr  += VIDEO_WIDTH_MAX;
 		srcPrev1 += VIDEO_WIDTH_MAX;
@@ -827,47 +1609,73 @@ static void videoPostProcessLcdGhost(unsigned width, unsigned height) {
 	}
 }
 
-static void videoPostProcessLcdGhostFast(unsigned width, unsigned height) {
+static void videoPostProcessLcdGhostFast(color_t* src, color_t* dst, unsigned width, unsigned height) {
 
-	color_t *srcCurr = outputBuffer;
-	float *srcPrevR  = outputBufferAccR;
-	float *srcPrevG  = outputBufferAccG;
-	float *srcPrevB  = outputBufferAccB;
-	color_t *dst     = ppOutputBuffer;
+	color_t *srcCurr   = src;
+	uint16_t *srcPrevR = outputBufferAccR;
+	uint16_t *srcPrevG = outputBufferAccG;
+	uint16_t *srcPrevB = outputBufferAccB;
 	size_t x, y;
 
 	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
+		x = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+		for (; x + 8 <= width; x += 8) {
+			static const int shifts[3] = { 11, 6, 0 };
+			uint16_t *srcPrev[3] = { srcPrevR + x, srcPrevG + x, srcPrevB + x };
+			int c;
+#if defined(__SSE2__)
+			__m128i rgbCurr = _mm_loadu_si128((const __m128i*) (srcCurr + x));
+			__m128i rgbMix  = _mm_setzero_si128();
+			for (c = 0; c < 3; c++) {
+				__m128i acc = _mm_loadu_si128((const __m128i*) srcPrev[c]);
+				acc = _mm_avg_epu16(_mm_slli_epi16(_channel8(rgbCurr, shifts[c]), LCD_GHOST_ACC_BITS), acc);
+				_mm_storeu_si128((__m128i*) srcPrev[c], acc);
+				acc = _mm_srli_epi16(_mm_add_epi16(acc, _mm_set1_epi16(1 << (LCD_GHOST_ACC_BITS - 1))), LCD_GHOST_ACC_BITS);
+				rgbMix = _mm_or_si128(rgbMix, _mm_sll_epi16(acc, _mm_cvtsi32_si128(shifts[c])));
+			}
+			_mm_storeu_si128((__m128i*) (dst + x), rgbMix);
+#else
+			uint16x8_t rgbCurr = vld1q_u16(srcCurr + x);
+			uint16x8_t rgbMix  = vdupq_n_u16(0);
+			for (c = 0; c < 3; c++) {
+				uint16x8_t acc = vld1q_u16(srcPrev[c]);
+				acc = vrhaddq_u16(vshlq_n_u16(_channel8(rgbCurr, shifts[c]), LCD_GHOST_ACC_BITS), acc);
+				vst1q_u16(srcPrev[c], acc);
+				acc = vshrq_n_u16(vaddq_u16(acc, vdupq_n_u16(1 << (LCD_GHOST_ACC_BITS - 1))), LCD_GHOST_ACC_BITS);
+				rgbMix = vorrq_u16(rgbMix, vshlq_u16(acc, vdupq_n_s16(shifts[c])));
+			}
+			vst1q_u16(dst + x, rgbMix);
+#endif
+		}
+#endif
+		for (; x < width; x++) {
 
 			/* Get colours from current + previous frames */
 			color_t rgbCurr = *(srcCurr + x);
-			float rPrev     = *(srcPrevR + x);
-			float gPrev     = *(srcPrevG + x);
-			float bPrev     = *(srcPrevB + x);
+			unsigned rPrev  = *(srcPrevR + x);
+			unsigned gPrev  = *(srcPrevG + x);
+			unsigned bPrev  = *(srcPrevB + x);
 
-			/* Unpack current colours and convert to float */
-			float rCurr = (float)(rgbCurr >> 11 & 0x1F);
-			float gCurr = (float)(rgbCurr >>  6 & 0x1F);
-			float bCurr = (float)(rgbCurr       & 0x1F);
+			/* Unpack current colours */
+			unsigned rCurr = (rgbCurr >> 11 & 0x1F) << LCD_GHOST_ACC_BITS;
+			unsigned gCurr = (rgbCurr >>  6 & 0x1F) << LCD_GHOST_ACC_BITS;
+			unsigned bCurr = (rgbCurr       & 0x1F) << LCD_GHOST_ACC_BITS;
 
 			/* Mix colours for current frame */
-			float rMix = (rCurr * (1.0f - LCD_RESPONSE_TIME_FAKE)) + (LCD_RESPONSE_TIME_FAKE * rPrev);
-			float gMix = (gCurr * (1.0f - LCD_RESPONSE_TIME_FAKE)) + (LCD_RESPONSE_TIME_FAKE * gPrev);
-			float bMix = (bCurr * (1.0f - LCD_RESPONSE_TIME_FAKE)) + (LCD_RESPONSE_TIME_FAKE * bPrev);
+			unsigned rMix = (rCurr + rPrev + 1) >> 1;
+			unsigned gMix = (gCurr + gPrev + 1) >> 1;
+			unsigned bMix = (bCurr + bPrev + 1) >> 1;
 
 			/* Store colours for next frame */
 			*(srcPrevR + x) = rMix;
 			*(srcPrevG + x) = gMix;
 			*(srcPrevB + x) = bMix;
 
-			/* Convert and repack current frame colours */
-			color_t rgbMix =   ((color_t)(rMix + 0.5f) & 0x1F) << 11
-								  | ((color_t)(gMix + 0.5f) & 0x1F) << 6
-								  | ((color_t)(bMix + 0.5f) & 0x1F);
-
-			/* Assign colours for current frame */
-			*(dst + x) = colorCorrectionEnabled ?
-					*(ccLUT + rgbMix) : rgbMix;
+			/* Round and repack current frame colours */
+			*(dst + x) =   ((rMix + (1 << (LCD_GHOST_ACC_BITS - 1))) >> LCD_GHOST_ACC_BITS) << 11
+			             | ((gMix + (1 << (LCD_GHOST_ACC_BITS - 1))) >> LCD_GHOST_ACC_BITS) << 6
+			             | ((bMix + (1 << (LCD_GHOST_ACC_BITS - 1))) >> LCD_GHOST_ACC_BITS);
 		}
 		srcCurr  += VIDEO_WIDTH_MAX;
 		srcPrevR += VIDEO_WIDTH_MAX;
@@ -877,12 +1685,159 @@ static void videoPostProcessLcdGhostFast(unsigned width, unsigned height) {
 	}
 }
 
+#ifndef DISABLE_THREADING
+/* Post processing of frame N may instead run on a
+ * helper thread while frame N+1 is being emulated.
+ * The core's output is copied aside for it, so the
+ * core can draw straight over it, and the two output
+ * buffers take turns: one is filled by the helper
+ * while the other is presented. Each frame is thus
+ * shown one frame later than it would otherwise be */
+static bool ppThreadActive               = false;
+static bool ppThreadExiting              = false;
+static bool ppThreadBusy                 = false;
+static Thread ppThread;
+static Mutex ppThreadMutex;
+static Condition ppThreadStartCond;
+static Condition ppThreadDoneCond;
+static color_t* ppInputBuffer            = NULL;
+static color_t* ppOutputBufferBack       = NULL;
+/* Buffer holding the latest frame handed to the
+ * helper, which has not been presented yet */
+static color_t* ppThreadTarget           = NULL;
+static unsigned ppThreadWidth            = 0;
+static unsigned ppThreadHeight           = 0;
+
+static THREAD_ENTRY _ppThreadRun(void* context) {
+	UNUSED(context);
+	ThreadSetName("Post processing");
+
+	MutexLock(&ppThreadMutex);
+	while (true) {
+		while (!ppThreadBusy && !ppThreadExiting) {
+			ConditionWait(&ppThreadStartCond, &ppThreadMutex);
+		}
+		if (ppThreadExiting) {
+			break;
+		}
+		MutexUnlock(&ppThreadMutex);
+		videoPostProcess(ppInputBuffer, ppThreadTarget, ppThreadWidth, ppThreadHeight);
+		MutexLock(&ppThreadMutex);
+		ppThreadBusy = false;
+		ConditionWake(&ppThreadDoneCond);
+	}
+	MutexUnlock(&ppThreadMutex);
+	return 0;
+}
+
+static void _ppThreadWait(void) {
+	MutexLock(&ppThreadMutex);
+	while (ppThreadBusy) {
+		ConditionWait(&ppThreadDoneCond, &ppThreadMutex);
+	}
+	MutexUnlock(&ppThreadMutex);
+}
+
+/* Waits for the frame in flight, if any, and
+ * returns it. It will not be returned again */
+static color_t* _ppThreadFlush(unsigned* width, unsigned* height) {
+	if (!ppThreadActive || !ppThreadTarget) {
+		return NULL;
+	}
+	_ppThreadWait();
+
+	color_t* frame = ppThreadTarget;
+	*width         = ppThreadWidth;
+	*height        = ppThreadHeight;
+	ppThreadTarget = NULL;
+	return frame;
+}
+
+/* Hands the frame the core just drew to the helper,
+ * and returns the previous one, now post processed.
+ * Returns NULL if there was no previous frame */
+static color_t* _ppThreadExchange(unsigned* width, unsigned* height) {
+	unsigned frameWidth  = *width;
+	unsigned frameHeight = *height;
+	color_t* frame       = _ppThreadFlush(width, height);
+	size_t y;
+
+	for (y = 0; y < frameHeight; y++) {
+		memcpy(&ppInputBuffer[y * VIDEO_WIDTH_MAX], &outputBuffer[y * VIDEO_WIDTH_MAX], frameWidth * sizeof(color_t));
+	}
+
+	MutexLock(&ppThreadMutex);
+	ppThreadTarget = frame == ppOutputBuffer ? ppOutputBufferBack : ppOutputBuffer;
+	ppThreadWidth  = frameWidth;
+	ppThreadHeight = frameHeight;
+	ppThreadBusy   = true;
+	ConditionWake(&ppThreadStartCond);
+	MutexUnlock(&ppThreadMutex);
+
+	return frame;
+}
+
+static void _deinitPostProcessThread(void) {
+	if (ppThreadActive) {
+		MutexLock(&ppThreadMutex);
+		ppThreadExiting = true;
+		ConditionWake(&ppThreadStartCond);
+		MutexUnlock(&ppThreadMutex);
+		ThreadJoin(&ppThread);
+
+		ConditionDeinit(&ppThreadDoneCond);
+		ConditionDeinit(&ppThreadStartCond);
+		MutexDeinit(&ppThreadMutex);
+		ppThreadActive = false;
+	}
+	ppThreadTarget = NULL;
+	_freeOutputBufferPrev(&ppInputBuffer);
+	_freeOutputBufferPrev(&ppOutputBufferBack);
+}
+
+/* Must only be called once videoPostProcess and
+ * ppOutputBuffer are set up */
+static void _initPostProcessThread(void) {
+	if (ppThreadActive) {
+		return;
+	}
+	if (!_allocateOutputBufferPrev(&ppInputBuffer) ||
+	    !_allocateOutputBufferPrev(&ppOutputBufferBack)) {
+		_deinitPostProcessThread();
+		return;
+	}
+
+	MutexInit(&ppThreadMutex);
+	ConditionInit(&ppThreadStartCond);
+	ConditionInit(&ppThreadDoneCond);
+	ppThreadExiting = false;
+	ppThreadBusy    = false;
+	ppThreadTarget  = NULL;
+	if (ThreadCreate(&ppThread, _ppThreadRun, NULL)) {
+		ConditionDeinit(&ppThreadDoneCond);
+		ConditionDeinit(&ppThreadStartCond);
+		MutexDeinit(&ppThreadMutex);
+		_deinitPostProcessThread();
+		return;
+	}
+	ppThreadActive = true;
+}
+#endif
+
 static void _initPostProcessing(void) {
 
 	/* Early return if all post processing elements
 	 * are disabled */
 	videoPostProcess = NULL;
-	if (!colorCorrectionEnabled && !frameBlendEnabled) {
+	if (!frameBlendEnabled) {
+		if (lowMemoryProfile && ppOutputBuffer) {
+#ifdef _3DS
+			linearFree(ppOutputBuffer);
+#else
+			free(ppOutputBuffer);
+#endif
+			ppOutputBuffer = NULL;
+		}
 		return;
 	}
 
@@ -917,34 +1872,299 @@ static void _initPostProcessing(void) {
 			case FRAME_BLEND_NONE:
 			default:
 				/* Cannot happen */
-				videoPostProcess = colorCorrectionEnabled ?
-						videoPostProcessCc : NULL;
 				return;
 		}
-	} else if (colorCorrectionEnabled) {
-		videoPostProcess = videoPostProcessCc;
 	}
 }
 
 static void _loadPostProcessingSettings(void) {
 
+#ifndef DISABLE_THREADING
+	/* The helper thread must not touch any buffers
+	 * while they are set up again. Whatever frame it
+	 * has in flight is dropped */
+	if (ppThreadActive) {
+		_ppThreadWait();
+		ppThreadTarget = NULL;
+	}
+#endif
+
 	/* Load settings and initialise individual
 	 * post processing elements */
-	_loadColorCorrectionSettings();
 	_loadFrameBlendSettings();
 
 	/* Initialise post processing buffers/functions
 	 * based on configured options */
 	_initPostProcessing();
+
+#ifndef DISABLE_THREADING
+	struct retro_variable var;
+	var.key   = "mgba_post_processing_thread";
+	var.value = 0;
+	bool threaded = environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value && strcmp(var.value, "ON") == 0;
+	/* The frame time governor has to see what post
+	 * processing costs, so it always runs inline */
+	if (threaded && videoPostProcess && frameskipType != 4) {
+		_initPostProcessThread();
+	} else {
+		_deinitPostProcessThread();
+	}
+#endif
+
+	/* Output may differ even if the core's doesn't */
+	unchangedFrames = 0;
+}
+
+/* Returns the number of previous frames that
+ * post processing blends into the current one.
+ * Output only stops changing once the core has
+ * repeated a frame one more time than this */
+static unsigned _postProcessHistory(void) {
+
+	if (!videoPostProcess || !frameBlendEnabled) {
+		return 0;
+	}
+
+	switch (frameBlendType) {
+		case FRAME_BLEND_MIX:
+			return 1;
+		case FRAME_BLEND_MIX_SMART:
+			return 3;
+		case FRAME_BLEND_LCD_GHOSTING:
+			return 4;
+		case FRAME_BLEND_LCD_GHOSTING_FAST:
+			/* Each frame halves (rounding up) the distance
+			 * of a 16-bit accumulator from its target,
+			 * which leaves it fixed after sixteen */
+			return 16;
+		default:
+			return UINT_MAX;
+	}
+}
+
+/* Output scaling */
+enum output_scale_method {
+	OUTPUT_SCALE_NONE = 0,
+	OUTPUT_SCALE_INTEGER,
+	OUTPUT_SCALE_NEAREST,
+	OUTPUT_SCALE_BILINEAR
+};
+
+static enum output_scale_method outputScaleType = OUTPUT_SCALE_NONE;
+static color_t* scaledOutputBuffer = NULL;
+
+/* Source dimensions and method the tables below
+ * were built for */
+static unsigned scaleSourceWidth  = 0;
+static unsigned scaleSourceHeight = 0;
+static enum output_scale_method scaleTableType = OUTPUT_SCALE_NONE;
+
+/* Picture rectangle within the scaled output, and
+ * for each of its columns and rows the source pixel
+ * and the 5-bit weight of the one after it */
+static unsigned scaleX;
+static unsigned scaleY;
+static unsigned scaleWidth;
+static unsigned scaleHeight;
+static uint16_t scaleColumn[VIDEO_SCALED_WIDTH];
+static uint8_t scaleColumnWeight[VIDEO_SCALED_WIDTH];
+static uint16_t scaleRow[VIDEO_SCALED_HEIGHT];
+static uint8_t scaleRowWeight[VIDEO_SCALED_HEIGHT];
+static bool scaleColumnsIdentity;
+
+static void _buildScaleAxis(uint16_t* index, uint8_t* weight, unsigned from, unsigned to, bool filter) {
+	unsigned i;
+	for (i = 0; i < to; ++i) {
+		/* Sample at the centre of each output pixel */
+		if (!filter) {
+			index[i] = (2 * i + 1) * from / (2 * to);
+			weight[i] = 0;
+			continue;
+		}
+		int32_t pos = (int32_t) ((((uint64_t) (2 * i + 1) * from) << 16) / (2 * to)) - 0x8000;
+		if (pos < 0) {
+			pos = 0;
+		}
+		index[i] = pos >> 16;
+		weight[i] = (pos >> 11) & 0x1F;
+		if (index[i] >= from - 1) {
+			index[i] = from - 1;
+			weight[i] = 0;
+		}
+	}
+}
+
+static void _buildScaleTables(unsigned width, unsigned height) {
+	scaleSourceWidth  = width;
+	scaleSourceHeight = height;
+	scaleTableType    = outputScaleType;
+
+	if (outputScaleType == OUTPUT_SCALE_INTEGER) {
+		unsigned factor = VIDEO_SCALED_WIDTH / width;
+		if (VIDEO_SCALED_HEIGHT / height < factor) {
+			factor = VIDEO_SCALED_HEIGHT / height;
+		}
+		if (factor) {
+			scaleWidth  = width * factor;
+			scaleHeight = height * factor;
+		} else if (width * VIDEO_SCALED_HEIGHT > height * VIDEO_SCALED_WIDTH) {
+			/* Too large for even one to one: shrink it,
+			 * keeping the aspect ratio */
+			scaleWidth  = VIDEO_SCALED_WIDTH;
+			scaleHeight = height * VIDEO_SCALED_WIDTH / width;
+		} else {
+			scaleWidth  = width * VIDEO_SCALED_HEIGHT / height;
+			scaleHeight = VIDEO_SCALED_HEIGHT;
+		}
+	} else {
+		scaleWidth  = VIDEO_SCALED_WIDTH;
+		scaleHeight = VIDEO_SCALED_HEIGHT;
+	}
+	scaleX = (VIDEO_SCALED_WIDTH - scaleWidth) / 2;
+	scaleY = (VIDEO_SCALED_HEIGHT - scaleHeight) / 2;
+
+	bool filter = outputScaleType == OUTPUT_SCALE_BILINEAR;
+	_buildScaleAxis(scaleColumn, scaleColumnWeight, width, scaleWidth, filter);
+	_buildScaleAxis(scaleRow, scaleRowWeight, height, scaleHeight, filter);
+
+	scaleColumnsIdentity = scaleWidth == width;
+
+	/* Borders stay black */
+	memset(scaledOutputBuffer, 0, VIDEO_SCALED_WIDTH * VIDEO_SCALED_HEIGHT * sizeof(color_t));
+}
+
+static inline color_t _blendPixels(uint32_t a, uint32_t b, unsigned weight) {
+	/* Spread the channels out so that all three
+	 * can be weighted by one multiplication */
+	a = (a | (a << 16)) & 0x07E0F81F;
+	b = (b | (b << 16)) & 0x07E0F81F;
+	uint32_t mix = ((a * (32 - weight) + b * weight) >> 5) & 0x07E0F81F;
+	return mix | (mix >> 16);
+}
+
+static void _blendRows(color_t* dst, const color_t* a, const color_t* b, unsigned width, unsigned weight) {
+	unsigned x = 0;
+#if defined(__SSE2__)
+	const __m128i wa = _mm_set1_epi16(32 - weight);
+	const __m128i wb = _mm_set1_epi16(weight);
+	const __m128i green = _mm_set1_epi16(0x3F);
+	const __m128i blue = _mm_set1_epi16(0x1F);
+	for (; x + 8 <= width; x += 8) {
+		__m128i pa = _mm_loadu_si128((const __m128i*) &a[x]);
+		__m128i pb = _mm_loadu_si128((const __m128i*) &b[x]);
+		__m128i r = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_srli_epi16(pa, 11), wa), _mm_mullo_epi16(_mm_srli_epi16(pb, 11), wb)), 5);
+		__m128i g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(pa, 5), green), wa), _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(pb, 5), green), wb)), 5);
+		__m128i bl = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(pa, blue), wa), _mm_mullo_epi16(_mm_and_si128(pb, blue), wb)), 5);
+		__m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), bl);
+		_mm_storeu_si128((__m128i*) &dst[x], out);
+	}
+#elif defined(__ARM_NEON)
+	const uint16x8_t wa = vdupq_n_u16(32 - weight);
+	const uint16x8_t wb = vdupq_n_u16(weight);
+	const uint16x8_t green = vdupq_n_u16(0x3F);
+	const uint16x8_t blue = vdupq_n_u16(0x1F);
+	for (; x + 8 <= width; x += 8) {
+		uint16x8_t pa = vld1q_u16(&a[x]);
+		uint16x8_t pb = vld1q_u16(&b[x]);
+		uint16x8_t r = vshrq_n_u16(vmlaq_u16(vmulq_u16(vshrq_n_u16(pa, 11), wa), vshrq_n_u16(pb, 11), wb), 5);
+		uint16x8_t g = vshrq_n_u16(vmlaq_u16(vmulq_u16(vandq_u16(vshrq_n_u16(pa, 5), green), wa), vandq_u16(vshrq_n_u16(pb, 5), green), wb), 5);
+		uint16x8_t bl = vshrq_n_u16(vmlaq_u16(vmulq_u16(vandq_u16(pa, blue), wa), vandq_u16(pb, blue), wb), 5);
+		vst1q_u16(&dst[x], vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), bl));
+	}
+#endif
+	for (; x < width; ++x) {
+		dst[x] = _blendPixels(a[x], b[x], weight);
+	}
+}
+
+static void _scaleRow(color_t* dst, const color_t* src) {
+	unsigned x;
+	for (x = 0; x < scaleWidth; ++x) {
+		unsigned weight = scaleColumnWeight[x];
+		const color_t* pixel = &src[scaleColumn[x]];
+		dst[x] = weight ? _blendPixels(pixel[0], pixel[1], weight) : pixel[0];
+	}
+}
+
+static void _scaleOutput(const color_t* src, size_t stride, unsigned width, unsigned height) {
+	if (width != scaleSourceWidth || height != scaleSourceHeight || outputScaleType != scaleTableType) {
+		_buildScaleTables(width, height);
+	}
+
+	color_t blended[VIDEO_WIDTH_MAX];
+	color_t* dst = &scaledOutputBuffer[scaleY * VIDEO_SCALED_WIDTH + scaleX];
+	unsigned y;
+	for (y = 0; y < scaleHeight; ++y, dst += VIDEO_SCALED_WIDTH) {
+		/* Upscaling repeats rows: copy the one above */
+		if (y && scaleRow[y] == scaleRow[y - 1] && scaleRowWeight[y] == scaleRowWeight[y - 1]) {
+			memcpy(dst, dst - VIDEO_SCALED_WIDTH, scaleWidth * sizeof(color_t));
+			continue;
+		}
+		const color_t* row = &src[scaleRow[y] * stride];
+		if (scaleRowWeight[y]) {
+			_blendRows(blended, row, row + stride, width, scaleRowWeight[y]);
+			row = blended;
+		}
+		if (scaleColumnsIdentity) {
+			memcpy(dst, row, width * sizeof(color_t));
+		} else {
+			_scaleRow(dst, row);
+		}
+	}
+}
+
+static void _initOutputScale(void) {
+	if (outputScaleType == OUTPUT_SCALE_NONE || scaledOutputBuffer) {
+		return;
+	}
+	scaledOutputBuffer = malloc(VIDEO_SCALED_WIDTH * VIDEO_SCALED_HEIGHT * sizeof(color_t));
+	if (!scaledOutputBuffer) {
+		outputScaleType = OUTPUT_SCALE_NONE;
+		return;
+	}
+	/* Force the tables and borders to be rebuilt */
+	scaleSourceWidth = 0;
+}
+
+/* Returns true if the output geometry changed */
+static bool _loadOutputScaleSettings(void) {
+
+	struct retro_variable var;
+	enum output_scale_method oldOutputScaleType = outputScaleType;
+	outputScaleType = OUTPUT_SCALE_NONE;
+
+	var.key = "mgba_output_scale";
+	var.value = 0;
+
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		if (strcmp(var.value, "integer") == 0) {
+			outputScaleType = OUTPUT_SCALE_INTEGER;
+		} else if (strcmp(var.value, "nearest") == 0) {
+			outputScaleType = OUTPUT_SCALE_NEAREST;
+		} else if (strcmp(var.value, "bilinear") == 0) {
+			outputScaleType = OUTPUT_SCALE_BILINEAR;
+		}
+	}
+
+	_initOutputScale();
+
+	/* Output may differ even if the core's doesn't */
+	if (outputScaleType != oldOutputScaleType) {
+		unchangedFrames = 0;
+	}
+	return (outputScaleType == OUTPUT_SCALE_NONE) != (oldOutputScaleType == OUTPUT_SCALE_NONE);
 }
 
 static void _deinitPostProcessing(void) {
 
-	ccType                 = 0;
+#ifndef DISABLE_THREADING
+	_deinitPostProcessThread();
+#endif
+
 	frameBlendType         = FRAME_BLEND_NONE;
-	colorCorrectionEnabled = false;
 	frameBlendEnabled      = false;
 	videoPostProcess       = NULL;
+	outputScaleType        = OUTPUT_SCALE_NONE;
 
 	/* Free all allocated buffers */
 	if (ppOutputBuffer) {
@@ -956,50 +2176,634 @@ static void _deinitPostProcessing(void) {
 		ppOutputBuffer = NULL;
 	}
 
-	/* > Colour correction */
-	if (ccLUT) {
-		free(ccLUT);
-		ccLUT = NULL;
+	if (scaledOutputBuffer) {
+		free(scaledOutputBuffer);
+		scaledOutputBuffer = NULL;
 	}
 
 	/* > Interframe blending */
-	if (outputBufferPrev1) {
-		free(outputBufferPrev1);
-		outputBufferPrev1 = NULL;
+	_freeOutputBufferPrev(&outputBufferPrev1);
+	_freeOutputBufferPrev(&outputBufferPrev2);
+	_freeOutputBufferPrev(&outputBufferPrev3);
+	_freeOutputBufferPrev(&outputBufferPrev4);
+	_freeOutputBufferAcc();
+}
+
+#endif
+
+/* Hardware rendering
+ * > The core's GL renderer draws each frame into
+ *   hwOutputTex, and a final pass draws that into
+ *   the frontend's framebuffer. Colour correction
+ *   and interframe blending are done by that pass,
+ *   with previous frames kept in textures rather
+ *   than the post processing buffers */
+#ifdef HAVE_HW_RENDER
+
+#define HW_HISTORY_MAX 4
+
+static struct retro_hw_render_callback hwRender;
+static unsigned hwRenderScale = 1;
+static bool hwRenderActive    = false;
+static GLuint hwOutputTex     = 0;
+static GLuint hwHistoryTex[HW_HISTORY_MAX];
+static GLuint hwHistoryFbo[HW_HISTORY_MAX];
+static unsigned hwHistoryHead = 0;
+static GLuint hwProgram       = 0;
+static GLuint hwVao           = 0;
+static GLuint hwVbo           = 0;
+
+static const GLfloat _hwVertices[] = {
+	-1.0f, -1.0f,
+	 1.0f, -1.0f,
+	-1.0f,  1.0f,
+	 1.0f,  1.0f,
+};
+
+/* The renderer's output has its first scanline in
+ * the first row, so drawing it into the frontend's
+ * framebuffer, which has its origin at the bottom,
+ * flips it */
+static const char* const _hwVertexShader =
+	"in vec2 position;\n"
+	"uniform bool flip;\n"
+	"out vec2 texCoord;\n"
+	"void main() {\n"
+	"	texCoord = position * 0.5 + 0.5;\n"
+	"	if (flip) {\n"
+	"		texCoord.y = 1.0 - texCoord.y;\n"
+	"	}\n"
+	"	gl_Position = vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+/* > blend takes the frame_blend_method values.
+ *   Colours are corrected before they are blended,
+ *   as the colour table does for software output,
+ *   so 'LCD Ghosting (Fast)' keeps a corrected
+ *   accumulator in prev1 */
+static const char* const _hwFragmentShader =
+	"in vec2 texCoord;\n"
+	"out vec4 color;\n"
+	"uniform sampler2D curr;\n"
+	"uniform sampler2D prev1;\n"
+	"uniform sampler2D prev2;\n"
+	"uniform sampler2D prev3;\n"
+	"uniform sampler2D prev4;\n"
+	"uniform int blend;\n"
+	"uniform float weights[5];\n"
+	"uniform bool correct;\n"
+	"uniform mat3 ccMatrix;\n"
+	"uniform float ccGamma;\n"
+	"uniform float ccGammaInv;\n"
+	"\n"
+	"vec3 fetch(sampler2D tex) {\n"
+	"	vec3 c = texture(tex, texCoord).rgb;\n"
+	"	if (correct) {\n"
+	"		c = max(ccMatrix * pow(c, vec3(ccGamma)), 0.0);\n"
+	"		c = min(pow(c, vec3(ccGammaInv)), 1.0);\n"
+	"	}\n"
+	"	return c;\n"
+	"}\n"
+	"\n"
+	"void main() {\n"
+	"	vec3 c = fetch(curr);\n"
+	"	if (blend == 1) {\n"
+	"		c = (c + fetch(prev1)) * 0.5;\n"
+	"	} else if (blend == 2) {\n"
+	"		vec3 p1 = fetch(prev1);\n"
+	"		vec3 p2 = fetch(prev2);\n"
+	"		vec3 p3 = fetch(prev3);\n"
+	"		if ((c == p2 || p1 == p3) && c != p1 && c != p3 && p1 != p2) {\n"
+	"			c = (c + p1) * 0.5;\n"
+	"		}\n"
+	"	} else if (blend == 3) {\n"
+	"		c = c * weights[0] + fetch(prev1) * weights[1] + fetch(prev2) * weights[2]\n"
+	"		  + fetch(prev3) * weights[3] + fetch(prev4) * weights[4];\n"
+	"	} else if (blend == 4) {\n"
+	"		c = (c + texture(prev1, texCoord).rgb) * 0.5;\n"
+	"	}\n"
+	"	color = vec4(c, 1.0);\n"
+	"}\n";
+
+static GLuint _hwCompileShader(GLenum type, const char* source) {
+	const char* sources[2] = {
+		hwRender.context_type == RETRO_HW_CONTEXT_OPENGLES3 ? "#version 300 es\nprecision highp float;\n" : "#version 150 core\n",
+		source
+	};
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 2, sources, NULL);
+	glCompileShader(shader);
+	GLint success = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success && logCallback) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		logCallback(RETRO_LOG_ERROR, "Hardware renderer: shader compilation failed: %s\n", log);
 	}
+	return shader;
+}
 
-	if (outputBufferPrev2) {
-		free(outputBufferPrev2);
-		outputBufferPrev2 = NULL;
+static void _hwInitProgram(void) {
+	GLuint vs = _hwCompileShader(GL_VERTEX_SHADER, _hwVertexShader);
+	GLuint fs = _hwCompileShader(GL_FRAGMENT_SHADER, _hwFragmentShader);
+	hwProgram = glCreateProgram();
+	glAttachShader(hwProgram, vs);
+	glAttachShader(hwProgram, fs);
+	glBindAttribLocation(hwProgram, 0, "position");
+	glLinkProgram(hwProgram);
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+
+	GLint success = GL_FALSE;
+	glGetProgramiv(hwProgram, GL_LINK_STATUS, &success);
+	if (!success && logCallback) {
+		char log[1024];
+		glGetProgramInfoLog(hwProgram, sizeof(log), NULL, log);
+		logCallback(RETRO_LOG_ERROR, "Hardware renderer: shader linking failed: %s\n", log);
 	}
 
-	if (outputBufferPrev3) {
-		free(outputBufferPrev3);
-		outputBufferPrev3 = NULL;
+	glUseProgram(hwProgram);
+	glUniform1i(glGetUniformLocation(hwProgram, "curr"), 0);
+	glUniform1i(glGetUniformLocation(hwProgram, "prev1"), 1);
+	glUniform1i(glGetUniformLocation(hwProgram, "prev2"), 2);
+	glUniform1i(glGetUniformLocation(hwProgram, "prev3"), 3);
+	glUniform1i(glGetUniformLocation(hwProgram, "prev4"), 4);
+	glUseProgram(0);
+
+	glGenVertexArrays(1, &hwVao);
+	glBindVertexArray(hwVao);
+	glGenBuffers(1, &hwVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, hwVbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(_hwVertices), _hwVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void _hwInitHistory(void) {
+	unsigned width = GBA_VIDEO_HORIZONTAL_PIXELS * hwRenderScale;
+	unsigned height = GBA_VIDEO_VERTICAL_PIXELS * hwRenderScale;
+	size_t i;
+
+	glGenTextures(HW_HISTORY_MAX, hwHistoryTex);
+	glGenFramebuffers(HW_HISTORY_MAX, hwHistoryFbo);
+	/* Start out white, as the software buffers do */
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+	for (i = 0; i < HW_HISTORY_MAX; i++) {
+		glBindTexture(GL_TEXTURE_2D, hwHistoryTex[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glBindFramebuffer(GL_FRAMEBUFFER, hwHistoryFbo[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, hwHistoryTex[i], 0);
+		glClear(GL_COLOR_BUFFER_BIT);
 	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	hwHistoryHead = 0;
+}
+
+/* The renderer is only chosen when the core resets,
+ * so the running game is carried across one */
+static void _hwSwapRenderer(bool hw) {
+	size_t size = core->stateSize(core);
+	void* state = anonymousMemoryMap(size);
+	bool saved = state && core->saveState(core, state);
 
-	if (outputBufferPrev4) {
-		free(outputBufferPrev4);
-		outputBufferPrev4 = NULL;
+	core->setVideoGLTex(core, hw ? hwOutputTex : (unsigned) -1);
+	mCoreConfigSetOverrideIntValue(&core->config, "hwaccelVideo", hw);
+	core->reset(core);
+	if (saved) {
+		core->loadState(core, state);
 	}
+	if (state) {
+		mappedMemoryFree(state, size);
+	}
+	frameAligned = false;
+	unchangedFrames = 0;
+	hwRenderActive = hw;
+}
 
-	if (outputBufferAccR) {
-		free(outputBufferAccR);
-		outputBufferAccR = NULL;
+static void _hwContextReset(void) {
+	_hwInitProgram();
+	_hwInitHistory();
+	glGenTextures(1, &hwOutputTex);
+	_hwSwapRenderer(true);
+}
+
+static void _hwContextDestroy(void) {
+	/* The GL renderer can't outlive the context, so
+	 * the core draws in software until it is back */
+	if (hwRenderActive) {
+		_hwSwapRenderer(false);
 	}
+	glDeleteProgram(hwProgram);
+	glDeleteVertexArrays(1, &hwVao);
+	glDeleteBuffers(1, &hwVbo);
+	glDeleteFramebuffers(HW_HISTORY_MAX, hwHistoryFbo);
+	glDeleteTextures(HW_HISTORY_MAX, hwHistoryTex);
+	glDeleteTextures(1, &hwOutputTex);
+	hwProgram = 0;
+	hwVao = 0;
+	hwVbo = 0;
+	hwOutputTex = 0;
+}
 
-	if (outputBufferAccG) {
-		free(outputBufferAccG);
-		outputBufferAccG = NULL;
+/* Returns true if the frontend gave us a context */
+static bool _initHwRender(void) {
+	struct retro_variable var = {
+		.key = "mgba_hw_render",
+		.value = 0
+	};
+	hwRenderScale = 0;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		hwRenderScale = strtoul(var.value, NULL, 10);
+	}
+	if (!hwRenderScale) {
+		return false;
 	}
 
-	if (outputBufferAccB) {
-		free(outputBufferAccB);
-		outputBufferAccB = NULL;
+	memset(&hwRender, 0, sizeof(hwRender));
+#ifdef BUILD_GL
+	hwRender.context_type = RETRO_HW_CONTEXT_OPENGL_CORE;
+	hwRender.version_major = 3;
+	hwRender.version_minor = 2;
+#else
+	hwRender.context_type = RETRO_HW_CONTEXT_OPENGLES3;
+#endif
+	hwRender.context_reset = _hwContextReset;
+	hwRender.context_destroy = _hwContextDestroy;
+	hwRender.bottom_left_origin = true;
+	if (!environCallback(RETRO_ENVIRONMENT_SET_HW_RENDER, &hwRender)) {
+		if (logCallback)
+			logCallback(RETRO_LOG_WARN, "Hardware renderer unavailable - frontend did not provide an OpenGL context.\n");
+		return false;
 	}
+
+	mCoreConfigSetOverrideIntValue(&core->config, "videoScale", hwRenderScale);
+	/* GL calls have to stay on this thread */
+	mCoreConfigSetOverrideIntValue(&core->config, "threadedVideo", 0);
+	return true;
+}
+
+static void _hwDrawPass(GLuint fbo, unsigned width, unsigned height, int blend, bool correct, bool flip) {
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+	glUniform1i(glGetUniformLocation(hwProgram, "blend"), blend);
+	glUniform1i(glGetUniformLocation(hwProgram, "correct"), correct);
+	glUniform1i(glGetUniformLocation(hwProgram, "flip"), flip);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
+static void _hwRenderPresent(unsigned width, unsigned height) {
+	unsigned nativeWidth = GBA_VIDEO_HORIZONTAL_PIXELS * hwRenderScale;
+	unsigned nativeHeight = GBA_VIDEO_VERTICAL_PIXELS * hwRenderScale;
+	GLuint target = hwRender.get_current_framebuffer();
+	int blend = frameBlendEnabled ? frameBlendType : FRAME_BLEND_NONE;
+	/* The oldest frame is the one to replace */
+	unsigned next = (hwHistoryHead + HW_HISTORY_MAX - 1) % HW_HISTORY_MAX;
+	size_t i;
+
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_STENCIL_TEST);
+	glUseProgram(hwProgram);
+	glBindVertexArray(hwVao);
+
+	if (blend == FRAME_BLEND_LCD_GHOSTING) {
+		GLfloat weights[5];
+		for (i = 0; i < 5; i++) {
+			weights[i] = frameBlendWeights[i] / (float) (1 << LCD_GHOST_WEIGHT_BITS);
+		}
+		glUniform1fv(glGetUniformLocation(hwProgram, "weights"), 5, weights);
+	}
+	if (colorCorrectionEnabled) {
+		glUniformMatrix3fv(glGetUniformLocation(hwProgram, "ccMatrix"), 1, GL_FALSE, ccMatrix);
+		glUniform1f(glGetUniformLocation(hwProgram, "ccGamma"), ccGamma);
+		glUniform1f(glGetUniformLocation(hwProgram, "ccGammaInv"), 1.0f / CC_TARGET_GAMMA);
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, hwOutputTex);
+	for (i = 0; i < HW_HISTORY_MAX; i++) {
+		glActiveTexture(GL_TEXTURE1 + i);
+		glBindTexture(GL_TEXTURE_2D, hwHistoryTex[(hwHistoryHead + i) % HW_HISTORY_MAX]);
+	}
+
+	if (blend == FRAME_BLEND_LCD_GHOSTING_FAST) {
+		/* The accumulator is what gets shown */
+		_hwDrawPass(hwHistoryFbo[next], nativeWidth, nativeHeight, blend, colorCorrectionEnabled, false);
+		hwHistoryHead = next;
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hwHistoryTex[next]);
+		_hwDrawPass(target, width, height, FRAME_BLEND_NONE, false, true);
+	} else {
+		_hwDrawPass(target, width, height, blend, colorCorrectionEnabled, true);
+		if (blend != FRAME_BLEND_NONE) {
+			/* Kept as drawn, since each frame is
+			 * corrected again when it is blended */
+			_hwDrawPass(hwHistoryFbo[next], nativeWidth, nativeHeight, FRAME_BLEND_NONE, false, false);
+			hwHistoryHead = next;
+		}
+	}
+
+	for (i = 0; i <= HW_HISTORY_MAX; i++) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
+
+#endif
+
+/* Auto-tune: over the first minutes of play, walk
+ * down a ladder of ever cheaper settings, timing a
+ * window of frames at each step, and keep the first
+ * one that holds full speed. Each step keeps the
+ * ones above it. Steps that only take effect on a
+ * reset are measured the next time the game is
+ * loaded, so play is never interrupted */
+
+enum {
+	TUNE_STEP_AS_CONFIGURED = 0,
+	TUNE_STEP_IDLE_LOOPS,
+	TUNE_STEP_NO_POST_PROCESSING,
+	TUNE_STEP_THREADED_VIDEO,
+	TUNE_STEP_FAST_ACCURACY,
+	TUNE_STEP_MAX
+};
+
+/* Frames left to settle after a change, then
+ * frames timed for each step */
+#define TUNE_SETTLE_FRAMES 60
+#define TUNE_WINDOW_FRAMES 600
+
+/* A step holds full speed if the core averages no
+ * more than the governor's busy share of the frame
+ * period, and only a few frames overrun it */
+#define TUNE_SLOW_PERCENT 2
+
+static bool tuneMeasuring;
+static bool tunePostProcess = true;
+static unsigned tuneStep;
+static unsigned tuneFrames;
+static unsigned tuneSlowFrames;
+static retro_time_t tuneFramePeriod;
+static retro_time_t tuneTotal;
+static struct Configuration tuneCache;
+static char tuneCachePath[PATH_MAX];
+static char tuneExportPath[PATH_MAX];
+static char tuneSection[24];
+
+/* Profiles are kept per game code, in sections named
+ * like those of the override table, so that they sit
+ * alongside the overrides when merged into a config
+ * file. Games without a code fall back to the CRC */
+static void _tuneSectionName(void) {
+	char code[16] = "";
+	uint32_t crc32 = 0;
+
+	core->getGameCode(core, code);
+	if (core->platform(core) == PLATFORM_GBA && code[4] && code[5] && code[6] && code[7]) {
+		snprintf(tuneSection, sizeof(tuneSection), "override.%.4s", &code[4]);
+		return;
+	}
+	core->checksum(core, &crc32, CHECKSUM_CRC32);
+	snprintf(tuneSection, sizeof(tuneSection), "game.%08X", crc32);
+}
+
+/* Whether a step changes anything for this game, so
+ * that the ones that don't aren't spent time on */
+static bool _tuneStepApplies(unsigned step) {
+	const char* value;
+
+	switch (step) {
+	case TUNE_STEP_IDLE_LOOPS:
+		value = mCoreConfigGetValue(&core->config, "idleOptimization");
+		return !value || strcmp(value, "detect") != 0;
+	case TUNE_STEP_NO_POST_PROCESSING:
+#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+#ifndef DISABLE_THREADING
+		/* Already off the emulation thread */
+		if (ppThreadActive) {
+			return false;
+		}
+#endif
+		return !hwRenderEnabled && videoPostProcess;
+#else
+		return false;
+#endif
+	case TUNE_STEP_THREADED_VIDEO:
+#ifndef DISABLE_THREADING
+		return core->platform(core) == PLATFORM_GBA && !hwRenderEnabled;
+#else
+		return false;
 #endif
+	case TUNE_STEP_FAST_ACCURACY:
+		value = mCoreConfigGetValue(&core->config, "accuracy");
+		return core->platform(core) == PLATFORM_GBA &&
+		       (!value || mCoreAccuracyFromName(value) != mCORE_ACCURACY_FAST);
+	default:
+		return false;
+	}
+}
+
+static bool _tuneStepNeedsReset(unsigned step) {
+	return step == TUNE_STEP_THREADED_VIDEO || step == TUNE_STEP_FAST_ACCURACY;
+}
+
+/* Records what a step changes in the profile */
+static void _tuneRecordStep(unsigned step) {
+	switch (step) {
+	case TUNE_STEP_IDLE_LOOPS:
+		ConfigurationSetValue(&tuneCache, tuneSection, "idleOptimization", "detect");
+		break;
+	case TUNE_STEP_NO_POST_PROCESSING:
+		ConfigurationSetIntValue(&tuneCache, tuneSection, "postProcessing", 0);
+		break;
+	case TUNE_STEP_THREADED_VIDEO:
+		ConfigurationSetIntValue(&tuneCache, tuneSection, "threadedVideo", 1);
+		break;
+	case TUNE_STEP_FAST_ACCURACY:
+		ConfigurationSetValue(&tuneCache, tuneSection, "accuracy", "fast");
+		break;
+	default:
+		break;
+	}
+}
+
+/* Applies the game's profile on top of the options.
+ * Accuracy and threaded video are only read on a
+ * reset, which the caller takes care of */
+static void _tuneApplyProfile(void) {
+	const char* value;
+
+	value = ConfigurationGetValue(&tuneCache, tuneSection, "idleOptimization");
+	if (value) {
+		mCoreConfigSetOverrideValue(&core->config, "idleOptimization", value);
+	}
+	value = ConfigurationGetValue(&tuneCache, tuneSection, "accuracy");
+	if (value) {
+		mCoreConfigSetOverrideValue(&core->config, "accuracy", value);
+	}
+	value = ConfigurationGetValue(&tuneCache, tuneSection, "threadedVideo");
+	if (value) {
+		mCoreConfigSetOverrideValue(&core->config, "threadedVideo", value);
+	}
+	value = ConfigurationGetValue(&tuneCache, tuneSection, "postProcessing");
+	tunePostProcess = !value || strcmp(value, "0") != 0;
+	mCoreLoadConfig(core);
+}
+
+struct TuneExport {
+	struct Configuration* profiles;
+	const char* section;
+};
+
+static void _tuneExportValue(const char* key, const char* value, void* user) {
+	struct TuneExport* export = user;
+	ConfigurationSetValue(export->profiles, export->section, key, value);
+}
+
+static void _tuneExportSection(const char* sectionName, void* user) {
+	struct TuneExport* export = user;
+	if (!ConfigurationGetValue(&tuneCache, sectionName, "autoTuned")) {
+		return;
+	}
+	export->section = sectionName;
+	ConfigurationEnumerate(&tuneCache, sectionName, _tuneExportValue, export);
+}
+
+/* Only finished profiles are exported, so that the
+ * file can be handed out as another device's cache */
+static void _tuneExportProfiles(void) {
+	struct Configuration profiles;
+	struct TuneExport export = { &profiles, NULL };
+
+	ConfigurationInit(&profiles);
+	ConfigurationEnumerateSections(&tuneCache, _tuneExportSection, &export);
+	ConfigurationWrite(&profiles, tuneExportPath);
+	ConfigurationDeinit(&profiles);
+}
+
+static void _tuneStartStep(unsigned step) {
+	tuneStep = step;
+	tuneFrames = 0;
+	tuneSlowFrames = 0;
+	tuneTotal = 0;
+	tuneMeasuring = true;
+}
+
+static void _tuneFinish(void) {
+	tuneMeasuring = false;
+	ConfigurationClearValue(&tuneCache, tuneSection, "autoTuneStep");
+	ConfigurationSetIntValue(&tuneCache, tuneSection, "autoTuned", 1);
+	ConfigurationWrite(&tuneCache, tuneCachePath);
+	_tuneExportProfiles();
+	if (logCallback) {
+		logCallback(RETRO_LOG_INFO, "Auto-tune: settled on step %u of %u for %s\n", tuneStep, TUNE_STEP_MAX - 1, tuneSection);
+	}
+}
+
+/* Moves on to the next step that changes anything,
+ * right away if it can be applied while running */
+static void _tuneNextStep(void) {
+	unsigned step = tuneStep + 1;
+	while (step < TUNE_STEP_MAX && !_tuneStepApplies(step)) {
+		++step;
+	}
+	if (step == TUNE_STEP_MAX) {
+		/* Nothing cheaper left to try */
+		_tuneFinish();
+		return;
+	}
+	_tuneRecordStep(step);
+	if (_tuneStepNeedsReset(step)) {
+		tuneMeasuring = false;
+		ConfigurationSetUIntValue(&tuneCache, tuneSection, "autoTuneStep", step);
+		ConfigurationWrite(&tuneCache, tuneCachePath);
+		return;
+	}
+	_tuneApplyProfile();
+	_tuneStartStep(step);
+}
+
+static void _tuneSample(retro_time_t frameTime) {
+	if (++tuneFrames <= TUNE_SETTLE_FRAMES) {
+		return;
+	}
+	tuneTotal += frameTime;
+	if (frameTime > tuneFramePeriod) {
+		++tuneSlowFrames;
+	}
+	if (tuneFrames < TUNE_SETTLE_FRAMES + TUNE_WINDOW_FRAMES) {
+		return;
+	}
+
+	retro_time_t average = tuneTotal / TUNE_WINDOW_FRAMES;
+	if (logCallback) {
+		logCallback(RETRO_LOG_INFO, "Auto-tune: step %u averaged %u us per frame, %u of %u frames over\n",
+		            tuneStep, (unsigned) average, tuneSlowFrames, TUNE_WINDOW_FRAMES);
+	}
+	if (average * 100 <= tuneFramePeriod * GOVERNOR_BUSY_PERCENT &&
+	    tuneSlowFrames * 100 <= TUNE_WINDOW_FRAMES * TUNE_SLOW_PERCENT) {
+		_tuneFinish();
+	} else {
+		_tuneNextStep();
+	}
+}
+
+static void _loadTuningProfile(void) {
+	struct retro_variable var;
+	const char* sysDir = 0;
+	const char* value;
+
+	tuneMeasuring = false;
+	tunePostProcess = true;
+	tuneCachePath[0] = '\0';
+	ConfigurationInit(&tuneCache);
+
+	var.key = "mgba_auto_tune";
+	var.value = 0;
+	if (!environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) || !var.value || strcmp(var.value, "ON") != 0) {
+		return;
+	}
+	if (!environCallback(RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY, &sysDir) || !sysDir) {
+		return;
+	}
+	snprintf(tuneCachePath, sizeof(tuneCachePath), "%s%s%s", sysDir, PATH_SEP, "mgba_tuning.ini");
+	snprintf(tuneExportPath, sizeof(tuneExportPath), "%s%s%s", sysDir, PATH_SEP, "mgba_tuning_profiles.ini");
+	ConfigurationRead(&tuneCache, tuneCachePath);
+	_tuneSectionName();
+	_tuneApplyProfile();
+
+	if (ConfigurationGetValue(&tuneCache, tuneSection, "autoTuned")) {
+		return;
+	}
+	if (!_initPerfTimer()) {
+		if (logCallback)
+			logCallback(RETRO_LOG_WARN, "Auto-tune disabled - frontend does not provide a performance timer.\n");
+		return;
+	}
+	tuneFramePeriod = (retro_time_t) core->frameCycles(core) * 1000000 / core->frequency(core);
+	value = ConfigurationGetValue(&tuneCache, tuneSection, "autoTuneStep");
+	unsigned long step = value ? strtoul(value, NULL, 10) : TUNE_STEP_AS_CONFIGURED;
+	_tuneStartStep(step < TUNE_STEP_MAX ? step : TUNE_STEP_AS_CONFIGURED);
+}
+
+static void _unloadTuningProfile(void) {
+	tuneMeasuring = false;
+	tunePostProcess = true;
+	ConfigurationDeinit(&tuneCache);
+	tuneCachePath[0] = '\0';
+}
 
 static void _initSensors(void) {
 	if (sensorsInitDone) {
@@ -1080,6 +2884,9 @@ static void _reloadSettings(void) {
 #endif
 
     _loadFrameskipSettings(&opts);
+	_loadFrameStatsSettings();
+	_loadInputPollSettings();
+	_loadAudioSettings(true);
 //	var.key = "mgba_frameskip";
 //	var.value = 0;
 //	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
@@ -1090,22 +2897,61 @@ static void _reloadSettings(void) {
 	var.key = "mgba_idle_optimization";
 	var.value = 0;
 	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
-		if (strcmp(var.value, "Don't Remove") == 0) {
-			mCoreConfigSetDefaultValue(&core->config, "idleOptimization", "ignore");
-		} else if (strcmp(var.value, "Remove Known") == 0) {
-			mCoreConfigSetDefaultValue(&core->config, "idleOptimization", "remove");
-		} else if (strcmp(var.value, "Detect and Remove") == 0) {
-			mCoreConfigSetDefaultValue(&core->config, "idleOptimization", "detect");
-		}
+		if (strcmp(var.value, "Don't Remove") == 0) {
+			mCoreConfigSetDefaultValue(&core->config, "idleOptimization", "ignore");
+		} else if (strcmp(var.value, "Remove Known") == 0) {
+			mCoreConfigSetDefaultValue(&core->config, "idleOptimization", "remove");
+		} else if (strcmp(var.value, "Detect and Remove") == 0) {
+			mCoreConfigSetDefaultValue(&core->config, "idleOptimization", "detect");
+		}
+	}
+
+	const char* sysDir = 0;
+	if (environCallback(RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY, &sysDir) && sysDir) {
+		char idleLoopCache[PATH_MAX];
+		snprintf(idleLoopCache, sizeof(idleLoopCache), "%s%s%s", sysDir, PATH_SEP, "mgba_idle_loops.ini");
+		mCoreConfigSetDefaultValue(&core->config, "idleLoopCache", idleLoopCache);
+	}
+
+#ifdef M_CORE_GBA
+	var.key = "mgba_force_gbp";
+	var.value = 0;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		mCoreConfigSetDefaultIntValue(&core->config, "gba.forceGbp", strcmp(var.value, "ON") == 0);
+	}
+
+	var.key = "mgba_cached_interpreter";
+	var.value = 0;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		mCoreConfigSetDefaultIntValue(&core->config, "cachedInterpreter", strcmp(var.value, "ON") == 0);
+	}
+
+	var.key = "mgba_audio_hle";
+	var.value = 0;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		mCoreConfigSetDefaultIntValue(&core->config, "gba.audioHle", strcmp(var.value, "ON") == 0);
+	}
+#endif
+
+	var.key = "mgba_accuracy";
+	var.value = 0;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		mCoreConfigSetDefaultValue(&core->config, "accuracy", var.value);
+	}
+
+#ifndef DISABLE_THREADING
+	var.key = "mgba_threaded_video";
+	var.value = 0;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+		mCoreConfigSetDefaultIntValue(&core->config, "threadedVideo", strcmp(var.value, "ON") == 0);
 	}
+#endif
 
-#ifdef M_CORE_GBA
-	var.key = "mgba_force_gbp";
+	var.key = "mgba_audio_resampler";
 	var.value = 0;
 	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
-		mCoreConfigSetDefaultIntValue(&core->config, "gba.forceGbp", strcmp(var.value, "ON") == 0);
+		mCoreConfigSetDefaultValue(&core->config, "audioResampler", var.value);
 	}
-#endif
 
 	mCoreConfigLoadDefaults(&core->config, &opts);
 	mCoreLoadConfig(core);
@@ -1115,9 +2961,40 @@ unsigned retro_api_version(void) {
 	return RETRO_API_VERSION;
 }
 
+/* Frontends can fetch this through SET_PROC_ADDRESS_CALLBACK
+ * as "retro_get_save_ram_generation" and only copy the
+ * RETRO_MEMORY_SAVE_RAM buffer out when the number moved.
+ * It changes once the game has written the savedata and
+ * then left it alone for a little while. */
+static unsigned RETRO_CALLCONV _getSaveRamGeneration(void) {
+	if (!core) {
+		return 0;
+	}
+#ifdef M_CORE_GBA
+	if (core->platform(core) == PLATFORM_GBA) {
+		return ((struct GBA*) core->board)->memory.savedata.flusher.generation;
+	}
+#endif
+#ifdef M_CORE_GB
+	if (core->platform(core) == PLATFORM_GB) {
+		return ((struct GB*) core->board)->sramFlusher.generation;
+	}
+#endif
+	return 0;
+}
+
+static retro_proc_address_t RETRO_CALLCONV _getProcAddress(const char* sym) {
+	if (strcmp(sym, "retro_get_save_ram_generation") == 0) {
+		return (retro_proc_address_t) _getSaveRamGeneration;
+	}
+	return NULL;
+}
+
 void retro_set_environment(retro_environment_t env)
 {
+	static const struct retro_get_proc_address_interface procAddress = { _getProcAddress };
 	environCallback = env;
+	environCallback(RETRO_ENVIRONMENT_SET_PROC_ADDRESS_CALLBACK, (void*) &procAddress);
 
 	libretro_set_core_options(environCallback);
 }
@@ -1164,6 +3041,14 @@ void retro_get_system_info(struct retro_system_info* info) {
 void retro_get_system_av_info(struct retro_system_av_info* info) {
 	unsigned width, height;
 	core->desiredVideoDimensions(core, &width, &height);
+#ifdef HAVE_HW_RENDER
+	/* The renderer only picks up its scale once the
+	 * frontend has set up the context */
+	if (hwRenderEnabled) {
+		width = GBA_VIDEO_HORIZONTAL_PIXELS * hwRenderScale;
+		height = GBA_VIDEO_VERTICAL_PIXELS * hwRenderScale;
+	}
+#endif
 	info->geometry.base_width = width;
 	info->geometry.base_height = height;
 #ifdef M_CORE_GB
@@ -1178,6 +3063,15 @@ void retro_get_system_av_info(struct retro_system_av_info* info) {
 	}
 
 	info->geometry.aspect_ratio = width / (double) height;
+#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+	if (outputScaleType != OUTPUT_SCALE_NONE) {
+		info->geometry.base_width = VIDEO_SCALED_WIDTH;
+		info->geometry.base_height = VIDEO_SCALED_HEIGHT;
+		info->geometry.max_width = VIDEO_SCALED_WIDTH;
+		info->geometry.max_height = VIDEO_SCALED_HEIGHT;
+		info->geometry.aspect_ratio = VIDEO_SCALED_WIDTH / (double) VIDEO_SCALED_HEIGHT;
+	}
+#endif
 	info->timing.fps = core->frequency(core) / (float) core->frameCycles(core);
 	info->timing.sample_rate = 32768;
 }
@@ -1196,6 +3090,7 @@ void retro_init(void) {
 	fmt = RETRO_PIXEL_FORMAT_XRGB8888;
 #endif
 	environCallback(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt);
+	pixelFormat = fmt;
 
 	struct retro_input_descriptor inputDescriptors[] = {
 		{ 0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_A, "A" },
@@ -1253,7 +3148,17 @@ void retro_init(void) {
 	} else {
 		logCallback = 0;
 	}
+	// Mirrors what GBARetroLog throws away, so those messages get skipped before they're formatted
+	mLogFilterInit(&logFilter);
+#ifdef NDEBUG
+	mLogFilterSetDefaultLevels(&logFilter, mLOG_ALL & ~(mLOG_STUB | mLOG_GAME_ERROR));
+	mLogFilterSet(&logFilter, "gba.bios", 0);
+#endif
+	if (!logCallback) {
+		mLogFilterSetDefaultLevels(&logFilter, 0);
+	}
 	logger.log = GBARetroLog;
+	logger.filter = &logFilter;
 	mLogSetDefaultLogger(&logger);
 
 	stream.videoDimensionsChanged = 0;
@@ -1268,6 +3173,11 @@ void retro_init(void) {
 	if (environCallback(RETRO_ENVIRONMENT_GET_INPUT_BITMASKS, NULL))
 		libretro_supports_bitmasks = true;
 
+	canDupe = false;
+	if (!environCallback(RETRO_ENVIRONMENT_GET_CAN_DUPE, &canDupe))
+		canDupe = false;
+	unchangedFrames = 0;
+
 	frameskipType           = 0;
 	frameskipThreshold      = 0;
 	frameskipCounter        = 0;
@@ -1276,6 +3186,9 @@ void retro_init(void) {
 	retroAudioBuffUnderrun  = false;
 	retroAudioLatency       = 0;
 	updateAudioLatency      = false;
+	audioPerFrame           = false;
+	frameStatsMode          = FRAME_STATS_OFF;
+	memset(&perfCallback, 0, sizeof(perfCallback));
 }
 
 void retro_deinit(void) {
@@ -1290,6 +3203,10 @@ void retro_deinit(void) {
 #if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
 	_deinitPostProcessing();
 #endif
+	_deinitColorCorrection();
+
+	logger.filter = NULL;
+	mLogFilterDeinit(&logFilter);
 
 	if (sensorStateCallback) {
 		sensorStateCallback(0, RETRO_SENSOR_ACCELEROMETER_DISABLE, EVENT_RATE);
@@ -1337,41 +3254,68 @@ int16_t cycleturbo(bool x/*turbo A*/, bool y/*turbo B*/, bool l2/*turbo L*/, boo
 }
 
 
-void retro_run(void) {
-	uint16_t keys;
-	bool skipFrame = false;
-
-	_initSensors();
-	inputPollCallback();
-
-	bool updated = false;
-	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated) {
-		envVarsUpdated = true;
-
-		struct retro_variable var = {
-			.key = "mgba_allow_opposing_directions",
-			.value = 0
-		};
-		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
-			mCoreConfigSetIntValue(&core->config, "allowOpposingDirections", strcmp(var.value, "yes") == 0);
-			core->reloadConfigOption(core, "allowOpposingDirections", NULL);
-		}
-
-    _loadFrameskipSettings(NULL);
-//		var.key = "mgba_frameskip";
-//		var.value = 0;
-//		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
-//			mCoreConfigSetIntValue(&core->config, "frameskip", strtol(var.value, NULL, 10));
-//			core->reloadConfigOption(core, "frameskip", NULL);
-//		}
+/* Keeps the core from drawing the frame it runs next */
+static void _skipFrameDrawing(void) {
+	switch (core->platform(core)) {
+#ifdef M_CORE_GBA
+	case PLATFORM_GBA:
+		((struct GBA*) core->board)->video.frameskipCounter = 1;
+		break;
+#endif
+#ifdef M_CORE_GB
+	case PLATFORM_GB:
+		((struct GB*) core->board)->video.frameskipCounter = 1;
+		break;
+#endif
+	default:
+		break;
+	}
+}
 
+static void _selectVideoBuffer(void) {
+	/* Rendering straight into memory owned by the
+	 * frontend saves it a copy, but that memory starts
+	 * out undefined every frame, so every line has to be
+	 * drawn again. While the screen is static, keep the
+	 * internal buffer, where unchanged lines are skipped.
+	 * Frames cut short by a reset or state load don't draw
+	 * every line, so these need the internal buffer too */
+	bool useFramebuffer = core->platform(core) == PLATFORM_GBA && frameAligned && !unchangedFrames;
 #if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
-		_loadPostProcessingSettings();
+	/* Post processing and scaling read back the
+	 * internal buffer */
+	if (videoPostProcess || outputScaleType != OUTPUT_SCALE_NONE) {
+		useFramebuffer = false;
+	}
 #endif
+	if (useFramebuffer) {
+		struct retro_framebuffer fb = {0};
+		core->desiredVideoDimensions(core, &fb.width, &fb.height);
+		fb.access_flags = RETRO_MEMORY_ACCESS_WRITE;
+		if (environCallback(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, &fb) && fb.data &&
+		    fb.format == pixelFormat && !(fb.pitch % sizeof(color_t))) {
+			videoBuffer = fb.data;
+			videoBufferStride = fb.pitch / sizeof(color_t);
+			core->setVideoBuffer(core, videoBuffer, videoBufferStride);
+			return;
+		}
+	}
+	if (videoBuffer != outputBuffer) {
+		/* Whatever the internal buffer held is out of date */
+		videoBuffer = outputBuffer;
+		videoBufferStride = VIDEO_WIDTH_MAX;
+		core->setVideoBuffer(core, videoBuffer, videoBufferStride);
 	}
+}
 
+static void _pollInput(void) {
+	uint16_t keys;
 	unsigned i;
 	int16_t joypad_bits;
+
+	inputPollCallback();
+	latePollDone = true;
+
 	if (libretro_supports_bitmasks)
 		joypad_bits = inputCallback(0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_MASK);
 	else
@@ -1397,6 +3341,110 @@ void retro_run(void) {
 	keys |= cycleturbo(RDKEYP1(X),RDKEYP1(Y),RDKEYP1(L2),RDKEYP1(R2));
 
 	core->setKeys(core, keys);
+}
+
+/* In late mode the frontend is only polled once
+ * the game first reads the keys during a frame,
+ * so input pressed while the frame was already
+ * running still makes it in */
+static void _latePollKeysRead(void* context) {
+	UNUSED(context);
+	if (latePollEnabled && !latePollDone) {
+		_pollInput();
+	}
+}
+
+void retro_run(void) {
+	bool skipFrame = false;
+	retro_time_t frameStart = _frameStatsNow();
+	retro_time_t tuneStart = tuneMeasuring ? perfCallback.get_time_usec() : 0;
+	retro_time_t stageStart;
+
+	_startupTimingEnd();
+	frameStatsAudioTime = 0;
+	_initSensors();
+	latePollDone = false;
+
+	bool updated = false;
+	if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated) {
+		envVarsUpdated = true;
+
+		struct retro_variable var = {
+			.key = "mgba_allow_opposing_directions",
+			.value = 0
+		};
+		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+			mCoreConfigSetIntValue(&core->config, "allowOpposingDirections", strcmp(var.value, "yes") == 0);
+			core->reloadConfigOption(core, "allowOpposingDirections", NULL);
+		}
+
+		var.key = "mgba_cached_interpreter";
+		var.value = 0;
+		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+			mCoreConfigSetIntValue(&core->config, "cachedInterpreter", strcmp(var.value, "ON") == 0);
+			core->reloadConfigOption(core, "cachedInterpreter", NULL);
+		}
+
+		var.key = "mgba_audio_hle";
+		var.value = 0;
+		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+			mCoreConfigSetIntValue(&core->config, "gba.audioHle", strcmp(var.value, "ON") == 0);
+			core->reloadConfigOption(core, "gba.audioHle", NULL);
+		}
+
+		/* Picked up by the next reset */
+		var.key = "mgba_accuracy";
+		var.value = 0;
+		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+			mCoreConfigSetValue(&core->config, "accuracy", var.value);
+		}
+
+#ifndef DISABLE_THREADING
+		/* Picked up by the next reset */
+		var.key = "mgba_threaded_video";
+		var.value = 0;
+		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+			mCoreConfigSetIntValue(&core->config, "threadedVideo", strcmp(var.value, "ON") == 0);
+		}
+#endif
+
+		var.key = "mgba_audio_resampler";
+		var.value = 0;
+		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+			mCoreConfigSetValue(&core->config, "audioResampler", var.value);
+			core->reloadConfigOption(core, "audioResampler", NULL);
+		}
+
+    _loadFrameskipSettings(NULL);
+		_loadAudioSettings(false);
+		_loadFrameStatsSettings();
+		_loadInputPollSettings();
+		_loadMemoryProfileSettings();
+//		var.key = "mgba_frameskip";
+//		var.value = 0;
+//		if (environCallback(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value) {
+//			mCoreConfigSetIntValue(&core->config, "frameskip", strtol(var.value, NULL, 10));
+//			core->reloadConfigOption(core, "frameskip", NULL);
+//		}
+
+		_loadColorCorrectionSettings();
+#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+		if (hwRenderEnabled) {
+			_loadFrameBlendSettings();
+		} else {
+			_loadPostProcessingSettings();
+		}
+		if (!hwRenderEnabled && _loadOutputScaleSettings()) {
+			struct retro_system_av_info info;
+			retro_get_system_av_info(&info);
+			environCallback(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &info);
+		}
+#endif
+	}
+
+	if (!latePollEnabled) {
+		_pollInput();
+	}
 
 	if (!luxSensorUsed) {
 		static bool wasAdjustingLux = false;
@@ -1420,6 +3468,9 @@ void retro_run(void) {
 		}
 	}
 
+	stageStart = _frameStatsNow();
+	_frameStatsAdd(FRAME_STAT_INPUT, stageStart - frameStart);
+
 	/* Check whether current frame should
 	 * be skipped */
 	if ((frameskipType > 0)  &&
@@ -1440,21 +3491,7 @@ void retro_run(void) {
 
 		if (skipFrame) {
 			if(frameskipCounter < RETRO_FRAMESKIP_MAX) {
-
-				switch (core->platform(core)) {
-#ifdef M_CORE_GBA
-				case PLATFORM_GBA:
-					((struct GBA*) core->board)->video.frameskipCounter = 1;
-					break;
-#endif
-#ifdef M_CORE_GB
-				case PLATFORM_GB:
-					((struct GB*) core->board)->video.frameskipCounter = 1;
-					break;
-#endif
-				default:
-					break;
-				}
+				_skipFrameDrawing();
 				frameskipCounter++;
 
 			} else {
@@ -1475,7 +3512,57 @@ void retro_run(void) {
       updateAudioLatency = false;
    }
 
+	/* Run-ahead and similar features discard the
+	 * audio of some frames, which then needn't be
+	 * synthesized at all */
+	int avEnable = 3;
+	if (!environCallback(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &avEnable)) {
+		avEnable = 3;
+	}
+	core->setAudioMuted(core, !(avEnable & 2));
+
+	/* ...and likewise the video, which needn't be
+	 * drawn. The renderer catches up on whatever
+	 * changed in the next frame that is */
+	bool videoEnabled = avEnable & 1;
+	if (videoEnabled && !hwRenderEnabled) {
+		_selectVideoBuffer();
+	} else {
+		_skipFrameDrawing();
+	}
+
+	/* The frame time governor paces itself on the
+	 * frames that are actually shown */
+	retro_time_t runStart = 0;
+	if (frameskipType == 4) {
+		if (videoEnabled && _governorSkipFrame()) {
+			_skipFrameDrawing();
+			skipFrame = true;
+		}
+		runStart = perfCallback.get_time_usec();
+	}
+	/* Skipped frames would flatter the step being
+	 * auto-tuned */
+	bool tuneSampled = tuneMeasuring && videoEnabled && !skipFrame;
+	/* Audio handed over mid-frame counts as audio,
+	 * not emulation */
+	retro_time_t audioBeforeRun = frameStatsAudioTime;
+	stageStart = _frameStatsNow();
 	core->runFrame(core);
+	/* The frontend still expects a poll every frame,
+	 * even when the game didn't read the keys */
+	if (!latePollDone) {
+		_pollInput();
+	}
+	retro_time_t emulateTime = _frameStatsNow() - stageStart - (frameStatsAudioTime - audioBeforeRun);
+	if (frameskipType == 4) {
+		retro_time_t frameTime = perfCallback.get_time_usec() - runStart;
+		_governorSample(videoEnabled && !skipFrame ? &governorDrawCost : &governorSkipCost, frameTime);
+		if (videoEnabled) {
+			_governorUpdate();
+		}
+	}
+	frameAligned = true;
 	unsigned width, height;
 	core->desiredVideoDimensions(core, &width, &height);
 
@@ -1497,26 +3584,93 @@ void retro_run(void) {
 			break;
 		}
 	}
+	if (!videoEnabled) {
+		skipFrame = true;
+	}
+	_frameStatsAdd(skipFrame ? FRAME_STAT_EMULATE_SKIPPED : FRAME_STAT_EMULATE, emulateTime);
 
+	/* If nothing on screen changed, let the frontend
+	 * reuse the previous frame: this skips both post
+	 * processing and the upload */
 	if (!skipFrame) {
+		if (canDupe && !core->videoFrameChanged(core)) {
+			if (unchangedFrames < UINT_MAX) {
+				++unchangedFrames;
+			}
+		} else {
+			unchangedFrames = 0;
+		}
 #if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
-		if (videoPostProcess) {
-			videoPostProcess(width, height);
-			videoCallback(ppOutputBuffer, width, height, VIDEO_WIDTH_MAX * sizeof(color_t));
-		} else
+		skipFrame = unchangedFrames > _postProcessHistory();
+#else
+		skipFrame = unchangedFrames > 0;
 #endif
-			videoCallback(outputBuffer, width, height, VIDEO_WIDTH_MAX * sizeof(color_t));
-	} else {
-		videoCallback(NULL, width, height, VIDEO_WIDTH_MAX * sizeof(color_t));
 	}
 
-	// This was from aliaspider patch (4539a0e), game boy audio is buggy with it (adapted for this refactored core)
-/*
-	int16_t samples[SAMPLES * 2];
-	int produced = blip_read_samples(core->getAudioChannel(core, 0), samples, SAMPLES, true);
-	blip_read_samples(core->getAudioChannel(core, 1), samples + 1, SAMPLES, true);
-	audioCallback(samples, produced);
-*/
+	const color_t* frame = videoBuffer;
+	size_t frameStride = videoBufferStride;
+#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+	stageStart = _frameStatsNow();
+#ifndef DISABLE_THREADING
+	if (ppThreadActive) {
+		/* Shows the frame handed over last time; if the
+		 * core has no new one, it is still shown */
+		color_t* ready = skipFrame ? _ppThreadFlush(&width, &height) : _ppThreadExchange(&width, &height);
+		if (ready) {
+			frame = ready;
+			frameStride = VIDEO_WIDTH_MAX;
+		}
+		skipFrame = !ready;
+	} else
+#endif
+	if (!skipFrame && videoPostProcess && tunePostProcess) {
+		if (frameskipType != 4) {
+			videoPostProcess(outputBuffer, ppOutputBuffer, width, height);
+			frame = ppOutputBuffer;
+			frameStride = VIDEO_WIDTH_MAX;
+		} else if (!governorLevel) {
+			retro_time_t postStart = perfCallback.get_time_usec();
+			videoPostProcess(outputBuffer, ppOutputBuffer, width, height);
+			_governorSample(&governorPostCost, perfCallback.get_time_usec() - postStart);
+			frame = ppOutputBuffer;
+			frameStride = VIDEO_WIDTH_MAX;
+		}
+	}
+	if (outputScaleType != OUTPUT_SCALE_NONE) {
+		if (!skipFrame) {
+			_scaleOutput(frame, frameStride, width, height);
+		}
+		frame = scaledOutputBuffer;
+		frameStride = VIDEO_SCALED_WIDTH;
+		width = VIDEO_SCALED_WIDTH;
+		height = VIDEO_SCALED_HEIGHT;
+	}
+	if (!skipFrame && (videoPostProcess || outputScaleType != OUTPUT_SCALE_NONE)) {
+		_frameStatsAdd(FRAME_STAT_POST_PROCESS, _frameStatsNow() - stageStart);
+	}
+#endif
+#ifdef HAVE_HW_RENDER
+	if (hwRenderActive) {
+		if (!skipFrame) {
+			stageStart = _frameStatsNow();
+			_hwRenderPresent(width, height);
+			_frameStatsAdd(FRAME_STAT_POST_PROCESS, _frameStatsNow() - stageStart);
+		}
+		frame = RETRO_HW_FRAME_BUFFER_VALID;
+		frameStride = 0;
+	}
+#endif
+	if (tuneSampled) {
+		_tuneSample(perfCallback.get_time_usec() - tuneStart);
+	}
+	stageStart = _frameStatsNow();
+	videoCallback(skipFrame ? NULL : frame, width, height, frameStride * sizeof(color_t));
+	_frameStatsAdd(FRAME_STAT_VIDEO, _frameStatsNow() - stageStart);
+
+	if (audioPerFrame) {
+		_drainAudio();
+	}
+	_frameStatsAdd(FRAME_STAT_AUDIO, frameStatsAudioTime);
 
 	if (rumbleCallback) {
 		if (rumbleUp) {
@@ -1529,6 +3683,9 @@ void retro_run(void) {
 		rumbleUp = 0;
 		rumbleDown = 0;
 	}
+
+	_frameStatsAdd(FRAME_STAT_TOTAL, _frameStatsNow() - frameStart);
+	_frameStatsReport();
 }
 
 static void _setupMaps(struct mCore* core) {
@@ -1713,6 +3870,7 @@ static void _setupMaps(struct mCore* core) {
 
 void retro_reset(void) {
 	core->reset(core);
+	frameAligned = false;
 	_setupMaps(core);
 
 	rumbleUp = 0;
@@ -1754,14 +3912,79 @@ error:
 }
 #endif
 
+/* Reports where the memory of a loaded game goes,
+ * so that the low memory profile can be judged on
+ * the device it is meant for */
+static void _logMemoryBreakdown(size_t romSize) {
+	if (!logCallback) {
+		return;
+	}
+
+	const struct mCoreMemoryBlock* blocks;
+	size_t nBlocks = core->listMemoryBlocks(core, &blocks);
+	size_t ramSize = 0;
+	size_t i;
+	for (i = 0; i < nBlocks; ++i) {
+		if ((blocks[i].flags & mCORE_MEMORY_WRITE) && !(blocks[i].flags & mCORE_MEMORY_VIRTUAL)) {
+			ramSize += blocks[i].size;
+		}
+	}
+
+	size_t videoSize = VIDEO_BUFF_SIZE;
+#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+	color_t* prevBuffers[] = {
+		ppOutputBuffer, outputBufferPrev1, outputBufferPrev2, outputBufferPrev3, outputBufferPrev4,
+#ifndef DISABLE_THREADING
+		ppInputBuffer, ppOutputBufferBack,
+#endif
+	};
+	for (i = 0; i < sizeof(prevBuffers) / sizeof(*prevBuffers); ++i) {
+		if (prevBuffers[i]) {
+			videoSize += VIDEO_BUFF_SIZE;
+		}
+	}
+	if (outputBufferAccR) {
+		videoSize += 3 * VIDEO_WIDTH_MAX * VIDEO_HEIGHT_MAX * sizeof(uint16_t);
+	}
+	if (scaledOutputBuffer) {
+		videoSize += VIDEO_SCALED_WIDTH * VIDEO_SCALED_HEIGHT * sizeof(color_t);
+	}
+#endif
+
+	logCallback(RETRO_LOG_INFO, "Memory: ROM %zu KiB (%s), emulated RAM %zu KiB, savedata %u KiB, "
+	            "savestate %zu KiB, video buffers %zu KiB\n",
+	            romSize >> 10, romMapped ? "mapped from file" : "copied", ramSize >> 10,
+	            SIZE_CART_FLASH1M >> 10, core->stateSize(core) >> 10, videoSize >> 10);
+}
+
 bool retro_load_game(const struct retro_game_info* game) {
-	struct VFile* rom;
+	struct VFile* rom = NULL;
+	size_t romSize;
 
 	if (!game) {
 		return false;
 	}
 
-	if (game->data) {
+	_startupTimingBegin();
+	_loadMemoryProfileSettings();
+	romMapped = false;
+
+#ifndef GEKKO
+	/* The frontend's copy of the ROM can't be shared,
+	 * so rather than keeping a second one, map the
+	 * file itself and let the OS page it in and out */
+	if (game->data && game->path && lowMemoryProfile) {
+		rom = VFileOpen(game->path, O_RDONLY);
+		if (rom) {
+			data = 0;
+			romMapped = true;
+		}
+	}
+#endif
+
+	if (rom) {
+		/* Mapped above */
+	} else if (game->data) {
 		data = anonymousMemoryMap(game->size);
 		dataSize = game->size;
 		memcpy(data, game->data, game->size);
@@ -1775,11 +3998,14 @@ bool retro_load_game(const struct retro_game_info* game) {
 #else
 		data = 0;
 		rom = VFileOpen(game->path, O_RDONLY);
+		romMapped = true;
 #endif
 	}
 	if (!rom) {
 		return false;
 	}
+	romSize = rom->size(rom);
+	_startupTimingPhase("reading ROM");
 
 	core = mCoreFindVF(rom);
 	if (!core) {
@@ -1791,6 +4017,16 @@ bool retro_load_game(const struct retro_game_info* game) {
 	core->init(core);
 	core->setAVStream(core, &stream);
 
+#ifdef HAVE_HW_RENDER
+	/* Has to be asked for before the game is loaded */
+	hwRenderEnabled = core->platform(core) == PLATFORM_GBA && _initHwRender();
+#endif
+
+	memset(&retroAudioStats, 0, sizeof(retroAudioStats));
+	memset(&latePollCallbacks, 0, sizeof(latePollCallbacks));
+	latePollCallbacks.keysRead = _latePollKeysRead;
+	core->addCoreCallbacks(core, &latePollCallbacks);
+
 #ifdef _3DS
 	outputBuffer = linearMemAlign(VIDEO_BUFF_SIZE, 0x80);
 #else
@@ -1798,6 +4034,8 @@ bool retro_load_game(const struct retro_game_info* game) {
 #endif
 	memset(outputBuffer, 0xFFFF, VIDEO_BUFF_SIZE);
 	core->setVideoBuffer(core, outputBuffer, VIDEO_WIDTH_MAX);
+	videoBuffer = outputBuffer;
+	videoBufferStride = VIDEO_WIDTH_MAX;
 
 	core->setAudioBufferSize(core, SAMPLES);
 
@@ -1810,10 +4048,13 @@ bool retro_load_game(const struct retro_game_info* game) {
 	savedata = anonymousMemoryMap(SIZE_CART_FLASH1M);
 	memset(savedata, 0xFF, SIZE_CART_FLASH1M);
 	struct VFile* save = VFileFromMemory(savedata, SIZE_CART_FLASH1M);
+	_startupTimingPhase("creating core");
 
 	_reloadSettings();
+	_startupTimingPhase("loading settings");
 	core->loadROM(core, rom);
 	core->loadSave(core, save);
+	_startupTimingPhase("loading ROM");
 
 	const char* sysDir = 0;
 	const char* biosName = 0;
@@ -1869,14 +4110,34 @@ bool retro_load_game(const struct retro_game_info* game) {
 			core->loadBIOS(core, bios, 0);
 		}
 	}
+	_startupTimingPhase("loading BIOS");
+
+	/* Before the reset, which is when accuracy and
+	 * threaded video are read */
+	_loadTuningProfile();
+
+	/* Before the reset, so that the renderer starts
+	 * out with corrected colours */
+	_loadColorCorrectionSettings();
+	_startupTimingPhase("colour correction");
 
 	core->reset(core);
 	_setupMaps(core);
+	frameAligned = false;
+	_loadGovernorLevel();
+	_startupTimingPhase("resetting");
 
 #if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
-	_loadPostProcessingSettings();
+	if (hwRenderEnabled) {
+		_loadFrameBlendSettings();
+	} else {
+		_loadPostProcessingSettings();
+		_loadOutputScaleSettings();
+	}
 #endif
+	_startupTimingPhase("post processing");
 
+	_logMemoryBreakdown(romSize);
 	return true;
 }
 
@@ -1884,41 +4145,107 @@ void retro_unload_game(void) {
 	if (!core) {
 		return;
 	}
+	_saveGovernorLevel();
+	_unloadTuningProfile();
+	_logAudioStats();
+#ifdef HAVE_HW_RENDER
+	/* The renderer goes along with the core, so the
+	 * context has nothing left to hand back */
+	hwRenderActive = false;
+	if (hwRenderEnabled) {
+		/* Nothing was allocated for blending, so the
+		 * next game has to set it up from scratch */
+		frameBlendType = FRAME_BLEND_NONE;
+		frameBlendEnabled = false;
+	}
+#endif
+	hwRenderEnabled = false;
 	mCoreConfigDeinit(&core->config);
 	core->deinit(core);
+	serializeSize = 0;
 	mappedMemoryFree(data, dataSize);
 	data = 0;
 	mappedMemoryFree(savedata, SIZE_CART_FLASH1M);
 	savedata = 0;
 }
 
+/* Savestates are the core's own state, followed by
+ * the savedata and RTC state as extdata. Neither of
+ * those can outgrow the savedata buffer plus a little
+ * room for the extdata headers */
+#define SERIALIZE_EXTDATA_MAX (SIZE_CART_FLASH1M + 0x1000)
+
+/* Run-ahead and netplay save and load state at least
+ * once per frame, and ask for them to be fast. These
+ * states never leave this process, so they are just
+ * the core's own state: the savedata is never rolled
+ * back, which would mean masking it on every load */
+static bool _useFastSavestates(void) {
+	int avEnable = 0;
+	if (!environCallback(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &avEnable)) {
+		return false;
+	}
+	return avEnable & 4;
+}
+
 size_t retro_serialize_size(void) {
-	struct VFile* vfm = VFileMemChunk(NULL, 0);
-	mCoreSaveStateNamed(core, vfm, SAVESTATE_SAVEDATA | SAVESTATE_RTC);
-	size_t size = vfm->size(vfm);
-	vfm->close(vfm);
-	return size;
+	/* The frontend expects this to stay the same for
+	 * the whole session, so account for the largest
+	 * extdata the state can ever carry */
+	if (!serializeSize) {
+		serializeSize = core->stateSize(core) + SERIALIZE_EXTDATA_MAX;
+	}
+	return serializeSize;
 }
 
 bool retro_serialize(void* data, size_t size) {
-	struct VFile* vfm = VFileMemChunk(NULL, 0);
-	mCoreSaveStateNamed(core, vfm, SAVESTATE_SAVEDATA | SAVESTATE_RTC);
-	if ((ssize_t) size > vfm->size(vfm)) {
-		size = vfm->size(vfm);
-	} else if ((ssize_t) size < vfm->size(vfm)) {
-		vfm->close(vfm);
+	size_t stateSize = core->stateSize(core);
+	if (size < retro_serialize_size()) {
+		return false;
+	}
+	if (_useFastSavestates()) {
+		if (!core->saveState(core, data)) {
+			return false;
+		}
+		/* An empty extdata header */
+		memset((uint8_t*) data + stateSize, 0, size - stateSize);
+		return true;
+	}
+
+	/* Written in place, since the state is mapped
+	 * straight out of the frontend's buffer */
+	struct VFile* vfm = VFileFromMemory(data, size);
+	if (!vfm) {
 		return false;
 	}
-	vfm->seek(vfm, 0, SEEK_SET);
-	vfm->read(vfm, data, size);
+	bool success = mCoreSaveStateNamed(core, vfm, SAVESTATE_SAVEDATA | SAVESTATE_RTC);
+	off_t end = vfm->seek(vfm, 0, SEEK_CUR);
 	vfm->close(vfm);
-	return true;
+	if (end >= 0 && (size_t) end < size) {
+		memset((uint8_t*) data + end, 0, size - end);
+	}
+	return success;
 }
 
 bool retro_unserialize(const void* data, size_t size) {
-	struct VFile* vfm = VFileFromConstMemory(data, size);
-	bool success = mCoreLoadStateNamed(core, vfm, SAVESTATE_RTC);
-	vfm->close(vfm);
+	bool success;
+	if (_useFastSavestates()) {
+		success = size >= core->stateSize(core) && core->loadState(core, data);
+	} else {
+		struct VFile* vfm = VFileFromConstMemory(data, size);
+		success = mCoreLoadStateNamed(core, vfm, SAVESTATE_RTC);
+		vfm->close(vfm);
+	}
+
+	/* States saved between calls to retro_run are
+	 * at the start of vblank, and the whole of the
+	 * next frame gets drawn from them */
+	frameAligned = false;
+#ifdef M_CORE_GBA
+	if (success && core->platform(core) == PLATFORM_GBA) {
+		frameAligned = ((struct GBA*) core->board)->video.vcount == GBA_VIDEO_VERTICAL_PIXELS;
+	}
+#endif
 	return success;
 }
 
@@ -2000,23 +4327,35 @@ bool retro_load_game_special(unsigned game_type, const struct retro_game_info* i
 }
 
 void* retro_get_memory_data(unsigned id) {
+#ifdef M_CORE_GBA
 	struct GBA* gba = core->board;
+#endif
+#ifdef M_CORE_GB
 	struct GB* gb = core->board;
+#endif
 
 	if (id == RETRO_MEMORY_SAVE_RAM) {
 		return savedata;
 	}
 	if (id == RETRO_MEMORY_SYSTEM_RAM) {
+#ifdef M_CORE_GBA
 		if (core->platform(core) == PLATFORM_GBA)
 			return gba->memory.wram;
+#endif
+#ifdef M_CORE_GB
 		if (core->platform(core) == PLATFORM_GB)
 			return gb->memory.wram;
+#endif
 	}
 	if (id == RETRO_MEMORY_VIDEO_RAM) {
+#ifdef M_CORE_GBA
 		if (core->platform(core) == PLATFORM_GBA)
 			return gba->video.renderer->vram;
+#endif
+#ifdef M_CORE_GB
 		if (core->platform(core) == PLATFORM_GB)
 			return gb->video.renderer->vram;
+#endif
 	}
 
 	return 0;
@@ -2098,9 +4437,15 @@ void GBARetroLog(struct mLogger* logger, int category, enum mLogLevel level, con
 static void _postAudioBuffer(struct mAVStream* stream, blip_t* left, blip_t* right) {
 	UNUSED(stream);
 	int16_t samples[SAMPLES * 2];
+	retro_time_t audioStart = _frameStatsNow();
 	blip_read_samples(left, samples, SAMPLES, true);
 	blip_read_samples(right, samples + 1, SAMPLES, true);
-	audioCallback(samples, SAMPLES);
+	if (audioCallback(samples, SAMPLES) < SAMPLES) {
+		++retroAudioStats.overruns;
+	}
+	if (frameStatsMode) {
+		frameStatsAudioTime += _frameStatsNow() - audioStart;
+	}
 }
 
 static void _setRumble(struct mRumble* rumble, int enable) {
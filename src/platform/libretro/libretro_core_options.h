@@ -140,15 +140,86 @@ struct retro_core_option_definition option_defs_us[] = {
       },
       "Remove Known"
    },
+   {
+      "mgba_cached_interpreter",
+      "Cached Interpreter",
+      "Decode runs of GBA instructions once and reuse them while the code stays unchanged. Reduces CPU usage on low-end hardware without affecting accuracy, at the cost of roughly 1 MB of extra memory.",
+      {
+         { "OFF", NULL },
+         { "ON",  NULL },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
+   {
+      "mgba_accuracy",
+      "Accuracy",
+      "Trade emulation accuracy for speed. 'Balanced' skips open bus details that only test ROMs check. 'Fast' also stops emulating the cartridge prefetch buffer, which makes some games run slightly slower in-game but lightens the load on weak devices. Games known to need more accuracy ignore this. Takes effect after a reset.",
+      {
+         { "Accurate", NULL },
+         { "Balanced", NULL },
+         { "Fast",     NULL },
+         { NULL, NULL },
+      },
+      "Accurate"
+   },
+#ifndef DISABLE_THREADING
+   {
+      "mgba_threaded_video",
+      "Threaded Video",
+      "Render GBA video on a second thread while the emulation runs ahead, waiting for it only at the end of each frame. Frees up CPU time on multi-core devices; output is identical either way. Takes effect after a reset.",
+      {
+         { "OFF", NULL },
+         { "ON",  NULL },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
+#endif
+   {
+      "mgba_audio_resampler",
+      "Audio Resampling Quality",
+      "Choose how the PSG channels are resampled to the output rate. 'bandlimited' gives the cleanest output. 'linear' and 'nearest' are progressively cheaper and suit low-end hardware, at the cost of some aliasing.",
+      {
+         { "nearest",     NULL },
+         { "linear",      NULL },
+         { "bandlimited", NULL },
+         { NULL, NULL },
+      },
+      "bandlimited"
+   },
+   {
+      "mgba_audio_hle",
+      "High-Quality GBA Audio",
+      "Re-render the music of games using the common MP2K (Sappy) sound driver at full precision instead of playing the driver's 8-bit output. Improves sound quality but costs some extra CPU time, since the driver itself still runs. Games using other drivers are unaffected.",
+      {
+         { "OFF", NULL },
+         { "ON",  NULL },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
+   {
+      "mgba_audio_per_frame",
+      "Per-Frame Audio Delivery",
+      "Hand the frontend exactly the audio generated by each frame, in a single batch at the end of the frame, instead of in fixed 512-sample blocks. Lowers audio latency and gives frameskip a steadier reading of the frontend's audio buffer.",
+      {
+         { "OFF", NULL },
+         { "ON",  NULL },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
    {
       "mgba_frameskip",
       "Frameskip",
-      "Skip frames to avoid audio buffer under-run (crackling). Improves performance at the expense of visual smoothness. 'Auto' skips frames when advised by the frontend. 'Auto (Threshold)' utilises the 'Frameskip Threshold (%)' setting. 'Fixed Interval' utilises the 'Frameskip Interval' setting.",
+      "Skip frames to avoid audio buffer under-run (crackling). Improves performance at the expense of visual smoothness. 'Auto' skips frames when advised by the frontend. 'Auto (Threshold)' utilises the 'Frameskip Threshold (%)' setting. 'Fixed Interval' utilises the 'Frameskip Interval' setting. 'Auto (Frame Time)' times the emulation itself, dropping post-processing and then frames as needed before the audio runs dry, and remembers the level each game needs.",
       {
          { "disabled",       NULL },
          { "auto",           "Auto" },
          { "auto_threshold", "Auto (Threshold)" },
          { "fixed_interval", "Fixed Interval" },
+         { "auto_frametime", "Auto (Frame Time)" },
          { NULL, NULL },
       },
       "disabled"
@@ -198,7 +269,51 @@ struct retro_core_option_definition option_defs_us[] = {
       },
       "0"
    },
-#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
+   {
+      "mgba_input_poll",
+      "Input Polling",
+      "'Late' waits until the game first reads the buttons during a frame before asking the frontend for input, instead of polling before the frame starts. Games that read input late in the frame respond up to a frame sooner, without the cost of run-ahead.",
+      {
+         { "early", "Early" },
+         { "late",  "Late" },
+         { NULL, NULL },
+      },
+      "early"
+   },
+   {
+      "mgba_memory_profile",
+      "Memory Profile",
+      "'Low' keeps the memory used by the core down on devices with little RAM: the ROM is mapped from its file instead of being copied, and post-processing buffers are freed as soon as their filter is turned off. Mapping the ROM takes effect the next time a game is loaded. A breakdown of memory use is logged whenever a game is loaded.",
+      {
+         { "default", "Default" },
+         { "low",     "Low" },
+         { NULL, NULL },
+      },
+      "default"
+   },
+   {
+      "mgba_auto_tune",
+      "Auto-Tune Performance",
+      "Over the first minutes of play, time the emulation under progressively cheaper settings (idle loop detection, no post-processing, threaded video, 'Fast' accuracy) and keep the first that holds full speed. The result is stored per game in 'mgba_tuning.ini' in the system directory, where it overrides those options, and finished profiles are also exported to 'mgba_tuning_profiles.ini' for use as another device's 'mgba_tuning.ini'. Settings that need a reset are tried the next time the game is loaded.",
+      {
+         { "OFF", NULL },
+         { "ON",  NULL },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
+   {
+      "mgba_frame_stats",
+      "Frame Statistics",
+      "Measure how long each stage of a frame takes on this device (input, emulation, audio, post-processing and video output) and report the average, median, 95th percentile and worst case every two seconds, either to the log or on screen.",
+      {
+         { "OFF", NULL },
+         { "log", "Log" },
+         { "osd", "On-Screen" },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
    {
       "mgba_color_correction",
       "Color Correction",
@@ -212,6 +327,7 @@ struct retro_core_option_definition option_defs_us[] = {
       },
       "OFF"
    },
+#if defined(COLOR_16_BIT) && defined(COLOR_5_6_5)
    {
       "mgba_interframe_blending",
       "Interframe Blending",
@@ -226,6 +342,48 @@ struct retro_core_option_definition option_defs_us[] = {
       },
       "OFF"
    },
+#ifndef DISABLE_THREADING
+   {
+      "mgba_post_processing_thread",
+      "Threaded Interframe Blending",
+      "Blend each frame on a second thread while the next one is emulated, taking interframe blending off the emulation thread on multi-core devices. The picture is shown one frame (about 17 ms) later than it otherwise would be, which adds that much input latency. Has no effect with 'Frameskip' set to 'Auto (Frame Time)'.",
+      {
+         { "OFF", NULL },
+         { "ON",  NULL },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
+#endif
+   {
+      "mgba_output_scale",
+      "Scale Output to 240x240",
+      "Scales the picture in the core to fill a 240x240 display (such as that of the FunKey S), so the frontend can show it without scaling it again. 'Integer' centers the picture at the largest whole multiple of its size that fits. 'Nearest' and 'Bilinear' stretch it to the whole display.",
+      {
+         { "OFF",      NULL },
+         { "integer",  "Integer" },
+         { "nearest",  "Nearest" },
+         { "bilinear", "Bilinear" },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
+#endif
+#ifdef HAVE_HW_RENDER
+   {
+      "mgba_hw_render",
+      "Hardware Renderer (requires restart)",
+      "Draw GBA video on the GPU through OpenGL, leaving the CPU to run only the emulated system. Color correction and interframe blending are applied by a shader. The picture can also be rendered at a multiple of the native resolution. Needs OpenGL 3.2 or OpenGL ES 3.0; output scaling to 240x240 is not available with it.",
+      {
+         { "OFF", NULL },
+         { "1",   "Native" },
+         { "2",   "2x" },
+         { "3",   "3x" },
+         { "4",   "4x" },
+         { NULL, NULL },
+      },
+      "OFF"
+   },
 #endif
    {
       "mgba_force_gbp",
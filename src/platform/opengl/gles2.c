@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include "gles2.h"
 
+#include <mgba/core/interface.h>
 #include <mgba/core/log.h>
 #include <mgba-util/configuration.h>
 #include <mgba-util/formatting.h>
@@ -98,6 +99,10 @@ static const GLfloat _vertices[] = {
 	1.f, -1.f,
 };
 
+#ifdef GL_MAP_INVALIDATE_BUFFER_BIT
+#define GLES2_STREAM_UPLOAD
+#endif
+
 static void mGLES2ContextInit(struct VideoBackend* v, WHandle handle) {
 	UNUSED(handle);
 	struct mGLES2Context* context = (struct mGLES2Context*) v;
@@ -108,6 +113,19 @@ static void mGLES2ContextInit(struct VideoBackend* v, WHandle handle) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
+	memset(context->streamPbo, 0, sizeof(context->streamPbo));
+	context->streamIndex = 0;
+#ifdef GLES2_STREAM_UPLOAD
+	// Buffer mapping needs GL 3.0 or GLES 3.0
+	const char* version = (const char*) glGetString(GL_VERSION);
+	if (version && strncmp(version, "OpenGL ES ", strlen("OpenGL ES ")) == 0) {
+		version += strlen("OpenGL ES ");
+	}
+	if (version && version[0] >= '3') {
+		glGenBuffers(3, context->streamPbo);
+	}
+#endif
+
 	glGenBuffers(1, &context->vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, context->vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(_vertices), _vertices, GL_STATIC_DRAW);
@@ -210,6 +228,9 @@ static void mGLES2ContextDeinit(struct VideoBackend* v) {
 	struct mGLES2Context* context = (struct mGLES2Context*) v;
 	glDeleteTextures(1, &context->tex);
 	glDeleteBuffers(1, &context->vbo);
+	if (context->streamPbo[0]) {
+		glDeleteBuffers(3, context->streamPbo);
+	}
 	mGLES2ShaderDeinit(&context->initialShader);
 	mGLES2ShaderDeinit(&context->finalShader);
 	mGLES2ShaderDeinit(&context->interframeShader);
@@ -404,19 +425,53 @@ void mGLES2ContextDrawFrame(struct VideoBackend* v) {
 	}
 }
 
+#ifdef GLES2_STREAM_UPLOAD
+// Copies the frame into the next buffer in the ring and leaves it bound, returning the offset to upload from.
+// The texture upload then happens on the GPU's timeline instead of blocking until the texture is free.
+static const void* _streamFrame(struct mGLES2Context* context, const void* frame) {
+	size_t size = context->d.width * context->d.height * BYTES_PER_PIXEL;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, context->streamPbo[context->streamIndex]);
+	context->streamIndex = (context->streamIndex + 1) % 3;
+	// Orphaning the old storage lets the driver hand out fresh memory while the last upload is still in flight
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (!mapped) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return frame;
+	}
+	memcpy(mapped, frame, size);
+	if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return frame;
+	}
+	return NULL;
+}
+#endif
+
 void mGLES2ContextPostFrame(struct VideoBackend* v, const void* frame) {
 	struct mGLES2Context* context = (struct mGLES2Context*) v;
 	glBindTexture(GL_TEXTURE_2D, context->tex);
+#ifdef GLES2_STREAM_UPLOAD
+	if (context->streamPbo[0]) {
+		frame = _streamFrame(context, frame);
+	}
+#endif
+	// The texture's storage was already allocated at this size when the dimensions were set
 #ifdef COLOR_16_BIT
 #ifdef COLOR_5_6_5
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, v->width, v->height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, frame);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, v->width, v->height, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, frame);
 #else
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, v->width, v->height, 0, GL_RGBA, GL_UNSIGNED_SHORT_1_5_5_5_REV, frame);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, v->width, v->height, GL_RGBA, GL_UNSIGNED_SHORT_1_5_5_5_REV, frame);
 #endif
 #elif defined(__BIG_ENDIAN__)
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, v->width, v->height, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, frame);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, v->width, v->height, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, frame);
 #else
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, v->width, v->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, frame);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, v->width, v->height, GL_RGBA, GL_UNSIGNED_BYTE, frame);
+#endif
+#ifdef GLES2_STREAM_UPLOAD
+	if (context->streamPbo[0]) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
 #endif
 }
 
@@ -81,6 +81,10 @@ struct mGLES2Context {
 	GLuint tex;
 	GLuint vbo;
 
+	// Ring of pixel unpack buffers that frames are streamed through, if the context has them
+	GLuint streamPbo[3];
+	unsigned streamIndex;
+
 	struct mGLES2Shader initialShader;
 	struct mGLES2Shader finalShader;
 	struct mGLES2Shader interframeShader;
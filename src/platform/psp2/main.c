@@ -195,6 +195,7 @@ int main() {
 	mPSP2MapKey(&runner.params.keyMap, SCE_CTRL_SQUARE, mGUI_INPUT_SCREEN_MODE);
 
 	scePowerSetArmClockFrequency(444);
+	sceKernelChangeThreadCpuAffinityMask(sceKernelGetThreadId(), SCE_KERNEL_CPU_MASK_USER_0);
 	mGUIRunloop(&runner);
 
 	vita2d_fini();
@@ -41,6 +41,7 @@ void free(void*);
 #include <mgba/core/core.h>
 #include <mgba/core/map-cache.h>
 #include <mgba/core/mem-search.h>
+#include <mgba/core/mem-watch.h>
 #include <mgba/core/thread.h>
 #include <mgba/core/version.h>
 
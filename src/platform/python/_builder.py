@@ -28,6 +28,7 @@ ffi.set_source("mgba._pylib", """
 #include <mgba/core/map-cache.h>
 #include <mgba/core/log.h>
 #include <mgba/core/mem-search.h>
+#include <mgba/core/mem-watch.h>
 #include <mgba/core/thread.h>
 #include <mgba/core/version.h>
 #include <mgba/debugger/debugger.h>
@@ -18,3 +18,13 @@ struct mCoreCallbacks* mCorePythonCallbackCreate(void* pyobj) {
 	callbacks->context = pyobj;
 	return callbacks;
 }
+
+void mCorePythonRunFrames(struct mCore* core, size_t frames, const uint32_t* keys) {
+	size_t i;
+	for (i = 0; i < frames; ++i) {
+		if (keys) {
+			core->setKeys(core, keys[i]);
+		}
+		core->runFrame(core);
+	}
+}
@@ -7,7 +7,10 @@
 
 #include "pycommon.h"
 
+struct mCore;
+
 struct mCoreCallbacks* mCorePythonCallbackCreate(void* pyobj);
+void mCorePythonRunFrames(struct mCore* core, size_t frames, const uint32_t* keys);
 
 PYEXPORT void _mCorePythonCallbacksVideoFrameStarted(void* user);
 PYEXPORT void _mCorePythonCallbacksVideoFrameEnded(void* user);
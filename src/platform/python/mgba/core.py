@@ -5,6 +5,7 @@
 # file, You can obtain one at http://mozilla.org/MPL/2.0/.
 from ._pylib import ffi, lib  # pylint: disable=no-name-in-module
 from . import tile, audio
+from .memory import MemoryBlock, MemoryWatchSet
 from cached_property import cached_property
 from functools import wraps
 
@@ -268,6 +269,21 @@ class Core(object):
     def run_frame(self):
         self._core.runFrame(self._core)
 
+    @needs_reset
+    @protected
+    def run_frames(self, frames, inputs=None):
+        # Runs all of the frames without returning to Python in between. inputs holds raw key
+        # bitmasks for each frame, either as a sequence or as a buffer of uint32_t
+        keys = ffi.NULL
+        if inputs is not None:
+            if len(inputs) < frames:
+                raise ValueError("Not enough inputs for {} frames".format(frames))
+            if isinstance(inputs, (list, tuple)):
+                keys = ffi.new("uint32_t[]", inputs)
+            else:
+                keys = ffi.from_buffer("uint32_t[]", inputs)
+        lib.mCorePythonRunFrames(self._core, frames, keys)
+
     @needs_reset
     @protected
     def run_loop(self):
@@ -339,9 +355,21 @@ class Core(object):
         self._core.getGameCode(self._core, code)
         return ffi.string(code, 12).decode("ascii")
 
+    @cached_property
+    def memory_blocks(self):
+        blocks = ffi.new("struct mCoreMemoryBlock**")
+        count = self._core.listMemoryBlocks(self._core, blocks)
+        return [MemoryBlock(self._core, blocks[0][i]) for i in range(count)]
+
     def add_frame_callback(self, callback):
         self._callbacks.video_frame_ended.append(callback)
 
+    def watch_set(self):
+        # The set is refreshed when each frame ends, so scripts get everything it names in one go
+        watches = MemoryWatchSet(self._core)
+        self.add_frame_callback(watches.take)
+        return watches
+
     @property
     def crc32(self):
         return self._native.romCrc32
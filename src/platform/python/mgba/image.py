@@ -25,6 +25,11 @@ class Image:
             self.stride = self.width
         self.buffer = ffi.new("color_t[{}]".format(self.stride * self.height))
 
+    def view(self):
+        # Rows are stride pixels long; the memory is shared with the buffer, so no copy is made
+        view = memoryview(ffi.buffer(self.buffer))
+        return view.cast("I" if ffi.sizeof("color_t") == 4 else "H", (self.height, self.stride))
+
     def save_png(self, fileobj):
         png_file = png.PNG(fileobj, mode=png.MODE_RGBA if self.alpha else png.MODE_RGB)
         success = png_file.write_header(self)
@@ -68,6 +68,29 @@ class MemoryView(object):
         self._raw_write(self._core, self._base + address, segment, value & self._mask)
 
 
+class MemoryBlock(object):
+    def __init__(self, core, native):
+        self._core = core
+        self.id = native.id
+        self.internal_name = ffi.string(native.internalName).decode("UTF-8")
+        self.short_name = ffi.string(native.shortName).decode("UTF-8")
+        self.long_name = ffi.string(native.longName).decode("UTF-8")
+        self.start = native.start
+        self.end = native.end
+        self.size = native.size
+        self.flags = native.flags
+        self.max_segment = native.maxSegment
+        self.segment_start = native.segmentStart
+
+    def view(self):
+        # Reads and writes go straight to emulated memory, bypassing the bus and its side effects
+        size = ffi.new("size_t*")
+        pointer = self._core.getMemoryBlock(self._core, self.id, size)
+        if pointer == ffi.NULL:
+            return None
+        return memoryview(ffi.buffer(pointer, size[0]))
+
+
 class MemorySearchResult(object):
     def __init__(self, memory, result):
         self.address = result.address
@@ -100,12 +123,83 @@ class MemorySearchResult(object):
         self._memory[self.address] = v // self.guessDivisor
 
 
+class MemorySearchSnapshot(object):
+    def __init__(self, memory, native):
+        self._memory = memory
+        self._native = native
+        self._deinit = ffi.gc(native, lib.mCoreMemorySearchSnapshotDeinit)
+
+    def __len__(self):
+        return lib.mCoreMemorySearchSnapshotSize(self._native)
+
+    def narrow(self, op, value=0):
+        params = ffi.new("struct mCoreMemorySearchParams*")
+        params.type = Memory.SEARCH_INT
+        params.op = op
+        params.valueInt = int(value)
+        lib.mCoreMemorySearchSnapshotRepeat(self._memory._core, params, self._native)
+
+    def results(self, limit=10000):
+        results = ffi.new("struct mCoreMemorySearchResults*")
+        lib.mCoreMemorySearchResultsInit(results, 0)
+        lib.mCoreMemorySearchSnapshotResults(self._native, results, limit)
+        new_results = [MemorySearchResult(self._memory, lib.mCoreMemorySearchResultsGetPointer(results, i)) for i in range(lib.mCoreMemorySearchResultsSize(results))]
+        lib.mCoreMemorySearchResultsDeinit(results)
+        return new_results
+
+
+class MemoryWatchSet(object):
+    # Values are read over the bus all at once, at the end of every frame, and read back from the
+    # buffer until the next one, so a script looking at many addresses only calls into the core once
+    def __init__(self, core):
+        self._core = core
+        self._native = ffi.gc(ffi.new("struct mCoreMemoryWatchSet*"), lib.mCoreMemoryWatchSetDeinit)
+        lib.mCoreMemoryWatchSetInit(self._native)
+        self._watches = []
+
+    def add(self, address, width=1, sign="u"):
+        offset = lib.mCoreMemoryWatchSetAdd(self._native, address, width)
+        if offset < 0:
+            raise ValueError("Invalid width: {}".format(width))
+        self._watches.append((offset, width, sign not in ("u", "unsigned")))
+        return len(self._watches) - 1
+
+    def clear(self):
+        lib.mCoreMemoryWatchSetClear(self._native)
+        self._watches = []
+
+    def take(self):
+        lib.mCoreMemoryWatchSetTake(self._core, self._native)
+
+    @property
+    def frame(self):
+        return self._native.frame
+
+    def __len__(self):
+        return len(self._watches)
+
+    def __getitem__(self, index):
+        offset, width, signed = self._watches[index]
+        return int.from_bytes(ffi.buffer(self._native.values + offset, width), "little", signed=signed)
+
+    def values(self):
+        data = bytes(ffi.buffer(self._native.values, self._native.size))
+        return [int.from_bytes(data[offset:offset + width], "little", signed=signed) for offset, width, signed in self._watches]
+
+
 class Memory(object):
     SEARCH_INT = lib.mCORE_MEMORY_SEARCH_INT
     SEARCH_STRING = lib.mCORE_MEMORY_SEARCH_STRING
     SEARCH_GUESS = lib.mCORE_MEMORY_SEARCH_GUESS
 
     SEARCH_EQUAL = lib.mCORE_MEMORY_SEARCH_EQUAL
+    SEARCH_GREATER = lib.mCORE_MEMORY_SEARCH_GREATER
+    SEARCH_LESS = lib.mCORE_MEMORY_SEARCH_LESS
+    SEARCH_ANY = lib.mCORE_MEMORY_SEARCH_ANY
+    SEARCH_DELTA = lib.mCORE_MEMORY_SEARCH_DELTA
+    SEARCH_DELTA_POSITIVE = lib.mCORE_MEMORY_SEARCH_DELTA_POSITIVE
+    SEARCH_DELTA_NEGATIVE = lib.mCORE_MEMORY_SEARCH_DELTA_NEGATIVE
+    SEARCH_DELTA_ANY = lib.mCORE_MEMORY_SEARCH_DELTA_ANY
 
     READ = lib.mCORE_MEMORY_READ
     WRITE = lib.mCORE_MEMORY_READ
@@ -126,6 +220,25 @@ class Memory(object):
     def __len__(self):
         return self.size
 
+    def read_batch(self, reads):
+        # Takes (address, width) pairs relative to the base and returns the unsigned values, read in a single call
+        native = ffi.new("struct mCoreMemoryRead[]", len(reads))
+        for i, (address, width) in enumerate(reads):
+            if width not in (1, 2, 4):
+                raise ValueError("Invalid width: {}".format(width))
+            native[i].address = self.base + address
+            native[i].width = width
+        size = lib.mCoreMemoryReadBatchSize(native, len(reads))
+        out = ffi.new("uint8_t[]", max(size, 1))
+        lib.mCoreMemoryReadBatch(self._core, native, len(reads), out)
+        data = bytes(ffi.buffer(out, size))
+        values = []
+        offset = 0
+        for _, width in reads:
+            values.append(int.from_bytes(data[offset:offset + width], "little"))
+            offset += width
+        return values
+
     def search(self, value, type=SEARCH_GUESS, flags=RW, limit=10000, old_results=[]):
         results = ffi.new("struct mCoreMemorySearchResults*")
         lib.mCoreMemorySearchResultsInit(results, len(old_results))
@@ -152,6 +265,18 @@ class Memory(object):
         lib.mCoreMemorySearchResultsDeinit(results)
         return new_results
 
+    def snapshot(self, width, op=SEARCH_ANY, value=0, flags=RW):
+        native = ffi.new("struct mCoreMemorySearchSnapshot*")
+        lib.mCoreMemorySearchSnapshotInit(native)
+        params = ffi.new("struct mCoreMemorySearchParams*")
+        params.memoryFlags = flags
+        params.type = self.SEARCH_INT
+        params.op = op
+        params.width = width
+        params.valueInt = int(value)
+        lib.mCoreMemorySearchSnapshotTake(self._core, params, native)
+        return MemorySearchSnapshot(self, native)
+
     def __getitem__(self, address):
         if isinstance(address, slice):
             return bytearray(self.u8[address])
@@ -34,6 +34,13 @@ AssetView::AssetView(std::shared_ptr<CoreController> controller, QWidget* parent
 	        static_cast<void(QTimer::*)()>(&QTimer::start));
 	connect(controller.get(), &CoreController::stopping, this, &AssetView::close);
 	connect(controller.get(), &CoreController::stopping, &m_updateTimer, &QTimer::stop);
+
+	static const char* const regions[] = { "oam", "io", nullptr };
+	m_snapshotConsumer = controller->addSnapshotConsumer(regions);
+}
+
+AssetView::~AssetView() {
+	m_controller->removeSnapshotConsumer(m_snapshotConsumer);
 }
 
 void AssetView::updateTiles() {
@@ -41,6 +48,8 @@ void AssetView::updateTiles() {
 }
 
 void AssetView::updateTiles(bool force) {
+	// Objects are looked up in the copy taken at the end of the last frame; this asks for the next one
+	m_controller->requestSnapshot(m_snapshotConsumer);
 	switch (m_controller->platform()) {
 #ifdef M_CORE_GBA
 	case PLATFORM_GBA:
@@ -113,20 +122,47 @@ void AssetView::compositeTile(const void* tBuffer, void* buffer, size_t stride,
 }
 
 QImage AssetView::compositeMap(int map, mMapCacheEntry* mapStatus) {
+	QImage rawMap;
+	compositeMap(map, mapStatus, rawMap, true);
+	return rawMap;
+}
+
+bool AssetView::compositeMap(int map, mMapCacheEntry* mapStatus, QImage& rawMap, bool force) {
 	mMapCache* mapCache = mMapCacheSetGetPointer(&m_cacheSet->maps, map);
 	int tilesW = 1 << mMapCacheSystemInfoGetTilesWide(mapCache->sysConfig);
 	int tilesH = 1 << mMapCacheSystemInfoGetTilesHigh(mapCache->sysConfig);
-	QImage rawMap = QImage(QSize(tilesW * 8, tilesH * 8), QImage::Format_ARGB32);
-	uchar* bgBits = rawMap.bits();
+	QSize size(tilesW * 8, tilesH * 8);
+	if (rawMap.size() != size || rawMap.format() != QImage::Format_ARGB32) {
+		rawMap = QImage(size, QImage::Format_ARGB32);
+		force = true;
+	}
+	// Only rows of tiles that were actually redrawn get copied into the image
+	bool changed = false;
 	for (int j = 0; j < tilesH; ++j) {
+		bool rowChanged = force;
 		for (int i = 0; i < tilesW; ++i) {
-			mMapCacheCleanTile(mapCache, mapStatus, i, j);
+			if (mMapCacheCleanTile(mapCache, mapStatus, i, j)) {
+				rowChanged = true;
+			}
+		}
+		if (!rowChanged) {
+			continue;
 		}
 		for (int i = 0; i < 8; ++i) {
-			memcpy(static_cast<void*>(&bgBits[tilesW * 32 * (i + j * 8)]), mMapCacheGetRow(mapCache, i + j * 8), tilesW * 32);
+			copyRow(mMapCacheGetRow(mapCache, i + j * 8), rawMap.scanLine(i + j * 8), tilesW * 8);
 		}
+		changed = true;
+	}
+	return changed;
+}
+
+void AssetView::copyRow(const color_t* row, uchar* out, int width, bool opaque) {
+	uint32_t* pixels = reinterpret_cast<uint32_t*>(out);
+	uint32_t alpha = opaque ? 0xFF000000 : 0;
+	for (int x = 0; x < width; ++x) {
+		uint32_t color = row[x];
+		pixels[x] = (color & 0xFF00FF00) | ((color >> 16) & 0xFF) | ((color & 0xFF) << 16) | alpha;
 	}
-	return rawMap.rgbSwapped();
 }
 
 QImage AssetView::compositeObj(const ObjInfo& objInfo) {
@@ -175,7 +211,14 @@ bool AssetView::lookupObjGBA(int id, struct ObjInfo* info) {
 	}
 
 	const GBA* gba = static_cast<const GBA*>(m_controller->thread()->core->board);
-	const GBAObj* obj = &gba->video.oam.obj[id];
+	GBAOAM oam;
+	uint16_t dispcntValue;
+	if (!m_controller->readSnapshot("oam", 0, &oam, sizeof(oam)) ||
+	    !m_controller->readSnapshot("io", 0, &dispcntValue, sizeof(dispcntValue))) {
+		oam = gba->video.oam;
+		dispcntValue = gba->memory.io[0]; // FIXME: Register name can't be imported due to namespacing issues
+	}
+	const GBAObj* obj = &oam.obj[id];
 
 	unsigned shape = GBAObjAttributesAGetShape(obj->a);
 	unsigned size = GBAObjAttributesBGetSize(obj->b);
@@ -212,14 +255,14 @@ bool AssetView::lookupObjGBA(int id, struct ObjInfo* info) {
 	};
 	if (GBAObjAttributesAIsTransformed(obj->a)) {
 		int matIndex = GBAObjAttributesBGetMatIndex(obj->b);
-		const GBAOAMMatrix* mat = &gba->video.oam.mat[matIndex];
+		const GBAOAMMatrix* mat = &oam.mat[matIndex];
 		QTransform invXform(mat->a / 256., mat->c / 256., mat->b / 256., mat->d / 256., 0, 0);
 		newInfo.xform = invXform.inverted();
 	} else {
 		newInfo.hflip = bool(GBAObjAttributesBIsHFlip(obj->b));
 		newInfo.vflip = bool(GBAObjAttributesBIsVFlip(obj->b));
 	}
-	GBARegisterDISPCNT dispcnt = gba->memory.io[0]; // FIXME: Register name can't be imported due to namespacing issues
+	GBARegisterDISPCNT dispcnt = dispcntValue;
 	if (!GBARegisterDISPCNTIsObjCharacterMapping(dispcnt)) {
 		newInfo.stride = 0x20 >> (GBAObjAttributesAGet256Color(obj->a));
 	};
@@ -235,11 +278,18 @@ bool AssetView::lookupObjGB(int id, struct ObjInfo* info) {
 	}
 
 	const GB* gb = static_cast<const GB*>(m_controller->thread()->core->board);
-	const GBObj* obj = &gb->video.oam.obj[id];
+	GBOAM oam;
+	uint8_t lcdcValue;
+	if (!m_controller->readSnapshot("oam", 0, &oam, sizeof(oam)) ||
+	    !m_controller->readSnapshot("io", REG_LCDC, &lcdcValue, sizeof(lcdcValue))) {
+		oam = gb->video.oam;
+		lcdcValue = gb->memory.io[REG_LCDC];
+	}
+	const GBObj* obj = &oam.obj[id];
 
 	unsigned width = 8;
 	unsigned height = 8;
-	GBRegisterLCDC lcdc = gb->memory.io[REG_LCDC];
+	GBRegisterLCDC lcdc = lcdcValue;
 	if (GBRegisterLCDCIsObjSize(lcdc)) {
 		height = 16;
 	}
@@ -24,6 +24,7 @@ Q_OBJECT
 
 public:
 	AssetView(std::shared_ptr<CoreController> controller, QWidget* parent = nullptr);
+	~AssetView();
 
 protected slots:
 	void updateTiles();
@@ -66,6 +67,8 @@ protected:
 
 	static void compositeTile(const void* tile, void* image, size_t stride, size_t x, size_t y, int depth = 8);
 	QImage compositeMap(int map, mMapCacheEntry*);
+	bool compositeMap(int map, mMapCacheEntry*, QImage& rawMap, bool force);
+	static void copyRow(const color_t* row, uchar* out, int width, bool opaque = false);
 	QImage compositeObj(const ObjInfo&);
 
 	bool lookupObj(int id, struct ObjInfo*);
@@ -79,6 +82,7 @@ private:
 #endif
 
 	QTimer m_updateTimer;
+	int m_snapshotConsumer;
 };
 
 }
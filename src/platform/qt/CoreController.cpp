@@ -14,6 +14,9 @@
 #include <QDateTime>
 #include <QMutexLocker>
 
+#include <algorithm>
+#include <cmath>
+
 #include <mgba/core/serialize.h>
 #include <mgba/feature/video-logger.h>
 #ifdef M_CORE_GBA
@@ -29,6 +32,10 @@
 #include <mgba-util/vfs.h>
 
 #define AUTOSAVE_GRANULARITY 600
+#define LOG_BUFFER_ENTRIES 1024
+#define LOG_FLUSH_INTERVAL 16
+#define LOG_FLUSH_LIMIT 256
+#define TURBO_UNBOUNDED_FRAMESKIP 9
 
 using namespace QGBA;
 
@@ -40,6 +47,13 @@ CoreController::CoreController(mCore* core, QObject* parent)
 	m_threadContext.core = core;
 	m_threadContext.userData = this;
 
+	// The emulation thread never waits on logging: messages pile up in the buffer and get
+	// handed to the UI in batches, at most once a display frame
+	mLogBufferInit(&m_logBuffer, LOG_BUFFER_ENTRIES);
+	m_logFlushTimer.setInterval(LOG_FLUSH_INTERVAL);
+	connect(&m_logFlushTimer, &QTimer::timeout, this, &CoreController::flushLog);
+	m_logFlushTimer.start();
+
 	m_resetActions.append([this]() {
 		if (m_autoload) {
 			mCoreLoadState(m_threadContext.core, 0, m_loadStateFlags);
@@ -94,12 +108,17 @@ CoreController::CoreController(mCore* core, QObject* parent)
 
 		if (controller->m_autosaveCounter == AUTOSAVE_GRANULARITY) {
 			if (controller->m_autosave) {
-				mCoreSaveState(context->core, 0, controller->m_saveStateFlags);
+				mCoreSaveState(context->core, 0, controller->m_saveStateFlags | controller->m_autosaveCompression);
 			}
 			controller->m_autosaveCounter = 0;
 		}
 		++controller->m_autosaveCounter;
 
+		if (controller->m_snapshot) {
+			mCoreSnapshotPublish(controller->m_snapshot.get());
+		}
+		mLogBufferCommit(&controller->m_logBuffer);
+
 		controller->finishFrame();
 	};
 
@@ -107,8 +126,9 @@ CoreController::CoreController(mCore* core, QObject* parent)
 		CoreController* controller = static_cast<CoreController*>(context->userData);
 
 		if (controller->m_autosave) {
-			mCoreSaveState(context->core, 0, controller->m_saveStateFlags);
+			mCoreSaveState(context->core, 0, controller->m_saveStateFlags | controller->m_autosaveCompression);
 		}
+		mLogBufferCommit(&controller->m_logBuffer);
 
 		controller->clearMultiplayerController();
 		QMetaObject::invokeMethod(controller, "stopping");
@@ -116,6 +136,7 @@ CoreController::CoreController(mCore* core, QObject* parent)
 
 	m_threadContext.pauseCallback = [](mCoreThread* context) {
 		CoreController* controller = static_cast<CoreController*>(context->userData);
+		mLogBufferCommit(&controller->m_logBuffer);
 
 		QMetaObject::invokeMethod(controller, "paused");
 	};
@@ -177,6 +198,11 @@ CoreController::CoreController(mCore* core, QObject* parent)
 			message = QString().vsprintf(format, args);
 			QMetaObject::invokeMethod(controller, "statusPosted", Q_ARG(const QString&, message));
 		}
+		if (level != mLOG_FATAL && mCoreThreadGet() == context) {
+			// Only the emulation thread may write to the buffer
+			mLogBufferPost(&controller->m_logBuffer, category, level, format, args);
+			return;
+		}
 		message = QString().vsprintf(format, args);
 		QMetaObject::invokeMethod(controller, "logPosted", Q_ARG(int, level), Q_ARG(int, category), Q_ARG(const QString&, message));
 		if (level == mLOG_FATAL) {
@@ -191,12 +217,19 @@ CoreController::~CoreController() {
 	disconnect();
 
 	mCoreThreadJoin(&m_threadContext);
+	m_logFlushTimer.stop();
+	mLogBufferDeinit(&m_logBuffer);
 
 	if (m_cacheSet) {
 		mCacheSetDeinit(m_cacheSet.get());
 		m_cacheSet.reset();
 	}
 
+	if (m_snapshot) {
+		mCoreSnapshotDeinit(m_snapshot.get());
+		m_snapshot.reset();
+	}
+
 	mCoreConfigDeinit(&m_threadContext.core->config);
 	m_threadContext.core->deinit(m_threadContext.core);
 }
@@ -253,6 +286,9 @@ void CoreController::loadConfig(ConfigController* config) {
 	Interrupter interrupter(this);
 	m_loadStateFlags = config->getOption("loadStateExtdata", m_loadStateFlags).toInt();
 	m_saveStateFlags = config->getOption("saveStateExtdata", m_saveStateFlags).toInt();
+	// Only applies to states saved without a screenshot, which are otherwise PNGs
+	m_saveStateCompression = mStateCompressionParse(config->getOption("saveStateCompression").toUtf8().constData());
+	m_autosaveCompression = mStateCompressionParse(config->getOption("autosaveCompression").toUtf8().constData());
 	m_fastForwardRatio = config->getOption("fastForwardRatio", m_fastForwardRatio).toFloat();
 	m_fastForwardHeldRatio = config->getOption("fastForwardHeldRatio", m_fastForwardRatio).toFloat();
 	m_videoSync = config->getOption("videoSync", m_videoSync).toInt();
@@ -263,6 +299,7 @@ void CoreController::loadConfig(ConfigController* config) {
 	m_autofireThreshold = config->getOption("autofireThreshold", m_autofireThreshold).toInt();
 	m_fastForwardVolume = config->getOption("fastForwardVolume", -1).toInt();
 	m_fastForwardMute = config->getOption("fastForwardMute", -1).toInt();
+	m_fastForwardTurbo = config->getOption("fastForwardTurbo", false).toInt();
 	mCoreConfigCopyValue(&m_threadContext.core->config, config->config(), "volume");
 	mCoreConfigCopyValue(&m_threadContext.core->config, config->config(), "mute");
 
@@ -349,6 +386,55 @@ mCacheSet* CoreController::graphicCaches() {
 	return m_cacheSet.get();
 }
 
+int CoreController::addSnapshotConsumer(const char* const* regions) {
+	if (!m_snapshot) {
+		Interrupter interrupter(this);
+		m_snapshot = std::make_unique<mCoreSnapshot>();
+		mCoreSnapshotInit(m_snapshot.get(), m_threadContext.core);
+	}
+	return mCoreSnapshotAddConsumer(m_snapshot.get(), regions);
+}
+
+void CoreController::removeSnapshotConsumer(int consumer) {
+	if (m_snapshot) {
+		mCoreSnapshotRemoveConsumer(m_snapshot.get(), consumer);
+	}
+}
+
+void CoreController::requestSnapshot(int consumer) {
+	if (!m_snapshot || consumer < 0) {
+		return;
+	}
+	mCoreSnapshotRequest(m_snapshot.get(), consumer);
+	if (isPaused()) {
+		// No frame is coming to publish it, but nothing is running to be held up either
+		Interrupter interrupter(this);
+		mCoreSnapshotPublish(m_snapshot.get());
+	}
+}
+
+bool CoreController::readSnapshot(const char* region, size_t offset, void* out, size_t size) {
+	if (!m_snapshot) {
+		return false;
+	}
+	ssize_t id = mCoreSnapshotFindRegion(m_snapshot.get(), region);
+	if (id < 0) {
+		return false;
+	}
+	return mCoreSnapshotRead(m_snapshot.get(), id, offset, out, size);
+}
+
+uint32_t CoreController::snapshotGeneration(const char* region) {
+	if (!m_snapshot) {
+		return 0;
+	}
+	ssize_t id = mCoreSnapshotFindRegion(m_snapshot.get(), region);
+	if (id < 0) {
+		return 0;
+	}
+	return mCoreSnapshotGeneration(m_snapshot.get(), id);
+}
+
 void CoreController::setOverride(std::unique_ptr<Override> override) {
 	Interrupter interrupter(this);
 	m_override = std::move(override);
@@ -369,6 +455,22 @@ void CoreController::setLogger(LogController* logger) {
 	connect(this, &CoreController::logPosted, m_log, &LogController::postLog);
 }
 
+void CoreController::flushLog() {
+	mLogBufferEntry entry;
+	int flushed;
+	for (flushed = 0; flushed < LOG_FLUSH_LIMIT && mLogBufferRead(&m_logBuffer, &entry); ++flushed) {
+		QString message = QString::fromUtf8(entry.message);
+		if (entry.repeats > 1) {
+			message = tr("%1 (repeated %2 times)").arg(message).arg(entry.repeats);
+		}
+		emit logPosted(entry.level, entry.category, message);
+	}
+	int dropped = mLogBufferTakeDropped(&m_logBuffer);
+	if (dropped) {
+		LOG(QT, WARN) << tr("Dropped %1 log messages").arg(dropped);
+	}
+}
+
 void CoreController::start() {
 	if (!m_hwaccel) {
 		QSize size(256, 224);
@@ -541,7 +643,7 @@ void CoreController::saveState(int slot) {
 			vf->read(vf, controller->m_backupSaveState.data(), controller->m_backupSaveState.size());
 			vf->close(vf);
 		}
-		mCoreSaveState(context->core, controller->m_stateSlot, controller->m_saveStateFlags);
+		mCoreThreadSaveState(context, controller->m_stateSlot, controller->m_saveStateFlags | controller->m_saveStateCompression | SAVESTATE_THUMBNAIL);
 	});
 }
 
@@ -559,7 +661,7 @@ void CoreController::saveState(const QString& path) {
 		if (!vf) {
 			return;
 		}
-		mCoreSaveStateNamed(context->core, vf, controller->m_saveStateFlags);
+		mCoreSaveStateNamed(context->core, vf, controller->m_saveStateFlags | controller->m_saveStateCompression);
 		vf->close(vf);
 	});
 }
@@ -839,7 +941,8 @@ void CoreController::startVideoLog(const QString& path, bool compression) {
 	if (!vf) {
 		return;
 	}
-	startVideoLog(vf);
+	// Log blocks are written from the emulation thread, so keep it from waiting on the disk
+	startVideoLog(VFileAsync(vf, 0x400000), compression);
 }
 
 void CoreController::startVideoLog(VFile* vf, bool compression) {
@@ -931,6 +1034,17 @@ void CoreController::updateFastForward() {
 			m_threadContext.core->opts.mute = m_fastForwardMute;
 		}
 
+		// Render only about as many frames as the display shows, leaving
+		// the rest to the skip path, which keeps the renderer's state current
+		float ratio = m_fastForward ? m_fastForwardHeldRatio : m_fastForwardRatio;
+		if (m_fastForwardTurbo) {
+			int frameskip = ratio > 0 ? std::ceil(ratio) - 1 : TURBO_UNBOUNDED_FRAMESKIP;
+			mCoreConfigSetOverrideIntValue(&m_threadContext.core->config, "frameskip", std::max(frameskip, 0));
+			m_threadContext.core->reloadConfigOption(m_threadContext.core, "frameskip", nullptr);
+		} else {
+			restoreFrameskip();
+		}
+
 		// If we aren't holding the fast forward button
 		// then use the non "(held)" ratio
 		if(!m_fastForward) {
@@ -959,11 +1073,18 @@ void CoreController::updateFastForward() {
 		m_threadContext.core->opts.mute = fakeBool;
 		m_threadContext.impl->sync.fpsTarget = m_fpsTarget;
 		setSync(true);
+		restoreFrameskip();
 	}
 
 	m_threadContext.core->reloadConfigOption(m_threadContext.core, NULL, NULL);
 }
 
+void CoreController::restoreFrameskip() {
+	mCoreConfigSetOverrideValue(&m_threadContext.core->config, "frameskip", nullptr);
+	m_threadContext.core->opts.frameskip = 0;
+	mCoreConfigGetIntValue(&m_threadContext.core->config, "frameskip", &m_threadContext.core->opts.frameskip);
+}
+
 CoreController::Interrupter::Interrupter(CoreController* parent, bool fromThread)
 	: m_parent(parent)
 {
@@ -10,6 +10,7 @@
 #include <QMutex>
 #include <QObject>
 #include <QSize>
+#include <QTimer>
 
 #include "VFileDevice.h"
 
@@ -18,8 +19,10 @@
 
 #include <mgba/core/core.h>
 #include <mgba/core/interface.h>
+#include <mgba/core/log-buffer.h>
 #include <mgba/core/thread.h>
 #include <mgba/core/cache-set.h>
+#include <mgba/core/snapshot.h>
 
 #ifdef M_CORE_GB
 #include <mgba/internal/gb/sio/printer.h>
@@ -91,6 +94,15 @@ public:
 	MultiplayerController* multiplayerController() { return m_multiplayer; }
 
 	mCacheSet* graphicCaches();
+
+	// Inspection tools read memory from copies the emulation thread takes at the end of a frame,
+	// rather than interrupting it: each asks for a fresh copy, then reads it once the next frame is out
+	int addSnapshotConsumer(const char* const* regions);
+	void removeSnapshotConsumer(int consumer);
+	void requestSnapshot(int consumer);
+	bool readSnapshot(const char* region, size_t offset, void* out, size_t size);
+	uint32_t snapshotGeneration(const char* region);
+
 	int stateSlot() const { return m_stateSlot; }
 
 	void setOverride(std::unique_ptr<Override> override);
@@ -190,12 +202,16 @@ signals:
 
 	void imagePrinted(const QImage&);
 
+private slots:
+	void flushLog();
+
 private:
 	void updateKeys();
 	int updateAutofire();
 	void finishFrame();
 
 	void updateFastForward();
+	void restoreFrameskip();
 
 	mCoreThread m_threadContext{};
 
@@ -206,6 +222,7 @@ private:
 	bool m_hwaccel = false;
 
 	std::unique_ptr<mCacheSet> m_cacheSet;
+	std::unique_ptr<mCoreSnapshot> m_snapshot;
 	std::unique_ptr<Override> m_override;
 
 	QList<std::function<void()>> m_resetActions;
@@ -224,6 +241,8 @@ private:
 	QString m_statePath;
 	int m_loadStateFlags;
 	int m_saveStateFlags;
+	int m_saveStateCompression = 0;
+	int m_autosaveCompression = 0;
 
 	bool m_audioSync = AUDIO_SYNC;
 	bool m_videoSync = VIDEO_SYNC;
@@ -236,12 +255,15 @@ private:
 	int m_fastForwardForced = false;
 	int m_fastForwardVolume = -1;
 	int m_fastForwardMute = -1;
+	bool m_fastForwardTurbo = false;
 	float m_fastForwardRatio = -1.f;
 	float m_fastForwardHeldRatio = -1.f;
 	float m_fpsTarget;
 
 	InputController* m_inputController = nullptr;
 	LogController* m_log = nullptr;
+	mLogBuffer m_logBuffer;
+	QTimer m_logFlushTimer;
 	MultiplayerController* m_multiplayer = nullptr;
 
 	mVideoLogContext* m_vl = nullptr;
@@ -6,6 +6,7 @@
 #include "FrameView.h"
 
 #include <QMouseEvent>
+#include <QPainter>
 #include <QPalette>
 
 #include <array>
@@ -29,6 +30,8 @@
 
 using namespace QGBA;
 
+static const int HIGHLIGHT_AMOUNT = 112;
+
 FrameView::FrameView(std::shared_ptr<CoreController> controller, QWidget* parent)
 	: AssetView(controller, parent)
 {
@@ -50,6 +53,7 @@ FrameView::FrameView(std::shared_ptr<CoreController> controller, QWidget* parent
 		} else {
 			m_disabled.insert(layer.id);
 		}
+		invalidatePlanes();
 		invalidateQueue();
 	});
 	connect(m_ui.queue, &QListWidget::currentItemChanged, this, [this](QListWidgetItem* item) {
@@ -69,7 +73,9 @@ FrameView::FrameView(std::shared_ptr<CoreController> controller, QWidget* parent
 	m_backdropPicker = ColorPicker(m_ui.backdrop, QColor(0, 0, 0, 0));
 	connect(&m_backdropPicker, &ColorPicker::colorChanged, this, [this](const QColor& color) {
 		m_overrideBackdrop = color;
+		invalidatePlanes();
 	});
+	connect(m_ui.disableScanline, &QCheckBox::stateChanged, this, &FrameView::invalidatePlanes);
 	m_controller->addFrameAction(std::bind(&FrameView::frameCallback, this, m_callbackLocker));
 
 	{
@@ -139,6 +145,32 @@ void FrameView::disableLayer(const QPointF& coord) {
 	}
 	layer->enabled = false;
 	m_disabled.insert(layer->id);
+	invalidatePlanes();
+}
+
+void FrameView::invalidatePlanes() {
+	QMutexLocker locker(&m_mutex);
+	m_planesDirty = true;
+	m_highlightPlanes.clear();
+}
+
+QImage FrameView::renderPlane(const LayerId& highlight) {
+	switch (m_controller->platform()) {
+#ifdef M_CORE_GBA
+	case PLATFORM_GBA:
+		injectGBA(highlight);
+		break;
+#endif
+#ifdef M_CORE_GB
+	case PLATFORM_GB:
+		injectGB(highlight);
+		break;
+#endif
+	default:
+		break;
+	}
+	m_vl->runFrame(m_vl);
+	return m_framebuffer.copy();
 }
 
 #ifdef M_CORE_GBA
@@ -235,7 +267,7 @@ void FrameView::updateTilesGBA(bool force) {
 	invalidateQueue(QSize(GBA_VIDEO_HORIZONTAL_PIXELS, GBA_VIDEO_VERTICAL_PIXELS));
 }
 
-void FrameView::injectGBA() {
+void FrameView::injectGBA(const LayerId& highlight) {
 	mVideoLogger* logger = m_vl->videoLogger;
 	mVideoLoggerInjectionPoint(logger, LOGGER_INJECTION_FIRST_SCANLINE);
 	GBA* gba = static_cast<GBA*>(m_vl->board);
@@ -248,7 +280,7 @@ void FrameView::injectGBA() {
 	}
 	QPalette palette;
 	gba->video.renderer->highlightColor = palette.color(QPalette::HighlightedText).rgb();
-	gba->video.renderer->highlightAmount = sin(m_glowFrame * M_PI / 30) * 48 + 64;
+	gba->video.renderer->highlightAmount = HIGHLIGHT_AMOUNT;
 	if (!m_overrideBackdrop.isValid()) {
 		QRgb backdrop = M_RGB5_TO_RGB8(gba->video.palette[0]) | 0xFF000000;
 		m_backdropPicker.setColor(backdrop);
@@ -261,13 +293,13 @@ void FrameView::injectGBA() {
 			if (!layer.enabled) {
 				mVideoLoggerInjectOAM(logger, layer.id.index << 2, 0x200);
 			}
-			if (layer.id == m_active) {
+			if (layer.id == highlight) {
 				gba->video.renderer->highlightOBJ[layer.id.index] = true;
 			}
 			break;
 		case LayerId::BACKGROUND:
 			m_vl->enableVideoLayer(m_vl, layer.id.index, layer.enabled);
-			if (layer.id == m_active) {
+			if (layer.id == highlight) {
 				gba->video.renderer->highlightBG[layer.id.index] = true;
 			}
 			break;
@@ -297,7 +329,7 @@ void FrameView::updateTilesGB(bool force) {
 	invalidateQueue(m_controller->screenDimensions());
 }
 
-void FrameView::injectGB() {
+void FrameView::injectGB(const LayerId&) {
 	for (const Layer& layer : m_queue) {
 	}
 }
@@ -310,17 +342,14 @@ void FrameView::invalidateQueue(const QSize& dims) {
 	bool blockSignals = m_ui.queue->blockSignals(true);
 	QMutexLocker locker(&m_mutex);
 	if (m_vl) {
-		switch (m_controller->platform()) {
-#ifdef M_CORE_GBA
-		case PLATFORM_GBA:
-			injectGBA();
-#endif
-#ifdef M_CORE_GB
-		case PLATFORM_GB:
-			injectGB();
-#endif
+		// Only render what isn't cached yet; selecting a layer or animating the glow just composites
+		if (m_planesDirty) {
+			m_basePlane = renderPlane({});
+			m_planesDirty = false;
+		}
+		if (m_active.type != LayerId::NONE && !m_highlightPlanes.contains(m_active)) {
+			m_highlightPlanes.insert(m_active, renderPlane(m_active));
 		}
-		m_vl->runFrame(m_vl);
 	}
 
 	for (int i = 0; i < m_queue.count(); ++i) {
@@ -345,12 +374,19 @@ void FrameView::invalidateQueue(const QSize& dims) {
 	m_ui.queue->blockSignals(blockSignals);
 
 	QPixmap composited;
-	if (m_framebuffer.isNull()) {
+	if (m_basePlane.isNull()) {
 		updateRendered();
 		composited = m_rendered;
 	} else {
 		m_ui.exportButton->setEnabled(true);
-		composited.convertFromImage(m_framebuffer);
+		QImage frame(m_basePlane);
+		auto plane = m_highlightPlanes.constFind(m_active);
+		if (m_active.type != LayerId::NONE && plane != m_highlightPlanes.constEnd()) {
+			QPainter painter(&frame);
+			painter.setOpacity((sin(m_glowFrame * M_PI / 30) * 48 + 64) / HIGHLIGHT_AMOUNT);
+			painter.drawImage(0, 0, *plane);
+		}
+		composited.convertFromImage(frame);
 	}
 	m_composited = composited.scaled(m_dims * m_ui.magnification->value());
 	m_ui.compositedView->setPixmap(m_composited);
@@ -415,6 +451,7 @@ void FrameView::newVl() {
 	m_framebuffer = QImage(width, height, QImage::Format_RGBX8888);
 	m_vl->setVideoBuffer(m_vl, reinterpret_cast<color_t*>(m_framebuffer.bits()), width);
 	m_vl->reset(m_vl);
+	invalidatePlanes();
 }
 
 void FrameView::frameCallback(FrameView* viewer, std::shared_ptr<bool> lock) {
@@ -429,8 +466,8 @@ void FrameView::frameCallback(FrameView* viewer, std::shared_ptr<bool> lock) {
 void FrameView::exportFrame() {
 	QString filename = GBAApp::app()->getSaveFileName(this, tr("Export frame"),
 	                                                  tr("Portable Network Graphics (*.png)"));
-	CoreController::Interrupter interrupter(m_controller);
-	m_framebuffer.save(filename, "PNG");
+	QMutexLocker locker(&m_mutex);
+	m_basePlane.save(filename, "PNG");
 }
 
 void FrameView::reset() {
@@ -439,6 +476,7 @@ void FrameView::reset() {
 		layer.enabled = true;
 	}
 	m_overrideBackdrop = QColor();
+	invalidatePlanes();
 	invalidateQueue();
 }
 
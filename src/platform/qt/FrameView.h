@@ -8,6 +8,7 @@
 #include "ui_FrameView.h"
 
 #include <QBitmap>
+#include <QHash>
 #include <QImage>
 #include <QList>
 #include <QMutex>
@@ -44,11 +45,9 @@ public slots:
 protected:
 #ifdef M_CORE_GBA
 	void updateTilesGBA(bool force) override;
-	void injectGBA();
 #endif
 #ifdef M_CORE_GB
 	void updateTilesGB(bool force) override;
-	void injectGB();
 #endif
 
 	bool eventFilter(QObject* obj, QEvent* event) override;
@@ -85,6 +84,14 @@ private:
 	};
 
 	bool lookupLayer(const QPointF& coord, Layer*&);
+	void invalidatePlanes();
+	QImage renderPlane(const LayerId& highlight);
+#ifdef M_CORE_GBA
+	void injectGBA(const LayerId& highlight);
+#endif
+#ifdef M_CORE_GB
+	void injectGB(const LayerId& highlight);
+#endif
 
 	static void frameCallback(FrameView*, std::shared_ptr<bool>);
 
@@ -101,6 +108,13 @@ private:
 	mCore* m_vl = nullptr;
 	QImage m_framebuffer;
 
+	// Renders of the captured frame, kept until it or the injected state changes. The base plane
+	// has nothing highlighted; each highlight plane has one layer lit at full strength, so the glow
+	// only has to fade it in over the base instead of rendering the frame again.
+	bool m_planesDirty = true;
+	QImage m_basePlane;
+	QHash<LayerId, QImage> m_highlightPlanes;
+
 	QSize m_dims;
 	QList<Layer> m_queue;
 	QSet<LayerId> m_disabled;
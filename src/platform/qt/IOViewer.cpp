@@ -1066,19 +1066,53 @@ IOViewer::IOViewer(std::shared_ptr<CoreController> controller, QWidget* parent)
 		connect(m_b[i], &QAbstractButton::toggled, this, &IOViewer::bitFlipped);
 	}
 
+	static const char* const regions[] = { "io", nullptr };
+	m_snapshotConsumer = controller->addSnapshotConsumer(regions);
+	connect(controller.get(), &CoreController::frameAvailable, this, &IOViewer::snapshotTaken);
+
 	selectRegister(0);
 
 	connect(controller.get(), &CoreController::stopping, this, &QWidget::close);
 }
 
+IOViewer::~IOViewer() {
+	m_controller->removeSnapshotConsumer(m_snapshotConsumer);
+}
+
 void IOViewer::updateRegister() {
-	m_value = 0;
+	if (m_snapshotConsumer >= 0) {
+		m_snapshotPending = true;
+		m_snapshotGeneration = m_controller->snapshotGeneration("io");
+		m_controller->requestSnapshot(m_snapshotConsumer);
+		if (m_controller->isPaused()) {
+			snapshotTaken();
+		}
+		return;
+	}
+
 	uint16_t value = 0;
 	{
 		CoreController::Interrupter interrupter(m_controller);
 		value = GBAView16(static_cast<ARMCore*>(m_controller->thread()->core->cpu), BASE_IO | m_register);
 	}
+	showValue(value);
+}
+
+void IOViewer::snapshotTaken() {
+	// Frames that were already on their way when the copy was asked for don't have it yet
+	if (!m_snapshotPending || m_controller->snapshotGeneration("io") == m_snapshotGeneration) {
+		return;
+	}
+	uint16_t value;
+	if (!m_controller->readSnapshot("io", m_register, &value, sizeof(value))) {
+		return;
+	}
+	m_snapshotPending = false;
+	showValue(value);
+}
 
+void IOViewer::showValue(uint16_t value) {
+	m_value = 0;
 	for (int i = 0; i < 16; ++i) {
 		m_b[i]->setChecked(value & (1 << i) ? Qt::Checked : Qt::Unchecked);
 	}
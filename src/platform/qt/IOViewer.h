@@ -41,6 +41,7 @@ public:
 	typedef QList<RegisterItem> RegisterDescription;
 
 	IOViewer(std::shared_ptr<CoreController> controller, QWidget* parent = nullptr);
+	~IOViewer();
 
 	static const QList<RegisterDescription>& registerDescriptions();
 
@@ -56,13 +57,19 @@ private slots:
 	void bitFlipped();
 	void writeback();
 	void selectRegister();
+	void snapshotTaken();
 
 private:
+	void showValue(uint16_t value);
+
 	static QList<RegisterDescription> s_registers;
 	Ui::IOViewer m_ui;
 
 	unsigned m_register;
 	uint16_t m_value;
+	int m_snapshotConsumer;
+	bool m_snapshotPending = false;
+	uint32_t m_snapshotGeneration = 0;
 
 	QCheckBox* m_b[16];
 
@@ -184,25 +184,39 @@ void LoadSaveState::loadState(int slot) {
 		return;
 	}
 
-	mStateExtdata extdata;
-	mStateExtdataInit(&extdata);
-	void* state = mCoreExtractState(thread->core, vf, &extdata);
-	vf->seek(vf, 0, SEEK_SET);
-	if (!state) {
-		m_slots[slot - 1]->setText(tr("Corrupted"));
-		mStateExtdataDeinit(&extdata);
-		return;
-	}
-
 	QDateTime creation;
 	QImage stateImage;
 
 	unsigned width, height;
 	thread->core->desiredVideoDimensions(thread->core, &width, &height);
 	mStateExtdataItem item;
-	if (mStateExtdataGet(&extdata, EXTDATA_SCREENSHOT, &item) && item.size >= width * height * 4) {
-		stateImage = QImage((uchar*) item.data, width, height, QImage::Format_ARGB32).rgbSwapped();
+
+	// States with a thumbnail don't need to be read in full just to fill in the picker
+	static const mStateExtdataTag tags[] = { EXTDATA_THUMBNAIL, EXTDATA_META_TIME };
+	mStateExtdata extdata;
+	mStateExtdataInit(&extdata);
+	void* state = nullptr;
+	unsigned thumbWidth, thumbHeight;
+	if (mCoreExtractExtdata(thread->core, vf, &extdata, tags, 2) && mStateExtdataGet(&extdata, EXTDATA_THUMBNAIL, &item) &&
+	    mStateThumbnailDecode(&item, &thumbWidth, &thumbHeight, nullptr, 0)) {
+		stateImage = QImage(thumbWidth, thumbHeight, QImage::Format_ARGB32);
+		mStateThumbnailDecode(&item, &thumbWidth, &thumbHeight, reinterpret_cast<color_t*>(stateImage.bits()), stateImage.bytesPerLine() / BYTES_PER_PIXEL);
+		stateImage = stateImage.rgbSwapped().scaled(width, height);
+	} else {
+		mStateExtdataDeinit(&extdata);
+		mStateExtdataInit(&extdata);
+		state = mCoreExtractState(thread->core, vf, &extdata);
+		if (!state) {
+			m_slots[slot - 1]->setText(tr("Corrupted"));
+			mStateExtdataDeinit(&extdata);
+			vf->close(vf);
+			return;
+		}
+		if (mStateExtdataGet(&extdata, EXTDATA_SCREENSHOT, &item) && item.size >= width * height * 4) {
+			stateImage = QImage((uchar*) item.data, width, height, QImage::Format_ARGB32).rgbSwapped();
+		}
 	}
+	vf->seek(vf, 0, SEEK_SET);
 
 	if (mStateExtdataGet(&extdata, EXTDATA_META_TIME, &item) && item.size == sizeof(uint64_t)) {
 		uint64_t creationUsec;
@@ -222,8 +236,11 @@ void LoadSaveState::loadState(int slot) {
 	} else {
 		m_slots[slot - 1]->setText(QString());
 	}
+	mStateExtdataDeinit(&extdata);
 	vf->close(vf);
-	mappedMemoryFree(state, thread->core->stateSize(thread->core));
+	if (state) {
+		mappedMemoryFree(state, thread->core->stateSize(thread->core));
+	}
 }
 
 void LoadSaveState::triggerState(int slot) {
@@ -20,7 +20,7 @@ LogController::LogController(int levels, QObject* parent)
 	mLogFilterInit(&m_filter);
 	mLogFilterSet(&m_filter, "gba.bios", mLOG_STUB | mLOG_FATAL);
 	mLogFilterSet(&m_filter, "core.status", mLOG_ALL & ~mLOG_DEBUG);
-	m_filter.defaultLevels = levels;
+	mLogFilterSetDefaultLevels(&m_filter, levels);
 	s_qtCat = mLogCategoryById("platform.qt");
 
 	if (this != &s_global) {
@@ -84,17 +84,17 @@ void LogController::postLog(int level, int category, const QString& string) {
 }
 
 void LogController::setLevels(int levels) {
-	m_filter.defaultLevels = levels;
+	mLogFilterSetDefaultLevels(&m_filter, levels);
 	emit levelsSet(levels);
 }
 
 void LogController::enableLevels(int levels) {
-	m_filter.defaultLevels |= levels;
+	mLogFilterSetDefaultLevels(&m_filter, m_filter.defaultLevels | levels);
 	emit levelsEnabled(levels);
 }
 
 void LogController::disableLevels(int levels) {
-	m_filter.defaultLevels &= ~levels;
+	mLogFilterSetDefaultLevels(&m_filter, m_filter.defaultLevels & ~levels);
 	emit levelsDisabled(levels);
 }
 
@@ -160,6 +160,7 @@ bool MapView::eventFilter(QObject* obj, QEvent* event) {
 }
 
 void MapView::updateTilesGBA(bool force) {
+	bool changed = false;
 	{
 		CoreController::Interrupter interrupter(m_controller);
 		int bitmap = -1;
@@ -219,13 +220,17 @@ void MapView::updateTilesGBA(bool force) {
 			m_ui.bgInfo->setCustomProperty("priority", priority);
 			m_ui.bgInfo->setCustomProperty("offset", offset);
 			m_ui.bgInfo->setCustomProperty("transform", transform);
-			m_rawMap = QImage(QSize(width, height), QImage::Format_ARGB32);
-			uchar* bgBits = m_rawMap.bits();
+			if (m_rawMap.size() != QSize(width, height) || m_rawMap.format() != QImage::Format_RGB32 || m_rawSource != bitmap * 2 + frame) {
+				m_rawMap = QImage(QSize(width, height), QImage::Format_RGB32);
+				m_rawSource = bitmap * 2 + frame;
+				force = true;
+			}
 			for (int j = 0; j < height; ++j) {
-				mBitmapCacheCleanRow(bitmapCache, m_bitmapStatus, j);
-				memcpy(static_cast<void*>(&bgBits[width * j * 4]), mBitmapCacheGetRow(bitmapCache, j), width * 4);
+				if (mBitmapCacheCleanRow(bitmapCache, m_bitmapStatus, j) || force) {
+					copyRow(mBitmapCacheGetRow(bitmapCache, j), m_rawMap.scanLine(j), width, true);
+					changed = true;
+				}
 			}
-			m_rawMap = m_rawMap.convertToFormat(QImage::Format_RGB32).rgbSwapped();
 		} else {
 			mMapCache* mapCache = mMapCacheSetGetPointer(&m_cacheSet->maps, m_map);
 			int tilesW = 1 << mMapCacheSystemInfoGetTilesWide(mapCache->sysConfig);
@@ -240,9 +245,16 @@ void MapView::updateTilesGBA(bool force) {
 			m_ui.bgInfo->setCustomProperty("priority", priority);
 			m_ui.bgInfo->setCustomProperty("offset", offset);
 			m_ui.bgInfo->setCustomProperty("transform", transform);
-			m_rawMap = compositeMap(m_map, m_mapStatus);
+			if (m_rawSource >= 0) {
+				m_rawSource = -1;
+				force = true;
+			}
+			changed = compositeMap(m_map, m_mapStatus, m_rawMap, force);
 		}
 	}
+	if (!changed && !force) {
+		return;
+	}
 	QPixmap map = QPixmap::fromImage(m_rawMap.convertToFormat(QImage::Format_RGB32));
 	if (m_ui.magnification->value() > 1) {
 		map = map.scaled(map.size() * m_ui.magnification->value());
@@ -47,6 +47,8 @@ private:
 	mBitmapCacheEntry m_bitmapStatus[512 * 2] = {}; // TODO: Correct size
 	int m_map = 0;
 	QImage m_rawMap;
+	// Which bitmap and frame m_rawMap holds, or -1 for a tile map
+	int m_rawSource = -1;
 	int m_boundary;
 	int m_addressBase;
 	int m_addressWidth;
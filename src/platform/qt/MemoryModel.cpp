@@ -119,6 +119,7 @@ void MemoryModel::setRegion(uint32_t base, uint32_t size, const QString& name, i
 	m_regionName = QStaticText(name);
 	m_regionName.prepare(QTransform(), m_font);
 	m_currentBank = segment;
+	m_snapshotStale = true;
 	verticalScrollBar()->setRange(0, (size >> 4) + 1 - viewport()->size().height() / m_cellHeight);
 	verticalScrollBar()->setValue(0);
 	viewport()->update();
@@ -126,6 +127,7 @@ void MemoryModel::setRegion(uint32_t base, uint32_t size, const QString& name, i
 
 void MemoryModel::setSegment(int segment) {
 	m_currentBank = segment;
+	m_snapshotStale = true;
 	viewport()->update();
 }
 
@@ -200,6 +202,7 @@ void MemoryModel::paste() {
 	}
 	QByteArray bytestring(QByteArray::fromHex(string.toLocal8Bit()));
 	deserialize(bytestring);
+	m_snapshotStale = true;
 	viewport()->update();
 }
 
@@ -229,6 +232,7 @@ void MemoryModel::load() {
 	}
 	QByteArray bytestring(infile.readAll());
 	deserialize(bytestring);
+	m_snapshotStale = true;
 	viewport()->update();
 }
 
@@ -345,12 +349,16 @@ void MemoryModel::paintEvent(QPaintEvent* event) {
 		painter.drawText(QRectF(QPointF(m_cellSize.width() * x + m_margins.left(), 0), m_cellSize), Qt::AlignHCenter,
 		                 QString::number(x, 16).toUpper());
 	}
+	ensureSnapshot();
 	int height = (viewport()->size().height() - m_cellHeight) / m_cellHeight;
 	for (int y = 0; y < height; ++y) {
 		int yp = m_cellHeight * y + m_margins.top();
 		if ((y + m_top) * 16 >= m_size) {
 			break;
 		}
+		if (yp + m_cellHeight <= event->rect().top() || yp > event->rect().bottom()) {
+			continue;
+		}
 		QString data;
 		if (m_currentBank >= 0) {
 			data = arg2.arg(m_currentBank, 2, 16, c0).arg((y + m_top) * 16 + m_base, 4, 16, c0).toUpper();
@@ -379,7 +387,7 @@ void MemoryModel::paintEvent(QPaintEvent* event) {
 				} else {
 					painter.setPen(palette.color(QPalette::WindowText));
 				}
-				uint16_t b = m_core->rawRead16(m_core, address, m_currentBank);
+				uint16_t b = snapshotRead16(address);
 				painter.drawStaticText(
 				    QPointF(m_cellSize.width() * (x + 1.0) - 2 * m_letterWidth + m_margins.left(), yp),
 				    m_staticNumbers[(b >> 8) & 0xFF]);
@@ -407,7 +415,7 @@ void MemoryModel::paintEvent(QPaintEvent* event) {
 				} else {
 					painter.setPen(palette.color(QPalette::WindowText));
 				}
-				uint32_t b = m_core->rawRead32(m_core, address, m_currentBank);
+				uint32_t b = snapshotRead32(address);
 				painter.drawStaticText(
 				    QPointF(m_cellSize.width() * (x + 2.0) - 4 * m_letterWidth + m_margins.left(), yp),
 				    m_staticNumbers[(b >> 24) & 0xFF]);
@@ -440,7 +448,7 @@ void MemoryModel::paintEvent(QPaintEvent* event) {
 				} else {
 					painter.setPen(palette.color(QPalette::WindowText));
 				}
-				uint8_t b = m_core->rawRead8(m_core, address, m_currentBank);
+				uint8_t b = snapshotRead8(address);
 				painter.drawStaticText(QPointF(m_cellSize.width() * (x + 0.5) - m_letterWidth + m_margins.left(), yp),
 				                       m_staticNumbers[b]);
 			}
@@ -452,16 +460,16 @@ void MemoryModel::paintEvent(QPaintEvent* event) {
 			uint32_t b;
 			switch (m_align) {
 			case 1:
-				b = m_core->rawRead8(m_core, (y + m_top) * 16 + x + m_base, m_currentBank);
+				b = snapshotRead8((y + m_top) * 16 + x + m_base);
 				array.append((char) b);
 				break;
 			case 2:
-				b = m_core->rawRead16(m_core, (y + m_top) * 16 + x + m_base, m_currentBank);
+				b = snapshotRead16((y + m_top) * 16 + x + m_base);
 				array.append((char) b);
 				array.append((char) (b >> 8));
 				break;
 			case 4:
-				b = m_core->rawRead32(m_core, (y + m_top) * 16 + x + m_base, m_currentBank);
+				b = snapshotRead32((y + m_top) * 16 + x + m_base);
 				array.append((char) b);
 				array.append((char) (b >> 8));
 				array.append((char) (b >> 16));
@@ -620,6 +628,7 @@ void MemoryModel::keyPressEvent(QKeyEvent* event) {
 		}
 		m_bufferedNybbles = 0;
 		m_buffer = 0;
+		m_snapshotStale = true;
 		m_selection.first += m_align;
 		if (m_selection.second <= m_selection.first) {
 			m_selection.second = m_selection.first + m_align;
@@ -629,6 +638,93 @@ void MemoryModel::keyPressEvent(QKeyEvent* event) {
 	viewport()->update();
 }
 
+void MemoryModel::refresh() {
+	QByteArray snapshot;
+	uint32_t start;
+	readVisible(snapshot, start);
+	if (m_snapshotStale || start != m_snapshotStart || snapshot.size() != m_snapshot.size()) {
+		m_snapshot = snapshot;
+		m_snapshotStart = start;
+		m_snapshotStale = false;
+		viewport()->update();
+		return;
+	}
+
+	// Only repaint the rows that changed since the last refresh
+	for (int offset = 0; offset < snapshot.size(); offset += 16) {
+		int length = std::min(16, snapshot.size() - offset);
+		if (!memcmp(&snapshot.constData()[offset], &m_snapshot.constData()[offset], length)) {
+			continue;
+		}
+		int yp = m_cellHeight * (offset / 16) + m_margins.top();
+		viewport()->update(QRect(0, yp, viewport()->size().width(), m_cellHeight));
+	}
+	m_snapshot = snapshot;
+}
+
+void MemoryModel::readVisible(QByteArray& out, uint32_t& start) const {
+	int height = (viewport()->size().height() - m_cellHeight) / m_cellHeight;
+	start = m_top * 16 + m_base;
+	uint32_t end = start + std::max(height, 0) * 16;
+	if (end > m_base + m_size) {
+		end = m_base + m_size;
+	}
+	if (end <= start) {
+		out.clear();
+		return;
+	}
+	out.resize(end - start);
+	char* data = out.data();
+	// Rows start word-aligned, so the bulk of this can be read a word at a time
+	uint32_t address = start;
+	for (; address + 4 <= end; address += 4) {
+		uint32_t word = m_core->rawRead32(m_core, address, m_currentBank);
+		STORE_32LE(word, address - start, data);
+	}
+	for (; address < end; ++address) {
+		data[address - start] = m_core->rawRead8(m_core, address, m_currentBank);
+	}
+}
+
+void MemoryModel::ensureSnapshot() {
+	int height = (viewport()->size().height() - m_cellHeight) / m_cellHeight;
+	uint32_t start = m_top * 16 + m_base;
+	uint32_t end = start + std::max(height, 0) * 16;
+	if (end > m_base + m_size) {
+		end = m_base + m_size;
+	}
+	if (!m_snapshotStale && start == m_snapshotStart && (end <= start || end - start == (uint32_t) m_snapshot.size())) {
+		return;
+	}
+	readVisible(m_snapshot, m_snapshotStart);
+	m_snapshotStale = false;
+}
+
+uint8_t MemoryModel::snapshotRead8(uint32_t address) const {
+	if (address < m_snapshotStart || address - m_snapshotStart >= (uint32_t) m_snapshot.size()) {
+		return m_core->rawRead8(m_core, address, m_currentBank);
+	}
+	return m_snapshot.constData()[address - m_snapshotStart];
+}
+
+uint16_t MemoryModel::snapshotRead16(uint32_t address) const {
+	if (address < m_snapshotStart || address - m_snapshotStart + 2 > (uint32_t) m_snapshot.size()) {
+		return m_core->rawRead16(m_core, address, m_currentBank);
+	}
+	uint16_t value;
+	LOAD_16LE(value, address - m_snapshotStart, m_snapshot.constData());
+	return value;
+}
+
+uint32_t MemoryModel::snapshotRead32(uint32_t address) const {
+	if (address < m_snapshotStart || address - m_snapshotStart + 4 > (uint32_t) m_snapshot.size()) {
+		return m_core->rawRead32(m_core, address, m_currentBank);
+	}
+	uint32_t value;
+	LOAD_32LE(value, address - m_snapshotStart, m_snapshot.constData());
+	return value;
+}
+
 void MemoryModel::boundsCheck() {
 	if (m_top < 0) {
 		m_top = 0;
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <QAbstractScrollArea>
+#include <QByteArray>
 #include <QFont>
 #include <QSize>
 #include <QStaticText>
@@ -40,6 +41,8 @@ public:
 	QString decodeText(const QByteArray&);
 
 public slots:
+	void refresh();
+
 	void jumpToAddress(const QString& hex);
 	void jumpToAddress(uint32_t);
 
@@ -65,6 +68,12 @@ protected:
 private:
 	void boundsCheck();
 
+	void readVisible(QByteArray& out, uint32_t& start) const;
+	void ensureSnapshot();
+	uint8_t snapshotRead8(uint32_t address) const;
+	uint16_t snapshotRead16(uint32_t address) const;
+	uint32_t snapshotRead32(uint32_t address) const;
+
 	bool isInSelection(uint32_t address);
 	bool isEditing(uint32_t address);
 	void drawEditingText(QPainter& painter, const QPointF& origin);
@@ -95,6 +104,11 @@ private:
 	uint32_t m_buffer;
 	int m_bufferedNybbles;
 	int m_currentBank;
+
+	// Visible rows as of the last refresh, so painting doesn't go back to the core for every cell
+	QByteArray m_snapshot;
+	uint32_t m_snapshotStart = 0;
+	bool m_snapshotStale = true;
 };
 
 }
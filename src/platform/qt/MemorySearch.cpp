@@ -20,6 +20,7 @@ MemorySearch::MemorySearch(std::shared_ptr<CoreController> controller, QWidget*
 	m_ui.setupUi(this);
 
 	mCoreMemorySearchResultsInit(&m_results, 0);
+	mCoreMemorySearchSnapshotInit(&m_snapshot);
 	connect(m_ui.search, &QPushButton::clicked, this, &MemorySearch::search);
 	connect(m_ui.value, &QLineEdit::returnPressed, this, &MemorySearch::search); 
 	connect(m_ui.searchWithin, &QPushButton::clicked, this, &MemorySearch::searchWithin);
@@ -33,6 +34,7 @@ MemorySearch::MemorySearch(std::shared_ptr<CoreController> controller, QWidget*
 
 MemorySearch::~MemorySearch() {
 	mCoreMemorySearchResultsDeinit(&m_results);
+	mCoreMemorySearchSnapshotDeinit(&m_snapshot);
 }
 
 bool MemorySearch::createParams(mCoreMemorySearchParams* params) {
@@ -136,6 +138,7 @@ bool MemorySearch::createParams(mCoreMemorySearchParams* params) {
 
 void MemorySearch::search() {
 	mCoreMemorySearchResultsClear(&m_results);
+	mCoreMemorySearchSnapshotClear(&m_snapshot);
 
 	mCoreMemorySearchParams params;
 
@@ -143,7 +146,13 @@ void MemorySearch::search() {
 	mCore* core = m_controller->thread()->core;
 
 	if (createParams(&params)) {
-		mCoreMemorySearch(core, &params, &m_results, LIMIT);
+		if (params.type == mCORE_MEMORY_SEARCH_INT && params.op == mCORE_MEMORY_SEARCH_ANY) {
+			// Unknown values match everywhere, far more than can be listed, so keep them all compactly
+			mCoreMemorySearchSnapshotTake(core, &params, &m_snapshot);
+			updateFromSnapshot();
+		} else {
+			mCoreMemorySearch(core, &params, &m_results, LIMIT);
+		}
 	}
 
 	refresh();
@@ -159,12 +168,23 @@ void MemorySearch::searchWithin() {
 		if (m_ui.opUnknown->isChecked()) {
 			params.op = mCORE_MEMORY_SEARCH_DELTA_ANY;
 		}
-		mCoreMemorySearchRepeat(core, &params, &m_results);
+		if (m_snapshot.width && params.type == mCORE_MEMORY_SEARCH_INT) {
+			mCoreMemorySearchSnapshotRepeat(core, &params, &m_snapshot);
+			updateFromSnapshot();
+		} else {
+			mCoreMemorySearchSnapshotClear(&m_snapshot);
+			mCoreMemorySearchRepeat(core, &params, &m_results);
+		}
 	}
 
 	refresh();
 }
 
+void MemorySearch::updateFromSnapshot() {
+	mCoreMemorySearchResultsClear(&m_results);
+	mCoreMemorySearchSnapshotResults(&m_snapshot, &m_results, LIMIT);
+}
+
 void MemorySearch::refresh() {
 	CoreController::Interrupter interrupter(m_controller);
 	mCore* core = m_controller->thread()->core;
@@ -34,12 +34,14 @@ private slots:
 
 private:
 	bool createParams(mCoreMemorySearchParams*);
+	void updateFromSnapshot();
 
 	Ui::MemorySearch m_ui;
 
 	std::shared_ptr<CoreController> m_controller;
 
 	mCoreMemorySearchResults m_results;
+	mCoreMemorySearchSnapshot m_snapshot;
 	QByteArray m_string;
 };
 
@@ -49,7 +49,16 @@ MemoryView::MemoryView(std::shared_ptr<CoreController> controller, QWidget* pare
 
 	connect(controller.get(), &CoreController::stopping, this, &QWidget::close);
 
-	connect(controller.get(), &CoreController::frameAvailable, this, &MemoryView::update);
+	// Frames can come in much faster than they're shown, e.g. while fast forwarding
+	m_updateTimer.setSingleShot(true);
+	m_updateTimer.setInterval(1000 / 60);
+	connect(&m_updateTimer, &QTimer::timeout, this, &MemoryView::update);
+	connect(controller.get(), &CoreController::frameAvailable, this, [this]() {
+		if (!m_updateTimer.isActive()) {
+			m_updateTimer.start();
+		}
+	});
+	connect(controller.get(), &CoreController::stopping, &m_updateTimer, &QTimer::stop);
 	connect(controller.get(), &CoreController::paused, this, &MemoryView::update);
 	connect(controller.get(), &CoreController::stateLoaded, this, &MemoryView::update);
 	connect(controller.get(), &CoreController::rewound, this, &MemoryView::update);
@@ -86,7 +95,7 @@ void MemoryView::setSegment(int segment) {
 }
 
 void MemoryView::update() {
-	m_ui.hexfield->viewport()->update();
+	m_ui.hexfield->refresh();
 	updateStatus();
 }
 
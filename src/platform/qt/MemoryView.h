@@ -9,6 +9,8 @@
 
 #include "ui_MemoryView.h"
 
+#include <QTimer>
+
 namespace QGBA {
 
 class CoreController;
@@ -36,6 +38,7 @@ private:
 	std::shared_ptr<CoreController> m_controller;
 	QPair<uint32_t, uint32_t> m_region;
 	QPair<uint32_t, uint32_t> m_selection;
+	QTimer m_updateTimer;
 };
 
 }
@@ -7,6 +7,8 @@
 
 #include "CoreController.h"
 
+#include <mgba-util/threading.h>
+
 #ifdef M_CORE_GBA
 #include <mgba/internal/gba/gba.h>
 #endif
@@ -219,6 +221,7 @@ bool MultiplayerController::attachGame(CoreController* controller) {
 		GBASIOLockstepNodeCreate(node);
 		GBASIOLockstepAttachNode(&m_gbaLockstep, node);
 		m_players.append({controller, node});
+		updateWaitSpin();
 
 		GBASIOSetDriver(&gba->sio, &node->d, SIO_MULTI);
 
@@ -234,6 +237,7 @@ bool MultiplayerController::attachGame(CoreController* controller) {
 		GBSIOLockstepNodeCreate(node);
 		GBSIOLockstepAttachNode(&m_gbLockstep, node);
 		m_players.append({controller, node});
+		updateWaitSpin();
 
 		GBSIOSetDriver(&gb->sio, &node->d);
 
@@ -296,9 +300,21 @@ void MultiplayerController::detachGame(CoreController* controller) {
 			break;
 		}
 	}
+	thread->spinOnWait = false;
+	updateWaitSpin();
 	emit gameDetached();
 }
 
+void MultiplayerController::updateWaitSpin() {
+	// Linked cores hand off to each other at every transfer. Polling through those short waits
+	// saves a sleep and wakeup each time, but only pays off while no player has to share a host
+	// core with another one or with the UI
+	bool spin = m_players.count() > 1 && ThreadCoreCount() > m_players.count();
+	for (Player& player : m_players) {
+		player.controller->thread()->spinOnWait = spin;
+	}
+}
+
 int MultiplayerController::playerId(CoreController* controller) {
 	for (int i = 0; i < m_players.count(); ++i) {
 		if (m_players[i].controller == controller) {
@@ -44,6 +44,8 @@ signals:
 	void gameDetached();
 
 private:
+	void updateWaitSpin();
+
 	struct Player {
 #ifdef M_CORE_GB
 		Player(CoreController* controller, GBSIOLockstepNode* node);
@@ -98,7 +98,11 @@ void ObjView::translateIndex(int index) {
 void ObjView::updateTilesGBA(bool force) {
 	m_ui.objId->setMaximum(127);
 	const GBA* gba = static_cast<const GBA*>(m_controller->thread()->core->board);
-	const GBAObj* obj = &gba->video.oam.obj[m_objId];
+	GBAObj objCopy;
+	if (!m_controller->readSnapshot("oam", m_objId * sizeof(objCopy), &objCopy, sizeof(objCopy))) {
+		objCopy = gba->video.oam.obj[m_objId];
+	}
+	const GBAObj* obj = &objCopy;
 
 	updateObjList(128);
 
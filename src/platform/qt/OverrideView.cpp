@@ -189,6 +189,7 @@ void OverrideView::updateOverrides() {
 		std::unique_ptr<GBOverride> gb(new GBOverride);
 		gb->override.mbc = s_mbcList[m_ui.mbc->currentIndex()];
 		gb->override.model = s_gbModelList[m_ui.gbModel->currentIndex()];
+		gb->override.idleLoop = GB_IDLE_LOOP_NONE;
 		bool hasColor = false;
 		for (int i = 0; i < 12; ++i) {
 			gb->override.gbColors[i] = m_gbColors[i];
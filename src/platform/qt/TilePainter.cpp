@@ -56,6 +56,15 @@ void TilePainter::setTile(int index, const color_t* data) {
 	update(r);
 }
 
+QPair<int, int> TilePainter::visibleTiles() const {
+	int w = width() / m_size;
+	QRect visible = visibleRegion().boundingRect();
+	if (!w || visible.isEmpty()) {
+		return qMakePair(0, 0);
+	}
+	return qMakePair(visible.top() / m_size * w, (visible.bottom() / m_size + 1) * w);
+}
+
 void TilePainter::setTileCount(int tiles) {
 	m_tileCount = tiles;
 	if (sizePolicy().horizontalPolicy() != QSizePolicy::Fixed) {
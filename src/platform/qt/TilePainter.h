@@ -6,6 +6,7 @@
 #pragma once
 
 #include <QColor>
+#include <QPair>
 #include <QWidget>
 #include <QVector>
 
@@ -20,6 +21,7 @@ public:
 	TilePainter(QWidget* parent = nullptr);
 
 	QPixmap backing() const { return m_backing; }
+	QPair<int, int> visibleTiles() const;
 
 public slots:
 	void setTile(int index, const color_t*);
@@ -11,6 +11,7 @@
 #include <QAction>
 #include <QClipboard>
 #include <QFontDatabase>
+#include <QScrollBar>
 #include <QTimer>
 
 #ifdef M_CORE_GB
@@ -31,6 +32,9 @@ TileView::TileView(std::shared_ptr<CoreController> controller, QWidget* parent)
 		updateTiles(true);
 	});
 	connect(m_ui.paletteId, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &TileView::updatePalette);
+	connect(m_ui.scrollArea->verticalScrollBar(), &QAbstractSlider::valueChanged, this, [this]() {
+		updateTiles(false);
+	});
 
 	switch (m_controller->platform()) {
 #ifdef M_CORE_GBA
@@ -107,10 +111,15 @@ TileView::TileView(std::shared_ptr<CoreController> controller, QWidget* parent)
 
 #ifdef M_CORE_GBA
 void TileView::updateTilesGBA(bool force) {
+	// Tiles scrolled out of view are left alone until they're visible again, unless everything is being redrawn
+	QPair<int, int> visible = m_ui.tiles->visibleTiles();
 	if (m_ui.palette256->isChecked()) {
 		m_ui.tiles->setTileCount(1536);
 		mTileCache* cache = mTileCacheSetGetPointer(&m_cacheSet->tiles, 1);
 		for (int i = 0; i < 1024; ++i) {
+			if (!force && (i < visible.first || i >= visible.second)) {
+				continue;
+			}
 			const color_t* data = mTileCacheGetTileIfDirty(cache, &m_tileStatus[16 * i], i, 0);
 			if (data) {
 				m_ui.tiles->setTile(i, data);
@@ -120,6 +129,9 @@ void TileView::updateTilesGBA(bool force) {
 		}
 		cache = mTileCacheSetGetPointer(&m_cacheSet->tiles, 3);
 		for (int i = 1024; i < 1536; ++i) {
+			if (!force && (i < visible.first || i >= visible.second)) {
+				continue;
+			}
 			const color_t* data = mTileCacheGetTileIfDirty(cache, &m_tileStatus[16 * i], i - 1024, 0);
 			if (data) {
 				m_ui.tiles->setTile(i, data);
@@ -131,6 +143,9 @@ void TileView::updateTilesGBA(bool force) {
 		mTileCache* cache = mTileCacheSetGetPointer(&m_cacheSet->tiles, 0);
 		m_ui.tiles->setTileCount(3072);
 		for (int i = 0; i < 2048; ++i) {
+			if (!force && (i < visible.first || i >= visible.second)) {
+				continue;
+			}
 			const color_t* data = mTileCacheGetTileIfDirty(cache, &m_tileStatus[16 * i], i, m_paletteId);
 			if (data) {
 				m_ui.tiles->setTile(i, data);
@@ -140,6 +155,9 @@ void TileView::updateTilesGBA(bool force) {
 		}
 		cache = mTileCacheSetGetPointer(&m_cacheSet->tiles, 2);
 		for (int i = 2048; i < 3072; ++i) {
+			if (!force && (i < visible.first || i >= visible.second)) {
+				continue;
+			}
 			const color_t* data = mTileCacheGetTileIfDirty(cache, &m_tileStatus[16 * i], i - 2048, m_paletteId);
 			if (data) {
 				m_ui.tiles->setTile(i, data);
@@ -157,7 +175,11 @@ void TileView::updateTilesGB(bool force) {
 	int count = gb->model >= GB_MODEL_CGB ? 1024 : 512;
 	m_ui.tiles->setTileCount(count);
 	mTileCache* cache = mTileCacheSetGetPointer(&m_cacheSet->tiles, 0);
+	QPair<int, int> visible = m_ui.tiles->visibleTiles();
 	for (int i = 0; i < count; ++i) {
+		if (!force && (i < visible.first || i >= visible.second)) {
+			continue;
+		}
 		const color_t* data = mTileCacheGetTileIfDirty(cache, &m_tileStatus[8 * i], i, m_paletteId);
 		if (data) {
 			m_ui.tiles->setTile(i, data);
@@ -181,7 +203,7 @@ void TileView::exportTiles() {
 		return;
 	}
 	CoreController::Interrupter interrupter(m_controller);
-	updateTiles(false);
+	updateTiles(true);
 	QPixmap pixmap(m_ui.tiles->backing());
 	pixmap.save(filename, "PNG");
 }
@@ -200,7 +222,7 @@ void TileView::exportTile() {
 
 void TileView::copyTiles() {
 	CoreController::Interrupter interrupter(m_controller);
-	updateTiles(false);
+	updateTiles(true);
 	QPixmap pixmap();
 	GBAApp::app()->clipboard()->setPixmap(m_ui.tiles->backing());
 }
@@ -198,13 +198,31 @@ int wmain(int argc, wchar_t** argv) {
 
 int mSDLRun(struct mSDLRenderer* renderer, struct mArguments* args) {
 	struct mCoreThread thread = {
-		.core = renderer->core
+		.core = renderer->core,
+		.audioRing = true
 	};
 	if (!mCoreLoadFile(renderer->core, args->fname)) {
 		return 1;
 	}
 	mCoreAutoloadSave(renderer->core);
 	mCoreAutoloadCheats(renderer->core);
+	int powerSave = 0;
+	mCoreConfigGetIntValue(&renderer->core->config, "powerSave", &powerSave);
+	thread.powerSave = powerSave;
+	int audioRateControl = 0;
+	mCoreConfigGetIntValue(&renderer->core->config, "audioRateControl", &audioRateControl);
+	thread.audioRateControl = audioRateControl;
+	const char* threadAffinity = mCoreConfigGetValue(&renderer->core->config, "threadAffinity");
+	if (threadAffinity && strcmp(threadAffinity, "fastest") == 0) {
+		thread.emulationAffinity = mCORE_THREAD_AFFINITY_FASTEST;
+	} else if (threadAffinity && threadAffinity[0]) {
+		thread.emulationAffinity = mCORE_THREAD_AFFINITY_CORE;
+		thread.emulationCore = strtol(threadAffinity, NULL, 10);
+	}
+	int threadIsolate = 0;
+	mCoreConfigGetIntValue(&renderer->core->config, "threadIsolate", &threadIsolate);
+	thread.isolateEmulationCore = threadIsolate;
+	mCoreConfigGetIntValue(&renderer->core->config, "threadPriority", &thread.emulationPriority);
 #ifdef ENABLE_SCRIPTING
 	struct mScriptBridge* bridge = mScriptBridgeCreate();
 #ifdef ENABLE_PYTHON
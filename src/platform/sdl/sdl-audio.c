@@ -13,6 +13,7 @@
 #include <mgba/core/blip_buf.h>
 
 #define BUFFER_SIZE (GBA_AUDIO_SAMPLES >> 2)
+#define RING_CLOCK_TOLERANCE 0.0001
 
 mLOG_DEFINE_CATEGORY(SDL_AUDIO, "SDL Audio", "platform.sdl.audio");
 
@@ -46,6 +47,7 @@ bool mSDLInitAudio(struct mSDLAudio* context, struct mCoreThread* threadContext)
 		return false;
 	}
 	context->core = 0;
+	context->ringClock = 0;
 
 	if (threadContext) {
 		context->core = threadContext->core;
@@ -91,12 +93,62 @@ void mSDLResumeAudio(struct mSDLAudio* context) {
 #endif
 }
 
+static void _mSDLAudioRingCallback(struct mSDLAudio* audioContext, Uint8* data, int len) {
+	struct mCoreSync* sync = audioContext->sync;
+	double fauxClock = 1;
+	if (sync->fpsTarget > 0) {
+		fauxClock = GBAAudioCalculateRatio(1, sync->fpsTarget, 1);
+	}
+	fauxClock *= mCoreSyncAudioRateRatio(sync);
+	// Rate control moves the ratio a little on every callback; only take the lock once it adds up
+	if (fabs(fauxClock - audioContext->ringClock) > audioContext->ringClock * RING_CLOCK_TOLERANCE) {
+		// Only retuning the rates needs the emulation thread to stay out of the blip buffers
+		int32_t clockRate = audioContext->core->frequency(audioContext->core);
+		mCoreSyncLockAudio(sync);
+		blip_set_rates(sync->audioLeft, clockRate, audioContext->obtainedSpec.freq * fauxClock);
+		blip_set_rates(sync->audioRight, clockRate, audioContext->obtainedSpec.freq * fauxClock);
+		mCoreSyncUnlockAudio(sync);
+		audioContext->ringClock = fauxClock;
+	}
+
+	int channels = audioContext->obtainedSpec.channels;
+	len /= 2 * channels;
+	int16_t* samples = (int16_t*) data;
+	size_t available;
+	if (channels == 2) {
+		available = mCoreSyncReadAudio(sync, samples, len);
+	} else {
+		int16_t stereo[mCORE_SYNC_AUDIO_CHUNK * 2];
+		size_t i;
+		for (available = 0; available < (size_t) len; available += i) {
+			size_t frames = len - available;
+			if (frames > mCORE_SYNC_AUDIO_CHUNK) {
+				frames = mCORE_SYNC_AUDIO_CHUNK;
+			}
+			frames = mCoreSyncReadAudio(sync, stereo, frames);
+			if (!frames) {
+				break;
+			}
+			for (i = 0; i < frames; ++i) {
+				samples[available + i] = stereo[i * 2];
+			}
+		}
+	}
+	if (available < (size_t) len) {
+		memset(&samples[channels * available], 0, (len - available) * channels * sizeof(*samples));
+	}
+}
+
 static void _mSDLAudioCallback(void* context, Uint8* data, int len) {
 	struct mSDLAudio* audioContext = context;
 	if (!context || !audioContext->core) {
 		memset(data, 0, len);
 		return;
 	}
+	if (audioContext->sync && audioContext->sync->audioRingOn) {
+		_mSDLAudioRingCallback(audioContext, data, len);
+		return;
+	}
 	blip_t* left = NULL;
 	blip_t* right = NULL;
 	int32_t clockRate = GBA_ARM7TDMI_FREQUENCY;
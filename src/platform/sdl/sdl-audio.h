@@ -38,6 +38,8 @@ struct mSDLAudio {
 
 	struct mCore* core;
 	struct mCoreSync* sync;
+	// Resampling ratio last given to the blip buffers when reading from the sync audio ring
+	double ringClock;
 };
 
 struct mCoreThread;
@@ -259,9 +259,16 @@ static void _setup(struct mGUIRunner* runner) {
 
 	int fakeBool;
 	if (mCoreConfigGetIntValue(&runner->config, "hwaccelVideo", &fakeBool) && fakeBool && runner->core->supportsFeature(runner->core, mCORE_FEATURE_OPENGL)) {
+		// The GL context belongs to this thread, so the renderer can't be moved off of it
+		mCoreConfigSetOverrideIntValue(&runner->config, "threadedVideo", 0);
+		mCoreLoadForeignConfig(runner->core, &runner->config);
 		runner->core->setVideoGLTex(runner->core, tex);
 		usePbo = false;
 	} else {
+		// Software rendering runs on its own thread, which gets the second core to itself
+		mCoreConfigSetOverrideValue(&runner->config, "threadedVideo", NULL);
+		mCoreConfigSetDefaultIntValue(&runner->config, "threadedVideo", 1);
+		mCoreLoadForeignConfig(runner->core, &runner->config);
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, tex);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -0,0 +1,619 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/blip_buf.h>
+#include <mgba/core/serialize.h>
+#include <mgba/core/timing.h>
+#ifdef M_CORE_GBA
+#include <mgba/internal/gba/io.h>
+#include <mgba/internal/gba/memory.h>
+#include <mgba/internal/gba/renderers/video-software.h>
+#endif
+#include <mgba-util/crc32.h>
+#include <mgba-util/patch/fast.h>
+#include <mgba-util/vfs.h>
+
+#ifdef _MSC_VER
+#include <mgba-util/platform/windows/getopt.h>
+#else
+#include <getopt.h>
+#endif
+
+#include <inttypes.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define BENCH_OPTIONS "f:ln:o:s:"
+#define BENCH_USAGE \
+	"usage: %s [-l] [-f FILTER] [-n REPEATS] [-s SCALE] [-o FILE]\n" \
+	"  -l          List the benchmarks and exit\n" \
+	"  -f FILTER   Only run benchmarks whose names contain FILTER; may be given more than once\n" \
+	"  -n REPEATS  Time each benchmark REPEATS times (default 7)\n" \
+	"  -s SCALE    Multiply every iteration count by SCALE\n" \
+	"  -o FILE     Write the JSON results to FILE instead of standard output\n"
+
+#define BENCH_MAX_FILTERS 16
+
+struct Bench {
+	const char* name;
+	// Fixed, so the numbers stay comparable between runs and machines
+	unsigned iterations;
+	// Bytes processed per iteration, for a throughput figure; 0 where that doesn't mean anything
+	size_t bytes;
+	void* (*setup)(void);
+	void (*run)(void* state, unsigned iterations);
+	void (*teardown)(void* state);
+};
+
+// Results get folded in here so the compiler can't throw the work away
+static volatile uint32_t _sink;
+
+static uint32_t _random(uint32_t* seed) {
+	// xorshift32, so every run sees the same data
+	uint32_t x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return x;
+}
+
+static void _fillRandom(void* buffer, size_t size, uint32_t seed) {
+	uint8_t* bytes = buffer;
+	size_t i;
+	for (i = 0; i < size; ++i) {
+		bytes[i] = _random(&seed);
+	}
+}
+
+static uint64_t _clock(void) {
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	if (!clock_gettime(CLOCK_MONOTONIC, &ts)) {
+		return 1000000000LL * ts.tv_sec + ts.tv_nsec;
+	}
+#endif
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return 1000000000LL * tv.tv_sec + 1000LL * tv.tv_usec;
+}
+
+#define CRC32_SIZE 0x10000
+
+static void* _crc32Setup(void) {
+	void* buffer = malloc(CRC32_SIZE);
+	_fillRandom(buffer, CRC32_SIZE, 1);
+	return buffer;
+}
+
+static void _crc32Run(void* state, unsigned iterations) {
+	uint32_t crc = 0;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		crc ^= doCrc32(state, CRC32_SIZE);
+	}
+	_sink ^= crc;
+}
+
+#define PATCH_SIZE 0x40000
+
+struct PatchBench {
+	struct PatchFast patch;
+	uint8_t* in;
+	uint8_t* out;
+};
+
+static void* _patchSetup(void) {
+	struct PatchBench* bench = malloc(sizeof(*bench));
+	initPatchFast(&bench->patch);
+	bench->in = malloc(PATCH_SIZE);
+	bench->out = malloc(PATCH_SIZE);
+	_fillRandom(bench->in, PATCH_SIZE, 2);
+	memcpy(bench->out, bench->in, PATCH_SIZE);
+	// Sparse changes in small runs, like a frame's worth of work RAM writes
+	uint32_t seed = 3;
+	size_t i;
+	for (i = 0; i < PATCH_SIZE / 256; ++i) {
+		size_t offset = _random(&seed) % (PATCH_SIZE - 8);
+		bench->out[offset] ^= 0xFF;
+		bench->out[offset + 1 + _random(&seed) % 7] ^= 0x5A;
+	}
+	return bench;
+}
+
+static void _patchRun(void* state, unsigned iterations) {
+	struct PatchBench* bench = state;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		diffPatchFast(&bench->patch, bench->in, bench->out, PATCH_SIZE);
+	}
+	_sink ^= PatchFastExtentsSize(&bench->patch.extents);
+}
+
+static void _patchTeardown(void* state) {
+	struct PatchBench* bench = state;
+	deinitPatchFast(&bench->patch);
+	free(bench->in);
+	free(bench->out);
+	free(bench);
+}
+
+#define STATE_SIZE 0x60000
+
+struct StateBench {
+	struct VFile* raw;
+	struct VFile* compressed;
+	int flags;
+};
+
+// Mostly zeroes with scattered runs of data, roughly what a GBA state with a game running looks like
+static struct StateBench* _stateSetup(int compression) {
+	struct StateBench* bench = malloc(sizeof(*bench));
+	bench->raw = VFileMemChunk(NULL, STATE_SIZE);
+	bench->compressed = VFileMemChunk(NULL, 0);
+	bench->flags = SAVESTATE_COMPRESS(compression, 0);
+	uint8_t* state = bench->raw->map(bench->raw, STATE_SIZE, MAP_WRITE);
+	uint32_t seed = 8;
+	size_t i;
+	for (i = 0; i < STATE_SIZE / 64; ++i) {
+		size_t offset = _random(&seed) % (STATE_SIZE - 32);
+		_fillRandom(&state[offset], 1 + _random(&seed) % 32, _random(&seed));
+	}
+	bench->raw->unmap(bench->raw, state, STATE_SIZE);
+	mStateCompress(bench->compressed, bench->raw, bench->flags);
+	return bench;
+}
+
+static void* _stateRLESetup(void) {
+	return _stateSetup(mSTATE_COMPRESSION_RLE);
+}
+
+#ifdef USE_ZLIB
+static void* _stateZlibSetup(void) {
+	return _stateSetup(mSTATE_COMPRESSION_ZLIB);
+}
+#endif
+
+static void _stateCompressRun(void* state, unsigned iterations) {
+	struct StateBench* bench = state;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		mStateCompress(bench->compressed, bench->raw, bench->flags);
+	}
+	_sink ^= bench->compressed->size(bench->compressed);
+}
+
+static void _stateDecompressRun(void* state, unsigned iterations) {
+	struct StateBench* bench = state;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		struct VFile* vf = mStateDecompress(bench->compressed);
+		_sink ^= vf->size(vf);
+		vf->close(vf);
+	}
+}
+
+static void _stateTeardown(void* state) {
+	struct StateBench* bench = state;
+	bench->raw->close(bench->raw);
+	bench->compressed->close(bench->compressed);
+	free(bench);
+}
+
+// One Game Boy frame of audio with a busy channel
+#define BLIP_CLOCK_RATE 0x400000
+#define BLIP_FRAME_CLOCKS 70224
+#define BLIP_DELTAS 1024
+
+static void* _blipSetup(void) {
+	struct blip_t* blip = blip_new(0x4000);
+	blip_set_rates(blip, BLIP_CLOCK_RATE, 48000);
+	return blip;
+}
+
+static void _blipRun(void* state, unsigned iterations) {
+	struct blip_t* blip = state;
+	int16_t samples[0x800];
+	uint32_t seed = 4;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		unsigned j;
+		for (j = 0; j < BLIP_DELTAS; ++j) {
+			blip_add_delta(blip, j * (BLIP_FRAME_CLOCKS / BLIP_DELTAS), (int) (_random(&seed) & 0x3FF) - 0x200);
+		}
+		blip_end_frame(blip, BLIP_FRAME_CLOCKS);
+		while (blip_samples_avail(blip) > 0) {
+			blip_read_samples(blip, samples, sizeof(samples) / sizeof(*samples), false);
+		}
+	}
+	_sink ^= samples[0];
+}
+
+static void _blipTeardown(void* state) {
+	blip_delete(state);
+}
+
+#define TIMING_EVENTS 16
+
+struct TimingBench {
+	struct mTiming timing;
+	struct mTimingEvent events[TIMING_EVENTS];
+	int32_t relativeCycles;
+	int32_t nextEvent;
+};
+
+static void _timingCallback(struct mTiming* timing, void* context, uint32_t cyclesLate) {
+	UNUSED(timing);
+	UNUSED(context);
+	UNUSED(cyclesLate);
+}
+
+static void* _timingSetup(void) {
+	struct TimingBench* bench = calloc(1, sizeof(*bench));
+	mTimingInit(&bench->timing, &bench->relativeCycles, &bench->nextEvent);
+	size_t i;
+	for (i = 0; i < TIMING_EVENTS; ++i) {
+		bench->events[i].context = bench;
+		bench->events[i].callback = _timingCallback;
+		bench->events[i].name = "Bench";
+		bench->events[i].priority = i & 3;
+	}
+	return bench;
+}
+
+// Each iteration moves every event, about as many as are live in a running GBA
+static void _timingRun(void* state, unsigned iterations) {
+	struct TimingBench* bench = state;
+	uint32_t seed = 5;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		size_t j;
+		for (j = 0; j < TIMING_EVENTS; ++j) {
+			mTimingSchedule(&bench->timing, &bench->events[j], _random(&seed) & 0xFFFF);
+		}
+	}
+	_sink ^= mTimingNextEvent(&bench->timing);
+}
+
+static void _timingTeardown(void* state) {
+	struct TimingBench* bench = state;
+	mTimingDeinit(&bench->timing);
+	free(bench);
+}
+
+#ifdef M_CORE_GBA
+struct GBARendererBench {
+	struct GBAVideoSoftwareRenderer renderer;
+	uint16_t* vram;
+	uint16_t palette[SIZE_PALETTE_RAM / 2];
+	union GBAOAM oam;
+	color_t* output;
+	// Sprite-heavy games rewrite OAM every frame, which also means binning the sprites again
+	bool touchOAM;
+};
+
+static struct GBARendererBench* _gbaRendererCreate(bool decodeTiles) {
+	struct GBARendererBench* bench = calloc(1, sizeof(*bench));
+	bench->vram = malloc(SIZE_VRAM);
+	bench->output = calloc(256 * GBA_VIDEO_VERTICAL_PIXELS, sizeof(color_t));
+	_fillRandom(bench->vram, SIZE_VRAM, 6);
+	_fillRandom(bench->palette, sizeof(bench->palette), 7);
+
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	GBAVideoSoftwareRendererCreate(&bench->renderer);
+	bench->renderer.outputBuffer = bench->output;
+	bench->renderer.outputBufferStride = 256;
+	bench->renderer.decodeTiles = decodeTiles;
+	renderer->vram = bench->vram;
+	renderer->palette = bench->palette;
+	renderer->oam = &bench->oam;
+	renderer->cache = NULL;
+	renderer->init(renderer);
+
+	uint32_t address;
+	for (address = 0; address < SIZE_VRAM; address += 2) {
+		renderer->writeVRAM(renderer, address);
+	}
+	for (address = 0; address < SIZE_PALETTE_RAM; address += 2) {
+		renderer->writePalette(renderer, address, bench->palette[address >> 1]);
+	}
+	return bench;
+}
+
+static void _gbaRendererDrawFrames(void* state, unsigned iterations) {
+	struct GBARendererBench* bench = state;
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		// Unchanged lines are skipped, so touch memory the way a game would each frame to get them all drawn
+		if (bench->touchOAM) {
+			renderer->writeOAM(renderer, 0);
+		} else {
+			renderer->writeVRAM(renderer, 0);
+		}
+		int y;
+		for (y = 0; y < GBA_VIDEO_VERTICAL_PIXELS; ++y) {
+			renderer->drawScanline(renderer, y);
+		}
+		renderer->finishFrame(renderer);
+	}
+	_sink ^= bench->output[256 * 80 + 120];
+}
+
+static void _gbaRendererTeardown(void* state) {
+	struct GBARendererBench* bench = state;
+	bench->renderer.d.deinit(&bench->renderer.d);
+	free(bench->vram);
+	free(bench->output);
+	free(bench);
+}
+
+static void _gbaSetupMode0(struct GBARendererBench* bench) {
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	uint32_t seed = 8;
+	// Four 4bpp text layers sharing the first 32 KiB of tiles, with their maps at 0xC000 onwards
+	int bg;
+	for (bg = 0; bg < 4; ++bg) {
+		renderer->writeVideoRegister(renderer, REG_BG0CNT + bg * 2, bg | ((24 + bg) << 8));
+		renderer->writeVideoRegister(renderer, REG_BG0HOFS + bg * 4, _random(&seed) & 0x1FF);
+		renderer->writeVideoRegister(renderer, REG_BG0VOFS + bg * 4, _random(&seed) & 0x1FF);
+	}
+	renderer->writeVideoRegister(renderer, REG_DISPCNT, 0x0F00);
+}
+
+static void* _gbaMode0Setup(void) {
+	struct GBARendererBench* bench = _gbaRendererCreate(false);
+	_gbaSetupMode0(bench);
+	return bench;
+}
+
+static void* _gbaMode0TileCacheSetup(void) {
+	struct GBARendererBench* bench = _gbaRendererCreate(true);
+	_gbaSetupMode0(bench);
+	return bench;
+}
+
+static void* _gbaMode2Setup(void) {
+	struct GBARendererBench* bench = _gbaRendererCreate(false);
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	// Two rotated, scaled 512x512 layers that wrap around
+	renderer->writeVideoRegister(renderer, REG_BG2CNT, 0x2000 | (16 << 8) | 0x8000);
+	renderer->writeVideoRegister(renderer, REG_BG3CNT, 0x2001 | (24 << 8) | 0x8000);
+	renderer->writeVideoRegister(renderer, REG_BG2PA, 0x00F6);
+	renderer->writeVideoRegister(renderer, REG_BG2PB, 0x0042);
+	renderer->writeVideoRegister(renderer, REG_BG2PC, 0xFFBE);
+	renderer->writeVideoRegister(renderer, REG_BG2PD, 0x00F6);
+	renderer->writeVideoRegister(renderer, REG_BG3PA, 0x0180);
+	renderer->writeVideoRegister(renderer, REG_BG3PB, 0xFF80);
+	renderer->writeVideoRegister(renderer, REG_BG3PC, 0x0080);
+	renderer->writeVideoRegister(renderer, REG_BG3PD, 0x0180);
+	renderer->writeVideoRegister(renderer, REG_DISPCNT, 0x0C02);
+	return bench;
+}
+
+static void* _gbaSpritesSetup(void) {
+	struct GBARendererBench* bench = _gbaRendererCreate(false);
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	uint32_t seed = 9;
+	int i;
+	for (i = 0; i < 128; ++i) {
+		bool affine = !(i & 3);
+		uint16_t a = (_random(&seed) % GBA_VIDEO_VERTICAL_PIXELS) | ((_random(&seed) % 3) << 14);
+		uint16_t b = (_random(&seed) % GBA_VIDEO_HORIZONTAL_PIXELS) | ((_random(&seed) & 3) << 14);
+		if (i & 1) {
+			a |= 0x2000;
+		}
+		if (affine) {
+			a |= 0x0100;
+			b |= (i >> 2) << 9;
+		} else {
+			b |= (_random(&seed) & 3) << 12;
+		}
+		bench->oam.obj[i].a = a;
+		bench->oam.obj[i].b = b;
+		bench->oam.obj[i].c = _random(&seed) & 0xFFFF;
+	}
+	for (i = 0; i < 32; ++i) {
+		int16_t scale = 0x80 + (_random(&seed) & 0x7F);
+		bench->oam.mat[i].a = scale;
+		bench->oam.mat[i].b = (_random(&seed) & 0x7F) - 0x40;
+		bench->oam.mat[i].c = (_random(&seed) & 0x7F) - 0x40;
+		bench->oam.mat[i].d = scale;
+	}
+	for (i = 0; i < 512; ++i) {
+		renderer->writeOAM(renderer, i);
+	}
+	// Objects only, with 1D tile mapping
+	renderer->writeVideoRegister(renderer, REG_DISPCNT, 0x1040);
+	bench->touchOAM = true;
+	return bench;
+}
+
+static void* _gbaBackdropSetup(void) {
+	struct GBARendererBench* bench = _gbaRendererCreate(false);
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	renderer->writeVideoRegister(renderer, REG_BLDCNT, 0x00BF);
+	renderer->writeVideoRegister(renderer, REG_DISPCNT, 0x0000);
+	return bench;
+}
+
+// A line with nothing on it, for taking out of gba_palette_brighten
+static void _gbaBackdropRun(void* state, unsigned iterations) {
+	struct GBARendererBench* bench = state;
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		renderer->writeVRAM(renderer, 0);
+		renderer->drawScanline(renderer, i % GBA_VIDEO_VERTICAL_PIXELS);
+		if (i % GBA_VIDEO_VERTICAL_PIXELS == GBA_VIDEO_VERTICAL_PIXELS - 1) {
+			renderer->finishFrame(renderer);
+		}
+	}
+	_sink ^= bench->output[0];
+}
+
+// Fading in steps BLDY every line, and the next line has to rebuild all 512 brightened colors first
+static void _gbaPaletteRun(void* state, unsigned iterations) {
+	struct GBARendererBench* bench = state;
+	struct GBAVideoRenderer* renderer = &bench->renderer.d;
+	unsigned i;
+	for (i = 0; i < iterations; ++i) {
+		renderer->writeVideoRegister(renderer, REG_BLDY, 1 + (i & 0xF));
+		renderer->writeVRAM(renderer, 0);
+		renderer->drawScanline(renderer, i % GBA_VIDEO_VERTICAL_PIXELS);
+		if (i % GBA_VIDEO_VERTICAL_PIXELS == GBA_VIDEO_VERTICAL_PIXELS - 1) {
+			renderer->finishFrame(renderer);
+		}
+	}
+	_sink ^= bench->output[0];
+}
+#endif
+
+static const struct Bench _benches[] = {
+	{ "crc32", 2000, CRC32_SIZE, _crc32Setup, _crc32Run, free },
+	{ "diff_patch_fast", 500, PATCH_SIZE, _patchSetup, _patchRun, _patchTeardown },
+	{ "blip_buf_frame", 5000, 0, _blipSetup, _blipRun, _blipTeardown },
+	{ "timing_schedule", 200000, 0, _timingSetup, _timingRun, _timingTeardown },
+	{ "state_compress_rle", 500, STATE_SIZE, _stateRLESetup, _stateCompressRun, _stateTeardown },
+	{ "state_decompress_rle", 500, STATE_SIZE, _stateRLESetup, _stateDecompressRun, _stateTeardown },
+#ifdef USE_ZLIB
+	{ "state_compress_zlib", 50, STATE_SIZE, _stateZlibSetup, _stateCompressRun, _stateTeardown },
+	{ "state_decompress_zlib", 200, STATE_SIZE, _stateZlibSetup, _stateDecompressRun, _stateTeardown },
+#endif
+#ifdef M_CORE_GBA
+	{ "gba_mode0_frame", 300, 0, _gbaMode0Setup, _gbaRendererDrawFrames, _gbaRendererTeardown },
+	{ "gba_mode0_tile_cache_frame", 300, 0, _gbaMode0TileCacheSetup, _gbaRendererDrawFrames, _gbaRendererTeardown },
+	{ "gba_mode2_frame", 300, 0, _gbaMode2Setup, _gbaRendererDrawFrames, _gbaRendererTeardown },
+	{ "gba_sprites_frame", 300, 0, _gbaSpritesSetup, _gbaRendererDrawFrames, _gbaRendererTeardown },
+	{ "gba_backdrop_scanline", 50000, 0, _gbaBackdropSetup, _gbaBackdropRun, _gbaRendererTeardown },
+	{ "gba_palette_brighten", 50000, 0, _gbaBackdropSetup, _gbaPaletteRun, _gbaRendererTeardown },
+#endif
+};
+
+static int _compareTimes(const void* a, const void* b) {
+	uint64_t left = *(const uint64_t*) a;
+	uint64_t right = *(const uint64_t*) b;
+	return (left > right) - (left < right);
+}
+
+static bool _matches(const char* name, const char* const* filters, size_t nFilters) {
+	if (!nFilters) {
+		return true;
+	}
+	size_t i;
+	for (i = 0; i < nFilters; ++i) {
+		if (strstr(name, filters[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void _runBench(const struct Bench* bench, unsigned iterations, unsigned repeats, uint64_t* times) {
+	void* state = bench->setup();
+	// Warm the caches and branch predictors up before anything counts
+	bench->run(state, iterations / 10 + 1);
+	unsigned i;
+	for (i = 0; i < repeats; ++i) {
+		uint64_t start = _clock();
+		bench->run(state, iterations);
+		times[i] = _clock() - start;
+	}
+	bench->teardown(state);
+	qsort(times, repeats, sizeof(*times), _compareTimes);
+}
+
+int main(int argc, char** argv) {
+	const char* filters[BENCH_MAX_FILTERS];
+	size_t nFilters = 0;
+	unsigned repeats = 7;
+	double scale = 1;
+	const char* output = NULL;
+	bool list = false;
+	int ch;
+	while ((ch = getopt(argc, argv, BENCH_OPTIONS)) != -1) {
+		switch (ch) {
+		case 'f':
+			if (nFilters < BENCH_MAX_FILTERS) {
+				filters[nFilters] = optarg;
+				++nFilters;
+			}
+			break;
+		case 'l':
+			list = true;
+			break;
+		case 'n':
+			repeats = strtoul(optarg, NULL, 10);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 's':
+			scale = strtod(optarg, NULL);
+			break;
+		default:
+			fprintf(stderr, BENCH_USAGE, argv[0]);
+			return 1;
+		}
+	}
+	if (optind != argc || !repeats || scale <= 0) {
+		fprintf(stderr, BENCH_USAGE, argv[0]);
+		return 1;
+	}
+
+	size_t nBenches = sizeof(_benches) / sizeof(*_benches);
+	size_t i;
+	if (list) {
+		for (i = 0; i < nBenches; ++i) {
+			printf("%s\n", _benches[i].name);
+		}
+		return 0;
+	}
+
+	FILE* out = stdout;
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			fprintf(stderr, "Could not open %s\n", output);
+			return 1;
+		}
+	}
+
+	uint64_t* times = malloc(sizeof(*times) * repeats);
+	bool first = true;
+	fputs("[\n", out);
+	for (i = 0; i < nBenches; ++i) {
+		const struct Bench* bench = &_benches[i];
+		if (!_matches(bench->name, filters, nFilters)) {
+			continue;
+		}
+		unsigned iterations = bench->iterations * scale;
+		if (!iterations) {
+			iterations = 1;
+		}
+		_runBench(bench, iterations, repeats, times);
+
+		// The minimum is the least disturbed by the rest of the system, so it's the one to compare
+		double perIteration[3] = {
+			(double) times[0] / iterations,
+			(double) times[repeats / 2] / iterations,
+			(double) times[repeats - 1] / iterations,
+		};
+		fprintf(out, "%s{\"name\": \"%s\", \"iterations\": %u, \"repeats\": %u, \"ns_per_iteration\": {\"min\": %.2f, \"median\": %.2f, \"max\": %.2f}",
+		        first ? "" : ",\n", bench->name, iterations, repeats, perIteration[0], perIteration[1], perIteration[2]);
+		if (bench->bytes) {
+			fprintf(out, ", \"mb_per_second\": %.1f", bench->bytes * 1000.0 / perIteration[0]);
+		}
+		fputc('}', out);
+		fflush(out);
+		first = false;
+	}
+	fputs("\n]\n", out);
+	free(times);
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
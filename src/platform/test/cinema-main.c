@@ -0,0 +1,631 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/config.h>
+#include <mgba/core/core.h>
+#include <mgba/core/log.h>
+#include <mgba-util/png-io.h>
+#include <mgba-util/string.h>
+#include <mgba-util/threading.h>
+#include <mgba-util/vector.h>
+#include <mgba-util/vfs.h>
+
+#ifdef _MSC_VER
+#include <mgba-util/platform/windows/getopt.h>
+#else
+#include <getopt.h>
+#endif
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define CINEMA_OPTIONS "b:j:o:q"
+#define CINEMA_USAGE \
+	"usage: %s [-q] [-b BASE] [-j THREADS] [-o FILE] [TEST...]\n" \
+	"  -b BASE     Look for tests under BASE (default cinema)\n" \
+	"  -j THREADS  Run up to THREADS tests at once, each on its own core\n" \
+	"  -o FILE     Write the JSON results, including frame rates, to FILE\n" \
+	"  -q          Only report tests that didn't go as expected\n" \
+	"  TEST        Only run tests named TEST or inside of it, e.g. gba.blend\n"
+
+#define CINEMA_BASELINE "baseline_%04u.png"
+
+#ifdef COLOR_16_BIT
+#ifdef COLOR_5_6_5
+#define CINEMA_COLOR_MASK 0xFFFF
+#else
+#define CINEMA_COLOR_MASK 0x7FFF
+#endif
+#else
+#define CINEMA_COLOR_MASK 0xFFFFFF
+#endif
+
+enum CinemaStatus {
+	CINEMA_PASS,
+	CINEMA_FAIL,
+	CINEMA_XFAIL,
+	CINEMA_XPASS,
+	CINEMA_ERROR
+};
+
+static const char* const _statusNames[] = {
+	[CINEMA_PASS] = "pass",
+	[CINEMA_FAIL] = "fail",
+	[CINEMA_XFAIL] = "xfail",
+	[CINEMA_XPASS] = "xpass",
+	[CINEMA_ERROR] = "error",
+};
+
+// Settings from manifest.yml, which also apply to every test further down the tree
+struct CinemaSettings {
+	int skip;
+	int frames;
+	bool fail;
+	// Alternating keys and values, with later ones taking precedence
+	struct StringList config;
+};
+
+struct CinemaTest {
+	char* name;
+	char* path;
+	char file[PATH_MAX];
+	struct CinemaSettings settings;
+
+	enum CinemaStatus status;
+	const char* error;
+	unsigned frames;
+	unsigned checked;
+	int firstMismatch;
+	bool missingBaseline;
+	unsigned mismatchedPixels;
+	uint64_t duration;
+};
+
+DECLARE_VECTOR(CinemaTestList, struct CinemaTest*);
+DEFINE_VECTOR(CinemaTestList, struct CinemaTest*);
+
+struct CinemaRun {
+	struct CinemaTestList tests;
+	size_t nextTest;
+	bool quiet;
+#ifndef DISABLE_THREADING
+	Mutex mutex;
+#endif
+};
+
+static uint64_t _clock(void) {
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	if (!clock_gettime(CLOCK_MONOTONIC, &ts)) {
+		return 1000000LL * ts.tv_sec + ts.tv_nsec / 1000;
+	}
+#endif
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return 1000000LL * tv.tv_sec + tv.tv_usec;
+}
+
+static void _log(struct mLogger* log, int category, enum mLogLevel level, const char* format, va_list args) {
+	UNUSED(log);
+	UNUSED(category);
+	UNUSED(level);
+	UNUSED(format);
+	UNUSED(args);
+}
+
+static void _settingsCopy(struct CinemaSettings* settings, const struct CinemaSettings* parent) {
+	settings->skip = parent->skip;
+	settings->frames = parent->frames;
+	settings->fail = parent->fail;
+	StringListInit(&settings->config, StringListSize(&parent->config));
+	size_t i;
+	for (i = 0; i < StringListSize(&parent->config); ++i) {
+		*StringListAppend(&settings->config) = strdup(*StringListGetConstPointer(&parent->config, i));
+	}
+}
+
+static void _settingsDeinit(struct CinemaSettings* settings) {
+	size_t i;
+	for (i = 0; i < StringListSize(&settings->config); ++i) {
+		free(*StringListGetPointer(&settings->config, i));
+	}
+	StringListDeinit(&settings->config);
+}
+
+static char* _trim(char* string) {
+	while (isspace((unsigned char) *string)) {
+		++string;
+	}
+	size_t length = strlen(string);
+	while (length && isspace((unsigned char) string[length - 1])) {
+		--length;
+	}
+	string[length] = '\0';
+	return string;
+}
+
+// Only understands what the corpus uses: scalars, plus one level of mapping under config
+static void _readManifest(const char* path, struct CinemaSettings* settings) {
+	char fname[PATH_MAX];
+	snprintf(fname, sizeof(fname), "%s" PATH_SEP "manifest.yml", path);
+	struct VFile* vf = VFileOpen(fname, O_RDONLY);
+	if (!vf) {
+		return;
+	}
+	char line[256];
+	bool inConfig = false;
+	while (vf->readline(vf, line, sizeof(line)) > 0) {
+		bool indented = isspace((unsigned char) line[0]);
+		char* key = _trim(line);
+		char* value = strchr(key, ':');
+		if (!key[0] || key[0] == '#' || !value) {
+			continue;
+		}
+		*value = '\0';
+		key = _trim(key);
+		value = _trim(&value[1]);
+		if (indented) {
+			if (inConfig) {
+				// YAML booleans have to be numbers by the time the core reads them
+				if (strcmp(value, "true") == 0) {
+					value = "1";
+				} else if (strcmp(value, "false") == 0) {
+					value = "0";
+				}
+				*StringListAppend(&settings->config) = strdup(key);
+				*StringListAppend(&settings->config) = strdup(value);
+			}
+			continue;
+		}
+		inConfig = false;
+		if (strcmp(key, "config") == 0) {
+			inConfig = true;
+		} else if (strcmp(key, "skip") == 0) {
+			settings->skip = strtol(value, NULL, 10);
+		} else if (strcmp(key, "frames") == 0) {
+			settings->frames = strtol(value, NULL, 10);
+		} else if (strcmp(key, "fail") == 0) {
+			settings->fail = strcmp(value, "true") == 0;
+		}
+	}
+	vf->close(vf);
+}
+
+static bool _isTestFile(const char* name) {
+	return strcmp(name, "test.mvl") == 0 || strcmp(name, "test.gb") == 0 || strcmp(name, "test.gba") == 0;
+}
+
+static bool _isSelected(const char* name, char* const* filters, int nFilters) {
+	if (!nFilters) {
+		return true;
+	}
+	int i;
+	for (i = 0; i < nFilters; ++i) {
+		size_t length = strlen(filters[i]);
+		if (strncmp(name, filters[i], length) == 0 && (!name[length] || name[length] == '.')) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void _gatherTests(const char* path, const char* name, const struct CinemaSettings* parent,
+                         char* const* filters, int nFilters, struct CinemaTestList* tests) {
+	struct VDir* dir = VDirOpen(path);
+	if (!dir) {
+		return;
+	}
+	struct CinemaSettings settings;
+	_settingsCopy(&settings, parent);
+	_readManifest(path, &settings);
+
+	struct StringList subdirs;
+	StringListInit(&subdirs, 0);
+	const char* testFile = NULL;
+	struct VDirEntry* entry;
+	while ((entry = dir->listNext(dir))) {
+		const char* entryName = entry->name(entry);
+		if (entryName[0] == '.') {
+			continue;
+		}
+		if (entry->type(entry) == VFS_DIRECTORY) {
+			*StringListAppend(&subdirs) = strdup(entryName);
+		} else if (!testFile && _isTestFile(entryName)) {
+			testFile = entryName;
+			if (_isSelected(name, filters, nFilters)) {
+				struct CinemaTest* test = calloc(1, sizeof(*test));
+				test->name = strdup(name);
+				test->path = strdup(path);
+				snprintf(test->file, sizeof(test->file), "%s" PATH_SEP "%s", path, entryName);
+				_settingsCopy(&test->settings, &settings);
+				*CinemaTestListAppend(tests) = test;
+			}
+		}
+	}
+	dir->close(dir);
+
+	size_t i;
+	for (i = 0; i < StringListSize(&subdirs); ++i) {
+		char* subdir = *StringListGetPointer(&subdirs, i);
+		char subpath[PATH_MAX];
+		char subname[PATH_MAX];
+		snprintf(subpath, sizeof(subpath), "%s" PATH_SEP "%s", path, subdir);
+		if (name[0]) {
+			snprintf(subname, sizeof(subname), "%s.%s", name, subdir);
+		} else {
+			strncpy(subname, subdir, sizeof(subname) - 1);
+			subname[sizeof(subname) - 1] = '\0';
+		}
+		_gatherTests(subpath, subname, &settings, filters, nFilters, tests);
+		free(subdir);
+	}
+	StringListDeinit(&subdirs);
+	_settingsDeinit(&settings);
+}
+
+static int _compareTests(const void* a, const void* b) {
+	const struct CinemaTest* left = *(const struct CinemaTest**) a;
+	const struct CinemaTest* right = *(const struct CinemaTest**) b;
+	return strcmp(left->name, right->name);
+}
+
+// A baseline of the wrong size still loads, but leaves sameSize unset
+static bool _loadBaseline(const struct CinemaTest* test, unsigned frame, color_t* pixels, unsigned width, unsigned height, bool* sameSize) {
+	char fname[PATH_MAX];
+	snprintf(fname, sizeof(fname), "%s" PATH_SEP CINEMA_BASELINE, test->path, frame);
+	struct VFile* vf = VFileOpen(fname, O_RDONLY);
+	if (!vf) {
+		return false;
+	}
+	bool success = false;
+	*sameSize = false;
+	png_structp png = PNGReadOpen(vf, 0);
+	png_infop info = png_create_info_struct(png);
+	png_infop end = png_create_info_struct(png);
+	if (png && info && end && PNGReadHeader(png, info)) {
+		success = true;
+		*sameSize = png_get_image_width(png, info) == width && png_get_image_height(png, info) == height;
+	}
+	if (*sameSize) {
+		// A few baselines were saved as grayscale
+		if (!(png_get_color_type(png, info) & PNG_COLOR_MASK_COLOR)) {
+			png_set_gray_to_rgb(png);
+			png_read_update_info(png, info);
+		}
+		success = PNGReadPixels(png, info, pixels, width, height, width);
+	}
+	PNGReadClose(png, info, end);
+	vf->close(vf);
+	return success;
+}
+
+static unsigned _compareFrame(const color_t* actual, const color_t* expected, size_t pixels) {
+	unsigned mismatched = 0;
+	size_t i;
+	for (i = 0; i < pixels; ++i) {
+		if ((actual[i] ^ expected[i]) & CINEMA_COLOR_MASK) {
+			++mismatched;
+		}
+	}
+	return mismatched;
+}
+
+static void _runTest(struct CinemaTest* test, color_t* outputBuffer, color_t* baseline) {
+	struct mCore* core = mCoreFind(test->file);
+	if (!core) {
+		test->status = CINEMA_ERROR;
+		test->error = "could not find a core";
+		return;
+	}
+	core->init(core);
+	mCoreInitConfig(core, NULL);
+	if (!mCoreLoadFile(core, test->file)) {
+		test->status = CINEMA_ERROR;
+		test->error = "could not load";
+		mCoreConfigDeinit(&core->config);
+		core->deinit(core);
+		return;
+	}
+	memset(outputBuffer, 0, 256 * 256 * BYTES_PER_PIXEL);
+	core->setVideoBuffer(core, outputBuffer, 256);
+
+	// The core may hold onto values from this until it's torn down
+	struct mCoreConfig config;
+	mCoreConfigInit(&config, NULL);
+	size_t i;
+	for (i = 0; i + 1 < StringListSize(&test->settings.config); i += 2) {
+		mCoreConfigSetDefaultValue(&config, *StringListGetPointer(&test->settings.config, i),
+		                           *StringListGetPointer(&test->settings.config, i + 1));
+	}
+	if (StringListSize(&test->settings.config)) {
+		mCoreLoadForeignConfig(core, &config);
+	}
+	core->reset(core);
+	// Like the baselines, frames are packed at the size the core settles on once it's reset
+	unsigned width, height;
+	core->desiredVideoDimensions(core, &width, &height);
+	core->setVideoBuffer(core, outputBuffer, width);
+
+	// Frames are counted the same way as the Python runner, so the baselines line up
+	uint64_t duration = 0;
+	uint64_t start;
+	int32_t frame = 0;
+	int skip;
+	for (skip = test->settings.skip + 1; skip > 0; --skip) {
+		frame = core->frameCounter(core);
+		start = _clock();
+		core->runFrame(core);
+		duration += _clock() - start;
+		++test->frames;
+	}
+
+	test->status = CINEMA_PASS;
+	test->firstMismatch = -1;
+	int limit = test->settings.frames;
+	// Video logs loop back to the start once they run out
+	while (frame <= core->frameCounter(core) && limit) {
+		bool sameSize;
+		if (!_loadBaseline(test, test->checked, baseline, width, height, &sameSize)) {
+			test->missingBaseline = true;
+			if (test->firstMismatch < 0) {
+				test->firstMismatch = test->checked;
+			}
+			break;
+		}
+		unsigned mismatched = width * height;
+		if (sameSize) {
+			mismatched = _compareFrame(outputBuffer, baseline, width * height);
+		}
+		if (mismatched && test->firstMismatch < 0) {
+			test->firstMismatch = test->checked;
+			test->mismatchedPixels = mismatched;
+		}
+		++test->checked;
+
+		frame = core->frameCounter(core);
+		start = _clock();
+		core->runFrame(core);
+		duration += _clock() - start;
+		++test->frames;
+		if (limit > 0) {
+			--limit;
+		}
+	}
+	test->duration = duration;
+
+	if (test->status == CINEMA_PASS && test->firstMismatch >= 0) {
+		test->status = CINEMA_FAIL;
+	}
+	if (test->settings.fail) {
+		if (test->status == CINEMA_PASS) {
+			test->status = CINEMA_XPASS;
+		} else if (test->status == CINEMA_FAIL) {
+			test->status = CINEMA_XFAIL;
+		}
+	}
+
+	mCoreConfigDeinit(&core->config);
+	core->deinit(core);
+	mCoreConfigDeinit(&config);
+}
+
+static double _fps(const struct CinemaTest* test) {
+	return test->duration ? test->frames * 1000000.0 / test->duration : 0;
+}
+
+static void _report(const struct CinemaRun* run, const struct CinemaTest* test) {
+	switch (test->status) {
+	case CINEMA_PASS:
+	case CINEMA_XFAIL:
+		if (run->quiet) {
+			return;
+		}
+		printf("%-5s %s: %u frames at %.1f fps\n", _statusNames[test->status], test->name, test->frames, _fps(test));
+		break;
+	case CINEMA_XPASS:
+		printf("%-5s %s: expected to fail, but matched every baseline\n", _statusNames[test->status], test->name);
+		break;
+	case CINEMA_FAIL:
+		if (test->missingBaseline && test->firstMismatch == (int) test->checked) {
+			printf("%-5s %s: frame %i has no baseline\n", _statusNames[test->status], test->name, test->firstMismatch);
+			break;
+		}
+		printf("%-5s %s: frame %i differs from the baseline in %u pixels\n", _statusNames[test->status], test->name, test->firstMismatch, test->mismatchedPixels);
+		break;
+	case CINEMA_ERROR:
+		printf("%-5s %s: %s\n", _statusNames[test->status], test->name, test->error);
+		break;
+	}
+	fflush(stdout);
+}
+
+static struct CinemaTest* _nextTest(struct CinemaRun* run, struct CinemaTest* finished) {
+	struct CinemaTest* test = NULL;
+#ifndef DISABLE_THREADING
+	MutexLock(&run->mutex);
+#endif
+	if (finished) {
+		_report(run, finished);
+	}
+	if (run->nextTest < CinemaTestListSize(&run->tests)) {
+		test = *CinemaTestListGetPointer(&run->tests, run->nextTest);
+		++run->nextTest;
+	}
+#ifndef DISABLE_THREADING
+	MutexUnlock(&run->mutex);
+#endif
+	return test;
+}
+
+static THREAD_ENTRY _cinemaWorker(void* context) {
+	struct CinemaRun* run = context;
+	color_t* outputBuffer = malloc(256 * 256 * BYTES_PER_PIXEL);
+	color_t* baseline = malloc(256 * 256 * BYTES_PER_PIXEL);
+	struct CinemaTest* test = NULL;
+	while ((test = _nextTest(run, test))) {
+		_runTest(test, outputBuffer, baseline);
+	}
+	free(baseline);
+	free(outputBuffer);
+	return 0;
+}
+
+static void _writeJSONString(FILE* out, const char* string) {
+	fputc('"', out);
+	for (; *string; ++string) {
+		unsigned char c = *string;
+		if (c == '"' || c == '\\') {
+			fprintf(out, "\\%c", c);
+		} else if (c < 0x20) {
+			fprintf(out, "\\u%04x", c);
+		} else {
+			fputc(c, out);
+		}
+	}
+	fputc('"', out);
+}
+
+static void _writeJSONResult(FILE* out, const struct CinemaTest* test) {
+	fputs("{\"name\": ", out);
+	_writeJSONString(out, test->name);
+	fprintf(out, ", \"status\": \"%s\"", _statusNames[test->status]);
+	if (test->status == CINEMA_ERROR) {
+		fputs(", \"error\": ", out);
+		_writeJSONString(out, test->error);
+	}
+	fprintf(out, ", \"frames\": %u, \"checked\": %u, \"duration\": %" PRIu64 ", \"fps\": %.3f",
+	        test->frames, test->checked, test->duration, _fps(test));
+	if (test->firstMismatch >= 0) {
+		fprintf(out, ", \"first_mismatch\": %i, \"mismatched_pixels\": %u", test->firstMismatch, test->mismatchedPixels);
+	}
+	if (test->missingBaseline) {
+		fprintf(out, ", \"missing_baseline\": %u", test->checked);
+	}
+	fputc('}', out);
+}
+
+int main(int argc, char** argv) {
+	const char* base = "cinema";
+	const char* output = NULL;
+	unsigned jobs = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nProcessors > 1) {
+		jobs = nProcessors;
+	}
+#endif
+	struct CinemaRun run = {
+		.nextTest = 0,
+		.quiet = false
+	};
+	int ch;
+	while ((ch = getopt(argc, argv, CINEMA_OPTIONS)) != -1) {
+		switch (ch) {
+		case 'b':
+			base = optarg;
+			break;
+		case 'j':
+			jobs = strtoul(optarg, NULL, 10);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'q':
+			run.quiet = true;
+			break;
+		default:
+			fprintf(stderr, CINEMA_USAGE, argv[0]);
+			return 1;
+		}
+	}
+	if (!jobs) {
+		fprintf(stderr, CINEMA_USAGE, argv[0]);
+		return 1;
+	}
+
+	struct mLogger logger = { .log = _log };
+	mLogSetDefaultLogger(&logger);
+
+	struct CinemaSettings settings = {
+		.skip = 0,
+		.frames = -1,
+		.fail = false
+	};
+	StringListInit(&settings.config, 0);
+	CinemaTestListInit(&run.tests, 0);
+	_gatherTests(base, "", &settings, &argv[optind], argc - optind, &run.tests);
+	_settingsDeinit(&settings);
+	if (!CinemaTestListSize(&run.tests)) {
+		fprintf(stderr, "No tests found in %s\n", base);
+		CinemaTestListDeinit(&run.tests);
+		return 1;
+	}
+	qsort(CinemaTestListGetPointer(&run.tests, 0), CinemaTestListSize(&run.tests), sizeof(struct CinemaTest*), _compareTests);
+
+#ifndef DISABLE_THREADING
+	// Every test gets its own core, so there is nothing to share besides the queue
+	size_t nThreads = jobs;
+	if (nThreads > CinemaTestListSize(&run.tests)) {
+		nThreads = CinemaTestListSize(&run.tests);
+	}
+	Thread* threads = malloc(sizeof(*threads) * nThreads);
+	size_t started;
+	MutexInit(&run.mutex);
+	for (started = 0; started < nThreads; ++started) {
+		if (ThreadCreate(&threads[started], _cinemaWorker, &run)) {
+			break;
+		}
+	}
+	if (!started) {
+		_cinemaWorker(&run);
+	}
+	size_t i;
+	for (i = 0; i < started; ++i) {
+		ThreadJoin(&threads[i]);
+	}
+	MutexDeinit(&run.mutex);
+	free(threads);
+#else
+	_cinemaWorker(&run);
+	size_t i;
+#endif
+
+	unsigned counts[CINEMA_ERROR + 1] = {0};
+	FILE* out = NULL;
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			fprintf(stderr, "Could not open %s\n", output);
+		} else {
+			fputs("[\n", out);
+		}
+	}
+	for (i = 0; i < CinemaTestListSize(&run.tests); ++i) {
+		struct CinemaTest* test = *CinemaTestListGetPointer(&run.tests, i);
+		++counts[test->status];
+		if (out) {
+			if (i) {
+				fputs(",\n", out);
+			}
+			_writeJSONResult(out, test);
+		}
+		_settingsDeinit(&test->settings);
+		free(test->name);
+		free(test->path);
+		free(test);
+	}
+	if (out) {
+		fputs("\n]\n", out);
+		fclose(out);
+	}
+	CinemaTestListDeinit(&run.tests);
+
+	printf("%u passed, %u failed, %u errors, %u expected failures, %u unexpected passes\n",
+	       counts[CINEMA_PASS], counts[CINEMA_FAIL], counts[CINEMA_ERROR], counts[CINEMA_XFAIL], counts[CINEMA_XPASS]);
+	return (counts[CINEMA_FAIL] || counts[CINEMA_ERROR] || (output && !out)) ? 1 : 0;
+}
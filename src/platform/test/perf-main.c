@@ -8,12 +8,21 @@
 #include <mgba/core/config.h>
 #include <mgba/core/core.h>
 #include <mgba/core/serialize.h>
+#include <mgba/core/timing.h>
 #include <mgba/gb/core.h>
 #include <mgba/gba/core.h>
 
 #include <mgba/feature/commandline.h>
+#include <mgba/feature/video-logger.h>
+#ifdef USE_DEBUGGERS
+#include <mgba/internal/debugger/profiler.h>
+#endif
+#include <mgba-util/configuration.h>
+#include <mgba-util/crc32.h>
 #include <mgba-util/socket.h>
 #include <mgba-util/string.h>
+#include <mgba-util/threading.h>
+#include <mgba-util/vector.h>
 #include <mgba-util/vfs.h>
 
 #ifdef _3DS
@@ -32,43 +41,236 @@ size_t romBufferSize;
 #endif
 #endif
 
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
 #include <inttypes.h>
 #include <sys/time.h>
 
-#define PERF_OPTIONS "DF:L:NPS:T"
+#ifdef __linux__
+#define PERF_HAS_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef USE_DEBUGGERS
+#define PERF_PROFILE_OPTIONS "R:"
+#define PERF_PROFILE_USAGE \
+	"  -R FILE          Sample the guest PC and write folded stacks for a flame graph to FILE\n"
+#else
+#define PERF_PROFILE_OPTIONS
+#define PERF_PROFILE_USAGE
+#endif
+
+#define PERF_OPTIONS "AB:DEF:GH:I:KL:M:NPS:TVX:j:o:r:" PERF_PROFILE_OPTIONS
 #define PERF_USAGE \
 	"\nBenchmark options:\n" \
 	"  -F FRAMES        Run for the specified number of FRAMES before exiting\n" \
 	"  -N               Disable video rendering entirely\n" \
 	"  -T               Use threaded video rendering\n" \
+	"  -B THREADS       Render scanlines in parallel bands on THREADS threads\n" \
 	"  -P               CSV output, useful for parsing\n" \
 	"  -S SEC           Run for SEC in-game seconds before exiting\n" \
 	"  -L FILE          Load a savestate when starting the test\n" \
-	"  -D               Act as a server"
+	"  -E               Break down where host time went when finished, including per-event scheduler statistics\n" \
+	"                   and the emulated cycles lost to memory waitstates\n" \
+	"  -A               Read out the audio buffers after every frame\n" \
+	"  -K               Count cycles, instructions, branch misses and cache misses on the emulation thread\n" \
+	"  -V               Replay a video log through the renderer alone, timing each frame and scanline\n" \
+	"  -I MOVIE         Press the keys listed in MOVIE, one \"FRAME KEYS\" line per change\n" \
+	"  -H GOLDEN        Hash the video and audio of every frame and fail if any differ from GOLDEN\n" \
+	"  -G               Write the frame hashes to GOLDEN instead of checking them\n" \
+	PERF_PROFILE_USAGE \
+	"  -D               Act as a server\n" \
+	"\nBatch options:\n" \
+	"  -M MANIFEST      Run every game listed in MANIFEST and write the results as JSON\n" \
+	"                   Each section names a rom, and optionally a savestate, frames, movie and golden\n" \
+	"  -j THREADS       Run up to THREADS games at once, each on its own core\n" \
+	"  -o FILE          Write the JSON results to FILE instead of standard output\n" \
+	"  -r BASELINE      Compare against the results of an earlier batch, failing on regressions\n" \
+	"  -X PERCENT       Allow frame rates and frame times to get PERCENT worse than the baseline (default 5)"
+
+#define PERF_CSV_HEADER "game_code,frames,duration,renderer"
+// Frame times are in microseconds, scanline times in nanoseconds
+#define PERF_RENDERER_CSV_COLUMNS ",frame_min,frame_median,frame_p99,frame_max,scanline_mean,scanline_max"
+// Hardware counters are per frame, and left empty where unavailable
+#define PERF_COUNTER_CSV_COLUMNS ",cycles,instructions,branch_misses,l1d_misses,llc_misses"
+#define PERF_BREAKDOWN_LENGTH 2048
 
 struct PerfOpts {
 	bool noVideo;
 	bool threadedVideo;
+	unsigned videoThreads;
 	bool csv;
 	unsigned duration;
 	unsigned frames;
 	char* savestate;
 	bool server;
+	bool eventStats;
+	bool drainAudio;
+	bool rendererOnly;
+	char* profile;
+	char* movie;
+	char* golden;
+	bool recordGolden;
+	char* manifest;
+	unsigned jobs;
+	char* output;
+	char* baseline;
+	float threshold;
+	bool hardwareCounters;
+};
+
+enum PerfCounter {
+	PERF_COUNTER_CYCLES,
+	PERF_COUNTER_INSTRUCTIONS,
+	PERF_COUNTER_BRANCH_MISSES,
+	PERF_COUNTER_L1D_MISSES,
+	PERF_COUNTER_LLC_MISSES,
+	PERF_COUNTER_MAX
+};
+
+struct PerfCounters {
+	int fd[PERF_COUNTER_MAX];
+};
+
+static const char* const _counterNames[PERF_COUNTER_MAX] = {
+	"cycles",
+	"instructions",
+	"branch_misses",
+	"l1d_misses",
+	"llc_misses",
+};
+
+DECLARE_VECTOR(PerfFrameTimes, uint64_t);
+DEFINE_VECTOR(PerfFrameTimes, uint64_t);
+
+struct PerfFrameHash {
+	uint32_t video;
+	uint32_t audio;
+};
+
+DECLARE_VECTOR(PerfFrameHashes, struct PerfFrameHash);
+DEFINE_VECTOR(PerfFrameHashes, struct PerfFrameHash);
+
+struct PerfMovieEntry {
+	int frame;
+	uint32_t keys;
+};
+
+DECLARE_VECTOR(PerfMovie, struct PerfMovieEntry);
+DEFINE_VECTOR(PerfMovie, struct PerfMovieEntry);
+
+struct PerfGame {
+	const char* rom;
+	struct VFile* savestate;
+	const char* movie;
+	int frames;
+	// Each frame's video and audio get hashed for comparison against a golden run
+	bool hashFrames;
+};
+
+struct PerfHashCheck {
+	size_t frames;
+	size_t mismatches;
+	int firstMismatch;
+};
+
+struct PerfResult {
+	char gameCode[9];
+	int frames;
+	// In microseconds
+	uint64_t duration;
+	// In nanoseconds, like everything else collected with _statsClock
+	struct PerfFrameTimes frameTimes;
+	struct PerfFrameHashes hashes;
+	struct mVideoLoggerStats lineStats;
+	uint64_t hostTime[mTIMING_HOST_MAX];
+	struct mTimingEventStatsList events;
+	// In emulated cycles
+	uint64_t cycles;
+	uint64_t waitCycles[mTIMING_WAIT_REGIONS][mTIMING_WAIT_MAX];
+	uint64_t counters[PERF_COUNTER_MAX];
+	bool counterValid[PERF_COUNTER_MAX];
 };
 
 #ifdef __SWITCH__
 TimeType __nx_time_type = TimeType_LocalSystemClock;
 #endif
 
-static void _mPerfRunloop(struct mCore* context, int* frames, bool quiet);
+static void _mPerfRunloop(struct mCore* context, int* frames, bool quiet, bool drainAudio, const struct PerfMovie* movie,
+                          struct PerfFrameTimes* frameTimes, bool hashVideo, struct PerfFrameHashes* hashes);
 static void _mPerfShutdown(int signal);
 static bool _parsePerfOpts(struct mSubParser* parser, int option, const char* arg);
 static void _log(struct mLogger*, int, enum mLogLevel, const char*, va_list);
+static uint64_t _statsClock(void);
+static const char* _csvHeader(const struct PerfOpts* opts);
+static void _formatBreakdown(const struct PerfResult* result, char* buffer, size_t size);
+static void _dumpEventStats(const struct PerfResult* result);
+static uint64_t _waitCycles(const struct PerfResult* result, unsigned region);
+static void _summarizeFrameTimes(struct PerfFrameTimes* frameTimes, uint64_t* summary);
+static size_t _countersOpen(struct PerfCounters* counters);
+static void _countersStart(struct PerfCounters* counters);
+static void _countersStop(struct PerfCounters* counters, struct PerfResult* result);
+static void _probeCounters(void);
+static void _dumpCounters(const struct PerfResult* result);
+static void _dumpRendererStats(struct PerfFrameTimes* frameTimes, const struct mVideoLoggerStats* lineStats);
+static int _compareFrameTimes(const void* a, const void* b) {
+	uint64_t left = *(const uint64_t*) a;
+	uint64_t right = *(const uint64_t*) b;
+	return (left > right) - (left < right);
+}
+
+// Fills in the minimum, median, 99th percentile and maximum, in nanoseconds
+static void _summarizeFrameTimes(struct PerfFrameTimes* frameTimes, uint64_t* summary) {
+	size_t size = PerfFrameTimesSize(frameTimes);
+	if (!size) {
+		memset(summary, 0, sizeof(*summary) * 4);
+		return;
+	}
+	uint64_t* times = PerfFrameTimesGetPointer(frameTimes, 0);
+	qsort(times, size, sizeof(*times), _compareFrameTimes);
+	summary[0] = times[0];
+	summary[1] = times[size / 2];
+	summary[2] = times[(size - 1) * 99 / 100];
+	summary[3] = times[size - 1];
+}
+
+static void _dumpRendererStats(struct PerfFrameTimes* frameTimes, const struct mVideoLoggerStats* lineStats) {
+	uint64_t summary[4];
+	_summarizeFrameTimes(frameTimes, summary);
+	printf("Frame times (us): min %.1f, median %.1f, 99th percentile %.1f, max %.1f\n",
+	       summary[0] / 1000.0, summary[1] / 1000.0, summary[2] / 1000.0, summary[3] / 1000.0);
+	if (!lineStats->lines) {
+		return;
+	}
+	printf("Scanline times (us): mean %.2f, max %.2f over %" PRIu64 " scanlines\n",
+	       lineStats->lineTime / (lineStats->lines * 1000.0), lineStats->maxLineTime / 1000.0, lineStats->lines);
+	printf("%8s %12s %10s\n", "Scanline", "Drawn", "Mean us");
+	size_t y;
+	for (y = 0; y < mVL_STATS_MAX_LINES; ++y) {
+		if (!lineStats->linesByY[y]) {
+			continue;
+		}
+		printf("%8u %12u %10.2f\n", (unsigned) y, lineStats->linesByY[y], lineStats->lineTimeByY[y] / (lineStats->linesByY[y] * 1000.0));
+	}
+}
+
+#ifdef USE_DEBUGGERS
+static void _writeProfile(struct mDebuggerProfiler* profiler, const char* path);
+#endif
+static void _perfResultInit(struct PerfResult* result);
+static void _perfResultDeinit(struct PerfResult* result);
+static bool _loadMovie(const char* path, struct PerfMovie* movie);
+static bool _writeFrameHashes(const char* path, const struct PerfFrameHashes* hashes);
+static bool _checkFrameHashes(const char* name, const char* path, const struct PerfFrameHashes* hashes, struct PerfHashCheck* check);
+static bool _mPerfRunGame(const struct PerfGame* game, void* outputBuffer, bool quiet,
+                          const struct mArguments*, const struct PerfOpts*, struct PerfResult* result);
 static bool _mPerfRunCore(const char* fname, const struct mArguments*, const struct PerfOpts*);
 static bool _mPerfRunServer(const struct mArguments*, const struct PerfOpts*);
+static bool _mPerfRunBatch(const struct mArguments*, const struct PerfOpts*);
 
 static bool _dispatchExiting = false;
 static struct VFile* _savestate = 0;
@@ -116,7 +318,13 @@ int main(int argc, char** argv) {
 	struct mLogger logger = { .log = _log };
 	mLogSetDefaultLogger(&logger);
 
-	struct PerfOpts perfOpts = { false, false, false, 0, 0, 0, false };
+	struct PerfOpts perfOpts = { false, false, 0, false, 0, 0, 0, false, false, false, false, NULL, NULL, NULL, false, NULL, 1, NULL, NULL, 5.f, false };
+#ifdef _SC_NPROCESSORS_ONLN
+	long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nProcessors > 1) {
+		perfOpts.jobs = nProcessors;
+	}
+#endif
 	struct mSubParser subparser = {
 		.usage = PERF_USAGE,
 		.parse = _parsePerfOpts,
@@ -126,7 +334,7 @@ int main(int argc, char** argv) {
 
 	struct mArguments args = {};
 	bool parsed = parseArguments(&args, argc, argv, &subparser);
-	if (!args.fname && !perfOpts.server) {
+	if (!args.fname && !perfOpts.server && !perfOpts.manifest) {
 		parsed = false;
 	}
 	if (!parsed || args.showHelp) {
@@ -140,14 +348,22 @@ int main(int argc, char** argv) {
 		goto cleanup;
 	}
 
+	if (perfOpts.hardwareCounters) {
+		_probeCounters();
+	}
+	if (perfOpts.manifest) {
+		// Batches keep the savestate path, since every worker needs its own copy open
+		didFail = !_mPerfRunBatch(&args, &perfOpts);
+		goto cleanup;
+	}
+
 	if (perfOpts.savestate) {
 		_savestate = VFileOpen(perfOpts.savestate, O_RDONLY);
-		free(perfOpts.savestate);
 	}
 
 	_outputBuffer = malloc(256 * 256 * 4);
 	if (perfOpts.csv) {
-		puts("game_code,frames,duration,renderer");
+		puts(_csvHeader(&perfOpts));
 #ifdef __SWITCH__
 		consoleUpdate(NULL);
 #elif defined(GEKKO)
@@ -166,6 +382,13 @@ int main(int argc, char** argv) {
 	}
 	cleanup:
 	freeArguments(&args);
+	free(perfOpts.profile);
+	free(perfOpts.savestate);
+	free(perfOpts.movie);
+	free(perfOpts.golden);
+	free(perfOpts.manifest);
+	free(perfOpts.output);
+	free(perfOpts.baseline);
 
 #ifdef _3DS
 	gfxExit();
@@ -182,18 +405,58 @@ int main(int argc, char** argv) {
 	return didFail;
 }
 
-bool _mPerfRunCore(const char* fname, const struct mArguments* args, const struct PerfOpts* perfOpts) {
-	struct mCore* core = mCoreFind(fname);
+static void _perfResultInit(struct PerfResult* result) {
+	memset(result, 0, sizeof(*result));
+	PerfFrameTimesInit(&result->frameTimes, 0);
+	PerfFrameHashesInit(&result->hashes, 0);
+	mTimingEventStatsListInit(&result->events, 0);
+}
+
+static void _perfResultDeinit(struct PerfResult* result) {
+	PerfFrameTimesDeinit(&result->frameTimes);
+	PerfFrameHashesDeinit(&result->hashes);
+	mTimingEventStatsListDeinit(&result->events);
+}
+
+// Everything here is local to the core, so several games can be run at once on different threads
+static bool _mPerfRunGame(const struct PerfGame* game, void* outputBuffer, bool quiet,
+                          const struct mArguments* args, const struct PerfOpts* perfOpts, struct PerfResult* result) {
+	const char* fname = game->rom;
+	int frames = game->frames;
+	struct PerfMovie movie;
+	PerfMovieInit(&movie, 0);
+	if (game->movie && !_loadMovie(game->movie, &movie)) {
+		PerfMovieDeinit(&movie);
+		return false;
+	}
+
+	struct mCore* core;
+	if (perfOpts->rendererOnly) {
+		// Only a video log leaves the CPU out of the measurement
+		struct VFile* vf = VFileOpen(fname, O_RDONLY);
+		core = vf ? mVideoLogCoreFind(vf) : NULL;
+		if (vf) {
+			vf->close(vf);
+		}
+		if (!core) {
+			fprintf(stderr, "%s is not a video log\n", fname);
+			PerfMovieDeinit(&movie);
+			return false;
+		}
+	} else {
+		core = mCoreFind(fname);
+	}
 	if (!core) {
+		PerfMovieDeinit(&movie);
 		return false;
 	}
 
 	// TODO: Put back debugger
-	char gameCode[9] = { 0 };
-
 	core->init(core);
 	if (!perfOpts->noVideo) {
-		core->setVideoBuffer(core, _outputBuffer, 256);
+		// The buffer gets reused between games, and the first frame may not cover all of it
+		memset(outputBuffer, 0, 256 * 256 * 4);
+		core->setVideoBuffer(core, outputBuffer, 256);
 	}
 	mCoreLoadFile(core, fname);
 	mCoreConfigInit(&core->config, "perf");
@@ -204,6 +467,7 @@ bool _mPerfRunCore(const char* fname, const struct mArguments* args, const struc
 	} else {
 		mCoreConfigSetOverrideIntValue(&core->config, "threadedVideo", 0);
 	}
+	mCoreConfigSetOverrideIntValue(&core->config, "videoThreads", perfOpts->videoThreads);
 
 	struct mCoreOptions opts = {};
 	mCoreConfigMap(&core->config, &opts);
@@ -214,63 +478,787 @@ bool _mPerfRunCore(const char* fname, const struct mArguments* args, const struc
 	mCoreConfigSetDefaultValue(&core->config, "idleOptimization", "detect");
 	mCoreLoadConfig(core);
 
+	if (game->hashFrames) {
+		// The host clock would make the game's clock, and anything it drives, differ between runs
+		core->rtc.override = RTC_FAKE_EPOCH;
+		core->rtc.value = 0;
+	}
+
 	core->reset(core);
-	if (_savestate) {
-		mCoreLoadStateNamed(core, _savestate, 0);
+	if (game->savestate) {
+		game->savestate->seek(game->savestate, 0, SEEK_SET);
+		mCoreLoadStateNamed(core, game->savestate, 0);
 	}
+	if (perfOpts->eventStats) {
+		mTimingEnableStats(core->timing, _statsClock);
+	}
+#ifdef USE_DEBUGGERS
+	struct mDebuggerProfiler profiler;
+	if (perfOpts->profile) {
+		mDebuggerProfilerInit(&profiler, core, 0);
+		mDebuggerProfilerStart(&profiler);
+	}
+#endif
 
-	core->getGameCode(core, gameCode);
+	if (perfOpts->rendererOnly && core->videoLogger) {
+		mVideoLoggerEnableStats(core->videoLogger, &result->lineStats, _statsClock);
+	}
 
-	int frames = perfOpts->frames;
-	if (!frames) {
-		frames = perfOpts->duration * 60;
+	core->getGameCode(core, result->gameCode);
+
+	struct PerfCounters counters;
+	if (perfOpts->hardwareCounters) {
+		// Counters follow the thread that opens them, so this has to happen on the one running the core
+		_countersOpen(&counters);
+		_countersStart(&counters);
 	}
 	struct timeval tv;
 	gettimeofday(&tv, 0);
 	uint64_t start = 1000000LL * tv.tv_sec + tv.tv_usec;
-	_mPerfRunloop(core, &frames, perfOpts->csv);
+	_mPerfRunloop(core, &frames, quiet, perfOpts->drainAudio, &movie, &result->frameTimes,
+	              !perfOpts->noVideo, game->hashFrames ? &result->hashes : NULL);
 	gettimeofday(&tv, 0);
 	uint64_t end = 1000000LL * tv.tv_sec + tv.tv_usec;
-	uint64_t duration = end - start;
+	if (perfOpts->hardwareCounters) {
+		_countersStop(&counters, result);
+	}
+	result->frames = frames;
+	result->duration = end - start;
+	if (perfOpts->rendererOnly && core->videoLogger) {
+		mVideoLoggerDisableStats(core->videoLogger);
+	}
+
+	if (perfOpts->eventStats) {
+		enum mTimingHostCategory category;
+		for (category = 0; category < mTIMING_HOST_MAX; ++category) {
+			result->hostTime[category] = mTimingHostTime(core->timing, category);
+		}
+		result->cycles = (uint64_t) frames * core->frameCycles(core);
+		unsigned region;
+		enum mTimingWaitAccess access;
+		for (region = 0; region < mTIMING_WAIT_REGIONS; ++region) {
+			for (access = 0; access < mTIMING_WAIT_MAX; ++access) {
+				result->waitCycles[region][access] = mTimingWaitCycles(core->timing, region, access);
+			}
+		}
+		// Event names are static strings, so they outlive the core
+		size_t i;
+		for (i = 0; i < mTimingStatsSize(core->timing); ++i) {
+			*mTimingEventStatsListAppend(&result->events) = *mTimingStatsGet(core->timing, i);
+		}
+	}
+#ifdef USE_DEBUGGERS
+	if (perfOpts->profile) {
+		_writeProfile(&profiler, perfOpts->profile);
+		mDebuggerProfilerDeinit(&profiler);
+	}
+#endif
 
 	mCoreConfigFreeOpts(&opts);
 	mCoreConfigDeinit(&core->config);
 	core->deinit(core);
+	PerfMovieDeinit(&movie);
+	return true;
+}
+
+static const char* _rendererName(const struct PerfOpts* perfOpts) {
+	if (perfOpts->noVideo) {
+		return "none";
+	} else if (perfOpts->threadedVideo) {
+		return "threaded-software";
+	} else {
+		return "software";
+	}
+}
+
+bool _mPerfRunCore(const char* fname, const struct mArguments* args, const struct PerfOpts* perfOpts) {
+	int frames = perfOpts->frames;
+	if (!frames) {
+		frames = perfOpts->duration * 60;
+	}
+	struct PerfGame game = {
+		.rom = fname,
+		.savestate = _savestate,
+		.movie = perfOpts->movie,
+		.frames = frames,
+		.hashFrames = !!perfOpts->golden
+	};
+	struct PerfResult* result = malloc(sizeof(*result));
+	_perfResultInit(result);
+	if (!_mPerfRunGame(&game, _outputBuffer, perfOpts->csv, args, perfOpts, result)) {
+		_perfResultDeinit(result);
+		free(result);
+		return false;
+	}
+	frames = result->frames;
+	uint64_t duration = result->duration;
 
 	float scaledFrames = frames * 1000000.f;
 	if (perfOpts->csv) {
-		char buffer[256];
-		const char* rendererName;
-		if (perfOpts->noVideo) {
-			rendererName = "none";
-		} else if (perfOpts->threadedVideo) {
-			rendererName = "threaded-software";
-		} else {
-			rendererName = "software";
+		char buffer[PERF_BREAKDOWN_LENGTH + 256];
+		int length = snprintf(buffer, sizeof(buffer), "%s,%i,%" PRIu64 ",%s", result->gameCode, frames, duration, _rendererName(perfOpts));
+		if (perfOpts->rendererOnly) {
+			const struct mVideoLoggerStats* lineStats = &result->lineStats;
+			uint64_t summary[4];
+			_summarizeFrameTimes(&result->frameTimes, summary);
+			length += snprintf(&buffer[length], sizeof(buffer) - length, ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+			                   summary[0] / 1000, summary[1] / 1000, summary[2] / 1000, summary[3] / 1000,
+			                   lineStats->lines ? lineStats->lineTime / lineStats->lines : 0, lineStats->maxLineTime);
+		}
+		if (perfOpts->hardwareCounters) {
+			size_t i;
+			for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+				if (result->counterValid[i] && frames) {
+					length += snprintf(&buffer[length], sizeof(buffer) - length, ",%" PRIu64, result->counters[i] / frames);
+				} else {
+					length += snprintf(&buffer[length], sizeof(buffer) - length, ",");
+				}
+			}
 		}
-		snprintf(buffer, sizeof(buffer), "%s,%i,%" PRIu64 ",%s\n", gameCode, frames, duration, rendererName);
+		if (perfOpts->eventStats) {
+			_formatBreakdown(result, &buffer[length], sizeof(buffer) - length);
+			length += strlen(&buffer[length]);
+		}
+		snprintf(&buffer[length], sizeof(buffer) - length, "\n");
 		printf("%s", buffer);
 		if (_socket != INVALID_SOCKET) {
 			SocketSend(_socket, buffer, strlen(buffer));
 		}
 	} else {
+		if (perfOpts->eventStats) {
+			_dumpEventStats(result);
+		}
+		if (perfOpts->hardwareCounters) {
+			_dumpCounters(result);
+		}
 		printf("%u frames in %" PRIu64 " microseconds: %g fps (%gx)\n", frames, duration, scaledFrames / duration, scaledFrames / (duration * 60.f));
+		if (perfOpts->rendererOnly) {
+			_dumpRendererStats(&result->frameTimes, &result->lineStats);
+		}
+	}
+	bool success = true;
+	if (perfOpts->golden && perfOpts->recordGolden) {
+		success = _writeFrameHashes(perfOpts->golden, &result->hashes);
+	} else if (perfOpts->golden) {
+		struct PerfHashCheck check;
+		success = _checkFrameHashes(fname, perfOpts->golden, &result->hashes, &check);
+		if (success && !perfOpts->csv) {
+			printf("All %" PRIz "u frame hashes match %s\n", check.frames, perfOpts->golden);
+		}
 	}
+	_perfResultDeinit(result);
+	free(result);
 #ifdef __SWITCH__
 	consoleUpdate(NULL);
 #endif
 
+	return success;
+}
+
+struct PerfJob {
+	char* name;
+	char rom[PATH_MAX];
+	char savestate[PATH_MAX];
+	char movie[PATH_MAX];
+	char golden[PATH_MAX];
+	int frames;
+	bool ran;
+	bool hashesMatch;
+	struct PerfHashCheck hashCheck;
+	struct PerfResult result;
+};
+
+DECLARE_VECTOR(PerfJobList, struct PerfJob*);
+DEFINE_VECTOR(PerfJobList, struct PerfJob*);
+
+struct PerfBatch {
+	const struct mArguments* args;
+	const struct PerfOpts* opts;
+	struct PerfJobList jobs;
+	size_t nextJob;
+#ifndef DISABLE_THREADING
+	Mutex mutex;
+#endif
+};
+
+struct PerfBaseline {
+	double fps;
+	double p99;
+};
+
+struct PerfManifestContext {
+	const struct Configuration* config;
+	const char* dirname;
+	const struct PerfOpts* opts;
+	struct PerfJobList* jobs;
+	bool failed;
+};
+
+static bool _isAbsolutePath(const char* path) {
+	return path[0] == '/' || path[0] == '\\' || (path[0] && path[1] == ':');
+}
+
+static void _resolvePath(char* out, const char* dirname, const char* path) {
+	if (!dirname[0] || strcmp(dirname, ".") == 0 || _isAbsolutePath(path)) {
+		strncpy(out, path, PATH_MAX - 1);
+		out[PATH_MAX - 1] = '\0';
+	} else {
+		snprintf(out, PATH_MAX, "%s" PATH_SEP "%s", dirname, path);
+	}
+}
+
+static void _addManifestJob(const char* section, void* user) {
+	struct PerfManifestContext* context = user;
+	const char* rom = ConfigurationGetValue(context->config, section, "rom");
+	if (!rom) {
+		fprintf(stderr, "Manifest entry %s has no rom\n", section);
+		context->failed = true;
+		return;
+	}
+	struct PerfJob* job = calloc(1, sizeof(*job));
+	job->name = strdup(section);
+	_resolvePath(job->rom, context->dirname, rom);
+
+	const char* savestate = ConfigurationGetValue(context->config, section, "savestate");
+	if (savestate) {
+		_resolvePath(job->savestate, context->dirname, savestate);
+	} else if (context->opts->savestate) {
+		strncpy(job->savestate, context->opts->savestate, sizeof(job->savestate) - 1);
+	}
+
+	const char* movie = ConfigurationGetValue(context->config, section, "movie");
+	if (movie) {
+		_resolvePath(job->movie, context->dirname, movie);
+	}
+	const char* golden = ConfigurationGetValue(context->config, section, "golden");
+	if (golden) {
+		_resolvePath(job->golden, context->dirname, golden);
+	}
+
+	const char* frames = ConfigurationGetValue(context->config, section, "frames");
+	if (frames) {
+		job->frames = strtol(frames, NULL, 10);
+	} else if (context->opts->frames) {
+		job->frames = context->opts->frames;
+	} else {
+		job->frames = context->opts->duration * 60;
+	}
+	if (job->frames <= 0) {
+		// Nothing would ever stop an unbounded run besides an interrupt
+		fprintf(stderr, "Manifest entry %s needs a frame count\n", section);
+		context->failed = true;
+	}
+	*PerfJobListAppend(context->jobs) = job;
+}
+
+static int _compareJobs(const void* a, const void* b) {
+	const struct PerfJob* left = *(const struct PerfJob**) a;
+	const struct PerfJob* right = *(const struct PerfJob**) b;
+	return strcmp(left->name, right->name);
+}
+
+static bool _loadManifest(const char* path, const struct PerfOpts* opts, struct PerfJobList* jobs) {
+	struct Configuration config;
+	ConfigurationInit(&config);
+	if (!ConfigurationRead(&config, path)) {
+		fprintf(stderr, "Could not read manifest %s\n", path);
+		ConfigurationDeinit(&config);
+		return false;
+	}
+	char dirname[PATH_MAX];
+	separatePath(path, dirname, NULL, NULL);
+
+	struct PerfManifestContext context = {
+		.config = &config,
+		.dirname = dirname,
+		.opts = opts,
+		.jobs = jobs,
+		.failed = false
+	};
+	ConfigurationEnumerateSections(&config, _addManifestJob, &context);
+	ConfigurationDeinit(&config);
+	if (!context.failed && !PerfJobListSize(jobs)) {
+		fprintf(stderr, "Manifest %s has no entries\n", path);
+		return false;
+	}
+	// Sections come out in hash order, so sort them to keep the output stable between runs
+	qsort(PerfJobListGetPointer(jobs, 0), PerfJobListSize(jobs), sizeof(struct PerfJob*), _compareJobs);
+	return !context.failed;
+}
+
+static void _runJob(struct PerfBatch* batch, struct PerfJob* job, void* outputBuffer) {
+	struct VFile* savestate = NULL;
+	if (job->savestate[0]) {
+		savestate = VFileOpen(job->savestate, O_RDONLY);
+		if (!savestate) {
+			fprintf(stderr, "Could not open savestate %s\n", job->savestate);
+			return;
+		}
+	}
+	struct PerfGame game = {
+		.rom = job->rom,
+		.savestate = savestate,
+		.movie = job->movie[0] ? job->movie : NULL,
+		.frames = job->frames,
+		.hashFrames = !!job->golden[0]
+	};
+	job->ran = _mPerfRunGame(&game, outputBuffer, true, batch->args, batch->opts, &job->result);
+	job->hashesMatch = true;
+	if (!job->ran) {
+		fprintf(stderr, "Could not run %s\n", job->rom);
+	} else if (game.hashFrames && batch->opts->recordGolden) {
+		job->hashesMatch = _writeFrameHashes(job->golden, &job->result.hashes);
+	} else if (game.hashFrames) {
+		job->hashesMatch = _checkFrameHashes(job->name, job->golden, &job->result.hashes, &job->hashCheck);
+	}
+	if (savestate) {
+		savestate->close(savestate);
+	}
+}
+
+static struct PerfJob* _nextJob(struct PerfBatch* batch) {
+	struct PerfJob* job = NULL;
+#ifndef DISABLE_THREADING
+	MutexLock(&batch->mutex);
+#endif
+	if (batch->nextJob < PerfJobListSize(&batch->jobs) && !_dispatchExiting) {
+		job = *PerfJobListGetPointer(&batch->jobs, batch->nextJob);
+		++batch->nextJob;
+	}
+#ifndef DISABLE_THREADING
+	MutexUnlock(&batch->mutex);
+#endif
+	return job;
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _batchWorker(void* context) {
+	struct PerfBatch* batch = context;
+	void* outputBuffer = malloc(256 * 256 * 4);
+	struct PerfJob* job;
+	while ((job = _nextJob(batch))) {
+		_runJob(batch, job, outputBuffer);
+	}
+	free(outputBuffer);
+	return 0;
+}
+#endif
+
+static void _writeJSONString(FILE* out, const char* string) {
+	fputc('"', out);
+	for (; *string; ++string) {
+		unsigned char c = *string;
+		if (c == '"' || c == '\\') {
+			fprintf(out, "\\%c", c);
+		} else if (c < 0x20) {
+			fprintf(out, "\\u%04x", c);
+		} else {
+			fputc(c, out);
+		}
+	}
+	fputc('"', out);
+}
+
+// Only understands what _writeJSONResult writes: one result object per line
+static bool _loadBaseline(const char* path, struct Table* baseline) {
+	FILE* in = fopen(path, "r");
+	if (!in) {
+		fprintf(stderr, "Could not open baseline %s\n", path);
+		return false;
+	}
+	char line[PERF_BREAKDOWN_LENGTH * 2];
+	while (fgets(line, sizeof(line), in)) {
+		const char* name = strstr(line, "{\"name\": \"");
+		const char* fps = strstr(line, "\"fps\": ");
+		const char* p99 = strstr(line, "\"p99\": ");
+		if (!name || !fps || !p99) {
+			continue;
+		}
+		char key[PATH_MAX];
+		size_t length = 0;
+		for (name += strlen("{\"name\": \""); *name && *name != '"' && length < sizeof(key) - 1; ++name) {
+			if (*name == '\\' && name[1]) {
+				++name;
+			}
+			key[length] = *name;
+			++length;
+		}
+		key[length] = '\0';
+		struct PerfBaseline* entry = malloc(sizeof(*entry));
+		entry->fps = strtod(&fps[strlen("\"fps\": ")], NULL);
+		entry->p99 = strtod(&p99[strlen("\"p99\": ")], NULL);
+		HashTableInsert(baseline, key, entry);
+	}
+	fclose(in);
 	return true;
 }
 
-static void _mPerfRunloop(struct mCore* core, int* frames, bool quiet) {
+static bool _isRegression(const struct PerfJob* job, double fps, double p99, const struct PerfBaseline* base, float threshold) {
+	bool regressed = false;
+	if (base->fps > 0 && fps < base->fps * (1 - threshold / 100)) {
+		fprintf(stderr, "%s: fps dropped from %.2f to %.2f (%.1f%%)\n", job->name, base->fps, fps, (fps / base->fps - 1) * 100);
+		regressed = true;
+	}
+	if (base->p99 > 0 && p99 > base->p99 * (1 + threshold / 100)) {
+		fprintf(stderr, "%s: 99th percentile frame time rose from %.1f us to %.1f us (+%.1f%%)\n", job->name, base->p99, p99, (p99 / base->p99 - 1) * 100);
+		regressed = true;
+	}
+	return regressed;
+}
+
+// Frame times are in microseconds, to match the CSV output
+static bool _writeJSONResult(FILE* out, struct PerfJob* job, const struct PerfOpts* opts, const struct Table* baseline) {
+	fputs("{\"name\": ", out);
+	_writeJSONString(out, job->name);
+	fputs(", \"rom\": ", out);
+	_writeJSONString(out, job->rom);
+	if (!job->ran) {
+		fputs(", \"error\": \"could not run\"}", out);
+		return false;
+	}
+	struct PerfResult* result = &job->result;
+	uint64_t summary[4];
+	_summarizeFrameTimes(&result->frameTimes, summary);
+	double fps = result->duration ? result->frames * 1000000.0 / result->duration : 0;
+	double p99 = summary[2] / 1000.0;
+
+	fputs(", \"game_code\": ", out);
+	_writeJSONString(out, result->gameCode);
+	fprintf(out, ", \"renderer\": \"%s\", \"frames\": %i, \"duration\": %" PRIu64 ", \"fps\": %.3f", _rendererName(opts), result->frames, result->duration, fps);
+	fprintf(out, ", \"frame_time\": {\"min\": %.1f, \"median\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+	        summary[0] / 1000.0, summary[1] / 1000.0, p99, summary[3] / 1000.0);
+	if (opts->rendererOnly) {
+		const struct mVideoLoggerStats* lineStats = &result->lineStats;
+		fprintf(out, ", \"scanline_time\": {\"mean\": %" PRIu64 ", \"max\": %" PRIu64 "}",
+		        lineStats->lines ? lineStats->lineTime / lineStats->lines : 0, lineStats->maxLineTime);
+	}
+	if (opts->hardwareCounters) {
+		fputs(", \"counters\": {", out);
+		size_t i;
+		for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+			if (result->counterValid[i] && result->frames) {
+				fprintf(out, "%s\"%s\": %.1f", i ? ", " : "", _counterNames[i], (double) result->counters[i] / result->frames);
+			} else {
+				fprintf(out, "%s\"%s\": null", i ? ", " : "", _counterNames[i]);
+			}
+		}
+		fputc('}', out);
+	}
+	if (opts->eventStats) {
+		fputs(", \"breakdown\": {", out);
+		enum mTimingHostCategory category;
+		for (category = 0; category < mTIMING_HOST_MAX; ++category) {
+			fprintf(out, "%s\"%s\": %" PRIu64, category ? ", " : "", mTimingHostCategoryName(category), result->hostTime[category] / 1000);
+		}
+		fprintf(out, "}, \"cycles\": %" PRIu64 ", \"waits\": {", result->cycles);
+		bool first = true;
+		unsigned region;
+		for (region = 0; region < mTIMING_WAIT_REGIONS; ++region) {
+			if (!_waitCycles(result, region)) {
+				continue;
+			}
+			fprintf(out, "%s\"%02X\": {", first ? "" : ", ", region);
+			first = false;
+			enum mTimingWaitAccess access;
+			for (access = 0; access < mTIMING_WAIT_MAX; ++access) {
+				fprintf(out, "%s\"%s\": %" PRIu64, access ? ", " : "", mTimingWaitAccessName(access), result->waitCycles[region][access]);
+			}
+			fputc('}', out);
+		}
+		fputs("}, \"events\": {", out);
+		size_t i;
+		for (i = 0; i < mTimingEventStatsListSize(&result->events); ++i) {
+			const struct mTimingEventStats* stats = mTimingEventStatsListGetConstPointer(&result->events, i);
+			if (i) {
+				fputs(", ", out);
+			}
+			_writeJSONString(out, stats->name);
+			fprintf(out, ": %" PRIu64, stats->hostTime / 1000);
+		}
+		fputc('}', out);
+	}
+
+	if (job->golden[0]) {
+		fputs(", \"frame_hashes\": {\"golden\": ", out);
+		_writeJSONString(out, job->golden);
+		if (opts->recordGolden) {
+			fprintf(out, ", \"recorded\": %s}", job->hashesMatch ? "true" : "false");
+		} else {
+			fprintf(out, ", \"frames\": %" PRIz "u, \"mismatches\": %" PRIz "u, \"first_mismatch\": %i}",
+			        job->hashCheck.frames, job->hashCheck.mismatches, job->hashCheck.firstMismatch);
+		}
+	}
+
+	bool regressed = false;
+	const struct PerfBaseline* base = baseline ? HashTableLookup(baseline, job->name) : NULL;
+	if (base) {
+		regressed = _isRegression(job, fps, p99, base, opts->threshold);
+		fprintf(out, ", \"baseline\": {\"fps\": %.3f, \"p99\": %.1f}, \"regression\": %s", base->fps, base->p99, regressed ? "true" : "false");
+	}
+	fputc('}', out);
+	return !regressed && job->hashesMatch;
+}
+
+static bool _mPerfRunBatch(const struct mArguments* args, const struct PerfOpts* perfOpts) {
+	struct PerfBatch batch = {
+		.args = args,
+		.opts = perfOpts,
+		.nextJob = 0
+	};
+	PerfJobListInit(&batch.jobs, 0);
+	bool success = _loadManifest(perfOpts->manifest, perfOpts, &batch.jobs);
+
+	struct Table baseline;
+	HashTableInit(&baseline, 0, free);
+	if (success && perfOpts->baseline) {
+		success = _loadBaseline(perfOpts->baseline, &baseline);
+	}
+	FILE* out = stdout;
+	if (success && perfOpts->output) {
+		out = fopen(perfOpts->output, "w");
+		if (!out) {
+			fprintf(stderr, "Could not open %s\n", perfOpts->output);
+			success = false;
+		}
+	}
+
+	size_t i;
+	for (i = 0; i < PerfJobListSize(&batch.jobs); ++i) {
+		_perfResultInit(&(*PerfJobListGetPointer(&batch.jobs, i))->result);
+	}
+	if (success) {
+#ifndef DISABLE_THREADING
+		// Each worker runs its own core, so there is nothing to share besides the queue
+		size_t nThreads = perfOpts->jobs;
+		if (nThreads > PerfJobListSize(&batch.jobs)) {
+			nThreads = PerfJobListSize(&batch.jobs);
+		}
+		Thread* threads = malloc(sizeof(*threads) * nThreads);
+		size_t started;
+		MutexInit(&batch.mutex);
+		for (started = 0; started < nThreads; ++started) {
+			if (ThreadCreate(&threads[started], _batchWorker, &batch)) {
+				break;
+			}
+		}
+		if (!started) {
+			_batchWorker(&batch);
+		}
+		for (i = 0; i < started; ++i) {
+			ThreadJoin(&threads[i]);
+		}
+		MutexDeinit(&batch.mutex);
+		free(threads);
+#else
+		void* outputBuffer = malloc(256 * 256 * 4);
+		struct PerfJob* job;
+		while ((job = _nextJob(&batch))) {
+			_runJob(&batch, job, outputBuffer);
+		}
+		free(outputBuffer);
+#endif
+
+		fputs("[\n", out);
+		for (i = 0; i < PerfJobListSize(&batch.jobs); ++i) {
+			if (i) {
+				fputs(",\n", out);
+			}
+			struct PerfJob* job = *PerfJobListGetPointer(&batch.jobs, i);
+			if (!_writeJSONResult(out, job, perfOpts, perfOpts->baseline ? &baseline : NULL)) {
+				success = false;
+			}
+		}
+		fputs("\n]\n", out);
+	}
+	if (out && out != stdout) {
+		fclose(out);
+	}
+
+	for (i = 0; i < PerfJobListSize(&batch.jobs); ++i) {
+		struct PerfJob* job = *PerfJobListGetPointer(&batch.jobs, i);
+		_perfResultDeinit(&job->result);
+		free(job->name);
+		free(job);
+	}
+	PerfJobListDeinit(&batch.jobs);
+	HashTableDeinit(&baseline);
+	return success;
+}
+
+// Lines are "FRAME KEYS", with KEYS as a hexadecimal mask that stays held from FRAME onwards
+static bool _loadMovie(const char* path, struct PerfMovie* movie) {
+	struct VFile* vf = VFileOpen(path, O_RDONLY);
+	if (!vf) {
+		fprintf(stderr, "Could not open movie %s\n", path);
+		return false;
+	}
+	char line[128];
+	int lineNumber = 0;
+	bool success = true;
+	while (vf->readline(vf, line, sizeof(line)) > 0) {
+		++lineNumber;
+		char* cursor = line;
+		while (isspace((unsigned char) *cursor)) {
+			++cursor;
+		}
+		if (!*cursor || *cursor == '#') {
+			continue;
+		}
+		char* end;
+		long frame = strtol(cursor, &end, 10);
+		uint32_t keys = strtoul(end, &end, 16);
+		while (isspace((unsigned char) *end)) {
+			++end;
+		}
+		size_t size = PerfMovieSize(movie);
+		if (frame < 0 || *end || (size && PerfMovieGetConstPointer(movie, size - 1)->frame >= frame)) {
+			fprintf(stderr, "%s:%i: expected \"FRAME KEYS\" with frames in increasing order\n", path, lineNumber);
+			success = false;
+			break;
+		}
+		struct PerfMovieEntry* entry = PerfMovieAppend(movie);
+		entry->frame = frame;
+		entry->keys = keys;
+	}
+	vf->close(vf);
+	return success;
+}
+
+static bool _writeFrameHashes(const char* path, const struct PerfFrameHashes* hashes) {
+	struct VFile* vf = VFileOpen(path, O_CREAT | O_TRUNC | O_WRONLY);
+	if (!vf) {
+		fprintf(stderr, "Could not open %s\n", path);
+		return false;
+	}
+	static const char header[] = "# frame video audio\n";
+	bool success = vf->write(vf, header, strlen(header)) == (ssize_t) strlen(header);
+	size_t i;
+	for (i = 0; i < PerfFrameHashesSize(hashes) && success; ++i) {
+		const struct PerfFrameHash* hash = PerfFrameHashesGetConstPointer(hashes, i);
+		char line[64];
+		int length = snprintf(line, sizeof(line), "%" PRIz "u %08X %08X\n", i, hash->video, hash->audio);
+		success = vf->write(vf, line, length) == length;
+	}
+	vf->close(vf);
+	if (!success) {
+		fprintf(stderr, "Could not write %s\n", path);
+	}
+	return success;
+}
+
+static bool _checkFrameHashes(const char* name, const char* path, const struct PerfFrameHashes* hashes, struct PerfHashCheck* check) {
+	check->frames = PerfFrameHashesSize(hashes);
+	check->mismatches = 0;
+	check->firstMismatch = -1;
+	struct VFile* vf = VFileOpen(path, O_RDONLY);
+	if (!vf) {
+		fprintf(stderr, "Could not open golden hashes %s\n", path);
+		return false;
+	}
+	struct PerfFrameHashes golden;
+	PerfFrameHashesInit(&golden, 0);
+	char line[64];
+	while (vf->readline(vf, line, sizeof(line)) > 0) {
+		unsigned long frame;
+		struct PerfFrameHash hash;
+		if (line[0] == '#' || sscanf(line, "%lu %" SCNx32 " %" SCNx32, &frame, &hash.video, &hash.audio) != 3) {
+			continue;
+		}
+		if (frame != PerfFrameHashesSize(&golden)) {
+			fprintf(stderr, "%s: golden hashes skip from frame %" PRIz "u to %lu\n", path, PerfFrameHashesSize(&golden), frame);
+			break;
+		}
+		*PerfFrameHashesAppend(&golden) = hash;
+	}
+	vf->close(vf);
+
+	// Frames missing from either side count against the run too, so a shorter golden can't pass by accident
+	size_t nGolden = PerfFrameHashesSize(&golden);
+	size_t nFrames = check->frames > nGolden ? check->frames : nGolden;
+	size_t i;
+	for (i = 0; i < nFrames; ++i) {
+		const struct PerfFrameHash* expected = i < nGolden ? PerfFrameHashesGetConstPointer(&golden, i) : NULL;
+		const struct PerfFrameHash* actual = i < check->frames ? PerfFrameHashesGetConstPointer(hashes, i) : NULL;
+		if (expected && actual && expected->video == actual->video && expected->audio == actual->audio) {
+			continue;
+		}
+		++check->mismatches;
+		if (check->firstMismatch >= 0) {
+			continue;
+		}
+		check->firstMismatch = i;
+		if (!expected || !actual) {
+			fprintf(stderr, "%s: ran %" PRIz "u frames, but the golden hashes cover %" PRIz "u\n", name, check->frames, nGolden);
+		} else {
+			fprintf(stderr, "%s: frame %" PRIz "u differs, video %08X audio %08X, expected video %08X audio %08X\n",
+			        name, i, actual->video, actual->audio, expected->video, expected->audio);
+		}
+	}
+	if (check->mismatches) {
+		fprintf(stderr, "%s: %" PRIz "u of %" PRIz "u frames differ from %s\n", name, check->mismatches, nFrames, path);
+	}
+	PerfFrameHashesDeinit(&golden);
+	return !check->mismatches;
+}
+
+static uint32_t _drainAudio(struct mCore* core) {
+	int16_t samples[0x1000];
+	uint32_t hash = 0;
+	struct blip_t* left = core->getAudioChannel(core, 0);
+	struct blip_t* right = core->getAudioChannel(core, 1);
+	while (blip_samples_avail(left) > 0) {
+		int count = blip_read_samples(left, samples, sizeof(samples) / sizeof(*samples) / 2, true);
+		blip_read_samples(right, &samples[1], sizeof(samples) / sizeof(*samples) / 2, true);
+		hash = crc32(hash, (const uint8_t*) samples, count * 2 * sizeof(*samples));
+	}
+	return hash;
+}
+
+static uint32_t _hashVideo(struct mCore* core) {
+	unsigned width, height;
+	core->desiredVideoDimensions(core, &width, &height);
+	// A threaded renderer may still be catching up when the frame ends, and asking for the pixels waits for it
+	const void* buffer;
+	size_t stride;
+	core->getPixels(core, &buffer, &stride);
+	const color_t* pixels = buffer;
+	uint32_t hash = 0;
+	unsigned y;
+	for (y = 0; y < height; ++y) {
+		hash = crc32(hash, (const uint8_t*) &pixels[y * stride], width * sizeof(*pixels));
+	}
+	return hash;
+}
+
+static void _mPerfRunloop(struct mCore* core, int* frames, bool quiet, bool drainAudio, const struct PerfMovie* movie,
+                          struct PerfFrameTimes* frameTimes, bool hashVideo, struct PerfFrameHashes* hashes) {
 	struct timeval lastEcho;
 	gettimeofday(&lastEcho, 0);
 	int duration = *frames;
 	*frames = 0;
 	int lastFrames = 0;
+	size_t nextInput = 0;
 	while (!_dispatchExiting) {
-		core->runFrame(core);
+		while (movie && nextInput < PerfMovieSize(movie) && PerfMovieGetConstPointer(movie, nextInput)->frame <= *frames) {
+			core->setKeys(core, PerfMovieGetConstPointer(movie, nextInput)->keys);
+			++nextInput;
+		}
+		if (frameTimes) {
+			uint64_t start = _statsClock();
+			core->runFrame(core);
+			*PerfFrameTimesAppend(frameTimes) = _statsClock() - start;
+		} else {
+			core->runFrame(core);
+		}
+		if (hashes) {
+			struct PerfFrameHash* hash = PerfFrameHashesAppend(hashes);
+			hash->video = hashVideo ? _hashVideo(core) : 0;
+			// Reading the audio out each frame is the only way to tell which frame a sample belongs to
+			hash->audio = _drainAudio(core);
+		} else if (drainAudio) {
+			// Without a reader, the buffers fill up and synthesis stops early
+			_drainAudio(core);
+		}
 		++*frames;
 		++lastFrames;
 		if (!quiet) {
@@ -318,8 +1306,9 @@ static bool _mPerfRunServer(const struct mArguments* args, const struct PerfOpts
 		return false;
 	}
 	if (perfOpts->csv) {
-		const char* header = "game_code,frames,duration,renderer\n";
+		const char* header = _csvHeader(perfOpts);
 		SocketSend(_socket, header, strlen(header));
+		SocketSend(_socket, "\n", 1);
 	}
 	char path[PATH_MAX];
 	memset(path, 0, sizeof(path));
@@ -355,32 +1344,356 @@ static bool _parsePerfOpts(struct mSubParser* parser, int option, const char* ar
 	struct PerfOpts* opts = parser->opts;
 	errno = 0;
 	switch (option) {
+	case 'A':
+		opts->drainAudio = true;
+		return true;
+	case 'B':
+		opts->videoThreads = strtoul(arg, 0, 10);
+		return !errno;
 	case 'D':
 		opts->server = true;
 		return true;
+	case 'E':
+		opts->eventStats = true;
+		return true;
 	case 'F':
 		opts->frames = strtoul(arg, 0, 10);
 		return !errno;
+	case 'G':
+		opts->recordGolden = true;
+		return true;
+	case 'H':
+		free(opts->golden);
+		opts->golden = strdup(arg);
+		return true;
+	case 'I':
+		free(opts->movie);
+		opts->movie = strdup(arg);
+		return true;
 	case 'N':
 		opts->noVideo = true;
 		return true;
 	case 'P':
 		opts->csv = true;
 		return true;
+#ifdef USE_DEBUGGERS
+	case 'R':
+		free(opts->profile);
+		opts->profile = strdup(arg);
+		return true;
+#endif
 	case 'S':
 		opts->duration = strtoul(arg, 0, 10);
 		return !errno;
 	case 'T':
 		opts->threadedVideo = true;
 		return true;
+	case 'V':
+		opts->rendererOnly = true;
+		return true;
+	case 'K':
+		opts->hardwareCounters = true;
+		return true;
 	case 'L':
 		opts->savestate = strdup(arg);
 		return true;
+	case 'M':
+		free(opts->manifest);
+		opts->manifest = strdup(arg);
+		return true;
+	case 'X':
+		opts->threshold = strtof(arg, 0);
+		return !errno;
+	case 'j':
+		opts->jobs = strtoul(arg, 0, 10);
+		return !errno && opts->jobs;
+	case 'o':
+		free(opts->output);
+		opts->output = strdup(arg);
+		return true;
+	case 'r':
+		free(opts->baseline);
+		opts->baseline = strdup(arg);
+		return true;
 	default:
 		return false;
 	}
 }
 
+static uint64_t _statsClock(void) {
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	if (!clock_gettime(CLOCK_MONOTONIC, &ts)) {
+		return 1000000000LL * ts.tv_sec + ts.tv_nsec;
+	}
+#endif
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return 1000000000LL * tv.tv_sec + 1000LL * tv.tv_usec;
+}
+
+#ifdef PERF_HAS_COUNTERS
+static const struct {
+	uint32_t type;
+	uint64_t config;
+} _counterEvents[PERF_COUNTER_MAX] = {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+};
+#endif
+
+// Counters that can't be opened are left closed; errno is left over from the last one that failed
+static size_t _countersOpen(struct PerfCounters* counters) {
+	size_t opened = 0;
+	size_t i;
+	for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+		counters->fd[i] = -1;
+#ifdef PERF_HAS_COUNTERS
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = _counterEvents[i].type;
+		attr.config = _counterEvents[i].config;
+		attr.disabled = 1;
+		// Leaving out the kernel keeps this usable at the default paranoia level
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		counters->fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if (counters->fd[i] >= 0) {
+			++opened;
+		}
+#endif
+	}
+#ifndef PERF_HAS_COUNTERS
+	errno = ENOSYS;
+#endif
+	return opened;
+}
+
+static void _countersClose(struct PerfCounters* counters) {
+	size_t i;
+	for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+		if (counters->fd[i] >= 0) {
+			close(counters->fd[i]);
+			counters->fd[i] = -1;
+		}
+	}
+}
+
+static void _countersStart(struct PerfCounters* counters) {
+#ifdef PERF_HAS_COUNTERS
+	size_t i;
+	for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+		if (counters->fd[i] >= 0) {
+			ioctl(counters->fd[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(counters->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#else
+	UNUSED(counters);
+#endif
+}
+
+static void _countersStop(struct PerfCounters* counters, struct PerfResult* result) {
+	size_t i;
+	for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+		result->counterValid[i] = false;
+#ifdef PERF_HAS_COUNTERS
+		if (counters->fd[i] < 0) {
+			continue;
+		}
+		ioctl(counters->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+		uint64_t values[3];
+		if (read(counters->fd[i], values, sizeof(values)) != sizeof(values) || !values[2]) {
+			continue;
+		}
+		// The kernel multiplexes counters when there are more than the hardware has, so scale up to the whole run
+		if (values[2] < values[1]) {
+			values[0] = (uint64_t) ((double) values[0] * values[1] / values[2]);
+		}
+		result->counters[i] = values[0];
+		result->counterValid[i] = true;
+#endif
+	}
+	_countersClose(counters);
+}
+
+static void _probeCounters(void) {
+	struct PerfCounters counters;
+	size_t opened = _countersOpen(&counters);
+	if (opened == PERF_COUNTER_MAX) {
+		_countersClose(&counters);
+		return;
+	}
+	if (!opened) {
+		fprintf(stderr, "Hardware counters are unavailable: %s\n", strerror(errno));
+		return;
+	}
+	size_t i;
+	for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+		if (counters.fd[i] < 0) {
+			fprintf(stderr, "Hardware counter %s is unavailable\n", _counterNames[i]);
+		}
+	}
+	_countersClose(&counters);
+}
+
+static void _dumpCounters(const struct PerfResult* result) {
+	if (!result->frames) {
+		return;
+	}
+	printf("%-28s %14s\n", "Hardware counters", "Per frame");
+	size_t i;
+	for (i = 0; i < PERF_COUNTER_MAX; ++i) {
+		if (result->counterValid[i]) {
+			printf("%-28s %14.0f\n", _counterNames[i], (double) result->counters[i] / result->frames);
+		} else {
+			printf("%-28s %14s\n", _counterNames[i], "n/a");
+		}
+	}
+	if (result->counterValid[PERF_COUNTER_CYCLES] && result->counterValid[PERF_COUNTER_INSTRUCTIONS] && result->counters[PERF_COUNTER_CYCLES]) {
+		printf("%-28s %14.2f\n", "ipc", (double) result->counters[PERF_COUNTER_INSTRUCTIONS] / result->counters[PERF_COUNTER_CYCLES]);
+	}
+	printf("\n");
+}
+
+static const char* _csvHeader(const struct PerfOpts* opts) {
+	static char header[512];
+	size_t length = snprintf(header, sizeof(header), "%s", PERF_CSV_HEADER);
+	if (opts->rendererOnly) {
+		length += snprintf(&header[length], sizeof(header) - length, "%s", PERF_RENDERER_CSV_COLUMNS);
+	}
+	if (opts->hardwareCounters) {
+		length += snprintf(&header[length], sizeof(header) - length, "%s", PERF_COUNTER_CSV_COLUMNS);
+	}
+	if (opts->eventStats) {
+		enum mTimingHostCategory category;
+		for (category = 0; category < mTIMING_HOST_MAX; ++category) {
+			length += snprintf(&header[length], sizeof(header) - length, ",%s_time", mTimingHostCategoryName(category));
+		}
+		snprintf(&header[length], sizeof(header) - length, ",wait_cycles,event_times");
+	}
+	return header;
+}
+
+// Emulated cycles actually lost to waits in one region, net of what the prefetcher hid
+static uint64_t _waitCycles(const struct PerfResult* result, unsigned region) {
+	const uint64_t* waits = result->waitCycles[region];
+	uint64_t total = 0;
+	enum mTimingWaitAccess access;
+	for (access = 0; access < mTIMING_WAIT_MAX; ++access) {
+		if (access != mTIMING_WAIT_PREFETCH_HIDDEN) {
+			total += waits[access];
+		}
+	}
+	if (total < waits[mTIMING_WAIT_PREFETCH_HIDDEN]) {
+		return 0;
+	}
+	return total - waits[mTIMING_WAIT_PREFETCH_HIDDEN];
+}
+
+// Host time in microseconds by category, the wait cycles, then "name=time" pairs for each event
+static void _formatBreakdown(const struct PerfResult* result, char* buffer, size_t size) {
+	size_t length = 0;
+	enum mTimingHostCategory category;
+	for (category = 0; category < mTIMING_HOST_MAX && length < size; ++category) {
+		length += snprintf(&buffer[length], size - length, ",%" PRIu64, result->hostTime[category] / 1000);
+	}
+	uint64_t waits = 0;
+	unsigned region;
+	for (region = 0; region < mTIMING_WAIT_REGIONS; ++region) {
+		waits += _waitCycles(result, region);
+	}
+	if (length < size) {
+		length += snprintf(&buffer[length], size - length, ",%" PRIu64 ",\"", waits);
+	}
+	size_t i;
+	for (i = 0; i < mTimingEventStatsListSize(&result->events) && length < size; ++i) {
+		const struct mTimingEventStats* stats = mTimingEventStatsListGetConstPointer(&result->events, i);
+		length += snprintf(&buffer[length], size - length, "%s%s=%" PRIu64, i ? ";" : "", stats->name, stats->hostTime / 1000);
+	}
+	if (length < size) {
+		snprintf(&buffer[length], size - length, "\"");
+	} else if (size > 1) {
+		// Cut short, but still a well-formed field
+		buffer[size - 2] = '"';
+	}
+}
+
+static void _dumpEventStats(const struct PerfResult* result) {
+	uint64_t total = 0;
+	enum mTimingHostCategory category;
+	for (category = 0; category < mTIMING_HOST_MAX; ++category) {
+		total += result->hostTime[category];
+	}
+	printf("%-28s %10s %6s\n", "Host time", "Host ms", "%");
+	for (category = 0; category < mTIMING_HOST_MAX; ++category) {
+		uint64_t time = result->hostTime[category];
+		printf("%-28s %10.2f %6.2f\n", mTimingHostCategoryName(category), time / 1000000.0, total ? time * 100.0 / total : 0.0);
+	}
+	// Event times include any renderer, audio or I/O work done inside them
+	printf("\n");
+
+	// Sequential code fetches between branches aren't counted, so they're part of executing
+	printf("%-8s %12s %12s %12s %12s %12s %12s %6s\n", "Region", "Code N", "Code S", "Data N", "Data S", "Stall", "Hidden", "%");
+	unsigned region;
+	for (region = 0; region < mTIMING_WAIT_REGIONS; ++region) {
+		uint64_t waits = _waitCycles(result, region);
+		if (!waits) {
+			continue;
+		}
+		const uint64_t* cycles = result->waitCycles[region];
+		printf("%02X       %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %6.2f\n", region,
+		       cycles[mTIMING_WAIT_CODE_NONSEQ], cycles[mTIMING_WAIT_CODE_SEQ], cycles[mTIMING_WAIT_DATA_NONSEQ],
+		       cycles[mTIMING_WAIT_DATA_SEQ], cycles[mTIMING_WAIT_PREFETCH_STALL], cycles[mTIMING_WAIT_PREFETCH_HIDDEN],
+		       result->cycles ? waits * 100.0 / result->cycles : 0.0);
+	}
+	printf("\n");
+
+	uint64_t duration = result->duration;
+	size_t nStats = mTimingEventStatsListSize(&result->events);
+	const struct mTimingEventStats** sorted = malloc(sizeof(*sorted) * nStats);
+	size_t i;
+	for (i = 0; i < nStats; ++i) {
+		// Insertion sort by host time, heaviest first; there are only a few dozen names
+		const struct mTimingEventStats* stats = mTimingEventStatsListGetConstPointer(&result->events, i);
+		size_t j;
+		for (j = i; j > 0 && sorted[j - 1]->hostTime < stats->hostTime; --j) {
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = stats;
+	}
+	printf("%-28s %12s %12s %12s %10s %6s\n", "Event", "Fired", "Scheduled", "Rescheduled", "Host ms", "%");
+	for (i = 0; i < nStats; ++i) {
+		const struct mTimingEventStats* stats = sorted[i];
+		printf("%-28s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %10.2f %6.2f\n", stats->name, stats->fired, stats->scheduled, stats->rescheduled,
+		       stats->hostTime / 1000000.0, duration ? stats->hostTime / (duration * 10.0) : 0.0);
+	}
+	free(sorted);
+}
+
+#ifdef USE_DEBUGGERS
+static void _writeProfile(struct mDebuggerProfiler* profiler, const char* path) {
+	struct mCore* core = profiler->core;
+	if (!core->symbolTable) {
+		core->loadSymbols(core, NULL);
+	}
+	struct VFile* vf = VFileOpen(path, O_CREAT | O_TRUNC | O_WRONLY);
+	if (!vf) {
+		fprintf(stderr, "Could not open %s\n", path);
+		return;
+	}
+	if (!mDebuggerProfilerWriteFolded(profiler, vf)) {
+		fprintf(stderr, "Could not write %s\n", path);
+	}
+	vf->close(vf);
+}
+#endif
+
 static void _log(struct mLogger* log, int category, enum mLogLevel level, const char* format, va_list args) {
 	UNUSED(log);
 	UNUSED(category);
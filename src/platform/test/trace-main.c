@@ -0,0 +1,228 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba/core/core.h>
+#include <mgba/internal/debugger/trace.h>
+#ifdef M_CORE_GBA
+#include <mgba/internal/arm/decoder.h>
+#endif
+#ifdef M_CORE_GB
+#include <mgba/internal/sm83/decoder.h>
+#endif
+#include <mgba-util/table.h>
+#include <mgba-util/vfs.h>
+
+#ifdef _MSC_VER
+#include <mgba-util/platform/windows/getopt.h>
+#else
+#include <getopt.h>
+#endif
+
+#include <inttypes.h>
+
+#define TRACE_OPTIONS "p:r"
+#define TRACE_USAGE \
+	"usage: %s [-r] [-p COUNT] TRACE\n" \
+	"  -r          Print the registers that changed before each instruction\n" \
+	"  -p COUNT    Print the COUNT addresses that took the most cycles instead\n"
+
+struct TraceProfileEntry {
+	struct mDebuggerTraceEntry entry;
+	uint64_t count;
+	uint64_t cycles;
+};
+
+static void _disassemble(int platform, const struct mDebuggerTraceEntry* entry, char* out, size_t size) {
+	out[0] = '\0';
+	switch (platform) {
+#ifdef M_CORE_GBA
+	case PLATFORM_GBA: {
+		struct ARMInstructionInfo info;
+		if (entry->opcodeSize == 4) {
+			ARMDecodeARM(entry->opcode, &info);
+		} else {
+			ARMDecodeThumb(entry->opcode, &info);
+		}
+		ARMDisassemble(&info, entry->address + 2 * entry->opcodeSize, out, size);
+		break;
+	}
+#endif
+#ifdef M_CORE_GB
+	case PLATFORM_GB: {
+		struct SM83InstructionInfo info;
+		memset(&info, 0, sizeof(info));
+		unsigned i;
+		for (i = 0; i < entry->opcodeSize; ++i) {
+			SM83Decode(entry->opcode >> (8 * i), &info);
+		}
+		SM83Disassemble(&info, entry->address + entry->opcodeSize, out, size);
+		break;
+	}
+#endif
+	default:
+		break;
+	}
+}
+
+static const char* _registerName(int platform, unsigned reg) {
+	static const char* const armNames[] = {
+		"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+		"r8", "r9", "r10", "r11", "r12", "sp", "lr", "cpsr"
+	};
+	static const char* const sm83Names[] = { "af", "bc", "de", "hl", "sp" };
+	switch (platform) {
+#ifdef M_CORE_GBA
+	case PLATFORM_GBA:
+		if (reg < sizeof(armNames) / sizeof(*armNames)) {
+			return armNames[reg];
+		}
+		break;
+#endif
+#ifdef M_CORE_GB
+	case PLATFORM_GB:
+		if (reg < sizeof(sm83Names) / sizeof(*sm83Names)) {
+			return sm83Names[reg];
+		}
+		break;
+#endif
+	default:
+		break;
+	}
+	UNUSED(armNames);
+	UNUSED(sm83Names);
+	return "?";
+}
+
+static void _printEntry(int platform, const struct mDebuggerTraceEntry* entry, const struct mDebuggerTraceEntry* last, bool registers) {
+	char disassembly[64];
+	_disassemble(platform, entry, disassembly, sizeof(disassembly));
+	printf("%10" PRIu32 " %08X: %0*X  %s", entry->cycles, entry->address, entry->opcodeSize * 2, entry->opcode, disassembly);
+	if (registers) {
+		unsigned i;
+		for (i = 0; i < entry->nRegisters; ++i) {
+			if (!last || entry->registers[i] != last->registers[i]) {
+				printf(" %s=%08X", _registerName(platform, i), entry->registers[i]);
+			}
+		}
+	}
+	putchar('\n');
+}
+
+static void _collectProfile(uint32_t key, void* value, void* user) {
+	UNUSED(key);
+	struct TraceProfileEntry*** cursor = user;
+	**cursor = value;
+	++*cursor;
+}
+
+static int _compareProfile(const void* a, const void* b) {
+	const struct TraceProfileEntry* left = *(const struct TraceProfileEntry* const*) a;
+	const struct TraceProfileEntry* right = *(const struct TraceProfileEntry* const*) b;
+	if (left->cycles != right->cycles) {
+		return left->cycles < right->cycles ? 1 : -1;
+	}
+	if (left->count != right->count) {
+		return left->count < right->count ? 1 : -1;
+	}
+	return left->entry.address < right->entry.address ? -1 : left->entry.address > right->entry.address;
+}
+
+static void _printProfile(struct mDebuggerTraceReader* reader, size_t top) {
+	struct Table profile;
+	TableInit(&profile, 0, free);
+	struct mDebuggerTraceEntry entry;
+	struct TraceProfileEntry* previous = NULL;
+	uint32_t lastCycles = 0;
+	uint64_t totalCycles = 0;
+	uint64_t totalCount = 0;
+	while (mDebuggerTraceReaderNext(reader, &entry)) {
+		// Cycles spent between two records belong to the instruction that ran in between
+		if (previous) {
+			previous->cycles += entry.cycles - lastCycles;
+			totalCycles += entry.cycles - lastCycles;
+		}
+		struct TraceProfileEntry* hit = TableLookup(&profile, entry.address);
+		if (!hit) {
+			hit = calloc(1, sizeof(*hit));
+			hit->entry = entry;
+			TableInsert(&profile, entry.address, hit);
+		}
+		++hit->count;
+		++totalCount;
+		previous = hit;
+		lastCycles = entry.cycles;
+	}
+
+	size_t size = TableSize(&profile);
+	struct TraceProfileEntry** sorted = malloc(size * sizeof(*sorted));
+	struct TraceProfileEntry** cursor = sorted;
+	TableEnumerate(&profile, _collectProfile, &cursor);
+	qsort(sorted, size, sizeof(*sorted), _compareProfile);
+
+	printf("%" PRIu64 " instructions, %" PRIu64 " cycles, %" PRIz "u addresses\n", totalCount, totalCycles, size);
+	printf("    cycles      count  address\n");
+	size_t i;
+	for (i = 0; i < size && i < top; ++i) {
+		char disassembly[64];
+		_disassemble(reader->header.platform, &sorted[i]->entry, disassembly, sizeof(disassembly));
+		printf("%10" PRIu64 " %10" PRIu64 "  %08X: %s\n", sorted[i]->cycles, sorted[i]->count, sorted[i]->entry.address, disassembly);
+	}
+	free(sorted);
+	TableDeinit(&profile);
+}
+
+int main(int argc, char** argv) {
+	bool registers = false;
+	size_t top = 0;
+	int ch;
+	while ((ch = getopt(argc, argv, TRACE_OPTIONS)) != -1) {
+		switch (ch) {
+		case 'p':
+			top = strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			registers = true;
+			break;
+		default:
+			fprintf(stderr, TRACE_USAGE, argv[0]);
+			return 1;
+		}
+	}
+	if (optind + 1 != argc) {
+		fprintf(stderr, TRACE_USAGE, argv[0]);
+		return 1;
+	}
+
+	struct VFile* vf = VFileOpen(argv[optind], O_RDONLY);
+	if (!vf) {
+		fprintf(stderr, "Could not open %s\n", argv[optind]);
+		return 1;
+	}
+	struct mDebuggerTraceReader* reader = malloc(sizeof(*reader));
+	if (!mDebuggerTraceReaderInit(reader, vf)) {
+		fprintf(stderr, "%s is not a trace\n", argv[optind]);
+		free(reader);
+		vf->close(vf);
+		return 1;
+	}
+	registers = registers && (reader->header.flags & mDEBUGGER_TRACE_REGISTERS);
+
+	if (top) {
+		_printProfile(reader, top);
+	} else {
+		struct mDebuggerTraceEntry entries[2];
+		unsigned current = 0;
+		bool hasLast = false;
+		while (mDebuggerTraceReaderNext(reader, &entries[current])) {
+			_printEntry(reader->header.platform, &entries[current], hasLast ? &entries[current ^ 1] : NULL, registers);
+			hasLast = true;
+			current ^= 1;
+		}
+	}
+
+	free(reader);
+	vf->close(vf);
+	return 0;
+}
@@ -6,6 +6,7 @@
 #include <mgba/internal/sm83/debugger/debugger.h>
 
 #include <mgba/core/core.h>
+#include <mgba/core/timing.h>
 #include <mgba/internal/debugger/parser.h>
 #include <mgba/internal/sm83/decoder.h>
 #include <mgba/internal/sm83/sm83.h>
@@ -30,6 +31,10 @@ static void _destroyBreakpoint(struct mBreakpoint* breakpoint) {
 		parseFree(breakpoint->condition);
 		free(breakpoint->condition);
 	}
+	if (breakpoint->program) {
+		parseProgramFree(breakpoint->program);
+		free(breakpoint->program);
+	}
 }
 
 static void _destroyWatchpoint(struct mWatchpoint* watchpoint) {
@@ -37,6 +42,10 @@ static void _destroyWatchpoint(struct mWatchpoint* watchpoint) {
 		parseFree(watchpoint->condition);
 		free(watchpoint->condition);
 	}
+	if (watchpoint->program) {
+		parseProgramFree(watchpoint->program);
+		free(watchpoint->program);
+	}
 }
 
 static void SM83DebuggerCheckBreakpoints(struct mDebuggerPlatform* d) {
@@ -45,12 +54,8 @@ static void SM83DebuggerCheckBreakpoints(struct mDebuggerPlatform* d) {
 	if (!breakpoint) {
 		return;
 	}
-	if (breakpoint->condition) {
-		int32_t value;
-		int segment;
-		if (!mDebuggerEvaluateParseTree(d->p, breakpoint->condition, &value, &segment) || !(value || segment >= 0)) {
-			return;
-		}
+	if (breakpoint->condition && !mDebuggerCheckCondition(d->p, breakpoint->condition, breakpoint->program)) {
+		return;
 	}
 	struct mDebuggerEntryInfo info = {
 		.address = breakpoint->address,
@@ -72,6 +77,7 @@ static void SM83DebuggerListWatchpoints(struct mDebuggerPlatform*, struct mWatch
 static void SM83DebuggerCheckBreakpoints(struct mDebuggerPlatform*);
 static bool SM83DebuggerHasBreakpoints(struct mDebuggerPlatform*);
 static void SM83DebuggerTrace(struct mDebuggerPlatform*, char* out, size_t* length);
+static void SM83DebuggerTraceEntry(struct mDebuggerPlatform*, struct mDebuggerTraceEntry* entry);
 static bool SM83DebuggerGetRegister(struct mDebuggerPlatform*, const char* name, int32_t* value);
 static bool SM83DebuggerSetRegister(struct mDebuggerPlatform*, const char* name, int32_t value);
 
@@ -88,8 +94,10 @@ struct mDebuggerPlatform* SM83DebuggerPlatformCreate(void) {
 	platform->d.checkBreakpoints = SM83DebuggerCheckBreakpoints;
 	platform->d.hasBreakpoints = SM83DebuggerHasBreakpoints;
 	platform->d.trace = SM83DebuggerTrace;
+	platform->d.traceEntry = SM83DebuggerTraceEntry;
 	platform->d.getRegister = SM83DebuggerGetRegister;
 	platform->d.setRegister = SM83DebuggerSetRegister;
+	platform->d.getRegisterPointer = NULL;
 	platform->printStatus = NULL;
 	return &platform->d;
 }
@@ -133,6 +141,7 @@ static ssize_t SM83DebuggerSetBreakpoint(struct mDebuggerPlatform* d, const stru
 	struct SM83Debugger* debugger = (struct SM83Debugger*) d;
 	struct mBreakpoint* breakpoint = mBreakpointListAppend(&debugger->breakpoints);
 	*breakpoint = *info;
+	breakpoint->program = mDebuggerCompileCondition(d->p, info->condition);
 	breakpoint->id = debugger->nextId;
 	++debugger->nextId;
 	return breakpoint->id;
@@ -180,6 +189,7 @@ static ssize_t SM83DebuggerSetWatchpoint(struct mDebuggerPlatform* d, const stru
 	}
 	struct mWatchpoint* watchpoint = mWatchpointListAppend(&debugger->watchpoints);
 	*watchpoint = *info;
+	watchpoint->program = mDebuggerCompileCondition(d->p, info->condition);
 	watchpoint->id = debugger->nextId;
 	++debugger->nextId;
 	return watchpoint->id;
@@ -225,6 +235,33 @@ static void SM83DebuggerTrace(struct mDebuggerPlatform* d, char* out, size_t* le
 		               cpu->sp, cpu->memory.currentSegment(cpu, cpu->pc), cpu->pc, disassembly);
 }
 
+static void SM83DebuggerTraceEntry(struct mDebuggerPlatform* d, struct mDebuggerTraceEntry* entry) {
+	struct SM83Debugger* debugger = (struct SM83Debugger*) d;
+	struct SM83Core* cpu = debugger->cpu;
+
+	struct SM83InstructionInfo info = {{0}};
+	uint16_t address = cpu->pc;
+	size_t bytesRemaining;
+	entry->opcode = 0;
+	entry->opcodeSize = 0;
+	for (bytesRemaining = 1; bytesRemaining && entry->opcodeSize < 4; --bytesRemaining) {
+		uint8_t instruction = d->p->core->rawRead8(d->p->core, address, -1);
+		entry->opcode |= instruction << (8 * entry->opcodeSize);
+		++entry->opcodeSize;
+		++address;
+		bytesRemaining += SM83Decode(instruction, &info);
+	}
+	entry->address = cpu->pc;
+	entry->cycles = mTimingCurrentTime(d->p->core->timing);
+
+	entry->registers[0] = cpu->af;
+	entry->registers[1] = cpu->bc;
+	entry->registers[2] = cpu->de;
+	entry->registers[3] = cpu->hl;
+	entry->registers[4] = cpu->sp;
+	entry->nRegisters = 5;
+}
+
 bool SM83DebuggerGetRegister(struct mDebuggerPlatform* d, const char* name, int32_t* value) {
 	struct SM83Debugger* debugger = (struct SM83Debugger*) d;
 	struct SM83Core* cpu = debugger->cpu;
@@ -48,12 +48,8 @@ static bool _checkWatchpoints(struct SM83Debugger* debugger, uint16_t address, s
 	for (i = 0; i < mWatchpointListSize(&debugger->watchpoints); ++i) {
 		watchpoint = mWatchpointListGetPointer(&debugger->watchpoints, i);
 		if (watchpoint->address == address && (watchpoint->segment < 0 || watchpoint->segment == debugger->originalMemory.currentSegment(debugger->cpu, address)) && watchpoint->type & type) {
-			if (watchpoint->condition) {
-				int32_t value;
-				int segment;
-				if (!mDebuggerEvaluateParseTree(debugger->d.p, watchpoint->condition, &value, &segment) || !(value || segment >= 0)) {
-					return false;
-				}
+			if (watchpoint->condition && !mDebuggerCheckCondition(debugger->d.p, watchpoint->condition, watchpoint->program)) {
+				return false;
 			}
 			info->type.wp.oldValue = debugger->originalMemory.load8(debugger->cpu, address);
 			info->type.wp.newValue = newValue;
@@ -155,6 +155,19 @@ void SM83Tick(struct SM83Core* cpu) {
 	++cpu->cycles;
 }
 
+// Runs M-cycles back to back while the next event can't land inside the one being run, without the
+// bookkeeping for splitting one around an event. Memory accesses can schedule events, so the distance
+// is checked after every M-cycle instead of once per instruction.
+static void _SM83RunFast(struct SM83Core* cpu) {
+	while (cpu->nextEvent - cpu->cycles > 3) {
+		_SM83Step(cpu);
+		cpu->cycles += 2;
+		cpu->executionState = SM83_CORE_FETCH;
+		cpu->instruction(cpu);
+		++cpu->cycles;
+	}
+}
+
 void SM83Run(struct SM83Core* cpu) {
 	bool running = true;
 	while (running || cpu->executionState != SM83_CORE_FETCH) {
@@ -162,6 +175,10 @@ void SM83Run(struct SM83Core* cpu) {
 			cpu->irqh.processEvents(cpu);
 			break;
 		}
+		_SM83RunFast(cpu);
+		if (cpu->cycles >= cpu->nextEvent) {
+			continue;
+		}
 		_SM83Step(cpu);
 		if (cpu->cycles + 2 >= cpu->nextEvent) {
 			int32_t diff = cpu->nextEvent - cpu->cycles;
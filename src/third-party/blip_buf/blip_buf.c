@@ -22,6 +22,17 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 	#include "blargg_test.h"
 #endif
 
+/* The synthesis kernel is vectorized when the target guarantees SSE2 or NEON.
+Define BLIP_NO_SIMD to force the portable version. */
+#if defined (BLIP_NO_SIMD)
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BLIP_SSE2 1
+	#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+	#define BLIP_NEON 1
+	#include <arm_neon.h>
+#endif
+
 /* Equivalent to ULONG_MAX >= 0xFFFFFFFF00000000.
 Avoids constants that don't fit in 32 bits. */
 #if ULONG_MAX/0xFFFFFFFF > 0xFFFFFFFF
@@ -308,6 +319,63 @@ void blip_add_delta( blip_t* m, unsigned time, int delta )
 	/* Fails if buffer size was exceeded */
 	assert( out <= &SAMPLES( m ) [m->size + end_frame_extra] );
 	
+#if defined (BLIP_SSE2)
+	{
+		/* SSE2 has no 32-bit multiply, so split each delta into 16-bit halves
+		and let pmaddwd pair every kernel tap with its neighbor phase's tap.
+		The products wrap exactly like the scalar ones. */
+		short const delta_lo  = (short) delta;
+		short const delta2_lo = (short) delta2;
+		__m128i const lo = _mm_unpacklo_epi16( _mm_set1_epi16( delta_lo ), _mm_set1_epi16( delta2_lo ) );
+		__m128i const hi = _mm_unpacklo_epi16( _mm_set1_epi16( (short) ((delta - delta_lo) >> 16) ),
+				_mm_set1_epi16( (short) ((delta2 - delta2_lo) >> 16) ) );
+		__m128i fwd  = _mm_loadu_si128( (__m128i const*) in );
+		__m128i fwd2 = _mm_loadu_si128( (__m128i const*) (in + half_width) );
+		__m128i bwd  = _mm_loadu_si128( (__m128i const*) rev );
+		__m128i bwd2 = _mm_loadu_si128( (__m128i const*) (rev - half_width) );
+		__m128i taps [4];
+		int i;
+		
+		/* The second half of the kernel runs backwards through its phase */
+		bwd  = _mm_shufflehi_epi16( _mm_shufflelo_epi16( bwd,  _MM_SHUFFLE( 0, 1, 2, 3 ) ), _MM_SHUFFLE( 0, 1, 2, 3 ) );
+		bwd  = _mm_shuffle_epi32( bwd,  _MM_SHUFFLE( 1, 0, 3, 2 ) );
+		bwd2 = _mm_shufflehi_epi16( _mm_shufflelo_epi16( bwd2, _MM_SHUFFLE( 0, 1, 2, 3 ) ), _MM_SHUFFLE( 0, 1, 2, 3 ) );
+		bwd2 = _mm_shuffle_epi32( bwd2, _MM_SHUFFLE( 1, 0, 3, 2 ) );
+		
+		taps [0] = _mm_unpacklo_epi16( fwd, fwd2 );
+		taps [1] = _mm_unpackhi_epi16( fwd, fwd2 );
+		taps [2] = _mm_unpacklo_epi16( bwd, bwd2 );
+		taps [3] = _mm_unpackhi_epi16( bwd, bwd2 );
+		for ( i = 0; i < 4; ++i )
+		{
+			__m128i sum = _mm_add_epi32( _mm_madd_epi16( taps [i], lo ),
+					_mm_slli_epi32( _mm_madd_epi16( taps [i], hi ), 16 ) );
+			__m128i* dst = (__m128i*) (out + i * 4);
+			_mm_storeu_si128( dst, _mm_add_epi32( _mm_loadu_si128( dst ), sum ) );
+		}
+	}
+#elif defined (BLIP_NEON)
+	{
+		int16x8_t fwd  = vld1q_s16( in );
+		int16x8_t fwd2 = vld1q_s16( in + half_width );
+		int16x8_t bwd  = vrev64q_s16( vld1q_s16( rev ) );
+		int16x8_t bwd2 = vrev64q_s16( vld1q_s16( rev - half_width ) );
+		int32x4_t acc;
+		
+		/* The second half of the kernel runs backwards through its phase */
+		bwd  = vcombine_s16( vget_high_s16( bwd ),  vget_low_s16( bwd ) );
+		bwd2 = vcombine_s16( vget_high_s16( bwd2 ), vget_low_s16( bwd2 ) );
+		
+		acc = vmlaq_n_s32( vld1q_s32( out ), vmovl_s16( vget_low_s16( fwd ) ), delta );
+		vst1q_s32( out, vmlaq_n_s32( acc, vmovl_s16( vget_low_s16( fwd2 ) ), delta2 ) );
+		acc = vmlaq_n_s32( vld1q_s32( out + 4 ), vmovl_s16( vget_high_s16( fwd ) ), delta );
+		vst1q_s32( out + 4, vmlaq_n_s32( acc, vmovl_s16( vget_high_s16( fwd2 ) ), delta2 ) );
+		acc = vmlaq_n_s32( vld1q_s32( out + 8 ), vmovl_s16( vget_low_s16( bwd ) ), delta );
+		vst1q_s32( out + 8, vmlaq_n_s32( acc, vmovl_s16( vget_low_s16( bwd2 ) ), delta2 ) );
+		acc = vmlaq_n_s32( vld1q_s32( out + 12 ), vmovl_s16( vget_high_s16( bwd ) ), delta );
+		vst1q_s32( out + 12, vmlaq_n_s32( acc, vmovl_s16( vget_high_s16( bwd2 ) ), delta2 ) );
+	}
+#else
 	out [0] += in[0]*delta + in[half_width+0]*delta2;
 	out [1] += in[1]*delta + in[half_width+1]*delta2;
 	out [2] += in[2]*delta + in[half_width+2]*delta2;
@@ -326,6 +394,7 @@ void blip_add_delta( blip_t* m, unsigned time, int delta )
 	out [13] += in[2]*delta + in[2-half_width]*delta2;
 	out [14] += in[1]*delta + in[1-half_width]*delta2;
 	out [15] += in[0]*delta + in[0-half_width]*delta2;
+#endif
 }
 
 void blip_add_delta_fast( blip_t* m, unsigned time, int delta )
@@ -342,3 +411,14 @@ void blip_add_delta_fast( blip_t* m, unsigned time, int delta )
 	out [7] += delta * delta_unit - delta2;
 	out [8] += delta2;
 }
+
+void blip_add_delta_nearest( blip_t* m, unsigned time, int delta )
+{
+	unsigned fixed = (unsigned) ((time * m->factor + m->offset) >> pre_shift);
+	buf_t* out = SAMPLES( m ) + m->avail + ((fixed + (1 << (frac_bits - 1))) >> frac_bits);
+	
+	/* Fails if buffer size was exceeded */
+	assert( out <= &SAMPLES( m ) [m->size + end_frame_extra] + 1 );
+	
+	out [7] += delta * delta_unit;
+}
@@ -31,6 +31,14 @@ struct ELF* ELFOpen(struct VFile* vf) {
 	if (!vf) {
 		return NULL;
 	}
+	// Every ROM gets asked whether it's an ELF, so turn the rest away before mapping them whole
+	char magic[SELFMAG];
+	off_t position = vf->seek(vf, 0, SEEK_CUR);
+	bool isELF = vf->seek(vf, 0, SEEK_SET) >= 0 && vf->read(vf, magic, SELFMAG) == SELFMAG && !memcmp(magic, ELFMAG, SELFMAG);
+	vf->seek(vf, position, SEEK_SET);
+	if (!isELF) {
+		return NULL;
+	}
 	size_t size = vf->size(vf);
 	char* memory = vf->map(vf, size, MAP_READ);
 	if (!memory) {
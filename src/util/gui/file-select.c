@@ -10,6 +10,7 @@
 #include <mgba-util/vfs.h>
 
 #include <stdlib.h>
+#include <time.h>
 
 #define ITERATION_SIZE 5
 #define SCANNING_THRESHOLD_1 50
@@ -19,6 +20,20 @@
 #else
 #define SCANNING_THRESHOLD_2 50
 #endif
+#define LISTING_CACHE_SIZE 4
+
+// Filtered listings of recently visited directories, reused as long as the directory hasn't changed
+struct GUIFileListing {
+	char* path;
+	int64_t mtime;
+	bool (*filterName)(const char* name);
+	bool (*filterContents)(struct VFile*);
+	struct GUIMenuItemList items;
+	unsigned lastUsed;
+};
+
+static struct GUIFileListing _listings[LISTING_CACHE_SIZE];
+static unsigned _listingClock;
 
 static void _cleanFiles(struct GUIMenuItemList* currentFiles) {
 	size_t size = GUIMenuItemListSize(currentFiles);
@@ -47,9 +62,94 @@ static int _strpcmp(const void* a, const void* b) {
 	return strcasecmp(((const struct GUIMenuItem*) a)->title, ((const struct GUIMenuItem*) b)->title);
 }
 
+static void _copyFiles(struct GUIMenuItemList* dest, const struct GUIMenuItemList* source, size_t start) {
+	size_t size = GUIMenuItemListSize(source);
+	size_t i;
+	for (i = start; i < size; ++i) {
+		const struct GUIMenuItem* item = GUIMenuItemListGetConstPointer(source, i);
+		*GUIMenuItemListAppend(dest) = (struct GUIMenuItem) { .title = strdup(item->title), .data = item->data };
+	}
+}
+
+static void _clearListing(struct GUIFileListing* listing) {
+	size_t i;
+	for (i = 0; i < GUIMenuItemListSize(&listing->items); ++i) {
+		free((char*) GUIMenuItemListGetPointer(&listing->items, i)->title);
+	}
+	GUIMenuItemListDeinit(&listing->items);
+	free(listing->path);
+	listing->path = NULL;
+}
+
+static struct GUIFileListing* _findListing(const char* path, int64_t mtime, bool (*filterName)(const char* name), bool (*filterContents)(struct VFile*)) {
+	size_t i;
+	for (i = 0; i < LISTING_CACHE_SIZE; ++i) {
+		struct GUIFileListing* listing = &_listings[i];
+		if (!listing->path || strcmp(listing->path, path) != 0) {
+			continue;
+		}
+		if (listing->mtime != mtime || listing->filterName != filterName || listing->filterContents != filterContents) {
+			_clearListing(listing);
+			return NULL;
+		}
+		listing->lastUsed = ++_listingClock;
+		return listing;
+	}
+	return NULL;
+}
+
+static void _storeListing(const char* path, int64_t mtime, bool (*filterName)(const char* name), bool (*filterContents)(struct VFile*), const struct GUIMenuItemList* files) {
+	struct GUIFileListing* listing = &_listings[0];
+	size_t i;
+	for (i = 1; i < LISTING_CACHE_SIZE && listing->path; ++i) {
+		if (!_listings[i].path || _listings[i].lastUsed < listing->lastUsed) {
+			listing = &_listings[i];
+		}
+	}
+	if (listing->path) {
+		_clearListing(listing);
+	}
+	listing->path = strdup(path);
+	listing->mtime = mtime;
+	listing->filterName = filterName;
+	listing->filterContents = filterContents;
+	listing->lastUsed = ++_listingClock;
+	GUIMenuItemListInit(&listing->items, GUIMenuItemListSize(files));
+	// The first item is "(Up)", which isn't owned by the list
+	_copyFiles(&listing->items, files, 1);
+}
+
+void GUISelectFileClearCache(void) {
+	size_t i;
+	for (i = 0; i < LISTING_CACHE_SIZE; ++i) {
+		if (_listings[i].path) {
+			_clearListing(&_listings[i]);
+		}
+	}
+}
+
 static bool _refreshDirectory(struct GUIParams* params, const char* currentPath, struct GUIMenuItemList* currentFiles, bool (*filterName)(const char* name), bool (*filterContents)(struct VFile*), const char* preselect) {
 	_cleanFiles(currentFiles);
 
+	// Read before listing, so that anything changing while the listing is made invalidates it
+	int64_t mtime = VDirModificationTime(currentPath);
+	struct GUIFileListing* listing = NULL;
+	if (mtime) {
+		listing = _findListing(currentPath, mtime, filterName, filterContents);
+	}
+	if (listing) {
+		*GUIMenuItemListAppend(currentFiles) = (struct GUIMenuItem) { .title = "(Up)" };
+		_copyFiles(currentFiles, &listing->items, 0);
+		size_t item;
+		for (item = 1; preselect && item < GUIMenuItemListSize(currentFiles); ++item) {
+			if (strncmp(GUIMenuItemListGetPointer(currentFiles, item)->title, preselect, PATH_MAX) == 0) {
+				params->fileIndex = item;
+				break;
+			}
+		}
+		return true;
+	}
+
 	struct VDir* dir = VDirOpen(currentPath);
 	if (!dir) {
 		return false;
@@ -83,7 +183,9 @@ static bool _refreshDirectory(struct GUIParams* params, const char* currentPath,
 		if (name[0] == '.') {
 			continue;
 		}
-		if (de->type(de) == VFS_DIRECTORY) {
+		// Finding the type can mean a stat, so only do it once
+		enum VFSType type = de->type(de);
+		if (type == VFS_DIRECTORY) {
 			size_t len = strlen(name) + 2;
 			char* n2 = malloc(len);
 			snprintf(n2, len, "%s/", name);
@@ -91,7 +193,7 @@ static bool _refreshDirectory(struct GUIParams* params, const char* currentPath,
 		} else {
 			name = strdup(name);
 		}
-		*GUIMenuItemListAppend(currentFiles) = (struct GUIMenuItem) { .title = name, .data = (void*) de->type(de) };
+		*GUIMenuItemListAppend(currentFiles) = (struct GUIMenuItem) { .title = name, .data = (void*) type };
 		++items;
 	}
 	qsort(GUIMenuItemListGetPointer(currentFiles, 1), GUIMenuItemListSize(currentFiles) - 1, sizeof(struct GUIMenuItem), _strpcmp);
@@ -152,6 +254,11 @@ static bool _refreshDirectory(struct GUIParams* params, const char* currentPath,
 	}
 	dir->close(dir);
 
+	// Modification times only have a resolution of a second, so a directory changed this very
+	// second could change again without its time moving
+	if (mtime && mtime < time(NULL)) {
+		_storeListing(currentPath, mtime, filterName, filterContents, currentFiles);
+	}
 	return true;
 }
 
@@ -105,3 +105,91 @@ uint32_t hash32(const void* key, int len, uint32_t seed) {
 
   return h1;
 } 
+
+//-----------------------------------------------------------------------------
+// xxHash64, by Yann Collet, BSD 2-clause license. Four independent lanes keep
+// the pipeline full on large inputs, such as whole memory regions.
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64 ( uint64_t x, int r ) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static FORCE_INLINE uint64_t getblock64 ( const uint8_t * p ) {
+  uint32_t lo, hi;
+  LOAD_32LE(lo, 0, p);
+  LOAD_32LE(hi, 4, p);
+  return ((uint64_t) hi << 32) | lo;
+}
+
+static FORCE_INLINE uint64_t round64 ( uint64_t acc, uint64_t input ) {
+  acc += input * PRIME64_2;
+  acc = rotl64(acc, 31);
+  return acc * PRIME64_1;
+}
+
+static FORCE_INLINE uint64_t merge64 ( uint64_t acc, uint64_t val ) {
+  acc ^= round64(0, val);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t hash64(const void* key, size_t len, uint64_t seed) {
+  const uint8_t * data = (const uint8_t*)key;
+  const uint8_t * end = data + len;
+  uint64_t h;
+
+  if (len >= 32) {
+    const uint8_t * limit = end - 32;
+    uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+    uint64_t v2 = seed + PRIME64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME64_1;
+
+    do {
+      v1 = round64(v1, getblock64(data));
+      v2 = round64(v2, getblock64(data + 8));
+      v3 = round64(v3, getblock64(data + 16));
+      v4 = round64(v4, getblock64(data + 24));
+      data += 32;
+    } while (data <= limit);
+
+    h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h = merge64(h, v1);
+    h = merge64(h, v2);
+    h = merge64(h, v3);
+    h = merge64(h, v4);
+  } else {
+    h = seed + PRIME64_5;
+  }
+
+  h += len;
+
+  for (; data + 8 <= end; data += 8) {
+    h ^= round64(0, getblock64(data));
+    h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+  }
+  if (data + 4 <= end) {
+    uint32_t k;
+    LOAD_32LE(k, 0, data);
+    h ^= k * PRIME64_1;
+    h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+    data += 4;
+  }
+  for (; data < end; ++data) {
+    h ^= *data * PRIME64_5;
+    h = rotl64(h, 11) * PRIME64_1;
+  }
+
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+
+  return h;
+}
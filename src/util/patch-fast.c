@@ -5,6 +5,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include <mgba-util/patch/fast.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define PATCH_FAST_EXTENT_BYTES (PATCH_FAST_EXTENT * 4)
+
 DEFINE_VECTOR(PatchFastExtents, struct PatchFastExtent);
 
 size_t _fastOutputSize(struct Patch* patch, size_t inSize);
@@ -12,6 +20,8 @@ bool _fastApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* o
 
 void initPatchFast(struct PatchFast* patch) {
 	PatchFastExtentsInit(&patch->extents, 32);
+	patch->d.hasInputCrc32 = false;
+	patch->d.hasOutputCrc32 = false;
 	patch->d.outputSize = _fastOutputSize;
 	patch->d.applyPatch = _fastApplyPatch;
 }
@@ -20,67 +30,86 @@ void deinitPatchFast(struct PatchFast* patch) {
 	PatchFastExtentsDeinit(&patch->extents);
 }
 
+static bool _diffBlock(const uint8_t* a, const uint8_t* b, uint32_t* out) {
+#if defined(__SSE2__)
+	__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*) a), _mm_loadu_si128((const __m128i*) b));
+	_mm_storeu_si128((__m128i*) out, x);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) != 0xFFFF;
+#elif defined(__ARM_NEON)
+	uint32x4_t x = veorq_u32(vld1q_u32((const uint32_t*) a), vld1q_u32((const uint32_t*) b));
+	vst1q_u32(out, x);
+	uint32x2_t folded = vorr_u32(vget_low_u32(x), vget_high_u32(x));
+	return vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1);
+#else
+	const uint32_t* a32 = (const uint32_t*) a;
+	const uint32_t* b32 = (const uint32_t*) b;
+	out[0] = a32[0] ^ b32[0];
+	out[1] = a32[1] ^ b32[1];
+	out[2] = a32[2] ^ b32[2];
+	out[3] = a32[3] ^ b32[3];
+	return out[0] | out[1] | out[2] | out[3];
+#endif
+}
+
+static void _applyExtent(uint8_t* out, const uint8_t* in, const uint8_t* extent, size_t length) {
+	size_t off;
+	for (off = 0; off < (length & ~15); off += 16) {
+#if defined(__SSE2__)
+		__m128i x = _mm_loadu_si128((const __m128i*) &extent[off]);
+		_mm_storeu_si128((__m128i*) &out[off], _mm_xor_si128(_mm_loadu_si128((const __m128i*) &in[off]), x));
+#elif defined(__ARM_NEON)
+		vst1q_u8(&out[off], veorq_u8(vld1q_u8(&in[off]), vld1q_u8(&extent[off])));
+#else
+		uint32_t* o32 = (uint32_t*) &out[off];
+		const uint32_t* i32 = (const uint32_t*) &in[off];
+		const uint32_t* e32 = (const uint32_t*) &extent[off];
+		o32[0] = i32[0] ^ e32[0];
+		o32[1] = i32[1] ^ e32[1];
+		o32[2] = i32[2] ^ e32[2];
+		o32[3] = i32[3] ^ e32[3];
+#endif
+	}
+	for (; off < length; ++off) {
+		out[off] = in[off] ^ extent[off];
+	}
+}
+
+// Every extent takes up the same amount of memory no matter how long it is, so an extent is
+// carried across unchanged data (stored as zeroes) for as long as the next change still fits
+static struct PatchFastExtent* _extendExtent(struct PatchFast* patch, struct PatchFastExtent* extent, size_t off, size_t length) {
+	if (extent && off + length - extent->offset <= PATCH_FAST_EXTENT_BYTES) {
+		memset((uint8_t*) extent->extent + extent->length, 0, off - extent->offset - extent->length);
+		extent->length = off + length - extent->offset;
+		return extent;
+	}
+	extent = PatchFastExtentsAppend(&patch->extents);
+	extent->offset = off;
+	extent->length = length;
+	return extent;
+}
+
 bool diffPatchFast(struct PatchFast* patch, const void* restrict in, const void* restrict out, size_t size) {
 	PatchFastExtentsClear(&patch->extents);
-	const uint32_t* iptr = in;
-	const uint32_t* optr = out;
-	size_t extentOff = 0;
+	const uint8_t* iptr = in;
+	const uint8_t* optr = out;
 	struct PatchFastExtent* extent = NULL;
+	uint32_t block[4];
 	size_t off;
 	for (off = 0; off < (size & ~15); off += 16) {
-		uint32_t a = iptr[0] ^ optr[0];
-		uint32_t b = iptr[1] ^ optr[1];
-		uint32_t c = iptr[2] ^ optr[2];
-		uint32_t d = iptr[3] ^ optr[3];
-		iptr += 4;
-		optr += 4;
-		if (a | b | c | d) {
-			if (!extent) {
-				extent = PatchFastExtentsAppend(&patch->extents);
-				extent->offset = off;
-				extentOff = 0;
-			}
-			extent->extent[extentOff] = a;
-			extent->extent[extentOff + 1] = b;
-			extent->extent[extentOff + 2] = c;
-			extent->extent[extentOff + 3] = d;
-			extentOff += 4;
-			if (extentOff == PATCH_FAST_EXTENT) {
-				extent->length = extentOff * 4;
-				extent = NULL;
-			}
-		} else if (extent) {
-			extent->length = extentOff * 4;
-			extent = NULL;
+		if (!_diffBlock(&iptr[off], &optr[off], block)) {
+			continue;
 		}
+		extent = _extendExtent(patch, extent, off, 16);
+		memcpy((uint8_t*) extent->extent + off - extent->offset, block, 16);
 	}
-	if (extent) {
-		extent->length = extentOff * 4;
-		extent = NULL;
-	}
-	const uint32_t* iptr8 = iptr;
-	const uint32_t* optr8 = optr;
 	for (; off < size; ++off) {
-		uint8_t a = iptr8[0] ^ optr8[0];
-		++iptr8;
-		++optr8;
-		if (a) {
-			if (!extent) {
-				extent = PatchFastExtentsAppend(&patch->extents);
-				extent->offset = off;
-			}
-			((uint8_t*) extent->extent)[extentOff] = a;
-			++extentOff;
-		} else if (extent) {
-			extent->length = extentOff;
-			extent = NULL;
+		uint8_t a = iptr[off] ^ optr[off];
+		if (!a) {
+			continue;
 		}
+		extent = _extendExtent(patch, extent, off, 1);
+		((uint8_t*) extent->extent)[off - extent->offset] = a;
 	}
-	if (extent) {
-		extent->length = extentOff;
-		extent = NULL;
-	}
-
 	return true;
 }
 
@@ -94,37 +123,23 @@ bool _fastApplyPatch(struct Patch* p, const void* in, size_t inSize, void* out,
 	if (inSize != outSize) {
 		return false;
 	}
-	const uint32_t* iptr = in;
-	uint32_t* optr = out;
+	const uint8_t* iptr = in;
+	uint8_t* optr = out;
 	size_t lastWritten = 0;
 	size_t s;
 	for (s = 0; s < PatchFastExtentsSize(&patch->extents); ++s) {
 		struct PatchFastExtent* extent = PatchFastExtentsGetPointer(&patch->extents, s);
-		if (extent->length + extent->offset > outSize) {
+		if (extent->offset < lastWritten || extent->length + extent->offset > outSize) {
 			return false;
 		}
-		memcpy(optr, iptr, extent->offset - lastWritten);
-		optr = (uint32_t*) out + extent->offset / 4;
-		iptr = (uint32_t*) in + extent->offset / 4;
-		uint32_t* eptr = extent->extent;
-		size_t off;
-		for (off = 0; off < (extent->length & ~15); off += 16) {
-			optr[0] = iptr[0] ^ eptr[0];
-			optr[1] = iptr[1] ^ eptr[1];
-			optr[2] = iptr[2] ^ eptr[2];
-			optr[3] = iptr[3] ^ eptr[3];
-			optr += 4;
-			iptr += 4;
-			eptr += 4;
+		if (optr != iptr) {
+			memcpy(&optr[lastWritten], &iptr[lastWritten], extent->offset - lastWritten);
 		}
-		for (; off < extent->length; ++off) {
-			*(uint8_t*) optr = *(uint8_t*) iptr ^ *(uint8_t*) eptr;
-			++optr;
-			++iptr;
-			++eptr;
-		}
-		lastWritten = extent->offset + off;
+		_applyExtent(&optr[extent->offset], &iptr[extent->offset], (const uint8_t*) extent->extent, extent->length);
+		lastWritten = extent->offset + extent->length;
+	}
+	if (optr != iptr) {
+		memcpy(&optr[lastWritten], &iptr[lastWritten], outSize - lastWritten);
 	}
-	memcpy(optr, iptr, outSize - lastWritten);
 	return true;
 }
@@ -43,51 +43,60 @@ size_t _IPSOutputSize(struct Patch* patch, size_t inSize) {
 	return 16 * 1024 * 1024; // IPS patches can grow up to 16MiB, but not beyond
 }
 
-bool _IPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize) {
-	if (patch->vf->seek(patch->vf, 5, SEEK_SET) != 5) {
-		return false;
-	}
-	memcpy(out, in, inSize > outSize ? outSize : inSize);
-	uint8_t* buf = out;
-
+static bool _IPSApply(const uint8_t* data, size_t filesize, uint8_t* buf, size_t outSize) {
+	size_t cursor = 5;
 	while (true) {
-		uint32_t offset = 0;
-		uint16_t size = 0;
-
-		if (patch->vf->read(patch->vf, &offset, 3) != 3) {
+		if (filesize - cursor < 3) {
 			return false;
 		}
-
-		if (offset == 0x464F45) {
+		uint32_t offset = (data[cursor] << 16) | (data[cursor + 1] << 8) | data[cursor + 2];
+		cursor += 3;
+		if (offset == 0x454F46) {
 			return true;
 		}
 
-		offset = (offset >> 16) | (offset & 0xFF00) | ((offset << 16) & 0xFF0000);
-		if (patch->vf->read(patch->vf, &size, 2) != 2) {
+		if (filesize - cursor < 2) {
 			return false;
 		}
+		uint16_t size = (data[cursor] << 8) | data[cursor + 1];
+		cursor += 2;
 		if (!size) {
 			// RLE chunk
-			if (patch->vf->read(patch->vf, &size, 2) != 2) {
-				return false;
-			}
-			size = (size >> 8) | (size << 8);
-			uint8_t byte;
-			if (patch->vf->read(patch->vf, &byte, 1) != 1) {
+			if (filesize - cursor < 3) {
 				return false;
 			}
+			size = (data[cursor] << 8) | data[cursor + 1];
+			uint8_t byte = data[cursor + 2];
+			cursor += 3;
 			if (offset + size > outSize) {
 				return false;
 			}
 			memset(&buf[offset], byte, size);
 		} else {
-			size = (size >> 8) | (size << 8);
-			if (offset + size > outSize) {
-				return false;
-			}
-			if (patch->vf->read(patch->vf, &buf[offset], size) != size) {
+			if (offset + size > outSize || filesize - cursor < size) {
 				return false;
 			}
+			memcpy(&buf[offset], &data[cursor], size);
+			cursor += size;
 		}
 	}
 }
+
+bool _IPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize) {
+	patch->hasOutputCrc32 = false;
+	ssize_t filesize = patch->vf->size(patch->vf);
+	if (filesize < 8) {
+		return false;
+	}
+	// Records are read straight out of a read-only mapping instead of through the VFile
+	const uint8_t* data = patch->vf->map(patch->vf, filesize, MAP_READ);
+	if (!data) {
+		return false;
+	}
+	if (out != in) {
+		memcpy(out, in, inSize > outSize ? outSize : inSize);
+	}
+	bool success = _IPSApply(data, filesize, out, outSize);
+	patch->vf->unmap(patch->vf, (void*) data, filesize);
+	return success;
+}
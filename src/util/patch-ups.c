@@ -20,7 +20,8 @@ static size_t _UPSOutputSize(struct Patch* patch, size_t inSize);
 static bool _UPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize);
 static bool _BPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize);
 
-static size_t _decodeLength(struct VFile* vf);
+static size_t _decodeLength(const uint8_t* data, size_t end, size_t* offset);
+static const uint8_t* _mapPatch(struct Patch* patch, size_t* size);
 
 bool loadPatchUPS(struct Patch* patch) {
 	patch->vf->seek(patch->vf, 0, SEEK_SET);
@@ -56,95 +57,118 @@ bool loadPatchUPS(struct Patch* patch) {
 }
 
 size_t _UPSOutputSize(struct Patch* patch, size_t inSize) {
-	UNUSED(inSize);
+	uint8_t header[32];
 	patch->vf->seek(patch->vf, 4, SEEK_SET);
-	if (_decodeLength(patch->vf) != inSize) {
+	ssize_t size = patch->vf->read(patch->vf, header, sizeof(header));
+	if (size <= 0) {
 		return 0;
 	}
-	return _decodeLength(patch->vf);
+	size_t offset = 0;
+	if (_decodeLength(header, size, &offset) != inSize) {
+		return 0;
+	}
+	return _decodeLength(header, size, &offset);
 }
 
-bool _UPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize) {
-	// TODO: Input checksum
+static bool _UPSApply(struct Patch* patch, const uint8_t* data, size_t filesize, const void* in, size_t inSize, void* out, size_t outSize) {
+	uint32_t expectedInChecksum;
+	uint32_t expectedOutChecksum;
+	LOAD_32LE(expectedInChecksum, filesize + IN_CHECKSUM, data);
+	LOAD_32LE(expectedOutChecksum, filesize + OUT_CHECKSUM, data);
+	if (patch->hasInputCrc32 && patch->inputCrc32 != expectedInChecksum) {
+		return false;
+	}
 
-	size_t filesize = patch->vf->size(patch->vf);
-	patch->vf->seek(patch->vf, 4, SEEK_SET);
-	_decodeLength(patch->vf); // Discard input size
-	if (_decodeLength(patch->vf) != outSize) {
+	size_t end = filesize + IN_CHECKSUM;
+	size_t cursor = 4;
+	_decodeLength(data, end, &cursor); // Discard input size
+	if (_decodeLength(data, end, &cursor) != outSize) {
 		return false;
 	}
 
-	memcpy(out, in, inSize > outSize ? outSize : inSize);
+	if (out != in) {
+		memcpy(out, in, inSize > outSize ? outSize : inSize);
+	}
 
+	// Hunks are XORed into the output directly, so only the pages they cover are written
 	size_t offset = 0;
-	size_t alreadyRead = 0;
 	uint8_t* buf = out;
-	while (alreadyRead < filesize + IN_CHECKSUM) {
-		offset += _decodeLength(patch->vf);
-		uint8_t byte;
-
-		while (true) {
-			if (patch->vf->read(patch->vf, &byte, 1) != 1) {
-				return false;
-			}
-			if (offset >= outSize) {
-				return false;
-			}
-			buf[offset] ^= byte;
-			++offset;
-			if (!byte) {
-				break;
-			}
+	while (cursor < end) {
+		offset += _decodeLength(data, end, &cursor);
+		const uint8_t* hunk = &data[cursor];
+		const uint8_t* terminator = memchr(hunk, 0, end - cursor);
+		if (!terminator) {
+			return false;
+		}
+		size_t length = terminator - hunk + 1;
+		if (offset >= outSize || length > outSize - offset) {
+			return false;
+		}
+		size_t i;
+		for (i = 0; i < length; ++i) {
+			buf[offset + i] ^= hunk[i];
 		}
-		alreadyRead = patch->vf->seek(patch->vf, 0, SEEK_CUR);
+		offset += length;
+		cursor += length;
 	}
 
-	uint32_t goodCrc32;
-	patch->vf->seek(patch->vf, OUT_CHECKSUM, SEEK_END);
-	if (patch->vf->read(patch->vf, &goodCrc32, 4) != 4) {
+	uint32_t outputChecksum = doCrc32(out, outSize);
+	if (outputChecksum != expectedOutChecksum) {
 		return false;
 	}
+	patch->outputCrc32 = outputChecksum;
+	patch->hasOutputCrc32 = true;
+	return true;
+}
 
-	patch->vf->seek(patch->vf, 0, SEEK_SET);
-	if (doCrc32(out, outSize) != goodCrc32) {
+bool _UPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize) {
+	patch->hasOutputCrc32 = false;
+	size_t filesize;
+	const uint8_t* data = _mapPatch(patch, &filesize);
+	if (!data) {
 		return false;
 	}
-	return true;
+	bool success = _UPSApply(patch, data, filesize, in, inSize, out, outSize);
+	patch->vf->unmap(patch->vf, (void*) data, filesize);
+	return success;
 }
 
-bool _BPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize) {
-	patch->vf->seek(patch->vf, IN_CHECKSUM, SEEK_END);
+static bool _BPSApply(struct Patch* patch, const uint8_t* data, size_t filesize, const void* in, size_t inSize, void* out, size_t outSize) {
 	uint32_t expectedInChecksum;
 	uint32_t expectedOutChecksum;
-	patch->vf->read(patch->vf, &expectedInChecksum, sizeof(expectedInChecksum));
-	patch->vf->read(patch->vf, &expectedOutChecksum, sizeof(expectedOutChecksum));
+	LOAD_32LE(expectedInChecksum, filesize + IN_CHECKSUM, data);
+	LOAD_32LE(expectedOutChecksum, filesize + OUT_CHECKSUM, data);
 
-	uint32_t inputChecksum = doCrc32(in, inSize);
+	// The caller usually already has the CRC32 of a freshly loaded ROM
+	uint32_t inputChecksum = patch->hasInputCrc32 ? patch->inputCrc32 : doCrc32(in, inSize);
 	uint32_t outputChecksum = 0;
 
 	if (inputChecksum != expectedInChecksum) {
 		return false;
 	}
 
-	ssize_t filesize = patch->vf->size(patch->vf);
-	patch->vf->seek(patch->vf, 4, SEEK_SET);
-	_decodeLength(patch->vf); // Discard input size
-	if (_decodeLength(patch->vf) != outSize) {
+	size_t end = filesize + IN_CHECKSUM;
+	size_t cursor = 4;
+	_decodeLength(data, end, &cursor); // Discard input size
+	if (_decodeLength(data, end, &cursor) != outSize) {
 		return false;
 	}
 	if (inSize > SSIZE_MAX || outSize > SSIZE_MAX) {
 		return false;
 	}
-	size_t metadataLength = _decodeLength(patch->vf);
-	patch->vf->seek(patch->vf, metadataLength, SEEK_CUR); // Skip metadata
+	size_t metadataLength = _decodeLength(data, end, &cursor);
+	if (metadataLength > end - cursor) {
+		return false;
+	}
+	cursor += metadataLength; // Skip metadata
 	size_t writeLocation = 0;
 	ssize_t readSourceLocation = 0;
 	ssize_t readTargetLocation = 0;
 	size_t readOffset;
 	uint8_t* writeBuffer = out;
 	const uint8_t* readBuffer = in;
-	while (patch->vf->seek(patch->vf, 0, SEEK_CUR) < filesize + IN_CHECKSUM) {
-		size_t command = _decodeLength(patch->vf);
+	while (cursor < end) {
+		size_t command = _decodeLength(data, end, &cursor);
 		size_t length = (command >> 2) + 1;
 		if (writeLocation + length > outSize) {
 			return false;
@@ -153,27 +177,32 @@ bool _BPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* ou
 		switch (command & 0x3) {
 		case 0x0:
 			// SourceRead
+			if (writeLocation + length > inSize) {
+				return false;
+			}
 			memmove(&writeBuffer[writeLocation], &readBuffer[writeLocation], length);
 			outputChecksum = crc32(outputChecksum, &writeBuffer[writeLocation], length);
 			writeLocation += length;
 			break;
 		case 0x1:
 			// TargetRead
-			if (patch->vf->read(patch->vf, &writeBuffer[writeLocation], length) != (ssize_t) length) {
+			if (length > end - cursor) {
 				return false;
 			}
+			memcpy(&writeBuffer[writeLocation], &data[cursor], length);
+			cursor += length;
 			outputChecksum = crc32(outputChecksum, &writeBuffer[writeLocation], length);
 			writeLocation += length;
 			break;
 		case 0x2:
 			// SourceCopy
-			readOffset = _decodeLength(patch->vf);
+			readOffset = _decodeLength(data, end, &cursor);
 			if (readOffset & 1) {
 				readSourceLocation -= readOffset >> 1;
 			} else {
 				readSourceLocation += readOffset >> 1;
 			}
-			if (readSourceLocation < 0 || readSourceLocation > (ssize_t) inSize) {
+			if (readSourceLocation < 0 || (size_t) readSourceLocation + length > inSize) {
 				return false;
 			}
 			memmove(&writeBuffer[writeLocation], &readBuffer[readSourceLocation], length);
@@ -183,7 +212,7 @@ bool _BPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* ou
 			break;
 		case 0x3:
 			// TargetCopy
-			readOffset = _decodeLength(patch->vf);
+			readOffset = _decodeLength(data, end, &cursor);
 			if (readOffset & 1) {
 				readTargetLocation -= readOffset >> 1;
 			} else {
@@ -205,17 +234,43 @@ bool _BPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* ou
 	if (expectedOutChecksum != outputChecksum) {
 		return false;
 	}
+	patch->outputCrc32 = outputChecksum;
+	patch->hasOutputCrc32 = true;
 	return true;
 }
 
-size_t _decodeLength(struct VFile* vf) {
+bool _BPSApplyPatch(struct Patch* patch, const void* in, size_t inSize, void* out, size_t outSize) {
+	patch->hasOutputCrc32 = false;
+	if (out == in) {
+		// Source copies can read data that was already overwritten
+		return false;
+	}
+	size_t filesize;
+	const uint8_t* data = _mapPatch(patch, &filesize);
+	if (!data) {
+		return false;
+	}
+	bool success = _BPSApply(patch, data, filesize, in, inSize, out, outSize);
+	patch->vf->unmap(patch->vf, (void*) data, filesize);
+	return success;
+}
+
+// Patches are parsed straight out of a read-only mapping instead of a byte at a time through the VFile
+const uint8_t* _mapPatch(struct Patch* patch, size_t* size) {
+	ssize_t filesize = patch->vf->size(patch->vf);
+	if (filesize < 4 - IN_CHECKSUM) {
+		return NULL;
+	}
+	*size = filesize;
+	return patch->vf->map(patch->vf, filesize, MAP_READ);
+}
+
+size_t _decodeLength(const uint8_t* data, size_t end, size_t* offset) {
 	size_t shift = 1;
 	size_t value = 0;
-	uint8_t byte;
-	while (true) {
-		if (vf->read(vf, &byte, 1) != 1) {
-			break;
-		}
+	while (*offset < end) {
+		uint8_t byte = data[*offset];
+		++*offset;
 		value += (byte & 0x7f) * shift;
 		if (byte & 0x80) {
 			break;
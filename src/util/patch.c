@@ -10,6 +10,8 @@
 
 bool loadPatch(struct VFile* vf, struct Patch* patch) {
 	patch->vf = vf;
+	patch->hasInputCrc32 = false;
+	patch->hasOutputCrc32 = false;
 
 	if (loadPatchIPS(patch)) {
 		return true;
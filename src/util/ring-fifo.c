@@ -37,18 +37,17 @@ size_t RingFIFOSize(const struct RingFIFO* buffer) {
 void RingFIFOClear(struct RingFIFO* buffer) {
 	ATOMIC_STORE_PTR(buffer->readPtr, buffer->data);
 	ATOMIC_STORE_PTR(buffer->writePtr, buffer->data);
+	buffer->stagedPtr = buffer->data;
+	buffer->readPtrCache = buffer->data;
+	buffer->writePtrCache = buffer->data;
 }
 
-size_t RingFIFOWrite(struct RingFIFO* buffer, const void* value, size_t length) {
-	void* data = buffer->writePtr;
-	void* end;
-	ATOMIC_LOAD_PTR(end, buffer->readPtr);
-
+static void* _writeTarget(const struct RingFIFO* buffer, void* data, const void* end, size_t length) {
 	// Wrap around if we can't fit enough in here
 	if ((uintptr_t) data - (uintptr_t) buffer->data + length >= buffer->capacity) {
 		if (end == buffer->data || end > data) {
 			// Oops! If we wrap now, it'll appear empty
-			return 0;
+			return NULL;
 		}
 		data = buffer->data;
 	}
@@ -62,25 +61,17 @@ size_t RingFIFOWrite(struct RingFIFO* buffer, const void* value, size_t length)
 	}
 	// Note that we can't hit the end pointer
 	if (remaining <= length) {
-		return 0;
+		return NULL;
 	}
-	if (value) {
-		memcpy(data, value, length);
-	}
-	ATOMIC_STORE_PTR(buffer->writePtr, (void*) ((intptr_t) data + length));
-	return length;
+	return data;
 }
 
-size_t RingFIFORead(struct RingFIFO* buffer, void* output, size_t length) {
-	void* data = buffer->readPtr;
-	void* end;
-	ATOMIC_LOAD_PTR(end, buffer->writePtr);
-
+static void* _readTarget(const struct RingFIFO* buffer, void* data, const void* end, size_t length) {
 	// Wrap around if we can't fit enough in here
 	if ((uintptr_t) data - (uintptr_t) buffer->data + length >= buffer->capacity) {
 		if (end >= data) {
 			// Oops! If we wrap now, it'll appear full
-			return 0;
+			return NULL;
 		}
 		data = buffer->data;
 	}
@@ -94,8 +85,49 @@ size_t RingFIFORead(struct RingFIFO* buffer, void* output, size_t length) {
 	}
 	// If the pointers touch, it's empty
 	if (remaining < length) {
+		return NULL;
+	}
+	return data;
+}
+
+size_t RingFIFOStage(struct RingFIFO* buffer, const void* value, size_t length) {
+	// The reader only ever moves forward, so an old view of it can only understate the free space
+	void* data = _writeTarget(buffer, buffer->stagedPtr, buffer->readPtrCache, length);
+	if (!data) {
+		ATOMIC_LOAD_PTR(buffer->readPtrCache, buffer->readPtr);
+		data = _writeTarget(buffer, buffer->stagedPtr, buffer->readPtrCache, length);
+		if (!data) {
+			return 0;
+		}
+	}
+	if (value) {
+		memcpy(data, value, length);
+	}
+	buffer->stagedPtr = (void*) ((uintptr_t) data + length);
+	return length;
+}
+
+void RingFIFOCommit(struct RingFIFO* buffer) {
+	ATOMIC_STORE_PTR(buffer->writePtr, buffer->stagedPtr);
+}
+
+size_t RingFIFOWrite(struct RingFIFO* buffer, const void* value, size_t length) {
+	if (!RingFIFOStage(buffer, value, length)) {
 		return 0;
 	}
+	RingFIFOCommit(buffer);
+	return length;
+}
+
+size_t RingFIFORead(struct RingFIFO* buffer, void* output, size_t length) {
+	void* data = _readTarget(buffer, buffer->readPtr, buffer->writePtrCache, length);
+	if (!data) {
+		ATOMIC_LOAD_PTR(buffer->writePtrCache, buffer->writePtr);
+		data = _readTarget(buffer, buffer->readPtr, buffer->writePtrCache, length);
+		if (!data) {
+			return 0;
+		}
+	}
 	if (output) {
 		memcpy(output, data, length);
 	}
@@ -8,59 +8,209 @@
 #include <mgba-util/hash.h>
 #include <mgba-util/string.h>
 
-#define LIST_INITIAL_SIZE 8
 #define TABLE_INITIAL_SIZE 8
+// Each insertion or removal moves this many old slots while the table is growing,
+// which finishes the move well before the new slots fill up
+#define TABLE_MIGRATE_STEP 8
 
-#define TABLE_COMPARATOR(LIST, INDEX) LIST->list[(INDEX)].key == key
-#define HASH_TABLE_COMPARATOR(LIST, INDEX) LIST->list[(INDEX)].key == hash && strncmp(LIST->list[(INDEX)].stringKey, key, LIST->list[(INDEX)].keylen) == 0
-
-#define TABLE_LOOKUP_START(COMPARATOR, LIST, KEY) \
-	uint32_t entry = (KEY) & (table->tableSize - 1); \
-	LIST = &table->table[entry]; \
-	size_t i; \
-	for (i = 0; i < LIST->nEntries; ++i) { \
-		if (COMPARATOR(LIST, i)) { \
-			struct TableTuple* lookupResult = &LIST->list[i]; \
-			UNUSED(lookupResult);
-
-#define TABLE_LOOKUP_END \
-			break; \
-		} \
-	}
+#define TABLE_MAX_LOAD(SIZE) ((SIZE) - ((SIZE) >> 3))
 
 struct TableTuple {
 	uint32_t key;
+	// Distance from the slot the key hashes to, plus one; zero for empty slots
+	uint32_t probe;
 	char* stringKey;
 	size_t keylen;
 	void* value;
 };
 
-struct TableList {
-	struct TableTuple* list;
-	size_t nEntries;
-	size_t listSize;
-};
+static inline uint32_t _intHash(uint32_t key) {
+	// Integer keys are often addresses, whose low bits are far from uniform
+	key ^= key >> 16;
+	key *= 0x85EBCA6B;
+	key ^= key >> 13;
+	key *= 0xC2B2AE35;
+	key ^= key >> 16;
+	return key;
+}
+
+static inline uint32_t _tupleHash(const struct TableTuple* tuple) {
+	return tuple->stringKey ? tuple->key : _intHash(tuple->key);
+}
 
-static struct TableList* _resizeAsNeeded(struct Table* table, struct TableList* list, uint32_t key) {
-	UNUSED(table);
-	UNUSED(key);
-	// TODO: Expand table if needed
-	if (list->nEntries + 1 == list->listSize) {
-		list->listSize *= 2;
-		list->list = realloc(list->list, list->listSize * sizeof(struct TableTuple));
+static struct TableTuple* _lookup(struct TableTuple* slots, size_t tableSize, uint32_t key, const char* stringKey, size_t keylen) {
+	if (!slots) {
+		return NULL;
+	}
+	size_t mask = tableSize - 1;
+	size_t index = (stringKey ? key : _intHash(key)) & mask;
+	uint32_t probe = 1;
+	while (true) {
+		struct TableTuple* tuple = &slots[index];
+		if (tuple->probe < probe) {
+			// Either empty or a key closer to home, so ours would have displaced it
+			return NULL;
+		}
+		if (tuple->key == key) {
+			if (!stringKey) {
+				return tuple;
+			}
+			if (tuple->keylen == keylen && memcmp(tuple->stringKey, stringKey, keylen) == 0) {
+				return tuple;
+			}
+		}
+		index = (index + 1) & mask;
+		++probe;
 	}
-	return list;
 }
 
-static void _removeItemFromList(struct Table* table, struct TableList* list, size_t item) {
-	--list->nEntries;
-	--table->size;
-	free(list->list[item].stringKey);
+static void _place(struct TableTuple* slots, size_t tableSize, struct TableTuple tuple) {
+	size_t mask = tableSize - 1;
+	size_t index = _tupleHash(&tuple) & mask;
+	tuple.probe = 1;
+	while (true) {
+		struct TableTuple* slot = &slots[index];
+		if (!slot->probe) {
+			*slot = tuple;
+			return;
+		}
+		if (slot->probe < tuple.probe) {
+			struct TableTuple displaced = *slot;
+			*slot = tuple;
+			tuple = displaced;
+		}
+		index = (index + 1) & mask;
+		++tuple.probe;
+	}
+}
+
+// Empties a slot by shifting the rest of its run back, so no tombstones are needed
+static void _vacate(struct TableTuple* slots, size_t tableSize, struct TableTuple* tuple) {
+	size_t mask = tableSize - 1;
+	size_t index = tuple - slots;
+	size_t next = (index + 1) & mask;
+	while (slots[next].probe > 1) {
+		slots[index] = slots[next];
+		--slots[index].probe;
+		index = next;
+		next = (next + 1) & mask;
+	}
+	memset(&slots[index], 0, sizeof(slots[index]));
+}
+
+static void _freeOldTable(struct Table* table) {
+	free(table->oldTable);
+	table->oldTable = NULL;
+	table->oldTableSize = 0;
+	table->oldSize = 0;
+	table->migrated = 0;
+}
+
+static void _migrate(struct Table* table, size_t slots) {
+	if (!table->oldTable) {
+		return;
+	}
+	while (slots && table->migrated < table->oldTableSize) {
+		struct TableTuple* tuple = &table->oldTable[table->migrated];
+		if (!tuple->probe) {
+			++table->migrated;
+			--slots;
+			continue;
+		}
+		// Vacating the slot may pull the next entry of its run into it, so stay put
+		_place(table->table, table->tableSize, *tuple);
+		_vacate(table->oldTable, table->oldTableSize, tuple);
+		--table->oldSize;
+		--slots;
+	}
+	if (!table->oldSize) {
+		_freeOldTable(table);
+	}
+}
+
+static void _growAsNeeded(struct Table* table) {
+	_migrate(table, TABLE_MIGRATE_STEP);
+	if (table->size - table->oldSize < TABLE_MAX_LOAD(table->tableSize)) {
+		return;
+	}
+	if (table->oldTable) {
+		_migrate(table, table->oldTableSize);
+	}
+	table->oldTable = table->table;
+	table->oldTableSize = table->tableSize;
+	table->oldSize = table->size;
+	table->migrated = 0;
+	table->tableSize *= 2;
+	table->table = calloc(table->tableSize, sizeof(struct TableTuple));
+}
+
+static struct TableTuple* _find(const struct Table* table, uint32_t key, const char* stringKey, size_t keylen, bool* old) {
+	struct TableTuple* tuple = _lookup(table->table, table->tableSize, key, stringKey, keylen);
+	if (old) {
+		*old = false;
+	}
+	if (!tuple && table->oldTable) {
+		tuple = _lookup(table->oldTable, table->oldTableSize, key, stringKey, keylen);
+		if (old) {
+			*old = true;
+		}
+	}
+	return tuple;
+}
+
+static void _insert(struct Table* table, uint32_t key, const char* stringKey, void* value) {
+	size_t keylen = stringKey ? strlen(stringKey) : 0;
+	struct TableTuple* tuple = _find(table, key, stringKey, keylen, NULL);
+	if (tuple) {
+		if (value != tuple->value) {
+			if (table->deinitializer) {
+				table->deinitializer(tuple->value);
+			}
+			tuple->value = value;
+		}
+		return;
+	}
+	_growAsNeeded(table);
+	struct TableTuple newTuple = {
+		.key = key,
+		.stringKey = stringKey ? strdup(stringKey) : NULL,
+		.keylen = keylen,
+		.value = value
+	};
+	_place(table->table, table->tableSize, newTuple);
+	++table->size;
+}
+
+static void _remove(struct Table* table, uint32_t key, const char* stringKey) {
+	bool old;
+	struct TableTuple* tuple = _find(table, key, stringKey, stringKey ? strlen(stringKey) : 0, &old);
+	if (!tuple) {
+		return;
+	}
+	free(tuple->stringKey);
 	if (table->deinitializer) {
-		table->deinitializer(list->list[item].value);
+		table->deinitializer(tuple->value);
+	}
+	--table->size;
+	if (old) {
+		_vacate(table->oldTable, table->oldTableSize, tuple);
+		--table->oldSize;
+	} else {
+		_vacate(table->table, table->tableSize, tuple);
 	}
-	if (item != list->nEntries) {
-		list->list[item] = list->list[list->nEntries];
+	_migrate(table, TABLE_MIGRATE_STEP);
+}
+
+static void _clearSlots(struct Table* table, struct TableTuple* slots, size_t tableSize) {
+	size_t i;
+	for (i = 0; i < tableSize; ++i) {
+		if (!slots[i].probe) {
+			continue;
+		}
+		free(slots[i].stringKey);
+		if (table->deinitializer) {
+			table->deinitializer(slots[i].value);
+		}
 	}
 }
 
@@ -69,94 +219,65 @@ void TableInit(struct Table* table, size_t initialSize, void (deinitializer(void
 		initialSize = TABLE_INITIAL_SIZE;
 	}
 	table->tableSize = initialSize;
-	table->table = calloc(table->tableSize, sizeof(struct TableList));
+	table->table = calloc(table->tableSize, sizeof(struct TableTuple));
 	table->size = 0;
 	table->deinitializer = deinitializer;
-
-	size_t i;
-	for (i = 0; i < table->tableSize; ++i) {
-		table->table[i].listSize = LIST_INITIAL_SIZE;
-		table->table[i].nEntries = 0;
-		table->table[i].list = calloc(LIST_INITIAL_SIZE, sizeof(struct TableTuple));
-	}
+	table->oldTable = NULL;
+	table->oldTableSize = 0;
+	table->oldSize = 0;
+	table->migrated = 0;
 }
 
 void TableDeinit(struct Table* table) {
-	size_t i;
-	for (i = 0; i < table->tableSize; ++i) {
-		struct TableList* list = &table->table[i];
-		size_t j;
-		for (j = 0; j < list->nEntries; ++j) {
-			free(list->list[j].stringKey);
-			if (table->deinitializer) {
-				table->deinitializer(list->list[j].value);
-			}
-		}
-		free(list->list);
+	if (table->table) {
+		_clearSlots(table, table->table, table->tableSize);
 	}
+	if (table->oldTable) {
+		_clearSlots(table, table->oldTable, table->oldTableSize);
+	}
+	_freeOldTable(table);
 	free(table->table);
 	table->table = 0;
 	table->tableSize = 0;
+	table->size = 0;
 }
 
 void* TableLookup(const struct Table* table, uint32_t key) {
-	const struct TableList* list;
-	TABLE_LOOKUP_START(TABLE_COMPARATOR, list, key) {
-		return lookupResult->value;
-	} TABLE_LOOKUP_END;
+	struct TableTuple* tuple = _find(table, key, NULL, 0, NULL);
+	if (tuple) {
+		return tuple->value;
+	}
 	return 0;
 }
 
 void TableInsert(struct Table* table, uint32_t key, void* value) {
-	struct TableList* list;
-	TABLE_LOOKUP_START(TABLE_COMPARATOR, list, key) {
-		if (value != lookupResult->value) {
-			if (table->deinitializer) {
-				table->deinitializer(lookupResult->value);
-			}
-			lookupResult->value = value;
-		}
-		return;
-	} TABLE_LOOKUP_END;
-	list = _resizeAsNeeded(table, list, key);
-	list->list[list->nEntries].key = key;
-	list->list[list->nEntries].stringKey = 0;
-	list->list[list->nEntries].value = value;
-	++list->nEntries;
-	++table->size;
+	_insert(table, key, NULL, value);
 }
 
 void TableRemove(struct Table* table, uint32_t key) {
-	struct TableList* list;
-	TABLE_LOOKUP_START(TABLE_COMPARATOR, list, key) {
-		_removeItemFromList(table, list, i); // TODO: Move i out of the macro
-	} TABLE_LOOKUP_END;
+	_remove(table, key, NULL);
 }
 
 void TableClear(struct Table* table) {
-	size_t i;
-	for (i = 0; i < table->tableSize; ++i) {
-		struct TableList* list = &table->table[i];
-		if (table->deinitializer) {
-			size_t j;
-			for (j = 0; j < list->nEntries; ++j) {
-				table->deinitializer(list->list[j].value);
-			}
-		}
-		free(list->list);
-		list->listSize = LIST_INITIAL_SIZE;
-		list->nEntries = 0;
-		list->list = calloc(LIST_INITIAL_SIZE, sizeof(struct TableTuple));
+	_clearSlots(table, table->table, table->tableSize);
+	memset(table->table, 0, table->tableSize * sizeof(struct TableTuple));
+	if (table->oldTable) {
+		_clearSlots(table, table->oldTable, table->oldTableSize);
 	}
+	_freeOldTable(table);
+	table->size = 0;
 }
 
 void TableEnumerate(const struct Table* table, void (handler(uint32_t key, void* value, void* user)), void* user) {
 	size_t i;
 	for (i = 0; i < table->tableSize; ++i) {
-		const struct TableList* list = &table->table[i];
-		size_t j;
-		for (j = 0; j < list->nEntries; ++j) {
-			handler(list->list[j].key, list->list[j].value, user);
+		if (table->table[i].probe) {
+			handler(table->table[i].key, table->table[i].value, user);
+		}
+	}
+	for (i = 0; i < table->oldTableSize; ++i) {
+		if (table->oldTable[i].probe) {
+			handler(table->oldTable[i].key, table->oldTable[i].value, user);
 		}
 	}
 }
@@ -174,68 +295,36 @@ void HashTableDeinit(struct Table* table) {
 }
 
 void* HashTableLookup(const struct Table* table, const char* key) {
-	uint32_t hash = hash32(key, strlen(key), 0);
-	const struct TableList* list;
-	TABLE_LOOKUP_START(HASH_TABLE_COMPARATOR, list, hash) {
-		return lookupResult->value;
-	} TABLE_LOOKUP_END;
+	size_t keylen = strlen(key);
+	struct TableTuple* tuple = _find(table, hash32(key, keylen, 0), key, keylen, NULL);
+	if (tuple) {
+		return tuple->value;
+	}
 	return 0;
 }
 
 void HashTableInsert(struct Table* table, const char* key, void* value) {
-	uint32_t hash = hash32(key, strlen(key), 0);
-	struct TableList* list;
-	TABLE_LOOKUP_START(HASH_TABLE_COMPARATOR, list, hash) {
-		if (value != lookupResult->value) {
-			if (table->deinitializer) {
-				table->deinitializer(lookupResult->value);
-			}
-			lookupResult->value = value;
-		}
-		return;
-	} TABLE_LOOKUP_END;
-	list = _resizeAsNeeded(table, list, hash);
-	list->list[list->nEntries].key = hash;
-	list->list[list->nEntries].stringKey = strdup(key);
-	list->list[list->nEntries].keylen = strlen(key);
-	list->list[list->nEntries].value = value;
-	++list->nEntries;
-	++table->size;
+	_insert(table, hash32(key, strlen(key), 0), key, value);
 }
 
 void HashTableRemove(struct Table* table, const char* key) {
-	uint32_t hash = hash32(key, strlen(key), 0);
-	struct TableList* list;
-	TABLE_LOOKUP_START(HASH_TABLE_COMPARATOR, list, hash) {
-		_removeItemFromList(table, list, i); // TODO: Move i out of the macro
-	} TABLE_LOOKUP_END;
+	_remove(table, hash32(key, strlen(key), 0), key);
 }
 
 void HashTableClear(struct Table* table) {
-	size_t i;
-	for (i = 0; i < table->tableSize; ++i) {
-		struct TableList* list = &table->table[i];
-		size_t j;
-		for (j = 0; j < list->nEntries; ++j) {
-			if (table->deinitializer) {
-				table->deinitializer(list->list[j].value);
-			}
-			free(list->list[j].stringKey);
-		}
-		free(list->list);
-		list->listSize = LIST_INITIAL_SIZE;
-		list->nEntries = 0;
-		list->list = calloc(LIST_INITIAL_SIZE, sizeof(struct TableTuple));
-	}
+	TableClear(table);
 }
 
 void HashTableEnumerate(const struct Table* table, void (handler(const char* key, void* value, void* user)), void* user) {
 	size_t i;
 	for (i = 0; i < table->tableSize; ++i) {
-		const struct TableList* list = &table->table[i];
-		size_t j;
-		for (j = 0; j < list->nEntries; ++j) {
-			handler(list->list[j].stringKey, list->list[j].value, user);
+		if (table->table[i].probe) {
+			handler(table->table[i].stringKey, table->table[i].value, user);
+		}
+	}
+	for (i = 0; i < table->oldTableSize; ++i) {
+		if (table->oldTable[i].probe) {
+			handler(table->oldTable[i].stringKey, table->oldTable[i].value, user);
 		}
 	}
 }
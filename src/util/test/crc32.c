@@ -0,0 +1,76 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba-util/crc32.h>
+#include <mgba-util/vfs.h>
+
+static uint32_t _bitwiseCrc32(uint32_t crc, const uint8_t* buf, size_t size) {
+	crc = ~crc;
+	size_t i;
+	for (i = 0; i < size; ++i) {
+		crc ^= buf[i];
+		int bit;
+		for (bit = 0; bit < 8; ++bit) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+M_TEST_DEFINE(checkValue) {
+	static const char check[] = "123456789";
+	assert_int_equal(doCrc32(check, 9), 0xCBF43926);
+	assert_int_equal(doCrc32(check, 0), 0);
+}
+
+M_TEST_DEFINE(unaligned) {
+	uint8_t buffer[80];
+	size_t i;
+	for (i = 0; i < sizeof(buffer); ++i) {
+		buffer[i] = i * 37 + 11;
+	}
+	size_t offset;
+	for (offset = 0; offset < 8; ++offset) {
+		size_t size;
+		for (size = 0; size <= sizeof(buffer) - offset; ++size) {
+			assert_int_equal(doCrc32(&buffer[offset], size), _bitwiseCrc32(0, &buffer[offset], size));
+		}
+	}
+}
+
+M_TEST_DEFINE(chained) {
+	uint8_t buffer[1000];
+	size_t i;
+	for (i = 0; i < sizeof(buffer); ++i) {
+		buffer[i] = i ^ (i >> 3);
+	}
+	uint32_t crc = 0;
+	for (i = 0; i < sizeof(buffer); i += 77) {
+		size_t size = sizeof(buffer) - i < 77 ? sizeof(buffer) - i : 77;
+		crc = crc32(crc, &buffer[i], size);
+	}
+	assert_int_equal(crc, doCrc32(buffer, sizeof(buffer)));
+}
+
+M_TEST_DEFINE(file) {
+	uint8_t buffer[3000];
+	size_t i;
+	for (i = 0; i < sizeof(buffer); ++i) {
+		buffer[i] = i * 7;
+	}
+	struct VFile* vf = VFileFromConstMemory(buffer, sizeof(buffer));
+	assert_int_equal(fileCrc32(vf, sizeof(buffer)), doCrc32(buffer, sizeof(buffer)));
+	assert_int_equal(fileCrc32(vf, 1500), doCrc32(buffer, 1500));
+	assert_int_equal(fileCrc32(vf, sizeof(buffer) + 1), 0);
+	vf->close(vf);
+}
+
+M_TEST_SUITE_DEFINE(Crc32,
+	cmocka_unit_test(checkValue),
+	cmocka_unit_test(unaligned),
+	cmocka_unit_test(chained),
+	cmocka_unit_test(file))
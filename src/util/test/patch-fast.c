@@ -0,0 +1,126 @@
+/* Copyright (c) 2013-2016 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba-util/patch/fast.h>
+
+static void _fill(uint8_t* buffer, size_t size, uint32_t seed) {
+	size_t i;
+	for (i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		buffer[i] = seed >> 16;
+	}
+}
+
+static void _roundTrip(const uint8_t* in, const uint8_t* out, size_t size) {
+	struct PatchFast patch;
+	initPatchFast(&patch);
+	assert_true(diffPatchFast(&patch, in, out, size));
+	uint8_t* result = malloc(size + 1);
+	memset(result, 0xA5, size + 1);
+	assert_true(patch.d.applyPatch(&patch.d, in, size, result, size));
+	assert_memory_equal(result, out, size);
+	assert_int_equal(result[size], 0xA5);
+	free(result);
+	deinitPatchFast(&patch);
+}
+
+M_TEST_DEFINE(identical) {
+	uint8_t in[4096];
+	_fill(in, sizeof(in), 1);
+	struct PatchFast patch;
+	initPatchFast(&patch);
+	assert_true(diffPatchFast(&patch, in, in, sizeof(in)));
+	assert_int_equal(PatchFastExtentsSize(&patch.extents), 0);
+	deinitPatchFast(&patch);
+	_roundTrip(in, in, sizeof(in));
+}
+
+M_TEST_DEFINE(randomSizes) {
+	static const size_t sizes[] = { 1, 7, 15, 16, 17, 31, 255, 513, 1000, 4097, 65543 };
+	size_t s;
+	for (s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s) {
+		size_t size = sizes[s];
+		uint8_t* in = malloc(size);
+		uint8_t* out = malloc(size);
+		_fill(in, size, size);
+		memcpy(out, in, size);
+		size_t i;
+		for (i = 0; i < size; i += (i * 7 + 3) % 97 + 1) {
+			out[i] ^= (i & 0xFF) | 1;
+		}
+		out[size / 2] ^= 0x80;
+		_roundTrip(in, out, size);
+
+		_fill(out, size, size * 3 + 1);
+		_roundTrip(in, out, size);
+		free(in);
+		free(out);
+	}
+}
+
+M_TEST_DEFINE(tailBytes) {
+	uint8_t in[1000 + 7];
+	uint8_t out[1000 + 7];
+	_fill(in, sizeof(in), 2);
+	memcpy(out, in, sizeof(out));
+	out[sizeof(out) - 1] ^= 1;
+	out[sizeof(out) - 5] ^= 2;
+	struct PatchFast patch;
+	initPatchFast(&patch);
+	assert_true(diffPatchFast(&patch, in, out, sizeof(in)));
+	assert_int_equal(PatchFastExtentsSize(&patch.extents), 1);
+	struct PatchFastExtent* extent = PatchFastExtentsGetPointer(&patch.extents, 0);
+	assert_int_equal(extent->offset, sizeof(out) - 5);
+	assert_int_equal(extent->length, 5);
+	deinitPatchFast(&patch);
+	_roundTrip(in, out, sizeof(in));
+}
+
+M_TEST_DEFINE(coalesceExtents) {
+	uint8_t in[8192];
+	uint8_t out[8192];
+	_fill(in, sizeof(in), 3);
+	memcpy(out, in, sizeof(out));
+	size_t i;
+	// Every other 16-byte block differs
+	for (i = 0; i < sizeof(out); i += 32) {
+		out[i] ^= 0xFF;
+	}
+	struct PatchFast patch;
+	initPatchFast(&patch);
+	assert_true(diffPatchFast(&patch, in, out, sizeof(in)));
+	assert_int_equal(PatchFastExtentsSize(&patch.extents), sizeof(out) / (PATCH_FAST_EXTENT * 4));
+	for (i = 0; i < PatchFastExtentsSize(&patch.extents); ++i) {
+		struct PatchFastExtent* extent = PatchFastExtentsGetPointer(&patch.extents, i);
+		assert_int_equal(extent->offset, i * PATCH_FAST_EXTENT * 4);
+		assert_true(extent->length <= PATCH_FAST_EXTENT * 4);
+	}
+	deinitPatchFast(&patch);
+	_roundTrip(in, out, sizeof(in));
+}
+
+M_TEST_DEFINE(applyInPlace) {
+	uint8_t in[2048 + 3];
+	uint8_t out[2048 + 3];
+	_fill(in, sizeof(in), 4);
+	_fill(out, sizeof(out), 5);
+	memcpy(out, in, 600);
+	struct PatchFast patch;
+	initPatchFast(&patch);
+	assert_true(diffPatchFast(&patch, in, out, sizeof(in)));
+	assert_true(patch.d.applyPatch(&patch.d, in, sizeof(in), in, sizeof(in)));
+	assert_memory_equal(in, out, sizeof(out));
+	assert_false(patch.d.applyPatch(&patch.d, in, sizeof(in), out, sizeof(out) - 1));
+	deinitPatchFast(&patch);
+}
+
+M_TEST_SUITE_DEFINE(PatchFast,
+	cmocka_unit_test(identical),
+	cmocka_unit_test(randomSizes),
+	cmocka_unit_test(tailBytes),
+	cmocka_unit_test(coalesceExtents),
+	cmocka_unit_test(applyInPlace))
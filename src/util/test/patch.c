@@ -0,0 +1,213 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba-util/crc32.h>
+#include <mgba-util/patch.h>
+#include <mgba-util/vfs.h>
+
+#define ROM_SIZE 0x1000
+
+static void _fill(uint8_t* buffer, size_t size, uint32_t seed) {
+	size_t i;
+	for (i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		buffer[i] = seed >> 16;
+	}
+}
+
+static void _putLength(uint8_t* patch, size_t* size, size_t value) {
+	while (true) {
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		if (!value) {
+			patch[(*size)++] = byte | 0x80;
+			break;
+		}
+		patch[(*size)++] = byte;
+		--value;
+	}
+}
+
+static void _putChecksums(uint8_t* patch, size_t* size, const uint8_t* in, const uint8_t* out) {
+	STORE_32LE(doCrc32(in, ROM_SIZE), *size, patch);
+	STORE_32LE(doCrc32(out, ROM_SIZE), *size + 4, patch);
+	*size += 8;
+	STORE_32LE(doCrc32(patch, *size), *size, patch);
+	*size += 4;
+}
+
+// Differences must not run into the last byte, since every hunk ends on an unchanged one
+static size_t _makeUPS(uint8_t* patch, const uint8_t* in, const uint8_t* out) {
+	size_t size = 4;
+	memcpy(patch, "UPS1", 4);
+	_putLength(patch, &size, ROM_SIZE);
+	_putLength(patch, &size, ROM_SIZE);
+	size_t last = 0;
+	size_t i;
+	for (i = 0; i < ROM_SIZE; ++i) {
+		if (in[i] == out[i]) {
+			continue;
+		}
+		_putLength(patch, &size, i - last);
+		for (; in[i] != out[i]; ++i) {
+			patch[size++] = in[i] ^ out[i];
+		}
+		patch[size++] = 0;
+		last = i + 1;
+	}
+	_putChecksums(patch, &size, in, out);
+	return size;
+}
+
+static void _applyUPS(uint8_t* patchData, size_t size, const uint8_t* in, const uint8_t* out) {
+	struct VFile* vf = VFileFromConstMemory(patchData, size);
+	struct Patch patch;
+	assert_true(loadPatch(vf, &patch));
+	assert_int_equal(patch.outputSize(&patch, ROM_SIZE), ROM_SIZE);
+
+	uint8_t* result = malloc(ROM_SIZE);
+	assert_true(patch.applyPatch(&patch, in, ROM_SIZE, result, ROM_SIZE));
+	assert_memory_equal(result, out, ROM_SIZE);
+	assert_true(patch.hasOutputCrc32);
+	assert_int_equal(patch.outputCrc32, doCrc32(out, ROM_SIZE));
+
+	// Applying in place only touches the hunks
+	memcpy(result, in, ROM_SIZE);
+	assert_true(patch.applyPatch(&patch, result, ROM_SIZE, result, ROM_SIZE));
+	assert_memory_equal(result, out, ROM_SIZE);
+
+	// A wrong input checksum is only caught when the caller knows the input's
+	patch.hasInputCrc32 = true;
+	patch.inputCrc32 = doCrc32(in, ROM_SIZE) ^ 1;
+	assert_false(patch.applyPatch(&patch, in, ROM_SIZE, result, ROM_SIZE));
+	assert_false(patch.hasOutputCrc32);
+
+	free(result);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(applyUPS) {
+	uint8_t* in = malloc(ROM_SIZE);
+	uint8_t* out = malloc(ROM_SIZE);
+	_fill(in, ROM_SIZE, 1);
+	memcpy(out, in, ROM_SIZE);
+	_fill(&out[0x10], 0x20, 2);
+	_fill(&out[0x800], 0x100, 3);
+	out[0xFFE] ^= 0xFF;
+
+	uint8_t* patch = malloc(ROM_SIZE * 2);
+	size_t size = _makeUPS(patch, in, out);
+	_applyUPS(patch, size, in, out);
+
+	// Corrupting a hunk is caught by the output checksum, once the patch checksum is fixed up
+	patch[12] ^= 0x55;
+	STORE_32LE(doCrc32(patch, size - 4), size - 4, patch);
+	struct VFile* vf = VFileFromConstMemory(patch, size);
+	struct Patch corrupt;
+	assert_true(loadPatch(vf, &corrupt));
+	uint8_t* result = malloc(ROM_SIZE);
+	assert_false(corrupt.applyPatch(&corrupt, in, ROM_SIZE, result, ROM_SIZE));
+	vf->close(vf);
+
+	free(result);
+	free(patch);
+	free(out);
+	free(in);
+}
+
+M_TEST_DEFINE(applyBPS) {
+	uint8_t* in = malloc(ROM_SIZE);
+	uint8_t* out = malloc(ROM_SIZE);
+	_fill(in, ROM_SIZE, 4);
+	memcpy(out, in, 0x400);
+	_fill(&out[0x400], 0x10, 5);
+	memcpy(&out[0x410], &in[0x100], ROM_SIZE - 0x410);
+
+	uint8_t* patchData = malloc(ROM_SIZE);
+	size_t size = 4;
+	memcpy(patchData, "BPS1", 4);
+	_putLength(patchData, &size, ROM_SIZE);
+	_putLength(patchData, &size, ROM_SIZE);
+	_putLength(patchData, &size, 0);
+	// SourceRead
+	_putLength(patchData, &size, ((0x400 - 1) << 2) | 0);
+	// TargetRead
+	_putLength(patchData, &size, ((0x10 - 1) << 2) | 1);
+	memcpy(&patchData[size], &out[0x400], 0x10);
+	size += 0x10;
+	// SourceCopy
+	_putLength(patchData, &size, ((ROM_SIZE - 0x410 - 1) << 2) | 2);
+	_putLength(patchData, &size, 0x100 << 1);
+	_putChecksums(patchData, &size, in, out);
+
+	struct VFile* vf = VFileFromConstMemory(patchData, size);
+	struct Patch patch;
+	assert_true(loadPatch(vf, &patch));
+	uint8_t* result = malloc(ROM_SIZE);
+	assert_true(patch.applyPatch(&patch, in, ROM_SIZE, result, ROM_SIZE));
+	assert_memory_equal(result, out, ROM_SIZE);
+	assert_true(patch.hasOutputCrc32);
+	assert_int_equal(patch.outputCrc32, doCrc32(out, ROM_SIZE));
+
+	// A known input checksum is trusted instead of being computed
+	patch.hasInputCrc32 = true;
+	patch.inputCrc32 = doCrc32(in, ROM_SIZE);
+	memset(result, 0, ROM_SIZE);
+	assert_true(patch.applyPatch(&patch, in, ROM_SIZE, result, ROM_SIZE));
+	assert_memory_equal(result, out, ROM_SIZE);
+	patch.inputCrc32 ^= 1;
+	assert_false(patch.applyPatch(&patch, in, ROM_SIZE, result, ROM_SIZE));
+
+	// Source copies can't be applied in place
+	patch.hasInputCrc32 = false;
+	assert_false(patch.applyPatch(&patch, in, ROM_SIZE, in, ROM_SIZE));
+
+	vf->close(vf);
+	free(result);
+	free(patchData);
+	free(out);
+	free(in);
+}
+
+M_TEST_DEFINE(applyIPS) {
+	static const uint8_t patchData[] = {
+		'P', 'A', 'T', 'C', 'H',
+		0x00, 0x01, 0x00, 0x00, 0x03, 0xAA, 0xBB, 0xCC,
+		0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x04, 0x5A,
+		'E', 'O', 'F'
+	};
+	uint8_t* in = malloc(ROM_SIZE);
+	_fill(in, ROM_SIZE, 6);
+	uint8_t* out = malloc(ROM_SIZE);
+	memcpy(out, in, ROM_SIZE);
+	out[0x100] = 0xAA;
+	out[0x101] = 0xBB;
+	out[0x102] = 0xCC;
+	memset(&out[0x200], 0x5A, 4);
+
+	struct VFile* vf = VFileFromConstMemory(patchData, sizeof(patchData));
+	struct Patch patch;
+	assert_true(loadPatch(vf, &patch));
+	uint8_t* result = malloc(ROM_SIZE);
+	assert_true(patch.applyPatch(&patch, in, ROM_SIZE, result, ROM_SIZE));
+	assert_memory_equal(result, out, ROM_SIZE);
+	assert_true(patch.applyPatch(&patch, in, ROM_SIZE, in, ROM_SIZE));
+	assert_memory_equal(in, out, ROM_SIZE);
+
+	// Records can't reach past the output
+	assert_false(patch.applyPatch(&patch, in, 0x100, result, 0x100));
+
+	vf->close(vf);
+	free(result);
+	free(out);
+	free(in);
+}
+
+M_TEST_SUITE_DEFINE(Patch,
+	cmocka_unit_test(applyUPS),
+	cmocka_unit_test(applyBPS),
+	cmocka_unit_test(applyIPS))
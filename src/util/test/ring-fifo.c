@@ -0,0 +1,131 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba-util/ring-fifo.h>
+#include <mgba-util/threading.h>
+
+#define RECORD_WORDS 5
+#define RECORDS 200000
+
+M_TEST_DEFINE(wrap) {
+	struct RingFIFO fifo;
+	RingFIFOInit(&fifo, 0x1000);
+	uint32_t record[RECORD_WORDS];
+	uint32_t i;
+	uint32_t written = 0;
+	uint32_t read = 0;
+	// Several trips around the buffer, never quite emptying it
+	for (i = 0; i < 2000; ++i) {
+		while (true) {
+			record[0] = written;
+			if (!RingFIFOWrite(&fifo, record, sizeof(record))) {
+				break;
+			}
+			++written;
+		}
+		assert_true(RingFIFOSize(&fifo) > 0);
+		uint32_t target = read + (written - read) / 2 + 1;
+		for (; read < target; ++read) {
+			assert_int_equal(RingFIFORead(&fifo, record, sizeof(record)), sizeof(record));
+			assert_int_equal(record[0], read);
+		}
+	}
+	while (RingFIFORead(&fifo, record, sizeof(record))) {
+		assert_int_equal(record[0], read);
+		++read;
+	}
+	assert_int_equal(read, written);
+	assert_int_equal(RingFIFOSize(&fifo), 0);
+	RingFIFODeinit(&fifo);
+}
+
+M_TEST_DEFINE(stageCommit) {
+	struct RingFIFO fifo;
+	RingFIFOInit(&fifo, 0x1000);
+	uint32_t value = 1;
+	assert_int_equal(RingFIFOStage(&fifo, &value, sizeof(value)), sizeof(value));
+	value = 2;
+	assert_int_equal(RingFIFOStage(&fifo, &value, sizeof(value)), sizeof(value));
+	assert_int_equal(RingFIFOSize(&fifo), 0);
+	assert_int_equal(RingFIFORead(&fifo, &value, sizeof(value)), 0);
+
+	RingFIFOCommit(&fifo);
+	assert_int_equal(RingFIFOSize(&fifo), sizeof(value) * 2);
+	assert_int_equal(RingFIFORead(&fifo, &value, sizeof(value)), sizeof(value));
+	assert_int_equal(value, 1);
+	assert_int_equal(RingFIFORead(&fifo, &value, sizeof(value)), sizeof(value));
+	assert_int_equal(value, 2);
+	assert_int_equal(RingFIFORead(&fifo, &value, sizeof(value)), 0);
+
+	// Staging can't run over data the reader hasn't got to, committed or not
+	RingFIFOClear(&fifo);
+	size_t staged = 0;
+	while (RingFIFOStage(&fifo, &value, sizeof(value))) {
+		staged += sizeof(value);
+	}
+	assert_true(staged < RingFIFOCapacity(&fifo));
+	RingFIFOCommit(&fifo);
+	assert_int_equal(RingFIFOSize(&fifo), staged);
+
+	RingFIFOClear(&fifo);
+	assert_int_equal(RingFIFOSize(&fifo), 0);
+	assert_int_equal(RingFIFOWrite(&fifo, &value, sizeof(value)), sizeof(value));
+	assert_int_equal(RingFIFOSize(&fifo), sizeof(value));
+	RingFIFODeinit(&fifo);
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _writer(void* context) {
+	struct RingFIFO* fifo = context;
+	uint32_t record[RECORD_WORDS];
+	uint32_t i;
+	for (i = 0; i < RECORDS; ++i) {
+		unsigned j;
+		for (j = 0; j < RECORD_WORDS; ++j) {
+			record[j] = i * RECORD_WORDS + j;
+		}
+		while (!RingFIFOStage(fifo, record, sizeof(record))) {
+			RingFIFOCommit(fifo);
+		}
+		if ((i & 7) == 7) {
+			RingFIFOCommit(fifo);
+		}
+	}
+	RingFIFOCommit(fifo);
+	return 0;
+}
+#endif
+
+M_TEST_DEFINE(concurrent) {
+#ifndef DISABLE_THREADING
+	struct RingFIFO fifo;
+	RingFIFOInit(&fifo, 0x1000);
+	Thread thread;
+	assert_int_equal(ThreadCreate(&thread, _writer, &fifo), 0);
+
+	uint32_t record[RECORD_WORDS];
+	uint32_t i = 0;
+	while (i < RECORDS) {
+		if (!RingFIFORead(&fifo, record, sizeof(record))) {
+			continue;
+		}
+		unsigned j;
+		for (j = 0; j < RECORD_WORDS; ++j) {
+			assert_int_equal(record[j], i * RECORD_WORDS + j);
+		}
+		++i;
+	}
+	ThreadJoin(&thread);
+	assert_int_equal(RingFIFOSize(&fifo), 0);
+	RingFIFODeinit(&fifo);
+#endif
+}
+
+M_TEST_SUITE_DEFINE(RingFIFO,
+	cmocka_unit_test(wrap),
+	cmocka_unit_test(stageCommit),
+	cmocka_unit_test(concurrent))
@@ -0,0 +1,142 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "util/test/suite.h"
+
+#include <mgba-util/table.h>
+
+#define TABLE_TEST_ENTRIES 5000
+
+static int _freed;
+
+static void _countFree(void* value) {
+	UNUSED(value);
+	++_freed;
+}
+
+static void _sumKeys(uint32_t key, void* value, void* user) {
+	UNUSED(value);
+	*(uint64_t*) user += key;
+}
+
+static void _countStrings(const char* key, void* value, void* user) {
+	assert_int_equal(strtoul(key, NULL, 10), (uintptr_t) value);
+	++*(size_t*) user;
+}
+
+M_TEST_DEFINE(insertLookup) {
+	struct Table table;
+	TableInit(&table, 0, NULL);
+	uint32_t i;
+	for (i = 0; i < TABLE_TEST_ENTRIES; ++i) {
+		TableInsert(&table, i * 4, (void*) (uintptr_t) (i + 1));
+		assert_int_equal(TableSize(&table), i + 1);
+	}
+	for (i = 0; i < TABLE_TEST_ENTRIES; ++i) {
+		assert_int_equal((uintptr_t) TableLookup(&table, i * 4), i + 1);
+		assert_null(TableLookup(&table, i * 4 + 1));
+	}
+	uint64_t sum = 0;
+	TableEnumerate(&table, _sumKeys, &sum);
+	assert_int_equal(sum, 4ULL * TABLE_TEST_ENTRIES * (TABLE_TEST_ENTRIES - 1) / 2);
+	TableDeinit(&table);
+}
+
+M_TEST_DEFINE(replace) {
+	struct Table table;
+	_freed = 0;
+	TableInit(&table, 0, _countFree);
+	TableInsert(&table, 1, (void*) 1);
+	TableInsert(&table, 1, (void*) 1);
+	assert_int_equal(_freed, 0);
+	TableInsert(&table, 1, (void*) 2);
+	assert_int_equal(_freed, 1);
+	assert_int_equal(TableSize(&table), 1);
+	assert_int_equal((uintptr_t) TableLookup(&table, 1), 2);
+	TableDeinit(&table);
+	assert_int_equal(_freed, 2);
+}
+
+M_TEST_DEFINE(removeWhileGrowing) {
+	struct Table table;
+	_freed = 0;
+	TableInit(&table, 0, _countFree);
+	uint32_t i;
+	for (i = 0; i < TABLE_TEST_ENTRIES; ++i) {
+		TableInsert(&table, i, (void*) (uintptr_t) (i + 1));
+		if (i & 1) {
+			TableRemove(&table, i - 1);
+		}
+	}
+	assert_int_equal(TableSize(&table), TABLE_TEST_ENTRIES / 2);
+	assert_int_equal(_freed, TABLE_TEST_ENTRIES / 2);
+	for (i = 0; i < TABLE_TEST_ENTRIES; ++i) {
+		if (i & 1) {
+			assert_int_equal((uintptr_t) TableLookup(&table, i), i + 1);
+		} else {
+			assert_null(TableLookup(&table, i));
+		}
+	}
+	TableRemove(&table, 0);
+	assert_int_equal(_freed, TABLE_TEST_ENTRIES / 2);
+	TableClear(&table);
+	assert_int_equal(TableSize(&table), 0);
+	assert_int_equal(_freed, TABLE_TEST_ENTRIES);
+	assert_null(TableLookup(&table, 1));
+	TableInsert(&table, 1, (void*) 1);
+	assert_int_equal((uintptr_t) TableLookup(&table, 1), 1);
+	TableDeinit(&table);
+}
+
+M_TEST_DEFINE(hashStrings) {
+	struct Table table;
+	HashTableInit(&table, 0, NULL);
+	char key[16];
+	uintptr_t i;
+	for (i = 0; i < TABLE_TEST_ENTRIES; ++i) {
+		snprintf(key, sizeof(key), "%u", (unsigned) i);
+		HashTableInsert(&table, key, (void*) i);
+	}
+	assert_int_equal(HashTableSize(&table), TABLE_TEST_ENTRIES);
+	for (i = 0; i < TABLE_TEST_ENTRIES; i += 3) {
+		snprintf(key, sizeof(key), "%u", (unsigned) i);
+		HashTableRemove(&table, key);
+	}
+	for (i = 0; i < TABLE_TEST_ENTRIES; ++i) {
+		snprintf(key, sizeof(key), "%u", (unsigned) i);
+		if (i % 3) {
+			assert_int_equal((uintptr_t) HashTableLookup(&table, key), i);
+		} else {
+			assert_null(HashTableLookup(&table, key));
+		}
+	}
+	size_t count = 0;
+	HashTableEnumerate(&table, _countStrings, &count);
+	assert_int_equal(count, HashTableSize(&table));
+	HashTableDeinit(&table);
+}
+
+M_TEST_DEFINE(hashPrefixes) {
+	struct Table table;
+	HashTableInit(&table, 0, NULL);
+	HashTableInsert(&table, "", (void*) 1);
+	HashTableInsert(&table, "a", (void*) 2);
+	HashTableInsert(&table, "ab", (void*) 3);
+	assert_int_equal((uintptr_t) HashTableLookup(&table, ""), 1);
+	assert_int_equal((uintptr_t) HashTableLookup(&table, "a"), 2);
+	assert_int_equal((uintptr_t) HashTableLookup(&table, "ab"), 3);
+	assert_null(HashTableLookup(&table, "abc"));
+	HashTableRemove(&table, "a");
+	assert_null(HashTableLookup(&table, "a"));
+	assert_int_equal((uintptr_t) HashTableLookup(&table, "ab"), 3);
+	HashTableDeinit(&table);
+}
+
+M_TEST_SUITE_DEFINE(Table,
+	cmocka_unit_test(insertLookup),
+	cmocka_unit_test(replace),
+	cmocka_unit_test(removeWhileGrowing),
+	cmocka_unit_test(hashStrings),
+	cmocka_unit_test(hashPrefixes))
@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 #include "util/test/suite.h"
 
+#include <mgba-util/memory.h>
 #include <mgba-util/vfs.h>
 
 #if !defined(MINIMAL_CORE) || MINIMAL_CORE < 2
@@ -145,6 +146,136 @@ M_TEST_DEFINE(mapMemChunk) {
 	vf->close(vf);
 }
 
+M_TEST_DEFINE(reuseMemChunk) {
+	uint8_t bytes[32] = "Test Pattern";
+	uint8_t zero[32] = {0};
+	struct VFile* vf = VFileMemChunk(bytes, 32);
+	assert_non_null(vf);
+	void* mapped = vf->map(vf, 32, MAP_READ);
+	vf->truncate(vf, 0);
+	assert_int_equal(vf->size(vf), 0);
+	vf->seek(vf, 16, SEEK_SET);
+	assert_int_equal(vf->write(vf, bytes, 4), 4);
+	assert_int_equal(vf->size(vf), 20);
+	assert_ptr_equal(vf->map(vf, 20, MAP_READ), mapped);
+	assert_memory_equal(mapped, zero, 16);
+	assert_memory_equal((uint8_t*) mapped + 16, bytes, 4);
+	vf->truncate(vf, 32);
+	assert_memory_equal((uint8_t*) mapped + 20, zero, 12);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(mapCopyOnWriteMem) {
+	uint8_t bytes[32] = "Test Pattern";
+	struct VFile* vf = VFileFromMemory(bytes, 32);
+	assert_non_null(vf);
+	assert_null(VFileMapCopyOnWrite(vf, 32, 64));
+	vf->close(vf);
+}
+
+#if (!defined(MINIMAL_CORE) || MINIMAL_CORE < 2) && !defined(_WIN32) && !defined(PSP2) && !defined(USE_VFS_3DS) && !defined(USE_VFS_FILE)
+M_TEST_DEFINE(mapCopyOnWriteFile) {
+	char path[] = "/tmp/mgba-vfs-XXXXXX";
+	int fd = mkstemp(path);
+	assert_true(fd >= 0);
+	unlink(path);
+	struct VFile* vf = VFileFromFD(fd);
+	assert_non_null(vf);
+	uint8_t bytes[32] = "Test Pattern";
+	assert_int_equal(vf->write(vf, bytes, sizeof(bytes)), sizeof(bytes));
+
+	assert_null(VFileMapCopyOnWrite(vf, 32, 16));
+	uint8_t* mapped = VFileMapCopyOnWrite(vf, 32, 0x10000);
+	assert_non_null(mapped);
+	assert_memory_equal(mapped, bytes, 32);
+	assert_int_equal(mapped[0xFFFF], 0);
+	mapped[0] = 'B';
+	mapped[0xFFFF] = 1;
+
+	uint8_t readback[32];
+	vf->seek(vf, 0, SEEK_SET);
+	assert_int_equal(vf->read(vf, readback, sizeof(readback)), sizeof(readback));
+	assert_memory_equal(readback, bytes, 32);
+	mappedMemoryFree(mapped, 0x10000);
+	vf->close(vf);
+}
+
+M_TEST_DEFINE(remapCopyOnWriteFile) {
+	char path[] = "/tmp/mgba-vfs-XXXXXX";
+	int fd = mkstemp(path);
+	assert_true(fd >= 0);
+	unlink(path);
+	struct VFile* vf = VFileFromFD(fd);
+	assert_non_null(vf);
+	size_t page = sysconf(_SC_PAGESIZE);
+	uint8_t* bytes = malloc(page * 2);
+	size_t i;
+	for (i = 0; i < page * 2; ++i) {
+		bytes[i] = i / page + 1;
+	}
+	assert_int_equal(vf->write(vf, bytes, page * 2), page * 2);
+
+	uint8_t* mapped = anonymousMemoryMap(page * 4);
+	assert_non_null(mapped);
+	memset(mapped, 0xAA, page * 4);
+	// Partial pages and ranges past the end of the file are left to the caller
+	assert_false(VFileRemapCopyOnWrite(vf, &mapped[page], 1, page));
+	assert_false(VFileRemapCopyOnWrite(vf, &mapped[1], 0, page));
+	assert_false(VFileRemapCopyOnWrite(vf, &mapped[page], page, page * 2));
+	assert_int_equal(mapped[page], 0xAA);
+
+	assert_true(VFileRemapCopyOnWrite(vf, &mapped[page * 2], page, page));
+	assert_int_equal(mapped[page * 2 - 1], 0xAA);
+	assert_memory_equal(&mapped[page * 2], &bytes[page], page);
+	assert_int_equal(mapped[page * 3], 0xAA);
+	mapped[page * 2] = 0;
+
+	uint8_t readback;
+	vf->seek(vf, page, SEEK_SET);
+	assert_int_equal(vf->read(vf, &readback, 1), 1);
+	assert_int_equal(readback, 2);
+	mappedMemoryFree(mapped, page * 4);
+	free(bytes);
+	vf->close(vf);
+}
+#endif
+
+M_TEST_DEFINE(asyncWrite) {
+	struct VFile* backing = VFileMemChunk(NULL, 0);
+	struct VFile* vf = VFileAsync(backing, 64);
+	assert_non_null(vf);
+
+	uint8_t bytes[200];
+	size_t i;
+	for (i = 0; i < sizeof(bytes); ++i) {
+		bytes[i] = i;
+	}
+	// Small writes wrap around the queue, and ones bigger than it go out directly
+	for (i = 0; i < 40; ++i) {
+		assert_int_equal(vf->write(vf, &bytes[i * 3], 3), 3);
+	}
+	assert_int_equal(vf->seek(vf, 0, SEEK_CUR), 120);
+	assert_int_equal(vf->write(vf, &bytes[120], 80), 80);
+	assert_int_equal(vf->seek(vf, 0, SEEK_CUR), sizeof(bytes));
+	assert_true(vf->sync(vf, NULL, 0));
+	assert_int_equal(backing->size(backing), sizeof(bytes));
+
+	uint8_t readback[sizeof(bytes)];
+	assert_int_equal(vf->seek(vf, 0, SEEK_SET), 0);
+	assert_int_equal(vf->read(vf, readback, sizeof(readback)), sizeof(readback));
+	assert_memory_equal(readback, bytes, sizeof(bytes));
+
+	// Writes after a seek land where it says
+	vf->seek(vf, 4, SEEK_SET);
+	vf->write(vf, "Test", 4);
+	assert_int_equal(vf->size(vf), sizeof(bytes));
+	vf->seek(vf, 0, SEEK_SET);
+	vf->read(vf, readback, 8);
+	assert_memory_equal(readback, bytes, 4);
+	assert_memory_equal(&readback[4], "Test", 4);
+	vf->close(vf);
+}
+
 M_TEST_SUITE_DEFINE(VFS,
 #if !defined(MINIMAL_CORE) || MINIMAL_CORE < 2
 	cmocka_unit_test(openNullPathR),
@@ -164,4 +295,12 @@ M_TEST_SUITE_DEFINE(VFS,
 	cmocka_unit_test(resizeMemChunk),
 	cmocka_unit_test(mapMem),
 	cmocka_unit_test(mapConstMem),
-	cmocka_unit_test(mapMemChunk))
+	cmocka_unit_test(mapMemChunk),
+	cmocka_unit_test(reuseMemChunk),
+	cmocka_unit_test(mapCopyOnWriteMem),
+#if (!defined(MINIMAL_CORE) || MINIMAL_CORE < 2) && !defined(_WIN32) && !defined(PSP2) && !defined(USE_VFS_3DS) && !defined(USE_VFS_FILE)
+	cmocka_unit_test(mapCopyOnWriteFile),
+	cmocka_unit_test(remapCopyOnWriteFile),
+#endif
+	cmocka_unit_test(asyncWrite),
+)
@@ -0,0 +1,242 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba-util/threading.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define THREAD_PLACEMENT_LINUX
+#elif defined(_WIN32)
+#include <windows.h>
+#define THREAD_PLACEMENT_WINDOWS
+#elif defined(__SWITCH__)
+#include <switch.h>
+#define THREAD_PLACEMENT_SWITCH
+// Applications get the first three cores; the last belongs to the system
+#define SWITCH_APPLICATION_CORES 3
+#endif
+
+#define FASTEST_CORE_UNKNOWN -2
+
+static int _claimedCore = -1;
+static int _claimExclusive = 0;
+static int _fastestCore = FASTEST_CORE_UNKNOWN;
+
+#ifdef THREAD_PLACEMENT_LINUX
+static unsigned long _readCpuValue(int core, const char* file) {
+	char path[64];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/%s", core, file);
+	FILE* f = fopen(path, "r");
+	if (!f) {
+		return 0;
+	}
+	unsigned long value = 0;
+	if (fscanf(f, "%lu", &value) != 1) {
+		value = 0;
+	}
+	fclose(f);
+	return value;
+}
+
+static int _setCores(int except) {
+	int count = ThreadCoreCount();
+	if (count > CPU_SETSIZE) {
+		count = CPU_SETSIZE;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	int i;
+	for (i = 0; i < count; ++i) {
+		if (i != except) {
+			CPU_SET(i, &set);
+		}
+	}
+	return sched_setaffinity(0, sizeof(set), &set);
+}
+#endif
+
+int ThreadCoreCount(void) {
+#if defined(THREAD_PLACEMENT_LINUX)
+	long count = sysconf(_SC_NPROCESSORS_CONF);
+	return count > 0 ? count : -1;
+#elif defined(THREAD_PLACEMENT_WINDOWS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#elif defined(THREAD_PLACEMENT_SWITCH)
+	return SWITCH_APPLICATION_CORES;
+#else
+	return -1;
+#endif
+}
+
+int ThreadFastestCore(void) {
+	int fastest;
+	ATOMIC_LOAD(fastest, _fastestCore);
+	if (fastest != FASTEST_CORE_UNKNOWN) {
+		return fastest;
+	}
+	fastest = -1;
+#ifdef THREAD_PLACEMENT_LINUX
+	// Capacity is what the scheduler itself goes by on asymmetric ARM systems; the top clock speed is a fallback
+	static const char* const sources[] = { "cpu_capacity", "cpufreq/cpuinfo_max_freq" };
+	int count = ThreadCoreCount();
+	size_t source;
+	for (source = 0; source < sizeof(sources) / sizeof(*sources) && fastest < 0; ++source) {
+		unsigned long best = 0;
+		unsigned long worst = 0;
+		int bestCore = -1;
+		int i;
+		for (i = 0; i < count; ++i) {
+			unsigned long value = _readCpuValue(i, sources[source]);
+			if (!value) {
+				continue;
+			}
+			if (value > best) {
+				best = value;
+				bestCore = i;
+			}
+			if (!worst || value < worst) {
+				worst = value;
+			}
+		}
+		// Picking one of several identical cores would only take choice away from the scheduler
+		if (best > worst) {
+			fastest = bestCore;
+		}
+	}
+#endif
+	ATOMIC_STORE(_fastestCore, fastest);
+	return fastest;
+}
+
+int ThreadSetCore(int core) {
+	if (core < 0 || core >= ThreadCoreCount()) {
+		return -1;
+	}
+#if defined(THREAD_PLACEMENT_LINUX)
+	if (core >= CPU_SETSIZE) {
+		return -1;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	return sched_setaffinity(0, sizeof(set), &set);
+#elif defined(THREAD_PLACEMENT_WINDOWS)
+	if ((size_t) core >= sizeof(DWORD_PTR) * 8) {
+		return -1;
+	}
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << core) ? 0 : -1;
+#elif defined(THREAD_PLACEMENT_SWITCH)
+	return R_FAILED(svcSetThreadCoreMask(CUR_THREAD_HANDLE, core, 1 << core)) ? -1 : 0;
+#else
+	return -1;
+#endif
+}
+
+int ThreadClearCore(void) {
+#if defined(THREAD_PLACEMENT_LINUX)
+	return _setCores(-1);
+#elif defined(THREAD_PLACEMENT_WINDOWS)
+	DWORD_PTR process;
+	DWORD_PTR system;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+		return -1;
+	}
+	return SetThreadAffinityMask(GetCurrentThread(), process) ? 0 : -1;
+#elif defined(THREAD_PLACEMENT_SWITCH)
+	return R_FAILED(svcSetThreadCoreMask(CUR_THREAD_HANDLE, -1, (1 << SWITCH_APPLICATION_CORES) - 1)) ? -1 : 0;
+#else
+	return -1;
+#endif
+}
+
+int ThreadSetPriority(enum ThreadPriority priority) {
+#if defined(THREAD_PLACEMENT_LINUX)
+	// Threads have their own nice value on Linux; raising it above normal needs CAP_SYS_NICE
+	int nice = 0;
+	if (priority == THREAD_PRIO_HIGH) {
+		nice = -5;
+	} else if (priority == THREAD_PRIO_LOW) {
+		nice = 5;
+	}
+	return setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice);
+#elif defined(THREAD_PLACEMENT_WINDOWS)
+	int level = THREAD_PRIORITY_NORMAL;
+	if (priority == THREAD_PRIO_HIGH) {
+		level = THREAD_PRIORITY_ABOVE_NORMAL;
+	} else if (priority == THREAD_PRIO_LOW) {
+		level = THREAD_PRIORITY_BELOW_NORMAL;
+	}
+	return SetThreadPriority(GetCurrentThread(), level) ? 0 : -1;
+#elif defined(THREAD_PLACEMENT_SWITCH)
+	// Lower numbers run first; ThreadCreate starts threads at 0x3B
+	int level = 0x3B;
+	if (priority == THREAD_PRIO_HIGH) {
+		level = 0x2C;
+	} else if (priority == THREAD_PRIO_LOW) {
+		level = 0x3F;
+	}
+	return R_FAILED(svcSetThreadPriority(CUR_THREAD_HANDLE, level)) ? -1 : 0;
+#else
+	UNUSED(priority);
+	return -1;
+#endif
+}
+
+void ThreadClaimCore(int core, bool exclusive) {
+	if (core < 0) {
+		core = -1;
+	}
+	// Helpers read the core first, so they never see a new core with an old exclusivity
+	ATOMIC_STORE(_claimExclusive, exclusive ? 1 : 0);
+	ATOMIC_STORE(_claimedCore, core);
+}
+
+void ThreadReleaseCore(void) {
+	ATOMIC_STORE(_claimedCore, -1);
+}
+
+int ThreadClaimedCore(void) {
+	int core;
+	ATOMIC_LOAD(core, _claimedCore);
+	return core;
+}
+
+int ThreadPlaceHelper(void) {
+	int reserved = ThreadClaimedCore();
+	if (reserved < 0) {
+		return 0;
+	}
+	int exclusive;
+	ATOMIC_LOAD(exclusive, _claimExclusive);
+	if (!exclusive || ThreadCoreCount() < 2) {
+		return ThreadClearCore();
+	}
+#if defined(THREAD_PLACEMENT_LINUX)
+	return _setCores(reserved);
+#elif defined(THREAD_PLACEMENT_WINDOWS)
+	DWORD_PTR process;
+	DWORD_PTR system;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+		return -1;
+	}
+	if ((size_t) reserved < sizeof(DWORD_PTR) * 8) {
+		process &= ~((DWORD_PTR) 1 << reserved);
+	}
+	if (!process) {
+		return -1;
+	}
+	return SetThreadAffinityMask(GetCurrentThread(), process) ? 0 : -1;
+#elif defined(THREAD_PLACEMENT_SWITCH)
+	u32 mask = ((1 << SWITCH_APPLICATION_CORES) - 1) & ~(1 << reserved);
+	return R_FAILED(svcSetThreadCoreMask(CUR_THREAD_HANDLE, -1, mask)) ? -1 : 0;
+#else
+	return -1;
+#endif
+}
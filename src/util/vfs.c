@@ -13,6 +13,9 @@
 #ifdef _3DS
 #include <mgba-util/platform/3ds/3ds-vfs.h>
 #endif
+#if !defined(USE_VFS_FILE) && !defined(PSP2) && !defined(USE_VFS_3DS) && !defined(_WIN32)
+#include <sys/stat.h>
+#endif
 
 struct VFile* VFileOpen(const char* path, int flags) {
 #ifdef USE_VFS_FILE
@@ -96,6 +99,51 @@ struct VFile* VFileOpen(const char* path, int flags) {
 #endif
 }
 
+void* VFileMapCopyOnWrite(struct VFile* vf, size_t size, size_t mapSize) {
+#if defined(USE_VFS_FILE) || defined(PSP2) || defined(USE_VFS_3DS)
+	UNUSED(vf);
+	UNUSED(size);
+	UNUSED(mapSize);
+	return NULL;
+#else
+	return VFileFDMapCopyOnWrite(vf, size, mapSize);
+#endif
+}
+
+bool VFileRemapCopyOnWrite(struct VFile* vf, void* memory, size_t offset, size_t size) {
+#if defined(USE_VFS_FILE) || defined(PSP2) || defined(USE_VFS_3DS)
+	UNUSED(vf);
+	UNUSED(memory);
+	UNUSED(offset);
+	UNUSED(size);
+	return false;
+#else
+	return VFileFDRemapCopyOnWrite(vf, memory, offset, size);
+#endif
+}
+
+int64_t VFileModificationTime(struct VFile* vf) {
+#if defined(USE_VFS_FILE) || defined(PSP2) || defined(USE_VFS_3DS)
+	UNUSED(vf);
+	return 0;
+#else
+	return VFileFDModificationTime(vf);
+#endif
+}
+
+int64_t VDirModificationTime(const char* path) {
+#if defined(USE_VFS_FILE) || defined(PSP2) || defined(USE_VFS_3DS) || defined(_WIN32)
+	UNUSED(path);
+	return 0;
+#else
+	struct stat info;
+	if (!path || stat(path, &info) < 0) {
+		return 0;
+	}
+	return info.st_mtime;
+#endif
+}
+
 struct VDir* VDirOpenArchive(const char* path) {
 	struct VDir* dir = 0;
 	UNUSED(path);
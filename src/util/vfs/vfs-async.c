@@ -0,0 +1,232 @@
+/* Copyright (c) 2013-2020 Jeffrey Pfau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <mgba-util/vfs.h>
+
+#include <mgba-util/threading.h>
+
+#ifndef DISABLE_THREADING
+struct VFileAsync {
+	struct VFile d;
+	struct VFile* backing;
+
+	Thread thread;
+	Mutex mutex;
+	Condition queued;
+	Condition drained;
+
+	// Writes waiting to go out, as a ring starting at head
+	uint8_t* buffer;
+	size_t capacity;
+	size_t head;
+	size_t fill;
+	bool stopping;
+	bool failed;
+
+	// Where the caller thinks the file is, including writes that haven't gone out yet
+	off_t position;
+};
+
+static bool _vfaClose(struct VFile* vf);
+static off_t _vfaSeek(struct VFile* vf, off_t offset, int whence);
+static ssize_t _vfaRead(struct VFile* vf, void* buffer, size_t size);
+static ssize_t _vfaWrite(struct VFile* vf, const void* buffer, size_t size);
+static void* _vfaMap(struct VFile* vf, size_t size, int flags);
+static void _vfaUnmap(struct VFile* vf, void* memory, size_t size);
+static void _vfaTruncate(struct VFile* vf, size_t size);
+static ssize_t _vfaSize(struct VFile* vf);
+static bool _vfaSync(struct VFile* vf, const void* buffer, size_t size);
+
+static THREAD_ENTRY _vfaWriterThread(void* context);
+#endif
+
+struct VFile* VFileAsync(struct VFile* backing, size_t bufferSize) {
+	if (!backing) {
+		return NULL;
+	}
+#ifdef DISABLE_THREADING
+	UNUSED(bufferSize);
+	return backing;
+#else
+	struct VFileAsync* vfa = malloc(sizeof(*vfa));
+	if (!vfa) {
+		return backing;
+	}
+	vfa->buffer = malloc(bufferSize);
+	if (!vfa->buffer) {
+		free(vfa);
+		return backing;
+	}
+	vfa->backing = backing;
+	vfa->capacity = bufferSize;
+	vfa->head = 0;
+	vfa->fill = 0;
+	vfa->stopping = false;
+	vfa->failed = false;
+	vfa->position = backing->seek(backing, 0, SEEK_CUR);
+
+	vfa->d.close = _vfaClose;
+	vfa->d.seek = _vfaSeek;
+	vfa->d.read = _vfaRead;
+	vfa->d.readline = VFileReadline;
+	vfa->d.write = _vfaWrite;
+	vfa->d.map = _vfaMap;
+	vfa->d.unmap = _vfaUnmap;
+	vfa->d.truncate = _vfaTruncate;
+	vfa->d.size = _vfaSize;
+	vfa->d.sync = _vfaSync;
+
+	MutexInit(&vfa->mutex);
+	ConditionInit(&vfa->queued);
+	ConditionInit(&vfa->drained);
+	ThreadCreate(&vfa->thread, _vfaWriterThread, vfa);
+	return &vfa->d;
+#endif
+}
+
+#ifndef DISABLE_THREADING
+static THREAD_ENTRY _vfaWriterThread(void* context) {
+	struct VFileAsync* vfa = context;
+	ThreadSetName("File Writer");
+	MutexLock(&vfa->mutex);
+	while (true) {
+		while (!vfa->fill && !vfa->stopping) {
+			ConditionWait(&vfa->queued, &vfa->mutex);
+		}
+		if (!vfa->fill) {
+			break;
+		}
+		// The span stays counted in fill until it's written, so the caller can't reuse it yet
+		size_t size = vfa->capacity - vfa->head;
+		if (size > vfa->fill) {
+			size = vfa->fill;
+		}
+		const uint8_t* span = &vfa->buffer[vfa->head];
+		MutexUnlock(&vfa->mutex);
+		bool success = vfa->backing->write(vfa->backing, span, size) == (ssize_t) size;
+		MutexLock(&vfa->mutex);
+		if (!success) {
+			vfa->failed = true;
+		}
+		vfa->head = (vfa->head + size) % vfa->capacity;
+		vfa->fill -= size;
+		ConditionWake(&vfa->drained);
+	}
+	MutexUnlock(&vfa->mutex);
+	return 0;
+}
+
+static void _vfaDrain(struct VFileAsync* vfa) {
+	MutexLock(&vfa->mutex);
+	while (vfa->fill) {
+		ConditionWait(&vfa->drained, &vfa->mutex);
+	}
+	MutexUnlock(&vfa->mutex);
+}
+
+static bool _vfaClose(struct VFile* vf) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	MutexLock(&vfa->mutex);
+	vfa->stopping = true;
+	ConditionWake(&vfa->queued);
+	MutexUnlock(&vfa->mutex);
+	ThreadJoin(&vfa->thread);
+	MutexDeinit(&vfa->mutex);
+	ConditionDeinit(&vfa->queued);
+	ConditionDeinit(&vfa->drained);
+
+	bool success = vfa->backing->close(vfa->backing) && !vfa->failed;
+	free(vfa->buffer);
+	free(vfa);
+	return success;
+}
+
+static off_t _vfaSeek(struct VFile* vf, off_t offset, int whence) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	// Writers ask where they are all the time, and that doesn't need to wait for anything
+	if (whence == SEEK_CUR && !offset) {
+		return vfa->position;
+	}
+	_vfaDrain(vfa);
+	off_t position = vfa->backing->seek(vfa->backing, offset, whence);
+	if (position >= 0) {
+		vfa->position = position;
+	}
+	return position;
+}
+
+static ssize_t _vfaRead(struct VFile* vf, void* buffer, size_t size) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	_vfaDrain(vfa);
+	ssize_t read = vfa->backing->read(vfa->backing, buffer, size);
+	if (read > 0) {
+		vfa->position += read;
+	}
+	return read;
+}
+
+static ssize_t _vfaWrite(struct VFile* vf, const void* buffer, size_t size) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	if (size > vfa->capacity) {
+		// Too big to queue, so it has to go out in order with everything before it
+		_vfaDrain(vfa);
+		ssize_t written = vfa->backing->write(vfa->backing, buffer, size);
+		if (written > 0) {
+			vfa->position += written;
+		}
+		return written;
+	}
+
+	MutexLock(&vfa->mutex);
+	while (vfa->capacity - vfa->fill < size) {
+		ConditionWait(&vfa->drained, &vfa->mutex);
+	}
+	size_t tail = (vfa->head + vfa->fill) % vfa->capacity;
+	size_t first = vfa->capacity - tail;
+	if (first > size) {
+		first = size;
+	}
+	memcpy(&vfa->buffer[tail], buffer, first);
+	memcpy(vfa->buffer, (const uint8_t*) buffer + first, size - first);
+	vfa->fill += size;
+	ConditionWake(&vfa->queued);
+	MutexUnlock(&vfa->mutex);
+	vfa->position += size;
+	return size;
+}
+
+static void* _vfaMap(struct VFile* vf, size_t size, int flags) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	_vfaDrain(vfa);
+	return vfa->backing->map(vfa->backing, size, flags);
+}
+
+static void _vfaUnmap(struct VFile* vf, void* memory, size_t size) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	vfa->backing->unmap(vfa->backing, memory, size);
+}
+
+static void _vfaTruncate(struct VFile* vf, size_t size) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	_vfaDrain(vfa);
+	vfa->backing->truncate(vfa->backing, size);
+}
+
+static ssize_t _vfaSize(struct VFile* vf) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	_vfaDrain(vfa);
+	return vfa->backing->size(vfa->backing);
+}
+
+static bool _vfaSync(struct VFile* vf, const void* buffer, size_t size) {
+	struct VFileAsync* vfa = (struct VFileAsync*) vf;
+	_vfaDrain(vfa);
+	MutexLock(&vfa->mutex);
+	bool failed = vfa->failed;
+	vfa->failed = false;
+	MutexUnlock(&vfa->mutex);
+	return vfa->backing->sync(vfa->backing, buffer, size) && !failed;
+}
+#endif
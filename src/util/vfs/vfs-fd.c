@@ -193,6 +193,66 @@ static ssize_t _vfdSize(struct VFile* vf) {
 	return stat.st_size;
 }
 
+void* VFileFDMapCopyOnWrite(struct VFile* vf, size_t size, size_t mapSize) {
+#ifndef _WIN32
+	if (vf->map != _vfdMap || size > mapSize) {
+		return NULL;
+	}
+	struct VFileFD* vfd = (struct VFileFD*) vf;
+	void* memory = mmap(0, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if (memory == MAP_FAILED) {
+		return NULL;
+	}
+	if (size && mmap(memory, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, vfd->fd, 0) == MAP_FAILED) {
+		munmap(memory, mapSize);
+		return NULL;
+	}
+	return memory;
+#else
+	UNUSED(vf);
+	UNUSED(size);
+	UNUSED(mapSize);
+	return NULL;
+#endif
+}
+
+bool VFileFDRemapCopyOnWrite(struct VFile* vf, void* memory, size_t offset, size_t size) {
+#ifndef _WIN32
+	if (vf->map != _vfdMap || !size) {
+		return false;
+	}
+	size_t pageMask = sysconf(_SC_PAGESIZE) - 1;
+	if (((uintptr_t) memory | offset | size) & pageMask) {
+		return false;
+	}
+	// Pages past the end of the file would fault instead of reading as zero
+	ssize_t fileSize = vf->size(vf);
+	if (fileSize < 0 || offset > (size_t) fileSize || size > (size_t) fileSize - offset) {
+		return false;
+	}
+	struct VFileFD* vfd = (struct VFileFD*) vf;
+	return mmap(memory, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, vfd->fd, offset) != MAP_FAILED;
+#else
+	UNUSED(vf);
+	UNUSED(memory);
+	UNUSED(offset);
+	UNUSED(size);
+	return false;
+#endif
+}
+
+int64_t VFileFDModificationTime(struct VFile* vf) {
+	if (vf->close != _vfdClose) {
+		return 0;
+	}
+	struct VFileFD* vfd = (struct VFileFD*) vf;
+	struct stat stat;
+	if (fstat(vfd->fd, &stat) < 0) {
+		return 0;
+	}
+	return stat.st_mtime;
+}
+
 static bool _vfdSync(struct VFile* vf, const void* buffer, size_t size) {
 	UNUSED(buffer);
 	UNUSED(size);
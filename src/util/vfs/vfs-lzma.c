@@ -8,6 +8,10 @@
 #ifdef USE_LZMA
 
 #include <mgba-util/string.h>
+#ifndef DISABLE_THREADING
+#include <mgba-util/threading.h>
+#include <mgba-util/vector.h>
+#endif
 
 #include "third-party/lzma/7z.h"
 #include "third-party/lzma/7zAlloc.h"
@@ -15,8 +19,13 @@
 #include "third-party/lzma/7zCrc.h"
 #include "third-party/lzma/7zFile.h"
 #include "third-party/lzma/7zVersion.h"
+#include "third-party/lzma/Lzma2Dec.h"
 
 #define BUFFER_SIZE 0x2000
+#define METHOD_LZMA2 0x21
+#define MAX_THREADS 16
+
+static int _threads = 0;
 
 struct VDirEntry7z {
 	struct VDirEntry d;
@@ -70,6 +79,33 @@ static bool _vd7zDeleteFile(struct VDir* vd, const char* path);
 static const char* _vde7zName(struct VDirEntry* vde);
 static enum VFSType _vde7zType(struct VDirEntry* vde);
 
+#ifndef DISABLE_THREADING
+struct VDir7zBlock {
+	const Byte* in;
+	size_t inSize;
+	Byte* out;
+	size_t outSize;
+};
+
+DECLARE_VECTOR(VDir7zBlockList, struct VDir7zBlock);
+DEFINE_VECTOR(VDir7zBlockList, struct VDir7zBlock);
+
+struct VDir7zDecoder {
+	struct VDir7zBlockList blocks;
+	size_t next;
+	bool failed;
+	Byte prop;
+	ISzAlloc* alloc;
+	Mutex mutex;
+};
+
+static bool _vd7zExtractThreaded(struct VDir7z* vd, UInt32 fileIndex, Byte** outBuffer, size_t* offset, size_t* size);
+#endif
+
+void VDir7zSetThreads(int threads) {
+	_threads = threads;
+}
+
 struct VDir* VDirOpen7z(const char* path, int flags) {
 	if (flags & O_WRONLY || flags & O_CREAT) {
 		return 0;
@@ -289,10 +325,16 @@ struct VFile* _vd7zOpenFile(struct VDir* vd, const char* path, int mode) {
 	UInt32 blockIndex;
 
 	vf->outBuffer = 0;
-	SRes res = SzArEx_Extract(&vd7z->db, &vd7z->lookStream.vt, i, &blockIndex,
-		&vf->outBuffer, &outBufferSize,
-		&vf->bufferOffset, &vf->size,
-		&vd7z->allocImp, &vd7z->allocTempImp);
+	SRes res = SZ_OK;
+#ifndef DISABLE_THREADING
+	if (!_vd7zExtractThreaded(vd7z, i, &vf->outBuffer, &vf->bufferOffset, &vf->size))
+#endif
+	{
+		res = SzArEx_Extract(&vd7z->db, &vd7z->lookStream.vt, i, &blockIndex,
+			&vf->outBuffer, &outBufferSize,
+			&vf->bufferOffset, &vf->size,
+			&vd7z->allocImp, &vd7z->allocTempImp);
+	}
 
 	if (res != SZ_OK) {
 		free(vf);
@@ -355,4 +397,183 @@ static enum VFSType _vde7zType(struct VDirEntry* vde) {
 	return VFS_FILE;
 }
 
+#ifndef DISABLE_THREADING
+static unsigned _threadCount(void) {
+	int threads = _threads;
+	if (threads <= 0) {
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		threads = info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+		threads = 1;
+#endif
+	}
+	if (threads > MAX_THREADS) {
+		threads = MAX_THREADS;
+	}
+	return threads > 0 ? threads : 1;
+}
+
+// An LZMA2 stream can be split wherever the dictionary is reset, and the pieces decoded independently
+static bool _vd7zSplitLzma2(const Byte* in, size_t inSize, Byte* out, size_t outSize, struct VDir7zBlockList* blocks) {
+	struct VDir7zBlock* block = NULL;
+	size_t inPos = 0;
+	size_t outPos = 0;
+	while (inPos < inSize && in[inPos]) {
+		Byte control = in[inPos];
+		size_t header;
+		size_t packed;
+		size_t unpacked;
+		bool reset;
+		if (control & 0x80) {
+			if (inSize - inPos < 5) {
+				return false;
+			}
+			unpacked = (((size_t) control & 0x1F) << 16) + ((size_t) in[inPos + 1] << 8) + in[inPos + 2] + 1;
+			packed = ((size_t) in[inPos + 3] << 8) + in[inPos + 4] + 1;
+			header = control >= 0xC0 ? 6 : 5;
+			reset = control >= 0xE0;
+		} else if (control <= 2) {
+			if (inSize - inPos < 3) {
+				return false;
+			}
+			unpacked = ((size_t) in[inPos + 1] << 8) + in[inPos + 2] + 1;
+			packed = unpacked;
+			header = 3;
+			reset = control == 1;
+		} else {
+			return false;
+		}
+		if (inSize - inPos < header + packed || outSize - outPos < unpacked) {
+			return false;
+		}
+		if (reset || !block) {
+			block = VDir7zBlockListAppend(blocks);
+			block->in = &in[inPos];
+			block->inSize = 0;
+			block->out = &out[outPos];
+			block->outSize = 0;
+		}
+		block->inSize += header + packed;
+		block->outSize += unpacked;
+		inPos += header + packed;
+		outPos += unpacked;
+	}
+	return outPos == outSize;
+}
+
+static THREAD_ENTRY _vd7zDecodeThread(void* context) {
+	struct VDir7zDecoder* decoder = context;
+	MutexLock(&decoder->mutex);
+	while (!decoder->failed && decoder->next < VDir7zBlockListSize(&decoder->blocks)) {
+		struct VDir7zBlock* block = VDir7zBlockListGetPointer(&decoder->blocks, decoder->next);
+		++decoder->next;
+		MutexUnlock(&decoder->mutex);
+
+		SizeT outSize = block->outSize;
+		SizeT inSize = block->inSize;
+		ELzmaStatus status;
+		SRes res = Lzma2Decode(block->out, &outSize, block->in, &inSize, decoder->prop, LZMA_FINISH_ANY, &status, decoder->alloc);
+
+		MutexLock(&decoder->mutex);
+		if (res != SZ_OK || outSize != block->outSize) {
+			decoder->failed = true;
+		}
+	}
+	MutexUnlock(&decoder->mutex);
+	return 0;
+}
+
+// Decodes folders that are a single LZMA2 stream on several threads; returns false to fall back on the SDK
+static bool _vd7zExtractThreaded(struct VDir7z* vd, UInt32 fileIndex, Byte** outBuffer, size_t* offset, size_t* size) {
+	unsigned threads = _threadCount();
+	const CSzArEx* db = &vd->db;
+	const CSzAr* ar = &db->db;
+	UInt32 folderIndex = db->FileToFolder[fileIndex];
+	if (threads < 2 || folderIndex == (UInt32) -1) {
+		return false;
+	}
+
+	const Byte* coders = ar->CodersData + ar->FoCodersOffsets[folderIndex];
+	CSzData sd = {
+		.Data = coders,
+		.Size = ar->FoCodersOffsets[folderIndex + 1] - ar->FoCodersOffsets[folderIndex]
+	};
+	CSzFolder folder;
+	if (SzGetNextFolderItem(&folder, &sd) != SZ_OK || folder.NumCoders != 1 || folder.NumPackStreams != 1) {
+		return false;
+	}
+	if (folder.Coders[0].MethodID != METHOD_LZMA2 || folder.Coders[0].PropsSize != 1) {
+		return false;
+	}
+
+	UInt32 packIndex = ar->FoStartPackStreamIndex[folderIndex];
+	UInt64 packSize = ar->PackPositions[packIndex + 1] - ar->PackPositions[packIndex];
+	UInt64 unpackSize = SzAr_GetFolderUnpackSize(ar, folderIndex);
+	if (packSize != (size_t) packSize || unpackSize != (size_t) unpackSize || !unpackSize) {
+		return false;
+	}
+
+	Byte* in = ISzAlloc_Alloc(&vd->allocTempImp, packSize);
+	Byte* out = ISzAlloc_Alloc(&vd->allocImp, unpackSize);
+	if (!in || !out) {
+		ISzAlloc_Free(&vd->allocTempImp, in);
+		ISzAlloc_Free(&vd->allocImp, out);
+		return false;
+	}
+
+	struct VDir7zDecoder decoder = {
+		.next = 0,
+		.failed = false,
+		.prop = coders[folder.Coders[0].PropsOffset],
+		.alloc = &vd->allocImp
+	};
+	VDir7zBlockListInit(&decoder.blocks, 8);
+	bool success = LookInStream_SeekTo(&vd->lookStream.vt, db->dataPos + ar->PackPositions[packIndex]) == SZ_OK &&
+	               LookInStream_Read(&vd->lookStream.vt, in, packSize) == SZ_OK &&
+	               _vd7zSplitLzma2(in, packSize, out, unpackSize, &decoder.blocks) &&
+	               VDir7zBlockListSize(&decoder.blocks) > 1;
+	if (success) {
+		if (threads > VDir7zBlockListSize(&decoder.blocks)) {
+			threads = VDir7zBlockListSize(&decoder.blocks);
+		}
+		MutexInit(&decoder.mutex);
+		Thread workers[MAX_THREADS];
+		unsigned started;
+		for (started = 0; started < threads - 1; ++started) {
+			if (ThreadCreate(&workers[started], _vd7zDecodeThread, &decoder)) {
+				break;
+			}
+		}
+		_vd7zDecodeThread(&decoder);
+		unsigned t;
+		for (t = 0; t < started; ++t) {
+			ThreadJoin(&workers[t]);
+		}
+		MutexDeinit(&decoder.mutex);
+		success = !decoder.failed;
+	}
+	VDir7zBlockListDeinit(&decoder.blocks);
+	ISzAlloc_Free(&vd->allocTempImp, in);
+
+	if (success && SzBitWithVals_Check(&ar->FolderCRCs, folderIndex)) {
+		success = CrcCalc(out, unpackSize) == ar->FolderCRCs.Vals[folderIndex];
+	}
+	*offset = db->UnpackPositions[fileIndex] - db->UnpackPositions[db->FolderToFile[folderIndex]];
+	*size = SzArEx_GetFileSize(db, fileIndex);
+	if (success && SzBitWithVals_Check(&db->CRCs, fileIndex)) {
+		success = CrcCalc(out + *offset, *size) == db->CRCs.Vals[fileIndex];
+	}
+	if (!success) {
+		ISzAlloc_Free(&vd->allocImp, out);
+		return false;
+	}
+	*outBuffer = out;
+	return true;
+}
+#endif
+
 #endif
@@ -117,20 +117,27 @@ struct VFile* VFileMemChunk(const void* mem, size_t size) {
 	return &vfm->d;
 }
 
-void _vfmExpand(struct VFileMem* vfm, size_t newSize) {
+// The buffer grows in powers of two and never shrinks, so a chunk that is truncated and
+// rewritten, e.g. once per frame, keeps reusing the same pages
+static void _vfmReserve(struct VFileMem* vfm, size_t newSize) {
 	size_t alignedSize = toPow2(newSize);
-	if (alignedSize > vfm->bufferSize) {
-		void* oldBuf = vfm->mem;
-		vfm->mem = anonymousMemoryMap(alignedSize);
-		if (oldBuf) {
-			if (newSize < vfm->size) {
-				memcpy(vfm->mem, oldBuf, newSize);
-			} else {
-				memcpy(vfm->mem, oldBuf, vfm->size);
-			}
-			mappedMemoryFree(oldBuf, vfm->bufferSize);
-		}
-		vfm->bufferSize = alignedSize;
+	if (alignedSize <= vfm->bufferSize) {
+		return;
+	}
+	void* oldBuf = vfm->mem;
+	vfm->mem = anonymousMemoryMap(alignedSize);
+	if (oldBuf) {
+		memcpy(vfm->mem, oldBuf, vfm->size);
+		mappedMemoryFree(oldBuf, vfm->bufferSize);
+	}
+	vfm->bufferSize = alignedSize;
+}
+
+// Bytes past the old end read as zero, even if an earlier truncation left stale data there
+static void _vfmExpand(struct VFileMem* vfm, size_t newSize) {
+	if (newSize > vfm->size) {
+		_vfmReserve(vfm, newSize);
+		memset((void*) ((uintptr_t) vfm->mem + vfm->size), 0, newSize - vfm->size);
 	}
 	vfm->size = newSize;
 }
@@ -248,7 +255,10 @@ ssize_t _vfmWriteExpanding(struct VFile* vf, const void* buffer, size_t size) {
 	struct VFileMem* vfm = (struct VFileMem*) vf;
 
 	if (size + vfm->offset > vfm->size) {
-		_vfmExpand(vfm, vfm->offset + size);
+		// Only the gap before the write needs clearing
+		_vfmExpand(vfm, vfm->offset);
+		_vfmReserve(vfm, vfm->offset + size);
+		vfm->size = vfm->offset + size;
 	}
 
 	memcpy((void*) ((uintptr_t) vfm->mem + vfm->offset), buffer, size);
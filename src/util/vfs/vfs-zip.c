@@ -42,6 +42,17 @@ enum {
 #include "third-party/zlib/contrib/minizip/unzip.h"
 #endif
 #include <mgba-util/memory.h>
+#include <mgba-util/vector.h>
+
+enum {
+	// Inflated data is cached in this many chunks of this size
+	ZIP_CHUNK_SIZE = 0x10000,
+	ZIP_CACHE_CHUNKS = 8,
+	// Inflating can be resumed from points spaced about this far apart
+	ZIP_POINT_SPAN = 0x40000,
+	ZIP_WINDOW_SIZE = 0x8000,
+	ZIP_INPUT_SIZE = 0x4000
+};
 
 struct VDirEntryZip {
 	struct VDirEntry d;
@@ -53,16 +64,54 @@ struct VDirEntryZip {
 struct VDirZip {
 	struct VDir d;
 	unzFile z;
+	struct VFile* vf;
 	struct VDirEntryZip dirent;
 	bool atStart;
 };
 
+struct VFileZipPoint {
+	uint64_t in;
+	uint64_t out;
+	int bits;
+	uint8_t* window;
+};
+
+DECLARE_VECTOR(VFileZipPointList, struct VFileZipPoint);
+DEFINE_VECTOR(VFileZipPointList, struct VFileZipPoint);
+
+struct VFileZipChunk {
+	uint8_t* data;
+	size_t size;
+	uint64_t index;
+	uint32_t lastUsed;
+};
+
+struct VFileZipStream {
+	z_stream zstream;
+	bool active;
+	uint64_t inRead;
+	uint64_t out;
+	uint8_t window[ZIP_WINDOW_SIZE];
+	size_t windowPos;
+	uint8_t input[ZIP_INPUT_SIZE];
+	struct VFileZipPointList points;
+	struct VFileZipChunk cache[ZIP_CACHE_CHUNKS];
+	uint32_t tick;
+};
+
 struct VFileZip {
 	struct VFile d;
 	unzFile z;
 	void* buffer;
 	size_t bufferSize;
 	size_t fileSize;
+
+	// Stored and deflated entries are read straight out of the archive instead of through minizip
+	struct VFile* archive;
+	uint64_t dataOffset;
+	uint64_t compressedSize;
+	uint64_t offset;
+	struct VFileZipStream* stream;
 };
 #endif
 
@@ -88,7 +137,7 @@ static enum VFSType _vdezType(struct VDirEntry* vde);
 
 #ifndef USE_LIBZIP
 static voidpf _vfmzOpen(voidpf opaque, const char* filename, int mode) {
-	UNUSED(opaque);
+	struct VFile** vfOut = opaque;
 	int flags = 0;
 	switch (mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) {
 	case ZLIB_FILEFUNC_MODE_READ:
@@ -104,7 +153,11 @@ static voidpf _vfmzOpen(voidpf opaque, const char* filename, int mode) {
 	if (mode & ZLIB_FILEFUNC_MODE_CREATE) {
 		flags |= O_CREAT;
 	}
-	return VFileOpen(filename, flags);
+	struct VFile* vf = VFileOpen(filename, flags);
+	if (vfOut) {
+		*vfOut = vf;
+	}
+	return vf;
 }
 
 static uLong _vfmzRead(voidpf opaque, voidpf stream, void* buf, uLong size) {
@@ -145,6 +198,8 @@ long _vfmzSeek(voidpf opaque, voidpf stream, uLong offset, int origin) {
 struct VDir* VDirOpenZip(const char* path, int flags) {
 #ifndef USE_LIBZIP
 	UNUSED(flags);
+	struct VDirZip* vd = malloc(sizeof(struct VDirZip));
+	vd->vf = NULL;
 	zlib_filefunc_def ops = {
 		.zopen_file = _vfmzOpen,
 		.zread_file = _vfmzRead,
@@ -153,10 +208,11 @@ struct VDir* VDirOpenZip(const char* path, int flags) {
 		.zseek_file = _vfmzSeek,
 		.zclose_file = _vfmzClose,
 		.zerror_file = _vfmzError,
-		.opaque = 0
+		.opaque = &vd->vf
 	};
 	unzFile z = unzOpen2(path, &ops);
 	if (!z) {
+		free(vd);
 		return 0;
 	}
 #else
@@ -172,8 +228,8 @@ struct VDir* VDirOpenZip(const char* path, int flags) {
 	if (!z) {
 		return 0;
 	}
-#endif
 	struct VDirZip* vd = malloc(sizeof(struct VDirZip));
+#endif
 
 	vd->d.close = _vdzClose;
 	vd->d.rewind = _vdzRewind;
@@ -449,9 +505,196 @@ static enum VFSType _vdezType(struct VDirEntry* vde) {
 	return VFS_FILE;
 }
 #else
+static ssize_t _vfzReadArchive(struct VFileZip* vfz, uint64_t offset, void* buffer, size_t size) {
+	if (offset >= vfz->compressedSize) {
+		return 0;
+	}
+	if (size > vfz->compressedSize - offset) {
+		size = vfz->compressedSize - offset;
+	}
+	// The archive is shared with minizip, so always seek first
+	if (vfz->archive->seek(vfz->archive, vfz->dataOffset + offset, SEEK_SET) < 0) {
+		return -1;
+	}
+	return vfz->archive->read(vfz->archive, buffer, size);
+}
+
+static void _vfzStreamStop(struct VFileZipStream* stream) {
+	if (stream->active) {
+		inflateEnd(&stream->zstream);
+		stream->active = false;
+	}
+}
+
+static bool _vfzStreamRestart(struct VFileZip* vfz, const struct VFileZipPoint* point) {
+	struct VFileZipStream* stream = vfz->stream;
+	_vfzStreamStop(stream);
+	memset(&stream->zstream, 0, sizeof(stream->zstream));
+	if (inflateInit2(&stream->zstream, -MAX_WBITS) != Z_OK) {
+		return false;
+	}
+	stream->active = true;
+	stream->inRead = point->in;
+	stream->out = point->out;
+	stream->windowPos = 0;
+	if (point->bits) {
+		uint8_t byte;
+		if (_vfzReadArchive(vfz, point->in - 1, &byte, 1) != 1) {
+			_vfzStreamStop(stream);
+			return false;
+		}
+		inflatePrime(&stream->zstream, point->bits, byte >> (8 - point->bits));
+	}
+	if (point->window) {
+		memcpy(stream->window, point->window, ZIP_WINDOW_SIZE);
+		inflateSetDictionary(&stream->zstream, point->window, ZIP_WINDOW_SIZE);
+	}
+	return true;
+}
+
+static void _vfzStreamAddPoint(struct VFileZipStream* stream) {
+	size_t count = VFileZipPointListSize(&stream->points);
+	if (stream->out < VFileZipPointListGetPointer(&stream->points, count - 1)->out + ZIP_POINT_SPAN) {
+		return;
+	}
+	struct VFileZipPoint* point = VFileZipPointListAppend(&stream->points);
+	point->in = stream->inRead - stream->zstream.avail_in;
+	point->out = stream->out;
+	point->bits = stream->zstream.data_type & 7;
+	point->window = malloc(ZIP_WINDOW_SIZE);
+	size_t left = ZIP_WINDOW_SIZE - stream->windowPos;
+	memcpy(point->window, &stream->window[stream->windowPos], left);
+	memcpy(&point->window[left], stream->window, stream->windowPos);
+}
+
+// Inflates the next size bytes of the entry into buffer, or discards them if buffer is NULL
+static bool _vfzStreamInflate(struct VFileZip* vfz, uint8_t* buffer, size_t size) {
+	struct VFileZipStream* stream = vfz->stream;
+	z_stream* zstream = &stream->zstream;
+	while (size) {
+		if (!zstream->avail_in) {
+			ssize_t read = _vfzReadArchive(vfz, stream->inRead, stream->input, sizeof(stream->input));
+			if (read <= 0) {
+				return false;
+			}
+			stream->inRead += read;
+			zstream->next_in = stream->input;
+			zstream->avail_in = read;
+		}
+		if (stream->windowPos == ZIP_WINDOW_SIZE) {
+			stream->windowPos = 0;
+		}
+		size_t avail = ZIP_WINDOW_SIZE - stream->windowPos;
+		if (avail > size) {
+			avail = size;
+		}
+		zstream->next_out = &stream->window[stream->windowPos];
+		zstream->avail_out = avail;
+		int ret = inflate(zstream, Z_BLOCK);
+		size_t produced = avail - zstream->avail_out;
+		if (buffer) {
+			memcpy(buffer, &stream->window[stream->windowPos], produced);
+			buffer += produced;
+		}
+		stream->windowPos += produced;
+		stream->out += produced;
+		size -= produced;
+		if (ret == Z_STREAM_END) {
+			return !size;
+		}
+		if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			return false;
+		}
+		// Inflating can only be resumed at the end of a block, see zlib's examples/zran.c
+		if ((zstream->data_type & 128) && !(zstream->data_type & 64)) {
+			_vfzStreamAddPoint(stream);
+		}
+	}
+	return true;
+}
+
+static const struct VFileZipChunk* _vfzStreamChunk(struct VFileZip* vfz, uint64_t index) {
+	struct VFileZipStream* stream = vfz->stream;
+	++stream->tick;
+	struct VFileZipChunk* victim = &stream->cache[0];
+	size_t i;
+	for (i = 0; i < ZIP_CACHE_CHUNKS; ++i) {
+		struct VFileZipChunk* chunk = &stream->cache[i];
+		if (chunk->data && chunk->index == index) {
+			chunk->lastUsed = stream->tick;
+			return chunk;
+		}
+		if (victim->data && (!chunk->data || chunk->lastUsed < victim->lastUsed)) {
+			victim = chunk;
+		}
+	}
+
+	uint64_t start = index * ZIP_CHUNK_SIZE;
+	size_t size = ZIP_CHUNK_SIZE;
+	if (size > vfz->fileSize - start) {
+		size = vfz->fileSize - start;
+	}
+
+	// Resume from the last point before the chunk, unless inflating is already past it
+	size_t p = VFileZipPointListSize(&stream->points);
+	const struct VFileZipPoint* point;
+	do {
+		--p;
+		point = VFileZipPointListGetPointer(&stream->points, p);
+	} while (point->out > start);
+	if (!stream->active || stream->out > start || stream->out < point->out) {
+		if (!_vfzStreamRestart(vfz, point)) {
+			return NULL;
+		}
+	}
+
+	if (!victim->data) {
+		victim->data = malloc(ZIP_CHUNK_SIZE);
+	}
+	if (!_vfzStreamInflate(vfz, NULL, start - stream->out) || !_vfzStreamInflate(vfz, victim->data, size)) {
+		_vfzStreamStop(stream);
+		free(victim->data);
+		victim->data = NULL;
+		return NULL;
+	}
+	victim->size = size;
+	victim->index = index;
+	victim->lastUsed = stream->tick;
+	return victim;
+}
+
+static struct VFileZipStream* _vfzStreamCreate(void) {
+	struct VFileZipStream* stream = calloc(1, sizeof(*stream));
+	VFileZipPointListInit(&stream->points, 4);
+	struct VFileZipPoint* point = VFileZipPointListAppend(&stream->points);
+	point->in = 0;
+	point->out = 0;
+	point->bits = 0;
+	point->window = NULL;
+	return stream;
+}
+
+static void _vfzStreamDestroy(struct VFileZipStream* stream) {
+	_vfzStreamStop(stream);
+	size_t i;
+	for (i = 0; i < VFileZipPointListSize(&stream->points); ++i) {
+		free(VFileZipPointListGetPointer(&stream->points, i)->window);
+	}
+	VFileZipPointListDeinit(&stream->points);
+	for (i = 0; i < ZIP_CACHE_CHUNKS; ++i) {
+		free(stream->cache[i].data);
+	}
+	free(stream);
+}
+
 bool _vfzClose(struct VFile* vf) {
 	struct VFileZip* vfz = (struct VFileZip*) vf;
-	unzCloseCurrentFile(vfz->z);
+	if (vfz->stream) {
+		_vfzStreamDestroy(vfz->stream);
+	}
+	if (!vfz->archive) {
+		unzCloseCurrentFile(vfz->z);
+	}
 	if (vfz->buffer) {
 		mappedMemoryFree(vfz->buffer, vfz->bufferSize);
 	}
@@ -462,14 +705,14 @@ bool _vfzClose(struct VFile* vf) {
 off_t _vfzSeek(struct VFile* vf, off_t offset, int whence) {
 	struct VFileZip* vfz = (struct VFileZip*) vf;
 
-	int64_t currentPos = unztell64(vfz->z);
+	int64_t currentPos = vfz->archive ? (int64_t) vfz->offset : (int64_t) unztell64(vfz->z);
 	int64_t pos;
 	switch (whence) {
 	case SEEK_SET:
 		pos = 0;
 		break;
 	case SEEK_CUR:
-		pos = unztell64(vfz->z);
+		pos = currentPos;
 		break;
 	case SEEK_END:
 		pos = vfz->fileSize;
@@ -482,6 +725,13 @@ off_t _vfzSeek(struct VFile* vf, off_t offset, int whence) {
 		return -1;
 	}
 	pos += offset;
+	if (vfz->archive) {
+		if (pos > (int64_t) vfz->fileSize) {
+			return -1;
+		}
+		vfz->offset = pos;
+		return pos;
+	}
 	if (currentPos > pos) {
 		unzCloseCurrentFile(vfz->z);
 		unzOpenCurrentFile(vfz->z);
@@ -505,7 +755,38 @@ off_t _vfzSeek(struct VFile* vf, off_t offset, int whence) {
 
 ssize_t _vfzRead(struct VFile* vf, void* buffer, size_t size) {
 	struct VFileZip* vfz = (struct VFileZip*) vf;
-	return unzReadCurrentFile(vfz->z, buffer, size);
+	if (!vfz->archive) {
+		return unzReadCurrentFile(vfz->z, buffer, size);
+	}
+	if (vfz->offset >= vfz->fileSize) {
+		return 0;
+	}
+	if (size > vfz->fileSize - vfz->offset) {
+		size = vfz->fileSize - vfz->offset;
+	}
+	if (!vfz->stream) {
+		ssize_t read = _vfzReadArchive(vfz, vfz->offset, buffer, size);
+		if (read > 0) {
+			vfz->offset += read;
+		}
+		return read;
+	}
+	size_t total = 0;
+	while (total < size) {
+		const struct VFileZipChunk* chunk = _vfzStreamChunk(vfz, vfz->offset / ZIP_CHUNK_SIZE);
+		if (!chunk) {
+			return total ? (ssize_t) total : -1;
+		}
+		size_t chunkOffset = vfz->offset % ZIP_CHUNK_SIZE;
+		size_t toCopy = chunk->size - chunkOffset;
+		if (toCopy > size - total) {
+			toCopy = size - total;
+		}
+		memcpy((uint8_t*) buffer + total, &chunk->data[chunkOffset], toCopy);
+		total += toCopy;
+		vfz->offset += toCopy;
+	}
+	return total;
 }
 
 ssize_t _vfzWrite(struct VFile* vf, const void* buffer, size_t size) {
@@ -532,12 +813,18 @@ void* _vfzMap(struct VFile* vf, size_t size, int flags) {
 		return 0;
 	}
 
-	unzCloseCurrentFile(vfz->z);
-	unzOpenCurrentFile(vfz->z);
-	vf->read(vf, vfz->buffer, size);
-	unzCloseCurrentFile(vfz->z);
-	unzOpenCurrentFile(vfz->z);
-	vf->seek(vf, pos, SEEK_SET);
+	if (vfz->archive) {
+		vfz->offset = 0;
+		vf->read(vf, vfz->buffer, size);
+		vfz->offset = pos;
+	} else {
+		unzCloseCurrentFile(vfz->z);
+		unzOpenCurrentFile(vfz->z);
+		vf->read(vf, vfz->buffer, size);
+		unzCloseCurrentFile(vfz->z);
+		unzOpenCurrentFile(vfz->z);
+		vf->seek(vf, pos, SEEK_SET);
+	}
 
 	vfz->bufferSize = size;
 
@@ -611,21 +898,40 @@ struct VFile* _vdzOpenFile(struct VDir* vd, const char* path, int mode) {
 		return 0;
 	}
 
-	if (unzOpenCurrentFile(vdz->z) < 0) {
-		return 0;
-	}
-
 	unz_file_info64 info;
 	int status = unzGetCurrentFileInfo64(vdz->z, &info, 0, 0, 0, 0, 0, 0);
 	if (status < 0) {
 		return 0;
 	}
 
+	// Unencrypted stored and deflated entries can be read at random, the rest go through minizip
+	bool direct = vdz->vf && !(info.flag & 1) && (info.compression_method == 0 || info.compression_method == Z_DEFLATED);
+	uint64_t dataOffset = 0;
+	if (direct) {
+		int method;
+		int level;
+		if (unzOpenCurrentFile2(vdz->z, &method, &level, 1) < 0) {
+			return 0;
+		}
+		dataOffset = unzGetCurrentFileZStreamPos64(vdz->z);
+		unzCloseCurrentFile(vdz->z);
+	} else if (unzOpenCurrentFile(vdz->z) < 0) {
+		return 0;
+	}
+
 	struct VFileZip* vfz = malloc(sizeof(struct VFileZip));
 	vfz->z = vdz->z;
 	vfz->buffer = 0;
 	vfz->bufferSize = 0;
 	vfz->fileSize = info.uncompressed_size;
+	vfz->archive = direct ? vdz->vf : NULL;
+	vfz->dataOffset = dataOffset;
+	vfz->compressedSize = info.compressed_size;
+	vfz->offset = 0;
+	vfz->stream = NULL;
+	if (direct && info.compression_method == Z_DEFLATED) {
+		vfz->stream = _vfzStreamCreate();
+	}
 
 	vfz->d.close = _vfzClose;
 	vfz->d.seek = _vfzSeek;
@@ -10,12 +10,23 @@ import subprocess
 import sys
 import time
 
+def expand_breakdown(results):
+    events = results.pop('event_times', None)
+    if not events:
+        return results
+    for event in events.split(';'):
+        name, _, time = event.rpartition('=')
+        if name:
+            results['event:{}'.format(name)] = time
+    return results
+
 class PerfTest(object):
     EXECUTABLE = 'mgba-perf'
 
-    def __init__(self, rom, renderer='software'):
+    def __init__(self, rom, renderer='software', breakdown=False):
         self.rom = rom
         self.renderer = renderer
+        self.breakdown = breakdown
         self.results = None
         self.name = 'Perf Test: {}'.format(rom)
 
@@ -32,6 +43,8 @@ class PerfTest(object):
             args.append('-N')
         elif self.renderer == 'threaded-software':
             args.append('-T')
+        if self.breakdown:
+            args.append('-E')
         args.append(self.rom)
         env = {}
         if 'LD_LIBRARY_PATH' in os.environ:
@@ -48,11 +61,11 @@ class PerfTest(object):
             print('Game crashed!', file=sys.stderr)
             return
         reader = csv.DictReader(proc.stdout)
-        self.results = next(reader)
+        self.results = expand_breakdown(next(reader))
 
 class WallClockTest(PerfTest):
-    def __init__(self, rom, duration, renderer='software'):
-        super(WallClockTest, self).__init__(rom, renderer)
+    def __init__(self, rom, duration, renderer='software', breakdown=False):
+        super(WallClockTest, self).__init__(rom, renderer, breakdown)
         self.duration = duration
         self.name = 'Wall-Clock Test ({} seconds, {} renderer): {}'.format(duration, renderer, rom)
 
@@ -61,8 +74,8 @@ class WallClockTest(PerfTest):
         proc.send_signal(signal.SIGINT)
 
 class GameClockTest(PerfTest):
-    def __init__(self, rom, frames, renderer='software'):
-        super(GameClockTest, self).__init__(rom, renderer)
+    def __init__(self, rom, frames, renderer='software', breakdown=False):
+        super(GameClockTest, self).__init__(rom, renderer, breakdown)
         self.frames = frames
         self.name = 'Game-Clock Test ({} frames, {} renderer): {}'.format(frames, renderer, rom)
 
@@ -97,6 +110,8 @@ class PerfServer(object):
             server_command.append('-N')
         elif test.renderer == 'threaded-software':
             server_command.append('-T')
+        if test.breakdown:
+            server_command.append('-E')
         subprocess.check_call(server_command)
         time.sleep(4)
         self.socket = socket.create_connection(self.address, timeout=1000)
@@ -109,7 +124,7 @@ class PerfServer(object):
         if not self.socket:
             self._start(test)
         self.socket.send(os.path.join("/perfroms", test.rom).encode("utf-8"))
-        self.results.append(next(self.reader))
+        self.results.append(expand_breakdown(next(self.reader)))
         self.iterations -= 1
         if self.iterations == 0:
             self.finish()
@@ -123,12 +138,13 @@ class PerfServer(object):
         self.socket = None
 
 class Suite(object):
-    def __init__(self, cwd, wall=None, game=None, renderer='software'):
+    def __init__(self, cwd, wall=None, game=None, renderer='software', breakdown=False):
         self.cwd = cwd
         self.tests = []
         self.wall = wall
         self.game = game
         self.renderer = renderer
+        self.breakdown = breakdown
         self.server = None
 
     def set_server(self, server):
@@ -145,9 +161,9 @@ class Suite(object):
 
     def add_tests(self, rom):
         if self.wall:
-            self.tests.append(WallClockTest(rom, self.wall, renderer=self.renderer))
+            self.tests.append(WallClockTest(rom, self.wall, renderer=self.renderer, breakdown=self.breakdown))
         if self.game:
-            self.tests.append(GameClockTest(rom, self.game, renderer=self.renderer))
+            self.tests.append(GameClockTest(rom, self.game, renderer=self.renderer, breakdown=self.breakdown))
 
     def run(self):
         results = []
@@ -175,6 +191,7 @@ if __name__ == '__main__':
     parser.add_argument('-g', '--game-frames', type=int, default=0, metavar='FRAMES', help='game-clock frames')
     parser.add_argument('-N', '--disable-renderer', action='store_const', const=True, help='disable video rendering')
     parser.add_argument('-T', '--threaded-renderer', action='store_const', const=True, help='threaded video rendering')
+    parser.add_argument('-E', '--breakdown', action='store_const', const=True, help='break down host time by subsystem and event')
     parser.add_argument('-s', '--server', metavar='ADDRESS', help='run on server')
     parser.add_argument('-S', '--server-command', metavar='COMMAND', help='command to launch server')
     parser.add_argument('-o', '--out', metavar='FILE', help='output file path')
@@ -186,7 +203,7 @@ if __name__ == '__main__':
         renderer = None
     elif args.threaded_renderer:
         renderer = 'threaded-software'
-    s = Suite(args.directory, wall=args.wall_time, game=args.game_frames, renderer=renderer)
+    s = Suite(args.directory, wall=args.wall_time, game=args.game_frames, renderer=renderer, breakdown=bool(args.breakdown))
     if args.server:
         if args.server_command:
             server = PerfServer(args.server, args.server_command)
@@ -198,7 +215,11 @@ if __name__ == '__main__':
     fout = sys.stdout
     if args.out:
         fout = open(args.out, 'w')
-    writer = csv.DictWriter(fout, results[0].keys())
+    # Not every game fires the same events
+    fields = []
+    for result in results:
+        fields.extend(key for key in result.keys() if key not in fields)
+    writer = csv.DictWriter(fout, fields)
     writer.writeheader()
     writer.writerows(results)
     if fout is not sys.stdout: